@@ -2372,6 +2372,15 @@ void AggExpr::print() const {
     case kAPPROX_COUNT_DISTINCT:
       agg = "APPROX_COUNT_DISTINCT";
       break;
+    case kAPPROX_COUNT_DISTINCT_SKETCH:
+      agg = "APPROX_COUNT_DISTINCT_SKETCH";
+      break;
+    case kAPPROX_COUNT_DISTINCT_UNION:
+      agg = "APPROX_COUNT_DISTINCT_UNION";
+      break;
+    case kAPPROX_QUANTILE:
+      agg = "APPROX_PERCENTILE";
+      break;
     case kSAMPLE:
       agg = "SAMPLE";
       break;
@@ -2851,4 +2860,79 @@ bool FunctionOperWithCustomTypeHandling::operator==(const Expr& rhs) const {
   return true;
 }
 
+namespace {
+
+std::vector<std::shared_ptr<Analyzer::Expr>> deep_copy_exprs(
+    const std::vector<std::shared_ptr<Analyzer::Expr>>& exprs) {
+  std::vector<std::shared_ptr<Analyzer::Expr>> exprs_copy;
+  for (const auto& expr : exprs) {
+    exprs_copy.push_back(expr->deep_copy());
+  }
+  return exprs_copy;
+}
+
+bool exprs_equal(const std::vector<std::shared_ptr<Analyzer::Expr>>& lhs,
+                 const std::vector<std::shared_ptr<Analyzer::Expr>>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.size(); ++i) {
+    if (!(*lhs[i] == *rhs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+std::shared_ptr<Analyzer::Expr> WindowFunction::deep_copy() const {
+  return makeExpr<WindowFunction>(type_info,
+                                  kind_,
+                                  deep_copy_exprs(args_),
+                                  deep_copy_exprs(partition_keys_),
+                                  deep_copy_exprs(order_keys_),
+                                  collation_,
+                                  is_rows_,
+                                  to_current_row_);
+}
+
+bool WindowFunction::operator==(const Expr& rhs) const {
+  const auto rhs_window = dynamic_cast<const WindowFunction*>(&rhs);
+  if (!rhs_window || type_info != rhs.get_type_info() || kind_ != rhs_window->kind_ ||
+      is_rows_ != rhs_window->is_rows_ ||
+      to_current_row_ != rhs_window->to_current_row_ ||
+      collation_.size() != rhs_window->collation_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < collation_.size(); ++i) {
+    const auto& lhs_entry = collation_[i];
+    const auto& rhs_entry = rhs_window->collation_[i];
+    if (lhs_entry.tle_no != rhs_entry.tle_no || lhs_entry.is_desc != rhs_entry.is_desc ||
+        lhs_entry.nulls_first != rhs_entry.nulls_first) {
+      return false;
+    }
+  }
+  return exprs_equal(args_, rhs_window->args_) &&
+         exprs_equal(partition_keys_, rhs_window->partition_keys_) &&
+         exprs_equal(order_keys_, rhs_window->order_keys_);
+}
+
+void WindowFunction::print() const {
+  std::cout << "(WindowFunction " << static_cast<int>(kind_) << " ";
+  for (const auto& arg : args_) {
+    arg->print();
+  }
+  std::cout << " PARTITION BY ";
+  for (const auto& partition_key : partition_keys_) {
+    partition_key->print();
+  }
+  std::cout << " ORDER BY ";
+  for (size_t i = 0; i < order_keys_.size(); ++i) {
+    order_keys_[i]->print();
+    collation_[i].print();
+  }
+  std::cout << ") ";
+}
+
 }  // namespace Analyzer
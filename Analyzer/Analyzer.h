@@ -890,6 +890,8 @@ class AggExpr : public Expr {
   std::shared_ptr<Analyzer::Expr> get_own_arg() const { return arg; }
   bool get_is_distinct() const { return is_distinct; }
   std::shared_ptr<Analyzer::Constant> get_error_rate() const { return error_rate; }
+  // The DOUBLE percentile of kAPPROX_QUANTILE, kept in place of the error rate.
+  std::shared_ptr<Analyzer::Constant> get_quantile() const { return error_rate; }
   virtual std::shared_ptr<Analyzer::Expr> deep_copy() const;
   virtual void group_predicates(std::list<const Expr*>& scan_predicates,
                                 std::list<const Expr*>& join_predicates,
@@ -919,7 +921,8 @@ class AggExpr : public Expr {
   SQLAgg aggtype;                       // aggregate type: kAVG, kMIN, kMAX, kSUM, kCOUNT
   std::shared_ptr<Analyzer::Expr> arg;  // argument to aggregate
   bool is_distinct;                     // true only if it is for COUNT(DISTINCT x)
-  std::shared_ptr<Analyzer::Constant> error_rate;  // error rate of kAPPROX_COUNT_DISTINCT
+  // error rate of kAPPROX_COUNT_DISTINCT, percentile of kAPPROX_QUANTILE
+  std::shared_ptr<Analyzer::Constant> error_rate;
 };
 
 /*
@@ -1305,6 +1308,65 @@ struct OrderEntry {
   bool nulls_first; /* true if nulls are ordered first.  otherwise last. */
 };
 
+/*
+ * @type WindowFunction
+ * @brief A window function target. It isn't code generated: RelAlgExecutor projects its
+ * arguments and keys, then evaluates it over the sorted partitions of the rows. The
+ * tle_no of the collation entries is the 1-based index of the order key.
+ */
+class WindowFunction : public Expr {
+ public:
+  WindowFunction(const SQLTypeInfo& ti,
+                 const SqlWindowFunctionKind kind,
+                 const std::vector<std::shared_ptr<Analyzer::Expr>>& args,
+                 const std::vector<std::shared_ptr<Analyzer::Expr>>& partition_keys,
+                 const std::vector<std::shared_ptr<Analyzer::Expr>>& order_keys,
+                 const std::vector<OrderEntry>& collation,
+                 const bool is_rows,
+                 const bool to_current_row)
+      : Expr(ti)
+      , kind_(kind)
+      , args_(args)
+      , partition_keys_(partition_keys)
+      , order_keys_(order_keys)
+      , collation_(collation)
+      , is_rows_(is_rows)
+      , to_current_row_(to_current_row) {}
+
+  std::shared_ptr<Analyzer::Expr> deep_copy() const override;
+
+  bool operator==(const Expr& rhs) const override;
+
+  void print() const override;
+
+  SqlWindowFunctionKind getKind() const { return kind_; }
+
+  const std::vector<std::shared_ptr<Analyzer::Expr>>& getArgs() const { return args_; }
+
+  const std::vector<std::shared_ptr<Analyzer::Expr>>& getPartitionKeys() const {
+    return partition_keys_;
+  }
+
+  const std::vector<std::shared_ptr<Analyzer::Expr>>& getOrderKeys() const {
+    return order_keys_;
+  }
+
+  const std::vector<OrderEntry>& getCollation() const { return collation_; }
+
+  bool isRows() const { return is_rows_; }
+
+  bool isFrameToCurrentRow() const { return to_current_row_; }
+
+ private:
+  const SqlWindowFunctionKind kind_;
+  const std::vector<std::shared_ptr<Analyzer::Expr>> args_;
+  const std::vector<std::shared_ptr<Analyzer::Expr>> partition_keys_;
+  const std::vector<std::shared_ptr<Analyzer::Expr>> order_keys_;
+  const std::vector<OrderEntry> collation_;
+  const bool is_rows_;
+  const bool to_current_row_;
+};
+
 /*
  * @type Query
  * @brief parse tree for a query
@@ -15,20 +15,62 @@
  */
 #include "S3Archive.h"
 #include <glog/logging.h>
+#include <algorithm>
 #include <atomic>
 #include <boost/filesystem.hpp>
 
 #include <aws/core/Aws.h>
-#include <aws/core/auth/AWSCredentialsProvider.h>
 #include <aws/s3/model/GetObjectRequest.h>
 #include <aws/s3/model/ListObjectsV2Request.h>
 #include <aws/s3/model/Object.h>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <memory>
+#include <sstream>
 
-int S3Archive::awsapi_count;
-std::mutex S3Archive::awsapi_mtx;
-Aws::SDKOptions S3Archive::awsapi_options;
+namespace {
+
+// Objects are downloaded in ranges of this size, up to S3_RANGES_IN_FLIGHT at once,
+// which bounds the memory a download takes.
+const size_t S3_RANGE_SIZE{8 << 20};
+const size_t S3_RANGES_IN_FLIGHT{8};
+
+std::string range_header(const size_t begin, const size_t end) {
+  return "bytes=" + std::to_string(begin) + "-" + std::to_string(end - 1);
+}
+
+// Total size in a "bytes 0-8388607/123456789" content range, 0 if there is none.
+size_t object_size_of(const Aws::String& content_range) {
+  const auto slash = content_range.find('/');
+  if (slash == Aws::String::npos || slash + 1 == content_range.size() ||
+      content_range[slash + 1] == '*') {
+    return 0;
+  }
+  return std::stoull(content_range.c_str() + slash + 1);
+}
+
+std::string get_object_range(Aws::S3::S3Client* s3_client,
+                             const std::string& bucket_name,
+                             const std::string& objkey,
+                             const size_t begin,
+                             const size_t end) {
+  Aws::S3::Model::GetObjectRequest range_request;
+  range_request.WithBucket(bucket_name).WithKey(objkey);
+  range_request.SetRange(range_header(begin, end));
+  auto outcome = s3_client->GetObject(range_request);
+  if (!outcome.IsSuccess()) {
+    throw std::runtime_error("failed to get bytes " + std::to_string(begin) + "-" +
+                             std::to_string(end - 1) + " of object '" + objkey +
+                             "': " + outcome.GetError().GetExceptionName() + ": " +
+                             outcome.GetError().GetMessage());
+  }
+  std::ostringstream body;
+  body << outcome.GetResult().GetBody().rdbuf();
+  return body.str();
+}
+
+}  // namespace
 
 void S3Archive::init_for_read() {
   boost::filesystem::create_directories(s3_temp_dir);
@@ -57,47 +99,7 @@ void S3Archive::init_for_read() {
     // credentials are configured *globally* while different users with private
     // s3 resources may need separate credentials to access.in that case, use
     // WITH s3_access_key/s3_secret_key parameters.
-    Aws::Client::ClientConfiguration s3_config;
-    s3_config.region = s3_region.size() ? s3_region : Aws::Region::US_EAST_1;
-
-    /*
-       Fix a wrong ca path established at building libcurl on Centos being carried to
-       Ubuntu. To fix the issue, this is this sequence of locating ca file: 1) if
-       `SSL_CERT_DIR` or `SSL_CERT_FILE` is set, set it to S3 ClientConfiguration. 2) if
-       none ^ is set, mapd core searches a list of known ca file paths. 3) if 2) finds
-       nothing, it is users' call to set correct SSL_CERT_DIR or SSL_CERT_FILE. S3 c++
-       sdk: "we only want to override the default path if someone has explicitly told us
-       to."
-     */
-    std::list<std::string> v_known_ca_paths({
-        "/etc/ssl/certs/ca-certificates.crt",
-        "/etc/pki/tls/certs/ca-bundle.crt",
-        "/usr/share/ssl/certs/ca-bundle.crt",
-        "/usr/local/share/certs/ca-root.crt",
-        "/etc/ssl/cert.pem",
-        "/etc/ssl/ca-bundle.pem",
-    });
-    char* env;
-    if (nullptr != (env = getenv("SSL_CERT_DIR"))) {
-      s3_config.caPath = env;
-    }
-    if (nullptr != (env = getenv("SSL_CERT_FILE"))) {
-      v_known_ca_paths.push_front(env);
-    }
-    for (const auto& known_ca_path : v_known_ca_paths) {
-      if (boost::filesystem::exists(known_ca_path)) {
-        s3_config.caFile = known_ca_path;
-        break;
-      }
-    }
-
-    if (!s3_access_key.empty() && !s3_secret_key.empty()) {
-      s3_client.reset(new Aws::S3::S3Client(
-          Aws::Auth::AWSCredentials(s3_access_key, s3_secret_key), s3_config));
-    } else {
-      s3_client.reset(new Aws::S3::S3Client(
-          std::make_shared<Aws::Auth::AnonymousAWSCredentialsProvider>(), s3_config));
-    }
+    s3_client = create_s3_client(s3_region, s3_access_key, s3_secret_key, "", false);
     while (true) {
       auto list_objects_outcome = s3_client->ListObjectsV2(objects_request);
       if (list_objects_outcome.IsSuccess()) {
@@ -203,8 +205,12 @@ const std::string S3Archive::land(const std::string& objkey,
   object_request.WithBucket(bucket_name).WithKey(objkey);
 
   // set a download byte range (max 10mb) to avoid getting stuck on detecting big s3 files
-  if (use_pipe && for_detection) {
+  const bool ranged_download = !(use_pipe && for_detection);
+  if (!ranged_download) {
     object_request.SetRange("bytes=0-10000000");
+  } else {
+    // only the first range here, the rest is downloaded in parallel by th_writer
+    object_request.SetRange(range_header(0, S3_RANGE_SIZE));
   }
 
   auto get_object_outcome = s3_client->GetObject(object_request);
@@ -214,10 +220,17 @@ const std::string S3Archive::land(const std::string& objkey,
                              ": " + get_object_outcome.GetError().GetMessage());
   }
 
+  // no content range if the server sent the whole object at once
+  const size_t object_size =
+      ranged_download ? object_size_of(get_object_outcome.GetResult().GetContentRange())
+                      : 0;
+
   // streaming means asynch
   std::atomic<bool> is_get_object_outcome_moved(false);
   // fix a race between S3Archive::land and S3Archive::~S3Archive on S3Archive itself
   auto& bucket_name = this->bucket_name;
+  // ~S3Archive joins th_writer before the client goes away
+  auto s3_client = this->s3_client.get();
   auto th_writer =
       std::thread([=, &teptr, &get_object_outcome, &is_get_object_outcome_moved]() {
         try {
@@ -239,6 +252,31 @@ const std::string S3Archive::land(const std::string& objkey,
           local_file.open(file_path.c_str(),
                           std::ios::out | std::ios::binary | std::ios::trunc);
           local_file << get_object_outcome_moved.GetResult().GetBody().rdbuf();
+          // the ranges after the first one are written in order as they arrive, while
+          // the next ones are being downloaded
+          std::deque<std::future<std::string>> ranges;
+          size_t next_range_begin = S3_RANGE_SIZE;
+          while (next_range_begin < object_size || !ranges.empty()) {
+            while (next_range_begin < object_size &&
+                   ranges.size() < S3_RANGES_IN_FLIGHT) {
+              const auto range_end =
+                  std::min(next_range_begin + S3_RANGE_SIZE, object_size);
+              ranges.push_back(std::async(std::launch::async,
+                                          get_object_range,
+                                          s3_client,
+                                          bucket_name,
+                                          objkey,
+                                          next_range_begin,
+                                          range_end));
+              next_range_begin = range_end;
+            }
+            const auto range = ranges.front().get();
+            ranges.pop_front();
+            local_file.write(range.data(), range.size());
+            if (!local_file) {
+              throw std::runtime_error("failed to write " + file_path);
+            }
+          }
           MAPD_S3_LOG(LOG(INFO)
                       << "downloaded s3://" << bucket_name << "/" << objkey << " to "
                       << (use_pipe ? "pipe " : "file ") << file_path << ".")
@@ -22,11 +22,7 @@
 #include <map>
 #include <thread>
 #include "Archive.h"
-
-#ifdef HAVE_AWS_S3
-#include <aws/core/Aws.h>
-#include <aws/s3/S3Client.h>
-#endif  // HAVE_AWS_S3
+#include "S3Client.h"
 
 // this is the based archive class for files hosted on AWS S3.
 // known variants:
@@ -36,17 +32,6 @@
 class S3Archive : public Archive {
  public:
   S3Archive(const std::string& url, const bool plain_text) : Archive(url, plain_text) {
-// init aws api should be singleton because because
-// it's bad to call Aws::InitAPI and Aws::ShutdownAPI
-// multiple times.
-#ifdef HAVE_AWS_S3
-    {
-      std::unique_lock<std::mutex> lck(awsapi_mtx);
-      if (0 == awsapi_count++)
-        Aws::InitAPI(awsapi_options);
-    }
-#endif  // HAVE_AWS_S3
-
     // these envs are on server side so are global settings
     // which make few senses in case of private s3 resources
     char* env;
@@ -79,9 +64,6 @@ class S3Archive : public Archive {
     for (auto& thread : threads)
       if (thread.joinable())
         thread.join();
-    std::unique_lock<std::mutex> lck(awsapi_mtx);
-    if (0 == --awsapi_count)
-      Aws::ShutdownAPI(awsapi_options);
 #endif  // HAVE_AWS_S3
   }
 
@@ -105,10 +87,8 @@ class S3Archive : public Archive {
 
  private:
 #ifdef HAVE_AWS_S3
-  static int awsapi_count;
-  static std::mutex awsapi_mtx;
-  static Aws::SDKOptions awsapi_options;
-
+  // before the client, which must go away while the api is initialized
+  AwsApiScope awsapi_scope;
   std::unique_ptr<Aws::S3::S3Client> s3_client;
   std::vector<std::thread> threads;
 #endif                        // HAVE_AWS_S3
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "S3Client.h"
+
+#include <aws/core/auth/AWSAuthSigner.h>
+#include <aws/core/auth/AWSCredentialsProvider.h>
+#include <boost/filesystem.hpp>
+
+#include <cstdlib>
+#include <list>
+
+int AwsApiScope::count_;
+std::mutex AwsApiScope::mutex_;
+Aws::SDKOptions AwsApiScope::options_;
+
+AwsApiScope::AwsApiScope() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (0 == count_++) {
+    Aws::InitAPI(options_);
+  }
+}
+
+AwsApiScope::~AwsApiScope() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (0 == --count_) {
+    Aws::ShutdownAPI(options_);
+  }
+}
+
+std::unique_ptr<Aws::S3::S3Client> create_s3_client(const std::string& region,
+                                                    const std::string& access_key,
+                                                    const std::string& secret_key,
+                                                    const std::string& endpoint,
+                                                    const bool default_credentials) {
+  Aws::Client::ClientConfiguration s3_config;
+  s3_config.region = region.size() ? region : Aws::Region::US_EAST_1;
+  if (!endpoint.empty()) {
+    s3_config.endpointOverride = endpoint;
+  }
+
+  /*
+     Fix a wrong ca path established at building libcurl on Centos being carried to
+     Ubuntu. To fix the issue, this is this sequence of locating ca file: 1) if
+     `SSL_CERT_DIR` or `SSL_CERT_FILE` is set, set it to S3 ClientConfiguration. 2) if
+     none ^ is set, mapd core searches a list of known ca file paths. 3) if 2) finds
+     nothing, it is users' call to set correct SSL_CERT_DIR or SSL_CERT_FILE. S3 c++
+     sdk: "we only want to override the default path if someone has explicitly told us
+     to."
+   */
+  std::list<std::string> v_known_ca_paths({
+      "/etc/ssl/certs/ca-certificates.crt",
+      "/etc/pki/tls/certs/ca-bundle.crt",
+      "/usr/share/ssl/certs/ca-bundle.crt",
+      "/usr/local/share/certs/ca-root.crt",
+      "/etc/ssl/cert.pem",
+      "/etc/ssl/ca-bundle.pem",
+  });
+  char* env;
+  if (nullptr != (env = getenv("SSL_CERT_DIR"))) {
+    s3_config.caPath = env;
+  }
+  if (nullptr != (env = getenv("SSL_CERT_FILE"))) {
+    v_known_ca_paths.push_front(env);
+  }
+  for (const auto& known_ca_path : v_known_ca_paths) {
+    if (boost::filesystem::exists(known_ca_path)) {
+      s3_config.caFile = known_ca_path;
+      break;
+    }
+  }
+
+  // The S3 compatible services mostly don't resolve the buckets as host names.
+  const bool use_virtual_addressing = endpoint.empty();
+  const auto signing_policy = Aws::Client::AWSAuthV4Signer::PayloadSigningPolicy::Never;
+  if (!access_key.empty() && !secret_key.empty()) {
+    return std::unique_ptr<Aws::S3::S3Client>(
+        new Aws::S3::S3Client(Aws::Auth::AWSCredentials(access_key, secret_key),
+                              s3_config,
+                              signing_policy,
+                              use_virtual_addressing));
+  }
+  if (default_credentials) {
+    return std::unique_ptr<Aws::S3::S3Client>(new Aws::S3::S3Client(
+        std::make_shared<Aws::Auth::DefaultAWSCredentialsProviderChain>(),
+        s3_config,
+        signing_policy,
+        use_virtual_addressing));
+  }
+  return std::unique_ptr<Aws::S3::S3Client>(new Aws::S3::S3Client(
+      std::make_shared<Aws::Auth::AnonymousAWSCredentialsProvider>(),
+      s3_config,
+      signing_policy,
+      use_virtual_addressing));
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    S3Client.h
+ * @brief   Setup of the AWS API and of the S3 clients, shared by the S3 archives of the
+ * importer and the cold storage of the data files.
+ */
+
+#ifndef ARCHIVE_S3CLIENT_H_
+#define ARCHIVE_S3CLIENT_H_
+
+#ifdef HAVE_AWS_S3
+
+#include <aws/core/Aws.h>
+#include <aws/s3/S3Client.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Keeps the AWS API initialized as long as an instance lives. The API must not be
+// initialized and shut down repeatedly, so only the first instance initializes it and
+// only the last one shuts it down.
+class AwsApiScope {
+ public:
+  AwsApiScope();
+  ~AwsApiScope();
+
+  AwsApiScope(const AwsApiScope&) = delete;
+  AwsApiScope& operator=(const AwsApiScope&) = delete;
+
+ private:
+  static int count_;
+  static std::mutex mutex_;
+  static Aws::SDKOptions options_;
+};
+
+// A client of the region, us-east-1 if empty, on AWS or on the S3 compatible service at
+// endpoint, addressed by path in that case. Without an access key, the requests are
+// anonymous, or signed with the credentials of the default provider chain (environment,
+// ~/.aws/credentials, instance profile) if default_credentials is set. The CA file is
+// located the way SSL_CERT_DIR and SSL_CERT_FILE say, or among the usual paths.
+std::unique_ptr<Aws::S3::S3Client> create_s3_client(const std::string& region,
+                                                    const std::string& access_key,
+                                                    const std::string& secret_key,
+                                                    const std::string& endpoint,
+                                                    const bool default_credentials);
+
+#endif  // HAVE_AWS_S3
+
+#endif  // ARCHIVE_S3CLIENT_H_
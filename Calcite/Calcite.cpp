@@ -35,6 +35,7 @@
 #include "Shared/fixautotools.h"
 
 #include <thrift/protocol/TBinaryProtocol.h>
+#include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/TSocket.h>
 #include <thrift/transport/TTransportUtils.h>
 
@@ -42,6 +43,10 @@
 
 #include "gen-cpp/CalciteServer.h"
 
+#ifdef HAVE_CALCITE_JNI
+#include <jni.h>
+#endif  // HAVE_CALCITE_JNI
+
 using namespace rapidjson;
 using namespace apache::thrift;
 using namespace apache::thrift::protocol;
@@ -133,6 +138,300 @@ std::pair<mapd::shared_ptr<CalciteServerClient>, mapd::shared_ptr<TTransport>> g
   return std::make_pair(client, transport);
 }
 
+#ifdef HAVE_CALCITE_JNI
+
+struct CalciteJni {
+  JavaVM* jvm;
+  jobject calcite_direct;
+  jmethodID process;
+  jmethodID update_metadata;
+  jmethodID get_extension_function_whitelist;
+  jmethodID get_completion_hints;
+};
+
+namespace {
+
+// A process can only create one JVM, the first Calcite running in process does.
+JavaVM* get_calcite_jvm(const std::string& data_dir, const size_t calcite_max_mem) {
+  static std::mutex jvm_mutex;
+  static JavaVM* jvm{nullptr};
+  std::lock_guard<std::mutex> lock(jvm_mutex);
+  if (jvm) {
+    return jvm;
+  }
+  std::string class_path = "-Djava.class.path=" + mapd_root_abs_path() +
+                           "/bin/calcite-1.0-SNAPSHOT-jar-with-dependencies.jar";
+  std::string max_mem = "-Xmx" + std::to_string(calcite_max_mem) + "m";
+  std::string log_dir = "-DMAPD_LOG_DIR=" + data_dir;
+  std::vector<JavaVMOption> options(3);
+  options[0].optionString = &class_path[0];
+  options[1].optionString = &max_mem[0];
+  options[2].optionString = &log_dir[0];
+  JavaVMInitArgs vm_args;
+  vm_args.version = JNI_VERSION_1_6;
+  vm_args.nOptions = options.size();
+  vm_args.options = options.data();
+  vm_args.ignoreUnrecognized = JNI_FALSE;
+  JNIEnv* env{nullptr};
+  if (JNI_CreateJavaVM(&jvm, reinterpret_cast<void**>(&env), &vm_args) != JNI_OK) {
+    LOG(FATAL) << "Could not create the JVM to run Calcite in process";
+  }
+  return jvm;
+}
+
+// The threads of the server are attached as daemons, they don't hold the JVM up.
+JNIEnv* attach_current_thread(JavaVM* jvm) {
+  JNIEnv* env{nullptr};
+  if (jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) == JNI_EDETACHED) {
+    CHECK_EQ(JNI_OK,
+             jvm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env), nullptr));
+  }
+  CHECK(env);
+  return env;
+}
+
+// The attached threads never return to Java, which is where the local references are
+// released otherwise.
+class JniLocalFrame {
+ public:
+  JniLocalFrame(JNIEnv* env) : env_(env) { CHECK_EQ(0, env_->PushLocalFrame(32)); }
+  ~JniLocalFrame() { env_->PopLocalFrame(nullptr); }
+
+ private:
+  JNIEnv* env_;
+};
+
+std::string from_java_string(JNIEnv* env, jstring str) {
+  const auto chars = env->GetStringUTFChars(str, nullptr);
+  std::string result(chars);
+  env->ReleaseStringUTFChars(str, chars);
+  return result;
+}
+
+// Rethrows the pending Java exception, invalid requests the same way as the Thrift
+// client does.
+void check_java_exception(JNIEnv* env) {
+  const auto exception = env->ExceptionOccurred();
+  if (!exception) {
+    return;
+  }
+  env->ExceptionClear();
+  const auto get_message = env->GetMethodID(
+      env->FindClass("java/lang/Throwable"), "getMessage", "()Ljava/lang/String;");
+  const auto message =
+      static_cast<jstring>(env->CallObjectMethod(exception, get_message));
+  const auto what = message ? from_java_string(env, message) : "Calcite error";
+  if (env->IsInstanceOf(exception,
+                        env->FindClass("java/lang/IllegalArgumentException"))) {
+    throw std::invalid_argument(what);
+  }
+  throw std::runtime_error(what);
+}
+
+template <class T>
+void deserialize_thrift(JNIEnv* env, jbyteArray bytes, T& result) {
+  const auto len = env->GetArrayLength(bytes);
+  const auto elems = env->GetByteArrayElements(bytes, nullptr);
+  mapd::shared_ptr<TMemoryBuffer> buffer(
+      new TMemoryBuffer(reinterpret_cast<uint8_t*>(elems), len));
+  TBinaryProtocol protocol(buffer);
+  result.read(&protocol);
+  env->ReleaseByteArrayElements(bytes, elems, JNI_ABORT);
+}
+
+std::unique_ptr<CalciteJni> create_calcite_jni(const int mapd_port,
+                                               const std::string& data_dir,
+                                               const size_t calcite_max_mem,
+                                               const std::string& ssl_trust_store,
+                                               const std::string& ssl_trust_password) {
+  auto calcite_jni = std::make_unique<CalciteJni>();
+  calcite_jni->jvm = get_calcite_jvm(data_dir, calcite_max_mem);
+  auto env = attach_current_thread(calcite_jni->jvm);
+  JniLocalFrame local_frame(env);
+  const auto calcite_direct_class =
+      env->FindClass("com/mapd/parser/server/CalciteDirect");
+  check_java_exception(env);
+  const auto constructor = env->GetMethodID(
+      calcite_direct_class,
+      "<init>",
+      "(ILjava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+  const auto calcite_direct =
+      env->NewObject(calcite_direct_class,
+                     constructor,
+                     static_cast<jint>(mapd_port),
+                     env->NewStringUTF(data_dir.c_str()),
+                     env->NewStringUTF((mapd_root_abs_path() + "/QueryEngine/").c_str()),
+                     env->NewStringUTF(ssl_trust_store.c_str()),
+                     env->NewStringUTF(ssl_trust_password.c_str()));
+  check_java_exception(env);
+  calcite_jni->calcite_direct = env->NewGlobalRef(calcite_direct);
+  calcite_jni->process = env->GetMethodID(
+      calcite_direct_class,
+      "process",
+      "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;[IZZ)[B");
+  calcite_jni->update_metadata = env->GetMethodID(
+      calcite_direct_class, "updateMetadata", "(Ljava/lang/String;Ljava/lang/String;)V");
+  calcite_jni->get_extension_function_whitelist = env->GetMethodID(
+      calcite_direct_class, "getExtensionFunctionWhitelist", "()Ljava/lang/String;");
+  calcite_jni->get_completion_hints =
+      env->GetMethodID(calcite_direct_class,
+                       "getCompletionHints",
+                       "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;[Ljava/"
+                       "lang/String;Ljava/lang/String;I)[[B");
+  check_java_exception(env);
+  return calcite_jni;
+}
+
+TPlanResult process_jni(const CalciteJni& calcite_jni,
+                        const std::string& user,
+                        const std::string& session,
+                        const std::string& catalog,
+                        const std::string& sql_string,
+                        const std::vector<TFilterPushDownInfo>& filter_push_down_info,
+                        const bool legacy_syntax,
+                        const bool is_explain) {
+  auto env = attach_current_thread(calcite_jni.jvm);
+  JniLocalFrame local_frame(env);
+  std::vector<jint> flat_filter_push_down_info;
+  for (const auto& push_down_info : filter_push_down_info) {
+    flat_filter_push_down_info.push_back(push_down_info.input_prev);
+    flat_filter_push_down_info.push_back(push_down_info.input_start);
+    flat_filter_push_down_info.push_back(push_down_info.input_next);
+  }
+  const auto java_filter_push_down_info =
+      env->NewIntArray(flat_filter_push_down_info.size());
+  env->SetIntArrayRegion(java_filter_push_down_info,
+                         0,
+                         flat_filter_push_down_info.size(),
+                         flat_filter_push_down_info.data());
+  const auto plan_bytes = static_cast<jbyteArray>(
+      env->CallObjectMethod(calcite_jni.calcite_direct,
+                            calcite_jni.process,
+                            env->NewStringUTF(user.c_str()),
+                            env->NewStringUTF(session.c_str()),
+                            env->NewStringUTF(catalog.c_str()),
+                            env->NewStringUTF(sql_string.c_str()),
+                            java_filter_push_down_info,
+                            static_cast<jboolean>(legacy_syntax),
+                            static_cast<jboolean>(is_explain)));
+  check_java_exception(env);
+  TPlanResult result;
+  deserialize_thrift(env, plan_bytes, result);
+  return result;
+}
+
+void update_metadata_jni(const CalciteJni& calcite_jni,
+                         const std::string& catalog,
+                         const std::string& table) {
+  auto env = attach_current_thread(calcite_jni.jvm);
+  JniLocalFrame local_frame(env);
+  env->CallVoidMethod(calcite_jni.calcite_direct,
+                      calcite_jni.update_metadata,
+                      env->NewStringUTF(catalog.c_str()),
+                      env->NewStringUTF(table.c_str()));
+  check_java_exception(env);
+}
+
+std::string get_extension_function_whitelist_jni(const CalciteJni& calcite_jni) {
+  auto env = attach_current_thread(calcite_jni.jvm);
+  JniLocalFrame local_frame(env);
+  const auto whitelist = static_cast<jstring>(
+      env->CallObjectMethod(calcite_jni.calcite_direct,
+                            calcite_jni.get_extension_function_whitelist));
+  check_java_exception(env);
+  return from_java_string(env, whitelist);
+}
+
+std::vector<TCompletionHint> get_completion_hints_jni(
+    const CalciteJni& calcite_jni,
+    const std::string& user,
+    const std::string& session,
+    const std::string& catalog,
+    const std::vector<std::string>& visible_tables,
+    const std::string& sql_string,
+    const int cursor) {
+  auto env = attach_current_thread(calcite_jni.jvm);
+  JniLocalFrame local_frame(env);
+  const auto java_visible_tables = env->NewObjectArray(
+      visible_tables.size(), env->FindClass("java/lang/String"), nullptr);
+  for (size_t i = 0; i < visible_tables.size(); ++i) {
+    env->SetObjectArrayElement(
+        java_visible_tables, i, env->NewStringUTF(visible_tables[i].c_str()));
+  }
+  const auto hints_bytes = static_cast<jobjectArray>(
+      env->CallObjectMethod(calcite_jni.calcite_direct,
+                            calcite_jni.get_completion_hints,
+                            env->NewStringUTF(user.c_str()),
+                            env->NewStringUTF(session.c_str()),
+                            env->NewStringUTF(catalog.c_str()),
+                            java_visible_tables,
+                            env->NewStringUTF(sql_string.c_str()),
+                            static_cast<jint>(cursor)));
+  check_java_exception(env);
+  std::vector<TCompletionHint> hints(env->GetArrayLength(hints_bytes));
+  for (size_t i = 0; i < hints.size(); ++i) {
+    const auto hint_bytes =
+        static_cast<jbyteArray>(env->GetObjectArrayElement(hints_bytes, i));
+    deserialize_thrift(env, hint_bytes, hints[i]);
+    env->DeleteLocalRef(hint_bytes);
+  }
+  return hints;
+}
+
+void destroy_calcite_jni(const CalciteJni& calcite_jni) {
+  auto env = attach_current_thread(calcite_jni.jvm);
+  env->DeleteGlobalRef(calcite_jni.calcite_direct);
+}
+
+}  // namespace
+
+#else
+
+// Never created without JNI.
+struct CalciteJni {};
+
+namespace {
+
+TPlanResult process_jni(const CalciteJni&,
+                        const std::string&,
+                        const std::string&,
+                        const std::string&,
+                        const std::string&,
+                        const std::vector<TFilterPushDownInfo>&,
+                        const bool,
+                        const bool) {
+  CHECK(false);
+  return {};
+}
+
+void update_metadata_jni(const CalciteJni&, const std::string&, const std::string&) {
+  CHECK(false);
+}
+
+std::string get_extension_function_whitelist_jni(const CalciteJni&) {
+  CHECK(false);
+  return "";
+}
+
+std::vector<TCompletionHint> get_completion_hints_jni(const CalciteJni&,
+                                                      const std::string&,
+                                                      const std::string&,
+                                                      const std::string&,
+                                                      const std::vector<std::string>&,
+                                                      const std::string&,
+                                                      const int) {
+  CHECK(false);
+  return {};
+}
+
+void destroy_calcite_jni(const CalciteJni&) {
+  CHECK(false);
+}
+
+}  // namespace
+
+#endif  // HAVE_CALCITE_JNI
+
 void Calcite::runServer(const int mapd_port,
                         const int port,
                         const std::string& data_dir,
@@ -214,7 +513,15 @@ void Calcite::init(const int mapd_port,
   LOG(INFO) << "Creating Calcite Handler,  Calcite Port is " << calcite_port
             << " base data dir is " << data_dir;
   if (calcite_port < 0) {
-    CHECK(false) << "JNI mode no longer supported.";
+#ifdef HAVE_CALCITE_JNI
+    // no server to start nor to reach through a socket, Calcite runs in process
+    calcite_jni_ = create_calcite_jni(
+        mapd_port, data_dir, calcite_max_mem, ssl_trust_store_, ssl_trust_password_);
+    server_available_ = true;
+    return;
+#else
+    CHECK(false) << "Running Calcite in process not supported by this build.";
+#endif  // HAVE_CALCITE_JNI
   }
   if (calcite_port == 0) {
     // dummy process for initdb
@@ -232,7 +539,8 @@ Calcite::Calcite(const MapDParameters& mapd_parameter,
                  const std::string& session_prefix)
     : ssl_trust_store_(mapd_parameter.ssl_trust_store)
     , ssl_trust_password_(mapd_parameter.ssl_trust_password)
-    , session_prefix_(session_prefix) {
+    , session_prefix_(session_prefix)
+    , plan_cache_max_entries_(mapd_parameter.calcite_plan_cache_size) {
   init(mapd_parameter.mapd_server_port,
        mapd_parameter.calcite_port,
        data_dir,
@@ -240,8 +548,14 @@ Calcite::Calcite(const MapDParameters& mapd_parameter,
 }
 
 void Calcite::updateMetadata(std::string catalog, std::string table) {
+  // Views can read the table, don't bother finding the plans it affects.
+  clearPlanCache();
   if (server_available_) {
     auto ms = measure<>::execution([&]() {
+      if (calcite_jni_) {
+        update_metadata_jni(*calcite_jni_, catalog, table);
+        return;
+      }
       std::pair<mapd::shared_ptr<CalciteServerClient>, mapd::shared_ptr<TTransport>>
           clientP = get_client(remote_calcite_port_);
       clientP.first->updateMetadata(catalog, table);
@@ -295,8 +609,25 @@ TPlanResult Calcite::process(
     const std::vector<TFilterPushDownInfo>& filter_push_down_info,
     const bool legacy_syntax,
     const bool is_explain) {
-  TPlanResult result = processImpl(
-      session_info, sql_string, filter_push_down_info, legacy_syntax, is_explain);
+  // The plans with pushed down filters depend on the first run of the query.
+  const bool use_plan_cache = plan_cache_max_entries_ && server_available_ &&
+                              filter_push_down_info.empty() && !is_explain;
+  const auto cache_key = use_plan_cache
+                             ? session_info.get_catalog().get_currentDB().dbName + '\n' +
+                                   (legacy_syntax ? "1" : "0") + '\n' + sql_string
+                             : std::string();
+  const auto cached_plan = use_plan_cache ? getCachedPlan(cache_key) : nullptr;
+  TPlanResult result;
+  if (cached_plan) {
+    result = *cached_plan;
+    result.execution_time_ms = 0;
+  } else {
+    result = processImpl(
+        session_info, sql_string, filter_push_down_info, legacy_syntax, is_explain);
+    if (use_plan_cache) {
+      putCachedPlan(cache_key, result);
+    }
+  }
 
   AccessPrivileges NOOP;
 
@@ -323,6 +654,35 @@ TPlanResult Calcite::process(
   return result;
 }
 
+std::shared_ptr<TPlanResult> Calcite::getCachedPlan(const std::string& key) {
+  std::lock_guard<std::mutex> lock(plan_cache_mutex_);
+  const auto it = plan_cache_index_.find(key);
+  if (it == plan_cache_index_.end()) {
+    return nullptr;
+  }
+  plan_cache_.splice(plan_cache_.begin(), plan_cache_, it->second);
+  return it->second->second;
+}
+
+void Calcite::putCachedPlan(const std::string& key, const TPlanResult& plan) {
+  std::lock_guard<std::mutex> lock(plan_cache_mutex_);
+  if (plan_cache_index_.count(key)) {
+    return;
+  }
+  while (plan_cache_.size() >= plan_cache_max_entries_) {
+    plan_cache_index_.erase(plan_cache_.back().first);
+    plan_cache_.pop_back();
+  }
+  plan_cache_.emplace_front(key, std::make_shared<TPlanResult>(plan));
+  plan_cache_index_.emplace(key, plan_cache_.begin());
+}
+
+void Calcite::clearPlanCache() {
+  std::lock_guard<std::mutex> lock(plan_cache_mutex_);
+  plan_cache_.clear();
+  plan_cache_index_.clear();
+}
+
 std::vector<TCompletionHint> Calcite::getCompletionHints(
     const Catalog_Namespace::SessionInfo& session_info,
     const std::vector<std::string>& visible_tables,
@@ -333,6 +693,10 @@ std::vector<TCompletionHint> Calcite::getCompletionHints(
   const auto user = session_info.get_currentUser().userName;
   const auto session = session_info.get_session_id();
   const auto catalog = cat.get_currentDB().dbName;
+  if (calcite_jni_) {
+    return get_completion_hints_jni(
+        *calcite_jni_, user, session, catalog, visible_tables, sql_string, cursor);
+  }
   auto client = get_client(remote_calcite_port_);
   client.first->getCompletionHints(
       hints, user, session, catalog, visible_tables, sql_string, cursor);
@@ -374,6 +738,23 @@ TPlanResult Calcite::processImpl(
   std::string catalog = cat.get_currentDB().dbName;
 
   LOG(INFO) << "User " << user << " catalog " << catalog << " sql '" << sql_string << "'";
+  if (calcite_jni_) {
+    TPlanResult ret;
+    auto ms = measure<>::execution([&]() {
+      ret = process_jni(*calcite_jni_,
+                        user,
+                        session,
+                        catalog,
+                        sql_string,
+                        filter_push_down_info,
+                        legacy_syntax,
+                        is_explain);
+    });
+    LOG(INFO) << "Time in JNI "
+              << (ms > ret.execution_time_ms ? ms - ret.execution_time_ms : 0)
+              << " (ms), Time in Java Calcite " << ret.execution_time_ms << " (ms)";
+    return ret;
+  }
   if (server_available_) {
     TPlanResult ret;
     try {
@@ -409,6 +790,9 @@ TPlanResult Calcite::processImpl(
 }
 
 std::string Calcite::getExtensionFunctionWhitelist() {
+  if (calcite_jni_) {
+    return get_extension_function_whitelist_jni(*calcite_jni_);
+  }
   if (server_available_) {
     TPlanResult ret;
     std::string whitelist;
@@ -428,6 +812,13 @@ std::string Calcite::getExtensionFunctionWhitelist() {
 }
 
 void Calcite::close_calcite_server() {
+  if (calcite_jni_) {
+    // the JVM stays up, a process can't create another one
+    destroy_calcite_jni(*calcite_jni_);
+    calcite_jni_.reset();
+    server_available_ = false;
+    return;
+  }
   if (server_available_) {
     LOG(INFO) << "Shutting down Calcite server";
     try {
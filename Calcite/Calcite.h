@@ -24,8 +24,12 @@
 #ifndef CALCITE_H
 #define CALCITE_H
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 #include "Shared/MapDParameters.h"
 #include "rapidjson/document.h"
@@ -39,6 +43,9 @@ class TFilterPushDownInfo;
 class TPlanResult;
 class TCompletionHint;
 
+// The JVM and the planner object of Calcite run in process, see Calcite.cpp.
+struct CalciteJni;
+
 class Calcite {
  public:
   Calcite(const int mapd_port,
@@ -86,15 +93,27 @@ class Calcite {
                           const bool legacy_syntax,
                           const bool is_explain);
   std::vector<std::string> get_db_objects(const std::string ra);
+  std::shared_ptr<TPlanResult> getCachedPlan(const std::string& key);
+  void putCachedPlan(const std::string& key, const TPlanResult& plan);
+  void clearPlanCache();
 
   std::thread calcite_server_thread_;
   int ping();
 
   bool server_available_;
   int remote_calcite_port_ = -1;
+  // Set if Calcite runs in process (negative port), the requests go through JNI.
+  std::unique_ptr<CalciteJni> calcite_jni_;
   std::string ssl_trust_store_;
   std::string ssl_trust_password_;
   std::string session_prefix_;
+
+  // Plans of the repeated queries, keyed on the catalog and the SQL text and cleared
+  // whenever the metadata Calcite knows changes. Most recently used first.
+  size_t plan_cache_max_entries_ = 0;
+  std::list<std::pair<std::string, std::shared_ptr<TPlanResult>>> plan_cache_;
+  std::unordered_map<std::string, decltype(plan_cache_)::iterator> plan_cache_index_;
+  std::mutex plan_cache_mutex_;
 };
 
 #endif /* CALCITE_H */
@@ -29,8 +29,10 @@
 #include <list>
 #include <memory>
 #include <random>
+#include <sstream>
 
 #include "Catalog/AuthMetadata.h"
+#include "CatalogSnapshot.h"
 #include "DataMgr/LockMgr.h"
 #include "SharedDictionaryValidator.h"
 
@@ -44,6 +46,7 @@
 
 #include "../Fragmenter/Fragmenter.h"
 #include "../Fragmenter/InsertOrderFragmenter.h"
+#include "../Fragmenter/ParquetFragmenter.h"
 #include "../Parser/ParserNode.h"
 #include "../Shared/StringTransform.h"
 #include "../Shared/measure.h"
@@ -54,6 +57,7 @@
 
 using Chunk_NS::Chunk;
 using Fragmenter_Namespace::InsertOrderFragmenter;
+using Fragmenter_Namespace::ParquetFragmenter;
 using std::list;
 using std::map;
 using std::pair;
@@ -62,6 +66,8 @@ using std::string;
 using std::vector;
 
 bool g_aggregator{false};
+bool g_enable_catalog_snapshot{true};
+size_t g_credential_cache_seconds{300};
 
 int g_test_against_columnId_gap = 0;
 
@@ -74,6 +80,26 @@ std::string hash_with_bcrypt(const std::string& pwd) {
   return std::string(hash, BCRYPT_HASHSIZE);
 }
 
+std::string salted_password_digest(const std::string& salt, const std::string& pwd) {
+  boost::uuids::detail::sha1 sha1;
+  sha1.process_bytes(salt.data(), salt.size());
+  sha1.process_bytes(pwd.data(), pwd.size());
+  unsigned int digest[5];
+  sha1.get_digest(digest);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+// Every string dictionary server holds a shard of each dictionary, see StringDictionary.
+std::vector<std::unique_ptr<StringDictionaryClient>> string_dict_clients(
+    const std::vector<LeafHostInfo>& hosts,
+    const DictRef dict_ref) {
+  std::vector<std::unique_ptr<StringDictionaryClient>> clients;
+  for (const auto& host : hosts) {
+    clients.emplace_back(new StringDictionaryClient(host, dict_ref, true));
+  }
+  return clients;
+}
+
 }  // namespace
 
 namespace Catalog_Namespace {
@@ -168,6 +194,14 @@ class sqlite_lock {
   }
 };
 
+// The lookups through the metadata snapshot of a catalog fall back to the lock while a
+// writer holds it, they don't have to for the system catalog.
+void invalidate_metadata_snapshot(const Catalog* cat) {
+  cat->invalidateMetadataSnapshot();
+}
+
+void invalidate_metadata_snapshot(const SysCatalog*) {}
+
 template <typename T>
 class write_lock {
   const T* catalog;
@@ -192,9 +226,11 @@ class write_lock {
     } else {
       lock_catalog(cat);
     }
+    invalidate_metadata_snapshot(catalog);
   }
 
   ~write_lock() {
+    invalidate_metadata_snapshot(catalog);
     if (holds_lock) {
       std::thread::id no_thread;
       if (catalog->name() == MAPD_SYSTEM_DB) {
@@ -231,6 +267,14 @@ void SysCatalog::init(const std::string& basePath,
   calciteMgr_ = calcite;
   check_privileges_ = check_privileges;
   string_dict_hosts_ = string_dict_hosts;
+  {
+    std::random_device rd;
+    std::uniform_int_distribution<int> dist(0, 255);
+    credentialSalt_.clear();
+    for (size_t i = 0; i < 16; ++i) {
+      credentialSalt_.push_back(static_cast<char>(dist(rd)));
+    }
+  }
   sqliteConnector_.reset(
       new SqliteConnector(MAPD_SYSTEM_DB, basePath + "/mapd_catalogs/"));
   if (is_new_db) {
@@ -703,8 +747,8 @@ std::shared_ptr<Catalog> SysCatalog::login(const std::string& dbname,
     throw std::runtime_error("Database " + dbname + " does not exist.");
   }
 
-  sys_write_lock write_lock(this);
-
+  // the password check doesn't need the lock, the logins of other users and the
+  // lookups of the catalogs go on meanwhile
   {
     bool userPresent = getMetadataForUser(username, user_meta);
 
@@ -718,6 +762,8 @@ std::shared_ptr<Catalog> SysCatalog::login(const std::string& dbname,
     }
   }
 
+  sys_write_lock write_lock(this);
+
   if (!arePrivilegesOn()) {
     // insert privilege is being treated as access allowed for now
     Privileges privs;
@@ -730,11 +776,16 @@ std::shared_ptr<Catalog> SysCatalog::login(const std::string& dbname,
     }
   }
 
-  auto cat = Catalog::get(dbname);
+  return getCatalog(db_meta);
+}
+
+std::shared_ptr<Catalog> SysCatalog::getCatalog(const DBMetadata& db_meta) {
+  sys_write_lock write_lock(this);
+  auto cat = Catalog::get(db_meta.dbName);
   if (cat == nullptr) {
     cat = std::make_shared<Catalog>(
         basePath_, db_meta, dataMgr_, *string_dict_hosts_, calciteMgr_);
-    Catalog::set(dbname, cat);
+    Catalog::set(db_meta.dbName, cat);
   }
 
   return cat;
@@ -920,6 +971,13 @@ void SysCatalog::createDatabase(const string& name, int owner) {
   dbConn.query(
       "CREATE TABLE mapd_logical_to_physical(logical_table_id integer, physical_table_id "
       "integer)");
+  dbConn.query(
+      "CREATE TABLE mapd_materialized_views(viewid integer primary key, source_tableid "
+      "integer, state_tableid integer, sql text, refreshed_rows bigint)");
+  dbConn.query(
+      "CREATE TABLE mapd_column_statistics(tableid integer, columnid integer, row_count "
+      "bigint, null_count bigint, distinct_count bigint, histogram text, primary "
+      "key(tableid, columnid))");
 }
 
 void SysCatalog::dropDatabase(const int32_t dbid,
@@ -956,6 +1014,7 @@ void SysCatalog::dropDatabase(const int32_t dbid,
     sqliteConnector_->query_with_text_param("DELETE FROM mapd_databases WHERE dbid = ?",
                                             std::to_string(dbid));
     boost::filesystem::remove(basePath_ + "/mapd_catalogs/" + name);
+    boost::filesystem::remove(basePath_ + "/mapd_catalogs/" + name + ".snapshot");
     ChunkKey chunkKeyPrefix = {dbid};
     calciteMgr_->updateMetadata(name, "");
     dataMgr_->deleteChunksWithPrefix(chunkKeyPrefix);
@@ -969,6 +1028,21 @@ void SysCatalog::dropDatabase(const int32_t dbid,
 }
 
 bool SysCatalog::checkPasswordForUser(const std::string& passwd, UserMetadata& user) {
+  const auto now = std::chrono::steady_clock::now();
+  std::string passwd_digest;
+  if (g_credential_cache_seconds) {
+    passwd_digest = salted_password_digest(credentialSalt_, passwd);
+    std::lock_guard<std::mutex> lock(credentialCacheMutex_);
+    const auto it = verifiedCredentials_.find(user.userName);
+    if (it != verifiedCredentials_.end()) {
+      // a changed password has another stored hash
+      if (it->second.expiry > now && it->second.passwd_hash == user.passwd_hash &&
+          it->second.passwd_digest == passwd_digest) {
+        return true;
+      }
+      verifiedCredentials_.erase(it);
+    }
+  }
   {
     int pwd_check_result = bcrypt_checkpw(passwd.c_str(), user.passwd_hash.c_str());
     // if the check fails there is a good chance that data on disc is broken
@@ -977,6 +1051,13 @@ bool SysCatalog::checkPasswordForUser(const std::string& passwd, UserMetadata& u
       return false;
     }
   }
+  if (g_credential_cache_seconds) {
+    std::lock_guard<std::mutex> lock(credentialCacheMutex_);
+    verifiedCredentials_[user.userName] = {
+        user.passwd_hash,
+        passwd_digest,
+        now + std::chrono::seconds(g_credential_cache_seconds)};
+  }
   return true;
 }
 
@@ -1786,6 +1867,41 @@ void Catalog::updateTableDescriptorSchema() {
                          std::to_string(MAPD_ROOT_USER_ID));
       sqliteConnector_.query(queryString);
     }
+    if (std::find(cols.begin(), cols.end(), std::string("sort_column_id")) ==
+        cols.end()) {
+      string queryString("ALTER TABLE mapd_tables ADD sort_column_id integer DEFAULT " +
+                         std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
+    if (std::find(cols.begin(), cols.end(), std::string("partition_interval")) ==
+        cols.end()) {
+      string queryString(
+          "ALTER TABLE mapd_tables ADD partition_interval BIGINT DEFAULT " +
+          std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
+    if (std::find(cols.begin(), cols.end(), std::string("retention")) == cols.end()) {
+      string queryString("ALTER TABLE mapd_tables ADD retention BIGINT DEFAULT " +
+                         std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
+    if (std::find(cols.begin(), cols.end(), std::string("index_column_id")) ==
+        cols.end()) {
+      string queryString("ALTER TABLE mapd_tables ADD index_column_id integer DEFAULT " +
+                         std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
+    if (std::find(cols.begin(), cols.end(), std::string("primary_key_column_id")) ==
+        cols.end()) {
+      string queryString(
+          "ALTER TABLE mapd_tables ADD primary_key_column_id integer DEFAULT " +
+          std::to_string(0));
+      sqliteConnector_.query(queryString);
+    }
+    if (std::find(cols.begin(), cols.end(), std::string("external_path")) ==
+        cols.end()) {
+      sqliteConnector_.query("ALTER TABLE mapd_tables ADD external_path text DEFAULT ''");
+    }
   } catch (std::exception& e) {
     sqliteConnector_.query("ROLLBACK TRANSACTION");
     throw;
@@ -2005,6 +2121,64 @@ void Catalog::updateLogicalToPhysicalTableLinkSchema() {
   sqliteConnector_.query("END TRANSACTION");
 }
 
+void Catalog::updateMaterializedViewSchema() {
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query(
+        "CREATE TABLE IF NOT EXISTS mapd_materialized_views(viewid integer primary key, "
+        "source_tableid integer, state_tableid integer, sql text, refreshed_rows "
+        "bigint)");
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+}
+
+void Catalog::updateColumnStatisticsSchema() {
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query(
+        "CREATE TABLE IF NOT EXISTS mapd_column_statistics(tableid integer, columnid "
+        "integer, row_count bigint, null_count bigint, distinct_count bigint, histogram "
+        "text, primary key(tableid, columnid))");
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+}
+
+// The catalog snapshot is tagged with the version, the triggers bump it on every change
+// to the rows the snapshot copies.
+void Catalog::updateCatalogVersionSchema() {
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query(
+        "CREATE TABLE IF NOT EXISTS mapd_catalog_version(version bigint)");
+    sqliteConnector_.query("SELECT count(*) FROM mapd_catalog_version");
+    if (!sqliteConnector_.getData<int>(0, 0)) {
+      sqliteConnector_.query("INSERT INTO mapd_catalog_version VALUES (0)");
+    }
+    for (const std::string table :
+         {"mapd_dictionaries", "mapd_tables", "mapd_columns", "mapd_views"}) {
+      for (const std::string event : {"insert", "update", "delete"}) {
+        sqliteConnector_.query("CREATE TRIGGER IF NOT EXISTS " + table + "_" + event +
+                               "_version AFTER " + to_upper(event) + " ON " + table +
+                               " BEGIN UPDATE mapd_catalog_version SET version = "
+                               "version + 1; END");
+      }
+    }
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+}
+
 void Catalog::updateLogicalToPhysicalTableMap(const int32_t logical_tb_id) {
   /* this proc inserts/updates all pairs of (logical_tb_id, physical_tb_id) in
    * sqlite mapd_logical_to_physical table for given logical_tb_id as needed
@@ -2206,6 +2380,9 @@ void Catalog::CheckAndExecuteMigrations() {
   updatePageSize();
   updateDeletedColumnIndicator();
   updateFrontendViewsToDashboards();
+  updateMaterializedViewSchema();
+  updateColumnStatisticsSchema();
+  updateCatalogVersionSchema();
   recordOwnershipOfObjectsInObjectPermissions();
 }
 
@@ -2362,6 +2539,26 @@ std::string getUserFromId(const int32_t id) {
   // a user could be deleted and a dashboard still exist?
   return "Unknown";
 }
+
+// The histogram bounds are kept in the catalog as text, separated by commas.
+std::string serialize_histogram(const std::vector<double>& histogram) {
+  std::ostringstream oss;
+  oss.precision(17);
+  for (size_t i = 0; i < histogram.size(); ++i) {
+    oss << (i ? "," : "") << histogram[i];
+  }
+  return oss.str();
+}
+
+std::vector<double> deserialize_histogram(const std::string& str) {
+  std::vector<double> histogram;
+  std::istringstream iss(str);
+  std::string bound;
+  while (std::getline(iss, bound, ',')) {
+    histogram.push_back(std::stod(bound));
+  }
+  return histogram;
+}
 }  // namespace
 
 void Catalog::buildMaps() {
@@ -2373,84 +2570,47 @@ void Catalog::buildMaps() {
 
   CheckAndExecuteMigrations();
 
-  string dictQuery(
-      "SELECT dictid, name, nbits, is_shared, refcount from mapd_dictionaries");
-  sqliteConnector_.query(dictQuery);
-  size_t numRows = sqliteConnector_.getNumRows();
-  for (size_t r = 0; r < numRows; ++r) {
-    int dictId = sqliteConnector_.getData<int>(r, 0);
-    std::string dictName = sqliteConnector_.getData<string>(r, 1);
-    int dictNBits = sqliteConnector_.getData<int>(r, 2);
-    bool is_shared = sqliteConnector_.getData<bool>(r, 3);
-    int refcount = sqliteConnector_.getData<int>(r, 4);
+  CatalogSnapshot snapshot;
+  const auto version = getCatalogVersion();
+  const auto snapshot_path = getCatalogSnapshotPath();
+  if (!g_enable_catalog_snapshot || !read_catalog_snapshot(snapshot, snapshot_path) ||
+      snapshot.version != version || snapshot.dbId != currentDB_.dbId) {
+    snapshot = CatalogSnapshot();
+    snapshot.version = version;
+    snapshot.dbId = currentDB_.dbId;
+    loadCatalogSnapshotFromSqlite(snapshot);
+    if (g_enable_catalog_snapshot) {
+      write_catalog_snapshot(snapshot, snapshot_path);
+    }
+  }
+
+  for (const auto& snapshot_dd : snapshot.dicts) {
+    const int dictId = snapshot_dd.dictRef.dictId;
     std::string fname = basePath_ + "/mapd_data/DB_" + std::to_string(currentDB_.dbId) +
                         "_DICT_" + std::to_string(dictId);
     DictRef dict_ref(currentDB_.dbId, dictId);
-    DictDescriptor* dd = new DictDescriptor(
-        dict_ref, dictName, dictNBits, is_shared, refcount, fname, false);
+    DictDescriptor* dd = new DictDescriptor(dict_ref,
+                                            snapshot_dd.dictName,
+                                            snapshot_dd.dictNBits,
+                                            snapshot_dd.dictIsShared,
+                                            snapshot_dd.refcount,
+                                            fname,
+                                            false);
     dictDescriptorMapByRef_[dict_ref].reset(dd);
   }
 
-  string tableQuery(
-      "SELECT tableid, name, ncolumns, isview, fragments, frag_type, max_frag_rows, "
-      "max_chunk_size, frag_page_size, "
-      "max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo, userid "
-      "from mapd_tables");
-  sqliteConnector_.query(tableQuery);
-  numRows = sqliteConnector_.getNumRows();
-  for (size_t r = 0; r < numRows; ++r) {
-    TableDescriptor* td = new TableDescriptor();
-    td->tableId = sqliteConnector_.getData<int>(r, 0);
-    td->tableName = sqliteConnector_.getData<string>(r, 1);
-    td->nColumns = sqliteConnector_.getData<int>(r, 2);
-    td->isView = sqliteConnector_.getData<bool>(r, 3);
-    td->fragments = sqliteConnector_.getData<string>(r, 4);
-    td->fragType =
-        (Fragmenter_Namespace::FragmenterType)sqliteConnector_.getData<int>(r, 5);
-    td->maxFragRows = sqliteConnector_.getData<int>(r, 6);
-    td->maxChunkSize = sqliteConnector_.getData<int>(r, 7);
-    td->fragPageSize = sqliteConnector_.getData<int>(r, 8);
-    td->maxRows = sqliteConnector_.getData<int64_t>(r, 9);
-    td->partitions = sqliteConnector_.getData<string>(r, 10);
-    td->shardedColumnId = sqliteConnector_.getData<int>(r, 11);
-    td->shard = sqliteConnector_.getData<int>(r, 12);
-    td->nShards = sqliteConnector_.getData<int>(r, 13);
-    td->keyMetainfo = sqliteConnector_.getData<string>(r, 14);
-    td->userId = sqliteConnector_.getData<int>(r, 15);
-    if (!td->isView) {
-      td->fragmenter = nullptr;
-    }
+  for (const auto& snapshot_td : snapshot.tables) {
+    TableDescriptor* td = new TableDescriptor(snapshot_td);
+    td->mutex_ = std::make_shared<std::mutex>();
+    td->fragmenter = nullptr;
     td->hasDeletedCol = false;
     tableDescriptorMap_[to_upper(td->tableName)] = td;
     tableDescriptorMapById_[td->tableId] = td;
   }
-  string columnQuery(
-      "SELECT tableid, columnid, name, coltype, colsubtype, coldim, colscale, "
-      "is_notnull, compression, comp_param, "
-      "size, chunks, is_systemcol, is_virtualcol, virtual_expr, is_deletedcol from "
-      "mapd_columns ORDER BY tableid, "
-      "columnid");
-  sqliteConnector_.query(columnQuery);
-  numRows = sqliteConnector_.getNumRows();
+
   int32_t skip_physical_cols = 0;
-  for (size_t r = 0; r < numRows; ++r) {
-    ColumnDescriptor* cd = new ColumnDescriptor();
-    cd->tableId = sqliteConnector_.getData<int>(r, 0);
-    cd->columnId = sqliteConnector_.getData<int>(r, 1);
-    cd->columnName = sqliteConnector_.getData<string>(r, 2);
-    cd->columnType.set_type((SQLTypes)sqliteConnector_.getData<int>(r, 3));
-    cd->columnType.set_subtype((SQLTypes)sqliteConnector_.getData<int>(r, 4));
-    cd->columnType.set_dimension(sqliteConnector_.getData<int>(r, 5));
-    cd->columnType.set_scale(sqliteConnector_.getData<int>(r, 6));
-    cd->columnType.set_notnull(sqliteConnector_.getData<bool>(r, 7));
-    cd->columnType.set_compression((EncodingType)sqliteConnector_.getData<int>(r, 8));
-    cd->columnType.set_comp_param(sqliteConnector_.getData<int>(r, 9));
-    cd->columnType.set_size(sqliteConnector_.getData<int>(r, 10));
-    cd->chunks = sqliteConnector_.getData<string>(r, 11);
-    cd->isSystemCol = sqliteConnector_.getData<bool>(r, 12);
-    cd->isVirtualCol = sqliteConnector_.getData<bool>(r, 13);
-    cd->virtualExpr = sqliteConnector_.getData<string>(r, 14);
-    cd->isDeletedCol = sqliteConnector_.getData<bool>(r, 15);
+  for (const auto& snapshot_cd : snapshot.columns) {
+    ColumnDescriptor* cd = new ColumnDescriptor(snapshot_cd);
     cd->isGeoPhyCol = skip_physical_cols > 0;
     ColumnKey columnKey(cd->tableId, to_upper(cd->columnName));
     columnDescriptorMap_[columnKey] = cd;
@@ -2478,23 +2638,13 @@ void Catalog::buildMaps() {
               [](const size_t a, const size_t b) -> bool { return a < b; });
   }
 
-  string viewQuery("SELECT tableid, sql FROM mapd_views");
-  sqliteConnector_.query(viewQuery);
-  numRows = sqliteConnector_.getNumRows();
-  for (size_t r = 0; r < numRows; ++r) {
-    int32_t tableId = sqliteConnector_.getData<int>(r, 0);
-    TableDescriptor* td = tableDescriptorMapById_[tableId];
-    td->viewSQL = sqliteConnector_.getData<string>(r, 1);
-    td->fragmenter = nullptr;
-  }
-
   string frontendViewQuery(
       "SELECT id, state, name, image_hash, strftime('%Y-%m-%dT%H:%M:%SZ', update_time), "
       "userid, "
       "metadata "
       "FROM mapd_dashboards");
   sqliteConnector_.query(frontendViewQuery);
-  numRows = sqliteConnector_.getNumRows();
+  size_t numRows = sqliteConnector_.getNumRows();
   for (size_t r = 0; r < numRows; ++r) {
     std::shared_ptr<FrontendViewDescriptor> vd =
         std::make_shared<FrontendViewDescriptor>();
@@ -2549,6 +2699,150 @@ void Catalog::buildMaps() {
       physicalTableIt->second.push_back(physical_tb_id);
     }
   }
+
+  string materializedViewQuery(
+      "SELECT viewid, source_tableid, state_tableid, sql, refreshed_rows "
+      "FROM mapd_materialized_views");
+  sqliteConnector_.query(materializedViewQuery);
+  numRows = sqliteConnector_.getNumRows();
+  for (size_t r = 0; r < numRows; ++r) {
+    MaterializedViewDescriptor mvd;
+    mvd.viewId = sqliteConnector_.getData<int>(r, 0);
+    mvd.sourceTableId = sqliteConnector_.getData<int>(r, 1);
+    mvd.stateTableId = sqliteConnector_.getData<int>(r, 2);
+    mvd.viewSQL = sqliteConnector_.getData<string>(r, 3);
+    mvd.refreshedRows = sqliteConnector_.getData<int64_t>(r, 4);
+    materializedViewDescriptorMapById_[mvd.viewId] = mvd;
+  }
+
+  string columnStatisticsQuery(
+      "SELECT tableid, columnid, row_count, null_count, distinct_count, histogram "
+      "FROM mapd_column_statistics");
+  sqliteConnector_.query(columnStatisticsQuery);
+  numRows = sqliteConnector_.getNumRows();
+  for (size_t r = 0; r < numRows; ++r) {
+    ColumnStatisticsDescriptor csd;
+    csd.tableId = sqliteConnector_.getData<int>(r, 0);
+    csd.columnId = sqliteConnector_.getData<int>(r, 1);
+    csd.rowCount = sqliteConnector_.getData<int64_t>(r, 2);
+    csd.nullCount = sqliteConnector_.getData<int64_t>(r, 3);
+    csd.distinctCount = sqliteConnector_.getData<int64_t>(r, 4);
+    csd.histogram = deserialize_histogram(sqliteConnector_.getData<string>(r, 5));
+    columnStatisticsMapByIds_[std::make_pair(csd.tableId, csd.columnId)] = csd;
+  }
+}
+
+// Reads the dictionary, table and column rows the maps are built from, the views are
+// folded into their table descriptors.
+void Catalog::loadCatalogSnapshotFromSqlite(CatalogSnapshot& snapshot) {
+  string dictQuery(
+      "SELECT dictid, name, nbits, is_shared, refcount from mapd_dictionaries");
+  sqliteConnector_.query(dictQuery);
+  size_t numRows = sqliteConnector_.getNumRows();
+  std::string no_folder_path;
+  for (size_t r = 0; r < numRows; ++r) {
+    int dictId = sqliteConnector_.getData<int>(r, 0);
+    std::string dictName = sqliteConnector_.getData<string>(r, 1);
+    int dictNBits = sqliteConnector_.getData<int>(r, 2);
+    bool is_shared = sqliteConnector_.getData<bool>(r, 3);
+    int refcount = sqliteConnector_.getData<int>(r, 4);
+    snapshot.dicts.emplace_back(currentDB_.dbId,
+                                dictId,
+                                dictName,
+                                dictNBits,
+                                is_shared,
+                                refcount,
+                                no_folder_path,
+                                false);
+  }
+
+  string tableQuery(
+      "SELECT tableid, name, ncolumns, isview, fragments, frag_type, max_frag_rows, "
+      "max_chunk_size, frag_page_size, "
+      "max_rows, partitions, shard_column_id, shard, num_shards, key_metainfo, userid, "
+      "sort_column_id, partition_interval, retention, index_column_id, "
+      "primary_key_column_id, external_path from mapd_tables");
+  sqliteConnector_.query(tableQuery);
+  numRows = sqliteConnector_.getNumRows();
+  std::unordered_map<int32_t, size_t> tableIndexById;
+  snapshot.tables.resize(numRows);
+  for (size_t r = 0; r < numRows; ++r) {
+    TableDescriptor* td = &snapshot.tables[r];
+    td->tableId = sqliteConnector_.getData<int>(r, 0);
+    td->tableName = sqliteConnector_.getData<string>(r, 1);
+    td->nColumns = sqliteConnector_.getData<int>(r, 2);
+    td->isView = sqliteConnector_.getData<bool>(r, 3);
+    td->fragments = sqliteConnector_.getData<string>(r, 4);
+    td->fragType =
+        (Fragmenter_Namespace::FragmenterType)sqliteConnector_.getData<int>(r, 5);
+    td->maxFragRows = sqliteConnector_.getData<int>(r, 6);
+    td->maxChunkSize = sqliteConnector_.getData<int>(r, 7);
+    td->fragPageSize = sqliteConnector_.getData<int>(r, 8);
+    td->maxRows = sqliteConnector_.getData<int64_t>(r, 9);
+    td->partitions = sqliteConnector_.getData<string>(r, 10);
+    td->shardedColumnId = sqliteConnector_.getData<int>(r, 11);
+    td->shard = sqliteConnector_.getData<int>(r, 12);
+    td->nShards = sqliteConnector_.getData<int>(r, 13);
+    td->keyMetainfo = sqliteConnector_.getData<string>(r, 14);
+    td->userId = sqliteConnector_.getData<int>(r, 15);
+    td->sortedColumnId = sqliteConnector_.getData<int>(r, 16);
+    td->partitionInterval = sqliteConnector_.getData<int64_t>(r, 17);
+    td->retention = sqliteConnector_.getData<int64_t>(r, 18);
+    td->indexColumnId = sqliteConnector_.getData<int>(r, 19);
+    td->primaryKeyColumnId = sqliteConnector_.getData<int>(r, 20);
+    td->externalPath = sqliteConnector_.getData<string>(r, 21);
+    tableIndexById[td->tableId] = r;
+  }
+
+  string columnQuery(
+      "SELECT tableid, columnid, name, coltype, colsubtype, coldim, colscale, "
+      "is_notnull, compression, comp_param, "
+      "size, chunks, is_systemcol, is_virtualcol, virtual_expr, is_deletedcol from "
+      "mapd_columns ORDER BY tableid, "
+      "columnid");
+  sqliteConnector_.query(columnQuery);
+  numRows = sqliteConnector_.getNumRows();
+  snapshot.columns.resize(numRows);
+  for (size_t r = 0; r < numRows; ++r) {
+    ColumnDescriptor* cd = &snapshot.columns[r];
+    cd->tableId = sqliteConnector_.getData<int>(r, 0);
+    cd->columnId = sqliteConnector_.getData<int>(r, 1);
+    cd->columnName = sqliteConnector_.getData<string>(r, 2);
+    cd->columnType.set_type((SQLTypes)sqliteConnector_.getData<int>(r, 3));
+    cd->columnType.set_subtype((SQLTypes)sqliteConnector_.getData<int>(r, 4));
+    cd->columnType.set_dimension(sqliteConnector_.getData<int>(r, 5));
+    cd->columnType.set_scale(sqliteConnector_.getData<int>(r, 6));
+    cd->columnType.set_notnull(sqliteConnector_.getData<bool>(r, 7));
+    cd->columnType.set_compression((EncodingType)sqliteConnector_.getData<int>(r, 8));
+    cd->columnType.set_comp_param(sqliteConnector_.getData<int>(r, 9));
+    cd->columnType.set_size(sqliteConnector_.getData<int>(r, 10));
+    cd->chunks = sqliteConnector_.getData<string>(r, 11);
+    cd->isSystemCol = sqliteConnector_.getData<bool>(r, 12);
+    cd->isVirtualCol = sqliteConnector_.getData<bool>(r, 13);
+    cd->virtualExpr = sqliteConnector_.getData<string>(r, 14);
+    cd->isDeletedCol = sqliteConnector_.getData<bool>(r, 15);
+  }
+
+  string viewQuery("SELECT tableid, sql FROM mapd_views");
+  sqliteConnector_.query(viewQuery);
+  numRows = sqliteConnector_.getNumRows();
+  for (size_t r = 0; r < numRows; ++r) {
+    int32_t tableId = sqliteConnector_.getData<int>(r, 0);
+    const auto tableIndexIt = tableIndexById.find(tableId);
+    CHECK(tableIndexIt != tableIndexById.end());
+    snapshot.tables[tableIndexIt->second].viewSQL =
+        sqliteConnector_.getData<string>(r, 1);
+  }
+}
+
+int64_t Catalog::getCatalogVersion() {
+  sqliteConnector_.query("SELECT version FROM mapd_catalog_version");
+  CHECK_EQ(sqliteConnector_.getNumRows(), size_t(1));
+  return sqliteConnector_.getData<int64_t>(0, 0);
+}
+
+std::string Catalog::getCatalogSnapshotPath() const {
+  return basePath_ + "/mapd_catalogs/" + currentDB_.dbName + ".snapshot";
 }
 
 void Catalog::addTableToMap(TableDescriptor& td,
@@ -2579,18 +2873,15 @@ void Catalog::addTableToMap(TableDescriptor& td,
             new_td->columnIdBySpi_.end(),
             [](const size_t a, const size_t b) -> bool { return a < b; });
 
-  std::unique_ptr<StringDictionaryClient> client;
   DictRef dict_ref(currentDB_.dbId, -1);
-  if (!string_dict_hosts_.empty()) {
-    client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dict_ref, true));
-  }
+  const auto clients = string_dict_clients(string_dict_hosts_, dict_ref);
   for (auto dd : dicts) {
     if (!dd.dictRef.dictId) {
       // Dummy entry created for a shard of a logical table, nothing to do.
       continue;
     }
     dict_ref.dictId = dd.dictRef.dictId;
-    if (client) {
+    for (const auto& client : clients) {
       client->create(dict_ref, dd.dictIsTemp);
     }
     DictDescriptor* new_dd = new DictDescriptor(dd);
@@ -2623,11 +2914,10 @@ void Catalog::removeTableFromMap(const string& tableName, int tableId) {
   bool isTemp = td->persistenceLevel == Data_Namespace::MemoryLevel::CPU_LEVEL;
   delete td;
 
-  std::unique_ptr<StringDictionaryClient> client;
+  std::vector<std::unique_ptr<StringDictionaryClient>> clients;
   if (g_aggregator) {
     CHECK(!string_dict_hosts_.empty());
-    DictRef dict_ref(currentDB_.dbId, -1);
-    client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dict_ref, true));
+    clients = string_dict_clients(string_dict_hosts_, DictRef(currentDB_.dbId, -1));
   }
 
   // delete all column descriptors for the table
@@ -2659,7 +2949,7 @@ void Catalog::removeTableFromMap(const string& tableName, int tableId) {
           if (!isTemp) {
             boost::filesystem::remove_all(dd->dictFolderPath);
           }
-          if (client) {
+          for (const auto& client : clients) {
             client->drop(dict_ref);
           }
           dictDescriptorMapByRef_.erase(dictIt);
@@ -2699,6 +2989,11 @@ void Catalog::instantiateFragmenter(TableDescriptor* td) const {
     getAllColumnMetadataForTable(td, columnDescs, true, false, true);
     Chunk::translateColumnDescriptorsToChunkVec(columnDescs, chunkVec);
     ChunkKey chunkKeyPrefix = {currentDB_.dbId, td->tableId};
+    if (!td->externalPath.empty()) {
+      td->fragmenter = new ParquetFragmenter(
+          chunkKeyPrefix, chunkVec, dataMgr_.get(), this, td->tableId, td->externalPath);
+      return;
+    }
     td->fragmenter = new InsertOrderFragmenter(chunkKeyPrefix,
                                                chunkVec,
                                                dataMgr_.get(),
@@ -2709,16 +3004,72 @@ void Catalog::instantiateFragmenter(TableDescriptor* td) const {
                                                td->maxChunkSize,
                                                td->fragPageSize,
                                                td->maxRows,
-                                               td->persistenceLevel);
+                                               td->persistenceLevel,
+                                               td->sortedColumnId,
+                                               td->partitionInterval,
+                                               td->retention,
+                                               td->indexColumnId,
+                                               td->primaryKeyColumnId);
   });
   LOG(INFO) << "Instantiating Fragmenter for table " << td->tableName << " took "
             << time_ms << "ms";
 }
 
+std::shared_ptr<const Catalog::MetadataSnapshot> Catalog::getMetadataSnapshot() const {
+  const auto snapshot = std::atomic_load(&metadataSnapshot_);
+  if (snapshot && snapshot->version == metadataVersion_) {
+    return snapshot;
+  }
+  const auto& lock_holder = name() == MAPD_SYSTEM_DB
+                                ? SysCatalog::instance().thread_holding_write_lock
+                                : thread_holding_write_lock;
+  if (lock_holder == std::this_thread::get_id()) {
+    return nullptr;
+  }
+  cat_read_lock read_lock(this);
+  auto new_snapshot = std::make_shared<MetadataSnapshot>();
+  new_snapshot->version = metadataVersion_;
+  new_snapshot->tableDescriptorMap = tableDescriptorMap_;
+  new_snapshot->tableDescriptorMapById = tableDescriptorMapById_;
+  new_snapshot->columnDescriptorMap = columnDescriptorMap_;
+  new_snapshot->columnDescriptorMapById = columnDescriptorMapById_;
+  std::atomic_store(&metadataSnapshot_,
+                    std::shared_ptr<const MetadataSnapshot>(new_snapshot));
+  return new_snapshot;
+}
+
+namespace {
+
+template <class MAP>
+typename MAP::mapped_type find_descriptor(const MAP& descriptor_map,
+                                          const typename MAP::key_type& key) {
+  const auto it = descriptor_map.find(key);
+  return it == descriptor_map.end() ? nullptr : it->second;
+}
+
+}  // namespace
+
+// The lookups below go through the metadata snapshot and only take the catalog lock if
+// a writer has taken it since the snapshot was made. As for the pointers returned by
+// the lookups under the lock, the table locks of the statements keep them alive.
+
 const TableDescriptor* Catalog::getMetadataForTable(const string& tableName,
                                                     const bool populateFragmenter) const {
   // we give option not to populate fragmenter (default true/yes) as it can be heavy for
   // pure metadata calls
+  const auto snapshot = getMetadataSnapshot();
+  if (snapshot) {
+    auto td = find_descriptor(snapshot->tableDescriptorMap, to_upper(tableName));
+    if (snapshot->version == metadataVersion_) {
+      if (!td || !populateFragmenter || td->isView) {
+        return td;
+      }
+      std::unique_lock<std::mutex> td_lock(*td->mutex_.get());
+      if (td->fragmenter) {
+        return td;
+      }
+    }
+  }
   cat_read_lock read_lock(this);
   auto tableDescIt = tableDescriptorMap_.find(to_upper(tableName));
   if (tableDescIt == tableDescriptorMap_.end()) {  // check to make sure table exists
@@ -2733,6 +3084,19 @@ const TableDescriptor* Catalog::getMetadataForTable(const string& tableName,
 }
 
 const TableDescriptor* Catalog::getMetadataForTable(int tableId) const {
+  const auto snapshot = getMetadataSnapshot();
+  if (snapshot) {
+    auto td = find_descriptor(snapshot->tableDescriptorMapById, tableId);
+    if (snapshot->version == metadataVersion_) {
+      if (!td || td->isView) {
+        return td;
+      }
+      std::unique_lock<std::mutex> td_lock(*td->mutex_.get());
+      if (td->fragmenter) {
+        return td;
+      }
+    }
+  }
   cat_read_lock read_lock(this);
   auto tableDescIt = tableDescriptorMapById_.find(tableId);
   if (tableDescIt == tableDescriptorMapById_.end()) {  // check to make sure table exists
@@ -2771,7 +3135,7 @@ const DictDescriptor* Catalog::getMetadataForDict(const int dictId,
           }
         } else {
           dd->stringDict =
-              std::make_shared<StringDictionary>(string_dict_hosts_.front(), dd->dictRef);
+              std::make_shared<StringDictionary>(string_dict_hosts_, dd->dictRef);
         }
       });
       LOG(INFO) << "Time to load Dictionary " << dd->dictRef.dbId << "_"
@@ -2788,6 +3152,14 @@ const std::vector<LeafHostInfo>& Catalog::getStringDictionaryHosts() const {
 
 const ColumnDescriptor* Catalog::getMetadataForColumn(int tableId,
                                                       const string& columnName) const {
+  const auto snapshot = getMetadataSnapshot();
+  if (snapshot) {
+    const auto cd = find_descriptor(snapshot->columnDescriptorMap,
+                                    ColumnKey(tableId, to_upper(columnName)));
+    if (snapshot->version == metadataVersion_) {
+      return cd;
+    }
+  }
   cat_read_lock read_lock(this);
 
   ColumnKey columnKey(tableId, to_upper(columnName));
@@ -2800,6 +3172,14 @@ const ColumnDescriptor* Catalog::getMetadataForColumn(int tableId,
 }
 
 const ColumnDescriptor* Catalog::getMetadataForColumn(int tableId, int columnId) const {
+  const auto snapshot = getMetadataSnapshot();
+  if (snapshot) {
+    const auto cd =
+        find_descriptor(snapshot->columnDescriptorMapById, ColumnIdKey(tableId, columnId));
+    if (snapshot->version == metadataVersion_) {
+      return cd;
+    }
+  }
   cat_read_lock read_lock(this);
 
   ColumnIdKey columnIdKey(tableId, columnId);
@@ -2943,6 +3323,110 @@ const LinkDescriptor* Catalog::getMetadataForLink(int linkId) const {
   return linkDescIt->second;
 }
 
+void Catalog::addMaterializedView(const MaterializedViewDescriptor& mvd) {
+  cat_write_lock write_lock(this);
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query_with_text_params(
+      "INSERT INTO mapd_materialized_views (viewid, source_tableid, state_tableid, sql, "
+      "refreshed_rows) VALUES (?1, ?2, ?3, ?4, ?5)",
+      std::vector<std::string>{std::to_string(mvd.viewId),
+                               std::to_string(mvd.sourceTableId),
+                               std::to_string(mvd.stateTableId),
+                               mvd.viewSQL,
+                               std::to_string(mvd.refreshedRows)});
+  materializedViewDescriptorMapById_[mvd.viewId] = mvd;
+}
+
+const MaterializedViewDescriptor* Catalog::getMetadataForMaterializedView(
+    int viewId) const {
+  cat_read_lock read_lock(this);
+  auto it = materializedViewDescriptorMapById_.find(viewId);
+  if (it == materializedViewDescriptorMapById_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+std::vector<MaterializedViewDescriptor> Catalog::getMaterializedViews(
+    int tableId) const {
+  cat_read_lock read_lock(this);
+  std::vector<MaterializedViewDescriptor> materialized_views;
+  for (const auto& view_id_mvd : materializedViewDescriptorMapById_) {
+    const auto& mvd = view_id_mvd.second;
+    if (tableId == -1 || mvd.sourceTableId == tableId || mvd.stateTableId == tableId) {
+      materialized_views.push_back(mvd);
+    }
+  }
+  return materialized_views;
+}
+
+void Catalog::setMaterializedViewRefreshedRows(int viewId, int64_t refreshedRows) {
+  cat_write_lock write_lock(this);
+  cat_sqlite_lock sqlite_lock(this);
+  auto it = materializedViewDescriptorMapById_.find(viewId);
+  CHECK(it != materializedViewDescriptorMapById_.end());
+  sqliteConnector_.query_with_text_params(
+      "UPDATE mapd_materialized_views SET refreshed_rows = ?1 WHERE viewid = ?2",
+      std::vector<std::string>{std::to_string(refreshedRows), std::to_string(viewId)});
+  it->second.refreshedRows = refreshedRows;
+}
+
+void Catalog::setColumnStatistics(
+    int tableId,
+    const std::vector<ColumnStatisticsDescriptor>& statistics) {
+  cat_write_lock write_lock(this);
+  cat_sqlite_lock sqlite_lock(this);
+  sqliteConnector_.query("BEGIN TRANSACTION");
+  try {
+    sqliteConnector_.query_with_text_param(
+        "DELETE FROM mapd_column_statistics WHERE tableid = ?", std::to_string(tableId));
+    for (const auto& csd : statistics) {
+      CHECK_EQ(tableId, csd.tableId);
+      sqliteConnector_.query_with_text_params(
+          "INSERT INTO mapd_column_statistics (tableid, columnid, row_count, "
+          "null_count, distinct_count, histogram) VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+          std::vector<std::string>{std::to_string(csd.tableId),
+                                   std::to_string(csd.columnId),
+                                   std::to_string(csd.rowCount),
+                                   std::to_string(csd.nullCount),
+                                   std::to_string(csd.distinctCount),
+                                   serialize_histogram(csd.histogram)});
+    }
+  } catch (const std::exception& e) {
+    sqliteConnector_.query("ROLLBACK TRANSACTION");
+    throw;
+  }
+  sqliteConnector_.query("END TRANSACTION");
+  auto it = columnStatisticsMapByIds_.lower_bound(std::make_pair(tableId, 0));
+  while (it != columnStatisticsMapByIds_.end() && it->first.first == tableId) {
+    it = columnStatisticsMapByIds_.erase(it);
+  }
+  for (const auto& csd : statistics) {
+    columnStatisticsMapByIds_[std::make_pair(csd.tableId, csd.columnId)] = csd;
+  }
+}
+
+const ColumnStatisticsDescriptor* Catalog::getColumnStatistics(int tableId,
+                                                               int columnId) const {
+  cat_read_lock read_lock(this);
+  auto it = columnStatisticsMapByIds_.find(std::make_pair(tableId, columnId));
+  if (it == columnStatisticsMapByIds_.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+std::vector<int> Catalog::getAnalyzedTables() const {
+  cat_read_lock read_lock(this);
+  std::vector<int> table_ids;
+  for (const auto& ids_csd : columnStatisticsMapByIds_) {
+    if (table_ids.empty() || table_ids.back() != ids_csd.first.first) {
+      table_ids.push_back(ids_csd.first.first);
+    }
+  }
+  return table_ids;
+}
+
 void Catalog::getAllColumnMetadataForTable(
     const TableDescriptor* td,
     list<const ColumnDescriptor*>& columnDescriptors,
@@ -3014,12 +3498,8 @@ DictRef Catalog::addDictionary(ColumnDescriptor& cd) {
   auto& dd = dds.back();
   CHECK(dd.dictRef.dictId);
 
-  std::unique_ptr<StringDictionaryClient> client;
-  if (!string_dict_hosts_.empty()) {
-    client.reset(new StringDictionaryClient(
-        string_dict_hosts_.front(), DictRef(currentDB_.dbId, -1), true));
-  }
-  if (client) {
+  for (const auto& client :
+       string_dict_clients(string_dict_hosts_, DictRef(currentDB_.dbId, -1))) {
     client->create(dd.dictRef, dd.dictIsTemp);
   }
 
@@ -3053,11 +3533,7 @@ void Catalog::delDictionary(const ColumnDescriptor& cd) {
                                 std::to_string(currentDB_.dbId) + "_DICT_" +
                                 std::to_string(dictId));
 
-  std::unique_ptr<StringDictionaryClient> client;
-  if (!string_dict_hosts_.empty()) {
-    client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dictRef, true));
-  }
-  if (client) {
+  for (const auto& client : string_dict_clients(string_dict_hosts_, dictRef)) {
     client->drop(dictRef);
   }
 
@@ -3094,6 +3570,7 @@ void Catalog::getDictionary(const ColumnDescriptor& cd,
 
 void Catalog::addColumn(const TableDescriptor& td, ColumnDescriptor& cd) {
   // caller must handle sqlite/chunk transaction TOGETHER
+  cat_write_lock write_lock(this);
   cd.tableId = td.tableId;
   if (cd.columnType.get_compression() == kENCODING_DICT) {
     addDictionary(cd);
@@ -3143,6 +3620,7 @@ void Catalog::addColumn(const TableDescriptor& td, ColumnDescriptor& cd) {
 }
 
 void Catalog::roll(const bool forward) {
+  cat_write_lock write_lock(this);
   std::set<const TableDescriptor*> tds;
 
   for (const auto& cdr : columnDescriptorsForRoll) {
@@ -3339,12 +3817,28 @@ void Catalog::createTable(
   list<DictDescriptor> dds;
   std::set<std::string> toplevel_column_names;
   list<ColumnDescriptor> columns;
+  // The sort column is given as its position among the columns declared, the physical
+  // columns of the geo columns before it move it.
+  int sortedColumnId = 0;
+  int indexColumnId = 0;
+  int primaryKeyColumnId = 0;
+  int declaredColumnId = 0;
   for (auto cd : cols) {
     if (cd.columnName == "rowid") {
       throw std::runtime_error(
           "Cannot create column with name rowid. rowid is a system defined column.");
     }
     columns.push_back(cd);
+    ++declaredColumnId;
+    if (declaredColumnId == td.sortedColumnId) {
+      sortedColumnId = columns.size();
+    }
+    if (declaredColumnId == td.indexColumnId) {
+      indexColumnId = columns.size();
+    }
+    if (declaredColumnId == td.primaryKeyColumnId) {
+      primaryKeyColumnId = columns.size();
+    }
     toplevel_column_names.insert(cd.columnName);
     if (cd.columnType.is_geometry()) {
       expandGeoColumn(cd, columns);
@@ -3377,6 +3871,9 @@ void Catalog::createTable(
   }
 
   td.nColumns = columns.size();
+  td.sortedColumnId = sortedColumnId;
+  td.indexColumnId = indexColumnId;
+  td.primaryKeyColumnId = primaryKeyColumnId;
   cat_sqlite_lock sqlite_lock(this);
   sqliteConnector_.query("BEGIN TRANSACTION");
   if (td.persistenceLevel == Data_Namespace::MemoryLevel::DISK_LEVEL) {
@@ -3386,8 +3883,9 @@ void Catalog::createTable(
           "frag_type, max_frag_rows, "
           "max_chunk_size, "
           "frag_page_size, max_rows, partitions, shard_column_id, shard, num_shards, "
-          "key_metainfo) VALUES (?, ?, ?, "
-          "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
+          "key_metainfo, sort_column_id, partition_interval, retention, "
+          "index_column_id, primary_key_column_id, external_path) VALUES (?, ?, ?, ?, "
+          "?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)",
 
           std::vector<std::string>{td.tableName,
                                    std::to_string(td.userId),
@@ -3403,7 +3901,13 @@ void Catalog::createTable(
                                    std::to_string(td.shardedColumnId),
                                    std::to_string(td.shard),
                                    std::to_string(td.nShards),
-                                   td.keyMetainfo});
+                                   td.keyMetainfo,
+                                   std::to_string(td.sortedColumnId),
+                                   std::to_string(td.partitionInterval),
+                                   std::to_string(td.retention),
+                                   std::to_string(td.indexColumnId),
+                                   std::to_string(td.primaryKeyColumnId),
+                                   td.externalPath});
 
       // now get the auto generated tableid
       sqliteConnector_.query_with_text_param(
@@ -3833,6 +4337,35 @@ void Catalog::truncateTable(const TableDescriptor* td) {
   doTruncateTable(td);
 }
 
+size_t Catalog::vacuumDeletedRows(const TableDescriptor* td,
+                                  const double minDeletedFraction) {
+  if (!getDeletedColumn(td)) {
+    return 0;
+  }
+  const auto physicalTables = getPhysicalTablesDescriptors(td);
+  std::vector<std::vector<int>> compactedFragmentIds;
+  size_t numCompacted = 0;
+  for (const auto physicalTable : physicalTables) {
+    CHECK(physicalTable->fragmenter);
+    compactedFragmentIds.push_back(
+        physicalTable->fragmenter->compactFragments(minDeletedFraction));
+    numCompacted += compactedFragmentIds.back().size();
+  }
+  if (numCompacted == 0) {
+    return 0;
+  }
+  // The rewritten rows have to be durable before the fragments they come from go away,
+  // dropping a fragment frees its pages without waiting for a checkpoint.
+  if (td->persistenceLevel == Data_Namespace::MemoryLevel::DISK_LEVEL) {
+    checkpoint(td->tableId);
+  }
+  for (size_t i = 0; i < physicalTables.size(); ++i) {
+    physicalTables[i]->fragmenter->dropFragments(compactedFragmentIds[i]);
+  }
+  LOG(INFO) << "Vacuumed " << numCompacted << " fragments of table " << td->tableName;
+  return numCompacted;
+}
+
 void Catalog::doTruncateTable(const TableDescriptor* td) {
   cat_write_lock write_lock(this);
 
@@ -3851,11 +4384,10 @@ void Catalog::doTruncateTable(const TableDescriptor* td) {
   dataMgr_->checkpoint(currentDB_.dbId, tableId);
   dataMgr_->removeTableRelatedDS(currentDB_.dbId, tableId);
 
-  std::unique_ptr<StringDictionaryClient> client;
+  std::vector<std::unique_ptr<StringDictionaryClient>> clients;
   if (g_aggregator) {
     CHECK(!string_dict_hosts_.empty());
-    DictRef dict_ref(currentDB_.dbId, -1);
-    client.reset(new StringDictionaryClient(string_dict_hosts_.front(), dict_ref, true));
+    clients = string_dict_clients(string_dict_hosts_, DictRef(currentDB_.dbId, -1));
   }
   // clean up any dictionaries
   // delete all column descriptors for the table
@@ -3877,7 +4409,7 @@ void Catalog::doTruncateTable(const TableDescriptor* td) {
         // close the dictionary
         dd->stringDict.reset();
         boost::filesystem::remove_all(dd->dictFolderPath);
-        if (client) {
+        for (const auto& client : clients) {
           client->drop(dd->dictRef);
         }
         if (!dd->dictIsTemp) {
@@ -3894,7 +4426,7 @@ void Catalog::doTruncateTable(const TableDescriptor* td) {
                                                   dd->dictIsTemp);
       dictDescriptorMapByRef_.erase(dictIt);
       // now create new Dict -- need to figure out what to do here for temp tables
-      if (client) {
+      for (const auto& client : clients) {
         client->create(new_dd->dictRef, new_dd->dictIsTemp);
       }
       dictDescriptorMapByRef_[new_dd->dictRef].reset(new_dd);
@@ -3959,6 +4491,21 @@ void Catalog::dropTable(const TableDescriptor* td) {
           std::to_string(td->tableId));
       logicalToPhysicalTableMapById_.erase(td->tableId);
     }
+    if (materializedViewDescriptorMapById_.count(td->tableId)) {
+      drop_conn->query_with_text_param(
+          "DELETE FROM mapd_materialized_views WHERE viewid = ?",
+          std::to_string(td->tableId));
+      materializedViewDescriptorMapById_.erase(td->tableId);
+    }
+    drop_conn->query_with_text_param(
+        "DELETE FROM mapd_column_statistics WHERE tableid = ?",
+        std::to_string(td->tableId));
+    auto column_statistics_it =
+        columnStatisticsMapByIds_.lower_bound(std::make_pair(td->tableId, 0));
+    while (column_statistics_it != columnStatisticsMapByIds_.end() &&
+           column_statistics_it->first.first == td->tableId) {
+      column_statistics_it = columnStatisticsMapByIds_.erase(column_statistics_it);
+    }
     doDropTable(td, drop_conn);
     removeTableFromMap(td->tableName, td->tableId);
   } catch (std::exception& e) {
@@ -33,22 +33,27 @@
 #define CATALOG_H
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <ctime>
 #include <limits>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "ColumnDescriptor.h"
+#include "ColumnStatisticsDescriptor.h"
 #include "DictDescriptor.h"
 #include "FrontendViewDescriptor.h"
 #include "Grantee.h"
 #include "LdapServer.h"
 #include "LinkDescriptor.h"
+#include "MaterializedViewDescriptor.h"
 #include "ObjectRoleDescriptor.h"
 #include "RestServer.h"
 #include "TableDescriptor.h"
@@ -85,6 +90,8 @@ class TypedImportBuffer;
 #define SPIMAP_GEO_PHYSICAL_INPUT(c, i) \
   (SPIMAP_MAGIC1 + (unsigned)(SPIMAP_MAGIC2 * ((c) + 1) + (i)))
 
+struct CatalogSnapshot;
+
 namespace Catalog_Namespace {
 
 /*
@@ -181,6 +188,14 @@ class Catalog {
   std::string createLink(LinkDescriptor& ld, size_t min_length);
   void dropTable(const TableDescriptor* td);
   void truncateTable(const TableDescriptor* td);
+  /**
+   * @brief Rewrites the fragments of the table with at least minDeletedFraction of their
+   * rows deleted without the deleted rows. The caller holds the checkpoint and the
+   * update / delete locks of the table.
+   *
+   * @return size_t The number of fragments rewritten.
+   */
+  size_t vacuumDeletedRows(const TableDescriptor* td, const double minDeletedFraction);
   void renameTable(const TableDescriptor* td, const std::string& newTableName);
   void renameColumn(const TableDescriptor* td,
                     const ColumnDescriptor* cd,
@@ -220,6 +235,26 @@ class Catalog {
   const LinkDescriptor* getMetadataForLink(const std::string& link) const;
   const LinkDescriptor* getMetadataForLink(int linkId) const;
 
+  void addMaterializedView(const MaterializedViewDescriptor& mvd);
+  const MaterializedViewDescriptor* getMetadataForMaterializedView(int viewId) const;
+  /**
+   * @brief Returns the materialized views which read the table (sourceTableId) or keep
+   * their state in it (stateTableId), any materialized view if tableId is -1.
+   */
+  std::vector<MaterializedViewDescriptor> getMaterializedViews(int tableId = -1) const;
+  void setMaterializedViewRefreshedRows(int viewId, int64_t refreshedRows);
+
+  /**
+   * @brief Replaces the statistics of the columns of a table computed by ANALYZE TABLE
+   */
+  void setColumnStatistics(int tableId,
+                           const std::vector<ColumnStatisticsDescriptor>& statistics);
+  const ColumnStatisticsDescriptor* getColumnStatistics(int tableId, int columnId) const;
+  /**
+   * @brief Returns the ids of the tables with column statistics
+   */
+  std::vector<int> getAnalyzedTables() const;
+
   /**
    * @brief Returns a list of pointers to constant ColumnDescriptor structs for all the
    * columns from a particular table specified by table id
@@ -288,6 +323,9 @@ class Catalog {
       FrontendViewDescriptorMap;
   typedef std::map<std::string, LinkDescriptor*> LinkDescriptorMap;
   typedef std::map<int, LinkDescriptor*> LinkDescriptorMapById;
+  typedef std::map<int, MaterializedViewDescriptor> MaterializedViewDescriptorMapById;
+  typedef std::map<std::pair<int, int>, ColumnStatisticsDescriptor>
+      ColumnStatisticsMapByIds;
   typedef std::unordered_map<const TableDescriptor*, const ColumnDescriptor*>
       DeletedColumnPerTableMap;
 
@@ -303,8 +341,14 @@ class Catalog {
   void updatePageSize();
   void updateDeletedColumnIndicator();
   void updateFrontendViewsToDashboards();
+  void updateMaterializedViewSchema();
+  void updateColumnStatisticsSchema();
+  void updateCatalogVersionSchema();
   void recordOwnershipOfObjectsInObjectPermissions();
   void buildMaps();
+  void loadCatalogSnapshotFromSqlite(CatalogSnapshot& snapshot);
+  int64_t getCatalogVersion();
+  std::string getCatalogSnapshotPath() const;
   void addTableToMap(TableDescriptor& td,
                      const std::list<ColumnDescriptor>& columns,
                      const std::list<DictDescriptor>& dicts);
@@ -337,6 +381,20 @@ class Catalog {
   std::string generatePhysicalTableName(const std::string& logicalTableName,
                                         const int32_t& shardNumber);
 
+  // Copy of the descriptor maps for the lookups which don't take the catalog lock. It
+  // is only valid as long as its version is the current one, the writers change the
+  // version when they take and release the lock.
+  struct MetadataSnapshot {
+    uint64_t version;
+    TableDescriptorMap tableDescriptorMap;
+    TableDescriptorMapById tableDescriptorMapById;
+    ColumnDescriptorMap columnDescriptorMap;
+    ColumnDescriptorMapById columnDescriptorMapById;
+  };
+
+  // Null if this thread is in the middle of changing the maps.
+  std::shared_ptr<const MetadataSnapshot> getMetadataSnapshot() const;
+
   std::string basePath_;
   TableDescriptorMap tableDescriptorMap_;
   TableDescriptorMapById tableDescriptorMapById_;
@@ -346,6 +404,8 @@ class Catalog {
   FrontendViewDescriptorMap dashboardDescriptorMap_;
   LinkDescriptorMap linkDescriptorMap_;
   LinkDescriptorMapById linkDescriptorMapById_;
+  MaterializedViewDescriptorMapById materializedViewDescriptorMapById_;
+  ColumnStatisticsMapByIds columnStatisticsMapByIds_;
   SqliteConnector sqliteConnector_;
   DBMetadata currentDB_;
   std::shared_ptr<Data_Namespace::DataMgr> dataMgr_;
@@ -372,12 +432,17 @@ class Catalog {
  private:
   static std::map<std::string, std::shared_ptr<Catalog>> mapd_cat_map_;
   DeletedColumnPerTableMap deletedColumnPerTable_;
+  // Accessed through std::atomic_load and std::atomic_store only.
+  mutable std::shared_ptr<const MetadataSnapshot> metadataSnapshot_;
 
  public:
+  void invalidateMetadataSnapshot() const { ++metadataVersion_; }
+
   mutable std::mutex sqliteMutex_;
   mutable mapd_shared_mutex sharedMutex_;
   mutable std::atomic<std::thread::id> thread_holding_sqlite_lock;
   mutable std::atomic<std::thread::id> thread_holding_write_lock;
+  mutable std::atomic<uint64_t> metadataVersion_{0};
   // assuming that you never call into a catalog from another catalog via the same thread
   static thread_local bool thread_holds_read_lock;
 };
@@ -407,6 +472,10 @@ class SysCatalog {
                                  const std::string& password,
                                  UserMetadata& user_meta,
                                  bool check_password = true);
+  /**
+   * returns the catalog of a database, loading it unless a session did already.
+   */
+  std::shared_ptr<Catalog> getCatalog(const DBMetadata& db_meta);
   void createUser(const std::string& name, const std::string& passwd, bool issuper);
   void dropUser(const std::string& name);
   void alterUser(const int32_t userid, const std::string* passwd, bool* issuper);
@@ -416,6 +485,8 @@ class SysCatalog {
   void dropDatabase(const int32_t dbid, const std::string& name, Catalog* db_cat);
   bool getMetadataForUser(const std::string& name, UserMetadata& user);
   bool getMetadataForUserById(const int32_t idIn, UserMetadata& user);
+  // The checks of a password verified against the same stored hash in the last
+  // g_credential_cache_seconds skip bcrypt, which takes most of the time of a connect.
   bool checkPasswordForUser(const std::string& passwd, UserMetadata& user);
   bool getMetadataForDB(const std::string& name, DBMetadata& db);
   const DBMetadata& get_currentDB() const { return currentDB_; }
@@ -578,6 +649,15 @@ class SysCatalog {
   std::shared_ptr<Calcite> calciteMgr_;
   const std::vector<LeafHostInfo>* string_dict_hosts_;
 
+  struct VerifiedCredentials {
+    std::string passwd_hash;    // the stored hash the password was verified against
+    std::string passwd_digest;  // salted, the password itself isn't kept
+    std::chrono::steady_clock::time_point expiry;
+  };
+  std::string credentialSalt_;
+  std::mutex credentialCacheMutex_;
+  std::unordered_map<std::string, VerifiedCredentials> verifiedCredentials_;  // by user
+
  public:
   mutable std::mutex sqliteMutex_;
   mutable mapd_shared_mutex sharedMutex_;
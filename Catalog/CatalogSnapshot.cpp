@@ -0,0 +1,277 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CatalogSnapshot.h"
+
+#include <boost/filesystem.hpp>
+#include <glog/logging.h>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+
+namespace {
+
+const char kSnapshotMagic[] = "MAPDCAT5";
+
+class SnapshotWriter {
+ public:
+  template <class T>
+  void put(const T val) {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic types are supported");
+    const auto bytes = reinterpret_cast<const char*>(&val);
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+  }
+
+  void put(const std::string& str) {
+    put(static_cast<uint32_t>(str.size()));
+    buffer_.insert(buffer_.end(), str.begin(), str.end());
+  }
+
+  void put(const SQLTypeInfo& ti) {
+    put(static_cast<int32_t>(ti.get_type()));
+    put(static_cast<int32_t>(ti.get_subtype()));
+    put(static_cast<int32_t>(ti.get_dimension()));
+    put(static_cast<int32_t>(ti.get_scale()));
+    put(ti.get_notnull());
+    put(static_cast<int32_t>(ti.get_compression()));
+    put(static_cast<int32_t>(ti.get_comp_param()));
+    put(static_cast<int32_t>(ti.get_size()));
+  }
+
+  const std::vector<char>& buffer() const { return buffer_; }
+
+ private:
+  std::vector<char> buffer_;
+};
+
+// Every getter returns false once the buffer is exhausted, the snapshot is then
+// treated as missing.
+class SnapshotReader {
+ public:
+  SnapshotReader(const std::vector<char>& buffer, const size_t pos)
+      : buffer_(buffer), pos_(pos) {}
+
+  template <class T>
+  bool get(T& val) {
+    static_assert(std::is_arithmetic<T>::value, "Only arithmetic types are supported");
+    if (buffer_.size() - pos_ < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&val, &buffer_[pos_], sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  bool get(std::string& str) {
+    uint32_t size{0};
+    if (!get(size) || buffer_.size() - pos_ < size) {
+      return false;
+    }
+    str.assign(&buffer_[pos_], size);
+    pos_ += size;
+    return true;
+  }
+
+  bool get(SQLTypeInfo& ti) {
+    int32_t type, subtype, dimension, scale, compression, comp_param, size;
+    bool notnull;
+    if (!get(type) || !get(subtype) || !get(dimension) || !get(scale) || !get(notnull) ||
+        !get(compression) || !get(comp_param) || !get(size)) {
+      return false;
+    }
+    ti.set_type(static_cast<SQLTypes>(type));
+    ti.set_subtype(static_cast<SQLTypes>(subtype));
+    ti.set_dimension(dimension);
+    ti.set_scale(scale);
+    ti.set_notnull(notnull);
+    ti.set_compression(static_cast<EncodingType>(compression));
+    ti.set_comp_param(comp_param);
+    ti.set_size(size);
+    return true;
+  }
+
+  bool atEnd() const { return pos_ == buffer_.size(); }
+
+ private:
+  const std::vector<char>& buffer_;
+  size_t pos_;
+};
+
+bool read_dicts(SnapshotReader& reader, std::vector<DictDescriptor>& dicts) {
+  uint64_t count{0};
+  if (!reader.get(count)) {
+    return false;
+  }
+  std::string no_folder_path;
+  for (uint64_t i = 0; i < count; ++i) {
+    int32_t db_id, dict_id, nbits, refcount;
+    std::string name;
+    bool is_shared;
+    if (!reader.get(db_id) || !reader.get(dict_id) || !reader.get(name) ||
+        !reader.get(nbits) || !reader.get(is_shared) || !reader.get(refcount)) {
+      return false;
+    }
+    dicts.emplace_back(
+        db_id, dict_id, name, nbits, is_shared, refcount, no_folder_path, false);
+  }
+  return true;
+}
+
+bool read_tables(SnapshotReader& reader, std::vector<TableDescriptor>& tables) {
+  uint64_t count{0};
+  if (!reader.get(count)) {
+    return false;
+  }
+  tables.resize(count);
+  for (auto& td : tables) {
+    int32_t frag_type;
+    if (!reader.get(td.tableId) || !reader.get(td.tableName) ||
+        !reader.get(td.nColumns) || !reader.get(td.isView) || !reader.get(td.viewSQL) ||
+        !reader.get(td.fragments) || !reader.get(frag_type) ||
+        !reader.get(td.maxFragRows) || !reader.get(td.maxChunkSize) ||
+        !reader.get(td.fragPageSize) || !reader.get(td.maxRows) ||
+        !reader.get(td.partitions) || !reader.get(td.shardedColumnId) ||
+        !reader.get(td.shard) || !reader.get(td.nShards) || !reader.get(td.keyMetainfo) ||
+        !reader.get(td.userId) || !reader.get(td.sortedColumnId) ||
+        !reader.get(td.partitionInterval) || !reader.get(td.retention) ||
+        !reader.get(td.indexColumnId) || !reader.get(td.primaryKeyColumnId) ||
+        !reader.get(td.externalPath)) {
+      return false;
+    }
+    td.fragType = static_cast<Fragmenter_Namespace::FragmenterType>(frag_type);
+  }
+  return true;
+}
+
+bool read_columns(SnapshotReader& reader, std::vector<ColumnDescriptor>& columns) {
+  uint64_t count{0};
+  if (!reader.get(count)) {
+    return false;
+  }
+  columns.resize(count);
+  for (auto& cd : columns) {
+    if (!reader.get(cd.tableId) || !reader.get(cd.columnId) ||
+        !reader.get(cd.columnName) || !reader.get(cd.columnType) ||
+        !reader.get(cd.chunks) || !reader.get(cd.isSystemCol) ||
+        !reader.get(cd.isVirtualCol) || !reader.get(cd.virtualExpr) ||
+        !reader.get(cd.isDeletedCol)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool read_catalog_snapshot(CatalogSnapshot& snapshot, const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  const std::vector<char> buffer((std::istreambuf_iterator<char>(in)),
+                                 std::istreambuf_iterator<char>());
+  const size_t magic_size = sizeof(kSnapshotMagic) - 1;
+  if (in.bad() || buffer.size() < magic_size ||
+      std::memcmp(&buffer[0], kSnapshotMagic, magic_size)) {
+    return false;
+  }
+  SnapshotReader reader(buffer, magic_size);
+  CatalogSnapshot read_snapshot;
+  if (!reader.get(read_snapshot.version) || !reader.get(read_snapshot.dbId) ||
+      !read_dicts(reader, read_snapshot.dicts) ||
+      !read_tables(reader, read_snapshot.tables) ||
+      !read_columns(reader, read_snapshot.columns) || !reader.atEnd()) {
+    LOG(WARNING) << "Ignoring the incomplete catalog snapshot " << path;
+    return false;
+  }
+  snapshot = std::move(read_snapshot);
+  return true;
+}
+
+void write_catalog_snapshot(const CatalogSnapshot& snapshot, const std::string& path) {
+  SnapshotWriter writer;
+  for (size_t i = 0; i < sizeof(kSnapshotMagic) - 1; ++i) {
+    writer.put(kSnapshotMagic[i]);
+  }
+  writer.put(snapshot.version);
+  writer.put(snapshot.dbId);
+  writer.put(static_cast<uint64_t>(snapshot.dicts.size()));
+  for (const auto& dd : snapshot.dicts) {
+    writer.put(static_cast<int32_t>(dd.dictRef.dbId));
+    writer.put(static_cast<int32_t>(dd.dictRef.dictId));
+    writer.put(dd.dictName);
+    writer.put(static_cast<int32_t>(dd.dictNBits));
+    writer.put(dd.dictIsShared);
+    writer.put(static_cast<int32_t>(dd.refcount));
+  }
+  writer.put(static_cast<uint64_t>(snapshot.tables.size()));
+  for (const auto& td : snapshot.tables) {
+    writer.put(td.tableId);
+    writer.put(td.tableName);
+    writer.put(td.nColumns);
+    writer.put(td.isView);
+    writer.put(td.viewSQL);
+    writer.put(td.fragments);
+    writer.put(static_cast<int32_t>(td.fragType));
+    writer.put(td.maxFragRows);
+    writer.put(td.maxChunkSize);
+    writer.put(td.fragPageSize);
+    writer.put(td.maxRows);
+    writer.put(td.partitions);
+    writer.put(static_cast<int32_t>(td.shardedColumnId));
+    writer.put(td.shard);
+    writer.put(td.nShards);
+    writer.put(td.keyMetainfo);
+    writer.put(td.userId);
+    writer.put(static_cast<int32_t>(td.sortedColumnId));
+    writer.put(td.partitionInterval);
+    writer.put(td.retention);
+    writer.put(static_cast<int32_t>(td.indexColumnId));
+    writer.put(static_cast<int32_t>(td.primaryKeyColumnId));
+    writer.put(td.externalPath);
+  }
+  writer.put(static_cast<uint64_t>(snapshot.columns.size()));
+  for (const auto& cd : snapshot.columns) {
+    writer.put(static_cast<int32_t>(cd.tableId));
+    writer.put(static_cast<int32_t>(cd.columnId));
+    writer.put(cd.columnName);
+    writer.put(cd.columnType);
+    writer.put(cd.chunks);
+    writer.put(cd.isSystemCol);
+    writer.put(cd.isVirtualCol);
+    writer.put(cd.virtualExpr);
+    writer.put(cd.isDeletedCol);
+  }
+
+  const auto tmp_path = path + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    const auto& buffer = writer.buffer();
+    out.write(buffer.data(), buffer.size());
+    if (!out) {
+      LOG(WARNING) << "Could not write the catalog snapshot " << tmp_path;
+      return;
+    }
+  }
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    LOG(WARNING) << "Could not replace the catalog snapshot " << path << ": "
+                 << ec.message();
+  }
+}
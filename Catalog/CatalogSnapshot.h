@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    CatalogSnapshot.h
+ * @brief   Binary copy of the dictionary, table and column rows of a catalog.
+ *
+ * Building the catalog maps of a database with many tables from sqlite takes seconds,
+ * the snapshot is read with a single read instead. It is tagged with the catalog
+ * version kept in sqlite, which triggers bump on every change to the rows it copies,
+ * and is only used as long as the versions match.
+ */
+
+#ifndef CATALOG_SNAPSHOT_H
+#define CATALOG_SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ColumnDescriptor.h"
+#include "DictDescriptor.h"
+#include "TableDescriptor.h"
+
+struct CatalogSnapshot {
+  int64_t version;
+  int32_t dbId;
+  // Only the fields stored in sqlite are kept, the folder path of the dictionaries
+  // isn't, and the definition of a view is in its table descriptor.
+  std::vector<DictDescriptor> dicts;
+  std::vector<TableDescriptor> tables;
+  std::vector<ColumnDescriptor> columns;  // ordered by table id and column id
+};
+
+// Returns false if the file doesn't exist or doesn't hold a complete snapshot.
+bool read_catalog_snapshot(CatalogSnapshot& snapshot, const std::string& path);
+
+// Replaces the file atomically, a failure is logged and leaves the old file alone.
+void write_catalog_snapshot(const CatalogSnapshot& snapshot, const std::string& path);
+
+#endif  // CATALOG_SNAPSHOT_H
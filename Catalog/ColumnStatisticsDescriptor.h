@@ -0,0 +1,42 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COLUMN_STATISTICS_DESCRIPTOR_H
+#define COLUMN_STATISTICS_DESCRIPTOR_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @type ColumnStatisticsDescriptor
+ * @brief specifies the content in-memory of a row in the column statistics metadata
+ *
+ * The statistics are computed by ANALYZE TABLE. The histogram is equi-depth: every
+ * bucket between two consecutive bounds holds about the same number of the non-null
+ * values, in the units the column is stored in (scaled integers for decimals). It is
+ * empty for dictionary encoded strings.
+ */
+
+struct ColumnStatisticsDescriptor {
+  int32_t tableId;
+  int32_t columnId;
+  int64_t rowCount;       // rows of the table when the statistics were computed
+  int64_t nullCount;
+  int64_t distinctCount;  // approximate, nulls excluded
+  std::vector<double> histogram;
+};
+
+#endif  // COLUMN_STATISTICS_DESCRIPTOR_H
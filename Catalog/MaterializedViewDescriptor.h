@@ -0,0 +1,40 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MATERIALIZED_VIEW_DESCRIPTOR_H
+#define MATERIALIZED_VIEW_DESCRIPTOR_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @type MaterializedViewDescriptor
+ * @brief specifies the content in-memory of a row in the materialized view metadata
+ *
+ * A materialized view is a logical view which merges the partial aggregates kept in
+ * its state table. The partial aggregates of the rows appended to the source table
+ * since the last refresh are added to the state table on each refresh.
+ */
+
+struct MaterializedViewDescriptor {
+  int32_t viewId;
+  int32_t sourceTableId;
+  int32_t stateTableId;
+  std::string viewSQL;    // the aggregate query over the source table
+  int64_t refreshedRows;  // rows of the source table already in the state table
+};
+
+#endif  // MATERIALIZED_VIEW_DESCRIPTOR_H
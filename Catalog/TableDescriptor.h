@@ -54,6 +54,12 @@ struct TableDescriptor {
   int32_t
       nShards;  // # of shards, i.e. physical tables for this logical table (default: 0)
   int shardedColumnId;  // Id of the column to be sharded on
+  int sortedColumnId;   // Id of the column the fragments are clustered on, 0 if none
+  int64_t partitionInterval;  // seconds of the sort column per fragment, 0 if none
+  int64_t retention;  // seconds of partitions kept behind the newest row, 0 for all
+  int indexColumnId;  // Id of the column with an in-memory key index, 0 if none
+  int primaryKeyColumnId;  // Id of the column loads upsert on, 0 if none
+  std::string externalPath;  // Parquet file or directory of an external table, or empty
   Data_Namespace::MemoryLevel persistenceLevel;
   bool hasDeletedCol;  // Does table has a delete col, Yes (VACUUM = DELAYED)
                        //                              No  (VACUUM = IMMEDIATE)
@@ -69,6 +75,11 @@ struct TableDescriptor {
       , shard(-1)
       , nShards(0)
       , shardedColumnId(0)
+      , sortedColumnId(0)
+      , partitionInterval(0)
+      , retention(0)
+      , indexColumnId(0)
+      , primaryKeyColumnId(0)
       , persistenceLevel(Data_Namespace::MemoryLevel::DISK_LEVEL)
       , hasDeletedCol(true)
       , mutex_(std::make_shared<std::mutex>()) {}
@@ -169,6 +169,12 @@ size_t Chunk::getNumElemsForBytesInsertData(const DataBlockPtr& src_data,
   }
 }
 
+size_t Chunk::getNumElemsForInsertData(const DataBlockPtr& src_data,
+                                       const size_t num_elems) const {
+  CHECK(!column_desc->columnType.is_varlen());
+  return buffer->encoder->getNumElemsForInsertData(src_data.numbersPtr, num_elems);
+}
+
 ChunkMetadata Chunk::appendData(DataBlockPtr& src_data,
                                 const size_t num_elems,
                                 const size_t start_idx,
@@ -62,6 +62,8 @@ class Chunk {
                                        const size_t start_idx,
                                        const size_t byte_limit,
                                        const bool replicating = false);
+  size_t getNumElemsForInsertData(const DataBlockPtr& src_data,
+                                  const size_t num_elems) const;
   ChunkMetadata appendData(DataBlockPtr& srcData,
                            const size_t numAppendElems,
                            const size_t startIdx,
@@ -40,6 +40,7 @@ CudaMgr::CudaMgr(const int numGpus, const int startGpu)
   }
   fillDeviceProperties();
   createDeviceContexts();
+  enablePeerAccess();
   printDeviceProperties();
 }
 #else
@@ -166,6 +167,40 @@ void CudaMgr::createDeviceContexts() {
 #endif
 }
 
+void CudaMgr::enablePeerAccess() {
+#ifdef HAVE_CUDA
+  peerAccess_.assign(deviceCount_, std::vector<bool>(deviceCount_, false));
+  for (int d = 0; d < deviceCount_; ++d) {
+    setContext(d);
+    for (int peer = 0; peer < deviceCount_; ++peer) {
+      if (peer == d) {
+        continue;
+      }
+      int canAccessPeer{0};
+      checkError(cuDeviceCanAccessPeer(
+          &canAccessPeer, deviceProperties[d].device, deviceProperties[peer].device));
+      if (!canAccessPeer) {
+        continue;
+      }
+      // Otherwise, copies between the devices are staged through host memory.
+      const auto status = cuCtxEnablePeerAccess(deviceContexts[peer], 0);
+      if (status == CUDA_SUCCESS || status == CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED) {
+        peerAccess_[d][peer] = true;
+      } else {
+        LOG(WARNING) << "Could not enable peer access from GPU " << d << " to GPU "
+                     << peer;
+      }
+    }
+  }
+#endif
+}
+
+bool CudaMgr::canAccessPeer(const int deviceNum, const int peerDeviceNum) const {
+  return deviceNum != peerDeviceNum &&
+         static_cast<size_t>(deviceNum) < peerAccess_.size() &&
+         peerAccess_[deviceNum][peerDeviceNum];
+}
+
 void CudaMgr::printDeviceProperties() const {
 #ifdef HAVE_CUDA
   LOG(INFO) << "Using " << deviceCount_ << " Gpus.";
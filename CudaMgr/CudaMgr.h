@@ -115,9 +115,13 @@ class CudaMgr {
 
   void synchronizeDevices();
 
+  // Whether the device can read the memory of the peer directly, over NVLink or PCIe.
+  bool canAccessPeer(const int deviceNum, const int peerDeviceNum) const;
+
  private:
   void fillDeviceProperties();
   void createDeviceContexts();
+  void enablePeerAccess();
   void checkError(CUresult cuResult);
 
   int deviceCount_;
@@ -127,6 +131,7 @@ class CudaMgr {
   int startGpu_;
 #endif  // HAVE_CUDA
   std::vector<CUcontext> deviceContexts;
+  std::vector<std::vector<bool>> peerAccess_;
 
 };  // class CudaMgr
 
@@ -89,6 +89,9 @@ class AbstractBufferMgr {
       const ChunkKey& keyPrefix) = 0;
 
   virtual bool isBufferOnDevice(const ChunkKey& key) = 0;
+  // Whether the chunk is read from the files of an external table, which have no
+  // buffer to get, see ForeignStorageInterface.
+  virtual bool isForeignBuffer(const ChunkKey& key) { return false; }
   virtual std::string printSlabs() = 0;
   virtual void clearSlabs() = 0;
   virtual size_t getMaxSize() = 0;
@@ -30,6 +30,10 @@
 
 using namespace std;
 
+std::string g_buffer_eviction_policy{"lru"};
+bool g_enable_peer_chunk_copies{true};
+bool g_enable_buffer_pool_compaction{true};
+
 static thread_local std::vector<std::string> oom_trace;
 
 void oom_trace_dump() {
@@ -74,7 +78,11 @@ BufferMgr::BufferMgr(const int deviceId,
     , allocationsCapped_(false)
     , parentMgr_(parentMgr)
     , maxBufferId_(0)
-    , bufferEpoch_(0) {
+    , bufferEpoch_(0)
+    , evictionPolicy_(create_eviction_policy(g_buffer_eviction_policy))
+    , numHits_(0)
+    , numMisses_(0)
+    , numEvictions_(0) {
   CHECK(maxBufferSize_ > 0 && maxSlabSize_ > 0 && pageSize_ > 0 &&
         maxSlabSize_ % pageSize_ == 0);
   maxNumPages_ = maxBufferSize_ / pageSize_;
@@ -82,6 +90,11 @@ BufferMgr::BufferMgr(const int deviceId,
   currentMaxSlabPageSize_ =
       maxNumPagesPerSlab_;  // currentMaxSlabPageSize_ will drop as allocations fail -
                             // this is the high water mark
+  // Only worth it in front of the disk, GPU pools reload from the CPU pool.
+  if (g_compressed_chunk_cache_bytes > 0 && parentMgr_ &&
+      parentMgr_->getMgrType() == GLOBAL_FILE_MGR) {
+    compressedCache_.reset(new CompressedChunkCache(g_compressed_chunk_cache_bytes));
+  }
 }
 
 /// Frees the heap-allocated buffer pool memory
@@ -99,16 +112,20 @@ void BufferMgr::reinit() {
 
 void BufferMgr::clear() {
   std::lock_guard<std::mutex> sizedSegsLock(sizedSegsMutex_);
-  std::lock_guard<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_lock_guard<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   std::lock_guard<std::mutex> unsizedSegsLock(unsizedSegsMutex_);
   for (auto bufferIt = chunkIndex_.begin(); bufferIt != chunkIndex_.end(); ++bufferIt) {
     delete bufferIt->second->buffer;
   }
   chunkIndex_.clear();
+  loadingChunks_.clear();
   slabs_.clear();
   slabSegments_.clear();
   unsizedSegs_.clear();
   bufferEpoch_ = 0;
+  if (compressedCache_) {
+    compressedCache_->clear();
+  }
 }
 
 /// Throws a runtime_error if the Chunk already exists
@@ -123,10 +140,15 @@ AbstractBuffer* BufferMgr::createBuffer(const ChunkKey& chunkKey,
 
   // ChunkPageSize here is just for recording dirty pages
   {
-    std::lock_guard<std::mutex> lock(chunkIndexMutex_);
+    mapd_lock_guard<mapd_shared_mutex> lock(chunkIndexMutex_);
     CHECK(chunkIndex_.find(chunkKey) == chunkIndex_.end());
     BufferSeg bufferSeg(BufferSeg(-1, 0, USED));
     bufferSeg.chunkKey = chunkKey;
+    bufferSeg.touchCount = 1 + evictionPolicy_->admit(chunkKey);
+    if (chunkKey[0] != -1) {
+      // Keeps pinResidentBuffer off the chunk until its creator is done filling it.
+      loadingChunks_.insert(chunkKey);
+    }
     std::lock_guard<std::mutex> unsizedSegsLock(unsizedSegsMutex_);
     unsizedSegs_.push_back(bufferSeg);  // race condition?
     chunkIndex_[chunkKey] =
@@ -150,7 +172,7 @@ AbstractBuffer* BufferMgr::createBuffer(const ChunkKey& chunkKey,
   }
   CHECK(initialSize == 0 || chunkIndex_[chunkKey]->buffer->getMemoryPtr());
   // chunkIndex_[chunkKey]->buffer->pin();
-  std::lock_guard<std::mutex> lock(chunkIndexMutex_);
+  mapd_lock_guard<mapd_shared_mutex> lock(chunkIndexMutex_);
   return chunkIndex_[chunkKey]->buffer;
 }
 
@@ -169,7 +191,16 @@ BufferList::iterator BufferMgr::evict(BufferList::iterator& evictStart,
     }
     numPages += evictIt->numPages;
     if (evictIt->memStatus == USED && evictIt->chunkKey.size() > 0) {
+      // Dirty chunks are never evicted, so the copy is what the disk has.
+      if (compressedCache_ && evictIt->chunkKey[0] != -1 &&
+          !parentMgr_->isForeignBuffer(evictIt->chunkKey)) {
+        compressedCache_->put(evictIt->chunkKey,
+                              evictIt->buffer->getMemoryPtr(),
+                              evictIt->buffer->size());
+      }
       chunkIndex_.erase(evictIt->chunkKey);
+      evictionPolicy_->evicted(*evictIt);
+      ++numEvictions_;
     }
     evictIt = slabSegments_[slabNum].erase(
         evictIt);  // erase operations returns next iterator - safe if we ever move
@@ -231,6 +262,7 @@ BufferList::iterator BufferMgr::reserveBuffer(
   newSegIt->buffer = segIt->buffer;
   // newSegIt->buffer->segIt_ = newSegIt;
   newSegIt->chunkKey = segIt->chunkKey;
+  newSegIt->touchCount = segIt->touchCount;
   int8_t* oldMem = newSegIt->buffer->mem_;
   newSegIt->buffer->mem_ = slabs_[newSegIt->slabNum] + newSegIt->startPage * pageSize_;
 
@@ -242,9 +274,10 @@ BufferList::iterator BufferMgr::reserveBuffer(
         oldMem, newSegIt->buffer->size(), 0, newSegIt->buffer->getType(), deviceId_);
   }
   // Deincrement pin count to reverse effect above
-  removeSegment(segIt);
   {
-    std::lock_guard<std::mutex> lock(chunkIndexMutex_);
+    // Lookups under the shared lock must never see the old segment after it's freed.
+    mapd_lock_guard<mapd_shared_mutex> lock(chunkIndexMutex_);
+    removeSegment(segIt);
     chunkIndex_[newSegIt->chunkKey] = newSegIt;
   }
 
@@ -350,6 +383,29 @@ BufferList::iterator BufferMgr::findFreeBuffer(size_t numBytes) {
 
   // If here then we can't add a slab - so we need to evict
 
+  // Chunks are only pinned outside of the global lock while holding the chunk index
+  // lock shared, hold it exclusively so that the pin counts can't change under us.
+  mapd_lock_guard<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  if (g_enable_buffer_pool_compaction) {
+    // Copying chunks within the device is cheaper than loading evicted ones again.
+    for (size_t slabNum = 0; slabNum != slabSegments_.size(); ++slabNum) {
+      size_t numFreePages = 0;
+      for (const auto& seg : slabSegments_[slabNum]) {
+        if (seg.memStatus == FREE) {
+          numFreePages += seg.numPages;
+        }
+      }
+      if (numFreePages < numPagesRequested || compactSlab(slabNum) == 0) {
+        continue;
+      }
+      auto segIt = findFreeBufferInSlab(slabNum, numPagesRequested);
+      if (segIt != slabSegments_[slabNum].end()) {
+        LOG(INFO) << "ALLOCATION found " << numBytes << "B free after compacting slab "
+                  << slabNum << " " << getStringMgrType() << ":" << deviceId_;
+        return segIt;
+      }
+    }
+  }
   size_t minScore = std::numeric_limits<size_t>::max();
   // We're going for lowest score here, like golf
   // This is because score is the sum of the lastTouched score for all
@@ -379,8 +435,10 @@ BufferList::iterator BufferMgr::findFreeBuffer(size_t numBytes) {
       for (; evictIt != slabSegments_[slabNum].end(); ++evictIt) {
         // pinCount should never go up - only down because we have
         // global lock on buffer pool and pin count only increments
-        // on getChunk
-        if (evictIt->memStatus == USED && evictIt->buffer->getPinCount() > 0) {
+        // on getChunk. Dirty chunks aren't evicted either: the chunks of the tables
+        // held at this level, temporary ones or not yet checkpointed, have no other copy.
+        if (evictIt->memStatus == USED &&
+            (evictIt->buffer->getPinCount() > 0 || evictIt->buffer->isDirty())) {
           break;
         }
         pageCount += evictIt->numPages;
@@ -392,7 +450,7 @@ BufferList::iterator BufferMgr::findFreeBuffer(size_t numBytes) {
           // chunk score was larger than one large chunk so it always would evict a large
           // chunk so under memory pressure a query would evict its own current chunks and
           // cause reloads rather than evict several smaller unused older chunks.
-          score = std::max(score, static_cast<size_t>(evictIt->lastTouched));
+          score = std::max(score, evictionScore(*evictIt));
         }
         if (pageCount >= numPagesRequested) {
           solutionFound = true;
@@ -431,6 +489,58 @@ BufferList::iterator BufferMgr::findFreeBuffer(size_t numBytes) {
   return bestEvictionStart;
 }
 
+AbstractBuffer* BufferMgr::pinResidentBuffer(const ChunkKey& key, const size_t numBytes) {
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  auto bufferIt = chunkIndex_.find(key);
+  if (bufferIt == chunkIndex_.end() || loadingChunks_.count(key)) {
+    return nullptr;
+  }
+  auto& seg = *bufferIt->second;
+  CHECK(seg.buffer);
+  if (seg.buffer->size() < numBytes) {
+    return nullptr;
+  }
+  seg.buffer->pin();
+  touchSegment(seg);
+  ++numHits_;
+  return seg.buffer;
+}
+
+void BufferMgr::markLoaded(const ChunkKey& key) {
+  mapd_lock_guard<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  loadingChunks_.erase(key);
+}
+
+void BufferMgr::touchSegment(BufferSeg& seg) {
+  const auto stripe = reinterpret_cast<uintptr_t>(&seg) / sizeof(BufferSeg);
+  std::lock_guard<std::mutex> touchLock(touchMutexes_[stripe % touchMutexes_.size()]);
+  seg.lastTouched = bufferEpoch_++;
+  ++seg.touchCount;
+}
+
+size_t BufferMgr::evictionScore(const BufferSeg& seg) const {
+  const auto score = evictionPolicy_->score(seg);
+  if (seg.chunkKey.size() < 2) {
+    return score;
+  }
+  const auto it = tablePriorities_.find(std::make_pair(seg.chunkKey[0], seg.chunkKey[1]));
+  if (it == tablePriorities_.end()) {
+    return score;
+  }
+  return (static_cast<size_t>(it->second) << 40) + score;
+}
+
+void BufferMgr::setTablePriority(const int db_id, const int tb_id, const int priority) {
+  CHECK_GE(priority, 0);
+  CHECK_LT(priority, 1 << 16);
+  std::lock_guard<std::mutex> lock(globalMutex_);
+  if (priority) {
+    tablePriorities_[std::make_pair(db_id, tb_id)] = priority;
+  } else {
+    tablePriorities_.erase(std::make_pair(db_id, tb_id));
+  }
+}
+
 std::string BufferMgr::printSlab(size_t slabNum) {
   std::ostringstream tss;
   // size_t lastEnd = 0;
@@ -590,7 +700,7 @@ void BufferMgr::printSegs() {
 }
 
 bool BufferMgr::isBufferOnDevice(const ChunkKey& key) {
-  std::lock_guard<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   if (chunkIndex_.find(key) == chunkIndex_.end()) {
     return false;
   } else {
@@ -600,7 +710,7 @@ bool BufferMgr::isBufferOnDevice(const ChunkKey& key) {
 
 /// This method throws a runtime_error when deleting a Chunk that does not exist.
 void BufferMgr::deleteBuffer(const ChunkKey& key, const bool purge) {
-  std::unique_lock<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_unique_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   // Note: purge is currently unused
 
   // lookup the buffer for the Chunk in chunkIndex_
@@ -609,7 +719,11 @@ void BufferMgr::deleteBuffer(const ChunkKey& key, const bool purge) {
   CHECK(bufferIt != chunkIndex_.end());
   auto segIt = bufferIt->second;
   chunkIndex_.erase(bufferIt);
+  loadingChunks_.erase(key);
   chunkIndexLock.unlock();
+  if (compressedCache_) {
+    compressedCache_->erase(key);
+  }
   std::lock_guard<std::mutex> sizedSegsLock(sizedSegsMutex_);
   if (segIt->buffer) {
     delete segIt->buffer;  // Delete Buffer for segment
@@ -625,7 +739,10 @@ void BufferMgr::deleteBuffersWithPrefix(const ChunkKey& keyPrefix, const bool pu
       sizedSegsMutex_);  // Take this lock early to prevent deadlock with
                          // reserveBuffer which needs segsMutex_ and then
                          // chunkIndexMutex_
-  std::lock_guard<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_lock_guard<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  if (compressedCache_) {
+    compressedCache_->erase(keyPrefix);
+  }
   auto startChunkIt = chunkIndex_.lower_bound(keyPrefix);
   if (startChunkIt == chunkIndex_.end()) {
     return;
@@ -643,6 +760,7 @@ void BufferMgr::deleteBuffersWithPrefix(const ChunkKey& keyPrefix, const bool pu
       segIt->buffer = 0;
     }
     removeSegment(segIt);
+    loadingChunks_.erase(bufferIt->first);
     chunkIndex_.erase(bufferIt++);
   }
 }
@@ -678,54 +796,111 @@ void BufferMgr::removeSegment(BufferList::iterator& segIt) {
   }
 }
 
-void BufferMgr::checkpoint() {
-  std::lock_guard<std::mutex> lock(globalMutex_);  // granular lock
-
-  for (auto bufferIt = chunkIndex_.begin(); bufferIt != chunkIndex_.end(); ++bufferIt) {
-    if (bufferIt->second->chunkKey[0] != -1 &&
-        bufferIt->second->buffer->isDirty_) {  // checks that buffer is actual chunk (not
-                                               // just buffer) and is dirty
+size_t BufferMgr::compact() {
+  std::lock_guard<std::mutex> lock(globalMutex_);
+  std::lock_guard<std::mutex> sizedSegsLock(sizedSegsMutex_);
+  mapd_lock_guard<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  size_t movedBytes = 0;
+  for (size_t slabNum = 0; slabNum != slabSegments_.size(); ++slabNum) {
+    movedBytes += compactSlab(slabNum);
+  }
+  LOG(INFO) << "Compacted the slabs of " << getStringMgrType() << ":" << deviceId_
+            << ", moved " << movedBytes << "B";
+  return movedBytes;
+}
 
-      parentMgr_->putBuffer(bufferIt->second->chunkKey, bufferIt->second->buffer);
-      bufferIt->second->buffer->clearDirtyBits();
+size_t BufferMgr::compactSlab(const size_t slabNum) {
+  auto& segs = slabSegments_[slabNum];
+  if (segs.empty()) {
+    return 0;
+  }
+  const size_t numSlabPages = segs.back().startPage + segs.back().numPages;
+  size_t movedBytes = 0;
+  size_t nextPage = 0;
+  for (auto segIt = segs.begin(); segIt != segs.end();) {
+    if (segIt->memStatus == FREE) {
+      segIt = segs.erase(segIt);
+      continue;
+    }
+    // Pinned chunks and the buffers of the executor are used through raw pointers,
+    // only the unpinned chunks can move.
+    const bool isMovable = segIt->buffer && segIt->buffer->getPinCount() == 0 &&
+                           !segIt->chunkKey.empty() && segIt->chunkKey[0] >= 0 &&
+                           !loadingChunks_.count(segIt->chunkKey);
+    if (isMovable && static_cast<size_t>(segIt->startPage) > nextPage) {
+      auto buffer = segIt->buffer;
+      int8_t* oldMem = buffer->mem_;
+      const size_t numBytes = buffer->size();
+      const size_t distance = (segIt->startPage - nextPage) * pageSize_;
+      buffer->mem_ = slabs_[slabNum] + nextPage * pageSize_;
+      // In pieces no longer than the distance, no copy overlaps its source.
+      for (size_t offset = 0; offset < numBytes; offset += distance) {
+        buffer->writeData(oldMem + offset,
+                          std::min(distance, numBytes - offset),
+                          offset,
+                          buffer->getType(),
+                          deviceId_);
+      }
+      segIt->startPage = nextPage;
+      movedBytes += numBytes;
     }
+    if (static_cast<size_t>(segIt->startPage) > nextPage) {
+      segs.insert(segIt, BufferSeg(nextPage, segIt->startPage - nextPage, FREE));
+    }
+    nextPage = segIt->startPage + segIt->numPages;
+    ++segIt;
+  }
+  if (nextPage < numSlabPages) {
+    segs.push_back(BufferSeg(nextPage, numSlabPages - nextPage, FREE));
   }
+  return movedBytes;
 }
 
-void BufferMgr::checkpoint(const int db_id, const int tb_id) {
-  std::lock_guard<std::mutex> lock(globalMutex_);  // granular lock
-  ChunkKey keyPrefix;
-  keyPrefix.push_back(db_id);
-  keyPrefix.push_back(tb_id);
-  auto startChunkIt = chunkIndex_.lower_bound(keyPrefix);
-  if (startChunkIt == chunkIndex_.end()) {
-    return;
-  }
+void BufferMgr::checkpoint() {
+  flushDirtyBuffers({});
+}
 
-  auto bufferIt = startChunkIt;
-  while (bufferIt != chunkIndex_.end() &&
-         std::search(bufferIt->first.begin(),
-                     bufferIt->first.begin() + keyPrefix.size(),
-                     keyPrefix.begin(),
-                     keyPrefix.end()) != bufferIt->first.begin() + keyPrefix.size()) {
-    if (bufferIt->second->chunkKey[0] != -1 &&
-        bufferIt->second->buffer->isDirty_) {  // checks that buffer is actual chunk (not
-                                               // just buffer) and is dirty
+void BufferMgr::checkpoint(const int db_id, const int tb_id) {
+  flushDirtyBuffers({db_id, tb_id});
+}
 
-      parentMgr_->putBuffer(bufferIt->second->chunkKey, bufferIt->second->buffer);
-      bufferIt->second->buffer->clearDirtyBits();
+void BufferMgr::flushDirtyBuffers(const ChunkKey& keyPrefix) {
+  // Pin the dirty chunks instead of holding the pool locks while they are written out,
+  // so that queries and the checkpoints of other tables can use the pool meanwhile.
+  std::vector<std::pair<ChunkKey, Buffer*>> dirtyBuffers;
+  {
+    mapd_shared_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+    for (auto bufferIt = chunkIndex_.lower_bound(keyPrefix);
+         bufferIt != chunkIndex_.end() && bufferIt->first.size() >= keyPrefix.size() &&
+         std::equal(keyPrefix.begin(), keyPrefix.end(), bufferIt->first.begin());
+         ++bufferIt) {
+      if (bufferIt->second->chunkKey[0] != -1 &&
+          bufferIt->second->buffer->isDirty_) {  // checks that buffer is actual chunk
+                                                 // (not just buffer) and is dirty
+        bufferIt->second->buffer->pin();
+        dirtyBuffers.emplace_back(bufferIt->first, bufferIt->second->buffer);
+      }
     }
-    bufferIt++;
+  }
+  for (auto& dirtyBuffer : dirtyBuffers) {
+    parentMgr_->putBuffer(dirtyBuffer.first, dirtyBuffer.second);
+    dirtyBuffer.second->clearDirtyBits();
+    dirtyBuffer.second->unPin();
   }
 }
 
 /// Returns a pointer to the Buffer holding the chunk, if it exists; otherwise,
 /// throws a runtime_error.
 AbstractBuffer* BufferMgr::getBuffer(const ChunkKey& key, const size_t numBytes) {
+  auto residentBuffer = pinResidentBuffer(key, numBytes);
+  if (residentBuffer) {
+    return residentBuffer;
+  }
+
   std::lock_guard<std::mutex> lock(globalMutex_);  // granular lock
 
   std::unique_lock<std::mutex> sizedSegsLock(sizedSegsMutex_);
-  std::unique_lock<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_unique_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   auto bufferIt = chunkIndex_.find(key);
   bool foundBuffer = bufferIt != chunkIndex_.end();
   chunkIndexLock.unlock();
@@ -733,7 +908,8 @@ AbstractBuffer* BufferMgr::getBuffer(const ChunkKey& key, const size_t numBytes)
     CHECK(bufferIt->second->buffer);
     bufferIt->second->buffer->pin();
     sizedSegsLock.unlock();
-    bufferIt->second->lastTouched = bufferEpoch_++;  // race
+    ++numHits_;
+    touchSegment(*bufferIt->second);
     if (bufferIt->second->buffer->size() <
         numBytes) {  // need to fetch part of buffer we don't have - up to numBytes
       parentMgr_->fetchBuffer(key, bufferIt->second->buffer, numBytes);
@@ -741,15 +917,19 @@ AbstractBuffer* BufferMgr::getBuffer(const ChunkKey& key, const size_t numBytes)
     return bufferIt->second->buffer;
   } else {  // If wasn't in pool then we need to fetch it
     sizedSegsLock.unlock();
+    ++numMisses_;
     AbstractBuffer* buffer =
         createBuffer(key, pageSize_, numBytes);  // createChunk pins for us
     try {
-      parentMgr_->fetchBuffer(
-          key, buffer, numBytes);  // this should put buffer in a BufferSegment
+      if (!fetchBufferFromPeer(key, buffer, numBytes)) {
+        fetchBufferFromParent(
+            key, buffer, numBytes);  // this should put buffer in a BufferSegment
+      }
     } catch (std::runtime_error& error) {
       LOG(FATAL) << "Get chunk - Could not find chunk " << keyToString(key)
                  << " in buffer pool or parent buffer pools. Error was " << error.what();
     }
+    markLoaded(key);
     return buffer;
   }
 }
@@ -757,37 +937,42 @@ AbstractBuffer* BufferMgr::getBuffer(const ChunkKey& key, const size_t numBytes)
 void BufferMgr::fetchBuffer(const ChunkKey& key,
                             AbstractBuffer* destBuffer,
                             const size_t numBytes) {
-  std::unique_lock<std::mutex> lock(globalMutex_);  // granular lock
-  std::unique_lock<std::mutex> sizedSegsLock(sizedSegsMutex_);
-  std::unique_lock<std::mutex> chunkIndexLock(chunkIndexMutex_);
-
-  auto bufferIt = chunkIndex_.find(key);
-  bool foundBuffer = bufferIt != chunkIndex_.end();
-  chunkIndexLock.unlock();
-  AbstractBuffer* buffer;
-  if (!foundBuffer) {
-    sizedSegsLock.unlock();
-    CHECK(parentMgr_ != 0);
-    buffer = createBuffer(key, pageSize_, numBytes);  // will pin buffer
-    try {
-      parentMgr_->fetchBuffer(key, buffer, numBytes);
-    } catch (std::runtime_error& error) {
-      LOG(FATAL) << "Could not fetch parent buffer " << keyToString(key);
-    }
-  } else {
-    buffer = bufferIt->second->buffer;
-    buffer->pin();
-    if (numBytes > buffer->size()) {
+  auto buffer = pinResidentBuffer(key, numBytes);
+  if (!buffer) {
+    std::lock_guard<std::mutex> lock(globalMutex_);  // granular lock
+    std::unique_lock<std::mutex> sizedSegsLock(sizedSegsMutex_);
+    mapd_unique_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+
+    auto bufferIt = chunkIndex_.find(key);
+    bool foundBuffer = bufferIt != chunkIndex_.end();
+    chunkIndexLock.unlock();
+    if (!foundBuffer) {
+      sizedSegsLock.unlock();
+      ++numMisses_;
+      CHECK(parentMgr_ != 0);
+      buffer = createBuffer(key, pageSize_, numBytes);  // will pin buffer
       try {
-        parentMgr_->fetchBuffer(key, buffer, numBytes);
+        fetchBufferFromParent(key, buffer, numBytes);
       } catch (std::runtime_error& error) {
         LOG(FATAL) << "Could not fetch parent buffer " << keyToString(key);
       }
+      markLoaded(key);
+    } else {
+      buffer = bufferIt->second->buffer;
+      buffer->pin();
+      ++numHits_;
+      touchSegment(*bufferIt->second);
+      if (numBytes > buffer->size()) {
+        try {
+          parentMgr_->fetchBuffer(key, buffer, numBytes);
+        } catch (std::runtime_error& error) {
+          LOG(FATAL) << "Could not fetch parent buffer " << keyToString(key);
+        }
+      }
+      sizedSegsLock.unlock();
     }
-    sizedSegsLock.unlock();
   }
   size_t chunkSize = numBytes == 0 ? buffer->size() : numBytes;
-  lock.unlock();
   destBuffer->reserve(chunkSize);
   if (buffer->isUpdated()) {
     buffer->read(destBuffer->getMemoryPtr(),
@@ -807,10 +992,66 @@ void BufferMgr::fetchBuffer(const ChunkKey& key,
   buffer->unPin();
 }
 
+// Only for a known size: a peer may hold fewer rows of a chunk appended to since.
+bool BufferMgr::fetchBufferFromPeer(const ChunkKey& key,
+                                    AbstractBuffer* destBuffer,
+                                    const size_t numBytes) {
+  if (numBytes == 0) {
+    return false;
+  }
+  for (auto peerMgr : peerMgrs_) {
+    auto buffer = peerMgr->pinResidentBuffer(key, numBytes);
+    if (!buffer) {
+      continue;
+    }
+    destBuffer->reserve(numBytes);
+    buffer->read(destBuffer->getMemoryPtr(),
+                 numBytes,
+                 0,
+                 destBuffer->getType(),
+                 destBuffer->getDeviceId());
+    destBuffer->setSize(numBytes);
+    destBuffer->syncEncoder(buffer);
+    buffer->unPin();
+    return true;
+  }
+  return false;
+}
+
+void BufferMgr::fetchBufferFromParent(const ChunkKey& key,
+                                      AbstractBuffer* destBuffer,
+                                      const size_t numBytes) {
+  if (!fetchBufferFromCompressedCache(key, destBuffer, numBytes)) {
+    parentMgr_->fetchBuffer(key, destBuffer, numBytes);
+  }
+}
+
+bool BufferMgr::fetchBufferFromCompressedCache(const ChunkKey& key,
+                                               AbstractBuffer* destBuffer,
+                                               const size_t numBytes) {
+  if (!compressedCache_ || parentMgr_->isForeignBuffer(key)) {
+    return false;
+  }
+  // The chunk on disk has the encoder, and tells the size of the whole chunk.
+  auto chunk = parentMgr_->getBuffer(key);
+  const size_t chunkSize = numBytes == 0 ? chunk->size() : numBytes;
+  if (chunkSize == 0 || chunkSize > chunk->size()) {
+    compressedCache_->erase(key);
+    return false;
+  }
+  destBuffer->reserve(chunkSize);
+  if (!compressedCache_->take(key, destBuffer->getMemoryPtr(), chunkSize)) {
+    return false;
+  }
+  destBuffer->setSize(chunkSize);
+  destBuffer->syncEncoder(chunk);
+  return true;
+}
+
 AbstractBuffer* BufferMgr::putBuffer(const ChunkKey& key,
                                      AbstractBuffer* srcBuffer,
                                      const size_t numBytes) {
-  std::unique_lock<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_unique_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   auto bufferIt = chunkIndex_.find(key);
   bool foundBuffer = bufferIt != chunkIndex_.end();
   chunkIndexLock.unlock();
@@ -841,6 +1082,12 @@ AbstractBuffer* BufferMgr::putBuffer(const ChunkKey& key,
   }
   srcBuffer->clearDirtyBits();
   buffer->syncEncoder(srcBuffer);
+  if (compressedCache_) {
+    compressedCache_->erase(key);
+  }
+  if (!foundBuffer) {
+    markLoaded(key);
+  }
   return buffer;
 }
 
@@ -866,10 +1113,21 @@ void BufferMgr::free(AbstractBuffer* buffer) {
 }
 
 size_t BufferMgr::getNumChunks() {
-  std::lock_guard<std::mutex> chunkIndexLock(chunkIndexMutex_);
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
   return chunkIndex_.size();
 }
 
+std::vector<std::pair<ChunkKey, unsigned int>> BufferMgr::getResidentChunks() {
+  std::vector<std::pair<ChunkKey, unsigned int>> residentChunks;
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexLock(chunkIndexMutex_);
+  for (const auto& chunk : chunkIndex_) {
+    if (chunk.first[0] != -1 && !loadingChunks_.count(chunk.first)) {
+      residentChunks.emplace_back(chunk.first, chunk.second->touchCount);
+    }
+  }
+  return residentChunks;
+}
+
 size_t BufferMgr::size() {
   return numPagesAllocated_;
 }
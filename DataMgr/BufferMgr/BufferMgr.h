@@ -25,14 +25,29 @@
 #ifndef DATAMGR_MEMORY_BUFFER_BUFFERMGR_H
 #define DATAMGR_MEMORY_BUFFER_BUFFERMGR_H
 
+#include <array>
+#include <atomic>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
 #include "../AbstractBuffer.h"
 #include "../AbstractBufferMgr.h"
+#include "../Shared/mapd_shared_mutex.h"
 #include "../Shared/types.h"
 #include "BufferSeg.h"
+#include "CompressedChunkCache.h"
+#include "EvictionPolicy.h"
+
+// Name of the eviction policy of the buffer pools, see create_eviction_policy.
+extern std::string g_buffer_eviction_policy;
+// Copy the chunks missing on a GPU from the GPUs holding them, not from the CPU pool.
+extern bool g_enable_peer_chunk_copies;
+// Move the unpinned chunks of a slab together instead of evicting chunks when the free
+// pages of the slab add up to an allocation.
+extern bool g_enable_buffer_pool_compaction;
 
 class OutOfMemory : public std::runtime_error {
  public:
@@ -100,6 +115,19 @@ class BufferMgr : public AbstractBufferMgr {  // implements
   size_t getPageSize();
   bool isAllocationCapped();
   const std::vector<BufferList>& getSlabSegments();
+  size_t getNumHits() const { return numHits_; }
+  size_t getNumMisses() const { return numMisses_; }
+  size_t getNumEvictions() const { return numEvictions_; }
+  /// The compressed copies of the chunks evicted, null unless a CPU pool caches them.
+  CompressedChunkCache* getCompressedCache() { return compressedCache_.get(); }
+
+  /// Chunks of tables with a higher priority are only evicted when no chunk of a table
+  /// with a lower priority can make room. The default priority is zero.
+  void setTablePriority(const int db_id, const int tb_id, const int priority);
+
+  /// Pools of the devices the device of this pool can copy from directly. A chunk
+  /// missing here is copied from the first of them holding it before asking the parent.
+  void setPeerMgrs(const std::vector<BufferMgr*>& peerMgrs) { peerMgrs_ = peerMgrs; }
 
   /// Creates a chunk with the specified key and page size.
   virtual AbstractBuffer* createBuffer(const ChunkKey& key,
@@ -135,9 +163,15 @@ class BufferMgr : public AbstractBufferMgr {  // implements
   virtual void free(AbstractBuffer* buffer);
   // virtual AbstractBuffer* putBuffer(AbstractBuffer *d);
 
+  /// Moves the unpinned chunks of every slab to its start, so that its free pages are
+  /// contiguous. Returns the bytes moved.
+  size_t compact();
+
   /// Returns the total number of bytes allocated.
   size_t size();
   size_t getNumChunks();
+  /// Keys of the chunks in the pool, with the number of times each was touched.
+  std::vector<std::pair<ChunkKey, unsigned int>> getResidentChunks();
 
   BufferList::iterator reserveBuffer(BufferList::iterator& segIt, const size_t numBytes);
   virtual void getChunkMetadataVec(
@@ -156,21 +190,42 @@ class BufferMgr : public AbstractBufferMgr {  // implements
   BufferMgr(const BufferMgr&);             // private copy constructor
   BufferMgr& operator=(const BufferMgr&);  // private assignment
   void removeSegment(BufferList::iterator& segIt);
+  /// Requires the chunk index lock held exclusively, see compact.
+  size_t compactSlab(const size_t slabNum);
   BufferList::iterator findFreeBufferInSlab(const size_t slabNum,
                                             const size_t numPagesRequested);
   int getBufferId();
+  /// Pins and returns the buffer of a chunk already filled up to numBytes, or returns
+  /// null. Only takes the chunk index lock shared, see findFreeBuffer.
+  AbstractBuffer* pinResidentBuffer(const ChunkKey& key, const size_t numBytes);
+  bool fetchBufferFromPeer(const ChunkKey& key,
+                           AbstractBuffer* destBuffer,
+                           const size_t numBytes);
+  /// Fills a buffer just created for a chunk missing from the pool, from its compressed
+  /// copy if there's one, from the parent otherwise.
+  void fetchBufferFromParent(const ChunkKey& key,
+                             AbstractBuffer* destBuffer,
+                             const size_t numBytes);
+  bool fetchBufferFromCompressedCache(const ChunkKey& key,
+                                      AbstractBuffer* destBuffer,
+                                      const size_t numBytes);
+  void flushDirtyBuffers(const ChunkKey& keyPrefix);
+  void markLoaded(const ChunkKey& key);
+  void touchSegment(BufferSeg& seg);
   virtual void addSlab(const size_t slabSize) = 0;
   virtual void freeAllMem() = 0;
   virtual void allocateBuffer(BufferList::iterator segIt,
                               const size_t pageSize,
                               const size_t numBytes) = 0;
-  std::mutex chunkIndexMutex_;
+  mapd_shared_mutex chunkIndexMutex_;
   std::mutex sizedSegsMutex_;
   std::mutex unsizedSegsMutex_;
   std::mutex bufferIdMutex_;
   std::mutex globalMutex_;
 
   std::map<ChunkKey, BufferList::iterator> chunkIndex_;
+  std::set<ChunkKey> loadingChunks_;  /// created, but still being filled
+  std::array<std::mutex, 16> touchMutexes_;
   size_t maxBufferSize_;  /// max number of bytes allocated for the buffer pool
   size_t maxNumPages_;
   size_t numPagesAllocated_;
@@ -181,7 +236,14 @@ class BufferMgr : public AbstractBufferMgr {  // implements
   bool allocationsCapped_;
   AbstractBufferMgr* parentMgr_;
   int maxBufferId_;
-  unsigned int bufferEpoch_;
+  std::atomic<unsigned int> bufferEpoch_;
+  std::unique_ptr<EvictionPolicy> evictionPolicy_;
+  std::map<std::pair<int, int>, int> tablePriorities_;
+  std::vector<BufferMgr*> peerMgrs_;
+  std::unique_ptr<CompressedChunkCache> compressedCache_;
+  std::atomic<size_t> numHits_;
+  std::atomic<size_t> numMisses_;
+  std::atomic<size_t> numEvictions_;
   // File_Namespace::FileMgr *fileMgr_;
 
   /// Maps sizes of free memory areas to host buffer pool memory addresses
@@ -194,6 +256,7 @@ class BufferMgr : public AbstractBufferMgr {  // implements
                              const size_t numPagesRequested,
                              const int slabNum);
   BufferList::iterator findFreeBuffer(size_t numBytes);
+  size_t evictionScore(const BufferSeg& seg) const;
 
   /**
    * @brief Gets a buffer of required size and returns an iterator to it
@@ -35,8 +35,15 @@ struct BufferSeg {
   unsigned int pinCount;
   int slabNum;
   unsigned int lastTouched;
+  unsigned int touchCount;
 
-  BufferSeg() : memStatus(FREE), buffer(0), pinCount(0), slabNum(-1), lastTouched(0) {}
+  BufferSeg()
+      : memStatus(FREE)
+      , buffer(0)
+      , pinCount(0)
+      , slabNum(-1)
+      , lastTouched(0)
+      , touchCount(0) {}
   BufferSeg(const int startPage, const size_t numPages)
       : startPage(startPage)
       , numPages(numPages)
@@ -44,7 +51,8 @@ struct BufferSeg {
       , buffer(0)
       , pinCount(0)
       , slabNum(-1)
-      , lastTouched(0) {}
+      , lastTouched(0)
+      , touchCount(0) {}
   BufferSeg(const int startPage, const size_t numPages, const MemStatus memStatus)
       : startPage(startPage)
       , numPages(numPages)
@@ -52,7 +60,8 @@ struct BufferSeg {
       , buffer(0)
       , pinCount(0)
       , slabNum(-1)
-      , lastTouched(0) {}
+      , lastTouched(0)
+      , touchCount(0) {}
   BufferSeg(const int startPage,
             const size_t numPages,
             const MemStatus memStatus,
@@ -63,7 +72,8 @@ struct BufferSeg {
       , buffer(0)
       , pinCount(0)
       , slabNum(-1)
-      , lastTouched(lastTouched) {}
+      , lastTouched(lastTouched)
+      , touchCount(0) {}
 };
 
 typedef std::list<BufferSeg> BufferList;
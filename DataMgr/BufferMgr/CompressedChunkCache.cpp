@@ -0,0 +1,215 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompressedChunkCache.h"
+
+#include <glog/logging.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+size_t g_compressed_chunk_cache_bytes{0};
+
+namespace Buffer_Namespace {
+
+namespace {
+
+// Returns the compressed data, empty if it isn't smaller than the input.
+std::vector<int8_t> compress_chunk(const std::vector<int8_t>& src, const int level) {
+  uLongf dstSize = compressBound(src.size());
+  std::vector<int8_t> dst(dstSize);
+  const int rc = compress2(reinterpret_cast<Bytef*>(dst.data()),
+                           &dstSize,
+                           reinterpret_cast<const Bytef*>(src.data()),
+                           src.size(),
+                           level);
+  if (rc != Z_OK || dstSize >= src.size()) {
+    return {};
+  }
+  dst.resize(dstSize);
+  dst.shrink_to_fit();
+  return dst;
+}
+
+// Only inflates the first dstSize bytes, the prefix of a chunk is often all a fetch
+// asks for.
+void uncompress_chunk(const std::vector<int8_t>& src, int8_t* dst, const size_t dstSize) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  CHECK_EQ(Z_OK, inflateInit(&stream));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<int8_t*>(src.data()));
+  stream.avail_in = src.size();
+  stream.next_out = reinterpret_cast<Bytef*>(dst);
+  stream.avail_out = dstSize;
+  int rc = Z_OK;
+  while (rc == Z_OK && stream.avail_out > 0) {
+    rc = inflate(&stream, Z_NO_FLUSH);
+  }
+  inflateEnd(&stream);
+  CHECK(rc == Z_OK || rc == Z_STREAM_END);
+  CHECK_EQ(0u, stream.avail_out);
+}
+
+bool has_prefix(const ChunkKey& key, const ChunkKey& keyPrefix) {
+  return key.size() >= keyPrefix.size() &&
+         std::equal(keyPrefix.begin(), keyPrefix.end(), key.begin());
+}
+
+}  // namespace
+
+CompressedChunkCache::CompressedChunkCache(const size_t maxBytes,
+                                           const int compressionLevel)
+    : maxBytes_(maxBytes)
+    , compressionLevel_(compressionLevel)
+    , bytes_(0)
+    , numCompressing_(0)
+    , stop_(false)
+    , numHits_(0) {
+  compressor_ = std::thread(&CompressedChunkCache::compressChunks, this);
+}
+
+CompressedChunkCache::~CompressedChunkCache() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  compressor_.join();
+}
+
+void CompressedChunkCache::put(const ChunkKey& key,
+                               const int8_t* data,
+                               const size_t size) {
+  if (size == 0 || size > maxBytes_) {
+    return;
+  }
+  auto copy = std::make_shared<std::vector<int8_t>>(data, data + size);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto entryIt = entries_.find(key);
+    if (entryIt != entries_.end()) {
+      eraseEntry(entryIt);
+    }
+    while (bytes_ + size > maxBytes_ && !lru_.empty()) {
+      eraseEntry(entries_.find(lru_.back()));
+    }
+    lru_.push_front(key);
+    entries_[key] = Entry{copy, size, false, lru_.begin()};
+    bytes_ += size;
+    pending_.push_back(key);
+  }
+  cv_.notify_all();
+}
+
+bool CompressedChunkCache::take(const ChunkKey& key, int8_t* dst, const size_t numBytes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto entryIt = entries_.find(key);
+  if (entryIt == entries_.end()) {
+    return false;
+  }
+  if (entryIt->second.size < numBytes) {
+    eraseEntry(entryIt);
+    return false;
+  }
+  const auto data = entryIt->second.data;
+  const bool compressed = entryIt->second.compressed;
+  eraseEntry(entryIt);
+  lock.unlock();
+  if (compressed) {
+    uncompress_chunk(*data, dst, numBytes);
+  } else {
+    memcpy(dst, data->data(), numBytes);
+  }
+  ++numHits_;
+  return true;
+}
+
+void CompressedChunkCache::erase(const ChunkKey& keyPrefix) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entryIt = entries_.lower_bound(keyPrefix);
+  while (entryIt != entries_.end() && has_prefix(entryIt->first, keyPrefix)) {
+    eraseEntry(entryIt++);
+  }
+}
+
+void CompressedChunkCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  pending_.clear();
+  bytes_ = 0;
+}
+
+void CompressedChunkCache::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return pending_.empty() && numCompressing_ == 0; });
+}
+
+size_t CompressedChunkCache::getBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+size_t CompressedChunkCache::getNumChunks() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void CompressedChunkCache::eraseEntry(std::map<ChunkKey, Entry>::iterator entryIt) {
+  // A pending key without an entry is skipped by the compressor.
+  bytes_ -= entryIt->second.data->size();
+  lru_.erase(entryIt->second.lruIt);
+  entries_.erase(entryIt);
+}
+
+void CompressedChunkCache::compressChunks() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (stop_) {
+      return;
+    }
+    const auto key = pending_.front();
+    pending_.pop_front();
+    auto entryIt = entries_.find(key);
+    if (entryIt == entries_.end() || entryIt->second.compressed) {
+      continue;
+    }
+    const auto data = entryIt->second.data;
+    ++numCompressing_;
+    lock.unlock();
+    auto compressed =
+        std::make_shared<std::vector<int8_t>>(compress_chunk(*data, compressionLevel_));
+    lock.lock();
+    --numCompressing_;
+    entryIt = entries_.find(key);
+    // Taken, or taken and put again, in the meantime.
+    if (entryIt != entries_.end() && entryIt->second.data == data) {
+      if (compressed->empty()) {
+        // Not worth the memory uncompressed, the disk still has it.
+        eraseEntry(entryIt);
+      } else {
+        bytes_ -= data->size();
+        bytes_ += compressed->size();
+        entryIt->second.data = compressed;
+        entryIt->second.compressed = true;
+      }
+    }
+    cv_.notify_all();
+  }
+}
+
+}  // namespace Buffer_Namespace
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    CompressedChunkCache.h
+ * @brief   Compressed copies, in memory, of the chunks evicted from the CPU buffer pool.
+ *
+ * A chunk evicted from the CPU pool is copied as is and compressed by a background
+ * thread, so that loading it again only costs decompressing it instead of reading it
+ * from disk. A chunk loaded again leaves the cache, the least recently evicted chunks
+ * make room for new ones.
+ */
+
+#ifndef DATAMGR_MEMORY_BUFFER_COMPRESSEDCHUNKCACHE_H
+#define DATAMGR_MEMORY_BUFFER_COMPRESSEDCHUNKCACHE_H
+
+#include "Shared/types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bytes of memory for the compressed copies of the chunks evicted from the CPU buffer
+// pool, zero, the default, to read evicted chunks from disk again.
+extern size_t g_compressed_chunk_cache_bytes;
+
+namespace Buffer_Namespace {
+
+class CompressedChunkCache {
+ public:
+  // Level 1, the fastest of zlib, by default.
+  CompressedChunkCache(const size_t maxBytes, const int compressionLevel = 1);
+  ~CompressedChunkCache();
+
+  // Keeps a copy of the chunk, compressed later.
+  void put(const ChunkKey& key, const int8_t* data, const size_t size);
+
+  // Copies the first numBytes bytes of the chunk to dst and drops the chunk. Returns
+  // false if the chunk isn't cached or has fewer bytes.
+  bool take(const ChunkKey& key, int8_t* dst, const size_t numBytes);
+
+  void erase(const ChunkKey& keyPrefix);
+  void clear();
+
+  // Waits until the chunks put so far are compressed.
+  void flush();
+
+  size_t getBytes();
+  size_t getNumChunks();
+  size_t getNumHits() const { return numHits_; }
+
+ private:
+  struct Entry {
+    // The data as is until compressed, shared with the compression.
+    std::shared_ptr<std::vector<int8_t>> data;
+    size_t size;
+    bool compressed;
+    std::list<ChunkKey>::iterator lruIt;
+  };
+
+  void compressChunks();
+  // Requires mutex_.
+  void eraseEntry(std::map<ChunkKey, Entry>::iterator entryIt);
+
+  const size_t maxBytes_;
+  const int compressionLevel_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<ChunkKey, Entry> entries_;
+  // The most recently put first.
+  std::list<ChunkKey> lru_;
+  std::deque<ChunkKey> pending_;
+  size_t bytes_;
+  size_t numCompressing_;
+  bool stop_;
+  std::atomic<size_t> numHits_;
+  std::thread compressor_;
+};
+
+}  // namespace Buffer_Namespace
+
+#endif  // DATAMGR_MEMORY_BUFFER_COMPRESSEDCHUNKCACHE_H
@@ -16,19 +16,110 @@
 
 #include "CpuBufferMgr.h"
 #include <glog/logging.h>
+#include <sys/mman.h>
+#include <fstream>
 #include "../../../CudaMgr/CudaMgr.h"
 #include "CpuBuffer.h"
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace Buffer_Namespace {
 
+namespace {
+
+constexpr size_t kHugePageSize{size_t(2) << 20};
+
+#ifdef __linux__
+// Mask of the NUMA nodes online, parsed from a list like "0-1,3".
+unsigned long get_online_numa_nodes() {
+  std::ifstream online_file("/sys/devices/system/node/online");
+  unsigned long node_mask{0};
+  std::string range;
+  while (std::getline(online_file, range, ',')) {
+    const auto dash_pos = range.find('-');
+    try {
+      const auto first = std::stoul(range.substr(0, dash_pos));
+      const auto last =
+          dash_pos == std::string::npos ? first : std::stoul(range.substr(dash_pos + 1));
+      for (auto node = first; node <= last && node < 8 * sizeof(node_mask); ++node) {
+        node_mask |= 1UL << node;
+      }
+    } catch (std::logic_error&) {
+      return 0;
+    }
+  }
+  return node_mask;
+}
+#endif
+
+// Maps a slab of anonymous memory, returns nullptr on failure. Reserved huge pages are
+// tried first, then transparent ones.
+int8_t* map_slab(const size_t mapped_size,
+                 const bool use_huge_pages,
+                 const bool interleave_numa_nodes) {
+  void* slab{MAP_FAILED};
+#ifdef MAP_HUGETLB
+  if (use_huge_pages) {
+    slab = mmap(nullptr,
+                mapped_size,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1,
+                0);
+  }
+#endif
+  if (slab == MAP_FAILED) {
+    slab = mmap(
+        nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (slab == MAP_FAILED) {
+      return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages) {
+      madvise(slab, mapped_size, MADV_HUGEPAGE);
+    }
+#endif
+  }
+#ifdef __linux__
+  if (interleave_numa_nodes) {
+    // Before the first touch, which places the pages.
+    const auto node_mask = get_online_numa_nodes();
+    if (node_mask & (node_mask - 1)) {
+      if (syscall(SYS_mbind,
+                  slab,
+                  mapped_size,
+                  MPOL_INTERLEAVE,
+                  &node_mask,
+                  8 * sizeof(node_mask),
+                  0)) {
+        LOG(WARNING) << "Could not interleave a CPU buffer pool slab over the NUMA nodes";
+      }
+    }
+  }
+#endif
+  return static_cast<int8_t*>(slab);
+}
+
+}  // namespace
+
 CpuBufferMgr::CpuBufferMgr(const int deviceId,
                            const size_t maxBufferSize,
                            CudaMgr_Namespace::CudaMgr* cudaMgr,
                            const size_t bufferAllocIncrement,
                            const size_t pageSize,
-                           AbstractBufferMgr* parentMgr)
+                           AbstractBufferMgr* parentMgr,
+                           const size_t maxPinnedSize,
+                           const bool useHugePages,
+                           const bool interleaveNumaNodes)
     : BufferMgr(deviceId, maxBufferSize, bufferAllocIncrement, pageSize, parentMgr)
-    , cudaMgr_(cudaMgr) {}
+    , cudaMgr_(cudaMgr)
+    , maxPinnedSize_(cudaMgr ? maxPinnedSize : 0)
+    , pinnedSize_(0)
+    , useHugePages_(useHugePages)
+    , interleaveNumaNodes_(interleaveNumaNodes) {}
 
 CpuBufferMgr::~CpuBufferMgr() {
   freeAllMem();
@@ -36,20 +127,54 @@ CpuBufferMgr::~CpuBufferMgr() {
 
 void CpuBufferMgr::addSlab(const size_t slabSize) {
   slabs_.resize(slabs_.size() + 1);
-  try {
-    slabs_.back() = new int8_t[slabSize];
-  } catch (std::bad_alloc&) {
-    slabs_.resize(slabs_.size() - 1);
-    throw FailedToCreateSlab();
+  if (pinnedSize_ + slabSize <= maxPinnedSize_) {
+    try {
+      slabs_.back() = cudaMgr_->allocatePinnedHostMem(slabSize);
+      pinnedSize_ += slabSize;
+      slabMemory_.emplace_back(SlabMemory::Pinned, slabSize);
+    } catch (std::runtime_error& e) {
+      LOG(WARNING) << "Could not allocate a page-locked CPU buffer pool slab of "
+                   << slabSize << " bytes: " << e.what();
+      maxPinnedSize_ = 0;
+    }
+  }
+  if (slabMemory_.size() < slabs_.size() && (useHugePages_ || interleaveNumaNodes_)) {
+    const size_t mappedSize =
+        (slabSize + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    slabs_.back() = map_slab(mappedSize, useHugePages_, interleaveNumaNodes_);
+    if (slabs_.back()) {
+      slabMemory_.emplace_back(SlabMemory::Mapped, mappedSize);
+    }
+  }
+  if (slabMemory_.size() < slabs_.size()) {
+    try {
+      slabs_.back() = new int8_t[slabSize];
+      slabMemory_.emplace_back(SlabMemory::Heap, slabSize);
+    } catch (std::bad_alloc&) {
+      slabs_.resize(slabs_.size() - 1);
+      throw FailedToCreateSlab();
+    }
   }
   slabSegments_.resize(slabSegments_.size() + 1);
   slabSegments_[slabSegments_.size() - 1].push_back(BufferSeg(0, slabSize / pageSize_));
 }
 
 void CpuBufferMgr::freeAllMem() {
-  for (auto bufIt = slabs_.begin(); bufIt != slabs_.end(); ++bufIt) {
-    delete[] * bufIt;
+  CHECK_EQ(slabMemory_.size(), slabs_.size());
+  for (size_t slabNum = 0; slabNum < slabs_.size(); ++slabNum) {
+    switch (slabMemory_[slabNum].first) {
+      case SlabMemory::Pinned:
+        cudaMgr_->freePinnedHostMem(slabs_[slabNum]);
+        break;
+      case SlabMemory::Mapped:
+        munmap(slabs_[slabNum], slabMemory_[slabNum].second);
+        break;
+      default:
+        delete[] slabs_[slabNum];
+    }
   }
+  slabMemory_.clear();
+  pinnedSize_ = 0;
 }
 
 void CpuBufferMgr::allocateBuffer(BufferList::iterator segIt,
@@ -32,7 +32,10 @@ class CpuBufferMgr : public BufferMgr {
                CudaMgr_Namespace::CudaMgr* cudaMgr,
                const size_t bufferAllocIncrement = 2147483648,
                const size_t pageSize = 512,
-               AbstractBufferMgr* parentMgr = 0);
+               AbstractBufferMgr* parentMgr = 0,
+               const size_t maxPinnedSize = 0,
+               const bool useHugePages = false,
+               const bool interleaveNumaNodes = false);
   virtual inline MgrType getMgrType() { return CPU_MGR; }
   virtual inline std::string getStringMgrType() { return ToString(CPU_MGR); }
   ~CpuBufferMgr();
@@ -44,6 +47,18 @@ class CpuBufferMgr : public BufferMgr {
                               const size_t pageSize,
                               const size_t initialSize);
   CudaMgr_Namespace::CudaMgr* cudaMgr_;
+  // The slabs within this many bytes are page-locked, which lets the transfers to the
+  // GPUs skip the staging copy of the driver.
+  size_t maxPinnedSize_;
+  size_t pinnedSize_;
+  // The other slabs are mapped directly, backed by huge pages to spare the TLB misses
+  // of the scans and spread over the NUMA nodes to use the bandwidth of all of them.
+  bool useHugePages_;
+  bool interleaveNumaNodes_;
+
+  enum class SlabMemory { Heap, Pinned, Mapped };
+  // How each slab was allocated, along with the size of its mapping.
+  std::vector<std::pair<SlabMemory, size_t>> slabMemory_;
 };
 
 }  // namespace Buffer_Namespace
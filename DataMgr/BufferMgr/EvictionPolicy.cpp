@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EvictionPolicy.h"
+
+#include <stdexcept>
+
+namespace Buffer_Namespace {
+
+TwoQueueEvictionPolicy::TwoQueueEvictionPolicy(const size_t max_ghost_entries)
+    : max_ghost_entries_(max_ghost_entries) {}
+
+unsigned int TwoQueueEvictionPolicy::admit(const ChunkKey& key) {
+  auto it = ghost_keys_.find(key);
+  if (it == ghost_keys_.end()) {
+    return 0;
+  }
+  ghost_keys_.erase(it);
+  // The FIFO entry goes stale and is skipped when it reaches the front.
+  return 1;
+}
+
+void TwoQueueEvictionPolicy::evicted(const BufferSeg& seg) {
+  if (seg.touchCount > 1 || seg.chunkKey.empty() || seg.chunkKey[0] == -1) {
+    return;
+  }
+  if (!ghost_keys_.insert(seg.chunkKey).second) {
+    return;
+  }
+  ghost_fifo_.push_back(seg.chunkKey);
+  while (ghost_fifo_.size() > max_ghost_entries_) {
+    ghost_keys_.erase(ghost_fifo_.front());
+    ghost_fifo_.pop_front();
+  }
+}
+
+size_t TwoQueueEvictionPolicy::score(const BufferSeg& seg) const {
+  const size_t frequent_boost = seg.touchCount > 1 ? size_t(1) << 32 : 0;
+  return frequent_boost + seg.lastTouched;
+}
+
+std::unique_ptr<EvictionPolicy> create_eviction_policy(const std::string& name) {
+  if (name == "lru") {
+    return std::unique_ptr<EvictionPolicy>(new LruEvictionPolicy());
+  }
+  if (name == "2q") {
+    return std::unique_ptr<EvictionPolicy>(new TwoQueueEvictionPolicy(1 << 16));
+  }
+  throw std::runtime_error("Unknown buffer eviction policy " + name);
+}
+
+}  // namespace Buffer_Namespace
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    EvictionPolicy.h
+ * @brief   Ranking of the segments of a buffer pool for eviction.
+ *
+ * The buffer manager evicts the contiguous run of unpinned segments whose highest
+ * score is the lowest, so a policy only has to rank individual segments.
+ */
+
+#ifndef DATAMGR_MEMORY_BUFFER_EVICTIONPOLICY_H
+#define DATAMGR_MEMORY_BUFFER_EVICTIONPOLICY_H
+
+#include "Shared/types.h"
+#include "BufferSeg.h"
+
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace Buffer_Namespace {
+
+class EvictionPolicy {
+ public:
+  virtual ~EvictionPolicy() {}
+
+  // Number of earlier accesses to credit a chunk with when it's loaded in the pool.
+  virtual unsigned int admit(const ChunkKey& key) { return 0; }
+
+  virtual void evicted(const BufferSeg& seg) {}
+
+  // Segments with lower scores are evicted first; only the low 40 bits can be used.
+  virtual size_t score(const BufferSeg& seg) const = 0;
+};
+
+// Evicts the least recently touched segments first.
+class LruEvictionPolicy : public EvictionPolicy {
+ public:
+  size_t score(const BufferSeg& seg) const override { return seg.lastTouched; }
+};
+
+// Simplified 2Q: segments touched once, like the chunks of a wide scan, are evicted
+// before any segment touched more than once, least recently touched first within
+// each group. The keys of chunks evicted after a single touch are remembered for a
+// while, so a chunk which comes back soon is credited with its earlier access.
+class TwoQueueEvictionPolicy : public EvictionPolicy {
+ public:
+  explicit TwoQueueEvictionPolicy(const size_t max_ghost_entries);
+
+  unsigned int admit(const ChunkKey& key) override;
+
+  void evicted(const BufferSeg& seg) override;
+
+  size_t score(const BufferSeg& seg) const override;
+
+ private:
+  const size_t max_ghost_entries_;
+  std::list<ChunkKey> ghost_fifo_;
+  std::set<ChunkKey> ghost_keys_;
+};
+
+// Creates the policy with the given name, "lru" or "2q".
+std::unique_ptr<EvictionPolicy> create_eviction_policy(const std::string& name);
+
+}  // namespace Buffer_Namespace
+
+#endif  // DATAMGR_MEMORY_BUFFER_EVICTIONPOLICY_H
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ChunkBloomFilter.h
+ * @brief   Bloom filter over the values of an integer chunk.
+ *
+ * Lets the executor skip a fragment for an equality predicate on a value within the
+ * range of the chunk but not in it. The filter has a fixed size so it fits into the
+ * metadata page of the chunk; once half of its bits are set the false positive rate
+ * gets too high for it to be worth keeping and the encoder drops it.
+ */
+
+#ifndef CHUNK_BLOOM_FILTER_H
+#define CHUNK_BLOOM_FILTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+class ChunkBloomFilter {
+ public:
+  static constexpr size_t kNumWords{64};
+  static constexpr size_t kNumBits{kNumWords * 64};
+
+  ChunkBloomFilter() : num_set_bits_(0) { words_.fill(0); }
+
+  explicit ChunkBloomFilter(const std::array<uint64_t, kNumWords>& words)
+      : words_(words), num_set_bits_(0) {
+    for (const auto word : words_) {
+      num_set_bits_ += __builtin_popcountll(word);
+    }
+  }
+
+  void add(const int64_t val) {
+    const auto hash = mix(val);
+    for (size_t i = 0; i < kNumHashes; ++i) {
+      const auto bit = bitAt(hash, i);
+      auto& word = words_[bit / 64];
+      const uint64_t mask = uint64_t(1) << (bit % 64);
+      if (!(word & mask)) {
+        word |= mask;
+        ++num_set_bits_;
+      }
+    }
+  }
+
+  bool mayContain(const int64_t val) const {
+    const auto hash = mix(val);
+    for (size_t i = 0; i < kNumHashes; ++i) {
+      const auto bit = bitAt(hash, i);
+      if (!(words_[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Adds the values of the other filter to this one.
+  void merge(const ChunkBloomFilter& other) {
+    num_set_bits_ = 0;
+    for (size_t i = 0; i < kNumWords; ++i) {
+      words_[i] |= other.words_[i];
+      num_set_bits_ += __builtin_popcountll(words_[i]);
+    }
+  }
+
+  bool isSaturated() const { return num_set_bits_ * 2 > kNumBits; }
+
+  const std::array<uint64_t, kNumWords>& getWords() const { return words_; }
+
+ private:
+  static constexpr size_t kNumHashes{3};
+
+  // Finalizer of MurmurHash3, consecutive keys end up far apart.
+  static uint64_t mix(const int64_t val) {
+    auto h = static_cast<uint64_t>(val);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // Double hashing: the probes are derived from the two halves of the hash.
+  static size_t bitAt(const uint64_t hash, const size_t i) {
+    const uint32_t h1 = hash;
+    const uint32_t h2 = (hash >> 32) | 1;
+    return (h1 + i * h2) % kNumBits;
+  }
+
+  std::array<uint64_t, kNumWords> words_;
+  size_t num_set_bits_;
+};
+
+#endif  // CHUNK_BLOOM_FILTER_H
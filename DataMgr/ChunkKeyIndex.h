@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ChunkKeyIndex.h
+ * @brief   Distinct values of a chunk of the index column of a table.
+ *
+ * Unlike the bloom filter, it has no false positives and no size limit, so it lets the
+ * executor skip every fragment but the ones holding the value of an equality predicate
+ * on a unique key. It lives in memory only: the fragmenter adds the keys of every
+ * append and builds it again from the chunks when the table is loaded.
+ *
+ * Queries share the index of a fragment with the inserts into it. A query may see the
+ * keys of rows appended after it got the fragment, which only makes it skip less.
+ */
+
+#ifndef CHUNK_KEY_INDEX_H
+#define CHUNK_KEY_INDEX_H
+
+#include "../Shared/mapd_shared_mutex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+class ChunkKeyIndex {
+ public:
+  void add(const std::vector<int64_t>& keys) {
+    mapd_unique_lock<mapd_shared_mutex> write_lock(mutex_);
+    unsorted_keys_.insert(unsorted_keys_.end(), keys.begin(), keys.end());
+    if (unsorted_keys_.size() <= kMaxUnsortedKeys) {
+      return;
+    }
+    // Merged in batches, small appends don't copy the sorted keys every time.
+    std::sort(unsorted_keys_.begin(), unsorted_keys_.end());
+    std::vector<int64_t> merged;
+    merged.reserve(sorted_keys_.size() + unsorted_keys_.size());
+    std::merge(sorted_keys_.begin(),
+               sorted_keys_.end(),
+               unsorted_keys_.begin(),
+               unsorted_keys_.end(),
+               std::back_inserter(merged));
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    sorted_keys_.swap(merged);
+    unsorted_keys_.clear();
+  }
+
+  bool contains(const int64_t key) const {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(mutex_);
+    return std::binary_search(sorted_keys_.begin(), sorted_keys_.end(), key) ||
+           std::find(unsorted_keys_.begin(), unsorted_keys_.end(), key) !=
+               unsorted_keys_.end();
+  }
+
+ private:
+  static constexpr size_t kMaxUnsortedKeys{4096};
+
+  std::vector<int64_t> sorted_keys_;
+  std::vector<int64_t> unsorted_keys_;
+  mutable mapd_shared_mutex mutex_;
+};
+
+#endif  // CHUNK_KEY_INDEX_H
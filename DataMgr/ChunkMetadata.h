@@ -18,7 +18,10 @@
 #define CHUNKMETADATA_H
 
 #include <stddef.h>
+#include <memory>
 #include "../Shared/sqltypes.h"
+#include "ChunkBloomFilter.h"
+#include "ChunkKeyIndex.h"
 
 struct ChunkStats {
   Datum min;
@@ -31,6 +34,11 @@ struct ChunkMetadata {
   size_t numBytes;
   size_t numElements;
   ChunkStats chunkStats;
+  // Only set for integer chunks with few enough distinct values, empty otherwise.
+  std::shared_ptr<const ChunkBloomFilter> bloomFilter;
+  // Only set by the fragmenter for the index column of a table, empty otherwise. Not
+  // const, the fragmenter adds to it in place.
+  std::shared_ptr<ChunkKeyIndex> keyIndex;
 
   template <typename T>
   void fillChunkStats(const T min, const T max, const bool has_nulls) {
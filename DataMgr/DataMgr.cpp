@@ -24,6 +24,8 @@
 #include "BufferMgr/CpuBufferMgr/CpuBufferMgr.h"
 #include "BufferMgr/GpuCudaBufferMgr/GpuCudaBufferMgr.h"
 #include "FileMgr/GlobalFileMgr.h"
+#include "Shared/Metrics.h"
+#include "Shared/measure.h"
 
 #ifdef __APPLE__
 #include <sys/sysctl.h>
@@ -51,7 +53,10 @@ DataMgr::DataMgr(const string& dataDir,
                  const int startGpu,
                  const size_t reservedGpuMem,
                  const size_t numReaderThreads)
-    : dataDir_(dataDir), dbConvertDir_(dbConvertDir) {
+    : dataDir_(dataDir)
+    , dbConvertDir_(dbConvertDir)
+    , reusableBufferMaxBytes_(mapd_parameters.reusable_gpu_buffer_mem_bytes)
+    , nextReusableBufferId_(0) {
   if (useGpus) {
     try {
       cudaMgr_ = new CudaMgr_Namespace::CudaMgr(numGpus, startGpu);
@@ -78,6 +83,7 @@ DataMgr::DataMgr(const string& dataDir,
 }
 
 DataMgr::~DataMgr() {
+  scratchPools_.clear();
   int numLevels = bufferMgrs_.size();
   for (int level = numLevels - 1; level >= 0; --level) {
     for (size_t device = 0; device < bufferMgrs_[level].size(); device++) {
@@ -126,8 +132,16 @@ void DataMgr::populateMgrs(const MapDParameters& mapd_parameters,
     LOG(INFO) << "reserved GPU memory is " << (float)reservedGpuMem_ / (1024 * 1024)
               << "M includes render buffer allocation";
     bufferMgrs_.resize(3);
-    bufferMgrs_[1].push_back(new CpuBufferMgr(
-        0, cpuBufferSize, cudaMgr_, cpuSlabSize, 512, bufferMgrs_[0][0]));
+    bufferMgrs_[1].push_back(
+        new CpuBufferMgr(0,
+                         cpuBufferSize,
+                         cudaMgr_,
+                         cpuSlabSize,
+                         512,
+                         bufferMgrs_[0][0],
+                         mapd_parameters.pinned_cpu_buffer_mem_bytes,
+                         mapd_parameters.cpu_buffer_huge_pages,
+                         mapd_parameters.cpu_buffer_numa_interleave));
     levelSizes_.push_back(1);
     int numGpus = cudaMgr_->getDeviceCount();
     for (int gpuNum = 0; gpuNum < numGpus; ++gpuNum) {
@@ -135,6 +149,17 @@ void DataMgr::populateMgrs(const MapDParameters& mapd_parameters,
           mapd_parameters.gpu_buffer_mem_bytes != 0
               ? mapd_parameters.gpu_buffer_mem_bytes
               : (cudaMgr_->deviceProperties[gpuNum].globalMem) - (reservedGpuMem_);
+      size_t gpuScratchMemSize = mapd_parameters.gpu_scratch_mem_bytes;
+      if (mapd_parameters.gpu_buffer_mem_bytes == 0) {
+        gpuScratchMemSize = std::min(gpuScratchMemSize, gpuMaxMemSize / 8);
+        gpuMaxMemSize -= gpuScratchMemSize;
+      }
+      if (gpuScratchMemSize > 0) {
+        scratchPools_.emplace_back(
+            new GpuScratchPool(cudaMgr_, gpuNum, gpuScratchMemSize));
+      } else {
+        scratchPools_.emplace_back(nullptr);
+      }
       size_t gpuSlabSize = std::min(static_cast<size_t>(1L << 31), gpuMaxMemSize);
       gpuSlabSize -= gpuSlabSize % 512 == 0 ? 0 : 512 - (gpuSlabSize % 512);
       LOG(INFO) << "gpuSlabSize is " << (float)gpuSlabSize / (1024 * 1024) << "M";
@@ -142,9 +167,28 @@ void DataMgr::populateMgrs(const MapDParameters& mapd_parameters,
           gpuNum, gpuMaxMemSize, cudaMgr_, gpuSlabSize, 512, bufferMgrs_[1][0]));
     }
     levelSizes_.push_back(numGpus);
+    if (g_enable_peer_chunk_copies) {
+      for (int gpuNum = 0; gpuNum < numGpus; ++gpuNum) {
+        std::vector<BufferMgr*> peerMgrs;
+        for (int peerNum = 0; peerNum < numGpus; ++peerNum) {
+          if (cudaMgr_->canAccessPeer(gpuNum, peerNum)) {
+            peerMgrs.push_back(dynamic_cast<BufferMgr*>(bufferMgrs_[2][peerNum]));
+          }
+        }
+        dynamic_cast<BufferMgr*>(bufferMgrs_[2][gpuNum])->setPeerMgrs(peerMgrs);
+      }
+    }
   } else {
-    bufferMgrs_[1].push_back(new CpuBufferMgr(
-        0, cpuBufferSize, cudaMgr_, cpuSlabSize, 512, bufferMgrs_[0][0]));
+    bufferMgrs_[1].push_back(
+        new CpuBufferMgr(0,
+                         cpuBufferSize,
+                         cudaMgr_,
+                         cpuSlabSize,
+                         512,
+                         bufferMgrs_[0][0],
+                         0,
+                         mapd_parameters.cpu_buffer_huge_pages,
+                         mapd_parameters.cpu_buffer_numa_interleave));
     levelSizes_.push_back(1);
   }
 }
@@ -198,6 +242,10 @@ std::vector<MemoryInfo> DataMgr::getMemoryInfo(const MemoryLevel memLevel) {
     mi.maxNumPages = cpuBuffer->getMaxSize() / mi.pageSize;
     mi.isAllocationCapped = cpuBuffer->isAllocationCapped();
     mi.numPageAllocated = cpuBuffer->getAllocated() / mi.pageSize;
+    mi.numHits = cpuBuffer->getNumHits();
+    mi.numMisses = cpuBuffer->getNumMisses();
+    mi.numEvictions = cpuBuffer->getNumEvictions();
+    mi.largestFreePages = 0;
 
     const std::vector<BufferList> slab_segments = cpuBuffer->getSlabSegments();
     size_t numSlabs = slab_segments.size();
@@ -210,6 +258,9 @@ std::vector<MemoryInfo> DataMgr::getMemoryInfo(const MemoryLevel memLevel) {
         md.numPages = segIt.numPages;
         md.touch = segIt.lastTouched;
         md.isFree = segIt.memStatus;
+        if (segIt.memStatus == FREE) {
+          mi.largestFreePages = std::max(mi.largestFreePages, segIt.numPages);
+        }
         md.chunk_key.insert(
             md.chunk_key.end(), segIt.chunkKey.begin(), segIt.chunkKey.end());
         mi.nodeMemoryData.push_back(md);
@@ -227,6 +278,10 @@ std::vector<MemoryInfo> DataMgr::getMemoryInfo(const MemoryLevel memLevel) {
       mi.maxNumPages = gpuBuffer->getMaxSize() / mi.pageSize;
       mi.isAllocationCapped = gpuBuffer->isAllocationCapped();
       mi.numPageAllocated = gpuBuffer->getAllocated() / mi.pageSize;
+      mi.numHits = gpuBuffer->getNumHits();
+      mi.numMisses = gpuBuffer->getNumMisses();
+      mi.numEvictions = gpuBuffer->getNumEvictions();
+      mi.largestFreePages = 0;
       const std::vector<BufferList> slab_segments = gpuBuffer->getSlabSegments();
       size_t numSlabs = slab_segments.size();
 
@@ -240,6 +295,9 @@ std::vector<MemoryInfo> DataMgr::getMemoryInfo(const MemoryLevel memLevel) {
           md.chunk_key.insert(
               md.chunk_key.end(), segIt.chunkKey.begin(), segIt.chunkKey.end());
           md.isFree = segIt.memStatus;
+          if (segIt.memStatus == FREE) {
+            mi.largestFreePages = std::max(mi.largestFreePages, segIt.numPages);
+          }
           mi.nodeMemoryData.push_back(md);
         }
       }
@@ -311,24 +369,127 @@ std::string DataMgr::dumpLevel(const MemoryLevel memLevel) {
 }
 
 void DataMgr::clearMemory(const MemoryLevel memLevel) {
+  freeReusableBuffers(memLevel);
   // if gpu we need to iterate through all the buffermanagers for each card
   if (memLevel == MemoryLevel::GPU_LEVEL) {
     int numGpus = cudaMgr_->getDeviceCount();
     for (int gpuNum = 0; gpuNum < numGpus; ++gpuNum) {
       LOG(INFO) << "clear slabs on gpu " << gpuNum;
       bufferMgrs_[memLevel][gpuNum]->clearSlabs();
+      if (scratchPools_[gpuNum]) {
+        scratchPools_[gpuNum]->release();
+      }
     }
   } else {
     bufferMgrs_[memLevel][0]->clearSlabs();
   }
 }
 
+size_t DataMgr::compactMemory(const MemoryLevel memLevel) {
+  CHECK_NE(memLevel, MemoryLevel::DISK_LEVEL);
+  if (memLevel == MemoryLevel::GPU_LEVEL && !hasGpus_) {
+    return 0;
+  }
+  size_t movedBytes = 0;
+  for (auto buffer_mgr : bufferMgrs_[memLevel]) {
+    auto pool = dynamic_cast<Buffer_Namespace::BufferMgr*>(buffer_mgr);
+    CHECK(pool);
+    movedBytes += pool->compact();
+  }
+  return movedBytes;
+}
+
+void DataMgr::setTableEvictionPriority(const int db_id,
+                                       const int tb_id,
+                                       const int priority) {
+  for (const auto memLevel : {MemoryLevel::CPU_LEVEL, MemoryLevel::GPU_LEVEL}) {
+    if (memLevel == MemoryLevel::GPU_LEVEL && !hasGpus_) {
+      continue;
+    }
+    for (auto buffer_mgr : bufferMgrs_[memLevel]) {
+      auto pool = dynamic_cast<Buffer_Namespace::BufferMgr*>(buffer_mgr);
+      CHECK(pool);
+      pool->setTablePriority(db_id, tb_id, priority);
+    }
+  }
+}
+
+std::vector<HotChunk> DataMgr::getHotChunks() {
+  std::vector<HotChunk> hotChunks;
+  for (const auto memLevel : {MemoryLevel::CPU_LEVEL, MemoryLevel::GPU_LEVEL}) {
+    if (memLevel == MemoryLevel::GPU_LEVEL && !hasGpus_) {
+      continue;
+    }
+    for (int deviceId = 0; deviceId < levelSizes_[memLevel]; ++deviceId) {
+      auto pool =
+          dynamic_cast<Buffer_Namespace::BufferMgr*>(bufferMgrs_[memLevel][deviceId]);
+      CHECK(pool);
+      for (const auto& chunk : pool->getResidentChunks()) {
+        hotChunks.push_back({chunk.first, memLevel, deviceId, chunk.second});
+      }
+    }
+  }
+  std::stable_sort(hotChunks.begin(),
+                   hotChunks.end(),
+                   [](const HotChunk& lhs, const HotChunk& rhs) {
+                     return lhs.touchCount > rhs.touchCount;
+                   });
+  return hotChunks;
+}
+
+size_t DataMgr::prefetchChunk(const ChunkKey& key,
+                              const MemoryLevel memLevel,
+                              const int deviceId) {
+  CHECK_NE(memLevel, MemoryLevel::DISK_LEVEL);
+  if ((memLevel == MemoryLevel::GPU_LEVEL && !hasGpus_) || deviceId < 0 ||
+      deviceId >= levelSizes_[memLevel]) {
+    return 0;
+  }
+  // Doesn't create the file manager of a table which isn't loaded or was dropped.
+  auto fm = dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->findFileMgr(key[0], key[1]);
+  if (!fm || !fm->isBufferOnDevice(key) ||
+      bufferMgrs_[memLevel][deviceId]->isBufferOnDevice(key)) {
+    return 0;
+  }
+  // Would evict the chunks prefetched before, which are touched more often.
+  if (getFreeMemory(memLevel, deviceId) == 0) {
+    return 0;
+  }
+  auto buffer = getChunkBuffer(key, memLevel, deviceId);
+  const auto numBytes = buffer->size();
+  buffer->unPin();
+  return numBytes;
+}
+
+size_t DataMgr::offloadColdFiles() {
+  return dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->offloadColdFiles();
+}
+
+void DataMgr::registerForeignStorage(
+    const int db_id,
+    const int tb_id,
+    std::shared_ptr<ForeignStorageInterface> foreignStorage) {
+  dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])
+      ->registerForeignStorage(db_id, tb_id, foreignStorage);
+}
+
+void DataMgr::unregisterForeignStorage(const int db_id, const int tb_id) {
+  dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->unregisterForeignStorage(db_id, tb_id);
+}
+
 bool DataMgr::isBufferOnDevice(const ChunkKey& key,
                                const MemoryLevel memLevel,
                                const int deviceId) {
   return bufferMgrs_[memLevel][deviceId]->isBufferOnDevice(key);
 }
 
+size_t DataMgr::getFreeMemory(const MemoryLevel memLevel, const int deviceId) {
+  auto buffer_mgr = bufferMgrs_[memLevel][deviceId];
+  const auto max_size = buffer_mgr->getMaxSize();
+  const auto in_use_size = buffer_mgr->getInUseSize();
+  return max_size > in_use_size ? max_size - in_use_size : 0;
+}
+
 void DataMgr::getChunkMetadataVec(
     std::vector<std::pair<ChunkKey, ChunkMetadata>>& chunkMetadataVec) {
   // Can we always assume this will just be at the disklevel bc we just
@@ -360,6 +521,19 @@ AbstractBuffer* DataMgr::getChunkBuffer(const ChunkKey& key,
   return bufferMgrs_[level][deviceId]->getBuffer(key, numBytes);
 }
 
+AbstractBuffer* DataMgr::getMappedChunkBuffer(const ChunkKey& key,
+                                              const size_t numBytes) {
+  if (!g_enable_mapped_chunks) {
+    return nullptr;
+  }
+  // The copy in the CPU pool may be newer than the data file.
+  if (bufferMgrs_[MemoryLevel::CPU_LEVEL][0]->isBufferOnDevice(key)) {
+    return nullptr;
+  }
+  auto fm = dynamic_cast<GlobalFileMgr*>(bufferMgrs_[0][0])->findFileMgr(key[0], key[1]);
+  return fm ? fm->getMappedBuffer(key, numBytes) : nullptr;
+}
+
 void DataMgr::deleteChunksWithPrefix(const ChunkKey& keyPrefix) {
   int numLevels = bufferMgrs_.size();
   for (int level = numLevels - 1; level >= 0; --level) {
@@ -388,16 +562,91 @@ AbstractBuffer* DataMgr::alloc(const MemoryLevel memoryLevel,
   return bufferMgrs_[level][deviceId]->alloc(numBytes);
 }
 
+AbstractBuffer* DataMgr::allocReusable(const MemoryLevel memoryLevel,
+                                       const int deviceId,
+                                       const size_t numBytes) {
+  int level = static_cast<int>(memoryLevel);
+  assert(deviceId < levelSizes_[level]);
+  std::lock_guard<std::mutex> lock(reusableBuffersMutex_);
+  AbstractBuffer* buffer{nullptr};
+  auto it = idleReusableBuffers_.find(std::make_tuple(level, deviceId, numBytes));
+  if (it != idleReusableBuffers_.end()) {
+    buffer = it->second.back();
+    it->second.pop_back();
+    if (it->second.empty()) {
+      idleReusableBuffers_.erase(it);
+    }
+    idleReusableBytes_[std::make_pair(level, deviceId)] -= numBytes;
+  } else {
+    // Out of the {-1} prefix, which freeAllBuffers deletes.
+    ChunkKey key{-2, nextReusableBufferId_++};
+    buffer = bufferMgrs_[level][deviceId]->createBuffer(key, 0, numBytes);
+  }
+  reusableBuffersInUse_.emplace_back(buffer, numBytes);
+  return buffer;
+}
+
 void DataMgr::free(AbstractBuffer* buffer) {
   int level = static_cast<int>(buffer->getType());
   bufferMgrs_[level][buffer->getDeviceId()]->free(buffer);
 }
 
+int8_t* DataMgr::allocScratch(const int deviceId, const size_t numBytes) {
+  if (static_cast<size_t>(deviceId) >= scratchPools_.size() || !scratchPools_[deviceId]) {
+    return nullptr;
+  }
+  return scratchPools_[deviceId]->allocate(numBytes);
+}
+
+void DataMgr::freeScratch(const int deviceId, int8_t* ptr) {
+  CHECK_LT(static_cast<size_t>(deviceId), scratchPools_.size());
+  CHECK(scratchPools_[deviceId]);
+  scratchPools_[deviceId]->free(ptr);
+}
+
 void DataMgr::freeAllBuffers() {
+  for (auto& scratchPool : scratchPools_) {
+    if (scratchPool) {
+      scratchPool->freeAll();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(reusableBuffersMutex_);
+    for (const auto& bufferAndSize : reusableBuffersInUse_) {
+      auto buffer = bufferAndSize.first;
+      const auto numBytes = bufferAndSize.second;
+      const int level = static_cast<int>(buffer->getType());
+      auto& idleBytes = idleReusableBytes_[std::make_pair(level, buffer->getDeviceId())];
+      if (idleBytes + numBytes <= reusableBufferMaxBytes_) {
+        idleReusableBuffers_[std::make_tuple(level, buffer->getDeviceId(), numBytes)]
+            .push_back(buffer);
+        idleBytes += numBytes;
+      } else {
+        free(buffer);
+      }
+    }
+    reusableBuffersInUse_.clear();
+  }
   ChunkKey keyPrefix = {-1};
   deleteChunksWithPrefix(keyPrefix);
 }
 
+void DataMgr::freeReusableBuffers(const MemoryLevel memLevel) {
+  const int level = static_cast<int>(memLevel);
+  std::lock_guard<std::mutex> lock(reusableBuffersMutex_);
+  for (auto it = idleReusableBuffers_.begin(); it != idleReusableBuffers_.end();) {
+    if (std::get<0>(it->first) != level) {
+      ++it;
+      continue;
+    }
+    for (auto buffer : it->second) {
+      free(buffer);
+    }
+    idleReusableBytes_[std::make_pair(level, std::get<1>(it->first))] = 0;
+    it = idleReusableBuffers_.erase(it);
+  }
+}
+
 void DataMgr::copy(AbstractBuffer* destBuffer, AbstractBuffer* srcBuffer) {
   destBuffer->write(srcBuffer->getMemoryPtr(),
                     srcBuffer->size(),
@@ -412,22 +661,36 @@ void DataMgr::copy(AbstractBuffer* destBuffer, AbstractBuffer* srcBuffer) {
 // size_t numBytes, const size_t destOffset, const size_t srcOffset) {
 //} /
 
+namespace {
+
+metrics::Histogram& checkpoint_duration_ms() {
+  static auto& histogram = metrics::Registry::get().histogram(
+      "mapd_checkpoint_duration_ms", "Time to checkpoint a table or all the tables");
+  return histogram;
+}
+
+}  // namespace
+
 void DataMgr::checkpoint(const int db_id, const int tb_id) {
+  auto clock_begin = timer_start();
   for (auto levelIt = bufferMgrs_.rbegin(); levelIt != bufferMgrs_.rend(); ++levelIt) {
     // use reverse iterator so we start at GPU level, then CPU then DISK
     for (auto deviceIt = levelIt->begin(); deviceIt != levelIt->end(); ++deviceIt) {
       (*deviceIt)->checkpoint(db_id, tb_id);
     }
   }
+  checkpoint_duration_ms().observe(timer_stop(clock_begin));
 }
 
 void DataMgr::checkpoint() {
+  auto clock_begin = timer_start();
   for (auto levelIt = bufferMgrs_.rbegin(); levelIt != bufferMgrs_.rend(); ++levelIt) {
     // use reverse iterator so we start at GPU level, then CPU then DISK
     for (auto deviceIt = levelIt->begin(); deviceIt != levelIt->end(); ++deviceIt) {
       (*deviceIt)->checkpoint();
     }
   }
+  checkpoint_duration_ms().observe(timer_stop(clock_begin));
 }
 
 void DataMgr::removeTableRelatedDS(const int db_id, const int tb_id) {
@@ -27,12 +27,17 @@
 #include "AbstractBufferMgr.h"
 #include "BufferMgr/Buffer.h"
 #include "BufferMgr/BufferMgr.h"
+#include "ForeignStorageInterface.h"
+#include "GpuScratchPool.h"
 #include "MemoryLevel.h"
 
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace File_Namespace {
@@ -59,9 +64,22 @@ struct MemoryInfo {
   size_t maxNumPages;
   size_t numPageAllocated;
   bool isAllocationCapped;
+  size_t numHits;
+  size_t numMisses;
+  size_t numEvictions;
+  size_t largestFreePages;  // of a free segment, much less than the free pages if
+                            // the slabs are fragmented
   std::vector<MemoryData> nodeMemoryData;
 };
 
+// A chunk resident in the CPU or GPU pool of a device.
+struct HotChunk {
+  ChunkKey key;
+  MemoryLevel memLevel;
+  int deviceId;
+  unsigned int touchCount;
+};
+
 class DataMgr {
   friend class GlobalFileMgr;
 
@@ -84,12 +102,24 @@ class DataMgr {
                                  const MemoryLevel memoryLevel,
                                  const int deviceId = 0,
                                  const size_t numBytes = 0);
+  // Returns a pinned, read-only view of a chunk mapped from its data file in place of
+  // a copy in the CPU pool, nullptr if the chunk can't be served that way.
+  AbstractBuffer* getMappedChunkBuffer(const ChunkKey& key, const size_t numBytes);
   void deleteChunksWithPrefix(const ChunkKey& keyPrefix);
   void deleteChunksWithPrefix(const ChunkKey& keyPrefix, const MemoryLevel memLevel);
   AbstractBuffer* alloc(const MemoryLevel memoryLevel,
                         const int deviceId,
                         const size_t numBytes);
+  // Like alloc, except that freeAllBuffers keeps the buffer, within a byte budget per
+  // device, for the next allocation of the same size on the device.
+  AbstractBuffer* allocReusable(const MemoryLevel memoryLevel,
+                                const int deviceId,
+                                const size_t numBytes);
   void free(AbstractBuffer* buffer);
+  // Scratch memory of a GPU out of the buffer pool, nullptr if the scratch pool of the
+  // device is exhausted. freeAllBuffers frees what the query didn't.
+  int8_t* allocScratch(const int deviceId, const size_t numBytes);
+  void freeScratch(const int deviceId, int8_t* ptr);
   void freeAllBuffers();
   // copies one buffer to another
   void copy(AbstractBuffer* destBuffer, AbstractBuffer* srcBuffer);
@@ -97,8 +127,32 @@ class DataMgr {
                         const MemoryLevel memLevel,
                         const int deviceId);
   std::vector<MemoryInfo> getMemoryInfo(const MemoryLevel memLevel);
+  // Bytes of the buffer pool of the device not taken by any chunk or allocation.
+  size_t getFreeMemory(const MemoryLevel memLevel, const int deviceId);
   std::string dumpLevel(const MemoryLevel memLevel);
   void clearMemory(const MemoryLevel memLevel);
+  // Moves the unpinned chunks of the pools of the level together, see
+  // BufferMgr::compact. Returns the bytes moved.
+  size_t compactMemory(const MemoryLevel memLevel);
+  // Sets the eviction priority of the chunks of a table in the CPU and GPU pools.
+  void setTableEvictionPriority(const int db_id, const int tb_id, const int priority);
+  // The chunks in the CPU and GPU pools, the most touched first.
+  std::vector<HotChunk> getHotChunks();
+  // Loads a chunk of a loaded table from disk into the pool of the device, unless it's
+  // resident already or the pool is full. Returns the bytes read. The caller keeps the
+  // table from being dropped meanwhile.
+  size_t prefetchChunk(const ChunkKey& key,
+                       const MemoryLevel memLevel,
+                       const int deviceId);
+  // Moves the data files untouched for g_cold_file_age_seconds to the cold storage, as
+  // done periodically when g_cold_storage_url is set. Returns the bytes moved.
+  size_t offloadColdFiles();
+  // The chunks of the table missing from the CPU pool are read from the storage, see
+  // GlobalFileMgr::registerForeignStorage.
+  void registerForeignStorage(const int db_id,
+                              const int tb_id,
+                              std::shared_ptr<ForeignStorageInterface> foreignStorage);
+  void unregisterForeignStorage(const int db_id, const int tb_id);
 
   // const std::map<ChunkKey, File_Namespace::FileBuffer *> & getChunkMap();
   const std::map<ChunkKey, File_Namespace::FileBuffer*>& getChunkMap();
@@ -133,6 +187,19 @@ class DataMgr {
   std::string dbConvertDir_;
   std::map<ChunkKey, std::shared_ptr<mapd_shared_mutex>> chunkMutexMap_;
   mapd_shared_mutex chunkMutexMapMutex_;
+
+  // Frees the reusable buffers of the level, the idle ones as well.
+  void freeReusableBuffers(const MemoryLevel memLevel);
+  // Memory level, device and size of a reusable buffer.
+  using ReusableBufferKey = std::tuple<int, int, size_t>;
+  size_t reusableBufferMaxBytes_;
+  int nextReusableBufferId_;
+  std::vector<std::pair<AbstractBuffer*, size_t>> reusableBuffersInUse_;
+  std::map<ReusableBufferKey, std::vector<AbstractBuffer*>> idleReusableBuffers_;
+  std::map<std::pair<int, int>, size_t> idleReusableBytes_;
+  std::mutex reusableBuffersMutex_;
+
+  std::vector<std::unique_ptr<GpuScratchPool>> scratchPools_;
 };
 }  // namespace Data_Namespace
 
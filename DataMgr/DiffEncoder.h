@@ -0,0 +1,239 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    DiffEncoder.h
+ * @brief   Frame of reference encoding of integer and time chunks.
+ *
+ * The chunk starts with a 64-bit baseline, followed by the differences of the values
+ * to it on the width of V. The smallest V is the null sentinel, so the frame of the
+ * chunk covers the values from the baseline plus the smallest V plus one to the
+ * baseline plus the largest V. The frame is placed by the first append to the chunk,
+ * starting at the smallest value appended, and doesn't move afterwards: the
+ * fragmenter starts a new fragment for the values out of the frame.
+ */
+
+#ifndef DIFF_ENCODER_H
+#define DIFF_ENCODER_H
+
+#include <glog/logging.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include "AbstractBuffer.h"
+#include "Encoder.h"
+
+template <typename T, typename V>
+class DiffEncoder : public Encoder {
+ public:
+  DiffEncoder(Data_Namespace::AbstractBuffer* buffer)
+      : Encoder(buffer)
+      , dataMin(std::numeric_limits<T>::max())
+      , dataMax(std::numeric_limits<T>::min())
+      , has_nulls(false)
+      , baseline(0) {
+    initBloomFilter();
+  }
+
+  ChunkMetadata appendData(int8_t*& srcData,
+                           const size_t numAppendElems,
+                           const bool replicating = false) {
+    T* unencodedData = reinterpret_cast<T*>(srcData);
+    const bool placesFrame = buffer_->size() == 0;
+    if (placesFrame) {
+      placeFrame(unencodedData, replicating ? 1 : numAppendElems);
+    }
+    auto encodedData = std::unique_ptr<V[]>(new V[numAppendElems]);
+    for (size_t i = 0; i < numAppendElems; ++i) {
+      size_t ri = replicating ? 0 : i;
+      const T data = unencodedData[ri];
+      if (data == std::numeric_limits<T>::min()) {
+        encodedData.get()[i] = std::numeric_limits<V>::min();
+        has_nulls = true;
+        continue;
+      }
+      if (!isInFrame(data)) {
+        throw std::runtime_error("DIFF encoding failed, " + std::to_string(data) +
+                                 " is out of the frame of the chunk");
+      }
+      encodedData.get()[i] = static_cast<V>(static_cast<int64_t>(
+          static_cast<uint64_t>(data) - static_cast<uint64_t>(baseline)));
+      dataMin = std::min(dataMin, data);
+      dataMax = std::max(dataMax, data);
+      addToBloomFilter(data);
+    }
+    dropSaturatedBloomFilter();
+    num_elems_ += numAppendElems;
+
+    if (placesFrame) {
+      buffer_->append(reinterpret_cast<int8_t*>(&baseline), sizeof(baseline));
+    }
+    buffer_->append((int8_t*)(encodedData.get()), numAppendElems * sizeof(V));
+    ChunkMetadata chunkMetadata;
+    getMetadata(chunkMetadata);
+    if (!replicating)
+      srcData += numAppendElems * sizeof(T);
+    return chunkMetadata;
+  }
+
+  size_t getNumElemsForInsertData(const int8_t* srcData, const size_t numElems) const {
+    const T* unencodedData = reinterpret_cast<const T*>(srcData);
+    const bool hasFrame = buffer_->size() > 0;
+    bool hasValues = false;
+    int64_t lo = 0;
+    int64_t hi = 0;
+    for (size_t i = 0; i < numElems; ++i) {
+      const T data = unencodedData[i];
+      if (data == std::numeric_limits<T>::min()) {
+        continue;
+      }
+      if (hasFrame) {
+        if (!isInFrame(data)) {
+          return i;
+        }
+        continue;
+      }
+      const int64_t newLo = hasValues ? std::min<int64_t>(lo, data) : data;
+      const int64_t newHi = hasValues ? std::max<int64_t>(hi, data) : data;
+      if (static_cast<uint64_t>(newHi) - static_cast<uint64_t>(newLo) > frameRange()) {
+        return i;
+      }
+      lo = newLo;
+      hi = newHi;
+      hasValues = true;
+    }
+    return numElems;
+  }
+
+  void getMetadata(ChunkMetadata& chunkMetadata) {
+    Encoder::getMetadata(chunkMetadata);  // call on parent class
+    chunkMetadata.fillChunkStats(dataMin, dataMax, has_nulls);
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  ChunkMetadata getMetadata(const SQLTypeInfo& ti) {
+    ChunkMetadata chunk_metadata{ti, 0, 0, ChunkStats{}};
+    chunk_metadata.fillChunkStats(dataMin, dataMax, has_nulls);
+    return chunk_metadata;
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void updateStats(const int64_t val, const bool is_null) {
+    // Only the range of the new values is known here, not the values themselves.
+    bloom_filter_.reset();
+    if (is_null) {
+      has_nulls = true;
+    } else {
+      const auto data = static_cast<T>(val);
+      dataMin = std::min(dataMin, data);
+      dataMax = std::max(dataMax, data);
+    }
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void updateStats(const double val, const bool is_null) {
+    bloom_filter_.reset();
+    if (is_null) {
+      has_nulls = true;
+    } else {
+      const auto data = static_cast<T>(val);
+      dataMin = std::min(dataMin, data);
+      dataMax = std::max(dataMax, data);
+    }
+  }
+
+  // Only called from the executor for synthesized meta-information.
+  void reduceStats(const Encoder& that) {
+    const auto& that_typed = static_cast<const DiffEncoder<T, V>&>(that);
+    bloom_filter_.reset();
+    if (that_typed.has_nulls) {
+      has_nulls = true;
+    }
+    dataMin = std::min(dataMin, that_typed.dataMin);
+    dataMax = std::max(dataMax, that_typed.dataMax);
+  }
+
+  void copyMetadata(const Encoder* copyFromEncoder) {
+    num_elems_ = copyFromEncoder->getNumElems();
+    auto castedEncoder = reinterpret_cast<const DiffEncoder<T, V>*>(copyFromEncoder);
+    dataMin = castedEncoder->dataMin;
+    dataMax = castedEncoder->dataMax;
+    has_nulls = castedEncoder->has_nulls;
+    baseline = castedEncoder->baseline;
+    copyBloomFilter(copyFromEncoder);
+  }
+
+  void writeMetadata(FILE* f) {
+    // assumes pointer is already in right place
+    fwrite((int8_t*)&num_elems_, sizeof(size_t), 1, f);
+    fwrite((int8_t*)&dataMin, sizeof(T), 1, f);
+    fwrite((int8_t*)&dataMax, sizeof(T), 1, f);
+    fwrite((int8_t*)&has_nulls, sizeof(bool), 1, f);
+    fwrite((int8_t*)&baseline, sizeof(int64_t), 1, f);
+  }
+
+  void readMetadata(FILE* f) {
+    // assumes pointer is already in right place
+    fread((int8_t*)&num_elems_, sizeof(size_t), 1, f);
+    fread((int8_t*)&dataMin, 1, sizeof(T), f);
+    fread((int8_t*)&dataMax, 1, sizeof(T), f);
+    fread((int8_t*)&has_nulls, 1, sizeof(bool), f);
+    fread((int8_t*)&baseline, 1, sizeof(int64_t), f);
+  }
+  T dataMin;
+  T dataMax;
+  bool has_nulls;
+  // Same as the header of the chunk.
+  int64_t baseline;
+
+ private:
+  // Largest difference between two values of the frame.
+  static uint64_t frameRange() {
+    return static_cast<uint64_t>(std::numeric_limits<V>::max()) -
+           static_cast<uint64_t>(std::numeric_limits<V>::min()) - 1;
+  }
+
+  int64_t frameMin() const {
+    return static_cast<int64_t>(static_cast<uint64_t>(baseline) +
+                                static_cast<uint64_t>(std::numeric_limits<V>::min()) +
+                                1);
+  }
+
+  bool isInFrame(const int64_t val) const {
+    const auto frame_min = frameMin();
+    return val >= frame_min &&
+           static_cast<uint64_t>(val) - static_cast<uint64_t>(frame_min) <= frameRange();
+  }
+
+  // Starts the frame at the smallest value, at zero if there are only nulls.
+  void placeFrame(const T* unencodedData, const size_t numElems) {
+    bool hasValues = false;
+    int64_t lo = 0;
+    for (size_t i = 0; i < numElems; ++i) {
+      const T data = unencodedData[i];
+      if (data != std::numeric_limits<T>::min()) {
+        lo = hasValues ? std::min<int64_t>(lo, data) : data;
+        hasValues = true;
+      }
+    }
+    baseline = static_cast<int64_t>(static_cast<uint64_t>(lo) -
+                                    static_cast<uint64_t>(std::numeric_limits<V>::min()) -
+                                    1);
+  }
+
+};  // DiffEncoder
+
+#endif  // DIFF_ENCODER_H
@@ -17,11 +17,14 @@
 #include "Encoder.h"
 #include <glog/logging.h>
 #include "ArrayNoneEncoder.h"
+#include "DiffEncoder.h"
 #include "FixedLengthArrayNoneEncoder.h"
 #include "FixedLengthEncoder.h"
 #include "NoneEncoder.h"
 #include "StringNoneEncoder.h"
 
+bool g_enable_chunk_bloom_filters{true};
+
 Encoder* Encoder::Create(Data_Namespace::AbstractBuffer* buffer,
                          const SQLTypeInfo sqlType) {
   switch (sqlType.get_compression()) {
@@ -146,6 +149,57 @@ Encoder* Encoder::Create(Data_Namespace::AbstractBuffer* buffer,
       }  // switch (sqlType)
       break;
     }  // Case: kENCODING_FIXED
+    case kENCODING_DIFF: {
+      switch (sqlType.get_type()) {
+        case kSMALLINT: {
+          switch (sqlType.get_comp_param()) {
+            case 8:
+              return new DiffEncoder<int16_t, int8_t>(buffer);
+            default:
+              return 0;
+          }
+        }
+        case kINT: {
+          switch (sqlType.get_comp_param()) {
+            case 8:
+              return new DiffEncoder<int32_t, int8_t>(buffer);
+            case 16:
+              return new DiffEncoder<int32_t, int16_t>(buffer);
+            default:
+              return 0;
+          }
+        }
+        case kBIGINT: {
+          switch (sqlType.get_comp_param()) {
+            case 8:
+              return new DiffEncoder<int64_t, int8_t>(buffer);
+            case 16:
+              return new DiffEncoder<int64_t, int16_t>(buffer);
+            case 32:
+              return new DiffEncoder<int64_t, int32_t>(buffer);
+            default:
+              return 0;
+          }
+        }
+        case kTIME:
+        case kTIMESTAMP:
+        case kDATE: {
+          switch (sqlType.get_comp_param()) {
+            case 8:
+              return new DiffEncoder<time_t, int8_t>(buffer);
+            case 16:
+              return new DiffEncoder<time_t, int16_t>(buffer);
+            case 32:
+              return new DiffEncoder<time_t, int32_t>(buffer);
+            default:
+              return 0;
+          }
+        }
+        default:
+          return 0;
+      }
+      break;
+    }  // Case: kENCODING_DIFF
     case kENCODING_DICT: {
       if (sqlType.get_type() == kARRAY) {
         CHECK(IS_STRING(sqlType.get_subtype()));
@@ -193,4 +247,9 @@ void Encoder::getMetadata(ChunkMetadata& chunkMetadata) {
   chunkMetadata.sqlType = buffer_->sqlType;
   chunkMetadata.numBytes = buffer_->size();
   chunkMetadata.numElements = num_elems_;
+  // Snapshot, appends to the chunk keep updating the filter of the encoder.
+  chunkMetadata.bloomFilter =
+      bloom_filter_ ? std::make_shared<const ChunkBloomFilter>(*bloom_filter_) : nullptr;
+  // Kept by the fragmenter, which sets it again after the appends it knows the keys of.
+  chunkMetadata.keyIndex.reset();
 }
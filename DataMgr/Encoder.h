@@ -23,6 +23,7 @@
 
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
@@ -33,6 +34,9 @@ class AbstractBuffer;
 // default max input buffer size to 1MB
 #define MAX_INPUT_BUF_SIZE 1048576
 
+// Keep a bloom filter of the values of new integer chunks.
+extern bool g_enable_chunk_bloom_filters;
+
 class Encoder {
  public:
   static Encoder* Create(Data_Namespace::AbstractBuffer* buffer,
@@ -52,11 +56,45 @@ class Encoder {
   virtual void copyMetadata(const Encoder* copyFromEncoder) = 0;
   virtual void writeMetadata(FILE* f /*, const size_t offset*/) = 0;
   virtual void readMetadata(FILE* f /*, const size_t offset*/) = 0;
+  // Encodings bounding the range of the values of a chunk take the longest prefix of
+  // srcData within that range, the others all the elements.
+  virtual size_t getNumElemsForInsertData(const int8_t* srcData,
+                                          const size_t numElems) const {
+    return numElems;
+  }
 
   size_t getNumElems() const { return num_elems_; }
 
+  // The bloom filter is persisted by the buffer, next to the metadata of the encoder.
+  const ChunkBloomFilter* getBloomFilter() const { return bloom_filter_.get(); }
+  void setBloomFilter(std::unique_ptr<ChunkBloomFilter> bloom_filter) {
+    bloom_filter_ = std::move(bloom_filter);
+  }
+
  protected:
+  void initBloomFilter() {
+    if (g_enable_chunk_bloom_filters) {
+      bloom_filter_.reset(new ChunkBloomFilter());
+    }
+  }
+  void addToBloomFilter(const int64_t val) {
+    if (bloom_filter_) {
+      bloom_filter_->add(val);
+    }
+  }
+  void dropSaturatedBloomFilter() {
+    if (bloom_filter_ && bloom_filter_->isSaturated()) {
+      bloom_filter_.reset();
+    }
+  }
+  void copyBloomFilter(const Encoder* copyFromEncoder) {
+    const auto bloom_filter = copyFromEncoder->bloom_filter_.get();
+    bloom_filter_.reset(bloom_filter ? new ChunkBloomFilter(*bloom_filter) : nullptr);
+  }
+
   size_t num_elems_;
+  // Empty if the values can't be tracked: once dropped, it stays empty for the chunk.
+  std::unique_ptr<ChunkBloomFilter> bloom_filter_;
 
   Data_Namespace::AbstractBuffer* buffer_;
   // ChunkMetadata metadataTemplate_;
@@ -0,0 +1,439 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ColdStorage.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#ifdef HAVE_AWS_S3
+#include <aws/core/utils/memory/stl/AWSStreamFwd.h>
+#include <aws/s3/model/DeleteObjectRequest.h>
+#include <aws/s3/model/GetObjectRequest.h>
+#include <aws/s3/model/PutObjectRequest.h>
+#include <fstream>
+#include "../../Archive/S3Client.h"
+#endif
+
+std::string g_cold_storage_url;
+std::string g_cold_storage_endpoint;
+std::string g_cold_storage_cache_path;
+size_t g_cold_storage_cache_bytes{size_t(64) << 30};
+size_t g_cold_file_age_seconds{7 * 24 * 3600};
+
+namespace File_Namespace {
+
+namespace {
+
+std::runtime_error errno_error(const std::string& what) {
+  return std::runtime_error(what + ": " + strerror(errno));
+}
+
+void pread_fully(const int fd,
+                 int8_t* buf,
+                 size_t size,
+                 size_t offset,
+                 const std::string& path) {
+  while (size > 0) {
+    const ssize_t bytesRead = pread(fd, buf, size, offset);
+    if (bytesRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesRead < 0) {
+      throw errno_error("Could not read " + path);
+    }
+    if (bytesRead == 0) {
+      throw std::runtime_error("Unexpected end of " + path);
+    }
+    buf += bytesRead;
+    size -= bytesRead;
+    offset += bytesRead;
+  }
+}
+
+void pwrite_fully(const int fd,
+                  const int8_t* buf,
+                  size_t size,
+                  size_t offset,
+                  const std::string& path) {
+  while (size > 0) {
+    const ssize_t bytesWritten = pwrite(fd, buf, size, offset);
+    if (bytesWritten < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesWritten < 0) {
+      throw errno_error("Could not write " + path);
+    }
+    buf += bytesWritten;
+    size -= bytesWritten;
+    offset += bytesWritten;
+  }
+}
+
+// Objects as files of a directory, on a volume cheaper than the data directory.
+class DirectoryObjectStore : public ObjectStore {
+ public:
+  DirectoryObjectStore(const std::string& path) : path_(path) {
+    boost::filesystem::create_directories(path_);
+  }
+
+  void put(const std::string& key, const std::string& filePath) override {
+    const auto objectPath = getObjectPath(key);
+    boost::filesystem::create_directories(
+        boost::filesystem::path(objectPath).parent_path());
+    // Written aside and renamed, a crash leaves no partial object behind.
+    const auto tmpPath = objectPath + ".tmp";
+    const int src = open(filePath.c_str(), O_RDONLY);
+    if (src < 0) {
+      throw errno_error("Could not open " + filePath);
+    }
+    const int dst = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (dst < 0) {
+      const auto error = errno_error("Could not create " + tmpPath);
+      ::close(src);
+      throw error;
+    }
+    try {
+      std::vector<int8_t> buf(1 << 20);
+      size_t offset = 0;
+      while (true) {
+        const ssize_t bytesRead = pread(src, buf.data(), buf.size(), offset);
+        if (bytesRead < 0 && errno == EINTR) {
+          continue;
+        }
+        if (bytesRead < 0) {
+          throw errno_error("Could not read " + filePath);
+        }
+        if (bytesRead == 0) {
+          break;
+        }
+        pwrite_fully(dst, buf.data(), bytesRead, offset, tmpPath);
+        offset += bytesRead;
+      }
+      if (fsync(dst) != 0) {
+        throw errno_error("Could not sync " + tmpPath);
+      }
+    } catch (...) {
+      ::close(src);
+      ::close(dst);
+      unlink(tmpPath.c_str());
+      throw;
+    }
+    ::close(src);
+    ::close(dst);
+    if (rename(tmpPath.c_str(), objectPath.c_str()) != 0) {
+      const auto error = errno_error("Could not rename " + tmpPath);
+      unlink(tmpPath.c_str());
+      throw error;
+    }
+  }
+
+  void get(const std::string& key,
+           const size_t offset,
+           const size_t size,
+           int8_t* buf) override {
+    const auto objectPath = getObjectPath(key);
+    const int fd = open(objectPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw errno_error("Could not open " + objectPath);
+    }
+    try {
+      pread_fully(fd, buf, size, offset, objectPath);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    ::close(fd);
+  }
+
+  void remove(const std::string& key) override {
+    boost::system::error_code ec;
+    boost::filesystem::remove(getObjectPath(key), ec);
+    if (ec) {
+      throw std::runtime_error("Could not remove " + getObjectPath(key) + ": " +
+                               ec.message());
+    }
+  }
+
+ private:
+  std::string getObjectPath(const std::string& key) const { return path_ + "/" + key; }
+
+  const std::string path_;
+};
+
+#ifdef HAVE_AWS_S3
+// Objects of a bucket of S3 or of an S3 compatible service, under a prefix. The requests
+// are signed with the credentials of the default provider chain.
+class S3ObjectStore : public ObjectStore {
+ public:
+  S3ObjectStore(const std::string& bucket,
+                const std::string& prefix,
+                const std::string& endpoint)
+      : bucket_(bucket), prefix_(prefix) {
+    const char* region = getenv("AWS_REGION");
+    client_ = create_s3_client(region ? region : "", "", "", endpoint, true);
+  }
+
+  void put(const std::string& key, const std::string& filePath) override {
+    Aws::S3::Model::PutObjectRequest request;
+    request.WithBucket(bucket_).WithKey(getObjectKey(key));
+    auto body = Aws::MakeShared<Aws::FStream>(
+        "ColdStorage", filePath.c_str(), std::ios_base::in | std::ios_base::binary);
+    if (!body->good()) {
+      throw std::runtime_error("Could not open " + filePath);
+    }
+    request.SetBody(body);
+    const auto outcome = client_->PutObject(request);
+    if (!outcome.IsSuccess()) {
+      throw std::runtime_error("Could not upload " + filePath + " to s3://" + bucket_ +
+                               "/" + getObjectKey(key) + ": " +
+                               outcome.GetError().GetMessage());
+    }
+  }
+
+  void get(const std::string& key,
+           const size_t offset,
+           const size_t size,
+           int8_t* buf) override {
+    Aws::S3::Model::GetObjectRequest request;
+    request.WithBucket(bucket_).WithKey(getObjectKey(key));
+    request.SetRange("bytes=" + std::to_string(offset) + "-" +
+                     std::to_string(offset + size - 1));
+    auto outcome = client_->GetObject(request);
+    if (!outcome.IsSuccess()) {
+      throw std::runtime_error("Could not download s3://" + bucket_ + "/" +
+                               getObjectKey(key) + ": " +
+                               outcome.GetError().GetMessage());
+    }
+    auto& body = outcome.GetResult().GetBody();
+    body.read(reinterpret_cast<char*>(buf), size);
+    if (static_cast<size_t>(body.gcount()) != size) {
+      throw std::runtime_error("Short download of s3://" + bucket_ + "/" +
+                               getObjectKey(key));
+    }
+  }
+
+  void remove(const std::string& key) override {
+    Aws::S3::Model::DeleteObjectRequest request;
+    request.WithBucket(bucket_).WithKey(getObjectKey(key));
+    const auto outcome = client_->DeleteObject(request);
+    if (!outcome.IsSuccess()) {
+      throw std::runtime_error("Could not remove s3://" + bucket_ + "/" +
+                               getObjectKey(key) + ": " +
+                               outcome.GetError().GetMessage());
+    }
+  }
+
+ private:
+  std::string getObjectKey(const std::string& key) const {
+    return prefix_.empty() ? key : prefix_ + "/" + key;
+  }
+
+  const std::string bucket_;
+  const std::string prefix_;
+  AwsApiScope awsApiScope_;
+  std::unique_ptr<Aws::S3::S3Client> client_;
+};
+#endif  // HAVE_AWS_S3
+
+}  // namespace
+
+std::unique_ptr<ObjectStore> create_object_store(const std::string& url,
+                                                 const std::string& endpoint) {
+  const std::string s3Scheme{"s3://"};
+  if (url.compare(0, s3Scheme.size(), s3Scheme) == 0) {
+#ifdef HAVE_AWS_S3
+    const auto path = url.substr(s3Scheme.size());
+    const auto slashPos = path.find('/');
+    const auto bucket = path.substr(0, slashPos);
+    auto prefix = slashPos == std::string::npos ? "" : path.substr(slashPos + 1);
+    while (!prefix.empty() && prefix.back() == '/') {
+      prefix.pop_back();
+    }
+    if (bucket.empty()) {
+      throw std::runtime_error("No bucket in " + url);
+    }
+    return std::unique_ptr<ObjectStore>(new S3ObjectStore(bucket, prefix, endpoint));
+#else
+    throw std::runtime_error("AWS S3 support not available");
+#endif  // HAVE_AWS_S3
+  }
+  return std::unique_ptr<ObjectStore>(new DirectoryObjectStore(url));
+}
+
+ColdStorage::Block::~Block() {
+  if (fetched.valid()) {
+    fetched.wait();
+  }
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+ColdStorage::ColdStorage(std::unique_ptr<ObjectStore> store,
+                         const std::string& cachePath,
+                         const size_t cacheBytes,
+                         const size_t blockSize,
+                         const size_t prefetchBlocks)
+    : store_(std::move(store))
+    , cachePath_(cachePath)
+    , cacheBytes_(cacheBytes)
+    , blockSize_(blockSize)
+    , prefetchBlocks_(prefetchBlocks)
+    , cachedBytes_(0) {
+  CHECK_GT(blockSize_, size_t(0));
+  // The blocks are unlinked files, nothing is left of the cache of a previous run.
+  boost::filesystem::create_directories(cachePath_);
+}
+
+ColdStorage::~ColdStorage() {
+  // Waits for the fetches in flight, which use store_.
+  std::lock_guard<std::mutex> lock(mutex_);
+  blocks_.clear();
+  lru_.clear();
+}
+
+void ColdStorage::upload(const std::string& key, const std::string& filePath) {
+  store_->put(key, filePath);
+}
+
+void ColdStorage::read(const std::string& key,
+                       const size_t objectSize,
+                       size_t offset,
+                       size_t size,
+                       int8_t* buf) {
+  CHECK_LE(offset + size, objectSize);
+  while (size > 0) {
+    const size_t blockNum = offset / blockSize_;
+    const size_t blockOffset = offset % blockSize_;
+    const size_t bytes = std::min(size, blockSize_ - blockOffset);
+    auto block = getBlock(key, objectSize, blockNum);
+    // The pages are mostly scanned in order, the next blocks get read soon.
+    for (size_t i = 1; i <= prefetchBlocks_ && (blockNum + i) * blockSize_ < objectSize;
+         ++i) {
+      getBlock(key, objectSize, blockNum + i);
+    }
+    try {
+      block->fetched.get();
+    } catch (...) {
+      // Fetched again by the next read.
+      dropBlock({key, blockNum}, block);
+      throw;
+    }
+    pread_fully(block->fd, buf, bytes, blockOffset, "the cold storage cache");
+    buf += bytes;
+    offset += bytes;
+    size -= bytes;
+  }
+}
+
+void ColdStorage::remove(const std::string& key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto blockIt = blocks_.lower_bound({key, 0});
+    while (blockIt != blocks_.end() && blockIt->first.first == key) {
+      cachedBytes_ -= blockIt->second.first->size;
+      lru_.erase(blockIt->second.second);
+      blockIt = blocks_.erase(blockIt);
+    }
+  }
+  store_->remove(key);
+}
+
+size_t ColdStorage::getCachedBytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cachedBytes_;
+}
+
+std::shared_ptr<ColdStorage::Block> ColdStorage::getBlock(const std::string& key,
+                                                          const size_t objectSize,
+                                                          const size_t blockNum) {
+  const BlockKey blockKey{key, blockNum};
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto blockIt = blocks_.find(blockKey);
+  if (blockIt != blocks_.end()) {
+    lru_.splice(lru_.begin(), lru_, blockIt->second.second);
+    return blockIt->second.first;
+  }
+  auto block = std::make_shared<Block>();
+  block->size = std::min(blockSize_, objectSize - blockNum * blockSize_);
+  block->fetched =
+      std::async(
+          std::launch::async, &ColdStorage::fetchBlock, this, block.get(), key, blockNum)
+          .share();
+  lru_.push_front(blockKey);
+  blocks_.emplace(blockKey, std::make_pair(block, lru_.begin()));
+  cachedBytes_ += block->size;
+  evictBlocks();
+  return block;
+}
+
+void ColdStorage::fetchBlock(Block* block,
+                             const std::string& key,
+                             const size_t blockNum) {
+  std::vector<int8_t> data(block->size);
+  store_->get(key, blockNum * blockSize_, data.size(), data.data());
+  std::string path = cachePath_ + "/blockXXXXXX";
+  const int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    throw errno_error("Could not create a block of the cold storage cache in " +
+                      cachePath_);
+  }
+  unlink(path.c_str());
+  block->fd = fd;
+  pwrite_fully(fd, data.data(), data.size(), 0, path);
+}
+
+void ColdStorage::dropBlock(const BlockKey& blockKey,
+                            const std::shared_ptr<Block>& block) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto blockIt = blocks_.find(blockKey);
+  if (blockIt == blocks_.end() || blockIt->second.first != block) {
+    return;
+  }
+  cachedBytes_ -= block->size;
+  lru_.erase(blockIt->second.second);
+  blocks_.erase(blockIt);
+}
+
+void ColdStorage::evictBlocks() {
+  auto lruIt = lru_.end();
+  while (cachedBytes_ > cacheBytes_ && lruIt != lru_.begin()) {
+    --lruIt;
+    auto blockIt = blocks_.find(*lruIt);
+    CHECK(blockIt != blocks_.end());
+    const auto& block = blockIt->second.first;
+    // About to be read.
+    if (block->fetched.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      continue;
+    }
+    cachedBytes_ -= block->size;
+    blocks_.erase(blockIt);
+    lruIt = lru_.erase(lruIt);
+  }
+}
+
+}  // namespace File_Namespace
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ColdStorage.h
+ * @brief   Object storage for the data files nobody touched for a while, read through a
+ * cache on local disk.
+ *
+ * A data file none of the pages of which was read or written for g_cold_file_age_seconds
+ * is uploaded whole to an S3 compatible bucket, or to a directory on a cheaper volume,
+ * and the data of its pages in use is punched out of the local file. The first
+ * COLD_PAGE_PREFIX bytes of every page stay, so the page headers are read and written
+ * as before. The data read later is fetched from the object in blocks, which are kept
+ * in a cache of bounded size on local disk, and the blocks after them are prefetched. A
+ * page written to is made local again. FileInfo keeps track of the pages in the object
+ * store, in a file next to the data file.
+ */
+
+#ifndef DATAMGR_FILE_COLDSTORAGE_H
+#define DATAMGR_FILE_COLDSTORAGE_H
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Where the cold data files go: s3://bucket/prefix, or the path of a directory. Empty,
+// the default, keeps all the data files local.
+extern std::string g_cold_storage_url;
+// Endpoint of the S3 compatible service, AWS itself if empty.
+extern std::string g_cold_storage_endpoint;
+// Directory of the read cache, cold_cache in the data directory if empty.
+extern std::string g_cold_storage_cache_path;
+extern size_t g_cold_storage_cache_bytes;
+extern size_t g_cold_file_age_seconds;
+
+namespace File_Namespace {
+
+// Bytes at the start of each page of a cold file which stay in the local file, a
+// multiple of the block size of the file systems so that the rest can be punched out.
+const size_t COLD_PAGE_PREFIX{4096};
+
+class ObjectStore {
+ public:
+  virtual ~ObjectStore() {}
+
+  // Stores the contents of the file as the object, which is durable on return.
+  virtual void put(const std::string& key, const std::string& filePath) = 0;
+  virtual void get(const std::string& key,
+                   const size_t offset,
+                   const size_t size,
+                   int8_t* buf) = 0;
+  virtual void remove(const std::string& key) = 0;
+};
+
+// The store of an s3://bucket/prefix url or of a directory. Throws std::runtime_error if
+// the store isn't available.
+std::unique_ptr<ObjectStore> create_object_store(const std::string& url,
+                                                 const std::string& endpoint);
+
+class ColdStorage {
+ public:
+  ColdStorage(std::unique_ptr<ObjectStore> store,
+              const std::string& cachePath,
+              const size_t cacheBytes,
+              const size_t blockSize = 16 << 20,
+              const size_t prefetchBlocks = 2);
+
+  ~ColdStorage();
+
+  void upload(const std::string& key, const std::string& filePath);
+
+  // Reads a range of the object, of objectSize bytes, through the cache. Throws
+  // std::runtime_error if a block can't be fetched.
+  void read(const std::string& key,
+            const size_t objectSize,
+            size_t offset,
+            size_t size,
+            int8_t* buf);
+
+  // Removes the object and drops its blocks from the cache.
+  void remove(const std::string& key);
+
+  size_t getCachedBytes();
+
+ private:
+  // A block of an object in the cache, in an unlinked file which goes away with it.
+  struct Block {
+    int fd{-1};
+    size_t size{0};
+    std::shared_future<void> fetched;
+
+    // Waits for the fetch, which writes the file.
+    ~Block();
+  };
+  using BlockKey = std::pair<std::string, size_t>;
+
+  // Returns the block, fetching it in the background unless cached.
+  std::shared_ptr<Block> getBlock(const std::string& key,
+                                  const size_t objectSize,
+                                  const size_t blockNum);
+  void fetchBlock(Block* block, const std::string& key, const size_t blockNum);
+  void dropBlock(const BlockKey& blockKey, const std::shared_ptr<Block>& block);
+  // Drops the least recently read blocks while the cache is too large, requires mutex_.
+  void evictBlocks();
+
+  std::unique_ptr<ObjectStore> store_;
+  const std::string cachePath_;
+  const size_t cacheBytes_;
+  const size_t blockSize_;
+  const size_t prefetchBlocks_;
+
+  std::mutex mutex_;
+  size_t cachedBytes_;
+  // The most recently read first.
+  std::list<BlockKey> lru_;
+  std::map<BlockKey, std::pair<std::shared_ptr<Block>, std::list<BlockKey>::iterator>>
+      blocks_;
+};
+
+}  // namespace File_Namespace
+
+#endif  // DATAMGR_FILE_COLDSTORAGE_H
@@ -21,12 +21,19 @@
  *
  */
 #include "File.h"
+#include <fcntl.h>
 #include <glog/logging.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace File_Namespace {
 
@@ -110,6 +117,71 @@ size_t read(FILE* f, const size_t offset, const size_t size, int8_t* buf) {
   return bytesRead;
 }
 
+size_t readPagesData(FILE* f,
+                     const size_t pageSize,
+                     const size_t headerSize,
+                     const size_t pageNum,
+                     const size_t startOffset,
+                     const size_t size,
+                     int8_t* buf) {
+  CHECK_LT(headerSize + startOffset, pageSize);
+  const int fd = fileno(f);
+  // The headers of the pages in the middle of the range land here and are dropped.
+  std::vector<int8_t> headerSink(headerSize);
+  std::vector<iovec> iovs;
+  size_t fileOffset = pageNum * pageSize + headerSize + startOffset;
+  size_t dataLeft = size;
+  size_t pageDataLeft = pageSize - headerSize - startOffset;
+  while (dataLeft > 0) {
+    // Build one batch of interleaved data and header buffers, starting with data.
+    iovs.clear();
+    size_t batchBytes = 0;
+    while (dataLeft > 0 && iovs.size() + 2 <= IOV_MAX) {
+      const size_t dataBytes = std::min(pageDataLeft, dataLeft);
+      iovs.push_back({buf, dataBytes});
+      buf += dataBytes;
+      dataLeft -= dataBytes;
+      batchBytes += dataBytes;
+      pageDataLeft = pageSize - headerSize;
+      if (dataLeft > 0 && iovs.size() + 2 <= IOV_MAX) {
+        iovs.push_back({headerSink.data(), headerSize});
+        batchBytes += headerSize;
+      }
+    }
+    if (iovs.back().iov_base == headerSink.data()) {
+      iovs.pop_back();
+      batchBytes -= headerSize;
+    }
+    // Resume a short read where it stopped.
+    size_t iovIdx = 0;
+    size_t batchBytesLeft = batchBytes;
+    while (batchBytesLeft > 0) {
+      const auto iovCount = std::min(iovs.size() - iovIdx, static_cast<size_t>(IOV_MAX));
+      const ssize_t bytesRead = preadv(fd, &iovs[iovIdx], iovCount, fileOffset);
+      if (bytesRead < 0 && errno == EINTR) {
+        continue;
+      }
+      CHECK_GT(bytesRead, 0) << "Could not read pages of file: " << strerror(errno);
+      fileOffset += bytesRead;
+      batchBytesLeft -= bytesRead;
+      size_t consumed = bytesRead;
+      while (consumed > 0 && consumed >= iovs[iovIdx].iov_len) {
+        consumed -= iovs[iovIdx].iov_len;
+        ++iovIdx;
+      }
+      if (consumed > 0) {
+        iovs[iovIdx].iov_base = static_cast<int8_t*>(iovs[iovIdx].iov_base) + consumed;
+        iovs[iovIdx].iov_len -= consumed;
+      }
+    }
+    // Skip the header of the page the next batch starts in.
+    if (dataLeft > 0) {
+      fileOffset += headerSize;
+    }
+  }
+  return size;
+}
+
 size_t write(FILE* f, const size_t offset, const size_t size, int8_t* buf) {
   // write size bytes from the buffer to the offset location in the file
   fseek(f, offset, SEEK_SET);
@@ -119,6 +191,12 @@ size_t write(FILE* f, const size_t offset, const size_t size, int8_t* buf) {
   return bytesWritten;
 }
 
+void punchHole(FILE* f, const size_t offset, const size_t size) {
+  fflush(f);
+  // The file keeps its size and the pages their place in it.
+  fallocate(fileno(f), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset, size);
+}
+
 size_t append(FILE* f, const size_t size, int8_t* buf) {
   return write(f, fileSize(f), size, buf);
 }
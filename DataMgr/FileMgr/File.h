@@ -78,6 +78,28 @@ bool removeFile(const std::string basePath, const std::string filename);
  */
 size_t read(FILE* f, const size_t offset, const size_t size, int8_t* buf);
 
+/**
+ * @brief Reads the data of consecutive pages of file f into buf, skipping the header at
+ * the start of every page. Uses as few vectored reads as possible and doesn't move the
+ * position of the file.
+ *
+ * @param f Pointer to the FILE.
+ * @param pageSize The size of each page, including its header.
+ * @param headerSize The size of the header at the start of each page.
+ * @param pageNum The first page to read.
+ * @param startOffset The location within the data of the first page to start from.
+ * @param size The number of data bytes to read.
+ * @param buf The destination buffer to where data is being read from the file.
+ * @return size_t The number of data bytes read.
+ */
+size_t readPagesData(FILE* f,
+                     const size_t pageSize,
+                     const size_t headerSize,
+                     const size_t pageNum,
+                     const size_t startOffset,
+                     const size_t size,
+                     int8_t* buf);
+
 /**
  * @brief Writes the specified number of bytes to the offset position in file f from buf.
  *
@@ -90,6 +112,16 @@ size_t read(FILE* f, const size_t offset, const size_t size, int8_t* buf);
  */
 size_t write(FILE* f, const size_t offset, const size_t size, int8_t* buf);
 
+/**
+ * @brief Releases the disk space backing a range of the file f, which then reads back as
+ * zeros. This is only an optimization and is silently skipped where unsupported.
+ *
+ * @param f Pointer to the FILE.
+ * @param offset The location within the file where the range starts.
+ * @param size The number of bytes in the range.
+ */
+void punchHole(FILE* f, const size_t offset, const size_t size);
+
 /**
  * @brief Appends the specified number of bytes to the end of the file f from buf.
  *
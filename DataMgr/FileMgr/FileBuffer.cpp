@@ -22,6 +22,8 @@
 
 #include "FileBuffer.h"
 #include <glog/logging.h>
+#include <zlib.h>
+#include <cstring>
 #include <future>
 #include <map>
 #include <thread>
@@ -29,12 +31,57 @@
 #include "FileMgr.h"
 
 #define METADATA_PAGE_SIZE 4096
+// Bounded by the room left for the compressed page sizes and the bloom filter in the
+// metadata page.
+#define MAX_COMPRESSED_PAGES 768
 
 using namespace std;
 
+bool g_enable_coalesced_file_reads{true};
+int g_file_page_compression_level{0};
+
 namespace File_Namespace {
 size_t FileBuffer::headerBufferOffset_ = 32;
 
+namespace {
+
+// Returns the size of the compressed data, or zero if it isn't smaller than the input.
+size_t compress_page_data(const int8_t* src,
+                          const size_t srcSize,
+                          int8_t* dst,
+                          const size_t dstCapacity) {
+  uLongf dstSize = dstCapacity;
+  const int rc = compress2(reinterpret_cast<Bytef*>(dst),
+                           &dstSize,
+                           reinterpret_cast<const Bytef*>(src),
+                           srcSize,
+                           g_file_page_compression_level);
+  // Z_BUF_ERROR: the data doesn't fit in dstCapacity bytes compressed.
+  if (rc != Z_OK || dstSize >= srcSize) {
+    return 0;
+  }
+  return dstSize;
+}
+
+void uncompress_page_data(const int8_t* src,
+                          const size_t srcSize,
+                          int8_t* dst,
+                          const size_t dstSize,
+                          const ChunkKey& chunkKey,
+                          const size_t pageNum) {
+  uLongf uncompressedSize = dstSize;
+  const int rc = uncompress(reinterpret_cast<Bytef*>(dst),
+                            &uncompressedSize,
+                            reinterpret_cast<const Bytef*>(src),
+                            srcSize);
+  if (rc != Z_OK || uncompressedSize != dstSize) {
+    LOG(FATAL) << "Failure reading DB file " << showChunk(chunkKey)
+               << " compressed page " << pageNum << " error " << rc;
+  }
+}
+
+}  // namespace
+
 FileBuffer::FileBuffer(FileMgr* fm,
                        const size_t pageSize,
                        const ChunkKey& chunkKey,
@@ -191,8 +238,53 @@ struct readThreadDS {
   size_t t_startPageOffset;  // offset - used for the first page of the buffer
   bool t_isFirstPage;        // true - for first page of the buffer, false - otherwise
   std::vector<MultiPage> multiPages;  // MultiPages of the FileBuffer passed to the thread
+  std::vector<uint32_t> compressedPageSizes;  // see FileBuffer::getCompressedPageSizes
 };
 
+static bool isCompressed(const readThreadDS& threadDS, const size_t pageNum) {
+  return pageNum < threadDS.compressedPageSizes.size() &&
+         threadDS.compressedPageSizes[pageNum] > 0;
+}
+
+// Reads the compressed data of the logical page and copies numBytes of it, starting at
+// pageOffset, to dst once uncompressed.
+static size_t readCompressedPage(FileBuffer* fileBuffer,
+                                 const readThreadDS& threadDS,
+                                 const size_t pageNum,
+                                 const size_t pageOffset,
+                                 const size_t numBytes,
+                                 int8_t* dst) {
+  const Page page = threadDS.multiPages[pageNum].current();
+  FileInfo* fileInfo = threadDS.t_fm->getFileInfoForFileId(page.fileId);
+  CHECK(fileInfo);
+  const size_t compressedSize = threadDS.compressedPageSizes[pageNum];
+  std::vector<int8_t> compressedData(compressedSize);
+  const size_t bytesRead = fileInfo->read(
+      page.pageNum * fileBuffer->pageSize() + fileBuffer->reservedHeaderSize(),
+      compressedSize,
+      compressedData.data());
+  CHECK_EQ(bytesRead, compressedSize);
+  const size_t pageDataSize = fileBuffer->pageDataSize();
+  if (pageOffset == 0 && numBytes == pageDataSize) {
+    uncompress_page_data(compressedData.data(),
+                         compressedSize,
+                         dst,
+                         pageDataSize,
+                         fileBuffer->getChunkKey(),
+                         pageNum);
+  } else {
+    std::vector<int8_t> pageData(pageDataSize);
+    uncompress_page_data(compressedData.data(),
+                         compressedSize,
+                         pageData.data(),
+                         pageDataSize,
+                         fileBuffer->getChunkKey(),
+                         pageNum);
+    memcpy(dst, pageData.data() + pageOffset, numBytes);
+  }
+  return numBytes;
+}
+
 static size_t readForThread(FileBuffer* fileBuffer, const readThreadDS threadDS) {
   size_t startPage = threadDS.t_startPage;  // start reading at startPage, including it
   size_t endPage = threadDS.t_endPage;      // stop reading at endPage, not including it
@@ -201,6 +293,52 @@ static size_t readForThread(FileBuffer* fileBuffer, const readThreadDS threadDS)
   size_t totalBytesRead = 0;
   bool isFirstPage = threadDS.t_isFirstPage;
 
+  if (g_enable_coalesced_file_reads) {
+    // Read the runs of logical pages stored in consecutive pages of the same file at
+    // once, skipping the page headers.
+    size_t pageNum = startPage;
+    while (pageNum < endPage) {
+      CHECK(threadDS.multiPages[pageNum].pageSize == fileBuffer->pageSize());
+      const Page firstPage = threadDS.multiPages[pageNum].current();
+      const size_t firstPageOffset = isFirstPage ? threadDS.t_startPageOffset : 0;
+      size_t runBytes = min(fileBuffer->pageDataSize() - firstPageOffset, bytesLeft);
+      if (isCompressed(threadDS, pageNum)) {
+        readCompressedPage(
+            fileBuffer, threadDS, pageNum, firstPageOffset, runBytes, curPtr);
+        isFirstPage = false;
+        curPtr += runBytes;
+        bytesLeft -= runBytes;
+        totalBytesRead += runBytes;
+        ++pageNum;
+        continue;
+      }
+      size_t runEnd = pageNum + 1;
+      while (runEnd < endPage && runBytes < bytesLeft) {
+        const Page page = threadDS.multiPages[runEnd].current();
+        if (isCompressed(threadDS, runEnd) || page.fileId != firstPage.fileId ||
+            page.pageNum != firstPage.pageNum + (runEnd - pageNum)) {
+          break;
+        }
+        runBytes += min(fileBuffer->pageDataSize(), bytesLeft - runBytes);
+        ++runEnd;
+      }
+      FileInfo* fileInfo = threadDS.t_fm->getFileInfoForFileId(firstPage.fileId);
+      CHECK(fileInfo);
+      const size_t bytesRead = fileInfo->readPagesData(firstPage.pageNum,
+                                                       fileBuffer->reservedHeaderSize(),
+                                                       firstPageOffset,
+                                                       runBytes,
+                                                       curPtr);
+      isFirstPage = false;
+      curPtr += bytesRead;
+      bytesLeft -= bytesRead;
+      totalBytesRead += bytesRead;
+      pageNum = runEnd;
+    }
+    CHECK(bytesLeft == 0);
+    return totalBytesRead;
+  }
+
   // Traverse the logical pages
   for (size_t pageNum = startPage; pageNum < endPage; ++pageNum) {
     CHECK(threadDS.multiPages[pageNum].pageSize == fileBuffer->pageSize());
@@ -212,7 +350,17 @@ static size_t readForThread(FileBuffer* fileBuffer, const readThreadDS threadDS)
     // Read the page into the destination (dst) buffer at its
     // current (cur) location
     size_t bytesRead = 0;
-    if (isFirstPage) {
+    if (isCompressed(threadDS, pageNum)) {
+      const size_t pageOffset = isFirstPage ? threadDS.t_startPageOffset : 0;
+      bytesRead = readCompressedPage(
+          fileBuffer,
+          threadDS,
+          pageNum,
+          pageOffset,
+          min(fileBuffer->pageDataSize() - pageOffset, bytesLeft),
+          curPtr);
+      isFirstPage = false;
+    } else if (isFirstPage) {
       bytesRead = fileInfo->read(
           page.pageNum * fileBuffer->pageSize() + threadDS.t_startPageOffset +
               fileBuffer->reservedHeaderSize(),
@@ -296,6 +444,7 @@ void FileBuffer::read(int8_t* const dst,
                            numBytesCurrent);
   threadDS.t_bytesLeft = bytesLeftForThread;
   threadDS.multiPages = getMultiPage();
+  threadDS.compressedPageSizes = compressedPageSizes_;
 
   if (numThreads == 1) {
     bytesRead += readForThread(this, threadDS);
@@ -325,6 +474,7 @@ void FileBuffer::read(int8_t* const dst,
           ((threadDS.t_endPage - threadDS.t_startPage) * pageDataSize_), numBytesCurrent);
       threadDS.t_bytesLeft = bytesLeftForThread;
       threadDS.multiPages = getMultiPage();
+  threadDS.compressedPageSizes = compressedPageSizes_;
     }
 
     for (auto& p : threads) {
@@ -337,6 +487,21 @@ void FileBuffer::read(int8_t* const dst,
   CHECK(bytesRead == numBytes);
 }
 
+void FileBuffer::setDirty() {
+  AbstractBuffer::setDirty();
+  fm_->addDirtyChunk(chunkKey_);
+}
+
+void FileBuffer::setUpdated() {
+  AbstractBuffer::setUpdated();
+  fm_->addDirtyChunk(chunkKey_);
+}
+
+void FileBuffer::setAppended() {
+  AbstractBuffer::setAppended();
+  fm_->addDirtyChunk(chunkKey_);
+}
+
 void FileBuffer::copyPage(Page& srcPage,
                           Page& destPage,
                           const size_t numBytes,
@@ -366,10 +531,72 @@ Page FileBuffer::addNewMultiPage(const int epoch) {
   return page;
 }
 
+Page FileBuffer::getPageForRewrite(const size_t pageNum) {
+  const int epoch = fm_->epoch();
+  MultiPage& multiPage = multiPages_[pageNum];
+  if (multiPage.epochs.back() < epoch) {
+    Page page = fm_->requestFreePage(pageSize_, false);
+    multiPage.epochs.push_back(epoch);
+    multiPage.pageVersions.push_back(page);
+    writeHeader(page, pageNum, epoch);
+  }
+  return multiPage.current();
+}
+
+bool FileBuffer::compressPage(const size_t pageNum, const int8_t* pageData) {
+  if (g_file_page_compression_level <= 0 || pageNum >= MAX_COMPRESSED_PAGES ||
+      isPageCompressed(pageNum)) {
+    return false;
+  }
+  std::vector<int8_t> storedData;
+  if (!pageData) {
+    const Page page = multiPages_[pageNum].current();
+    FileInfo* fileInfo = fm_->getFileInfoForFileId(page.fileId);
+    storedData.resize(pageDataSize_);
+    fileInfo->read(
+        page.pageNum * pageSize_ + reservedHeaderSize_, pageDataSize_, storedData.data());
+    pageData = storedData.data();
+  }
+  std::vector<int8_t> compressedData(pageDataSize_);
+  const size_t compressedSize = compress_page_data(
+      pageData, pageDataSize_, compressedData.data(), compressedData.size());
+  if (!compressedSize) {
+    return false;
+  }
+  Page page = getPageForRewrite(pageNum);
+  FileInfo* fileInfo = fm_->getFileInfoForFileId(page.fileId);
+  const size_t dataOffset = page.pageNum * pageSize_ + reservedHeaderSize_;
+  fileInfo->write(dataOffset, compressedSize, compressedData.data());
+  // The rest of the page is never read while the page stays compressed.
+  fileInfo->punchHole(dataOffset + compressedSize, pageDataSize_ - compressedSize);
+  if (compressedPageSizes_.size() <= pageNum) {
+    compressedPageSizes_.resize(pageNum + 1, 0);
+  }
+  compressedPageSizes_[pageNum] = compressedSize;
+  return true;
+}
+
+void FileBuffer::decompressPages(const size_t startPage, const size_t endPage) {
+  for (size_t pageNum = startPage; pageNum < min(endPage, compressedPageSizes_.size());
+       ++pageNum) {
+    if (!compressedPageSizes_[pageNum]) {
+      continue;
+    }
+    std::vector<int8_t> pageData(pageDataSize_);
+    read(pageData.data(), pageDataSize_, pageNum * pageDataSize_);
+    Page page = getPageForRewrite(pageNum);
+    compressedPageSizes_[pageNum] = 0;
+    FileInfo* fileInfo = fm_->getFileInfoForFileId(page.fileId);
+    fileInfo->write(
+        page.pageNum * pageSize_ + reservedHeaderSize_, pageDataSize_, pageData.data());
+  }
+}
+
 void FileBuffer::writeHeader(Page& page,
                              const int pageId,
                              const int epoch,
                              const bool writeMetadata) {
+  fm_->headerChanged();
   int intHeaderSize = chunkKey_.size() + 3;  // does not include chunkSize
   vector<int> header(intHeaderSize);
   // in addition to chunkkey we need size of header, pageId, version
@@ -394,7 +621,9 @@ void FileBuffer::readMetadata(const Page& page) {
                                        // encodingType, encodingBits all as int
   fread((int8_t*)&(typeData[0]), sizeof(int), typeData.size(), f);
   int version = typeData[0];
-  CHECK(version == METADATA_VERSION);  // add backward compatibility code here
+  // add backward compatibility code here
+  CHECK(version == METADATA_VERSION || version == METADATA_VERSION_COMPRESSED ||
+        version == METADATA_VERSION_UNCOMPRESSED);
   hasEncoder = static_cast<bool>(typeData[1]);
   if (hasEncoder) {
     sqlType.set_type(static_cast<SQLTypes>(typeData[2]));
@@ -408,6 +637,28 @@ void FileBuffer::readMetadata(const Page& page) {
     initEncoder(sqlType);
     encoder->readMetadata(f);
   }
+  compressedPageSizes_.clear();
+  if (version != METADATA_VERSION_UNCOMPRESSED) {
+    uint32_t numCompressedPageSizes = 0;
+    fread(&numCompressedPageSizes, sizeof(uint32_t), 1, f);
+    CHECK_LE(numCompressedPageSizes, size_t(MAX_COMPRESSED_PAGES));
+    compressedPageSizes_.resize(numCompressedPageSizes);
+    fread(compressedPageSizes_.data(), sizeof(uint32_t), numCompressedPageSizes, f);
+  }
+  if (hasEncoder) {
+    std::unique_ptr<ChunkBloomFilter> bloomFilter;
+    if (version == METADATA_VERSION) {
+      uint32_t hasBloomFilter = 0;
+      fread(&hasBloomFilter, sizeof(uint32_t), 1, f);
+      if (hasBloomFilter) {
+        std::array<uint64_t, ChunkBloomFilter::kNumWords> words;
+        fread(words.data(), sizeof(uint64_t), words.size(), f);
+        bloomFilter.reset(new ChunkBloomFilter(words));
+      }
+    }
+    // Without a persisted filter the values of the chunk are unknown.
+    encoder->setBloomFilter(std::move(bloomFilter));
+  }
 }
 
 void FileBuffer::writeMetadata(const int epoch) {
@@ -421,7 +672,14 @@ void FileBuffer::writeMetadata(const int epoch) {
   fwrite((int8_t*)&size_, sizeof(size_t), 1, f);
   vector<int> typeData(NUM_METADATA);  // assumes we will encode hasEncoder, bufferType,
                                        // encodingType, encodingBits all as int
-  typeData[0] = METADATA_VERSION;
+  uint32_t numCompressedPageSizes = compressedPageSizes_.size();
+  while (numCompressedPageSizes > 0 &&
+         !compressedPageSizes_[numCompressedPageSizes - 1]) {
+    --numCompressedPageSizes;
+  }
+  const auto bloomFilter = hasEncoder ? encoder->getBloomFilter() : nullptr;
+  typeData[0] = numCompressedPageSizes || bloomFilter ? METADATA_VERSION
+                                                      : METADATA_VERSION_UNCOMPRESSED;
   typeData[1] = static_cast<int>(hasEncoder);
   if (hasEncoder) {
     typeData[2] = static_cast<int>(sqlType.get_type());
@@ -437,6 +695,18 @@ void FileBuffer::writeMetadata(const int epoch) {
   if (hasEncoder) {  // redundant
     encoder->writeMetadata(f);
   }
+  if (typeData[0] == METADATA_VERSION) {
+    fwrite(&numCompressedPageSizes, sizeof(uint32_t), 1, f);
+    fwrite(compressedPageSizes_.data(), sizeof(uint32_t), numCompressedPageSizes, f);
+    if (hasEncoder) {
+      const uint32_t hasBloomFilter = bloomFilter != nullptr;
+      fwrite(&hasBloomFilter, sizeof(uint32_t), 1, f);
+      if (bloomFilter) {
+        const auto& words = bloomFilter->getWords();
+        fwrite(words.data(), sizeof(uint64_t), words.size(), f);
+      }
+    }
+  }
   metadataPages_.epochs.push_back(epoch);
   metadataPages_.pageVersions.push_back(page);
 }
@@ -457,8 +727,7 @@ void FileBuffer::append(int8_t* src,
                         const size_t numBytes,
                         const MemoryLevel srcBufferType,
                         const int deviceId) {
-  isDirty_ = true;
-  isAppended_ = true;
+  setAppended();
 
   size_t startPage = size_ / pageDataSize_;
   size_t startPageOffset = size_ % pageDataSize_;
@@ -469,6 +738,7 @@ void FileBuffer::append(int8_t* src,
   size_t initialNumPages = multiPages_.size();
   size_ = size_ + numBytes;
   int epoch = fm_->epoch();
+  decompressPages(startPage, startPage + numPagesToWrite);
   for (size_t pageNum = startPage; pageNum < startPage + numPagesToWrite; ++pageNum) {
     Page page;
     if (pageNum >= initialNumPages) {
@@ -480,6 +750,13 @@ void FileBuffer::append(int8_t* src,
       page = multiPages_[pageNum].current();
     }
     CHECK(page.fileId >= 0);  // make sure page was initialized
+    const bool isWholePage =
+        (pageNum != startPage || startPageOffset == 0) && bytesLeft >= pageDataSize_;
+    if (isWholePage && compressPage(pageNum, curPtr)) {
+      curPtr += pageDataSize_;
+      bytesLeft -= pageDataSize_;
+      continue;
+    }
     FileInfo* fileInfo = fm_->getFileInfoForFileId(page.fileId);
     size_t bytesWritten;
     if (pageNum == startPage) {
@@ -487,6 +764,10 @@ void FileBuffer::append(int8_t* src,
           page.pageNum * pageSize_ + startPageOffset + reservedHeaderSize_,
           min(pageDataSize_ - startPageOffset, bytesLeft),
           curPtr);
+      if (startPageOffset > 0 && startPageOffset + bytesWritten == pageDataSize_) {
+        // This append filled up the page.
+        compressPage(pageNum, nullptr);
+      }
     } else {
       bytesWritten = fileInfo->write(page.pageNum * pageSize_ + reservedHeaderSize_,
                                      min(pageDataSize_, bytesLeft),
@@ -506,7 +787,7 @@ void FileBuffer::write(int8_t* src,
   if (srcBufferType != CPU_LEVEL) {
     LOG(FATAL) << "Unsupported Buffer type";
   }
-  isDirty_ = true;
+  setDirty();
   if (offset < size_) {
     isUpdated_ = true;
   }
@@ -527,6 +808,9 @@ void FileBuffer::write(int8_t* src,
   int8_t* curPtr = src;  // a pointer to the current location in dst being written to
   size_t initialNumPages = multiPages_.size();
   int epoch = fm_->epoch();
+  // Compressed pages are rewritten uncompressed before being partially overwritten and
+  // compressed again below.
+  decompressPages(startPage, startPage + numPagesToWrite);
 
   if (startPage >
       initialNumPages) {  // means there is a gap we need to allocate pages for
@@ -589,6 +873,11 @@ void FileBuffer::write(int8_t* src,
     }
   }
   CHECK(bytesLeft == 0);
+  for (size_t pageNum = startPage;
+       pageNum < startPage + numPagesToWrite && (pageNum + 1) * pageDataSize_ <= size_;
+       ++pageNum) {
+    compressPage(pageNum, nullptr);
+  }
 }
 
 }  // namespace File_Namespace
@@ -31,8 +31,18 @@
 
 using namespace Data_Namespace;
 
+// Read runs of pages stored next to each other in a file with vectored reads.
+extern bool g_enable_coalesced_file_reads;
+
+// zlib level used to compress full data pages as they are written; zero disables it.
+extern int g_file_page_compression_level;
+
 #define NUM_METADATA 10
-#define METADATA_VERSION 0
+#define METADATA_VERSION 2
+// Version 1 appends the compressed sizes of the pages to the metadata, version 2 the
+// bloom filter of the encoder after them. Chunks with neither keep writing version 0.
+#define METADATA_VERSION_COMPRESSED 1
+#define METADATA_VERSION_UNCOMPRESSED 0
 
 namespace File_Namespace {
 
@@ -132,6 +142,18 @@ class FileBuffer : public AbstractBuffer {
   /// Returns vector of MultiPages in the FileBuffer.
   inline virtual std::vector<MultiPage> getMultiPage() const { return multiPages_; }
 
+  /// Returns the compressed size of the data of each logical page, zero for the pages
+  /// stored uncompressed. May be shorter than the number of pages.
+  inline const std::vector<uint32_t>& getCompressedPageSizes() const {
+    return compressedPageSizes_;
+  }
+
+  inline const ChunkKey& getChunkKey() const { return chunkKey_; }
+
+  inline bool isPageCompressed(const size_t pageNum) const {
+    return pageNum < compressedPageSizes_.size() && compressedPageSizes_[pageNum] > 0;
+  }
+
   inline virtual size_t size() const { return size_; }
 
   /// Returns the total number of bytes allocated for the FileBuffer.
@@ -144,6 +166,12 @@ class FileBuffer : public AbstractBuffer {
   /// flush/checkpoint.
   virtual bool isDirty() const { return isDirty_; }
 
+  /// The dirty bits are tracked by the FileMgr as well, so checkpoints only visit the
+  /// chunks which changed since the last one.
+  virtual void setDirty();
+  virtual void setUpdated();
+  virtual void setAppended();
+
  private:
   // FileBuffer(const FileBuffer&);      // private copy constructor
   // FileBuffer& operator=(const FileBuffer&); // private overloaded assignment operator
@@ -160,6 +188,18 @@ class FileBuffer : public AbstractBuffer {
   void readMetadata(const Page& page);
   void calcHeaderBuffer();
 
+  /// Returns the current version of the page, after adding a new version if the
+  /// current one belongs to an older epoch and must not be overwritten.
+  Page getPageForRewrite(const size_t pageNum);
+
+  /// Stores the full page compressed if that saves space, reading its data back from
+  /// disk when pageData is null. Returns false and leaves the page as is otherwise.
+  bool compressPage(const size_t pageNum, const int8_t* pageData);
+
+  /// Stores the compressed pages in [startPage, endPage) uncompressed again, so they
+  /// can be partially overwritten.
+  void decompressPages(const size_t startPage, const size_t endPage);
+
   FileMgr* fm_;  // a reference to FileMgr is needed for writing to new pages in available
                  // files
   static size_t headerBufferOffset_;
@@ -169,6 +209,7 @@ class FileBuffer : public AbstractBuffer {
   size_t pageDataSize_;
   size_t reservedHeaderSize_;  // lets make this a constant now for simplicity - 128 bytes
   ChunkKey chunkKey_;
+  std::vector<uint32_t> compressedPageSizes_;
 };
 
 }  // namespace File_Namespace
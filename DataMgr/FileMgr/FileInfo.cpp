@@ -16,11 +16,19 @@
 
 #include "FileInfo.h"
 #include <glog/logging.h>
+#include <boost/filesystem.hpp>
+#include <boost/system/error_code.hpp>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include "ColdStorage.h"
 #include "File.h"
 #include "FileMgr.h"
 #include "Page.h"
 
+#include <algorithm>
 #include <utility>
 using namespace std;
 
@@ -32,7 +40,17 @@ FileInfo::FileInfo(FileMgr* fileMgr,
                    const size_t pageSize,
                    size_t numPages,
                    bool init)
-    : fileMgr(fileMgr), fileId(fileId), f(f), pageSize(pageSize), numPages(numPages) {
+    : fileMgr(fileMgr)
+    , fileId(fileId)
+    , f(f)
+    , pageSize(pageSize)
+    , numPages(numPages)
+    , isDirty(true)
+    , lastAccessTime(time(nullptr))
+    , writeCount(0)
+    , numRemotePages(0)
+    , coldObjectSize(0)
+    , coldPagesDirty(false) {
   if (init) {
     initNewFile();
   }
@@ -58,15 +76,245 @@ void FileInfo::initNewFile() {
 }
 
 size_t FileInfo::write(const size_t offset, const size_t size, int8_t* buf) {
+  lastAccessTime = time(nullptr);
+  // Counted before the cold pages are checked, so that moving the file to the cold
+  // storage concurrently gives up.
+  ++writeCount;
+  mapd_shared_lock<mapd_shared_mutex> coldReadLock(coldMutex_);
+  mapd_unique_lock<mapd_shared_mutex> coldWriteLock;
+  if (numRemotePages > 0) {
+    coldReadLock.unlock();
+    coldWriteLock = mapd_unique_lock<mapd_shared_mutex>(coldMutex_);
+    localizePages(offset, size);
+  }
   std::lock_guard<std::mutex> lock(readWriteMutex_);
+  isDirty = true;
   return File_Namespace::write(f, offset, size, buf);
 }
 
 size_t FileInfo::read(const size_t offset, const size_t size, int8_t* buf) {
+  lastAccessTime = time(nullptr);
+  mapd_shared_lock<mapd_shared_mutex> coldReadLock(coldMutex_);
+  if (numRemotePages > 0) {
+    readCold(offset, size, buf);
+    return size;
+  }
   std::lock_guard<std::mutex> lock(readWriteMutex_);
   return File_Namespace::read(f, offset, size, buf);
 }
 
+void FileInfo::punchHole(const size_t offset, const size_t size) {
+  std::lock_guard<std::mutex> lock(readWriteMutex_);
+  isDirty = true;
+  File_Namespace::punchHole(f, offset, size);
+}
+
+size_t FileInfo::readPagesData(const size_t pageNum,
+                               const size_t headerSize,
+                               const size_t startOffset,
+                               const size_t size,
+                               int8_t* buf) {
+  lastAccessTime = time(nullptr);
+  mapd_shared_lock<mapd_shared_mutex> coldReadLock(coldMutex_);
+  if (numRemotePages == 0) {
+    return File_Namespace::readPagesData(
+        f, pageSize, headerSize, pageNum, startOffset, size, buf);
+  }
+  // Page by page, the data of some of them is in the cold storage.
+  size_t pageDataOffset = headerSize + startOffset;
+  size_t dataLeft = size;
+  for (size_t page = pageNum; dataLeft > 0; ++page) {
+    const size_t bytes = std::min(dataLeft, pageSize - pageDataOffset);
+    readCold(page * pageSize + pageDataOffset, bytes, buf);
+    buf += bytes;
+    dataLeft -= bytes;
+    pageDataOffset = headerSize;
+  }
+  return size;
+}
+
+void FileInfo::readCold(size_t offset, size_t size, int8_t* buf) {
+  while (size > 0) {
+    const size_t pageNum = offset / pageSize;
+    const size_t pageOffset = offset % pageSize;
+    size_t bytes = std::min(size, pageSize - pageOffset);
+    if (isPageRemote(pageNum) && pageOffset >= COLD_PAGE_PREFIX) {
+      getColdStorage()->read(coldObject, coldObjectSize, offset, bytes, buf);
+    } else {
+      if (isPageRemote(pageNum)) {
+        bytes = std::min(bytes, COLD_PAGE_PREFIX - pageOffset);
+      }
+      std::lock_guard<std::mutex> lock(readWriteMutex_);
+      File_Namespace::read(f, offset, bytes, buf);
+    }
+    buf += bytes;
+    offset += bytes;
+    size -= bytes;
+  }
+}
+
+void FileInfo::localizePages(const size_t offset, const size_t size) {
+  const size_t endOffset = offset + size;
+  for (size_t pageNum = offset / pageSize; pageNum * pageSize < endOffset; ++pageNum) {
+    if (!isPageRemote(pageNum)) {
+      continue;
+    }
+    const size_t remoteBegin = pageNum * pageSize + COLD_PAGE_PREFIX;
+    const size_t remoteEnd = (pageNum + 1) * pageSize;
+    // Nothing to fetch when the write replaces all the remote data of the page.
+    if (offset > remoteBegin || endOffset < remoteEnd) {
+      std::vector<int8_t> data(remoteEnd - remoteBegin);
+      getColdStorage()->read(
+          coldObject, coldObjectSize, remoteBegin, data.size(), data.data());
+      std::lock_guard<std::mutex> lock(readWriteMutex_);
+      File_Namespace::write(f, remoteBegin, data.size(), data.data());
+    }
+    remotePages[pageNum] = false;
+    --numRemotePages;
+    coldPagesDirty = true;
+    isDirty = true;
+  }
+}
+
+size_t FileInfo::setColdObject(const std::string& key,
+                               const uint64_t expectedWriteCount) {
+  mapd_unique_lock<mapd_shared_mutex> coldWriteLock(coldMutex_);
+  // The object of the file may only go away at the next sync.
+  if (writeCount != expectedWriteCount || isDirty || numRemotePages > 0 ||
+      !coldObject.empty()) {
+    return 0;
+  }
+  remotePages.assign(numPages, true);
+  {
+    std::lock_guard<std::mutex> lock(freePagesMutex_);
+    for (const auto pageNum : freePages) {
+      remotePages[pageNum] = false;
+    }
+  }
+  numRemotePages = std::count(remotePages.begin(), remotePages.end(), true);
+  coldObject = key;
+  coldObjectSize = size();
+  if (numRemotePages == 0 || !saveColdPages()) {
+    remotePages.clear();
+    numRemotePages = 0;
+    coldObject.clear();
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(readWriteMutex_);
+  for (size_t pageNum = 0; pageNum < numPages; ++pageNum) {
+    if (remotePages[pageNum]) {
+      File_Namespace::punchHole(
+          f, pageNum * pageSize + COLD_PAGE_PREFIX, pageSize - COLD_PAGE_PREFIX);
+    }
+  }
+  return numRemotePages * (pageSize - COLD_PAGE_PREFIX);
+}
+
+int FileInfo::syncToDisk() {
+  // The data of the pages made local must be on disk before they are saved as local.
+  mapd_unique_lock<mapd_shared_mutex> coldWriteLock;
+  if (coldPagesDirty) {
+    coldWriteLock = mapd_unique_lock<mapd_shared_mutex>(coldMutex_);
+  }
+  isDirty = false;
+  fflush(f);
+#ifdef __APPLE__
+  int status = fcntl(fileno(f), 51);
+#else
+  int status = fsync(fileno(f));
+#endif
+  if (status != 0 || !coldWriteLock.owns_lock() || !coldPagesDirty) {
+    return status;
+  }
+  if (!saveColdPages()) {
+    return -1;
+  }
+  if (numRemotePages == 0 && !coldObject.empty()) {
+    try {
+      getColdStorage()->remove(coldObject);
+    } catch (const std::exception& e) {
+      LOG(WARNING) << e.what();
+    }
+    remotePages.clear();
+    coldObject.clear();
+  }
+  return 0;
+}
+
+ColdStorage* FileInfo::getColdStorage() const {
+  return fileMgr->getColdStorage();
+}
+
+std::string FileInfo::coldPagesPath() const {
+  return fileMgr->getFileMgrBasePath() + std::to_string(fileId) + "." +
+         std::to_string(pageSize) + ".cold";
+}
+
+void FileInfo::loadColdPages() {
+  const auto path = coldPagesPath();
+  std::ifstream coldPagesFile(path);
+  if (!coldPagesFile) {
+    return;
+  }
+  if (!getColdStorage()) {
+    LOG(FATAL) << "The pages of " << path
+               << " are in the cold storage, which is not configured";
+  }
+  std::string bitmap;
+  if (!std::getline(coldPagesFile, coldObject) || !(coldPagesFile >> coldObjectSize) ||
+      !(coldPagesFile >> bitmap) || bitmap.size() != numPages) {
+    LOG(FATAL) << "Invalid cold pages file " << path;
+  }
+  remotePages.assign(numPages, false);
+  for (size_t pageNum = 0; pageNum < numPages; ++pageNum) {
+    remotePages[pageNum] = bitmap[pageNum] == '1';
+  }
+  numRemotePages = std::count(remotePages.begin(), remotePages.end(), true);
+}
+
+bool FileInfo::saveColdPages() {
+  const auto path = coldPagesPath();
+  coldPagesDirty = false;
+  if (numRemotePages == 0) {
+    boost::system::error_code ec;
+    boost::filesystem::remove(path, ec);
+    if (ec) {
+      LOG(ERROR) << "Could not remove " << path << ": " << ec.message();
+      coldPagesDirty = true;
+      return false;
+    }
+    return true;
+  }
+  std::string bitmap(numPages, '0');
+  for (size_t pageNum = 0; pageNum < numPages; ++pageNum) {
+    if (remotePages[pageNum]) {
+      bitmap[pageNum] = '1';
+    }
+  }
+  // Written aside and renamed, a crash leaves the previous version.
+  const auto tmpPath = path + ".tmp";
+  FILE* coldPagesFile = fopen(tmpPath.c_str(), "w");
+  bool saved = coldPagesFile &&
+               fprintf(coldPagesFile,
+                       "%s\n%zu\n%s\n",
+                       coldObject.c_str(),
+                       coldObjectSize,
+                       bitmap.c_str()) > 0 &&
+               fflush(coldPagesFile) == 0 && fsync(fileno(coldPagesFile)) == 0;
+  if (coldPagesFile && fclose(coldPagesFile) != 0) {
+    saved = false;
+  }
+  if (saved && rename(tmpPath.c_str(), path.c_str()) != 0) {
+    saved = false;
+  }
+  if (!saved) {
+    LOG(ERROR) << "Could not save " << path << ": " << strerror(errno);
+    unlink(tmpPath.c_str());
+    coldPagesDirty = true;
+  }
+  return saved;
+}
+
 void FileInfo::openExistingFile(std::vector<HeaderInfo>& headerVec,
                                 const int fileMgrEpoch) {
   // HeaderInfo is defined in Page.h
@@ -201,9 +449,11 @@ static void sighandler(int sig) {
 #endif
 
 void FileInfo::freePage(int pageId) {
+  fileMgr->headerChanged();
 #define RESILIENT_PAGE_HEADER
 #ifdef RESILIENT_PAGE_HEADER
   int epoch_freed_page[2] = {DELETE_CONTINGENT, fileMgr->epoch()};
+  isDirty = true;
   File_Namespace::write(f,
                         pageId * pageSize + sizeof(int),
                         sizeof(epoch_freed_page),
@@ -212,6 +462,7 @@ void FileInfo::freePage(int pageId) {
 #else
   int zeroVal = 0;
   int8_t* zeroAddr = reinterpret_cast<int8_t*>(&zeroVal);
+  isDirty = true;
   File_Namespace::write(f, pageId * pageSize, sizeof(int), zeroAddr);
   std::lock_guard<std::mutex> lock(freePagesMutex_);
   freePages.insert(pageId);
@@ -226,13 +477,26 @@ void FileInfo::freePage(int pageId) {
 
 int FileInfo::getFreePage() {
   // returns -1 if there is no free page
-  std::lock_guard<std::mutex> lock(freePagesMutex_);
-  if (freePages.size() == 0) {
-    return -1;
+  int pageNum;
+  {
+    std::lock_guard<std::mutex> lock(freePagesMutex_);
+    if (freePages.size() == 0) {
+      return -1;
+    }
+    auto pageIt = freePages.begin();
+    pageNum = *pageIt;
+    freePages.erase(pageIt);
+  }
+  if (numRemotePages > 0) {
+    // The old data of the page is of no use, the page gets written locally.
+    mapd_unique_lock<mapd_shared_mutex> coldWriteLock(coldMutex_);
+    if (isPageRemote(pageNum)) {
+      remotePages[pageNum] = false;
+      --numRemotePages;
+      coldPagesDirty = true;
+      isDirty = true;
+    }
   }
-  auto pageIt = freePages.begin();
-  int pageNum = *pageIt;
-  freePages.erase(pageIt);
   return pageNum;
 }
 
@@ -19,10 +19,13 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <atomic>
 #include <cstdio>
 #include <mutex>
 #include <set>
+#include <string>
 #include <vector>
+#include "../../Shared/mapd_shared_mutex.h"
 #include "../../Shared/types.h"
 #include "Page.h"
 
@@ -46,6 +49,7 @@ struct Page;
  */
 #define DELETE_CONTINGENT (-1)
 
+class ColdStorage;
 class FileMgr;
 struct FileInfo {
   FileMgr* fileMgr;
@@ -58,6 +62,19 @@ struct FileInfo {
   std::set<size_t> freePages;  /// set of page numbers of free pages
   std::mutex freePagesMutex_;
   std::mutex readWriteMutex_;
+  std::atomic<bool> isDirty;  /// written to since the last sync
+  std::atomic<int64_t> lastAccessTime;  /// seconds since the epoch of the last read/write
+  std::atomic<uint64_t> writeCount;
+
+  // The pages the data of which, past their first COLD_PAGE_PREFIX bytes, is in the
+  // coldObject uploaded from the file, see ColdStorage.h. Guarded by coldMutex_,
+  // exclusively when they change.
+  std::vector<bool> remotePages;
+  std::atomic<size_t> numRemotePages;
+  std::string coldObject;
+  size_t coldObjectSize;
+  std::atomic<bool> coldPagesDirty;  /// remotePages changed since saved
+  mapd_shared_mutex coldMutex_;
 
   /// Constructor
   FileInfo(FileMgr* fileMgr,
@@ -79,6 +96,23 @@ struct FileInfo {
   int getFreePage();
   size_t write(const size_t offset, const size_t size, int8_t* buf);
   size_t read(const size_t offset, const size_t size, int8_t* buf);
+  void punchHole(const size_t offset, const size_t size);
+  /// Whether the data of the page is in the cold storage, requires coldMutex_.
+  bool isPageRemote(const size_t pageNum) const {
+    return pageNum < remotePages.size() && remotePages[pageNum];
+  }
+  /// Moves the data of the pages in use to the object uploaded from the file, unless
+  /// the file was written to since writeCount was taken. Returns the bytes moved.
+  size_t setColdObject(const std::string& key, const uint64_t expectedWriteCount);
+  /// Loads the pages in the cold storage, saved next to the file.
+  void loadColdPages();
+  // Reads the data of consecutive pages without taking readWriteMutex_, see
+  // File_Namespace::readPagesData.
+  size_t readPagesData(const size_t pageNum,
+                       const size_t headerSize,
+                       const size_t startOffset,
+                       const size_t size,
+                       int8_t* buf);
 
   void openExistingFile(std::vector<HeaderInfo>& headerVec, const int fileMgrEpoch);
   /// Prints a summary of the file to stdout
@@ -87,14 +121,8 @@ struct FileInfo {
   /// Returns the number of bytes used by the file
   inline size_t size() { return pageSize * numPages; }
 
-  inline int syncToDisk() {
-    fflush(f);
-#ifdef __APPLE__
-    return fcntl(fileno(f), 51);
-#else
-    return fsync(fileno(f));
-#endif
-  }
+  /// Also saves the pages in the cold storage, and removes the object once no page is.
+  int syncToDisk();
 
   /// Returns the number of free bytes available
   inline size_t available() { return freePages.size() * pageSize; }
@@ -107,6 +135,17 @@ struct FileInfo {
 
   /// Returns the amount of used bytes; size() - available()
   inline size_t used() { return size() - available(); }
+
+ private:
+  ColdStorage* getColdStorage() const;
+  std::string coldPagesPath() const;
+  /// Returns false if the pages couldn't be saved, requires coldMutex_.
+  bool saveColdPages();
+  /// Reads through the cold storage, requires coldMutex_.
+  void readCold(size_t offset, size_t size, int8_t* buf);
+  /// Brings the data of the remote pages in the range back into the file, requires
+  /// coldMutex_ exclusively.
+  void localizePages(const size_t offset, const size_t size);
 };
 }  // namespace File_Namespace
 
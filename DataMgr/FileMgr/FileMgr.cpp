@@ -26,12 +26,15 @@
 #include <boost/system/error_code.hpp>
 #include <string>
 #include "../Shared/measure.h"
+#include "ColdStorage.h"
 #include "File.h"
 #include "GlobalFileMgr.h"
+#include "HeaderIndex.h"
 
 #include <fcntl.h>
 #include <unistd.h>
 #include <algorithm>
+#include <ctime>
 #include <future>
 #include <thread>
 #include <utility>
@@ -42,6 +45,9 @@
 
 using namespace std;
 
+bool g_enable_mapped_chunks{false};
+bool g_enable_header_index{true};
+
 namespace File_Namespace {
 
 bool headerCompare(const HeaderInfo& firstElem, const HeaderInfo& secondElem) {
@@ -73,7 +79,9 @@ FileMgr::FileMgr(const int deviceId,
     , fileMgrKey_(fileMgrKey)
     , defaultPageSize_(defaultPageSize)
     , nextFileId_(0)
-    , epoch_(epoch) {
+    , epoch_(epoch)
+    , headerIndexOnDisk_(false)
+    , headerChanges_(0) {
   init(num_reader_threads);
 }
 
@@ -84,7 +92,9 @@ FileMgr::FileMgr(GlobalFileMgr* gfm, const size_t defaultPageSize, std::string b
     , fileMgrBasePath_(basePath)
     , defaultPageSize_(defaultPageSize)
     , nextFileId_(0)
-    , epoch_(-1) {
+    , epoch_(-1)
+    , headerIndexOnDisk_(false)
+    , headerChanges_(0) {
   init(basePath);
 }
 
@@ -130,6 +140,8 @@ void FileMgr::init(const size_t num_reader_threads) {
     int threadCount = std::thread::hardware_concurrency();
     std::vector<HeaderInfo> headerVec;
     std::vector<std::future<std::vector<HeaderInfo>>> file_futures;
+    std::vector<std::string> filePaths;
+    std::vector<HeaderIndexFile> dataFiles;
     for (boost::filesystem::directory_iterator fileIt(path); fileIt != endItr; ++fileIt) {
       if (boost::filesystem::is_regular_file(fileIt->status())) {
         // note that boost::filesystem leaves preceding dot on
@@ -160,27 +172,49 @@ void FileMgr::init(const size_t num_reader_threads) {
           VLOG(1) << "File id: " << fileId << " Page size: " << pageSize
                   << " Num pages: " << numPages;
 
-          file_futures.emplace_back(std::async(
-              std::launch::async, [filePath, fileId, pageSize, numPages, this] {
-                std::vector<HeaderInfo> tempHeaderVec;
-                openExistingFile(filePath, fileId, pageSize, numPages, tempHeaderVec);
-                return tempHeaderVec;
-              }));
-          fileCount++;
-          if (fileCount % threadCount == 0) {
-            processFileFutures(file_futures, headerVec);
-          }
+          filePaths.push_back(filePath);
+          dataFiles.push_back(HeaderIndexFile{fileId, pageSize, numPages});
         }
       }
     }
 
-    if (file_futures.size() > 0) {
-      processFileFutures(file_futures, headerVec);
+    const bool fromHeaderIndex =
+        g_enable_header_index &&
+        readHeaderIndex(fileMgrBasePath_, epoch_, dataFiles, headerVec);
+    if (fromHeaderIndex) {
+      openIndexedFiles(filePaths, dataFiles, headerVec);
+      fileCount = dataFiles.size();
+    } else {
+      // Reading the headers frees the pages which weren't checkpointed.
+      removeHeaderIndex(fileMgrBasePath_);
+      for (size_t i = 0; i < dataFiles.size(); ++i) {
+        const auto& filePath = filePaths[i];
+        const auto& dataFile = dataFiles[i];
+        file_futures.emplace_back(
+            std::async(std::launch::async, [filePath, dataFile, this] {
+              std::vector<HeaderInfo> tempHeaderVec;
+              openExistingFile(filePath,
+                               dataFile.fileId,
+                               dataFile.pageSize,
+                               dataFile.numPages,
+                               tempHeaderVec);
+              return tempHeaderVec;
+            }));
+        fileCount++;
+        if (fileCount % threadCount == 0) {
+          processFileFutures(file_futures, headerVec);
+        }
+      }
+
+      if (file_futures.size() > 0) {
+        processFileFutures(file_futures, headerVec);
+      }
     }
     int64_t queue_time_ms = timer_stop(clock_begin);
 
     LOG(INFO) << "Completed Reading table's file metadata, Elapsed time : "
               << queue_time_ms << "ms Epoch: " << epoch_ << " files read: " << fileCount
+              << (fromHeaderIndex ? " from the page header index" : "")
               << " table location: '" << fileMgrBasePath_ << "'";
 
     /* Sort headerVec so that all HeaderInfos
@@ -235,6 +269,17 @@ void FileMgr::init(const size_t num_reader_threads) {
       //}
     }
     nextFileId_ = maxFileId + 1;
+    if (fromHeaderIndex) {
+      headerIndexOnDisk_ = true;
+    } else if (g_enable_header_index) {
+      // The pages freed above must stay free when the index gets used.
+      for (auto file_info : files_) {
+        if (file_info && file_info->syncToDisk() != 0) {
+          LOG(FATAL) << "Could not sync file to disk";
+        }
+      }
+      writeHeaderIndex(headerVec, headerChanges_);
+    }
     // std::cout << "next file id: " << nextFileId_ << std::endl;
   } else {  // data directory does not exist
     // std::cout << basePath_ << " does not exist. Creating" << std::endl;
@@ -368,6 +413,7 @@ void FileMgr::init(const std::string dataPathToConvertFrom) {
           c_fm_->chunkIndex_[lastChunkKey] = destBuf;
           destBuf->syncEncoder(srcBuf);
           destBuf->setSize(srcBuf->size());
+          destBuf->compressedPageSizes_ = srcBuf->compressedPageSizes_;
           destBuf->setDirty();  // this needs to be set to force writing out metadata
                                 // files from "checkpoint()" call
 
@@ -399,6 +445,7 @@ void FileMgr::init(const std::string dataPathToConvertFrom) {
       c_fm_->chunkIndex_[lastChunkKey] = destBuf;
       destBuf->syncEncoder(srcBuf);
       destBuf->setSize(srcBuf->size());
+      destBuf->compressedPageSizes_ = srcBuf->compressedPageSizes_;
       destBuf->setDirty();  // this needs to be set to write out metadata file from the
                             // "checkpoint()" call
 
@@ -427,6 +474,13 @@ void FileMgr::init(const std::string dataPathToConvertFrom) {
 
 void FileMgr::closeRemovePhysical() {
   for (auto file_info : files_) {
+    if (!file_info->coldObject.empty()) {
+      try {
+        getColdStorage()->remove(file_info->coldObject);
+      } catch (const std::exception& e) {
+        LOG(WARNING) << e.what();
+      }
+    }
     if (file_info->f) {
       close(file_info->f);
       file_info->f = nullptr;
@@ -559,24 +613,43 @@ void FileMgr::writeAndSyncDBMetaToDisk() {
 }
 
 void FileMgr::checkpoint() {
-  // std::cout << "Checkpointing " << epoch_ <<  std::endl;
+  std::lock_guard<std::mutex> checkpointLock(checkpointMutex_);
   mapd_unique_lock<mapd_shared_mutex> chunkIndexWriteLock(chunkIndexMutex_);
-  for (auto chunkIt = chunkIndex_.begin(); chunkIt != chunkIndex_.end(); ++chunkIt) {
-    /*
-    for (auto vecIt = chunkIt->first.begin(); vecIt != chunkIt->first.end(); ++vecIt) {
-        std::cout << *vecIt << ",";
+  std::set<ChunkKey> dirtyChunks;
+  {
+    std::lock_guard<std::mutex> dirtyChunksLock(dirtyChunksMutex_);
+    dirtyChunks.swap(dirtyChunks_);
+  }
+  for (const auto& key : dirtyChunks) {
+    auto chunkIt = chunkIndex_.find(key);
+    // Dropped since it got dirty.
+    if (chunkIt == chunkIndex_.end()) {
+      continue;
     }
-    cout << "Is dirty: " << chunkIt->second->isDirty_ << endl;
-    */
     if (chunkIt->second->isDirty_) {
       chunkIt->second->writeMetadata(epoch_);
       chunkIt->second->clearDirtyBits();
     }
   }
+  // Replace the page header index if some page header changed since it was written.
+  bool updateHeaderIndex{false};
+  uint64_t headerChanges{0};
+  if (g_enable_header_index) {
+    std::lock_guard<std::mutex> headerIndexLock(headerIndexMutex_);
+    updateHeaderIndex = !headerIndexOnDisk_;
+    headerChanges = headerChanges_;
+  }
+  std::vector<HeaderInfo> headers;
+  if (updateHeaderIndex) {
+    headers = getHeaders();
+  }
   chunkIndexWriteLock.unlock();
 
   mapd_shared_lock<mapd_shared_mutex> read_lock(files_rw_mutex_);
   for (auto fileIt = files_.begin(); fileIt != files_.end(); ++fileIt) {
+    if (!(*fileIt)->isDirty) {
+      continue;
+    }
     int status = (*fileIt)->syncToDisk();
     if (status != 0) {
       LOG(FATAL) << "Could not sync file to disk";
@@ -590,6 +663,16 @@ void FileMgr::checkpoint() {
     free_page.first->freePageDeferred(free_page.second);
   }
   free_pages.clear();
+  freePagesWriteLock.unlock();
+
+  if (updateHeaderIndex) {
+    writeHeaderIndex(headers, headerChanges);
+  }
+}
+
+void FileMgr::addDirtyChunk(const ChunkKey& key) {
+  std::lock_guard<std::mutex> dirtyChunksLock(dirtyChunksMutex_);
+  dirtyChunks_.insert(key);
 }
 
 AbstractBuffer* FileMgr::createBuffer(const ChunkKey& key,
@@ -618,6 +701,7 @@ bool FileMgr::isBufferOnDevice(const ChunkKey& key) {
 }
 
 void FileMgr::deleteBuffer(const ChunkKey& key, const bool purge) {
+  dropMappedBuffers(key);
   mapd_unique_lock<mapd_shared_mutex> chunkIndexWriteLock(chunkIndexMutex_);
   auto chunkIt = chunkIndex_.find(key);
   // ensure the Chunk exists
@@ -635,6 +719,7 @@ void FileMgr::deleteBuffer(const ChunkKey& key, const bool purge) {
 }
 
 void FileMgr::deleteBuffersWithPrefix(const ChunkKey& keyPrefix, const bool purge) {
+  dropMappedBuffers(keyPrefix);
   mapd_unique_lock<mapd_shared_mutex> chunkIndexWriteLock(chunkIndexMutex_);
   auto chunkIt = chunkIndex_.lower_bound(keyPrefix);
   if (chunkIt == chunkIndex_.end()) {
@@ -711,6 +796,150 @@ void FileMgr::fetchBuffer(const ChunkKey& key,
   destBuffer->syncEncoder(chunk);
 }
 
+AbstractBuffer* FileMgr::getMappedBuffer(const ChunkKey& key, const size_t numBytes) {
+  mapd_shared_lock<mapd_shared_mutex> chunkIndexReadLock(chunkIndexMutex_);
+  auto chunkIt = chunkIndex_.find(key);
+  if (chunkIt == chunkIndex_.end()) {
+    return nullptr;
+  }
+  const FileBuffer* chunk = chunkIt->second;
+  // The page headers interleave with the data of chunks spanning several pages.
+  if (chunk->isDirty() || chunk->pageCount() != 1 || chunk->isPageCompressed(0) ||
+      chunk->size() == 0 || numBytes > chunk->size()) {
+    return nullptr;
+  }
+  const Page page = chunk->getMultiPage().front().current();
+  FileInfo* fileInfo = getFileInfoForFileId(page.fileId);
+  std::lock_guard<std::mutex> mappedBuffersLock(mappedBuffersMutex_);
+  {
+    // The data of the page isn't in the file.
+    mapd_shared_lock<mapd_shared_mutex> coldReadLock(fileInfo->coldMutex_);
+    if (fileInfo->isPageRemote(page.pageNum)) {
+      return nullptr;
+    }
+  }
+  retiredMappedBuffers_.erase(
+      std::remove_if(retiredMappedBuffers_.begin(),
+                     retiredMappedBuffers_.end(),
+                     [](const std::unique_ptr<MappedBuffer>& mappedBuffer) {
+                       return mappedBuffer->getPinCount() == 0;
+                     }),
+      retiredMappedBuffers_.end());
+  auto& mappedBuffer = mappedBuffers_[key];
+  if (!mappedBuffer || !mappedBuffer->matches(chunk, page)) {
+    retireMappedBuffer(mappedBuffer);
+    try {
+      mappedBuffer.reset(new MappedBuffer(chunk, fileInfo, page));
+    } catch (const std::runtime_error& e) {
+      LOG(WARNING) << e.what() << ", reading chunk " << showChunk(key) << " instead";
+      mappedBuffers_.erase(key);
+      return nullptr;
+    }
+  }
+  mappedBuffer->pin();
+  return mappedBuffer.get();
+}
+
+void FileMgr::retireMappedBuffer(std::unique_ptr<MappedBuffer>& mappedBuffer) {
+  if (mappedBuffer && mappedBuffer->getPinCount() > 0) {
+    retiredMappedBuffers_.push_back(std::move(mappedBuffer));
+  }
+  mappedBuffer.reset();
+}
+
+void FileMgr::dropMappedBuffers(const ChunkKey& keyPrefix) {
+  std::lock_guard<std::mutex> mappedBuffersLock(mappedBuffersMutex_);
+  auto mappedIt = mappedBuffers_.lower_bound(keyPrefix);
+  while (mappedIt != mappedBuffers_.end() &&
+         mappedIt->first.size() >= keyPrefix.size() &&
+         std::equal(keyPrefix.begin(), keyPrefix.end(), mappedIt->first.begin())) {
+    retireMappedBuffer(mappedIt->second);
+    mappedBuffers_.erase(mappedIt++);
+  }
+}
+
+bool FileMgr::dropFileMappedBuffers(const int fileId) {
+  for (const auto& mappedBuffer : retiredMappedBuffers_) {
+    if (mappedBuffer->getPage().fileId == fileId && mappedBuffer->getPinCount() > 0) {
+      return false;
+    }
+  }
+  for (const auto& mappedBuffer : mappedBuffers_) {
+    if (mappedBuffer.second && mappedBuffer.second->getPage().fileId == fileId &&
+        mappedBuffer.second->getPinCount() > 0) {
+      return false;
+    }
+  }
+  for (auto mappedIt = mappedBuffers_.begin(); mappedIt != mappedBuffers_.end();) {
+    if (mappedIt->second && mappedIt->second->getPage().fileId == fileId) {
+      mappedBuffers_.erase(mappedIt++);
+    } else {
+      ++mappedIt;
+    }
+  }
+  return true;
+}
+
+ColdStorage* FileMgr::getColdStorage() const {
+  return gfm_->getColdStorage();
+}
+
+size_t FileMgr::offloadColdFiles(const int64_t maxLastAccessTime) {
+  ColdStorage* coldStorage = getColdStorage();
+  if (!coldStorage) {
+    return 0;
+  }
+  std::vector<FileInfo*> coldFiles;
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(files_rw_mutex_);
+    for (auto file_info : files_) {
+      // The metadata pages are too small to keep their headers and punch out the rest.
+      if (!file_info || file_info->pageSize <= COLD_PAGE_PREFIX ||
+          file_info->pageSize % COLD_PAGE_PREFIX != 0 || file_info->isDirty ||
+          file_info->numRemotePages > 0 ||
+          file_info->lastAccessTime > maxLastAccessTime ||
+          file_info->numFreePages() == file_info->numPages) {
+        continue;
+      }
+      coldFiles.push_back(file_info);
+    }
+  }
+  size_t offloadedBytes = 0;
+  for (auto file_info : coldFiles) {
+    try {
+      offloadedBytes += offloadColdFile(file_info, coldStorage);
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Could not move data file " << file_info->fileId << " of table "
+                   << fileMgrBasePath_ << " to the cold storage: " << e.what();
+    }
+  }
+  return offloadedBytes;
+}
+
+size_t FileMgr::offloadColdFile(FileInfo* fileInfo, ColdStorage* coldStorage) {
+  // Any write from now on makes the upload useless.
+  const uint64_t writeCount = fileInfo->writeCount;
+  const auto fileName = std::to_string(fileInfo->fileId) + "." +
+                        std::to_string(fileInfo->pageSize) + MAPD_FILE_EXT;
+  // Unique, the object of the file may still be around from an earlier move.
+  const auto key = std::to_string(fileMgrKey_.first) + "_" +
+                   std::to_string(fileMgrKey_.second) + "/" + fileName + "." +
+                   std::to_string(epoch_) + "." + std::to_string(time(nullptr));
+  coldStorage->upload(key, fileMgrBasePath_ + fileName);
+  size_t offloadedBytes = 0;
+  {
+    // The views of the file would show the holes punched into it.
+    std::lock_guard<std::mutex> mappedBuffersLock(mappedBuffersMutex_);
+    if (dropFileMappedBuffers(fileInfo->fileId)) {
+      offloadedBytes = fileInfo->setColdObject(key, writeCount);
+    }
+  }
+  if (!offloadedBytes) {
+    coldStorage->remove(key);
+  }
+  return offloadedBytes;
+}
+
 AbstractBuffer* FileMgr::putBuffer(const ChunkKey& key,
                                    AbstractBuffer* srcBuffer,
                                    const size_t numBytes) {
@@ -767,6 +996,7 @@ void FileMgr::free(AbstractBuffer* buffer) {
 //}
 
 Page FileMgr::requestFreePage(size_t pageSize, const bool isMetadata) {
+  headerChanged();
   std::lock_guard<std::mutex> lock(getPageMutex_);
 
   auto candidateFiles = fileIndex_.equal_range(pageSize);
@@ -796,6 +1026,7 @@ void FileMgr::requestFreePages(size_t numPagesRequested,
                                const bool isMetadata) {
   // not used currently
   // @todo add method to FileInfo to get more than one page
+  headerChanged();
   std::lock_guard<std::mutex> lock(getPageMutex_);
   auto candidateFiles = fileIndex_.equal_range(pageSize);
   size_t numPagesNeeded = numPagesRequested;
@@ -844,6 +1075,7 @@ FileInfo* FileMgr::openExistingFile(const std::string& path,
   FileInfo* fInfo = new FileInfo(
       this, fileId, f, pageSize, numPages, false);  // false means don't init file
 
+  fInfo->loadColdPages();
   fInfo->openExistingFile(headerVec, epoch_);
   mapd_unique_lock<mapd_shared_mutex> write_lock(files_rw_mutex_);
   if (fileId >= static_cast<int>(files_.size())) {
@@ -854,6 +1086,102 @@ FileInfo* FileMgr::openExistingFile(const std::string& path,
   return fInfo;
 }
 
+FileInfo* FileMgr::openExistingFile(const std::string& path,
+                                    const int fileId,
+                                    const size_t pageSize,
+                                    const size_t numPages,
+                                    const std::vector<bool>& usedPages) {
+  FILE* f = open(path);
+  FileInfo* fInfo = new FileInfo(
+      this, fileId, f, pageSize, numPages, false);  // false means don't init file
+  fInfo->loadColdPages();
+  for (size_t pageNum = 0; pageNum < numPages; ++pageNum) {
+    if (!usedPages[pageNum]) {
+      fInfo->freePages.insert(pageNum);
+    }
+  }
+  mapd_unique_lock<mapd_shared_mutex> write_lock(files_rw_mutex_);
+  if (fileId >= static_cast<int>(files_.size())) {
+    files_.resize(fileId + 1);
+  }
+  files_[fileId] = fInfo;
+  fileIndex_.insert(std::pair<size_t, int>(pageSize, fileId));
+  return fInfo;
+}
+
+void FileMgr::openIndexedFiles(const std::vector<std::string>& filePaths,
+                               const std::vector<HeaderIndexFile>& dataFiles,
+                               std::vector<HeaderInfo>& headerVec) {
+  std::map<int, std::vector<bool>> usedPages;
+  for (const auto& dataFile : dataFiles) {
+    usedPages[dataFile.fileId].resize(dataFile.numPages, false);
+  }
+  for (auto& header : headerVec) {
+    // always derive dbid/tbid from FileMgr, same as when reading the headers
+    header.chunkKey[0] = fileMgrKey_.first;
+    header.chunkKey[1] = fileMgrKey_.second;
+    usedPages[header.page.fileId][header.page.pageNum] = true;
+  }
+  for (size_t i = 0; i < dataFiles.size(); ++i) {
+    const auto& dataFile = dataFiles[i];
+    openExistingFile(filePaths[i],
+                     dataFile.fileId,
+                     dataFile.pageSize,
+                     dataFile.numPages,
+                     usedPages[dataFile.fileId]);
+  }
+}
+
+void FileMgr::headerChanged() {
+  std::lock_guard<std::mutex> headerIndexLock(headerIndexMutex_);
+  ++headerChanges_;
+  if (headerIndexOnDisk_) {
+    removeHeaderIndex(fileMgrBasePath_);
+    headerIndexOnDisk_ = false;
+  }
+}
+
+std::vector<HeaderInfo> FileMgr::getHeaders() const {
+  std::vector<HeaderInfo> headers;
+  for (const auto& chunk : chunkIndex_) {
+    const FileBuffer* buffer = chunk.second;
+    const auto& metadataPages = buffer->metadataPages_;
+    for (size_t i = 0; i < metadataPages.pageVersions.size(); ++i) {
+      headers.emplace_back(
+          chunk.first, -1, metadataPages.epochs[i], metadataPages.pageVersions[i]);
+    }
+    for (size_t pageId = 0; pageId < buffer->multiPages_.size(); ++pageId) {
+      const auto& multiPage = buffer->multiPages_[pageId];
+      for (size_t i = 0; i < multiPage.pageVersions.size(); ++i) {
+        headers.emplace_back(
+            chunk.first, pageId, multiPage.epochs[i], multiPage.pageVersions[i]);
+      }
+    }
+  }
+  return headers;
+}
+
+void FileMgr::writeHeaderIndex(const std::vector<HeaderInfo>& headers,
+                               const uint64_t headerChanges) {
+  std::lock_guard<std::mutex> headerIndexLock(headerIndexMutex_);
+  // Some header changed after the headers were collected.
+  if (headerChanges != headerChanges_) {
+    return;
+  }
+  std::vector<HeaderIndexFile> dataFiles;
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(files_rw_mutex_);
+    for (const auto file_info : files_) {
+      if (file_info) {
+        dataFiles.push_back(
+            HeaderIndexFile{file_info->fileId, file_info->pageSize, file_info->numPages});
+      }
+    }
+  }
+  headerIndexOnDisk_ =
+      File_Namespace::writeHeaderIndex(fileMgrBasePath_, epoch_, dataFiles, headers);
+}
+
 FileInfo* FileMgr::createFile(const size_t pageSize, const size_t numPages) {
   // check arguments
   if (pageSize == 0 || numPages == 0) {
@@ -29,6 +29,7 @@
 #include <future>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <vector>
@@ -38,12 +39,23 @@
 #include "../Shared/mapd_shared_mutex.h"
 #include "FileBuffer.h"
 #include "FileInfo.h"
+#include "HeaderIndex.h"
+#include "MappedBuffer.h"
 #include "Page.h"
 
 using namespace Data_Namespace;
 
+// Serve the single page chunks the query engine reads from the CPU level as read-only
+// views mapped from the data files, instead of copying them in the CPU buffer pool.
+extern bool g_enable_mapped_chunks;
+
+// Load the page headers of the tables from the index written at checkpoints instead of
+// reading them from all the data files, when the index is still valid.
+extern bool g_enable_header_index;
+
 namespace File_Namespace {
 
+class ColdStorage;
 class GlobalFileMgr;  // forward declaration
                       /**
                        * @type PageSizeFileMMap
@@ -122,6 +134,14 @@ class FileMgr : public AbstractBufferMgr {  // implements
                            AbstractBuffer* destBuffer,
                            const size_t numBytes);
 
+  /**
+   * @brief Returns a pinned, read-only view of the chunk mapped from its data file.
+   *
+   * Returns nullptr if the chunk doesn't exist, has unflushed changes or spans more
+   * than one page, the caller then has to fetch it into a buffer of its own.
+   */
+  AbstractBuffer* getMappedBuffer(const ChunkKey& key, const size_t numBytes);
+
   /**
    * @brief Puts the contents of d into the Chunk with the given key.
    * @param key - Unique identifier for a Chunk.
@@ -227,8 +247,22 @@ class FileMgr : public AbstractBufferMgr {  // implements
   void closeRemovePhysical();
 
   void free_page(std::pair<FileInfo*, int>&& page);
+
+  /// Records a chunk with changes to be written out by the next checkpoint.
+  void addDirtyChunk(const ChunkKey& key);
+
+  /// Must be called before a page header changes on disk, so the page header index is
+  /// dropped before it gets stale.
+  void headerChanged();
   const std::pair<const int, const int> get_fileMgrKey() const { return fileMgrKey_; }
 
+  /// The cold storage of the data files, nullptr unless configured.
+  ColdStorage* getColdStorage() const;
+
+  /// Moves the data files not read or written to since maxLastAccessTime and synced
+  /// since to the cold storage. Returns the bytes moved.
+  size_t offloadColdFiles(const int64_t maxLastAccessTime);
+
  private:
   GlobalFileMgr* gfm_;  /// Global FileMgr
   std::pair<const int, const int> fileMgrKey_;
@@ -252,6 +286,38 @@ class FileMgr : public AbstractBufferMgr {  // implements
   mutable mapd_shared_mutex mutex_free_page;
   std::vector<std::pair<FileInfo*, int>> free_pages;
 
+  std::mutex checkpointMutex_;
+  std::mutex dirtyChunksMutex_;
+  std::set<ChunkKey> dirtyChunks_;
+
+  /// Views handed out by getMappedBuffer; the ones which got stale while pinned are
+  /// kept around until they are unpinned.
+  std::mutex mappedBuffersMutex_;
+  std::map<ChunkKey, std::unique_ptr<MappedBuffer>> mappedBuffers_;
+  std::vector<std::unique_ptr<MappedBuffer>> retiredMappedBuffers_;
+
+  void retireMappedBuffer(std::unique_ptr<MappedBuffer>& mappedBuffer);
+  void dropMappedBuffers(const ChunkKey& keyPrefix);
+  /// Drops the views of the file unless some is pinned, requires mappedBuffersMutex_.
+  bool dropFileMappedBuffers(const int fileId);
+
+  size_t offloadColdFile(FileInfo* fileInfo, ColdStorage* coldStorage);
+
+  /// Whether the page header index in the table directory matches the data files, and
+  /// the number of header changes so far.
+  std::mutex headerIndexMutex_;
+  bool headerIndexOnDisk_;
+  uint64_t headerChanges_;
+
+  /// Returns the headers of all the pages of the chunks.
+  std::vector<HeaderInfo> getHeaders() const;
+  /// Writes the page header index unless some header changed since headerChanges.
+  void writeHeaderIndex(const std::vector<HeaderInfo>& headers,
+                        const uint64_t headerChanges);
+  void openIndexedFiles(const std::vector<std::string>& filePaths,
+                        const std::vector<HeaderIndexFile>& dataFiles,
+                        std::vector<HeaderInfo>& headerVec);
+
   /**
    * @brief Adds a file to the file manager repository.
    *
@@ -274,6 +340,12 @@ class FileMgr : public AbstractBufferMgr {  // implements
                              const size_t pageSize,
                              const size_t numPages,
                              std::vector<HeaderInfo>& headerVec);
+  /// Opens a file known from the page header index, all the pages not in use are free.
+  FileInfo* openExistingFile(const std::string& path,
+                             const int fileId,
+                             const size_t pageSize,
+                             const size_t numPages,
+                             const std::vector<bool>& usedPages);
   void createEpochFile(const std::string& epochFileName);
   void openEpochFile(const std::string& epochFileName);
   void writeAndSyncEpochToDisk();
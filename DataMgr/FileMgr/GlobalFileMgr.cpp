@@ -29,6 +29,9 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <future>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -47,14 +50,20 @@ GlobalFileMgr::GlobalFileMgr(const int deviceId,
     , epoch_(-1)
     ,  // set the default epoch for all tables corresponding to the time of
        // last checkpoint
-    defaultPageSize_(defaultPageSize) {
+    defaultPageSize_(defaultPageSize)
+    , openCheckpointBatch_(1)
+    , completedCheckpointBatch_(0)
+    , checkpointInProgress_(false)
+    , stopColdStorage_(false) {
   mapd_db_version_ =
       1;  // DS changes triggered by individual FileMgr per table project (release 2.1.0)
   dbConvert_ = false;
   init();
+  initColdStorage();
 }
 
 GlobalFileMgr::~GlobalFileMgr() {
+  stopColdStorageThread();
   mapd_lock_guard<mapd_shared_mutex> fileMgrsMutex(fileMgrs_mutex_);
   for (auto fileMgrsIt = fileMgrs_.begin(); fileMgrsIt != fileMgrs_.end(); ++fileMgrsIt) {
     delete fileMgrsIt->second;
@@ -78,15 +87,123 @@ void GlobalFileMgr::init() {
   }
 }
 
+void GlobalFileMgr::initColdStorage() {
+  if (g_cold_storage_url.empty()) {
+    return;
+  }
+  std::unique_ptr<ObjectStore> store;
+  try {
+    store = create_object_store(g_cold_storage_url, g_cold_storage_endpoint);
+  } catch (const std::exception& e) {
+    LOG(FATAL) << "Could not set up the cold storage at " << g_cold_storage_url << ": "
+               << e.what();
+  }
+  const auto cachePath = g_cold_storage_cache_path.empty() ? basePath_ + "cold_cache"
+                                                           : g_cold_storage_cache_path;
+  coldStorage_.reset(
+      new ColdStorage(std::move(store), cachePath, g_cold_storage_cache_bytes));
+  LOG(INFO) << "Moving the data files untouched for " << g_cold_file_age_seconds
+            << " seconds to " << g_cold_storage_url << ", read cache in " << cachePath;
+  coldStorageThread_ = std::thread([this] {
+    const auto interval = std::chrono::seconds(
+        std::max<size_t>(1, std::min<size_t>(g_cold_file_age_seconds, 600)));
+    std::unique_lock<std::mutex> lock(coldStorageMutex_);
+    const auto stopped = [this] { return stopColdStorage_; };
+    while (!coldStorageCv_.wait_for(lock, interval, stopped)) {
+      lock.unlock();
+      offloadColdFiles();
+      lock.lock();
+    }
+  });
+}
+
+void GlobalFileMgr::stopColdStorageThread() {
+  if (!coldStorageThread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(coldStorageMutex_);
+    stopColdStorage_ = true;
+  }
+  coldStorageCv_.notify_all();
+  coldStorageThread_.join();
+}
+
+size_t GlobalFileMgr::offloadColdFiles() {
+  if (!coldStorage_) {
+    return 0;
+  }
+  const int64_t maxLastAccessTime = time(nullptr) - g_cold_file_age_seconds;
+  std::vector<std::pair<int, int>> fileMgrKeys;
+  {
+    mapd_shared_lock<mapd_shared_mutex> fileMgrsMutex(fileMgrs_mutex_);
+    for (const auto& fileMgr : fileMgrs_) {
+      fileMgrKeys.push_back(fileMgr.first);
+    }
+  }
+  size_t offloadedBytes = 0;
+  for (const auto& fileMgrKey : fileMgrKeys) {
+    // Keeps the table from being dropped meanwhile.
+    mapd_shared_lock<mapd_shared_mutex> fileMgrsMutex(fileMgrs_mutex_);
+    auto fileMgrIt = fileMgrs_.find(fileMgrKey);
+    if (fileMgrIt != fileMgrs_.end()) {
+      offloadedBytes += fileMgrIt->second->offloadColdFiles(maxLastAccessTime);
+    }
+  }
+  if (offloadedBytes) {
+    LOG(INFO) << "Moved " << offloadedBytes << " bytes of data files to the cold storage";
+  }
+  return offloadedBytes;
+}
+
 void GlobalFileMgr::checkpoint() {
   mapd_lock_guard<mapd_shared_mutex> fileMgrsMutex(fileMgrs_mutex_);
+  std::vector<FileMgr*> fileMgrs;
   for (auto fileMgrsIt = fileMgrs_.begin(); fileMgrsIt != fileMgrs_.end(); ++fileMgrsIt) {
-    fileMgrsIt->second->checkpoint();
+    fileMgrs.push_back(fileMgrsIt->second);
   }
+  checkpointFileMgrs(fileMgrs);
 }
 
 void GlobalFileMgr::checkpoint(const int db_id, const int tb_id) {
-  getFileMgr(db_id, tb_id)->checkpoint();
+  FileMgr* fileMgr = getFileMgr(db_id, tb_id);
+  std::unique_lock<std::mutex> batchLock(checkpointBatchMutex_);
+  const auto batch = openCheckpointBatch_;
+  pendingCheckpoints_.insert(fileMgr);
+  while (completedCheckpointBatch_ < batch) {
+    if (checkpointInProgress_) {
+      checkpointBatchCv_.wait(batchLock);
+      continue;
+    }
+    // Write out the whole batch, the later requests go into the next one.
+    checkpointInProgress_ = true;
+    const std::vector<FileMgr*> fileMgrs(pendingCheckpoints_.begin(),
+                                         pendingCheckpoints_.end());
+    pendingCheckpoints_.clear();
+    ++openCheckpointBatch_;
+    batchLock.unlock();
+    checkpointFileMgrs(fileMgrs);
+    batchLock.lock();
+    checkpointInProgress_ = false;
+    completedCheckpointBatch_ = batch;
+    checkpointBatchCv_.notify_all();
+  }
+}
+
+void GlobalFileMgr::checkpointFileMgrs(const std::vector<FileMgr*>& fileMgrs) {
+  if (fileMgrs.size() == 1) {
+    fileMgrs.front()->checkpoint();
+    return;
+  }
+  // The tables have files of their own, sync them concurrently.
+  std::vector<std::future<void>> checkpoints;
+  for (auto fileMgr : fileMgrs) {
+    checkpoints.push_back(
+        std::async(std::launch::async, [fileMgr] { fileMgr->checkpoint(); }));
+  }
+  for (auto& checkpoint : checkpoints) {
+    checkpoint.get();
+  }
 }
 
 size_t GlobalFileMgr::getNumChunks() {
@@ -185,6 +302,27 @@ void GlobalFileMgr::writeFileMgrData(
   }
 }
 
+void GlobalFileMgr::registerForeignStorage(
+    const int db_id,
+    const int tb_id,
+    std::shared_ptr<ForeignStorageInterface> foreignStorage) {
+  mapd_lock_guard<mapd_shared_mutex> write_lock(fileMgrs_mutex_);
+  foreignStorages_[std::make_pair(db_id, tb_id)] = foreignStorage;
+}
+
+void GlobalFileMgr::unregisterForeignStorage(const int db_id, const int tb_id) {
+  mapd_lock_guard<mapd_shared_mutex> write_lock(fileMgrs_mutex_);
+  foreignStorages_.erase(std::make_pair(db_id, tb_id));
+}
+
+std::shared_ptr<ForeignStorageInterface> GlobalFileMgr::findForeignStorage(
+    const int db_id,
+    const int tb_id) {
+  mapd_shared_lock<mapd_shared_mutex> read_lock(fileMgrs_mutex_);
+  const auto it = foreignStorages_.find(std::make_pair(db_id, tb_id));
+  return it == foreignStorages_.end() ? nullptr : it->second;
+}
+
 void GlobalFileMgr::removeTableRelatedDS(const int db_id, const int tb_id) {
   FileMgr* fm = findFileMgr(db_id, tb_id, true);
   if (fm == nullptr) {
@@ -26,14 +26,19 @@
 #ifndef DATAMGR_MEMORY_FILE_GLOBAL_FILEMGR_H
 #define DATAMGR_MEMORY_FILE_GLOBAL_FILEMGR_H
 
+#include <condition_variable>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <set>
+#include <thread>
 #include "../Shared/mapd_shared_mutex.h"
 
 #include "../AbstractBuffer.h"
 #include "../AbstractBufferMgr.h"
+#include "../ForeignStorageInterface.h"
+#include "ColdStorage.h"
 #include "FileMgr.h"
 
 using namespace Data_Namespace;
@@ -86,9 +91,17 @@ class GlobalFileMgr : public AbstractBufferMgr {  // implements
   virtual void fetchBuffer(const ChunkKey& key,
                            AbstractBuffer* destBuffer,
                            const size_t numBytes) {
+    const auto foreignStorage = findForeignStorage(key[0], key[1]);
+    if (foreignStorage) {
+      return foreignStorage->read(key, destBuffer, numBytes);
+    }
     return getFileMgr(key)->fetchBuffer(key, destBuffer, numBytes);
   }
 
+  virtual bool isForeignBuffer(const ChunkKey& key) {
+    return key[0] != -1 && findForeignStorage(key[0], key[1]) != nullptr;
+  }
+
   /**
    * @brief Puts the contents of d into the Chunk with the given key.
    * @param key - Unique identifier for a Chunk.
@@ -162,6 +175,18 @@ class GlobalFileMgr : public AbstractBufferMgr {  // implements
   void setTableEpoch(const int db_id, const int tb_id, const int start_epoch);
   size_t getTableEpoch(const int db_id, const int tb_id);
 
+  /// The chunks of the table are read from the storage from now on, until it is
+  /// unregistered, rather than from its data files.
+  void registerForeignStorage(const int db_id,
+                              const int tb_id,
+                              std::shared_ptr<ForeignStorageInterface> foreignStorage);
+  void unregisterForeignStorage(const int db_id, const int tb_id);
+
+  ColdStorage* getColdStorage() const { return coldStorage_.get(); }
+  /// Moves the data files nobody touched for g_cold_file_age_seconds to the cold
+  /// storage, as a background thread does periodically. Returns the bytes moved.
+  size_t offloadColdFiles();
+
  private:
   std::string basePath_;       /// The OS file system path containing the files.
   size_t num_reader_threads_;  /// number of threads used when loading data
@@ -181,6 +206,33 @@ class GlobalFileMgr : public AbstractBufferMgr {  // implements
                     /// "mapd_db_version_"
   std::map<std::pair<int, int>, FileMgr*> fileMgrs_;
   mapd_shared_mutex fileMgrs_mutex_;
+  std::map<std::pair<int, int>, std::shared_ptr<ForeignStorageInterface>>
+      foreignStorages_;  // guarded by fileMgrs_mutex_
+
+  std::shared_ptr<ForeignStorageInterface> findForeignStorage(const int db_id,
+                                                              const int tb_id);
+
+  /* Table checkpoints requested while another batch is being written are grouped in
+   * the next batch, which is written by the first of its requesters once the previous
+   * batch completes.
+   */
+  std::mutex checkpointBatchMutex_;
+  std::condition_variable checkpointBatchCv_;
+  std::set<FileMgr*> pendingCheckpoints_;
+  uint64_t openCheckpointBatch_;
+  uint64_t completedCheckpointBatch_;
+  bool checkpointInProgress_;
+
+  void checkpointFileMgrs(const std::vector<FileMgr*>& fileMgrs);
+
+  std::unique_ptr<ColdStorage> coldStorage_;
+  std::mutex coldStorageMutex_;
+  std::condition_variable coldStorageCv_;
+  bool stopColdStorage_;
+  std::thread coldStorageThread_;
+
+  void initColdStorage();
+  void stopColdStorageThread();
 };
 
 }  // namespace File_Namespace
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HeaderIndex.h"
+
+#include <fcntl.h>
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace File_Namespace {
+
+namespace {
+
+const std::string HEADER_INDEX_FILENAME{"header_index"};
+const uint64_t HEADER_INDEX_MAGIC{0x584449484450414DULL};  // MAPDHIDX
+const uint32_t HEADER_INDEX_VERSION{1};
+
+std::string index_path(const std::string& dirPath) {
+  return dirPath + HEADER_INDEX_FILENAME;
+}
+
+uint32_t checksum(const int8_t* data, const size_t size) {
+  boost::crc_32_type crc;
+  crc.process_bytes(data, size);
+  return crc.checksum();
+}
+
+template <class T>
+void put(std::vector<int8_t>& buf, const T val) {
+  const auto ptr = reinterpret_cast<const int8_t*>(&val);
+  buf.insert(buf.end(), ptr, ptr + sizeof(val));
+}
+
+class Reader {
+ public:
+  Reader(const int8_t* data, const size_t size) : data_(data), size_(size), pos_(0) {}
+
+  template <class T>
+  bool get(T& val) {
+    if (size_ - pos_ < sizeof(val)) {
+      return false;
+    }
+    memcpy(&val, data_ + pos_, sizeof(val));
+    pos_ += sizeof(val);
+    return true;
+  }
+
+  bool atEnd() const { return pos_ == size_; }
+
+ private:
+  const int8_t* data_;
+  const size_t size_;
+  size_t pos_;
+};
+
+bool parse_index(const int8_t* data,
+                 const size_t size,
+                 const int epoch,
+                 std::vector<HeaderIndexFile> files,
+                 std::vector<HeaderInfo>& headers) {
+  if (size < sizeof(uint32_t)) {
+    return false;
+  }
+  const size_t payloadSize = size - sizeof(uint32_t);
+  uint32_t storedChecksum;
+  memcpy(&storedChecksum, data + payloadSize, sizeof(storedChecksum));
+  if (storedChecksum != checksum(data, payloadSize)) {
+    LOG(WARNING) << "Checksum mismatch";
+    return false;
+  }
+  Reader reader(data, payloadSize);
+  uint64_t magic;
+  uint32_t version;
+  int indexEpoch;
+  uint32_t numFiles;
+  if (!reader.get(magic) || magic != HEADER_INDEX_MAGIC || !reader.get(version) ||
+      version != HEADER_INDEX_VERSION || !reader.get(indexEpoch) ||
+      !reader.get(numFiles)) {
+    return false;
+  }
+  // The epoch can move on at checkpoints which don't change any page header.
+  if (indexEpoch > epoch) {
+    LOG(WARNING) << "Written at epoch " << indexEpoch << ", table epoch is " << epoch;
+    return false;
+  }
+  std::vector<HeaderIndexFile> indexFiles(numFiles);
+  for (auto& indexFile : indexFiles) {
+    uint64_t pageSize;
+    uint64_t numPages;
+    if (!reader.get(indexFile.fileId) || !reader.get(pageSize) ||
+        !reader.get(numPages)) {
+      return false;
+    }
+    indexFile.pageSize = pageSize;
+    indexFile.numPages = numPages;
+  }
+  const auto byFileId = [](const HeaderIndexFile& lhs, const HeaderIndexFile& rhs) {
+    return lhs.fileId < rhs.fileId;
+  };
+  std::sort(files.begin(), files.end(), byFileId);
+  std::sort(indexFiles.begin(), indexFiles.end(), byFileId);
+  if (files != indexFiles) {
+    LOG(WARNING) << "Data files changed";
+    return false;
+  }
+  uint64_t numChunks;
+  if (!reader.get(numChunks)) {
+    return false;
+  }
+  for (uint64_t chunk = 0; chunk < numChunks; ++chunk) {
+    uint32_t keySize;
+    if (!reader.get(keySize) || keySize == 0 || keySize > payloadSize) {
+      return false;
+    }
+    ChunkKey chunkKey(keySize);
+    for (auto& keyElem : chunkKey) {
+      if (!reader.get(keyElem)) {
+        return false;
+      }
+    }
+    uint32_t numPages;
+    if (!reader.get(numPages)) {
+      return false;
+    }
+    for (uint32_t i = 0; i < numPages; ++i) {
+      int pageId;
+      int versionEpoch;
+      int fileId;
+      uint64_t pageNum;
+      if (!reader.get(pageId) || !reader.get(versionEpoch) || !reader.get(fileId) ||
+          !reader.get(pageNum)) {
+        return false;
+      }
+      const auto fileIt = std::lower_bound(
+          files.begin(), files.end(), HeaderIndexFile{fileId, 0, 0}, byFileId);
+      if (fileIt == files.end() || fileIt->fileId != fileId ||
+          pageNum >= fileIt->numPages || versionEpoch >= indexEpoch) {
+        return false;
+      }
+      headers.emplace_back(chunkKey, pageId, versionEpoch, Page(fileId, pageNum));
+    }
+  }
+  return reader.atEnd();
+}
+
+void sync_dir(const std::string& dirPath) {
+  const int fd = ::open(dirPath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(WARNING) << "Could not open " << dirPath << ": " << strerror(errno);
+    return;
+  }
+  if (fsync(fd)) {
+    LOG(WARNING) << "Could not sync " << dirPath << ": " << strerror(errno);
+  }
+  ::close(fd);
+}
+
+}  // namespace
+
+bool writeHeaderIndex(const std::string& dirPath,
+                      const int epoch,
+                      const std::vector<HeaderIndexFile>& files,
+                      const std::vector<HeaderInfo>& headers) {
+  std::vector<int8_t> buf;
+  put(buf, HEADER_INDEX_MAGIC);
+  put(buf, HEADER_INDEX_VERSION);
+  put(buf, epoch);
+  put(buf, static_cast<uint32_t>(files.size()));
+  for (const auto& file : files) {
+    put(buf, file.fileId);
+    put(buf, static_cast<uint64_t>(file.pageSize));
+    put(buf, static_cast<uint64_t>(file.numPages));
+  }
+  // The headers of a chunk are next to each other, its key is only written once.
+  const size_t numChunksPos = buf.size();
+  uint64_t numChunks = 0;
+  put(buf, numChunks);
+  for (auto chunkBegin = headers.begin(); chunkBegin != headers.end();) {
+    const auto chunkEnd =
+        std::find_if(chunkBegin, headers.end(), [&chunkBegin](const HeaderInfo& header) {
+          return header.chunkKey != chunkBegin->chunkKey;
+        });
+    put(buf, static_cast<uint32_t>(chunkBegin->chunkKey.size()));
+    for (const auto keyElem : chunkBegin->chunkKey) {
+      put(buf, keyElem);
+    }
+    put(buf, static_cast<uint32_t>(chunkEnd - chunkBegin));
+    for (auto it = chunkBegin; it != chunkEnd; ++it) {
+      CHECK_LT(it->versionEpoch, epoch);
+      put(buf, it->pageId);
+      put(buf, it->versionEpoch);
+      put(buf, it->page.fileId);
+      put(buf, static_cast<uint64_t>(it->page.pageNum));
+    }
+    ++numChunks;
+    chunkBegin = chunkEnd;
+  }
+  memcpy(&buf[numChunksPos], &numChunks, sizeof(numChunks));
+  put(buf, checksum(buf.data(), buf.size()));
+
+  const auto path = index_path(dirPath);
+  const auto tmpPath = path + ".tmp";
+  FILE* f = fopen(tmpPath.c_str(), "wb");
+  if (!f) {
+    LOG(WARNING) << "Could not create " << tmpPath << ": " << strerror(errno);
+    return false;
+  }
+  const bool written = fwrite(buf.data(), 1, buf.size(), f) == buf.size() &&
+                       fflush(f) == 0 && fsync(fileno(f)) == 0;
+  fclose(f);
+  if (!written || rename(tmpPath.c_str(), path.c_str())) {
+    LOG(WARNING) << "Could not write " << path << ": " << strerror(errno);
+    unlink(tmpPath.c_str());
+    return false;
+  }
+  sync_dir(dirPath);
+  return true;
+}
+
+bool readHeaderIndex(const std::string& dirPath,
+                     const int epoch,
+                     const std::vector<HeaderIndexFile>& files,
+                     std::vector<HeaderInfo>& headers) {
+  const auto path = index_path(dirPath);
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  const size_t size = st.st_size;
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    LOG(WARNING) << "Could not map " << path << ": " << strerror(errno);
+    return false;
+  }
+  madvise(data, size, MADV_SEQUENTIAL);
+  const bool parsed =
+      parse_index(static_cast<const int8_t*>(data), size, epoch, files, headers);
+  munmap(data, size);
+  if (!parsed) {
+    LOG(WARNING) << "Ignoring the page header index " << path;
+    headers.clear();
+  }
+  return parsed;
+}
+
+bool headerIndexExists(const std::string& dirPath) {
+  return access(index_path(dirPath).c_str(), F_OK) == 0;
+}
+
+void removeHeaderIndex(const std::string& dirPath) {
+  const auto path = index_path(dirPath);
+  if (unlink(path.c_str())) {
+    if (errno != ENOENT) {
+      LOG(FATAL) << "Could not remove " << path << ": " << strerror(errno);
+    }
+    return;
+  }
+  sync_dir(dirPath);
+}
+
+}  // namespace File_Namespace
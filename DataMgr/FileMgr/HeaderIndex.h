@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    HeaderIndex.h
+ * @brief   Persistent index of the page headers of the data files of a table.
+ *
+ * Opening a table normally reads the header of every page of its data files. The
+ * index keeps the headers of all the pages in use in a single file, so they can be
+ * loaded at once instead. It is only valid as long as no page header changed since it
+ * was written: FileMgr removes it before the first change and writes a new one at the
+ * next checkpoint.
+ */
+
+#ifndef DATAMGR_FILE_HEADERINDEX_H
+#define DATAMGR_FILE_HEADERINDEX_H
+
+#include <string>
+#include <vector>
+
+#include "Page.h"
+
+namespace File_Namespace {
+
+struct HeaderIndexFile {
+  int fileId;
+  size_t pageSize;
+  size_t numPages;
+
+  bool operator==(const HeaderIndexFile& other) const {
+    return fileId == other.fileId && pageSize == other.pageSize &&
+           numPages == other.numPages;
+  }
+};
+
+/**
+ * @brief Writes the index of the headers to the directory of the table, replacing the
+ * previous index atomically.
+ *
+ * @param dirPath The directory of the table.
+ * @param epoch The epoch of the table, which must be greater than the epoch of every
+ * page in the index.
+ * @param files The data files of the table.
+ * @param headers The headers of the pages in use, any other page of the files is free.
+ * @return bool Whether the index got written.
+ */
+bool writeHeaderIndex(const std::string& dirPath,
+                      const int epoch,
+                      const std::vector<HeaderIndexFile>& files,
+                      const std::vector<HeaderInfo>& headers);
+
+/**
+ * @brief Loads the index of the headers into headers.
+ *
+ * @return bool False if the index is missing, corrupt, written at a later epoch or for
+ * another set of data files, in which case the headers have to be read from the files.
+ */
+bool readHeaderIndex(const std::string& dirPath,
+                     const int epoch,
+                     const std::vector<HeaderIndexFile>& files,
+                     std::vector<HeaderInfo>& headers);
+
+bool headerIndexExists(const std::string& dirPath);
+
+/// Removes the index, returning once the removal is durable.
+void removeHeaderIndex(const std::string& dirPath);
+
+}  // namespace File_Namespace
+
+#endif  // DATAMGR_FILE_HEADERINDEX_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MappedBuffer.h"
+
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace File_Namespace {
+
+MappedBuffer::MappedBuffer(const FileBuffer* fileBuffer,
+                           FileInfo* fileInfo,
+                           const Page& page)
+    : AbstractBuffer(0)
+    , page_(page)
+    , pageSize_(fileBuffer->pageSize())
+    , mapping_(nullptr)
+    , mappingSize_(0)
+    , data_(nullptr)
+    , pinCount_(0) {
+  CHECK_EQ(fileInfo->pageSize, pageSize_);
+  CHECK_LE(fileBuffer->size(), fileBuffer->pageDataSize());
+  const size_t dataOffset = page.pageNum * pageSize_ + fileBuffer->reservedHeaderSize();
+  // The mapping has to start at a multiple of the OS page size.
+  const size_t osPageSize = sysconf(_SC_PAGESIZE);
+  const size_t mappingOffset = dataOffset / osPageSize * osPageSize;
+  mappingSize_ = dataOffset - mappingOffset + fileBuffer->size();
+  void* mapping = mmap(
+      nullptr, mappingSize_, PROT_READ, MAP_SHARED, fileno(fileInfo->f), mappingOffset);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("Could not map chunk page: " +
+                             std::string(strerror(errno)));
+  }
+  mapping_ = static_cast<int8_t*>(mapping);
+  data_ = mapping_ + (dataOffset - mappingOffset);
+  size_ = fileBuffer->size();
+  syncEncoder(fileBuffer);
+}
+
+MappedBuffer::~MappedBuffer() {
+  CHECK_EQ(pinCount_, 0);
+  munmap(mapping_, mappingSize_);
+}
+
+void MappedBuffer::read(int8_t* const dst,
+                        const size_t numBytes,
+                        const size_t offset,
+                        const MemoryLevel dstBufferType,
+                        const int dstDeviceId) {
+  if (dstBufferType != CPU_LEVEL) {
+    LOG(FATAL) << "Unsupported Buffer type";
+  }
+  CHECK_LE(offset + numBytes, size_);
+  memcpy(dst, data_ + offset, numBytes);
+}
+
+void MappedBuffer::write(int8_t* src,
+                         const size_t numBytes,
+                         const size_t offset,
+                         const MemoryLevel srcBufferType,
+                         const int srcDeviceId) {
+  LOG(FATAL) << "Mapped chunks are read-only";
+}
+
+void MappedBuffer::reserve(size_t numBytes) {
+  LOG(FATAL) << "Mapped chunks are read-only";
+}
+
+void MappedBuffer::append(int8_t* src,
+                          const size_t numBytes,
+                          const MemoryLevel srcBufferType,
+                          const int deviceId) {
+  LOG(FATAL) << "Mapped chunks are read-only";
+}
+
+bool MappedBuffer::matches(const FileBuffer* fileBuffer, const Page& page) const {
+  return page.fileId == page_.fileId && page.pageNum == page_.pageNum &&
+         fileBuffer->size() == size_;
+}
+
+}  // namespace File_Namespace
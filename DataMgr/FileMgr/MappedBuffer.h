@@ -0,0 +1,94 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    MappedBuffer.h
+ * @brief   Read-only view of a chunk mapped from the data file it is stored in.
+ *
+ * The data of a single page chunk is contiguous in its file, so it can be handed to
+ * the executor straight from the OS page cache instead of being copied into the CPU
+ * buffer pool. Writes keep going through the FileBuffer of the chunk.
+ */
+
+#ifndef DATAMGR_FILE_MAPPEDBUFFER_H
+#define DATAMGR_FILE_MAPPEDBUFFER_H
+
+#include "../AbstractBuffer.h"
+#include "FileBuffer.h"
+#include "FileInfo.h"
+#include "Page.h"
+
+#include <atomic>
+
+using namespace Data_Namespace;
+
+namespace File_Namespace {
+
+class MappedBuffer : public AbstractBuffer {
+ public:
+  // Maps the data of the first page of fileBuffer, stored in page of fileInfo.
+  MappedBuffer(const FileBuffer* fileBuffer, FileInfo* fileInfo, const Page& page);
+
+  virtual ~MappedBuffer();
+
+  virtual void read(int8_t* const dst,
+                    const size_t numBytes,
+                    const size_t offset = 0,
+                    const MemoryLevel dstBufferType = CPU_LEVEL,
+                    const int dstDeviceId = -1);
+
+  virtual void write(int8_t* src,
+                     const size_t numBytes,
+                     const size_t offset = 0,
+                     const MemoryLevel srcBufferType = CPU_LEVEL,
+                     const int srcDeviceId = -1);
+
+  virtual void reserve(size_t numBytes);
+
+  virtual void append(int8_t* src,
+                      const size_t numBytes,
+                      const MemoryLevel srcBufferType = CPU_LEVEL,
+                      const int deviceId = -1);
+
+  virtual int8_t* getMemoryPtr() { return data_; }
+
+  virtual size_t pageCount() const { return 1; }
+  virtual size_t pageSize() const { return pageSize_; }
+  virtual size_t size() const { return size_; }
+  virtual size_t reservedSize() const { return size_; }
+  virtual MemoryLevel getType() const { return CPU_LEVEL; }
+
+  virtual int pin() { return ++pinCount_; }
+  virtual int unPin() { return --pinCount_; }
+  virtual int getPinCount() { return pinCount_; }
+
+  // True if the view still shows the current contents of fileBuffer.
+  bool matches(const FileBuffer* fileBuffer, const Page& page) const;
+
+  const Page& getPage() const { return page_; }
+
+ private:
+  Page page_;
+  size_t pageSize_;
+  int8_t* mapping_;
+  size_t mappingSize_;
+  int8_t* data_;
+  std::atomic<int> pinCount_;
+};
+
+}  // namespace File_Namespace
+
+#endif  // DATAMGR_FILE_MAPPEDBUFFER_H
@@ -30,7 +30,9 @@ class FixedLengthEncoder : public Encoder {
       : Encoder(buffer)
       , dataMin(std::numeric_limits<T>::max())
       , dataMax(std::numeric_limits<T>::min())
-      , has_nulls(false) {}
+      , has_nulls(false) {
+    initBloomFilter();
+  }
 
   ChunkMetadata appendData(int8_t*& srcData,
                            const size_t numAppendElems,
@@ -51,9 +53,11 @@ class FixedLengthEncoder : public Encoder {
         else {
           dataMin = std::min(dataMin, data);
           dataMax = std::max(dataMax, data);
+          addToBloomFilter(data);
         }
       }
     }
+    dropSaturatedBloomFilter();
     num_elems_ += numAppendElems;
 
     // assume always CPU_BUFFER?
@@ -79,6 +83,8 @@ class FixedLengthEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const int64_t val, const bool is_null) {
+    // Only the range of the new values is known here, not the values themselves.
+    bloom_filter_.reset();
     if (is_null) {
       has_nulls = true;
     } else {
@@ -90,6 +96,7 @@ class FixedLengthEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const double val, const bool is_null) {
+    bloom_filter_.reset();
     if (is_null) {
       has_nulls = true;
     } else {
@@ -101,7 +108,8 @@ class FixedLengthEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void reduceStats(const Encoder& that) {
-    const auto that_typed = static_cast<const FixedLengthEncoder<T, V>&>(that);
+    const auto& that_typed = static_cast<const FixedLengthEncoder<T, V>&>(that);
+    bloom_filter_.reset();
     if (that_typed.has_nulls) {
       has_nulls = true;
     }
@@ -116,6 +124,7 @@ class FixedLengthEncoder : public Encoder {
     dataMin = castedEncoder->dataMin;
     dataMax = castedEncoder->dataMax;
     has_nulls = castedEncoder->has_nulls;
+    copyBloomFilter(copyFromEncoder);
   }
 
   void writeMetadata(FILE* f) {
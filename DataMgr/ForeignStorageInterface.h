@@ -0,0 +1,51 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ForeignStorageInterface.h
+ * @brief   Source of the chunks of a table whose data lives outside of the data files.
+ *
+ * The chunks of an external table are read from its files by the storage the
+ * fragmenter of the table registers with the GlobalFileMgr, in place of the FileMgr of
+ * the table, when the CPU buffer pool misses them. The pools keep them like any other
+ * chunk; they never write them back.
+ */
+
+#ifndef FOREIGN_STORAGE_INTERFACE_H
+#define FOREIGN_STORAGE_INTERFACE_H
+
+#include "../Shared/types.h"
+
+#include <cstddef>
+
+namespace Data_Namespace {
+
+class AbstractBuffer;
+
+class ForeignStorageInterface {
+ public:
+  virtual ~ForeignStorageInterface() {}
+
+  // Fills destBuffer with the first numBytes of the chunk, all of it if zero, and sets
+  // its size. Throws std::runtime_error if the chunk can't be read.
+  virtual void read(const ChunkKey& chunkKey,
+                    AbstractBuffer* destBuffer,
+                    const size_t numBytes) = 0;
+};
+
+}  // namespace Data_Namespace
+
+#endif  // FOREIGN_STORAGE_INTERFACE_H
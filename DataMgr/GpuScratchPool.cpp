@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuScratchPool.h"
+#include "../CudaMgr/CudaMgr.h"
+
+#include <glog/logging.h>
+
+#include <stdexcept>
+
+namespace Data_Namespace {
+
+GpuScratchPool::GpuScratchPool(CudaMgr_Namespace::CudaMgr* cudaMgr,
+                               const int deviceId,
+                               const size_t maxBytes)
+    : cudaMgr_(cudaMgr), deviceId_(deviceId), maxBytes_(maxBytes), allocatedBytes_(0) {
+  CHECK(cudaMgr_);
+}
+
+GpuScratchPool::~GpuScratchPool() {
+  try {
+    freeAll();
+    release();
+  } catch (const std::runtime_error& e) {
+    LOG(ERROR) << "Could not free the scratch memory of GPU " << deviceId_ << ": "
+               << e.what();
+  }
+}
+
+size_t GpuScratchPool::sizeClass(const size_t numBytes) {
+  constexpr size_t kMinBlockBytes{4096};
+  if (numBytes <= kMinBlockBytes) {
+    return kMinBlockBytes;
+  }
+  size_t powerOfTwo = kMinBlockBytes;
+  while (powerOfTwo <= numBytes / 2) {
+    powerOfTwo *= 2;
+  }
+  const auto step = powerOfTwo / 4;
+  return (numBytes + step - 1) / step * step;
+}
+
+int8_t* GpuScratchPool::allocate(const size_t numBytes) {
+  const auto classBytes = sizeClass(numBytes);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto idleIt = idleBlocks_.find(classBytes);
+  if (idleIt != idleBlocks_.end()) {
+    auto ptr = idleIt->second.back();
+    idleIt->second.pop_back();
+    if (idleIt->second.empty()) {
+      idleBlocks_.erase(idleIt);
+    }
+    blocksInUse_.emplace(ptr, classBytes);
+    return ptr;
+  }
+  if (allocatedBytes_ + classBytes > maxBytes_) {
+    // The idle blocks of the other classes make room for this one.
+    releaseUnlocked();
+    if (allocatedBytes_ + classBytes > maxBytes_) {
+      return nullptr;
+    }
+  }
+  int8_t* ptr{nullptr};
+  try {
+    ptr = cudaMgr_->allocateDeviceMem(classBytes, deviceId_);
+  } catch (const std::runtime_error& e) {
+    VLOG(1) << "Scratch allocation of " << classBytes << " bytes failed on GPU "
+            << deviceId_ << ": " << e.what();
+    return nullptr;
+  }
+  if (!ptr) {
+    return nullptr;
+  }
+  allocatedBytes_ += classBytes;
+  blocksInUse_.emplace(ptr, classBytes);
+  return ptr;
+}
+
+void GpuScratchPool::free(int8_t* ptr) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto blockIt = blocksInUse_.find(ptr);
+  if (blockIt == blocksInUse_.end()) {
+    return;
+  }
+  idleBlocks_[blockIt->second].push_back(ptr);
+  blocksInUse_.erase(blockIt);
+}
+
+void GpuScratchPool::freeAll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& block : blocksInUse_) {
+    idleBlocks_[block.second].push_back(block.first);
+  }
+  blocksInUse_.clear();
+}
+
+void GpuScratchPool::release() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  releaseUnlocked();
+}
+
+void GpuScratchPool::releaseUnlocked() {
+  for (const auto& idleClass : idleBlocks_) {
+    for (auto ptr : idleClass.second) {
+      cudaMgr_->freeDeviceMem(ptr);
+      allocatedBytes_ -= idleClass.first;
+    }
+  }
+  idleBlocks_.clear();
+}
+
+}  // namespace Data_Namespace
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    GpuScratchPool.h
+ * @brief   Device memory of a GPU for the transient allocations of queries.
+ *
+ * Sort buffers, the scratch memory of hash table builds and the count distinct bitmaps
+ * live for a query at most. Allocated from the buffer pool, they fragment the slabs
+ * holding the chunks and serialize on the pool locks. The scratch pool allocates them
+ * from the driver instead and keeps freed blocks in free lists per size class for the
+ * next allocation of the class, within a byte budget per device.
+ *
+ * The kernels run on the default stream and complete before a query frees its memory,
+ * so a freed block can be handed out again right away.
+ */
+
+#ifndef GPUSCRATCHPOOL_H
+#define GPUSCRATCHPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace CudaMgr_Namespace {
+class CudaMgr;
+}
+
+namespace Data_Namespace {
+
+class GpuScratchPool {
+ public:
+  GpuScratchPool(CudaMgr_Namespace::CudaMgr* cudaMgr,
+                 const int deviceId,
+                 const size_t maxBytes);
+  ~GpuScratchPool();
+
+  // Returns nullptr if the block doesn't fit in the budget or the device is out of
+  // memory, the caller allocates from the buffer pool instead.
+  int8_t* allocate(const size_t numBytes);
+
+  // Ignores the blocks freed by freeAll already.
+  void free(int8_t* ptr);
+
+  // Frees the blocks still in use at the end of a query.
+  void freeAll();
+
+  // Returns the idle blocks to the driver.
+  void release();
+
+  // 4 classes per power of two, a block is at most 25% larger than requested.
+  static size_t sizeClass(const size_t numBytes);
+
+ private:
+  void releaseUnlocked();
+
+  CudaMgr_Namespace::CudaMgr* cudaMgr_;
+  const int deviceId_;
+  const size_t maxBytes_;
+  size_t allocatedBytes_;
+  std::unordered_map<int8_t*, size_t> blocksInUse_;
+  std::map<size_t, std::vector<int8_t*>> idleBlocks_;
+  std::mutex mutex_;
+};
+
+}  // namespace Data_Namespace
+
+#endif  // GPUSCRATCHPOOL_H
@@ -33,7 +33,11 @@ class NoneEncoder : public Encoder {
       : Encoder(buffer)
       , dataMin(std::numeric_limits<T>::max())
       , dataMax(std::numeric_limits<T>::lowest())
-      , has_nulls(false) {}
+      , has_nulls(false) {
+    if (std::is_integral<T>::value) {
+      initBloomFilter();
+    }
+  }
 
   ChunkMetadata appendData(int8_t*& srcData,
                            const size_t numAppendElems,
@@ -52,8 +56,10 @@ class NoneEncoder : public Encoder {
       else {
         dataMin = std::min(dataMin, data);
         dataMax = std::max(dataMax, data);
+        addToBloomFilter(static_cast<int64_t>(data));
       }
     }
+    dropSaturatedBloomFilter();
     num_elems_ += numAppendElems;
     buffer_->append(replicating ? (int8_t*)encodedData.get() : srcData,
                     numAppendElems * sizeof(T));
@@ -78,6 +84,8 @@ class NoneEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const int64_t val, const bool is_null) {
+    // Only the range of the new values is known here, not the values themselves.
+    bloom_filter_.reset();
     if (is_null) {
       has_nulls = true;
     } else {
@@ -89,6 +97,7 @@ class NoneEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void updateStats(const double val, const bool is_null) {
+    bloom_filter_.reset();
     if (is_null) {
       has_nulls = true;
     } else {
@@ -100,7 +109,8 @@ class NoneEncoder : public Encoder {
 
   // Only called from the executor for synthesized meta-information.
   void reduceStats(const Encoder& that) {
-    const auto that_typed = static_cast<const NoneEncoder&>(that);
+    const auto& that_typed = static_cast<const NoneEncoder&>(that);
+    bloom_filter_.reset();
     if (that_typed.has_nulls) {
       has_nulls = true;
     }
@@ -130,6 +140,7 @@ class NoneEncoder : public Encoder {
     dataMin = castedEncoder->dataMin;
     dataMax = castedEncoder->dataMax;
     has_nulls = castedEncoder->has_nulls;
+    copyBloomFilter(copyFromEncoder);
   }
 
   T dataMin;
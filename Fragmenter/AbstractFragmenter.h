@@ -23,12 +23,14 @@
 #define _ABSTRACT_FRAGMENTER_H
 
 #include <boost/variant.hpp>
+#include <mutex>
 #include <string>
 #include <vector>
 #include "../Shared/UpdelRoll.h"
 #include "../Shared/sqltypes.h"
 #include "../StringDictionary/StringDictionary.h"
 #include "Fragmenter.h"
+#include "PrimaryKeyIndex.h"
 
 // Should the ColumnInfo and FragmentInfo structs be in
 // AbstractFragmenter?
@@ -49,6 +51,10 @@ struct TableDescriptor;
 struct ColumnDescriptor;
 
 namespace Fragmenter_Namespace {
+
+// A generation no fragmenter had before, see AbstractFragmenter::getGeneration.
+size_t next_fragmenter_generation();
+
 using NullableString = boost::variant<std::string, void*>;
 using ScalarTargetValue = boost::variant<int64_t, double, float, NullableString>;
 /*
@@ -94,6 +100,17 @@ class AbstractFragmenter {
 
   virtual void insertDataNoCheckpoint(InsertData& insertDataStruct) = 0;
 
+  /**
+   * @brief Given data wrapped in an InsertData struct,
+   * inserts it into the correct partitions with locks. The checkpoint is taken in
+   * the background at most commitIntervalMs later, or right away once maxPendingRows
+   * rows are waiting for one
+   */
+
+  virtual void insertDataDeferCheckpoint(InsertData& insertDataStruct,
+                                         const size_t commitIntervalMs,
+                                         const size_t maxPendingRows) = 0;
+
   /**
    * @brief Will truncate table to less than maxRows by dropping
    * fragments
@@ -101,6 +118,36 @@ class AbstractFragmenter {
 
   virtual void dropFragmentsToSize(const size_t maxRows) = 0;
 
+  /**
+   * @brief Appends the live rows of the fragments with at least minDeletedFraction of
+   * their rows deleted to the table and marks all the rows of these fragments deleted.
+   * No locks and checkpoints taken, the checkpoint has to come before dropFragments.
+   *
+   * @return std::vector<int> The ids of the compacted fragments.
+   */
+
+  virtual std::vector<int> compactFragments(const double minDeletedFraction) = 0;
+
+  /**
+   * @brief Drops fragments returned by compactFragments
+   */
+
+  virtual void dropFragments(const std::vector<int>& fragmentIds) = 0;
+
+  /**
+   * @brief Finds the live rows of the keys of the primary key column, {-1, 0} for the
+   * keys not in the table. Only for a table with a primary key.
+   */
+
+  virtual std::vector<RowLocation> findPrimaryKeys(const std::vector<int64_t>& keys) = 0;
+
+  /**
+   * @brief Held by the loads which look their keys up, so that no other load inserts
+   * the keys found missing before they do
+   */
+
+  virtual std::mutex& getUpsertMutex() = 0;
+
   /**
    * @brief Gets the id of the partitioner
    */
@@ -115,6 +162,13 @@ class AbstractFragmenter {
 
   virtual size_t getNumRows() = 0;
 
+  /**
+   * @brief Changes every time the fragments or their metadata do, never goes back to a
+   * value it had, even across fragmenters
+   */
+
+  virtual size_t getGeneration() = 0;
+
   virtual void updateColumn(const Catalog_Namespace::Catalog* catalog,
                             const TableDescriptor* td,
                             const ColumnDescriptor* cd,
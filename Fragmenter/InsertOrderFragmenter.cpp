@@ -17,10 +17,15 @@
 #include "InsertOrderFragmenter.h"
 #include <glog/logging.h>
 #include <boost/lexical_cast.hpp>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
 #include <iostream>
 #include <limits>
+#include <list>
+#include <numeric>
 #include <thread>
 #include <type_traits>
 #include "../DataMgr/AbstractBuffer.h"
@@ -40,6 +45,79 @@ using namespace std;
 
 namespace Fragmenter_Namespace {
 
+namespace {
+
+// Fragmenters holding rows inserted by insertDataDeferCheckpoint which still need a
+// checkpoint, with the time it is due by. A single background thread takes them.
+class DeferredCheckpoints {
+ public:
+  static DeferredCheckpoints& instance() {
+    // Never destroyed, the thread keeps running until the process exits.
+    static auto deferred_checkpoints = new DeferredCheckpoints();
+    return *deferred_checkpoints;
+  }
+
+  // Must not be called with the insert lock of the fragmenter held.
+  void schedule(InsertOrderFragmenter* fragmenter,
+                const std::chrono::steady_clock::time_point due) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // an earlier due time already scheduled is kept
+    if (due_.emplace(fragmenter, due).second) {
+      cv_.notify_one();
+    }
+  }
+
+  // Waits for a checkpoint of the fragmenter in progress, if any.
+  void cancel(InsertOrderFragmenter* fragmenter) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    due_.erase(fragmenter);
+  }
+
+ private:
+  DeferredCheckpoints() : checkpointer_([this] { run(); }) { checkpointer_.detach(); }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (due_.empty()) {
+        cv_.wait(lock);
+        continue;
+      }
+      const auto next_due = std::min_element(
+          due_.begin(), due_.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.second < rhs.second;
+          });
+      if (next_due->second > std::chrono::steady_clock::now()) {
+        cv_.wait_until(lock, next_due->second);
+        continue;
+      }
+      const auto fragmenter = next_due->first;
+      due_.erase(next_due);
+      // checkpointed under the lock, so that a fragmenter being destroyed waits for it
+      try {
+        fragmenter->checkpointDeferredInserts();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Deferred insert checkpoint failed: " << e.what();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<InsertOrderFragmenter*, std::chrono::steady_clock::time_point> due_;
+  std::thread checkpointer_;
+};
+
+// Shared by all the fragmenters, a table dropped or truncated and created again doesn't
+// go through the generations of the previous one.
+std::atomic<size_t> g_next_generation{0};
+
+}  // namespace
+
+size_t next_fragmenter_generation() {
+  return ++g_next_generation;
+}
+
 InsertOrderFragmenter::InsertOrderFragmenter(
     const vector<int> chunkKeyPrefix,
     vector<Chunk>& chunkVec,
@@ -51,7 +129,12 @@ InsertOrderFragmenter::InsertOrderFragmenter(
     const size_t maxChunkSize,
     const size_t pageSize,
     const size_t maxRows,
-    const Data_Namespace::MemoryLevel defaultInsertLevel)
+    const Data_Namespace::MemoryLevel defaultInsertLevel,
+    const int sortedColumnId,
+    const int64_t partitionInterval,
+    const int64_t retention,
+    const int indexColumnId,
+    const int primaryKeyColumnId)
     : chunkKeyPrefix_(chunkKeyPrefix)
     , dataMgr_(dataMgr)
     , catalog_(catalog)
@@ -60,12 +143,18 @@ InsertOrderFragmenter::InsertOrderFragmenter(
     , maxFragmentRows_(std::min<size_t>(maxFragmentRows, maxRows))
     , pageSize_(pageSize)
     , numTuples_(0)
+    , generation_(next_fragmenter_generation())
     , maxFragmentId_(-1)
     , maxChunkSize_(maxChunkSize)
     , maxRows_(maxRows)
     , fragmenterType_("insert_order")
     , defaultInsertLevel_(defaultInsertLevel)
     , hasMaterializedRowId_(false)
+    , sortedColumnId_(sortedColumnId)
+    , partitionInterval_(partitionInterval)
+    , retention_(retention)
+    , indexColumnId_(indexColumnId)
+    , primaryKeyColumnId_(primaryKeyColumnId)
     , mutex_access_inmem_states(new std::mutex) {
   // Note that Fragmenter is not passed virtual columns and so should only
   // find row id column if it is non virtual
@@ -79,9 +168,16 @@ InsertOrderFragmenter::InsertOrderFragmenter(
     }
   }
   getChunkMetadata();
+  buildKeyIndexes();
 }
 
-InsertOrderFragmenter::~InsertOrderFragmenter() {}
+void InsertOrderFragmenter::bumpGeneration() {
+  generation_ = next_fragmenter_generation();
+}
+
+InsertOrderFragmenter::~InsertOrderFragmenter() {
+  DeferredCheckpoints::instance().cancel(this);
+}
 
 void InsertOrderFragmenter::getChunkMetadata() {
   if (defaultInsertLevel_ ==
@@ -215,6 +311,7 @@ void InsertOrderFragmenter::deleteFragments(const vector<int>& dropFragIds) {
       *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::UpdateDeleteLock,
                                                       chunkKeyPrefix));
   mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+  bumpGeneration();
 
   for (const auto fragId : dropFragIds) {
     for (const auto& col : columnMap_) {
@@ -227,6 +324,377 @@ void InsertOrderFragmenter::deleteFragments(const vector<int>& dropFragIds) {
   }
 }
 
+namespace {
+
+template <class T>
+std::vector<size_t> get_sort_permutation(const int8_t* data, const size_t numRows) {
+  const auto vals = reinterpret_cast<const T*>(data);
+  std::vector<size_t> permutation(numRows);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::stable_sort(
+      permutation.begin(), permutation.end(), [vals](const size_t lhs, const size_t rhs) {
+        return vals[lhs] < vals[rhs];
+      });
+  return permutation;
+}
+
+// Nulls are the smallest integers, they go first.
+std::vector<size_t> get_sort_permutation(const SQLTypeInfo& ti,
+                                         const int8_t* data,
+                                         const size_t numRows) {
+  if (ti.is_fp()) {
+    return ti.get_type() == kFLOAT ? get_sort_permutation<float>(data, numRows)
+                                   : get_sort_permutation<double>(data, numRows);
+  }
+  switch (ti.get_logical_size()) {
+    case 1:
+      return get_sort_permutation<int8_t>(data, numRows);
+    case 2:
+      return get_sort_permutation<int16_t>(data, numRows);
+    case 4:
+      return get_sort_permutation<int32_t>(data, numRows);
+    case 8:
+      return get_sort_permutation<int64_t>(data, numRows);
+    default:
+      CHECK(false);
+  }
+  return {};
+}
+
+// Dictionary ids come in the width of the column, other numbers in their logical width.
+size_t get_insert_elem_size(const SQLTypeInfo& ti) {
+  return ti.get_compression() == kENCODING_DICT ? ti.get_size() : ti.get_logical_size();
+}
+
+template <class T>
+std::vector<T> permute(const std::vector<T>& vals,
+                       const std::vector<size_t>& permutation) {
+  std::vector<T> permuted;
+  permuted.reserve(permutation.size());
+  for (const auto idx : permutation) {
+    permuted.push_back(vals[idx]);
+  }
+  return permuted;
+}
+
+// Columns of an insert reordered on the values of the sort column.
+struct SortedInsertData {
+  std::vector<DataBlockPtr> data;
+  std::vector<std::unique_ptr<int8_t[]>> numbers;
+  std::list<std::vector<std::string>> strings;
+  std::list<std::vector<ArrayDatum>> arrays;
+};
+
+void sort_insert_data(SortedInsertData& sorted,
+                      const InsertData& insertData,
+                      const std::map<int, Chunk>& columnMap,
+                      const size_t sortedColumnPos) {
+  const auto& sortedColumnType =
+      columnMap.at(insertData.columnIds[sortedColumnPos]).get_column_desc()->columnType;
+  const auto permutation = get_sort_permutation(
+      sortedColumnType, insertData.data[sortedColumnPos].numbersPtr, insertData.numRows);
+  for (size_t i = 0; i < insertData.columnIds.size(); ++i) {
+    const auto& ti = columnMap.at(insertData.columnIds[i]).get_column_desc()->columnType;
+    DataBlockPtr block;
+    if (ti.is_varlen()) {
+      if (ti.is_array()) {
+        sorted.arrays.push_back(permute(*insertData.data[i].arraysPtr, permutation));
+        block.arraysPtr = &sorted.arrays.back();
+      } else {
+        sorted.strings.push_back(permute(*insertData.data[i].stringsPtr, permutation));
+        block.stringsPtr = &sorted.strings.back();
+      }
+    } else {
+      const auto elemSize = get_insert_elem_size(ti);
+      const auto src = insertData.data[i].numbersPtr;
+      std::unique_ptr<int8_t[]> dst(new int8_t[insertData.numRows * elemSize]);
+      for (size_t row = 0; row < insertData.numRows; ++row) {
+        memcpy(dst.get() + row * elemSize, src + permutation[row] * elemSize, elemSize);
+      }
+      block.numbersPtr = dst.get();
+      sorted.numbers.push_back(std::move(dst));
+    }
+    sorted.data.push_back(block);
+  }
+}
+
+// The partition of a time is the number of intervals since the epoch, rounded down.
+// Nulls are in a partition of their own.
+const int64_t NULL_PARTITION{std::numeric_limits<int64_t>::min()};
+
+int64_t get_partition(const int64_t time, const int64_t interval) {
+  CHECK_GT(interval, 0);
+  const auto partition = time / interval;
+  return time % interval < 0 ? partition - 1 : partition;
+}
+
+int64_t get_insert_partition(const int8_t* data,
+                             const size_t elemSize,
+                             const size_t row,
+                             const int64_t interval) {
+  const auto time = elemSize == sizeof(int32_t)
+                        ? reinterpret_cast<const int32_t*>(data)[row]
+                        : reinterpret_cast<const int64_t*>(data)[row];
+  const int64_t nullTime = elemSize == sizeof(int32_t) ? NULL_INT : NULL_BIGINT;
+  return time == nullTime ? NULL_PARTITION : get_partition(time, interval);
+}
+
+// Nulls are read as their sentinel, which only keeps the index from skipping it.
+std::vector<int64_t> read_keys(const int8_t* data,
+                               const size_t elemSize,
+                               const size_t numElems) {
+  std::vector<int64_t> keys(numElems);
+  for (size_t i = 0; i < numElems; ++i) {
+    switch (elemSize) {
+      case 1:
+        keys[i] = reinterpret_cast<const int8_t*>(data)[i];
+        break;
+      case 2:
+        keys[i] = reinterpret_cast<const int16_t*>(data)[i];
+        break;
+      case 4:
+        keys[i] = reinterpret_cast<const int32_t*>(data)[i];
+        break;
+      case 8:
+        keys[i] = reinterpret_cast<const int64_t*>(data)[i];
+        break;
+      default:
+        CHECK(false);
+    }
+  }
+  return keys;
+}
+
+int64_t read_key(const int8_t* data, const size_t elemSize, const size_t row) {
+  return read_keys(data + row * elemSize, elemSize, 1).front();
+}
+
+}  // namespace
+
+// The metadata of the chunk, from the insert in progress if it appended to it.
+const ChunkMetadata* InsertOrderFragmenter::findChunkMetadata(
+    const FragmentInfo& fragment,
+    const int columnId) const {
+  auto chunkMetadataIt = fragment.shadowChunkMetadataMap.find(columnId);
+  if (chunkMetadataIt == fragment.shadowChunkMetadataMap.end()) {
+    const auto& chunkMetadataMap = fragment.getChunkMetadataMapPhysical();
+    chunkMetadataIt = chunkMetadataMap.find(columnId);
+    if (chunkMetadataIt == chunkMetadataMap.end()) {
+      return nullptr;
+    }
+  }
+  return &chunkMetadataIt->second;
+}
+
+// The stats of the partition column, null if the fragment has no time in it yet.
+const ChunkStats* InsertOrderFragmenter::getPartitionStats(
+    const FragmentInfo& fragment) const {
+  const auto chunkMetadata = findChunkMetadata(fragment, sortedColumnId_);
+  if (!chunkMetadata) {
+    return nullptr;
+  }
+  const auto& chunkStats = chunkMetadata->chunkStats;
+  return chunkStats.min.timeval > chunkStats.max.timeval ? nullptr : &chunkStats;
+}
+
+// The index isn't persisted, the chunks of the index column are read once per load.
+void InsertOrderFragmenter::buildKeyIndexes() {
+  if (!indexColumnId_) {
+    return;
+  }
+  const auto cd = columnMap_.at(indexColumnId_).get_column_desc();
+  for (auto& fragment : fragmentInfoVec_) {
+    auto chunkMetadataMap = fragment.getChunkMetadataMapPhysical();
+    const auto chunkMetadataIt = chunkMetadataMap.find(indexColumnId_);
+    if (chunkMetadataIt == chunkMetadataMap.end()) {
+      continue;
+    }
+    auto& chunkMetadata = chunkMetadataIt->second;
+    ChunkKey chunkKey = chunkKeyPrefix_;
+    chunkKey.push_back(indexColumnId_);
+    chunkKey.push_back(fragment.fragmentId);
+    const auto chunk = Chunk::getChunk(
+        cd,
+        dataMgr_,
+        chunkKey,
+        Data_Namespace::CPU_LEVEL,
+        fragment.deviceIds[static_cast<int>(Data_Namespace::CPU_LEVEL)],
+        chunkMetadata.numBytes,
+        chunkMetadata.numElements);
+    chunkMetadata.keyIndex = std::make_shared<ChunkKeyIndex>();
+    chunkMetadata.keyIndex->add(read_keys(chunk->get_buffer()->getMemoryPtr(),
+                                          cd->columnType.get_size(),
+                                          chunkMetadata.numElements));
+    fragment.setChunkMetadataMap(chunkMetadataMap);
+  }
+}
+
+std::shared_ptr<Chunk> InsertOrderFragmenter::getCpuChunk(const ColumnDescriptor* cd,
+                                                         const FragmentInfo& fragment) {
+  const auto& chunkMetadata = fragment.getChunkMetadataMapPhysical().at(cd->columnId);
+  ChunkKey chunkKey = chunkKeyPrefix_;
+  chunkKey.push_back(cd->columnId);
+  chunkKey.push_back(fragment.fragmentId);
+  return Chunk::getChunk(cd,
+                         dataMgr_,
+                         chunkKey,
+                         Data_Namespace::CPU_LEVEL,
+                         fragment.deviceIds[static_cast<int>(Data_Namespace::CPU_LEVEL)],
+                         chunkMetadata.numBytes,
+                         chunkMetadata.numElements);
+}
+
+// Only the first upsert into the table reads the whole key column.
+void InsertOrderFragmenter::buildPrimaryKeyIndex() {
+  const auto keyCd = columnMap_.at(primaryKeyColumnId_).get_column_desc();
+  const ColumnDescriptor* deletedCd{nullptr};
+  for (const auto& col : columnMap_) {
+    if (col.second.get_column_desc()->isDeletedCol) {
+      deletedCd = col.second.get_column_desc();
+    }
+  }
+  primaryKeyIndex_.reset(new PrimaryKeyIndex());
+  for (const auto& fragment : fragmentInfoVec_) {
+    const auto numRows = fragment.getPhysicalNumTuples();
+    if (!numRows) {
+      continue;
+    }
+    const auto keyChunk = getCpuChunk(keyCd, fragment);
+    const auto keys = read_keys(keyChunk->get_buffer()->getMemoryPtr(),
+                                keyCd->columnType.get_size(),
+                                numRows);
+    if (!deletedCd) {
+      primaryKeyIndex_->add(keys, fragment.fragmentId, 0);
+      continue;
+    }
+    const auto deletedChunk = getCpuChunk(deletedCd, fragment);
+    const auto deleted = deletedChunk->get_buffer()->getMemoryPtr();
+    for (size_t row = 0; row < numRows; ++row) {
+      if (!deleted[row]) {
+        primaryKeyIndex_->add({keys[row]}, fragment.fragmentId, row);
+      }
+    }
+  }
+  LOG(INFO) << "Built the primary key index of table " << physicalTableId_ << ", "
+            << primaryKeyIndex_->size() << " keys";
+}
+
+// The index may point at a row deleted, or moved by the vacuum or by an update of its
+// key, since; the chunks have the last word.
+std::vector<RowLocation> InsertOrderFragmenter::findPrimaryKeys(
+    const std::vector<int64_t>& keys) {
+  CHECK(primaryKeyColumnId_);
+  mapd_shared_lock<mapd_shared_mutex> insertLock(insertMutex_);
+  std::lock_guard<std::mutex> primaryKeyLock(primaryKeyMutex_);
+  if (!primaryKeyIndex_) {
+    buildPrimaryKeyIndex();
+  }
+  std::vector<RowLocation> locations;
+  locations.reserve(keys.size());
+  std::map<int, std::vector<size_t>> fragmentKeys;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    locations.push_back(primaryKeyIndex_->find(keys[i]));
+    if (locations.back().fragmentId >= 0) {
+      fragmentKeys[locations.back().fragmentId].push_back(i);
+    }
+  }
+  const auto keyCd = columnMap_.at(primaryKeyColumnId_).get_column_desc();
+  const ColumnDescriptor* deletedCd{nullptr};
+  for (const auto& col : columnMap_) {
+    if (col.second.get_column_desc()->isDeletedCol) {
+      deletedCd = col.second.get_column_desc();
+    }
+  }
+  for (const auto& fragmentKeysIt : fragmentKeys) {
+    const auto fragmentId = fragmentKeysIt.first;
+    const auto fragmentIt = std::find_if(
+        fragmentInfoVec_.begin(),
+        fragmentInfoVec_.end(),
+        [fragmentId](const FragmentInfo& f) { return f.fragmentId == fragmentId; });
+    const auto numRows =
+        fragmentIt == fragmentInfoVec_.end() ? 0 : fragmentIt->getPhysicalNumTuples();
+    if (!numRows) {
+      for (const auto i : fragmentKeysIt.second) {
+        locations[i] = RowLocation{-1, 0};
+      }
+      continue;
+    }
+    const auto keyChunk = getCpuChunk(keyCd, *fragmentIt);
+    const auto keyData = keyChunk->get_buffer()->getMemoryPtr();
+    std::shared_ptr<Chunk> deletedChunk;
+    if (deletedCd) {
+      deletedChunk = getCpuChunk(deletedCd, *fragmentIt);
+    }
+    const auto deleted =
+        deletedChunk ? deletedChunk->get_buffer()->getMemoryPtr() : nullptr;
+    for (const auto i : fragmentKeysIt.second) {
+      const auto offset = locations[i].offset;
+      if (offset >= numRows ||
+          read_key(keyData, keyCd->columnType.get_size(), offset) != keys[i] ||
+          (deleted && deleted[offset])) {
+        locations[i] = RowLocation{-1, 0};
+      }
+    }
+  }
+  return locations;
+}
+
+bool InsertOrderFragmenter::isInPartition(const FragmentInfo& fragment,
+                                          const int64_t partition) const {
+  if (!fragment.shadowNumTuples) {
+    return true;
+  }
+  const auto chunkStats = getPartitionStats(fragment);
+  return chunkStats ? get_partition(chunkStats->min.timeval, partitionInterval_) ==
+                          partition
+                    : partition == NULL_PARTITION;
+}
+
+// Drops the fragments of the partitions which end retention_ seconds or more before the
+// newest time of the table. Whole fragments go, their rows are never scanned.
+void InsertOrderFragmenter::dropExpiredPartitions() {
+  // not safe to call from outside insertData, like dropFragmentsToSize
+  if (!retention_ || fragmentInfoVec_.size() < 2) {
+    return;
+  }
+  int64_t newestTime{std::numeric_limits<int64_t>::min()};
+  for (const auto& fragment : fragmentInfoVec_) {
+    const auto chunkStats = getPartitionStats(fragment);
+    if (chunkStats) {
+      newestTime = std::max(newestTime, chunkStats->max.timeval);
+    }
+  }
+  if (newestTime == std::numeric_limits<int64_t>::min()) {
+    return;
+  }
+  const auto oldestPartition = get_partition(newestTime - retention_, partitionInterval_);
+  const auto insertFragmentId = fragmentInfoVec_.back().fragmentId;
+  vector<int> dropFragIds;
+  {
+    mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+    bumpGeneration();
+    for (auto fragmentIt = fragmentInfoVec_.begin();
+         fragmentIt != fragmentInfoVec_.end();) {
+      const auto chunkStats = getPartitionStats(*fragmentIt);
+      if (fragmentIt->fragmentId == insertFragmentId || !chunkStats ||
+          get_partition(chunkStats->min.timeval, partitionInterval_) >= oldestPartition) {
+        ++fragmentIt;
+        continue;
+      }
+      CHECK_GE(numTuples_, fragmentIt->getPhysicalNumTuples());
+      numTuples_ -= fragmentIt->getPhysicalNumTuples();
+      dropFragIds.push_back(fragmentIt->fragmentId);
+      fragmentIt = fragmentInfoVec_.erase(fragmentIt);
+    }
+  }
+  if (dropFragIds.empty()) {
+    return;
+  }
+  deleteFragments(dropFragIds);
+  LOG(INFO) << "dropExpiredPartitions, fragments dropped: " << dropFragIds.size()
+            << " numTuples post: " << numTuples_;
+}
+
 void InsertOrderFragmenter::insertData(InsertData& insertDataStruct) {
   // TODO: this local lock will need to be centralized when ALTER COLUMN is added, bc
   mapd_unique_lock<mapd_shared_mutex> insertLock(
@@ -239,6 +707,40 @@ void InsertOrderFragmenter::insertData(InsertData& insertDataStruct) {
         chunkKeyPrefix_[0],
         chunkKeyPrefix_[1]);  // need to checkpoint here to remove window for corruption
   }
+  uncheckpointedRows_ = 0;
+}
+
+void InsertOrderFragmenter::insertDataDeferCheckpoint(InsertData& insertDataStruct,
+                                                      const size_t commitIntervalMs,
+                                                      const size_t maxPendingRows) {
+  bool scheduleCheckpoint{false};
+  {
+    mapd_unique_lock<mapd_shared_mutex> insertLock(insertMutex_);
+    insertDataImpl(insertDataStruct);
+    if (defaultInsertLevel_ != Data_Namespace::DISK_LEVEL) {
+      return;
+    }
+    scheduleCheckpoint = uncheckpointedRows_ == 0;
+    uncheckpointedRows_ += insertDataStruct.numRows;
+    if (uncheckpointedRows_ >= maxPendingRows) {
+      dataMgr_->checkpoint(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+      uncheckpointedRows_ = 0;
+      return;
+    }
+  }
+  if (scheduleCheckpoint) {
+    DeferredCheckpoints::instance().schedule(
+        this,
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(commitIntervalMs));
+  }
+}
+
+void InsertOrderFragmenter::checkpointDeferredInserts() {
+  mapd_unique_lock<mapd_shared_mutex> insertLock(insertMutex_);
+  if (uncheckpointedRows_) {
+    dataMgr_->checkpoint(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+    uncheckpointedRows_ = 0;
+  }
 }
 
 void InsertOrderFragmenter::insertDataNoCheckpoint(InsertData& insertDataStruct) {
@@ -322,6 +824,7 @@ void InsertOrderFragmenter::replicateData(const InsertData& insertDataStruct) {
   CHECK(0 == numRowsLeft);
 
   mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+  bumpGeneration();
   for (auto& fragmentInfo : fragmentInfoVec_) {
     fragmentInfo.setChunkMetadataMap(fragmentInfo.shadowChunkMetadataMap);
   }
@@ -363,15 +866,86 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
         std::make_pair(insertDataStruct.columnIds[insertId], insertId));
   }
 
+  // The rows of a table with a sort column are appended in the order of its values.
+  SortedInsertData sortedInsertData;
+  const auto sortedColumnIt = std::find(insertDataStruct.columnIds.begin(),
+                                        insertDataStruct.columnIds.end(),
+                                        sortedColumnId_);
+  const auto sortedColumnPos = sortedColumnIt - insertDataStruct.columnIds.begin();
+  if (sortedColumnId_ && sortedColumnIt != insertDataStruct.columnIds.end() &&
+      insertDataStruct.numRows > 1) {
+    sort_insert_data(sortedInsertData, insertDataStruct, columnMap_, sortedColumnPos);
+  }
+  const auto indexColumnIt = std::find(insertDataStruct.columnIds.begin(),
+                                       insertDataStruct.columnIds.end(),
+                                       indexColumnId_);
+  const bool isIndexed =
+      indexColumnId_ && indexColumnIt != insertDataStruct.columnIds.end();
+  const auto indexColumnPos = indexColumnIt - insertDataStruct.columnIds.begin();
+  const auto primaryKeyColumnIt = std::find(insertDataStruct.columnIds.begin(),
+                                            insertDataStruct.columnIds.end(),
+                                            primaryKeyColumnId_);
+  const bool hasPrimaryKey =
+      primaryKeyColumnId_ && primaryKeyColumnIt != insertDataStruct.columnIds.end();
+  const auto primaryKeyColumnPos =
+      primaryKeyColumnIt - insertDataStruct.columnIds.begin();
+  const bool isPartitioned =
+      partitionInterval_ && sortedColumnIt != insertDataStruct.columnIds.end();
+  const auto partitionElemSize =
+      isPartitioned ? get_insert_elem_size(columnMap_.at(sortedColumnId_)
+                                               .get_column_desc()
+                                               ->columnType)
+                    : size_t(0);
+
   size_t numRowsLeft = insertDataStruct.numRows;
   size_t numRowsInserted = 0;
   vector<DataBlockPtr> dataCopy =
-      insertDataStruct.data;  // bc append data will move ptr forward and this violates
-                              // constness of InsertData
+      sortedInsertData.data.empty()
+          ? insertDataStruct.data
+          : sortedInsertData.data;  // bc append data will move ptr forward and this
+                                    // violates constness of InsertData
   if (numRowsLeft <= 0) {
     return;
   }
 
+  // DIFF encoded chunks only take the values within the frame of reference placed by
+  // their first append.
+  const auto numRowsForDiffEncodedCols = [&](size_t numRowsToInsert) {
+    for (size_t i = 0; i < insertDataStruct.columnIds.size(); ++i) {
+      const auto& chunk = columnMap_.find(insertDataStruct.columnIds[i])->second;
+      if (chunk.get_column_desc()->columnType.get_compression() == kENCODING_DIFF) {
+        numRowsToInsert = std::min(
+            numRowsToInsert, chunk.getNumElemsForInsertData(dataCopy[i], numRowsToInsert));
+      }
+    }
+    return numRowsToInsert;
+  };
+
+  // A fragment only gets the rows of a single partition, sorted they are contiguous.
+  const auto numRowsForPartition = [&](size_t numRowsToInsert) {
+    if (!isPartitioned) {
+      return numRowsToInsert;
+    }
+    const auto data = dataCopy[sortedColumnPos].numbersPtr;
+    const auto partition =
+        get_insert_partition(data, partitionElemSize, 0, partitionInterval_);
+    for (size_t row = 1; row < numRowsToInsert; ++row) {
+      if (get_insert_partition(data, partitionElemSize, row, partitionInterval_) !=
+          partition) {
+        return row;
+      }
+    }
+    return numRowsToInsert;
+  };
+  const auto isInInsertPartition = [&](const FragmentInfo& fragment) {
+    return !isPartitioned ||
+           isInPartition(fragment,
+                         get_insert_partition(dataCopy[sortedColumnPos].numbersPtr,
+                                              partitionElemSize,
+                                              0,
+                                              partitionInterval_));
+  };
+
   FragmentInfo* currentFragment = 0;
 
   if (fragmentInfoVec_.empty()) {  // if no fragments exist for table
@@ -402,6 +976,10 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
                                                              bytesLeft));
         }
       }
+      numRowsToInsert = numRowsForDiffEncodedCols(numRowsToInsert);
+      numRowsToInsert = isInInsertPartition(*currentFragment)
+                            ? numRowsForPartition(numRowsToInsert)
+                            : 0;
     }
 
     if (rowsLeftInCurrentFragment == 0 || numRowsToInsert == 0) {
@@ -428,11 +1006,43 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
                                                              bytesLeft));
         }
       }
+      numRowsToInsert = numRowsForPartition(numRowsForDiffEncodedCols(numRowsToInsert));
     }
 
     CHECK_GT(numRowsToInsert, size_t(0));  // would put us into an endless loop as we'd
                                            // never be able to insert anything
 
+    // The keys are added before the append moves the data past them. A fragment which
+    // lost its index to an update doesn't get a new one.
+    std::shared_ptr<ChunkKeyIndex> keyIndex;
+    if (isIndexed) {
+      if (!currentFragment->shadowNumTuples) {
+        keyIndex = std::make_shared<ChunkKeyIndex>();
+      } else {
+        const auto chunkMetadata = findChunkMetadata(*currentFragment, indexColumnId_);
+        keyIndex = chunkMetadata ? chunkMetadata->keyIndex : nullptr;
+      }
+      if (keyIndex) {
+        keyIndex->add(read_keys(dataCopy[indexColumnPos].numbersPtr,
+                                get_insert_elem_size(columnMap_.at(indexColumnId_)
+                                                         .get_column_desc()
+                                                         ->columnType),
+                                numRowsToInsert));
+      }
+    }
+    if (hasPrimaryKey) {
+      std::lock_guard<std::mutex> primaryKeyLock(primaryKeyMutex_);
+      if (primaryKeyIndex_) {
+        const auto& keyType =
+            columnMap_.at(primaryKeyColumnId_).get_column_desc()->columnType;
+        primaryKeyIndex_->add(read_keys(dataCopy[primaryKeyColumnPos].numbersPtr,
+                                        get_insert_elem_size(keyType),
+                                        numRowsToInsert),
+                              currentFragment->fragmentId,
+                              currentFragment->shadowNumTuples);
+      }
+    }
+
     // for each column, append the data in the appropriate insert buffer
     for (size_t i = 0; i < insertDataStruct.columnIds.size(); ++i) {
       int columnId = insertDataStruct.columnIds[i];
@@ -440,6 +1050,9 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
       assert(colMapIt != columnMap_.end());
       currentFragment->shadowChunkMetadataMap[columnId] =
           colMapIt->second.appendData(dataCopy[i], numRowsToInsert, numRowsInserted);
+      if (columnId == indexColumnId_) {
+        currentFragment->shadowChunkMetadataMap[columnId].keyIndex = keyIndex;
+      }
       auto varLenColInfoIt = varLenColInfo_.find(columnId);
       if (varLenColInfoIt != varLenColInfo_.end()) {
         varLenColInfoIt->second = colMapIt->second.get_buffer()->size();
@@ -471,6 +1084,7 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
     // for UpdateDeleteLock
 
     mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+    bumpGeneration();
     for (auto partIt = fragmentInfoVec_.begin() + startFragment;
          partIt != fragmentInfoVec_.end();
          ++partIt) {
@@ -480,6 +1094,7 @@ void InsertOrderFragmenter::insertDataImpl(InsertData& insertDataStruct) {
   }
   numTuples_ += insertDataStruct.numRows;
   dropFragmentsToSize(maxRows_);
+  dropExpiredPartitions();
 }
 
 FragmentInfo* InsertOrderFragmenter::createNewFragment(
@@ -514,6 +1129,7 @@ FragmentInfo* InsertOrderFragmenter::createNewFragment(
   }
 
   mapd_lock_guard<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+  bumpGeneration();
   fragmentInfoVec_.push_back(newFragmentInfo);
   return &(fragmentInfoVec_.back());
 }
@@ -27,7 +27,9 @@
 #include "../Shared/types.h"
 #include "AbstractFragmenter.h"
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -47,6 +49,9 @@ namespace Fragmenter_Namespace {
  * @brief	The InsertOrderFragmenter is a child class of
  * AbstractFragmenter, and fragments data in insert
  * order. Likely the default fragmenter
+ *
+ * With a sort column the rows of each insert are appended in the order of its values,
+ * so the fragments filled by a bulk insert cover disjoint ranges of the column.
  */
 
 class InsertOrderFragmenter : public AbstractFragmenter {
@@ -64,7 +69,12 @@ class InsertOrderFragmenter : public AbstractFragmenter {
       const size_t maxChunkSize = DEFAULT_MAX_CHUNK_SIZE,
       const size_t pageSize = DEFAULT_PAGE_SIZE /*default 1MB*/,
       const size_t maxRows = DEFAULT_MAX_ROWS,
-      const Data_Namespace::MemoryLevel defaultInsertLevel = Data_Namespace::DISK_LEVEL);
+      const Data_Namespace::MemoryLevel defaultInsertLevel = Data_Namespace::DISK_LEVEL,
+      const int sortedColumnId = 0,
+      const int64_t partitionInterval = 0,
+      const int64_t retention = 0,
+      const int indexColumnId = 0,
+      const int primaryKeyColumnId = 0);
 
   virtual ~InsertOrderFragmenter();
   /**
@@ -87,7 +97,22 @@ class InsertOrderFragmenter : public AbstractFragmenter {
 
   virtual void insertDataNoCheckpoint(InsertData& insertDataStruct);
 
+  virtual void insertDataDeferCheckpoint(InsertData& insertDataStruct,
+                                         const size_t commitIntervalMs,
+                                         const size_t maxPendingRows);
+
+  // Checkpoints the rows inserted by insertDataDeferCheckpoint since the last checkpoint.
+  void checkpointDeferredInserts();
+
   virtual void dropFragmentsToSize(const size_t maxRows);
+
+  virtual std::vector<int> compactFragments(const double minDeletedFraction);
+
+  virtual void dropFragments(const std::vector<int>& fragmentIds);
+
+  virtual std::vector<RowLocation> findPrimaryKeys(const std::vector<int64_t>& keys);
+
+  virtual std::mutex& getUpsertMutex() { return upsertMutex_; }
   /**
    * @brief get fragmenter's id
    */
@@ -99,6 +124,7 @@ class InsertOrderFragmenter : public AbstractFragmenter {
    */
   inline std::string getFragmenterType() { return fragmenterType_; }
   size_t getNumRows() { return numTuples_; }
+  size_t getGeneration() { return generation_; }
 
   static void updateColumn(const Catalog_Namespace::Catalog* catalog,
                            const std::string& tabName,
@@ -160,6 +186,7 @@ class InsertOrderFragmenter : public AbstractFragmenter {
   size_t pageSize_; /* Page size in bytes of each page making up a given chunk - passed to
                        BufferMgr in createChunk() */
   size_t numTuples_;
+  std::atomic<size_t> generation_;  // bumped under the write lock of fragmentInfoMutex_
   int maxFragmentId_;
   size_t maxChunkSize_;
   size_t maxRows_;
@@ -169,9 +196,18 @@ class InsertOrderFragmenter : public AbstractFragmenter {
   mapd_shared_mutex
       insertMutex_;  // to prevent race conditions on insert - only one insert statement
                      // should be going to a table at a time
+  size_t uncheckpointedRows_{0};  // guarded by insertMutex_
   Data_Namespace::MemoryLevel defaultInsertLevel_;
   bool hasMaterializedRowId_;
   int rowIdColId_;
+  int sortedColumnId_;
+  int64_t partitionInterval_;  // seconds of the sort column per fragment, 0 if none
+  int64_t retention_;          // seconds of partitions kept behind the newest row
+  int indexColumnId_;  // column the chunks keep a ChunkKeyIndex of, 0 if none
+  int primaryKeyColumnId_;  // column of the keys of the upserts, 0 if none
+  std::unique_ptr<PrimaryKeyIndex> primaryKeyIndex_;  // null until the first lookup
+  std::mutex primaryKeyMutex_;  // guards primaryKeyIndex_, after insertMutex_
+  std::mutex upsertMutex_;
   std::unordered_map<int, size_t> varLenColInfo_;
   std::shared_ptr<std::mutex> mutex_access_inmem_states;
 
@@ -186,8 +222,19 @@ class InsertOrderFragmenter : public AbstractFragmenter {
   FragmentInfo* createNewFragment(
       const Data_Namespace::MemoryLevel memoryLevel = Data_Namespace::DISK_LEVEL);
   void deleteFragments(const std::vector<int>& dropFragIds);
+  void bumpGeneration();
+  const ChunkMetadata* findChunkMetadata(const FragmentInfo& fragment,
+                                         const int columnId) const;
+  const ChunkStats* getPartitionStats(const FragmentInfo& fragment) const;
+  bool isInPartition(const FragmentInfo& fragment, const int64_t partition) const;
+  void dropExpiredPartitions();
 
   void getChunkMetadata();
+  void buildKeyIndexes();
+  /// Requires primaryKeyMutex_ and insertMutex_.
+  void buildPrimaryKeyIndex();
+  std::shared_ptr<Chunk_NS::Chunk> getCpuChunk(const ColumnDescriptor* cd,
+                                               const FragmentInfo& fragment);
 
   void lockInsertCheckpointData(const InsertData& insertDataStruct);
   void insertDataImpl(InsertData& insertDataStruct);
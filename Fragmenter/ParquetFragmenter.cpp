@@ -0,0 +1,591 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ParquetFragmenter.h"
+#include "../Catalog/Catalog.h"
+#include "../DataMgr/AbstractBuffer.h"
+#include "../DataMgr/DataMgr.h"
+#include "../DataMgr/ForeignStorageInterface.h"
+
+#include <glog/logging.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#ifdef ENABLE_IMPORT_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/exception.h>
+#include <parquet/statistics.h>
+#endif  // ENABLE_IMPORT_PARQUET
+
+namespace Fragmenter_Namespace {
+
+// Reads the chunks of the fragments of a ParquetFragmenter, a column of a row group each.
+class ParquetStorage : public Data_Namespace::ForeignStorageInterface {
+ public:
+  struct RowGroup {
+    size_t fileIdx;
+    int index;  // in the file
+  };
+
+  ParquetStorage(const Catalog_Namespace::Catalog* catalog,
+                 const std::vector<const ColumnDescriptor*>& columns)
+      : catalog_(catalog), columns_(columns) {}
+
+  void setRowGroups(const std::vector<std::string>& files,
+                    const std::vector<RowGroup>& rowGroups) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_ = files;
+    rowGroups_ = rowGroups;
+  }
+
+  void read(const ChunkKey& chunkKey,
+            Data_Namespace::AbstractBuffer* destBuffer,
+            const size_t numBytes) override;
+
+ private:
+  const Catalog_Namespace::Catalog* catalog_;
+  const std::vector<const ColumnDescriptor*> columns_;
+  std::mutex mutex_;  // guards the members below
+  std::vector<std::string> files_;
+  std::vector<RowGroup> rowGroups_;  // by fragment id
+};
+
+namespace {
+
+void throw_read_only() {
+  throw std::runtime_error(
+      "Cannot modify an external table, its Parquet files are read-only.");
+}
+
+#ifdef ENABLE_IMPORT_PARQUET
+std::vector<std::string> get_parquet_files(const std::string& path) {
+  namespace fs = boost::filesystem;
+  if (!fs::is_directory(path)) {
+    return {path};
+  }
+  std::vector<std::string> files;
+  for (fs::directory_iterator it(path), end_it; it != end_it; ++it) {
+    if (fs::is_regular_file(it->status()) && it->path().extension() == ".parquet") {
+      files.push_back(it->path().string());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+std::unique_ptr<parquet::arrow::FileReader> open_parquet_file(
+    const std::string& file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(file_path, &infile));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(
+      parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+  return reader;
+}
+
+parquet::Type::type get_physical_type(const SQLTypeInfo& ti) {
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+      return parquet::Type::BOOLEAN;
+    case kTINYINT:
+    case kSMALLINT:
+    case kINT:
+      return parquet::Type::INT32;
+    case kBIGINT:
+      return parquet::Type::INT64;
+    case kFLOAT:
+      return parquet::Type::FLOAT;
+    case kDOUBLE:
+      return parquet::Type::DOUBLE;
+    case kTEXT:
+    case kVARCHAR:
+    case kCHAR:
+      return parquet::Type::BYTE_ARRAY;
+    default:
+      CHECK(false);
+  }
+  return parquet::Type::BYTE_ARRAY;
+}
+
+// For the chunks the file has no statistics of. The smallest integer is the null.
+template <typename T>
+void fill_full_range_stats(ChunkMetadata& chunk_metadata) {
+  const T min = std::is_integral<T>::value ? std::numeric_limits<T>::min() + 1
+                                           : std::numeric_limits<T>::lowest();
+  chunk_metadata.fillChunkStats<T>(min, std::numeric_limits<T>::max(), true);
+}
+
+void fill_chunk_stats(ChunkMetadata& chunk_metadata,
+                      const parquet::ColumnChunkMetaData& column_chunk) {
+  const auto& ti = chunk_metadata.sqlType;
+  if (ti.is_string()) {
+    // The strings get their ids as the chunks are read, any id may show up.
+    chunk_metadata.fillChunkStats<int32_t>(
+        0, std::numeric_limits<int32_t>::max() - 1, true);
+    return;
+  }
+  const auto stats = column_chunk.is_stats_set() ? column_chunk.statistics() : nullptr;
+  if (!stats || !stats->HasMinMax()) {
+    switch (ti.get_type()) {
+      case kBOOLEAN:
+        chunk_metadata.fillChunkStats<int8_t>(0, 1, true);
+        break;
+      case kTINYINT:
+        fill_full_range_stats<int8_t>(chunk_metadata);
+        break;
+      case kSMALLINT:
+        fill_full_range_stats<int16_t>(chunk_metadata);
+        break;
+      case kINT:
+        fill_full_range_stats<int32_t>(chunk_metadata);
+        break;
+      case kBIGINT:
+        fill_full_range_stats<int64_t>(chunk_metadata);
+        break;
+      case kFLOAT:
+        fill_full_range_stats<float>(chunk_metadata);
+        break;
+      case kDOUBLE:
+        fill_full_range_stats<double>(chunk_metadata);
+        break;
+      default:
+        CHECK(false);
+    }
+    return;
+  }
+  const bool has_nulls = stats->null_count() > 0;
+  switch (column_chunk.type()) {
+    case parquet::Type::BOOLEAN: {
+      const auto typed_stats = std::static_pointer_cast<parquet::BoolStatistics>(stats);
+      chunk_metadata.fillChunkStats<int8_t>(
+          typed_stats->min(), typed_stats->max(), has_nulls);
+      break;
+    }
+    case parquet::Type::INT32: {
+      const auto typed_stats = std::static_pointer_cast<parquet::Int32Statistics>(stats);
+      chunk_metadata.fillChunkStats<int32_t>(
+          typed_stats->min(), typed_stats->max(), has_nulls);
+      break;
+    }
+    case parquet::Type::INT64: {
+      const auto typed_stats = std::static_pointer_cast<parquet::Int64Statistics>(stats);
+      chunk_metadata.fillChunkStats<int64_t>(
+          typed_stats->min(), typed_stats->max(), has_nulls);
+      break;
+    }
+    case parquet::Type::FLOAT: {
+      const auto typed_stats = std::static_pointer_cast<parquet::FloatStatistics>(stats);
+      chunk_metadata.fillChunkStats<float>(
+          typed_stats->min(), typed_stats->max(), has_nulls);
+      break;
+    }
+    case parquet::Type::DOUBLE: {
+      const auto typed_stats = std::static_pointer_cast<parquet::DoubleStatistics>(stats);
+      chunk_metadata.fillChunkStats<double>(
+          typed_stats->min(), typed_stats->max(), has_nulls);
+      break;
+    }
+    default:
+      CHECK(false);
+  }
+}
+
+void check_arrow_type(const arrow::Array& values,
+                      const arrow::Type::type type,
+                      const ColumnDescriptor* cd) {
+  if (values.type_id() != type) {
+    throw std::runtime_error("Cannot read Parquet values of type " +
+                             values.type()->ToString() + " into column " +
+                             cd->columnName + " of type " +
+                             cd->columnType.get_type_name());
+  }
+}
+
+template <typename ArrayType, typename T>
+void copy_arrow_values(const arrow::Array& values, const T null_sentinel, int8_t* dest) {
+  const auto& typed_values = static_cast<const ArrayType&>(values);
+  auto typed_dest = reinterpret_cast<T*>(dest);
+  for (int64_t i = 0; i < typed_values.length(); ++i) {
+    typed_dest[i] =
+        typed_values.IsNull(i) ? null_sentinel : static_cast<T>(typed_values.Value(i));
+  }
+}
+
+void copy_arrow_strings(const arrow::Array& values,
+                        StringDictionary* string_dict,
+                        int8_t* dest) {
+  const auto& typed_values = static_cast<const arrow::BinaryArray&>(values);
+  auto ids = reinterpret_cast<int32_t*>(dest);
+  std::vector<std::string> strings;
+  std::vector<int64_t> string_rows;
+  for (int64_t i = 0; i < typed_values.length(); ++i) {
+    if (typed_values.IsNull(i)) {
+      ids[i] = inline_int_null_value<int32_t>();
+      continue;
+    }
+    strings.push_back(typed_values.GetString(i));
+    if (strings.back().size() > StringDictionary::MAX_STRLEN) {
+      throw std::runtime_error("String too long for dictionary encoding.");
+    }
+    string_rows.push_back(i);
+  }
+  std::vector<int32_t> string_ids(strings.size());
+  string_dict->getOrAddBulk(strings, string_ids.data());
+  for (size_t i = 0; i < string_rows.size(); ++i) {
+    ids[string_rows[i]] = string_ids[i];
+  }
+}
+
+void copy_arrow_array(const arrow::Array& values,
+                      const ColumnDescriptor* cd,
+                      StringDictionary* string_dict,
+                      int8_t* dest) {
+  const auto& ti = cd->columnType;
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+      check_arrow_type(values, arrow::Type::BOOL, cd);
+      copy_arrow_values<arrow::BooleanArray, int8_t>(
+          values, inline_int_null_value<int8_t>(), dest);
+      break;
+    case kTINYINT:
+      check_arrow_type(values, arrow::Type::INT8, cd);
+      copy_arrow_values<arrow::Int8Array, int8_t>(
+          values, inline_int_null_value<int8_t>(), dest);
+      break;
+    case kSMALLINT:
+      check_arrow_type(values, arrow::Type::INT16, cd);
+      copy_arrow_values<arrow::Int16Array, int16_t>(
+          values, inline_int_null_value<int16_t>(), dest);
+      break;
+    case kINT:
+      check_arrow_type(values, arrow::Type::INT32, cd);
+      copy_arrow_values<arrow::Int32Array, int32_t>(
+          values, inline_int_null_value<int32_t>(), dest);
+      break;
+    case kBIGINT:
+      check_arrow_type(values, arrow::Type::INT64, cd);
+      copy_arrow_values<arrow::Int64Array, int64_t>(
+          values, inline_int_null_value<int64_t>(), dest);
+      break;
+    case kFLOAT:
+      check_arrow_type(values, arrow::Type::FLOAT, cd);
+      copy_arrow_values<arrow::FloatArray, float>(values, NULL_FLOAT, dest);
+      break;
+    case kDOUBLE:
+      check_arrow_type(values, arrow::Type::DOUBLE, cd);
+      copy_arrow_values<arrow::DoubleArray, double>(values, NULL_DOUBLE, dest);
+      break;
+    case kTEXT:
+    case kVARCHAR:
+    case kCHAR:
+      if (values.type_id() != arrow::Type::BINARY) {
+        check_arrow_type(values, arrow::Type::STRING, cd);
+      }
+      CHECK(string_dict);
+      copy_arrow_strings(values, string_dict, dest);
+      break;
+    default:
+      CHECK(false);
+  }
+}
+#endif  // ENABLE_IMPORT_PARQUET
+
+}  // namespace
+
+void ParquetStorage::read(const ChunkKey& chunkKey,
+                          Data_Namespace::AbstractBuffer* destBuffer,
+                          const size_t numBytes) {
+#ifdef ENABLE_IMPORT_PARQUET
+  CHECK_EQ(size_t(4), chunkKey.size());
+  CHECK_EQ(Data_Namespace::CPU_LEVEL, destBuffer->getType());
+  const auto column_it = std::find_if(
+      columns_.begin(), columns_.end(), [&chunkKey](const ColumnDescriptor* cd) {
+        return cd->columnId == chunkKey[2];
+      });
+  CHECK(column_it != columns_.end());
+  const auto cd = *column_it;
+  const int file_column = column_it - columns_.begin();
+  std::string file_path;
+  int row_group{-1};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CHECK_LT(static_cast<size_t>(chunkKey[3]), rowGroups_.size());
+    const auto& fragment_row_group = rowGroups_[chunkKey[3]];
+    file_path = files_[fragment_row_group.fileIdx];
+    row_group = fragment_row_group.index;
+  }
+  const auto& ti = cd->columnType;
+  StringDictionary* string_dict{nullptr};
+  if (ti.is_string()) {
+    const auto dd = catalog_->getMetadataForDict(ti.get_comp_param(), true);
+    CHECK(dd);
+    string_dict = dd->stringDict.get();
+  }
+  std::shared_ptr<arrow::Table> table;
+  PARQUET_THROW_NOT_OK(
+      open_parquet_file(file_path)->ReadRowGroup(row_group, {file_column}, &table));
+  const size_t chunk_size = table->num_rows() * ti.get_size();
+  const size_t read_size = numBytes ? numBytes : chunk_size;
+  if (read_size > chunk_size) {
+    throw std::runtime_error("Row group " + std::to_string(row_group) +
+                             " of Parquet file " + file_path +
+                             " has fewer rows than when the table was first queried.");
+  }
+  destBuffer->reserve(chunk_size);
+  auto dest = destBuffer->getMemoryPtr();
+  for (const auto& values : table->column(0)->data()->chunks()) {
+    copy_arrow_array(*values, cd, string_dict, dest);
+    dest += values->length() * ti.get_size();
+  }
+  destBuffer->setSize(read_size);
+#else
+  throw std::runtime_error("Parquet support not available");
+#endif  // ENABLE_IMPORT_PARQUET
+}
+
+ParquetFragmenter::ParquetFragmenter(const std::vector<int> chunkKeyPrefix,
+                                     std::vector<Chunk_NS::Chunk>& chunkVec,
+                                     Data_Namespace::DataMgr* dataMgr,
+                                     const Catalog_Namespace::Catalog* catalog,
+                                     const int physicalTableId,
+                                     const std::string& externalPath)
+    : chunkKeyPrefix_(chunkKeyPrefix)
+    , dataMgr_(dataMgr)
+    , physicalTableId_(physicalTableId)
+    , externalPath_(externalPath)
+    , generation_(next_fragmenter_generation())
+    , metadataLoaded_(false)
+    , numTuples_(0) {
+  for (auto& chunk : chunkVec) {
+    const auto cd = chunk.get_column_desc();
+    if (!cd->isSystemCol && !cd->isVirtualCol) {
+      columns_.push_back(cd);
+    }
+  }
+  storage_ = std::make_shared<ParquetStorage>(catalog, columns_);
+  dataMgr_->registerForeignStorage(chunkKeyPrefix_[0], chunkKeyPrefix_[1], storage_);
+}
+
+ParquetFragmenter::~ParquetFragmenter() {
+  dataMgr_->unregisterForeignStorage(chunkKeyPrefix_[0], chunkKeyPrefix_[1]);
+}
+
+void ParquetFragmenter::validateColumn(const ColumnDescriptor& cd) {
+  const auto& ti = cd.columnType;
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+    case kTINYINT:
+    case kSMALLINT:
+    case kINT:
+    case kBIGINT:
+    case kFLOAT:
+    case kDOUBLE:
+      if (ti.get_compression() == kENCODING_NONE) {
+        return;
+      }
+      break;
+    case kTEXT:
+    case kVARCHAR:
+    case kCHAR:
+      if (ti.get_compression() == kENCODING_DICT && ti.get_size() == 4) {
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  throw std::runtime_error("Cannot read column " + cd.columnName + " of type " +
+                           ti.get_type_name() + ", encoding " +
+                           ti.get_compression_name() + " from Parquet files.");
+}
+
+void ParquetFragmenter::loadMetadata() {
+  if (metadataLoaded_) {
+    return;
+  }
+#ifdef ENABLE_IMPORT_PARQUET
+  const auto files = get_parquet_files(externalPath_);
+  if (files.empty()) {
+    throw std::runtime_error("No Parquet files in " + externalPath_);
+  }
+  std::vector<ParquetStorage::RowGroup> row_groups;
+  std::deque<FragmentInfo> fragments;
+  size_t num_tuples{0};
+  for (size_t file_idx = 0; file_idx < files.size(); ++file_idx) {
+    const auto& file_path = files[file_idx];
+    const auto file_metadata = open_parquet_file(file_path)->parquet_reader()->metadata();
+    if (static_cast<size_t>(file_metadata->num_columns()) != columns_.size()) {
+      throw std::runtime_error("Parquet file " + file_path + " has " +
+                               std::to_string(file_metadata->num_columns()) +
+                               " columns, the table has " +
+                               std::to_string(columns_.size()));
+    }
+    for (size_t col_idx = 0; col_idx < columns_.size(); ++col_idx) {
+      const auto column_schema = file_metadata->schema()->Column(col_idx);
+      if (column_schema->physical_type() !=
+          get_physical_type(columns_[col_idx]->columnType)) {
+        throw std::runtime_error("Cannot read Parquet column " + column_schema->name() +
+                                 " of " + file_path + " into column " +
+                                 columns_[col_idx]->columnName + " of type " +
+                                 columns_[col_idx]->columnType.get_type_name());
+      }
+    }
+    for (int row_group = 0; row_group < file_metadata->num_row_groups(); ++row_group) {
+      const auto row_group_metadata = file_metadata->RowGroup(row_group);
+      const size_t num_rows = row_group_metadata->num_rows();
+      if (!num_rows) {
+        continue;
+      }
+      FragmentInfo fragment;
+      fragment.fragmentId = fragments.size();
+      fragment.shadowNumTuples = num_rows;
+      fragment.setPhysicalNumTuples(num_rows);
+      for (const auto levelSize : dataMgr_->levelSizes_) {
+        fragment.deviceIds.push_back(fragment.fragmentId % levelSize);
+      }
+      fragment.physicalTableId = physicalTableId_;
+      for (size_t col_idx = 0; col_idx < columns_.size(); ++col_idx) {
+        const auto cd = columns_[col_idx];
+        ChunkMetadata chunk_metadata;
+        chunk_metadata.sqlType = cd->columnType;
+        chunk_metadata.numElements = num_rows;
+        chunk_metadata.numBytes = num_rows * cd->columnType.get_size();
+        fill_chunk_stats(chunk_metadata, *row_group_metadata->ColumnChunk(col_idx));
+        fragment.setChunkMetadata(cd->columnId, chunk_metadata);
+      }
+      fragments.push_back(fragment);
+      row_groups.push_back({file_idx, row_group});
+      num_tuples += num_rows;
+    }
+  }
+  storage_->setRowGroups(files, row_groups);
+  fragmentInfoVec_ = fragments;
+  numTuples_ = num_tuples;
+  metadataLoaded_ = true;
+  LOG(INFO) << "Read the metadata of " << fragmentInfoVec_.size() << " row groups of "
+            << files.size() << " Parquet files in " << externalPath_;
+#else
+  throw std::runtime_error("Parquet support not available");
+#endif  // ENABLE_IMPORT_PARQUET
+}
+
+TableInfo ParquetFragmenter::getFragmentsForQuery() {
+  std::lock_guard<std::mutex> lock(metadataMutex_);
+  loadMetadata();
+  TableInfo queryInfo;
+  queryInfo.chunkKeyPrefix = chunkKeyPrefix_;
+  queryInfo.fragments = fragmentInfoVec_;
+  if (queryInfo.fragments.empty()) {
+    // Same dummy empty fragment as the InsertOrderFragmenter has for an empty table.
+    FragmentInfo emptyFragmentInfo;
+    emptyFragmentInfo.fragmentId = 0;
+    emptyFragmentInfo.shadowNumTuples = 0;
+    emptyFragmentInfo.setPhysicalNumTuples(0);
+    emptyFragmentInfo.deviceIds.resize(dataMgr_->levelSizes_.size());
+    emptyFragmentInfo.physicalTableId = physicalTableId_;
+    queryInfo.fragments.push_back(emptyFragmentInfo);
+  }
+  queryInfo.setPhysicalNumTuples(numTuples_);
+  return queryInfo;
+}
+
+size_t ParquetFragmenter::getNumRows() {
+  std::lock_guard<std::mutex> lock(metadataMutex_);
+  loadMetadata();
+  return numTuples_;
+}
+
+void ParquetFragmenter::insertData(InsertData& insertDataStruct) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::insertDataNoCheckpoint(InsertData& insertDataStruct) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::insertDataDeferCheckpoint(InsertData& insertDataStruct,
+                                                  const size_t commitIntervalMs,
+                                                  const size_t maxPendingRows) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::dropFragmentsToSize(const size_t maxRows) {
+  throw_read_only();
+}
+
+std::vector<int> ParquetFragmenter::compactFragments(const double minDeletedFraction) {
+  // Nothing is ever deleted.
+  return {};
+}
+
+void ParquetFragmenter::dropFragments(const std::vector<int>& fragmentIds) {
+  throw_read_only();
+}
+
+std::vector<RowLocation> ParquetFragmenter::findPrimaryKeys(
+    const std::vector<int64_t>& keys) {
+  throw std::runtime_error("An external table has no primary key.");
+}
+
+void ParquetFragmenter::updateColumn(const Catalog_Namespace::Catalog* catalog,
+                                     const TableDescriptor* td,
+                                     const ColumnDescriptor* cd,
+                                     const int fragmentId,
+                                     const std::vector<uint64_t>& fragOffsets,
+                                     const std::vector<ScalarTargetValue>& rhsValues,
+                                     const SQLTypeInfo& rhsType,
+                                     const Data_Namespace::MemoryLevel memoryLevel,
+                                     UpdelRoll& updelRoll) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::updateColumn(const Catalog_Namespace::Catalog* catalog,
+                                     const TableDescriptor* td,
+                                     const ColumnDescriptor* cd,
+                                     const int fragmentId,
+                                     const std::vector<uint64_t>& fragOffsets,
+                                     const ScalarTargetValue& rhsValue,
+                                     const SQLTypeInfo& rhsType,
+                                     const Data_Namespace::MemoryLevel memoryLevel,
+                                     UpdelRoll& updelRoll) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::updateColumnMetadata(const ColumnDescriptor* cd,
+                                             FragmentInfo& fragment,
+                                             std::shared_ptr<Chunk_NS::Chunk> chunk,
+                                             const bool null,
+                                             const double dmax,
+                                             const double dmin,
+                                             const int64_t lmax,
+                                             const int64_t lmin,
+                                             const SQLTypeInfo& rhsType,
+                                             UpdelRoll& updelRoll) {
+  throw_read_only();
+}
+
+void ParquetFragmenter::updateMetadata(const Catalog_Namespace::Catalog* catalog,
+                                       const MetaDataKey& key,
+                                       UpdelRoll& updelRoll) {
+  throw_read_only();
+}
+
+}  // namespace Fragmenter_Namespace
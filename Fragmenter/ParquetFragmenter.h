@@ -0,0 +1,152 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ParquetFragmenter.h
+ * @brief   Fragments of an external table queried in place from Parquet files.
+ *
+ * Every row group of the files is a fragment. Its chunk metadata comes from the
+ * statistics in the footers, read on the first query, so the executor skips the row
+ * groups a filter rules out without reading them. The chunks are read from the files
+ * when the CPU pool misses them, one column of one row group at a time, through the
+ * storage the fragmenter registers with the DataMgr. The table is read-only and the
+ * files are assumed not to change; the table is dropped and created again otherwise.
+ *
+ * The columns of the table map to the columns of the files by position, like COPY of
+ * Parquet files does.
+ */
+
+#ifndef PARQUET_FRAGMENTER_H
+#define PARQUET_FRAGMENTER_H
+
+#include "../Chunk/Chunk.h"
+#include "AbstractFragmenter.h"
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Data_Namespace {
+class DataMgr;
+}
+
+namespace Fragmenter_Namespace {
+
+class ParquetStorage;
+
+class ParquetFragmenter : public AbstractFragmenter {
+ public:
+  // The path is a Parquet file or a directory of .parquet files, taken in name order.
+  ParquetFragmenter(const std::vector<int> chunkKeyPrefix,
+                    std::vector<Chunk_NS::Chunk>& chunkVec,
+                    Data_Namespace::DataMgr* dataMgr,
+                    const Catalog_Namespace::Catalog* catalog,
+                    const int physicalTableId,
+                    const std::string& externalPath);
+
+  virtual ~ParquetFragmenter();
+
+  virtual TableInfo getFragmentsForQuery();
+
+  virtual void insertData(InsertData& insertDataStruct);
+
+  virtual void insertDataNoCheckpoint(InsertData& insertDataStruct);
+
+  virtual void insertDataDeferCheckpoint(InsertData& insertDataStruct,
+                                         const size_t commitIntervalMs,
+                                         const size_t maxPendingRows);
+
+  virtual void dropFragmentsToSize(const size_t maxRows);
+
+  virtual std::vector<int> compactFragments(const double minDeletedFraction);
+
+  virtual void dropFragments(const std::vector<int>& fragmentIds);
+
+  virtual std::vector<RowLocation> findPrimaryKeys(const std::vector<int64_t>& keys);
+
+  virtual std::mutex& getUpsertMutex() { return upsertMutex_; }
+
+  inline int getFragmenterId() { return chunkKeyPrefix_.back(); }
+
+  inline std::string getFragmenterType() { return "Parquet"; }
+
+  size_t getNumRows();
+
+  size_t getGeneration() { return generation_; }
+
+  virtual void updateColumn(const Catalog_Namespace::Catalog* catalog,
+                            const TableDescriptor* td,
+                            const ColumnDescriptor* cd,
+                            const int fragmentId,
+                            const std::vector<uint64_t>& fragOffsets,
+                            const std::vector<ScalarTargetValue>& rhsValues,
+                            const SQLTypeInfo& rhsType,
+                            const Data_Namespace::MemoryLevel memoryLevel,
+                            UpdelRoll& updelRoll);
+
+  virtual void updateColumn(const Catalog_Namespace::Catalog* catalog,
+                            const TableDescriptor* td,
+                            const ColumnDescriptor* cd,
+                            const int fragmentId,
+                            const std::vector<uint64_t>& fragOffsets,
+                            const ScalarTargetValue& rhsValue,
+                            const SQLTypeInfo& rhsType,
+                            const Data_Namespace::MemoryLevel memoryLevel,
+                            UpdelRoll& updelRoll);
+
+  virtual void updateColumnMetadata(const ColumnDescriptor* cd,
+                                    FragmentInfo& fragment,
+                                    std::shared_ptr<Chunk_NS::Chunk> chunk,
+                                    const bool null,
+                                    const double dmax,
+                                    const double dmin,
+                                    const int64_t lmax,
+                                    const int64_t lmin,
+                                    const SQLTypeInfo& rhsType,
+                                    UpdelRoll& updelRoll);
+
+  virtual void updateMetadata(const Catalog_Namespace::Catalog* catalog,
+                              const MetaDataKey& key,
+                              UpdelRoll& updelRoll);
+
+  // Throws if a column of the table can't be read from Parquet files in place.
+  static void validateColumn(const ColumnDescriptor& cd);
+
+ private:
+  std::vector<int> chunkKeyPrefix_;
+  Data_Namespace::DataMgr* dataMgr_;
+  const int physicalTableId_;
+  const std::string externalPath_;
+  std::vector<const ColumnDescriptor*> columns_;  // in the order of the file columns
+  std::shared_ptr<ParquetStorage> storage_;
+  const size_t generation_;
+  std::mutex upsertMutex_;
+  std::mutex metadataMutex_;  // guards the members below
+  bool metadataLoaded_;
+  std::deque<FragmentInfo> fragmentInfoVec_;
+  size_t numTuples_;
+
+  void loadMetadata();
+
+  ParquetFragmenter(const ParquetFragmenter&);
+  ParquetFragmenter& operator=(const ParquetFragmenter&);
+};
+
+}  // namespace Fragmenter_Namespace
+
+#endif  // PARQUET_FRAGMENTER_H
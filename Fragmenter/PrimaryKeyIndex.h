@@ -0,0 +1,68 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    PrimaryKeyIndex.h
+ * @brief   Location of the row of every key of the primary key column of a table.
+ *
+ * The loads of a table with a primary key look their keys up to update the rows
+ * already there, or skip them, instead of appending duplicates. The fragmenter builds
+ * the index from the chunks of the key column on the first lookup and adds the keys of
+ * every append. It isn't persisted; what the chunks hold is, and the fragmenter checks
+ * the rows found against them, so a stale location is only a miss.
+ */
+
+#ifndef PRIMARY_KEY_INDEX_H
+#define PRIMARY_KEY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Fragmenter_Namespace {
+
+struct RowLocation {
+  int fragmentId;  // -1 if the key isn't in the table
+  size_t offset;
+};
+
+class PrimaryKeyIndex {
+ public:
+  // A later row of a key replaces the earlier one: compaction appends the live rows of
+  // a fragment again before it drops the fragment.
+  void add(const std::vector<int64_t>& keys,
+           const int fragmentId,
+           const size_t firstOffset) {
+    for (size_t i = 0; i < keys.size(); ++i) {
+      locations_[keys[i]] = RowLocation{fragmentId, firstOffset + i};
+    }
+  }
+
+  RowLocation find(const int64_t key) const {
+    const auto it = locations_.find(key);
+    return it == locations_.end() ? RowLocation{-1, 0} : it->second;
+  }
+
+  size_t size() const { return locations_.size(); }
+
+ private:
+  std::unordered_map<int64_t, RowLocation> locations_;
+};
+
+}  // namespace Fragmenter_Namespace
+
+#endif  // PRIMARY_KEY_INDEX_H
@@ -16,7 +16,9 @@
 #include <algorithm>
 #include <boost/variant.hpp>
 #include <boost/variant/get.hpp>
+#include <cstring>
 #include <limits>
+#include <list>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -25,6 +27,7 @@
 #include "DataMgr/DataMgr.h"
 #include "Fragmenter/InsertOrderFragmenter.h"
 #include "Shared/TypedDataAccessors.h"
+#include "Shared/checked_alloc.h"
 #include "Shared/thread_count.h"
 
 namespace Fragmenter_Namespace {
@@ -96,6 +99,15 @@ void InsertOrderFragmenter::updateColumn(const Catalog_Namespace::Catalog* catal
     return;
   }
   CHECK(nrow == nval || 1 == nval);
+  if (cd->columnType.get_compression() == kENCODING_DIFF) {
+    throw std::runtime_error("UPDATE of DIFF encoded column " + cd->columnName +
+                             " is not supported.");
+  }
+  if (cd->columnId == primaryKeyColumnId_) {
+    // The rows move to other keys; the next upsert rebuilds the index.
+    std::lock_guard<std::mutex> primaryKeyLock(primaryKeyMutex_);
+    primaryKeyIndex_.reset();
+  }
 
   auto fragment_it = std::find_if(
       fragmentInfoVec_.begin(), fragmentInfoVec_.end(), [=](FragmentInfo& f) -> bool {
@@ -400,6 +412,7 @@ void InsertOrderFragmenter::updateColumn(const Catalog_Namespace::Catalog* catal
           const MetaDataKey& key,
           UpdelRoll& updelRoll) {
         mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+        bumpGeneration();
         if (updelRoll.chunkMetadata.count(key)) {
           auto& fragmentInfo = *key.second;
           const auto& chunkMetadata = updelRoll.chunkMetadata[key];
@@ -420,6 +433,298 @@ void InsertOrderFragmenter::updateColumn(const Catalog_Namespace::Catalog* catal
         }
       }
 
+namespace {
+
+int64_t read_int(const int8_t* ptr, const size_t width) {
+  switch (width) {
+    case 1:
+      return *reinterpret_cast<const int8_t*>(ptr);
+    case 2:
+      return *reinterpret_cast<const int16_t*>(ptr);
+    case 4:
+      return *reinterpret_cast<const int32_t*>(ptr);
+    case 8:
+      return *reinterpret_cast<const int64_t*>(ptr);
+    default:
+      CHECK(false);
+  }
+  return 0;
+}
+
+void write_int(int8_t* ptr, const size_t width, const int64_t val) {
+  switch (width) {
+    case 1:
+      *reinterpret_cast<int8_t*>(ptr) = val;
+      break;
+    case 2:
+      *reinterpret_cast<int16_t*>(ptr) = val;
+      break;
+    case 4:
+      *reinterpret_cast<int32_t*>(ptr) = val;
+      break;
+    case 8:
+      *reinterpret_cast<int64_t*>(ptr) = val;
+      break;
+    default:
+      CHECK(false);
+  }
+}
+
+int64_t int_null(const size_t width) {
+  switch (width) {
+    case 1:
+      return inline_int_null_value<int8_t>();
+    case 2:
+      return inline_int_null_value<int16_t>();
+    case 4:
+      return inline_int_null_value<int32_t>();
+    case 8:
+      return inline_int_null_value<int64_t>();
+    default:
+      CHECK(false);
+  }
+  return 0;
+}
+
+// Live rows of the columns of a fragment, in the layout insertDataImpl takes them in.
+struct LiveRows {
+  InsertData insertData;
+  std::vector<std::unique_ptr<int8_t[]>> numbers;
+  std::list<std::vector<std::string>> strings;
+  std::list<std::vector<ArrayDatum>> arrays;
+};
+
+void copy_live_rows(LiveRows& liveRows,
+                    const Chunk_NS::Chunk& chunk,
+                    const std::vector<size_t>& liveRowIds) {
+  const auto& ti = chunk.get_column_desc()->columnType;
+  const auto data = chunk.get_buffer()->getMemoryPtr();
+  DataBlockPtr block;
+  if (ti.is_varlen() && !ti.is_fixlen_array()) {
+    const auto index =
+        reinterpret_cast<const StringOffsetT*>(chunk.get_index_buf()->getMemoryPtr());
+    if (ti.is_array()) {
+      liveRows.arrays.emplace_back();
+      auto& arrays = liveRows.arrays.back();
+      for (const auto row : liveRowIds) {
+        const size_t len = index[row + 1] - index[row];
+        if (len == 0) {
+          arrays.emplace_back(0, nullptr, true);
+          continue;
+        }
+        auto ptr = reinterpret_cast<int8_t*>(checked_malloc(len));
+        memcpy(ptr, data + index[row], len);
+        arrays.emplace_back(len, ptr, false);
+      }
+      block.arraysPtr = &arrays;
+    } else {
+      liveRows.strings.emplace_back();
+      auto& strings = liveRows.strings.back();
+      for (const auto row : liveRowIds) {
+        strings.emplace_back(reinterpret_cast<const char*>(data + index[row]),
+                             index[row + 1] - index[row]);
+      }
+      block.stringsPtr = &strings;
+    }
+  } else if (ti.is_fixlen_array()) {
+    const size_t len = ti.get_size();
+    liveRows.arrays.emplace_back();
+    auto& arrays = liveRows.arrays.back();
+    for (const auto row : liveRowIds) {
+      auto ptr = reinterpret_cast<int8_t*>(checked_malloc(len));
+      memcpy(ptr, data + row * len, len);
+      arrays.emplace_back(len, ptr, false);
+    }
+    block.arraysPtr = &arrays;
+  } else if (ti.get_compression() == kENCODING_FIXED ||
+             ti.get_compression() == kENCODING_DIFF) {
+    // The encoders take these in the logical width, with the null sentinel of the
+    // column's narrow type for FIXED and of the logical type for DIFF.
+    const bool isDiff = ti.get_compression() == kENCODING_DIFF;
+    const size_t narrowWidth = ti.get_size();
+    const size_t width = ti.get_logical_size();
+    const auto values = isDiff ? data + sizeof(int64_t) : data;
+    const auto baseline = isDiff ? read_int(data, sizeof(int64_t)) : 0;
+    std::unique_ptr<int8_t[]> dst(new int8_t[liveRowIds.size() * width]);
+    for (size_t i = 0; i < liveRowIds.size(); ++i) {
+      auto val = read_int(values + liveRowIds[i] * narrowWidth, narrowWidth);
+      if (isDiff) {
+        val = val == int_null(narrowWidth)
+                  ? int_null(width)
+                  : static_cast<int64_t>(static_cast<uint64_t>(baseline) +
+                                         static_cast<uint64_t>(val));
+      }
+      write_int(dst.get() + i * width, width, val);
+    }
+    block.numbersPtr = dst.get();
+    liveRows.numbers.push_back(std::move(dst));
+  } else {
+    const size_t width = ti.get_size();
+    std::unique_ptr<int8_t[]> dst(new int8_t[liveRowIds.size() * width]);
+    for (size_t i = 0; i < liveRowIds.size(); ++i) {
+      memcpy(dst.get() + i * width, data + liveRowIds[i] * width, width);
+    }
+    block.numbersPtr = dst.get();
+    liveRows.numbers.push_back(std::move(dst));
+  }
+  liveRows.insertData.columnIds.push_back(chunk.get_column_desc()->columnId);
+  liveRows.insertData.columnDescriptors[chunk.get_column_desc()->columnId] =
+      chunk.get_column_desc();
+  liveRows.insertData.data.push_back(block);
+}
+
+}  // namespace
+
+std::vector<int> InsertOrderFragmenter::compactFragments(
+    const double minDeletedFraction) {
+  mapd_unique_lock<mapd_shared_mutex> insertLock(insertMutex_);
+  const ColumnDescriptor* deletedCd{nullptr};
+  for (const auto& col : columnMap_) {
+    if (col.second.get_column_desc()->isDeletedCol) {
+      deletedCd = col.second.get_column_desc();
+    }
+  }
+  if (!deletedCd) {
+    return {};
+  }
+  const auto getChunk = [this](const ColumnDescriptor* cd,
+                               const FragmentInfo& fragment,
+                               const Data_Namespace::MemoryLevel memoryLevel) {
+    const auto& chunkMetadata = fragment.getChunkMetadataMapPhysical().at(cd->columnId);
+    ChunkKey chunkKey = chunkKeyPrefix_;
+    chunkKey.push_back(cd->columnId);
+    chunkKey.push_back(fragment.fragmentId);
+    return Chunk_NS::Chunk::getChunk(cd,
+                                     dataMgr_,
+                                     chunkKey,
+                                     memoryLevel,
+                                     fragment.deviceIds[static_cast<int>(memoryLevel)],
+                                     chunkMetadata.numBytes,
+                                     chunkMetadata.numElements);
+  };
+
+  std::vector<int> candidateIds;
+  for (const auto& fragment : fragmentInfoVec_) {
+    const auto& chunkMetadataMap = fragment.getChunkMetadataMapPhysical();
+    const auto deletedMetaIt = chunkMetadataMap.find(deletedCd->columnId);
+    if (fragment.getPhysicalNumTuples() > 0 && deletedMetaIt != chunkMetadataMap.end() &&
+        deletedMetaIt->second.chunkStats.max.tinyintval) {
+      candidateIds.push_back(fragment.fragmentId);
+    }
+  }
+
+  std::vector<int> compactedIds;
+  for (const auto fragmentId : candidateIds) {
+    // Found by id, the inserts of the previous candidates can add fragments. Adding
+    // fragments to the deque leaves the reference valid.
+    auto& fragment = *std::find_if(
+        fragmentInfoVec_.begin(),
+        fragmentInfoVec_.end(),
+        [fragmentId](const FragmentInfo& f) { return f.fragmentId == fragmentId; });
+    const auto numRows = fragment.getPhysicalNumTuples();
+    std::vector<size_t> liveRowIds;
+    {
+      const auto deletedChunk = getChunk(deletedCd, fragment, Data_Namespace::CPU_LEVEL);
+      const auto deleted = deletedChunk->get_buffer()->getMemoryPtr();
+      for (size_t row = 0; row < numRows; ++row) {
+        if (!deleted[row]) {
+          liveRowIds.push_back(row);
+        }
+      }
+    }
+    const auto numDeleted = numRows - liveRowIds.size();
+    if (numDeleted == 0 || numDeleted < minDeletedFraction * numRows) {
+      continue;
+    }
+
+    // The live rows go to the insert buffers, which mustn't be the compacted fragment.
+    if (fragmentId == fragmentInfoVec_.back().fragmentId) {
+      createNewFragment(defaultInsertLevel_);
+      for (auto& varLenColInfoIt : varLenColInfo_) {
+        varLenColInfoIt.second = 0;
+      }
+    }
+    // The rows of the fragment are counted again by the insert.
+    CHECK_GE(numTuples_, numRows);
+    numTuples_ -= numRows;
+    if (!liveRowIds.empty()) {
+      LiveRows liveRows;
+      {
+        std::vector<std::shared_ptr<Chunk_NS::Chunk>> chunks;
+        for (const auto& col : columnMap_) {
+          const auto cd = col.second.get_column_desc();
+          if (cd->isDeletedCol ||
+              (hasMaterializedRowId_ && cd->columnId == rowIdColId_)) {
+            continue;
+          }
+          chunks.push_back(getChunk(cd, fragment, Data_Namespace::CPU_LEVEL));
+          copy_live_rows(liveRows, *chunks.back(), liveRowIds);
+        }
+      }
+      liveRows.insertData.databaseId = chunkKeyPrefix_[0];
+      liveRows.insertData.tableId = chunkKeyPrefix_[1];
+      liveRows.insertData.numRows = liveRowIds.size();
+      liveRows.insertData.bypass.resize(liveRows.insertData.columnIds.size(), false);
+      insertDataImpl(liveRows.insertData);
+    }
+
+    // Marking all the rows deleted keeps the rows from being seen twice if the
+    // fragment outlives a crash after the next checkpoint.
+    const auto deletedChunk = getChunk(deletedCd, fragment, defaultInsertLevel_);
+    const auto deletedBuffer = deletedChunk->get_buffer();
+    std::vector<int8_t> deleted(numRows, 1);
+    deletedBuffer->write(deleted.data(), numRows);
+    deletedBuffer->encoder->updateStats(int64_t(1), false);
+    {
+      mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+      bumpGeneration();
+      auto chunkMetadataMap = fragment.getChunkMetadataMapPhysical();
+      deletedBuffer->encoder->getMetadata(chunkMetadataMap[deletedCd->columnId]);
+      fragment.shadowChunkMetadataMap = chunkMetadataMap;
+      fragment.setChunkMetadataMap(chunkMetadataMap);
+    }
+    ChunkKey deletedKey = chunkKeyPrefix_;
+    deletedKey.push_back(deletedCd->columnId);
+    deletedKey.push_back(fragmentId);
+    if (defaultInsertLevel_ != Data_Namespace::CPU_LEVEL) {
+      dataMgr_->deleteChunksWithPrefix(deletedKey, Data_Namespace::CPU_LEVEL);
+    }
+    dataMgr_->deleteChunksWithPrefix(deletedKey, Data_Namespace::GPU_LEVEL);
+    compactedIds.push_back(fragmentId);
+  }
+  LOG_IF(INFO, !compactedIds.empty())
+      << "compactFragments, fragments compacted: " << compactedIds.size()
+      << " numTuples post: " << numTuples_;
+  return compactedIds;
+}
+
+void InsertOrderFragmenter::dropFragments(const std::vector<int>& fragmentIds) {
+  mapd_unique_lock<mapd_shared_mutex> insertLock(insertMutex_);
+  {
+    mapd_unique_lock<mapd_shared_mutex> writeLock(fragmentInfoMutex_);
+    bumpGeneration();
+    for (const auto fragmentId : fragmentIds) {
+      const auto fragmentIt = std::find_if(
+          fragmentInfoVec_.begin(),
+          fragmentInfoVec_.end(),
+          [fragmentId](const FragmentInfo& f) { return f.fragmentId == fragmentId; });
+      CHECK(fragmentIt != fragmentInfoVec_.end());
+      // The insert buffers are never in a compacted fragment.
+      CHECK_NE(fragmentId, fragmentInfoVec_.back().fragmentId);
+      fragmentInfoVec_.erase(fragmentIt);
+    }
+  }
+  // Unlike deleteFragments, the caller already holds the UpdateDeleteLock of the table.
+  for (const auto fragmentId : fragmentIds) {
+    for (const auto& col : columnMap_) {
+      ChunkKey fragmentPrefix = chunkKeyPrefix_;
+      fragmentPrefix.push_back(col.first);
+      fragmentPrefix.push_back(fragmentId);
+      dataMgr_->deleteChunksWithPrefix(fragmentPrefix);
+    }
+  }
+}
+
 }  // namespace Fragmenter_Namespace
 
 void UpdelRoll::commitUpdate() {
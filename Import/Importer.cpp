@@ -27,15 +27,21 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <csignal>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <future>
 #include <iomanip>
 #include <iostream>
 #include <list>
 #include <mutex>
+#include <numeric>
 #include <stack>
 #include <stdexcept>
 #include <thread>
@@ -49,6 +55,7 @@
 #include "../Shared/import_helpers.h"
 #include "../Shared/mapd_glob.h"
 #include "../Shared/mapdpath.h"
+#include "../Shared/Metrics.h"
 #include "../Shared/measure.h"
 #include "../Shared/scope.h"
 #include "../Shared/shard_key.h"
@@ -63,6 +70,15 @@
 #include "gen-cpp/MapD.h"
 
 #include <arrow/api.h>
+#ifdef ENABLE_IMPORT_PARQUET
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/exception.h>
+#endif  // ENABLE_IMPORT_PARQUET
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "../Archive/PosixFileArchive.h"
 
@@ -70,6 +86,9 @@
 
 using std::ostream;
 
+size_t g_load_commit_interval_ms{0};
+size_t g_load_commit_max_rows{1000000};
+
 namespace {
 
 struct OGRDataSourceDeleter {
@@ -118,6 +137,10 @@ using FeaturePtrVector = std::vector<OGRFeatureUqPtr>;
 
 static constexpr bool PROMOTE_POLYGON_TO_MULTIPOLYGON = true;
 
+// Detection samples at most this many ranges of a file, of this many bytes each.
+static constexpr size_t DETECT_SAMPLE_RANGES = 8;
+static constexpr size_t DETECT_SAMPLE_RANGE_BYTES = 1 << 20;
+
 static mapd_shared_mutex status_mutex;
 static std::map<std::string, ImportStatus> import_status_map;
 
@@ -129,6 +152,7 @@ Importer::Importer(Catalog_Namespace::Catalog& c,
 
 Importer::Importer(Loader* providedLoader, const std::string& f, const CopyParams& p)
     : DataStreamSink(p, f), loader(providedLoader) {
+  loader->set_skip_duplicate_keys(p.skip_duplicate_keys);
   import_id = boost::filesystem::path(file_path).filename().string();
   file_size = 0;
   max_threads = 0;
@@ -213,6 +237,72 @@ static const bool is_eol(const char& p, const std::string& line_delims) {
   return false;
 }
 
+// Finds the bytes get_row has to look at, the delimiters, quotes and the like. The other
+// bytes, most of the input, are skipped 16 at a time where SSE2 is available.
+class SpecialCharFinder {
+ public:
+  SpecialCharFinder(const CopyParams& copy_params, const bool has_arrays)
+      : num_chars_(0) {
+    add(copy_params.delimiter);
+    add(copy_params.line_delim);
+    add('\r');
+    add('\n');
+    add(copy_params.escape);
+    if (copy_params.quoted) {
+      add(copy_params.quote);
+    }
+    if (has_arrays) {
+      add(copy_params.array_begin);
+      add(copy_params.array_end);
+    }
+  }
+
+  // Returns the first special byte in [p, end), end if there is none.
+  const char* next(const char* p, const char* end) const {
+#if defined(__SSE2__)
+    while (end - p >= 16) {
+      const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      auto matches = _mm_cmpeq_epi8(block, char_vecs_[0]);
+      for (size_t i = 1; i < num_chars_; ++i) {
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, char_vecs_[i]));
+      }
+      const int mask = _mm_movemask_epi8(matches);
+      if (mask) {
+        return p + __builtin_ctz(mask);
+      }
+      p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+      if (std::find(chars_, chars_ + num_chars_, *p) != chars_ + num_chars_) {
+        return p;
+      }
+    }
+    return end;
+  }
+
+ private:
+  static constexpr size_t kMaxChars{8};
+
+  void add(const char c) {
+    if (std::find(chars_, chars_ + num_chars_, c) != chars_ + num_chars_) {
+      return;
+    }
+    CHECK_LT(num_chars_, kMaxChars);
+    chars_[num_chars_] = c;
+#if defined(__SSE2__)
+    char_vecs_[num_chars_] = _mm_set1_epi8(c);
+#endif
+    ++num_chars_;
+  }
+
+  char chars_[kMaxChars];
+#if defined(__SSE2__)
+  __m128i char_vecs_[kMaxChars];
+#endif
+  size_t num_chars_;
+};
+
 static const char* get_row(const char* buf,
                            const char* buf_end,
                            const char* entire_buf_end,
@@ -229,7 +319,10 @@ static const char* get_row(const char* buf,
   bool strip_quotes = false;
   try_single_thread = false;
   std::string line_endings({copy_params.line_delim, '\r', '\n'});
-  for (p = buf; p < entire_buf_end; p++) {
+  const SpecialCharFinder special_chars(copy_params, is_array != nullptr);
+  // Only the special bytes change the state, the others end up in the fields as is.
+  for (p = special_chars.next(buf, entire_buf_end); p < entire_buf_end;
+       p = special_chars.next(p + 1, entire_buf_end)) {
     if (*p == copy_params.escape && p < entire_buf_end - 1 &&
         *(p + 1) == copy_params.quote) {
       p++;
@@ -438,14 +531,10 @@ static size_t find_beginning(const char* buffer,
   if (begin == 0 || (begin > 0 && buffer[begin - 1] == copy_params.line_delim)) {
     return 0;
   }
-  size_t i;
   const char* buf = buffer + begin;
-  for (i = 0; i < end - begin; i++) {
-    if (buf[i] == copy_params.line_delim) {
-      return i + 1;
-    }
-  }
-  return i;
+  const auto eol =
+      static_cast<const char*>(memchr(buf, copy_params.line_delim, end - begin));
+  return eol ? eol - buf + 1 : end - begin;
 }
 
 void TypedImportBuffer::add_value(const ColumnDescriptor* cd,
@@ -651,7 +740,11 @@ void TypedImportBuffer::pop_value() {
     case kTEXT:
     case kVARCHAR:
     case kCHAR:
-      string_buffer_->pop_back();
+      if (column_desc_->columnType.get_compression() == kENCODING_DICT) {
+        dict_string_buffer_->pop_back();
+      } else {
+        string_buffer_->pop_back();
+      }
       break;
     case kTIME:
     case kTIMESTAMP:
@@ -691,20 +784,15 @@ inline void append_arrow_primitive(const Array& values,
                                    const T null_sentinel,
                                    std::vector<T>* buffer) {
   const auto& typed_values = static_cast<const ArrayType&>(values);
-  buffer->reserve(typed_values.length());
   const T* raw_values = typed_values.raw_values();
+  const size_t offset = buffer->size();
+  buffer->insert(buffer->end(), raw_values, raw_values + typed_values.length());
   if (typed_values.null_count() > 0) {
     for (int64_t i = 0; i < typed_values.length(); i++) {
       if (typed_values.IsNull(i)) {
-        buffer->push_back(null_sentinel);
-      } else {
-        buffer->push_back(raw_values[i]);
+        (*buffer)[offset + i] = null_sentinel;
       }
     }
-  } else {
-    for (int64_t i = 0; i < typed_values.length(); i++) {
-      buffer->push_back(raw_values[i]);
-    }
   }
 }
 
@@ -886,14 +974,23 @@ void append_arrow_date(const ColumnDescriptor* cd,
   }
 }
 
+void reserve_arrow_binary(const BinaryArray& values, std::vector<std::string>* buffer) {
+  buffer->reserve(buffer->size() + values.length());
+}
+
+void reserve_arrow_binary(const BinaryArray& values, StringArena* buffer) {
+  buffer->reserve(values.length(), values.value_data() ? values.value_data()->size() : 0);
+}
+
+template <class STRINGS>
 void append_arrow_binary(const ColumnDescriptor* cd,
                          const Array& values,
-                         std::vector<std::string>* buffer) {
+                         STRINGS* buffer) {
   ARROW_THROW_IF(values.type_id() != Type::BINARY && values.type_id() != Type::STRING,
                  "Expected binary col");
 
   const auto& typed_values = static_cast<const BinaryArray&>(values);
-  buffer->reserve(typed_values.length());
+  reserve_arrow_binary(typed_values, buffer);
 
   const char* bytes;
   int32_t bytes_length = 0;
@@ -903,13 +1000,104 @@ void append_arrow_binary(const ColumnDescriptor* cd,
       buffer->push_back(std::string());
     } else {
       bytes = reinterpret_cast<const char*>(typed_values.GetValue(i, &bytes_length));
-      buffer->push_back(std::string(bytes, bytes_length));
+      buffer->emplace_back(bytes, bytes_length);
+    }
+  }
+}
+
+template <typename IndexArrayType, typename F>
+void for_each_typed_index(const Array& indices, F func) {
+  const auto& typed_indices = static_cast<const IndexArrayType&>(indices);
+  for (int64_t i = 0; i < typed_indices.length(); i++) {
+    func(typed_indices.IsNull(i), static_cast<int64_t>(typed_indices.Value(i)));
+  }
+}
+
+template <typename F>
+void for_each_dictionary_index(const Array& indices, F func) {
+  switch (indices.type_id()) {
+    case Type::INT8:
+      for_each_typed_index<Int8Array>(indices, func);
+      break;
+    case Type::INT16:
+      for_each_typed_index<Int16Array>(indices, func);
+      break;
+    case Type::INT32:
+      for_each_typed_index<Int32Array>(indices, func);
+      break;
+    case Type::INT64:
+      for_each_typed_index<Int64Array>(indices, func);
+      break;
+    default:
+      ARROW_THROW_IF(true, "Unsupported dictionary index type");
+  }
+}
+
+void check_dict_string_lengths(const StringArena& strings) {
+  for (size_t i = 0; i < strings.size(); ++i) {
+    if (strings[i].size() > StringDictionary::MAX_STRLEN) {
+      throw std::runtime_error("String too long for dictionary encoding.");
     }
   }
 }
 
 }  // namespace
 
+template <class ArrowType, class T>
+bool TypedImportBuffer::useArrowValues(const arrow::Array& col, std::vector<T>* buffer) {
+  if (arrow_values_) {
+    materializeArrowValues(buffer);
+    return false;
+  }
+  // Nulls only show in the validity bitmap of the array, the values need the sentinel.
+  if (!buffer->empty() || col.null_count() > 0 || column_desc_->columnType.is_decimal()) {
+    return false;
+  }
+  using ArrayType = typename arrow::TypeTraits<ArrowType>::ArrayType;
+  const auto& typed_values = static_cast<const ArrayType&>(col);
+  arrow_values_ = reinterpret_cast<const int8_t*>(typed_values.raw_values());
+  arrow_values_count_ = typed_values.length();
+  return true;
+}
+
+template <class T>
+void TypedImportBuffer::materializeArrowValues(std::vector<T>* buffer) {
+  CHECK(buffer->empty());
+  const auto values = reinterpret_cast<const T*>(arrow_values_);
+  buffer->assign(values, values + arrow_values_count_);
+  arrow_values_ = nullptr;
+  arrow_values_count_ = 0;
+}
+
+template <class T>
+void TypedImportBuffer::addDictEncodedArrowStrings(const arrow::Array& col,
+                                                   std::vector<T>* buffer) {
+  CHECK(string_dict_);
+  CHECK(dict_string_buffer_->empty());
+  dict_encoded_strings_ = true;
+  StringArena strings;
+  if (col.type_id() != arrow::Type::DICTIONARY) {
+    append_arrow_binary(column_desc_, col, &strings);
+    check_dict_string_lengths(strings);
+    const size_t offset = buffer->size();
+    buffer->resize(offset + strings.size());
+    string_dict_->getOrAddBulk(strings, buffer->data() + offset);
+    return;
+  }
+  // Each string of the dictionary gets encoded once, the rows only map its index.
+  const auto& dict_values = static_cast<const arrow::DictionaryArray&>(col);
+  append_arrow_binary(column_desc_, *dict_values.dictionary(), &strings);
+  check_dict_string_lengths(strings);
+  std::vector<T> ids(strings.size());
+  string_dict_->getOrAddBulk(strings, ids.data());
+  const T null_id = inline_int_null_value<T>();
+  buffer->reserve(buffer->size() + col.length());
+  for_each_dictionary_index(*dict_values.indices(),
+                            [buffer, &ids, null_id](const bool is_null, const int64_t i) {
+                              buffer->push_back(is_null ? null_id : ids[i]);
+                            });
+}
+
 size_t TypedImportBuffer::add_arrow_values(const ColumnDescriptor* cd,
                                            const arrow::Array& col) {
   const auto type = cd->columnType.is_decimal() ? decimal_to_int_type(cd->columnType)
@@ -927,30 +1115,60 @@ size_t TypedImportBuffer::add_arrow_values(const ColumnDescriptor* cd,
       break;
     case kTINYINT:
       ARROW_THROW_IF(col.type_id() != arrow::Type::INT8, "Expected int8 type");
-      append_arrow_integer<arrow::Int8Type, int8_t>(cd, col, tinyint_buffer_);
+      if (!useArrowValues<arrow::Int8Type>(col, tinyint_buffer_)) {
+        append_arrow_integer<arrow::Int8Type, int8_t>(cd, col, tinyint_buffer_);
+      }
       break;
     case kSMALLINT:
       ARROW_THROW_IF(col.type_id() != arrow::Type::INT16, "Expected int16 type");
-      append_arrow_integer<arrow::Int16Type, int16_t>(cd, col, smallint_buffer_);
+      if (!useArrowValues<arrow::Int16Type>(col, smallint_buffer_)) {
+        append_arrow_integer<arrow::Int16Type, int16_t>(cd, col, smallint_buffer_);
+      }
       break;
     case kINT:
       ARROW_THROW_IF(col.type_id() != arrow::Type::INT32, "Expected int32 type");
-      append_arrow_integer<arrow::Int32Type, int32_t>(cd, col, int_buffer_);
+      if (!useArrowValues<arrow::Int32Type>(col, int_buffer_)) {
+        append_arrow_integer<arrow::Int32Type, int32_t>(cd, col, int_buffer_);
+      }
       break;
     case kBIGINT:
       ARROW_THROW_IF(col.type_id() != arrow::Type::INT64, "Expected int64 type");
-      append_arrow_integer<arrow::Int64Type, int64_t>(cd, col, bigint_buffer_);
+      if (!useArrowValues<arrow::Int64Type>(col, bigint_buffer_)) {
+        append_arrow_integer<arrow::Int64Type, int64_t>(cd, col, bigint_buffer_);
+      }
       break;
     case kFLOAT:
-      append_arrow_float(cd, col, float_buffer_);
+      ARROW_THROW_IF(col.type_id() != arrow::Type::FLOAT, "Expected float col");
+      if (!useArrowValues<arrow::FloatType>(col, float_buffer_)) {
+        append_arrow_float(cd, col, float_buffer_);
+      }
       break;
     case kDOUBLE:
-      append_arrow_double(cd, col, double_buffer_);
+      ARROW_THROW_IF(col.type_id() != arrow::Type::DOUBLE, "Expected double col");
+      if (!useArrowValues<arrow::DoubleType>(col, double_buffer_)) {
+        append_arrow_double(cd, col, double_buffer_);
+      }
       break;
     case kTEXT:
     case kVARCHAR:
     case kCHAR:
-      append_arrow_binary(cd, col, string_buffer_);
+      if (cd->columnType.get_compression() != kENCODING_DICT) {
+        append_arrow_binary(cd, col, string_buffer_);
+        break;
+      }
+      switch (cd->columnType.get_size()) {
+        case 1:
+          addDictEncodedArrowStrings(col, string_dict_i8_buffer_);
+          break;
+        case 2:
+          addDictEncodedArrowStrings(col, string_dict_i16_buffer_);
+          break;
+        case 4:
+          addDictEncodedArrowStrings(col, string_dict_i32_buffer_);
+          break;
+        default:
+          CHECK(false);
+      }
       break;
     case kTIME:
       append_arrow_time(cd, col, time_buffer_);
@@ -1070,12 +1288,14 @@ size_t TypedImportBuffer::add_values(const ColumnDescriptor* cd, const TColumn&
     case kCHAR: {
       // TODO: for now, use empty string for nulls
       dataSize = col.data.str_col.size();
-      string_buffer_->reserve(dataSize);
+      if (cd->columnType.get_compression() != kENCODING_DICT) {
+        string_buffer_->reserve(dataSize);
+      }
       for (size_t i = 0; i < dataSize; i++) {
         if (col.nulls[i]) {
-          string_buffer_->push_back(std::string());
+          addString(std::string());
         } else {
-          string_buffer_->push_back(col.data.str_col[i]);
+          addString(col.data.str_col[i]);
         }
       }
       break;
@@ -1587,7 +1807,7 @@ static ImportStatus import_thread_delimited(
   int64_t total_get_row_time_us = 0;
   int64_t total_str_to_val_time_us = 0;
   auto buffer = sbuffer.get();
-  auto load_ms = measure<>::execution([]() {});
+  int64_t load_us = 0;
   auto ms = measure<>::execution([&]() {
     const CopyParams& copy_params = importer->get_copy_params();
     const std::list<const ColumnDescriptor*>& col_descs = importer->get_column_descs();
@@ -1604,6 +1824,7 @@ static ImportStatus import_thread_delimited(
     }
     std::vector<std::string> row;
     size_t row_index_plus_one = 0;
+    const auto parse_start = timer_start();
     for (const char* p = thread_buf; p < thread_buf_end; p++) {
       row.clear();
       if (DEBUG_TIMING) {
@@ -1791,15 +2012,19 @@ static ImportStatus import_thread_delimited(
       });
       total_str_to_val_time_us += us;
     }
+    import_status.parse_us =
+        timer_stop<std::chrono::steady_clock::time_point, std::chrono::microseconds>(
+            parse_start);
     if (import_status.rows_completed > 0) {
-      load_ms = measure<>::execution(
+      load_us = measure<std::chrono::microseconds>::execution(
           [&]() { importer->load(import_buffers, import_status.rows_completed); });
     }
   });
+  import_status.load_us = load_us;
   if (DEBUG_TIMING && import_status.rows_completed > 0) {
     LOG(INFO) << "Thread" << std::this_thread::get_id() << ":"
               << import_status.rows_completed << " rows inserted in "
-              << (double)ms / 1000.0 << "sec, Insert Time: " << (double)load_ms / 1000.0
+              << (double)ms / 1000.0 << "sec, Insert Time: " << (double)load_us / 1000000.0
               << "sec, get_row: " << (double)total_get_row_time_us / 1000000.0
               << "sec, str_to_val: " << (double)total_str_to_val_time_us / 1000000.0
               << "sec" << std::endl;
@@ -1831,6 +2056,16 @@ static ImportStatus import_thread_shapefile(
     p->clear();
   }
 
+  // The render groups of the polygons are assigned once all the features of the chunk
+  // are converted, each analyzer taking all its bounds under a single lock of its
+  // rtree, and patched into the rows then. Keyed by render group column index.
+  struct PendingRenderGroups {
+    RenderGroupAnalyzer* analyzer;
+    std::vector<size_t> rows;
+    std::vector<std::vector<double>> bounds;
+  };
+  std::map<size_t, PendingRenderGroups> pending_render_groups;
+
   auto convert_timer = timer_start();
 
   for (size_t iFeature = 0; iFeature < numFeatures; iFeature++) {
@@ -1881,6 +2116,7 @@ static ImportStatus import_thread_shapefile(
           std::vector<int> ring_sizes;
           std::vector<int> poly_rings;
           int render_group = 0;
+          RenderGroupAnalyzer* render_group_analyzer{nullptr};
 
           // extract it
           SQLTypeInfo import_ti;
@@ -1914,7 +2150,7 @@ static ImportStatus import_thread_shapefile(
               // get a suitable render group for these poly coords
               auto rga_it = columnIdToRenderGroupAnalyzerMap.find(cd->columnId);
               CHECK(rga_it != columnIdToRenderGroupAnalyzerMap.end());
-              render_group = (*rga_it).second->insertBoundsAndReturnRenderGroup(bounds);
+              render_group_analyzer = (*rga_it).second.get();
             } else {
               // empty poly
               render_group = -1;
@@ -1993,6 +2229,12 @@ static ImportStatus import_thread_shapefile(
             // Create render_group value and add it to the physical column
             ++cd_it;
             auto cd_render_group = *cd_it;
+            if (render_group_analyzer) {
+              auto& pending = pending_render_groups[col_idx];
+              pending.analyzer = render_group_analyzer;
+              pending.rows.push_back(import_status.rows_completed);
+              pending.bounds.push_back(bounds);
+            }
             TDatum td_render_group;
             td_render_group.val.int_val = render_group;
             td_render_group.is_null = false;
@@ -2019,10 +2261,30 @@ static ImportStatus import_thread_shapefile(
       for (size_t col_idx_to_pop = 0; col_idx_to_pop < col_idx; ++col_idx_to_pop) {
         import_buffers[col_idx_to_pop]->pop_value();
       }
+      for (auto& pending : pending_render_groups) {
+        auto& rows = pending.second.rows;
+        if (!rows.empty() && rows.back() == import_status.rows_completed) {
+          rows.pop_back();
+          pending.second.bounds.pop_back();
+        }
+      }
       import_status.rows_rejected++;
       LOG(ERROR) << "Input exception thrown: " << e.what() << ". Row discarded.";
     }
   }
+
+  for (const auto& pending : pending_render_groups) {
+    const auto render_groups =
+        pending.second.analyzer->insertBoundsAndReturnRenderGroups(pending.second.bounds);
+    auto& render_group_buffer = *import_buffers[pending.first];
+    CHECK_EQ(kINT, render_group_buffer.getTypeInfo().get_type());
+    auto render_group_values =
+        reinterpret_cast<int32_t*>(render_group_buffer.getAsBytes());
+    for (size_t i = 0; i < render_groups.size(); ++i) {
+      render_group_values[pending.second.rows[i]] = render_groups[i];
+    }
+  }
+
   float convert_ms =
       float(timer_stop<std::chrono::steady_clock::time_point, std::chrono::microseconds>(
           convert_timer)) /
@@ -2087,48 +2349,200 @@ bool Loader::load(const std::vector<std::unique_ptr<TypedImportBuffer>>& import_
 
 namespace {
 
-int64_t int_value_at(const TypedImportBuffer& import_buffer, const size_t index) {
-  const auto& ti = import_buffer.getTypeInfo();
-  const int8_t* values_buffer{nullptr};
-  if (ti.is_string()) {
-    CHECK_EQ(kENCODING_DICT, ti.get_compression());
-    values_buffer = import_buffer.getStringDictBuffer();
-  } else {
-    values_buffer = import_buffer.getAsBytes();
+// Computes the shard of every row in one pass over a buffer of T keys.
+template <typename T>
+void set_row_shards(std::vector<size_t>& row_shards,
+                    const int8_t* keys_buffer,
+                    const size_t shard_count) {
+  const auto keys = reinterpret_cast<const T*>(may_alias_ptr(keys_buffer));
+  for (size_t i = 0; i < row_shards.size(); ++i) {
+    const int64_t val = keys[i];
+    row_shards[i] = SHARD_FOR_KEY(val, shard_count);
   }
-  CHECK(values_buffer);
-  switch (ti.get_logical_size()) {
-    case 1: {
-      return values_buffer[index];
-    }
-    case 2: {
-      return reinterpret_cast<const int16_t*>(values_buffer)[index];
-    }
-    case 4: {
-      return reinterpret_cast<const int32_t*>(values_buffer)[index];
-    }
-    case 8: {
-      return reinterpret_cast<const int64_t*>(values_buffer)[index];
-    }
+}
+
+// Calls add_value with the values of the rows, read from a buffer of T.
+template <typename T, typename ADD_VALUE>
+void scatter_values(const int8_t* values_buffer,
+                    const std::vector<size_t>& rows,
+                    ADD_VALUE add_value) {
+  const auto values = reinterpret_cast<const T*>(may_alias_ptr(values_buffer));
+  for (const auto row : rows) {
+    add_value(values[row]);
+  }
+}
+
+template <typename ADD_VALUE>
+void scatter_int_values(const TypedImportBuffer& input_buffer,
+                        const std::vector<size_t>& rows,
+                        ADD_VALUE add_value) {
+  const auto values_buffer = input_buffer.getAsBytes();
+  switch (input_buffer.getTypeInfo().get_logical_size()) {
+    case 1:
+      scatter_values<int8_t>(values_buffer, rows, add_value);
+      break;
+    case 2:
+      scatter_values<int16_t>(values_buffer, rows, add_value);
+      break;
+    case 4:
+      scatter_values<int32_t>(values_buffer, rows, add_value);
+      break;
+    case 8:
+      scatter_values<int64_t>(values_buffer, rows, add_value);
+      break;
     default:
       CHECK(false);
   }
-  UNREACHABLE();
-  return 0;
 }
 
-float float_value_at(const TypedImportBuffer& import_buffer, const size_t index) {
-  const auto& ti = import_buffer.getTypeInfo();
-  CHECK_EQ(kFLOAT, ti.get_type());
-  const auto values_buffer = import_buffer.getAsBytes();
-  return reinterpret_cast<const float*>(may_alias_ptr(values_buffer))[index];
+// Appends the rows of the input buffer listed in shard_rows[shard] to
+// shard_buffers[shard], keeping their order.
+void scatter_column(const TypedImportBuffer& input_buffer,
+                    const std::vector<TypedImportBuffer*>& shard_buffers,
+                    const std::vector<std::vector<size_t>>& shard_rows) {
+  const auto& col_ti = input_buffer.getTypeInfo();
+  const auto type = col_ti.is_decimal() ? decimal_to_int_type(col_ti) : col_ti.get_type();
+  for (size_t shard = 0; shard < shard_buffers.size(); ++shard) {
+    const auto& rows = shard_rows[shard];
+    if (rows.empty()) {
+      continue;
+    }
+    auto& output_buffer = *shard_buffers[shard];
+    output_buffer.reserve(rows.size());
+    switch (type) {
+      case kBOOLEAN:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addBoolean(v);
+        });
+        break;
+      case kTINYINT:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addTinyint(v);
+        });
+        break;
+      case kSMALLINT:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addSmallint(v);
+        });
+        break;
+      case kINT:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addInt(v);
+        });
+        break;
+      case kBIGINT:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addBigint(v);
+        });
+        break;
+      case kFLOAT:
+        scatter_values<float>(
+            input_buffer.getAsBytes(), rows, [&output_buffer](const float v) {
+              output_buffer.addFloat(v);
+            });
+        break;
+      case kDOUBLE:
+        scatter_values<double>(
+            input_buffer.getAsBytes(), rows, [&output_buffer](const double v) {
+              output_buffer.addDouble(v);
+            });
+        break;
+      case kTEXT:
+      case kVARCHAR:
+      case kCHAR: {
+        if (input_buffer.hasDictEncodedStrings()) {
+          for (const auto row : rows) {
+            output_buffer.addStringDictId(input_buffer.getStringDictId(row));
+          }
+          break;
+        }
+        const auto& strings = *input_buffer.getStringBuffer();
+        for (const auto row : rows) {
+          CHECK_LT(row, strings.size());
+          output_buffer.addString(strings[row]);
+        }
+        break;
+      }
+      case kTIME:
+      case kTIMESTAMP:
+      case kDATE:
+        scatter_int_values(input_buffer, rows, [&output_buffer](const int64_t v) {
+          output_buffer.addTime(v);
+        });
+        break;
+      case kARRAY:
+        if (IS_STRING(col_ti.get_subtype())) {
+          CHECK(input_buffer.getStringArrayBuffer());
+          const auto& string_arrays = *input_buffer.getStringArrayBuffer();
+          for (const auto row : rows) {
+            CHECK_LT(row, string_arrays.size());
+            output_buffer.addStringArray(string_arrays[row]);
+          }
+        } else {
+          const auto& arrays = *input_buffer.getArrayBuffer();
+          for (const auto row : rows) {
+            output_buffer.addArray(arrays[row]);
+          }
+        }
+        break;
+      case kPOINT:
+      case kLINESTRING:
+      case kPOLYGON:
+      case kMULTIPOLYGON: {
+        const auto& geo_strings = *input_buffer.getGeoStringBuffer();
+        for (const auto row : rows) {
+          CHECK_LT(row, geo_strings.size());
+          output_buffer.addGeoString(geo_strings[row]);
+        }
+        break;
+      }
+      default:
+        CHECK(false);
+    }
+  }
 }
 
-double double_value_at(const TypedImportBuffer& import_buffer, const size_t index) {
-  const auto& ti = import_buffer.getTypeInfo();
-  CHECK_EQ(kDOUBLE, ti.get_type());
-  const auto values_buffer = import_buffer.getAsBytes();
-  return reinterpret_cast<const double*>(may_alias_ptr(values_buffer))[index];
+// The values of the rows of a fixed width column, as updateColumn takes them.
+std::vector<ScalarTargetValue> get_update_values(const TypedImportBuffer& input_buffer,
+                                                 const std::vector<size_t>& rows) {
+  std::vector<ScalarTargetValue> values;
+  values.reserve(rows.size());
+  const auto& col_ti = input_buffer.getTypeInfo();
+  if (col_ti.is_string()) {
+    CHECK(input_buffer.hasDictEncodedStrings());
+    int64_t null_id;
+    switch (col_ti.get_size()) {
+      case 1:
+        null_id = inline_int_null_value<uint8_t>();
+        break;
+      case 2:
+        null_id = inline_int_null_value<uint16_t>();
+        break;
+      default:
+        null_id = inline_int_null_value<int32_t>();
+    }
+    for (const auto row : rows) {
+      const int64_t id = input_buffer.getStringDictId(row);
+      if (id == null_id) {
+        values.emplace_back(NullableString(static_cast<void*>(nullptr)));
+      } else {
+        values.emplace_back(id);
+      }
+    }
+  } else if (col_ti.get_type() == kFLOAT) {
+    scatter_values<float>(input_buffer.getAsBytes(), rows, [&values](const float v) {
+      values.emplace_back(v);
+    });
+  } else if (col_ti.get_type() == kDOUBLE) {
+    scatter_values<double>(input_buffer.getAsBytes(), rows, [&values](const double v) {
+      values.emplace_back(v);
+    });
+  } else {
+    scatter_int_values(input_buffer, rows, [&values](const int64_t v) {
+      values.emplace_back(v);
+    });
+  }
+  return values;
 }
 
 }  // namespace
@@ -2163,108 +2577,101 @@ void Loader::distributeToShards(std::vector<OneShardBuffers>& all_shard_import_b
   const auto& shard_col_ti = shard_col_desc->columnType;
   CHECK(shard_col_ti.is_integer() ||
         (shard_col_ti.is_string() && shard_col_ti.get_compression() == kENCODING_DICT));
-  if (shard_col_ti.is_string()) {
-    const auto payloads_ptr = shard_column_input_buffer->getStringBuffer();
-    CHECK(payloads_ptr);
-    shard_column_input_buffer->addDictEncodedString(*payloads_ptr);
-  }
+  const auto encode_strings = [this](TypedImportBuffer& input_buffer) {
+    const auto& col_ti = input_buffer.getTypeInfo();
+    if (col_ti.is_string() && col_ti.get_compression() == kENCODING_DICT &&
+        !input_buffer.hasDictEncodedStrings()) {
+      const auto payloads_ptr = input_buffer.getDictStringBuffer();
+      CHECK(payloads_ptr);
+      dict_encode_us_ += measure<std::chrono::microseconds>::execution(
+          [&]() { input_buffer.addDictEncodedString(*payloads_ptr); });
+    }
+  };
 
+  // Rows of every shard, in their original order. When replicating a column, the
+  // 'rows' are populated to all shards only once.
+  std::vector<std::vector<size_t>> shard_rows(shard_count);
   int64_t rows_per_shard = (row_count + shard_count + 1) / shard_count;
-  int64_t rows_left = row_count;
-
-  for (size_t i = 0; i < row_count; ++i, rows_left -= rows_per_shard) {
-    const auto val = get_replicating() ? i : int_value_at(*shard_column_input_buffer, i);
-    const size_t shard = SHARD_FOR_KEY(val, shard_count);
-    auto& shard_output_buffers = all_shard_import_buffers[shard];
-
-    // when replicate a column, populate 'rows' to all shards only once
-    if (get_replicating()) {
-      if (i >= shard_count) {
-        break;
-      }
+  if (get_replicating()) {
+    int64_t rows_left = row_count;
+    for (size_t i = 0; i < std::min(row_count, shard_count);
+         ++i, rows_left -= rows_per_shard) {
+      const size_t shard = SHARD_FOR_KEY(i, shard_count);
+      shard_rows[shard].push_back(i);
+      // when replicating a column, row count of a shard == replicate count of the
+      // column on the shard
+      all_shard_row_counts[shard] = std::min<int64_t>(rows_left, rows_per_shard);
     }
-
-    for (size_t col_idx = 0; col_idx < import_buffers.size(); ++col_idx) {
-      const auto& input_buffer = import_buffers[col_idx];
-      const auto& col_ti = input_buffer->getTypeInfo();
-      const auto type =
-          col_ti.is_decimal() ? decimal_to_int_type(col_ti) : col_ti.get_type();
-
-      // for a replicated (added) column, populate rows_per_shard as per-shard replicate
-      // count. and, bypass non-replicated column.
-      if (get_replicating()) {
-        if (input_buffer->get_replicate_count() > 0) {
-          shard_output_buffers[col_idx]->set_replicate_count(
-              std::min<int64_t>(rows_left, rows_per_shard));
-        } else {
-          continue;
-        }
+  } else {
+    encode_strings(*shard_column_input_buffer);
+    std::vector<size_t> row_shards(row_count);
+    if (shard_col_ti.is_string()) {
+      for (size_t i = 0; i < row_count; ++i) {
+        const int64_t val = shard_column_input_buffer->getStringDictId(i);
+        row_shards[i] = SHARD_FOR_KEY(val, shard_count);
       }
-
-      switch (type) {
-        case kBOOLEAN:
-          shard_output_buffers[col_idx]->addBoolean(int_value_at(*input_buffer, i));
-          break;
-        case kTINYINT:
-          shard_output_buffers[col_idx]->addTinyint(int_value_at(*input_buffer, i));
-          break;
-        case kSMALLINT:
-          shard_output_buffers[col_idx]->addSmallint(int_value_at(*input_buffer, i));
-          break;
-        case kINT:
-          shard_output_buffers[col_idx]->addInt(int_value_at(*input_buffer, i));
-          break;
-        case kBIGINT:
-          shard_output_buffers[col_idx]->addBigint(int_value_at(*input_buffer, i));
-          break;
-        case kFLOAT:
-          shard_output_buffers[col_idx]->addFloat(float_value_at(*input_buffer, i));
-          break;
-        case kDOUBLE:
-          shard_output_buffers[col_idx]->addDouble(double_value_at(*input_buffer, i));
+    } else {
+      const auto keys_buffer = shard_column_input_buffer->getAsBytes();
+      switch (shard_col_ti.get_logical_size()) {
+        case 1:
+          set_row_shards<int8_t>(row_shards, keys_buffer, shard_count);
           break;
-        case kTEXT:
-        case kVARCHAR:
-        case kCHAR: {
-          CHECK_LT(i, input_buffer->getStringBuffer()->size());
-          shard_output_buffers[col_idx]->addString((*input_buffer->getStringBuffer())[i]);
+        case 2:
+          set_row_shards<int16_t>(row_shards, keys_buffer, shard_count);
           break;
-        }
-        case kTIME:
-        case kTIMESTAMP:
-        case kDATE:
-          shard_output_buffers[col_idx]->addTime(int_value_at(*input_buffer, i));
+        case 4:
+          set_row_shards<int32_t>(row_shards, keys_buffer, shard_count);
           break;
-        case kARRAY:
-          if (IS_STRING(col_ti.get_subtype())) {
-            CHECK(input_buffer->getStringArrayBuffer());
-            CHECK_LT(i, input_buffer->getStringArrayBuffer()->size());
-            const auto& input_arr = (*(input_buffer->getStringArrayBuffer()))[i];
-            shard_output_buffers[col_idx]->addStringArray(input_arr);
-          } else {
-            shard_output_buffers[col_idx]->addArray((*input_buffer->getArrayBuffer())[i]);
-          }
+        case 8:
+          set_row_shards<int64_t>(row_shards, keys_buffer, shard_count);
           break;
-        case kPOINT:
-        case kLINESTRING:
-        case kPOLYGON:
-        case kMULTIPOLYGON: {
-          CHECK_LT(i, input_buffer->getGeoStringBuffer()->size());
-          shard_output_buffers[col_idx]->addGeoString(
-              (*input_buffer->getGeoStringBuffer())[i]);
-          break;
-        }
         default:
           CHECK(false);
       }
     }
-    ++all_shard_row_counts[shard];
-    // when replicating a column, row count of a shard == replicate count of the column on
-    // the shard
-    if (get_replicating()) {
-      all_shard_row_counts[shard] = std::min<int64_t>(rows_left, rows_per_shard);
+    for (const auto shard : row_shards) {
+      ++all_shard_row_counts[shard];
+    }
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+      shard_rows[shard].reserve(all_shard_row_counts[shard]);
+    }
+    for (size_t i = 0; i < row_count; ++i) {
+      shard_rows[row_shards[i]].push_back(i);
     }
   }
+
+  // scatter the columns in parallel, each into its own buffer of every shard
+  std::atomic<size_t> next_col_idx{0};
+  const auto scatter_columns = [&]() {
+    std::vector<TypedImportBuffer*> shard_buffers(shard_count);
+    for (size_t col_idx = next_col_idx++; col_idx < import_buffers.size();
+         col_idx = next_col_idx++) {
+      auto& input_buffer = *import_buffers[col_idx];
+      // for a replicated (added) column, populate rows_per_shard as per-shard replicate
+      // count. and, bypass non-replicated column.
+      if (get_replicating() && input_buffer.get_replicate_count() <= 0) {
+        continue;
+      }
+      encode_strings(input_buffer);
+      for (size_t shard = 0; shard < shard_count; ++shard) {
+        shard_buffers[shard] = all_shard_import_buffers[shard][col_idx].get();
+        if (get_replicating() && !shard_rows[shard].empty()) {
+          shard_buffers[shard]->set_replicate_count(all_shard_row_counts[shard]);
+        }
+      }
+      scatter_column(input_buffer, shard_buffers, shard_rows);
+    }
+  };
+  const auto thread_count = std::min<size_t>(
+      import_buffers.size(), std::max(std::thread::hardware_concurrency(), 1u));
+  std::vector<std::future<void>> scatter_threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    scatter_threads.push_back(std::async(std::launch::async, scatter_columns));
+  }
+  scatter_columns();
+  for (auto& scatter_thread : scatter_threads) {
+    scatter_thread.get();
+  }
 }
 
 bool Loader::loadImpl(
@@ -2280,18 +2687,33 @@ bool Loader::loadImpl(
                        import_buffers,
                        row_count,
                        shard_tables.size());
-    bool success = true;
+    // the shards are physical tables of their own, load them concurrently, except for
+    // the upserts, which checkpoint the whole table. The batches of the other import
+    // threads load at the same time; a batch only waits for the shards still busy
+    // with an earlier one.
+    const auto launch_policy = table_desc->primaryKeyColumnId && !get_replicating()
+                                   ? std::launch::deferred
+                                   : std::launch::async;
+    std::vector<std::future<bool>> shard_loads;
     for (size_t shard_idx = 0; shard_idx < shard_tables.size(); ++shard_idx) {
       if (!all_shard_row_counts[shard_idx]) {
         continue;
       }
-      success = success && loadToShard(all_shard_import_buffers[shard_idx],
-                                       all_shard_row_counts[shard_idx],
-                                       shard_tables[shard_idx],
-                                       checkpoint);
+      shard_loads.push_back(std::async(launch_policy, [&, shard_idx] {
+        std::lock_guard<std::mutex> shard_lock(shard_mutexes_[shard_idx]);
+        return loadToShard(all_shard_import_buffers[shard_idx],
+                           all_shard_row_counts[shard_idx],
+                           shard_tables[shard_idx],
+                           checkpoint);
+      }));
+    }
+    bool success = true;
+    for (auto& shard_load : shard_loads) {
+      success = shard_load.get() && success;
     }
     return success;
   }
+  std::lock_guard<std::mutex> loader_lock(shard_mutexes_.front());
   return loadToShard(import_buffers, row_count, table_desc, checkpoint);
 }
 
@@ -2300,17 +2722,142 @@ bool Loader::loadToShard(
     size_t row_count,
     const TableDescriptor* shard_table,
     bool checkpoint) {
-  std::lock_guard<std::mutex> loader_lock(loader_mutex_);
+  if (shard_table->primaryKeyColumnId && !get_replicating()) {
+    return upsertToShard(import_buffers, row_count, shard_table, checkpoint);
+  }
+  return insertToShard(import_buffers, row_count, shard_table, checkpoint);
+}
+
+// The rows of the keys already in the table are updated in place, or skipped, and the
+// others inserted. Within the batch, the last row of a key wins, or the first when
+// skipping. The upsert mutex of the fragmenter keeps two loads from both inserting a
+// new key.
+bool Loader::upsertToShard(
+    const std::vector<std::unique_ptr<TypedImportBuffer>>& import_buffers,
+    size_t row_count,
+    const TableDescriptor* shard_table,
+    bool checkpoint) {
+  auto fragmenter = shard_table->fragmenter;
+  std::lock_guard<std::mutex> upsert_lock(fragmenter->getUpsertMutex());
+  const TypedImportBuffer* key_buffer{nullptr};
+  for (const auto& import_buff : import_buffers) {
+    const auto& col_ti = import_buff->getTypeInfo();
+    if (col_ti.is_string() && col_ti.get_compression() == kENCODING_DICT &&
+        !import_buff->hasDictEncodedStrings()) {
+      auto string_payload_ptr = import_buff->getDictStringBuffer();
+      dict_encode_us_ += measure<std::chrono::microseconds>::execution(
+          [&]() { import_buff->addDictEncodedString(*string_payload_ptr); });
+    }
+    if (import_buff->getColumnDesc()->columnId == shard_table->primaryKeyColumnId) {
+      key_buffer = import_buff.get();
+    }
+  }
+  CHECK(key_buffer);
+
+  std::vector<size_t> all_rows(row_count);
+  std::iota(all_rows.begin(), all_rows.end(), 0);
+  std::vector<int64_t> row_keys;
+  row_keys.reserve(row_count);
+  scatter_int_values(*key_buffer, all_rows, [&row_keys](const int64_t v) {
+    row_keys.push_back(v);
+  });
+  std::unordered_map<int64_t, size_t> key_rows;
+  for (size_t row = 0; row < row_count; ++row) {
+    const auto it_ok = key_rows.emplace(row_keys[row], row);
+    if (!it_ok.second && !skip_duplicate_keys_) {
+      it_ok.first->second = row;
+    }
+  }
+  std::vector<size_t> rows;
+  std::vector<int64_t> keys;
+  for (size_t row = 0; row < row_count; ++row) {
+    if (key_rows[row_keys[row]] == row) {
+      rows.push_back(row);
+      keys.push_back(row_keys[row]);
+    }
+  }
+
+  std::vector<size_t> new_rows;
+  {
+    // Like UPDATE, on the logical table.
+    using namespace Lock_Namespace;
+    const ChunkKey table_key{catalog.get_currentDB().dbId, table_desc->tableId};
+    mapd_unique_lock<mapd_shared_mutex> update_delete_lock(
+        *LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(LockType::UpdateDeleteLock,
+                                                        table_key));
+    const auto locations = fragmenter->findPrimaryKeys(keys);
+    std::map<int, std::pair<std::vector<uint64_t>, std::vector<size_t>>> fragment_rows;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      if (locations[i].fragmentId < 0) {
+        new_rows.push_back(rows[i]);
+      } else if (!skip_duplicate_keys_) {
+        auto& offsets_rows = fragment_rows[locations[i].fragmentId];
+        offsets_rows.first.push_back(locations[i].offset);
+        offsets_rows.second.push_back(rows[i]);
+      }
+    }
+    if (!fragment_rows.empty()) {
+      // Rolled back by its destructor unless committed.
+      UpdelRoll updel_roll;
+      try {
+        for (const auto& fragment : fragment_rows) {
+          for (const auto& import_buff : import_buffers) {
+            const auto cd = import_buff->getColumnDesc();
+            if (cd->columnId == shard_table->primaryKeyColumnId) {
+              continue;
+            }
+            const auto shard_cd =
+                catalog.getMetadataForColumn(shard_table->tableId, cd->columnId);
+            CHECK(shard_cd);
+            const auto values = get_update_values(*import_buff, fragment.second.second);
+            fragmenter->updateColumn(&catalog,
+                                     shard_table,
+                                     shard_cd,
+                                     fragment.first,
+                                     fragment.second.first,
+                                     values,
+                                     import_buff->getTypeInfo(),
+                                     Data_Namespace::MemoryLevel::CPU_LEVEL,
+                                     updel_roll);
+          }
+        }
+        updel_roll.commitUpdate();
+      } catch (std::exception& e) {
+        LOG(ERROR) << "Fragmenter Update Exception: " << e.what();
+        return false;
+      }
+    }
+  }
+
+  if (new_rows.size() == row_count) {
+    return insertToShard(import_buffers, row_count, shard_table, checkpoint);
+  }
+  if (new_rows.empty()) {
+    return true;
+  }
+  OneShardBuffers new_buffers;
+  for (const auto& import_buff : import_buffers) {
+    new_buffers.emplace_back(new TypedImportBuffer(import_buff->getColumnDesc(),
+                                                   import_buff->getStringDictionary()));
+    scatter_column(*import_buff, {new_buffers.back().get()}, {new_rows});
+  }
+  return insertToShard(new_buffers, new_rows.size(), shard_table, checkpoint);
+}
+
+bool Loader::insertToShard(
+    const std::vector<std::unique_ptr<TypedImportBuffer>>& import_buffers,
+    size_t row_count,
+    const TableDescriptor* shard_table,
+    bool checkpoint) {
+  Fragmenter_Namespace::InsertData ins_data(insert_data);
   // patch insert_data with new column
   if (this->get_replicating()) {
     for (const auto& import_buff : import_buffers) {
-      insert_data.replicate_count = import_buff->get_replicate_count();
-      insert_data.columnDescriptors[import_buff->getColumnDesc()->columnId] =
+      ins_data.replicate_count = import_buff->get_replicate_count();
+      ins_data.columnDescriptors[import_buff->getColumnDesc()->columnId] =
           import_buff->getColumnDesc();
     }
   }
-
-  Fragmenter_Namespace::InsertData ins_data(insert_data);
   ins_data.numRows = row_count;
   bool success = true;
   for (const auto& import_buff : import_buffers) {
@@ -2319,12 +2866,15 @@ bool Loader::loadToShard(
         import_buff->getTypeInfo().get_type() == kBOOLEAN) {
       p.numbersPtr = import_buff->getAsBytes();
     } else if (import_buff->getTypeInfo().is_string()) {
-      auto string_payload_ptr = import_buff->getStringBuffer();
       if (import_buff->getTypeInfo().get_compression() == kENCODING_NONE) {
-        p.stringsPtr = string_payload_ptr;
+        p.stringsPtr = import_buff->getStringBuffer();
       } else {
         CHECK_EQ(kENCODING_DICT, import_buff->getTypeInfo().get_compression());
-        import_buff->addDictEncodedString(*string_payload_ptr);
+        if (!import_buff->hasDictEncodedStrings()) {
+          auto string_payload_ptr = import_buff->getDictStringBuffer();
+          dict_encode_us_ += measure<std::chrono::microseconds>::execution(
+              [&]() { import_buff->addDictEncodedString(*string_payload_ptr); });
+        }
         p.numbersPtr = import_buff->getStringDictBuffer();
       }
     } else if (import_buff->getTypeInfo().is_geometry()) {
@@ -2334,7 +2884,9 @@ bool Loader::loadToShard(
       CHECK(import_buff->getTypeInfo().get_type() == kARRAY);
       if (IS_STRING(import_buff->getTypeInfo().get_subtype())) {
         CHECK(import_buff->getTypeInfo().get_compression() == kENCODING_DICT);
-        import_buff->addDictEncodedStringArray(*import_buff->getStringArrayBuffer());
+        dict_encode_us_ += measure<std::chrono::microseconds>::execution([&]() {
+          import_buff->addDictEncodedStringArray(*import_buff->getStringArrayBuffer());
+        });
         p.arraysPtr = import_buff->getStringArrayDictBuffer();
       } else {
         p.arraysPtr = import_buff->getArrayBuffer();
@@ -2344,8 +2896,14 @@ bool Loader::loadToShard(
     ins_data.bypass.push_back(0 == import_buff->get_replicate_count());
   }
   {
+    const auto insert_start = timer_start();
     try {
-      if (checkpoint) {
+      if (checkpoint && g_load_commit_interval_ms) {
+        // visible to the queries right away, checkpointed in the background with the
+        // batches loaded after it
+        shard_table->fragmenter->insertDataDeferCheckpoint(
+            ins_data, g_load_commit_interval_ms, g_load_commit_max_rows);
+      } else if (checkpoint) {
         shard_table->fragmenter->insertData(ins_data);
       } else {
         shard_table->fragmenter->insertDataNoCheckpoint(ins_data);
@@ -2354,11 +2912,19 @@ bool Loader::loadToShard(
       LOG(ERROR) << "Fragmenter Insert Exception: " << e.what();
       success = false;
     }
+    insert_us_ += timer_stop<std::chrono::steady_clock::time_point,
+                             std::chrono::microseconds>(insert_start);
+  }
+  if (success) {
+    static auto& imported_rows = metrics::Registry::get().counter(
+        "mapd_import_rows_total", "Rows loaded into the tables by the importers");
+    imported_rows.inc(row_count);
   }
   return success;
 }
 
 void Loader::init() {
+  shard_mutexes_ = std::vector<std::mutex>(std::max(table_desc->nShards, 1));
   insert_data.databaseId = catalog.get_currentDB().dbId;
   insert_data.tableId = table_desc->tableId;
   for (auto cd : column_descs) {
@@ -2426,6 +2992,10 @@ ImportStatus Detector::importDelimited(const std::string& file_path,
           break;
         }
       }
+      // a stream that can't be sampled in ranges is read for as many bytes
+      if (raw_data.size() >= DETECT_SAMPLE_RANGES * DETECT_SAMPLE_RANGE_BYTES) {
+        break;
+      }
     }
   } catch (std::exception& e) {
   }
@@ -2440,10 +3010,65 @@ ImportStatus Detector::importDelimited(const std::string& file_path,
 }
 
 void Detector::read_file() {
+  if (read_file_ranges()) {
+    return;
+  }
   // this becomes analogous to Importer::import()
   (void)DataStreamSink::archivePlumber();
 }
 
+// A large local plain text file is sampled from its head and from ranges evenly spaced
+// over the rest of it, so that the types don't only reflect the beginning of the file
+// and the bytes read don't depend on its size. Archives and S3 objects can't be seeked
+// into and are read from their beginning.
+bool Detector::read_file_ranges() {
+  std::map<int, std::string> url_parts;
+  Archive::parse_url(file_path.string(), url_parts);
+  if ("file" != url_parts[2] && "" != url_parts[2]) {
+    return false;
+  }
+  const auto& path = url_parts[5];
+  const auto ext = boost::filesystem::extension(path);
+  const bool plain_text = copy_params.plain_text || ext == ".csv" || ext == ".tsv" ||
+                          ext == ".txt" || ext == "";
+  boost::system::error_code ec;
+  if (!plain_text || !boost::filesystem::is_regular_file(path, ec)) {
+    return false;
+  }
+  const size_t file_size = boost::filesystem::file_size(path, ec);
+  if (ec || file_size <= DETECT_SAMPLE_RANGES * DETECT_SAMPLE_RANGE_BYTES) {
+    return false;
+  }
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::vector<char> range(DETECT_SAMPLE_RANGE_BYTES);
+  const size_t stride = file_size / DETECT_SAMPLE_RANGES;
+  for (size_t i = 0; i < DETECT_SAMPLE_RANGES; ++i) {
+    in.clear();
+    in.seekg(i * stride);
+    in.read(range.data(), range.size());
+    const char* begin = range.data();
+    const char* end = begin + in.gcount();
+    if (i > 0) {
+      // skip the line the range starts in the middle of
+      begin = std::find(begin, end, copy_params.line_delim);
+      if (begin == end) {
+        continue;
+      }
+      ++begin;
+    }
+    // and the one it ends in the middle of
+    while (end > begin && *(end - 1) != copy_params.line_delim) {
+      --end;
+    }
+    raw_data.append(begin, end);
+  }
+  read_ranges = true;
+  return !raw_data.empty();
+}
+
 void Detector::detect_row_delimiter() {
   if (copy_params.delimiter == '\0') {
     copy_params.delimiter = ',';
@@ -2475,6 +3100,17 @@ void Detector::split_raw_data() {
       raw_rows.push_back(row);
     }
   }
+  if (read_ranges && !raw_rows.empty()) {
+    // a range may start inside a quoted field spanning lines, such rows are misparsed
+    // and dropped as long as they don't have as many fields as the first row
+    const size_t num_cols = raw_rows.front().size();
+    raw_rows.erase(std::remove_if(raw_rows.begin() + 1,
+                                  raw_rows.end(),
+                                  [num_cols](const std::vector<std::string>& row) {
+                                    return row.size() != num_cols;
+                                  }),
+                   raw_rows.end());
+  }
 }
 
 template <class T>
@@ -2585,22 +3221,26 @@ std::vector<SQLTypes> Detector::detect_column_types(const std::vector<std::strin
 }
 
 bool Detector::more_restrictive_sqltype(const SQLTypes a, const SQLTypes b) {
-  static std::array<int, kSQLTYPE_LAST> typeorder;
-  typeorder[kCHAR] = 0;
-  typeorder[kBOOLEAN] = 2;
-  typeorder[kSMALLINT] = 3;
-  typeorder[kINT] = 4;
-  typeorder[kBIGINT] = 5;
-  typeorder[kFLOAT] = 6;
-  typeorder[kDOUBLE] = 7;
-  typeorder[kTIMESTAMP] = 8;
-  typeorder[kTIME] = 9;
-  typeorder[kDATE] = 10;
-  typeorder[kPOINT] = 11;
-  typeorder[kLINESTRING] = 11;
-  typeorder[kPOLYGON] = 11;
-  typeorder[kMULTIPOLYGON] = 11;
-  typeorder[kTEXT] = 12;
+  // initialized once, types are detected from several threads
+  static const std::array<int, kSQLTYPE_LAST> typeorder = []() {
+    std::array<int, kSQLTYPE_LAST> typeorder{};
+    typeorder[kCHAR] = 0;
+    typeorder[kBOOLEAN] = 2;
+    typeorder[kSMALLINT] = 3;
+    typeorder[kINT] = 4;
+    typeorder[kBIGINT] = 5;
+    typeorder[kFLOAT] = 6;
+    typeorder[kDOUBLE] = 7;
+    typeorder[kTIMESTAMP] = 8;
+    typeorder[kTIME] = 9;
+    typeorder[kDATE] = 10;
+    typeorder[kPOINT] = 11;
+    typeorder[kLINESTRING] = 11;
+    typeorder[kPOLYGON] = 11;
+    typeorder[kMULTIPOLYGON] = 11;
+    typeorder[kTEXT] = 12;
+    return typeorder;
+  }();
 
   // note: b < a instead of a < b because the map is ordered most to least restrictive
   return typeorder[b] < typeorder[a];
@@ -2635,27 +3275,62 @@ std::vector<SQLTypes> Detector::find_best_sqltypes(
   }
   auto end_time = std::chrono::steady_clock::now() + timeout;
   size_t num_cols = raw_rows.front().size();
+  using ChunkTypes = std::pair<std::vector<SQLTypes>, std::vector<size_t>>;
+  const auto find_chunk_types = [&](
+      const std::vector<std::vector<std::string>>::const_iterator& chunk_begin,
+      const std::vector<std::vector<std::string>>::const_iterator& chunk_end) {
+    std::vector<SQLTypes> best_types(num_cols, kCHAR);
+    std::vector<size_t> non_null_col_counts(num_cols, 0);
+    for (auto row = chunk_begin; row != chunk_end; row++) {
+      while (best_types.size() < row->size() ||
+             non_null_col_counts.size() < row->size()) {
+        best_types.push_back(kCHAR);
+        non_null_col_counts.push_back(0);
+      }
+      for (size_t col_idx = 0; col_idx < row->size(); col_idx++) {
+        // do not count nulls
+        if (row->at(col_idx) == "" || !row->at(col_idx).compare(copy_params.null_str)) {
+          continue;
+        }
+        SQLTypes t = detect_sqltype(row->at(col_idx));
+        non_null_col_counts[col_idx]++;
+        if (!more_restrictive_sqltype(best_types[col_idx], t)) {
+          best_types[col_idx] = t;
+        }
+      }
+      if (std::chrono::steady_clock::now() > end_time) {
+        break;
+      }
+    }
+    return ChunkTypes(std::move(best_types), std::move(non_null_col_counts));
+  };
+  // the rows are typed in chunks on as many threads, whose types are then merged
+  const size_t num_rows = std::distance(row_begin, row_end);
+  const size_t num_chunks = std::max<size_t>(
+      std::min<size_t>(std::thread::hardware_concurrency(), num_rows / 1000), 1);
+  const size_t chunk_rows = (num_rows + num_chunks - 1) / num_chunks;
+  std::vector<std::future<ChunkTypes>> chunk_types;
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    chunk_types.push_back(
+        std::async(std::launch::async,
+                   find_chunk_types,
+                   row_begin + std::min(chunk * chunk_rows, num_rows),
+                   row_begin + std::min((chunk + 1) * chunk_rows, num_rows)));
+  }
   std::vector<SQLTypes> best_types(num_cols, kCHAR);
   std::vector<size_t> non_null_col_counts(num_cols, 0);
-  for (auto row = row_begin; row != row_end; row++) {
-    while (best_types.size() < row->size() || non_null_col_counts.size() < row->size()) {
-      best_types.push_back(kCHAR);
-      non_null_col_counts.push_back(0);
-    }
-    for (size_t col_idx = 0; col_idx < row->size(); col_idx++) {
-      // do not count nulls
-      if (row->at(col_idx) == "" || !row->at(col_idx).compare(copy_params.null_str)) {
-        continue;
+  for (auto& chunk_future : chunk_types) {
+    const auto chunk = chunk_future.get();
+    for (size_t col_idx = 0; col_idx < chunk.first.size(); col_idx++) {
+      if (col_idx == best_types.size()) {
+        best_types.push_back(kCHAR);
+        non_null_col_counts.push_back(0);
       }
-      SQLTypes t = detect_sqltype(row->at(col_idx));
-      non_null_col_counts[col_idx]++;
-      if (!more_restrictive_sqltype(best_types[col_idx], t)) {
-        best_types[col_idx] = t;
+      non_null_col_counts[col_idx] += chunk.second[col_idx];
+      if (!more_restrictive_sqltype(best_types[col_idx], chunk.first[col_idx])) {
+        best_types[col_idx] = chunk.first[col_idx];
       }
     }
-    if (std::chrono::steady_clock::now() > end_time) {
-      break;
-    }
   }
   for (size_t col_idx = 0; col_idx < num_cols; col_idx++) {
     // if we don't have any non-null values for this column make it text to be
@@ -2784,6 +3459,116 @@ void DataStreamSink::import_local_parquet(const std::string& file_path) {
   // note: for 'early-stop' purpose like that of Detector, this function
   // needs extra parameters, eg. timeout or maximum rows to scan, ...
 }
+
+#ifdef ENABLE_IMPORT_PARQUET
+static std::unique_ptr<parquet::arrow::FileReader> open_parquet_file(
+    const std::string& file_path) {
+  std::shared_ptr<arrow::io::ReadableFile> infile;
+  PARQUET_THROW_NOT_OK(arrow::io::ReadableFile::Open(file_path, &infile));
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  PARQUET_THROW_NOT_OK(
+      parquet::arrow::OpenFile(infile, arrow::default_memory_pool(), &reader));
+  return reader;
+}
+
+// Loads the row groups handed out through next_row_group, column by column: the arrow
+// arrays the row groups decode into are appended to the import buffers as a whole.
+static ImportStatus import_thread_parquet(int thread_id,
+                                          Importer* importer,
+                                          const std::string& file_path,
+                                          std::atomic<int>* next_row_group) {
+  ImportStatus import_status;
+  const auto& col_descs = importer->get_column_descs();
+  auto& import_buffers = importer->get_import_buffers(thread_id);
+  // The readers share nothing, each thread has its own.
+  const auto reader = open_parquet_file(file_path);
+  const int num_row_groups = reader->num_row_groups();
+  for (int row_group = (*next_row_group)++; row_group < num_row_groups;
+       row_group = (*next_row_group)++) {
+    std::shared_ptr<arrow::Table> table;
+    import_status.read_us += measure<std::chrono::microseconds>::execution(
+        [&]() { PARQUET_THROW_NOT_OK(reader->ReadRowGroup(row_group, &table)); });
+    if (static_cast<size_t>(table->num_columns()) != col_descs.size()) {
+      throw std::runtime_error("Parquet file " + file_path + " has " +
+                               std::to_string(table->num_columns()) +
+                               " columns, the table has " +
+                               std::to_string(col_descs.size()));
+    }
+    for (const auto& p : import_buffers) {
+      p->clear();
+    }
+    import_status.parse_us += measure<std::chrono::microseconds>::execution([&]() {
+      size_t col_idx = 0;
+      for (const auto cd : col_descs) {
+        for (const auto& chunk : table->column(col_idx)->data()->chunks()) {
+          import_buffers[col_idx]->add_arrow_values(cd, *chunk);
+        }
+        ++col_idx;
+      }
+    });
+    const size_t row_count = table->num_rows();
+    if (row_count > 0) {
+      import_status.load_us += measure<std::chrono::microseconds>::execution(
+          [&]() { importer->load(import_buffers, row_count); });
+      import_status.rows_completed += row_count;
+    }
+  }
+  // The buffers can point into the last row group, which is gone now.
+  for (const auto& p : import_buffers) {
+    p->clear();
+  }
+  import_status.thread_id = thread_id;
+  return import_status;
+}
+#endif  // ENABLE_IMPORT_PARQUET
+
+void Importer::import_local_parquet(const std::string& file_path) {
+#ifdef ENABLE_IMPORT_PARQUET
+  for (const auto cd : loader->get_column_descs()) {
+    if (cd->columnType.is_geometry() || cd->columnType.is_array()) {
+      throw std::runtime_error("Parquet import into " +
+                               cd->columnType.get_type_name() +
+                               " columns is not supported yet");
+    }
+  }
+  set_import_status(import_id, import_status);
+  max_threads = copy_params.threads ? static_cast<size_t>(copy_params.threads)
+                                    : static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF));
+  const int num_row_groups = open_parquet_file(file_path)->num_row_groups();
+  max_threads = std::max(std::min(max_threads, static_cast<size_t>(num_row_groups)),
+                         size_t(1));
+  for (size_t i = import_buffers_vec.size(); i < max_threads; i++) {
+    import_buffers_vec.emplace_back();
+    for (const auto cd : loader->get_column_descs()) {
+      import_buffers_vec[i].push_back(std::unique_ptr<TypedImportBuffer>(
+          new TypedImportBuffer(cd, loader->get_string_dict(cd))));
+    }
+  }
+  const auto start_epoch = loader->getTableEpoch();
+  std::atomic<int> next_row_group{0};
+  std::vector<std::future<ImportStatus>> threads;
+  for (size_t i = 0; i < max_threads; i++) {
+    threads.push_back(std::async(
+        std::launch::async, import_thread_parquet, i, this, file_path, &next_row_group));
+  }
+  for (auto& p : threads) {
+    p.wait();
+  }
+  try {
+    for (auto& p : threads) {
+      import_status += p.get();
+    }
+  } catch (...) {
+    loader->setTableEpoch(start_epoch);
+    throw;
+  }
+  import_status.rows_estimated = import_status.rows_completed;
+  set_import_status(import_id, import_status);
+  checkpoint(start_epoch);
+#else
+  throw std::runtime_error("Parquet support not available");
+#endif  // ENABLE_IMPORT_PARQUET
+}
 void DataStreamSink::import_parquet(std::vector<std::string>& file_paths) {
   std::exception_ptr teptr;
   // file_paths may contain one local file path, a list of local file paths
@@ -2839,6 +3624,62 @@ void DataStreamSink::import_parquet(std::vector<std::string>& file_paths) {
   }
 }
 
+void DataStreamSink::read_archive(
+    Archive& arch,
+    const std::function<bool(const char*, size_t)>& write_bytes) {
+  const void* buf;
+  size_t size;
+  int64_t offset;
+  bool just_saw_archive_header;
+  bool is_detecting = nullptr != dynamic_cast<Detector*>(this);
+  bool first_text_header_skipped = false;
+  // start reading uncompressed bytes of this archive from libarchive
+  // note! this archive may contain more than one files!
+  while (!!(just_saw_archive_header = arch.read_next_header())) {
+    bool insert_line_delim_after_this_file = false;
+    while (arch.read_data_block(&buf, &size, &offset)) {
+      // one subtle point here is now we concatenate all files
+      // to a single FILE stream with which we call importDelimited
+      // only once. this would make it misunderstand that only one
+      // header line is with this 'single' stream, while actually
+      // we may have one header line for each of the files.
+      // so we need to skip header lines here instead in importDelimited.
+      const char* buf2 = (const char*)buf;
+      int size2 = size;
+      if (copy_params.has_header && just_saw_archive_header &&
+          (first_text_header_skipped || !is_detecting)) {
+        while (size2-- > 0) {
+          if (*buf2++ == copy_params.line_delim) {
+            break;
+          }
+        }
+        if (size2 <= 0) {
+          LOG(WARNING) << "No line delimiter in block." << std::endl;
+        }
+        just_saw_archive_header = false;
+        first_text_header_skipped = true;
+      }
+      if (size2 > 0) {
+        if (!write_bytes(buf2, size2)) {
+          return;
+        }
+        // check that this file (buf for size) ended with a line delim
+        if (size > 0) {
+          const char* plast = static_cast<const char*>(buf) + (size - 1);
+          insert_line_delim_after_this_file = (*plast != copy_params.line_delim);
+        }
+      }
+    }
+    // if that file didn't end with a line delim, we insert one here to terminate
+    // that file's stream
+    if (insert_line_delim_after_this_file) {
+      if (!write_bytes(&copy_params.line_delim, 1)) {
+        return;
+      }
+    }
+  }
+}
+
 void DataStreamSink::import_compressed(std::vector<std::string>& file_paths) {
   // a new requirement is to have one single input stream into
   // Importer::importDelimited, so need to move pipe related
@@ -2876,10 +3717,83 @@ void DataStreamSink::import_compressed(std::vector<std::string>& file_paths) {
     p_file = 0;
   });
 
+  // Writes the whole buffer to the pipe, false once the import is truncated.
+  const auto write_to_pipe = [&](const char* buf, size_t size) {
+    // In very rare occasions the write pipe somehow operates in a mode similar to
+    // non-blocking while pipe(fds) should behave like pipe2(fds, 0) which means
+    // blocking mode. On such a unreliable blocking mode, a possible fix is to
+    // loop reading till no bytes left, otherwise the annoying `failed to write
+    // pipe: Success`...
+    size_t nremaining = size;
+    while (nremaining > 0) {
+      // try to write the entire remainder of the buffer to the pipe
+      ssize_t nwritten = write(fd[1], buf, nremaining);
+      // how did we do?
+      if (nwritten < 0) {
+        // something bad happened
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+          // ignore these, assume nothing written, try again
+          nwritten = 0;
+        } else {
+          // a real error
+          throw std::runtime_error(std::string("failed or interrupted write to pipe: ") +
+                                   strerror(errno));
+        }
+      }
+      nremaining -= nwritten;
+      buf += nwritten;
+      // no exception when too many rejected
+      // @simon.eves how would this get set? from the other thread? mutex
+      // needed?
+      if (import_status.load_truncated) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  // when import is aborted because too many data errors or because end of a
+  // detection, any exception thrown by s3 sdk or libarchive is okay and should be
+  // suppressed.
+  const auto keep_writer_exception = [&]() {
+    if (import_status.load_truncated) {
+      return;
+    }
+    if (import_status.rows_completed > 0) {
+      if (nullptr != dynamic_cast<Detector*>(this)) {
+        return;
+      }
+    }
+    if (!teptr) {  // no replace
+      teptr = std::current_exception();
+    }
+  };
+
+  // Local archives are decompressed in parallel, in the order of the pipe, unless
+  // detecting which only reads the beginning of the first one.
+  const bool decompress_in_parallel =
+      file_paths.size() > 1 && copy_params.threads != 1 &&
+      nullptr == dynamic_cast<Detector*>(this) &&
+      std::all_of(file_paths.begin(), file_paths.end(), [](const std::string& path) {
+        std::map<int, std::string> url_parts;
+        Archive::parse_url(path, url_parts);
+        return "file" == url_parts[2] || "" == url_parts[2];
+      });
+
   // create a thread to iterate all files (in all archives) and
   // forward the uncompressed byte stream to fd[1] which is
   // then feed into importDelimited, importParquet, and etc.
   auto th_pipe_writer = std::thread([&]() {
+    if (decompress_in_parallel) {
+      try {
+        import_compressed_in_parallel(file_paths, write_to_pipe);
+      } catch (...) {
+        keep_writer_exception();
+      }
+      // close writer end
+      close(fd[1]);
+      return;
+    }
     std::unique_ptr<S3Archive> us3arch;
     bool stop = false;
     for (size_t fi = 0; !stop && fi < file_paths.size(); fi++) {
@@ -2933,127 +3847,14 @@ void DataStreamSink::import_compressed(std::vector<std::string>& file_paths) {
           throw std::runtime_error(std::string("unsupported archive url: ") + file_path);
         }
 
-        // init the archive for read
-        auto& arch = *uarch;
-
         // coming here, the archive of url should be ready to be read, unarchived
         // and uncompressed by libarchive into a byte stream (in csv) for the pipe
-        const void* buf;
-        size_t size;
-        int64_t offset;
-        bool just_saw_archive_header;
-        bool is_detecting = nullptr != dynamic_cast<Detector*>(this);
-        bool first_text_header_skipped = false;
-        // start reading uncompressed bytes of this archive from libarchive
-        // note! this archive may contain more than one files!
-        while (!stop && !!(just_saw_archive_header = arch.read_next_header())) {
-          bool insert_line_delim_after_this_file = false;
-          while (!stop && arch.read_data_block(&buf, &size, &offset)) {
-            // one subtle point here is now we concatenate all files
-            // to a single FILE stream with which we call importDelimited
-            // only once. this would make it misunderstand that only one
-            // header line is with this 'single' stream, while actually
-            // we may have one header line for each of the files.
-            // so we need to skip header lines here instead in importDelimited.
-            const char* buf2 = (const char*)buf;
-            int size2 = size;
-            if (copy_params.has_header && just_saw_archive_header &&
-                (first_text_header_skipped || !is_detecting)) {
-              while (size2-- > 0) {
-                if (*buf2++ == copy_params.line_delim) {
-                  break;
-                }
-              }
-              if (size2 <= 0) {
-                LOG(WARNING) << "No line delimiter in block." << std::endl;
-              }
-              just_saw_archive_header = false;
-              first_text_header_skipped = true;
-            }
-            // In very rare occasions the write pipe somehow operates in a mode similar to
-            // non-blocking while pipe(fds) should behave like pipe2(fds, 0) which means
-            // blocking mode. On such a unreliable blocking mode, a possible fix is to
-            // loop reading till no bytes left, otherwise the annoying `failed to write
-            // pipe: Success`...
-            if (size2 > 0) {
-              int nremaining = size2;
-              while (nremaining > 0) {
-                // try to write the entire remainder of the buffer to the pipe
-                int nwritten = write(fd[1], buf2, nremaining);
-                // how did we do?
-                if (nwritten < 0) {
-                  // something bad happened
-                  if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
-                    // ignore these, assume nothing written, try again
-                    nwritten = 0;
-                  } else {
-                    // a real error
-                    throw std::runtime_error(
-                        std::string("failed or interrupted write to pipe: ") +
-                        strerror(errno));
-                  }
-                } else if (nwritten == nremaining) {
-                  // we wrote everything; we're done
-                  break;
-                }
-                // only wrote some (or nothing), try again
-                nremaining -= nwritten;
-                buf2 += nwritten;
-                // no exception when too many rejected
-                // @simon.eves how would this get set? from the other thread? mutex
-                // needed?
-                if (import_status.load_truncated) {
-                  stop = true;
-                  break;
-                }
-              }
-              // check that this file (buf for size) ended with a line delim
-              if (size > 0) {
-                const char* plast = static_cast<const char*>(buf) + (size - 1);
-                insert_line_delim_after_this_file = (*plast != copy_params.line_delim);
-              }
-            }
-          }
-          // if that file didn't end with a line delim, we insert one here to terminate
-          // that file's stream use a loop for the same reason as above
-          if (insert_line_delim_after_this_file) {
-            while (true) {
-              // write the delim char to the pipe
-              int nwritten = write(fd[1], &copy_params.line_delim, 1);
-              // how did we do?
-              if (nwritten < 0) {
-                // something bad happened
-                if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
-                  // ignore these, assume nothing written, try again
-                  nwritten = 0;
-                } else {
-                  // a real error
-                  throw std::runtime_error(
-                      std::string("failed or interrupted write to pipe: ") +
-                      strerror(errno));
-                }
-              } else if (nwritten == 1) {
-                // we wrote it; we're done
-                break;
-              }
-            }
-          }
-        }
+        read_archive(*uarch, [&](const char* buf, size_t size) {
+          stop = !write_to_pipe(buf, size);
+          return !stop;
+        });
       } catch (...) {
-        // when import is aborted because too many data errors or because end of a
-        // detection, any exception thrown by s3 sdk or libarchive is okay and should be
-        // suppressed.
-        if (import_status.load_truncated) {
-          break;
-        }
-        if (import_status.rows_completed > 0) {
-          if (nullptr != dynamic_cast<Detector*>(this)) {
-            break;
-          }
-        }
-        if (!teptr) {  // no replace
-          teptr = std::current_exception();
-        }
+        keep_writer_exception();
         break;
       }
     }
@@ -3070,6 +3871,112 @@ void DataStreamSink::import_compressed(std::vector<std::string>& file_paths) {
   }
 }
 
+// Every archive is decompressed by a worker into its own queue of blocks, the blocks are
+// written to the pipe one archive after the other. Past the budget, the workers wait
+// for the blocks to be written, except for the one of the archive being written when
+// its queue is empty, so the pipe never starves.
+void DataStreamSink::import_compressed_in_parallel(
+    const std::vector<std::string>& file_paths,
+    const std::function<bool(const char*, size_t)>& write_to_pipe) {
+  const size_t max_buffered_bytes = 64 << 20;
+  struct DecompressedArchive {
+    std::deque<std::string> blocks;
+    bool done{false};
+    std::exception_ptr error;
+  };
+  std::vector<DecompressedArchive> archives(file_paths.size());
+  std::mutex archives_mutex;
+  std::condition_variable archives_cv;
+  size_t next_archive{0};
+  size_t writing_archive{0};
+  size_t buffered_bytes{0};
+  bool stop_workers{false};
+
+  const auto decompress = [&]() {
+    while (true) {
+      size_t archive_idx;
+      {
+        std::lock_guard<std::mutex> lock(archives_mutex);
+        if (stop_workers || next_archive == archives.size()) {
+          return;
+        }
+        archive_idx = next_archive++;
+      }
+      auto& archive = archives[archive_idx];
+      try {
+        PosixFileArchive arch(file_paths[archive_idx], copy_params.plain_text);
+        read_archive(arch, [&](const char* buf, size_t size) {
+          std::unique_lock<std::mutex> lock(archives_mutex);
+          archives_cv.wait(lock, [&] {
+            return stop_workers || buffered_bytes < max_buffered_bytes ||
+                   (archive_idx == writing_archive && archive.blocks.empty());
+          });
+          if (stop_workers) {
+            return false;
+          }
+          archive.blocks.emplace_back(buf, size);
+          buffered_bytes += size;
+          archives_cv.notify_all();
+          return true;
+        });
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(archives_mutex);
+        archive.error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(archives_mutex);
+      archive.done = true;
+      archives_cv.notify_all();
+    }
+  };
+
+  const size_t worker_count = std::min(
+      copy_params.threads ? static_cast<size_t>(copy_params.threads)
+                          : static_cast<size_t>(sysconf(_SC_NPROCESSORS_CONF)),
+      file_paths.size());
+  std::vector<std::future<void>> workers;
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers.push_back(std::async(std::launch::async, decompress));
+  }
+  const auto stop_and_join_workers = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(archives_mutex);
+      stop_workers = true;
+      archives_cv.notify_all();
+    }
+    for (auto& worker : workers) {
+      worker.wait();
+    }
+  };
+  ScopeGuard join_workers = [&stop_and_join_workers] { stop_and_join_workers(); };
+
+  for (size_t archive_idx = 0; archive_idx < archives.size(); ++archive_idx) {
+    auto& archive = archives[archive_idx];
+    while (true) {
+      std::string block;
+      {
+        std::unique_lock<std::mutex> lock(archives_mutex);
+        archives_cv.wait(lock, [&] { return !archive.blocks.empty() || archive.done; });
+        if (archive.blocks.empty()) {
+          if (archive.error) {
+            std::rethrow_exception(archive.error);
+          }
+          break;
+        }
+        block = std::move(archive.blocks.front());
+        archive.blocks.pop_front();
+        buffered_bytes -= block.size();
+        archives_cv.notify_all();
+      }
+      if (!write_to_pipe(block.data(), block.size())) {
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> lock(archives_mutex);
+    writing_archive = archive_idx + 1;
+    archives_cv.notify_all();
+  }
+}
+
 ImportStatus Importer::import() {
   return DataStreamSink::archivePlumber();
 }
@@ -3123,7 +4030,9 @@ ImportStatus Importer::importDelimited(const std::string& file_path,
   size_t begin_pos = 0;
 
   (void)fseek(p_file, current_pos, SEEK_SET);
-  size_t size = fread((void*)sbuffer.get(), 1, alloc_size, p_file);
+  size_t size{0};
+  import_status.read_us += measure<std::chrono::microseconds>::execution(
+      [&]() { size = fread((void*)sbuffer.get(), 1, alloc_size, p_file); });
 
   // make render group analyzers for each poly column
   ColumnIdToRenderGroupAnalyzerMapType columnIdToRenderGroupAnalyzerMap;
@@ -3204,10 +4113,12 @@ ImportStatus Importer::importDelimited(const std::string& file_path,
       current_pos += end_pos;
       sbuffer.reset(new char[alloc_size]);
       memcpy(sbuffer.get(), unbuf.get(), nresidual);
-      size = nresidual + fread(sbuffer.get() + nresidual,
-                               1,
-                               IMPORT_FILE_BUFFER_SIZE - nresidual,
-                               p_file);
+      import_status.read_us += measure<std::chrono::microseconds>::execution([&]() {
+        size = nresidual + fread(sbuffer.get() + nresidual,
+                                 1,
+                                 IMPORT_FILE_BUFFER_SIZE - nresidual,
+                                 p_file);
+      });
       if (size < IMPORT_FILE_BUFFER_SIZE && feof(p_file)) {
         eof_reached = true;
       }
@@ -3275,26 +4186,34 @@ ImportStatus Importer::importDelimited(const std::string& file_path,
       p.wait();
     }
 
-    if (load_failed) {
-      // rollback to starting epoch - undo all the added records
-      loader->setTableEpoch(start_epoch);
-    } else {
-      loader->checkpoint();
-    }
+    checkpoint(start_epoch);
   }
 
-  if (loader->get_table_desc()->persistenceLevel ==
-      Data_Namespace::MemoryLevel::DISK_LEVEL) {  // only checkpoint disk-resident tables
+  // must set import_status.load_truncated before closing this end of pipe
+  // otherwise, the thread on the other end would throw an unwanted 'write()'
+  // exception
+  import_status.load_truncated = load_truncated;
+
+  fclose(p_file);
+  p_file = nullptr;
+  return import_status;
+}
+
+void Importer::checkpoint(const int32_t start_epoch) {
+  const auto checkpoint_start = timer_start();
+  // The dictionaries go first, all at once, so the checkpointed epoch of the table never
+  // references strings which weren't. The table is rolled back if they fail.
+  if (!load_failed && loader->get_table_desc()->persistenceLevel ==
+                          Data_Namespace::MemoryLevel::DISK_LEVEL) {
     auto ms = measure<>::execution([&]() {
-      if (!load_failed) {
-        for (auto& p : import_buffers_vec[0]) {
-          if (!p->stringDictCheckpoint()) {
-            LOG(ERROR) << "Checkpointing Dictionary for Column "
-                       << p->getColumnDesc()->columnName << " failed.";
-            load_failed = true;
-            break;
-          }
-        }
+      std::vector<StringDictionary*> string_dicts;
+      for (const auto& import_buffer : import_buffers_vec[0]) {
+        string_dicts.push_back(import_buffer->getStringDictionary());
+      }
+      if (!checkpoint_string_dictionaries(string_dicts)) {
+        LOG(ERROR) << "Checkpointing the dictionaries of table "
+                   << loader->get_table_desc()->tableName << " failed.";
+        load_failed = true;
       }
     });
     if (DEBUG_TIMING) {
@@ -3302,14 +4221,16 @@ ImportStatus Importer::importDelimited(const std::string& file_path,
                 << std::endl;
     }
   }
-  // must set import_status.load_truncated before closing this end of pipe
-  // otherwise, the thread on the other end would throw an unwanted 'write()'
-  // exception
-  import_status.load_truncated = load_truncated;
 
-  fclose(p_file);
-  p_file = nullptr;
-  return import_status;
+  if (load_failed) {
+    // rollback to starting epoch - undo all the added records
+    loader->setTableEpoch(start_epoch);
+  } else {
+    loader->checkpoint();
+  }
+  import_status.checkpoint_us +=
+      timer_stop<std::chrono::steady_clock::time_point, std::chrono::microseconds>(
+          checkpoint_start);
 }
 
 void Loader::checkpoint() {
@@ -3881,7 +4802,43 @@ ImportStatus Importer::importGDAL(
     }
   }
 
+  bool read_in_threads{false};
 #if !DISABLE_MULTI_THREADED_SHAPEFILE_IMPORT
+  // Shapefiles are read by the threads themselves, each chunk of features seeked to
+  // through a dataset of the thread since OGR handles can't be shared between threads,
+  // instead of feature by feature here. Other drivers, GeoJSON loading the whole file
+  // on open in particular, are still read here.
+  read_in_threads = max_threads > 1 &&
+                    std::string(poDS->GetDriverName()) == "ESRI Shapefile" &&
+                    poLayer->TestCapability(OLCFastSetNextByIndex);
+  std::vector<OGRDataSourceUqPtr> thread_datasets(max_threads);
+  const auto read_features = [this, &thread_datasets](const size_t thread_id,
+                                                      const size_t firstFeature,
+                                                      const size_t numFeatures,
+                                                      FeaturePtrVector& features) {
+    auto& dataset = thread_datasets[thread_id];
+    if (!dataset) {
+      dataset.reset(openGDALDataset(file_path, copy_params));
+      if (!dataset) {
+        throw std::runtime_error("openGDALDataset Error: Unable to open geo file " +
+                                 file_path);
+      }
+    }
+    OGRLayer* layer = dataset->GetLayer(0);
+    CHECK(layer);
+    layer->SetNextByIndex(firstFeature);
+    for (size_t i = 0; i < numFeatures; i++) {
+      OGRFeatureUqPtr feature(layer->GetNextFeature());
+      // deleted records are skipped, stop at the first feature of the next chunk
+      if (!feature ||
+          feature->GetFID() >= static_cast<GIntBig>(firstFeature + numFeatures)) {
+        break;
+      }
+      features.push_back(std::move(feature));
+    }
+    features.resize(numFeatures);
+  };
+
   // threads
   std::list<std::future<ImportStatus>> threads;
 
@@ -3921,8 +4878,10 @@ ImportStatus Importer::importGDAL(
 #endif
 
     // fill features buffer for new thread
-    for (size_t i = 0; i < numFeaturesThisChunk; i++) {
-      features[thread_id].emplace_back(poLayer->GetNextFeature());
+    if (!read_in_threads) {
+      for (size_t i = 0; i < numFeaturesThisChunk; i++) {
+        features[thread_id].emplace_back(poLayer->GetNextFeature());
+      }
     }
 
 #if DISABLE_MULTI_THREADED_SHAPEFILE_IMPORT
@@ -3942,17 +4901,25 @@ ImportStatus Importer::importGDAL(
     set_import_status(import_id, import_status);
 #else
     // fire up that thread to import this geometry
-    threads.push_back(std::async(std::launch::async,
-                                 import_thread_shapefile,
-                                 thread_id,
-                                 this,
-                                 poGeographicSR.get(),
-                                 std::move(features[thread_id]),
-                                 firstFeatureThisChunk,
-                                 numFeaturesThisChunk,
-                                 fieldNameToIndexMap,
-                                 columnNameToSourceNameMap,
-                                 columnIdToRenderGroupAnalyzerMap));
+    threads.push_back(std::async(
+        std::launch::async,
+        [&, thread_id, firstFeatureThisChunk, numFeaturesThisChunk](
+            FeaturePtrVector thread_features) {
+          if (read_in_threads) {
+            read_features(
+                thread_id, firstFeatureThisChunk, numFeaturesThisChunk, thread_features);
+          }
+          return import_thread_shapefile(thread_id,
+                                         this,
+                                         poGeographicSR.get(),
+                                         thread_features,
+                                         firstFeatureThisChunk,
+                                         numFeaturesThisChunk,
+                                         fieldNameToIndexMap,
+                                         columnNameToSourceNameMap,
+                                         columnIdToRenderGroupAnalyzerMap);
+        },
+        std::move(features[thread_id])));
 
     // let the threads run
     while (threads.size() > 0) {
@@ -4026,26 +4993,7 @@ ImportStatus Importer::importGDAL(
   }
 #endif
 
-  if (load_failed) {
-    // rollback to starting epoch - undo all the added records
-    loader->setTableEpoch(start_epoch);
-  } else {
-    loader->checkpoint();
-  }
-
-  if (!load_failed &&
-      loader->get_table_desc()->persistenceLevel ==
-          Data_Namespace::MemoryLevel::DISK_LEVEL) {  // only checkpoint disk-resident
-                                                      // tables
-    for (auto& p : import_buffers_vec[0]) {
-      if (!p->stringDictCheckpoint()) {
-        LOG(ERROR) << "Checkpointing Dictionary for Column "
-                   << p->getColumnDesc()->columnName << " failed.";
-        load_failed = true;
-        break;
-      }
-    }
-  }
+  checkpoint(start_epoch);
 
   // must set import_status.load_truncated before closing this end of pipe
   // otherwise, the thread on the other end would throw an unwanted 'write()'
@@ -4184,6 +5132,32 @@ void RenderGroupAnalyzer::seedFromExistingTableContents(
 
 int RenderGroupAnalyzer::insertBoundsAndReturnRenderGroup(
     const std::vector<double>& bounds) {
+  const auto bounding_box = toBoundingBox(bounds);
+
+  // remainder under mutex to allow this to be multi-threaded
+  std::lock_guard<std::mutex> guard(_rtreeMutex);
+  return insertBoundingBox(bounding_box);
+}
+
+std::vector<int> RenderGroupAnalyzer::insertBoundsAndReturnRenderGroups(
+    const std::vector<std::vector<double>>& all_bounds) {
+  std::vector<BoundingBox> bounding_boxes;
+  bounding_boxes.reserve(all_bounds.size());
+  for (const auto& bounds : all_bounds) {
+    bounding_boxes.push_back(toBoundingBox(bounds));
+  }
+
+  std::vector<int> render_groups;
+  render_groups.reserve(bounding_boxes.size());
+  std::lock_guard<std::mutex> guard(_rtreeMutex);
+  for (const auto& bounding_box : bounding_boxes) {
+    render_groups.push_back(insertBoundingBox(bounding_box));
+  }
+  return render_groups;
+}
+
+RenderGroupAnalyzer::BoundingBox RenderGroupAnalyzer::toBoundingBox(
+    const std::vector<double>& bounds) {
   // validate
   CHECK(bounds.size() == 4);
 
@@ -4192,10 +5166,10 @@ int RenderGroupAnalyzer::insertBoundsAndReturnRenderGroup(
   boost::geometry::assign_inverse(bounding_box);
   boost::geometry::expand(bounding_box, Point(bounds[0], bounds[1]));
   boost::geometry::expand(bounding_box, Point(bounds[2], bounds[3]));
+  return bounding_box;
+}
 
-  // remainder under mutex to allow this to be multi-threaded
-  std::lock_guard<std::mutex> guard(_rtreeMutex);
-
+int RenderGroupAnalyzer::insertBoundingBox(const BoundingBox& bounding_box) {
   // get the intersecting nodes
   std::vector<Node> intersects;
   _rtree->query(boost::geometry::index::intersects(bounding_box),
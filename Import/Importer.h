@@ -33,8 +33,10 @@
 #include <boost/filesystem.hpp>
 #include <boost/noncopyable.hpp>
 #include <boost/tokenizer.hpp>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <map>
@@ -44,6 +46,7 @@
 #include "../Catalog/TableDescriptor.h"
 #include "../Chunk/Chunk.h"
 #include "../Fragmenter/Fragmenter.h"
+#include "../Shared/StringArena.h"
 #include "../Shared/checked_alloc.h"
 
 // Some builds of boost::geometry require iostream, but don't explicitly include it.
@@ -52,6 +55,14 @@
 
 class TDatum;
 class TColumn;
+class Archive;
+
+// Checkpoint the tables at most that many milliseconds after a load which would have
+// checkpointed them, with the loads of the meantime, 0 checkpoints every load. A crash
+// rolls the table back to its last checkpoint, like an interrupted load.
+extern size_t g_load_commit_interval_ms;
+// Checkpoint right away once that many loaded rows of a table wait for the interval.
+extern size_t g_load_commit_max_rows;
 
 namespace arrow {
 
@@ -79,6 +90,9 @@ struct CopyParams {
       max_reject;  // maximum number of records that can be rejected before copy is failed
   TableType table_type;
   bool plain_text = false;
+  // Whether the rows of the keys already in a table with a primary key are skipped
+  // instead of updated.
+  bool skip_duplicate_keys = false;
   // s3/parquet related params
   bool is_parquet;
   std::string s3_access_key;  // per-query credentials to override the
@@ -177,8 +191,8 @@ class TypedImportBuffer : boost::noncopyable {
       case kTEXT:
       case kVARCHAR:
       case kCHAR:
-        string_buffer_ = new std::vector<std::string>();
         if (col_desc->columnType.get_compression() == kENCODING_DICT) {
+          dict_string_buffer_ = new StringArena();
           switch (col_desc->columnType.get_size()) {
             case 1:
               string_dict_i8_buffer_ = new std::vector<uint8_t>();
@@ -192,6 +206,8 @@ class TypedImportBuffer : boost::noncopyable {
             default:
               CHECK(false);
           }
+        } else {
+          string_buffer_ = new std::vector<std::string>();
         }
         break;
       case kTIME:
@@ -246,8 +262,8 @@ class TypedImportBuffer : boost::noncopyable {
       case kTEXT:
       case kVARCHAR:
       case kCHAR:
-        delete string_buffer_;
         if (column_desc_->columnType.get_compression() == kENCODING_DICT) {
+          delete dict_string_buffer_;
           switch (column_desc_->columnType.get_size()) {
             case 1:
               delete string_dict_i8_buffer_;
@@ -259,6 +275,8 @@ class TypedImportBuffer : boost::noncopyable {
               delete string_dict_i32_buffer_;
               break;
           }
+        } else {
+          delete string_buffer_;
         }
         break;
       case kTIME:
@@ -298,7 +316,13 @@ class TypedImportBuffer : boost::noncopyable {
 
   void addDouble(const double v) { double_buffer_->push_back(v); }
 
-  void addString(const std::string& v) { string_buffer_->push_back(v); }
+  void addString(const std::string& v) {
+    if (column_desc_->columnType.get_compression() == kENCODING_DICT) {
+      dict_string_buffer_->push_back(v);
+    } else {
+      string_buffer_->push_back(v);
+    }
+  }
 
   void addGeoString(const std::string& v) { geo_string_buffer_->push_back(v); }
 
@@ -315,10 +339,10 @@ class TypedImportBuffer : boost::noncopyable {
 
   void addTime(const time_t v) { time_buffer_->push_back(v); }
 
-  void addDictEncodedString(const std::vector<std::string>& string_vec) {
+  void addDictEncodedString(const StringArena& string_vec) {
     CHECK(string_dict_);
-    for (const auto& str : string_vec) {
-      if (str.size() > StringDictionary::MAX_STRLEN) {
+    for (size_t i = 0; i < string_vec.size(); ++i) {
+      if (string_vec[i].size() > StringDictionary::MAX_STRLEN) {
         throw std::runtime_error("String too long for dictionary encoding.");
       }
     }
@@ -338,6 +362,7 @@ class TypedImportBuffer : boost::noncopyable {
       default:
         CHECK(false);
     }
+    dict_encoded_strings_ = true;
   }
 
   void addDictEncodedStringArray(
@@ -364,6 +389,9 @@ class TypedImportBuffer : boost::noncopyable {
   StringDictionary* getStringDictionary() const { return string_dict_; }
 
   int8_t* getAsBytes() const {
+    if (arrow_values_) {
+      return const_cast<int8_t*>(arrow_values_);
+    }
     switch (column_desc_->columnType.get_type()) {
       case kBOOLEAN:
         return reinterpret_cast<int8_t*>(&((*bool_buffer_)[0]));
@@ -419,6 +447,9 @@ class TypedImportBuffer : boost::noncopyable {
 
   std::vector<std::string>* getStringBuffer() const { return string_buffer_; }
 
+  // The strings of a dictionary encoded column, until they are encoded.
+  StringArena* getDictStringBuffer() const { return dict_string_buffer_; }
+
   std::vector<std::string>* getGeoStringBuffer() const { return geo_string_buffer_; }
 
   std::vector<ArrayDatum>* getArrayBuffer() const { return array_buffer_; }
@@ -444,13 +475,45 @@ class TypedImportBuffer : boost::noncopyable {
     }
   }
 
-  bool stringDictCheckpoint() {
-    if (string_dict_ == nullptr)
-      return true;
-    return string_dict_->checkpoint();
+  // Whether the strings of a dictionary encoded column have been encoded as they were
+  // added, in which case only the dictionary buffer holds them.
+  bool hasDictEncodedStrings() const { return dict_encoded_strings_; }
+
+  int32_t getStringDictId(const size_t index) const {
+    switch (column_desc_->columnType.get_size()) {
+      case 1:
+        return (*string_dict_i8_buffer_)[index];
+      case 2:
+        return (*string_dict_i16_buffer_)[index];
+      case 4:
+        return (*string_dict_i32_buffer_)[index];
+      default:
+        CHECK(false);
+    }
+    return 0;
+  }
+
+  void addStringDictId(const int32_t id) {
+    CHECK(dict_string_buffer_->empty());
+    switch (column_desc_->columnType.get_size()) {
+      case 1:
+        string_dict_i8_buffer_->push_back(id);
+        break;
+      case 2:
+        string_dict_i16_buffer_->push_back(id);
+        break;
+      case 4:
+        string_dict_i32_buffer_->push_back(id);
+        break;
+      default:
+        CHECK(false);
+    }
+    dict_encoded_strings_ = true;
   }
 
   void clear() {
+    arrow_values_ = nullptr;
+    dict_encoded_strings_ = false;
     switch (column_desc_->columnType.get_type()) {
       case kBOOLEAN: {
         bool_buffer_->clear();
@@ -485,8 +548,10 @@ class TypedImportBuffer : boost::noncopyable {
       case kTEXT:
       case kVARCHAR:
       case kCHAR: {
-        string_buffer_->clear();
-        if (column_desc_->columnType.get_compression() == kENCODING_DICT) {
+        if (column_desc_->columnType.get_compression() != kENCODING_DICT) {
+          string_buffer_->clear();
+        } else {
+          dict_string_buffer_->clear();
           switch (column_desc_->columnType.get_size()) {
             case 1:
               string_dict_i8_buffer_->clear();
@@ -528,6 +593,77 @@ class TypedImportBuffer : boost::noncopyable {
     }
   }
 
+  // Makes room for row_count more values, the strings of a dictionary encoded column
+  // are expected to be added as ids.
+  void reserve(const size_t row_count) {
+    switch (column_desc_->columnType.get_type()) {
+      case kBOOLEAN:
+        bool_buffer_->reserve(bool_buffer_->size() + row_count);
+        break;
+      case kTINYINT:
+        tinyint_buffer_->reserve(tinyint_buffer_->size() + row_count);
+        break;
+      case kSMALLINT:
+        smallint_buffer_->reserve(smallint_buffer_->size() + row_count);
+        break;
+      case kINT:
+        int_buffer_->reserve(int_buffer_->size() + row_count);
+        break;
+      case kBIGINT:
+      case kNUMERIC:
+      case kDECIMAL:
+        bigint_buffer_->reserve(bigint_buffer_->size() + row_count);
+        break;
+      case kFLOAT:
+        float_buffer_->reserve(float_buffer_->size() + row_count);
+        break;
+      case kDOUBLE:
+        double_buffer_->reserve(double_buffer_->size() + row_count);
+        break;
+      case kTEXT:
+      case kVARCHAR:
+      case kCHAR:
+        if (column_desc_->columnType.get_compression() != kENCODING_DICT) {
+          string_buffer_->reserve(string_buffer_->size() + row_count);
+          break;
+        }
+        switch (column_desc_->columnType.get_size()) {
+          case 1:
+            string_dict_i8_buffer_->reserve(string_dict_i8_buffer_->size() + row_count);
+            break;
+          case 2:
+            string_dict_i16_buffer_->reserve(string_dict_i16_buffer_->size() + row_count);
+            break;
+          case 4:
+            string_dict_i32_buffer_->reserve(string_dict_i32_buffer_->size() + row_count);
+            break;
+          default:
+            CHECK(false);
+        }
+        break;
+      case kTIME:
+      case kTIMESTAMP:
+      case kDATE:
+        time_buffer_->reserve(time_buffer_->size() + row_count);
+        break;
+      case kARRAY:
+        if (IS_STRING(column_desc_->columnType.get_subtype())) {
+          string_array_buffer_->reserve(string_array_buffer_->size() + row_count);
+        } else {
+          array_buffer_->reserve(array_buffer_->size() + row_count);
+        }
+        break;
+      case kPOINT:
+      case kLINESTRING:
+      case kPOLYGON:
+      case kMULTIPOLYGON:
+        geo_string_buffer_->reserve(geo_string_buffer_->size() + row_count);
+        break;
+      default:
+        CHECK(false);
+    }
+  }
+
   size_t add_values(const ColumnDescriptor* cd, const TColumn& data);
 
   size_t add_arrow_values(const ColumnDescriptor* cd, const arrow::Array& data);
@@ -549,6 +685,13 @@ class TypedImportBuffer : boost::noncopyable {
   }
 
  private:
+  template <class ArrowType, class T>
+  bool useArrowValues(const arrow::Array& col, std::vector<T>* buffer);
+  template <class T>
+  void materializeArrowValues(std::vector<T>* buffer);
+  template <class T>
+  void addDictEncodedArrowStrings(const arrow::Array& col, std::vector<T>* buffer);
+
   union {
     std::vector<int8_t>* bool_buffer_;
     std::vector<int8_t>* tinyint_buffer_;
@@ -559,6 +702,7 @@ class TypedImportBuffer : boost::noncopyable {
     std::vector<double>* double_buffer_;
     std::vector<time_t>* time_buffer_;
     std::vector<std::string>* string_buffer_;
+    StringArena* dict_string_buffer_;
     std::vector<std::string>* geo_string_buffer_;
     std::vector<ArrayDatum>* array_buffer_;
     std::vector<std::vector<std::string>>* string_array_buffer_;
@@ -572,6 +716,11 @@ class TypedImportBuffer : boost::noncopyable {
   const ColumnDescriptor* column_desc_;
   StringDictionary* string_dict_;
   size_t replicate_count_ = 0;
+  // Values of a fixed width column taken as is from an arrow array, which has to
+  // outlive the load. Set instead of the vector, until anything else is added.
+  const int8_t* arrow_values_ = nullptr;
+  size_t arrow_values_count_ = 0;
+  bool dict_encoded_strings_ = false;
 };
 
 class Loader {
@@ -610,6 +759,11 @@ class Loader {
   virtual void setTableEpoch(const int32_t new_epoch);
   inline void set_replicating(const bool replicating) { replicating_ = replicating; }
   inline bool get_replicating() const { return replicating_; }
+  inline void set_skip_duplicate_keys(const bool skip) { skip_duplicate_keys_ = skip; }
+  // Microseconds spent by the loads so far encoding the strings of the dictionary
+  // encoded columns and inserting into the fragmenter, summed over the threads.
+  int64_t getDictEncodeTime() const { return dict_encode_us_; }
+  int64_t getInsertTime() const { return insert_us_; }
   virtual ~Loader() {}
 
  protected:
@@ -631,8 +785,22 @@ class Loader {
                    size_t row_count,
                    const TableDescriptor* shard_table,
                    bool checkpoint);
+  bool upsertToShard(
+      const std::vector<std::unique_ptr<TypedImportBuffer>>& import_buffers,
+      size_t row_count,
+      const TableDescriptor* shard_table,
+      bool checkpoint);
+  bool insertToShard(
+      const std::vector<std::unique_ptr<TypedImportBuffer>>& import_buffers,
+      size_t row_count,
+      const TableDescriptor* shard_table,
+      bool checkpoint);
   bool replicating_ = false;
-  std::mutex loader_mutex_;
+  bool skip_duplicate_keys_ = false;
+  // Serialize the loads into each shard, or into the table if it isn't sharded.
+  std::vector<std::mutex> shard_mutexes_;
+  std::atomic<int64_t> dict_encode_us_{0};
+  std::atomic<int64_t> insert_us_{0};
 };
 
 struct ImportStatus {
@@ -644,6 +812,11 @@ struct ImportStatus {
   std::chrono::duration<size_t, std::milli> elapsed;
   bool load_truncated;
   int thread_id;  // to recall thread_id after thread exit
+  // microseconds spent in the stages of the import, summed over the threads
+  int64_t read_us;
+  int64_t parse_us;
+  int64_t load_us;
+  int64_t checkpoint_us;
   ImportStatus()
       : start(std::chrono::steady_clock::now())
       , rows_completed(0)
@@ -651,11 +824,19 @@ struct ImportStatus {
       , rows_rejected(0)
       , elapsed(0)
       , load_truncated(0)
-      , thread_id(0) {}
+      , thread_id(0)
+      , read_us(0)
+      , parse_us(0)
+      , load_us(0)
+      , checkpoint_us(0) {}
 
   ImportStatus& operator+=(const ImportStatus& is) {
     rows_completed += is.rows_completed;
     rows_rejected += is.rows_rejected;
+    read_us += is.read_us;
+    parse_us += is.parse_us;
+    load_us += is.load_us;
+    checkpoint_us += is.checkpoint_us;
 
     return *this;
   }
@@ -670,12 +851,19 @@ class DataStreamSink {
   virtual ImportStatus importDelimited(const std::string& file_path,
                                        const bool decompressed) = 0;
   const CopyParams& get_copy_params() const { return copy_params; }
-  void import_local_parquet(const std::string& file_path);
+  virtual void import_local_parquet(const std::string& file_path);
   void import_parquet(std::vector<std::string>& file_paths);
   void import_compressed(std::vector<std::string>& file_paths);
 
  protected:
   ImportStatus archivePlumber();
+  // Feeds the uncompressed bytes of every file in the archive to write_bytes, without
+  // their header line, until it returns false.
+  void read_archive(Archive& arch,
+                    const std::function<bool(const char*, size_t)>& write_bytes);
+  void import_compressed_in_parallel(
+      const std::vector<std::string>& file_paths,
+      const std::function<bool(const char*, size_t)>& write_to_pipe);
 
   CopyParams copy_params;
   const std::string file_path;
@@ -702,6 +890,7 @@ class Detector : public DataStreamSink {
  private:
   void init();
   void read_file();
+  bool read_file_ranges();
   void detect_row_delimiter();
   void split_raw_data();
   std::vector<SQLTypes> detect_column_types(const std::vector<std::string>& row);
@@ -727,6 +916,7 @@ class Detector : public DataStreamSink {
   void find_best_sqltypes_and_headers();
   ImportStatus importDelimited(const std::string& file_path, const bool decompressed);
   std::string raw_data;
+  bool read_ranges = false;
   boost::filesystem::path file_path;
   std::chrono::duration<double> timeout{1};
   std::string line1;
@@ -775,6 +965,9 @@ class RenderGroupAnalyzer {
   void seedFromExistingTableContents(const std::unique_ptr<Loader>& loader,
                                      const std::string& geoColumnBaseName);
   int insertBoundsAndReturnRenderGroup(const std::vector<double>& bounds);
+  // Same as above for a batch of bounds, with a single lock of the rtree.
+  std::vector<int> insertBoundsAndReturnRenderGroups(
+      const std::vector<std::vector<double>>& all_bounds);
 
  private:
   using Point = boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian>;
@@ -782,6 +975,9 @@ class RenderGroupAnalyzer {
   using Node = std::pair<BoundingBox, int>;
   using RTree =
       boost::geometry::index::rtree<Node, boost::geometry::index::quadratic<16>>;
+  static BoundingBox toBoundingBox(const std::vector<double>& bounds);
+  // Requires _rtreeMutex.
+  int insertBoundingBox(const BoundingBox& bounding_box);
   std::unique_ptr<RTree> _rtree;
   std::mutex _rtreeMutex;
   int _numRenderGroups;
@@ -798,6 +994,7 @@ class Importer : public DataStreamSink {
   ImportStatus import();
   ImportStatus importDelimited(const std::string& file_path, const bool decompressed);
   ImportStatus importGDAL(std::map<std::string, std::string> colname_to_src);
+  void import_local_parquet(const std::string& file_path) override;
   const CopyParams& get_copy_params() const { return copy_params; }
   const std::list<const ColumnDescriptor*>& get_column_descs() const {
     return loader->get_column_descs();
@@ -851,6 +1048,8 @@ class Importer : public DataStreamSink {
   static OGRDataSource* openGDALDataset(const std::string& fileName,
                                         const CopyParams& copy_params);
   static void setGDALAuthorizationTokens(const CopyParams& copy_params);
+  // Makes the rows loaded since start_epoch durable, or rolls them back if a load failed.
+  void checkpoint(const int32_t start_epoch);
   std::string import_id;
   size_t file_size;
   size_t max_threads;
@@ -36,7 +36,10 @@
 #include "Shared/ThriftClient.h"
 #include "Shared/sqltypes.h"
 
+#include <algorithm>
 #include <chrono>
+#include <functional>
+#include <future>
 #include <thread>
 
 #include <boost/program_options.hpp>
@@ -65,6 +68,9 @@ class RebalanceCb : public RdKafka::RebalanceCb {
   }
 
  public:
+  // makes the messages consumed so far durable before their partitions go elsewhere
+  std::function<void()> before_revoke;
+
   void rebalance_cb(RdKafka::KafkaConsumer* consumer,
                     RdKafka::ErrorCode err,
                     std::vector<RdKafka::TopicPartition*>& partitions) {
@@ -76,6 +82,9 @@ class RebalanceCb : public RdKafka::RebalanceCb {
       consumer->assign(partitions);
       partition_cnt = (int)partitions.size();
     } else {
+      if (before_revoke) {
+        before_revoke();
+      }
       consumer->unassign();
       partition_cnt = 0;
     }
@@ -83,146 +92,165 @@ class RebalanceCb : public RdKafka::RebalanceCb {
   }
 };
 
-bool msg_consume(RdKafka::Message* message,
-                 RowToColumnLoader& row_loader,
-                 Importer_NS::CopyParams copy_params,
-                 const std::map<std::string,
-                                std::pair<std::unique_ptr<boost::regex>,
-                                          std::unique_ptr<std::string>>>& transformations,
-                 const bool remove_quotes) {
-  switch (message->err()) {
-    case RdKafka::ERR__TIMED_OUT:
-      VLOG(1) << " Timed out";
-      break;
-
-    case RdKafka::ERR_NO_ERROR: { /* Real message */
-      msg_cnt++;
-      msg_bytes += message->len();
-      VLOG(1) << "Read msg at offset " << message->offset();
-      RdKafka::MessageTimestamp ts;
-      ts = message->timestamp();
-      if (ts.type != RdKafka::MessageTimestamp::MSG_TIMESTAMP_NOT_AVAILABLE) {
-        std::string tsname = "?";
-        if (ts.type == RdKafka::MessageTimestamp::MSG_TIMESTAMP_CREATE_TIME) {
-          tsname = "create time";
-        } else if (ts.type == RdKafka::MessageTimestamp::MSG_TIMESTAMP_LOG_APPEND_TIME) {
-          tsname = "log append time";
-        }
-        VLOG(1) << "Timestamp: " << tsname << " " << ts.timestamp << std::endl;
-      }
-
-      char buffer[message->len() + 1];
-      sprintf(buffer,
-              "%.*s\n",
-              static_cast<int>(message->len()),
-              static_cast<const char*>(message->payload()));
-      VLOG(1) << "Full Message received is :'" << buffer << "'";
-
-      char field[MAX_FIELD_LEN];
-      size_t field_i = 0;
-
-      bool backEscape = false;
-
-      auto row_desc = row_loader.get_row_descriptor();
-
-      const std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>*
-          xforms[row_desc.size()];
-      for (size_t i = 0; i < row_desc.size(); i++) {
-        auto it = transformations.find(row_desc[i].col_name);
-        if (it != transformations.end()) {
-          xforms[i] = &(it->second);
-        } else {
-          xforms[i] = nullptr;
+using Transformations =
+    std::map<std::string,
+             std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>>;
+
+// splits the payload of a message into the values of a row, false if it doesn't have
+// the values of all the columns
+bool parse_message(const std::string& payload,
+                   const TRowDescriptor& row_desc,
+                   const std::vector<const Transformations::mapped_type*>& xforms,
+                   const Importer_NS::CopyParams& copy_params,
+                   const bool remove_quotes,
+                   const RowToColumnLoader& row_loader,
+                   std::vector<TStringValue>& row) {
+  VLOG(1) << "Full Message received is :'" << payload << "'";
+
+  char field[MAX_FIELD_LEN];
+  size_t field_i = 0;
+
+  bool backEscape = false;
+
+  // the message ends the row, as if it was followed by a line delimiter
+  for (size_t pos = 0; pos <= payload.size(); ++pos) {
+    const char iit = pos < payload.size() ? payload[pos] : '\n';
+    if (iit == copy_params.delimiter || iit == copy_params.line_delim) {
+      bool end_of_field = (iit == copy_params.delimiter);
+      bool end_of_row;
+      if (end_of_field) {
+        end_of_row = false;
+      } else {
+        end_of_row = (row_desc[row.size()].col_type.type != TDatumType::STR) ||
+                     (row.size() == row_desc.size() - 1);
+        if (!end_of_row) {
+          size_t l = copy_params.null_str.size();
+          if (field_i >= l &&
+              strncmp(field + field_i - l, copy_params.null_str.c_str(), l) == 0) {
+            end_of_row = true;
+          }
         }
       }
-
-      std::vector<TStringValue>
-          row;  // used to store each row as we move through the stream
-
-      for (auto iit : buffer) {
-        if (iit == copy_params.delimiter || iit == copy_params.line_delim) {
-          bool end_of_field = (iit == copy_params.delimiter);
-          bool end_of_row;
-          if (end_of_field) {
-            end_of_row = false;
-          } else {
-            end_of_row = (row_desc[row.size()].col_type.type != TDatumType::STR) ||
-                         (row.size() == row_desc.size() - 1);
-            if (!end_of_row) {
-              size_t l = copy_params.null_str.size();
-              if (field_i >= l &&
-                  strncmp(field + field_i - l, copy_params.null_str.c_str(), l) == 0) {
-                end_of_row = true;
-              }
-            }
+      if (!end_of_field && !end_of_row) {
+        // not enough columns yet and it is a string column
+        // treat the line delimiter as part of the string
+        field[field_i++] = iit;
+      } else {
+        field[field_i] = '\0';
+        field_i = 0;
+        TStringValue ts;
+        ts.str_val = std::string(field);
+        ts.is_null = (ts.str_val.empty() || ts.str_val == copy_params.null_str);
+        auto xform = row.size() < row_desc.size() ? xforms[row.size()] : nullptr;
+        if (!ts.is_null && xform != nullptr) {
+          if (print_transformation) {
+            std::cout << "\ntransforming\n" << ts.str_val << "\nto\n";
           }
-          if (!end_of_field && !end_of_row) {
-            // not enough columns yet and it is a string column
-            // treat the line delimiter as part of the string
-            field[field_i++] = iit;
-          } else {
-            field[field_i] = '\0';
-            field_i = 0;
-            TStringValue ts;
-            ts.str_val = std::string(field);
-            ts.is_null = (ts.str_val.empty() || ts.str_val == copy_params.null_str);
-            auto xform = row.size() < row_desc.size() ? xforms[row.size()] : nullptr;
-            if (!ts.is_null && xform != nullptr) {
-              if (print_transformation) {
-                std::cout << "\ntransforming\n" << ts.str_val << "\nto\n";
-              }
-              ts.str_val =
-                  boost::regex_replace(ts.str_val, *xform->first, *xform->second);
-              if (ts.str_val.empty()) {
-                ts.is_null = true;
-              }
-              if (print_transformation) {
-                std::cout << ts.str_val << std::endl;
-              }
-            }
-
-            row.push_back(ts);  // add column value to row
-            if (end_of_row || (row.size() > row_desc.size())) {
-              break;  // found row
-            }
+          ts.str_val = boost::regex_replace(ts.str_val, *xform->first, *xform->second);
+          if (ts.str_val.empty()) {
+            ts.is_null = true;
           }
-        } else {
-          if (iit == '\\') {
-            backEscape = true;
-          } else if (backEscape || !remove_quotes || iit != '\"') {
-            field[field_i++] = iit;
-            backEscape = false;
+          if (print_transformation) {
+            std::cout << ts.str_val << std::endl;
           }
-          // else if unescaped double-quote, continue without adding the
-          // character to the field string.
         }
-        if (field_i >= MAX_FIELD_LEN) {
-          field[MAX_FIELD_LEN - 1] = '\0';
-          std::cerr << "String too long for buffer." << std::endl;
-          if (print_error_data) {
-            std::cerr << field << std::endl;
-          }
-          field_i = 0;
-          break;
+
+        row.push_back(ts);  // add column value to row
+        if (end_of_row || (row.size() > row_desc.size())) {
+          break;  // found row
         }
       }
-      if (row.size() == row_desc.size()) {
-        // add the new data in the column format
-        bool record_loaded = row_loader.convert_string_to_column(row, copy_params);
-        if (!record_loaded) {
-          // record could not be parsed correctly consider it skipped
-          return false;
-        } else {
-          return true;
-        }
-      } else {
-        if (print_error_data) {
-          std::cerr << "Incorrect number of columns for row: ";
-          std::cerr << row_loader.print_row_with_delim(row, copy_params) << std::endl;
-          return false;
-        }
+    } else {
+      if (iit == '\\') {
+        backEscape = true;
+      } else if (backEscape || !remove_quotes || iit != '\"') {
+        field[field_i++] = iit;
+        backEscape = false;
       }
+      // else if unescaped double-quote, continue without adding the
+      // character to the field string.
+    }
+    if (field_i >= MAX_FIELD_LEN) {
+      field[MAX_FIELD_LEN - 1] = '\0';
+      std::cerr << "String too long for buffer." << std::endl;
+      if (print_error_data) {
+        std::cerr << field << std::endl;
+      }
+      field_i = 0;
+      break;
+    }
+  }
+  if (row.size() != row_desc.size()) {
+    if (print_error_data) {
+      std::cerr << "Incorrect number of columns for row: ";
+      std::cerr << row_loader.print_row_with_delim(row, copy_params) << std::endl;
+    }
+    return false;
+  }
+  return true;
+}
+
+// parses the messages of a micro-batch on parse_threads threads, then adds the rows to
+// the columns of the loader in the order of the messages, returns the number skipped
+int add_messages(const std::vector<std::string>& payloads,
+                 RowToColumnLoader& row_loader,
+                 const Importer_NS::CopyParams& copy_params,
+                 const Transformations& transformations,
+                 const bool remove_quotes,
+                 const size_t parse_threads) {
+  const auto row_desc = row_loader.get_row_descriptor();
+  std::vector<const Transformations::mapped_type*> xforms;
+  for (const auto& col : row_desc) {
+    auto it = transformations.find(col.col_name);
+    xforms.push_back(it != transformations.end() ? &(it->second) : nullptr);
+  }
+
+  std::vector<std::vector<TStringValue>> rows(payloads.size());
+  std::vector<char> parsed(payloads.size());
+  const auto parse_range = [&](const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      parsed[i] = parse_message(payloads[i],
+                                row_desc,
+                                xforms,
+                                copy_params,
+                                remove_quotes,
+                                row_loader,
+                                rows[i]);
     }
+  };
+  const size_t per_thread =
+      (payloads.size() + parse_threads - 1) / std::max<size_t>(parse_threads, 1);
+  if (per_thread >= payloads.size()) {
+    parse_range(0, payloads.size());
+  } else {
+    std::vector<std::future<void>> parsers;
+    for (size_t begin = 0; begin < payloads.size(); begin += per_thread) {
+      parsers.emplace_back(std::async(std::launch::async,
+                                      parse_range,
+                                      begin,
+                                      std::min(begin + per_thread, payloads.size())));
+    }
+    for (auto& parser : parsers) {
+      parser.get();
+    }
+  }
+
+  int skipped = 0;
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    // a record which could not be parsed correctly is considered skipped
+    if (!parsed[i] || !row_loader.convert_string_to_column(rows[i], copy_params)) {
+      skipped++;
+    }
+  }
+  return skipped;
+}
+
+// handles a consume which didn't return a message
+void consume_error(const RdKafka::Message* message) {
+  switch (message->err()) {
+    case RdKafka::ERR__TIMED_OUT:
+      VLOG(1) << " Timed out";
+      break;
 
     case RdKafka::ERR__PARTITION_EOF:
       /* Last message */
@@ -243,8 +271,7 @@ bool msg_consume(RdKafka::Message* message,
       LOG(ERROR) << "Consume failed: " << message->errstr();
       run = false;
   }
-  return false;
-};
+}
 
 class ConsumeCb : public RdKafka::ConsumeCb {
  public:
@@ -289,16 +316,22 @@ class EventCb : public RdKafka::EventCb {
 };
 
 // reads from a kafka topic (expects delimited string input)
-void kafka_insert(
-    RowToColumnLoader& row_loader,
-    const std::map<std::string,
-                   std::pair<std::unique_ptr<boost::regex>,
-                             std::unique_ptr<std::string>>>& transformations,
-    const Importer_NS::CopyParams& copy_params,
-    const bool remove_quotes,
-    std::string group_id,
-    std::string topic,
-    std::string brokers) {
+//
+// The messages are loaded in micro-batches of up to batch_size messages, a batch being
+// loaded once it is full or batch_wait_ms after its first message. The loads don't
+// checkpoint the table: every checkpoint_batches batches it gets checkpointed and only
+// then the offsets of the loaded messages get committed, so a restart resumes right
+// after the last rows which made it to disk.
+void kafka_insert(RowToColumnLoader& row_loader,
+                  const Transformations& transformations,
+                  const Importer_NS::CopyParams& copy_params,
+                  const bool remove_quotes,
+                  std::string group_id,
+                  std::string topic,
+                  std::string brokers,
+                  const size_t batch_wait_ms,
+                  const size_t checkpoint_batches,
+                  const size_t parse_threads) {
   std::string errstr;
   std::string topic_str;
   std::string mode;
@@ -429,32 +462,81 @@ void kafka_insert(
   /*
    * Consume messages
    */
-  size_t recv_rows = 0;
   int skipped = 0;
   int rows_loaded = 0;
+  std::vector<std::string> payloads;
+  auto batch_deadline = std::chrono::steady_clock::now();
+  size_t batches_since_checkpoint = 0;
+  // offset to resume from for each partition with loaded but uncommitted messages
+  std::map<std::pair<std::string, int32_t>, int64_t> next_offsets;
+
+  const auto flush = [&]() {
+    if (payloads.empty()) {
+      return;
+    }
+    skipped += add_messages(
+        payloads, row_loader, copy_params, transformations, remove_quotes, parse_threads);
+    payloads.clear();
+    if (row_loader.get_pending_row_count() > 0) {
+      row_loader.do_load_async(rows_loaded, skipped, copy_params, false);
+    }
+    ++batches_since_checkpoint;
+  };
+  const auto commit = [&]() {
+    flush();
+    if (next_offsets.empty()) {
+      return;
+    }
+    const auto epoch = row_loader.checkpoint_table(copy_params);
+    VLOG(1) << "Checkpointed at epoch " << epoch;
+    std::vector<RdKafka::TopicPartition*> offsets;
+    for (const auto& next_offset : next_offsets) {
+      offsets.push_back(RdKafka::TopicPartition::create(
+          next_offset.first.first, next_offset.first.second, next_offset.second));
+    }
+    const auto err = consumer->commitSync(offsets);
+    if (err) {
+      LOG(ERROR) << "Failed to commit offsets: " << RdKafka::err2str(err);
+    }
+    RdKafka::TopicPartition::destroy(offsets);
+    next_offsets.clear();
+    batches_since_checkpoint = 0;
+  };
+  ex_rebalance_cb.before_revoke = commit;
+
   while (run) {
-    RdKafka::Message* msg = consumer->consume(10000);
+    int timeout_ms = 10000;
+    if (!payloads.empty()) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          batch_deadline - std::chrono::steady_clock::now());
+      timeout_ms = std::max<int>(left.count(), 0);
+    }
+    RdKafka::Message* msg = consumer->consume(timeout_ms);
     if (msg->err() == RdKafka::ERR_NO_ERROR) {
-      if (!use_ccb) {
-        bool added =
-            msg_consume(msg, row_loader, copy_params, transformations, remove_quotes);
-        if (added) {
-          recv_rows++;
-          if (recv_rows == copy_params.batch_size) {
-            recv_rows = 0;
-            row_loader.do_load(rows_loaded, skipped, copy_params);
-            // make sure we now commit that we are up to here to cover the mesages we just
-            // loaded
-            consumer->commitSync();
-          }
-        } else {
-          // LOG(ERROR) << " messsage was skipped ";
-          skipped++;
-        }
+      msg_cnt++;
+      msg_bytes += msg->len();
+      VLOG(1) << "Read msg at offset " << msg->offset();
+      if (payloads.empty()) {
+        batch_deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(batch_wait_ms);
       }
+      payloads.emplace_back(static_cast<const char*>(msg->payload()), msg->len());
+      next_offsets[std::make_pair(msg->topic_name(), msg->partition())] =
+          msg->offset() + 1;
+    } else {
+      consume_error(msg);
     }
     delete msg;
+    if (payloads.size() >= copy_params.batch_size ||
+        (!payloads.empty() && std::chrono::steady_clock::now() >= batch_deadline)) {
+      flush();
+    }
+    if (batches_since_checkpoint >= checkpoint_batches) {
+      commit();
+    }
   }
+  commit();
+  ex_rebalance_cb.before_revoke = nullptr;
 
   /*
    * Stop consumer
@@ -480,6 +562,7 @@ int main(int argc, char** argv) {
   bool http = false;
   bool https = false;
   bool skip_host_verify = false;
+  bool compress = false;
   std::string ca_cert_name{""};
   std::string table_name;
   std::string db_name;
@@ -492,11 +575,12 @@ int main(int argc, char** argv) {
   size_t batch_size = 10000;
   size_t retry_count = 10;
   size_t retry_wait = 5;
+  size_t batch_wait_ms = 1000;
+  size_t checkpoint_batches = 10;
+  size_t parse_threads = std::max(std::thread::hardware_concurrency(), 1u);
   bool remove_quotes = false;
   std::vector<std::string> xforms;
-  std::map<std::string,
-           std::pair<std::unique_ptr<boost::regex>, std::unique_ptr<std::string>>>
-      transformations;
+  Transformations transformations;
   ThriftConnectionType conn_type;
 
   google::InitGoogleLogging(argv[0]);
@@ -524,6 +608,9 @@ int main(int argc, char** argv) {
   desc.add_options()("https",
                      po::bool_switch(&https)->default_value(https)->implicit_value(true),
                      "Use HTTPS transport");
+  desc.add_options()("compress",
+                     po::bool_switch(&compress)->default_value(compress)->implicit_value(true),
+                     "Compress the binary transport, for the compressed port of the server");
   desc.add_options()("skip-verify",
                      po::bool_switch(&skip_host_verify)
                          ->default_value(skip_host_verify)
@@ -545,6 +632,16 @@ int main(int argc, char** argv) {
   desc.add_options()("batch",
                      po::value<size_t>(&batch_size)->default_value(batch_size),
                      "Insert batch size");
+  desc.add_options()("batch_wait_ms",
+                     po::value<size_t>(&batch_wait_ms)->default_value(batch_wait_ms),
+                     "Max time in ms to wait for a batch to fill before loading it");
+  desc.add_options()(
+      "checkpoint_batches",
+      po::value<size_t>(&checkpoint_batches)->default_value(checkpoint_batches),
+      "Number of batches loaded between checkpoints and offset commits");
+  desc.add_options()("parse_threads",
+                     po::value<size_t>(&parse_threads)->default_value(parse_threads),
+                     "Number of threads parsing the messages of a batch");
   desc.add_options()("retry_count",
                      po::value<size_t>(&retry_count)->default_value(retry_count),
                      "Number of time to retry an insert");
@@ -720,13 +817,27 @@ int main(int argc, char** argv) {
       delim, nulls, line_delim, batch_size, retry_count, retry_wait);
   RowToColumnLoader row_loader(
       ThriftClientConnection(
-          server_host, port, conn_type, skip_host_verify, ca_cert_name, ca_cert_name),
+          server_host,
+          port,
+          conn_type,
+          skip_host_verify,
+          ca_cert_name,
+          ca_cert_name,
+          compress),
       user_name,
       passwd,
       db_name,
       table_name);
 
-  kafka_insert(
-      row_loader, transformations, copy_params, remove_quotes, group_id, topic, brokers);
+  kafka_insert(row_loader,
+               transformations,
+               copy_params,
+               remove_quotes,
+               group_id,
+               topic,
+               brokers,
+               batch_wait_ms,
+               std::max<size_t>(checkpoint_batches, 1),
+               parse_threads);
   return 0;
 }
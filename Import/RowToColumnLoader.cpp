@@ -27,6 +27,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/regex.hpp>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <iterator>
@@ -122,7 +123,7 @@ SQLTypeInfo create_array_sql_type_info_from_col_type(const TColumnType& ct) {
 
 std::string RowToColumnLoader::print_row_with_delim(
     std::vector<TStringValue> row,
-    const Importer_NS::CopyParams& copy_params) {
+    const Importer_NS::CopyParams& copy_params) const {
   std::ostringstream out;
   bool first = true;
   for (TStringValue ts : row) {
@@ -281,9 +282,68 @@ TRowDescriptor RowToColumnLoader::get_row_descriptor() {
   return row_desc_;
 };
 
+// moves the values of the columns from to the end of the columns to
+void append_columns(std::vector<TColumn>& to, std::vector<TColumn>& from) {
+  const auto append = [](auto& to_values, auto& from_values) {
+    to_values.insert(to_values.end(),
+                     std::make_move_iterator(from_values.begin()),
+                     std::make_move_iterator(from_values.end()));
+  };
+  for (size_t i = 0; i < to.size(); ++i) {
+    append(to[i].nulls, from[i].nulls);
+    append(to[i].data.int_col, from[i].data.int_col);
+    append(to[i].data.real_col, from[i].data.real_col);
+    append(to[i].data.str_col, from[i].data.str_col);
+    append(to[i].data.arr_col, from[i].data.arr_col);
+  }
+}
+
 bool RowToColumnLoader::convert_string_to_column(
     std::vector<TStringValue> row,
     const Importer_NS::CopyParams& copy_params) {
+  return convert_row(row, input_columns_, copy_params);
+}
+
+int RowToColumnLoader::convert_strings_to_columns(
+    const std::vector<std::vector<TStringValue>>& rows,
+    const Importer_NS::CopyParams& copy_params,
+    const size_t threads) {
+  const size_t per_thread = (rows.size() + threads - 1) / std::max<size_t>(threads, 1);
+  int skipped = 0;
+  if (per_thread >= rows.size()) {
+    for (const auto& row : rows) {
+      if (!convert_row(row, input_columns_, copy_params)) {
+        ++skipped;
+      }
+    }
+    return skipped;
+  }
+  using Converted = std::pair<std::vector<TColumn>, int>;
+  std::vector<std::future<Converted>> converters;
+  for (size_t begin = 0; begin < rows.size(); begin += per_thread) {
+    const size_t end = std::min(begin + per_thread, rows.size());
+    converters.emplace_back(
+        std::async(std::launch::async, [this, &rows, &copy_params, begin, end] {
+          Converted converted(std::vector<TColumn>(row_desc_.size()), 0);
+          for (size_t i = begin; i < end; ++i) {
+            if (!convert_row(rows[i], converted.first, copy_params)) {
+              ++converted.second;
+            }
+          }
+          return converted;
+        }));
+  }
+  for (auto& converter : converters) {
+    auto converted = converter.get();
+    append_columns(input_columns_, converted.first);
+    skipped += converted.second;
+  }
+  return skipped;
+}
+
+bool RowToColumnLoader::convert_row(const std::vector<TStringValue>& row,
+                                    std::vector<TColumn>& columns,
+                                    const Importer_NS::CopyParams& copy_params) const {
   // create datum and push data to column structure from row data
   uint curr_col = 0;
   for (TStringValue ts : row) {
@@ -302,16 +362,16 @@ bool RowToColumnLoader::convert_string_to_column(
             populate_TColumn(
                 tsa, array_column_type_info_[curr_col], array_tcol, copy_params);
           }
-          input_columns_[curr_col].nulls.push_back(false);
-          input_columns_[curr_col].data.arr_col.push_back(array_tcol);
+          columns[curr_col].nulls.push_back(false);
+          columns[curr_col].data.arr_col.push_back(array_tcol);
 
         } break;
         default:
           populate_TColumn(
-              ts, column_type_info_[curr_col], input_columns_[curr_col], copy_params);
+              ts, column_type_info_[curr_col], columns[curr_col], copy_params);
       }
     } catch (const std::exception& e) {
-      remove_partial_row(curr_col, column_type_info_, input_columns_);
+      remove_partial_row(curr_col, column_type_info_, columns);
       // import_status.rows_rejected++;
       LOG(ERROR) << "Input exception thrown: " << e.what()
                  << ". Row discarded, issue at column : " << (curr_col + 1)
@@ -327,16 +387,22 @@ RowToColumnLoader::RowToColumnLoader(const ThriftClientConnection& conn_details,
                                      const std::string& user_name,
                                      const std::string& passwd,
                                      const std::string& db_name,
-                                     const std::string& table_name)
+                                     const std::string& table_name,
+                                     const size_t loads_in_flight)
     : user_name_(user_name)
     , passwd_(passwd)
     , db_name_(db_name)
     , table_name_(table_name)
-    , conn_details_(conn_details) {
-  createConnection(conn_details_);
+    , conn_details_(conn_details)
+    , connections_(std::max<size_t>(loads_in_flight, 1))
+    , loads_in_flight_(connections_.size()) {
+  for (auto& connection : connections_) {
+    createConnection(connection);
+  }
 
   TTableDetails table_details;
-  client_->get_table_details(table_details, session_, table_name_);
+  connections_[0].client->get_table_details(
+      table_details, connections_[0].session, table_name_);
 
   row_desc_ = table_details.row_desc;
 
@@ -351,37 +417,47 @@ RowToColumnLoader::RowToColumnLoader(const ThriftClientConnection& conn_details,
     array_column_type_info_.push_back(create_array_sql_type_info_from_col_type(ct));
   }
 
+  reset_input_columns();
+}
+RowToColumnLoader::~RowToColumnLoader() {
+  wait_load();
+  for (auto& connection : connections_) {
+    closeConnection(connection);
+  }
+}
+
+void RowToColumnLoader::reset_input_columns() {
+  input_columns_.clear();
   // create vector for storage of the actual column data
   for (TColumnType column : row_desc_) {
     TColumn t;
     input_columns_.push_back(t);
   }
 }
-RowToColumnLoader::~RowToColumnLoader() {
-  closeConnection();
-}
 
-void RowToColumnLoader::createConnection(const ThriftClientConnection& con) {
+void RowToColumnLoader::createConnection(Connection& connection) {
+  const auto& con = conn_details_;
   mapd::shared_ptr<TProtocol> protocol;
   mapd::shared_ptr<TTransport> socket;
   if (con.conn_type_ == ThriftConnectionType::HTTP ||
       con.conn_type_ == ThriftConnectionType::HTTPS) {
-    mytransport_ = openHttpClientTransport(con.server_host_,
-                                           con.port_,
-                                           con.ca_cert_name_,
-                                           con.conn_type_ == ThriftConnectionType::HTTPS,
-                                           con.skip_host_verify_);
-    protocol = mapd::shared_ptr<TProtocol>(new TJSONProtocol(mytransport_));
+    connection.transport =
+        openHttpClientTransport(con.server_host_,
+                                con.port_,
+                                con.ca_cert_name_,
+                                con.conn_type_ == ThriftConnectionType::HTTPS,
+                                con.skip_host_verify_);
+    protocol = mapd::shared_ptr<TProtocol>(new TJSONProtocol(connection.transport));
   } else {
-    mytransport_ =
-        openBufferedClientTransport(con.server_host_, con.port_, con.ca_cert_name_);
-    protocol = mapd::shared_ptr<TProtocol>(new TBinaryProtocol(mytransport_));
+    connection.transport = openBufferedClientTransport(
+        con.server_host_, con.port_, con.ca_cert_name_, con.compress_);
+    protocol = mapd::shared_ptr<TProtocol>(new TBinaryProtocol(connection.transport));
   }
-  client_.reset(new MapDClient(protocol));
+  connection.client.reset(new MapDClient(protocol));
 
   try {
-    mytransport_->open();
-    client_->connect(session_, user_name_, passwd_, db_name_);
+    connection.transport->open();
+    connection.client->connect(connection.session, user_name_, passwd_, db_name_);
   } catch (TMapDException& e) {
     std::cerr << e.error_msg << std::endl;
   } catch (TException& te) {
@@ -389,10 +465,10 @@ void RowToColumnLoader::createConnection(const ThriftClientConnection& con) {
   }
 }
 
-void RowToColumnLoader::closeConnection() {
+void RowToColumnLoader::closeConnection(Connection& connection) {
   try {
-    client_->disconnect(session_);  // disconnect from mapd_server
-    mytransport_->close();          // close transport
+    connection.client->disconnect(connection.session);  // disconnect from mapd_server
+    connection.transport->close();                      // close transport
   } catch (TMapDException& e) {
     std::cerr << e.error_msg << std::endl;
   } catch (TException& te) {
@@ -402,41 +478,102 @@ void RowToColumnLoader::closeConnection() {
 
 void RowToColumnLoader::wait_disconnet_reconnnect_retry(
     size_t tries,
-    Importer_NS::CopyParams copy_params) {
+    Importer_NS::CopyParams copy_params,
+    Connection& connection) {
   std::cout << "  Waiting  " << copy_params.retry_wait
             << " secs to retry Inserts , will try " << (copy_params.retry_count - tries)
             << " times more " << std::endl;
   sleep(copy_params.retry_wait);
 
-  closeConnection();
-  createConnection(conn_details_);
+  closeConnection(connection);
+  createConnection(connection);
+}
+
+size_t RowToColumnLoader::get_pending_row_count() const {
+  return input_columns_.empty() ? 0 : input_columns_[0].nulls.size();
 }
 
 void RowToColumnLoader::do_load(int& nrows,
                                 int& nskipped,
-                                Importer_NS::CopyParams copy_params) {
+                                Importer_NS::CopyParams copy_params,
+                                const bool checkpoint) {
+  wait_load();
+  load_columns(input_columns_, connections_[0], nrows, nskipped, copy_params, checkpoint);
+  // we successfully loaded the data, lets move on
+  reset_input_columns();
+}
+
+void RowToColumnLoader::do_load_async(int& nrows,
+                                      const int nskipped,
+                                      Importer_NS::CopyParams copy_params,
+                                      const bool checkpoint) {
+  auto& load = loads_in_flight_[next_load_];
+  auto& connection = connections_[next_load_];
+  next_load_ = (next_load_ + 1) % loads_in_flight_.size();
+  if (load.done.valid()) {
+    load.done.get();
+  }
+  load.columns.swap(input_columns_);
+  reset_input_columns();
+  load.done = std::async(std::launch::async, [&, nskipped, copy_params, checkpoint] {
+    load_columns(load.columns, connection, nrows, nskipped, copy_params, checkpoint);
+  });
+}
+
+void RowToColumnLoader::wait_load() {
+  for (auto& load : loads_in_flight_) {
+    if (load.done.valid()) {
+      load.done.get();
+    }
+  }
+}
+
+void RowToColumnLoader::load_columns(const std::vector<TColumn>& columns,
+                                     Connection& connection,
+                                     int& nrows,
+                                     const int nskipped,
+                                     Importer_NS::CopyParams copy_params,
+                                     const bool checkpoint) {
   for (size_t tries = 0; tries < copy_params.retry_count;
        tries++) {  // allow for retries in case of insert failure
     try {
-      client_->load_table_binary_columnar(session_, table_name_, input_columns_);
+      if (checkpoint) {
+        connection.client->load_table_binary_columnar(
+            connection.session, table_name_, columns);
+      } else {
+        connection.client->load_table_binary_columnar_no_checkpoint(
+            connection.session, table_name_, columns);
+      }
       //      client->load_table(session, table_name, input_rows);
-      nrows += input_columns_[0].nulls.size();
+      std::lock_guard<std::mutex> lock(nrows_mutex_);
+      nrows += columns[0].nulls.size();
       std::cout << nrows << " Rows Inserted, " << nskipped << " rows skipped."
                 << std::endl;
-      // we successfully loaded the data, lets move on
-      input_columns_.clear();
-      // create vector for storage of the actual column data
-      for (TColumnType column : row_desc_) {
-        TColumn t;
-        input_columns_.push_back(t);
-      }
       return;
     } catch (TMapDException& e) {
       std::cerr << "Exception trying to insert data " << e.error_msg << std::endl;
-      wait_disconnet_reconnnect_retry(tries, copy_params);
+      wait_disconnet_reconnnect_retry(tries, copy_params, connection);
     } catch (TException& te) {
       std::cerr << "Exception trying to insert data " << te.what() << std::endl;
-      wait_disconnet_reconnnect_retry(tries, copy_params);
+      wait_disconnet_reconnnect_retry(tries, copy_params, connection);
+    }
+  }
+  std::cerr << "Retries exhausted program terminated" << std::endl;
+  exit(1);
+}
+
+int32_t RowToColumnLoader::checkpoint_table(Importer_NS::CopyParams copy_params) {
+  wait_load();
+  for (size_t tries = 0; tries < copy_params.retry_count; tries++) {
+    try {
+      return connections_[0].client->checkpoint_table(connections_[0].session,
+                                                      table_name_);
+    } catch (TMapDException& e) {
+      std::cerr << "Exception trying to checkpoint " << e.error_msg << std::endl;
+      wait_disconnet_reconnnect_retry(tries, copy_params, connections_[0]);
+    } catch (TException& te) {
+      std::cerr << "Exception trying to checkpoint " << te.what() << std::endl;
+      wait_disconnet_reconnnect_retry(tries, copy_params, connections_[0]);
     }
   }
   std::cerr << "Retries exhausted program terminated" << std::endl;
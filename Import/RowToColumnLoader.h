@@ -40,6 +40,8 @@
 #include "Shared/sqltypes.h"
 
 #include <chrono>
+#include <future>
+#include <mutex>
 #include <thread>
 
 #include <boost/program_options.hpp>
@@ -64,14 +66,35 @@ class RowToColumnLoader {
                     const std::string& user_name,
                     const std::string& passwd,
                     const std::string& db_name,
-                    const std::string& table_name);
+                    const std::string& table_name,
+                    const size_t loads_in_flight = 1);
   ~RowToColumnLoader();
-  void do_load(int& nrows, int& nskipped, Importer_NS::CopyParams copy_params);
+  // Without checkpoint the rows only become durable at the next checkpoint_table.
+  void do_load(int& nrows,
+               int& nskipped,
+               Importer_NS::CopyParams copy_params,
+               const bool checkpoint = true);
+  // Sends the rows added so far in the background on the next of the connections while
+  // the next batches get built, after waiting for the server to acknowledge the batch
+  // previously sent on it. The batches of different connections may load in any order.
+  void do_load_async(int& nrows,
+                     const int nskipped,
+                     Importer_NS::CopyParams copy_params,
+                     const bool checkpoint = true);
+  // Waits for the batches sent by do_load_async, if any.
+  void wait_load();
+  int32_t checkpoint_table(Importer_NS::CopyParams copy_params);
+  size_t get_pending_row_count() const;
   bool convert_string_to_column(std::vector<TStringValue> row,
                                 const Importer_NS::CopyParams& copy_params);
+  // Converts the rows on up to threads threads, the columns converted by each are then
+  // added in the order of the rows. Returns the number of rows which couldn't be.
+  int convert_strings_to_columns(const std::vector<std::vector<TStringValue>>& rows,
+                                 const Importer_NS::CopyParams& copy_params,
+                                 const size_t threads);
   TRowDescriptor get_row_descriptor();
   std::string print_row_with_delim(std::vector<TStringValue> row,
-                                   const Importer_NS::CopyParams& copy_params);
+                                   const Importer_NS::CopyParams& copy_params) const;
 
  private:
   std::string user_name_;
@@ -80,19 +103,45 @@ class RowToColumnLoader {
   std::string table_name_;
   ThriftClientConnection conn_details_;
 
+  struct Connection {
+    mapd::shared_ptr<MapDClient> client;
+    TSessionId session;
+    mapd::shared_ptr<apache::thrift::transport::TTransport> transport;
+  };
+
+  // A batch sent by do_load_async, owned by the sender until done is.
+  struct LoadInFlight {
+    std::vector<TColumn> columns;
+    std::future<void> done;
+  };
+
   std::vector<TColumn> input_columns_;
+  // One load in flight per connection, the first one also gets the table details and
+  // the checkpoints.
+  std::vector<Connection> connections_;
+  std::vector<LoadInFlight> loads_in_flight_;
+  size_t next_load_{0};
+  std::mutex nrows_mutex_;
   std::vector<SQLTypeInfo> column_type_info_;
   std::vector<SQLTypeInfo> array_column_type_info_;
 
   TRowDescriptor row_desc_;
 
-  mapd::shared_ptr<MapDClient> client_;
-  TSessionId session_;
-  mapd::shared_ptr<apache::thrift::transport::TTransport> mytransport_;
-
-  void createConnection(const ThriftClientConnection& con);
-  void closeConnection();
-  void wait_disconnet_reconnnect_retry(size_t tries, Importer_NS::CopyParams copy_params);
+  bool convert_row(const std::vector<TStringValue>& row,
+                   std::vector<TColumn>& columns,
+                   const Importer_NS::CopyParams& copy_params) const;
+  void load_columns(const std::vector<TColumn>& columns,
+                    Connection& connection,
+                    int& nrows,
+                    const int nskipped,
+                    Importer_NS::CopyParams copy_params,
+                    const bool checkpoint);
+  void reset_input_columns();
+  void createConnection(Connection& connection);
+  void closeConnection(Connection& connection);
+  void wait_disconnet_reconnnect_retry(size_t tries,
+                                       Importer_NS::CopyParams copy_params,
+                                       Connection& connection);
 };
 
 #endif  // _ROWTOCOLUMNLOADER_H_
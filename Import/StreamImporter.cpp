@@ -27,6 +27,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/regex.hpp>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <iterator>
@@ -48,13 +49,20 @@ bool print_transformation = false;
 
 // reads copy_params.delimiter delimited rows from std::cin and load them to
 // table_name in batches of size copy_params.batch_size until EOF
+//
+// The rows of a batch are converted to columns on convert_threads threads, and the
+// batches are sent while the next ones get read, as many at a time as the loader has
+// connections. The loads don't checkpoint, the table gets checkpointed every
+// checkpoint_batches batches and at EOF instead.
 void stream_insert(
     RowToColumnLoader& row_loader,
     const std::map<std::string,
                    std::pair<std::unique_ptr<boost::regex>,
                              std::unique_ptr<std::string>>>& transformations,
     const Importer_NS::CopyParams& copy_params,
-    const bool remove_quotes) {
+    const bool remove_quotes,
+    const size_t checkpoint_batches,
+    const size_t convert_threads) {
   std::ios_base::sync_with_stdio(false);
   std::istream_iterator<char> eos;
   std::cin >> std::noskipws;
@@ -81,8 +89,10 @@ void stream_insert(
   }
 
   std::vector<TStringValue> row;  // used to store each row as we move through the stream
+  std::vector<std::vector<TStringValue>> rows;  // the rows of the batch being read
 
   int read_rows = 0;
+  size_t batches_since_checkpoint = 0;
   while (iit != eos) {
     // construct a row
     while (iit != eos) {
@@ -153,16 +163,20 @@ void stream_insert(
       ++iit;
     }
     if (row.size() == row_desc.size()) {
-      // add the new data in the column format
-      bool record_loaded = row_loader.convert_string_to_column(row, copy_params);
+      rows.push_back(std::move(row));
       read_rows++;
-      if (!record_loaded) {
-        // record could not be parsed correctly conside rit skipped
-        ++nskipped;
-      }
       row.clear();
       if (read_rows % copy_params.batch_size == 0) {
-        row_loader.do_load(nrows, nskipped, copy_params);
+        // add the new data in the column format, records which could not be parsed
+        // correctly are considered skipped
+        nskipped +=
+            row_loader.convert_strings_to_columns(rows, copy_params, convert_threads);
+        rows.clear();
+        row_loader.do_load_async(nrows, nskipped, copy_params, false);
+        if (++batches_since_checkpoint == checkpoint_batches) {
+          row_loader.checkpoint_table(copy_params);
+          batches_since_checkpoint = 0;
+        }
       }
     } else {
       ++nskipped;
@@ -183,7 +197,12 @@ void stream_insert(
   // load remaining rows if any
   if (read_rows % copy_params.batch_size != 0) {
     LOG(INFO) << " read_rows " << read_rows;
-    row_loader.do_load(nrows, nskipped, copy_params);
+    nskipped += row_loader.convert_strings_to_columns(rows, copy_params, convert_threads);
+    row_loader.do_load(nrows, nskipped, copy_params, false);
+    ++batches_since_checkpoint;
+  }
+  if (batches_since_checkpoint > 0) {
+    row_loader.checkpoint_table(copy_params);
   }
 }
 
@@ -193,6 +212,7 @@ int main(int argc, char** argv) {
   bool http = false;
   bool https = false;
   bool skip_host_verify = false;
+  bool compress = false;
   std::string ca_cert_name{""};
   std::string table_name;
   std::string db_name;
@@ -200,8 +220,11 @@ int main(int argc, char** argv) {
   std::string passwd;
   std::string delim_str(","), nulls("\\N"), line_delim_str("\n"), quoted("false");
   size_t batch_size = 10000;
+  size_t checkpoint_batches = 10;
   size_t retry_count = 10;
   size_t retry_wait = 5;
+  size_t convert_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  size_t connections = 2;
   bool remove_quotes = false;
   std::vector<std::string> xforms;
   std::map<std::string,
@@ -234,6 +257,9 @@ int main(int argc, char** argv) {
   desc.add_options()("https",
                      po::bool_switch(&https)->default_value(https)->implicit_value(true),
                      "Use HTTPS transport");
+  desc.add_options()("compress",
+                     po::bool_switch(&compress)->default_value(compress)->implicit_value(true),
+                     "Compress the binary transport, for the compressed port of the server");
   desc.add_options()("skip-verify",
                      po::bool_switch(&skip_host_verify)
                          ->default_value(skip_host_verify)
@@ -255,6 +281,18 @@ int main(int argc, char** argv) {
   desc.add_options()("batch",
                      po::value<size_t>(&batch_size)->default_value(batch_size),
                      "Insert batch size");
+  desc.add_options()(
+      "checkpoint_batches",
+      po::value<size_t>(&checkpoint_batches)->default_value(checkpoint_batches),
+      "Number of batches loaded between checkpoints");
+  desc.add_options()(
+      "threads",
+      po::value<size_t>(&convert_threads)->default_value(convert_threads),
+      "Number of threads converting the rows of a batch to columns");
+  desc.add_options()(
+      "connections",
+      po::value<size_t>(&connections)->default_value(connections),
+      "Number of connections, each with a batch being loaded at a time");
   desc.add_options()("retry_count",
                      po::value<size_t>(&retry_count)->default_value(retry_count),
                      "Number of time to retry an insert");
@@ -421,12 +459,24 @@ int main(int argc, char** argv) {
       delim, nulls, line_delim, batch_size, retry_count, retry_wait);
   RowToColumnLoader row_loader(
       ThriftClientConnection(
-          server_host, port, conn_type, skip_host_verify, ca_cert_name, ca_cert_name),
+          server_host,
+          port,
+          conn_type,
+          skip_host_verify,
+          ca_cert_name,
+          ca_cert_name,
+          compress),
       user_name,
       passwd,
       db_name,
-      table_name);
+      table_name,
+      connections);
 
-  stream_insert(row_loader, transformations, copy_params, remove_quotes);
+  stream_insert(row_loader,
+                transformations,
+                copy_params,
+                remove_quotes,
+                std::max<size_t>(checkpoint_batches, 1),
+                convert_threads);
   return 0;
 }
@@ -21,12 +21,18 @@
 #include <thrift/concurrency/ThreadManager.h>
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/protocol/TJSONProtocol.h>
+#include <thrift/server/TNonblockingServer.h>
 #include <thrift/server/TThreadedServer.h>
 #include <thrift/transport/TBufferTransports.h>
 #include <thrift/transport/THttpServer.h>
+#ifdef HAVE_THRIFT_STD_SHAREDPTR
+#include <thrift/transport/TNonblockingSSLServerSocket.h>
+#include <thrift/transport/TNonblockingServerSocket.h>
+#endif  // HAVE_THRIFT_STD_SHAREDPTR
 #include <thrift/transport/TSSLServerSocket.h>
 #include <thrift/transport/TSSLSocket.h>
 #include <thrift/transport/TServerSocket.h>
+#include <thrift/transport/TZlibTransport.h>
 
 #include "MapDRelease.h"
 
@@ -51,8 +57,38 @@ using namespace ::apache::thrift::server;
 using namespace ::apache::thrift::transport;
 
 extern bool g_aggregator;
+extern bool g_enable_catalog_snapshot;
+extern size_t g_credential_cache_seconds;
+extern size_t g_load_commit_interval_ms;
+extern size_t g_load_commit_max_rows;
 extern bool g_multi_subquery_exc;
 extern size_t g_leaf_count;
+extern size_t g_query_worker_threads;
+extern std::string g_persistent_code_cache_dir;
+extern bool g_enable_gpu_launch_tuning;
+extern std::string g_buffer_eviction_policy;
+extern bool g_enable_peer_chunk_copies;
+extern bool g_enable_buffer_pool_compaction;
+extern size_t g_compressed_chunk_cache_bytes;
+extern bool g_enable_coalesced_file_reads;
+extern bool g_enable_mapped_chunks;
+extern int g_file_page_compression_level;
+extern bool g_enable_header_index;
+extern std::string g_cold_storage_url;
+extern std::string g_cold_storage_endpoint;
+extern std::string g_cold_storage_cache_path;
+extern size_t g_cold_storage_cache_bytes;
+extern size_t g_cold_file_age_seconds;
+extern bool g_enable_chunk_bloom_filters;
+extern size_t g_vacuum_interval_secs;
+extern double g_vacuum_min_deleted_fraction;
+extern size_t g_hot_chunks_save_interval_secs;
+extern size_t g_hot_chunks_prefetch_mb_per_sec;
+extern size_t g_async_query_threads;
+extern int64_t g_slow_query_threshold_ms;
+extern double g_trace_sample_rate;
+extern bool g_enable_string_dict_trigram_index;
+extern size_t g_string_dict_index_memory_budget;
 
 TableGenerations table_generations_from_thrift(
     const std::vector<TTableGeneration>& thrift_table_generations) {
@@ -123,7 +159,7 @@ void register_signal_handler() {
   std::signal(SIGPIPE, SIG_IGN);
 }
 
-void start_server(TThreadedServer& server) {
+void start_server(TServer& server) {
   try {
     server.serve();
   } catch (std::exception& e) {
@@ -131,6 +167,39 @@ void start_server(TThreadedServer& server) {
   }
 }
 
+std::unique_ptr<TNonblockingServer> make_nonblocking_server(
+    mapd::shared_ptr<TProcessor> processor,
+    mapd::shared_ptr<TProtocolFactory> protocol_factory,
+    const int port,
+    mapd::shared_ptr<TSSLSocketFactory> ssl_socket_factory,
+    const size_t io_thread_count,
+    const size_t worker_thread_count) {
+  auto thread_manager =
+      ThreadManager::newSimpleThreadManager(std::max(worker_thread_count, size_t(1)));
+  thread_manager->threadFactory(mapd::make_shared<PlatformThreadFactory>());
+  thread_manager->start();
+  std::unique_ptr<TNonblockingServer> server;
+#ifdef HAVE_THRIFT_STD_SHAREDPTR
+  mapd::shared_ptr<TNonblockingServerSocket> server_socket(
+      ssl_socket_factory ? new TNonblockingSSLServerSocket(port, ssl_socket_factory)
+                         : new TNonblockingServerSocket(port));
+  server.reset(
+      new TNonblockingServer(processor, protocol_factory, server_socket, thread_manager));
+#else
+  if (ssl_socket_factory) {
+    LOG(ERROR) << "The nonblocking port requires Thrift 0.11 or later to use SSL, "
+                  "it won't be started";
+    thread_manager->stop();
+    return nullptr;
+  }
+  server.reset(new TNonblockingServer(processor, protocol_factory, port, thread_manager));
+#endif  // HAVE_THRIFT_STD_SHAREDPTR
+  server->setNumIOThreads(std::max(io_thread_count, size_t(1)));
+  LOG(INFO) << " MapD server nonblocking port " << port << ", " << io_thread_count
+            << " io threads, " << worker_thread_count << " worker threads";
+  return server;
+}
+
 void releaseWarmupSession(TSessionId& sessionId, std::ifstream& query_file) {
   query_file.close();
   if (sessionId != g_warmup_handler->getInvalidSessionId()) {
@@ -204,6 +273,10 @@ void run_warmup_queries(mapd::shared_ptr<MapDHandler> handler,
 
 int main(int argc, char** argv) {
   int http_port = 9090;
+  int compressed_port = -1;  // zlib-compressed binary port, disabled when negative
+  int nonblocking_port = -1;  // event loop framed binary port, disabled when negative
+  size_t nonblocking_io_threads = 1;
+  size_t nonblocking_worker_threads = std::thread::hardware_concurrency();
   size_t reserved_gpu_mem = 1 << 27;
   std::string base_path;
   std::string device("gpu");
@@ -258,10 +331,27 @@ int main(int argc, char** argv) {
   desc.add_options()("http-port",
                      po::value<int>(&http_port)->default_value(http_port),
                      "HTTP port number");
+  desc.add_options()("compressed-port",
+                     po::value<int>(&compressed_port)->default_value(compressed_port),
+                     "Port number for the zlib-compressed binary protocol, for clients "
+                     "on slow networks (disabled if negative)");
+  desc.add_options()("nonblocking-port",
+                     po::value<int>(&nonblocking_port)->default_value(nonblocking_port),
+                     "Port number for the binary protocol over a framed transport, "
+                     "served by event loop threads and a bounded pool of workers instead "
+                     "of a thread per connection (disabled if negative)");
+  desc.add_options()("nonblocking-io-threads",
+                     po::value<size_t>(&nonblocking_io_threads)
+                         ->default_value(nonblocking_io_threads),
+                     "Number of event loop threads of the nonblocking port");
+  desc.add_options()("nonblocking-worker-threads",
+                     po::value<size_t>(&nonblocking_worker_threads)
+                         ->default_value(nonblocking_worker_threads),
+                     "Number of threads running the requests of the nonblocking port");
   desc.add_options()("calcite-port",
                      po::value<int>(&mapd_parameters.calcite_port)
                          ->default_value(mapd_parameters.calcite_port),
-                     "Calcite port number");
+                     "Calcite port number, negative to run Calcite in process");
   desc.add_options()(
       "flush-log",
       po::value<bool>(&flush_log)->default_value(flush_log)->implicit_value(true),
@@ -275,6 +365,37 @@ int main(int argc, char** argv) {
                      po::value<size_t>(&mapd_parameters.gpu_buffer_mem_bytes)
                          ->default_value(mapd_parameters.gpu_buffer_mem_bytes),
                      "Size of memory reserved for GPU buffers [bytes] (per GPU)");
+  desc.add_options()(
+      "pinned-cpu-buffer-mem-bytes",
+      po::value<size_t>(&mapd_parameters.pinned_cpu_buffer_mem_bytes)
+          ->default_value(mapd_parameters.pinned_cpu_buffer_mem_bytes),
+      "Size of the CPU buffers allocated as page-locked memory, for faster transfers "
+      "to the GPUs [bytes]");
+  desc.add_options()(
+      "cpu-buffer-huge-pages",
+      po::value<bool>(&mapd_parameters.cpu_buffer_huge_pages)
+          ->default_value(mapd_parameters.cpu_buffer_huge_pages)
+          ->implicit_value(true),
+      "Back the CPU buffers with huge pages, the reserved ones if any, to reduce the "
+      "TLB misses of the scans");
+  desc.add_options()(
+      "cpu-buffer-numa-interleave",
+      po::value<bool>(&mapd_parameters.cpu_buffer_numa_interleave)
+          ->default_value(mapd_parameters.cpu_buffer_numa_interleave)
+          ->implicit_value(true),
+      "Interleave the pages of the CPU buffers over the NUMA nodes");
+  desc.add_options()(
+      "reusable-gpu-buffer-mem-bytes",
+      po::value<size_t>(&mapd_parameters.reusable_gpu_buffer_mem_bytes)
+          ->default_value(mapd_parameters.reusable_gpu_buffer_mem_bytes),
+      "Size of the query output buffers kept on each GPU for the next queries with the "
+      "same layout [bytes]");
+  desc.add_options()(
+      "gpu-scratch-mem-bytes",
+      po::value<size_t>(&mapd_parameters.gpu_scratch_mem_bytes)
+          ->default_value(mapd_parameters.gpu_scratch_mem_bytes),
+      "Size of the memory pooled on each GPU for the sort, hash table build and count "
+      "distinct scratch buffers of the queries, out of the buffer pool [bytes]");
 
   desc.add_options()("num-gpus",
                      po::value<int>(&num_gpus)->default_value(num_gpus),
@@ -360,6 +481,10 @@ int main(int argc, char** argv) {
       "num-reader-threads",
       po::value<size_t>(&num_reader_threads)->default_value(num_reader_threads),
       "Number of reader threads to use");
+  desc_adv.add_options()(
+      "query-worker-threads",
+      po::value<size_t>(&g_query_worker_threads)->default_value(g_query_worker_threads),
+      "Number of threads in the shared query worker pool (0 = number of cores).");
   desc_adv.add_options()("enable-dynamic-watchdog",
                          po::value<bool>(&enable_dynamic_watchdog)
                              ->default_value(enable_dynamic_watchdog)
@@ -393,6 +518,12 @@ int main(int argc, char** argv) {
                          po::value<size_t>(&mapd_parameters.calcite_max_mem)
                              ->default_value(mapd_parameters.calcite_max_mem),
                          "Max memory available to calcite JVM");
+  desc_adv.add_options()(
+      "calcite-plan-cache-size",
+      po::value<size_t>(&mapd_parameters.calcite_plan_cache_size)
+          ->default_value(mapd_parameters.calcite_plan_cache_size),
+      "Number of query plans kept to skip Calcite for the repeated queries, 0 disables "
+      "the cache.");
   desc_adv.add_options()("db-convert",
                          po::value<std::string>(&db_convert_dir),
                          "Directory path to mapd DB to convert from");
@@ -401,6 +532,196 @@ int main(int argc, char** argv) {
                          po::value<bool>(&g_enable_columnar_output)
                              ->default_value(g_enable_columnar_output)
                              ->implicit_value(true));
+  desc_adv.add_options()("enable-cpu-morsels",
+                         po::value<bool>(&g_enable_cpu_morsels)
+                             ->default_value(g_enable_cpu_morsels)
+                             ->implicit_value(true),
+                         "Split CPU scans of single table aggregates in row ranges");
+  desc_adv.add_options()("cpu-morsel-size",
+                         po::value<size_t>(&g_cpu_morsel_size)
+                             ->default_value(g_cpu_morsel_size)
+                             ->implicit_value(g_cpu_morsel_size),
+                         "Number of rows in a morsel of a CPU scan");
+  desc_adv.add_options()("enable-tiered-cpu-codegen",
+                         po::value<bool>(&g_enable_tiered_cpu_codegen)
+                             ->default_value(g_enable_tiered_cpu_codegen)
+                             ->implicit_value(true),
+                         "Skip most of the optimizations for queries on small inputs");
+  desc_adv.add_options()("tiered-codegen-row-threshold",
+                         po::value<size_t>(&g_tiered_codegen_row_threshold)
+                             ->default_value(g_tiered_codegen_row_threshold),
+                         "Max number of input rows for quickly compiled CPU code");
+  desc_adv.add_options()("tiered-codegen-promotion-count",
+                         po::value<size_t>(&g_tiered_codegen_promotion_count)
+                             ->default_value(g_tiered_codegen_promotion_count),
+                         "Runs of a quickly compiled query before it gets optimized");
+  desc_adv.add_options()("enable-batched-cpu-codegen",
+                         po::value<bool>(&g_enable_batched_cpu_codegen)
+                             ->default_value(g_enable_batched_cpu_codegen)
+                             ->implicit_value(true),
+                         "Filter rows in batches ahead of the aggregates on CPU");
+  desc_adv.add_options()("enable-expression-cse",
+                         po::value<bool>(&g_enable_expression_cse)
+                             ->default_value(g_enable_expression_cse)
+                             ->implicit_value(true),
+                         "Compute repeated expressions once per row");
+  desc_adv.add_options()("enable-chunk-prefetch",
+                         po::value<bool>(&g_enable_chunk_prefetch)
+                             ->default_value(g_enable_chunk_prefetch)
+                             ->implicit_value(true),
+                         "Load the chunks of GPU queries from disk ahead of the kernels");
+  desc_adv.add_options()(
+      "enable-gpu-string-dictionaries",
+      po::value<bool>(&g_enable_gpu_string_dictionaries)
+          ->default_value(g_enable_gpu_string_dictionaries)
+          ->implicit_value(true),
+      "Copy dictionaries to the GPUs to compare and match their strings there");
+  desc_adv.add_options()("enable-query-profile",
+                         po::value<bool>(&g_enable_query_profile)
+                             ->default_value(g_enable_query_profile)
+                             ->implicit_value(true),
+                         "Return the time spent in each query phase with the results");
+  desc_adv.add_options()(
+      "enable-kernel-instrumentation",
+      po::value<bool>(&g_enable_kernel_instrumentation)
+          ->default_value(g_enable_kernel_instrumentation)
+          ->implicit_value(true),
+      "Time the GPU kernels with CUDA events and read the hardware counters around "
+      "the CPU kernels, reported with the query profile");
+  desc_adv.add_options()(
+      "enable-roaring-count-distinct",
+      po::value<bool>(&g_enable_roaring_count_distinct)
+          ->default_value(g_enable_roaring_count_distinct)
+          ->implicit_value(true),
+      "Use compressed bitmaps rather than ordered sets for exact COUNT(DISTINCT) when "
+      "the range of the argument is unknown or too wide for a dense bitmap");
+  desc_adv.add_options()(
+      "enable-top-count-pruning",
+      po::value<bool>(&g_enable_top_count_pruning)
+          ->default_value(g_enable_top_count_pruning)
+          ->implicit_value(true),
+      "Sum across the devices only the groups which may have one of the highest counts "
+      "of a GROUP BY ordered by COUNT(*) DESC with a LIMIT");
+  desc_adv.add_options()(
+      "persistent-code-cache-dir",
+      po::value<std::string>(&g_persistent_code_cache_dir),
+      "Directory to keep compiled query kernels in across restarts, disabled if empty");
+  desc_adv.add_options()(
+      "enable-gpu-launch-tuning",
+      po::value<bool>(&g_enable_gpu_launch_tuning)
+          ->default_value(g_enable_gpu_launch_tuning)
+          ->implicit_value(true),
+      "Time the GPU kernels with each candidate grid size and keep the fastest, per "
+      "kind of kernel and GPU architecture, unless a grid size is configured");
+  desc_adv.add_options()("buffer-eviction-policy",
+                         po::value<std::string>(&g_buffer_eviction_policy)
+                             ->default_value(g_buffer_eviction_policy),
+                         "Eviction policy of the CPU and GPU buffer pools: lru or 2q");
+  desc_adv.add_options()("enable-peer-chunk-copies",
+                         po::value<bool>(&g_enable_peer_chunk_copies)
+                             ->default_value(g_enable_peer_chunk_copies)
+                             ->implicit_value(true),
+                         "Copy the chunks missing on a GPU from the peer GPUs holding "
+                         "them");
+  desc_adv.add_options()("enable-buffer-pool-compaction",
+                         po::value<bool>(&g_enable_buffer_pool_compaction)
+                             ->default_value(g_enable_buffer_pool_compaction)
+                             ->implicit_value(true),
+                         "Move the unpinned chunks of a slab together rather than evict "
+                         "chunks when its free pages add up to an allocation");
+  desc_adv.add_options()("compressed-chunk-cache-bytes",
+                         po::value<size_t>(&g_compressed_chunk_cache_bytes)
+                             ->default_value(g_compressed_chunk_cache_bytes),
+                         "Memory for compressed copies of the chunks evicted from the "
+                         "CPU buffer pool, 0 to read them from disk again");
+  desc_adv.add_options()("enable-coalesced-file-reads",
+                         po::value<bool>(&g_enable_coalesced_file_reads)
+                             ->default_value(g_enable_coalesced_file_reads)
+                             ->implicit_value(true),
+                         "Read consecutive pages of a chunk from disk at once");
+  desc_adv.add_options()("enable-mapped-chunks",
+                         po::value<bool>(&g_enable_mapped_chunks)
+                             ->default_value(g_enable_mapped_chunks)
+                             ->implicit_value(true),
+                         "Scan single page chunks on CPU straight from the data files");
+  desc_adv.add_options()(
+      "file-page-compression-level",
+      po::value<int>(&g_file_page_compression_level)
+          ->default_value(g_file_page_compression_level),
+      "zlib level (1-9) to compress the data pages written to disk at, 0 to disable");
+  desc_adv.add_options()("enable-header-index",
+                         po::value<bool>(&g_enable_header_index)
+                             ->default_value(g_enable_header_index)
+                             ->implicit_value(true),
+                         "Load the page headers of tables from an index at startup");
+  desc_adv.add_options()(
+      "cold-storage-url",
+      po::value<std::string>(&g_cold_storage_url)->default_value(g_cold_storage_url),
+      "Move the data files untouched for a while to s3://bucket/prefix or a directory");
+  desc_adv.add_options()("cold-storage-endpoint",
+                         po::value<std::string>(&g_cold_storage_endpoint)
+                             ->default_value(g_cold_storage_endpoint),
+                         "Endpoint of the S3 compatible service of the cold storage");
+  desc_adv.add_options()("cold-storage-cache-path",
+                         po::value<std::string>(&g_cold_storage_cache_path)
+                             ->default_value(g_cold_storage_cache_path),
+                         "Directory of the local read cache of the cold storage");
+  desc_adv.add_options()("cold-storage-cache-bytes",
+                         po::value<size_t>(&g_cold_storage_cache_bytes)
+                             ->default_value(g_cold_storage_cache_bytes),
+                         "Size of the local read cache of the cold storage");
+  desc_adv.add_options()(
+      "cold-file-age-seconds",
+      po::value<size_t>(&g_cold_file_age_seconds)->default_value(g_cold_file_age_seconds),
+      "Seconds a data file is left untouched before it moves to the cold storage");
+  desc_adv.add_options()("enable-chunk-bloom-filters",
+                         po::value<bool>(&g_enable_chunk_bloom_filters)
+                             ->default_value(g_enable_chunk_bloom_filters)
+                             ->implicit_value(true),
+                         "Keep bloom filters of the values of integer chunks");
+  desc_adv.add_options()(
+      "vacuum-interval-secs",
+      po::value<size_t>(&g_vacuum_interval_secs)->default_value(g_vacuum_interval_secs),
+      "Seconds between background rewrites of fragments with deleted rows, 0 to disable");
+  desc_adv.add_options()("vacuum-min-deleted-fraction",
+                         po::value<double>(&g_vacuum_min_deleted_fraction)
+                             ->default_value(g_vacuum_min_deleted_fraction),
+                         "Fraction of deleted rows a fragment is rewritten at");
+  desc_adv.add_options()("hot-chunks-save-interval-secs",
+                         po::value<size_t>(&g_hot_chunks_save_interval_secs)
+                             ->default_value(g_hot_chunks_save_interval_secs),
+                         "Seconds between records of the chunks in the buffer pools, "
+                         "prefetched again at startup, 0 to disable");
+  desc_adv.add_options()("hot-chunks-prefetch-mb-per-sec",
+                         po::value<size_t>(&g_hot_chunks_prefetch_mb_per_sec)
+                             ->default_value(g_hot_chunks_prefetch_mb_per_sec),
+                         "Disk bandwidth budget of the prefetch of the hot chunks");
+  desc_adv.add_options()("async-query-threads",
+                         po::value<size_t>(&g_async_query_threads)
+                             ->default_value(g_async_query_threads),
+                         "Threads running the queries submitted through sql_submit");
+  desc_adv.add_options()("slow-query-threshold-ms",
+                         po::value<int64_t>(&g_slow_query_threshold_ms)
+                             ->default_value(g_slow_query_threshold_ms),
+                         "Log the performance records of the queries which take at least "
+                         "this long to mapd_log/slow_queries.tsv, negative to disable");
+  desc_adv.add_options()(
+      "trace-sample-rate",
+      po::value<double>(&g_trace_sample_rate)->default_value(g_trace_sample_rate),
+      "Fraction of the queries whose phases are traced to mapd_log/traces.jsonl, in the "
+      "OTLP JSON format. A leaf follows the traces of its aggregator regardless.");
+  desc_adv.add_options()("enable-string-dict-trigram-index",
+                         po::value<bool>(&g_enable_string_dict_trigram_index)
+                             ->default_value(g_enable_string_dict_trigram_index)
+                             ->implicit_value(true),
+                         "Index the trigrams of the strings in dictionaries for LIKE and "
+                         "REGEXP");
+  desc_adv.add_options()("string-dict-index-memory-budget",
+                         po::value<size_t>(&g_string_dict_index_memory_budget)
+                             ->default_value(g_string_dict_index_memory_budget),
+                         "Memory for the hash tables of the string dictionaries, the "
+                         "least recently used ones are unloaded past it, 0 for no limit "
+                         "[bytes]");
   desc_adv.add_options()("bigint-count",
                          po::value<bool>(&g_bigint_count)
                              ->default_value(g_bigint_count)
@@ -431,11 +752,176 @@ int main(int argc, char** argv) {
                              ->default_value(g_inner_join_fragment_skipping)
                              ->implicit_value(true),
                          "Enable/disable inner join fragment skipping.");
+  desc_adv.add_options()(
+      "enable-partitioned-hash-join-build",
+      po::value<bool>(&g_enable_partitioned_hash_join_build)
+          ->default_value(g_enable_partitioned_hash_join_build)
+          ->implicit_value(true),
+      "Build large one-to-many CPU join hash tables partition by partition.");
+  desc_adv.add_options()(
+      "enable-join-key-fragment-skipping",
+      po::value<bool>(&g_enable_join_key_fragment_skipping)
+          ->default_value(g_enable_join_key_fragment_skipping)
+          ->implicit_value(true),
+      "Skip the outer fragments whose join keys can't be on the build side of a hash "
+      "join.");
+  desc_adv.add_options()(
+      "enable-smem-hash-join-build",
+      po::value<bool>(&g_enable_smem_hash_join_build)
+          ->default_value(g_enable_smem_hash_join_build)
+          ->implicit_value(true),
+      "Build the perfect join hash tables in shared memory on GPU, partition by "
+      "partition.");
+  desc_adv.add_options()(
+      "enable-range-join-hash-table",
+      po::value<bool>(&g_enable_range_join_hash_table)
+          ->default_value(g_enable_range_join_hash_table)
+          ->implicit_value(true),
+      "Index the intervals of the inner table for the joins on a value between two of "
+      "its columns.");
+  desc_adv.add_options()(
+      "enable-spatial-join-hash-table",
+      po::value<bool>(&g_enable_spatial_join_hash_table)
+          ->default_value(g_enable_spatial_join_hash_table)
+          ->implicit_value(true),
+      "Index the geometries of the inner table in a grid for the joins on a point "
+      "contained by a polygon or within a distance of a point.");
+  desc_adv.add_options()(
+      "join-hash-table-cache-size",
+      po::value<size_t>(&g_join_hash_table_cache_max_bytes)
+          ->default_value(g_join_hash_table_cache_max_bytes),
+      "Max number of bytes held by the CPU join hash tables cached across queries, for "
+      "each of the perfect and the baseline layout.");
+  desc_adv.add_options()(
+      "in-values-hash-set-cache-size",
+      po::value<size_t>(&g_in_values_hash_set_cache_max_bytes)
+          ->default_value(g_in_values_hash_set_cache_max_bytes),
+      "Max number of bytes held by the IN list hash sets cached across queries.");
+  desc_adv.add_options()(
+      "enable-query-result-cache",
+      po::value<bool>(&g_enable_query_result_cache)
+          ->default_value(g_enable_query_result_cache)
+          ->implicit_value(true),
+      "Reuse the results of the queries repeated on unchanged tables.");
+  desc_adv.add_options()(
+      "query-result-cache-size",
+      po::value<size_t>(&g_query_result_cache_max_bytes)
+          ->default_value(g_query_result_cache_max_bytes),
+      "Max number of bytes held by the cached query results.");
+  desc_adv.add_options()(
+      "enable-columnar-results-cache",
+      po::value<bool>(&g_enable_columnar_results_cache)
+          ->default_value(g_enable_columnar_results_cache)
+          ->implicit_value(true),
+      "Reuse the columnar form of the intermediate results of the plans repeated on "
+      "unchanged tables, for the scans and the join hash table builds.");
+  desc_adv.add_options()(
+      "columnar-results-cache-size",
+      po::value<size_t>(&g_columnar_results_cache_max_bytes)
+          ->default_value(g_columnar_results_cache_max_bytes),
+      "Max number of bytes held by the cached columnar results.");
+  desc_adv.add_options()(
+      "enable-table-metadata-cache",
+      po::value<bool>(&g_enable_table_metadata_cache)
+          ->default_value(g_enable_table_metadata_cache)
+          ->implicit_value(true),
+      "Reuse the fragments and the column ranges of the tables across queries until "
+      "the tables change.");
+  desc_adv.add_options()(
+      "enable-shared-scans",
+      po::value<bool>(&g_enable_shared_scans)
+          ->default_value(g_enable_shared_scans)
+          ->implicit_value(true),
+      "Compute the queued non-grouped aggregates over the same table and filter in the "
+      "pass of the query running before them.");
+  desc_adv.add_options()(
+      "query-cpu-memory-limit",
+      po::value<size_t>(&g_query_cpu_memory_limit_bytes)
+          ->default_value(g_query_cpu_memory_limit_bytes),
+      "Bytes of output buffers, count distinct bitmaps and join hash tables a query can "
+      "take in host memory, 0 for no limit.");
+  desc_adv.add_options()(
+      "query-gpu-memory-limit",
+      po::value<size_t>(&g_query_gpu_memory_limit_bytes)
+          ->default_value(g_query_gpu_memory_limit_bytes),
+      "Bytes of buffers a step of a query can take on the GPUs before it runs on CPU "
+      "instead, 0 for no limit.");
+  desc_adv.add_options()(
+      "interactive-query-max-input-bytes",
+      po::value<size_t>(&g_interactive_query_max_input_bytes)
+          ->default_value(g_interactive_query_max_input_bytes),
+      "Queries reading at most this many bytes of columns are interactive and get to "
+      "run before the queued batch queries.");
+  desc_adv.add_options()(
+      "batch-query-max-delay",
+      po::value<unsigned>(&g_batch_query_max_delay_ms)
+          ->default_value(g_batch_query_max_delay_ms),
+      "Longest time in milliseconds a queued batch query can be overtaken by the "
+      "interactive ones.");
+  desc_adv.add_options()(
+      "enable-hybrid-execution",
+      po::value<bool>(&g_enable_hybrid_execution)
+          ->default_value(g_enable_hybrid_execution)
+          ->implicit_value(true),
+      "Let the CPU take over part of the fragments of the GPU aggregate queries without "
+      "group by, the ones not resident on the GPUs first.");
+  desc_adv.add_options()(
+      "enable-residency-aware-placement",
+      po::value<bool>(&g_enable_residency_aware_placement)
+          ->default_value(g_enable_residency_aware_placement)
+          ->implicit_value(true),
+      "Send the fragments to the GPUs which already hold their columns, the others to "
+      "the ones with the most free memory.");
+  desc_adv.add_options()(
+      "group-by-buffer-pool-max-bytes",
+      po::value<size_t>(&g_group_by_buffer_pool_max_bytes)
+          ->default_value(g_group_by_buffer_pool_max_bytes),
+      "Bytes of host group by buffers kept for reuse by the next queries, 0 disables "
+      "the reuse.");
+  desc_adv.add_options()(
+      "enable-group-by-partitioning",
+      po::value<bool>(&g_enable_group_by_partitioning)
+          ->default_value(g_enable_group_by_partitioning)
+          ->implicit_value(true),
+      "Compute the groups of a query one partition of its keys at a time when they "
+      "don't all fit in host memory.");
+  desc_adv.add_options()("max-group-by-partitions",
+                         po::value<size_t>(&g_max_group_by_partitions)
+                             ->default_value(g_max_group_by_partitions),
+                         "Max number of partitions of the keys of a group by.");
+  desc_adv.add_options()(
+      "enable-partitioned-reduction",
+      po::value<bool>(&g_enable_partitioned_reduction)
+          ->default_value(g_enable_partitioned_reduction)
+          ->implicit_value(true),
+      "Reduce the baseline hash group by results of the devices one partition of the "
+      "keys per thread.");
+  desc_adv.add_options()(
+      "enable-cpu-radix-sort",
+      po::value<bool>(&g_enable_cpu_radix_sort)
+          ->default_value(g_enable_cpu_radix_sort)
+          ->implicit_value(true),
+      "Sort large results on numeric order entries with a parallel radix sort on the "
+      "CPU.");
+  desc_adv.add_options()(
+      "enable-gpu-sort",
+      po::value<bool>(&g_enable_gpu_sort)
+          ->default_value(g_enable_gpu_sort)
+          ->implicit_value(true),
+      "Sort the keys of the large results of the queries which ran on the GPU on the "
+      "device instead of the radix sort on the CPU.");
   desc_adv.add_options()("disable-shared-mem-group-by",
                          po::value<bool>(&g_enable_smem_group_by)
                              ->default_value(g_enable_smem_group_by)
                              ->implicit_value(false),
                          "Enable/disable using GPU shared memory for GROUP BY.");
+  desc_adv.add_options()(
+      "enable-gpu-group-by-reduction",
+      po::value<bool>(&g_enable_gpu_group_by_reduction)
+          ->default_value(g_enable_gpu_group_by_reduction)
+          ->implicit_value(true),
+      "Add up the group by buffers of the GPU blocks on the device and copy only the "
+      "result to the host, when the aggregates allow it.");
   desc_adv.add_options()(
       "idle-session-duration",
       po::value<int>(&idle_session_duration)->default_value(idle_session_duration),
@@ -468,6 +954,119 @@ int main(int argc, char** argv) {
                          "Upperbound on the number of rows that should pass the filter "
                          "if the selectivity is less than "
                          "the high fraction threshold.");
+  desc_adv.add_options()("enable-adaptive-filter-ordering",
+                         po::value<bool>(&g_enable_adaptive_filter_ordering)
+                             ->default_value(g_enable_adaptive_filter_ordering)
+                             ->implicit_value(true),
+                         "Order filters by their selectivity on the first fragment");
+  desc_adv.add_options()(
+      "enable-cost-based-join-ordering",
+      po::value<bool>(&g_enable_cost_based_join_ordering)
+          ->default_value(g_enable_cost_based_join_ordering)
+          ->implicit_value(true),
+      "Order the inputs of inner joins by their estimated cost instead of their size");
+  desc_adv.add_options()(
+      "enable-fragment-bounded-group-by",
+      po::value<bool>(&g_enable_fragment_bounded_group_by)
+          ->default_value(g_enable_fragment_bounded_group_by)
+          ->implicit_value(true),
+      "Size the CPU baseline group by buffers after the fragment row counts instead of "
+      "running a cardinality estimation query first");
+  desc_adv.add_options()(
+      "enable-subquery-result-cache",
+      po::value<bool>(&g_enable_subquery_result_cache)
+          ->default_value(g_enable_subquery_result_cache)
+          ->implicit_value(true),
+      "Reuse the results of the uncorrelated subqueries repeated on unchanged tables "
+      "across queries, in the query result cache.");
+  desc_adv.add_options()(
+      "enable-dictionary-translation-map",
+      po::value<bool>(&g_enable_dictionary_translation_map)
+          ->default_value(g_enable_dictionary_translation_map)
+          ->implicit_value(true),
+      "Translate the join keys of string columns with different dictionaries through a "
+      "map of the dictionary ids built once per dictionary generations.");
+  desc_adv.add_options()(
+      "enable-gpu-column-decode",
+      po::value<bool>(&g_enable_gpu_column_decode)
+          ->default_value(g_enable_gpu_column_decode)
+          ->implicit_value(true),
+      "Copy the DIFF encoded chunks of inner tables to the GPU encoded and decode them "
+      "there.");
+  desc_adv.add_options()(
+      "enable-gpu-waves",
+      po::value<bool>(&g_enable_gpu_waves)
+          ->default_value(g_enable_gpu_waves)
+          ->implicit_value(true),
+      "Retry the queries out of GPU memory on the GPU in waves of fragments sized to a "
+      "quarter of the GPU buffer pool before going fragment by fragment or to the CPU.");
+  desc_adv.add_options()(
+      "enable-cpu-multifrag-kernels",
+      po::value<bool>(&g_enable_cpu_multifrag_kernels)
+          ->default_value(g_enable_cpu_multifrag_kernels)
+          ->implicit_value(true),
+      "Aggregate the fragments on CPU with a kernel per thread instead of a kernel per "
+      "fragment.");
+  desc_adv.add_options()(
+      "insert-commit-interval-ms",
+      po::value<size_t>(&g_insert_commit_interval_ms)
+          ->default_value(g_insert_commit_interval_ms),
+      "Checkpoint the tables receiving INSERT statements at most this many milliseconds "
+      "after their rows instead of after every statement, 0 to checkpoint every one.");
+  desc_adv.add_options()(
+      "insert-commit-max-rows",
+      po::value<size_t>(&g_insert_commit_max_rows)
+          ->default_value(g_insert_commit_max_rows),
+      "Checkpoint a table right away once that many inserted rows wait for the commit "
+      "interval.");
+  desc_adv.add_options()(
+      "load-commit-interval-ms",
+      po::value<size_t>(&g_load_commit_interval_ms)
+          ->default_value(g_load_commit_interval_ms),
+      "Return from the loads which checkpoint their table, load_table_binary and the "
+      "like, once their rows are visible, and checkpoint the table at most this many "
+      "milliseconds later, 0 to checkpoint in the load.");
+  desc_adv.add_options()(
+      "load-commit-max-rows",
+      po::value<size_t>(&g_load_commit_max_rows)
+          ->default_value(g_load_commit_max_rows),
+      "Checkpoint a table right away once that many loaded rows wait for the commit "
+      "interval.");
+  desc_adv.add_options()(
+      "result-set-spill-threshold-bytes",
+      po::value<size_t>(&g_result_set_spill_threshold_bytes)
+          ->default_value(g_result_set_spill_threshold_bytes),
+      "Move the buffers of a projection result beyond that many bytes to scratch files "
+      "mapped back in memory, 0 keeps them all in memory.");
+  desc_adv.add_options()(
+      "result-set-spill-dir",
+      po::value<std::string>(&g_result_set_spill_dir)
+          ->default_value(g_result_set_spill_dir),
+      "Directory of the scratch files of the spilled result sets, the temporary "
+      "directory of the system if empty.");
+  desc_adv.add_options()(
+      "projection-single-pass-max-bytes",
+      po::value<size_t>(&g_projection_single_pass_max_bytes)
+          ->default_value(g_projection_single_pass_max_bytes),
+      "Run a projection without a limit in a single pass, with output buffers as large "
+      "as its fragments, when they take at most that many bytes. Larger projections "
+      "count their filtered rows first, 0 always counts.");
+  desc_adv.add_options()(
+      "code-cache-max-bytes",
+      po::value<size_t>(&g_code_cache_max_bytes)->default_value(g_code_cache_max_bytes),
+      "Evict the least recently used kernels of a code cache once their native code and "
+      "keys take more than that many bytes, 0 never evicts.");
+  desc_adv.add_options()("enable-catalog-snapshot",
+                         po::value<bool>(&g_enable_catalog_snapshot)
+                             ->default_value(g_enable_catalog_snapshot)
+                             ->implicit_value(true),
+                         "Load the tables and columns of a database from a binary "
+                         "snapshot of its catalog, rebuilt from sqlite when stale.");
+  desc_adv.add_options()("credential-cache-seconds",
+                         po::value<size_t>(&g_credential_cache_seconds)
+                             ->default_value(g_credential_cache_seconds),
+                         "Skip the bcrypt check of a password verified for the user that "
+                         "many seconds ago at most, 0 always checks.");
 
   po::positional_options_description positionalOptions;
   positionalOptions.add("data", 1);
@@ -737,8 +1336,9 @@ int main(int argc, char** argv) {
                                                   max_session_duration);
 
   mapd::shared_ptr<TServerSocket> serverSocket;
+  mapd::shared_ptr<TServerSocket> compressedServerSocket;
+  mapd::shared_ptr<TSSLSocketFactory> sslSocketFactory;
   if (!mapd_parameters.ssl_cert_file.empty() && !mapd_parameters.ssl_key_file.empty()) {
-    mapd::shared_ptr<TSSLSocketFactory> sslSocketFactory;
     sslSocketFactory =
         mapd::shared_ptr<TSSLSocketFactory>(new TSSLSocketFactory(SSLProtocol::SSLTLS));
     sslSocketFactory->loadCertificate(mapd_parameters.ssl_cert_file.c_str());
@@ -755,6 +1355,12 @@ int main(int argc, char** argv) {
     serverSocket = mapd::shared_ptr<TServerSocket>(
         new TServerSocket(mapd_parameters.mapd_server_port));
   }
+  if (compressed_port >= 0) {
+    compressedServerSocket = mapd::shared_ptr<TServerSocket>(
+        sslSocketFactory ? new TSSLServerSocket(compressed_port, sslSocketFactory)
+                         : new TServerSocket(compressed_port));
+    LOG(INFO) << " MapD server compressed port " << compressed_port;
+  }
 
   if (mapd_parameters.ha_group_id.empty()) {
     mapd::shared_ptr<TProcessor> processor(new MapDProcessor(g_mapd_handler));
@@ -774,14 +1380,55 @@ int main(int argc, char** argv) {
     TThreadedServer httpServer(
         processor, httpServerTransport, httpTransportFactory, httpProtocolFactory);
 
+    // Same binary protocol as the buffered port, framed by zlib so that large
+    // sql_execute results and load_table_binary_columnar payloads cross slow links
+    // compressed. The zlib transport does its own buffering.
+    std::unique_ptr<TThreadedServer> compressedServer;
+    if (compressedServerSocket) {
+      mapd::shared_ptr<TTransportFactory> compressedTransportFactory(
+          new TZlibTransportFactory());
+      compressedServer.reset(new TThreadedServer(processor,
+                                                 compressedServerSocket,
+                                                 compressedTransportFactory,
+                                                 bufProtocolFactory));
+    }
+
+    // Thousands of mostly idle dashboard connections would each hold a thread of the
+    // threaded servers. This one reads the framed requests from event loop threads
+    // and runs them on a bounded pool of workers. A connection only has one request
+    // in flight at a time, so a busy session can't hold more than one worker.
+    std::unique_ptr<TNonblockingServer> nonblockingServer;
+    if (nonblocking_port >= 0) {
+      nonblockingServer = make_nonblocking_server(processor,
+                                                  bufProtocolFactory,
+                                                  nonblocking_port,
+                                                  sslSocketFactory,
+                                                  nonblocking_io_threads,
+                                                  nonblocking_worker_threads);
+    }
+
     std::thread bufThread(start_server, std::ref(bufServer));
     std::thread httpThread(start_server, std::ref(httpServer));
+    std::thread compressedThread;
+    if (compressedServer) {
+      compressedThread = std::thread(start_server, std::ref(*compressedServer));
+    }
+    std::thread nonblockingThread;
+    if (nonblockingServer) {
+      nonblockingThread = std::thread(start_server, std::ref(*nonblockingServer));
+    }
 
     // run warm up queries if any exists
     run_warmup_queries(g_mapd_handler, base_path, db_query_file);
 
     bufThread.join();
     httpThread.join();
+    if (compressedThread.joinable()) {
+      compressedThread.join();
+    }
+    if (nonblockingThread.joinable()) {
+      nonblockingThread.join();
+    }
   } else {  // running ha server
     LOG(FATAL) << "No High Availability module available, please contact MapD support";
   }
@@ -32,11 +32,14 @@
 #include <cassert>
 #include <cmath>
 #include <limits>
+#include <mutex>
+#include <set>
 #include <stdexcept>
 #include <typeinfo>
 #include "../Catalog/Catalog.h"
 #include "../Catalog/SharedDictionaryValidator.h"
 #include "../Fragmenter/InsertOrderFragmenter.h"
+#include "../Fragmenter/ParquetFragmenter.h"
 #include "../Import/Importer.h"
 #include "../Planner/Planner.h"
 #include "../QueryEngine/CalciteAdapter.h"
@@ -2091,6 +2094,111 @@ void validate_shard_column_type(const size_t shard_column_id,
                            ", encoding " + col_ti.get_compression_name());
 }
 
+void validate_sort_column_type(const size_t sort_column_id,
+                               const std::list<ColumnDescriptor>& columns) {
+  CHECK_NE(size_t(0), sort_column_id);
+  CHECK_LE(sort_column_id, columns.size());
+  auto column_it = columns.begin();
+  std::advance(column_it, sort_column_id - 1);
+  const auto& col_ti = column_it->columnType;
+  // Fragments are only skipped on the range of numbers and times.
+  if (col_ti.is_integer() || col_ti.is_decimal() || col_ti.is_time() || col_ti.is_fp()) {
+    return;
+  }
+  throw std::runtime_error("Cannot sort on type " + col_ti.get_type_name());
+}
+
+void validate_index_column_type(const size_t index_column_id,
+                                const std::list<ColumnDescriptor>& columns) {
+  CHECK_NE(size_t(0), index_column_id);
+  CHECK_LE(index_column_id, columns.size());
+  auto column_it = columns.begin();
+  std::advance(column_it, index_column_id - 1);
+  const auto& col_ti = column_it->columnType;
+  // The index holds the values as inserted, the other encodings store them differently.
+  if ((col_ti.is_integer() || col_ti.is_time()) &&
+      (col_ti.get_compression() == kENCODING_NONE ||
+       col_ti.get_compression() == kENCODING_FIXED)) {
+    return;
+  }
+  throw std::runtime_error("Cannot index type " + col_ti.get_type_name() +
+                           ", encoding " + col_ti.get_compression_name());
+}
+
+// Time partitions are ranges of the sort column, which has to be a time.
+void validate_partition_options(const TableDescriptor& td,
+                                const std::list<ColumnDescriptor>& columns) {
+  if (td.retention && !td.partitionInterval) {
+    throw std::runtime_error("RETENTION requires a PARTITION_INTERVAL.");
+  }
+  if (!td.partitionInterval) {
+    return;
+  }
+  if (!td.sortedColumnId) {
+    throw std::runtime_error("PARTITION_INTERVAL requires a SORT_COLUMN.");
+  }
+  auto column_it = columns.begin();
+  std::advance(column_it, td.sortedColumnId - 1);
+  const auto& col_ti = column_it->columnType;
+  if (col_ti.get_type() != kTIMESTAMP && col_ti.get_type() != kDATE) {
+    throw std::runtime_error("Cannot partition on type " + col_ti.get_type_name());
+  }
+}
+
+// The loads update the rows of the keys already there column by column, which only
+// works for fixed width columns.
+void validate_primary_key_options(const TableDescriptor& td,
+                                  const std::list<ColumnDescriptor>& columns) {
+  if (!td.primaryKeyColumnId) {
+    return;
+  }
+  validate_index_column_type(td.primaryKeyColumnId, columns);
+  auto column_it = columns.begin();
+  std::advance(column_it, td.primaryKeyColumnId - 1);
+  if (!column_it->columnType.get_notnull()) {
+    throw std::runtime_error("PRIMARY_KEY column " + column_it->columnName +
+                             " must be NOT NULL.");
+  }
+  if (td.shardedColumnId && td.shardedColumnId != td.primaryKeyColumnId) {
+    throw std::runtime_error("PRIMARY_KEY of a sharded table must be its shard key.");
+  }
+  for (const auto& cd : columns) {
+    if (cd.columnType.is_varlen() ||
+        cd.columnType.get_compression() == kENCODING_DIFF) {
+      throw std::runtime_error("A table with a PRIMARY_KEY cannot have column " +
+                               cd.columnName + " of type " +
+                               cd.columnType.get_type_name() + ", encoding " +
+                               cd.columnType.get_compression_name());
+    }
+  }
+}
+
+// An external table is read in place from its Parquet files, it can't be laid out or
+// written to.
+void validate_external_options(const TableDescriptor& td,
+                               const std::list<ColumnDescriptor>& columns) {
+  if (td.externalPath.empty()) {
+    return;
+  }
+  if (!boost::filesystem::exists(td.externalPath)) {
+    throw std::runtime_error("EXTERNAL_PARQUET path " + td.externalPath +
+                             " doesn't exist.");
+  }
+  if (td.persistenceLevel != Data_Namespace::MemoryLevel::DISK_LEVEL) {
+    throw std::runtime_error("A temporary table cannot be EXTERNAL_PARQUET.");
+  }
+  if (td.shardedColumnId || td.nShards || td.sortedColumnId || td.indexColumnId ||
+      td.primaryKeyColumnId || td.partitionInterval || table_is_replicated(&td) ||
+      td.hasDeletedCol) {
+    throw std::runtime_error(
+        "An EXTERNAL_PARQUET table cannot have a SHARD KEY, SORT_COLUMN, INDEX_COLUMN, "
+        "PRIMARY_KEY, PARTITION_INTERVAL, PARTITIONS or VACUUM='DELAYED'.");
+  }
+  for (const auto& cd : columns) {
+    Fragmenter_Namespace::ParquetFragmenter::validateColumn(cd);
+  }
+}
+
 void set_string_field(rapidjson::Value& obj,
                       const std::string& field_name,
                       const std::string& field_value,
@@ -2263,6 +2371,74 @@ void CreateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
               "A table cannot be sharded and replicated at the same time");
         }
         td.partitions = partitions_uc;
+      } else if (boost::iequals(*p->get_name(), "sort_column")) {
+        if (!dynamic_cast<const StringLiteral*>(p->get_value())) {
+          throw std::runtime_error("SORT_COLUMN must be a string literal.");
+        }
+        const auto sort_column =
+            static_cast<const StringLiteral*>(p->get_value())->get_stringval();
+        CHECK(sort_column);
+        td.sortedColumnId = shard_column_index(*sort_column, columns);
+        if (!td.sortedColumnId) {
+          throw std::runtime_error("Specified sort column " + *sort_column +
+                                   " doesn't exist");
+        }
+        validate_sort_column_type(td.sortedColumnId, columns);
+      } else if (boost::iequals(*p->get_name(), "index_column")) {
+        if (!dynamic_cast<const StringLiteral*>(p->get_value())) {
+          throw std::runtime_error("INDEX_COLUMN must be a string literal.");
+        }
+        const auto index_column =
+            static_cast<const StringLiteral*>(p->get_value())->get_stringval();
+        CHECK(index_column);
+        td.indexColumnId = shard_column_index(*index_column, columns);
+        if (!td.indexColumnId) {
+          throw std::runtime_error("Specified index column " + *index_column +
+                                   " doesn't exist");
+        }
+        validate_index_column_type(td.indexColumnId, columns);
+      } else if (boost::iequals(*p->get_name(), "primary_key")) {
+        if (!dynamic_cast<const StringLiteral*>(p->get_value())) {
+          throw std::runtime_error("PRIMARY_KEY must be a string literal.");
+        }
+        const auto primary_key =
+            static_cast<const StringLiteral*>(p->get_value())->get_stringval();
+        CHECK(primary_key);
+        td.primaryKeyColumnId = shard_column_index(*primary_key, columns);
+        if (!td.primaryKeyColumnId) {
+          throw std::runtime_error("Specified primary key " + *primary_key +
+                                   " doesn't exist");
+        }
+      } else if (boost::iequals(*p->get_name(), "partition_interval")) {
+        if (!dynamic_cast<const IntLiteral*>(p->get_value())) {
+          throw std::runtime_error("PARTITION_INTERVAL must be an integer literal.");
+        }
+        const auto interval =
+            static_cast<const IntLiteral*>(p->get_value())->get_intval();
+        if (interval <= 0) {
+          throw std::runtime_error("PARTITION_INTERVAL must be a positive number.");
+        }
+        td.partitionInterval = interval;
+      } else if (boost::iequals(*p->get_name(), "retention")) {
+        if (!dynamic_cast<const IntLiteral*>(p->get_value())) {
+          throw std::runtime_error("RETENTION must be an integer literal.");
+        }
+        const auto retention =
+            static_cast<const IntLiteral*>(p->get_value())->get_intval();
+        if (retention <= 0) {
+          throw std::runtime_error("RETENTION must be a positive number.");
+        }
+        td.retention = retention;
+      } else if (boost::iequals(*p->get_name(), "external_parquet")) {
+        if (!dynamic_cast<const StringLiteral*>(p->get_value())) {
+          throw std::runtime_error("EXTERNAL_PARQUET must be a string literal.");
+        }
+        const auto external_path =
+            static_cast<const StringLiteral*>(p->get_value())->get_stringval();
+        CHECK(external_path);
+        td.externalPath = boost::filesystem::absolute(*external_path).string();
+        // Nothing is ever deleted from the files.
+        td.hasDeletedCol = false;
       } else if (boost::iequals(*p->get_name(), "shard_count")) {
         if (!dynamic_cast<const IntLiteral*>(p->get_value())) {
           throw std::runtime_error("SHARD_COUNT must be an integer literal.");
@@ -2296,10 +2472,15 @@ void CreateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
       } else {
         throw std::runtime_error("Invalid CREATE TABLE option " + *p->get_name() +
                                  ".  Should be FRAGMENT_SIZE, PAGE_SIZE, MAX_ROWS, "
-                                 "PARTITIONS, VACUUM or SHARD_COUNT.");
+                                 "PARTITIONS, VACUUM, SORT_COLUMN, INDEX_COLUMN, "
+                                 "PRIMARY_KEY, PARTITION_INTERVAL, RETENTION, "
+                                 "EXTERNAL_PARQUET or SHARD_COUNT.");
       }
     }
   }
+  validate_partition_options(td, columns);
+  validate_primary_key_options(td, columns);
+  validate_external_options(td, columns);
   if (shard_key_def && !td.nShards) {
     throw std::runtime_error(
         "Must specify the number of shards through the SHARD_COUNT option");
@@ -2406,6 +2587,141 @@ int8_t* fill_dict_column(std::vector<std::unique_ptr<int8_t[]>>& dest_string_ids
   return dest_string_ids_owner.back().get();
 }
 
+// Converts the rows of a query result to the columns of the table, given in the order
+// of the query targets, and appends them to the table.
+void append_result_rows(Catalog_Namespace::Catalog& catalog,
+                        const TableDescriptor* td,
+                        const std::shared_ptr<ResultSet>& result_rows,
+                        const std::vector<ColumnDescriptor>& column_descriptors) {
+  const auto num_rows = result_rows->rowCount();
+  std::vector<std::unique_ptr<TargetValueConverter>> value_converters;
+  TargetValueConverterFactory factory;
+
+  for (const auto& cd : column_descriptors) {
+    const ColumnDescriptor* sourceDescriptor = &cd;
+    const ColumnDescriptor* targetDescriptor =
+        catalog.getMetadataForColumn(td->tableId, cd.columnName);
+
+    ConverterCreateParameter param{num_rows,
+                                   catalog,
+                                   sourceDescriptor,
+                                   targetDescriptor,
+                                   targetDescriptor->columnType,
+                                   !targetDescriptor->columnType.get_notnull()};
+    auto converter = factory.create(param);
+    value_converters.push_back(std::move(converter));
+  }
+
+  const int num_cols = value_converters.size();
+  bool can_go_parallel = !result_rows->isTruncated() && num_rows > 20000;
+
+  if (can_go_parallel) {
+    const size_t entryCount =
+        result_rows->isPermutationBufferEmpty() ? result_rows->entryCount() : num_rows;
+    const size_t num_worker_threads = cpu_threads();
+    const size_t stride = (entryCount + num_worker_threads - 1) / num_worker_threads;
+    std::vector<std::pair<size_t, size_t>> entry_ranges;
+    for (size_t start_entry = 0; start_entry < entryCount; start_entry += stride) {
+      entry_ranges.emplace_back(start_entry, std::min(start_entry + stride, entryCount));
+    }
+    // Count the rows of each range first, so that every worker writes its rows from a
+    // known offset: the rows keep the result order and no counter is shared.
+    std::vector<std::future<size_t>> counter_threads;
+    for (const auto& entry_range : entry_ranges) {
+      counter_threads.push_back(std::async(
+          std::launch::async,
+          [&result_rows](const size_t start, const size_t end) {
+            size_t row_count{0};
+            for (size_t entry_idx = start; entry_idx < end; ++entry_idx) {
+              if (!result_rows->isRowAtEmpty(entry_idx)) {
+                ++row_count;
+              }
+            }
+            return row_count;
+          },
+          entry_range.first,
+          entry_range.second));
+    }
+    std::vector<size_t> row_offsets;
+    size_t row_offset{0};
+    for (auto& child : counter_threads) {
+      row_offsets.push_back(row_offset);
+      row_offset += child.get();
+    }
+    CHECK_EQ(num_rows, row_offset);
+
+    std::vector<std::future<void>> worker_threads;
+    for (size_t i = 0; i < entry_ranges.size(); ++i) {
+      worker_threads.push_back(std::async(
+          std::launch::async,
+          [&result_rows, &value_converters, num_cols](
+              const size_t start, const size_t end, size_t target_row) {
+            for (size_t entry_idx = start; entry_idx < end; ++entry_idx) {
+              if (result_rows->isRowAtEmpty(entry_idx)) {
+                continue;
+              }
+              const auto result_row = result_rows->getRowAtNoTranslations(entry_idx);
+              for (int col = 0; col < num_cols; col++) {
+                const auto& mapd_variant = result_row[col];
+                value_converters[col]->convertToColumnarFormat(target_row,
+                                                               &mapd_variant);
+              }
+              ++target_row;
+            }
+          },
+          entry_ranges[i].first,
+          entry_ranges[i].second,
+          row_offsets[i]));
+    }
+
+    for (auto& child : worker_threads) {
+      child.get();
+    }
+
+  } else {
+    for (size_t row = 0; row < num_rows; row++) {
+      const auto result_row = result_rows->getNextRow(false, false);
+      for (unsigned int col = 0; col < num_cols; col++) {
+        const auto& mapd_variant = result_row[col];
+        value_converters[col]->convertToColumnarFormat(row, &mapd_variant);
+      }
+    }
+  }
+
+  // the dictionary encoded columns are translated in bulk once all rows are converted
+  std::vector<std::future<void>> finalize_threads;
+  for (auto& value_converter : value_converters) {
+    finalize_threads.push_back(std::async(
+        std::launch::async,
+        [&value_converter] { value_converter->finalizeDataBlocksForInsertData(); }));
+  }
+  for (auto& child : finalize_threads) {
+    child.get();
+  }
+
+  {
+    Fragmenter_Namespace::InsertData insert_data;
+    insert_data.databaseId = catalog.get_currentDB().dbId;
+    insert_data.tableId = td->tableId;
+
+    int col_idx = 0;
+    for (const auto cd : column_descriptors) {
+      value_converters[col_idx++]->addDataBlocksToInsertData(insert_data);
+      continue;
+    }
+    // get CheckpointLock+UpdateDeleteLock locks on the table before trying to create its
+    // 1st fragment
+    ChunkKey chunkKey = {catalog.get_currentDB().dbId, td->tableId};
+    mapd_unique_lock<mapd_shared_mutex> chkptlLock(
+        *Lock_Namespace::LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(
+            Lock_Namespace::LockType::CheckpointLock, chunkKey));
+    // [ write UpdateDeleteLocks ] lock is deferred in
+    // InsertOrderFragmenter::deleteFragments
+    insert_data.numRows = num_rows;
+    td->fragmenter->insertData(insert_data);
+  }
+}
+
 }  // namespace
 
 void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& session) {
@@ -2442,8 +2758,6 @@ void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& sess
 
   std::list<ColumnDescriptor> column_descriptors_for_create;
   std::vector<ColumnDescriptor> column_descriptors;
-  std::vector<std::unique_ptr<TargetValueConverter>> value_converters;
-  const auto num_rows = result_rows->rowCount();
 
   for (const auto& target_metainfo : target_metainfos) {
     ColumnDescriptor cd;
@@ -2484,99 +2798,11 @@ void CreateTableAsSelectStmt::execute(const Catalog_Namespace::SessionInfo& sess
   }
 
   const TableDescriptor* created_td = catalog.getMetadataForTable(table_name_);
-
-  TargetValueConverterFactory factory;
-
-  for (const auto& cd : column_descriptors) {
-    const ColumnDescriptor* sourceDescriptor = &cd;
-    const ColumnDescriptor* targetDescriptor =
-        catalog.getMetadataForColumn(created_td->tableId, cd.columnName);
-
-    ConverterCreateParameter param{num_rows,
-                                   catalog,
-                                   sourceDescriptor,
-                                   targetDescriptor,
-                                   targetDescriptor->columnType,
-                                   !targetDescriptor->columnType.get_notnull()};
-    auto converter = factory.create(param);
-    value_converters.push_back(std::move(converter));
-  }
-
-  const int num_cols = value_converters.size();
-  bool can_go_parallel = !result_rows->isTruncated() && num_rows > 20000;
-
-  if (can_go_parallel) {
-    const size_t entryCount = result_rows->entryCount();
-    const size_t num_worker_threads = cpu_threads();
-    std::atomic<size_t> row_idx{0};
-    std::vector<std::future<size_t>> worker_threads;
-    for (size_t i = 0,
-                start_entry = 0,
-                stride = (entryCount + num_worker_threads - 1) / num_worker_threads;
-         i < num_worker_threads && start_entry < entryCount;
-         ++i, start_entry += stride) {
-      const auto end_entry = std::min(start_entry + stride, entryCount);
-      worker_threads.push_back(
-          std::async(std::launch::async,
-                     [&result_rows, &value_converters, &num_cols, &row_idx](
-                         const size_t start, const size_t end) {
-                       size_t row_count{0};
-                       for (size_t i = start; i < end; ++i) {
-                         const auto result_row = result_rows->getRowAtNoTranslations(i);
-                         if (!result_row.empty()) {
-                           size_t target_row = row_idx.fetch_add(1);
-                           for (unsigned int col = 0; col < num_cols; col++) {
-                             const auto& mapd_variant = result_row[col];
-                             value_converters[col]->convertToColumnarFormat(
-                                 target_row, &mapd_variant);
-                           }
-                         }
-                       }
-                       return row_count;
-                     },
-                     start_entry,
-                     end_entry));
-    }
-
-    for (auto& child : worker_threads) {
-      child.wait();
-    }
-
-  } else {
-    for (size_t row = 0; row < num_rows; row++) {
-      const auto result_row = result_rows->getNextRow(false, false);
-      for (unsigned int col = 0; col < num_cols; col++) {
-        const auto& mapd_variant = result_row[col];
-        value_converters[col]->convertToColumnarFormat(row, &mapd_variant);
-      }
-    }
-  }
-
+  CHECK(created_td);
   try {
-    Fragmenter_Namespace::InsertData insert_data;
-    insert_data.databaseId = catalog.get_currentDB().dbId;
-    CHECK(created_td);
-    insert_data.tableId = created_td->tableId;
-
-    int col_idx = 0;
-    for (const auto cd : column_descriptors) {
-      value_converters[col_idx++]->addDataBlocksToInsertData(insert_data);
-      continue;
-    }
-    // get CheckpointLock+UpdateDeleteLock locks on the table before trying to create its
-    // 1st fragment
-    ChunkKey chunkKey = {catalog.get_currentDB().dbId, created_td->tableId};
-    mapd_unique_lock<mapd_shared_mutex> chkptlLock(
-        *Lock_Namespace::LockMgr<mapd_shared_mutex, ChunkKey>::getMutex(
-            Lock_Namespace::LockType::CheckpointLock, chunkKey));
-    // [ write UpdateDeleteLocks ] lock is deferred in
-    // InsertOrderFragmenter::deleteFragments
-    insert_data.numRows = num_rows;
-    created_td->fragmenter->insertData(insert_data);
+    append_result_rows(catalog, created_td, result_rows, column_descriptors);
   } catch (...) {
-    if (created_td) {
-      catalog.dropTable(created_td);
-    }
+    catalog.dropTable(created_td);
     throw;
   }
   if (SysCatalog::instance().arePrivilegesOn()) {
@@ -2608,6 +2834,13 @@ void DropTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (td->isView) {
     throw std::runtime_error(*table + " is a view.  Use DROP VIEW.");
   }
+  const auto materialized_views = catalog.getMaterializedViews(td->tableId);
+  if (!materialized_views.empty()) {
+    const auto view_td = catalog.getMetadataForTable(materialized_views.front().viewId);
+    CHECK(view_td);
+    throw std::runtime_error("Table " + *table + " is used by materialized view " +
+                             view_td->tableName + ".  Drop the view first.");
+  }
 
   auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
       catalog, *table, LockType::CheckpointLock);
@@ -2640,7 +2873,11 @@ void TruncateTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (td->isView) {
     throw std::runtime_error(*table + " is a view.  Cannot Truncate.");
   }
+  if (!td->externalPath.empty()) {
+    throw std::runtime_error(*table + " is an external table.  Cannot Truncate.");
+  }
   catalog.truncateTable(td);
+  DeleteTriggeredCacheInvalidator::invalidateCaches();
 }
 
 void check_alter_table_privilege(const Catalog_Namespace::SessionInfo& session,
@@ -2663,6 +2900,39 @@ void check_alter_table_privilege(const Catalog_Namespace::SessionInfo& session,
   }
 }
 
+void OptimizeTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  const TableDescriptor* td = catalog.getMetadataForTable(*table);
+  if (td == nullptr) {
+    throw std::runtime_error("Table " + *table + " does not exist.");
+  }
+  if (td->isView) {
+    throw std::runtime_error(*table + " is a view.  Cannot Optimize.");
+  }
+  check_alter_table_privilege(session, td);
+  // By default any fragment with a deleted row gets rewritten.
+  double min_deleted_fraction = 0;
+  for (const auto& p : options) {
+    if (boost::iequals(*p->get_name(), "min_deleted_fraction")) {
+      if (const auto int_literal = dynamic_cast<const IntLiteral*>(p->get_value())) {
+        min_deleted_fraction = int_literal->get_intval();
+      } else if (const auto fixedpt_literal =
+                     dynamic_cast<const FixedPtLiteral*>(p->get_value())) {
+        min_deleted_fraction = std::stod(*fixedpt_literal->get_fixedptval());
+      } else {
+        throw std::runtime_error("min_deleted_fraction option must be a number.");
+      }
+      if (min_deleted_fraction < 0 || min_deleted_fraction > 1) {
+        throw std::runtime_error("min_deleted_fraction must be between 0 and 1.");
+      }
+    } else {
+      throw std::runtime_error("Invalid OPTIMIZE TABLE option " + *p->get_name() +
+                               ". Should be MIN_DELETED_FRACTION.");
+    }
+  }
+  catalog.vacuumDeletedRows(td, min_deleted_fraction);
+}
+
 void RenameTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   auto& catalog = session.get_catalog();
   const TableDescriptor* td = catalog.getMetadataForTable(*table);
@@ -2775,10 +3045,47 @@ void DDLStmt::setColumnDescriptor(ColumnDescriptor& cd, const ColumnDef* coldef)
       cd.columnType.set_comp_param(0);
       // throw std::runtime_error("RL(Run Length) encoding not supported yet.");
     } else if (boost::iequals(comp, "diff")) {
-      // differential encoding
+      // frame of reference encoding, the values are stored relative to a baseline
+      if (!cd.columnType.is_integer() && !cd.columnType.is_time()) {
+        throw std::runtime_error(
+            cd.columnName +
+            ": Diff encoding is only supported for integer or time columns.");
+      }
+      switch (cd.columnType.get_type()) {
+        case kSMALLINT:
+          if (compression->get_encoding_param() != 8) {
+            throw std::runtime_error(
+                cd.columnName +
+                ": Compression parameter for Diff encoding on SMALLINT must be 8.");
+          }
+          break;
+        case kINT:
+          if (compression->get_encoding_param() != 8 &&
+              compression->get_encoding_param() != 16) {
+            throw std::runtime_error(
+                cd.columnName +
+                ": Compression parameter for Diff encoding on INTEGER must be 8 or 16.");
+          }
+          break;
+        case kBIGINT:
+        case kTIMESTAMP:
+        case kDATE:
+        case kTIME:
+          if (compression->get_encoding_param() != 8 &&
+              compression->get_encoding_param() != 16 &&
+              compression->get_encoding_param() != 32) {
+            throw std::runtime_error(cd.columnName +
+                                     ": Compression parameter for Diff encoding on "
+                                     "BIGINT, TIME, DATE or TIMESTAMP must be 8 or 16 "
+                                     "or 32.");
+          }
+          break;
+        default:
+          throw std::runtime_error(cd.columnName + ": Cannot apply DIFF encoding to " +
+                                   t->to_string());
+      }
       cd.columnType.set_compression(kENCODING_DIFF);
-      cd.columnType.set_comp_param(0);
-      // throw std::runtime_error("DIFF(differential) encoding not supported yet.");
+      cd.columnType.set_comp_param(compression->get_encoding_param());
     } else if (boost::iequals(comp, "dict")) {
       if (!cd.columnType.is_string() && !cd.columnType.is_string_array()) {
         throw std::runtime_error(
@@ -3086,6 +3393,9 @@ void CopyTableStmt::execute(const Catalog_Namespace::SessionInfo& session,
                                " has no insert privileges for table " + *table + ".");
     }
   }
+  if (td && !td->externalPath.empty()) {
+    throw std::runtime_error(*table + " is an external table.  Cannot COPY into it.");
+  }
 
   // since we'll have not only posix file names but also s3/hdfs/... url
   // we do not expand wildcard or check file existence here.
@@ -3137,6 +3447,20 @@ void CopyTableStmt::execute(const Catalog_Namespace::SessionInfo& session,
         } else {
           throw std::runtime_error("Invalid string for boolean " + *s);
         }
+      } else if (boost::iequals(*p->get_name(), "on_duplicate_key")) {
+        const StringLiteral* str_literal =
+            dynamic_cast<const StringLiteral*>(p->get_value());
+        if (str_literal == nullptr) {
+          throw std::runtime_error("On_duplicate_key option must be a string.");
+        }
+        const std::string* s = str_literal->get_stringval();
+        if (boost::iequals(*s, "update")) {
+          copy_params.skip_duplicate_keys = false;
+        } else if (boost::iequals(*s, "skip")) {
+          copy_params.skip_duplicate_keys = true;
+        } else {
+          throw std::runtime_error("On_duplicate_key must be UPDATE or SKIP.");
+        }
 #ifdef ENABLE_IMPORT_PARQUET  // for now skeleton only
       } else if (boost::iequals(*p->get_name(), "parquet")) {
         const StringLiteral* str_literal =
@@ -4106,7 +4430,472 @@ void DropViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
   if (!td->isView) {
     throw std::runtime_error(*view_name + " is a table.  Use DROP TABLE.");
   }
+  const auto mvd = catalog.getMetadataForMaterializedView(td->tableId);
+  const auto state_td = mvd ? catalog.getMetadataForTable(mvd->stateTableId) : nullptr;
   catalog.dropTable(td);
+  if (state_td) {
+    const auto state_table_name = state_td->tableName;
+    auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+        catalog, state_table_name, LockType::CheckpointLock);
+    auto upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+        catalog, state_table_name, LockType::UpdateDeleteLock);
+    catalog.dropTable(state_td);
+  }
+}
+
+namespace {
+
+const std::string kMaterializedViewStateSuffix{"_mv_state"};
+
+// The aggregate query of a materialized view, split in the query which computes the
+// partial aggregates of a range of source rows and the query which merges them.
+struct MaterializedViewQueries {
+  std::string source_table;
+  std::string state_targets;
+  std::string filter;
+  std::string groupby;
+  std::string merge_query;
+
+  std::string getStateQuery(const int64_t begin_row, const int64_t end_row) const {
+    std::string query = "SELECT " + state_targets + " FROM " + source_table +
+                        " WHERE rowid >= " + std::to_string(begin_row) +
+                        " AND rowid < " + std::to_string(end_row);
+    if (!filter.empty()) {
+      query += " AND (" + filter + ")";
+    }
+    if (!groupby.empty()) {
+      query += " GROUP BY " + groupby;
+    }
+    return query;
+  }
+};
+
+MaterializedViewQueries get_materialized_view_queries(
+    const std::string& select_query,
+    const std::string& state_table_name) {
+  SQLParser parser;
+  std::list<std::unique_ptr<Stmt>> parse_trees;
+  std::string last_parsed;
+  if (parser.parse(select_query, parse_trees, last_parsed) || parse_trees.size() != 1) {
+    throw std::runtime_error("Syntax error in materialized view query at: " +
+                             last_parsed);
+  }
+  const auto select_stmt = dynamic_cast<const SelectStmt*>(parse_trees.front().get());
+  if (!select_stmt) {
+    throw std::runtime_error("A materialized view must be defined by a SELECT query.");
+  }
+  if (!select_stmt->get_orderby_clause().empty() || select_stmt->get_limit() ||
+      select_stmt->get_offset()) {
+    throw std::runtime_error(
+        "ORDER BY, LIMIT and OFFSET are not supported in a materialized view.");
+  }
+  const auto query_spec = dynamic_cast<const QuerySpec*>(select_stmt->get_query_expr());
+  if (!query_spec) {
+    throw std::runtime_error("UNION is not supported in a materialized view.");
+  }
+  if (query_spec->get_is_distinct() || query_spec->get_having_clause()) {
+    throw std::runtime_error(
+        "SELECT DISTINCT and HAVING are not supported in a materialized view.");
+  }
+  if (query_spec->get_from_clause().size() != 1) {
+    throw std::runtime_error("A materialized view must select from a single table.");
+  }
+  if (query_spec->get_select_clause().empty()) {
+    throw std::runtime_error("SELECT * is not supported in a materialized view.");
+  }
+
+  MaterializedViewQueries queries;
+  const auto& table_ref = query_spec->get_from_clause().front();
+  queries.source_table = *table_ref->get_table_name();
+  std::vector<std::string> groupby_strs;
+  for (const auto& groupby_expr : query_spec->get_groupby_clause()) {
+    groupby_strs.push_back(groupby_expr->to_string());
+  }
+  std::set<std::string> selected_groupby_strs;
+  std::vector<std::string> state_targets;
+  std::vector<std::string> merge_targets;
+  std::vector<std::string> merge_keys;
+  for (const auto& select_entry : query_spec->get_select_clause()) {
+    const auto expr = select_entry->get_select_expr();
+    const auto alias = select_entry->get_alias();
+    const auto expr_str = expr->to_string();
+    if (std::find(groupby_strs.begin(), groupby_strs.end(), expr_str) !=
+        groupby_strs.end()) {
+      const auto col_ref = dynamic_cast<const ColumnRef*>(expr);
+      if (!alias && !(col_ref && col_ref->get_column())) {
+        throw std::runtime_error("Grouping expression " + expr_str +
+                                 " must have an alias in a materialized view.");
+      }
+      const auto name = alias ? *alias : *col_ref->get_column();
+      state_targets.push_back(expr_str + " AS " + name);
+      merge_targets.push_back(name);
+      merge_keys.push_back(name);
+      selected_groupby_strs.insert(expr_str);
+      continue;
+    }
+    const auto agg = dynamic_cast<const FunctionRef*>(expr);
+    if (!agg) {
+      throw std::runtime_error("Expression " + expr_str +
+                               " must be a grouping expression or an aggregate in a "
+                               "materialized view.");
+    }
+    if (!alias) {
+      throw std::runtime_error("Aggregate " + expr_str +
+                               " must have an alias in a materialized view.");
+    }
+    if (agg->get_distinct()) {
+      throw std::runtime_error(
+          "COUNT(DISTINCT) is not supported in a materialized view, use "
+          "APPROX_COUNT_DISTINCT instead.");
+    }
+    const auto& name = *alias;
+    const auto agg_name = boost::to_upper_copy<std::string>(*agg->get_name());
+    if (agg_name == "COUNT") {
+      state_targets.push_back(expr_str + " AS " + name);
+      merge_targets.push_back("SUM(" + name + ") AS " + name);
+      continue;
+    }
+    if (!agg->get_arg()) {
+      throw std::runtime_error("Aggregate " + expr_str + " is not supported.");
+    }
+    const auto arg_str = agg->get_arg()->to_string();
+    if (agg_name == "SUM" || agg_name == "MIN" || agg_name == "MAX") {
+      state_targets.push_back(expr_str + " AS " + name);
+      merge_targets.push_back(agg_name + "(" + name + ") AS " + name);
+    } else if (agg_name == "AVG") {
+      const auto sum_name = name + "_sum";
+      const auto count_name = name + "_count";
+      state_targets.push_back("SUM(" + arg_str + ") AS " + sum_name);
+      state_targets.push_back("COUNT(" + arg_str + ") AS " + count_name);
+      merge_targets.push_back("CASE WHEN SUM(" + count_name + ") > 0 THEN CAST(SUM(" +
+                              sum_name + ") AS DOUBLE) / SUM(" + count_name +
+                              ") END AS " + name);
+    } else if (agg_name == "APPROX_COUNT_DISTINCT") {
+      state_targets.push_back("APPROX_COUNT_DISTINCT_SKETCH(" + arg_str + ") AS " +
+                              name);
+      merge_targets.push_back("APPROX_COUNT_DISTINCT_UNION(" + name + ") AS " + name);
+    } else {
+      throw std::runtime_error("Aggregate " + expr_str +
+                               " is not supported in a materialized view.");
+    }
+  }
+  for (const auto& groupby_str : groupby_strs) {
+    if (!selected_groupby_strs.count(groupby_str)) {
+      throw std::runtime_error("Grouping expression " + groupby_str +
+                               " must be selected in a materialized view.");
+    }
+  }
+
+  queries.state_targets = boost::algorithm::join(state_targets, ", ");
+  if (query_spec->get_where_clause()) {
+    queries.filter = query_spec->get_where_clause()->to_string();
+  }
+  queries.groupby = boost::algorithm::join(groupby_strs, ", ");
+  queries.merge_query = "SELECT " + boost::algorithm::join(merge_targets, ", ") +
+                        " FROM " + state_table_name;
+  if (!merge_keys.empty()) {
+    queries.merge_query += " GROUP BY " + boost::algorithm::join(merge_keys, ", ");
+  }
+  return queries;
+}
+
+// Adds the partial aggregates of the source rows appended since the last refresh to the
+// state table of the view. Only the row range is read, the fragments before it are
+// skipped on their rowid metadata.
+void refresh_materialized_view(const Catalog_Namespace::SessionInfo& session,
+                               const int view_id) {
+  static std::mutex refresh_mutex;
+  std::lock_guard<std::mutex> refresh_lock(refresh_mutex);
+  auto& catalog = session.get_catalog();
+  // the view could have been refreshed or dropped while waiting for the lock
+  const auto mvd_ptr = catalog.getMetadataForMaterializedView(view_id);
+  if (!mvd_ptr) {
+    return;
+  }
+  const auto mvd = *mvd_ptr;
+  const auto source_td = catalog.getMetadataForTable(mvd.sourceTableId);
+  const auto state_td = catalog.getMetadataForTable(mvd.stateTableId);
+  CHECK(source_td && source_td->fragmenter);
+  CHECK(state_td);
+  const auto source_rows = static_cast<int64_t>(
+      source_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples());
+  auto refreshed_rows = mvd.refreshedRows;
+  if (source_rows == refreshed_rows) {
+    return;
+  }
+  if (source_rows < refreshed_rows) {
+    // the source table has been truncated, aggregate it again from its first row
+    auto chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+        catalog, state_td->tableName, LockType::CheckpointLock);
+    auto upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+        catalog, state_td->tableName, LockType::UpdateDeleteLock);
+    catalog.truncateTable(state_td);
+    refreshed_rows = 0;
+  }
+  if (source_rows > refreshed_rows) {
+    const auto queries = get_materialized_view_queries(mvd.viewSQL, state_td->tableName);
+    const auto state_query = queries.getStateQuery(refreshed_rows, source_rows);
+
+    // get read UpdateDeleteLock on the source table
+    const auto query_ra = parse_to_ra(catalog, state_query, session);
+    std::vector<std::shared_ptr<VLock>> readUpdateDeleteLocks;
+    Lock_Namespace::getTableLocks<mapd_shared_mutex>(
+        catalog, query_ra, readUpdateDeleteLocks, LockType::UpdateDeleteLock);
+
+    std::vector<TargetMetaInfo> target_metainfos;
+    const auto result_rows = getResultRows(session, state_query, target_metainfos);
+    if (!result_rows->definitelyHasNoRows()) {
+      std::vector<ColumnDescriptor> column_descriptors;
+      for (const auto& target_metainfo : target_metainfos) {
+        ColumnDescriptor cd;
+        cd.columnName = target_metainfo.get_resname();
+        cd.columnType = target_metainfo.get_physical_type_info();
+        column_descriptors.push_back(cd);
+      }
+      append_result_rows(catalog, state_td, result_rows, column_descriptors);
+    }
+  }
+  catalog.setMaterializedViewRefreshedRows(view_id, source_rows);
+}
+
+}  // namespace
+
+void CreateMaterializedViewStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  if (g_cluster) {
+    throw std::runtime_error("Distributed materialized views not supported yet");
+  }
+  auto& catalog = session.get_catalog();
+
+  if (catalog.getMetadataForTable(view_name_) != nullptr) {
+    if (if_not_exists_) {
+      return;
+    }
+    throw std::runtime_error("Table or View " + view_name_ + " already exists.");
+  }
+  const auto state_table_name = view_name_ + kMaterializedViewStateSuffix;
+  if (catalog.getMetadataForTable(state_table_name) != nullptr) {
+    throw std::runtime_error("Table " + state_table_name + " already exists.");
+  }
+
+  const auto view_sql = boost::algorithm::trim_right_copy_if(
+      select_query_, boost::is_any_of(";") || boost::is_space());
+  const auto queries = get_materialized_view_queries(view_sql, state_table_name);
+  const auto source_td = catalog.getMetadataForTable(queries.source_table);
+  if (source_td == nullptr) {
+    throw std::runtime_error("Table " + queries.source_table + " does not exist.");
+  }
+  if (source_td->isView) {
+    throw std::runtime_error("A materialized view must select from a table, " +
+                             queries.source_table + " is a view.");
+  }
+  if (source_td->nShards) {
+    throw std::runtime_error("Materialized views over sharded tables not supported yet");
+  }
+
+  const auto source_rows = static_cast<int64_t>(
+      source_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples());
+  CreateTableAsSelectStmt(
+      state_table_name, queries.getStateQuery(0, source_rows), false)
+      .execute(session);
+  const auto state_td = catalog.getMetadataForTable(state_table_name);
+  CHECK(state_td);
+  try {
+    CreateViewStmt(view_name_, queries.merge_query, false).execute(session);
+    const auto view_td = catalog.getMetadataForTable(view_name_);
+    CHECK(view_td);
+    catalog.addMaterializedView(
+        {view_td->tableId, source_td->tableId, state_td->tableId, view_sql, source_rows});
+  } catch (...) {
+    const auto view_td = catalog.getMetadataForTable(view_name_);
+    if (view_td) {
+      catalog.dropTable(view_td);
+    }
+    catalog.dropTable(state_td);
+    throw;
+  }
+}
+
+void RefreshMaterializedViewStmt::execute(
+    const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  const auto td = catalog.getMetadataForTable(view_name_);
+  if (td == nullptr || !catalog.getMetadataForMaterializedView(td->tableId)) {
+    throw std::runtime_error("Materialized view " + view_name_ + " does not exist.");
+  }
+  refresh_materialized_view(session, td->tableId);
+}
+
+void RefreshMaterializedViewStmt::refreshAll(
+    const Catalog_Namespace::SessionInfo& session) {
+  for (const auto& mvd : session.get_catalog().getMaterializedViews()) {
+    refresh_materialized_view(session, mvd.viewId);
+  }
+}
+
+namespace {
+
+// Buckets of the equi-depth histograms computed by ANALYZE TABLE.
+constexpr size_t kHistogramBuckets{32};
+// Rows sampled to build a histogram, every n-th row by rowid.
+constexpr int64_t kHistogramSampleRows{32768};
+// The statistics of a table are computed again once its row count changed by more than
+// this fraction, which keeps the cost of maintaining them proportional to the loads.
+constexpr double kStaleStatisticsFraction{0.2};
+
+int64_t get_physical_row_count(const Catalog_Namespace::Catalog& catalog,
+                               const TableDescriptor* td) {
+  int64_t row_count{0};
+  for (const auto physical_td : catalog.getPhysicalTablesDescriptors(td)) {
+    CHECK(physical_td->fragmenter);
+    row_count += physical_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples();
+  }
+  return row_count;
+}
+
+int64_t get_int_value(const TargetValue& tv) {
+  const auto scalar_tv = boost::get<ScalarTargetValue>(&tv);
+  CHECK(scalar_tv);
+  const auto int_p = boost::get<int64_t>(scalar_tv);
+  CHECK(int_p);
+  return *int_p;
+}
+
+double get_double_value(const TargetValue& tv) {
+  const auto scalar_tv = boost::get<ScalarTargetValue>(&tv);
+  CHECK(scalar_tv);
+  if (const auto int_p = boost::get<int64_t>(scalar_tv)) {
+    return *int_p;
+  }
+  if (const auto float_p = boost::get<float>(scalar_tv)) {
+    return *float_p;
+  }
+  const auto double_p = boost::get<double>(scalar_tv);
+  CHECK(double_p);
+  return *double_p;
+}
+
+// Bounds of the equi-depth histogram of the non-null values of a column, from a sample
+// of its rows. The values are in the units the column is stored in.
+std::vector<double> compute_histogram(const Catalog_Namespace::SessionInfo& session,
+                                      const TableDescriptor* td,
+                                      const ColumnDescriptor* cd,
+                                      const int64_t row_count) {
+  const auto sample_step = std::max(row_count / kHistogramSampleRows, int64_t(1));
+  auto sample_query = "SELECT " + cd->columnName + " FROM " + td->tableName + " WHERE " +
+                      cd->columnName + " IS NOT NULL";
+  if (sample_step > 1) {
+    sample_query += " AND MOD(rowid, " + std::to_string(sample_step) + ") = 0";
+  }
+  std::vector<TargetMetaInfo> target_metainfos;
+  const auto result_rows = getResultRows(session, sample_query, target_metainfos);
+  std::vector<double> values;
+  while (true) {
+    const auto row = result_rows->getNextRow(false, false);
+    if (row.empty()) {
+      break;
+    }
+    CHECK_EQ(size_t(1), row.size());
+    values.push_back(get_double_value(row.front()));
+  }
+  std::vector<double> histogram;
+  if (values.empty()) {
+    return histogram;
+  }
+  std::sort(values.begin(), values.end());
+  for (size_t i = 0; i <= kHistogramBuckets; ++i) {
+    histogram.push_back(values[i * (values.size() - 1) / kHistogramBuckets]);
+  }
+  return histogram;
+}
+
+// Computes the row, null and approximate distinct counts of the columns of the table in
+// a single query, then a histogram of every numeric and time column from a sample.
+void analyze_table(const Catalog_Namespace::SessionInfo& session,
+                   const TableDescriptor* td) {
+  auto& catalog = session.get_catalog();
+  auto upddelLock = getTableLock<mapd_shared_mutex, mapd_shared_lock>(
+      catalog, td->tableName, LockType::UpdateDeleteLock);
+  const auto row_count = get_physical_row_count(catalog, td);
+  std::vector<const ColumnDescriptor*> analyzed_columns;
+  std::vector<std::string> count_targets{"COUNT(*)"};
+  for (const auto cd :
+       catalog.getAllColumnMetadataForTable(td->tableId, false, false, false)) {
+    const auto& ti = cd->columnType;
+    if (ti.is_array() || ti.is_geometry() ||
+        (ti.is_string() && ti.get_compression() != kENCODING_DICT)) {
+      continue;
+    }
+    analyzed_columns.push_back(cd);
+    count_targets.push_back("COUNT(" + cd->columnName + ")");
+    count_targets.push_back("APPROX_COUNT_DISTINCT(" + cd->columnName + ")");
+  }
+  std::vector<ColumnStatisticsDescriptor> statistics;
+  if (!analyzed_columns.empty()) {
+    const auto count_query = "SELECT " + boost::algorithm::join(count_targets, ", ") +
+                             " FROM " + td->tableName;
+    std::vector<TargetMetaInfo> target_metainfos;
+    const auto result_rows = getResultRows(session, count_query, target_metainfos);
+    const auto row = result_rows->getNextRow(false, false);
+    CHECK_EQ(count_targets.size(), row.size());
+    const auto live_row_count = get_int_value(row[0]);
+    for (size_t i = 0; i < analyzed_columns.size(); ++i) {
+      const auto cd = analyzed_columns[i];
+      ColumnStatisticsDescriptor csd;
+      csd.tableId = td->tableId;
+      csd.columnId = cd->columnId;
+      csd.rowCount = row_count;
+      csd.nullCount = live_row_count - get_int_value(row[2 * i + 1]);
+      csd.distinctCount = get_int_value(row[2 * i + 2]);
+      const auto& ti = cd->columnType;
+      if ((ti.is_number() || ti.is_time()) && csd.nullCount < live_row_count) {
+        csd.histogram = compute_histogram(session, td, cd, row_count);
+      }
+      statistics.push_back(csd);
+    }
+  }
+  catalog.setColumnStatistics(td->tableId, statistics);
+}
+
+}  // namespace
+
+void AnalyzeTableStmt::execute(const Catalog_Namespace::SessionInfo& session) {
+  if (g_cluster) {
+    throw std::runtime_error("Distributed ANALYZE TABLE not supported yet");
+  }
+  auto& catalog = session.get_catalog();
+  const auto td = catalog.getMetadataForTable(table_name_);
+  if (td == nullptr) {
+    throw std::runtime_error("Table " + table_name_ + " does not exist.");
+  }
+  if (td->isView) {
+    throw std::runtime_error(table_name_ + " is a view.  Cannot Analyze.");
+  }
+  check_alter_table_privilege(session, td);
+  analyze_table(session, td);
+}
+
+void AnalyzeTableStmt::analyzeStale(const Catalog_Namespace::SessionInfo& session) {
+  auto& catalog = session.get_catalog();
+  for (const auto table_id : catalog.getAnalyzedTables()) {
+    const auto td = catalog.getMetadataForTable(table_id);
+    if (!td || td->isView) {
+      continue;
+    }
+    const auto row_count = get_physical_row_count(catalog, td);
+    for (const auto cd :
+         catalog.getAllColumnMetadataForTable(table_id, false, false, false)) {
+      const auto csd = catalog.getColumnStatistics(table_id, cd->columnId);
+      if (!csd) {
+        continue;
+      }
+      const auto analyzed_row_count = csd->rowCount;
+      if (std::fabs(static_cast<double>(row_count - analyzed_row_count)) >
+          kStaleStatisticsFraction * std::max(analyzed_row_count, int64_t(1))) {
+        analyze_table(session, td);
+      }
+      break;
+    }
+  }
 }
 
 void CreateDBStmt::execute(const Catalog_Namespace::SessionInfo& session) {
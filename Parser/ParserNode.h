@@ -1054,6 +1054,29 @@ class TruncateTableStmt : public DDLStmt {
   std::unique_ptr<std::string> table;
 };
 
+/*
+ * @type OptimizeTableStmt
+ * @brief OPTIMIZE TABLE statement, rewrites the fragments of the table holding deleted
+ * rows without them
+ */
+class OptimizeTableStmt : public DDLStmt {
+ public:
+  OptimizeTableStmt(std::string* tab, std::list<NameValueAssign*>* o) : table(tab) {
+    if (o) {
+      for (const auto e : *o) {
+        options.emplace_back(e);
+      }
+      delete o;
+    }
+  }
+  const std::string* get_table() const { return table.get(); }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  std::unique_ptr<std::string> table;
+  std::list<std::unique_ptr<NameValueAssign>> options;
+};
+
 class RenameTableStmt : public DDLStmt {
  public:
   RenameTableStmt(std::string* tab, std::string* new_tab_name)
@@ -1444,6 +1467,8 @@ class SelectStmt : public DMLStmt {
   const std::list<std::unique_ptr<OrderSpec>>& get_orderby_clause() const {
     return orderby_clause;
   }
+  int64_t get_limit() const { return limit; }
+  int64_t get_offset() const { return offset; }
   virtual void analyze(const Catalog_Namespace::Catalog& catalog,
                        Analyzer::Query& query) const;
 
@@ -1543,6 +1568,64 @@ class DropViewStmt : public DDLStmt {
   bool if_exists;
 };
 
+/*
+ * @type CreateMaterializedViewStmt
+ * @brief CREATE MATERIALIZED VIEW statement
+ */
+class CreateMaterializedViewStmt : public DDLStmt {
+ public:
+  CreateMaterializedViewStmt(const std::string& view_name,
+                             const std::string& select_query,
+                             const bool if_not_exists)
+      : view_name_(view_name)
+      , select_query_(select_query)
+      , if_not_exists_(if_not_exists) {}
+  const std::string& get_view_name() const { return view_name_; }
+  const std::string& get_select_query() const { return select_query_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string view_name_;
+  const std::string select_query_;
+  const bool if_not_exists_;
+};
+
+/*
+ * @type RefreshMaterializedViewStmt
+ * @brief REFRESH MATERIALIZED VIEW statement
+ */
+class RefreshMaterializedViewStmt : public DDLStmt {
+ public:
+  explicit RefreshMaterializedViewStmt(const std::string& view_name)
+      : view_name_(view_name) {}
+  const std::string& get_view_name() const { return view_name_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+  // Refreshes every materialized view of the database whose source table has grown.
+  static void refreshAll(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string view_name_;
+};
+
+/*
+ * @type AnalyzeTableStmt
+ * @brief ANALYZE TABLE statement
+ */
+class AnalyzeTableStmt : public DDLStmt {
+ public:
+  explicit AnalyzeTableStmt(const std::string& table_name) : table_name_(table_name) {}
+  const std::string& get_table_name() const { return table_name_; }
+  virtual void execute(const Catalog_Namespace::SessionInfo& session);
+
+  // Analyzes again the tables whose row count changed by a large enough fraction since
+  // their statistics were computed.
+  static void analyzeStale(const Catalog_Namespace::SessionInfo& session);
+
+ private:
+  const std::string table_name_;
+};
+
 /*
  * @type CreateDBStmt
  * @brief CREATE DATABASE statement
@@ -30,8 +30,17 @@
 
 using namespace std;
 
-const std::vector<std::string> ParserWrapper::ddl_cmd =
-    {"ALTER", "COPY", "GRANT", "CREATE", "DROP", "REVOKE", "SHOW", "TRUNCATE"};
+const std::vector<std::string> ParserWrapper::ddl_cmd = {"ALTER",
+                                                         "ANALYZE",
+                                                         "COPY",
+                                                         "GRANT",
+                                                         "CREATE",
+                                                         "DROP",
+                                                         "OPTIMIZE",
+                                                         "REFRESH",
+                                                         "REVOKE",
+                                                         "SHOW",
+                                                         "TRUNCATE"};
 
 const std::vector<std::string> ParserWrapper::update_dml_cmd = {
     "INSERT",
@@ -42,6 +51,7 @@ const std::vector<std::string> ParserWrapper::update_dml_cmd = {
 
 const std::string ParserWrapper::explain_str = {"explain"};
 const std::string ParserWrapper::calcite_explain_str = {"explain calcite"};
+const std::string ParserWrapper::explain_analyze_str = {"explain analyze"};
 
 ParserWrapper::ParserWrapper(std::string query_string) {
   if (boost::istarts_with(query_string, calcite_explain_str)) {
@@ -56,6 +66,18 @@ ParserWrapper::ParserWrapper(std::string query_string) {
     }
   }
 
+  if (boost::istarts_with(query_string, explain_analyze_str)) {
+    actual_query = boost::trim_copy(query_string.substr(explain_analyze_str.size()));
+    ParserWrapper inner{actual_query};
+    if (inner.is_ddl || inner.is_update_dml) {
+      is_other_explain = true;
+      return;
+    } else {
+      is_select_explain_analyze = true;
+      return;
+    }
+  }
+
   if (boost::istarts_with(query_string, explain_str)) {
     actual_query = boost::trim_copy(query_string.substr(explain_str.size()));
     ParserWrapper inner{actual_query};
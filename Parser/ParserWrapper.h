@@ -44,6 +44,7 @@ class ParserWrapper {
   virtual ~ParserWrapper();
   bool is_select_explain = false;
   bool is_select_calcite_explain = false;
+  bool is_select_explain_analyze = false;
   bool is_other_explain = false;
   bool is_ddl = false;
   bool is_update_dml = false;
@@ -60,6 +61,7 @@ class ParserWrapper {
   static const std::vector<std::string> update_dml_cmd;
   static const std::string explain_str;
   static const std::string calcite_explain_str;
+  static const std::string explain_analyze_str;
 };
 
 enum class CalciteDMLPathSelection : int {
@@ -22,6 +22,8 @@
 #include "../Shared/sqldefs.h"
 #include "../Shared/sqltypes.h"
 
+#include <unordered_map>
+
 namespace Importer_NS {
 std::vector<uint8_t> compress_coords(std::vector<double>& coords, const SQLTypeInfo& ti);
 }  // namespace Importer_NS
@@ -66,6 +68,9 @@ struct TargetValueConverter {
 
   virtual void convertToColumnarFormat(size_t row, const TargetValue* value) = 0;
 
+  // Called once all the rows are converted, before the data blocks are added.
+  virtual void finalizeDataBlocksForInsertData() {}
+
   virtual void addDataBlocksToInsertData(
       Fragmenter_Namespace::InsertData& insertData) = 0;
 };
@@ -135,6 +140,8 @@ template <typename TARGET_TYPE>
 struct DictionaryValueConverter : public NumericValueConverter<int64_t, TARGET_TYPE> {
   const DictDescriptor* source_Dict_;
   const DictDescriptor* target_dict_;
+  // the ids in the source dictionary, translated to the target one in bulk
+  std::vector<int32_t> source_ids_;
 
   DictionaryValueConverter(Catalog_Namespace::Catalog& cat,
                            const ColumnDescriptor* sourceDescriptor,
@@ -152,20 +159,50 @@ struct DictionaryValueConverter : public NumericValueConverter<int64_t, TARGET_T
         cat.getMetadataForDict(sourceDescriptor->columnType.get_comp_param(), true);
     target_dict_ =
         cat.getMetadataForDict(targetDescriptor->columnType.get_comp_param(), true);
+    source_ids_.resize(num_rows);
   }
 
   virtual ~DictionaryValueConverter() {}
 
+  virtual void allocateColumnarData(size_t num_rows) {
+    NumericValueConverter<int64_t, TARGET_TYPE>::allocateColumnarData(num_rows);
+    source_ids_.resize(num_rows);
+  }
+
   void convertToColumnarFormat(size_t row, const ScalarTargetValue* scalarValue) {
     auto mapd_p = checked_get<int64_t>(row, scalarValue, this->SOURCE_TYPE_ACCESSOR);
     auto val = *mapd_p;
 
     if (this->do_null_check_ && this->null_check_value_ == val) {
-      this->column_data_.get()[row] = this->null_value_;
+      source_ids_[row] = NULL_INT;
     } else {
-      std::string strVal = source_Dict_->stringDict->getString(val);
-      auto newVal = target_dict_->stringDict->getOrAdd(strVal);
-      this->column_data_.get()[row] = (TARGET_TYPE)newVal;
+      source_ids_[row] = static_cast<int32_t>(val);
+    }
+  }
+
+  // Each distinct string is read from the source dictionary once and all of them are
+  // added to the target dictionary in a single call, instead of a locked lookup per row.
+  virtual void finalizeDataBlocksForInsertData() {
+    std::unordered_map<int32_t, size_t> string_idx_by_source_id;
+    std::vector<std::string> strings;
+    for (const auto source_id : source_ids_) {
+      if (source_id != NULL_INT &&
+          string_idx_by_source_id.emplace(source_id, strings.size()).second) {
+        strings.push_back(source_Dict_->stringDict->getString(source_id));
+      }
+    }
+    std::vector<int32_t> target_ids(strings.size());
+    target_dict_->stringDict->getOrAddBulk(strings, target_ids.data());
+    for (size_t row = 0; row < source_ids_.size(); ++row) {
+      const auto source_id = source_ids_[row];
+      if (source_id == NULL_INT) {
+        this->column_data_.get()[row] = this->null_value_;
+        continue;
+      }
+      const auto target_id = target_ids[string_idx_by_source_id[source_id]];
+      this->column_data_.get()[row] = target_id == inline_int_null_value<int32_t>()
+                                          ? this->null_value_
+                                          : (TARGET_TYPE)target_id;
     }
   }
 
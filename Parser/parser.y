@@ -18,6 +18,36 @@
       parseTrees.emplace_back(new CreateViewStmt(view_name, select_query, if_not_exists));                              \
       return 0;                                                                                                         \
     }                                                                                                                   \
+    boost::regex create_materialized_view_expr{                                                                         \
+        R"(CREATE\s+MATERIALIZED\s+VIEW\s+(IF\s+NOT\s+EXISTS\s+)?([A-Za-z_][A-Za-z0-9\$_]*)\s+AS\s+(.*);?)",            \
+        boost::regex::extended | boost::regex::icase};                                                                  \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, create_materialized_view_expr)) {        \
+      const bool if_not_exists = what[1].length() > 0;                                                                  \
+      const auto view_name = what[2].str();                                                                             \
+      const auto select_query = what[3].str();                                                                          \
+      parseTrees.emplace_back(new CreateMaterializedViewStmt(view_name, select_query, if_not_exists));                  \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
+    boost::regex refresh_materialized_view_expr{R"(REFRESH\s+MATERIALIZED\s+VIEW\s+([A-Za-z_][A-Za-z0-9\$_]*)\s*;?)",   \
+                                                boost::regex::extended | boost::regex::icase};                          \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, refresh_materialized_view_expr)) {       \
+      parseTrees.emplace_back(new RefreshMaterializedViewStmt(what[1].str()));                                          \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
+    boost::regex analyze_table_expr{R"(ANALYZE\s+TABLE\s+([A-Za-z_][A-Za-z0-9\$_]*)\s*;?)",                             \
+                                    boost::regex::extended | boost::regex::icase};                                      \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, analyze_table_expr)) {                   \
+      parseTrees.emplace_back(new AnalyzeTableStmt(what[1].str()));                                                     \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
+    boost::regex drop_materialized_view_expr{                                                                           \
+        R"(DROP\s+MATERIALIZED\s+VIEW\s+(IF\s+EXISTS\s+)?([A-Za-z_][A-Za-z0-9\$_]*)\s*;?)",                             \
+        boost::regex::extended | boost::regex::icase};                                                                  \
+    if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, drop_materialized_view_expr)) {          \
+      const bool if_exists = what[1].length() > 0;                                                                      \
+      parseTrees.emplace_back(new DropViewStmt(new std::string(what[2].str()), if_exists));                             \
+      return 0;                                                                                                         \
+    }                                                                                                                   \
     boost::regex create_table_as_expr{R"(CREATE\s+TABLE\s+([A-Za-z_][A-Za-z0-9\$_]*)\s+AS\s+(.*);?)",                   \
                                       boost::regex::extended | boost::regex::icase};                                    \
     if (boost::regex_match(trimmed_input.cbegin(), trimmed_input.cend(), what, create_table_as_expr)) {                 \
@@ -112,7 +142,7 @@ using namespace Parser;
 %token CURSOR DATABASE DATE DATETIME DATE_TRUNC DECIMAL DECLARE DEFAULT DELETE DESC DICTIONARY DISTINCT DOUBLE DROP
 %token ELSE END EXISTS EXPLAIN EXTRACT FETCH FIRST FLOAT FOR FOREIGN FOUND FROM
 %token GEOGRAPHY GEOMETRY GRANT GROUP HAVING IF ILIKE IN INSERT INTEGER INTO
-%token IS LANGUAGE LAST LENGTH LIKE LIMIT LINESTRING MOD MULTIPOLYGON NOW NULLX NUMERIC OF OFFSET ON OPEN OPTION
+%token IS LANGUAGE LAST LENGTH LIKE LIMIT LINESTRING MOD MULTIPOLYGON NOW NULLX NUMERIC OF OFFSET ON OPEN OPTIMIZE OPTION
 %token ORDER PARAMETER POINT POLYGON PRECISION PRIMARY PRIVILEGES PROCEDURE
 %token SMALLINT SOME TABLE TEMPORARY TEXT THEN TIME TIMESTAMP TINYINT TO TRUNCATE UNION
 %token PUBLIC REAL REFERENCES RENAME REVOKE ROLE ROLLBACK SCHEMA SELECT SET SHARD SHARED SHOW
@@ -139,6 +169,7 @@ sql:		/* schema {	$<nodeval>$ = $<nodeval>1; } */
 	| drop_view_statement { $<nodeval>$ = $<nodeval>1; }
 	| drop_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| truncate_table_statement { $<nodeval>$ = $<nodeval>1; }
+	| optimize_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| rename_table_statement { $<nodeval>$ = $<nodeval>1; }
 	| rename_column_statement { $<nodeval>$ = $<nodeval>1; }
 	| add_column_statement { $<nodeval>$ = $<nodeval>1; }
@@ -268,6 +299,12 @@ truncate_table_statement:
 		  $<nodeval>$ = new TruncateTableStmt($<stringval>3);
 		}
 		;
+optimize_table_statement:
+		OPTIMIZE TABLE table opt_with_option_list
+		{
+		  $<nodeval>$ = new OptimizeTableStmt($<stringval>3, reinterpret_cast<std::list<NameValueAssign*>*>($<listval>4));
+		}
+		;
 rename_table_statement:
 		ALTER TABLE table RENAME TO table
 		{
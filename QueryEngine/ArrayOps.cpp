@@ -66,6 +66,14 @@ ARRAY_AT(double)
 
 #undef ARRAY_AT
 
+// ANY and ALL test the elements in blocks without branching, which vectorizes, and
+// only stop between the blocks.
+#define ARRAY_BLOCK 16
+
+DEVICE ALWAYS_INLINE size_t array_block_end(const size_t start, const size_t elem_count) {
+  return start + ARRAY_BLOCK < elem_count ? start + ARRAY_BLOCK : elem_count;
+}
+
 #define ARRAY_ANY(type, needle_type, oper_name, oper)                    \
   extern "C" DEVICE bool array_any_##oper_name##_##type##_##needle_type( \
       int8_t* chunk_iter_,                                               \
@@ -77,9 +85,15 @@ ARRAY_AT(double)
     bool is_end;                                                         \
     ChunkIter_get_nth(chunk_iter, row_pos, &ad, &is_end);                \
     const size_t elem_count = ad.length / sizeof(type);                  \
-    for (size_t i = 0; i < elem_count; ++i) {                            \
-      const needle_type val = reinterpret_cast<type*>(ad.pointer)[i];    \
-      if (val != null_val && val oper needle) {                          \
+    const type* vals = reinterpret_cast<const type*>(ad.pointer);        \
+    for (size_t start = 0; start < elem_count; start += ARRAY_BLOCK) {   \
+      const size_t end = array_block_end(start, elem_count);             \
+      bool any = false;                                                  \
+      for (size_t i = start; i < end; ++i) {                             \
+        const needle_type val = vals[i];                                 \
+        any |= (val != null_val) & (val oper needle);                    \
+      }                                                                  \
+      if (any) {                                                         \
         return true;                                                     \
       }                                                                  \
     }                                                                    \
@@ -97,9 +111,15 @@ ARRAY_AT(double)
     bool is_end;                                                         \
     ChunkIter_get_nth(chunk_iter, row_pos, &ad, &is_end);                \
     const size_t elem_count = ad.length / sizeof(type);                  \
-    for (size_t i = 0; i < elem_count; ++i) {                            \
-      const needle_type val = reinterpret_cast<type*>(ad.pointer)[i];    \
-      if (!(val != null_val && val oper needle)) {                       \
+    const type* vals = reinterpret_cast<const type*>(ad.pointer);        \
+    for (size_t start = 0; start < elem_count; start += ARRAY_BLOCK) {   \
+      const size_t end = array_block_end(start, elem_count);             \
+      bool all = true;                                                   \
+      for (size_t i = start; i < end; ++i) {                             \
+        const needle_type val = vals[i];                                 \
+        all &= (val != null_val) & (val oper needle);                    \
+      }                                                                  \
+      if (!all) {                                                        \
         return false;                                                    \
       }                                                                  \
     }                                                                    \
@@ -165,6 +185,7 @@ ARRAY_ALL_ANY_ALL_TYPES(ge, >=, double)
 #undef ARRAY_ALL_ANY_ALL_TYPES
 #undef ARRAY_ALL
 #undef ARRAY_ANY
+#undef ARRAY_BLOCK
 
 #define ARRAY_AT_CHECKED(type)                                                    \
   extern "C" DEVICE type array_at_##type##_checked(int8_t* chunk_iter_,           \
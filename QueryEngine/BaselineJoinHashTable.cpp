@@ -17,13 +17,14 @@
 #include "BaselineJoinHashTable.h"
 #include "Execute.h"
 #include "ExpressionRewrite.h"
+#include "QueryMemoryAccount.h"
+#include "TableMetadataCache.h"
 
 #include <future>
 
-std::vector<std::pair<BaselineJoinHashTable::HashTableCacheKey,
-                      BaselineJoinHashTable::HashTableCacheValue>>
-    BaselineJoinHashTable::hash_table_cache_;
-std::mutex BaselineJoinHashTable::hash_table_cache_mutex_;
+JoinHashTableCache<BaselineJoinHashTable::HashTableCacheKey,
+                   BaselineJoinHashTable::HashTableCacheValue>
+    BaselineJoinHashTable::hash_table_cache_(g_join_hash_table_cache_max_bytes);
 
 namespace {
 
@@ -42,6 +43,33 @@ size_t get_entries_per_device(const size_t total_entries,
   return entries_per_device;
 }
 
+// The key components take 4 bytes if the values of all the inner columns fit, whatever
+// their type. The outer values which don't fit, the nulls among them, can't match.
+size_t get_key_component_width(const std::shared_ptr<Analyzer::BinOper> condition,
+                               const std::vector<InputTableInfo>& query_infos,
+                               const Executor* executor) {
+  const auto inner_outer_pairs = normalize_column_pairs(
+      condition.get(), *executor->getCatalog(), executor->getTemporaryTables());
+  for (const auto& inner_outer_pair : inner_outer_pairs) {
+    const auto inner_col = inner_outer_pair.first;
+    const auto& inner_col_ti = inner_col->get_type_info();
+    if (inner_col_ti.get_logical_size() > 4) {
+      CHECK_EQ(size_t(8), inner_col_ti.get_logical_size());
+      // the nulls are in the table for a bitwise equality
+      if (condition->get_optype() == kBW_EQ) {
+        return 8;
+      }
+      const auto col_range = getExpressionRange(inner_col, query_infos, executor);
+      if (col_range.getType() != ExpressionRangeType::Integer ||
+          col_range.getIntMin() <= std::numeric_limits<int32_t>::min() ||
+          col_range.getIntMax() >= EMPTY_KEY_32 - 1) {
+        return 8;
+      }
+    }
+  }
+  return 4;
+}
+
 }  // namespace
 
 std::shared_ptr<BaselineJoinHashTable> BaselineJoinHashTable::getInstance(
@@ -81,6 +109,8 @@ std::shared_ptr<BaselineJoinHashTable> BaselineJoinHashTable::getInstance(
       getInnerTableId(condition.get(), executor));
   try {
     join_hash_table->reify(device_count);
+  } catch (const QueryInterrupted&) {
+    throw;
   } catch (const std::exception& e) {
     throw HashJoinFail(std::string("Could not build a 1-to-1 correspondence for columns "
                                    "involved in equijoin | ") +
@@ -104,7 +134,8 @@ BaselineJoinHashTable::BaselineJoinHashTable(
     , executor_(executor)
     , ra_exe_unit_(ra_exe_unit)
     , column_cache_(column_cache)
-    , layout_(JoinHashTableInterface::HashType::OneToOne) {}
+    , layout_(JoinHashTableInterface::HashType::OneToOne)
+    , key_component_width_(get_key_component_width(condition, query_infos, executor)) {}
 
 int64_t BaselineJoinHashTable::getJoinHashBuffer(const ExecutorDeviceType device_type,
                                                  const int device_id) noexcept {
@@ -190,6 +221,13 @@ CompositeKeyInfo get_composite_key_info(const std::vector<InnerOuter>& inner_out
       sd_inner_proxy_per_key.emplace_back();
       sd_outer_proxy_per_key.emplace_back();
     }
+    // Rows updated in place keep the element count of the cache key the same.
+    if (inner_col->get_table_id() > 0) {
+      for (const auto generation : TableMetadataCache::getGenerations(
+               *executor->getCatalog(), inner_col->get_table_id())) {
+        cache_key_chunks_for_column.push_back(static_cast<int>(generation));
+      }
+    }
     cache_key_chunks.push_back(cache_key_chunks_for_column);
   }
   return {sd_inner_proxy_per_key, sd_outer_proxy_per_key, cache_key_chunks};
@@ -210,6 +248,8 @@ void BaselineJoinHashTable::reify(const int device_count) {
                                             : JoinHashTableInterface::HashType::OneToOne;
   try {
     reifyWithLayout(device_count, layout);
+  } catch (const QueryInterrupted&) {
+    throw;
   } catch (const std::exception& e) {
     VLOG(1) << "Caught Baseline Hash Join Exception, attempting to build 1:Many table: "
             << e.what();
@@ -261,6 +301,7 @@ void BaselineJoinHashTable::reifyWithLayout(
         shard_count
             ? only_shards_for_device(query_info.fragments, device_id, device_count)
             : query_info.fragments;
+    executor_->checkInterrupted();
     const auto columns_for_device = fetchColumnsForDevice(fragments, device_id);
     switch (columns_for_device.err) {
       case ERR_FAILED_TO_FETCH_COLUMN:
@@ -580,25 +621,6 @@ size_t get_baseline_shard_count(const Analyzer::BinOper* condition,
   return 0;
 }
 
-namespace {
-
-size_t get_key_component_width(const std::shared_ptr<Analyzer::BinOper> condition,
-                               const Executor* executor) {
-  const auto inner_outer_pairs = normalize_column_pairs(
-      condition.get(), *executor->getCatalog(), executor->getTemporaryTables());
-  for (const auto& inner_outer_pair : inner_outer_pairs) {
-    const auto inner_col = inner_outer_pair.first;
-    const auto& inner_col_ti = inner_col->get_type_info();
-    if (inner_col_ti.get_logical_size() > 4) {
-      CHECK_EQ(size_t(8), inner_col_ti.get_logical_size());
-      return 8;
-    }
-  }
-  return 4;
-}
-
-}  // namespace
-
 int BaselineJoinHashTable::initHashTableOnCpu(
     const std::vector<JoinColumn>& join_columns,
     const std::vector<JoinColumnTypeInfo>& join_column_types,
@@ -614,7 +636,7 @@ int BaselineJoinHashTable::initHashTableOnCpu(
   if (cpu_hash_table_buff_) {
     return 0;
   }
-  const auto key_component_width = get_key_component_width(condition_, executor_);
+  const auto key_component_width = key_component_width_;
   const auto entry_size =
       (inner_outer_pairs.size() +
        (layout == JoinHashTableInterface::HashType::OneToOne ? 1 : 0)) *
@@ -623,8 +645,10 @@ int BaselineJoinHashTable::initHashTableOnCpu(
       layout == JoinHashTableInterface::HashType::OneToMany
           ? 2 * entry_count_ + join_columns.front().num_elems
           : 0;
-  cpu_hash_table_buff_.reset(new std::vector<int8_t>(
-      entry_size * entry_count_ + one_to_many_hash_entries * sizeof(int32_t)));
+  const auto hash_table_bytes =
+      entry_size * entry_count_ + one_to_many_hash_entries * sizeof(int32_t);
+  QueryMemoryAccount::charge(ExecutorDeviceType::CPU, hash_table_bytes);
+  cpu_hash_table_buff_.reset(new std::vector<int8_t>(hash_table_bytes));
   const auto key_component_count = inner_outer_pairs.size();
   int thread_count = cpu_threads();
   std::vector<std::future<void>> init_cpu_buff_threads;
@@ -912,7 +936,7 @@ int BaselineJoinHashTable::initHashTableForDevice(
   const auto catalog = executor_->getCatalog();
   const auto inner_outer_pairs =
       normalize_column_pairs(condition_.get(), *catalog, executor_->getTemporaryTables());
-  const auto key_component_width = get_key_component_width(condition_, executor_);
+  const auto key_component_width = key_component_width_;
   const auto key_component_count = inner_outer_pairs.size();
   int err = 0;
 #ifdef HAVE_CUDA
@@ -985,7 +1009,7 @@ llvm::Value* BaselineJoinHashTable::codegenSlotIsValid(const CompilationOptions&
 
 llvm::Value* BaselineJoinHashTable::codegenSlot(const CompilationOptions& co,
                                                 const size_t index) {
-  const auto key_component_width = get_key_component_width(condition_, executor_);
+  const auto key_component_width = key_component_width_;
   CHECK(key_component_width == 4 || key_component_width == 8);
   const auto inner_outer_pairs = normalize_column_pairs(
       condition_.get(), *executor_->getCatalog(), executor_->getTemporaryTables());
@@ -1008,7 +1032,7 @@ llvm::Value* BaselineJoinHashTable::codegenSlot(const CompilationOptions& co,
 HashJoinMatchingSet BaselineJoinHashTable::codegenMatchingSet(
     const CompilationOptions& co,
     const size_t index) {
-  const auto key_component_width = get_key_component_width(condition_, executor_);
+  const auto key_component_width = key_component_width_;
   CHECK(key_component_width == 4 || key_component_width == 8);
   const auto inner_outer_pairs = normalize_column_pairs(
       condition_.get(), *executor_->getCatalog(), executor_->getTemporaryTables());
@@ -1050,7 +1074,7 @@ HashJoinMatchingSet BaselineJoinHashTable::codegenMatchingSet(
 }
 
 llvm::Value* BaselineJoinHashTable::codegenKey(const CompilationOptions& co) {
-  const auto key_component_width = get_key_component_width(condition_, executor_);
+  const auto key_component_width = key_component_width_;
   CHECK(key_component_width == 4 || key_component_width == 8);
   const auto inner_outer_pairs = normalize_column_pairs(
       condition_.get(), *executor_->getCatalog(), executor_->getTemporaryTables());
@@ -1074,8 +1098,18 @@ llvm::Value* BaselineJoinHashTable::codegenKey(const CompilationOptions& co) {
     const auto outer_col = inner_outer_pair.second;
     const auto col_lvs = executor_->codegen(outer_col, true, co);
     CHECK_EQ(size_t(1), col_lvs.size());
-    const auto col_lv = LL_BUILDER.CreateSExt(
-        col_lvs.front(), get_int_type(key_component_width * 8, LL_CONTEXT));
+    auto col_lv = col_lvs.front();
+    const auto key_component_ty = get_int_type(key_component_width * 8, LL_CONTEXT);
+    if (col_lv->getType()->getIntegerBitWidth() > key_component_width * 8) {
+      // narrowed, the values out of the range of the inner keys can't match
+      const auto narrow_col_lv = LL_BUILDER.CreateTrunc(col_lv, key_component_ty);
+      const auto fits_lv = LL_BUILDER.CreateICmpEQ(
+          LL_BUILDER.CreateSExt(narrow_col_lv, col_lv->getType()), col_lv);
+      col_lv = LL_BUILDER.CreateSelect(
+          fits_lv, narrow_col_lv, LL_INT(static_cast<int32_t>(EMPTY_KEY_32 - 1)));
+    } else {
+      col_lv = LL_BUILDER.CreateSExt(col_lv, key_component_ty);
+    }
     LL_BUILDER.CreateStore(col_lv, key_comp_dest_lv);
   }
   return key_buff_lv;
@@ -1181,37 +1215,24 @@ void BaselineJoinHashTable::checkHashJoinReplicationConstraint(const int table_i
 }
 
 void BaselineJoinHashTable::initHashTableOnCpuFromCache(const HashTableCacheKey& key) {
-  std::lock_guard<std::mutex> hash_table_cache_lock(hash_table_cache_mutex_);
-  for (const auto& kv : hash_table_cache_) {
-    if (kv.first == key) {
-      cpu_hash_table_buff_ = kv.second.buffer;
-      layout_ = kv.second.type;
-      entry_count_ = kv.second.entry_count;
-      break;
-    }
+  const auto cached_table = hash_table_cache_.get(key);
+  if (cached_table) {
+    cpu_hash_table_buff_ = cached_table->buffer;
+    layout_ = cached_table->type;
+    entry_count_ = cached_table->entry_count;
   }
 }
 
 void BaselineJoinHashTable::putHashTableOnCpuToCache(const HashTableCacheKey& key) {
-  std::lock_guard<std::mutex> hash_table_cache_lock(hash_table_cache_mutex_);
-  for (const auto& kv : hash_table_cache_) {
-    if (std::get<0>(kv) == key) {
-      return;
-    }
-  }
-  hash_table_cache_.emplace_back(
-      key, HashTableCacheValue{cpu_hash_table_buff_, layout_, entry_count_});
+  hash_table_cache_.put(key,
+                        HashTableCacheValue{cpu_hash_table_buff_, layout_, entry_count_},
+                        cpu_hash_table_buff_->size());
 }
 
 ssize_t BaselineJoinHashTable::getApproximateTupleCountFromCache(
     const HashTableCacheKey& key) const {
-  std::lock_guard<std::mutex> hash_table_cache_lock(hash_table_cache_mutex_);
-  for (const auto& kv : hash_table_cache_) {
-    if (kv.first == key) {
-      return kv.second.entry_count;
-    }
-  }
-  return -1;
+  const auto cached_table = hash_table_cache_.get(key);
+  return cached_table ? static_cast<ssize_t>(cached_table->entry_count) : -1;
 }
 
 bool BaselineJoinHashTable::isBitwiseEq() const {
@@ -21,6 +21,7 @@
 #include "ColumnarResults.h"
 #include "HashJoinRuntime.h"
 #include "InputMetadata.h"
+#include "JoinHashTableCache.h"
 #include "JoinHashTableInterface.h"
 #include "ResultRows.h"
 
@@ -69,12 +70,11 @@ class BaselineJoinHashTable : public JoinHashTableInterface {
   JoinHashTableInterface::HashType getHashType() const noexcept override;
 
   static auto yieldCacheInvalidator() -> std::function<void()> {
-    return []() -> void {
-      std::lock_guard<std::mutex> guard(hash_table_cache_mutex_);
-      hash_table_cache_.clear();
-    };
+    return []() -> void { hash_table_cache_.clear(); };
   }
 
+  static JoinHashTableCacheStats getCacheStats() { return hash_table_cache_.getStats(); }
+
   virtual ~BaselineJoinHashTable() {}
 
  private:
@@ -186,6 +186,8 @@ class BaselineJoinHashTable : public JoinHashTableInterface {
   std::mutex linearized_multifrag_column_mutex_;
   RowSetMemoryOwner linearized_multifrag_column_owner_;
   JoinHashTableInterface::HashType layout_;
+  // 4 or 8 bytes, see get_key_component_width
+  const size_t key_component_width_;
 
   struct HashTableCacheValue {
     const std::shared_ptr<std::vector<int8_t>> buffer;
@@ -193,8 +195,7 @@ class BaselineJoinHashTable : public JoinHashTableInterface {
     const size_t entry_count;
   };
 
-  static std::vector<std::pair<HashTableCacheKey, HashTableCacheValue>> hash_table_cache_;
-  static std::mutex hash_table_cache_mutex_;
+  static JoinHashTableCache<HashTableCacheKey, HashTableCacheValue> hash_table_cache_;
 
   static const int ERR_FAILED_TO_FETCH_COLUMN{-3};
   static const int ERR_FAILED_TO_JOIN_ON_VIRTUAL_COLUMN{-4};
@@ -33,9 +33,17 @@ SQLTypeInfo get_agg_type(const SQLAgg agg_kind, const Analyzer::Expr* arg_expr)
       return arg_expr->get_type_info().is_integer() ? SQLTypeInfo(kBIGINT, false)
                                                     : arg_expr->get_type_info();
     case kAVG:
+    case kAPPROX_QUANTILE:
       return SQLTypeInfo(kDOUBLE, false);
     case kAPPROX_COUNT_DISTINCT:
+    case kAPPROX_COUNT_DISTINCT_UNION:
       return SQLTypeInfo(kBIGINT, false);
+    case kAPPROX_COUNT_DISTINCT_SKETCH: {
+      // the HyperLogLog registers, one byte each
+      SQLTypeInfo sketch_ti(kARRAY, false);
+      sketch_ti.set_subtype(kTINYINT);
+      return sketch_ti;
+    }
     case kSAMPLE:
       return arg_expr->get_type_info();
     default:
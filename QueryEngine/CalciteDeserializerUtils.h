@@ -108,12 +108,65 @@ inline SQLAgg to_agg_kind(const std::string& agg_name) {
   if (agg_name == std::string("APPROX_COUNT_DISTINCT")) {
     return kAPPROX_COUNT_DISTINCT;
   }
+  if (agg_name == std::string("APPROX_COUNT_DISTINCT_SKETCH")) {
+    return kAPPROX_COUNT_DISTINCT_SKETCH;
+  }
+  if (agg_name == std::string("APPROX_COUNT_DISTINCT_UNION")) {
+    return kAPPROX_COUNT_DISTINCT_UNION;
+  }
+  if (agg_name == std::string("APPROX_PERCENTILE") ||
+      agg_name == std::string("APPROX_MEDIAN")) {
+    return kAPPROX_QUANTILE;
+  }
   if (agg_name == std::string("SAMPLE") || agg_name == std::string("LAST_SAMPLE")) {
     return kSAMPLE;
   }
   throw std::runtime_error("Aggregate function " + agg_name + " not supported");
 }
 
+inline SqlWindowFunctionKind to_window_function_kind(const std::string& name) {
+  if (name == std::string("ROW_NUMBER")) {
+    return SqlWindowFunctionKind::ROW_NUMBER;
+  }
+  if (name == std::string("RANK")) {
+    return SqlWindowFunctionKind::RANK;
+  }
+  if (name == std::string("DENSE_RANK")) {
+    return SqlWindowFunctionKind::DENSE_RANK;
+  }
+  if (name == std::string("LAG")) {
+    return SqlWindowFunctionKind::LAG;
+  }
+  if (name == std::string("LEAD")) {
+    return SqlWindowFunctionKind::LEAD;
+  }
+  if (name == std::string("FIRST_VALUE")) {
+    return SqlWindowFunctionKind::FIRST_VALUE;
+  }
+  if (name == std::string("LAST_VALUE")) {
+    return SqlWindowFunctionKind::LAST_VALUE;
+  }
+  if (name == std::string("AVG")) {
+    return SqlWindowFunctionKind::AVG;
+  }
+  if (name == std::string("MIN")) {
+    return SqlWindowFunctionKind::MIN;
+  }
+  if (name == std::string("MAX")) {
+    return SqlWindowFunctionKind::MAX;
+  }
+  if (name == std::string("SUM")) {
+    return SqlWindowFunctionKind::SUM;
+  }
+  if (name == std::string("COUNT")) {
+    return SqlWindowFunctionKind::COUNT;
+  }
+  if (name == std::string("$SUM0")) {
+    return SqlWindowFunctionKind::SUM_INTERNAL;
+  }
+  throw std::runtime_error("Window function " + name + " not supported");
+}
+
 inline SQLTypes to_sql_type(const std::string& type_name) {
   if (type_name == std::string("BIGINT")) {
     return kBIGINT;
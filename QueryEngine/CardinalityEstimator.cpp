@@ -17,6 +17,8 @@
 #include "CardinalityEstimator.h"
 #include "RelAlgExecutor.h"
 
+#include <limits>
+
 size_t ResultSet::getNDVEstimator() const {
   CHECK(dynamic_cast<const Analyzer::NDVEstimator*>(estimator_.get()));
   CHECK(host_estimator_buffer_);
@@ -31,10 +33,51 @@ size_t ResultSet::getNDVEstimator() const {
   return -static_cast<double>(total_bits) * log(ratio);
 }
 
+namespace {
+
+// Upper bound of the number of groups from the statistics computed by ANALYZE TABLE.
+// Zero unless every grouping expression is a column with statistics which are still
+// current, since the groups could otherwise outnumber the buffer sized after them.
+size_t get_analyzed_group_count(const RelAlgExecutionUnit& ra_exe_unit,
+                                const std::vector<InputTableInfo>& table_infos,
+                                const Catalog_Namespace::Catalog& cat) {
+  size_t group_count{1};
+  for (const auto& groupby_expr : ra_exe_unit.groupby_exprs) {
+    const auto col_var = dynamic_cast<const Analyzer::ColumnVar*>(groupby_expr.get());
+    if (!col_var || col_var->get_table_id() < 0) {
+      return 0;
+    }
+    const auto csd = cat.getColumnStatistics(col_var->get_table_id(),
+                                             col_var->get_column_id());
+    const auto rte_idx = static_cast<size_t>(col_var->get_rte_idx());
+    CHECK_LT(rte_idx, table_infos.size());
+    if (!csd || table_infos[rte_idx].info.getNumTuples() >
+                    static_cast<size_t>(std::max(csd->rowCount, int64_t(0)))) {
+      return 0;
+    }
+    // nulls are a group of their own
+    const auto column_groups =
+        std::max(static_cast<size_t>(csd->distinctCount) + (csd->nullCount ? 1 : 0),
+                 size_t(1));
+    if (group_count > std::numeric_limits<size_t>::max() / column_groups) {
+      return 0;
+    }
+    group_count *= column_groups;
+  }
+  return group_count;
+}
+
+}  // namespace
+
 size_t RelAlgExecutor::getNDVEstimation(const WorkUnit& work_unit,
                                         const bool is_agg,
                                         const CompilationOptions& co,
                                         const ExecutionOptions& eo) {
+  const auto analyzed_group_count = get_analyzed_group_count(
+      work_unit.exe_unit, get_table_infos(work_unit.exe_unit, executor_), cat_);
+  if (analyzed_group_count) {
+    return analyzed_group_count;
+  }
   const auto estimator_exe_unit = create_ndv_execution_unit(work_unit.exe_unit);
   int32_t error_code{0};
   size_t one{1};
@@ -41,7 +41,15 @@ std::vector<llvm::Value*> Executor::codegen(const Analyzer::CaseExpr* case_expr,
   CHECK(case_llvm_type);
   const auto& else_ti = case_expr->get_else_expr()->get_type_info();
   CHECK_EQ(else_ti.get_type(), case_ti.get_type());
-  llvm::Value* case_val = codegenCase(case_expr, case_llvm_type, is_real_str, co);
+  llvm::Value* case_val{nullptr};
+  if (!is_real_str && !case_ti.is_fp()) {
+    case_val = codegenCaseLookup(case_expr, co);
+  }
+  if (case_val) {
+    case_val = castToTypeIn(case_val, case_llvm_type->getScalarSizeInBits());
+  } else {
+    case_val = codegenCase(case_expr, case_llvm_type, is_real_str, co);
+  }
   std::vector<llvm::Value*> ret_vals{case_val};
   if (is_real_str) {
     ret_vals.push_back(cgen_state_->emitCall("extract_str_ptr", {case_val}));
@@ -113,3 +121,143 @@ llvm::Value* Executor::codegenCase(const Analyzer::CaseExpr* case_expr,
   then_phi->addIncoming(else_lv, else_bb);
   return then_phi;
 }
+
+namespace {
+
+// The column compared with constants by the condition of a branch, and the constants.
+const Analyzer::ColumnVar* get_case_key(
+    const Analyzer::Expr* when_expr,
+    std::vector<const Analyzer::Constant*>& key_constants) {
+  if (const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(when_expr)) {
+    if (bin_oper->get_optype() != kEQ || bin_oper->get_qualifier() != kONE) {
+      return nullptr;
+    }
+    auto key = dynamic_cast<const Analyzer::ColumnVar*>(bin_oper->get_left_operand());
+    auto constant = dynamic_cast<const Analyzer::Constant*>(
+        extract_cast_arg(bin_oper->get_right_operand()));
+    if (!key || !constant) {
+      key = dynamic_cast<const Analyzer::ColumnVar*>(bin_oper->get_right_operand());
+      constant = dynamic_cast<const Analyzer::Constant*>(
+          extract_cast_arg(bin_oper->get_left_operand()));
+    }
+    if (!key || !constant) {
+      return nullptr;
+    }
+    key_constants.push_back(constant);
+    return key;
+  }
+  if (const auto in_values = dynamic_cast<const Analyzer::InValues*>(when_expr)) {
+    const auto key = dynamic_cast<const Analyzer::ColumnVar*>(in_values->get_arg());
+    if (!key) {
+      return nullptr;
+    }
+    for (const auto& value : in_values->get_value_list()) {
+      const auto constant =
+          dynamic_cast<const Analyzer::Constant*>(extract_cast_arg(value.get()));
+      if (!constant) {
+        return nullptr;
+      }
+      key_constants.push_back(constant);
+    }
+    return key;
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+llvm::Value* Executor::codegenCaseLookup(const Analyzer::CaseExpr* case_expr,
+                                         const CompilationOptions& co) {
+  const auto& expr_pair_list = case_expr->get_expr_pair_list();
+  // Fewer branches are as fast to test as the table is to read. The table is a hoisted
+  // literal, like the IN bitmaps.
+  const size_t min_branch_count{4};
+  if (!co.hoist_literals_ || expr_pair_list.size() < min_branch_count) {
+    return nullptr;
+  }
+  const auto& case_ti = case_expr->get_type_info();
+  if (!(case_ti.is_integer() || case_ti.is_decimal() || case_ti.is_time() ||
+        case_ti.is_boolean())) {
+    return nullptr;
+  }
+  const auto get_result = [this, &case_ti](const Analyzer::Expr* expr, int64_t& result) {
+    const auto constant = dynamic_cast<const Analyzer::Constant*>(expr);
+    if (!constant) {
+      return false;
+    }
+    const auto& ti = constant->get_type_info();
+    if (ti.get_type() != case_ti.get_type() || ti.get_scale() != case_ti.get_scale() ||
+        ti.get_dimension() != case_ti.get_dimension()) {
+      return false;
+    }
+    if (constant->get_is_null()) {
+      result = inline_int_null_val(case_ti);
+    } else if (case_ti.is_boolean()) {
+      result = constant->get_constval().boolval;
+    } else {
+      result = codegenIntConst(constant)->getSExtValue();
+    }
+    return true;
+  };
+  int64_t else_val{0};
+  if (!get_result(case_expr->get_else_expr(), else_val)) {
+    return nullptr;
+  }
+  const Analyzer::ColumnVar* key{nullptr};
+  std::vector<std::pair<int64_t, int64_t>> keys_results;
+  for (const auto& expr_pair : expr_pair_list) {
+    std::vector<const Analyzer::Constant*> key_constants;
+    const auto branch_key = get_case_key(expr_pair.first.get(), key_constants);
+    if (!branch_key || (key && !(*branch_key == *key))) {
+      return nullptr;
+    }
+    key = branch_key;
+    int64_t result{0};
+    if (!get_result(expr_pair.second.get(), result)) {
+      return nullptr;
+    }
+    const auto& key_ti = key->get_type_info();
+    const bool is_dict_key =
+        key_ti.is_string() && key_ti.get_compression() == kENCODING_DICT;
+    if (!key_ti.is_integer() && !is_dict_key) {
+      return nullptr;
+    }
+    for (const auto constant : key_constants) {
+      // A null key never matches.
+      if (constant->get_is_null()) {
+        continue;
+      }
+      if (is_dict_key) {
+        if (!constant->get_type_info().is_string()) {
+          return nullptr;
+        }
+        CHECK(constant->get_constval().stringval);
+        const auto string_id =
+            getStringDictionaryProxy(key_ti.get_comp_param(), row_set_mem_owner_, true)
+                ->getIdOfString(*constant->get_constval().stringval);
+        if (string_id != StringDictionary::INVALID_STR_ID) {
+          keys_results.emplace_back(string_id, result);
+        }
+        continue;
+      }
+      if (constant->get_type_info().get_type() != key_ti.get_type()) {
+        return nullptr;
+      }
+      keys_results.emplace_back(codegenIntConst(constant)->getSExtValue(), result);
+    }
+  }
+  if (keys_results.empty() || !CaseLookupTable::isDenseEnough(keys_results)) {
+    return nullptr;
+  }
+  const auto key_lvs = codegen(key, true, co);
+  CHECK_EQ(size_t(1), key_lvs.size());
+  auto case_lookup_table = boost::make_unique<const CaseLookupTable>(
+      keys_results,
+      else_val,
+      co.device_type_ == ExecutorDeviceType::GPU ? Data_Namespace::GPU_LEVEL
+                                                 : Data_Namespace::CPU_LEVEL,
+      deviceCount(co.device_type_),
+      &catalog_->get_dataMgr());
+  return cgen_state_->addCaseLookupTable(std::move(case_lookup_table))
+      ->codegen(key_lvs.front(), this);
+}
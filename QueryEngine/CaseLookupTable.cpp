@@ -0,0 +1,133 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CaseLookupTable.h"
+#include "Execute.h"
+#ifdef HAVE_CUDA
+#include "GpuMemUtils.h"
+#endif  // HAVE_CUDA
+#include "../Parser/ParserNode.h"
+#include "../Shared/checked_alloc.h"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <limits>
+
+CaseLookupTable::CaseLookupTable(
+    const std::vector<std::pair<int64_t, int64_t>>& keys_results,
+    const int64_t else_val,
+    const Data_Namespace::MemoryLevel memory_level,
+    const int device_count,
+    Data_Namespace::DataMgr* data_mgr)
+    : data_mgr_(data_mgr)
+    , min_key_(std::numeric_limits<int64_t>::max())
+    , max_key_(std::numeric_limits<int64_t>::min())
+    , else_val_(else_val)
+    , memory_level_(memory_level)
+    , device_count_(device_count) {
+#ifdef HAVE_CUDA
+  CHECK(memory_level_ == Data_Namespace::CPU_LEVEL ||
+        memory_level_ == Data_Namespace::GPU_LEVEL);
+#else
+  CHECK_EQ(Data_Namespace::CPU_LEVEL, memory_level_);
+#endif  // HAVE_CUDA
+  CHECK(!keys_results.empty());
+  for (const auto& key_result : keys_results) {
+    min_key_ = std::min(min_key_, key_result.first);
+    max_key_ = std::max(max_key_, key_result.first);
+  }
+  const size_t entry_count = max_key_ - min_key_ + 1;
+  const auto table_sz_bytes = entry_count * sizeof(int64_t);
+  auto cpu_table = static_cast<int8_t*>(checked_malloc(table_sz_bytes));
+  auto entries = reinterpret_cast<int64_t*>(cpu_table);
+  std::fill(entries, entries + entry_count, else_val);
+  // Backwards, the first branch of a key overwrites the later ones.
+  for (auto it = keys_results.rbegin(); it != keys_results.rend(); ++it) {
+    entries[it->first - min_key_] = it->second;
+  }
+#ifdef HAVE_CUDA
+  if (memory_level_ == Data_Namespace::GPU_LEVEL) {
+    for (int device_id = 0; device_id < device_count_; ++device_id) {
+      auto gpu_buffer = alloc_gpu_abstract_buffer(data_mgr, table_sz_bytes, device_id);
+      gpu_buffers_.push_back(gpu_buffer);
+      auto gpu_table = reinterpret_cast<CUdeviceptr>(gpu_buffer->getMemoryPtr());
+      copy_to_gpu(data_mgr, gpu_table, cpu_table, table_sz_bytes, device_id);
+      tables_.push_back(reinterpret_cast<int8_t*>(gpu_table));
+    }
+    free(cpu_table);
+  } else {
+    tables_.push_back(cpu_table);
+  }
+#else
+  CHECK_EQ(1, device_count_);
+  tables_.push_back(cpu_table);
+#endif  // HAVE_CUDA
+}
+
+CaseLookupTable::~CaseLookupTable() {
+  if (memory_level_ == Data_Namespace::CPU_LEVEL) {
+    CHECK_EQ(size_t(1), tables_.size());
+    free(tables_.front());
+  }
+#ifdef HAVE_CUDA
+  for (auto gpu_buffer : gpu_buffers_) {
+    free_gpu_abstract_buffer(data_mgr_, gpu_buffer);
+  }
+#endif  // HAVE_CUDA
+}
+
+llvm::Value* CaseLookupTable::codegen(llvm::Value* key, Executor* executor) const {
+  CHECK(!tables_.empty());
+  std::vector<std::shared_ptr<const Analyzer::Constant>> constants_owned;
+  std::vector<const Analyzer::Constant*> constants;
+  for (const auto table : tables_) {
+    const int64_t table_handle = reinterpret_cast<int64_t>(table);
+    const auto table_handle_literal = std::dynamic_pointer_cast<Analyzer::Constant>(
+        Parser::IntLiteral::analyzeValue(table_handle));
+    CHECK(table_handle_literal);
+    CHECK_EQ(kENCODING_NONE, table_handle_literal->get_type_info().get_compression());
+    constants_owned.push_back(table_handle_literal);
+    constants.push_back(table_handle_literal.get());
+  }
+  const auto table_handle_lvs =
+      executor->codegenHoistedConstants(constants, kENCODING_NONE, 0);
+  CHECK_EQ(size_t(1), table_handle_lvs.size());
+  // The null key is below the range: the null of a type is its smallest value.
+  return executor->cgen_state_->emitCall(
+      "case_lookup",
+      {executor->castToTypeIn(table_handle_lvs.front(), 64),
+       executor->castToTypeIn(key, 64),
+       executor->codegenHoistedBigint(min_key_, tables_.size()),
+       executor->codegenHoistedBigint(max_key_, tables_.size()),
+       executor->codegenHoistedBigint(else_val_, tables_.size())});
+}
+
+bool CaseLookupTable::isDenseEnough(
+    const std::vector<std::pair<int64_t, int64_t>>& keys_results) {
+  if (keys_results.empty()) {
+    return false;
+  }
+  auto min_key = std::numeric_limits<int64_t>::max();
+  auto max_key = std::numeric_limits<int64_t>::min();
+  for (const auto& key_result : keys_results) {
+    min_key = std::min(min_key, key_result.first);
+    max_key = std::max(max_key, key_result.first);
+  }
+  // Up to 512 KB, or 64 bytes per branch beyond that.
+  const long double max_entry_count =
+      std::max<size_t>(size_t(1) << 16, 8 * keys_results.size());
+  return static_cast<long double>(max_key) - min_key + 1 <= max_entry_count;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    CaseLookupTable.h
+ * @brief   Results of a CASE over the values of an integer expression, indexed by value.
+ *
+ * A CASE whose branches compare the same integer or dictionary encoded expression
+ * with constants and return constants, like the mapping of codes to categories, is
+ * a function of that value over a small range: its results go into an array of the
+ * range, the ELSE result in the holes, and the row reads its result at its value
+ * instead of testing the branches one after the other, which diverges on GPU.
+ */
+
+#ifndef QUERYENGINE_CASELOOKUPTABLE_H
+#define QUERYENGINE_CASELOOKUPTABLE_H
+
+#include "../DataMgr/DataMgr.h"
+
+#include <llvm/IR/Value.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Executor;
+
+class CaseLookupTable {
+ public:
+  // The keys and results in the order of the branches, the first branch of a key wins.
+  CaseLookupTable(const std::vector<std::pair<int64_t, int64_t>>& keys_results,
+                  const int64_t else_val,
+                  const Data_Namespace::MemoryLevel memory_level,
+                  const int device_count,
+                  Data_Namespace::DataMgr* data_mgr);
+  ~CaseLookupTable();
+
+  // Returns the 64-bit result for the key.
+  llvm::Value* codegen(llvm::Value* key, Executor* executor) const;
+
+  // Whether the range of the keys is small enough for a table.
+  static bool isDenseEnough(const std::vector<std::pair<int64_t, int64_t>>& keys_results);
+
+ private:
+  std::vector<int8_t*> tables_;
+  // Owned copies on the devices, released with the table.
+  std::vector<Data_Namespace::AbstractBuffer*> gpu_buffers_;
+  Data_Namespace::DataMgr* data_mgr_;
+  int64_t min_key_;
+  int64_t max_key_;
+  const int64_t else_val_;
+  const Data_Namespace::MemoryLevel memory_level_;
+  const int device_count_;
+};
+
+#endif  // QUERYENGINE_CASELOOKUPTABLE_H
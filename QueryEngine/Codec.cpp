@@ -54,8 +54,8 @@ llvm::Instruction* FixedWidthUnsigned::codegenDecode(llvm::Value* byte_stream,
   return llvm::CallInst::Create(f, args);
 }
 
-DiffFixedWidthInt::DiffFixedWidthInt(const size_t byte_width, const int64_t baseline)
-    : byte_width_{byte_width}, baseline_{baseline} {}
+DiffFixedWidthInt::DiffFixedWidthInt(const size_t byte_width, const int64_t null_val)
+    : byte_width_{byte_width}, null_val_{null_val} {}
 
 llvm::Instruction* DiffFixedWidthInt::codegenDecode(llvm::Value* byte_stream,
                                                     llvm::Value* pos,
@@ -66,7 +66,7 @@ llvm::Instruction* DiffFixedWidthInt::codegenDecode(llvm::Value* byte_stream,
   llvm::Value* args[] = {
       byte_stream,
       llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), byte_width_),
-      llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), baseline_),
+      llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), null_val_),
       pos};
   return llvm::CallInst::Create(f, args);
 }
@@ -51,16 +51,17 @@ class FixedWidthUnsigned : public Decoder {
   const size_t byte_width_;
 };
 
+// Decodes the differences to the baseline stored at the start of the byte stream.
 class DiffFixedWidthInt : public Decoder {
  public:
-  DiffFixedWidthInt(const size_t byte_width, const int64_t baseline);
+  DiffFixedWidthInt(const size_t byte_width, const int64_t null_val);
   llvm::Instruction* codegenDecode(llvm::Value* byte_stream,
                                    llvm::Value* pos,
                                    llvm::Module* module) const override;
 
  private:
   const size_t byte_width_;
-  const int64_t baseline_;
+  const int64_t null_val_;
 };
 
 class FixedWidthReal : public Decoder {
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "ColumnDecodeGpu.h"
+#include "DecodersImpl.h"
+
+template <typename T>
+__global__ void decode_diff_column_gpu(T* dst,
+                                       const int8_t* diff_buffer,
+                                       const int64_t num_rows,
+                                       const int32_t diff_width,
+                                       const int64_t null_val) {
+  const int64_t start = blockIdx.x * blockDim.x + threadIdx.x;
+  const int64_t step = blockDim.x * gridDim.x;
+  for (int64_t i = start; i < num_rows; i += step) {
+    dst[i] = static_cast<T>(
+        SUFFIX(diff_fixed_width_int_decode)(diff_buffer, diff_width, null_val, i));
+  }
+}
+
+void decode_diff_column_on_device(int8_t* dst,
+                                  const int8_t* diff_buffer,
+                                  const size_t num_rows,
+                                  const int32_t diff_width,
+                                  const int32_t dst_width,
+                                  const int64_t null_val,
+                                  const size_t block_size_x,
+                                  const size_t grid_size_x) {
+  switch (dst_width) {
+    case 2:
+      decode_diff_column_gpu<<<grid_size_x, block_size_x>>>(
+          reinterpret_cast<int16_t*>(dst), diff_buffer, num_rows, diff_width, null_val);
+      break;
+    case 4:
+      decode_diff_column_gpu<<<grid_size_x, block_size_x>>>(
+          reinterpret_cast<int32_t*>(dst), diff_buffer, num_rows, diff_width, null_val);
+      break;
+    case 8:
+      decode_diff_column_gpu<<<grid_size_x, block_size_x>>>(
+          reinterpret_cast<int64_t*>(dst), diff_buffer, num_rows, diff_width, null_val);
+      break;
+    default:
+      return;
+  }
+  // The caller unpins the encoded chunk right after.
+  cudaStreamSynchronize(0);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    ColumnDecodeGpu.h
+ * @brief   Decoding of encoded chunks into plain columns on the device.
+ *
+ * Copyright (c) 2018 MapD Technologies, Inc.  All rights reserved.
+ */
+
+#ifndef QUERYENGINE_COLUMNDECODEGPU_H
+#define QUERYENGINE_COLUMNDECODEGPU_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Decodes the rows of a DIFF encoded chunk, baseline included, to values of dst_width
+// bytes. Returns once the decoding is done, the chunk can be unpinned then.
+void decode_diff_column_on_device(int8_t* dst,
+                                  const int8_t* diff_buffer,
+                                  const size_t num_rows,
+                                  const int32_t diff_width,
+                                  const int32_t dst_width,
+                                  const int64_t null_val,
+                                  const size_t block_size_x,
+                                  const size_t grid_size_x);
+
+#endif  // QUERYENGINE_COLUMNDECODEGPU_H
@@ -66,6 +66,15 @@ std::shared_ptr<Decoder> get_col_decoder(const Analyzer::ColumnVar* col_var) {
       CHECK_EQ(0, bit_width % 8);
       return std::make_shared<FixedWidthInt>(bit_width / 8);
     }
+    case kENCODING_DIFF: {
+      // The columns of the inner tables are fetched decoded, see Executor::fetchChunks.
+      if (col_var->get_rte_idx() > 0) {
+        return std::make_shared<FixedWidthInt>(get_bit_width(ti) / 8);
+      }
+      const auto bit_width = col_var->get_comp_param();
+      CHECK_EQ(0, bit_width % 8);
+      return std::make_shared<DiffFixedWidthInt>(bit_width / 8, inline_int_null_val(ti));
+    }
     default:
       abort();
   }
@@ -458,6 +467,9 @@ llvm::Value* Executor::posArg(const Analyzer::Expr* expr) const {
 
 const Analyzer::ColumnVar* Executor::hashJoinLhs(const Analyzer::ColumnVar* rhs) const {
   for (const auto tautological_eq : plan_state_->join_info_.equi_join_tautologies_) {
+    if (!tautological_eq) {
+      continue;
+    }
     CHECK(IS_EQUIVALENCE(tautological_eq->get_optype()));
     if (dynamic_cast<const Analyzer::ExpressionTuple*>(
             tautological_eq->get_left_operand())) {
@@ -16,9 +16,11 @@
 
 #include "ColumnarResults.h"
 #include "ResultRows.h"
+#include "RuntimeFunctions.h"
 
-#include "../Shared/thread_count.h"
+#include "../Shared/ThreadPool.h"
 
+#include <algorithm>
 #include <atomic>
 #include <future>
 #include <numeric>
@@ -37,6 +39,98 @@ int64_t fixed_encoding_nullable_val(const int64_t val, const SQLTypeInfo& type_i
   return val;
 }
 
+// Decodes a DIFF encoded chunk to the logical width of its type.
+void decode_diff_encoded_column(int8_t* dst,
+                                const int8_t* diff_buffer,
+                                const size_t num_rows,
+                                const SQLTypeInfo& diff_ti) {
+  const auto logical_ti = get_logical_type_info(diff_ti);
+  const auto null_val = inline_int_null_val(logical_ti);
+  for (size_t i = 0; i < num_rows; ++i) {
+    const auto val = diff_fixed_width_int_decode_noinline(
+        diff_buffer, diff_ti.get_size(), null_val, i);
+    switch (logical_ti.get_size()) {
+      case 2:
+        reinterpret_cast<int16_t*>(dst)[i] = val;
+        break;
+      case 4:
+        reinterpret_cast<int32_t*>(dst)[i] = val;
+        break;
+      case 8:
+        reinterpret_cast<int64_t*>(dst)[i] = val;
+        break;
+      default:
+        CHECK(false);
+    }
+  }
+}
+
+struct BufferCopy {
+  int8_t* dst;
+  const int8_t* src;
+  size_t byte_count;
+};
+
+// Below this, the copies run on the calling thread.
+const size_t MIN_PARALLEL_COPY_BYTES{1 << 20};
+
+// Splits the copies in ranges of about the same size, one per worker thread.
+void copy_buffers(const std::vector<BufferCopy>& copies) {
+  const auto total_bytes =
+      std::accumulate(copies.begin(),
+                      copies.end(),
+                      size_t(0),
+                      [](const size_t init, const BufferCopy& copy) {
+                        return init + copy.byte_count;
+                      });
+  if (total_bytes < MIN_PARALLEL_COPY_BYTES) {
+    for (const auto& copy : copies) {
+      memcpy(copy.dst, copy.src, copy.byte_count);
+    }
+    return;
+  }
+  const size_t worker_count = threadpool::ThreadPool::instance().workerCount();
+  const auto stride = std::max((total_bytes + worker_count - 1) / worker_count,
+                               MIN_PARALLEL_COPY_BYTES / worker_count);
+  std::vector<std::future<void>> copy_threads;
+  for (const auto& copy : copies) {
+    for (size_t offset = 0; offset < copy.byte_count; offset += stride) {
+      copy_threads.push_back(threadpool::ThreadPool::instance().submit(
+          [](int8_t* dst, const int8_t* src, const size_t byte_count) {
+            memcpy(dst, src, byte_count);
+          },
+          copy.dst + offset,
+          copy.src + offset,
+          std::min(stride, copy.byte_count - offset)));
+    }
+  }
+  threadpool::wait_all(copy_threads);
+}
+
+// The columns of a columnar projection can be copied as they are if they have the width
+// of the target types and their nulls are the ones of the targets.
+bool can_copy_projection_columns(const ResultSet& rows,
+                                 const std::vector<const int8_t*>& projection_buffers,
+                                 const std::vector<SQLTypeInfo>& target_types) {
+  if (projection_buffers.empty() || projection_buffers.size() != target_types.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < target_types.size(); ++i) {
+    const auto& target_type = target_types[i];
+    const auto col_type = rows.getColType(i);
+    if (target_type.get_size() != col_type.get_size() ||
+        target_type.is_fp() != col_type.is_fp()) {
+      return false;
+    }
+    const bool is_dict_id =
+        target_type.get_compression() == kENCODING_DICT && target_type.get_size() == 4;
+    if (target_type.get_compression() != kENCODING_NONE && !is_dict_id) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 ColumnarResults::ColumnarResults(
@@ -44,10 +138,7 @@ ColumnarResults::ColumnarResults(
     const ResultSet& rows,
     const size_t num_columns,
     const std::vector<SQLTypeInfo>& target_types)
-    : column_buffers_(num_columns)
-    , num_rows_(use_parallel_algorithms(rows) ? rows.entryCount() : rows.rowCount())
-    , target_types_(target_types) {
-  column_buffers_.resize(num_columns);
+    : column_buffers_(num_columns), num_rows_(0), target_types_(target_types) {
   for (size_t i = 0; i < num_columns; ++i) {
     const bool is_varlen = target_types[i].is_array() ||
                            (target_types[i].is_string() &&
@@ -56,6 +147,28 @@ ColumnarResults::ColumnarResults(
     if (is_varlen) {
       throw ColumnarConversionNotSupported();
     }
+  }
+  // The columns of a columnar projection, GPU ones included once copied back to the
+  // host, are copied whole instead of being gathered row by row.
+  size_t projection_row_count{0};
+  const auto projection_buffers =
+      rows.getColumnarProjectionBuffers(0, rows.entryCount(), projection_row_count);
+  if (can_copy_projection_columns(rows, projection_buffers, target_types)) {
+    num_rows_ = projection_row_count;
+    std::vector<BufferCopy> copies;
+    for (size_t i = 0; i < num_columns; ++i) {
+      const auto byte_count = num_rows_ * target_types[i].get_size();
+      auto col_buffer = reinterpret_cast<int8_t*>(checked_malloc(byte_count));
+      column_buffers_[i] = col_buffer;
+      row_set_mem_owner->addColBuffer(col_buffer);
+      copies.push_back({col_buffer, projection_buffers[i], byte_count});
+    }
+    copy_buffers(copies);
+    rows.setCachedRowCount(num_rows_);
+    return;
+  }
+  num_rows_ = use_parallel_algorithms(rows) ? rows.entryCount() : rows.rowCount();
+  for (size_t i = 0; i < num_columns; ++i) {
     column_buffers_[i] = reinterpret_cast<const int8_t*>(
         checked_malloc(num_rows_ * target_types[i].get_size()));
     row_set_mem_owner->addColBuffer(column_buffers_[i]);
@@ -108,7 +221,7 @@ ColumnarResults::ColumnarResults(
     }
   };
   if (use_parallel_algorithms(rows)) {
-    const size_t worker_count = cpu_threads();
+    const size_t worker_count = threadpool::ThreadPool::instance().workerCount();
     std::vector<std::future<void>> conversion_threads;
     const auto entry_count = rows.entryCount();
     for (size_t i = 0,
@@ -117,25 +230,19 @@ ColumnarResults::ColumnarResults(
          i < worker_count && start_entry < entry_count;
          ++i, start_entry += stride) {
       const auto end_entry = std::min(start_entry + stride, entry_count);
-      conversion_threads.push_back(
-          std::async(std::launch::async,
-                     [&rows, &do_work, &row_idx](const size_t start, const size_t end) {
-                       for (size_t i = start; i < end; ++i) {
-                         const auto crt_row = rows.getRowAtNoTranslations(i);
-                         if (!crt_row.empty()) {
-                           do_work(crt_row, row_idx.fetch_add(1));
-                         }
-                       }
-                     },
-                     start_entry,
-                     end_entry));
-    }
-    for (auto& child : conversion_threads) {
-      child.wait();
-    }
-    for (auto& child : conversion_threads) {
-      child.get();
+      conversion_threads.push_back(threadpool::ThreadPool::instance().submit(
+          [&rows, &do_work, &row_idx](const size_t start, const size_t end) {
+            for (size_t i = start; i < end; ++i) {
+              const auto crt_row = rows.getRowAtNoTranslations(i);
+              if (!crt_row.empty()) {
+                do_work(crt_row, row_idx.fetch_add(1));
+              }
+            }
+          },
+          start_entry,
+          end_entry));
     }
+    threadpool::wait_all(conversion_threads);
     num_rows_ = row_idx;
     rows.setCachedRowCount(num_rows_);
     return;
@@ -156,7 +263,11 @@ ColumnarResults::ColumnarResults(
     const int8_t* one_col_buffer,
     const size_t num_rows,
     const SQLTypeInfo& target_type)
-    : column_buffers_(1), num_rows_(num_rows), target_types_{target_type} {
+    : column_buffers_(1)
+    , num_rows_(num_rows)
+    , target_types_{target_type.get_compression() == kENCODING_DIFF
+                        ? get_logical_type_info(target_type)
+                        : target_type} {
   const bool is_varlen =
       target_type.is_array() ||
       (target_type.is_string() && target_type.get_compression() == kENCODING_NONE) ||
@@ -164,9 +275,14 @@ ColumnarResults::ColumnarResults(
   if (is_varlen) {
     throw ColumnarConversionNotSupported();
   }
-  const auto buf_size = num_rows * target_type.get_size();
+  const auto buf_size = num_rows * target_types_[0].get_size();
   column_buffers_[0] = reinterpret_cast<const int8_t*>(checked_malloc(buf_size));
-  memcpy(((void*)column_buffers_[0]), one_col_buffer, buf_size);
+  if (target_type.get_compression() == kENCODING_DIFF) {
+    decode_diff_encoded_column(
+        const_cast<int8_t*>(column_buffers_[0]), one_col_buffer, num_rows, target_type);
+  } else {
+    memcpy(((void*)column_buffers_[0]), one_col_buffer, buf_size);
+  }
   row_set_mem_owner->addColBuffer(column_buffers_[0]);
 }
 
@@ -193,6 +309,7 @@ std::unique_ptr<ColumnarResults> ColumnarResults::mergeResults(
   if (nonempty_it == sub_results.end()) {
     return nullptr;
   }
+  std::vector<BufferCopy> copies;
   for (size_t col_idx = 0; col_idx < col_count; ++col_idx) {
     const auto byte_width = (*nonempty_it)->getColumnType(col_idx).get_size();
     auto write_ptr =
@@ -205,9 +322,11 @@ std::unique_ptr<ColumnarResults> ColumnarResults::mergeResults(
         continue;
       }
       CHECK_EQ(byte_width, rs->getColumnType(col_idx).get_size());
-      memcpy(write_ptr, rs->column_buffers_[col_idx], rs->size() * byte_width);
-      write_ptr += rs->size() * byte_width;
+      const auto byte_count = rs->size() * byte_width;
+      copies.push_back({write_ptr, rs->column_buffers_[col_idx], byte_count});
+      write_ptr += byte_count;
     }
   }
+  copy_buffers(copies);
   return merged_results;
 }
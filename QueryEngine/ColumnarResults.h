@@ -38,6 +38,7 @@ class ColumnarResults {
                   const size_t num_columns,
                   const std::vector<SQLTypeInfo>& target_types);
 
+  // A DIFF encoded buffer is decoded, the column gets the logical type.
   ColumnarResults(const std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner,
                   const int8_t* one_col_buffer,
                   const size_t num_rows,
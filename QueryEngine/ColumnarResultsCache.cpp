@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ColumnarResultsCache.h"
+#include "ColumnarResults.h"
+#include "Execute.h"
+#include "RelAlgAbstractInterpreter.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+void collect_plan_nodes(const RelAlgNode* node, std::vector<const RelAlgNode*>& nodes) {
+  if (std::find(nodes.begin(), nodes.end(), node) != nodes.end()) {
+    return;
+  }
+  nodes.push_back(node);
+  for (size_t i = 0; i < node->inputCount(); ++i) {
+    collect_plan_nodes(node->getInput(i), nodes);
+  }
+}
+
+void replace_all(std::string& str, const std::string& from, const std::string& to) {
+  for (auto pos = str.find(from); pos != std::string::npos;
+       pos = str.find(from, pos + to.size())) {
+    str.replace(pos, from.size(), to);
+  }
+}
+
+}  // namespace
+
+JoinHashTableCache<QueryResultCacheKey, std::shared_ptr<const ColumnarResults>>
+    ColumnarResultsCache::columnar_cache_(g_columnar_results_cache_max_bytes);
+
+std::string ColumnarResultsCache::getPlanKey(const RelAlgNode* node) {
+  std::vector<const RelAlgNode*> nodes;
+  collect_plan_nodes(node, nodes);
+  std::string key;
+  for (const auto plan_node : nodes) {
+    key += plan_node->toString() + " inputs:";
+    for (size_t i = 0; i < plan_node->inputCount(); ++i) {
+      const auto input_it =
+          std::find(nodes.begin(), nodes.end(), plan_node->getInput(i));
+      CHECK(input_it != nodes.end());
+      key += " #" + std::to_string(input_it - nodes.begin());
+    }
+    key += "\n";
+  }
+  // The nodes print their own address and the one of the node a RexInput refers to.
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const auto address = std::to_string(reinterpret_cast<uint64_t>(nodes[i]));
+    const auto ordinal = "#" + std::to_string(i);
+    replace_all(key, "<" + address + ">", "<" + ordinal + ">");
+    replace_all(key, " " + address + ")", " " + ordinal + ")");
+  }
+  // The subqueries are printed with their address as well. NOW() and the 'now'
+  // literals are evaluated at execution time.
+  if (key.find("RexSubQuery") != std::string::npos ||
+      key.find("NOW") != std::string::npos || key.find("now") != std::string::npos) {
+    return "";
+  }
+  return key;
+}
+
+std::shared_ptr<const ColumnarResults> ColumnarResultsCache::columnarize(
+    const QueryResultCacheKey* key,
+    const std::shared_ptr<RowSetMemoryOwner>& row_set_mem_owner,
+    const std::shared_ptr<ResultSet>& rows,
+    const int frag_id) {
+  if (!key || !g_enable_columnar_results_cache) {
+    return std::shared_ptr<const ColumnarResults>(
+        columnarize_result(row_set_mem_owner, rows, frag_id));
+  }
+  // A sort with a limit may keep other rows among the ties, but never another number.
+  const auto row_count = rows->rowCount();
+  const auto cached = columnar_cache_.get(
+      *key, [row_count](const std::shared_ptr<const ColumnarResults>& columnar) {
+        return columnar->size() == row_count;
+      });
+  if (cached) {
+    return *cached;
+  }
+  auto columnar_owner = std::make_shared<RowSetMemoryOwner>();
+  std::shared_ptr<const ColumnarResults> columnar(
+      columnarize_result(columnar_owner, rows, frag_id),
+      [columnar_owner](const ColumnarResults* columnar) { delete columnar; });
+  size_t bytes{0};
+  for (size_t i = 0; i < columnar->getColumnBuffers().size(); ++i) {
+    bytes += columnar->size() * columnar->getColumnType(i).get_size();
+  }
+  columnar_cache_.put(*key, columnar, bytes + key->query_ra.size());
+  return columnar;
+}
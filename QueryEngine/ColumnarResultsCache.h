@@ -0,0 +1,67 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ColumnarResultsCache.h
+ * @brief   Columnar form of the temporary tables, shared across queries.
+ *
+ * The scans and the join hash table builds read the output of the previous steps of a
+ * query in columnar form. Dashboard queries join against the same views and subqueries
+ * over and over again, each one converting the same rows again. The conversions are
+ * keyed by the plan of the step which produced the rows, without the addresses of its
+ * nodes, and the generations of the tables and string dictionaries it reads.
+ */
+
+#ifndef QUERYENGINE_COLUMNARRESULTSCACHE_H
+#define QUERYENGINE_COLUMNARRESULTSCACHE_H
+
+#include "QueryResultCache.h"
+
+#include <memory>
+#include <string>
+
+class ColumnarResults;
+class RelAlgNode;
+class RowSetMemoryOwner;
+
+class ColumnarResultsCache {
+ public:
+  // Serialization of the plan rooted at the node, empty if the rows it produces may
+  // differ between two runs on the same data. The nodes are numbered in the order of a
+  // depth-first traversal instead of printed with their addresses.
+  static std::string getPlanKey(const RelAlgNode* node);
+
+  // Converts the temporary table, or gets the conversion of the same rows by a previous
+  // query if the key isn't null. The cached columns own their buffers, they stay valid
+  // after the eviction of the entry.
+  static std::shared_ptr<const ColumnarResults> columnarize(
+      const QueryResultCacheKey* key,
+      const std::shared_ptr<RowSetMemoryOwner>& row_set_mem_owner,
+      const std::shared_ptr<ResultSet>& rows,
+      const int frag_id);
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void { columnar_cache_.clear(); };
+  }
+
+  static JoinHashTableCacheStats getCacheStats() { return columnar_cache_.getStats(); }
+
+ private:
+  static JoinHashTableCache<QueryResultCacheKey, std::shared_ptr<const ColumnarResults>>
+      columnar_cache_;
+};
+
+#endif  // QUERYENGINE_COLUMNARRESULTSCACHE_H
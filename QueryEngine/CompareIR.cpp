@@ -184,7 +184,7 @@ llvm::Value* Executor::codegenCmp(const Analyzer::BinOper* bin_oper,
                                   const CompilationOptions& co) {
   for (size_t i = 0; i < plan_state_->join_info_.equi_join_tautologies_.size(); ++i) {
     const auto& equi_join_tautology = plan_state_->join_info_.equi_join_tautologies_[i];
-    if (*equi_join_tautology == *bin_oper) {
+    if (equi_join_tautology && *equi_join_tautology == *bin_oper) {
       return plan_state_->join_info_.join_hash_tables_[i]->codegenSlotIsValid(co, i);
     }
   }
@@ -229,7 +229,10 @@ llvm::Value* Executor::codegenCmp(const Analyzer::BinOper* bin_oper,
     }
   }
 
-  auto lhs_lvs = codegen(lhs, true, co);
+  auto lhs_lvs = codegenDeviceStringDecode(lhs, co);
+  if (lhs_lvs.empty()) {
+    lhs_lvs = codegen(lhs, true, co);
+  }
   return codegenCmp(optype, qualifier, lhs_lvs, lhs_ti, rhs, co);
 }
 
@@ -324,7 +327,10 @@ llvm::Value* Executor::codegenCmp(const SQLOps optype,
   if (rhs_ti.is_array()) {
     return codegenQualifierCmp(optype, qualifier, lhs_lvs, rhs, co);
   }
-  auto rhs_lvs = codegen(rhs, true, co);
+  auto rhs_lvs = codegenDeviceStringDecode(rhs, co);
+  if (rhs_lvs.empty()) {
+    rhs_lvs = codegen(rhs, true, co);
+  }
   CHECK_EQ(kONE, qualifier);
   CHECK((lhs_ti.get_type() == rhs_ti.get_type()) ||
         (lhs_ti.is_string() && rhs_ti.is_string()));
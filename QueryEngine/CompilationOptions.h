@@ -41,6 +41,9 @@ struct ExecutionOptions {
       dynamic_watchdog_time_limit;  // Dynamic watchdog time limit, in milliseconds.
   const bool find_push_down_candidates;
   const bool just_calcite_explain;
+  // Input bytes of the outer table per multi-fragment GPU kernel, 0 for no limit. The
+  // fragments of a device past it go to more kernels, run one after the other.
+  const size_t gpu_wave_bytes;
 };
 
 #endif  // QUERYENGINE_COMPILATIONOPTIONS_H
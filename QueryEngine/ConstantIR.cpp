@@ -315,3 +315,14 @@ std::vector<llvm::Value*> Executor::codegenHoistedConstants(
       type_info, enc_type, lit_off, hoisted_literal_loads);
   return literal_placeholders;
 }
+
+llvm::Value* Executor::codegenHoistedBigint(const int64_t val,
+                                            const size_t device_count) {
+  Datum d;
+  d.bigintval = val;
+  const auto constant = makeExpr<Analyzer::Constant>(kBIGINT, false, d);
+  const std::vector<const Analyzer::Constant*> constants(device_count, constant.get());
+  const auto lvs = codegenHoistedConstants(constants, kENCODING_NONE, 0);
+  CHECK_EQ(size_t(1), lvs.size());
+  return lvs.front();
+}
@@ -25,9 +25,12 @@
 #ifndef QUERYENGINE_COUNTDISTINCT_H
 #define QUERYENGINE_COUNTDISTINCT_H
 
+#include "../Shared/sqltypes.h"
 #include "CountDistinctDescriptor.h"
 #include "HyperLogLog.h"
+#include "RoaringBitmap.h"
 
+#include <algorithm>
 #include <bitset>
 #include <set>
 #include <vector>
@@ -93,15 +96,71 @@ inline int64_t count_distinct_set_size(
     }
     return bitmap_set_size(set_vals, count_distinct_desc.bitmapSizeBytes());
   }
+  if (count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring) {
+    return reinterpret_cast<RoaringBitmap*>(set_handle)->size();
+  }
   CHECK(count_distinct_desc.impl_type_ == CountDistinctImplType::StdSet);
   return reinterpret_cast<std::set<int64_t>*>(set_handle)->size();
 }
 
+// The registers of an approximate count distinct bitmap, as stored in a sketch. They
+// are one byte wide whichever device computed them.
+inline std::vector<int8_t> count_distinct_set_registers(
+    const int64_t set_handle,
+    const CountDistinctDescriptor& count_distinct_desc) {
+  CHECK(count_distinct_desc.impl_type_ == CountDistinctImplType::Bitmap &&
+        count_distinct_desc.approximate);
+  const size_t m = 1 << count_distinct_desc.bitmap_sz_bits;
+  std::vector<int8_t> registers(m, 0);
+  if (!set_handle) {
+    return registers;
+  }
+  if (count_distinct_desc.device_type == ExecutorDeviceType::GPU) {
+    const auto M = reinterpret_cast<const int32_t*>(set_handle);
+    std::copy(M, M + m, registers.begin());
+  } else {
+    const auto M = reinterpret_cast<const int8_t*>(set_handle);
+    std::copy(M, M + m, registers.begin());
+  }
+  return registers;
+}
+
+// The approximate percentile of the values counted in a quantile sketch, NULL_DOUBLE if
+// there are none.
+inline double count_distinct_set_quantile(
+    const int64_t set_handle,
+    const CountDistinctDescriptor& count_distinct_desc) {
+  CHECK(count_distinct_desc.impl_type_ == CountDistinctImplType::Bitmap &&
+        count_distinct_desc.isQuantileSketch());
+  double value{NULL_DOUBLE};
+  if (set_handle) {
+    quantile_sketch_value(value,
+                          reinterpret_cast<const int64_t*>(set_handle),
+                          count_distinct_desc.quantile);
+  }
+  return value;
+}
+
 inline void count_distinct_set_union(
     const int64_t new_set_handle,
     const int64_t old_set_handle,
     const CountDistinctDescriptor& new_count_distinct_desc,
     const CountDistinctDescriptor& old_count_distinct_desc) {
+  if (new_count_distinct_desc.isQuantileSketch()) {
+    // Unlike the unions, adding the counts up isn't idempotent: only the old set, the
+    // one reduced into, is updated.
+    CHECK(old_count_distinct_desc.isQuantileSketch());
+    if (!new_set_handle || new_set_handle == old_set_handle) {
+      return;
+    }
+    CHECK(old_set_handle);
+    auto new_counts = reinterpret_cast<const int64_t*>(new_set_handle);
+    auto old_counts = reinterpret_cast<int64_t*>(old_set_handle);
+    for (uint32_t i = 0; i < kQuantileSketchBuckets; ++i) {
+      old_counts[i] += new_counts[i];
+    }
+    return;
+  }
   if (new_count_distinct_desc.impl_type_ == CountDistinctImplType::Bitmap) {
     auto new_set = reinterpret_cast<int8_t*>(new_set_handle);
     auto old_set = reinterpret_cast<int8_t*>(old_set_handle);
@@ -141,6 +200,12 @@ inline void count_distinct_set_union(
                                       : old_count_distinct_desc.bitmapPaddedSizeBytes();
       bitmap_set_union(new_set, old_set, bitmap_byte_sz);
     }
+  } else if (new_count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring) {
+    CHECK(old_count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring);
+    auto old_set = reinterpret_cast<RoaringBitmap*>(old_set_handle);
+    auto new_set = reinterpret_cast<RoaringBitmap*>(new_set_handle);
+    new_set->unite(*old_set);
+    *old_set = *new_set;
   } else {
     CHECK(old_count_distinct_desc.impl_type_ == CountDistinctImplType::StdSet);
     auto old_set = reinterpret_cast<std::set<int64_t>*>(old_set_handle);
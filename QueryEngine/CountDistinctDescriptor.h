@@ -28,6 +28,7 @@
 
 #include "BufferCompaction.h"
 #include "CompilationOptions.h"
+#include "QuantileSketch.h"
 
 #include <glog/logging.h>
 
@@ -39,7 +40,7 @@ inline size_t bitmap_bits_to_bytes(const size_t bitmap_sz) {
   return bitmap_byte_sz;
 }
 
-enum class CountDistinctImplType { Invalid, Bitmap, StdSet };
+enum class CountDistinctImplType { Invalid, Bitmap, StdSet, Roaring };
 
 struct CountDistinctDescriptor {
   CountDistinctImplType impl_type_;
@@ -48,9 +49,17 @@ struct CountDistinctDescriptor {
   bool approximate;
   ExecutorDeviceType device_type;
   size_t sub_bitmap_count;
+  // The percentile of APPROX_PERCENTILE, between 0 and 1. The bitmap holds the counts of
+  // a quantile sketch instead. Negative for the count distinct.
+  double quantile{-1};
+
+  bool isQuantileSketch() const { return quantile >= 0; }
 
   size_t bitmapSizeBytes() const {
     CHECK(impl_type_ == CountDistinctImplType::Bitmap);
+    if (isQuantileSketch()) {
+      return kQuantileSketchBuckets * sizeof(int64_t);
+    }
     const auto approx_reg_bytes =
         (device_type == ExecutorDeviceType::GPU ? sizeof(int32_t) : 1);
     return approximate ? (1 << bitmap_sz_bits) * approx_reg_bytes
@@ -71,7 +80,7 @@ inline bool operator==(const CountDistinctDescriptor& lhs,
                        const CountDistinctDescriptor& rhs) {
   return lhs.impl_type_ == rhs.impl_type_ && lhs.min_val == rhs.min_val &&
          lhs.bitmap_sz_bits == rhs.bitmap_sz_bits && lhs.approximate == rhs.approximate &&
-         lhs.device_type == rhs.device_type;
+         lhs.device_type == rhs.device_type && lhs.quantile == rhs.quantile;
 }
 
 inline bool operator!=(const CountDistinctDescriptor& lhs,
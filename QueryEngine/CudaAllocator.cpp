@@ -15,6 +15,7 @@
  */
 
 #include "CudaAllocator.h"
+#include "QueryMemoryAccount.h"
 
 #include <CudaMgr/CudaMgr.h>
 #include <DataMgr/DataMgr.h>
@@ -44,6 +45,20 @@ CUdeviceptr CudaAllocator::alloc(const size_t num_bytes,
   return reinterpret_cast<CUdeviceptr>(ab->getMemoryPtr());
 }
 
+CUdeviceptr CudaAllocator::allocReusable(const size_t num_bytes,
+                                         const int device_id,
+                                         RenderAllocator* render_allocator) const {
+  if (render_allocator) {
+    return reinterpret_cast<CUdeviceptr>(render_allocator->alloc(num_bytes));
+  }
+  OOM_TRACE_PUSH(+": device_id " + std::to_string(device_id) + ", num_bytes " +
+                 std::to_string(num_bytes));
+  QueryMemoryAccount::charge(ExecutorDeviceType::GPU, num_bytes);
+  auto ab = data_mgr_->allocReusable(Data_Namespace::GPU_LEVEL, device_id, num_bytes);
+  CHECK_EQ(ab->getPinCount(), 1);
+  return reinterpret_cast<CUdeviceptr>(ab->getMemoryPtr());
+}
+
 void CudaAllocator::free(Data_Namespace::AbstractBuffer* ab) const {
   data_mgr_->free(ab);
 }
@@ -88,6 +103,7 @@ void CudaAllocator::setDeviceMem(int8_t* device_ptr,
 Data_Namespace::AbstractBuffer* CudaAllocator::allocGpuAbstractBuffer(
     const size_t num_bytes,
     const int device_id) const {
+  QueryMemoryAccount::charge(ExecutorDeviceType::GPU, num_bytes);
   auto ab = data_mgr_->alloc(Data_Namespace::GPU_LEVEL, device_id, num_bytes);
   CHECK_EQ(ab->getPinCount(), 1);
   return ab;
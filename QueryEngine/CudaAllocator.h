@@ -47,6 +47,11 @@ class CudaAllocator {
                     const int device_id,
                     RenderAllocator* render_allocator) const;
 
+  // For the output buffers, which repeated queries ask for with the same size.
+  CUdeviceptr allocReusable(const size_t num_bytes,
+                            const int device_id,
+                            RenderAllocator* render_allocator) const;
+
   void free(Data_Namespace::AbstractBuffer* ab) const;
 
   void copyToDevice(CUdeviceptr dst,
@@ -131,6 +131,13 @@ llvm::Value* Executor::codegen(const Analyzer::DatetruncExpr* datetrunc_expr,
                                             from_expr,
                                             get_int_type(32, cgen_state_->context_));
   }
+  if (datetrunc_expr_ti.get_dimension() == 0) {
+    const auto fixed_width_lv = codegenFixedWidthDatetrunc(
+        datetrunc_expr->get_field(), from_expr, datetrunc_expr_ti);
+    if (fixed_width_lv) {
+      return fixed_width_lv;
+    }
+  }
   std::vector<llvm::Value*> datetrunc_args{
       ll_int(static_cast<int32_t>(datetrunc_expr->get_field())), from_expr};
   if (datetrunc_expr_ti.get_dimension() > 0) {
@@ -146,3 +153,65 @@ llvm::Value* Executor::codegen(const Analyzer::DatetruncExpr* datetrunc_expr,
   return cgen_state_->emitExternalCall(
       datetrunc_fname, get_int_type(64, cgen_state_->context_), datetrunc_args);
 }
+
+// Truncations to a fixed number of seconds, done inline with arithmetic by constants
+// which LLVM strength reduces, instead of through DateTruncate. The results are the
+// same as DateTruncate's, negative timestamps included. Returns nullptr for the fields
+// which depend on the calendar.
+llvm::Value* Executor::codegenFixedWidthDatetrunc(const DatetruncField field,
+                                                  llvm::Value* ts,
+                                                  const SQLTypeInfo& ts_ti) {
+  int64_t width{1};
+  switch (field) {
+    case dtNANOSECOND:
+    case dtMICROSECOND:
+    case dtMILLISECOND:
+    case dtSECOND:
+      break;
+    case dtMINUTE:
+      width = SECSPERMIN;
+      break;
+    case dtHOUR:
+      width = SECSPERHOUR;
+      break;
+    case dtQUARTERDAY:
+      width = SECSPERQUARTERDAY;
+      break;
+    case dtDAY:
+    case dtWEEK:
+      width = SECSPERDAY;
+      break;
+    default:
+      return nullptr;
+  }
+  auto& ir_builder = cgen_state_->ir_builder_;
+  const auto ts_type = ts->getType();
+  llvm::Value* ret = ts;
+  if (width > 1) {
+    const auto width_lv = llvm::ConstantInt::get(ts_type, width);
+    ret = ir_builder.CreateMul(ir_builder.CreateSDiv(ts, width_lv), width_lv);
+    // Like DateTruncate, move negative results one more bucket down.
+    ret = ir_builder.CreateSelect(
+        ir_builder.CreateICmpSLT(ret, llvm::ConstantInt::get(ts_type, 0)),
+        ir_builder.CreateSub(ret, width_lv),
+        ret);
+  }
+  if (field == dtWEEK) {
+    // Back to the Sunday of the week, the epoch was on a Thursday.
+    const auto day_lv = llvm::ConstantInt::get(ts_type, SECSPERDAY);
+    const auto days_lv = ir_builder.CreateSDiv(ret, day_lv);
+    const auto week_lv = llvm::ConstantInt::get(ts_type, DAYSPERWEEK);
+    auto dow_lv = ir_builder.CreateSRem(
+        ir_builder.CreateAdd(days_lv, llvm::ConstantInt::get(ts_type, 4)), week_lv);
+    dow_lv = ir_builder.CreateSelect(
+        ir_builder.CreateICmpSLT(dow_lv, llvm::ConstantInt::get(ts_type, 0)),
+        ir_builder.CreateAdd(dow_lv, week_lv),
+        dow_lv);
+    ret = ir_builder.CreateSub(ret, ir_builder.CreateMul(dow_lv, day_lv));
+  }
+  if (!ts_ti.get_notnull()) {
+    const auto null_lv = llvm::ConstantInt::get(ts_type, inline_int_null_val(ts_ti));
+    ret = ir_builder.CreateSelect(ir_builder.CreateICmpEQ(ts, null_lv), null_lv, ret);
+  }
+  return ret;
+}
@@ -93,12 +93,28 @@ SUFFIX(fixed_width_unsigned_decode_noinline)(const int8_t* byte_stream,
   return SUFFIX(fixed_width_unsigned_decode)(byte_stream, byte_width, pos);
 }
 
+// The stream starts with the 64-bit baseline, the smallest difference is the null.
 extern "C" DEVICE ALWAYS_INLINE int64_t
 SUFFIX(diff_fixed_width_int_decode)(const int8_t* byte_stream,
                                     const int32_t byte_width,
-                                    const int64_t baseline,
+                                    const int64_t null_val,
                                     const int64_t pos) {
-  return SUFFIX(fixed_width_int_decode)(byte_stream, byte_width, pos) + baseline;
+  const auto diff = SUFFIX(fixed_width_int_decode)(
+      byte_stream + sizeof(int64_t), byte_width, pos);
+  if (diff == -(int64_t(1) << (byte_width * 8 - 1))) {
+    return null_val;
+  }
+  const auto baseline = *(reinterpret_cast<const int64_t*>(byte_stream));
+  return static_cast<int64_t>(static_cast<uint64_t>(baseline) +
+                              static_cast<uint64_t>(diff));
+}
+
+extern "C" DEVICE NEVER_INLINE int64_t
+SUFFIX(diff_fixed_width_int_decode_noinline)(const int8_t* byte_stream,
+                                             const int32_t byte_width,
+                                             const int64_t null_val,
+                                             const int64_t pos) {
+  return SUFFIX(diff_fixed_width_int_decode)(byte_stream, byte_width, null_val, pos);
 }
 
 extern "C" DEVICE ALWAYS_INLINE float SUFFIX(
@@ -21,21 +21,28 @@
 #include "DynamicWatchdog.h"
 #include "EquiJoinCondition.h"
 #include "ExpressionRewrite.h"
+#include "GpuLaunchTuner.h"
 #include "GpuMemUtils.h"
 #include "InPlaceSort.h"
 #include "JsonAccessors.h"
 #include "OutputBufferInitialization.h"
 #include "QueryFragmentDescriptor.h"
+#include "QueryMemoryAccount.h"
+#include "QueryResultCache.h"
 #include "QueryRewrite.h"
 #include "QueryTemplateGenerator.h"
 #include "RuntimeFunctions.h"
 #include "SpeculativeTopN.h"
+#include "TableMetadataCache.h"
+#include "TableSample.h"
 
 #include "CudaMgr/CudaMgr.h"
 #include "DataMgr/BufferMgr/BufferMgr.h"
 #include "Parser/ParserNode.h"
 #include "Shared/ExperimentalTypeUtilities.h"
 #include "Shared/MapDParameters.h"
+#include "Shared/ThreadPool.h"
+#include "Shared/Tracing.h"
 #include "Shared/checked_alloc.h"
 #include "Shared/measure.h"
 #include "Shared/scope.h"
@@ -52,6 +59,7 @@
 #ifdef HAVE_CUDA
 #include <cuda.h>
 #endif  // HAVE_CUDA
+#include <atomic>
 #include <future>
 #include <memory>
 #include <numeric>
@@ -68,14 +76,66 @@ unsigned g_trivial_loop_join_threshold{1000};
 bool g_left_deep_join_optimization{true};
 bool g_from_table_reordering{true};
 bool g_inner_join_fragment_skipping{false};
+bool g_enable_partitioned_hash_join_build{true};
+bool g_enable_join_key_fragment_skipping{true};
+bool g_enable_smem_hash_join_build{true};
+bool g_enable_range_join_hash_table{true};
+bool g_enable_spatial_join_hash_table{true};
+size_t g_join_hash_table_cache_max_bytes{size_t(4) << 30};
+size_t g_in_values_hash_set_cache_max_bytes{size_t(1) << 30};
+bool g_enable_query_result_cache{false};
+size_t g_query_result_cache_max_bytes{size_t(1) << 30};
+bool g_enable_columnar_results_cache{true};
+size_t g_columnar_results_cache_max_bytes{size_t(1) << 30};
+bool g_enable_table_metadata_cache{true};
+bool g_enable_shared_scans{false};
+size_t g_query_cpu_memory_limit_bytes{0};
+size_t g_query_gpu_memory_limit_bytes{0};
+size_t g_interactive_query_max_input_bytes{size_t(256) << 20};
+unsigned g_batch_query_max_delay_ms{2000};
+bool g_enable_hybrid_execution{false};
+bool g_enable_residency_aware_placement{false};
+size_t g_group_by_buffer_pool_max_bytes{size_t(256) << 20};
+bool g_enable_group_by_partitioning{true};
+size_t g_max_group_by_partitions{256};
+bool g_enable_partitioned_reduction{true};
+bool g_enable_cpu_radix_sort{true};
+bool g_enable_gpu_sort{true};
 extern bool g_enable_smem_group_by;
 extern std::unique_ptr<llvm::Module> g_rt_module;
 bool g_enable_filter_push_down{false};
 float g_filter_push_down_low_frac{-1.0f};
 float g_filter_push_down_high_frac{-1.0f};
 size_t g_filter_push_down_passing_row_ubound{0};
+bool g_enable_adaptive_filter_ordering{false};
 bool g_multi_subquery_exc{true};
 bool g_enable_columnar_output{false};
+bool g_enable_cpu_morsels{false};
+size_t g_cpu_morsel_size{1 << 20};
+bool g_enable_tiered_cpu_codegen{false};
+size_t g_tiered_codegen_row_threshold{100000};
+size_t g_tiered_codegen_promotion_count{3};
+bool g_enable_batched_cpu_codegen{false};
+bool g_enable_expression_cse{false};
+bool g_enable_chunk_prefetch{false};
+bool g_enable_gpu_string_dictionaries{false};
+bool g_enable_query_profile{false};
+bool g_enable_kernel_instrumentation{false};
+bool g_enable_roaring_count_distinct{true};
+bool g_enable_top_count_pruning{true};
+bool g_enable_cost_based_join_ordering{false};
+bool g_enable_fragment_bounded_group_by{false};
+bool g_enable_subquery_result_cache{false};
+bool g_enable_dictionary_translation_map{true};
+bool g_enable_gpu_column_decode{true};
+bool g_enable_gpu_waves{true};
+bool g_enable_cpu_multifrag_kernels{true};
+size_t g_insert_commit_interval_ms{0};
+size_t g_insert_commit_max_rows{10000};
+size_t g_result_set_spill_threshold_bytes{0};
+std::string g_result_set_spill_dir;
+size_t g_projection_single_pass_max_bytes{size_t(1) << 30};
+size_t g_code_cache_max_bytes{size_t(1) << 30};
 
 Executor::Executor(const int db_id,
                    const size_t block_size_x,
@@ -90,11 +150,13 @@ Executor::Executor(const int db_id,
     , render_manager_(render_manager)
     , block_size_x_(block_size_x)
     , grid_size_x_(grid_size_x)
+    , launch_grid_size_(0)
     , debug_dir_(debug_dir)
     , debug_file_(debug_file)
     , db_id_(db_id)
     , catalog_(nullptr)
     , temporary_tables_(nullptr)
+    , temporary_table_cache_keys_(nullptr)
     , input_table_info_cache_(this) {}
 
 std::shared_ptr<Executor> Executor::getExecutor(
@@ -179,10 +241,23 @@ const TemporaryTables* Executor::getTemporaryTables() const {
   return temporary_tables_;
 }
 
+const QueryResultCacheKey* Executor::getTemporaryTableCacheKey(const int table_id) const {
+  if (!temporary_table_cache_keys_) {
+    return nullptr;
+  }
+  const auto it = temporary_table_cache_keys_->find(table_id);
+  return it == temporary_table_cache_keys_->end() ? nullptr : &it->second;
+}
+
 Fragmenter_Namespace::TableInfo Executor::getTableInfo(const int table_id) const {
   return input_table_info_cache_.getTableInfo(table_id);
 }
 
+std::shared_ptr<const Fragmenter_Namespace::TableInfo> Executor::getSharedTableInfo(
+    const int table_id) const {
+  return input_table_info_cache_.getSharedTableInfo(table_id);
+}
+
 const TableGeneration& Executor::getTableGeneration(const int table_id) const {
   return table_generations_.getGeneration(table_id);
 }
@@ -836,10 +911,28 @@ ResultSetPtr Executor::reduceMultiDeviceResultSets(
         CHECK(false);
     }
   } else {
-    reduced_results = first;
+    // All the results have the same layout, reduce them pairwise in log(device count)
+    // rounds of concurrent reductions rather than folding them one at a time into the
+    // first one. The reduction of two results can still use several threads by itself.
+    for (size_t stride = 1; stride < results_per_device.size(); stride *= 2) {
+      std::vector<std::future<void>> reduction_threads;
+      for (size_t i = 0; i + stride < results_per_device.size(); i += 2 * stride) {
+        reduction_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+            [this, &results_per_device, i, stride] {
+              checkInterrupted();
+              results_per_device[i].first->getStorage()->reduce(
+                  *(results_per_device[i + stride].first->getStorage()), {});
+            }));
+      }
+      threadpool::wait_all(reduction_threads);
+    }
+    return first;
   }
 
+  // The baseline layout reduces into a buffer sized for the entries of all the devices,
+  // the results can't be reduced into each other.
   for (size_t i = 1; i < results_per_device.size(); ++i) {
+    checkInterrupted();
     reduced_results->getStorage()->reduce(*(results_per_device[i].first->getStorage()),
                                           {});
   }
@@ -1001,8 +1094,15 @@ ResultSetPtr Executor::executeWorkUnit(
   }
 
   int8_t crt_min_byte_width{get_min_byte_width()};
+  ScopeGuard reset_launch_grid_size = [this] {
+    launch_grid_size_ = 0;
+    launch_shape_key_.clear();
+  };
   do {
     *error_code = 0;
+    // The compilation sizes the buffers for the default grid.
+    launch_grid_size_ = 0;
+    launch_shape_key_.clear();
     // could use std::thread::hardware_concurrency(), but some
     // slightly out-of-date compilers (gcc 4.7) implement it as always 0.
     // Play it POSIX.1 safe instead.
@@ -1025,6 +1125,8 @@ ResultSetPtr Executor::executeWorkUnit(
         render_info);
     try {
       INJECT_TIMER(execution_dispatch_comp);
+      QueryProfile::Timer compilation_timer(query_profile_,
+                                            QueryProfile::Phase::Compilation);
       crt_min_byte_width = execution_dispatch.compile(join_info,
                                                       max_groups_buffer_entry_guess,
                                                       crt_min_byte_width,
@@ -1033,10 +1135,24 @@ ResultSetPtr Executor::executeWorkUnit(
     } catch (CompilationRetryNoCompaction&) {
       crt_min_byte_width = MAX_BYTE_WIDTH_SUPPORTED;
       continue;
+    } catch (const QueryInterrupted&) {
+      // Interrupted while building the hash tables, which fetch the inner columns.
+      *error_code = ERR_INTERRUPTED;
+      cat.get_dataMgr().freeAllBuffers();
+      QueryMemoryAccount::releaseGpuBuffers();
+      return std::make_shared<ResultSet>(std::vector<TargetInfo>{},
+                                         ExecutorDeviceType::CPU,
+                                         QueryMemoryDescriptor(),
+                                         nullptr,
+                                         this);
     }
     if (options.just_explain) {
       return executeExplain(execution_dispatch);
     }
+    if (g_enable_gpu_launch_tuning && device_type == ExecutorDeviceType::GPU &&
+        !grid_size_x_ && !(render_info && render_info->isPotentialInSituRender())) {
+      tuneGridSize(execution_dispatch.getQueryMemoryDescriptor());
+    }
 
     for (const auto target_expr : ra_exe_unit.target_exprs) {
       plan_state_->target_exprs_.push_back(target_expr);
@@ -1047,14 +1163,16 @@ ResultSetPtr Executor::executeWorkUnit(
                         int chosen_device_id,
                         const FragmentsList& frag_list,
                         const size_t ctx_idx,
-                        const int64_t rowid_lookup_key) {
+                        const int64_t rowid_lookup_key,
+                        const RowRange& row_range) {
       INJECT_TIMER(execution_dispatch_run);
       execution_dispatch.run(chosen_device_type,
                              chosen_device_id,
                              options,
                              frag_list,
                              ctx_idx,
-                             rowid_lookup_key);
+                             rowid_lookup_key,
+                             row_range);
     };
 
     QueryFragmentDescriptor fragment_descriptor(ra_exe_unit, query_infos);
@@ -1062,6 +1180,7 @@ ResultSetPtr Executor::executeWorkUnit(
     const QueryMemoryDescriptor& query_mem_desc =
         execution_dispatch.getQueryMemoryDescriptor();
     if (!options.just_validate) {
+      tracing::Span dispatch_span("execute_fragments");
       dispatchFragments(dispatch,
                         execution_dispatch,
                         options,
@@ -1074,7 +1193,12 @@ ResultSetPtr Executor::executeWorkUnit(
     if (options.with_dynamic_watchdog && interrupted_ && *error_code == ERR_OUT_OF_TIME) {
       *error_code = ERR_INTERRUPTED;
     }
+    if (interrupted_ && !*error_code) {
+      // Skip the reduction, the buffers of the fragments are released below.
+      *error_code = ERR_INTERRUPTED;
+    }
     cat.get_dataMgr().freeAllBuffers();
+    QueryMemoryAccount::releaseGpuBuffers();
     if (*error_code == ERR_OVERFLOW_OR_UNDERFLOW) {
       crt_min_byte_width <<= 1;
       continue;
@@ -1089,6 +1213,8 @@ ResultSetPtr Executor::executeWorkUnit(
     if (is_agg) {
       try {
         OOM_TRACE_PUSH();
+        QueryProfile::Timer reduction_timer(query_profile_,
+                                            QueryProfile::Phase::Reduction);
         return collectAllDeviceResults(execution_dispatch,
                                        ra_exe_unit.target_exprs,
                                        query_mem_desc,
@@ -1187,11 +1313,9 @@ void fill_entries_for_empty_input(std::vector<TargetInfo>& target_infos,
       const auto& count_distinct_desc =
           query_mem_desc.getCountDistinctDescriptor(target_idx);
       if (count_distinct_desc.impl_type_ == CountDistinctImplType::Bitmap) {
-        auto count_distinct_buffer = static_cast<int8_t*>(
-            checked_calloc(count_distinct_desc.bitmapPaddedSizeBytes(), 1));
         CHECK(row_set_mem_owner);
-        row_set_mem_owner->addCountDistinctBuffer(
-            count_distinct_buffer, count_distinct_desc.bitmapPaddedSizeBytes(), true);
+        auto count_distinct_buffer = row_set_mem_owner->allocateCountDistinctBuffer(
+            count_distinct_desc.bitmapPaddedSizeBytes());
         entry.push_back(reinterpret_cast<int64_t>(count_distinct_buffer));
         continue;
       }
@@ -1202,9 +1326,16 @@ void fill_entries_for_empty_input(std::vector<TargetInfo>& target_infos,
         entry.push_back(reinterpret_cast<int64_t>(count_distinct_set));
         continue;
       }
+      if (count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring) {
+        auto count_distinct_roaring = new RoaringBitmap();
+        row_set_mem_owner->addCountDistinctRoaring(count_distinct_roaring);
+        entry.push_back(reinterpret_cast<int64_t>(count_distinct_roaring));
+        continue;
+      }
     }
     const bool float_argument_input = takes_float_argument(agg_info);
-    if (agg_info.agg_kind == kCOUNT || agg_info.agg_kind == kAPPROX_COUNT_DISTINCT) {
+    if (agg_info.agg_kind == kCOUNT || is_approx_count_distinct(agg_info.agg_kind) ||
+        agg_info.agg_kind == kAPPROX_QUANTILE) {
       entry.push_back(0);
     } else if (agg_info.agg_kind == kAVG) {
       entry.push_back(inline_null_val(agg_info.agg_arg_type, float_argument_input));
@@ -1294,6 +1425,22 @@ ResultSetPtr Executor::collectAllDeviceResults(
   if (shard_count && !result_per_device.empty()) {
     return collectAllDeviceShardedTopResults(execution_dispatch);
   }
+  if (result_per_device.size() > 1 &&
+      use_top_count_pruning(ra_exe_unit, query_mem_desc)) {
+    std::vector<ResultSetPtr> partial_results;
+    for (const auto& result : result_per_device) {
+      partial_results.push_back(result.first);
+    }
+    const auto top_n = ra_exe_unit.sort_info.limit + ra_exe_unit.sort_info.offset;
+    const auto top_groups =
+        get_top_count_groups(partial_results, ra_exe_unit.target_exprs, top_n);
+    return top_n_entries_to_rows(top_groups,
+                                 top_groups.size(),
+                                 ra_exe_unit,
+                                 row_set_mem_owner,
+                                 query_mem_desc,
+                                 this);
+  }
   return reduceMultiDeviceResults(
       ra_exe_unit, result_per_device, row_set_mem_owner, query_mem_desc);
 }
@@ -1352,6 +1499,9 @@ std::unordered_map<int, const Analyzer::BinOper*> Executor::getInnerTabIdToJoinC
   const auto& join_info = plan_state_->join_info_;
   CHECK_EQ(join_info.equi_join_tautologies_.size(), join_info.join_hash_tables_.size());
   for (size_t i = 0; i < join_info.join_hash_tables_.size(); ++i) {
+    if (!join_info.equi_join_tautologies_[i]) {
+      continue;
+    }
     int inner_table_id = join_info.join_hash_tables_[i]->getInnerTableId();
     id_to_cond.insert(
         std::make_pair(inner_table_id, join_info.equi_join_tautologies_[i].get()));
@@ -1359,12 +1509,165 @@ std::unordered_map<int, const Analyzer::BinOper*> Executor::getInnerTabIdToJoinC
   return id_to_cond;
 }
 
+namespace {
+
+// Morsels of one fragment run as separate kernels, so restrict them to single table
+// aggregates whose per-kernel results are small or accumulate in a shared context.
+bool can_use_cpu_morsels(const RelAlgExecutionUnit& ra_exe_unit,
+                         const QueryMemoryDescriptor& query_mem_desc,
+                         const bool is_agg) {
+  return is_agg && ra_exe_unit.input_descs.size() == 1 && !ra_exe_unit.estimator &&
+         !ra_exe_unit.scan_limit &&
+         (ra_exe_unit.groupby_exprs.empty() || query_mem_desc.usesCachedContext());
+}
+
+const ColumnDescriptor* try_get_column_descriptor(const InputColDescriptor* col_desc,
+                                                  const Catalog_Namespace::Catalog& cat) {
+  const int table_id = col_desc->getScanDesc().getTableId();
+  const int col_id = col_desc->getColId();
+  return get_column_descriptor_maybe(col_id, table_id, cat);
+}
+
+}  // namespace
+
+namespace {
+
+// Rows per millisecond of a CPU and a GPU kernel, averaged over the hybrid queries.
+class HybridThroughput {
+ public:
+  static HybridThroughput& instance() {
+    static HybridThroughput throughput;
+    return throughput;
+  }
+
+  // Share of the rows the CPU kernels should take to finish along with the GPUs.
+  double cpuShare(const size_t cpu_kernel_count, const size_t gpu_kernel_count) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cpu_rows_per_ms_ <= 0 || gpu_rows_per_ms_ <= 0) {
+      // Nothing measured yet, start with an even split.
+      return 0.5;
+    }
+    const double cpu_rate = cpu_rows_per_ms_ * cpu_kernel_count;
+    return cpu_rate / (cpu_rate + gpu_rows_per_ms_ * gpu_kernel_count);
+  }
+
+  void record(const ExecutorDeviceType device_type,
+              const size_t row_count,
+              const int64_t elapsed_ms) {
+    const double rows_per_ms =
+        static_cast<double>(row_count) / std::max<int64_t>(elapsed_ms, 1);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& average =
+        device_type == ExecutorDeviceType::GPU ? gpu_rows_per_ms_ : cpu_rows_per_ms_;
+    average = average <= 0 ? rows_per_ms : 0.8 * average + 0.2 * rows_per_ms;
+  }
+
+ private:
+  HybridThroughput() : cpu_rows_per_ms_(0), gpu_rows_per_ms_(0) {}
+
+  double cpu_rows_per_ms_;
+  double gpu_rows_per_ms_;
+  mutable std::mutex mutex_;
+};
+
+size_t count_outer_rows(
+    const FragmentsList& frag_list,
+    const std::map<int, const TableFragments*>& all_tables_fragments) {
+  CHECK(!frag_list.empty());
+  const auto fragments_it = all_tables_fragments.find(frag_list.front().table_id);
+  CHECK(fragments_it != all_tables_fragments.end());
+  size_t row_count{0};
+  for (const auto frag_id : frag_list.front().fragment_ids) {
+    CHECK_LT(frag_id, fragments_it->second->size());
+    row_count += (*fragments_it->second)[frag_id].getNumTuples();
+  }
+  return row_count;
+}
+
+}  // namespace
+
+namespace {
+
+// Chunks holding the columns the query reads from the fragment, the payload only for
+// the variable length ones since the offsets go along, with their size.
+std::vector<std::pair<ChunkKey, size_t>> get_fragment_input_chunks(
+    const RelAlgExecutionUnit& ra_exe_unit,
+    const Fragmenter_Namespace::FragmentInfo& fragment,
+    const Catalog_Namespace::Catalog& cat) {
+  std::vector<std::pair<ChunkKey, size_t>> chunks;
+  const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+  for (const auto& col_desc : ra_exe_unit.input_col_descs) {
+    if (col_desc->getScanDesc().getSourceType() != InputSourceType::TABLE) {
+      continue;
+    }
+    const auto cd = try_get_column_descriptor(col_desc.get(), cat);
+    if (!cd || cd->isVirtualCol) {
+      continue;
+    }
+    ChunkKey chunk_key{cat.get_currentDB().dbId,
+                       fragment.physicalTableId,
+                       col_desc->getColId(),
+                       fragment.fragmentId};
+    if (cd->columnType.is_varlen() && !cd->columnType.is_fixlen_array()) {
+      chunk_key.push_back(1);
+    }
+    const auto chunk_metadata_it = chunk_metadata_map.find(col_desc->getColId());
+    chunks.emplace_back(chunk_key,
+                        chunk_metadata_it != chunk_metadata_map.end()
+                            ? chunk_metadata_it->second.numBytes
+                            : size_t(0));
+  }
+  return chunks;
+}
+
+}  // namespace
+
+bool Executor::isFragmentOnDevice(const RelAlgExecutionUnit& ra_exe_unit,
+                                  const Fragmenter_Namespace::FragmentInfo& fragment,
+                                  const int device_id) const {
+  auto& data_mgr = catalog_->get_dataMgr();
+  for (const auto& chunk : get_fragment_input_chunks(ra_exe_unit, fragment, *catalog_)) {
+    if (!data_mgr.isBufferOnDevice(chunk.first, Data_Namespace::GPU_LEVEL, device_id)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::pair<size_t, std::vector<size_t>> Executor::getFragmentGpuResidency(
+    const RelAlgExecutionUnit& ra_exe_unit,
+    const Fragmenter_Namespace::FragmentInfo& fragment,
+    const int device_count) const {
+  auto& data_mgr = catalog_->get_dataMgr();
+  size_t total_bytes{0};
+  std::vector<size_t> resident_bytes(device_count, 0);
+  for (const auto& chunk : get_fragment_input_chunks(ra_exe_unit, fragment, *catalog_)) {
+    total_bytes += chunk.second;
+    for (int device_id = 0; device_id < device_count; ++device_id) {
+      if (data_mgr.isBufferOnDevice(chunk.first, Data_Namespace::GPU_LEVEL, device_id)) {
+        resident_bytes[device_id] += chunk.second;
+      }
+    }
+  }
+  return {total_bytes, resident_bytes};
+}
+
+std::vector<size_t> Executor::getGpuFreeMemory(const int device_count) const {
+  auto& data_mgr = catalog_->get_dataMgr();
+  std::vector<size_t> free_bytes;
+  for (int device_id = 0; device_id < device_count; ++device_id) {
+    free_bytes.push_back(data_mgr.getFreeMemory(Data_Namespace::GPU_LEVEL, device_id));
+  }
+  return free_bytes;
+}
+
 void Executor::dispatchFragments(
     const std::function<void(const ExecutorDeviceType chosen_device_type,
                              int chosen_device_id,
                              const FragmentsList& frag_list,
                              const size_t ctx_idx,
-                             const int64_t rowid_lookup_key)> dispatch,
+                             const int64_t rowid_lookup_key,
+                             const RowRange& row_range)> dispatch,
     const ExecutionDispatch& execution_dispatch,
     const ExecutionOptions& eo,
     const bool is_agg,
@@ -1387,8 +1690,12 @@ void Executor::dispatchFragments(
        query_mem_desc.getQueryDescriptionType() ==
            QueryDescriptionType::GroupByBaselineHash ||
        query_mem_desc.getQueryDescriptionType() == QueryDescriptionType::Projection);
+  // On CPU, a kernel per thread processes a share of the fragments into one output
+  // buffer, instead of a kernel and a buffer to reduce for every fragment.
   const bool use_multifrag_kernel =
-      (device_type == ExecutorDeviceType::GPU) && allow_multifrag && is_agg;
+      (device_type == ExecutorDeviceType::GPU ||
+       (g_enable_cpu_multifrag_kernels && !execution_dispatch.isHybrid())) &&
+      allow_multifrag && is_agg;
 
   const auto device_count = device_type == ExecutorDeviceType::CPU
                                 ? 1
@@ -1401,26 +1708,204 @@ void Executor::dispatchFragments(
                                              device_type,
                                              use_multifrag_kernel,
                                              g_inner_join_fragment_skipping,
-                                             this);
+                                             this,
+                                             eo.gpu_wave_bytes);
   if (eo.with_watchdog && fragment_descriptor.shouldCheckWorkUnitWatchdog()) {
     checkWorkUnitWatchdog(ra_exe_unit, *catalog_);
   }
 
-  if (use_multifrag_kernel) {
+  std::map<int, const TableFragments*> all_tables_fragments;
+  std::atomic<bool> prefetch_cancelled{false};
+  std::vector<std::future<void>> prefetch_threads;
+  ScopeGuard prefetch_guard = [&prefetch_cancelled, &prefetch_threads] {
+    prefetch_cancelled = true;
+    threadpool::wait_all(prefetch_threads);
+  };
+  if (device_type == ExecutorDeviceType::GPU && g_enable_chunk_prefetch &&
+      !fragment_descriptor.hasRowidLookup()) {
+    // Load the chunks from disk while the kernels copy and process the fragments
+    // already in the CPU pool.
+    std::vector<FragmentsList> kernel_frag_lists;
+    auto collect_frag_list = [&kernel_frag_lists](const int device_id,
+                                                  const FragmentsList& frag_list,
+                                                  const int64_t rowid_lookup_key) {
+      kernel_frag_lists.push_back(frag_list);
+    };
+    if (use_multifrag_kernel) {
+      fragment_descriptor.assignFragsToMultiDispatch(collect_frag_list);
+    } else {
+      fragment_descriptor.assignFragsToKernelDispatch(collect_frag_list, ra_exe_unit);
+    }
+    QueryFragmentDescriptor::computeAllTablesFragments(
+        all_tables_fragments, ra_exe_unit, execution_dispatch.getQueryInfos());
+    prefetch_threads.push_back(threadpool::ThreadPool::instance().submit(
+        [this, &ra_exe_unit, &all_tables_fragments, &prefetch_cancelled](
+            const std::vector<FragmentsList>& kernel_frag_lists) {
+          prefetchChunks(
+              ra_exe_unit, kernel_frag_lists, all_tables_fragments, prefetch_cancelled);
+        },
+        std::move(kernel_frag_lists)));
+  }
+
+  // In hybrid mode the CPU takes over part of the outer fragments of each GPU kernel,
+  // the ones not resident on the GPU first, in proportion to the measured throughputs.
+  const bool use_hybrid =
+      execution_dispatch.isHybrid() && !fragment_descriptor.hasRowidLookup();
+  std::map<int, const TableFragments*> hybrid_tables_fragments;
+  double hybrid_cpu_share{0};
+  if (use_hybrid) {
+    QueryFragmentDescriptor::computeAllTablesFragments(
+        hybrid_tables_fragments, ra_exe_unit, execution_dispatch.getQueryInfos());
+    hybrid_cpu_share = HybridThroughput::instance().cpuShare(
+        std::max(available_cpus, 1), std::max<size_t>(available_gpus.size(), 1));
+    VLOG(1) << "Hybrid execution, CPU share of the rows: " << hybrid_cpu_share;
+  }
+  auto timed_dispatch = [&dispatch, &hybrid_tables_fragments](
+                            const ExecutorDeviceType chosen_device_type,
+                            int chosen_device_id,
+                            const FragmentsList& frag_list,
+                            const size_t ctx_idx,
+                            const int64_t rowid_lookup_key,
+                            const RowRange& row_range) {
+    auto clock_begin = timer_start();
+    dispatch(chosen_device_type,
+             chosen_device_id,
+             frag_list,
+             ctx_idx,
+             rowid_lookup_key,
+             row_range);
+    HybridThroughput::instance().record(
+        chosen_device_type,
+        count_outer_rows(frag_list, hybrid_tables_fragments),
+        timer_stop(clock_begin));
+  };
+  // Dispatches the fragments taken over by the CPU, one kernel each, and returns the
+  // fragment list left for the GPU.
+  auto split_off_cpu_fragments = [this,
+                                  &ra_exe_unit,
+                                  &hybrid_tables_fragments,
+                                  hybrid_cpu_share,
+                                  &query_threads,
+                                  &timed_dispatch](const int device_id,
+                                                   const FragmentsList& frag_list) {
+    CHECK_EQ(size_t(1), frag_list.size());
+    const auto& outer_frags = frag_list.front();
+    const auto fragments_it = hybrid_tables_fragments.find(outer_frags.table_id);
+    CHECK(fragments_it != hybrid_tables_fragments.end());
+    const auto& fragments = *fragments_it->second;
+    std::vector<size_t> resident_frag_ids;
+    std::vector<size_t> moved_frag_ids;
+    for (const auto frag_id : outer_frags.fragment_ids) {
+      CHECK_LT(frag_id, fragments.size());
+      if (isFragmentOnDevice(ra_exe_unit, fragments[frag_id], device_id)) {
+        resident_frag_ids.push_back(frag_id);
+      } else {
+        moved_frag_ids.push_back(frag_id);
+      }
+    }
+    const auto target_cpu_rows = static_cast<size_t>(
+        hybrid_cpu_share * count_outer_rows(frag_list, hybrid_tables_fragments));
+    std::vector<size_t> gpu_frag_ids;
+    size_t cpu_rows{0};
+    for (const auto frag_id : moved_frag_ids) {
+      if (cpu_rows < target_cpu_rows) {
+        cpu_rows += fragments[frag_id].getNumTuples();
+        query_threads.push_back(threadpool::ThreadPool::instance().submit(
+            timed_dispatch,
+            ExecutorDeviceType::CPU,
+            0,
+            FragmentsList{{outer_frags.table_id, {frag_id}}},
+            0,
+            -1,
+            RowRange{0, 0}));
+      } else {
+        gpu_frag_ids.push_back(frag_id);
+      }
+    }
+    gpu_frag_ids.insert(
+        gpu_frag_ids.end(), resident_frag_ids.begin(), resident_frag_ids.end());
+    std::sort(gpu_frag_ids.begin(), gpu_frag_ids.end());
+    return gpu_frag_ids.empty() ? FragmentsList{}
+                                : FragmentsList{{outer_frags.table_id, gpu_frag_ids}};
+  };
+
+  if (device_type == ExecutorDeviceType::CPU && g_enable_cpu_morsels &&
+      can_use_cpu_morsels(ra_exe_unit, query_mem_desc, is_agg) &&
+      !fragment_descriptor.hasRowidLookup()) {
+    // Workers pull row ranges from a shared cursor until all of them are processed,
+    // which keeps the cores busy regardless of the number and the size of fragments.
+    const auto morsels = fragment_descriptor.buildMorsels(g_cpu_morsel_size);
+    std::atomic<size_t> morsel_cursor{0};
+    const auto worker_count = std::min(
+        std::min(morsels.size(), threadpool::ThreadPool::instance().workerCount()),
+        context_count);
+    for (size_t worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
+      query_threads.push_back(threadpool::ThreadPool::instance().submit(
+          [&dispatch, &morsels, &morsel_cursor, worker_idx] {
+            while (true) {
+              const auto morsel_idx = morsel_cursor.fetch_add(1);
+              if (morsel_idx >= morsels.size()) {
+                break;
+              }
+              const auto& morsel = morsels[morsel_idx];
+              dispatch(ExecutorDeviceType::CPU,
+                       morsel.device_id,
+                       morsel.frag_list,
+                       worker_idx,
+                       -1,
+                       morsel.rows);
+            }
+          }));
+    }
+  } else if (use_multifrag_kernel) {
     // NB: We should never be on this path when the query is retried because of
     //     running out of group by slots; also, for scan only queries (!agg_plan)
     //     we want the high-granularity, fragment by fragment execution instead.
-    auto multifrag_kernel_dispatch = [&query_threads, &dispatch, &context_count](
+    size_t kernel_idx{0};
+    auto multifrag_kernel_dispatch = [&query_threads,
+                                      &dispatch,
+                                      &context_count,
+                                      &kernel_idx,
+                                      &device_type,
+                                      use_hybrid,
+                                      &timed_dispatch,
+                                      &split_off_cpu_fragments](
                                          const int device_id,
                                          const FragmentsList& frag_list,
                                          const int64_t rowid_lookup_key) {
-      query_threads.push_back(std::async(std::launch::async,
-                                         dispatch,
-                                         ExecutorDeviceType::GPU,
-                                         device_id,
-                                         frag_list,
-                                         device_id % context_count,
-                                         rowid_lookup_key));
+      if (device_type == ExecutorDeviceType::CPU) {
+        query_threads.push_back(
+            threadpool::ThreadPool::instance().submit(dispatch,
+                                                      ExecutorDeviceType::CPU,
+                                                      device_id,
+                                                      frag_list,
+                                                      kernel_idx++ % context_count,
+                                                      rowid_lookup_key,
+                                                      RowRange{0, 0}));
+        return;
+      }
+      if (use_hybrid) {
+        const auto gpu_frag_list = split_off_cpu_fragments(device_id, frag_list);
+        if (!gpu_frag_list.empty()) {
+          query_threads.push_back(
+              threadpool::ThreadPool::instance().submit(timed_dispatch,
+                                                        ExecutorDeviceType::GPU,
+                                                        device_id,
+                                                        gpu_frag_list,
+                                                        device_id % context_count,
+                                                        rowid_lookup_key,
+                                                        RowRange{0, 0}));
+        }
+        return;
+      }
+      query_threads.push_back(
+          threadpool::ThreadPool::instance().submit(dispatch,
+                                                    ExecutorDeviceType::GPU,
+                                                    device_id,
+                                                    frag_list,
+                                                    device_id % context_count,
+                                                    rowid_lookup_key,
+                                                    RowRange{0, 0}));
     };
     fragment_descriptor.assignFragsToMultiDispatch(multifrag_kernel_dispatch);
 
@@ -1428,22 +1913,45 @@ void Executor::dispatchFragments(
     size_t frag_list_idx{0};
 
     auto fragment_per_kernel_dispatch =
-        [&query_threads, &dispatch, &context_count, &frag_list_idx, &device_type](
-            const int device_id,
-            const FragmentsList& frag_list,
-            const int64_t rowid_lookup_key) {
+        [&query_threads,
+         &dispatch,
+         &context_count,
+         &frag_list_idx,
+         &device_type,
+         use_hybrid,
+         &timed_dispatch,
+         &split_off_cpu_fragments](const int device_id,
+                                   const FragmentsList& frag_list,
+                                   const int64_t rowid_lookup_key) {
           if (!frag_list.size()) {
             return;
           }
           CHECK_GE(device_id, 0);
 
-          query_threads.push_back(std::async(std::launch::async,
-                                             dispatch,
-                                             device_type,
-                                             device_id,
-                                             frag_list,
-                                             frag_list_idx % context_count,
-                                             rowid_lookup_key));
+          if (use_hybrid) {
+            const auto gpu_frag_list = split_off_cpu_fragments(device_id, frag_list);
+            if (!gpu_frag_list.empty()) {
+              query_threads.push_back(
+                  threadpool::ThreadPool::instance().submit(timed_dispatch,
+                                                            device_type,
+                                                            device_id,
+                                                            gpu_frag_list,
+                                                            frag_list_idx % context_count,
+                                                            rowid_lookup_key,
+                                                            RowRange{0, 0}));
+              ++frag_list_idx;
+            }
+            return;
+          }
+
+          query_threads.push_back(
+              threadpool::ThreadPool::instance().submit(dispatch,
+                                                        device_type,
+                                                        device_id,
+                                                        frag_list,
+                                                        frag_list_idx % context_count,
+                                                        rowid_lookup_key,
+                                                        RowRange{0, 0}));
 
           ++frag_list_idx;
         };
@@ -1451,11 +1959,92 @@ void Executor::dispatchFragments(
     fragment_descriptor.assignFragsToKernelDispatch(fragment_per_kernel_dispatch,
                                                     ra_exe_unit);
   }
-  for (auto& child : query_threads) {
-    child.wait();
-  }
-  for (auto& child : query_threads) {
-    child.get();
+  threadpool::wait_all(query_threads);
+}
+
+void Executor::prefetchChunks(
+    const RelAlgExecutionUnit& ra_exe_unit,
+    const std::vector<FragmentsList>& kernel_frag_lists,
+    const std::map<int, const TableFragments*>& all_tables_fragments,
+    const std::atomic<bool>& cancelled) {
+  auto& data_mgr = catalog_->get_dataMgr();
+  const auto cpu_memory_info = data_mgr.getMemoryInfo(Data_Namespace::CPU_LEVEL);
+  CHECK_EQ(cpu_memory_info.size(), size_t(1));
+  // Don't let the prefetched chunks evict the ones the kernels are about to use.
+  const size_t max_prefetch_bytes =
+      cpu_memory_info.front().maxNumPages * cpu_memory_info.front().pageSize / 2;
+  size_t prefetched_bytes{0};
+  std::set<ChunkKey> prefetched_keys;
+  // Visit the kernels round-robin by position, the devices consume their fragments
+  // in parallel.
+  for (size_t pos = 0;; ++pos) {
+    bool found_fragments = false;
+    for (const auto& frag_list : kernel_frag_lists) {
+      for (const auto& table_frags : frag_list) {
+        if (pos >= table_frags.fragment_ids.size() || table_frags.table_id <= 0) {
+          continue;
+        }
+        found_fragments = true;
+        const auto fragments_it = all_tables_fragments.find(table_frags.table_id);
+        CHECK(fragments_it != all_tables_fragments.end());
+        const auto frag_id = table_frags.fragment_ids[pos];
+        CHECK_LT(frag_id, fragments_it->second->size());
+        const auto& fragment = (*fragments_it->second)[frag_id];
+        if (fragment.isEmptyPhysicalFragment()) {
+          continue;
+        }
+        for (const auto& col_desc : ra_exe_unit.input_col_descs) {
+          if (cancelled || interrupted_) {
+            return;
+          }
+          if (col_desc->getScanDesc().getTableId() != table_frags.table_id ||
+              col_desc->getScanDesc().getSourceType() != InputSourceType::TABLE) {
+            continue;
+          }
+          const auto cd = try_get_column_descriptor(col_desc.get(), *catalog_);
+          // Variable length chunks are fetched under a lock by the kernels, leave them
+          // alone.
+          if (!cd || cd->isVirtualCol || cd->columnType.is_array() ||
+              (cd->columnType.is_string() &&
+               cd->columnType.get_compression() == kENCODING_NONE)) {
+            continue;
+          }
+          const auto chunk_meta_it =
+              fragment.getChunkMetadataMap().find(col_desc->getColId());
+          if (chunk_meta_it == fragment.getChunkMetadataMap().end()) {
+            continue;
+          }
+          ChunkKey chunk_key{catalog_->get_currentDB().dbId,
+                             fragment.physicalTableId,
+                             col_desc->getColId(),
+                             fragment.fragmentId};
+          if (!prefetched_keys.insert(chunk_key).second) {
+            continue;
+          }
+          prefetched_bytes += chunk_meta_it->second.numBytes;
+          if (prefetched_bytes > max_prefetch_bytes) {
+            return;
+          }
+          try {
+            // The chunk stays in the pool once it's unpinned.
+            Chunk_NS::Chunk::getChunk(cd,
+                                      &data_mgr,
+                                      chunk_key,
+                                      Data_Namespace::CPU_LEVEL,
+                                      0,
+                                      chunk_meta_it->second.numBytes,
+                                      chunk_meta_it->second.numElements);
+          } catch (const std::exception& e) {
+            // Not fatal, the kernel fetches the chunk itself.
+            LOG(INFO) << "Chunk prefetch stopped: " << e.what();
+            return;
+          }
+        }
+      }
+    }
+    if (!found_fragments) {
+      break;
+    }
   }
 }
 
@@ -1560,17 +2149,6 @@ bool Executor::skipFragmentPair(
   return shard_count;
 }
 
-namespace {
-
-const ColumnDescriptor* try_get_column_descriptor(const InputColDescriptor* col_desc,
-                                                  const Catalog_Namespace::Catalog& cat) {
-  const int table_id = col_desc->getScanDesc().getTableId();
-  const int col_id = col_desc->getColId();
-  return get_column_descriptor_maybe(col_id, table_id, cat);
-}
-
-}  // namespace
-
 std::map<size_t, std::vector<uint64_t>> get_table_id_to_frag_offsets(
     const std::vector<InputDescriptor>& input_descs,
     const std::map<int, const TableFragments*>& all_tables_fragments) {
@@ -1692,6 +2270,8 @@ Executor::FetchResult Executor::fetchChunks(
         plan_state_->global_to_local_col_ids_.size());
     for (const auto& col_id : col_global_ids) {
       CHECK(col_id);
+      // Every column can be read from disk and copied to the device.
+      checkInterrupted();
       const int table_id = col_id->getScanDesc().getTableId();
       const auto cd = try_get_column_descriptor(col_id.get(), cat);
       bool is_rowid = false;
@@ -1734,6 +2314,16 @@ Executor::FetchResult Executor::fetchChunks(
                                                        all_tables_fragments,
                                                        memory_level_for_column,
                                                        device_id);
+        } else if (col_id->getScanDesc().getNestLevel() > 0 && cd &&
+                   cd->columnType.get_compression() == kENCODING_DIFF) {
+          // Kernels only decode the DIFF encoded columns of the outer table.
+          frag_col_buffers[it->second] =
+              execution_dispatch.getDecodedScanColumn(table_id,
+                                                      frag_id,
+                                                      col_id->getColId(),
+                                                      all_tables_fragments,
+                                                      memory_level_for_column,
+                                                      device_id);
         } else {
           frag_col_buffers[it->second] =
               execution_dispatch.getScanColumn(table_id,
@@ -1831,7 +2421,8 @@ class AggregateReductionEgress {
     int64_t val1;
     const bool float_argument_input = takes_float_argument(agg_info);
     if (is_distinct_target(agg_info)) {
-      CHECK(agg_info.agg_kind == kCOUNT || agg_info.agg_kind == kAPPROX_COUNT_DISTINCT);
+      CHECK(agg_info.agg_kind == kCOUNT || is_approx_count_distinct(agg_info.agg_kind) ||
+            agg_info.agg_kind == kAPPROX_QUANTILE);
       val1 = out_vec[out_vec_idx][0];
       error_code = 0;
     } else {
@@ -1949,7 +2540,7 @@ int32_t Executor::executePlanWithoutGroupBy(
   const auto hoist_buf = serializeLiterals(compilation_result.literal_values, device_id);
   const auto join_hash_table_ptrs = getJoinHashTablePtrs(device_type, device_id);
   std::unique_ptr<OutVecOwner> output_memory_scope;
-  if (g_enable_dynamic_watchdog && interrupted_) {
+  if (interrupted_) {
     return ERR_INTERRUPTED;
   }
   if (device_type == ExecutorDeviceType::CPU) {
@@ -2092,7 +2683,7 @@ int32_t Executor::executePlanWithGroupBy(
   auto hoist_buf = serializeLiterals(compilation_result.literal_values, device_id);
   int32_t error_code = device_type == ExecutorDeviceType::GPU ? 0 : start_rowid;
   const auto join_hash_table_ptrs = getJoinHashTablePtrs(device_type, device_id);
-  if (g_enable_dynamic_watchdog && interrupted_) {
+  if (interrupted_) {
     return ERR_INTERRUPTED;
   }
 
@@ -2188,6 +2779,85 @@ std::vector<int64_t> Executor::getJoinHashTablePtrs(const ExecutorDeviceType dev
   return table_ptrs;
 }
 
+// Returns the address of the copy of the dictionary on each device, copying it there if
+// it isn't yet or misses strings the query can see. Empty if they don't fit in memory.
+std::vector<int64_t> Executor::getGpuStringDictionaryBuffers(const int dict_id) {
+  CHECK(catalog_);
+  const auto dd = catalog_->getMetadataForDict(dict_id);
+  CHECK(dd);
+  CHECK(dd->stringDict);
+  const auto generation = string_dictionary_generations_.getGeneration(dict_id);
+  const size_t str_count = generation >= 0
+                               ? static_cast<size_t>(generation)
+                               : dd->stringDict->storageEntryCount();
+  auto& data_mgr = catalog_->get_dataMgr();
+  const int device_count = deviceCount(ExecutorDeviceType::GPU);
+  std::vector<int8_t> host_dict;
+  std::vector<int64_t> dict_buffers;
+  for (int device_id = 0; device_id < device_count; ++device_id) {
+    const auto key = std::make_pair(dict_id, device_id);
+    auto it = gpu_string_dictionaries_.find(key);
+    // the strings are never changed, a copy with more of them serves the query as well
+    if (it != gpu_string_dictionaries_.end() && it->second.str_count >= str_count) {
+      dict_buffers.push_back(
+          reinterpret_cast<int64_t>(it->second.buffer->getMemoryPtr()));
+      continue;
+    }
+    if (it != gpu_string_dictionaries_.end()) {
+      free_gpu_abstract_buffer(it->second.data_mgr, it->second.buffer);
+      gpu_string_dictionaries_.erase(it);
+    }
+    if (host_dict.empty()) {
+      std::vector<int64_t> offsets(str_count + 1, 0);
+      for (size_t string_id = 0; string_id < str_count; ++string_id) {
+        offsets[string_id + 1] =
+            offsets[string_id] + dd->stringDict->getStringBytes(string_id).second;
+      }
+      const size_t header_bytes = (offsets.size() + 1) * sizeof(int64_t);
+      host_dict.resize(header_bytes + offsets.back());
+      const int64_t str_count_header = str_count;
+      memcpy(&host_dict[0], &str_count_header, sizeof(int64_t));
+      memcpy(&host_dict[sizeof(int64_t)], &offsets[0], offsets.size() * sizeof(int64_t));
+      for (size_t string_id = 0; string_id < str_count; ++string_id) {
+        const auto str = dd->stringDict->getStringBytes(string_id);
+        memcpy(&host_dict[header_bytes + offsets[string_id]], str.first, str.second);
+      }
+    }
+    Data_Namespace::AbstractBuffer* buffer{nullptr};
+    try {
+      buffer = alloc_gpu_abstract_buffer(&data_mgr, host_dict.size(), device_id);
+    } catch (const OutOfMemory& e) {
+      LOG(INFO) << "Dictionary " << dict_id << " doesn't fit on device " << device_id
+                << ": " << e.what();
+      return {};
+    }
+    copy_to_gpu(&data_mgr,
+                reinterpret_cast<CUdeviceptr>(buffer->getMemoryPtr()),
+                &host_dict[0],
+                host_dict.size(),
+                device_id);
+    gpu_string_dictionaries_.emplace(key,
+                                     GpuStringDictionary{&data_mgr, buffer, str_count});
+    dict_buffers.push_back(reinterpret_cast<int64_t>(buffer->getMemoryPtr()));
+  }
+  return dict_buffers;
+}
+
+void Executor::freeGpuStringDictionaries() {
+  for (const auto& gpu_dict : gpu_string_dictionaries_) {
+    free_gpu_abstract_buffer(gpu_dict.second.data_mgr, gpu_dict.second.buffer);
+  }
+  gpu_string_dictionaries_.clear();
+}
+
+void Executor::clearGpuStringDictionaries() {
+  std::lock_guard<std::mutex> flush_lock(execute_mutex_);
+  mapd_shared_lock<mapd_shared_mutex> read_lock(executors_cache_mutex_);
+  for (auto& executor : executors_) {
+    executor.second->freeGpuStringDictionaries();
+  }
+}
+
 namespace {
 
 template <class T>
@@ -2488,10 +3158,13 @@ void Executor::executeSimpleInsert(const Planner::RootPlan* root_plan) {
     insert_data.data.push_back(p);
   }
   insert_data.numRows = 1;
-  if (shard) {
-    shard->fragmenter->insertData(insert_data);
+  const auto fragmenter = shard ? shard->fragmenter : table_descriptor->fragmenter;
+  if (g_insert_commit_interval_ms) {
+    // the row is visible right away, only its checkpoint is batched with the next ones
+    fragmenter->insertDataDeferCheckpoint(
+        insert_data, g_insert_commit_interval_ms, g_insert_commit_max_rows);
   } else {
-    table_descriptor->fragmenter->insertData(insert_data);
+    fragmenter->insertData(insert_data);
   }
 }
 
@@ -2507,7 +3180,7 @@ void Executor::nukeOldState(const bool allow_lazy_fetch,
                    }) != ra_exe_unit.inner_joins.end();
   cgen_state_.reset(new CgenState(query_infos, contains_left_deep_outer_join));
   plan_state_.reset(
-      new PlanState(allow_lazy_fetch && !contains_left_deep_outer_join, join_info, this));
+      new PlanState(allow_lazy_fetch, contains_left_deep_outer_join, join_info, this));
 }
 
 void Executor::preloadFragOffsets(const std::vector<InputDescriptor>& input_descs,
@@ -2602,7 +3275,10 @@ unsigned Executor::gridSize() const {
   CHECK(catalog_);
   CHECK(catalog_->get_dataMgr().cudaMgr_);
   const auto& dev_props = catalog_->get_dataMgr().cudaMgr_->deviceProperties;
-  return grid_size_x_ ? grid_size_x_ : 2 * dev_props.front().numMPs;
+  if (grid_size_x_) {
+    return grid_size_x_;
+  }
+  return launch_grid_size_ ? launch_grid_size_ : 2 * dev_props.front().numMPs;
 }
 
 unsigned Executor::blockSize() const {
@@ -2612,6 +3288,46 @@ unsigned Executor::blockSize() const {
   return block_size_x_ ? block_size_x_ : dev_props.front().maxThreadsPerBlock;
 }
 
+void Executor::tuneGridSize(const QueryMemoryDescriptor& query_mem_desc) {
+  CHECK(catalog_);
+  CHECK(catalog_->get_dataMgr().cudaMgr_);
+  const auto& dev_props = catalog_->get_dataMgr().cudaMgr_->deviceProperties;
+  CHECK(!dev_props.empty());
+  std::string kernel_kind;
+  switch (query_mem_desc.getQueryDescriptionType()) {
+    case QueryDescriptionType::GroupByPerfectHash:
+      kernel_kind = "perfect_hash_group_by";
+      break;
+    case QueryDescriptionType::GroupByBaselineHash:
+      kernel_kind = "baseline_hash_group_by";
+      break;
+    case QueryDescriptionType::Projection:
+      kernel_kind = "projection";
+      break;
+    case QueryDescriptionType::NonGroupedAggregate:
+      kernel_kind = "aggregate";
+      break;
+    case QueryDescriptionType::Estimator:
+      kernel_kind = "estimator";
+      break;
+  }
+  const bool buffers_per_block =
+      query_mem_desc.isGroupBy() && !query_mem_desc.blocksShareMemory();
+  launch_shape_key_ = kernel_kind + (buffers_per_block ? "_per_block" : "") + "_sm" +
+                      std::to_string(dev_props.front().computeMajor) +
+                      std::to_string(dev_props.front().computeMinor) + "_block" +
+                      std::to_string(blockSize());
+  // The output buffers of every block take memory, which the compilation checked
+  // against the default grid: tune below it only.
+  const unsigned num_mps = dev_props.front().numMPs;
+  std::vector<unsigned> candidate_grid_sizes{num_mps, 2 * num_mps};
+  if (!buffers_per_block) {
+    candidate_grid_sizes.push_back(4 * num_mps);
+  }
+  launch_grid_size_ =
+      GpuLaunchTuner::instance().getGridSize(launch_shape_key_, candidate_grid_sizes);
+}
+
 int64_t Executor::deviceCycles(int milliseconds) const {
   CHECK(catalog_);
   CHECK(catalog_->get_dataMgr().cudaMgr_);
@@ -2804,6 +3520,8 @@ std::pair<bool, int64_t> Executor::skipFragment(
     auto chunk_meta_it = fragment.getChunkMetadataMap().find(col_id);
     int64_t chunk_min{0};
     int64_t chunk_max{0};
+    const ChunkBloomFilter* bloom_filter{nullptr};
+    const ChunkKeyIndex* key_index{nullptr};
     bool is_rowid{false};
     size_t start_rowid{0};
     if (chunk_meta_it == fragment.getChunkMetadataMap().end()) {
@@ -2820,6 +3538,8 @@ std::pair<bool, int64_t> Executor::skipFragment(
       const auto& chunk_type = lhs_col->get_type_info();
       chunk_min = extract_min_stat(chunk_meta_it->second.chunkStats, chunk_type);
       chunk_max = extract_max_stat(chunk_meta_it->second.chunkStats, chunk_type);
+      bloom_filter = chunk_meta_it->second.bloomFilter.get();
+      key_index = chunk_meta_it->second.keyIndex.get();
     }
     const auto rhs_val = codegenIntConst(rhs_const)->getSExtValue();
     switch (comp_expr->get_optype()) {
@@ -2846,6 +3566,10 @@ std::pair<bool, int64_t> Executor::skipFragment(
       case kEQ:
         if (chunk_min > rhs_val || chunk_max < rhs_val) {
           return {true, -1};
+        } else if (bloom_filter && !bloom_filter->mayContain(rhs_val)) {
+          return {true, -1};
+        } else if (key_index && !key_index->contains(rhs_val)) {
+          return {true, -1};
         } else if (is_rowid) {
           return {false, rhs_val - start_rowid};
         }
@@ -2857,6 +3581,138 @@ std::pair<bool, int64_t> Executor::skipFragment(
   return {false, -1};
 }
 
+namespace {
+
+// Whether the fragments are a copy of the ones of the table info, without comparing
+// them all.
+bool same_fragments(const std::deque<Fragmenter_Namespace::FragmentInfo>& lhs,
+                    const std::deque<Fragmenter_Namespace::FragmentInfo>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  if (lhs.empty()) {
+    return true;
+  }
+  const auto same_fragment = [](const Fragmenter_Namespace::FragmentInfo& a,
+                                const Fragmenter_Namespace::FragmentInfo& b) {
+    return a.fragmentId == b.fragmentId && a.physicalTableId == b.physicalTableId &&
+           a.getPhysicalNumTuples() == b.getPhysicalNumTuples();
+  };
+  return same_fragment(lhs.front(), rhs.front()) && same_fragment(lhs.back(), rhs.back());
+}
+
+}  // namespace
+
+boost::optional<std::vector<size_t>> Executor::getCandidateFragments(
+    const InputDescriptor& table_desc,
+    const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
+    const std::list<std::shared_ptr<Analyzer::Expr>>& simple_quals) {
+  const int table_id = table_desc.getTableId();
+  if (!g_enable_table_metadata_cache || simple_quals.empty() ||
+      table_desc.getSourceType() != InputSourceType::TABLE || table_id <= 0) {
+    return boost::none;
+  }
+  // The quals skipFragment checks against the chunk stats, intersected by column.
+  std::map<int, std::pair<int64_t, int64_t>> col_intervals;
+  std::map<int, SQLTypeInfo> col_types;
+  for (const auto& simple_qual : simple_quals) {
+    const auto comp_expr =
+        std::dynamic_pointer_cast<const Analyzer::BinOper>(simple_qual);
+    if (!comp_expr) {
+      return boost::none;
+    }
+    const auto lhs = comp_expr->get_left_operand();
+    auto lhs_col = dynamic_cast<const Analyzer::ColumnVar*>(lhs);
+    if (!lhs_col || !lhs_col->get_table_id() || lhs_col->get_rte_idx()) {
+      const auto lhs_uexpr = dynamic_cast<const Analyzer::UOper*>(lhs);
+      lhs_col = lhs_uexpr
+                    ? dynamic_cast<const Analyzer::ColumnVar*>(lhs_uexpr->get_operand())
+                    : nullptr;
+      if (!lhs_col || !lhs_col->get_table_id() || lhs_col->get_rte_idx()) {
+        continue;
+      }
+    }
+    const auto rhs_const =
+        dynamic_cast<const Analyzer::Constant*>(comp_expr->get_right_operand());
+    if (!rhs_const) {
+      return boost::none;
+    }
+    if (!lhs->get_type_info().is_integer() && !lhs->get_type_info().is_time()) {
+      continue;
+    }
+    if (lhs->get_type_info().get_type() == kTIMESTAMP &&
+        (lhs_col->get_type_info() != rhs_const->get_type_info())) {
+      continue;
+    }
+    const int col_id = lhs_col->get_column_id();
+    if (get_column_descriptor(col_id, table_id, *catalog_)->isVirtualCol) {
+      continue;
+    }
+    constexpr auto int_min = std::numeric_limits<int64_t>::min();
+    constexpr auto int_max = std::numeric_limits<int64_t>::max();
+    const auto rhs_val = codegenIntConst(rhs_const)->getSExtValue();
+    // An empty interval is kept as [int_max, int_min].
+    auto interval = std::make_pair(int_min, int_max);
+    switch (comp_expr->get_optype()) {
+      case kGE:
+        interval.first = rhs_val;
+        break;
+      case kGT:
+        interval = rhs_val == int_max ? std::make_pair(int_max, int_min)
+                                      : std::make_pair(rhs_val + 1, int_max);
+        break;
+      case kLE:
+        interval.second = rhs_val;
+        break;
+      case kLT:
+        interval = rhs_val == int_min ? std::make_pair(int_max, int_min)
+                                      : std::make_pair(int_min, rhs_val - 1);
+        break;
+      case kEQ:
+        interval = std::make_pair(rhs_val, rhs_val);
+        break;
+      default:
+        continue;
+    }
+    auto it_ok = col_intervals.emplace(col_id, interval);
+    if (!it_ok.second) {
+      auto& col_interval = it_ok.first->second;
+      col_interval.first = std::max(col_interval.first, interval.first);
+      col_interval.second = std::min(col_interval.second, interval.second);
+    }
+    col_types.emplace(col_id, lhs_col->get_type_info());
+  }
+  if (col_intervals.empty()) {
+    return boost::none;
+  }
+  const auto table_info = getSharedTableInfo(table_id);
+  if (!same_fragments(fragments, table_info->fragments)) {
+    return boost::none;
+  }
+  const int db_id = catalog_->get_currentDB().dbId;
+  boost::optional<std::vector<size_t>> candidates;
+  for (const auto& kv : col_intervals) {
+    const auto index = TableMetadataCache::getFragmentRangeIndex(
+        db_id, {kv.first, table_id}, col_types[kv.first], table_info.get());
+    if (!index) {
+      return boost::none;
+    }
+    auto col_candidates = index->getCandidates(kv.second.first, kv.second.second);
+    if (!candidates) {
+      candidates = std::move(col_candidates);
+      continue;
+    }
+    std::vector<size_t> both;
+    std::set_intersection(candidates->begin(),
+                          candidates->end(),
+                          col_candidates.begin(),
+                          col_candidates.end(),
+                          std::back_inserter(both));
+    candidates->swap(both);
+  }
+  return candidates;
+}
+
 /*
  *   The skipFragmentInnerJoins process all quals stored in the execution unit's
  * inner_joins and gather all the ones that meet the "simple_qual" characteristics
@@ -2914,6 +3770,107 @@ std::pair<bool, int64_t> Executor::skipFragmentInnerJoins(
   return skip_frag;
 }
 
+/*
+ *   The skipFragmentJoinKeys checks the join keys of the outer fragment against the
+ * hash tables built for the inner joins: the fragment can be skipped if the keys on the
+ * outer side of any of them can't be found on the build side, which is decided from the
+ * range and the bloom filters of the chunks on both sides.
+ *   - The hash tables are built by the compilation, before the fragments are assigned.
+ *   - Only the equijoin conditions of the INNER joins are considered, the outer rows
+ * without a match can't be dropped for the other join types.
+ */
+bool Executor::skipFragmentJoinKeys(
+    const RelAlgExecutionUnit& ra_exe_unit,
+    const Fragmenter_Namespace::FragmentInfo& fragment) const {
+  if (!g_enable_join_key_fragment_skipping) {
+    return false;
+  }
+  const auto& join_info = plan_state_->join_info_;
+  CHECK_EQ(join_info.equi_join_tautologies_.size(), join_info.join_hash_tables_.size());
+  for (size_t i = 0; i < join_info.join_hash_tables_.size(); ++i) {
+    const auto qual = join_info.equi_join_tautologies_[i].get();
+    const bool is_inner_join_qual = std::any_of(
+        ra_exe_unit.inner_joins.begin(),
+        ra_exe_unit.inner_joins.end(),
+        [qual](const JoinCondition& join_condition) {
+          return join_condition.type == JoinType::INNER &&
+                 std::any_of(join_condition.quals.begin(),
+                             join_condition.quals.end(),
+                             [qual](const std::shared_ptr<Analyzer::Expr>& join_qual) {
+                               return join_qual.get() == qual;
+                             });
+        });
+    if (is_inner_join_qual &&
+        join_info.join_hash_tables_[i]->skipOuterFragment(fragment)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ *   The skipFragmentTableSample evaluates the filters of TABLESAMPLE on the outer table
+ * for the blocks of row ids the fragment spans, see TableSample.h. With SYSTEM a block
+ * is a fragment, those out of the sample aren't fetched. With BERNOULLI a block is a
+ * single row, the fragments are too large to be decided without scanning them.
+ */
+bool Executor::skipFragmentTableSample(
+    const InputDescriptor& table_desc,
+    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const std::vector<uint64_t>& frag_offsets,
+    const size_t frag_idx) {
+  constexpr int64_t max_checked_blocks{16};
+  const int table_id = table_desc.getTableId();
+  for (const auto& qual : quals) {
+    const auto function_oper = dynamic_cast<const Analyzer::FunctionOper*>(qual.get());
+    if (!function_oper || function_oper->getName() != "table_sample") {
+      continue;
+    }
+    CHECK_EQ(size_t(4), function_oper->getArity());
+    const auto rowid_col =
+        dynamic_cast<const Analyzer::ColumnVar*>(function_oper->getArg(0));
+    const auto block_rows_const =
+        dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(1));
+    const auto proportion_const =
+        dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(2));
+    const auto seed_const =
+        dynamic_cast<const Analyzer::Constant*>(function_oper->getArg(3));
+    if (!rowid_col || rowid_col->get_table_id() != table_id || rowid_col->get_rte_idx() ||
+        !block_rows_const || !proportion_const || !seed_const ||
+        proportion_const->get_type_info().get_type() != kDOUBLE) {
+      continue;
+    }
+    const auto block_rows = codegenIntConst(block_rows_const)->getSExtValue();
+    const auto seed = codegenIntConst(seed_const)->getSExtValue();
+    const auto proportion = proportion_const->get_constval().doubleval;
+    CHECK_GT(block_rows, 0);
+    CHECK_LT(frag_idx + 1, frag_offsets.size());
+    if (frag_offsets[frag_idx + 1] == frag_offsets[frag_idx]) {
+      continue;
+    }
+    const int64_t first_rowid =
+        frag_offsets[frag_idx] + getTableGeneration(table_id).start_rowid;
+    const int64_t last_rowid = first_rowid +
+                               (frag_offsets[frag_idx + 1] - frag_offsets[frag_idx]) - 1;
+    const auto first_block = first_rowid / block_rows;
+    const auto last_block = last_rowid / block_rows;
+    if (last_block - first_block >= max_checked_blocks) {
+      continue;
+    }
+    bool any_block_selected{false};
+    for (int64_t block = first_block; block <= last_block; ++block) {
+      if (table_sample_block_selected(block, proportion, seed)) {
+        any_block_selected = true;
+        break;
+      }
+    }
+    if (!any_block_selected) {
+      return true;
+    }
+  }
+  return false;
+}
+
 llvm::Value* Executor::CgenState::emitCall(const std::string& fname,
                                            const std::vector<llvm::Value*>& args) {
   // Get the implementation from the runtime module.
@@ -20,15 +20,18 @@
 #include "AggregatedColRange.h"
 #include "BufferCompaction.h"
 #include "CartesianProduct.h"
+#include "CaseLookupTable.h"
 #include "GroupByAndAggregate.h"
 #include "IRCodegenUtils.h"
 #include "InValuesBitmap.h"
+#include "InValuesHashSet.h"
 #include "InputMetadata.h"
 #include "JoinHashTable.h"
 #include "LLVMGlobalContext.h"
 #include "LoopControlFlow/JoinLoop.h"
 #include "NvidiaKernel.h"
 #include "QueryFragmentDescriptor.h"
+#include "QueryProfile.h"
 #include "RelAlgExecutionUnit.h"
 #include "RelAlgTranslator.h"
 #include "StringDictionaryGenerations.h"
@@ -56,11 +59,13 @@
 
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
 #include <deque>
 #include <functional>
 #include <limits>
+#include <list>
 #include <map>
 #include <mutex>
 #include <stack>
@@ -79,12 +84,66 @@ extern bool g_null_div_by_zero;
 extern bool g_bigint_count;
 extern bool g_fast_strcmp;
 extern bool g_inner_join_fragment_skipping;
+extern bool g_enable_partitioned_hash_join_build;
+extern bool g_enable_join_key_fragment_skipping;
+extern bool g_enable_smem_hash_join_build;
+extern bool g_enable_range_join_hash_table;
+extern bool g_enable_spatial_join_hash_table;
+extern size_t g_join_hash_table_cache_max_bytes;
+extern size_t g_in_values_hash_set_cache_max_bytes;
+extern bool g_enable_query_result_cache;
+extern size_t g_query_result_cache_max_bytes;
+extern bool g_enable_columnar_results_cache;
+extern size_t g_columnar_results_cache_max_bytes;
+extern bool g_enable_table_metadata_cache;
+extern bool g_enable_shared_scans;
+// Bytes of buffers a query can take on each device, 0 for no limit.
+extern size_t g_query_cpu_memory_limit_bytes;
+extern size_t g_query_gpu_memory_limit_bytes;
+extern size_t g_interactive_query_max_input_bytes;
+extern unsigned g_batch_query_max_delay_ms;
+extern bool g_enable_hybrid_execution;
+extern bool g_enable_residency_aware_placement;
+extern size_t g_group_by_buffer_pool_max_bytes;
+extern bool g_enable_group_by_partitioning;
+extern size_t g_max_group_by_partitions;
+extern bool g_enable_partitioned_reduction;
+extern bool g_enable_cpu_radix_sort;
+extern bool g_enable_gpu_sort;
 extern float g_filter_push_down_low_frac;
 extern float g_filter_push_down_high_frac;
 extern size_t g_filter_push_down_passing_row_ubound;
+extern bool g_enable_adaptive_filter_ordering;
 extern bool g_enable_columnar_output;
+extern bool g_enable_cpu_morsels;
+extern size_t g_cpu_morsel_size;
+extern bool g_enable_tiered_cpu_codegen;
+extern size_t g_tiered_codegen_row_threshold;
+extern size_t g_tiered_codegen_promotion_count;
+extern bool g_enable_batched_cpu_codegen;
+extern bool g_enable_expression_cse;
+extern bool g_enable_chunk_prefetch;
+extern bool g_enable_gpu_string_dictionaries;
+extern bool g_enable_query_profile;
+extern bool g_enable_kernel_instrumentation;
+extern bool g_enable_roaring_count_distinct;
+extern bool g_enable_top_count_pruning;
+extern bool g_enable_cost_based_join_ordering;
+extern bool g_enable_fragment_bounded_group_by;
+extern bool g_enable_subquery_result_cache;
+extern bool g_enable_dictionary_translation_map;
+extern bool g_enable_gpu_column_decode;
+extern bool g_enable_gpu_waves;
+extern bool g_enable_cpu_multifrag_kernels;
+extern size_t g_insert_commit_interval_ms;
+extern size_t g_insert_commit_max_rows;
+extern size_t g_result_set_spill_threshold_bytes;
+extern std::string g_result_set_spill_dir;
+extern size_t g_projection_single_pass_max_bytes;
+extern size_t g_code_cache_max_bytes;
 
 class ExecutionResult;
+struct QueryResultCacheKey;
 
 class WatchdogException : public std::runtime_error {
  public:
@@ -227,6 +286,12 @@ class QueryMustRunOnCpu : public std::runtime_error {
   QueryMustRunOnCpu() : std::runtime_error("QueryMustRunOnCpu") {}
 };
 
+// Thrown at the checkpoints outside of the kernels once the query has been interrupted.
+class QueryInterrupted : public std::runtime_error {
+ public:
+  QueryInterrupted() : std::runtime_error("Query execution has been interrupted") {}
+};
+
 class SringConstInResultSet : public std::runtime_error {
  public:
   SringConstInResultSet()
@@ -312,6 +377,10 @@ class Executor {
     (decltype(executors_){}).swap(executors_);
   }
 
+  // Releases the copies of the string dictionaries on the devices, they're pinned and
+  // would keep the GPU buffer pools from being cleared.
+  static void clearGpuStringDictionaries();
+
   typedef std::tuple<std::string, const Analyzer::Expr*, int64_t, const size_t> AggInfo;
 
   std::shared_ptr<ResultSet> execute(const Planner::RootPlan* root_plan,
@@ -401,8 +470,14 @@ class Executor {
 
   const TemporaryTables* getTemporaryTables() const;
 
+  // Null if the plan which produced the temporary table can't be cached.
+  const QueryResultCacheKey* getTemporaryTableCacheKey(const int table_id) const;
+
   Fragmenter_Namespace::TableInfo getTableInfo(const int table_id) const;
 
+  std::shared_ptr<const Fragmenter_Namespace::TableInfo> getSharedTableInfo(
+      const int table_id) const;
+
   const TableGeneration& getTableGeneration(const int table_id) const;
 
   ExpressionRange getColRange(const PhysicalInput&) const;
@@ -426,6 +501,8 @@ class Executor {
   void unregisterActiveModule(void* module, const int device_id) const;
   void interrupt();
   void resetInterrupt();
+  // Throws QueryInterrupted if the query has been interrupted since it started.
+  void checkInterrupted() const;
 
   static const size_t high_scan_limit{10000000};
 
@@ -451,6 +528,9 @@ class Executor {
   std::vector<llvm::Value*> codegen(const Analyzer::Expr*,
                                     const bool fetch_columns,
                                     const CompilationOptions&);
+  std::vector<llvm::Value*> codegenUncached(const Analyzer::Expr*,
+                                            const bool fetch_columns,
+                                            const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::BinOper*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::UOper*, const CompilationOptions&);
 
@@ -497,6 +577,9 @@ class Executor {
       const EncodingType enc_type,
       const int16_t lit_off,
       const std::vector<llvm::Value*>& literal_loads);
+  // Hoists a BIGINT literal with the same value on every device, so that a value which
+  // only depends on the data, like the bounds of an IN bitmap, doesn't change the code.
+  llvm::Value* codegenHoistedBigint(const int64_t val, const size_t device_count);
 
   int deviceCount(const ExecutorDeviceType) const;
   std::vector<llvm::Value*> codegen(const Analyzer::CaseExpr*, const CompilationOptions&);
@@ -504,10 +587,18 @@ class Executor {
                            llvm::Type* case_llvm_type,
                            const bool is_real_str,
                            const CompilationOptions&);
+  // The result of a CASE mapping the values of a column to constants read from a table,
+  // nullptr if the CASE isn't one.
+  llvm::Value* codegenCaseLookup(const Analyzer::CaseExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::ExtractExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::DateaddExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::DatediffExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::DatetruncExpr*, const CompilationOptions&);
+  llvm::Value* codegenFixedWidthDatetrunc(const DatetruncField,
+                                         llvm::Value* ts,
+                                         const SQLTypeInfo& ts_ti);
+  std::vector<llvm::Value*> codegenDeviceStringDecode(const Analyzer::Expr*,
+                                                      const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::CharLengthExpr*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::LikeExpr*, const CompilationOptions&);
   llvm::Value* codegenDictLike(const std::shared_ptr<Analyzer::Expr> arg,
@@ -523,7 +614,9 @@ class Executor {
                                  const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::InValues*, const CompilationOptions&);
   llvm::Value* codegen(const Analyzer::InIntegerSet* expr, const CompilationOptions& co);
-  std::unique_ptr<InValuesBitmap> createInValuesBitmap(const Analyzer::InValues*,
+  bool collectInValues(const Analyzer::InValues*, std::vector<int64_t>& values);
+  std::unique_ptr<InValuesBitmap> createInValuesBitmap(const std::vector<int64_t>& values,
+                                                       const int64_t null_val,
                                                        const CompilationOptions&);
   llvm::Value* codegenCmp(const Analyzer::BinOper*, const CompilationOptions&);
   llvm::Value* codegenCmpDecimalConst(const SQLOps,
@@ -719,7 +812,9 @@ class Executor {
     std::vector<std::shared_ptr<Analyzer::BinOper>>
         equi_join_tautologies_;  // expressions we equi-join on are true by
                                  // definition when using a hash join; we'll
-                                 // fold them to true during code generation
+                                 // fold them to true during code generation;
+                                 // null for the range join tables, which don't
+                                 // make any qual true
     std::vector<std::shared_ptr<JoinHashTableInterface>> join_hash_tables_;
     std::string hash_join_fail_reason_;
     std::unordered_set<size_t> sharded_range_table_indices_;
@@ -765,6 +860,10 @@ class Executor {
         columnarized_ref_table_cache_;
     mutable std::unordered_map<InputColDescriptor, std::unique_ptr<const ColumnarResults>>
         columnarized_scan_table_cache_;
+    mutable std::unordered_map<
+        InputColDescriptor,
+        std::unordered_map<int, std::unique_ptr<const ColumnarResults>>>
+        decoded_scan_frag_cache_;
 
     uint32_t getFragmentStride(const FragmentsList& frag_list) const;
 
@@ -785,7 +884,8 @@ class Executor {
                  const ExecutionOptions& options,
                  const FragmentsList& frag_list,
                  const size_t ctx_idx,
-                 const int64_t rowid_lookup_key);
+                 const int64_t rowid_lookup_key,
+                 const RowRange& row_range);
 
    public:
     ExecutionDispatch(Executor* executor,
@@ -818,7 +918,8 @@ class Executor {
              const ExecutionOptions& options,
              const FragmentsList& frag_ids,
              const size_t ctx_idx,
-             const int64_t rowid_lookup_key) noexcept;
+             const int64_t rowid_lookup_key,
+             const RowRange& row_range) noexcept;
 
     const int8_t* getScanColumn(
         const int table_id,
@@ -835,6 +936,14 @@ class Executor {
         const std::map<int, const TableFragments*>& all_tables_fragments,
         const Data_Namespace::MemoryLevel memory_level,
         const int device_id) const;
+    // The fragment of a DIFF encoded column, decoded to its logical type.
+    const int8_t* getDecodedScanColumn(
+        const int table_id,
+        const int frag_id,
+        const int col_id,
+        const std::map<int, const TableFragments*>& all_tables_fragments,
+        const Data_Namespace::MemoryLevel memory_level,
+        const int device_id) const;
 
     const int8_t* getColumn(
         const InputColDescriptor* col_desc,
@@ -856,10 +965,15 @@ class Executor {
 
     const RelAlgExecutionUnit& getExecutionUnit() const;
 
+    const std::vector<InputTableInfo>& getQueryInfos() const;
+
     const QueryMemoryDescriptor& getQueryMemoryDescriptor() const;
 
     const bool outputColumnar() const;
 
+    // Whether the fragments can be split between the GPUs and the CPU.
+    bool isHybrid() const;
+
     const std::vector<uint64_t>& getFragOffsets() const;
 
     const std::vector<std::unique_ptr<QueryExecutionContext>>& getQueryContexts() const;
@@ -926,7 +1040,8 @@ class Executor {
                                int chosen_device_id,
                                const FragmentsList& frag_list,
                                const size_t ctx_idx,
-                               const int64_t rowid_lookup_key)> dispatch,
+                               const int64_t rowid_lookup_key,
+                               const RowRange& row_range)> dispatch,
       const ExecutionDispatch& execution_dispatch,
       const ExecutionOptions& eo,
       const bool is_agg,
@@ -935,6 +1050,29 @@ class Executor {
       std::unordered_set<int>& available_gpus,
       int& available_cpus);
 
+  // Whether the columns the query reads from the fragment are all in the memory of
+  // the GPU.
+  bool isFragmentOnDevice(const RelAlgExecutionUnit& ra_exe_unit,
+                          const Fragmenter_Namespace::FragmentInfo& fragment,
+                          const int device_id) const;
+
+  // Bytes of the columns the query reads from the fragment, along with the part of
+  // them already in the memory of each of the GPUs.
+  std::pair<size_t, std::vector<size_t>> getFragmentGpuResidency(
+      const RelAlgExecutionUnit& ra_exe_unit,
+      const Fragmenter_Namespace::FragmentInfo& fragment,
+      const int device_count) const;
+
+  // Free bytes in the buffer pool of each of the GPUs.
+  std::vector<size_t> getGpuFreeMemory(const int device_count) const;
+
+  // Loads the chunks of the given kernels in the CPU buffer pool ahead of their
+  // execution, so the fetch of a fragment only needs the host to device copy.
+  void prefetchChunks(const RelAlgExecutionUnit& ra_exe_unit,
+                      const std::vector<FragmentsList>& kernel_frag_lists,
+                      const std::map<int, const TableFragments*>& all_tables_fragments,
+                      const std::atomic<bool>& cancelled);
+
   std::vector<size_t> getTableFragmentIndices(
       const RelAlgExecutionUnit& ra_exe_unit,
       const ExecutorDeviceType device_type,
@@ -1053,6 +1191,8 @@ class Executor {
   static ResultSetPtr resultsUnion(ExecutionDispatch& execution_dispatch);
   std::vector<int64_t> getJoinHashTablePtrs(const ExecutorDeviceType device_type,
                                             const int device_id);
+  std::vector<int64_t> getGpuStringDictionaryBuffers(const int dict_id);
+  void freeGpuStringDictionaries();
   ResultSetPtr reduceMultiDeviceResults(
       const RelAlgExecutionUnit&,
       std::vector<std::pair<ResultSetPtr, std::vector<size_t>>>& all_fragment_results,
@@ -1104,14 +1244,17 @@ class Executor {
                    const size_t level_idx,
                    const CompilationOptions& co);
   // Builds a join hash table for the provided conditions on the current level.
-  // Returns null iff on failure and provides the reasons in `fail_reasons`.
+  // Returns null iff on failure and provides the reasons in `fail_reasons`. For an outer
+  // join, the quals the hash table doesn't cover go in `outer_join_residual_quals`.
   std::shared_ptr<JoinHashTableInterface> buildCurrentLevelHashTable(
       const JoinCondition& current_level_join_conditions,
+      const size_t level_idx,
       RelAlgExecutionUnit& ra_exe_unit,
       const CompilationOptions& co,
       const std::vector<InputTableInfo>& query_infos,
       ColumnCacheMap& column_cache,
-      std::vector<std::string>& fail_reasons);
+      std::vector<std::string>& fail_reasons,
+      std::list<std::shared_ptr<Analyzer::Expr>>& outer_join_residual_quals);
   llvm::Value* addJoinLoopIterator(const std::vector<llvm::Value*>& prev_iters,
                                    const size_t level_idx);
   void codegenJoinLoops(const std::vector<JoinLoop>& join_loops,
@@ -1123,7 +1266,8 @@ class Executor {
                         const ExecutionOptions& eo);
   bool compileBody(const RelAlgExecutionUnit& ra_exe_unit,
                    GroupByAndAggregate& group_by_and_aggregate,
-                   const CompilationOptions& co);
+                   const CompilationOptions& co,
+                   const bool batched_filter);
 
   void createErrorCheckControlFlow(llvm::Function* query_func,
                                    bool run_with_dynamic_watchdog);
@@ -1153,7 +1297,8 @@ class Executor {
       llvm::Function*,
       std::unordered_set<llvm::Function*>&,
       llvm::Module*,
-      const CompilationOptions&);
+      const CompilationOptions&,
+      const bool quick_compile);
   std::vector<std::pair<void*, void*>> optimizeAndCodegenGPU(
       llvm::Function*,
       llvm::Function*,
@@ -1168,6 +1313,8 @@ class Executor {
   int8_t warpSize() const;
   unsigned gridSize() const;
   unsigned blockSize() const;
+  // Sets the grid size of the kernels of the work unit being executed, from the tuner.
+  void tuneGridSize(const QueryMemoryDescriptor&);
 
   int64_t deviceCycles(int milliseconds) const;
 
@@ -1201,6 +1348,14 @@ class Executor {
       const std::vector<uint64_t>& frag_offsets,
       const size_t frag_idx);
 
+  // Positions, in increasing order, of the fragments the range quals don't skip, found
+  // in the range indexes of the columns. None if the quals can't be looked up there,
+  // the fragments left still have to go through skipFragment.
+  boost::optional<std::vector<size_t>> getCandidateFragments(
+      const InputDescriptor& table_desc,
+      const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
+      const std::list<std::shared_ptr<Analyzer::Expr>>& simple_quals);
+
   std::pair<bool, int64_t> skipFragmentInnerJoins(
       const InputDescriptor& table_desc,
       const RelAlgExecutionUnit& ra_exe_unit,
@@ -1208,20 +1363,42 @@ class Executor {
       const std::vector<uint64_t>& frag_offsets,
       const size_t frag_idx);
 
+  bool skipFragmentJoinKeys(const RelAlgExecutionUnit& ra_exe_unit,
+                            const Fragmenter_Namespace::FragmentInfo& fragment) const;
+
+  bool skipFragmentTableSample(const InputDescriptor& table_desc,
+                               const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+                               const std::vector<uint64_t>& frag_offsets,
+                               const size_t frag_idx);
+
   typedef std::vector<std::string> CodeCacheKey;
   typedef std::vector<std::tuple<void*,
                                  std::unique_ptr<llvm::ExecutionEngine>,
                                  std::unique_ptr<GpuCompilationContext>>>
       CodeCacheVal;
-  std::vector<std::pair<void*, void*>> getCodeFromCache(
-      const CodeCacheKey&,
-      const std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>>&);
+  // Compiled kernels by the IR of their functions. Once the estimated size of a cache,
+  // the native code of its kernels and their keys, exceeds g_code_cache_max_bytes, the
+  // least recently used kernels are evicted.
+  struct CodeCache {
+    struct Entry {
+      CodeCacheVal val;
+      llvm::Module* module;
+      size_t bytes;
+      std::list<const CodeCacheKey*>::iterator lru_pos;
+    };
+    std::map<CodeCacheKey, Entry> entries;
+    std::list<const CodeCacheKey*> lru;  // most recently used first
+    size_t bytes{0};
+  };
+  std::vector<std::pair<void*, void*>> getCodeFromCache(const CodeCacheKey&, CodeCache&);
   void addCodeToCache(
       const CodeCacheKey&,
       const std::vector<
           std::tuple<void*, llvm::ExecutionEngine*, GpuCompilationContext*>>&,
       llvm::Module*,
-      std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>>&);
+      const size_t code_bytes,
+      CodeCache&);
+  void eraseCodeFromCache(const CodeCacheKey&, CodeCache&);
 
   std::vector<int8_t> serializeLiterals(
       const std::unordered_map<int, Executor::LiteralValues>& literals,
@@ -1434,6 +1611,18 @@ class Executor {
       in_values_bitmaps_.emplace_back(std::move(in_values_bitmap));
       return in_values_bitmaps_.back().get();
     }
+
+    const InValuesHashSet* addInValuesHashSet(
+        const std::shared_ptr<const InValuesHashSet>& in_values_hash_set) {
+      in_values_hash_sets_.push_back(in_values_hash_set);
+      return in_values_hash_sets_.back().get();
+    }
+
+    const CaseLookupTable* addCaseLookupTable(
+        std::unique_ptr<const CaseLookupTable> case_lookup_table) {
+      case_lookup_tables_.emplace_back(std::move(case_lookup_table));
+      return case_lookup_tables_.back().get();
+    }
     // look up a runtime function based on the name, return type and type of
     // the arguments and call it; x64 only, don't call from GPU codegen
     llvm::Value* emitExternalCall(const std::string& fname,
@@ -1466,6 +1655,9 @@ class Executor {
     llvm::ValueToValueMapTy vmap_;  // used for cloning the runtime module
     llvm::IRBuilder<> ir_builder_;
     std::unordered_map<int, std::vector<llvm::Value*>> fetch_cache_;
+    // values of the expressions computed so far for the current row, see codegen()
+    std::vector<std::pair<const Analyzer::Expr*, std::vector<llvm::Value*>>>
+        expr_cache_;
     std::vector<llvm::Value*> group_by_expr_cache_;
     std::vector<llvm::Value*> str_constants_;
     std::vector<llvm::Value*> frag_offsets_;
@@ -1473,6 +1665,8 @@ class Executor {
     std::vector<llvm::Value*> outer_join_match_found_per_level_;
     std::unordered_map<int, llvm::Value*> scan_idx_to_hash_pos_;
     std::vector<std::unique_ptr<const InValuesBitmap>> in_values_bitmaps_;
+    std::vector<std::shared_ptr<const InValuesHashSet>> in_values_hash_sets_;
+    std::vector<std::unique_ptr<const CaseLookupTable>> case_lookup_tables_;
     const std::vector<InputTableInfo>& query_infos_;
     bool needs_error_check_;
 
@@ -1514,12 +1708,19 @@ class Executor {
   class FetchCacheAnchor {
    public:
     FetchCacheAnchor(CgenState* cgen_state)
-        : cgen_state_(cgen_state), saved_fetch_cache(cgen_state_->fetch_cache_) {}
-    ~FetchCacheAnchor() { cgen_state_->fetch_cache_.swap(saved_fetch_cache); }
+        : cgen_state_(cgen_state)
+        , saved_fetch_cache(cgen_state_->fetch_cache_)
+        , saved_expr_cache(cgen_state_->expr_cache_) {}
+    ~FetchCacheAnchor() {
+      cgen_state_->fetch_cache_.swap(saved_fetch_cache);
+      cgen_state_->expr_cache_.swap(saved_expr_cache);
+    }
 
    private:
     CgenState* cgen_state_;
     std::unordered_map<int, std::vector<llvm::Value*>> saved_fetch_cache;
+    std::vector<std::pair<const Analyzer::Expr*, std::vector<llvm::Value*>>>
+        saved_expr_cache;
   };
 
   // TODO(alex): remove, only useful for the legacy path
@@ -1534,9 +1735,11 @@ class Executor {
 
   struct PlanState {
     PlanState(const bool allow_lazy_fetch,
+              const bool contains_left_deep_outer_join,
               const JoinInfo& join_info,
               const Executor* executor)
         : allow_lazy_fetch_(allow_lazy_fetch)
+        , contains_left_deep_outer_join_(contains_left_deep_outer_join)
         , join_info_(join_info)
         , executor_(executor) {}
 
@@ -1547,6 +1750,7 @@ class Executor {
     std::set<std::pair<int, int>> columns_to_fetch_;
     std::set<std::pair<int, int>> columns_to_not_fetch_;
     bool allow_lazy_fetch_;
+    const bool contains_left_deep_outer_join_;
     JoinInfo join_info_;
     const Executor* executor_;
 
@@ -1560,6 +1764,11 @@ class Executor {
           dynamic_cast<const Analyzer::Var*>(do_not_fetch_column)) {
         return false;
       }
+      // A row of the inner tables of an outer join may not exist, only the columns of
+      // the outer table are sure to have a position to read the value from later.
+      if (contains_left_deep_outer_join_ && do_not_fetch_column->get_rte_idx() > 0) {
+        return false;
+      }
       if (do_not_fetch_column->get_table_id() > 0) {
         auto cd = get_column_descriptor(do_not_fetch_column->get_column_id(),
                                         do_not_fetch_column->get_table_id(),
@@ -1567,6 +1776,10 @@ class Executor {
         if (cd->isVirtualCol) {
           return false;
         }
+        // Lazy fetch reads the values from the chunk, which only the kernels decode.
+        if (cd->columnType.get_compression() == kENCODING_DIFF) {
+          return false;
+        }
       }
       std::set<std::pair<int, int>> intersect;
       std::set_intersection(columns_to_fetch_.begin(),
@@ -1600,6 +1813,8 @@ class Executor {
 
   std::unique_ptr<PlanState> plan_state_;
   std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner_;
+  // Profile of the query being executed, if requested.
+  QueryProfile* query_profile_{nullptr};
 
   bool is_nested_;
 
@@ -1609,15 +1824,29 @@ class Executor {
   mutable std::mutex gpu_active_modules_mutex_;
   mutable uint32_t gpu_active_modules_device_mask_;
   mutable void* gpu_active_modules_[max_gpu_count];
-  bool interrupted_;
+  // Set from the thread of the interrupt, read by the threads of the query.
+  std::atomic<bool> interrupted_;
 
   mutable std::shared_ptr<StringDictionaryProxy> lit_str_dict_proxy_;
   mutable std::mutex str_dict_mutex_;
 
-  mutable std::unique_ptr<llvm::TargetMachine> nvptx_target_machine_;
+  // Strings of a dictionary on one device, laid out as the number of strings, their
+  // offsets in the payload (one more than the strings) and the payload.
+  struct GpuStringDictionary {
+    Data_Namespace::DataMgr* data_mgr;
+    Data_Namespace::AbstractBuffer* buffer;
+    size_t str_count;
+  };
+  std::map<std::pair<int, int>, GpuStringDictionary> gpu_string_dictionaries_;
+
+  // Shared by the executors of all the databases, created on the first GPU compilation.
+  static std::unique_ptr<llvm::TargetMachine> nvptx_target_machine_;
+  static std::once_flag nvptx_backend_init_flag_;
 
-  std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>> cpu_code_cache_;
-  std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>> gpu_code_cache_;
+  CodeCache cpu_code_cache_;
+  CodeCache gpu_code_cache_;
+  // Number of quick compilations seen per query, by hash of the code cache key.
+  std::unordered_map<uint64_t, size_t> quick_code_uses_;
 
   ::QueryRenderer::QueryRenderManager* render_manager_;
 
@@ -1627,12 +1856,17 @@ class Executor {
 
   const unsigned block_size_x_;
   const unsigned grid_size_x_;
+  // The tuned grid size and the shape of the kernels being launched, if tuning.
+  unsigned launch_grid_size_;
+  std::string launch_shape_key_;
   const std::string debug_dir_;
   const std::string debug_file_;
 
   const int db_id_;
   const Catalog_Namespace::Catalog* catalog_;
   const TemporaryTables* temporary_tables_;
+  // Keys of the columnar form of the temporary tables in the ColumnarResultsCache.
+  const std::unordered_map<int, QueryResultCacheKey>* temporary_table_cache_keys_;
 
   mutable InputTableInfoCache input_table_info_cache_;
   AggregatedColRange agg_col_range_cache_;
@@ -1665,8 +1899,12 @@ class Executor {
   friend class QueryFragmentDescriptor;
   friend class QueryExecutionContext;
   friend class ResultSet;
+  friend class CaseLookupTable;
   friend class InValuesBitmap;
+  friend class InValuesHashSet;
   friend class JoinHashTable;
+  friend class RangeJoinHashTable;
+  friend class SpatialJoinHashTable;
   friend class LeafAggregator;
   friend class QueryRewriter;
   friend class PendingExecutionClosure;
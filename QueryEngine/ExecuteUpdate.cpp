@@ -98,9 +98,9 @@ void Executor::executeUpdate(const RelAlgExecutionUnit& ra_exe_unit_in,
        ++fragment_index) {
     // We may want to consider in the future allowing this to execute on devices other
     // than CPU
-    execution_dispatch.run(co.device_type_, 0, eo, {{table_id, {fragment_index}}}, 0, -1);
+    execution_dispatch.run(
+        co.device_type_, 0, eo, {{table_id, {fragment_index}}}, 0, -1, {0, 0});
   }
-  // Further optimization possible here to skip fragments
   CHECK_EQ(outer_fragments.size(), execution_dispatch.getFragmentResults().size());
   // There could be benefit to multithread this once we see where the bottle necks really
   // are
@@ -117,6 +117,10 @@ void Executor::executeUpdate(const RelAlgExecutionUnit& ra_exe_unit_in,
     CHECK(count_scalar_tv);
     const auto count_ptr = boost::get<int64_t>(count_scalar_tv);
     CHECK(count_ptr);
+    if (*count_ptr == 0) {
+      // no row of the fragment is updated, spare the projection and its compilation
+      continue;
+    }
     ExecutionDispatch current_fragment_execution_dispatch(this,
                                                           ra_exe_unit,
                                                           table_infos,
@@ -131,8 +135,13 @@ void Executor::executeUpdate(const RelAlgExecutionUnit& ra_exe_unit_in,
         JoinInfo{JoinImplType::Invalid, {}, {}, ""}, *count_ptr, 8, eo, false);
     // We may want to consider in the future allowing this to execute on devices other
     // than CPU
-    current_fragment_execution_dispatch.run(
-        co.device_type_, 0, eo, {FragmentsPerTable{table_id, {fragment_index}}}, 0, -1);
+    current_fragment_execution_dispatch.run(co.device_type_,
+                                            0,
+                                            eo,
+                                            {FragmentsPerTable{table_id, {fragment_index}}},
+                                            0,
+                                            -1,
+                                            {0, 0});
     const auto& proj_fragment_results =
         current_fragment_execution_dispatch.getFragmentResults()[0];
     const auto proj_result_set = proj_fragment_results.first;
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include "ColumnDecodeGpu.h"
+#include "ColumnarResultsCache.h"
 #include "DynamicWatchdog.h"
 #include "Execute.h"
 #include "QueryFragmentDescriptor.h"
@@ -119,10 +121,11 @@ const int8_t* Executor::ExecutionDispatch::getColumn(
     }
     auto& frag_id_to_result = columnarized_table_cache_[table_id];
     if (frag_id_to_result.empty() || !frag_id_to_result.count(frag_id)) {
-      frag_id_to_result.insert(
-          std::make_pair(frag_id,
-                         std::shared_ptr<const ColumnarResults>(
-                             columnarize_result(row_set_mem_owner_, buffer, frag_id))));
+      const auto cache_key = executor_->getTemporaryTableCacheKey(table_id);
+      frag_id_to_result.insert(std::make_pair(
+          frag_id,
+          ColumnarResultsCache::columnarize(
+              cache_key, row_set_mem_owner_, buffer, frag_id)));
     }
     CHECK_NE(size_t(0), columnarized_table_cache_.count(table_id));
     result = columnarized_table_cache_[table_id][frag_id].get();
@@ -152,6 +155,51 @@ bool need_to_hold_chunk(const Chunk_NS::Chunk* chunk,
   return false;
 }
 
+// The CPU kernel processes the rows from the one passed through the error code up to
+// the row count of the outer table, lowering the latter restricts it to a range.
+void trim_outer_num_rows(std::vector<std::vector<int64_t>>& num_rows,
+                         const int64_t end_row) {
+  CHECK_EQ(size_t(1), num_rows.size());
+  CHECK(!num_rows.front().empty());
+  auto& outer_num_rows = num_rows.front().front();
+  outer_num_rows = std::min(outer_num_rows, end_row);
+}
+
+// Hybrid execution is limited to the aggregates without group by on a single table:
+// their device results are a single row and the join hash tables, built for the memory
+// level of one device type only, aren't involved.
+bool can_split_across_device_types(const RelAlgExecutionUnit& ra_exe_unit,
+                                   const RenderInfo* render_info) {
+  if (!g_enable_hybrid_execution || render_info || ra_exe_unit.estimator ||
+      !ra_exe_unit.groupby_exprs.empty() || ra_exe_unit.input_descs.size() != 1 ||
+      !ra_exe_unit.inner_joins.empty() || !ra_exe_unit.inner_join_quals.empty() ||
+      ra_exe_unit.scan_limit) {
+    return false;
+  }
+  for (const auto target_expr : ra_exe_unit.target_exprs) {
+    const auto agg_info = target_info(target_expr);
+    if (!agg_info.is_agg || is_distinct_target(agg_info) ||
+        agg_info.sql_type.is_geometry()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Zeros read in place of the deleted column of the fragments without deleted rows. The
+// buffer only grows, the smaller ones stay for the kernels still reading them.
+const int8_t* get_no_deleted_rows(const size_t num_rows) {
+  static std::mutex zeros_mutex;
+  static std::vector<std::unique_ptr<int8_t[]>> zeros;
+  static size_t zeros_size{0};
+  std::lock_guard<std::mutex> zeros_lock(zeros_mutex);
+  if (num_rows > zeros_size) {
+    zeros.emplace_back(new int8_t[num_rows]());
+    zeros_size = num_rows;
+  }
+  return zeros.back().get();
+}
+
 }  // namespace
 
 void Executor::ExecutionDispatch::runImpl(const ExecutorDeviceType chosen_device_type,
@@ -159,7 +207,8 @@ void Executor::ExecutionDispatch::runImpl(const ExecutorDeviceType chosen_device
                                           const ExecutionOptions& options,
                                           const FragmentsList& frag_list,
                                           const size_t ctx_idx,
-                                          const int64_t rowid_lookup_key) {
+                                          const int64_t rowid_lookup_key,
+                                          const RowRange& row_range) {
   const auto memory_level = chosen_device_type == ExecutorDeviceType::GPU
                                 ? Data_Namespace::GPU_LEVEL
                                 : Data_Namespace::CPU_LEVEL;
@@ -184,6 +233,10 @@ void Executor::ExecutionDispatch::runImpl(const ExecutorDeviceType chosen_device
         all_tables_fragments, ra_exe_unit_, query_infos_);
 
     OOM_TRACE_PUSH();
+    QueryProfile::Timer fetch_timer(executor_->query_profile_,
+                                    chosen_device_type == ExecutorDeviceType::GPU
+                                        ? QueryProfile::Phase::GpuFetch
+                                        : QueryProfile::Phase::CpuFetch);
     fetch_result = executor_->fetchChunks(*this,
                                           ra_exe_unit_,
                                           chosen_device_id,
@@ -196,6 +249,18 @@ void Executor::ExecutionDispatch::runImpl(const ExecutorDeviceType chosen_device
     if (fetch_result.num_rows.empty()) {
       return;
     }
+    if (executor_->query_profile_) {
+      size_t fetched_bytes{0};
+      for (const auto& chunk : chunks) {
+        if (chunk->get_buffer()) {
+          fetched_bytes += chunk->get_buffer()->size();
+        }
+        if (chunk->get_index_buf()) {
+          fetched_bytes += chunk->get_index_buf()->size();
+        }
+      }
+      executor_->query_profile_->addFetchedBytes(chosen_device_type, fetched_bytes);
+    }
     if (options.with_dynamic_watchdog &&
         !dynamic_watchdog_set_.test_and_set(std::memory_order_acquire)) {
       CHECK_GT(options.dynamic_watchdog_time_limit, 0);
@@ -279,10 +344,30 @@ void Executor::ExecutionDispatch::runImpl(const ExecutorDeviceType chosen_device
       const auto& all_frag_row_offsets = getFragOffsets();
       start_rowid = rowid_lookup_key -
                     all_frag_row_offsets[frag_list.begin()->fragment_ids.front()];
+      trim_outer_num_rows(fetch_result.num_rows, start_rowid + 1);
     }
+  } else if (!row_range.empty()) {
+    CHECK(chosen_device_type == ExecutorDeviceType::CPU);
+    start_rowid = row_range.begin;
+    trim_outer_num_rows(fetch_result.num_rows, row_range.end);
   }
 
   ResultSetPtr device_results;
+  QueryProfile::Timer kernel_timer(executor_->query_profile_,
+                                   chosen_device_type == ExecutorDeviceType::GPU
+                                       ? QueryProfile::Phase::GpuKernel
+                                       : QueryProfile::Phase::CpuKernel);
+  if (executor_->query_profile_) {
+    executor_->query_profile_->addKernel(chosen_device_type);
+    // The rows of the outer fragments, from the start row of a lookup or row range on.
+    int64_t scanned_rows{0};
+    for (const auto& frag_num_rows : fetch_result.num_rows) {
+      CHECK(!frag_num_rows.empty());
+      scanned_rows +=
+          std::max(frag_num_rows.front() - static_cast<int64_t>(start_rowid), int64_t(0));
+    }
+    executor_->query_profile_->addScannedRows(scanned_rows);
+  }
   if (ra_exe_unit_.groupby_exprs.empty()) {
     OOM_TRACE_PUSH();
     err = executor_->executePlanWithoutGroupBy(ra_exe_unit_,
@@ -422,7 +507,10 @@ int8_t Executor::ExecutionDispatch::compile(const Executor::JoinInfo& join_info,
             actual_min_byte_width);
   };
 
-  if (co_.device_type_ == ExecutorDeviceType::CPU) {
+  // The CPU code of a hybrid query is compiled first, the plan state left for the
+  // kernels is the one of the GPU code.
+  if (co_.device_type_ == ExecutorDeviceType::CPU ||
+      can_split_across_device_types(ra_exe_unit_, render_info_)) {
     compile_on_cpu();
   }
 
@@ -482,14 +570,16 @@ void Executor::ExecutionDispatch::run(const ExecutorDeviceType chosen_device_typ
                                       const ExecutionOptions& options,
                                       const FragmentsList& frag_list,
                                       const size_t ctx_idx,
-                                      const int64_t rowid_lookup_key) noexcept {
+                                      const int64_t rowid_lookup_key,
+                                      const RowRange& row_range) noexcept {
   try {
     runImpl(chosen_device_type,
             chosen_device_id,
             options,
             frag_list,
             ctx_idx,
-            rowid_lookup_key);
+            rowid_lookup_key,
+            row_range);
   } catch (const std::bad_alloc& e) {
     std::lock_guard<std::mutex> lock(reduce_mutex_);
     LOG(ERROR) << e.what();
@@ -506,6 +596,9 @@ void Executor::ExecutionDispatch::run(const ExecutorDeviceType chosen_device_typ
     std::lock_guard<std::mutex> lock(reduce_mutex_);
     LOG(ERROR) << e.what();
     *error_code_ = ERR_OUT_OF_GPU_MEM;
+  } catch (const QueryInterrupted&) {
+    std::lock_guard<std::mutex> lock(reduce_mutex_);
+    *error_code_ = ERR_INTERRUPTED;
   } catch (const ColumnarConversionNotSupported& e) {
     std::lock_guard<std::mutex> lock(reduce_mutex_);
     *error_code_ = ERR_COLUMNAR_CONVERSION_NOT_SUPPORTED;
@@ -543,6 +636,13 @@ const int8_t* Executor::ExecutionDispatch::getScanColumn(
   CHECK(table_id > 0);
   auto cd = get_column_descriptor(col_id, table_id, cat_);
   CHECK(cd);
+  // The metadata of the deleted column tells whether the fragment has deleted rows,
+  // most fragments of a table with a few don't and needn't read the column.
+  if (cd->isDeletedCol && memory_level == Data_Namespace::CPU_LEVEL &&
+      !chunk_meta_it->second.chunkStats.max.tinyintval) {
+    return get_no_deleted_rows(
+        std::max(chunk_meta_it->second.numElements, fragment.getNumTuples()));
+  }
   const auto col_type =
       get_column_type(col_id, table_id, cd, executor_->temporary_tables_);
   const bool is_real_string =
@@ -558,14 +658,23 @@ const int8_t* Executor::ExecutionDispatch::getScanColumn(
       varlen_chunk_lock.reset(new std::lock_guard<std::mutex>(varlen_chunk_mutex));
     }
     OOM_TRACE_PUSH(+": chunk key [" + showChunk(chunk_key) + "]");
-    chunk = Chunk_NS::Chunk::getChunk(
-        cd,
-        &cat_.get_dataMgr(),
-        chunk_key,
-        memory_level,
-        memory_level == Data_Namespace::CPU_LEVEL ? 0 : device_id,
-        chunk_meta_it->second.numBytes,
-        chunk_meta_it->second.numElements);
+    if (memory_level == Data_Namespace::CPU_LEVEL && !is_varlen) {
+      auto mapped_buffer = cat_.get_dataMgr().getMappedChunkBuffer(
+          chunk_key, chunk_meta_it->second.numBytes);
+      if (mapped_buffer) {
+        chunk = std::make_shared<Chunk_NS::Chunk>(mapped_buffer, nullptr, cd);
+      }
+    }
+    if (!chunk) {
+      chunk = Chunk_NS::Chunk::getChunk(
+          cd,
+          &cat_.get_dataMgr(),
+          chunk_key,
+          memory_level,
+          memory_level == Data_Namespace::CPU_LEVEL ? 0 : device_id,
+          chunk_meta_it->second.numBytes,
+          chunk_meta_it->second.numElements);
+    }
     std::lock_guard<std::mutex> chunk_list_lock(chunk_list_mutex);
     chunk_holder.push_back(chunk);
   }
@@ -643,6 +752,85 @@ const int8_t* Executor::ExecutionDispatch::getAllScanColumnFrags(
   return getColumn(table_column, 0, &cat_.get_dataMgr(), memory_level, device_id);
 }
 
+const int8_t* Executor::ExecutionDispatch::getDecodedScanColumn(
+    const int table_id,
+    const int frag_id,
+    const int col_id,
+    const std::map<int, const TableFragments*>& all_tables_fragments,
+    const Data_Namespace::MemoryLevel memory_level,
+    const int device_id) const {
+  const auto fragments_it = all_tables_fragments.find(table_id);
+  CHECK(fragments_it != all_tables_fragments.end());
+  const auto& fragment = (*fragments_it->second)[frag_id];
+  if (fragment.isEmptyPhysicalFragment()) {
+    return nullptr;
+  }
+#ifdef HAVE_CUDA
+  if (memory_level == Data_Namespace::GPU_LEVEL && g_enable_gpu_column_decode) {
+    // The chunk crosses the bus at its encoded width, a fraction of the decoded one.
+    std::list<std::shared_ptr<Chunk_NS::Chunk>> chunk_holder;
+    std::list<ChunkIter> chunk_iter_holder;
+    auto chunk_meta_it = fragment.getChunkMetadataMap().find(col_id);
+    CHECK(chunk_meta_it != fragment.getChunkMetadataMap().end());
+    const auto& diff_ti = chunk_meta_it->second.sqlType;
+    const auto logical_ti = get_logical_type_info(diff_ti);
+    auto diff_buffer = getScanColumn(table_id,
+                                     frag_id,
+                                     col_id,
+                                     all_tables_fragments,
+                                     chunk_holder,
+                                     chunk_iter_holder,
+                                     memory_level,
+                                     device_id);
+    auto data_mgr = &cat_.get_dataMgr();
+    const auto num_rows = fragment.getNumTuples();
+    auto decoded_buffer =
+        alloc_gpu_mem(data_mgr, num_rows * logical_ti.get_size(), device_id, nullptr);
+    data_mgr->cudaMgr_->setContext(device_id);
+    decode_diff_column_on_device(reinterpret_cast<int8_t*>(decoded_buffer),
+                                 diff_buffer,
+                                 num_rows,
+                                 diff_ti.get_size(),
+                                 logical_ti.get_size(),
+                                 inline_int_null_val(logical_ti),
+                                 executor_->blockSize(),
+                                 executor_->gridSize());
+    return reinterpret_cast<const int8_t*>(decoded_buffer);
+  }
+#endif  // HAVE_CUDA
+  const ColumnarResults* frag_column = nullptr;
+  const InputColDescriptor col_desc(col_id, table_id, int(0));
+  {
+    std::lock_guard<std::mutex> columnar_conversion_guard(columnar_conversion_mutex_);
+    auto& frag_id_to_result = decoded_scan_frag_cache_[col_desc];
+    auto frag_it = frag_id_to_result.find(frag_id);
+    if (frag_it == frag_id_to_result.end()) {
+      std::list<std::shared_ptr<Chunk_NS::Chunk>> chunk_holder;
+      std::list<ChunkIter> chunk_iter_holder;
+      auto chunk_meta_it = fragment.getChunkMetadataMap().find(col_id);
+      CHECK(chunk_meta_it != fragment.getChunkMetadataMap().end());
+      auto col_buffer = getScanColumn(table_id,
+                                      frag_id,
+                                      col_id,
+                                      all_tables_fragments,
+                                      chunk_holder,
+                                      chunk_iter_holder,
+                                      Data_Namespace::CPU_LEVEL,
+                                      int(0));
+      frag_it = frag_id_to_result
+                    .emplace(frag_id,
+                             boost::make_unique<ColumnarResults>(
+                                 row_set_mem_owner_,
+                                 col_buffer,
+                                 fragment.getNumTuples(),
+                                 chunk_meta_it->second.sqlType))
+                    .first;
+    }
+    frag_column = frag_it->second.get();
+  }
+  return getColumn(frag_column, 0, &cat_.get_dataMgr(), memory_level, device_id);
+}
+
 const int8_t* Executor::ExecutionDispatch::getColumn(
     const InputColDescriptor* col_desc,
     const int frag_id,
@@ -697,20 +885,33 @@ const RelAlgExecutionUnit& Executor::ExecutionDispatch::getExecutionUnit() const
   return ra_exe_unit_;
 }
 
+const std::vector<InputTableInfo>& Executor::ExecutionDispatch::getQueryInfos() const {
+  return query_infos_;
+}
+
 const QueryMemoryDescriptor& Executor::ExecutionDispatch::getQueryMemoryDescriptor()
     const {
   // TODO(alex): make query_mem_desc easily available
-  return compilation_result_cpu_.native_functions.empty()
+  return co_.device_type_ == ExecutorDeviceType::GPU
              ? compilation_result_gpu_.query_mem_desc
              : compilation_result_cpu_.query_mem_desc;
 }
 
 const bool Executor::ExecutionDispatch::outputColumnar() const {
-  return compilation_result_cpu_.native_functions.empty()
+  return co_.device_type_ == ExecutorDeviceType::GPU
              ? compilation_result_gpu_.output_columnar
              : false;
 }
 
+bool Executor::ExecutionDispatch::isHybrid() const {
+  // The device results are reduced together, their layouts must match.
+  return co_.device_type_ == ExecutorDeviceType::GPU &&
+         !compilation_result_cpu_.native_functions.empty() &&
+         !compilation_result_gpu_.native_functions.empty() &&
+         compilation_result_cpu_.query_mem_desc ==
+             compilation_result_gpu_.query_mem_desc;
+}
+
 const std::vector<uint64_t>& Executor::ExecutionDispatch::getFragOffsets() const {
   std::lock_guard<std::mutex> lock(all_frag_row_offsets_mutex_);
   if (all_frag_row_offsets_.empty()) {
@@ -786,10 +987,11 @@ std::pair<const int8_t*, size_t> Executor::ExecutionDispatch::getColumnFragment(
       if (frag_id_to_result.empty() || !frag_id_to_result.count(frag_id)) {
         frag_id_to_result.insert(std::make_pair(
             frag_id,
-            std::shared_ptr<const ColumnarResults>(columnarize_result(
+            ColumnarResultsCache::columnarize(
+                executor->getTemporaryTableCacheKey(table_id),
                 executor->row_set_mem_owner_,
-                get_temporary_table(executor->temporary_tables_, hash_col.get_table_id()),
-                frag_id))));
+                get_temporary_table(executor->temporary_tables_, table_id),
+                frag_id)));
       }
       col_frag = column_cache[table_id][frag_id].get();
     }
@@ -489,7 +489,7 @@ int64_t get_conservative_datetrunc_bucket(const DatetruncField datetrunc_field)
     case dtWEEK:
       return 7 * day_seconds;
     case dtQUARTERDAY:
-      return 4 * 60 * 50;
+      return 6 * 3600;
     default:
       return 0;
   }
@@ -1,4 +1,5 @@
 #include "../Shared/funcannotations.h"
+#include "TableSample.h"
 #ifndef __CUDACC__
 #include <cstdint>
 #endif
@@ -854,4 +855,13 @@ EXTENSION_NOINLINE bool is_point_size_in_merc_view(const double lon,
            lat + latdiff < min_lat || lat - latdiff > max_lat);
 }
 
+// The filter of TABLESAMPLE, block_rows is 1 for BERNOULLI and the fragment size for
+// SYSTEM. See TableSample.h.
+EXTENSION_NOINLINE bool table_sample(const int64_t rowid,
+                                     const int64_t block_rows,
+                                     const double proportion,
+                                     const int64_t seed) {
+  return table_sample_block_selected(rowid / block_rows, proportion, seed);
+}
+
 #include "ExtensionFunctionsGeo.hpp"
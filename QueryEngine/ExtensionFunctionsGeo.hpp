@@ -971,6 +971,21 @@ double ST_Distance_Point_Point(int8_t* p1,
   return distance_point_point(p1x, p1y, p2x, p2y);
 }
 
+// Distance between a point and the coordinates of a POINT literal, which the query
+// engine decompresses once instead of on every row.
+EXTENSION_INLINE
+double ST_Distance_Point_XY(int8_t* p,
+                            int64_t psize,
+                            int32_t ic,
+                            int32_t isr,
+                            int32_t osr,
+                            double x,
+                            double y) {
+  double px = coord_x(p, 0, ic, isr, osr);
+  double py = coord_y(p, 1, ic, isr, osr);
+  return distance_point_point(px, py, x, y);
+}
+
 EXTENSION_NOINLINE
 double ST_Distance_Point_Point_Geodesic(int8_t* p1,
                                         int64_t p1size,
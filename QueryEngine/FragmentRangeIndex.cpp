@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FragmentRangeIndex.h"
+#include "GroupByAndAggregate.h"
+
+#include <algorithm>
+#include <numeric>
+
+FragmentRangeIndex::FragmentRangeIndex(
+    const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
+    const int col_id,
+    const SQLTypeInfo& col_ti)
+    : fragment_count_(fragments.size()) {
+  std::vector<int64_t> mins;
+  std::vector<int64_t> maxs;
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < fragments.size(); ++i) {
+    const auto& chunk_metadata_map = fragments[i].getChunkMetadataMap();
+    const auto chunk_meta_it = chunk_metadata_map.find(col_id);
+    if (chunk_meta_it == chunk_metadata_map.end()) {
+      unindexed_positions_.push_back(i);
+      continue;
+    }
+    mins.push_back(extract_min_stat(chunk_meta_it->second.chunkStats, col_ti));
+    maxs.push_back(extract_max_stat(chunk_meta_it->second.chunkStats, col_ti));
+    positions.push_back(i);
+  }
+  std::vector<size_t> order(mins.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&mins](const size_t a, const size_t b) {
+    return mins[a] < mins[b];
+  });
+  mins_.reserve(order.size());
+  positions_.reserve(order.size());
+  std::vector<int64_t> sorted_maxs;
+  sorted_maxs.reserve(order.size());
+  for (const auto i : order) {
+    mins_.push_back(mins[i]);
+    sorted_maxs.push_back(maxs[i]);
+    positions_.push_back(positions[i]);
+  }
+  if (sorted_maxs.empty()) {
+    return;
+  }
+  max_tree_.resize(4 * sorted_maxs.size());
+  build(sorted_maxs, 0, 0, sorted_maxs.size());
+}
+
+int64_t FragmentRangeIndex::build(const std::vector<int64_t>& sorted_maxs,
+                                  const size_t node,
+                                  const size_t begin,
+                                  const size_t end) {
+  if (end - begin == 1) {
+    max_tree_[node] = sorted_maxs[begin];
+  } else {
+    const auto mid = begin + (end - begin) / 2;
+    max_tree_[node] = std::max(build(sorted_maxs, 2 * node + 1, begin, mid),
+                               build(sorted_maxs, 2 * node + 2, mid, end));
+  }
+  return max_tree_[node];
+}
+
+std::vector<size_t> FragmentRangeIndex::getCandidates(const int64_t lo,
+                                                      const int64_t hi) const {
+  std::vector<size_t> candidates(unindexed_positions_);
+  if (lo <= hi && !mins_.empty()) {
+    // Only the fragments with a minimum up to hi, among them the ones reaching lo.
+    const auto limit = static_cast<size_t>(
+        std::upper_bound(mins_.begin(), mins_.end(), hi) - mins_.begin());
+    collect(candidates, 0, 0, mins_.size(), limit, lo);
+  }
+  std::sort(candidates.begin(), candidates.end());
+  return candidates;
+}
+
+void FragmentRangeIndex::collect(std::vector<size_t>& candidates,
+                                 const size_t node,
+                                 const size_t begin,
+                                 const size_t end,
+                                 const size_t limit,
+                                 const int64_t lo) const {
+  if (begin >= limit || max_tree_[node] < lo) {
+    return;
+  }
+  if (end - begin == 1) {
+    candidates.push_back(positions_[begin]);
+    return;
+  }
+  const auto mid = begin + (end - begin) / 2;
+  collect(candidates, 2 * node + 1, begin, mid, limit, lo);
+  collect(candidates, 2 * node + 2, mid, end, limit, lo);
+}
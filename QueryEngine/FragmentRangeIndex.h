@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    FragmentRangeIndex.h
+ * @brief   Fragments of a table whose range of an integer column meets an interval.
+ *
+ * The fragments are sorted by the minimum of the column, a tree over the maximums of
+ * the sorted fragments then only descends into the subtrees which hold a fragment of
+ * the answer. A range predicate finds its candidate fragments in logarithmic time per
+ * fragment found rather than checking the metadata of all of them.
+ */
+
+#ifndef QUERYENGINE_FRAGMENTRANGEINDEX_H
+#define QUERYENGINE_FRAGMENTRANGEINDEX_H
+
+#include "../Fragmenter/Fragmenter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class FragmentRangeIndex {
+ public:
+  // Over the chunk stats of the column, extracted the same way as by skipFragment.
+  FragmentRangeIndex(const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
+                     const int col_id,
+                     const SQLTypeInfo& col_ti);
+
+  // Positions in the fragments, in increasing order, of the ones with a chunk range
+  // which meets [lo, hi] and of the ones without stats for the column.
+  std::vector<size_t> getCandidates(const int64_t lo, const int64_t hi) const;
+
+  size_t getFragmentCount() const { return fragment_count_; }
+
+ private:
+  int64_t build(const std::vector<int64_t>& sorted_maxs,
+                const size_t node,
+                const size_t begin,
+                const size_t end);
+
+  void collect(std::vector<size_t>& candidates,
+               const size_t node,
+               const size_t begin,
+               const size_t end,
+               const size_t limit,
+               const int64_t lo) const;
+
+  size_t fragment_count_;
+  // Sorted by minimum.
+  std::vector<int64_t> mins_;
+  std::vector<size_t> positions_;
+  // The maximum of each subtree over the sorted fragments, the root first.
+  std::vector<int64_t> max_tree_;
+  std::vector<size_t> unindexed_positions_;
+};
+
+#endif  // QUERYENGINE_FRAGMENTRANGEINDEX_H
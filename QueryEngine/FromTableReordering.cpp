@@ -0,0 +1,434 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FromTableReordering.h"
+#include "Execute.h"
+#include "ExpressionRange.h"
+#include "RangeTableIndexVisitor.h"
+
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+
+namespace {
+
+// Fraction of the rows kept by a qualifier the statistics say nothing about.
+constexpr double kDefaultSelectivity{0.5};
+// Inserting a row in a hash table costs more than probing it or producing a row.
+constexpr double kHashBuildRowCost{2.};
+// Past this many inputs, the orders are built greedily instead of all being tried.
+constexpr size_t kMaxExhaustiveInputs{8};
+
+// The estimates for a qualifier which references more than one input.
+struct JoinQualEstimate {
+  std::vector<int> inputs;
+  double selectivity;
+  bool hash_joinable;
+};
+
+const Analyzer::ColumnVar* get_column_var(const Analyzer::Expr* expr) {
+  const auto uoper = dynamic_cast<const Analyzer::UOper*>(expr);
+  if (uoper && uoper->get_optype() == kCAST) {
+    expr = uoper->get_operand();
+  }
+  return dynamic_cast<const Analyzer::ColumnVar*>(expr);
+}
+
+double get_input_rows(const Analyzer::ColumnVar* col_var,
+                      const std::vector<InputTableInfo>& table_infos) {
+  const auto rte_idx = static_cast<size_t>(col_var->get_rte_idx());
+  CHECK_LT(rte_idx, table_infos.size());
+  return std::max(static_cast<double>(table_infos[rte_idx].info.getNumTuples()), 1.);
+}
+
+ExpressionRange get_column_range(const Analyzer::ColumnVar* col_var,
+                                 const std::vector<InputTableInfo>& table_infos,
+                                 const Executor* executor) {
+  const auto& ti = col_var->get_type_info();
+  if (ti.is_array() || ti.is_geometry() ||
+      (ti.is_string() && ti.get_compression() != kENCODING_DICT)) {
+    return ExpressionRange::makeInvalidRange();
+  }
+  return getLeafColumnRange(col_var, table_infos, executor, false);
+}
+
+// The statistics computed by ANALYZE TABLE for the column, if any.
+const ColumnStatisticsDescriptor* get_column_statistics(
+    const Analyzer::ColumnVar* col_var,
+    const Executor* executor) {
+  const auto catalog = executor->getCatalog();
+  if (!catalog || col_var->get_table_id() < 0) {
+    return nullptr;
+  }
+  return catalog->getColumnStatistics(col_var->get_table_id(), col_var->get_column_id());
+}
+
+double get_non_null_fraction(const Analyzer::ColumnVar* col_var,
+                             const Executor* executor) {
+  const auto csd = get_column_statistics(col_var, executor);
+  if (!csd || csd->rowCount <= 0) {
+    return 1;
+  }
+  return std::max(1. - static_cast<double>(csd->nullCount) / csd->rowCount, 0.);
+}
+
+// Number of distinct values of a column: from its statistics if it has been analyzed,
+// otherwise an upper bound from its row count and, for integer columns, the size of the
+// range of its values.
+double get_distinct_values(const Analyzer::ColumnVar* col_var,
+                           const std::vector<InputTableInfo>& table_infos,
+                           const Executor* executor) {
+  auto ndv = get_input_rows(col_var, table_infos);
+  const auto csd = get_column_statistics(col_var, executor);
+  if (csd) {
+    return std::max(std::min(ndv, static_cast<double>(csd->distinctCount)), 1.);
+  }
+  const auto col_range = get_column_range(col_var, table_infos, executor);
+  if (col_range.getType() == ExpressionRangeType::Integer &&
+      col_range.getIntMax() >= col_range.getIntMin()) {
+    const auto bucket = col_range.getBucket() ? col_range.getBucket() : 1;
+    ndv = std::min(
+        ndv,
+        static_cast<double>(col_range.getIntMax() - col_range.getIntMin()) / bucket + 1);
+  }
+  return std::max(ndv, 1.);
+}
+
+// Fraction of the values below the given one in an equi-depth histogram, interpolated
+// linearly within the bucket which holds it.
+double get_histogram_fraction_below(const std::vector<double>& histogram,
+                                    const double value) {
+  CHECK_GE(histogram.size(), size_t(2));
+  if (value <= histogram.front()) {
+    return 0;
+  }
+  if (value >= histogram.back()) {
+    return 1;
+  }
+  const auto bucket =
+      std::upper_bound(histogram.begin(), histogram.end(), value) - histogram.begin() - 1;
+  const auto bucket_start = histogram[bucket];
+  const auto bucket_end = histogram[bucket + 1];
+  const auto in_bucket = bucket_end > bucket_start
+                             ? (value - bucket_start) / (bucket_end - bucket_start)
+                             : 0.;
+  return (bucket + in_bucket) / (histogram.size() - 1);
+}
+
+// Fraction of the values of the column on the given side of the constant, from its
+// histogram if it has been analyzed, otherwise assuming they are spread uniformly
+// between the minimum and maximum of the column.
+double get_range_selectivity(const Analyzer::ColumnVar* col_var,
+                             const SQLOps optype,
+                             const Analyzer::Expr* constant,
+                             const std::vector<InputTableInfo>& table_infos,
+                             const Executor* executor) {
+  const auto const_range = getExpressionRange(constant, table_infos, executor);
+  if (const_range.getType() == ExpressionRangeType::Invalid) {
+    return kDefaultSelectivity;
+  }
+  const auto as_double = [](const ExpressionRange& range, const bool min) {
+    if (range.getType() == ExpressionRangeType::Integer) {
+      return static_cast<double>(min ? range.getIntMin() : range.getIntMax());
+    }
+    return min ? range.getFpMin() : range.getFpMax();
+  };
+  const auto value = as_double(const_range, true);
+  const auto csd = get_column_statistics(col_var, executor);
+  double below{0};
+  if (csd && csd->histogram.size() >= 2) {
+    below = get_histogram_fraction_below(csd->histogram, value);
+  } else {
+    const auto col_range = get_column_range(col_var, table_infos, executor);
+    if (col_range.getType() == ExpressionRangeType::Invalid) {
+      return kDefaultSelectivity;
+    }
+    const auto col_min = as_double(col_range, true);
+    const auto col_max = as_double(col_range, false);
+    if (col_max < col_min) {
+      return 0;
+    }
+    below = col_max > col_min ? (value - col_min) / (col_max - col_min)
+                              : (value > col_min ? 1. : 0.);
+    below = std::min(std::max(below, 0.), 1.);
+  }
+  const auto non_null_fraction = get_non_null_fraction(col_var, executor);
+  return non_null_fraction * (optype == kLT || optype == kLE ? below : 1. - below);
+}
+
+SQLOps commute_comparison(const SQLOps optype) {
+  switch (optype) {
+    case kLT:
+      return kGT;
+    case kLE:
+      return kGE;
+    case kGT:
+      return kLT;
+    case kGE:
+      return kLE;
+    default:
+      return optype;
+  }
+}
+
+// Fraction of the rows of its input kept by a qualifier which references only one.
+double get_filter_selectivity(const Analyzer::Expr* qual,
+                              const std::vector<InputTableInfo>& table_infos,
+                              const Executor* executor) {
+  const auto in_values = dynamic_cast<const Analyzer::InValues*>(qual);
+  if (in_values) {
+    const auto col_var = get_column_var(in_values->get_arg());
+    if (!col_var) {
+      return kDefaultSelectivity;
+    }
+    return get_non_null_fraction(col_var, executor) *
+           std::min(static_cast<double>(in_values->get_value_list().size()) /
+                        get_distinct_values(col_var, table_infos, executor),
+                    1.);
+  }
+  const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual);
+  if (!bin_oper || !IS_COMPARISON(bin_oper->get_optype())) {
+    return kDefaultSelectivity;
+  }
+  auto optype = bin_oper->get_optype();
+  auto col_var = get_column_var(bin_oper->get_left_operand());
+  const Analyzer::Expr* constant = bin_oper->get_right_operand();
+  if (!col_var) {
+    col_var = get_column_var(bin_oper->get_right_operand());
+    constant = bin_oper->get_left_operand();
+    optype = commute_comparison(optype);
+  }
+  if (!col_var || !dynamic_cast<const Analyzer::Constant*>(constant)) {
+    return kDefaultSelectivity;
+  }
+  switch (optype) {
+    case kEQ:
+    case kBW_EQ:
+      return get_non_null_fraction(col_var, executor) /
+             get_distinct_values(col_var, table_infos, executor);
+    case kNE:
+      return get_non_null_fraction(col_var, executor) *
+             (1. - 1. / get_distinct_values(col_var, table_infos, executor));
+    case kLT:
+    case kLE:
+    case kGT:
+    case kGE:
+      return get_range_selectivity(col_var, optype, constant, table_infos, executor);
+    default:
+      return kDefaultSelectivity;
+  }
+}
+
+// Fraction of the pairs of rows kept by an equality between columns of two inputs,
+// which is one over the larger number of distinct values when the smaller side's values
+// are all found on the larger side, nulls excluded. Zero if the qualifier isn't such an
+// equality.
+double get_equi_join_selectivity(const Analyzer::Expr* qual,
+                                 const std::vector<InputTableInfo>& table_infos,
+                                 const Executor* executor) {
+  const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual);
+  if (!bin_oper || !IS_EQUIVALENCE(bin_oper->get_optype())) {
+    return 0;
+  }
+  const auto lhs_tuple =
+      dynamic_cast<const Analyzer::ExpressionTuple*>(bin_oper->get_left_operand());
+  const auto rhs_tuple =
+      dynamic_cast<const Analyzer::ExpressionTuple*>(bin_oper->get_right_operand());
+  std::vector<const Analyzer::Expr*> lhs_exprs;
+  std::vector<const Analyzer::Expr*> rhs_exprs;
+  if (lhs_tuple && rhs_tuple) {
+    CHECK_EQ(lhs_tuple->getTuple().size(), rhs_tuple->getTuple().size());
+    for (size_t i = 0; i < lhs_tuple->getTuple().size(); ++i) {
+      lhs_exprs.push_back(lhs_tuple->getTuple()[i].get());
+      rhs_exprs.push_back(rhs_tuple->getTuple()[i].get());
+    }
+  } else {
+    lhs_exprs.push_back(bin_oper->get_left_operand());
+    rhs_exprs.push_back(bin_oper->get_right_operand());
+  }
+  double selectivity{1};
+  for (size_t i = 0; i < lhs_exprs.size(); ++i) {
+    const auto lhs_col = get_column_var(lhs_exprs[i]);
+    const auto rhs_col = get_column_var(rhs_exprs[i]);
+    if (!lhs_col || !rhs_col || lhs_col->get_rte_idx() == rhs_col->get_rte_idx()) {
+      return 0;
+    }
+    selectivity *= get_non_null_fraction(lhs_col, executor) *
+                   get_non_null_fraction(rhs_col, executor) /
+                   std::max(get_distinct_values(lhs_col, table_infos, executor),
+                            get_distinct_values(rhs_col, table_infos, executor));
+  }
+  return selectivity;
+}
+
+// Estimated cost of joining the inputs in the given order; also fills in the rows after
+// every nesting level. The qualifiers are applied at the first level which has all
+// their inputs. Levels without an equi-join qualifier are costed as loop joins.
+double get_join_order_cost(const std::vector<size_t>& permutation,
+                           const std::vector<double>& input_rows,
+                           const std::vector<double>& filtered_rows,
+                           const std::vector<JoinQualEstimate>& join_quals,
+                           std::vector<double>* level_rows) {
+  std::vector<size_t> level_of_input(permutation.size());
+  for (size_t level = 0; level < permutation.size(); ++level) {
+    level_of_input[permutation[level]] = level;
+  }
+  std::vector<double> level_selectivity(permutation.size(), 1.);
+  std::vector<bool> level_hash_joinable(permutation.size(), false);
+  for (const auto& join_qual : join_quals) {
+    size_t qual_level{0};
+    for (const auto input : join_qual.inputs) {
+      qual_level = std::max(qual_level, level_of_input[input]);
+    }
+    level_selectivity[qual_level] *= join_qual.selectivity;
+    if (join_qual.hash_joinable) {
+      level_hash_joinable[qual_level] = true;
+    }
+  }
+  double rows = filtered_rows[permutation.front()];
+  double cost = rows;
+  if (level_rows) {
+    level_rows->assign(1, rows);
+  }
+  for (size_t level = 1; level < permutation.size(); ++level) {
+    const auto input = permutation[level];
+    cost += level_hash_joinable[level] ? kHashBuildRowCost * input_rows[input] + rows
+                                       : rows * input_rows[input];
+    rows *= filtered_rows[input] * level_selectivity[level];
+    cost += rows;
+    if (level_rows) {
+      level_rows->push_back(rows);
+    }
+  }
+  return cost;
+}
+
+}  // namespace
+
+std::string JoinOrderEstimate::toString() const {
+  std::ostringstream oss;
+  oss << "Join order:";
+  for (size_t level = 0; level < input_permutation.size(); ++level) {
+    const auto input = input_permutation[level];
+    oss << (level ? ", " : " ") << "input " << input << " ("
+        << static_cast<size_t>(filtered_rows[input]) << " rows after filters, "
+        << static_cast<size_t>(level_rows[level]) << " rows joined)";
+  }
+  oss << ", estimated cost " << static_cast<size_t>(cost);
+  return oss.str();
+}
+
+JoinOrderEstimate get_cost_based_input_permutation(
+    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const std::vector<InputTableInfo>& table_infos,
+    const Executor* executor) {
+  const auto input_count = table_infos.size();
+  std::vector<double> input_rows;
+  for (const auto& table_info : table_infos) {
+    input_rows.push_back(
+        std::max(static_cast<double>(table_info.info.getNumTuples()), 1.));
+  }
+  auto filtered_rows = input_rows;
+  std::vector<JoinQualEstimate> join_quals;
+  AllRangeTableIndexVisitor rte_idx_visitor;
+  for (const auto& qual : quals) {
+    const auto rte_idx_set = rte_idx_visitor.visit(qual.get());
+    if (rte_idx_set.empty()) {
+      continue;
+    }
+    if (rte_idx_set.size() == 1) {
+      const auto input = static_cast<size_t>(*rte_idx_set.begin());
+      CHECK_LT(input, input_count);
+      filtered_rows[input] *= get_filter_selectivity(qual.get(), table_infos, executor);
+      continue;
+    }
+    JoinQualEstimate join_qual{std::vector<int>(rte_idx_set.begin(), rte_idx_set.end()),
+                               kDefaultSelectivity,
+                               false};
+    const auto equi_join_selectivity =
+        get_equi_join_selectivity(qual.get(), table_infos, executor);
+    if (equi_join_selectivity > 0) {
+      join_qual.selectivity = equi_join_selectivity;
+      join_qual.hash_joinable = rte_idx_set.size() == 2;
+    }
+    join_quals.push_back(join_qual);
+  }
+  for (auto& rows : filtered_rows) {
+    rows = std::max(rows, 1.);
+  }
+
+  // Start from the largest input outermost, as the heuristic ordering does, so that it
+  // is kept when nothing is estimated to be cheaper.
+  std::vector<size_t> permutation(input_count);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::stable_sort(permutation.begin(),
+                   permutation.end(),
+                   [&input_rows](const size_t lhs, const size_t rhs) {
+                     return input_rows[lhs] > input_rows[rhs];
+                   });
+  const auto heuristic_cost =
+      get_join_order_cost(permutation, input_rows, filtered_rows, join_quals, nullptr);
+  JoinOrderEstimate best{permutation, filtered_rows, {}, heuristic_cost};
+  if (input_count <= kMaxExhaustiveInputs) {
+    std::sort(permutation.begin(), permutation.end());
+    do {
+      const auto cost = get_join_order_cost(
+          permutation, input_rows, filtered_rows, join_quals, nullptr);
+      if (cost < best.cost) {
+        best.input_permutation = permutation;
+        best.cost = cost;
+      }
+    } while (std::next_permutation(permutation.begin(), permutation.end()));
+  } else {
+    // Keep the outer input and add the cheapest next input, one level at a time.
+    std::vector<size_t> greedy{best.input_permutation.front()};
+    std::vector<size_t> remaining(best.input_permutation.begin() + 1,
+                                  best.input_permutation.end());
+    while (!remaining.empty()) {
+      auto best_it = remaining.begin();
+      double best_prefix_rows{-1};
+      for (auto it = remaining.begin(); it != remaining.end(); ++it) {
+        auto candidate = greedy;
+        candidate.push_back(*it);
+        for (const auto input : remaining) {
+          if (input != *it) {
+            candidate.push_back(input);
+          }
+        }
+        std::vector<double> candidate_level_rows;
+        get_join_order_cost(
+            candidate, input_rows, filtered_rows, join_quals, &candidate_level_rows);
+        // Compare the prefixes only, the rest is in the same order for all candidates.
+        const auto prefix_rows = candidate_level_rows[greedy.size()];
+        if (best_prefix_rows < 0 || prefix_rows < best_prefix_rows) {
+          best_prefix_rows = prefix_rows;
+          best_it = it;
+        }
+      }
+      greedy.push_back(*best_it);
+      remaining.erase(best_it);
+    }
+    const auto cost =
+        get_join_order_cost(greedy, input_rows, filtered_rows, join_quals, nullptr);
+    if (cost < best.cost) {
+      best.input_permutation = greedy;
+      best.cost = cost;
+    }
+  }
+  get_join_order_cost(
+      best.input_permutation, input_rows, filtered_rows, join_quals, &best.level_rows);
+  return best;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    FromTableReordering.h
+ * @brief   Cost based ordering of the inputs of a left deep inner join.
+ *
+ * The number of rows of every input left after its own filters is estimated from the
+ * column statistics in the fragment metadata, and so is the fraction of row pairs an
+ * equi-join qualifier keeps, from the number of distinct values on both sides. The
+ * order with the lowest cost is then picked among all of them, or greedily when there
+ * are too many inputs. The cost counts the hash table builds over the whole inner
+ * inputs, the probes and the rows produced at every nesting level.
+ */
+
+#ifndef QUERYENGINE_FROMTABLEREORDERING_H
+#define QUERYENGINE_FROMTABLEREORDERING_H
+
+#include "InputMetadata.h"
+
+#include "../Analyzer/Analyzer.h"
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Executor;
+
+struct JoinOrderEstimate {
+  // Inputs in their chosen order, the first one is the outer input.
+  std::vector<size_t> input_permutation;
+  // Estimated rows of each input after its own filters, in the original input order.
+  std::vector<double> filtered_rows;
+  // Estimated rows after each nesting level, in the chosen order.
+  std::vector<double> level_rows;
+  double cost;
+
+  std::string toString() const;
+};
+
+// Picks the order of the inputs which joins them at the lowest estimated cost. The
+// qualifiers are those of the join and of the filter, with the range table indices of
+// the original input order.
+JoinOrderEstimate get_cost_based_input_permutation(
+    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const std::vector<InputTableInfo>& table_infos,
+    const Executor* executor);
+
+#endif  // QUERYENGINE_FROMTABLEREORDERING_H
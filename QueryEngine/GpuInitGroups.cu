@@ -247,3 +247,53 @@ void init_render_buffer_on_device(int64_t* render_buffer,
                                   const size_t grid_size_x) {
   init_render_buffer_wrapper<<<grid_size_x, block_size_x>>>(render_buffer, qw_count);
 }
+
+// Adds up the keyless group by buffers of the blocks into the first one, one thread
+// per entry. The slots set in agg_slot_mask are added up, the other ones hold the group
+// by columns and are copied from the buffers which have hit the entry, the ones with a
+// non-zero value in the slot at key_slot.
+__global__ void reduce_group_by_buffers_gpu(int64_t* groups_buffers,
+                                            const uint32_t buffer_count,
+                                            const size_t buffer_qw_count,
+                                            const uint32_t entry_count,
+                                            const uint32_t row_size_quad,
+                                            const uint32_t key_slot,
+                                            const uint64_t agg_slot_mask) {
+  const int32_t start = blockIdx.x * blockDim.x + threadIdx.x;
+  const int32_t step = blockDim.x * gridDim.x;
+  for (int32_t i = start; i < entry_count; i += step) {
+    int64_t* this_row = groups_buffers + i * row_size_quad;
+    for (uint32_t buffer_idx = 1; buffer_idx < buffer_count; ++buffer_idx) {
+      const int64_t* that_row =
+          groups_buffers + buffer_idx * buffer_qw_count + i * row_size_quad;
+      if (!that_row[key_slot]) {
+        continue;
+      }
+      for (uint32_t j = 0; j < row_size_quad; ++j) {
+        if (agg_slot_mask & (uint64_t(1) << j)) {
+          this_row[j] += that_row[j];
+        } else {
+          this_row[j] = that_row[j];
+        }
+      }
+    }
+  }
+}
+
+void reduce_group_by_buffers_on_device(int64_t* groups_buffers,
+                                       const uint32_t buffer_count,
+                                       const size_t buffer_qw_count,
+                                       const uint32_t entry_count,
+                                       const uint32_t row_size_quad,
+                                       const uint32_t key_slot,
+                                       const uint64_t agg_slot_mask,
+                                       const size_t block_size_x,
+                                       const size_t grid_size_x) {
+  reduce_group_by_buffers_gpu<<<grid_size_x, block_size_x>>>(groups_buffers,
+                                                             buffer_count,
+                                                             buffer_qw_count,
+                                                             entry_count,
+                                                             row_size_quad,
+                                                             key_slot,
+                                                             agg_slot_mask);
+}
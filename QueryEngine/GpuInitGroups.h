@@ -52,4 +52,14 @@ void init_render_buffer_on_device(int64_t* render_buffer,
                                   const uint32_t qw_count,
                                   const size_t block_size_x,
                                   const size_t grid_size_x);
+
+void reduce_group_by_buffers_on_device(int64_t* groups_buffers,
+                                       const uint32_t buffer_count,
+                                       const size_t buffer_qw_count,
+                                       const uint32_t entry_count,
+                                       const uint32_t row_size_quad,
+                                       const uint32_t key_slot,
+                                       const uint64_t agg_slot_mask,
+                                       const size_t block_size_x,
+                                       const size_t grid_size_x);
 #endif  // GPUINITGROUPS_H
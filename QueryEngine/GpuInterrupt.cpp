@@ -122,3 +122,9 @@ void Executor::resetInterrupt() {
   interrupted_ = false;
   VLOG(1) << "RESET Executor " << this << " that had previously been interrupted";
 }
+
+void Executor::checkInterrupted() const {
+  if (interrupted_) {
+    throw QueryInterrupted();
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GpuLaunchTuner.h"
+#include "PersistentCodeCache.h"
+
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstdlib>
+
+bool g_enable_gpu_launch_tuning{false};
+
+namespace {
+
+const size_t LAUNCHES_PER_GRID_SIZE{3};
+// The launches over fewer rows are mostly fixed costs.
+const size_t MIN_TIMED_ROW_COUNT{1000000};
+const std::string PERSISTENT_CACHE_TARGET{"gpu_launch_grid_size"};
+
+}  // namespace
+
+GpuLaunchTuner& GpuLaunchTuner::instance() {
+  static GpuLaunchTuner launch_tuner;
+  return launch_tuner;
+}
+
+unsigned GpuLaunchTuner::getGridSize(const std::string& shape_key,
+                                     const std::vector<unsigned>& candidate_grid_sizes) {
+  CHECK(!candidate_grid_sizes.empty());
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = shapes_.find(shape_key);
+  if (it == shapes_.end()) {
+    ShapeTuning shape_tuning{{}, 0};
+    for (const auto grid_size : candidate_grid_sizes) {
+      shape_tuning.grids.push_back({grid_size, 0, 0, 0});
+    }
+    std::string persisted_grid_size;
+    if (PersistentCodeCache::instance().get(
+            {shape_key}, PERSISTENT_CACHE_TARGET, persisted_grid_size)) {
+      const auto grid_size =
+          static_cast<unsigned>(std::strtoul(persisted_grid_size.c_str(), nullptr, 10));
+      if (std::find(candidate_grid_sizes.begin(),
+                    candidate_grid_sizes.end(),
+                    grid_size) != candidate_grid_sizes.end()) {
+        shape_tuning.best_grid_size = grid_size;
+      }
+    }
+    it = shapes_.emplace(shape_key, shape_tuning).first;
+  }
+  auto& shape_tuning = it->second;
+  if (shape_tuning.best_grid_size) {
+    return shape_tuning.best_grid_size;
+  }
+  const auto least_timed_it =
+      std::min_element(shape_tuning.grids.begin(),
+                       shape_tuning.grids.end(),
+                       [](const GridTimes& lhs, const GridTimes& rhs) {
+                         return lhs.launch_count < rhs.launch_count;
+                       });
+  return least_timed_it->grid_size;
+}
+
+void GpuLaunchTuner::addLaunchTime(const std::string& shape_key,
+                                   const unsigned grid_size,
+                                   const size_t row_count,
+                                   const float milliseconds) {
+  if (row_count < MIN_TIMED_ROW_COUNT) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = shapes_.find(shape_key);
+  if (it == shapes_.end() || it->second.best_grid_size) {
+    return;
+  }
+  auto& shape_tuning = it->second;
+  for (auto& grid_times : shape_tuning.grids) {
+    if (grid_times.grid_size == grid_size) {
+      ++grid_times.launch_count;
+      grid_times.row_count += row_count;
+      grid_times.milliseconds += milliseconds;
+    }
+  }
+  for (const auto& grid_times : shape_tuning.grids) {
+    if (grid_times.launch_count < LAUNCHES_PER_GRID_SIZE) {
+      return;
+    }
+  }
+  const auto best_it = std::min_element(
+      shape_tuning.grids.begin(),
+      shape_tuning.grids.end(),
+      [](const GridTimes& lhs, const GridTimes& rhs) {
+        return lhs.milliseconds / lhs.row_count < rhs.milliseconds / rhs.row_count;
+      });
+  shape_tuning.best_grid_size = best_it->grid_size;
+  LOG(INFO) << "Grid size of the " << shape_key << " kernels tuned to "
+            << shape_tuning.best_grid_size;
+  const auto grid_size_str = std::to_string(shape_tuning.best_grid_size);
+  PersistentCodeCache::instance().put(
+      {shape_key}, PERSISTENT_CACHE_TARGET, grid_size_str.data(), grid_size_str.size());
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    GpuLaunchTuner.h
+ * @brief   Choice of the grid size of the query kernels, by timing their launches.
+ *
+ * The best grid differs between the kinds of kernels (projections, perfect and baseline
+ * hash group-bys, aggregates without group-by) and between GPU models. Kernels of a
+ * shape, the kind of kernel on a GPU architecture with a block size, run with each
+ * candidate grid size in turn until each has been timed a few times over enough rows,
+ * then with the one which took the least time per row. The choice is kept in the
+ * persistent code cache, if enabled, for the next runs.
+ */
+
+#ifndef QUERYENGINE_GPULAUNCHTUNER_H
+#define QUERYENGINE_GPULAUNCHTUNER_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tunes the grid size of the query kernels unless a grid size is configured.
+extern bool g_enable_gpu_launch_tuning;
+
+class GpuLaunchTuner {
+ public:
+  static GpuLaunchTuner& instance();
+
+  // The grid size for the next launch of a kernel of the shape, one of the candidates.
+  unsigned getGridSize(const std::string& shape_key,
+                       const std::vector<unsigned>& candidate_grid_sizes);
+
+  void addLaunchTime(const std::string& shape_key,
+                     const unsigned grid_size,
+                     const size_t row_count,
+                     const float milliseconds);
+
+ private:
+  struct GridTimes {
+    unsigned grid_size;
+    size_t launch_count;
+    size_t row_count;
+    double milliseconds;
+  };
+
+  struct ShapeTuning {
+    std::vector<GridTimes> grids;
+    unsigned best_grid_size;  // zero until tuned
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, ShapeTuning> shapes_;
+};
+
+#endif  // QUERYENGINE_GPULAUNCHTUNER_H
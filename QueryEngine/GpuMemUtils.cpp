@@ -17,6 +17,7 @@
 #include "GpuMemUtils.h"
 #include "CudaAllocator.h"
 #include "GpuInitGroups.h"
+#include "QueryMemoryAccount.h"
 #include "StreamingTopN.h"
 
 #include "../CudaMgr/CudaMgr.h"
@@ -41,6 +42,7 @@ Data_Namespace::AbstractBuffer* alloc_gpu_abstract_buffer(
     Data_Namespace::DataMgr* data_mgr,
     const size_t num_bytes,
     const int device_id) {
+  QueryMemoryAccount::charge(ExecutorDeviceType::GPU, num_bytes);
   auto ab = data_mgr->alloc(Data_Namespace::GPU_LEVEL, device_id, num_bytes);
   CHECK_EQ(ab->getPinCount(), 1);
   return ab;
@@ -113,7 +115,8 @@ GpuGroupByBuffers create_dev_group_by_buffers(
           : 0};
 
   auto group_by_dev_buffers_mem =
-      cuda_allocator.alloc(mem_size + prepended_buff_size, device_id, render_allocator) +
+      cuda_allocator.allocReusable(
+          mem_size + prepended_buff_size, device_id, render_allocator) +
       prepended_buff_size;
   if (query_mem_desc.getCompactByteWidth() < 8) {
     // TODO(miyu): Compaction assumes the base ptr to be aligned to int64_t, otherwise
@@ -263,6 +266,11 @@ int8_t* ThrustAllocator::allocate(std::ptrdiff_t num_bytes) {
     return reinterpret_cast<int8_t*>(ptr);
   }
 #endif  // HAVE_CUDA
+  auto scratch_ptr = data_mgr_->allocScratch(device_id_, num_bytes);
+  if (scratch_ptr) {
+    scratch_ptrs_.insert(scratch_ptr);
+    return scratch_ptr;
+  }
   OOM_TRACE_PUSH(+": device_id " + std::to_string(device_id_) + ", num_bytes " +
                  std::to_string(num_bytes));
   Data_Namespace::AbstractBuffer* ab =
@@ -281,6 +289,10 @@ void ThrustAllocator::deallocate(int8_t* ptr, size_t num_bytes) {
     return;
   }
 #endif  // HAVE_CUDA
+  if (scratch_ptrs_.erase(ptr)) {
+    data_mgr_->freeScratch(device_id_, ptr);
+    return;
+  }
   PtrMapperType::iterator ab_it = raw_to_ab_ptr_.find(ptr);
   CHECK(ab_it != raw_to_ab_ptr_.end());
   data_mgr_->free(ab_it->second);
@@ -297,6 +309,11 @@ int8_t* ThrustAllocator::allocateScopedBuffer(std::ptrdiff_t num_bytes) {
     return reinterpret_cast<int8_t*>(ptr);
   }
 #endif  // HAVE_CUDA
+  auto scratch_ptr = data_mgr_->allocScratch(device_id_, num_bytes);
+  if (scratch_ptr) {
+    scoped_scratch_ptrs_.push_back(scratch_ptr);
+    return scratch_ptr;
+  }
   OOM_TRACE_PUSH(+": device_id " + std::to_string(device_id_) + ", num_bytes " +
                  std::to_string(num_bytes));
   Data_Namespace::AbstractBuffer* ab =
@@ -309,6 +326,9 @@ ThrustAllocator::~ThrustAllocator() {
   for (auto ab : scoped_buffers_) {
     data_mgr_->free(ab);
   }
+  for (auto ptr : scoped_scratch_ptrs_) {
+    data_mgr_->freeScratch(device_id_, ptr);
+  }
 #ifdef HAVE_CUDA
   for (auto ptr : default_alloc_scoped_buffers_) {
     const auto err = cuMemFree(reinterpret_cast<CUdeviceptr>(ptr));
@@ -22,14 +22,17 @@
 #include "ExpressionRange.h"
 #include "ExpressionRewrite.h"
 #include "GpuInitGroups.h"
+#include "GpuLaunchTuner.h"
 #include "InPlaceSort.h"
 #include "LLVMFunctionAttributesUtil.h"
 #include "MaxwellCodegenPatch.h"
 #include "OutputBufferInitialization.h"
+#include "PerfEventCounters.h"
 #include "QueryMemoryDescriptor.h"
 
 #include "../CudaMgr/CudaMgr.h"
 #include "../Shared/checked_alloc.h"
+#include "../Shared/scope.h"
 #include "../Utils/ChunkIter.h"
 #include "DataMgr/BufferMgr/BufferMgr.h"
 #include "Execute.h"
@@ -50,6 +53,7 @@
 
 bool g_cluster{false};
 bool g_bigint_count{false};
+bool g_enable_gpu_group_by_reduction{true};
 int g_hll_precision_bits{11};
 extern size_t g_leaf_count;
 extern bool g_enable_columnar_output;
@@ -72,6 +76,23 @@ int32_t aggregate_error_codes(const std::vector<int32_t>& error_codes) {
   return 0;
 }
 
+// The mask of the slots to add up if the group by buffers of the blocks can be reduced
+// into the first one on the device before being copied to the host, 0 otherwise.
+uint64_t gpu_reduction_agg_slot_mask(const RelAlgExecutionUnit& ra_exe_unit,
+                                     const QueryMemoryDescriptor& query_mem_desc,
+                                     const unsigned grid_size_x) {
+  if (!g_enable_gpu_group_by_reduction || grid_size_x < 2 ||
+      query_mem_desc.getQueryDescriptionType() !=
+          QueryDescriptionType::GroupByPerfectHash ||
+      !query_mem_desc.hasKeylessHash() || query_mem_desc.getInitVal() ||
+      query_mem_desc.didOutputColumnar() || query_mem_desc.blocksShareMemory() ||
+      query_mem_desc.interleavedBins(ExecutorDeviceType::GPU) ||
+      use_speculative_top_n(ra_exe_unit, query_mem_desc)) {
+    return 0;
+  }
+  return query_mem_desc.getSumAggSlotMask(ra_exe_unit.target_exprs);
+}
+
 }  // namespace
 #endif
 
@@ -109,6 +130,13 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
   uint32_t num_fragments = col_buffers.size();
   std::vector<int32_t> error_codes(grid_size_x * block_size_x);
 
+  // The kernels of the launches running at the same time on a device can overlap on
+  // their own streams. These are blocking streams, the synchronous copies on the
+  // default stream still wait for the kernel.
+  CUstream cu_stream;
+  checkCudaErrors(cuStreamCreate(&cu_stream, CU_STREAM_DEFAULT));
+  ScopeGuard destroy_stream = [&cu_stream] { cuStreamDestroy(cu_stream); };
+
   CUevent start0, stop0;  // preparation
   cuEventCreate(&start0, 0);
   cuEventCreate(&stop0, 0);
@@ -119,8 +147,17 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
   cuEventCreate(&start2, 0);
   cuEventCreate(&stop2, 0);
 
+  // the instrumentation waits for each kernel to time it with the events
+  const bool tune_launch{!executor_->launch_shape_key_.empty()};
+  const bool time_kernel{g_enable_dynamic_watchdog || tune_launch ||
+                         (g_enable_kernel_instrumentation && executor_->query_profile_)};
+  size_t row_count{0};
+  for (const auto& frag_num_rows : num_rows) {
+    row_count += frag_num_rows.empty() ? 0 : frag_num_rows.front();
+  }
+
   if (g_enable_dynamic_watchdog) {
-    cuEventRecord(start0, 0);
+    cuEventRecord(start0, cu_stream);
   }
 
   if (g_enable_dynamic_watchdog) {
@@ -173,14 +210,16 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
     }
 
     if (g_enable_dynamic_watchdog) {
-      cuEventRecord(stop0, 0);
+      cuEventRecord(stop0, cu_stream);
       cuEventSynchronize(stop0);
       float milliseconds0 = 0;
       cuEventElapsedTime(&milliseconds0, start0, stop0);
       VLOG(1) << "Device " << std::to_string(device_id)
               << ": launchGpuCode: group-by prepare: " << std::to_string(milliseconds0)
               << " ms";
-      cuEventRecord(start1, 0);
+    }
+    if (time_kernel) {
+      cuEventRecord(start1, cu_stream);
     }
 
     if (hoist_literals) {
@@ -194,7 +233,7 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
                          block_size_y,
                          block_size_z,
                          query_mem_desc_.sharedMemBytes(ExecutorDeviceType::GPU),
-                         nullptr,
+                         cu_stream,
                          &param_ptrs[0],
                          nullptr));
     } else {
@@ -209,21 +248,32 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
                          block_size_y,
                          block_size_z,
                          query_mem_desc_.sharedMemBytes(ExecutorDeviceType::GPU),
-                         nullptr,
+                         cu_stream,
                          &param_ptrs[0],
                          nullptr));
     }
+    float milliseconds1 = 0;
     if (g_enable_dynamic_watchdog) {
       executor_->registerActiveModule(cu_functions[device_id].second, device_id);
-      cuEventRecord(stop1, 0);
+    }
+    if (time_kernel) {
+      cuEventRecord(stop1, cu_stream);
       cuEventSynchronize(stop1);
-      executor_->unregisterActiveModule(cu_functions[device_id].second, device_id);
-      float milliseconds1 = 0;
       cuEventElapsedTime(&milliseconds1, start1, stop1);
+      if (g_enable_kernel_instrumentation && executor_->query_profile_) {
+        executor_->query_profile_->addGpuKernelEventTime(device_id, milliseconds1);
+      }
+      if (tune_launch) {
+        GpuLaunchTuner::instance().addLaunchTime(
+            executor_->launch_shape_key_, grid_size_x, row_count, milliseconds1);
+      }
+    }
+    if (g_enable_dynamic_watchdog) {
+      executor_->unregisterActiveModule(cu_functions[device_id].second, device_id);
       VLOG(1) << "Device " << std::to_string(device_id)
               << ": launchGpuCode: group-by cuLaunchKernel: "
               << std::to_string(milliseconds1) << " ms";
-      cuEventRecord(start2, 0);
+      cuEventRecord(start2, cu_stream);
     }
 
     cuda_allocator.copyFromDevice(&error_codes[0],
@@ -257,15 +307,40 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
                                          data_mgr,
                                          device_id);
         }
-        copy_group_by_buffers_from_gpu(
-            data_mgr,
-            this,
-            gpu_query_mem,
-            ra_exe_unit,
-            block_size_x,
-            grid_size_x,
-            device_id,
-            can_sort_on_gpu && query_mem_desc_.hasKeylessHash());
+        const auto agg_slot_mask =
+            gpu_reduction_agg_slot_mask(ra_exe_unit, query_mem_desc_, grid_size_x);
+        if (agg_slot_mask && !can_sort_on_gpu) {
+          // Only the buffer of the first block comes back to the host, with the
+          // aggregates of all the blocks.
+          const auto groups_buffer_size = query_mem_desc_.getBufferSizeBytes(
+              ra_exe_unit, block_size_x * grid_size_x, ExecutorDeviceType::GPU);
+          reduce_group_by_buffers_on_device(
+              reinterpret_cast<int64_t*>(gpu_query_mem.group_by_buffers.second),
+              grid_size_x,
+              groups_buffer_size / sizeof(int64_t),
+              query_mem_desc_.getEntryCount(),
+              query_mem_desc_.getRowSize() / sizeof(int64_t),
+              query_mem_desc_.getTargetIdxForKey(),
+              agg_slot_mask,
+              block_size_x,
+              grid_size_x);
+          copy_from_gpu(data_mgr,
+                        group_by_buffers_[0],
+                        gpu_query_mem.group_by_buffers.second,
+                        groups_buffer_size,
+                        device_id);
+          group_by_buffers_reduced_on_device_ = true;
+        } else {
+          copy_group_by_buffers_from_gpu(
+              data_mgr,
+              this,
+              gpu_query_mem,
+              ra_exe_unit,
+              block_size_x,
+              grid_size_x,
+              device_id,
+              can_sort_on_gpu && query_mem_desc_.hasKeylessHash());
+        }
       }
     }
   } else {
@@ -307,13 +382,15 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
     }
 
     if (g_enable_dynamic_watchdog) {
-      cuEventRecord(stop0, 0);
+      cuEventRecord(stop0, cu_stream);
       cuEventSynchronize(stop0);
       float milliseconds0 = 0;
       cuEventElapsedTime(&milliseconds0, start0, stop0);
       VLOG(1) << "Device " << std::to_string(device_id)
               << ": launchGpuCode: prepare: " << std::to_string(milliseconds0) << " ms";
-      cuEventRecord(start1, 0);
+    }
+    if (time_kernel) {
+      cuEventRecord(start1, cu_stream);
     }
 
     if (hoist_literals) {
@@ -325,7 +402,7 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
                                      block_size_y,
                                      block_size_z,
                                      0,
-                                     nullptr,
+                                     cu_stream,
                                      &param_ptrs[0],
                                      nullptr));
     } else {
@@ -338,22 +415,33 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
                                      block_size_y,
                                      block_size_z,
                                      0,
-                                     nullptr,
+                                     cu_stream,
                                      &param_ptrs[0],
                                      nullptr));
     }
 
+    float milliseconds1 = 0;
     if (g_enable_dynamic_watchdog) {
       executor_->registerActiveModule(cu_functions[device_id].second, device_id);
-      cuEventRecord(stop1, 0);
+    }
+    if (time_kernel) {
+      cuEventRecord(stop1, cu_stream);
       cuEventSynchronize(stop1);
-      executor_->unregisterActiveModule(cu_functions[device_id].second, device_id);
-      float milliseconds1 = 0;
       cuEventElapsedTime(&milliseconds1, start1, stop1);
+      if (g_enable_kernel_instrumentation && executor_->query_profile_) {
+        executor_->query_profile_->addGpuKernelEventTime(device_id, milliseconds1);
+      }
+      if (tune_launch) {
+        GpuLaunchTuner::instance().addLaunchTime(
+            executor_->launch_shape_key_, grid_size_x, row_count, milliseconds1);
+      }
+    }
+    if (g_enable_dynamic_watchdog) {
+      executor_->unregisterActiveModule(cu_functions[device_id].second, device_id);
       VLOG(1) << "Device " << std::to_string(device_id)
               << ": launchGpuCode: cuLaunchKernel: " << std::to_string(milliseconds1)
               << " ms";
-      cuEventRecord(start2, 0);
+      cuEventRecord(start2, cu_stream);
     }
 
     copy_from_gpu(data_mgr,
@@ -390,7 +478,7 @@ std::vector<int64_t*> QueryExecutionContext::launchGpuCode(
   }
 
   if (g_enable_dynamic_watchdog) {
-    cuEventRecord(stop2, 0);
+    cuEventRecord(stop2, cu_stream);
     cuEventSynchronize(stop2);
     float milliseconds2 = 0;
     cuEventElapsedTime(&milliseconds2, start2, stop2);
@@ -460,9 +548,10 @@ std::vector<int64_t*> QueryExecutionContext::launchCpuCode(
     flatened_frag_offsets.insert(
         flatened_frag_offsets.end(), offsets.begin(), offsets.end());
   }
-  int64_t rowid_lookup_num_rows{*error_code ? *error_code + 1 : 0};
-  auto num_rows_ptr =
-      rowid_lookup_num_rows ? &rowid_lookup_num_rows : &flatened_num_rows[0];
+  // The kernel starts at the row passed through the error code; the caller limits the
+  // row count of the outer fragment for row id lookups and morsels.
+  const bool starts_mid_fragment = *error_code != 0;
+  auto num_rows_ptr = &flatened_num_rows[0];
   int32_t total_matched_init{0};
 
   std::vector<int64_t> cmpt_val_buff;
@@ -477,6 +566,11 @@ std::vector<int64_t*> QueryExecutionContext::launchCpuCode(
       join_hash_tables.size() == 1
           ? reinterpret_cast<int64_t*>(join_hash_tables[0])
           : (join_hash_tables.size() > 1 ? &join_hash_tables[0] : nullptr);
+  std::unique_ptr<PerfEventCounters> perf_counters;
+  if (g_enable_kernel_instrumentation && executor_->query_profile_) {
+    perf_counters = std::make_unique<PerfEventCounters>();
+    perf_counters->start();
+  }
   if (hoist_literals) {
     using agg_query = void (*)(const int8_t***,  // col_buffers
                                const uint32_t*,  // num_fragments
@@ -571,12 +665,15 @@ std::vector<int64_t*> QueryExecutionContext::launchCpuCode(
                                                     join_hash_tables_ptr);
     }
   }
+  if (perf_counters) {
+    executor_->query_profile_->addCpuKernelCounters(perf_counters->stop());
+  }
 
   if (ra_exe_unit.estimator) {
     return {};
   }
 
-  if (rowid_lookup_num_rows && *error_code < 0) {
+  if (starts_mid_fragment && *error_code < 0) {
     *error_code = 0;
   }
 
@@ -1042,17 +1139,30 @@ CountDistinctDescriptors GroupByAndAggregate::initCountDistinctDescriptors() {
     auto agg_info = target_info(target_expr);
     if (is_distinct_target(agg_info)) {
       CHECK(agg_info.is_agg);
-      CHECK(agg_info.agg_kind == kCOUNT || agg_info.agg_kind == kAPPROX_COUNT_DISTINCT);
       const auto agg_expr = static_cast<const Analyzer::AggExpr*>(target_expr);
+      if (agg_info.agg_kind == kAPPROX_QUANTILE) {
+        // The counts of the sketch have a fixed size whatever the range of the argument.
+        const auto quantile = agg_expr->get_quantile();
+        CountDistinctDescriptor quantile_sketch_desc{
+            CountDistinctImplType::Bitmap, 0, 0, false, device_type_, 1};
+        quantile_sketch_desc.quantile =
+            quantile ? quantile->get_constval().doubleval : 0.5;
+        count_distinct_descriptors.push_back(quantile_sketch_desc);
+        continue;
+      }
+      CHECK(agg_info.agg_kind == kCOUNT || is_approx_count_distinct(agg_info.agg_kind));
       const auto& arg_ti = agg_expr->get_arg()->get_type_info();
       if (arg_ti.is_string() && arg_ti.get_compression() != kENCODING_DICT) {
         throw std::runtime_error(
             "Strings must be dictionary-encoded for COUNT(DISTINCT).");
       }
+      const bool approximate = is_approx_count_distinct(agg_info.agg_kind);
+      // an array argument of the sketch and union aggregates is a sketch to merge
+      const bool merges_sketches = approximate && arg_ti.is_array();
       if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT && arg_ti.is_array()) {
         throw std::runtime_error("APPROX_COUNT_DISTINCT on arrays not supported yet");
       }
-      if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT && arg_ti.is_geometry()) {
+      if (approximate && arg_ti.is_geometry()) {
         throw std::runtime_error(
             "APPROX_COUNT_DISTINCT on geometry columns not supported");
       }
@@ -1060,11 +1170,12 @@ CountDistinctDescriptors GroupByAndAggregate::initCountDistinctDescriptors() {
         throw std::runtime_error("COUNT DISTINCT on geometry columns not supported");
       }
       ColRangeInfo no_range_info{QueryDescriptionType::Projection, 0, 0, 0, false};
-      auto arg_range_info =
-          arg_ti.is_fp() ? no_range_info : getExprRangeInfo(agg_expr->get_arg());
+      auto arg_range_info = arg_ti.is_fp() || merges_sketches
+                                ? no_range_info
+                                : getExprRangeInfo(agg_expr->get_arg());
       CountDistinctImplType count_distinct_impl_type{CountDistinctImplType::StdSet};
       int64_t bitmap_sz_bits{0};
-      if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT) {
+      if (approximate) {
         const auto error_rate = agg_expr->get_error_rate();
         if (error_rate) {
           CHECK(error_rate->get_type_info().get_type() == kSMALLINT);
@@ -1081,8 +1192,8 @@ CountDistinctDescriptors GroupByAndAggregate::initCountDistinctDescriptors() {
           count_distinct_descriptors.emplace_back(
               CountDistinctDescriptor{CountDistinctImplType::Bitmap,
                                       0,
-                                      64,
-                                      agg_info.agg_kind == kAPPROX_COUNT_DISTINCT,
+                                      approximate ? bitmap_sz_bits : 64,
+                                      approximate,
                                       device_type_,
                                       1});
           continue;
@@ -1096,10 +1207,14 @@ CountDistinctDescriptors GroupByAndAggregate::initCountDistinctDescriptors() {
           }
         }
       }
-      if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT &&
+      if (approximate && count_distinct_impl_type == CountDistinctImplType::StdSet &&
+          (merges_sketches || !(arg_ti.is_array() || arg_ti.is_geometry()))) {
+        count_distinct_impl_type = CountDistinctImplType::Bitmap;
+      }
+      if (g_enable_roaring_count_distinct &&
           count_distinct_impl_type == CountDistinctImplType::StdSet &&
           !(arg_ti.is_array() || arg_ti.is_geometry())) {
-        count_distinct_impl_type = CountDistinctImplType::Bitmap;
+        count_distinct_impl_type = CountDistinctImplType::Roaring;
       }
       if (g_enable_watchdog &&
           count_distinct_impl_type == CountDistinctImplType::StdSet) {
@@ -1111,7 +1226,7 @@ CountDistinctDescriptors GroupByAndAggregate::initCountDistinctDescriptors() {
           CountDistinctDescriptor{count_distinct_impl_type,
                                   arg_range_info.min,
                                   bitmap_sz_bits,
-                                  agg_info.agg_kind == kAPPROX_COUNT_DISTINCT,
+                                  approximate,
                                   device_type_,
                                   sub_bitmap_count});
     } else {
@@ -1381,7 +1496,8 @@ bool GroupByAndAggregate::gpuCanHandleOrderEntries(
     auto agg_expr = static_cast<Analyzer::AggExpr*>(target_expr);
     if (agg_expr->get_is_distinct() || agg_expr->get_aggtype() == kAVG ||
         agg_expr->get_aggtype() == kMIN || agg_expr->get_aggtype() == kMAX ||
-        agg_expr->get_aggtype() == kAPPROX_COUNT_DISTINCT) {
+        is_approx_count_distinct(agg_expr->get_aggtype()) ||
+        agg_expr->get_aggtype() == kAPPROX_QUANTILE) {
       return false;
     }
     if (agg_expr->get_arg()) {
@@ -1967,7 +2083,11 @@ std::vector<std::string> agg_fn_base_names(const TargetInfo& target_info) {
     case kSUM:
       return {"agg_sum"};
     case kAPPROX_COUNT_DISTINCT:
+    case kAPPROX_COUNT_DISTINCT_SKETCH:
+    case kAPPROX_COUNT_DISTINCT_UNION:
       return {"agg_approximate_count_distinct"};
+    case kAPPROX_QUANTILE:
+      return {"agg_approx_quantile"};
     case kSAMPLE:
       return {"agg_id"};
     default:
@@ -2122,7 +2242,8 @@ bool GroupByAndAggregate::codegenAggCalls(
       } else if (query_mem_desc_.getQueryDescriptionType() ==
                  QueryDescriptionType::NonGroupedAggregate) {
         agg_info.skip_null_val = true;
-      } else if (constrained_not_null(arg_expr, ra_exe_unit_.quals)) {
+      } else if (known_not_null(
+                     arg_expr, ra_exe_unit_.quals, query_infos_, executor_)) {
         agg_info.skip_null_val = false;
       }
     }
@@ -2334,7 +2455,10 @@ bool GroupByAndAggregate::codegenAggCalls(
       const auto needs_unnest_double_patch =
           needsUnnestDoublePatch(target_lv, agg_base_name, co);
       const auto need_skip_null = !needs_unnest_double_patch && agg_info.skip_null_val;
-      if (!needs_unnest_double_patch) {
+      // the chunk iterator of a sketch column is passed through, see codegenCountDistinct
+      const bool merges_sketches = is_approx_count_distinct(agg_info.agg_kind) &&
+                                   arg_expr->get_type_info().is_array();
+      if (!needs_unnest_double_patch && !merges_sketches) {
         if (need_skip_null && agg_info.agg_kind != kCOUNT) {
           target_lv = convertNullIfAny(
               arg_expr->get_type_info(), arg_type, agg_chosen_bytes, target_lv);
@@ -2470,6 +2594,18 @@ extern "C" void agg_count_distinct_skip_val(int64_t* agg,
   }
 }
 
+extern "C" void agg_count_distinct_roaring(int64_t* agg, const int64_t val) {
+  reinterpret_cast<RoaringBitmap*>(*agg)->insert(val);
+}
+
+extern "C" void agg_count_distinct_roaring_skip_val(int64_t* agg,
+                                                    const int64_t val,
+                                                    const int64_t skip_val) {
+  if (val != skip_val) {
+    agg_count_distinct_roaring(agg, val);
+  }
+}
+
 void GroupByAndAggregate::codegenCountDistinct(
     const size_t target_idx,
     const Analyzer::Expr* target_expr,
@@ -2479,24 +2615,53 @@ void GroupByAndAggregate::codegenCountDistinct(
   const auto agg_info = target_info(target_expr);
   const auto& arg_ti =
       static_cast<const Analyzer::AggExpr*>(target_expr)->get_arg()->get_type_info();
+  const auto& count_distinct_descriptor =
+      query_mem_desc.getCountDistinctDescriptor(target_idx);
+  CHECK(count_distinct_descriptor.impl_type_ != CountDistinctImplType::Invalid);
+  if (agg_info.agg_kind == kAPPROX_QUANTILE) {
+    // the argument has been cast to DOUBLE, it's counted in its bucket unless null
+    CHECK(count_distinct_descriptor.isQuantileSketch());
+    CHECK(arg_ti.get_type() == kDOUBLE);
+    agg_args.push_back(executor_->inlineFpNull(arg_ti));
+    if (device_type == ExecutorDeviceType::GPU) {
+      agg_args.push_back(getAdditionalLiteral(-1));
+      agg_args.push_back(getAdditionalLiteral(-2));
+      emitCall("agg_approx_quantile_gpu", agg_args);
+    } else {
+      emitCall("agg_approx_quantile", agg_args);
+    }
+    return;
+  }
   if (arg_ti.is_fp()) {
     agg_args.back() = executor_->cgen_state_->ir_builder_.CreateBitCast(
         agg_args.back(), get_int_type(64, executor_->cgen_state_->context_));
   }
-  const auto& count_distinct_descriptor =
-      query_mem_desc.getCountDistinctDescriptor(target_idx);
-  CHECK(count_distinct_descriptor.impl_type_ != CountDistinctImplType::Invalid);
-  if (agg_info.agg_kind == kAPPROX_COUNT_DISTINCT) {
+  if (is_approx_count_distinct(agg_info.agg_kind)) {
     CHECK(count_distinct_descriptor.impl_type_ == CountDistinctImplType::Bitmap);
+    std::string agg_fname{"agg_approximate_count_distinct"};
+    if (arg_ti.is_array()) {
+      // the argument is a sketch, its registers are merged into the ones of the group
+      const auto arg_expr = static_cast<const Analyzer::AggExpr*>(target_expr)->get_arg();
+      const auto chunk_iter_lv = agg_args.back();
+      agg_args.back() = executor_->cgen_state_->emitExternalCall(
+          "array_buff",
+          llvm::PointerType::get(get_int_type(8, LL_CONTEXT), 0),
+          {chunk_iter_lv, executor_->posArg(arg_expr)});
+      agg_args.push_back(executor_->cgen_state_->emitExternalCall(
+          "array_size",
+          get_int_type(32, LL_CONTEXT),
+          {chunk_iter_lv, executor_->posArg(arg_expr), LL_INT(int32_t(0))}));
+      agg_fname += "_merge";
+    }
     agg_args.push_back(LL_INT(int32_t(count_distinct_descriptor.bitmap_sz_bits)));
     if (device_type == ExecutorDeviceType::GPU) {
       const auto base_dev_addr = getAdditionalLiteral(-1);
       const auto base_host_addr = getAdditionalLiteral(-2);
       agg_args.push_back(base_dev_addr);
       agg_args.push_back(base_host_addr);
-      emitCall("agg_approximate_count_distinct_gpu", agg_args);
+      emitCall(agg_fname + "_gpu", agg_args);
     } else {
-      emitCall("agg_approximate_count_distinct", agg_args);
+      emitCall(agg_fname, agg_args);
     }
     return;
   }
@@ -2504,6 +2669,8 @@ void GroupByAndAggregate::codegenCountDistinct(
   if (count_distinct_descriptor.impl_type_ == CountDistinctImplType::Bitmap) {
     agg_fname += "_bitmap";
     agg_args.push_back(LL_INT(static_cast<int64_t>(count_distinct_descriptor.min_val)));
+  } else if (count_distinct_descriptor.impl_type_ == CountDistinctImplType::Roaring) {
+    agg_fname += "_roaring";
   }
   if (agg_info.skip_null_val) {
     auto null_lv = executor_->castToTypeIn(
@@ -2553,7 +2720,11 @@ std::vector<llvm::Value*> GroupByAndAggregate::codegenAggArg(
   // TODO(alex): handle arrays uniformly?
   if (target_expr) {
     const auto& target_ti = target_expr->get_type_info();
-    if (target_ti.is_array() && !executor_->plan_state_->isLazyFetchColumn(target_expr)) {
+    // a sketch is built in the registers of the group, not fetched
+    const bool is_sketch_target =
+        agg_expr && agg_expr->get_aggtype() == kAPPROX_COUNT_DISTINCT_SKETCH;
+    if (target_ti.is_array() && !is_sketch_target &&
+        !executor_->plan_state_->isLazyFetchColumn(target_expr)) {
       const auto target_lvs =
           agg_expr ? executor_->codegen(agg_expr->get_arg(), true, co)
                    : executor_->codegen(
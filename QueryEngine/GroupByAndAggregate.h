@@ -40,6 +40,7 @@
 #include <vector>
 
 extern bool g_enable_smem_group_by;
+extern bool g_enable_gpu_group_by_reduction;
 
 class ReductionRanOutOfSlots : public std::runtime_error {
  public:
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GroupByBufferPool.h"
+
+#include "../Shared/checked_alloc.h"
+
+extern size_t g_group_by_buffer_pool_max_bytes;
+
+std::mutex GroupByBufferPool::pool_mutex_;
+std::unordered_map<size_t, std::vector<int64_t*>> GroupByBufferPool::free_buffers_;
+size_t GroupByBufferPool::pooled_bytes_{0};
+
+int64_t* GroupByBufferPool::acquire(const size_t num_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    auto it = free_buffers_.find(num_bytes);
+    if (it != free_buffers_.end()) {
+      auto buffer = it->second.back();
+      it->second.pop_back();
+      if (it->second.empty()) {
+        free_buffers_.erase(it);
+      }
+      pooled_bytes_ -= num_bytes;
+      return buffer;
+    }
+  }
+  return reinterpret_cast<int64_t*>(checked_malloc(num_bytes));
+}
+
+void GroupByBufferPool::release(int64_t* buffer, const size_t num_bytes) {
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (pooled_bytes_ + num_bytes <= g_group_by_buffer_pool_max_bytes) {
+      free_buffers_[num_bytes].push_back(buffer);
+      pooled_bytes_ += num_bytes;
+      return;
+    }
+  }
+  free(buffer);
+}
+
+void GroupByBufferPool::clear() {
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  for (auto& kv : free_buffers_) {
+    for (auto buffer : kv.second) {
+      free(buffer);
+    }
+  }
+  free_buffers_.clear();
+  pooled_bytes_ = 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    GroupByBufferPool.h
+ * @brief   Host group by buffers kept across queries.
+ *
+ * The output buffers of a query are sized by its memory descriptor, so a repeated query
+ * asks for buffers of the very same sizes. Instead of handing them back to malloc with
+ * the rest of the result set, the pool keeps them by size, up to a total byte budget,
+ * for the next query to pick up.
+ */
+
+#ifndef QUERYENGINE_GROUPBYBUFFERPOOL_H
+#define QUERYENGINE_GROUPBYBUFFERPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class GroupByBufferPool {
+ public:
+  // Returns a buffer of the given size, recycled if possible. Its content is undefined.
+  static int64_t* acquire(const size_t num_bytes);
+
+  // Takes back a buffer of the given size, frees it if the pool is full.
+  static void release(int64_t* buffer, const size_t num_bytes);
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void { clear(); };
+  }
+
+  static void clear();
+
+ private:
+  static std::mutex pool_mutex_;
+  static std::unordered_map<size_t, std::vector<int64_t*>> free_buffers_;
+  static size_t pooled_bytes_;
+};
+
+#endif  // QUERYENGINE_GROUPBYBUFFERPOOL_H
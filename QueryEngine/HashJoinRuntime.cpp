@@ -30,6 +30,7 @@
 #include "../StringDictionary/StringDictionaryProxy.h"
 #include "RuntimeFunctions.h"
 
+#include <atomic>
 #include <future>
 #endif
 
@@ -1038,6 +1039,172 @@ void fill_one_to_many_hash_table(int32_t* buff,
   }
 }
 
+namespace {
+
+// Bytes of counts and positions one partition of the table gets filled in, sized for
+// the L2 cache of a core.
+constexpr size_t kHashJoinPartitionBytes{256 * 1024};
+
+// The bucket of the row in a perfect hash table, -1 for a row which can't match.
+int64_t get_perfect_hash_bucket(const JoinColumn& join_column,
+                                const JoinColumnTypeInfo& type_info,
+                                const void* sd_inner_proxy,
+                                const void* sd_outer_proxy,
+                                const size_t i) {
+  const auto col_buff = join_column.col_buff;
+  const auto elem_sz = type_info.elem_sz;
+  int64_t elem = type_info.is_unsigned
+                     ? fixed_width_unsigned_decode_noinline(col_buff, elem_sz, i)
+                     : fixed_width_int_decode_noinline(col_buff, elem_sz, i);
+  if (elem == type_info.null_val) {
+    if (type_info.uses_bw_eq) {
+      elem = type_info.translated_null_val;
+    } else {
+      return -1;
+    }
+  }
+  if (sd_inner_proxy &&
+      (!type_info.uses_bw_eq || elem != type_info.translated_null_val)) {
+    CHECK(sd_outer_proxy);
+    const auto sd_inner_dict_proxy =
+        static_cast<const StringDictionaryProxy*>(sd_inner_proxy);
+    const auto sd_outer_dict_proxy =
+        static_cast<const StringDictionaryProxy*>(sd_outer_proxy);
+    const auto elem_str = sd_inner_dict_proxy->getString(elem);
+    const auto outer_id = sd_outer_dict_proxy->getIdOfString(elem_str);
+    if (outer_id == StringDictionary::INVALID_STR_ID) {
+      return -1;
+    }
+    elem = outer_id;
+  }
+  return elem - type_info.min_val;
+}
+
+template <typename F>
+void run_cpu_threads(const int32_t cpu_thread_count, F func) {
+  std::vector<std::future<void>> threads;
+  for (int cpu_thread_idx = 0; cpu_thread_idx < cpu_thread_count; ++cpu_thread_idx) {
+    threads.push_back(std::async(std::launch::async, func, cpu_thread_idx));
+  }
+  for (auto& child : threads) {
+    child.get();
+  }
+}
+
+}  // namespace
+
+void fill_one_to_many_hash_table_partitioned(int32_t* buff,
+                                             const int32_t hash_entry_count,
+                                             const int32_t invalid_slot_val,
+                                             const JoinColumn& join_column,
+                                             const JoinColumnTypeInfo& type_info,
+                                             const void* sd_inner_proxy,
+                                             const void* sd_outer_proxy,
+                                             const int32_t cpu_thread_count) {
+  const size_t entries_per_partition = kHashJoinPartitionBytes / (2 * sizeof(int32_t));
+  const size_t partition_count =
+      (hash_entry_count + entries_per_partition - 1) / entries_per_partition;
+  if (partition_count <= 1) {
+    fill_one_to_many_hash_table(buff,
+                                hash_entry_count,
+                                invalid_slot_val,
+                                join_column,
+                                type_info,
+                                sd_inner_proxy,
+                                sd_outer_proxy,
+                                cpu_thread_count);
+    return;
+  }
+  CHECK_GT(cpu_thread_count, 0);
+  const size_t num_elems = join_column.num_elems;
+  const size_t elems_per_thread = (num_elems + cpu_thread_count - 1) / cpu_thread_count;
+  const auto thread_elems = [num_elems, elems_per_thread](const int thread_idx) {
+    const size_t start = std::min(thread_idx * elems_per_thread, num_elems);
+    return std::make_pair(start, std::min(start + elems_per_thread, num_elems));
+  };
+
+  // Histogram of the partitions over the rows of each thread.
+  std::vector<int32_t> buckets(num_elems);
+  std::vector<std::vector<int32_t>> partition_offsets(
+      cpu_thread_count, std::vector<int32_t>(partition_count, 0));
+  run_cpu_threads(cpu_thread_count, [&](const int thread_idx) {
+    auto& histogram = partition_offsets[thread_idx];
+    const auto elems = thread_elems(thread_idx);
+    for (size_t i = elems.first; i < elems.second; ++i) {
+      const auto bucket = get_perfect_hash_bucket(
+          join_column, type_info, sd_inner_proxy, sd_outer_proxy, i);
+      buckets[i] = bucket;
+      if (bucket >= 0) {
+        ++histogram[bucket / entries_per_partition];
+      }
+    }
+  });
+
+  // The rows of a partition are contiguous, in the order of the threads which read them.
+  std::vector<int32_t> partition_begin(partition_count + 1);
+  int32_t row_count = 0;
+  for (size_t partition = 0; partition < partition_count; ++partition) {
+    partition_begin[partition] = row_count;
+    for (auto& offsets : partition_offsets) {
+      const auto partition_rows = offsets[partition];
+      offsets[partition] = row_count;
+      row_count += partition_rows;
+    }
+  }
+  partition_begin[partition_count] = row_count;
+
+  std::vector<int32_t> partitioned_rows(row_count);
+  std::vector<int32_t> partitioned_buckets(row_count);
+  run_cpu_threads(cpu_thread_count, [&](const int thread_idx) {
+    auto& offsets = partition_offsets[thread_idx];
+    const auto elems = thread_elems(thread_idx);
+    for (size_t i = elems.first; i < elems.second; ++i) {
+      const auto bucket = buckets[i];
+      if (bucket < 0) {
+        continue;
+      }
+      const auto pos = offsets[bucket / entries_per_partition]++;
+      partitioned_rows[pos] = i;
+      partitioned_buckets[pos] = bucket;
+    }
+  });
+  std::vector<int32_t>().swap(buckets);
+
+  // The rows of the buckets of a partition follow the rows of the partitions before.
+  int32_t* pos_buff = buff;
+  int32_t* count_buff = buff + hash_entry_count;
+  int32_t* id_buff = count_buff + hash_entry_count;
+  std::atomic<size_t> next_partition{0};
+  run_cpu_threads(cpu_thread_count, [&](const int thread_idx) {
+    for (size_t partition = next_partition++; partition < partition_count;
+         partition = next_partition++) {
+      const size_t first_bucket = partition * entries_per_partition;
+      const size_t last_bucket =
+          std::min(first_bucket + entries_per_partition, size_t(hash_entry_count));
+      const auto begin = partition_begin[partition];
+      const auto end = partition_begin[partition + 1];
+      memset(count_buff + first_bucket,
+             0,
+             (last_bucket - first_bucket) * sizeof(int32_t));
+      for (auto j = begin; j < end; ++j) {
+        ++count_buff[partitioned_buckets[j]];
+      }
+      int32_t pos = begin;
+      for (size_t bucket = first_bucket; bucket < last_bucket; ++bucket) {
+        if (count_buff[bucket]) {
+          pos_buff[bucket] = pos;
+          pos += count_buff[bucket];
+          count_buff[bucket] = 0;
+        }
+      }
+      for (auto j = begin; j < end; ++j) {
+        const auto bucket = partitioned_buckets[j];
+        id_buff[pos_buff[bucket] + count_buff[bucket]++] = partitioned_rows[j];
+      }
+    }
+  });
+}
+
 void fill_one_to_many_hash_table_sharded(int32_t* buff,
                                          const int32_t hash_entry_count,
                                          const int32_t invalid_slot_val,
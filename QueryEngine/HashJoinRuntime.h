@@ -130,6 +130,18 @@ void fill_one_to_many_hash_table(int32_t* buff,
                                  const void* sd_outer_proxy,
                                  const int32_t cpu_thread_count);
 
+// Builds the same table as fill_one_to_many_hash_table, but scatters the rows by range
+// of buckets first and fills each range on a single thread, so the randomly accessed
+// counts and positions stay in the cache. The row ids of a bucket are in row order.
+void fill_one_to_many_hash_table_partitioned(int32_t* buff,
+                                             const int32_t hash_entry_count,
+                                             const int32_t invalid_slot_val,
+                                             const JoinColumn& join_column,
+                                             const JoinColumnTypeInfo& type_info,
+                                             const void* sd_inner_proxy,
+                                             const void* sd_outer_proxy,
+                                             const int32_t cpu_thread_count);
+
 void fill_one_to_many_hash_table_sharded(int32_t* buff,
                                          const int32_t hash_entry_count,
                                          const int32_t invalid_slot_val,
@@ -157,6 +169,38 @@ void fill_one_to_many_hash_table_on_device_sharded(int32_t* buff,
                                                    const size_t block_size_x,
                                                    const size_t grid_size_x);
 
+// The GPU build in shared memory partitions the slots of the perfect hash table into
+// chunks of 8192 entries, lays the keys out by chunk and lets each block build whole
+// chunks in shared memory. It needs at least one chunk per block, zero is returned when
+// the table is too small or too large for it.
+size_t get_smem_hash_join_partition_count(const int32_t hash_entry_count,
+                                          const size_t grid_size_x);
+
+size_t get_smem_hash_join_scratch_size(const size_t num_elems,
+                                       const size_t partition_count);
+
+void fill_hash_join_buff_on_device_partitioned(int32_t* buff,
+                                               const int32_t hash_entry_count,
+                                               const int32_t invalid_slot_val,
+                                               int* dev_err_buff,
+                                               const JoinColumn join_column,
+                                               const JoinColumnTypeInfo type_info,
+                                               int8_t* scratch_buff,
+                                               const size_t partition_count,
+                                               const size_t block_size_x,
+                                               const size_t grid_size_x);
+
+void fill_one_to_many_hash_table_on_device_partitioned(
+    int32_t* buff,
+    const int32_t hash_entry_count,
+    const int32_t invalid_slot_val,
+    const JoinColumn& join_column,
+    const JoinColumnTypeInfo& type_info,
+    int8_t* scratch_buff,
+    const size_t partition_count,
+    const size_t block_size_x,
+    const size_t grid_size_x);
+
 int fill_baseline_hash_join_buff_32(
     int8_t* hash_buff,
     const size_t entry_count,
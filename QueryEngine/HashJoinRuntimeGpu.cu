@@ -154,6 +154,258 @@ void fill_one_to_many_hash_table_on_device_sharded(int32_t* buff,
       buff, hash_entry_count, invalid_slot_val, join_column, type_info, shard_info);
 }
 
+// Entries of the hash table built by a block in shared memory, 32KB worth of slots.
+#define SMEM_PARTITION_ENTRIES 8192
+
+size_t get_smem_hash_join_partition_count(const int32_t hash_entry_count,
+                                          const size_t grid_size_x) {
+  const size_t partition_count =
+      (static_cast<size_t>(hash_entry_count) + SMEM_PARTITION_ENTRIES - 1) /
+      SMEM_PARTITION_ENTRIES;
+  // Every block must get a partition, the histogram of the partitions is built in
+  // shared memory as well.
+  return partition_count >= grid_size_x && partition_count <= SMEM_PARTITION_ENTRIES
+             ? partition_count
+             : 0;
+}
+
+size_t get_smem_hash_join_scratch_size(const size_t num_elems,
+                                       const size_t partition_count) {
+  return (2 * num_elems + 2 * (partition_count + 1)) * sizeof(int32_t);
+}
+
+// Slot of the i-th key of the column in the hash table, -1 for the keys not in it.
+__device__ int32_t get_partitioned_slot(const JoinColumn& join_column,
+                                        const JoinColumnTypeInfo& type_info,
+                                        const size_t i) {
+  int64_t elem = type_info.is_unsigned ? SUFFIX(fixed_width_unsigned_decode_noinline)(
+                                             join_column.col_buff, type_info.elem_sz, i)
+                                       : SUFFIX(fixed_width_int_decode_noinline)(
+                                             join_column.col_buff, type_info.elem_sz, i);
+  if (elem == type_info.null_val) {
+    if (!type_info.uses_bw_eq) {
+      return -1;
+    }
+    elem = type_info.translated_null_val;
+  }
+  return static_cast<int32_t>(elem - type_info.min_val);
+}
+
+__global__ void count_partition_sizes(int32_t* partition_sizes,
+                                      const size_t partition_count,
+                                      const JoinColumn join_column,
+                                      const JoinColumnTypeInfo type_info) {
+  extern __shared__ int32_t block_partition_sizes[];
+  for (size_t p = threadIdx.x; p < partition_count; p += blockDim.x) {
+    block_partition_sizes[p] = 0;
+  }
+  __syncthreads();
+  const int32_t start = threadIdx.x + blockDim.x * blockIdx.x;
+  const int32_t step = blockDim.x * gridDim.x;
+  for (size_t i = start; i < join_column.num_elems; i += step) {
+    const auto slot = get_partitioned_slot(join_column, type_info, i);
+    if (slot >= 0) {
+      atomicAdd(&block_partition_sizes[slot / SMEM_PARTITION_ENTRIES], 1);
+    }
+  }
+  __syncthreads();
+  for (size_t p = threadIdx.x; p < partition_count; p += blockDim.x) {
+    if (block_partition_sizes[p]) {
+      atomicAdd(&partition_sizes[p], block_partition_sizes[p]);
+    }
+  }
+}
+
+__global__ void scatter_to_partitions(int32_t* partition_cursors,
+                                      int32_t* slots,
+                                      int32_t* row_ids,
+                                      const JoinColumn join_column,
+                                      const JoinColumnTypeInfo type_info) {
+  const int32_t start = threadIdx.x + blockDim.x * blockIdx.x;
+  const int32_t step = blockDim.x * gridDim.x;
+  for (size_t i = start; i < join_column.num_elems; i += step) {
+    const auto slot = get_partitioned_slot(join_column, type_info, i);
+    if (slot >= 0) {
+      const auto pos = atomicAdd(&partition_cursors[slot / SMEM_PARTITION_ENTRIES], 1);
+      slots[pos] = slot;
+      row_ids[pos] = static_cast<int32_t>(i);
+    }
+  }
+}
+
+// Lays the slots and the row ids of the keys out partition by partition in the scratch
+// buffer, returns the offsets of the partitions in there.
+const int32_t* partition_join_column(int8_t* scratch_buff,
+                                     const size_t partition_count,
+                                     const JoinColumn& join_column,
+                                     const JoinColumnTypeInfo& type_info,
+                                     const size_t block_size_x,
+                                     const size_t grid_size_x) {
+  auto partition_offsets = reinterpret_cast<int32_t*>(scratch_buff);
+  auto partition_cursors = partition_offsets + partition_count + 1;
+  auto slots = partition_cursors + partition_count + 1;
+  auto row_ids = slots + join_column.num_elems;
+  cudaMemset(partition_offsets, 0, (partition_count + 1) * sizeof(int32_t));
+  count_partition_sizes<<<grid_size_x,
+                          block_size_x,
+                          partition_count * sizeof(int32_t)>>>(
+      partition_offsets, partition_count, join_column, type_info);
+  auto partition_offsets_dev_ptr = thrust::device_pointer_cast(partition_offsets);
+  thrust::exclusive_scan(partition_offsets_dev_ptr,
+                         partition_offsets_dev_ptr + partition_count + 1,
+                         partition_offsets_dev_ptr);
+  cudaMemcpy(partition_cursors,
+             partition_offsets,
+             (partition_count + 1) * sizeof(int32_t),
+             cudaMemcpyDeviceToDevice);
+  scatter_to_partitions<<<grid_size_x, block_size_x>>>(
+      partition_cursors, slots, row_ids, join_column, type_info);
+  return partition_offsets;
+}
+
+// The blocks take the partitions in turn, building each of them in shared memory.
+__global__ void fill_hash_join_buff_partitioned(int32_t* buff,
+                                                const int32_t hash_entry_count,
+                                                const int32_t invalid_slot_val,
+                                                const int32_t* partition_offsets,
+                                                const size_t partition_count,
+                                                const int32_t* slots,
+                                                const int32_t* row_ids,
+                                                int* err) {
+  __shared__ int32_t partition_buff[SMEM_PARTITION_ENTRIES];
+  for (size_t p = blockIdx.x; p < partition_count; p += gridDim.x) {
+    const int32_t base = p * SMEM_PARTITION_ENTRIES;
+    const int32_t entry_count = min(SMEM_PARTITION_ENTRIES, hash_entry_count - base);
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      partition_buff[j] = invalid_slot_val;
+    }
+    __syncthreads();
+    for (int32_t k = partition_offsets[p] + threadIdx.x; k < partition_offsets[p + 1];
+         k += blockDim.x) {
+      if (atomicCAS(&partition_buff[slots[k] - base], invalid_slot_val, row_ids[k]) !=
+          invalid_slot_val) {
+        atomicCAS(err, 0, -1);
+      }
+    }
+    __syncthreads();
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      buff[base + j] = partition_buff[j];
+    }
+    __syncthreads();
+  }
+}
+
+void fill_hash_join_buff_on_device_partitioned(int32_t* buff,
+                                               const int32_t hash_entry_count,
+                                               const int32_t invalid_slot_val,
+                                               int* dev_err_buff,
+                                               const JoinColumn join_column,
+                                               const JoinColumnTypeInfo type_info,
+                                               int8_t* scratch_buff,
+                                               const size_t partition_count,
+                                               const size_t block_size_x,
+                                               const size_t grid_size_x) {
+  const auto partition_offsets = partition_join_column(
+      scratch_buff, partition_count, join_column, type_info, block_size_x, grid_size_x);
+  const auto slots = partition_offsets + 2 * (partition_count + 1);
+  const auto row_ids = slots + join_column.num_elems;
+  fill_hash_join_buff_partitioned<<<grid_size_x, block_size_x>>>(buff,
+                                                                 hash_entry_count,
+                                                                 invalid_slot_val,
+                                                                 partition_offsets,
+                                                                 partition_count,
+                                                                 slots,
+                                                                 row_ids,
+                                                                 dev_err_buff);
+}
+
+__global__ void count_matches_partitioned(int32_t* count_buff,
+                                          const int32_t hash_entry_count,
+                                          const int32_t* partition_offsets,
+                                          const size_t partition_count,
+                                          const int32_t* slots) {
+  __shared__ int32_t partition_counts[SMEM_PARTITION_ENTRIES];
+  for (size_t p = blockIdx.x; p < partition_count; p += gridDim.x) {
+    const int32_t base = p * SMEM_PARTITION_ENTRIES;
+    const int32_t entry_count = min(SMEM_PARTITION_ENTRIES, hash_entry_count - base);
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      partition_counts[j] = 0;
+    }
+    __syncthreads();
+    for (int32_t k = partition_offsets[p] + threadIdx.x; k < partition_offsets[p + 1];
+         k += blockDim.x) {
+      atomicAdd(&partition_counts[slots[k] - base], 1);
+    }
+    __syncthreads();
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      count_buff[base + j] = partition_counts[j];
+    }
+    __syncthreads();
+  }
+}
+
+// Leaves the counts of matches in the count buffer, as fill_row_ids does.
+__global__ void fill_row_ids_partitioned(int32_t* buff,
+                                         const int32_t hash_entry_count,
+                                         const int32_t* partition_offsets,
+                                         const size_t partition_count,
+                                         const int32_t* slots,
+                                         const int32_t* row_ids) {
+  __shared__ int32_t partition_counts[SMEM_PARTITION_ENTRIES];
+  const int32_t* pos_buff = buff;
+  int32_t* count_buff = buff + hash_entry_count;
+  int32_t* id_buff = count_buff + hash_entry_count;
+  for (size_t p = blockIdx.x; p < partition_count; p += gridDim.x) {
+    const int32_t base = p * SMEM_PARTITION_ENTRIES;
+    const int32_t entry_count = min(SMEM_PARTITION_ENTRIES, hash_entry_count - base);
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      partition_counts[j] = 0;
+    }
+    __syncthreads();
+    for (int32_t k = partition_offsets[p] + threadIdx.x; k < partition_offsets[p + 1];
+         k += blockDim.x) {
+      const auto slot = slots[k];
+      id_buff[pos_buff[slot] + atomicAdd(&partition_counts[slot - base], 1)] =
+          row_ids[k];
+    }
+    __syncthreads();
+    for (int32_t j = threadIdx.x; j < entry_count; j += blockDim.x) {
+      count_buff[base + j] = partition_counts[j];
+    }
+    __syncthreads();
+  }
+}
+
+void fill_one_to_many_hash_table_on_device_partitioned(
+    int32_t* buff,
+    const int32_t hash_entry_count,
+    const int32_t invalid_slot_val,
+    const JoinColumn& join_column,
+    const JoinColumnTypeInfo& type_info,
+    int8_t* scratch_buff,
+    const size_t partition_count,
+    const size_t block_size_x,
+    const size_t grid_size_x) {
+  int32_t* pos_buff = buff;
+  int32_t* count_buff = buff + hash_entry_count;
+  const auto partition_offsets = partition_join_column(
+      scratch_buff, partition_count, join_column, type_info, block_size_x, grid_size_x);
+  const auto slots = partition_offsets + 2 * (partition_count + 1);
+  const auto row_ids = slots + join_column.num_elems;
+  count_matches_partitioned<<<grid_size_x, block_size_x>>>(
+      count_buff, hash_entry_count, partition_offsets, partition_count, slots);
+
+  set_valid_pos_flag<<<grid_size_x, block_size_x>>>(
+      pos_buff, count_buff, hash_entry_count);
+
+  auto count_buff_dev_ptr = thrust::device_pointer_cast(count_buff);
+  thrust::inclusive_scan(
+      count_buff_dev_ptr, count_buff_dev_ptr + hash_entry_count, count_buff_dev_ptr);
+  set_valid_pos<<<grid_size_x, block_size_x>>>(pos_buff, count_buff, hash_entry_count);
+  fill_row_ids_partitioned<<<grid_size_x, block_size_x>>>(
+      buff, hash_entry_count, partition_offsets, partition_count, slots, row_ids);
+}
+
 template <typename T>
 void fill_one_to_many_baseline_hash_table_on_device(
     int32_t* buff,
@@ -29,4 +29,50 @@ FORCE_INLINE uint8_t get_rank(uint64_t x, uint32_t b) {
 }
 #endif
 
+// Maps a register of a sketch with 2^q registers to the register of 2^b registers it
+// is merged into, updating the index and the rank in place. Folding to fewer registers
+// is exact, the index bits dropped lead the bits the rank was computed on. Spreading to
+// more registers isn't, the register is set to the lower bound it's known to have.
+DEVICE inline void hll_fold_register(uint32_t& idx,
+                                     int32_t& rank,
+                                     const uint32_t q,
+                                     const uint32_t b) {
+  if (!rank) {
+    return;
+  }
+  if (q >= b) {
+    const uint32_t d = q - b;
+    auto dropped = idx & ((1u << d) - 1);
+    idx >>= d;
+    if (!dropped) {
+      rank += d;
+      return;
+    }
+    // the leading zeros of the dropped bits, plus one
+    rank = d;
+    while (dropped >>= 1) {
+      --rank;
+    }
+    return;
+  }
+  const uint32_t d = b - q;
+  if (rank > static_cast<int32_t>(d)) {
+    idx <<= d;
+    rank -= d;
+    return;
+  }
+  idx = (idx << d) | (1u << (d - rank));
+  rank = 1;
+}
+
+// The precision of a sketch of the given number of registers, 0 if it isn't one. Null
+// arrays have no registers.
+DEVICE inline uint32_t hll_sketch_precision(const uint32_t sketch_sz) {
+  uint32_t q = 0;
+  while (q < 31 && (1u << q) < sketch_sz) {
+    ++q;
+  }
+  return q >= 4 && (1u << q) == sketch_sz ? q : 0;
+}
+
 #endif  // QUERYENGINE_HYPERLOGLOGRT_H
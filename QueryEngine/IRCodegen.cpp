@@ -17,13 +17,113 @@
 #include "../Parser/ParserNode.h"
 #include "Execute.h"
 #include "MaxwellCodegenPatch.h"
+#include "RangeJoinHashTable.h"
+#include "SpatialJoinHashTable.h"
 #include "RelAlgTranslator.h"
 
 // Driver methods for the IR generation.
 
+namespace {
+
+// Expressions worth computing once per row when they show up several times, in the
+// filter, the group by keys and the targets. All of them are deterministic.
+bool is_cse_candidate(const Analyzer::Expr* expr) {
+  auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(expr);
+  if (bin_oper) {
+    return IS_ARITHMETIC(bin_oper->get_optype());
+  }
+  return dynamic_cast<const Analyzer::CaseExpr*>(expr) ||
+         dynamic_cast<const Analyzer::ExtractExpr*>(expr) ||
+         dynamic_cast<const Analyzer::DateaddExpr*>(expr) ||
+         dynamic_cast<const Analyzer::DatediffExpr*>(expr) ||
+         dynamic_cast<const Analyzer::DatetruncExpr*>(expr);
+}
+
+// Structural equality which also compares the types of the intermediate results,
+// casts included. Analyzer::Expr::operator== ignores them.
+bool is_same_expr(const Analyzer::Expr* lhs, const Analyzer::Expr* rhs) {
+  if (!lhs || !rhs) {
+    return lhs == rhs;
+  }
+  if (!(lhs->get_type_info() == rhs->get_type_info()) || !(*lhs == *rhs)) {
+    return false;
+  }
+  auto lhs_uoper = dynamic_cast<const Analyzer::UOper*>(lhs);
+  if (lhs_uoper) {
+    auto rhs_uoper = static_cast<const Analyzer::UOper*>(rhs);
+    return is_same_expr(lhs_uoper->get_operand(), rhs_uoper->get_operand());
+  }
+  auto lhs_bin_oper = dynamic_cast<const Analyzer::BinOper*>(lhs);
+  if (lhs_bin_oper) {
+    auto rhs_bin_oper = static_cast<const Analyzer::BinOper*>(rhs);
+    return lhs_bin_oper->get_qualifier() == rhs_bin_oper->get_qualifier() &&
+           is_same_expr(lhs_bin_oper->get_left_operand(),
+                        rhs_bin_oper->get_left_operand()) &&
+           is_same_expr(lhs_bin_oper->get_right_operand(),
+                        rhs_bin_oper->get_right_operand());
+  }
+  auto lhs_case = dynamic_cast<const Analyzer::CaseExpr*>(lhs);
+  if (lhs_case) {
+    auto rhs_case = static_cast<const Analyzer::CaseExpr*>(rhs);
+    auto rhs_it = rhs_case->get_expr_pair_list().begin();
+    for (const auto& lhs_pair : lhs_case->get_expr_pair_list()) {
+      if (!is_same_expr(lhs_pair.first.get(), rhs_it->first.get()) ||
+          !is_same_expr(lhs_pair.second.get(), rhs_it->second.get())) {
+        return false;
+      }
+      ++rhs_it;
+    }
+    return is_same_expr(lhs_case->get_else_expr(), rhs_case->get_else_expr());
+  }
+  auto lhs_extract = dynamic_cast<const Analyzer::ExtractExpr*>(lhs);
+  if (lhs_extract) {
+    auto rhs_extract = static_cast<const Analyzer::ExtractExpr*>(rhs);
+    return is_same_expr(lhs_extract->get_from_expr(), rhs_extract->get_from_expr());
+  }
+  auto lhs_datetrunc = dynamic_cast<const Analyzer::DatetruncExpr*>(lhs);
+  if (lhs_datetrunc) {
+    auto rhs_datetrunc = static_cast<const Analyzer::DatetruncExpr*>(rhs);
+    return is_same_expr(lhs_datetrunc->get_from_expr(), rhs_datetrunc->get_from_expr());
+  }
+  auto lhs_dateadd = dynamic_cast<const Analyzer::DateaddExpr*>(lhs);
+  if (lhs_dateadd) {
+    auto rhs_dateadd = static_cast<const Analyzer::DateaddExpr*>(rhs);
+    return is_same_expr(lhs_dateadd->get_number_expr(),
+                        rhs_dateadd->get_number_expr()) &&
+           is_same_expr(lhs_dateadd->get_datetime_expr(),
+                        rhs_dateadd->get_datetime_expr());
+  }
+  auto lhs_datediff = dynamic_cast<const Analyzer::DatediffExpr*>(lhs);
+  if (lhs_datediff) {
+    auto rhs_datediff = static_cast<const Analyzer::DatediffExpr*>(rhs);
+    return is_same_expr(lhs_datediff->get_start_expr(),
+                        rhs_datediff->get_start_expr()) &&
+           is_same_expr(lhs_datediff->get_end_expr(), rhs_datediff->get_end_expr());
+  }
+  return true;
+}
+
+}  // namespace
+
 std::vector<llvm::Value*> Executor::codegen(const Analyzer::Expr* expr,
                                             const bool fetch_columns,
                                             const CompilationOptions& co) {
+  if (!g_enable_expression_cse || !expr || !is_cse_candidate(expr)) {
+    return codegenUncached(expr, fetch_columns, co);
+  }
+  for (const auto& cached : cgen_state_->expr_cache_) {
+    if (is_same_expr(cached.first, expr)) {
+      return cached.second;
+    }
+  }
+  const auto expr_lvs = codegenUncached(expr, fetch_columns, co);
+  cgen_state_->expr_cache_.emplace_back(expr, expr_lvs);
+  return expr_lvs;
+}
+
+std::vector<llvm::Value*> Executor::codegenUncached(const Analyzer::Expr* expr,
+                                                    const bool fetch_columns,
+                                                    const CompilationOptions& co) {
   if (!expr) {
     return {posArg(expr)};
   }
@@ -220,13 +320,16 @@ std::vector<JoinLoop> Executor::buildJoinLoops(
        ++level_idx) {
     const auto& current_level_join_conditions = ra_exe_unit.inner_joins[level_idx];
     std::vector<std::string> fail_reasons;
+    std::list<std::shared_ptr<Analyzer::Expr>> outer_join_residual_quals;
     const auto current_level_hash_table =
         buildCurrentLevelHashTable(current_level_join_conditions,
+                                   level_idx,
                                    ra_exe_unit,
                                    co,
                                    query_infos,
                                    column_cache,
-                                   fail_reasons);
+                                   fail_reasons,
+                                   outer_join_residual_quals);
     const auto found_outer_join_matches_cb =
         [this, level_idx](llvm::Value* found_outer_join_matches) {
           CHECK_LT(level_idx, cgen_state_->outer_join_match_found_per_level_.size());
@@ -236,6 +339,25 @@ std::vector<JoinLoop> Executor::buildJoinLoops(
         };
     const auto is_deleted_cb = buildIsDeletedCb(ra_exe_unit, level_idx, co);
     if (current_level_hash_table) {
+      // The quals of a left join which didn't go into the hash table are evaluated on
+      // the matching rows only, a row without any match for them is still preserved.
+      const auto residual_quals_cb =
+          [this, level_idx, &co, outer_join_residual_quals](
+              const std::vector<llvm::Value*>& prev_iters) {
+            FetchCacheAnchor anchor(cgen_state_.get());
+            addJoinLoopIterator(prev_iters, level_idx + 1);
+            llvm::Value* residual_cond = ll_bool(true);
+            for (const auto& expr : outer_join_residual_quals) {
+              residual_cond = cgen_state_->ir_builder_.CreateAnd(
+                  residual_cond, toBool(codegen(expr.get(), true, co).front()));
+            }
+            return residual_cond;
+          };
+      const auto outer_condition_match_cb =
+          outer_join_residual_quals.empty()
+              ? nullptr
+              : std::function<llvm::Value*(const std::vector<llvm::Value*>&)>(
+                    residual_quals_cb);
       if (current_level_hash_table->getHashType() == JoinHashTable::HashType::OneToOne) {
         join_loops.emplace_back(
             JoinLoopKind::Singleton,
@@ -248,7 +370,7 @@ std::vector<JoinLoop> Executor::buildJoinLoops(
                   current_level_hash_table->codegenSlot(co, current_hash_table_idx);
               return domain;
             },
-            nullptr,
+            outer_condition_match_cb,
             current_level_join_conditions.type == JoinType::LEFT
                 ? std::function<void(llvm::Value*)>(found_outer_join_matches_cb)
                 : nullptr,
@@ -267,7 +389,7 @@ std::vector<JoinLoop> Executor::buildJoinLoops(
               domain.element_count = matching_set.count;
               return domain;
             },
-            nullptr,
+            outer_condition_match_cb,
             current_level_join_conditions.type == JoinType::LEFT
                 ? std::function<void(llvm::Value*)>(found_outer_join_matches_cb)
                 : nullptr,
@@ -382,16 +504,13 @@ Executor::buildIsDeletedCb(const RelAlgExecutionUnit& ra_exe_unit,
 
 std::shared_ptr<JoinHashTableInterface> Executor::buildCurrentLevelHashTable(
     const JoinCondition& current_level_join_conditions,
+    const size_t level_idx,
     RelAlgExecutionUnit& ra_exe_unit,
     const CompilationOptions& co,
     const std::vector<InputTableInfo>& query_infos,
     ColumnCacheMap& column_cache,
-    std::vector<std::string>& fail_reasons) {
-  if (current_level_join_conditions.type != JoinType::INNER &&
-      current_level_join_conditions.quals.size() > 1) {
-    fail_reasons.emplace_back("No equijoin expression found for outer join");
-    return nullptr;
-  }
+    std::vector<std::string>& fail_reasons,
+    std::list<std::shared_ptr<Analyzer::Expr>>& outer_join_residual_quals) {
   std::shared_ptr<JoinHashTableInterface> current_level_hash_table;
   for (const auto& join_qual : current_level_join_conditions.quals) {
     auto qual_bin_oper = std::dynamic_pointer_cast<Analyzer::BinOper>(join_qual);
@@ -399,6 +518,8 @@ std::shared_ptr<JoinHashTableInterface> Executor::buildCurrentLevelHashTable(
       fail_reasons.emplace_back("No equijoin expression found");
       if (current_level_join_conditions.type == JoinType::INNER) {
         add_qualifier_to_execution_unit(ra_exe_unit, join_qual);
+      } else {
+        outer_join_residual_quals.push_back(join_qual);
       }
       continue;
     }
@@ -421,9 +542,58 @@ std::shared_ptr<JoinHashTableInterface> Executor::buildCurrentLevelHashTable(
       fail_reasons.push_back(hash_table_or_error.fail_reason);
       if (current_level_join_conditions.type == JoinType::INNER) {
         add_qualifier_to_execution_unit(ra_exe_unit, qual_bin_oper);
+      } else {
+        outer_join_residual_quals.push_back(qual_bin_oper);
       }
     }
   }
+  if (!current_level_hash_table) {
+    // The loop join evaluates all the quals of an outer join.
+    outer_join_residual_quals.clear();
+  }
+  if (g_enable_range_join_hash_table && !current_level_hash_table &&
+      current_level_join_conditions.type == JoinType::INNER) {
+    // All the quals are in the filter by now, the index only narrows the inner rows
+    // they get evaluated on.
+    try {
+      current_level_hash_table = RangeJoinHashTable::getInstance(
+          current_level_join_conditions.quals,
+          level_idx + 1,
+          query_infos,
+          co.device_type_ == ExecutorDeviceType::GPU ? MemoryLevel::GPU_LEVEL
+                                                     : MemoryLevel::CPU_LEVEL,
+          co.device_type_ == ExecutorDeviceType::GPU
+              ? catalog_->get_dataMgr().cudaMgr_->getDeviceCount()
+              : 1,
+          column_cache,
+          this);
+      plan_state_->join_info_.join_hash_tables_.push_back(current_level_hash_table);
+      plan_state_->join_info_.equi_join_tautologies_.push_back(nullptr);
+    } catch (const HashJoinFail& e) {
+      fail_reasons.emplace_back(e.what());
+    }
+  }
+  if (g_enable_spatial_join_hash_table && !current_level_hash_table &&
+      current_level_join_conditions.type == JoinType::INNER) {
+    // Same as for the range joins, the spatial quals stay in the filter.
+    try {
+      current_level_hash_table = SpatialJoinHashTable::getInstance(
+          current_level_join_conditions.quals,
+          level_idx + 1,
+          query_infos,
+          co.device_type_ == ExecutorDeviceType::GPU ? MemoryLevel::GPU_LEVEL
+                                                     : MemoryLevel::CPU_LEVEL,
+          co.device_type_ == ExecutorDeviceType::GPU
+              ? catalog_->get_dataMgr().cudaMgr_->getDeviceCount()
+              : 1,
+          column_cache,
+          this);
+      plan_state_->join_info_.join_hash_tables_.push_back(current_level_hash_table);
+      plan_state_->join_info_.equi_join_tautologies_.push_back(nullptr);
+    } catch (const HashJoinFail& e) {
+      fail_reasons.emplace_back(e.what());
+    }
+  }
   return current_level_hash_table;
 }
 
@@ -466,7 +636,7 @@ void Executor::codegenJoinLoops(const std::vector<JoinLoop>& join_loops,
             builder.getContext(), "loop_body", builder.GetInsertBlock()->getParent());
         builder.SetInsertPoint(loop_body_bb);
         const bool can_return_error =
-            compileBody(ra_exe_unit, group_by_and_aggregate, co);
+            compileBody(ra_exe_unit, group_by_and_aggregate, co, false);
         if (can_return_error || cgen_state_->needs_error_check_ ||
             eo.with_dynamic_watchdog) {
           createErrorCheckControlFlow(query_func, eo.with_dynamic_watchdog);
@@ -516,6 +686,20 @@ Executor::GroupColLLVMValue Executor::groupByColumnCodegen(
                                {group_key,
                                 posArg(arr_expr),
                                 ll_int(log2_bytes(elem_ti.get_logical_size()))});
+    const auto ar_ret_ty =
+        elem_ti.is_fp()
+            ? (elem_ti.get_type() == kDOUBLE
+                   ? llvm::Type::getDoubleTy(cgen_state_->context_)
+                   : llvm::Type::getFloatTy(cgen_state_->context_))
+            : get_int_type(elem_ti.get_logical_size() * 8, cgen_state_->context_);
+    // The elements are contiguous, the array is looked up once and they're loaded from
+    // its buffer instead of looking it up again for each of them.
+    const auto array_buff = cgen_state_->emitExternalCall(
+        "array_buff",
+        llvm::Type::getInt8PtrTy(cgen_state_->context_),
+        {group_key, posArg(arr_expr)});
+    const auto array_elems =
+        cgen_state_->ir_builder_.CreatePointerCast(array_buff, ar_ret_ty->getPointerTo());
     cgen_state_->ir_builder_.CreateBr(array_loop_head);
     cgen_state_->ir_builder_.SetInsertPoint(array_loop_head);
     CHECK(array_len);
@@ -531,15 +715,8 @@ Executor::GroupColLLVMValue Executor::groupByColumnCodegen(
     cgen_state_->ir_builder_.SetInsertPoint(array_loop_body);
     cgen_state_->ir_builder_.CreateStore(
         cgen_state_->ir_builder_.CreateAdd(array_idx, ll_int(int32_t(1))), array_idx_ptr);
-    const auto array_at_fname = "array_at_" + numeric_type_name(elem_ti);
-    const auto ar_ret_ty =
-        elem_ti.is_fp()
-            ? (elem_ti.get_type() == kDOUBLE
-                   ? llvm::Type::getDoubleTy(cgen_state_->context_)
-                   : llvm::Type::getFloatTy(cgen_state_->context_))
-            : get_int_type(elem_ti.get_logical_size() * 8, cgen_state_->context_);
-    group_key = cgen_state_->emitExternalCall(
-        array_at_fname, ar_ret_ty, {group_key, posArg(arr_expr), array_idx});
+    group_key = cgen_state_->ir_builder_.CreateLoad(
+        cgen_state_->ir_builder_.CreateGEP(array_elems, array_idx));
     if (need_patch_unnest_double(
             elem_ti, isArchMaxwell(co.device_type_), thread_mem_shared)) {
       key_to_cache = spillDoubleElement(group_key, ar_ret_ty);
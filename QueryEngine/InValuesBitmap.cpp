@@ -138,8 +138,8 @@ llvm::Value* InValuesBitmap::codegen(llvm::Value* needle, Executor* executor) co
       "bit_is_set",
       {executor->castToTypeIn(bitset_handle_lvs.front(), 64),
        needle_i64,
-       executor->ll_int(min_val_),
-       executor->ll_int(max_val_),
+       executor->codegenHoistedBigint(min_val_, bitsets_.size()),
+       executor->codegenHoistedBigint(max_val_, bitsets_.size()),
        executor->ll_int(null_val_),
        executor->ll_int(null_bool_val)});
 }
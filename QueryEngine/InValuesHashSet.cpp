@@ -0,0 +1,203 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InValuesHashSet.h"
+#include "Execute.h"
+#ifdef HAVE_CUDA
+#include "GpuMemUtils.h"
+#endif  // HAVE_CUDA
+#include "../Parser/ParserNode.h"
+#include "../Shared/checked_alloc.h"
+#include "RuntimeFunctions.h"
+
+#include <glog/logging.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Keeps the fill rate at or below 50%, the probes stay short.
+size_t get_capacity(const size_t value_count) {
+  size_t capacity{1};
+  while (capacity < 2 * value_count) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+}  // namespace
+
+JoinHashTableCache<InValuesHashSet::HashSetCacheKey,
+                   std::shared_ptr<const InValuesHashSet>>
+    InValuesHashSet::hash_set_cache_(g_in_values_hash_set_cache_max_bytes);
+
+InValuesHashSet::InValuesHashSet(const std::vector<int64_t>& values,
+                                 const int64_t null_val,
+                                 const Data_Namespace::MemoryLevel memory_level,
+                                 const int device_count,
+                                 Data_Namespace::DataMgr* data_mgr)
+    : data_mgr_(data_mgr)
+    , rhs_has_null_(false)
+    , capacity_(0)
+    , null_val_(null_val)
+    , memory_level_(memory_level)
+    , device_count_(device_count) {
+#ifdef HAVE_CUDA
+  CHECK(memory_level_ == Data_Namespace::CPU_LEVEL ||
+        memory_level == Data_Namespace::GPU_LEVEL);
+#else
+  CHECK_EQ(Data_Namespace::CPU_LEVEL, memory_level_);
+#endif  // HAVE_CUDA
+  size_t value_count{0};
+  for (const auto value : values) {
+    if (value == null_val) {
+      rhs_has_null_ = true;
+      continue;
+    }
+    ++value_count;
+  }
+  if (!value_count) {
+    return;
+  }
+  capacity_ = get_capacity(value_count);
+  const auto hash_set_sz_bytes = capacity_ * sizeof(int64_t);
+  auto cpu_hash_set = static_cast<int8_t*>(checked_malloc(hash_set_sz_bytes));
+  auto slots = reinterpret_cast<int64_t*>(cpu_hash_set);
+  std::fill(slots, slots + capacity_, null_val);
+  for (const auto value : values) {
+    if (value == null_val) {
+      continue;
+    }
+    auto slot = in_values_hash_set_slot(value, capacity_);
+    while (slots[slot] != null_val && slots[slot] != value) {
+      slot = (slot + 1) & (capacity_ - 1);
+    }
+    slots[slot] = value;
+  }
+#ifdef HAVE_CUDA
+  if (memory_level_ == Data_Namespace::GPU_LEVEL) {
+    for (int device_id = 0; device_id < device_count_; ++device_id) {
+      auto gpu_buffer = alloc_gpu_abstract_buffer(data_mgr, hash_set_sz_bytes, device_id);
+      gpu_buffers_.push_back(gpu_buffer);
+      auto gpu_hash_set = reinterpret_cast<CUdeviceptr>(gpu_buffer->getMemoryPtr());
+      copy_to_gpu(data_mgr, gpu_hash_set, cpu_hash_set, hash_set_sz_bytes, device_id);
+      hash_sets_.push_back(reinterpret_cast<int8_t*>(gpu_hash_set));
+    }
+    free(cpu_hash_set);
+  } else {
+    hash_sets_.push_back(cpu_hash_set);
+  }
+#else
+  CHECK_EQ(1, device_count_);
+  hash_sets_.push_back(cpu_hash_set);
+#endif  // HAVE_CUDA
+}
+
+InValuesHashSet::~InValuesHashSet() {
+  if (hash_sets_.empty()) {
+    return;
+  }
+  if (memory_level_ == Data_Namespace::CPU_LEVEL) {
+    CHECK_EQ(size_t(1), hash_sets_.size());
+    free(hash_sets_.front());
+  }
+#ifdef HAVE_CUDA
+  for (auto gpu_buffer : gpu_buffers_) {
+    free_gpu_abstract_buffer(data_mgr_, gpu_buffer);
+  }
+#endif  // HAVE_CUDA
+}
+
+llvm::Value* InValuesHashSet::codegen(llvm::Value* needle, Executor* executor) const {
+  CHECK(!hash_sets_.empty());
+  std::vector<std::shared_ptr<const Analyzer::Constant>> constants_owned;
+  std::vector<const Analyzer::Constant*> constants;
+  for (const auto hash_set : hash_sets_) {
+    const int64_t hash_set_handle = reinterpret_cast<int64_t>(hash_set);
+    const auto hash_set_handle_literal = std::dynamic_pointer_cast<Analyzer::Constant>(
+        Parser::IntLiteral::analyzeValue(hash_set_handle));
+    CHECK(hash_set_handle_literal);
+    CHECK_EQ(kENCODING_NONE, hash_set_handle_literal->get_type_info().get_compression());
+    constants_owned.push_back(hash_set_handle_literal);
+    constants.push_back(hash_set_handle_literal.get());
+  }
+  const auto hash_set_handle_lvs =
+      executor->codegenHoistedConstants(constants, kENCODING_NONE, 0);
+  CHECK_EQ(size_t(1), hash_set_handle_lvs.size());
+  const auto needle_i64 = executor->castToTypeIn(needle, 64);
+  const auto null_bool_val =
+      static_cast<int8_t>(inline_int_null_val(SQLTypeInfo(kBOOLEAN, false)));
+  return executor->cgen_state_->emitCall(
+      "hash_set_contains",
+      {executor->castToTypeIn(hash_set_handle_lvs.front(), 64),
+       needle_i64,
+       executor->codegenHoistedBigint(static_cast<int64_t>(capacity_),
+                                      hash_sets_.size()),
+       executor->ll_int(null_val_),
+       executor->ll_int(null_bool_val)});
+}
+
+bool InValuesHashSet::isEmpty() const {
+  return hash_sets_.empty();
+}
+
+bool InValuesHashSet::hasNull() const {
+  return rhs_has_null_;
+}
+
+bool InValuesHashSet::isSmallerThanBitmap(const std::vector<int64_t>& values,
+                                          const int64_t null_val) {
+  size_t value_count{0};
+  auto min_val = std::numeric_limits<int64_t>::max();
+  auto max_val = std::numeric_limits<int64_t>::min();
+  for (const auto value : values) {
+    if (value == null_val) {
+      continue;
+    }
+    min_val = std::min(min_val, value);
+    max_val = std::max(max_val, value);
+    ++value_count;
+  }
+  if (!value_count) {
+    return false;
+  }
+  const auto bitmap_sz_bytes = (static_cast<long double>(max_val) - min_val + 1) / 8;
+  return get_capacity(value_count) * sizeof(int64_t) < bitmap_sz_bytes;
+}
+
+std::shared_ptr<const InValuesHashSet> InValuesHashSet::getOrCreate(
+    const std::vector<int64_t>& values,
+    const int64_t null_val,
+    const Data_Namespace::MemoryLevel memory_level,
+    const int device_count,
+    Data_Namespace::DataMgr* data_mgr) {
+  HashSetCacheKey key{0, values, null_val, memory_level, device_count};
+  std::sort(key.values.begin(), key.values.end());
+  key.values.erase(std::unique(key.values.begin(), key.values.end()), key.values.end());
+  key.values_hash = boost::hash_range(key.values.begin(), key.values.end());
+  const auto cached_hash_set = hash_set_cache_.get(key);
+  if (cached_hash_set) {
+    return *cached_hash_set;
+  }
+  auto hash_set = std::make_shared<const InValuesHashSet>(
+      key.values, null_val, memory_level, device_count, data_mgr);
+  const auto hash_set_bytes =
+      hash_set->capacity_ * sizeof(int64_t) * hash_set->hash_sets_.size() +
+      key.values.size() * sizeof(int64_t);
+  hash_set_cache_.put(key, hash_set, hash_set_bytes);
+  return hash_set;
+}
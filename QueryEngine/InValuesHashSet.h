@@ -0,0 +1,109 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    InValuesHashSet.h
+ * @brief   Existence-only hash set for IN subqueries with sparse values.
+ *
+ * Counterpart of InValuesBitmap for the right-hand sides whose range is too wide for
+ * a bitmap, like the big integer ids of a fact table: the values go into an open
+ * addressing table of twice their count, with no payload, and the needle probes it.
+ *
+ * The hash sets are shared by the queries with the same right-hand side, keyed by the
+ * hash of the sorted values, so that a long IN list sent over and over again is only
+ * hashed and copied to the devices once.
+ */
+
+#ifndef QUERYENGINE_INVALUESHASHSET_H
+#define QUERYENGINE_INVALUESHASHSET_H
+
+#include "../DataMgr/DataMgr.h"
+#include "JoinHashTableCache.h"
+
+#include <llvm/IR/Value.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class Executor;
+
+class InValuesHashSet {
+ public:
+  InValuesHashSet(const std::vector<int64_t>& values,
+                  const int64_t null_val,
+                  const Data_Namespace::MemoryLevel memory_level,
+                  const int device_count,
+                  Data_Namespace::DataMgr* data_mgr);
+  ~InValuesHashSet();
+
+  llvm::Value* codegen(llvm::Value* needle, Executor* executor) const;
+
+  bool isEmpty() const;
+
+  bool hasNull() const;
+
+  // Whether the hash set takes less memory than the bitmap for the given values.
+  static bool isSmallerThanBitmap(const std::vector<int64_t>& values,
+                                  const int64_t null_val);
+
+  // Returns the cached hash set for the values, builds and caches it on a miss.
+  static std::shared_ptr<const InValuesHashSet> getOrCreate(
+      const std::vector<int64_t>& values,
+      const int64_t null_val,
+      const Data_Namespace::MemoryLevel memory_level,
+      const int device_count,
+      Data_Namespace::DataMgr* data_mgr);
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void { hash_set_cache_.clear(); };
+  }
+
+  static JoinHashTableCacheStats getCacheStats() { return hash_set_cache_.getStats(); }
+
+ private:
+  struct HashSetCacheKey {
+    size_t values_hash;
+    // Sorted, without duplicates.
+    std::vector<int64_t> values;
+    int64_t null_val;
+    Data_Namespace::MemoryLevel memory_level;
+    int device_count;
+
+    bool operator==(const HashSetCacheKey& that) const {
+      return values_hash == that.values_hash && null_val == that.null_val &&
+             memory_level == that.memory_level && device_count == that.device_count &&
+             values == that.values;
+    }
+  };
+
+  static JoinHashTableCache<HashSetCacheKey, std::shared_ptr<const InValuesHashSet>>
+      hash_set_cache_;
+
+  std::vector<int8_t*> hash_sets_;
+  // Owned copies on the devices, released with the hash set.
+  std::vector<Data_Namespace::AbstractBuffer*> gpu_buffers_;
+  Data_Namespace::DataMgr* data_mgr_;
+  bool rhs_has_null_;
+  // The capacity is a power of two, the empty slots hold the null value.
+  size_t capacity_;
+  const int64_t null_val_;
+  const Data_Namespace::MemoryLevel memory_level_;
+  const int device_count_;
+};
+
+#endif  // QUERYENGINE_INVALUESHASHSET_H
@@ -35,8 +35,23 @@ llvm::Value* Executor::codegen(const Analyzer::InValues* expr,
     result = ll_int(int8_t(0));
   }
   CHECK(result);
-  if (co.hoist_literals_) {  // TODO(alex): remove this constraint
-    auto in_vals_bitmap = createInValuesBitmap(expr, co);
+  std::vector<int64_t> values;
+  // TODO(alex): remove the literal hoisting constraint
+  if (co.hoist_literals_ && collectInValues(expr, values)) {
+    const auto needle_null_val = inline_int_null_val(in_arg->get_type_info());
+    if (InValuesHashSet::isSmallerThanBitmap(values, needle_null_val)) {
+      CHECK_EQ(size_t(1), lhs_lvs.size());
+      const auto in_vals_hash_set = InValuesHashSet::getOrCreate(
+          values,
+          needle_null_val,
+          co.device_type_ == ExecutorDeviceType::GPU ? Data_Namespace::GPU_LEVEL
+                                                     : Data_Namespace::CPU_LEVEL,
+          deviceCount(co.device_type_),
+          &catalog_->get_dataMgr());
+      return cgen_state_->addInValuesHashSet(in_vals_hash_set)
+          ->codegen(lhs_lvs.front(), this);
+    }
+    auto in_vals_bitmap = createInValuesBitmap(values, needle_null_val, co);
     if (in_vals_bitmap) {
       if (in_vals_bitmap->isEmpty()) {
         return in_vals_bitmap->hasNull() ? inlineIntNull(SQLTypeInfo(kBOOLEAN, false))
@@ -79,13 +94,10 @@ llvm::Value* Executor::codegen(const Analyzer::InIntegerSet* in_integer_set,
         "IN subquery with many right-hand side values not supported when literal "
         "hoisting is disabled");
   }
-  auto in_vals_bitmap = boost::make_unique<InValuesBitmap>(
-      in_integer_set->get_value_list(),
-      needle_null_val,
-      co.device_type_ == ExecutorDeviceType::GPU ? Data_Namespace::GPU_LEVEL
-                                                 : Data_Namespace::CPU_LEVEL,
-      deviceCount(co.device_type_),
-      &catalog_->get_dataMgr());
+  const auto memory_level = co.device_type_ == ExecutorDeviceType::GPU
+                                ? Data_Namespace::GPU_LEVEL
+                                : Data_Namespace::CPU_LEVEL;
+  const auto& value_list = in_integer_set->get_value_list();
   const auto& in_integer_set_ti = in_integer_set->get_type_info();
   CHECK(in_integer_set_ti.is_boolean());
   const auto lhs_lvs = codegen(in_arg, true, co);
@@ -97,29 +109,47 @@ llvm::Value* Executor::codegen(const Analyzer::InIntegerSet* in_integer_set,
     result = ll_int(int8_t(0));
   }
   CHECK(result);
+  CHECK_EQ(size_t(1), lhs_lvs.size());
+  // Sparse values, like the ids of a big table, would need a huge bitmap: only test
+  // their existence in a hash set instead.
+  if (InValuesHashSet::isSmallerThanBitmap(value_list, needle_null_val)) {
+    const auto in_vals_hash_set =
+        InValuesHashSet::getOrCreate(value_list,
+                                     needle_null_val,
+                                     memory_level,
+                                     deviceCount(co.device_type_),
+                                     &catalog_->get_dataMgr());
+    CHECK(!in_vals_hash_set->isEmpty());
+    return cgen_state_->addInValuesHashSet(in_vals_hash_set)
+        ->codegen(lhs_lvs.front(), this);
+  }
+  auto in_vals_bitmap = boost::make_unique<InValuesBitmap>(value_list,
+                                                           needle_null_val,
+                                                           memory_level,
+                                                           deviceCount(co.device_type_),
+                                                           &catalog_->get_dataMgr());
   if (in_vals_bitmap->isEmpty()) {
     return in_vals_bitmap->hasNull() ? inlineIntNull(SQLTypeInfo(kBOOLEAN, false))
                                      : result;
   }
-  CHECK_EQ(size_t(1), lhs_lvs.size());
   return cgen_state_->addInValuesBitmap(in_vals_bitmap)->codegen(lhs_lvs.front(), this);
 }
 
-std::unique_ptr<InValuesBitmap> Executor::createInValuesBitmap(
-    const Analyzer::InValues* in_values,
-    const CompilationOptions& co) {
+// Translates the constants of the IN list to the integers the needle is compared with,
+// dictionary ids for strings, in parallel for the long lists.
+bool Executor::collectInValues(const Analyzer::InValues* in_values,
+                               std::vector<int64_t>& values) {
   const auto& value_list = in_values->get_value_list();
   const auto val_count = value_list.size();
   const auto& ti = in_values->get_arg()->get_type_info();
   if (!(ti.is_integer() || (ti.is_string() && ti.get_compression() == kENCODING_DICT))) {
-    return nullptr;
+    return false;
   }
   const auto sdp = ti.is_string() ? getStringDictionaryProxy(
                                         ti.get_comp_param(), row_set_mem_owner_, true)
                                   : nullptr;
   if (val_count > 3) {
     using ListIterator = decltype(value_list.begin());
-    std::vector<int64_t> values;
     const auto needle_null_val = inline_int_null_val(ti);
     const int worker_count = val_count > 10000 ? cpu_threads() : int(1);
     std::vector<std::vector<int64_t>> values_set(worker_count, std::vector<int64_t>());
@@ -171,7 +201,7 @@ std::unique_ptr<InValuesBitmap> Executor::createInValuesBitmap(
       success &= worker.get();
     }
     if (!success) {
-      return nullptr;
+      return false;
     }
     if (worker_count > 1) {
       size_t total_val_count = 0;
@@ -183,17 +213,24 @@ std::unique_ptr<InValuesBitmap> Executor::createInValuesBitmap(
         values.insert(values.end(), vals.begin(), vals.end());
       }
     }
-    try {
-      return boost::make_unique<InValuesBitmap>(values,
-                                                needle_null_val,
-                                                co.device_type_ == ExecutorDeviceType::GPU
-                                                    ? Data_Namespace::GPU_LEVEL
-                                                    : Data_Namespace::CPU_LEVEL,
-                                                deviceCount(co.device_type_),
-                                                &catalog_->get_dataMgr());
-    } catch (...) {
-      return nullptr;
-    }
+    return true;
+  }
+  return false;
+}
+
+std::unique_ptr<InValuesBitmap> Executor::createInValuesBitmap(
+    const std::vector<int64_t>& values,
+    const int64_t null_val,
+    const CompilationOptions& co) {
+  try {
+    return boost::make_unique<InValuesBitmap>(values,
+                                              null_val,
+                                              co.device_type_ == ExecutorDeviceType::GPU
+                                                  ? Data_Namespace::GPU_LEVEL
+                                                  : Data_Namespace::CPU_LEVEL,
+                                              deviceCount(co.device_type_),
+                                              &catalog_->get_dataMgr());
+  } catch (...) {
+    return nullptr;
   }
-  return nullptr;
 }
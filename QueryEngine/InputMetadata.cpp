@@ -16,6 +16,7 @@
 
 #include "InputMetadata.h"
 #include "Execute.h"
+#include "TableMetadataCache.h"
 
 #include "../Fragmenter/Fragmenter.h"
 
@@ -34,39 +35,24 @@ Fragmenter_Namespace::TableInfo copy_table_info(
   return table_info_copy;
 }
 
-Fragmenter_Namespace::TableInfo build_table_info(
-    const std::vector<const TableDescriptor*>& shard_tables) {
-  size_t total_number_of_tuples{0};
-  Fragmenter_Namespace::TableInfo table_info_all_shards;
-  for (const TableDescriptor* shard_table : shard_tables) {
-    CHECK(shard_table->fragmenter);
-    const auto& shard_metainfo = shard_table->fragmenter->getFragmentsForQuery();
-    total_number_of_tuples += shard_metainfo.getPhysicalNumTuples();
-    table_info_all_shards.fragments.insert(table_info_all_shards.fragments.end(),
-                                           shard_metainfo.fragments.begin(),
-                                           shard_metainfo.fragments.end());
-  }
-  table_info_all_shards.setPhysicalNumTuples(total_number_of_tuples);
-  return table_info_all_shards;
-}
-
 }  // namespace
 
 Fragmenter_Namespace::TableInfo InputTableInfoCache::getTableInfo(const int table_id) {
+  return copy_table_info(*getSharedTableInfo(table_id));
+}
+
+std::shared_ptr<const Fragmenter_Namespace::TableInfo>
+InputTableInfoCache::getSharedTableInfo(const int table_id) {
   const auto it = cache_.find(table_id);
   if (it != cache_.end()) {
-    const auto& table_info = it->second;
-    return copy_table_info(table_info);
+    return it->second;
   }
   const auto cat = executor_->getCatalog();
   CHECK(cat);
-  const auto td = cat->getMetadataForTable(table_id);
-  CHECK(td);
-  const auto shard_tables = cat->getPhysicalTablesDescriptors(td);
-  auto table_info = build_table_info(shard_tables);
-  auto it_ok = cache_.emplace(table_id, copy_table_info(table_info));
+  auto table_info = TableMetadataCache::getTableInfo(*cat, table_id);
+  auto it_ok = cache_.emplace(table_id, table_info);
   CHECK(it_ok.second);
-  return copy_table_info(table_info);
+  return table_info;
 }
 
 void InputTableInfoCache::clear() {
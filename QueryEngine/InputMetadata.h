@@ -20,6 +20,7 @@
 #include "InputDescriptors.h"
 #include "RelAlgExecutionUnit.h"
 
+#include <memory>
 #include <unordered_map>
 
 namespace Catalog_Namespace {
@@ -41,10 +42,14 @@ class InputTableInfoCache {
 
   Fragmenter_Namespace::TableInfo getTableInfo(const int table_id);
 
+  // Same as above without the copy, the fragments stay the same for the whole query.
+  std::shared_ptr<const Fragmenter_Namespace::TableInfo> getSharedTableInfo(
+      const int table_id);
+
   void clear();
 
  private:
-  std::unordered_map<int, Fragmenter_Namespace::TableInfo> cache_;
+  std::unordered_map<int, std::shared_ptr<const Fragmenter_Namespace::TableInfo>> cache_;
   Executor* executor_;
 };
 
@@ -52,12 +52,14 @@ class CollectInputColumnsVisitor
  * compute the number of passing rows, and then generates a set of statistics
  * related to those filters.
  * Later, these stats are used to decide whether
- * a filter should be pushed down or not.
+ * a filter should be pushed down or not, or in which order to evaluate filters.
+ * With first_fragment_only set, only the first fragment of the table is counted.
  */
 FilterSelectivity RelAlgExecutor::getFilterSelectivity(
     const std::vector<std::shared_ptr<Analyzer::Expr>>& filter_expressions,
     const CompilationOptions& co,
-    const ExecutionOptions& eo) {
+    const ExecutionOptions& eo,
+    const bool first_fragment_only) {
   CollectInputColumnsVisitor input_columns_visitor;
   std::list<std::shared_ptr<Analyzer::Expr>> quals;
   std::unordered_set<InputColDescriptor> input_column_descriptors;
@@ -77,6 +79,9 @@ FilterSelectivity RelAlgExecutor::getFilterSelectivity(
     }
     input_col_descs.push_back(std::make_shared<const InputColDescriptor>(input_col_desc));
   }
+  if (input_descs.empty()) {
+    return {false, 1.0, 0};
+  }
   const auto count_expr =
       makeExpr<Analyzer::AggExpr>(SQLTypeInfo(g_bigint_count ? kBIGINT : kINT, false),
                                   kCOUNT,
@@ -97,8 +102,13 @@ FilterSelectivity RelAlgExecutor::getFilterSelectivity(
   int32_t error_code{0};
   size_t one{1};
   ResultSetPtr filtered_result;
-  const auto table_infos = get_table_infos(input_descs, executor_);
+  auto table_infos = get_table_infos(input_descs, executor_);
   CHECK_EQ(size_t(1), table_infos.size());
+  auto& table_info = table_infos.front().info;
+  if (first_fragment_only && table_info.fragments.size() > 1) {
+    table_info.fragments.resize(1);
+    table_info.setPhysicalNumTuples(table_info.fragments.front().getNumTuples());
+  }
   const size_t total_rows_upper_bound = table_infos.front().info.getNumTuplesUpperBound();
   try {
     filtered_result = executor_->executeWorkUnit(&error_code,
@@ -182,21 +192,11 @@ ExecutionResult RelAlgExecutor::executeRelAlgQueryWithFilterPushDown(
                                        /*just_calcite_explain=*/false};
 
     // Dispatch the subqueries first
-    for (auto subquery : subqueries_) {
-      // Execute the subquery and cache the result.
-      RelAlgExecutor ra_executor(executor_, cat_);
-      auto result = ra_executor.executeRelAlgSubQuery(subquery.get(), co, eo_modified);
-      subquery->setExecutionResult(std::make_shared<ExecutionResult>(result));
-    }
+    executeSubqueries(co, eo_modified);
     return executeRelAlgSeq(ed_list, co, eo_modified, render_info, queue_time_ms);
   } else {
     // Dispatch the subqueries first
-    for (auto subquery : subqueries_) {
-      // Execute the subquery and cache the result.
-      RelAlgExecutor ra_executor(executor_, cat_);
-      auto result = ra_executor.executeRelAlgSubQuery(subquery.get(), co, eo);
-      subquery->setExecutionResult(std::make_shared<ExecutionResult>(result));
-    }
+    executeSubqueries(co, eo);
     return executeRelAlgSeq(ed_list, co, eo, render_info, queue_time_ms);
   }
 }
@@ -18,8 +18,12 @@
 #include "Execute.h"
 #include "ExpressionRewrite.h"
 #include "HashJoinRuntime.h"
+#include "QueryMemoryAccount.h"
 #include "RangeTableIndexVisitor.h"
 #include "RuntimeFunctions.h"
+#include "TableMetadataCache.h"
+
+#include "Shared/ThreadPool.h"
 
 #include <glog/logging.h>
 #include <future>
@@ -104,6 +108,9 @@ std::pair<const Analyzer::ColumnVar*, const Analyzer::Expr*> normalize_column_pa
     throw HashJoinFail(
         "Can only apply hash join to integer-like types and dictionary encoded strings");
   }
+  if (inner_col_real_ti.get_compression() == kENCODING_DIFF) {
+    throw HashJoinFail("Cannot apply hash join to DIFF encoded columns");
+  }
   return {inner_col, outer_col ? outer_col : outer_expr};
 }
 
@@ -130,10 +137,13 @@ size_t get_hash_entry_count(const ExpressionRange& col_range, const bool is_bw_e
 
 }  // namespace
 
-std::vector<std::pair<JoinHashTable::JoinHashTableCacheKey,
-                      std::shared_ptr<std::vector<int32_t>>>>
-    JoinHashTable::join_hash_table_cache_;
-std::mutex JoinHashTable::join_hash_table_cache_mutex_;
+JoinHashTableCache<JoinHashTable::JoinHashTableCacheKey,
+                   std::shared_ptr<std::vector<int32_t>>>
+    JoinHashTable::join_hash_table_cache_(g_join_hash_table_cache_max_bytes);
+
+JoinHashTableCache<JoinHashTable::DictionaryTranslationCacheKey,
+                   std::shared_ptr<const std::vector<int32_t>>>
+    JoinHashTable::dictionary_translation_cache_(g_join_hash_table_cache_max_bytes);
 
 size_t get_shard_count(const Analyzer::BinOper* join_condition,
                        const RelAlgExecutionUnit& ra_exe_unit,
@@ -172,6 +182,15 @@ bool shard_count_less_or_equal_device_count(const int inner_table_id,
   return true;
 }
 
+#ifdef HAVE_CUDA
+// Number of partitions for the build in shared memory, zero to build in global memory.
+size_t get_smem_partition_count(const size_t hash_entry_count, const Executor* executor) {
+  return g_enable_smem_hash_join_build
+             ? get_smem_hash_join_partition_count(hash_entry_count, executor->gridSize())
+             : 0;
+}
+#endif  // HAVE_CUDA
+
 }  // namespace
 
 size_t get_shard_count(
@@ -272,6 +291,8 @@ std::shared_ptr<JoinHashTable> JoinHashTable::getInstance(
                                                                           device_count));
   try {
     join_hash_table->reify(device_count);
+  } catch (const QueryInterrupted&) {
+    throw;
   } catch (const std::exception& e) {
     throw HashJoinFail(std::string("Could not build a 1-to-1 correspondence for columns "
                                    "involved in equijoin | ") +
@@ -392,6 +413,7 @@ void JoinHashTable::reify(const int device_count) {
       static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
     throw TooManyHashEntries();
   }
+  initBuildKeyBloomFilter(inner_col, query_info.fragments);
 #ifdef HAVE_CUDA
   gpu_hash_table_buff_.resize(device_count);
 #endif  // HAVE_CUDA
@@ -404,18 +426,10 @@ void JoinHashTable::reify(const int device_count) {
           shard_count
               ? only_shards_for_device(query_info.fragments, device_id, device_count)
               : query_info.fragments;
-      init_threads.push_back(std::async(std::launch::async,
-                                        &JoinHashTable::reifyOneToOneForDevice,
-                                        this,
-                                        fragments,
-                                        device_id));
-    }
-    for (auto& init_thread : init_threads) {
-      init_thread.wait();
-    }
-    for (auto& init_thread : init_threads) {
-      init_thread.get();
+      init_threads.push_back(threadpool::ThreadPool::instance().submit(
+          &JoinHashTable::reifyOneToOneForDevice, this, fragments, device_id));
     }
+    threadpool::wait_all(init_threads);
 
   } catch (const NeedsOneToManyHash& e) {
     hash_type_ = JoinHashTableInterface::HashType::OneToMany;
@@ -427,17 +441,82 @@ void JoinHashTable::reify(const int device_count) {
               ? only_shards_for_device(query_info.fragments, device_id, device_count)
               : query_info.fragments;
 
-      init_threads.push_back(std::async(std::launch::async,
-                                        &JoinHashTable::reifyOneToManyForDevice,
-                                        this,
-                                        fragments,
-                                        device_id));
+      init_threads.push_back(threadpool::ThreadPool::instance().submit(
+          &JoinHashTable::reifyOneToManyForDevice, this, fragments, device_id));
+    }
+    threadpool::wait_all(init_threads);
+  }
+}
+
+void JoinHashTable::initBuildKeyBloomFilter(
+    const Analyzer::ColumnVar* inner_col,
+    const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments) {
+  // The dictionary ids of the inner column can differ from the outer column ones.
+  if (inner_col->get_type_info().is_string()) {
+    return;
+  }
+  std::unique_ptr<ChunkBloomFilter> bloom_filter(new ChunkBloomFilter());
+  for (const auto& fragment : fragments) {
+    const auto& chunk_metadata_map = fragment.getChunkMetadataMap();
+    const auto chunk_meta_it = chunk_metadata_map.find(inner_col->get_column_id());
+    if (chunk_meta_it == chunk_metadata_map.end() ||
+        !chunk_meta_it->second.bloomFilter) {
+      return;
+    }
+    bloom_filter->merge(*chunk_meta_it->second.bloomFilter);
+    if (bloom_filter->isSaturated()) {
+      return;
     }
-    for (auto& init_thread : init_threads) {
-      init_thread.wait();
+  }
+  build_key_bloom_filter_ = std::move(bloom_filter);
+}
+
+bool JoinHashTable::skipOuterFragment(
+    const Fragmenter_Namespace::FragmentInfo& outer_fragment) const {
+  // Null keys match each other with the bitwise equality, their range isn't tracked.
+  if (qual_bin_oper_->get_optype() != kEQ) {
+    return false;
+  }
+  const auto cols = get_cols(
+      qual_bin_oper_.get(), *executor_->getCatalog(), executor_->temporary_tables_);
+  const auto outer_col = dynamic_cast<const Analyzer::ColumnVar*>(cols.second);
+  if (!outer_col || outer_col->get_rte_idx() != 0) {
+    return false;
+  }
+  const auto& inner_ti = col_var_->get_type_info();
+  const auto& outer_ti = outer_col->get_type_info();
+  if (inner_ti.is_string() || outer_ti.get_type() != inner_ti.get_type() ||
+      outer_ti.get_dimension() != inner_ti.get_dimension()) {
+    return false;
+  }
+  const auto& chunk_metadata_map = outer_fragment.getChunkMetadataMap();
+  const auto chunk_meta_it = chunk_metadata_map.find(outer_col->get_column_id());
+  if (chunk_meta_it == chunk_metadata_map.end()) {
+    return false;
+  }
+  const auto& chunk_stats = chunk_meta_it->second.chunkStats;
+  const auto chunk_min = extract_min_stat(chunk_stats, outer_ti);
+  const auto chunk_max = extract_max_stat(chunk_stats, outer_ti);
+  if (chunk_min > col_range_.getIntMax() || chunk_max < col_range_.getIntMin()) {
+    return true;
+  }
+  // Only probe the filters for the fragments covering a narrow range of keys.
+  constexpr uint64_t max_probed_keys{4096};
+  if (!build_key_bloom_filter_ || chunk_min > chunk_max ||
+      static_cast<uint64_t>(chunk_max) - static_cast<uint64_t>(chunk_min) >=
+          max_probed_keys) {
+    return false;
+  }
+  const auto outer_bloom_filter = chunk_meta_it->second.bloomFilter.get();
+  const auto probe_min = std::max(chunk_min, col_range_.getIntMin());
+  const auto probe_max = std::min(chunk_max, col_range_.getIntMax());
+  for (auto key = probe_min;; ++key) {
+    if ((!outer_bloom_filter || outer_bloom_filter->mayContain(key)) &&
+        build_key_bloom_filter_->mayContain(key)) {
+      return false;
     }
-    for (auto& init_thread : init_threads) {
-      init_thread.get();
+    if (key == probe_max) {
+      return true;
     }
   }
 }
@@ -505,8 +584,16 @@ ChunkKey JoinHashTable::genHashTableKey(
     }
     hash_table_key.push_back(outer_elem_count);
   }
-  if (fragments.size() < 2) {
-    hash_table_key.push_back(fragments.front().fragmentId);
+  // The fragment set and the generations of the inner table for the cache. The element
+  // count doesn't change when rows are updated in place.
+  for (const auto& fragment : fragments) {
+    hash_table_key.push_back(fragment.fragmentId);
+  }
+  if (inner_col->get_table_id() > 0) {
+    for (const auto generation : TableMetadataCache::getGenerations(
+             *executor_->getCatalog(), inner_col->get_table_id())) {
+      hash_table_key.push_back(static_cast<int>(generation));
+    }
   }
   return hash_table_key;
 }
@@ -514,6 +601,7 @@ ChunkKey JoinHashTable::genHashTableKey(
 void JoinHashTable::reifyOneToOneForDevice(
     const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
     const int device_id) {
+  executor_->checkInterrupted();
   std::pair<Data_Namespace::AbstractBuffer*, Data_Namespace::AbstractBuffer*>
       buff_and_err;
   const auto& catalog = *executor_->getCatalog();
@@ -577,6 +665,7 @@ void JoinHashTable::reifyOneToOneForDevice(
 void JoinHashTable::reifyOneToManyForDevice(
     const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
     const int device_id) {
+  executor_->checkInterrupted();
   const auto& catalog = *executor_->getCatalog();
   auto& data_mgr = catalog.get_dataMgr();
   const auto cols = get_cols(qual_bin_oper_.get(), catalog, executor_->temporary_tables_);
@@ -637,6 +726,119 @@ void JoinHashTable::checkHashJoinReplicationConstraint(const int table_id) const
   }
 }
 
+namespace {
+
+// Replaces the inner dictionary ids of the column with the outer dictionary ids of the
+// same strings, the rows whose string isn't in the outer dictionary become nulls.
+std::vector<int32_t> translate_join_column(const int8_t* col_buff,
+                                           const size_t num_elements,
+                                           const SQLTypeInfo& ti,
+                                           const std::vector<int32_t>& translation_map,
+                                           const int64_t min_id) {
+  std::vector<int32_t> translated_col(num_elements);
+  const auto null_val = inline_fixed_encoding_null_val(ti);
+  const auto translated_null_val = inline_int_null_value<int32_t>();
+  const size_t thread_count = cpu_threads();
+  const size_t slice_size = (num_elements + thread_count - 1) / thread_count;
+  std::vector<std::future<void>> translate_threads;
+  for (size_t start = 0; start < num_elements; start += slice_size) {
+    const auto end = std::min(start + slice_size, num_elements);
+    translate_threads.push_back(std::async(std::launch::async, [&, start, end] {
+      for (size_t i = start; i < end; ++i) {
+        int64_t elem{0};
+        switch (ti.get_size()) {
+          case 1:
+            elem = reinterpret_cast<const uint8_t*>(col_buff)[i];
+            break;
+          case 2:
+            elem = reinterpret_cast<const uint16_t*>(col_buff)[i];
+            break;
+          case 4:
+            elem = reinterpret_cast<const int32_t*>(col_buff)[i];
+            break;
+          default:
+            CHECK(false);
+        }
+        const auto outer_id =
+            elem == null_val ? StringDictionary::INVALID_STR_ID
+                             : translation_map[elem - min_id];
+        translated_col[i] =
+            outer_id == StringDictionary::INVALID_STR_ID ? translated_null_val : outer_id;
+      }
+    }));
+  }
+  for (auto& child : translate_threads) {
+    child.get();
+  }
+  return translated_col;
+}
+
+}  // namespace
+
+std::shared_ptr<const std::vector<int32_t>> JoinHashTable::getDictionaryTranslationMap(
+    const std::pair<const Analyzer::ColumnVar*, const Analyzer::Expr*>& cols) {
+  const auto inner_col = cols.first;
+  CHECK(inner_col);
+  const auto& ti = inner_col->get_type_info();
+  const auto outer_col = dynamic_cast<const Analyzer::ColumnVar*>(cols.second);
+  // The negative ids are transient strings, which only live as long as the query. The
+  // untranslated rows can't be told apart from nulls with the bitwise equality.
+  if (!g_enable_dictionary_translation_map || !ti.is_string() || !outer_col ||
+      inner_col->get_comp_param() == outer_col->get_comp_param() || isBitwiseEq() ||
+      col_range_.getIntMin() < 0 || col_range_.getIntMin() > col_range_.getIntMax()) {
+    return nullptr;
+  }
+  CHECK_EQ(kENCODING_DICT, ti.get_compression());
+  const auto sd_inner_proxy = executor_->getStringDictionaryProxy(
+      inner_col->get_comp_param(), executor_->row_set_mem_owner_, true);
+  CHECK(sd_inner_proxy);
+  const auto sd_outer_proxy = executor_->getStringDictionaryProxy(
+      outer_col->get_comp_param(), executor_->row_set_mem_owner_, true);
+  CHECK(sd_outer_proxy);
+  const auto min_id = col_range_.getIntMin();
+  const auto max_id = col_range_.getIntMax();
+  const DictionaryTranslationCacheKey cache_key{inner_col->get_comp_param(),
+                                                sd_inner_proxy->getGeneration(),
+                                                outer_col->get_comp_param(),
+                                                sd_outer_proxy->getGeneration(),
+                                                min_id,
+                                                max_id};
+  const auto cached_map = dictionary_translation_cache_.get(cache_key);
+  if (cached_map) {
+    return *cached_map;
+  }
+  const auto inner_generation = sd_inner_proxy->getGeneration();
+  const int64_t inner_string_count =
+      inner_generation >= 0 ? static_cast<int64_t>(inner_generation)
+                            : static_cast<int64_t>(sd_inner_proxy->storageEntryCount());
+  const auto end_id = std::min(max_id + 1, inner_string_count);
+  auto translation_map = std::make_shared<std::vector<int32_t>>(
+      max_id - min_id + 1, StringDictionary::INVALID_STR_ID);
+  const int64_t thread_count = cpu_threads();
+  const auto slice_size =
+      std::max((end_id - min_id + thread_count - 1) / thread_count, int64_t(1));
+  std::vector<std::future<void>> translate_threads;
+  for (auto start = min_id; start < end_id; start += slice_size) {
+    const auto end = std::min(start + slice_size, end_id);
+    translate_threads.push_back(std::async(std::launch::async, [&, start, end] {
+      for (auto id = start; id < end; ++id) {
+        const auto outer_id =
+            sd_outer_proxy->getIdOfString(sd_inner_proxy->getString(id));
+        // The ids out of the range of the join can't match any row of the outer column.
+        if (outer_id >= min_id && outer_id <= max_id) {
+          (*translation_map)[id - min_id] = outer_id;
+        }
+      }
+    }));
+  }
+  for (auto& child : translate_threads) {
+    child.get();
+  }
+  dictionary_translation_cache_.put(
+      cache_key, translation_map, translation_map->size() * sizeof(int32_t));
+  return translation_map;
+}
+
 int JoinHashTable::initHashTableOnCpu(
     const int8_t* col_buff,
     const size_t num_elements,
@@ -648,10 +850,32 @@ int JoinHashTable::initHashTableOnCpu(
   const auto& ti = inner_col->get_type_info();
   int err = 0;
   if (!cpu_hash_table_buff_) {
+    QueryMemoryAccount::charge(ExecutorDeviceType::CPU,
+                               hash_entry_count * sizeof(int32_t));
     cpu_hash_table_buff_ = std::make_shared<std::vector<int32_t>>(hash_entry_count);
+    JoinColumn join_column{col_buff, num_elements};
+    JoinColumnTypeInfo type_info{static_cast<size_t>(ti.get_size()),
+                                 col_range_.getIntMin(),
+                                 inline_fixed_encoding_null_val(ti),
+                                 isBitwiseEq(),
+                                 col_range_.getIntMax() + 1,
+                                 is_unsigned_type(ti)};
+    std::vector<int32_t> translated_col;
     const StringDictionaryProxy* sd_inner_proxy{nullptr};
     const StringDictionaryProxy* sd_outer_proxy{nullptr};
-    if (ti.is_string()) {
+    const auto translation_map = getDictionaryTranslationMap(cols);
+    if (translation_map) {
+      translated_col = translate_join_column(
+          col_buff, num_elements, ti, *translation_map, col_range_.getIntMin());
+      join_column = {reinterpret_cast<const int8_t*>(translated_col.data()),
+                     num_elements};
+      type_info = {sizeof(int32_t),
+                   col_range_.getIntMin(),
+                   inline_int_null_value<int32_t>(),
+                   false,
+                   col_range_.getIntMax() + 1,
+                   false};
+    } else if (ti.is_string()) {
       CHECK_EQ(kENCODING_DICT, ti.get_compression());
       sd_inner_proxy = executor_->getStringDictionaryProxy(
           inner_col->get_comp_param(), executor_->row_set_mem_owner_, true);
@@ -681,23 +905,17 @@ int JoinHashTable::initHashTableOnCpu(
     for (int thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
       init_cpu_buff_threads.emplace_back([this,
                                           hash_join_invalid_val,
-                                          col_buff,
-                                          num_elements,
+                                          join_column,
+                                          type_info,
                                           sd_inner_proxy,
                                           sd_outer_proxy,
                                           thread_idx,
                                           thread_count,
-                                          &ti,
                                           &err] {
         int partial_err = fill_hash_join_buff(&(*cpu_hash_table_buff_)[0],
                                               hash_join_invalid_val,
-                                              {col_buff, num_elements},
-                                              {static_cast<size_t>(ti.get_size()),
-                                               col_range_.getIntMin(),
-                                               inline_fixed_encoding_null_val(ti),
-                                               isBitwiseEq(),
-                                               col_range_.getIntMax() + 1,
-                                               is_unsigned_type(ti)},
+                                              join_column,
+                                              type_info,
                                               sd_inner_proxy,
                                               sd_outer_proxy,
                                               thread_idx,
@@ -727,11 +945,32 @@ void JoinHashTable::initOneToManyHashTableOnCpu(
   if (cpu_hash_table_buff_) {
     return;
   }
+  QueryMemoryAccount::charge(ExecutorDeviceType::CPU,
+                             (2 * hash_entry_count + num_elements) * sizeof(int32_t));
   cpu_hash_table_buff_ =
       std::make_shared<std::vector<int32_t>>(2 * hash_entry_count + num_elements);
+  JoinColumn join_column{col_buff, num_elements};
+  JoinColumnTypeInfo type_info{static_cast<size_t>(ti.get_size()),
+                               col_range_.getIntMin(),
+                               inline_fixed_encoding_null_val(ti),
+                               isBitwiseEq(),
+                               col_range_.getIntMax() + 1,
+                               is_unsigned_type(ti)};
+  std::vector<int32_t> translated_col;
   const StringDictionaryProxy* sd_inner_proxy{nullptr};
   const StringDictionaryProxy* sd_outer_proxy{nullptr};
-  if (ti.is_string()) {
+  const auto translation_map = getDictionaryTranslationMap(cols);
+  if (translation_map) {
+    translated_col = translate_join_column(
+        col_buff, num_elements, ti, *translation_map, col_range_.getIntMin());
+    join_column = {reinterpret_cast<const int8_t*>(translated_col.data()), num_elements};
+    type_info = {sizeof(int32_t),
+                 col_range_.getIntMin(),
+                 inline_int_null_value<int32_t>(),
+                 false,
+                 col_range_.getIntMax() + 1,
+                 false};
+  } else if (ti.is_string()) {
     CHECK_EQ(kENCODING_DICT, ti.get_compression());
     sd_inner_proxy = executor_->getStringDictionaryProxy(
         inner_col->get_comp_param(), executor_->row_set_mem_owner_, true);
@@ -760,19 +999,25 @@ void JoinHashTable::initOneToManyHashTableOnCpu(
     child.get();
   }
 
-  fill_one_to_many_hash_table(&(*cpu_hash_table_buff_)[0],
-                              hash_entry_count,
-                              hash_join_invalid_val,
-                              {col_buff, num_elements},
-                              {static_cast<size_t>(ti.get_size()),
-                               col_range_.getIntMin(),
-                               inline_fixed_encoding_null_val(ti),
-                               isBitwiseEq(),
-                               col_range_.getIntMax() + 1,
-                               is_unsigned_type(ti)},
-                              sd_inner_proxy,
-                              sd_outer_proxy,
-                              thread_count);
+  if (g_enable_partitioned_hash_join_build) {
+    fill_one_to_many_hash_table_partitioned(&(*cpu_hash_table_buff_)[0],
+                                            hash_entry_count,
+                                            hash_join_invalid_val,
+                                            join_column,
+                                            type_info,
+                                            sd_inner_proxy,
+                                            sd_outer_proxy,
+                                            thread_count);
+  } else {
+    fill_one_to_many_hash_table(&(*cpu_hash_table_buff_)[0],
+                                hash_entry_count,
+                                hash_join_invalid_val,
+                                join_column,
+                                type_info,
+                                sd_inner_proxy,
+                                sd_outer_proxy,
+                                thread_count);
+  }
 }
 
 namespace {
@@ -886,6 +1131,8 @@ void JoinHashTable::initHashTableForDevice(
                                  isBitwiseEq(),
                                  col_range_.getIntMax() + 1,
                                  is_unsigned_type(ti)};
+    const auto partition_count =
+        shard_count ? 0 : get_smem_partition_count(hash_entry_count, executor_);
     if (shard_count) {
       CHECK_GT(device_count_, 0);
       for (size_t shard = device_id; shard < shard_count; shard += device_count_) {
@@ -900,6 +1147,22 @@ void JoinHashTable::initHashTableForDevice(
             executor_->blockSize(),
             executor_->gridSize());
       }
+    } else if (partition_count) {
+      // Out of the scratch pool of the device if there's room left in it.
+      ThrustAllocator scratch_allocator(&data_mgr, device_id);
+      auto scratch_buff = scratch_allocator.allocateScopedBuffer(
+          get_smem_hash_join_scratch_size(num_elements, partition_count));
+      fill_hash_join_buff_on_device_partitioned(
+          reinterpret_cast<int32_t*>(gpu_hash_table_buff_[device_id]),
+          hash_entry_count,
+          hash_join_invalid_val,
+          reinterpret_cast<int*>(dev_err_buff),
+          join_column,
+          type_info,
+          scratch_buff,
+          partition_count,
+          executor_->blockSize(),
+          executor_->gridSize());
     } else {
       fill_hash_join_buff_on_device(
           reinterpret_cast<int32_t*>(gpu_hash_table_buff_[device_id]),
@@ -1014,6 +1277,8 @@ void JoinHashTable::initOneToManyHashTable(
                                  isBitwiseEq(),
                                  col_range_.getIntMax() + 1,
                                  is_unsigned_type(ti)};
+    const auto partition_count =
+        shard_count ? 0 : get_smem_partition_count(hash_entry_count, executor_);
     if (shard_count) {
       CHECK_GT(device_count_, 0);
       for (size_t shard = device_id; shard < shard_count; shard += device_count_) {
@@ -1028,6 +1293,21 @@ void JoinHashTable::initOneToManyHashTable(
             executor_->blockSize(),
             executor_->gridSize());
       }
+    } else if (partition_count) {
+      // Out of the scratch pool of the device if there's room left in it.
+      ThrustAllocator scratch_allocator(&data_mgr, device_id);
+      auto scratch_buff = scratch_allocator.allocateScopedBuffer(
+          get_smem_hash_join_scratch_size(num_elements, partition_count));
+      fill_one_to_many_hash_table_on_device_partitioned(
+          reinterpret_cast<int32_t*>(gpu_hash_table_buff_[device_id]),
+          hash_entry_count,
+          hash_join_invalid_val,
+          join_column,
+          type_info,
+          scratch_buff,
+          partition_count,
+          executor_->blockSize(),
+          executor_->gridSize());
     } else {
       fill_one_to_many_hash_table_on_device(
           reinterpret_cast<int32_t*>(gpu_hash_table_buff_[device_id]),
@@ -1055,12 +1335,9 @@ void JoinHashTable::initHashTableOnCpuFromCache(
                                   num_elements,
                                   chunk_key,
                                   qual_bin_oper_->get_optype()};
-  std::lock_guard<std::mutex> join_hash_table_cache_lock(join_hash_table_cache_mutex_);
-  for (const auto& kv : join_hash_table_cache_) {
-    if (kv.first == cache_key) {
-      cpu_hash_table_buff_ = kv.second;
-      break;
-    }
+  const auto cached_buff = join_hash_table_cache_.get(cache_key);
+  if (cached_buff) {
+    cpu_hash_table_buff_ = *cached_buff;
   }
 }
 
@@ -1075,13 +1352,9 @@ void JoinHashTable::putHashTableOnCpuToCache(
                                   num_elements,
                                   chunk_key,
                                   qual_bin_oper_->get_optype()};
-  std::lock_guard<std::mutex> join_hash_table_cache_lock(join_hash_table_cache_mutex_);
-  for (const auto& kv : join_hash_table_cache_) {
-    if (kv.first == cache_key) {
-      return;
-    }
-  }
-  join_hash_table_cache_.emplace_back(cache_key, cpu_hash_table_buff_);
+  join_hash_table_cache_.put(cache_key,
+                             cpu_hash_table_buff_,
+                             cpu_hash_table_buff_->size() * sizeof(int32_t));
 }
 
 llvm::Value* JoinHashTable::codegenHashTableLoad(const size_t table_idx) {
@@ -31,6 +31,7 @@
 #include "ExpressionRange.h"
 #include "InputDescriptors.h"
 #include "InputMetadata.h"
+#include "JoinHashTableCache.h"
 #include "JoinHashTableInterface.h"
 #include "ResultRows.h"
 #include "ThrustAllocator.h"
@@ -92,6 +93,9 @@ class JoinHashTable : public JoinHashTableInterface {
 
   HashType getHashType() const noexcept override { return hash_type_; }
 
+  bool skipOuterFragment(
+      const Fragmenter_Namespace::FragmentInfo& outer_fragment) const override;
+
   static llvm::Value* codegenOneToManyHashJoin(
       const std::vector<llvm::Value*>& hash_join_idx_args_in,
       const size_t inner_rte_idx,
@@ -112,10 +116,11 @@ class JoinHashTable : public JoinHashTableInterface {
   static llvm::Value* codegenHashTableLoad(const size_t table_idx, Executor* executor);
 
   static auto yieldCacheInvalidator() -> std::function<void()> {
-    return []() -> void {
-      std::lock_guard<std::mutex> guard(join_hash_table_cache_mutex_);
-      join_hash_table_cache_.clear();
-    };
+    return []() -> void { join_hash_table_cache_.clear(); };
+  }
+
+  static JoinHashTableCacheStats getCacheStats() {
+    return join_hash_table_cache_.getStats();
   }
 
   virtual ~JoinHashTable() {}
@@ -162,6 +167,9 @@ class JoinHashTable : public JoinHashTableInterface {
       const Analyzer::ColumnVar* inner_col) const;
 
   void reify(const int device_count);
+  void initBuildKeyBloomFilter(
+      const Analyzer::ColumnVar* inner_col,
+      const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments);
   void reifyOneToOneForDevice(
       const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments,
       const int device_id);
@@ -206,6 +214,11 @@ class JoinHashTable : public JoinHashTableInterface {
       const int32_t hash_entry_count,
       const int32_t hash_join_invalid_val);
 
+  // Maps the inner dictionary ids in the range of the join to the outer dictionary ids
+  // of the same strings, null if the build has to translate the rows one by one.
+  std::shared_ptr<const std::vector<int32_t>> getDictionaryTranslationMap(
+      const std::pair<const Analyzer::ColumnVar*, const Analyzer::Expr*>& cols);
+
   const InputTableInfo& getInnerQueryInfo(const Analyzer::ColumnVar* inner_col) const;
 
   size_t shardCount() const;
@@ -243,6 +256,8 @@ class JoinHashTable : public JoinHashTableInterface {
   std::vector<CUdeviceptr> gpu_hash_table_buff_;
 #endif
   ExpressionRange col_range_;
+  // Union of the bloom filters of the chunks of the build side, if all of them have one.
+  std::unique_ptr<ChunkBloomFilter> build_key_bloom_filter_;
   Executor* executor_;
   const RelAlgExecutionUnit& ra_exe_unit_;
   ColumnCacheMap& column_cache_;
@@ -266,10 +281,30 @@ class JoinHashTable : public JoinHashTableInterface {
     }
   };
 
-  static std::vector<
-      std::pair<JoinHashTableCacheKey, std::shared_ptr<std::vector<int32_t>>>>
+  static JoinHashTableCache<JoinHashTableCacheKey, std::shared_ptr<std::vector<int32_t>>>
       join_hash_table_cache_;
-  static std::mutex join_hash_table_cache_mutex_;
+
+  struct DictionaryTranslationCacheKey {
+    const int inner_dict_id;
+    const ssize_t inner_generation;
+    const int outer_dict_id;
+    const ssize_t outer_generation;
+    const int64_t min_id;
+    const int64_t max_id;
+
+    bool operator==(const struct DictionaryTranslationCacheKey& that) const {
+      return inner_dict_id == that.inner_dict_id &&
+             inner_generation == that.inner_generation &&
+             outer_dict_id == that.outer_dict_id &&
+             outer_generation == that.outer_generation && min_id == that.min_id &&
+             max_id == that.max_id;
+    }
+  };
+
+  // The dictionaries only grow, a translation map stays valid for their generations.
+  static JoinHashTableCache<DictionaryTranslationCacheKey,
+                            std::shared_ptr<const std::vector<int32_t>>>
+      dictionary_translation_cache_;
 
   static const int ERR_MULTI_FRAG{-2};
   static const int ERR_FAILED_TO_FETCH_COLUMN{-3};
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    JoinHashTableCache.h
+ * @brief   Cache of the CPU join hash tables shared across queries.
+ *
+ * The hash tables of the dimension tables get reused by the following queries on the
+ * same columns instead of being built again. The cache holds at most a given number of
+ * bytes and evicts the least recently used tables to make room for new ones.
+ */
+
+#ifndef QUERYENGINE_JOINHASHTABLECACHE_H
+#define QUERYENGINE_JOINHASHTABLECACHE_H
+
+#include <glog/logging.h>
+#include <boost/optional.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <ostream>
+
+struct JoinHashTableCacheStats {
+  size_t hits;
+  size_t misses;
+  size_t evictions;
+  size_t entry_count;
+  size_t bytes;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const JoinHashTableCacheStats& stats) {
+  return os << stats.entry_count << " tables, " << stats.bytes << " bytes, "
+            << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions
+            << " evictions";
+}
+
+template <class K, class V>
+class JoinHashTableCache {
+ public:
+  // The limit is read on every insertion, it can be a flag set after the construction.
+  explicit JoinHashTableCache(const size_t& max_bytes)
+      : max_bytes_(max_bytes), bytes_(0), hits_(0), misses_(0), evictions_(0) {}
+
+  // Marks the table as the most recently used one.
+  boost::optional<V> get(const K& key) {
+    return get(key, [](const V&) { return true; });
+  }
+
+  // Same as above, an entry the predicate rejects is a miss. The predicate runs under
+  // the cache lock.
+  boost::optional<V> get(const K& key, const std::function<bool(const V&)>& usable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->key == key) {
+        if (!usable(it->value)) {
+          break;
+        }
+        entries_.splice(entries_.begin(), entries_, it);
+        ++hits_;
+        return it->value;
+      }
+    }
+    ++misses_;
+    return boost::none;
+  }
+
+  // Doesn't replace a table already in the cache. A table larger than the limit isn't
+  // cached at all rather than flushing all the others.
+  void put(const K& key, const V& value, const size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& entry : entries_) {
+      if (entry.key == key) {
+        return;
+      }
+    }
+    if (bytes > max_bytes_) {
+      return;
+    }
+    while (bytes_ + bytes > max_bytes_) {
+      evictLeastRecentlyUsed();
+    }
+    entries_.push_front(Entry{key, value, bytes});
+    bytes_ += bytes;
+  }
+
+  // Evicts tables until at least the given number of bytes is freed or the cache is
+  // empty, returns the number of bytes freed.
+  size_t evict(const size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto bytes_before = bytes_;
+    while (!entries_.empty() && bytes_before - bytes_ < bytes) {
+      evictLeastRecentlyUsed();
+    }
+    return bytes_before - bytes_;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    bytes_ = 0;
+  }
+
+  JoinHashTableCacheStats getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {hits_, misses_, evictions_, entries_.size(), bytes_};
+  }
+
+ private:
+  struct Entry {
+    K key;
+    V value;
+    size_t bytes;
+  };
+
+  void evictLeastRecentlyUsed() {
+    CHECK(!entries_.empty());
+    const auto& lru_entry = entries_.back();
+    CHECK_GE(bytes_, lru_entry.bytes);
+    bytes_ -= lru_entry.bytes;
+    entries_.pop_back();
+    ++evictions_;
+  }
+
+  const size_t& max_bytes_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  size_t bytes_;
+  size_t hits_;
+  size_t misses_;
+  size_t evictions_;
+  mutable std::mutex mutex_;
+};
+
+#endif  // QUERYENGINE_JOINHASHTABLECACHE_H
@@ -47,6 +47,10 @@ class FailedToJoinOnVirtualColumn : public HashJoinFail {
   FailedToJoinOnVirtualColumn() : HashJoinFail("Cannot join on rowid") {}
 };
 
+namespace Fragmenter_Namespace {
+class FragmentInfo;
+}  // namespace Fragmenter_Namespace
+
 struct HashJoinMatchingSet {
   llvm::Value* elements;
   llvm::Value* count;
@@ -75,6 +79,13 @@ class JoinHashTableInterface {
   };
 
   virtual HashType getHashType() const noexcept = 0;
+
+  // Whether none of the join keys of the given fragment of the outer table can be in
+  // the table, according to the metadata of the chunks on both sides.
+  virtual bool skipOuterFragment(
+      const Fragmenter_Namespace::FragmentInfo& outer_fragment) const {
+    return false;
+  }
 };
 
 #endif  // QUERYENGINE_JOINHASHTABLEINTERFACE_H
@@ -16,6 +16,7 @@
 
 #include "CompareKeysInl.h"
 #include "MurmurHash.h"
+#include "SpatialJoinRuntime.h"
 
 DEVICE bool compare_to_key(const int8_t* entry,
                            const int8_t* key,
@@ -129,3 +130,27 @@ get_composite_key_index_64(const int64_t* key,
   return get_composite_key_index_impl(
       key, key_component_count, composite_key_dict, entry_count);
 }
+
+// The cell of the grid of a spatial join hash table which holds the point, -1 if the
+// point is outside of the grid.
+extern "C" NEVER_INLINE DEVICE int64_t spatial_join_grid_cell(const int8_t* coords,
+                                                              const int32_t ic,
+                                                              const double min_x,
+                                                              const double min_y,
+                                                              const double max_x,
+                                                              const double max_y,
+                                                              const double cell_width,
+                                                              const double cell_height,
+                                                              const int64_t cells_x,
+                                                              const int64_t cells_y) {
+  if (!coords) {
+    return -1;
+  }
+  const auto x = spatial_join_decompress_coord(coords, 0, ic, true);
+  const auto y = spatial_join_decompress_coord(coords, 1, ic, false);
+  if (!(x >= min_x && x <= max_x && y >= min_y && y <= max_y)) {
+    return -1;
+  }
+  return spatial_join_cell_idx(y, min_y, cell_height, cells_y) * cells_x +
+         spatial_join_cell_idx(x, min_x, cell_width, cells_x);
+}
@@ -582,9 +582,7 @@ std::shared_ptr<ResultSet> Executor::execute(
   // capture the lock acquistion time
   auto clock_begin = timer_start();
   std::lock_guard<std::mutex> lock(execute_mutex_);
-  if (g_enable_dynamic_watchdog) {
-    resetInterrupt();
-  }
+  resetInterrupt();
   ScopeGuard restore_metainfo_cache = [this] { clearMetaInfoCache(); };
   int64_t queue_time_ms = timer_stop(clock_begin);
   ScopeGuard row_set_holder = [this] { row_set_mem_owner_ = nullptr; };
@@ -51,6 +51,9 @@ bool contains_unsafe_division(const Analyzer::Expr* expr) {
 }
 
 bool should_defer_eval(const std::shared_ptr<Analyzer::Expr> expr) {
+  if (auto likelihood_expr = std::dynamic_pointer_cast<Analyzer::LikelihoodExpr>(expr)) {
+    return should_defer_eval(likelihood_expr->get_own_arg());
+  }
   if (std::dynamic_pointer_cast<Analyzer::LikeExpr>(expr)) {
     return true;
   }
@@ -109,6 +112,10 @@ Likelihood get_likelihood(const Analyzer::Expr* expr) {
 }
 
 Weight get_weight(const Analyzer::Expr* expr, int depth = 0) {
+  auto likelihood_expr = dynamic_cast<const Analyzer::LikelihoodExpr*>(expr);
+  if (likelihood_expr) {
+    return get_weight(likelihood_expr->get_arg(), depth);
+  }
   auto like_expr = dynamic_cast<const Analyzer::LikeExpr*>(expr);
   if (like_expr) {
     // heavy weight expr, start valid weight propagation
@@ -172,6 +179,28 @@ void sort_eq_joins_by_rte_indices(std::vector<Analyzer::Expr*>& join_conditions)
   std::sort(join_conditions.begin(), join_conditions.end(), cmp);
 }
 
+// Orders the quals by their cost per rejected row once all of them have a likelihood,
+// sampled by the executor or given in the query. The heavy weight ones count as costly.
+void order_quals_by_rank(std::vector<std::shared_ptr<Analyzer::Expr>>& quals) {
+  for (const auto& qual : quals) {
+    if (get_likelihood(qual.get()).isInvalid()) {
+      return;
+    }
+  }
+  const auto rank = [](const std::shared_ptr<Analyzer::Expr>& qual) {
+    const auto weight = get_weight(qual.get());
+    const double cost = weight.isValid() ? weight.getValue() : 1.0;
+    const double likelihood = get_likelihood(qual.get()).getValue();
+    return cost / std::max(1.0 - likelihood, 1e-3);
+  };
+  std::stable_sort(quals.begin(),
+                   quals.end(),
+                   [&rank](const std::shared_ptr<Analyzer::Expr>& lhs,
+                           const std::shared_ptr<Analyzer::Expr>& rhs) {
+                     return rank(lhs) < rank(rhs);
+                   });
+}
+
 }  // namespace
 
 bool Executor::prioritizeQuals(const RelAlgExecutionUnit& ra_exe_unit,
@@ -205,9 +234,15 @@ bool Executor::prioritizeQuals(const RelAlgExecutionUnit& ra_exe_unit,
     primary_quals.push_back(expr.get());
   }
 
+  std::vector<std::shared_ptr<Analyzer::Expr>> quals(ra_exe_unit.quals.begin(),
+                                                     ra_exe_unit.quals.end());
+  if (g_enable_adaptive_filter_ordering) {
+    order_quals_by_rank(quals);
+  }
+
   bool short_circuit = false;
 
-  for (auto expr : ra_exe_unit.quals) {
+  for (auto expr : quals) {
     if (get_likelihood(expr.get()) < 0.10 && !contains_unsafe_division(expr.get())) {
       if (!short_circuit) {
         primary_quals.push_back(expr.get());
@@ -174,6 +174,24 @@ llvm::BasicBlock* JoinLoop::codegen(
             break;
           }
           case JoinType::LEFT: {
+            if (join_loop.outer_condition_match_) {
+              // The rest of the outer condition is only evaluated on a valid slot.
+              const auto eval_outer_cond_bb = llvm::BasicBlock::Create(
+                  context, "singleton_eval_outer_cond_" + join_loop.name_, parent_func);
+              const auto after_outer_cond_bb = llvm::BasicBlock::Create(
+                  context, "singleton_after_outer_cond_" + join_loop.name_, parent_func);
+              builder.CreateCondBr(match_found, eval_outer_cond_bb, after_outer_cond_bb);
+              builder.SetInsertPoint(eval_outer_cond_bb);
+              const auto outer_cond_match = join_loop.outer_condition_match_(iterators);
+              const auto outer_cond_match_bb = builder.GetInsertBlock();
+              builder.CreateBr(after_outer_cond_bb);
+              builder.SetInsertPoint(after_outer_cond_bb);
+              auto match_and_outer_cond = builder.CreatePHI(get_int_type(1, context), 2);
+              match_and_outer_cond->addIncoming(ll_bool(false, context), match_found_bb);
+              match_and_outer_cond->addIncoming(outer_cond_match, outer_cond_match_bb);
+              match_found = match_and_outer_cond;
+              match_found_bb = after_outer_cond_bb;
+            }
             join_loop.found_outer_matches_(match_found);
             // For outer joins, do the iteration regardless of the result of the match.
             prev_comparison_result = ll_bool(true, context);
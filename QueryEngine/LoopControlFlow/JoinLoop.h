@@ -87,7 +87,7 @@ class JoinLoop {
   const std::function<JoinLoopDomain(const std::vector<llvm::Value*>&)>
       iteration_domain_codegen_;
   // Callback provided from the executor which generates true iff the outer condition
-  // evaluates to true.
+  // evaluates to true. For hash joins, only the part not covered by the hash table.
   const std::function<llvm::Value*(const std::vector<llvm::Value*>&)>
       outer_condition_match_;
   // Callback provided from the executor which receives the IR boolean value which tracks
@@ -17,8 +17,12 @@
 #include "Execute.h"
 #include "ExtensionFunctionsWhitelist.h"
 #include "LLVMFunctionAttributesUtil.h"
+#include "MurmurHash.h"
+#include "PersistentCodeCache.h"
 #include "QueryTemplateGenerator.h"
 
+#include "Shared/Metrics.h"
+#include "Shared/ThreadPool.h"
 #include "Shared/mapdpath.h"
 
 #if LLVM_VERSION_MAJOR >= 4
@@ -27,7 +31,10 @@
 #else
 #include <llvm/Bitcode/ReaderWriter.h>
 #endif
+#include <llvm/Config/llvm-config.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #include <llvm/IR/Attributes.h>
 #include <llvm/IR/GlobalValue.h>
 #include <llvm/IR/InstIterator.h>
@@ -36,6 +43,7 @@
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/FormattedStream.h>
+#include <llvm/Support/Host.h>
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/TargetRegistry.h>
@@ -132,6 +140,32 @@ void optimize_ir(llvm::Function* query_func,
 }
 #endif
 
+#ifndef WITH_JIT_DEBUG
+// Only inlines and drops the unused runtime functions, for queries which don't run
+// long enough to pay for the full pipeline.
+void optimize_ir_quick(llvm::Module* module,
+                       std::unordered_set<llvm::Function*>& live_funcs) {
+  llvm::legacy::PassManager pass_manager;
+#if LLVM_VERSION_MAJOR < 4
+  pass_manager.add(llvm::createAlwaysInlinerPass());
+#else
+  pass_manager.add(llvm::createAlwaysInlinerLegacyPass());
+#endif
+  pass_manager.add(llvm::createGlobalDCEPass());
+  pass_manager.run(*module);
+
+  eliminate_dead_self_recursive_funcs(*module, live_funcs);
+}
+#endif  // WITH_JIT_DEBUG
+
+uint64_t hash_code_cache_key(const std::vector<std::string>& key) {
+  uint64_t hash{0};
+  for (const auto& ir : key) {
+    hash = MurmurHash64A(ir.data(), static_cast<int>(ir.size()), hash);
+  }
+  return hash;
+}
+
 template <class T>
 std::string serialize_llvm_object(const T* llvm_obj) {
   std::stringstream ss;
@@ -141,17 +175,170 @@ std::string serialize_llvm_object(const T* llvm_obj) {
   return ss.str();
 }
 
+#if LLVM_VERSION_MAJOR >= 4 && !defined(WITH_JIT_DEBUG)
+#define HAVE_PERSISTENT_CPU_CODE_CACHE
+
+std::string cpu_code_cache_target(const CompilationOptions& co) {
+  return std::string("cpu-") + LLVM_VERSION_STRING + "-" +
+         llvm::sys::getHostCPUName().str() + "-" +
+         std::to_string(static_cast<int>(co.opt_level_));
+}
+
+// Hands the object code found in the persistent cache to MCJIT instead of generating
+// it, and persists the object code MCJIT generates otherwise.
+class PersistentObjectCache : public llvm::ObjectCache {
+ public:
+  PersistentObjectCache(const std::vector<std::string>& key,
+                        const std::string& target,
+                        const std::string& cached_object)
+      : key_(key), target_(target), cached_object_(cached_object) {}
+
+  void notifyObjectCompiled(const llvm::Module*, llvm::MemoryBufferRef obj) override {
+    PersistentCodeCache::instance().put(
+        key_, target_, obj.getBufferStart(), obj.getBufferSize());
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module*) override {
+    if (cached_object_.empty()) {
+      return nullptr;
+    }
+    return llvm::MemoryBuffer::getMemBufferCopy(cached_object_);
+  }
+
+ private:
+  const std::vector<std::string>& key_;
+  const std::string target_;
+  const std::string& cached_object_;
+};
+#endif  // LLVM_VERSION_MAJOR >= 4 && !defined(WITH_JIT_DEBUG)
+
+// Counts the bytes of the code and data sections MCJIT allocates for a kernel.
+class CountingMemoryManager : public llvm::SectionMemoryManager {
+ public:
+  uint8_t* allocateCodeSection(uintptr_t size,
+                               unsigned alignment,
+                               unsigned section_id,
+                               llvm::StringRef section_name) override {
+    allocated_bytes_ += size;
+    return llvm::SectionMemoryManager::allocateCodeSection(
+        size, alignment, section_id, section_name);
+  }
+
+  uint8_t* allocateDataSection(uintptr_t size,
+                               unsigned alignment,
+                               unsigned section_id,
+                               llvm::StringRef section_name,
+                               bool is_read_only) override {
+    allocated_bytes_ += size;
+    return llvm::SectionMemoryManager::allocateDataSection(
+        size, alignment, section_id, section_name, is_read_only);
+  }
+
+  size_t allocatedBytes() const { return allocated_bytes_; }
+
+ private:
+  size_t allocated_bytes_{0};
+};
+
+#ifdef HAVE_CUDA
+// The devices by compute capability, a cubin is linked once for all the devices of one.
+std::map<std::string, std::vector<int>> devices_per_arch(
+    const CudaMgr_Namespace::CudaMgr* cuda_mgr) {
+  std::map<std::string, std::vector<int>> device_ids;
+  for (int device_id = 0; device_id < cuda_mgr->getDeviceCount(); ++device_id) {
+    const auto& device_props = cuda_mgr->deviceProperties[device_id];
+    device_ids[std::to_string(device_props.computeMajor) +
+               std::to_string(device_props.computeMinor)]
+        .push_back(device_id);
+  }
+  return device_ids;
+}
+
+// Loads the cubin on the devices, into gpu_contexts by device id. The loads are
+// independent of each other, so do them concurrently when there are several devices.
+void load_on_devices(const void* cubin,
+                     const std::string& func_name,
+                     const CudaMgr_Namespace::CudaMgr* cuda_mgr,
+                     const std::vector<int>& device_ids,
+                     const unsigned num_options,
+                     CUjit_option* option_keys,
+                     void** option_values,
+                     std::vector<GpuCompilationContext*>& gpu_contexts) {
+  auto load_on_device = [&](const int device_id) {
+    gpu_contexts[device_id] = new GpuCompilationContext(
+        cubin, func_name, device_id, cuda_mgr, num_options, option_keys, option_values);
+  };
+  if (device_ids.size() == 1) {
+    load_on_device(device_ids.front());
+    return;
+  }
+  std::vector<std::future<void>> loads;
+  for (const auto device_id : device_ids) {
+    loads.push_back(threadpool::ThreadPool::instance().submit(load_on_device, device_id));
+  }
+  threadpool::wait_all(loads);
+}
+#endif  // HAVE_CUDA
+
 }  // namespace
 
-std::vector<std::pair<void*, void*>> Executor::getCodeFromCache(
-    const CodeCacheKey& key,
-    const std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>>& cache) {
-  auto it = cache.find(key);
-  if (it != cache.end()) {
+namespace {
+
+struct CodeCacheMetrics {
+  metrics::Counter& hits;
+  metrics::Counter& misses;
+  metrics::Counter& evictions;
+  metrics::Gauge& kernels;
+  metrics::Gauge& bytes;
+};
+
+CodeCacheMetrics& code_cache_metrics(const bool is_cpu_cache) {
+  auto& registry = metrics::Registry::get();
+  const auto make_metrics = [&registry](const std::string& labels) {
+    return CodeCacheMetrics{
+        registry.counter(
+            "mapd_code_cache_hits_total", "Kernels found in the code cache", labels),
+        registry.counter("mapd_code_cache_misses_total",
+                         "Kernels not found in the code cache",
+                         labels),
+        registry.counter("mapd_code_cache_evictions_total",
+                         "Least recently used kernels evicted from the code cache",
+                         labels),
+        registry.gauge("mapd_code_cache_kernels", "Kernels in the code caches", labels),
+        registry.gauge("mapd_code_cache_bytes",
+                       "Estimated size of the native code and keys of the code caches",
+                       labels)};
+  };
+  static auto cpu_metrics = make_metrics("device=\"cpu\"");
+  static auto gpu_metrics = make_metrics("device=\"gpu\"");
+  return is_cpu_cache ? cpu_metrics : gpu_metrics;
+}
+
+size_t code_cache_key_bytes(const std::vector<std::string>& key) {
+  size_t bytes{0};
+  for (const auto& ir : key) {
+    bytes += ir.size();
+  }
+  return bytes;
+}
+
+}  // namespace
+
+std::vector<std::pair<void*, void*>> Executor::getCodeFromCache(const CodeCacheKey& key,
+                                                                CodeCache& cache) {
+  auto& cache_metrics = code_cache_metrics(&cache == &cpu_code_cache_);
+  auto it = cache.entries.find(key);
+  (it != cache.entries.end() ? cache_metrics.hits : cache_metrics.misses).inc();
+  if (query_profile_) {
+    query_profile_->addCodeCacheLookup(it != cache.entries.end());
+  }
+  if (it != cache.entries.end()) {
+    auto& entry = it->second;
+    cache.lru.splice(cache.lru.begin(), cache.lru, entry.lru_pos);
     delete cgen_state_->module_;
-    cgen_state_->module_ = it->second.second;
+    cgen_state_->module_ = entry.module;
     std::vector<std::pair<void*, void*>> native_functions;
-    for (auto& native_code : it->second.first) {
+    for (auto& native_code : entry.val) {
       GpuCompilationContext* gpu_context = std::get<2>(native_code).get();
       native_functions.emplace_back(std::get<0>(native_code),
                                     gpu_context ? gpu_context->module() : nullptr);
@@ -161,12 +348,14 @@ std::vector<std::pair<void*, void*>> Executor::getCodeFromCache(
   return {};
 }
 
+// The caller holds the execute mutex, so no query runs the code of an evicted kernel.
 void Executor::addCodeToCache(
     const CodeCacheKey& key,
     const std::vector<std::tuple<void*, llvm::ExecutionEngine*, GpuCompilationContext*>>&
         native_code,
     llvm::Module* module,
-    std::map<CodeCacheKey, std::pair<CodeCacheVal, llvm::Module*>>& cache) {
+    const size_t code_bytes,
+    CodeCache& cache) {
   CHECK(!native_code.empty());
   CodeCacheVal cache_val;
   for (const auto& native_func : native_code) {
@@ -175,9 +364,42 @@ void Executor::addCodeToCache(
         std::unique_ptr<llvm::ExecutionEngine>(std::get<1>(native_func)),
         std::unique_ptr<GpuCompilationContext>(std::get<2>(native_func)));
   }
-  auto it_ok =
-      cache.insert(std::make_pair(key, std::make_pair(std::move(cache_val), module)));
+  const auto bytes = code_bytes + code_cache_key_bytes(key);
+  auto it_ok = cache.entries.insert(
+      std::make_pair(key, CodeCache::Entry{std::move(cache_val), module, bytes, {}}));
   CHECK(it_ok.second);
+  cache.lru.push_front(&it_ok.first->first);
+  it_ok.first->second.lru_pos = cache.lru.begin();
+  cache.bytes += bytes;
+  auto& cache_metrics = code_cache_metrics(&cache == &cpu_code_cache_);
+  cache_metrics.kernels.add(1);
+  cache_metrics.bytes.add(bytes);
+  // the kernel just added is about to run, it's never evicted
+  while (g_code_cache_max_bytes && cache.bytes > g_code_cache_max_bytes &&
+         cache.lru.size() > 1) {
+    const auto lru_key = cache.lru.back();
+    eraseCodeFromCache(*lru_key, cache);
+    cache_metrics.evictions.inc();
+  }
+}
+
+void Executor::eraseCodeFromCache(const CodeCacheKey& key, CodeCache& cache) {
+  auto it = cache.entries.find(key);
+  if (it == cache.entries.end()) {
+    return;
+  }
+  auto& entry = it->second;
+  // an execution engine owns its module, the GPU kernels leave it to the cache
+  const bool owns_module = !std::get<1>(entry.val.front());
+  if (owns_module && entry.module != cgen_state_->module_) {
+    delete entry.module;
+  }
+  auto& cache_metrics = code_cache_metrics(&cache == &cpu_code_cache_);
+  cache_metrics.kernels.add(-1);
+  cache_metrics.bytes.add(-static_cast<int64_t>(entry.bytes));
+  cache.bytes -= entry.bytes;
+  cache.lru.erase(entry.lru_pos);
+  cache.entries.erase(it);
 }
 
 std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenCPU(
@@ -185,7 +407,8 @@ std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenCPU(
     llvm::Function* multifrag_query_func,
     std::unordered_set<llvm::Function*>& live_funcs,
     llvm::Module* module,
-    const CompilationOptions& co) {
+    const CompilationOptions& co,
+    const bool quick_compile) {
   CodeCacheKey key{serialize_llvm_object(query_func),
                    serialize_llvm_object(cgen_state_->row_func_)};
   for (const auto helper : cgen_state_->helper_functions_) {
@@ -196,9 +419,49 @@ std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenCPU(
     return cached_code;
   }
 
+#ifdef HAVE_PERSISTENT_CPU_CODE_CACHE
+  const auto persistent_cache_target = cpu_code_cache_target(co);
+  std::string persisted_object;
+  PersistentCodeCache::instance().get(key, persistent_cache_target, persisted_object);
+#endif  // HAVE_PERSISTENT_CPU_CODE_CACHE
+
+  // Quickly compiled code is cached under its own key, until the query has been seen
+  // often enough to be worth the full optimization pipeline.
+  CodeCacheKey quick_key;
+  bool use_quick_code{false};
+  if (quick_compile) {
+    quick_key = key;
+    quick_key.emplace_back("quick");
+    const auto key_hash = hash_code_cache_key(key);
+    use_quick_code = ++quick_code_uses_[key_hash] < g_tiered_codegen_promotion_count;
+#ifdef HAVE_PERSISTENT_CPU_CODE_CACHE
+    use_quick_code = use_quick_code && persisted_object.empty();
+#endif  // HAVE_PERSISTENT_CPU_CODE_CACHE
+    if (use_quick_code) {
+      cached_code = getCodeFromCache(quick_key, cpu_code_cache_);
+      if (!cached_code.empty()) {
+        return cached_code;
+      }
+    } else {
+      quick_code_uses_.erase(key_hash);
+      eraseCodeFromCache(quick_key, cpu_code_cache_);
+    }
+  }
+
   // run optimizations
 #ifndef WITH_JIT_DEBUG
-  optimize_ir(query_func, module, live_funcs, co, debug_dir_, debug_file_);
+  if (use_quick_code) {
+    optimize_ir_quick(module, live_funcs);
+  } else {
+#ifdef HAVE_PERSISTENT_CPU_CODE_CACHE
+    // The persisted object code was generated from the optimized module.
+    if (persisted_object.empty()) {
+      optimize_ir(query_func, module, live_funcs, co, debug_dir_, debug_file_);
+    }
+#else
+    optimize_ir(query_func, module, live_funcs, co, debug_dir_, debug_file_);
+#endif  // HAVE_PERSISTENT_CPU_CODE_CACHE
+  }
 #endif  // WITH_JIT_DEBUG
 
   llvm::ExecutionEngine* execution_engine{nullptr};
@@ -217,22 +480,44 @@ std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenCPU(
 #else
   std::unique_ptr<llvm::Module> owner(module);
   llvm::EngineBuilder eb(std::move(owner));
+#endif
+  // owned by the execution engine
+  auto memory_manager = new CountingMemoryManager();
+#if LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR == 5
+  eb.setMCJITMemoryManager(memory_manager);
+#else
+  eb.setMCJITMemoryManager(std::unique_ptr<llvm::RTDyldMemoryManager>(memory_manager));
 #endif
   eb.setErrorStr(&err_str);
   eb.setEngineKind(llvm::EngineKind::JIT);
   llvm::TargetOptions to;
   to.EnableFastISel = true;
   eb.setTargetOptions(to);
+  if (use_quick_code) {
+    eb.setOptLevel(llvm::CodeGenOpt::None);
+  }
   execution_engine = eb.create();
   CHECK(execution_engine);
 
+#ifdef HAVE_PERSISTENT_CPU_CODE_CACHE
+  std::unique_ptr<PersistentObjectCache> object_cache;
+  if (PersistentCodeCache::instance().isEnabled() && !use_quick_code) {
+    object_cache.reset(
+        new PersistentObjectCache(key, persistent_cache_target, persisted_object));
+    execution_engine->setObjectCache(object_cache.get());
+  }
+#endif  // HAVE_PERSISTENT_CPU_CODE_CACHE
   execution_engine->finalizeObject();
+#ifdef HAVE_PERSISTENT_CPU_CODE_CACHE
+  execution_engine->setObjectCache(nullptr);
+#endif  // HAVE_PERSISTENT_CPU_CODE_CACHE
   auto native_code = execution_engine->getPointerToFunction(multifrag_query_func);
 
   CHECK(native_code);
-  addCodeToCache(key,
+  addCodeToCache(use_quick_code ? quick_key : key,
                  {{std::make_tuple(native_code, execution_engine, nullptr)}},
                  module,
+                 memory_manager->allocatedBytes(),
                  cpu_code_cache_);
 
   return {std::make_pair(native_code, nullptr)};
@@ -308,6 +593,7 @@ declare void @write_back_nop(i64*, i64*, i32);
 declare void @agg_from_smem_to_gmem_nop(i64*, i64*, i32);
 declare void @agg_from_smem_to_gmem_binId_count(i64*, i64*, i32);
 declare void @agg_from_smem_to_gmem_count_binId(i64*, i64*, i32);
+declare void @agg_from_smem_to_gmem_slots(i64*, i64*, i32, i32, i32, i64);
 declare void @init_group_by_buffer_gpu(i64*, i64*, i32, i32, i32, i1, i8);
 declare i64* @get_group_value(i64*, i32, i64*, i32, i32, i32, i64*);
 declare i64* @get_group_value_with_watchdog(i64*, i32, i64*, i32, i32, i32, i64*);
@@ -320,6 +606,7 @@ declare i64 @baseline_hash_join_idx_32(i8*, i8*, i64, i64);
 declare i64 @baseline_hash_join_idx_64(i8*, i8*, i64, i64);
 declare i64 @get_composite_key_index_32(i32*, i64, i32*, i64);
 declare i64 @get_composite_key_index_64(i64*, i64, i64*, i64);
+declare i64 @spatial_join_grid_cell(i8*, i32, double, double, double, double, double, double, i64, i64);
 declare i64 @agg_count_shared(i64*, i64);
 declare i64 @agg_count_skip_val_shared(i64*, i64, i64);
 declare i32 @agg_count_int32_shared(i32*, i32);
@@ -399,6 +686,10 @@ declare i1 @string_like_simple(i8*, i32, i8*, i32);
 declare i1 @string_ilike_simple(i8*, i32, i8*, i32);
 declare i8 @string_like_simple_nullable(i8*, i32, i8*, i32, i8);
 declare i8 @string_ilike_simple_nullable(i8*, i32, i8*, i32, i8);
+declare i1 @string_like_compiled(i8*, i32, i8*, i32);
+declare i1 @string_ilike_compiled(i8*, i32, i8*, i32);
+declare i8 @string_like_compiled_nullable(i8*, i32, i8*, i32, i8);
+declare i8 @string_ilike_compiled_nullable(i8*, i32, i8*, i32, i8);
 declare i1 @string_lt(i8*, i32, i8*, i32);
 declare i1 @string_le(i8*, i32, i8*, i32);
 declare i1 @string_gt(i8*, i32, i8*, i32);
@@ -417,6 +708,7 @@ declare void @linear_probabilistic_count(i8*, i32, i8*, i32);
 declare void @agg_count_distinct_bitmap_gpu(i64*, i64, i64, i64, i64, i64, i64);
 declare void @agg_count_distinct_bitmap_skip_val_gpu(i64*, i64, i64, i64, i64, i64, i64, i64);
 declare void @agg_approximate_count_distinct_gpu(i64*, i64, i32, i64, i64);
+declare void @agg_approx_quantile_gpu(i64*, double, double, i64, i64);
 declare i32 @record_error_code(i32, i32*);
 declare i1 @dynamic_watchdog();
 declare void @force_sync();
@@ -482,6 +774,54 @@ std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenGPU(
     return cached_code;
   }
 
+  const auto func_name = multifrag_query_func->getName().str();
+  const auto arch_device_ids = devices_per_arch(cuda_mgr);
+  auto persistent_cache_target = [this](const std::string& arch) {
+    return std::string("gpu-") + LLVM_VERSION_STRING + "-sm_" + arch + "-" +
+           std::to_string(blockSize());
+  };
+  std::map<std::string, std::string> persisted_cubins;
+  for (const auto& arch_and_devices : arch_device_ids) {
+    std::string persisted_cubin;
+    if (PersistentCodeCache::instance().get(
+            key, persistent_cache_target(arch_and_devices.first), persisted_cubin)) {
+      persisted_cubins.emplace(arch_and_devices.first, std::move(persisted_cubin));
+    }
+  }
+  std::vector<GpuCompilationContext*> gpu_contexts(cuda_mgr->getDeviceCount(), nullptr);
+  size_t code_bytes{0};
+  auto gpu_contexts_to_cache = [&]() {
+    std::vector<std::pair<void*, void*>> native_functions;
+    std::vector<std::tuple<void*, llvm::ExecutionEngine*, GpuCompilationContext*>>
+        cached_functions;
+    for (auto gpu_context : gpu_contexts) {
+      CHECK(gpu_context);
+      auto native_code = gpu_context->kernel();
+      auto native_module = gpu_context->module();
+      CHECK(native_code);
+      CHECK(native_module);
+      native_functions.emplace_back(native_code, native_module);
+      cached_functions.emplace_back(native_code, nullptr, gpu_context);
+    }
+    addCodeToCache(key, cached_functions, module, code_bytes, gpu_code_cache_);
+    return native_functions;
+  };
+  for (const auto& arch_and_cubin : persisted_cubins) {
+    const auto& device_ids = arch_device_ids.at(arch_and_cubin.first);
+    load_on_devices(arch_and_cubin.second.data(),
+                    func_name,
+                    cuda_mgr,
+                    device_ids,
+                    0,
+                    nullptr,
+                    nullptr,
+                    gpu_contexts);
+    code_bytes += arch_and_cubin.second.size() * device_ids.size();
+  }
+  if (persisted_cubins.size() == arch_device_ids.size()) {
+    return gpu_contexts_to_cache();
+  }
+
   bool row_func_not_inlined = false;
   if (no_inline) {
     for (auto it = llvm::inst_begin(cgen_state_->row_func_),
@@ -562,40 +902,34 @@ std::vector<std::pair<void*, void*>> Executor::optimizeAndCodegenGPU(
 
   auto cuda_llir = cuda_rt_decls + extension_function_decls() + ss.str();
 
-  std::vector<std::pair<void*, void*>> native_functions;
-  std::vector<std::tuple<void*, llvm::ExecutionEngine*, GpuCompilationContext*>>
-      cached_functions;
-
   const auto ptx = generatePTX(cuda_llir);
 
-  auto cubin_result = ptx_to_cubin(ptx, blockSize(), cuda_mgr);
-  auto& option_keys = cubin_result.option_keys;
-  auto& option_values = cubin_result.option_values;
-  auto cubin = cubin_result.cubin;
-  auto link_state = cubin_result.link_state;
-  const auto num_options = option_keys.size();
-
-  auto func_name = multifrag_query_func->getName().str();
-  for (int device_id = 0; device_id < cuda_mgr->getDeviceCount(); ++device_id) {
-    auto gpu_context = new GpuCompilationContext(cubin,
-                                                 func_name,
-                                                 device_id,
-                                                 cuda_mgr,
-                                                 num_options,
-                                                 &option_keys[0],
-                                                 &option_values[0]);
-    auto native_code = gpu_context->kernel();
-    auto native_module = gpu_context->module();
-    CHECK(native_code);
-    CHECK(native_module);
-    native_functions.emplace_back(native_code, native_module);
-    cached_functions.emplace_back(native_code, nullptr, gpu_context);
-  }
-  addCodeToCache(key, cached_functions, module, gpu_code_cache_);
-
-  checkCudaErrors(cuLinkDestroy(link_state));
-
-  return native_functions;
+  // The PTX doesn't depend on the device, the cubin does on its compute capability.
+  for (const auto& arch_and_devices : arch_device_ids) {
+    if (persisted_cubins.count(arch_and_devices.first)) {
+      continue;
+    }
+    const auto& device_ids = arch_and_devices.second;
+    auto cubin_result = ptx_to_cubin(ptx, blockSize(), cuda_mgr, device_ids.front());
+    auto& option_keys = cubin_result.option_keys;
+    auto& option_values = cubin_result.option_values;
+    PersistentCodeCache::instance().put(key,
+                                        persistent_cache_target(arch_and_devices.first),
+                                        cubin_result.cubin,
+                                        cubin_result.cubin_size);
+    load_on_devices(cubin_result.cubin,
+                    func_name,
+                    cuda_mgr,
+                    device_ids,
+                    option_keys.size(),
+                    &option_keys[0],
+                    &option_values[0],
+                    gpu_contexts);
+    code_bytes += cubin_result.cubin_size * device_ids.size();
+    checkCudaErrors(cuLinkDestroy(cubin_result.link_state));
+  }
+
+  return gpu_contexts_to_cache();
 #else
   return {};
 #endif
@@ -653,20 +987,22 @@ std::string Executor::generatePTX(const std::string& cuda_llir) const {
 #endif
 }
 
+std::unique_ptr<llvm::TargetMachine> Executor::nvptx_target_machine_;
+std::once_flag Executor::nvptx_backend_init_flag_;
+
 void Executor::initializeNVPTXBackend() const {
-  if (nvptx_target_machine_) {
-    return;
-  }
-  llvm::InitializeAllTargets();
-  llvm::InitializeAllTargetMCs();
-  llvm::InitializeAllAsmPrinters();
-  std::string err;
-  auto target = llvm::TargetRegistry::lookupTarget("nvptx64", err);
-  if (!target) {
-    LOG(FATAL) << err;
-  }
-  nvptx_target_machine_.reset(target->createTargetMachine(
-      "nvptx64-nvidia-cuda", "sm_30", "", llvm::TargetOptions(), llvm::Reloc::Static));
+  std::call_once(nvptx_backend_init_flag_, [] {
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    std::string err;
+    auto target = llvm::TargetRegistry::lookupTarget("nvptx64", err);
+    if (!target) {
+      LOG(FATAL) << err;
+    }
+    nvptx_target_machine_.reset(target->createTargetMachine(
+        "nvptx64-nvidia-cuda", "sm_30", "", llvm::TargetOptions(), llvm::Reloc::Static));
+  });
 }
 
 namespace {
@@ -741,7 +1077,8 @@ std::vector<llvm::Value*> generate_column_heads_load(const int num_columns,
 void set_row_func_argnames(llvm::Function* row_func,
                            const size_t in_col_count,
                            const size_t agg_col_count,
-                           const bool hoist_literals) {
+                           const bool hoist_literals,
+                           const bool batched_filter) {
   auto arg_it = row_func->arg_begin();
 
   if (agg_col_count) {
@@ -774,6 +1111,11 @@ void set_row_func_argnames(llvm::Function* row_func,
   arg_it->setName("num_rows_per_scan");
   ++arg_it;
 
+  if (batched_filter) {
+    arg_it->setName("filter_only");
+    ++arg_it;
+  }
+
   if (hoist_literals) {
     arg_it->setName("literals");
     ++arg_it;
@@ -791,6 +1133,7 @@ std::pair<llvm::Function*, std::vector<llvm::Value*>> create_row_function(
     const size_t in_col_count,
     const size_t agg_col_count,
     const bool hoist_literals,
+    const bool batched_filter,
     llvm::Function* query_func,
     llvm::Module* module,
     llvm::LLVMContext& context) {
@@ -826,6 +1169,11 @@ std::pair<llvm::Function*, std::vector<llvm::Value*>> create_row_function(
   // number of rows for each scan
   row_process_arg_types.push_back(llvm::Type::getInt64PtrTy(context));
 
+  // only evaluate the filter, for the batched query template
+  if (batched_filter) {
+    row_process_arg_types.push_back(llvm::Type::getInt32Ty(context));
+  }
+
   // literals buffer argument
   if (hoist_literals) {
     row_process_arg_types.push_back(llvm::Type::getInt8PtrTy(context));
@@ -852,7 +1200,8 @@ std::pair<llvm::Function*, std::vector<llvm::Value*>> create_row_function(
       llvm::Function::Create(ft, llvm::Function::ExternalLinkage, "row_func", module);
 
   // set the row function argument names; for debugging purposes only
-  set_row_func_argnames(row_func, in_col_count, agg_col_count, hoist_literals);
+  set_row_func_argnames(
+      row_func, in_col_count, agg_col_count, hoist_literals, batched_filter);
 
   return std::make_pair(row_func, col_heads);
 }
@@ -973,8 +1322,13 @@ std::vector<std::string> get_agg_fnames(const std::vector<Analyzer::Expr*>& targ
         break;
       }
       case kAPPROX_COUNT_DISTINCT:
+      case kAPPROX_COUNT_DISTINCT_SKETCH:
+      case kAPPROX_COUNT_DISTINCT_UNION:
         result.emplace_back("agg_approximate_count_distinct");
         break;
+      case kAPPROX_QUANTILE:
+        result.emplace_back("agg_approx_quantile");
+        break;
       default:
         CHECK(false);
     }
@@ -1039,6 +1393,10 @@ void Executor::createErrorCheckControlFlow(llvm::Function* query_func,
         continue;
       }
       auto& filter_call = llvm::cast<llvm::CallInst>(*inst_it);
+      // The filter loop of the batched template doesn't return error codes.
+      if (filter_call.getName() == "filter_match") {
+        continue;
+      }
       if (std::string(filter_call.getCalledFunction()->getName()) ==
           unique_name("row_process", is_nested_)) {
         auto next_inst_it = inst_it;
@@ -1220,6 +1578,74 @@ bool always_clone_runtime_function(const llvm::Function* func) {
          func->getName() == "record_error_code";
 }
 
+// Small inputs are scanned in less time than the full optimization pipeline takes.
+bool use_quick_cpu_codegen(const std::vector<InputTableInfo>& query_infos) {
+  if (!g_enable_tiered_cpu_codegen) {
+    return false;
+  }
+  size_t total_rows_upper_bound{0};
+  for (const auto& query_info : query_infos) {
+    total_rows_upper_bound += query_info.info.getNumTuplesUpperBound();
+  }
+  return total_rows_upper_bound <= g_tiered_codegen_row_threshold;
+}
+
+// Whether the filter can be evaluated ahead of the aggregates by the batched template:
+// comparisons and logical operators over fixed width numbers, which can't error out.
+bool is_simple_batch_filter(const Analyzer::Expr* expr) {
+  const auto& ti = expr->get_type_info();
+  if (!ti.is_boolean() && !ti.is_integer() && !ti.is_fp() && !ti.is_time()) {
+    return false;
+  }
+  if (dynamic_cast<const Analyzer::ColumnVar*>(expr) ||
+      dynamic_cast<const Analyzer::Constant*>(expr)) {
+    return true;
+  }
+  const auto uoper = dynamic_cast<const Analyzer::UOper*>(expr);
+  if (uoper) {
+    const auto operand = uoper->get_operand();
+    if (uoper->get_optype() == kCAST) {
+      const auto& operand_ti = operand->get_type_info();
+      const bool wider = ti.get_size() >= operand_ti.get_size();
+      const bool widening = (operand_ti.is_integer() && ti.is_integer() && wider) ||
+                            (operand_ti.is_integer() && ti.is_fp()) ||
+                            (operand_ti.is_fp() && ti.is_fp() && wider);
+      return widening && is_simple_batch_filter(operand);
+    }
+    return (uoper->get_optype() == kNOT || uoper->get_optype() == kISNULL) &&
+           is_simple_batch_filter(operand);
+  }
+  const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(expr);
+  if (bin_oper) {
+    const auto optype = bin_oper->get_optype();
+    if (bin_oper->get_qualifier() != kONE ||
+        !(IS_COMPARISON(optype) || optype == kAND || optype == kOR)) {
+      return false;
+    }
+    return is_simple_batch_filter(bin_oper->get_left_operand()) &&
+           is_simple_batch_filter(bin_oper->get_right_operand());
+  }
+  return false;
+}
+
+bool can_batch_filter(const RelAlgExecutionUnit& ra_exe_unit) {
+  if (ra_exe_unit.estimator || ra_exe_unit.input_descs.size() != 1 ||
+      (ra_exe_unit.simple_quals.empty() && ra_exe_unit.quals.empty())) {
+    return false;
+  }
+  for (const auto& qual : ra_exe_unit.simple_quals) {
+    if (!is_simple_batch_filter(qual.get())) {
+      return false;
+    }
+  }
+  for (const auto& qual : ra_exe_unit.quals) {
+    if (!is_simple_batch_filter(qual.get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace
 
 Executor::CompilationResult Executor::compileWorkUnit(
@@ -1269,6 +1695,7 @@ Executor::CompilationResult Executor::compileWorkUnit(
       const auto& count_distinct_descriptor =
           query_mem_desc.getCountDistinctDescriptor(i);
       if (count_distinct_descriptor.impl_type_ == CountDistinctImplType::StdSet ||
+          count_distinct_descriptor.impl_type_ == CountDistinctImplType::Roaring ||
           (count_distinct_descriptor.impl_type_ != CountDistinctImplType::Invalid &&
            !co.hoist_literals_)) {
         throw QueryMustRunOnCpu();
@@ -1318,6 +1745,10 @@ Executor::CompilationResult Executor::compileWorkUnit(
   const auto agg_slot_count = ra_exe_unit.estimator ? size_t(1) : agg_fnames.size();
 
   const bool is_group_by{query_mem_desc.isGroupBy()};
+  const bool batched_filter = g_enable_batched_cpu_codegen &&
+                              co.device_type_ == ExecutorDeviceType::CPU &&
+                              !is_group_by && !eo.with_dynamic_watchdog &&
+                              can_batch_filter(ra_exe_unit);
   auto query_func = is_group_by ? query_group_by_template(cgen_state_->module_,
                                                           is_nested_,
                                                           co.hoist_literals_,
@@ -1328,7 +1759,8 @@ Executor::CompilationResult Executor::compileWorkUnit(
                                                  agg_slot_count,
                                                  is_nested_,
                                                  co.hoist_literals_,
-                                                 !!ra_exe_unit.estimator);
+                                                 !!ra_exe_unit.estimator,
+                                                 batched_filter);
   bind_pos_placeholders("pos_start", true, query_func, cgen_state_->module_);
   bind_pos_placeholders("group_buff_idx", false, query_func, cgen_state_->module_);
   bind_pos_placeholders("pos_step", false, query_func, cgen_state_->module_);
@@ -1342,6 +1774,7 @@ Executor::CompilationResult Executor::compileWorkUnit(
       create_row_function(ra_exe_unit.input_col_descs.size(),
                           is_group_by ? 0 : agg_slot_count,
                           co.hoist_literals_,
+                          batched_filter,
                           query_func,
                           cgen_state_->module_,
                           cgen_state_->context_);
@@ -1368,7 +1801,8 @@ Executor::CompilationResult Executor::compileWorkUnit(
     codegenJoinLoops(
         join_loops, body_execution_unit, group_by_and_aggregate, query_func, bb, co, eo);
   } else {
-    const bool can_return_error = compileBody(ra_exe_unit, group_by_and_aggregate, co);
+    const bool can_return_error =
+        compileBody(ra_exe_unit, group_by_and_aggregate, co, batched_filter);
 
     if (can_return_error || cgen_state_->needs_error_check_ || eo.with_dynamic_watchdog) {
       createErrorCheckControlFlow(query_func, eo.with_dynamic_watchdog);
@@ -1390,7 +1824,9 @@ Executor::CompilationResult Executor::compileWorkUnit(
   }
 
   // iterate through all the instruction in the query template function and
-  // replace the call to the filter placeholder with the call to the actual filter
+  // replace the calls to the filter placeholder with calls to the actual filter; the
+  // batched template has two of them
+  std::vector<llvm::CallInst*> filter_calls;
   for (auto it = llvm::inst_begin(query_func), e = llvm::inst_end(query_func); it != e;
        ++it) {
     if (!llvm::isa<llvm::CallInst>(*it)) {
@@ -1399,24 +1835,27 @@ Executor::CompilationResult Executor::compileWorkUnit(
     auto& filter_call = llvm::cast<llvm::CallInst>(*it);
     if (std::string(filter_call.getCalledFunction()->getName()) ==
         unique_name("row_process", is_nested_)) {
-      std::vector<llvm::Value*> args;
-      for (size_t i = 0; i < filter_call.getNumArgOperands(); ++i) {
-        args.push_back(filter_call.getArgOperand(i));
-      }
-      args.insert(args.end(), col_heads.begin(), col_heads.end());
-      args.push_back(get_arg_by_name(query_func, "join_hash_tables"));
-      // push hoisted literals arguments, if any
-      args.insert(args.end(), hoisted_literals.begin(), hoisted_literals.end());
-
-      llvm::ReplaceInstWithInst(&filter_call,
-                                llvm::CallInst::Create(cgen_state_->row_func_, args, ""));
-      break;
+      filter_calls.push_back(&filter_call);
+    }
+  }
+  CHECK(!filter_calls.empty());
+  for (auto filter_call : filter_calls) {
+    std::vector<llvm::Value*> args;
+    for (size_t i = 0; i < filter_call->getNumArgOperands(); ++i) {
+      args.push_back(filter_call->getArgOperand(i));
     }
+    args.insert(args.end(), col_heads.begin(), col_heads.end());
+    args.push_back(get_arg_by_name(query_func, "join_hash_tables"));
+    // push hoisted literals arguments, if any
+    args.insert(args.end(), hoisted_literals.begin(), hoisted_literals.end());
+
+    llvm::ReplaceInstWithInst(filter_call,
+                              llvm::CallInst::Create(cgen_state_->row_func_, args, ""));
   }
 
   is_nested_ = false;
-  plan_state_->init_agg_vals_ =
-      init_agg_val_vec(ra_exe_unit.target_exprs, ra_exe_unit.quals, query_mem_desc);
+  plan_state_->init_agg_vals_ = init_agg_val_vec(
+      ra_exe_unit.target_exprs, ra_exe_unit.quals, query_infos, this, query_mem_desc);
 
   auto multifrag_query_func = cgen_state_->module_->getFunction(
       "multifrag_query" + std::string(co.hoist_literals_ ? "_hoisted_literals" : ""));
@@ -1439,8 +1878,12 @@ Executor::CompilationResult Executor::compileWorkUnit(
   verify_function_ir(cgen_state_->row_func_);
   return Executor::CompilationResult{
       co.device_type_ == ExecutorDeviceType::CPU
-          ? optimizeAndCodegenCPU(
-                query_func, multifrag_query_func, live_funcs, cgen_state_->module_, co)
+          ? optimizeAndCodegenCPU(query_func,
+                                  multifrag_query_func,
+                                  live_funcs,
+                                  cgen_state_->module_,
+                                  co,
+                                  use_quick_cpu_codegen(query_infos))
           : optimizeAndCodegenGPU(query_func,
                                   multifrag_query_func,
                                   live_funcs,
@@ -1488,11 +1931,19 @@ llvm::BasicBlock* Executor::codegenSkipDeletedOuterTableRow(
 
 bool Executor::compileBody(const RelAlgExecutionUnit& ra_exe_unit,
                            GroupByAndAggregate& group_by_and_aggregate,
-                           const CompilationOptions& co) {
+                           const CompilationOptions& co,
+                           const bool batched_filter) {
   // generate the code for the filter
   std::vector<Analyzer::Expr*> primary_quals;
   std::vector<Analyzer::Expr*> deferred_quals;
   bool short_circuited = prioritizeQuals(ra_exe_unit, primary_quals, deferred_quals);
+  if (batched_filter) {
+    // The batched filter loop evaluates all the quals without branching on them.
+    primary_quals.insert(
+        primary_quals.end(), deferred_quals.begin(), deferred_quals.end());
+    deferred_quals.clear();
+    short_circuited = false;
+  }
   if (short_circuited) {
     VLOG(1) << "Prioritized " << std::to_string(primary_quals.size()) << " quals, "
             << "short-circuited and deferred " << std::to_string(deferred_quals.size())
@@ -1537,6 +1988,26 @@ bool Executor::compileBody(const RelAlgExecutionUnit& ra_exe_unit,
 
   CHECK(filter_lv->getType()->isIntegerTy(1));
 
+  if (batched_filter) {
+    // Called with filter_only set, the row function returns whether the row matches.
+    // Otherwise the row is already known to match and only the aggregates run. Once
+    // inlined in either loop of the template, the other path folds away.
+    auto filter_only_bb = llvm::BasicBlock::Create(
+        cgen_state_->context_, "filter_only", cgen_state_->row_func_);
+    auto filter_passed_bb = llvm::BasicBlock::Create(
+        cgen_state_->context_, "filter_passed", cgen_state_->row_func_);
+    auto filter_only_lv = get_arg_by_name(cgen_state_->row_func_, "filter_only");
+    cgen_state_->ir_builder_.CreateCondBr(
+        cgen_state_->ir_builder_.CreateICmpNE(filter_only_lv, ll_int(int32_t(0))),
+        filter_only_bb,
+        filter_passed_bb);
+    cgen_state_->ir_builder_.SetInsertPoint(filter_only_bb);
+    cgen_state_->ir_builder_.CreateRet(cgen_state_->ir_builder_.CreateZExt(
+        filter_lv, get_int_type(32, cgen_state_->context_)));
+    cgen_state_->ir_builder_.SetInsertPoint(filter_passed_bb);
+    filter_lv = ll_bool(true);
+  }
+
   return group_by_and_aggregate.codegen(
       filter_lv, outerjoin_query_filter_lv, sc_false, co);
 }
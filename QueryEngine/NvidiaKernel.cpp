@@ -37,10 +37,12 @@ void fill_options(std::vector<CUjit_option>& option_keys,
 
 CubinResult ptx_to_cubin(const std::string& ptx,
                          const unsigned block_size,
-                         const CudaMgr_Namespace::CudaMgr* cuda_mgr) {
+                         const CudaMgr_Namespace::CudaMgr* cuda_mgr,
+                         const int device_id) {
   CHECK(!ptx.empty());
-  CHECK(cuda_mgr->getDeviceCount() > 0);
-  static_cast<const CudaMgr_Namespace::CudaMgr*>(cuda_mgr)->setContext(0);
+  CHECK_LT(device_id, cuda_mgr->getDeviceCount());
+  // the cubin targets the compute capability of the device of the current context
+  static_cast<const CudaMgr_Namespace::CudaMgr*>(cuda_mgr)->setContext(device_id);
   std::vector<CUjit_option> option_keys;
   std::vector<void*> option_values;
   fill_options(option_keys, option_values, block_size);
@@ -83,7 +85,7 @@ CubinResult ptx_to_cubin(const std::string& ptx,
   checkCudaErrors(cuLinkComplete(link_state, &cubin, &cubinSize));
   CHECK(cubin);
   CHECK_GT(cubinSize, size_t(0));
-  return {cubin, option_keys, option_values, link_state};
+  return {cubin, cubinSize, option_keys, option_values, link_state};
 }
 #endif
 
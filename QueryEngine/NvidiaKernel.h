@@ -29,14 +29,17 @@
 
 struct CubinResult {
   void* cubin;
+  size_t cubin_size;
   std::vector<CUjit_option> option_keys;
   std::vector<void*> option_values;
   CUlinkState link_state;
 };
 
+// The cubin runs on the devices of the same compute capability as device_id.
 CubinResult ptx_to_cubin(const std::string& ptx,
                          const unsigned block_size,
-                         const CudaMgr_Namespace::CudaMgr* cuda_mgr);
+                         const CudaMgr_Namespace::CudaMgr* cuda_mgr,
+                         const int device_id);
 
 class GpuCompilationContext {
  public:
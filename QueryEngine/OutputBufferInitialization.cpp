@@ -16,6 +16,7 @@
 
 #include "OutputBufferInitialization.h"
 #include "BufferCompaction.h"
+#include "ExpressionRange.h"
 #include "ResultRows.h"
 #include "TypePunning.h"
 
@@ -185,6 +186,9 @@ int64_t get_agg_initial_val(const SQLAgg agg,
     }
     case kCOUNT:
     case kAPPROX_COUNT_DISTINCT:
+    case kAPPROX_COUNT_DISTINCT_SKETCH:
+    case kAPPROX_COUNT_DISTINCT_UNION:
+    case kAPPROX_QUANTILE:
       return 0;
     case kMIN: {
       switch (byte_width) {
@@ -261,6 +265,8 @@ int64_t get_initial_val(const TargetInfo& target_info,
 std::vector<int64_t> init_agg_val_vec(
     const std::vector<Analyzer::Expr*>& targets,
     const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const std::vector<InputTableInfo>& query_infos,
+    const Executor* executor,
     const QueryMemoryDescriptor& query_mem_desc) {
   std::vector<TargetInfo> target_infos;
   target_infos.reserve(targets.size());
@@ -278,7 +284,7 @@ std::vector<int64_t> init_agg_val_vec(
           (target.agg_kind == kMIN ||
            target.agg_kind == kMAX)) {  // TODO(alex): fix SUM and AVG as well
         set_notnull(target, false);
-      } else if (constrained_not_null(arg_expr, quals)) {
+      } else if (known_not_null(arg_expr, quals, query_infos, executor)) {
         set_notnull(target, true);
       }
     }
@@ -314,6 +320,25 @@ bool constrained_not_null(const Analyzer::Expr* expr,
   return false;
 }
 
+bool known_not_null(const Analyzer::Expr* expr,
+                    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+                    const std::vector<InputTableInfo>& query_infos,
+                    const Executor* executor) {
+  if (constrained_not_null(expr, quals)) {
+    return true;
+  }
+  const auto& ti = expr->get_type_info();
+  if (ti.get_notnull()) {
+    return true;
+  }
+  if (ti.is_array() || ti.is_geometry() ||
+      (ti.is_string() && ti.get_compression() == kENCODING_NONE)) {
+    return false;
+  }
+  const auto expr_range = getExpressionRange(expr, query_infos, executor);
+  return expr_range.getType() != ExpressionRangeType::Invalid && !expr_range.hasNulls();
+}
+
 void set_notnull(TargetInfo& target, const bool not_null) {
   target.skip_null_val = !not_null;
   auto new_type = get_compact_type(target);
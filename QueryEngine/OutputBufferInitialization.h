@@ -33,6 +33,8 @@ namespace Analyzer {
 class Expr;
 }  // namespace Analyzer
 
+class Executor;
+struct InputTableInfo;
 class QueryMemoryDescriptor;
 
 std::pair<int64_t, int64_t> inline_int_max_min(const size_t byte_width);
@@ -50,6 +52,8 @@ int64_t get_agg_initial_val(const SQLAgg agg,
 std::vector<int64_t> init_agg_val_vec(
     const std::vector<Analyzer::Expr*>& targets,
     const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const std::vector<InputTableInfo>& query_infos,
+    const Executor* executor,
     const QueryMemoryDescriptor& query_mem_desc);
 
 const Analyzer::Expr* agg_arg(const Analyzer::Expr* expr);
@@ -57,6 +61,13 @@ const Analyzer::Expr* agg_arg(const Analyzer::Expr* expr);
 bool constrained_not_null(const Analyzer::Expr* expr,
                           const std::list<std::shared_ptr<Analyzer::Expr>>& quals);
 
+// The argument of an aggregate can't be null if the quals filter its nulls out or if the
+// metadata of the chunks of the query shows none, its updates then skip the null checks.
+bool known_not_null(const Analyzer::Expr* expr,
+                    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+                    const std::vector<InputTableInfo>& query_infos,
+                    const Executor* executor);
+
 void set_notnull(TargetInfo& target, const bool not_null);
 
 #endif  // QUERYENGINE_OUTPUTBUFFERINITIALIZATION_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PerfEventCounters.h"
+
+#include <glog/logging.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace {
+
+#ifdef __linux__
+int open_counter(const uint64_t config, const int group_fd) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group_fd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // the calling thread, on any cpu
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+}  // namespace
+
+PerfEventCounters::PerfEventCounters() {
+  for (auto& fd : fds_) {
+    fd = -1;
+  }
+#ifdef __linux__
+  const uint64_t configs[kCounterCount]{
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+  fds_[0] = open_counter(configs[0], -1);
+  if (fds_[0] == -1) {
+    LOG_FIRST_N(WARNING, 1) << "Could not open the hardware performance counters: "
+                            << strerror(errno);
+    return;
+  }
+  for (int i = 1; i < kCounterCount; ++i) {
+    fds_[i] = open_counter(configs[i], fds_[0]);
+  }
+#endif
+}
+
+PerfEventCounters::~PerfEventCounters() {
+#ifdef __linux__
+  for (const auto fd : fds_) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+void PerfEventCounters::start() {
+#ifdef __linux__
+  if (fds_[0] != -1) {
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+PerfEventCounters::Values PerfEventCounters::stop() {
+  uint64_t counts[kCounterCount]{0, 0, 0};
+#ifdef __linux__
+  if (fds_[0] != -1) {
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  }
+  for (int i = 0; i < kCounterCount; ++i) {
+    if (fds_[i] == -1) {
+      continue;
+    }
+    if (read(fds_[i], &counts[i], sizeof(counts[i])) != sizeof(counts[i])) {
+      counts[i] = 0;
+    }
+  }
+#endif
+  Values values;
+  values.cycles = counts[0];
+  values.llc_misses = counts[1];
+  values.branch_misses = counts[2];
+  return values;
+}
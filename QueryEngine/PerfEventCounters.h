@@ -0,0 +1,54 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    PerfEventCounters.h
+ * @brief   Hardware counters of the calling thread, read through perf_event_open.
+ *
+ * The counters are zero where the kernel does not allow unprivileged access to them
+ * (see /proc/sys/kernel/perf_event_paranoid).
+ */
+
+#ifndef QUERYENGINE_PERFEVENTCOUNTERS_H
+#define QUERYENGINE_PERFEVENTCOUNTERS_H
+
+#include <cstdint>
+
+class PerfEventCounters {
+ public:
+  struct Values {
+    uint64_t cycles{0};
+    uint64_t llc_misses{0};
+    uint64_t branch_misses{0};
+  };
+
+  PerfEventCounters();
+  ~PerfEventCounters();
+
+  PerfEventCounters(const PerfEventCounters&) = delete;
+  PerfEventCounters& operator=(const PerfEventCounters&) = delete;
+
+  void start();
+
+  Values stop();
+
+ private:
+  static constexpr int kCounterCount{3};
+
+  int fds_[kCounterCount];
+};
+
+#endif  // QUERYENGINE_PERFEVENTCOUNTERS_H
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PersistentCodeCache.h"
+#include "MurmurHash.h"
+
+#include <glog/logging.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+std::string g_persistent_code_cache_dir;
+
+namespace {
+
+const uint64_t CODE_CACHE_MAGIC{0x434A4450414DULL};  // MAPDJC
+const uint32_t CODE_CACHE_FORMAT_VERSION{1};
+const std::string CODE_CACHE_ENTRY_EXT{".jit"};
+
+template <class T>
+void write_scalar(std::ostream& os, const T val) {
+  os.write(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+template <class T>
+bool read_scalar(std::istream& is, T& val) {
+  is.read(reinterpret_cast<char*>(&val), sizeof(val));
+  return is.good();
+}
+
+bool read_string(std::istream& is, const uint64_t size, std::string& str) {
+  str.resize(size);
+  if (!size) {
+    return true;
+  }
+  is.read(&str[0], size);
+  return static_cast<uint64_t>(is.gcount()) == size;
+}
+
+}  // namespace
+
+PersistentCodeCache& PersistentCodeCache::instance() {
+  static PersistentCodeCache code_cache(g_persistent_code_cache_dir);
+  return code_cache;
+}
+
+PersistentCodeCache::PersistentCodeCache(const std::string& cache_dir)
+    : cache_dir_(cache_dir) {
+  if (!isEnabled()) {
+    return;
+  }
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(cache_dir_, ec);
+  if (ec) {
+    LOG(ERROR) << "Could not create the code cache directory " << cache_dir_ << ": "
+               << ec.message();
+  }
+  loadIndex();
+}
+
+void PersistentCodeCache::loadIndex() {
+  boost::system::error_code ec;
+  boost::filesystem::directory_iterator it(cache_dir_, ec);
+  if (ec) {
+    return;
+  }
+  size_t stale_count{0};
+  for (; it != boost::filesystem::directory_iterator(); it.increment(ec)) {
+    if (ec) {
+      break;
+    }
+    const auto& path = it->path();
+    if (path.extension() == CODE_CACHE_ENTRY_EXT) {
+      index_.insert(path.stem().string());
+    } else {
+      // Leftovers from writers interrupted before the rename.
+      boost::filesystem::remove(path, ec);
+      ++stale_count;
+    }
+  }
+  LOG(INFO) << "Loaded " << index_.size() << " entries from the code cache "
+            << cache_dir_ << (stale_count ? ", removed incomplete files" : "");
+}
+
+std::string PersistentCodeCache::serializeKey(const std::vector<std::string>& ir_key,
+                                              const std::string& target) {
+  std::string serialized_key{target};
+  for (const auto& ir : ir_key) {
+    serialized_key += '\0';
+    serialized_key += ir;
+  }
+  return serialized_key;
+}
+
+std::string PersistentCodeCache::entryName(const std::string& serialized_key) const {
+  const auto len = static_cast<int>(serialized_key.size());
+  std::ostringstream oss;
+  oss << std::hex << std::setfill('0') << std::setw(16)
+      << MurmurHash64A(serialized_key.data(), len, 0) << std::setw(16)
+      << MurmurHash64A(serialized_key.data(), len, CODE_CACHE_MAGIC);
+  return oss.str();
+}
+
+bool PersistentCodeCache::get(const std::vector<std::string>& ir_key,
+                              const std::string& target,
+                              std::string& image) {
+  if (!isEnabled()) {
+    return false;
+  }
+  const auto serialized_key = serializeKey(ir_key, target);
+  const auto entry_name = entryName(serialized_key);
+  {
+    std::lock_guard<std::mutex> lock(index_mutex_);
+    if (!index_.count(entry_name)) {
+      return false;
+    }
+  }
+  const auto path =
+      boost::filesystem::path(cache_dir_) / (entry_name + CODE_CACHE_ENTRY_EXT);
+  std::ifstream entry_file(path.string(), std::ios::binary);
+  uint64_t magic{0};
+  uint32_t version{0};
+  uint64_t key_size{0};
+  std::string stored_key;
+  uint64_t image_size{0};
+  if (!entry_file || !read_scalar(entry_file, magic) || magic != CODE_CACHE_MAGIC ||
+      !read_scalar(entry_file, version) || version != CODE_CACHE_FORMAT_VERSION ||
+      !read_scalar(entry_file, key_size) ||
+      !read_string(entry_file, key_size, stored_key) ||
+      stored_key != serialized_key || !read_scalar(entry_file, image_size) ||
+      !read_string(entry_file, image_size, image)) {
+    LOG(WARNING) << "Ignoring mismatched or corrupt code cache entry " << path.string();
+    image.clear();
+    return false;
+  }
+  return true;
+}
+
+void PersistentCodeCache::put(const std::vector<std::string>& ir_key,
+                              const std::string& target,
+                              const void* image,
+                              const size_t image_size) {
+  if (!isEnabled()) {
+    return;
+  }
+  CHECK(image);
+  const auto serialized_key = serializeKey(ir_key, target);
+  const auto entry_name = entryName(serialized_key);
+  const auto path =
+      boost::filesystem::path(cache_dir_) / (entry_name + CODE_CACHE_ENTRY_EXT);
+  std::ostringstream tmp_suffix;
+  tmp_suffix << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  const auto tmp_path = path.string() + tmp_suffix.str();
+  {
+    std::ofstream entry_file(tmp_path, std::ios::binary | std::ios::trunc);
+    write_scalar(entry_file, CODE_CACHE_MAGIC);
+    write_scalar(entry_file, CODE_CACHE_FORMAT_VERSION);
+    write_scalar(entry_file, static_cast<uint64_t>(serialized_key.size()));
+    entry_file.write(serialized_key.data(), serialized_key.size());
+    write_scalar(entry_file, static_cast<uint64_t>(image_size));
+    entry_file.write(static_cast<const char*>(image), image_size);
+    if (!entry_file) {
+      LOG(WARNING) << "Could not write code cache entry " << tmp_path;
+      boost::system::error_code ec;
+      boost::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  // Readers only ever see complete entries.
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    LOG(WARNING) << "Could not publish code cache entry " << path.string() << ": "
+                 << ec.message();
+    boost::filesystem::remove(tmp_path, ec);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(index_mutex_);
+  index_.insert(entry_name);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    PersistentCodeCache.h
+ * @brief   On-disk cache of the native code generated for queries.
+ *
+ * Entries are keyed by the IR of the query functions (the same key as the in-memory
+ * code caches of the executor) and by the target the code was generated for: the LLVM
+ * version, the host CPU or the GPU architecture. Every entry file stores the full key
+ * next to the object code or cubin, so a hash collision is detected and treated as a
+ * miss. The cache is disabled unless a directory is configured.
+ */
+
+#ifndef QUERYENGINE_PERSISTENTCODECACHE_H
+#define QUERYENGINE_PERSISTENTCODECACHE_H
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+extern std::string g_persistent_code_cache_dir;
+
+class PersistentCodeCache {
+ public:
+  static PersistentCodeCache& instance();
+
+  bool isEnabled() const { return !cache_dir_.empty(); }
+
+  // Looks up the code for the given IR and target, fills `image` on hit.
+  bool get(const std::vector<std::string>& ir_key,
+           const std::string& target,
+           std::string& image);
+
+  void put(const std::vector<std::string>& ir_key,
+           const std::string& target,
+           const void* image,
+           const size_t image_size);
+
+ private:
+  explicit PersistentCodeCache(const std::string& cache_dir);
+
+  // Builds the index of the entries written by previous runs.
+  void loadIndex();
+
+  static std::string serializeKey(const std::vector<std::string>& ir_key,
+                                  const std::string& target);
+
+  std::string entryName(const std::string& serialized_key) const;
+
+  const std::string cache_dir_;
+  std::mutex index_mutex_;
+  std::unordered_set<std::string> index_;
+};
+
+#endif  // QUERYENGINE_PERSISTENTCODECACHE_H
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QuantileSketch.h
+ * @brief   Log-scaled histogram the approximate percentiles are computed from.
+ *
+ * The buckets of a sketch cover the magnitudes from kQuantileSketchMinMagnitude up in
+ * steps of gamma = (1 + a) / (1 - a), which bounds the relative error of a percentile
+ * by a = 2%. Smaller magnitudes count as zero, the larger ones go in the last bucket.
+ * The counts are 64-bit on both devices, two sketches merge by adding them up.
+ */
+
+#ifndef QUERYENGINE_QUANTILESKETCH_H
+#define QUERYENGINE_QUANTILESKETCH_H
+
+#include "../Shared/funcannotations.h"
+
+#include <cmath>
+#include <cstdint>
+
+constexpr uint32_t kQuantileSketchBucketsPerSign{2048};
+// The negative buckets, the zero bucket, then the positive ones, in increasing order.
+constexpr uint32_t kQuantileSketchBuckets{2 * kQuantileSketchBucketsPerSign + 1};
+constexpr double kQuantileSketchMinMagnitude{1e-12};
+// log(gamma) for a relative error of 2%
+constexpr double kQuantileSketchLogGamma{0.040005334613699164};
+
+DEVICE inline uint32_t quantile_sketch_bucket(const double val) {
+  const double magnitude = val < 0 ? -val : val;
+  if (!(magnitude > kQuantileSketchMinMagnitude)) {
+    return kQuantileSketchBucketsPerSign;
+  }
+  // clamped before the conversion, the magnitude can be infinite
+  auto k = ceil(log(magnitude / kQuantileSketchMinMagnitude) / kQuantileSketchLogGamma);
+  k = k < 1 ? 1 : (k > kQuantileSketchBucketsPerSign ? kQuantileSketchBucketsPerSign : k);
+  const auto bucket_offset = static_cast<uint32_t>(k);
+  return val > 0 ? kQuantileSketchBucketsPerSign + bucket_offset
+                 : kQuantileSketchBucketsPerSign - bucket_offset;
+}
+
+// The value whose relative distance to both ends of the bucket is the same.
+inline double quantile_sketch_bucket_value(const uint32_t bucket) {
+  if (bucket == kQuantileSketchBucketsPerSign) {
+    return 0;
+  }
+  const int64_t k = bucket > kQuantileSketchBucketsPerSign
+                        ? bucket - kQuantileSketchBucketsPerSign
+                        : kQuantileSketchBucketsPerSign - bucket;
+  const double gamma = exp(kQuantileSketchLogGamma);
+  const double magnitude =
+      kQuantileSketchMinMagnitude * exp(k * kQuantileSketchLogGamma) * 2 / (gamma + 1);
+  return bucket > kQuantileSketchBucketsPerSign ? magnitude : -magnitude;
+}
+
+// The value of rank q * (n - 1) among the n values counted, false if there are none.
+inline bool quantile_sketch_value(double& value,
+                                  const int64_t* counts,
+                                  const double q) {
+  int64_t total{0};
+  for (uint32_t i = 0; i < kQuantileSketchBuckets; ++i) {
+    total += counts[i];
+  }
+  if (!total) {
+    return false;
+  }
+  const auto rank = static_cast<int64_t>(q * (total - 1));
+  int64_t seen{0};
+  for (uint32_t i = 0; i < kQuantileSketchBuckets; ++i) {
+    seen += counts[i];
+    if (seen > rank) {
+      value = quantile_sketch_bucket_value(i);
+      return true;
+    }
+  }
+  value = quantile_sketch_bucket_value(kQuantileSketchBuckets - 1);
+  return true;
+}
+
+#endif  // QUERYENGINE_QUANTILESKETCH_H
@@ -18,12 +18,18 @@
 #include "AggregateUtils.h"
 #include "Execute.h"
 #include "GpuInitGroups.h"
+#include "GroupByBufferPool.h"
+#include "QueryMemoryAccount.h"
 #include "QueryMemoryDescriptor.h"
 #include "RelAlgExecutionUnit.h"
 #include "StreamingTopN.h"
 
 namespace {
 
+// Sizes recorded for the deferred count distinct sets, which have no bitmap.
+constexpr ssize_t kDeferredSetSize{-1};
+constexpr ssize_t kDeferredRoaringSize{-2};
+
 void check_total_bitmap_memory(const QueryMemoryDescriptor& query_mem_desc) {
   const int32_t groups_buffer_entry_count = query_mem_desc.getEntryCount();
   if (g_enable_watchdog) {
@@ -64,7 +70,8 @@ int64_t* alloc_group_by_buffer(const size_t numBytes,
     auto render_allocator_ptr = render_allocator_map->getRenderAllocator(gpu_idx);
     return reinterpret_cast<int64_t*>(render_allocator_ptr->alloc(numBytes));
   } else {
-    return reinterpret_cast<int64_t*>(checked_malloc(numBytes));
+    QueryMemoryAccount::charge(ExecutorDeviceType::CPU, numBytes);
+    return GroupByBufferPool::acquire(numBytes);
   }
 }
 
@@ -98,6 +105,7 @@ QueryExecutionContext::QueryExecutionContext(
                        : executor->blockSize() * (query_mem_desc_.blocksShareMemory()
                                                       ? 1
                                                       : executor->gridSize())}
+    , group_by_buffers_reduced_on_device_(false)
     , row_set_mem_owner_(row_set_mem_owner)
     , output_columnar_(output_columnar)
     , sort_on_gpu_(sort_on_gpu)
@@ -194,7 +202,7 @@ QueryExecutionContext::QueryExecutionContext(
              group_buffer_size);
     }
     if (!render_allocator_map) {
-      row_set_mem_owner_->addGroupByBuffer(group_by_buffer);
+      row_set_mem_owner_->addGroupByBuffer(group_by_buffer, actual_group_buffer_size);
     }
     group_by_buffers_.push_back(group_by_buffer);
     for (size_t j = 1; j < step; ++j) {
@@ -242,13 +250,20 @@ void QueryExecutionContext::allocateCountDistinctGpuMem() {
   }
   count_distinct_bitmap_mem_bytes_ =
       total_bytes_per_entry * query_mem_desc_.getEntryCount();
-  count_distinct_bitmap_mem_ =
-      alloc_gpu_mem(data_mgr, count_distinct_bitmap_mem_bytes_, device_id_, nullptr);
+  // Out of the scratch pool if there's room left in it, freeAllBuffers frees it either
+  // way at the end of the query.
+  count_distinct_bitmap_mem_ = reinterpret_cast<CUdeviceptr>(
+      data_mgr->allocScratch(device_id_, count_distinct_bitmap_mem_bytes_));
+  if (!count_distinct_bitmap_mem_) {
+    count_distinct_bitmap_mem_ =
+        alloc_gpu_mem(data_mgr, count_distinct_bitmap_mem_bytes_, device_id_, nullptr);
+  }
   data_mgr->cudaMgr_->zeroDeviceMem(reinterpret_cast<int8_t*>(count_distinct_bitmap_mem_),
                                     count_distinct_bitmap_mem_bytes_,
                                     device_id_);
   OOM_TRACE_PUSH(+": count_distinct_bitmap_mem_bytes_ " +
                  std::to_string(count_distinct_bitmap_mem_bytes_));
+  QueryMemoryAccount::charge(ExecutorDeviceType::CPU, count_distinct_bitmap_mem_bytes_);
   count_distinct_bitmap_crt_ptr_ = count_distinct_bitmap_host_mem_ =
       static_cast<int8_t*>(checked_malloc(count_distinct_bitmap_mem_bytes_));
   row_set_mem_owner_->addCountDistinctBuffer(
@@ -315,8 +330,11 @@ void QueryExecutionContext::initColumnPerRow(const QueryMemoryDescriptor& query_
     } else {
       CHECK_EQ(static_cast<size_t>(query_mem_desc.getColumnWidth(col_idx).compact),
                sizeof(int64_t));
-      init_val =
-          bm_sz > 0 ? allocateCountDistinctBitmap(bm_sz) : allocateCountDistinctSet();
+      init_val = bm_sz > 0 ? allocateCountDistinctBitmap(bm_sz)
+                           : allocateCountDistinctSet(
+                                 bm_sz == kDeferredRoaringSize
+                                     ? CountDistinctImplType::Roaring
+                                     : CountDistinctImplType::StdSet);
       ++init_vec_idx;
     }
     switch (query_mem_desc.getColumnWidth(col_idx).compact) {
@@ -468,7 +486,8 @@ std::vector<ssize_t> QueryExecutionContext::allocateCountDistinctBuffers(
     const auto agg_info = target_info(target_expr);
     if (is_distinct_target(agg_info)) {
       CHECK(agg_info.is_agg &&
-            (agg_info.agg_kind == kCOUNT || agg_info.agg_kind == kAPPROX_COUNT_DISTINCT));
+            (agg_info.agg_kind == kCOUNT || is_approx_count_distinct(agg_info.agg_kind) ||
+             agg_info.agg_kind == kAPPROX_QUANTILE));
       CHECK_EQ(static_cast<size_t>(query_mem_desc_.getColumnWidth(agg_col_idx).actual),
                sizeof(int64_t));
       const auto& count_distinct_desc =
@@ -482,11 +501,16 @@ std::vector<ssize_t> QueryExecutionContext::allocateCountDistinctBuffers(
           init_agg_vals_[agg_col_idx] = allocateCountDistinctBitmap(bitmap_byte_sz);
         }
       } else {
-        CHECK(count_distinct_desc.impl_type_ == CountDistinctImplType::StdSet);
+        CHECK(count_distinct_desc.impl_type_ == CountDistinctImplType::StdSet ||
+              count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring);
         if (deferred) {
-          agg_bitmap_size[agg_col_idx] = -1;
+          agg_bitmap_size[agg_col_idx] =
+              count_distinct_desc.impl_type_ == CountDistinctImplType::Roaring
+                  ? kDeferredRoaringSize
+                  : kDeferredSetSize;
         } else {
-          init_agg_vals_[agg_col_idx] = allocateCountDistinctSet();
+          init_agg_vals_[agg_col_idx] =
+              allocateCountDistinctSet(count_distinct_desc.impl_type_);
         }
       }
     }
@@ -507,12 +531,18 @@ int64_t QueryExecutionContext::allocateCountDistinctBitmap(const size_t bitmap_b
     return reinterpret_cast<int64_t>(ptr);
   }
   OOM_TRACE_PUSH(+": count_distinct_buffer " + std::to_string(bitmap_byte_sz));
-  auto count_distinct_buffer = static_cast<int8_t*>(checked_calloc(bitmap_byte_sz, 1));
-  row_set_mem_owner_->addCountDistinctBuffer(count_distinct_buffer, bitmap_byte_sz, true);
-  return reinterpret_cast<int64_t>(count_distinct_buffer);
+  return reinterpret_cast<int64_t>(
+      row_set_mem_owner_->allocateCountDistinctBuffer(bitmap_byte_sz));
 }
 
-int64_t QueryExecutionContext::allocateCountDistinctSet() {
+int64_t QueryExecutionContext::allocateCountDistinctSet(
+    const CountDistinctImplType impl_type) {
+  if (impl_type == CountDistinctImplType::Roaring) {
+    auto count_distinct_roaring = new RoaringBitmap();
+    row_set_mem_owner_->addCountDistinctRoaring(count_distinct_roaring);
+    return reinterpret_cast<int64_t>(count_distinct_roaring);
+  }
+  CHECK(impl_type == CountDistinctImplType::StdSet);
   auto count_distinct_set = new std::set<int64_t>();
   row_set_mem_owner_->addCountDistinctSet(count_distinct_set);
   return reinterpret_cast<int64_t>(count_distinct_set);
@@ -527,6 +557,9 @@ ResultSetPtr QueryExecutionContext::getRowSet(
     CHECK_EQ(size_t(1), num_buffers_);
     return groupBufferToResults(0, ra_exe_unit.target_exprs);
   }
+  if (group_by_buffers_reduced_on_device_) {
+    return groupBufferToResults(0, ra_exe_unit.target_exprs);
+  }
   size_t step{query_mem_desc_.threadsShareMemory() ? executor_->blockSize() : 1};
   for (size_t i = 0; i < group_by_buffers_.size(); i += step) {
     results_per_sm.emplace_back(groupBufferToResults(i, ra_exe_unit.target_exprs),
@@ -177,7 +177,7 @@ class QueryExecutionContext : boost::noncopyable {
 
   std::vector<ssize_t> allocateCountDistinctBuffers(const bool deferred);
   int64_t allocateCountDistinctBitmap(const size_t bitmap_byte_sz);
-  int64_t allocateCountDistinctSet();
+  int64_t allocateCountDistinctSet(const CountDistinctImplType impl_type);
 
   std::vector<ColumnLazyFetchInfo> getColLazyFetchInfo(
       const std::vector<Analyzer::Expr*>& target_exprs) const;
@@ -199,6 +199,8 @@ class QueryExecutionContext : boost::noncopyable {
 
   std::vector<int64_t*> group_by_buffers_;
   std::vector<int64_t*> small_group_by_buffers_;
+  // The buffers of the blocks have been added up into the first one on the device.
+  bool group_by_buffers_reduced_on_device_;
   std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner_;
   const bool output_columnar_;
   const bool sort_on_gpu_;
@@ -17,6 +17,7 @@
 #include "QueryFragmentDescriptor.h"
 
 #include "Execute.h"
+#include "Shared/thread_count.h"
 
 QueryFragmentDescriptor::QueryFragmentDescriptor(
     const RelAlgExecutionUnit& ra_exe_unit,
@@ -53,20 +54,42 @@ void QueryFragmentDescriptor::buildFragmentKernelMap(
     const ExecutorDeviceType& device_type,
     const bool enable_multifrag_kernels,
     const bool enable_inner_join_fragment_skipping,
-    Executor* executor) {
+    Executor* executor,
+    const size_t gpu_wave_bytes) {
   if (enable_multifrag_kernels) {
     buildMultifragKernelMap(ra_exe_unit,
                             frag_offsets,
                             device_count,
                             device_type,
                             enable_inner_join_fragment_skipping,
-                            executor);
+                            executor,
+                            gpu_wave_bytes);
   } else {
     buildFragmentPerKernelMap(
         ra_exe_unit, frag_offsets, device_count, device_type, executor);
   }
 }
 
+std::vector<FragmentMorsel> QueryFragmentDescriptor::buildMorsels(
+    const size_t morsel_size) const {
+  CHECK_GT(morsel_size, size_t(0));
+  std::vector<FragmentMorsel> morsels;
+  for (const auto& kv : kernels_per_device_) {
+    for (const auto kernel_id : kv.second) {
+      CHECK_LT(kernel_id, fragments_per_kernel_.size());
+      const auto& frag_list = fragments_per_kernel_[kernel_id];
+      CHECK_EQ(size_t(1), frag_list.size());
+      CHECK_EQ(size_t(1), frag_list.front().fragment_ids.size());
+      const auto tuple_count = getOuterFragmentTupleSize(kernel_id);
+      for (size_t begin = 0; begin < tuple_count; begin += morsel_size) {
+        morsels.push_back(FragmentMorsel{
+            kv.first, frag_list, {begin, std::min(begin + morsel_size, tuple_count)}});
+      }
+    }
+  }
+  return morsels;
+}
+
 void QueryFragmentDescriptor::buildFragmentPerKernelMap(
     const RelAlgExecutionUnit& ra_exe_unit,
     const std::vector<uint64_t>& frag_offsets,
@@ -79,14 +102,31 @@ void QueryFragmentDescriptor::buildFragmentPerKernelMap(
   CHECK(it != selected_tables_fragments_.end());
   const auto outer_fragments = it->second;
   outer_fragments_size_ = outer_fragments->size();
+  if (device_type == ExecutorDeviceType::GPU) {
+    computeGpuPlacement(ra_exe_unit, *outer_fragments, device_count, executor);
+  }
 
-  for (size_t i = 0; i < outer_fragments->size(); ++i) {
+  const auto candidates = executor->getCandidateFragments(
+      outer_table_desc, *outer_fragments, ra_exe_unit.simple_quals);
+  const size_t candidate_count =
+      candidates ? candidates->size() : outer_fragments->size();
+  size_t selected_count{0};
+  for (size_t candidate_idx = 0; candidate_idx < candidate_count; ++candidate_idx) {
+    const size_t i = candidates ? (*candidates)[candidate_idx] : candidate_idx;
     const auto& fragment = (*outer_fragments)[i];
-    const auto skip_frag = executor->skipFragment(
+    auto skip_frag = executor->skipFragment(
         outer_table_desc, fragment, ra_exe_unit.simple_quals, frag_offsets, i);
+    if (skip_frag == std::pair<bool, int64_t>(false, -1)) {
+      skip_frag.first = executor->skipFragmentJoinKeys(ra_exe_unit, fragment);
+    }
+    if (skip_frag == std::pair<bool, int64_t>(false, -1)) {
+      skip_frag.first = executor->skipFragmentTableSample(
+          outer_table_desc, ra_exe_unit.quals, frag_offsets, i);
+    }
     if (skip_frag.first) {
       continue;
     }
+    ++selected_count;
     // NOTE: Using kernel index instead of frag index now
     outer_fragment_tuple_sizes_.push_back(fragment.getNumTuples());
     rowid_lookup_key_ = std::max(rowid_lookup_key_, skip_frag.second);
@@ -96,9 +136,9 @@ void QueryFragmentDescriptor::buildFragmentPerKernelMap(
     const auto memory_level = device_type == ExecutorDeviceType::GPU
                                   ? Data_Namespace::GPU_LEVEL
                                   : Data_Namespace::CPU_LEVEL;
-    int device_id = (device_type == ExecutorDeviceType::CPU || fragment.shard == -1)
+    int device_id = device_type == ExecutorDeviceType::CPU
                         ? fragment.deviceIds[static_cast<int>(memory_level)]
-                        : fragment.shard % chosen_device_count;
+                        : getGpuForFragment(fragment, i, chosen_device_count);
 
     // Since we may have skipped fragments, the fragments_per_kernel_ vector may be
     // smaller than the outer_fragments size
@@ -123,6 +163,10 @@ void QueryFragmentDescriptor::buildFragmentPerKernelMap(
           FragmentsPerTable{table_id, frag_ids});
     }
   }
+  if (executor->query_profile_) {
+    executor->query_profile_->addFragments(outer_fragments_size_,
+                                           outer_fragments_size_ - selected_count);
+  }
 }
 
 void QueryFragmentDescriptor::buildMultifragKernelMap(
@@ -131,7 +175,8 @@ void QueryFragmentDescriptor::buildMultifragKernelMap(
     const int device_count,
     const ExecutorDeviceType& device_type,
     const bool enable_inner_join_fragment_skipping,
-    Executor* executor) {
+    Executor* executor,
+    const size_t gpu_wave_bytes) {
   // Allocate all the fragments of the tables involved in the query to available
   // devices. The basic idea: the device is decided by the outer table in the
   // query (the first table in a join) and we need to broadcast the fragments
@@ -142,11 +187,26 @@ void QueryFragmentDescriptor::buildMultifragKernelMap(
   CHECK(it != selected_tables_fragments_.end());
   const auto outer_fragments = it->second;
   outer_fragments_size_ = outer_fragments->size();
+  if (device_type == ExecutorDeviceType::GPU) {
+    computeGpuPlacement(ra_exe_unit, *outer_fragments, device_count, executor);
+  }
 
   const auto inner_table_id_to_join_condition = executor->getInnerTabIdToJoinCond();
+  // Input bytes of the outer fragments of the last kernel of each device.
+  std::map<int, size_t> wave_bytes_per_device;
+  // On CPU, the outer fragments go round robin to one kernel per thread.
+  const size_t cpu_kernel_count = static_cast<size_t>(std::max(cpu_threads(), 1));
+  size_t cpu_frag_count{0};
 
-  for (size_t outer_frag_id = 0; outer_frag_id < outer_fragments->size();
-       ++outer_frag_id) {
+  // Only the outer fragments the range indexes don't rule out.
+  const auto candidates = executor->getCandidateFragments(
+      outer_table_desc, *outer_fragments, ra_exe_unit.simple_quals);
+  const size_t candidate_count =
+      candidates ? candidates->size() : outer_fragments->size();
+  size_t selected_count{0};
+  for (size_t candidate_idx = 0; candidate_idx < candidate_count; ++candidate_idx) {
+    const size_t outer_frag_id =
+        candidates ? (*candidates)[candidate_idx] : candidate_idx;
     const auto& fragment = (*outer_fragments)[outer_frag_id];
     auto skip_frag = executor->skipFragment(outer_table_desc,
                                             fragment,
@@ -158,13 +218,51 @@ void QueryFragmentDescriptor::buildMultifragKernelMap(
       skip_frag = executor->skipFragmentInnerJoins(
           outer_table_desc, ra_exe_unit, fragment, frag_offsets, outer_frag_id);
     }
+    if (skip_frag == std::pair<bool, int64_t>(false, -1)) {
+      skip_frag.first = executor->skipFragmentJoinKeys(ra_exe_unit, fragment);
+    }
+    if (skip_frag == std::pair<bool, int64_t>(false, -1)) {
+      skip_frag.first = executor->skipFragmentTableSample(
+          outer_table_desc, ra_exe_unit.quals, frag_offsets, outer_frag_id);
+    }
     if (skip_frag.first) {
       continue;
     }
-    const int device_id =
-        fragment.shard == -1
-            ? fragment.deviceIds[static_cast<int>(Data_Namespace::GPU_LEVEL)]
-            : fragment.shard % device_count;
+    ++selected_count;
+    const int device_id = device_type == ExecutorDeviceType::CPU
+                              ? 0
+                              : getGpuForFragment(fragment, outer_frag_id, device_count);
+    if (gpu_wave_bytes && device_type == ExecutorDeviceType::GPU) {
+      size_t fragment_bytes{0};
+      for (const auto& col_desc : ra_exe_unit.input_col_descs) {
+        if (col_desc->getScanDesc().getTableId() != outer_table_id) {
+          continue;
+        }
+        const auto chunk_meta_it =
+            fragment.getChunkMetadataMap().find(col_desc->getColId());
+        if (chunk_meta_it != fragment.getChunkMetadataMap().end()) {
+          fragment_bytes += chunk_meta_it->second.numBytes;
+        }
+      }
+      auto& wave_bytes = wave_bytes_per_device[device_id];
+      if (wave_bytes > 0 && wave_bytes + fragment_bytes > gpu_wave_bytes) {
+        // The next wave of the device starts with this fragment.
+        fragments_per_kernel_.emplace_back(FragmentsList{});
+        kernels_per_device_[device_id].insert(fragments_per_kernel_.size() - 1);
+        wave_bytes = 0;
+      }
+      wave_bytes += fragment_bytes;
+    }
+    if (kernels_per_device_.find(device_id) == kernels_per_device_.end() ||
+        (device_type == ExecutorDeviceType::CPU &&
+         fragments_per_kernel_.size() < cpu_kernel_count)) {
+      fragments_per_kernel_.emplace_back(FragmentsList{});
+      kernels_per_device_[device_id].insert(fragments_per_kernel_.size() - 1);
+    }
+    const auto kernel_id = device_type == ExecutorDeviceType::CPU
+                               ? cpu_frag_count++ % fragments_per_kernel_.size()
+                               : *kernels_per_device_[device_id].rbegin();
+    CHECK_LT(kernel_id, fragments_per_kernel_.size());
     for (size_t j = 0; j < ra_exe_unit.input_descs.size(); ++j) {
       const auto table_id = ra_exe_unit.input_descs[j].getTableId();
       auto table_frags_it = selected_tables_fragments_.find(table_id);
@@ -177,13 +275,6 @@ void QueryFragmentDescriptor::buildMultifragKernelMap(
                                             selected_tables_fragments_,
                                             inner_table_id_to_join_condition);
 
-      if (kernels_per_device_.find(device_id) == kernels_per_device_.end()) {
-        fragments_per_kernel_.emplace_back(FragmentsList{});
-        kernels_per_device_.insert(std::make_pair(
-            device_id, std::set<size_t>({fragments_per_kernel_.size() - 1})));
-      }
-      const auto kernel_id = *kernels_per_device_[device_id].begin();
-      CHECK_LT(kernel_id, fragments_per_kernel_.size());
       if (fragments_per_kernel_[kernel_id].size() < j + 1) {
         fragments_per_kernel_[kernel_id].emplace_back(
             FragmentsPerTable{table_id, frag_ids});
@@ -200,6 +291,92 @@ void QueryFragmentDescriptor::buildMultifragKernelMap(
     }
     rowid_lookup_key_ = std::max(rowid_lookup_key_, skip_frag.second);
   }
+  if (executor->query_profile_) {
+    executor->query_profile_->addFragments(outer_fragments_size_,
+                                           outer_fragments_size_ - selected_count);
+  }
+}
+
+void QueryFragmentDescriptor::computeGpuPlacement(
+    const RelAlgExecutionUnit& ra_exe_unit,
+    const TableFragments& outer_fragments,
+    const int device_count,
+    Executor* executor) {
+  outer_fragment_gpus_.assign(outer_fragments.size(), -1);
+  if (!g_enable_residency_aware_placement || device_count < 2) {
+    return;
+  }
+  size_t total_rows{0};
+  for (const auto& fragment : outer_fragments) {
+    total_rows += fragment.getNumTuples();
+  }
+  const size_t rows_share = (total_rows + device_count - 1) / device_count;
+  std::vector<size_t> device_rows(device_count, 0);
+  auto free_bytes = executor->getGpuFreeMemory(device_count);
+  const auto place = [&](const size_t frag_id,
+                         const int device_id,
+                         const size_t missing_bytes) {
+    outer_fragment_gpus_[frag_id] = device_id;
+    device_rows[device_id] += outer_fragments[frag_id].getNumTuples();
+    free_bytes[device_id] -= std::min(free_bytes[device_id], missing_bytes);
+  };
+
+  std::vector<std::pair<size_t, std::vector<size_t>>> residency(outer_fragments.size());
+  std::vector<size_t> not_resident_frag_ids;
+  for (size_t frag_id = 0; frag_id < outer_fragments.size(); ++frag_id) {
+    const auto& fragment = outer_fragments[frag_id];
+    if (fragment.shard != -1) {
+      // The shards of the joined tables must meet on the same device.
+      device_rows[fragment.shard % device_count] += fragment.getNumTuples();
+      continue;
+    }
+    residency[frag_id] =
+        executor->getFragmentGpuResidency(ra_exe_unit, fragment, device_count);
+    const auto& resident_bytes = residency[frag_id].second;
+    const auto best_it = std::max_element(resident_bytes.begin(), resident_bytes.end());
+    const int best_device_id = std::distance(resident_bytes.begin(), best_it);
+    if (*best_it > 0 &&
+        device_rows[best_device_id] + fragment.getNumTuples() <= rows_share) {
+      place(frag_id, best_device_id, residency[frag_id].first - *best_it);
+    } else {
+      not_resident_frag_ids.push_back(frag_id);
+    }
+  }
+
+  for (const auto frag_id : not_resident_frag_ids) {
+    const auto frag_rows = outer_fragments[frag_id].getNumTuples();
+    int chosen_device_id{-1};
+    for (int device_id = 0; device_id < device_count; ++device_id) {
+      if (device_rows[device_id] + frag_rows > rows_share) {
+        continue;
+      }
+      if (chosen_device_id < 0 || free_bytes[device_id] > free_bytes[chosen_device_id]) {
+        chosen_device_id = device_id;
+      }
+    }
+    if (chosen_device_id < 0) {
+      chosen_device_id = std::distance(
+          device_rows.begin(), std::min_element(device_rows.begin(), device_rows.end()));
+    }
+    const auto& frag_residency = residency[frag_id];
+    place(frag_id,
+          chosen_device_id,
+          frag_residency.first - frag_residency.second[chosen_device_id]);
+  }
+}
+
+int QueryFragmentDescriptor::getGpuForFragment(
+    const Fragmenter_Namespace::FragmentInfo& fragment,
+    const size_t outer_frag_id,
+    const int device_count) const {
+  if (fragment.shard != -1) {
+    return fragment.shard % device_count;
+  }
+  if (outer_frag_id < outer_fragment_gpus_.size() &&
+      outer_fragment_gpus_[outer_frag_id] >= 0) {
+    return outer_fragment_gpus_[outer_frag_id];
+  }
+  return fragment.deviceIds[static_cast<int>(Data_Namespace::GPU_LEVEL)];
 }
 
 namespace {
@@ -48,6 +48,22 @@ struct FragmentsPerTable {
 using FragmentsList = std::vector<FragmentsPerTable>;
 using TableFragments = std::deque<Fragmenter_Namespace::FragmentInfo>;
 
+// Rows [begin, end) of the outer fragment processed by a kernel. An empty range stands
+// for all the rows of the fragment.
+struct RowRange {
+  size_t begin;
+  size_t end;
+
+  bool empty() const { return begin == end; }
+};
+
+// A slice of the outer fragment of a kernel, executed as a unit of work in morsel mode.
+struct FragmentMorsel {
+  int device_id;
+  FragmentsList frag_list;
+  RowRange rows;
+};
+
 class QueryFragmentDescriptor {
  public:
   QueryFragmentDescriptor(const RelAlgExecutionUnit& ra_exe_unit,
@@ -64,16 +80,19 @@ class QueryFragmentDescriptor {
                               const ExecutorDeviceType& device_type,
                               const bool enable_multifrag_kernels,
                               const bool enable_inner_join_fragment_skipping,
-                              Executor* executor);
+                              Executor* executor,
+                              const size_t gpu_wave_bytes = 0);
 
   template <typename DISPATCH_FCN>
   void assignFragsToMultiDispatch(DISPATCH_FCN f) const {
     for (const auto& kv : kernels_per_device_) {
-      CHECK_EQ(kv.second.size(), size_t(1));
-      const auto kernel_id = *kv.second.begin();
-      CHECK_LT(kernel_id, fragments_per_kernel_.size());
+      // More than one kernel per device with GPU waves and on CPU, see
+      // buildMultifragKernelMap.
+      for (const auto kernel_id : kv.second) {
+        CHECK_LT(kernel_id, fragments_per_kernel_.size());
 
-      f(kv.first, fragments_per_kernel_[kernel_id], rowid_lookup_key_);
+        f(kv.first, fragments_per_kernel_[kernel_id], rowid_lookup_key_);
+      }
     }
   }
 
@@ -94,6 +113,11 @@ class QueryFragmentDescriptor {
     }
   }
 
+  // Splits the outer fragment of every kernel in ranges of at most morsel_size rows.
+  std::vector<FragmentMorsel> buildMorsels(const size_t morsel_size) const;
+
+  bool hasRowidLookup() const { return rowid_lookup_key_ >= 0; }
+
   bool shouldCheckWorkUnitWatchdog() const {
     return rowid_lookup_key_ < 0 && fragments_per_kernel_.size() > 0;
   }
@@ -107,6 +131,20 @@ class QueryFragmentDescriptor {
   std::vector<FragmentsList> fragments_per_kernel_;
   std::map<int, std::set<size_t>> kernels_per_device_;
   std::vector<size_t> outer_fragment_tuple_sizes_;
+  // GPU chosen for each of the outer fragments, -1 to keep the one of the fragmenter.
+  std::vector<int> outer_fragment_gpus_;
+
+  // Places the outer fragments on the GPUs which already hold the most of their input
+  // columns, then spreads the others by free memory, each device taking no more than
+  // its share of the rows unless none can.
+  void computeGpuPlacement(const RelAlgExecutionUnit& ra_exe_unit,
+                           const TableFragments& outer_fragments,
+                           const int device_count,
+                           Executor* executor);
+
+  int getGpuForFragment(const Fragmenter_Namespace::FragmentInfo& fragment,
+                        const size_t outer_frag_id,
+                        const int device_count) const;
 
   void buildFragmentPerKernelMap(const RelAlgExecutionUnit& ra_exe_unit,
                                  const std::vector<uint64_t>& frag_offsets,
@@ -119,7 +157,8 @@ class QueryFragmentDescriptor {
                                const int device_count,
                                const ExecutorDeviceType& device_type,
                                const bool enable_inner_join_fragment_skipping,
-                               Executor* executor);
+                               Executor* executor,
+                               const size_t gpu_wave_bytes);
 
   const size_t getOuterFragmentTupleSize(const size_t frag_index) const {
     if (frag_index < outer_fragment_tuple_sizes_.size()) {
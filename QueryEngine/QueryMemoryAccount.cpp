@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QueryMemoryAccount.h"
+#include "Execute.h"
+
+#include "../DataMgr/BufferMgr/BufferMgr.h"
+#include "../Shared/checked_alloc.h"
+
+#include <glog/logging.h>
+
+#include <string>
+
+std::atomic<bool> QueryMemoryAccount::open_{false};
+std::atomic<bool> QueryMemoryAccount::cpu_limit_exceeded_{false};
+std::atomic<size_t> QueryMemoryAccount::cpu_bytes_{0};
+std::atomic<size_t> QueryMemoryAccount::gpu_bytes_{0};
+std::atomic<size_t> QueryMemoryAccount::gpu_peak_bytes_{0};
+
+QueryMemoryAccount::Scope::Scope() {
+  cpu_limit_exceeded_ = false;
+  cpu_bytes_ = 0;
+  gpu_bytes_ = 0;
+  gpu_peak_bytes_ = 0;
+  open_ = true;
+}
+
+QueryMemoryAccount::Scope::~Scope() {
+  open_ = false;
+  VLOG(1) << "Query memory: " << cpu_bytes_ << " CPU bytes, " << gpu_peak_bytes_
+          << " GPU bytes at peak";
+}
+
+void QueryMemoryAccount::charge(const ExecutorDeviceType device_type,
+                                const size_t num_bytes) {
+  if (!open_) {
+    return;
+  }
+  if (device_type == ExecutorDeviceType::CPU) {
+    const size_t bytes = cpu_bytes_ += num_bytes;
+    if (g_query_cpu_memory_limit_bytes && bytes > g_query_cpu_memory_limit_bytes) {
+      cpu_bytes_ -= num_bytes;
+      cpu_limit_exceeded_ = true;
+      throw OutOfHostMemory(num_bytes);
+    }
+    return;
+  }
+  const size_t bytes = gpu_bytes_ += num_bytes;
+  if (g_query_gpu_memory_limit_bytes && bytes > g_query_gpu_memory_limit_bytes) {
+    gpu_bytes_ -= num_bytes;
+    throw OutOfMemory("Query GPU memory limit of " +
+                      std::to_string(g_query_gpu_memory_limit_bytes) +
+                      " bytes exceeded");
+  }
+  auto peak_bytes = gpu_peak_bytes_.load();
+  while (bytes > peak_bytes &&
+         !gpu_peak_bytes_.compare_exchange_weak(peak_bytes, bytes)) {
+  }
+}
+
+void QueryMemoryAccount::releaseGpuBuffers() {
+  gpu_bytes_ = 0;
+}
+
+bool QueryMemoryAccount::cpuLimitExceeded() {
+  return cpu_limit_exceeded_;
+}
+
+size_t QueryMemoryAccount::getPeakBytes(const ExecutorDeviceType device_type) {
+  return device_type == ExecutorDeviceType::CPU ? cpu_bytes_.load()
+                                                : gpu_peak_bytes_.load();
+}
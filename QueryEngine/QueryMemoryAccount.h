@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QueryMemoryAccount.h
+ * @brief   Memory taken by the buffers of the running query, against per query limits.
+ *
+ * A query with a huge group by or join could take most of the memory, the queries after
+ * it then failed and got their chunks and cached hash tables evicted. The output buffers,
+ * count distinct bitmaps and join hash tables of the query being executed are charged to
+ * its account. Past the GPU limit, an allocation fails like the GPU running out of memory
+ * and the query moves on to the CPU. Past the CPU limit, it fails like the host running
+ * out of memory: the group by gets partitioned when it can be, otherwise the query fails
+ * without evicting the caches of the others.
+ */
+
+#ifndef QUERYENGINE_QUERYMEMORYACCOUNT_H
+#define QUERYENGINE_QUERYMEMORYACCOUNT_H
+
+#include "CompilationOptions.h"
+
+#include <atomic>
+#include <cstddef>
+
+class QueryMemoryAccount {
+ public:
+  // Opened by the query admitted to the executor, the queries run one at a time. The
+  // buffers allocated outside of it, by the loads or the legacy path, aren't charged.
+  class Scope {
+   public:
+    Scope();
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  // Throws the out of memory error of the device if the query goes past its limit.
+  static void charge(const ExecutorDeviceType device_type, const size_t num_bytes);
+
+  // The temporary GPU buffers of a step are all freed at its end.
+  static void releaseGpuBuffers();
+
+  // Whether the last out of host memory error came from the limit of the query.
+  static bool cpuLimitExceeded();
+
+  // Of the running query, or of the last one once it's done.
+  static size_t getPeakBytes(const ExecutorDeviceType device_type);
+
+ private:
+  static std::atomic<bool> open_;
+  static std::atomic<bool> cpu_limit_exceeded_;
+  // The CPU buffers are owned by the result sets, they're held until the query is done.
+  static std::atomic<size_t> cpu_bytes_;
+  static std::atomic<size_t> gpu_bytes_;
+  static std::atomic<size_t> gpu_peak_bytes_;
+};
+
+#endif  // QUERYENGINE_QUERYMEMORYACCOUNT_H
@@ -55,6 +55,45 @@ std::vector<ssize_t> target_expr_group_by_indices(
   return indices;
 }
 
+// The mask of the slots which hold a COUNT or a SUM, the slots to add up when merging
+// the buffers of the blocks, if the rows of the group by are made of one 64-bit slot
+// per target and all the aggregates can be added up. Returns 0 otherwise.
+uint64_t smem_agg_slot_mask(const std::vector<Analyzer::Expr*>& target_exprs,
+                            const std::vector<ColWidths>& agg_col_widths) {
+  if (target_exprs.size() != agg_col_widths.size() ||
+      target_exprs.size() > sizeof(uint64_t) * 8) {
+    return 0;
+  }
+  uint64_t mask{0};
+  for (size_t target_idx = 0; target_idx < target_exprs.size(); ++target_idx) {
+    if (agg_col_widths[target_idx].compact != sizeof(int64_t)) {
+      return 0;
+    }
+    const auto target_expr = target_exprs[target_idx];
+    const auto agg_info = target_info(target_expr);
+    if (!agg_info.is_agg) {
+      // Group by columns, stored as they are once the group has been hit.
+      const auto& ti = target_expr->get_type_info();
+      if (!ti.is_integer() &&
+          !(ti.is_string() && ti.get_compression() == kENCODING_DICT)) {
+        return 0;
+      }
+      continue;
+    }
+    // Accumulating from zero in shared memory must give the same result, which rules
+    // out the aggregates skipping nulls.
+    if (agg_info.is_distinct || agg_info.skip_null_val) {
+      return 0;
+    }
+    if (agg_info.agg_kind != kCOUNT &&
+        !(agg_info.agg_kind == kSUM && agg_info.agg_arg_type.is_integer())) {
+      return 0;
+    }
+    mask |= uint64_t(1) << target_idx;
+  }
+  return mask;
+}
+
 class UsedColumnsVisitor : public ScalarExprVisitor<std::unordered_set<int>> {
  protected:
   virtual std::unordered_set<int> visitColumnVar(
@@ -192,7 +231,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
     , output_columnar_(false)
     , render_output_(false)
     , must_use_baseline_sort_(must_use_baseline_sort)
-    , force_4byte_float_(false) {
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {
   // Constructor for non-group by queries
   CHECK(!is_group_by);
 
@@ -245,7 +285,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
     , output_columnar_(false)
     , render_output_(false)
     , must_use_baseline_sort_(must_use_baseline_sort)
-    , force_4byte_float_(false) {
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {
   // Constructor for group by queries
   CHECK(!group_col_widths.empty());
 
@@ -286,6 +327,7 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
       const size_t interleaved_max_threshold{512};
 
       size_t gpu_smem_max_threshold{0};
+      size_t gpu_smem_max_bytes{0};
       if (group_by_and_agg->device_type_ == ExecutorDeviceType::GPU) {
         const auto cuda_manager = executor_->getCatalog()->get_dataMgr().cudaMgr_;
         CHECK(cuda_manager);
@@ -304,6 +346,7 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
           gpu_smem_max_threshold =
               std::min((cuda_manager->isArchVoltaForAll()) ? 4095LU : 2047LU,
                        (cuda_manager->maxSharedMemoryForAll / sizeof(int64_t) - 1));
+          gpu_smem_max_bytes = cuda_manager->maxSharedMemoryForAll;
         }
       }
 
@@ -317,14 +360,15 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
         }
       }
       const auto group_expr = ra_exe_unit.groupby_exprs.front().get();
-      bool shared_mem_for_group_by =
-          g_enable_smem_group_by && keyless_hash_ && keyless_info.shared_mem_support &&
+      const bool smem_candidate =
+          g_enable_smem_group_by && keyless_hash_ &&
           (entry_count_ <= gpu_smem_max_threshold) &&
           (group_by_and_agg->supportedExprForGpuSharedMemUsage(group_expr)) &&
           QueryMemoryDescriptor::countDescriptorsLogicallyEmpty(
               count_distinct_descriptors) &&
           !output_columnar_;  // TODO(Saman): add columnar support with the new smem
                               // support.
+      bool shared_mem_for_group_by = smem_candidate && keyless_info.shared_mem_support;
 
       bool has_varlen_sample_agg = false;
       for (const auto& target_expr : ra_exe_unit.target_exprs) {
@@ -347,6 +391,16 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
         // GroupByMemSharing
         sharing_ = GroupByMemSharing::SharedForKeylessOneColumnKnownRange;
         interleaved_bins_on_gpu_ = false;
+      } else if (smem_candidate && init_val_ == 0 &&
+                 (entry_count_ + 1) * getRowSize() <= gpu_smem_max_bytes &&
+                 smem_agg_slot_mask(ra_exe_unit.target_exprs, agg_col_widths_)) {
+        // Every block accumulates its COUNT and SUM aggregates in its own buffer in
+        // shared memory and adds them to the global buffer when done, instead of all
+        // the threads contending on the atomics of the global buffer.
+        smem_agg_slot_mask_ =
+            smem_agg_slot_mask(ra_exe_unit.target_exprs, agg_col_widths_);
+        sharing_ = GroupByMemSharing::SharedForKeylessOneColumnKnownRange;
+        interleaved_bins_on_gpu_ = false;
       } else {
         interleaved_bins_on_gpu_ = keyless_hash_ && !has_varlen_sample_agg &&
                                    (entry_count_ <= interleaved_max_threshold) &&
@@ -442,7 +496,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor()
     , output_columnar_(false)
     , render_output_(false)
     , must_use_baseline_sort_(false)
-    , force_4byte_float_(false) {}
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {}
 
 QueryMemoryDescriptor::QueryMemoryDescriptor(const Executor* executor,
                                              const size_t entry_count,
@@ -465,7 +520,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(const Executor* executor,
     , output_columnar_(false)
     , render_output_(false)
     , must_use_baseline_sort_(false)
-    , force_4byte_float_(false) {}
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {}
 
 QueryMemoryDescriptor::QueryMemoryDescriptor(const QueryDescriptionType query_desc_type,
                                              const int64_t min_val,
@@ -491,7 +547,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(const QueryDescriptionType query_de
     , output_columnar_(false)
     , render_output_(false)
     , must_use_baseline_sort_(false)
-    , force_4byte_float_(false) {}
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {}
 
 QueryMemoryDescriptor::QueryMemoryDescriptor(
     const Executor* executor,
@@ -542,7 +599,8 @@ QueryMemoryDescriptor::QueryMemoryDescriptor(
     , key_column_pad_bytes_(key_column_pad_bytes)
     , target_column_pad_bytes_(target_column_pad_bytes)
     , must_use_baseline_sort_(must_use_baseline_sort)
-    , force_4byte_float_(false) {}
+    , force_4byte_float_(false)
+    , smem_agg_slot_mask_(0) {}
 
 bool QueryMemoryDescriptor::operator==(const QueryMemoryDescriptor& other) const {
   // Note that this method does not check ptr reference members (e.g. executor_) or
@@ -565,6 +623,9 @@ bool QueryMemoryDescriptor::operator==(const QueryMemoryDescriptor& other) const
   if (force_4byte_float_ != other.force_4byte_float_) {
     return false;
   }
+  if (smem_agg_slot_mask_ != other.smem_agg_slot_mask_) {
+    return false;
+  }
   if (group_col_widths_ != other.group_col_widths_) {
     return false;
   }
@@ -1001,6 +1062,11 @@ bool QueryMemoryDescriptor::threadsShareMemory() const {
   return query_desc_type_ != QueryDescriptionType::NonGroupedAggregate;
 }
 
+uint64_t QueryMemoryDescriptor::getSumAggSlotMask(
+    const std::vector<Analyzer::Expr*>& target_exprs) const {
+  return smem_agg_slot_mask(target_exprs, agg_col_widths_);
+}
+
 bool QueryMemoryDescriptor::blocksShareMemory() const {
   if (g_cluster) {
     return true;
@@ -1035,10 +1101,12 @@ size_t QueryMemoryDescriptor::sharedMemBytes(const ExecutorDeviceType device_typ
   }
   // if performing keyless aggregate query with a single column group-by:
   if (sharing_ == GroupByMemSharing::SharedForKeylessOneColumnKnownRange) {
-    CHECK_EQ(getRowSize(),
-             sizeof(int64_t));  // Currently just designed for this scenario
+    if (!smem_agg_slot_mask_) {
+      CHECK_EQ(getRowSize(),
+               sizeof(int64_t));  // Currently just designed for this scenario
+    }
     size_t shared_mem_size =
-        (/*bin_count=*/entry_count_ + 1) * sizeof(int64_t);  // one extra for NULL values
+        (/*bin_count=*/entry_count_ + 1) * getRowSize();  // one extra for NULL values
     CHECK(shared_mem_size <=
           executor_->getCatalog()->get_dataMgr().cudaMgr_->maxSharedMemoryForAll);
     return shared_mem_size;
@@ -274,6 +274,13 @@ class QueryMemoryDescriptor {
   GroupByMemSharing getGpuMemSharing() const { return sharing_; }
   void setGpuMemSharing(const GroupByMemSharing val) { sharing_ = val; }
 
+  // Non-zero if the shared memory rows are made of one 64-bit slot per target, the bit
+  // of a target is set if its slot holds an aggregate to add up across the blocks.
+  uint64_t getSharedMemAggSlotMask() const { return smem_agg_slot_mask_; }
+
+  // Same as above for the rows of the group by buffer, whichever memory it's in.
+  uint64_t getSumAggSlotMask(const std::vector<Analyzer::Expr*>& target_exprs) const;
+
   const CountDistinctDescriptor getCountDistinctDescriptor(const size_t idx) const {
     CHECK_LT(idx, count_distinct_descriptors_.size());
     return count_distinct_descriptors_[idx];
@@ -400,6 +407,8 @@ class QueryMemoryDescriptor {
 
   bool force_4byte_float_;
 
+  uint64_t smem_agg_slot_mask_;
+
   size_t getTotalBytesOfColumnarBuffers(const std::vector<ColWidths>& col_widths) const;
 
   friend class ResultSet;
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QueryProfile.h"
+#include "Shared/Metrics.h"
+
+#include <iomanip>
+#include <sstream>
+
+QueryProfile::QueryProfile() {
+  for (auto& us : phase_us_) {
+    us = 0;
+  }
+  for (size_t i = 0; i < 2; ++i) {
+    fetched_bytes_[i] = 0;
+    kernel_count_[i] = 0;
+    code_cache_lookups_[i] = 0;
+    peak_bytes_[i] = 0;
+  }
+  scanned_rows_ = 0;
+  fragment_count_ = 0;
+  skipped_fragment_count_ = 0;
+  step_ = 0;
+}
+
+void QueryProfile::setCpuRetryReason(const std::string& reason) {
+  std::lock_guard<std::mutex> lock(instrumentation_mutex_);
+  cpu_retry_reason_ = reason;
+}
+
+std::string QueryProfile::getCpuRetryReason() const {
+  std::lock_guard<std::mutex> lock(instrumentation_mutex_);
+  return cpu_retry_reason_;
+}
+
+void QueryProfile::addGpuKernelEventTime(const int device_id, const float ms) {
+  std::lock_guard<std::mutex> lock(instrumentation_mutex_);
+  auto& events = gpu_kernel_events_[std::make_pair(step_.load(), device_id)];
+  events.ms += ms;
+  ++events.launch_count;
+}
+
+void QueryProfile::addCpuKernelCounters(const PerfEventCounters::Values& values) {
+  std::lock_guard<std::mutex> lock(instrumentation_mutex_);
+  auto& counters = cpu_kernel_counters_[step_];
+  counters.values.cycles += values.cycles;
+  counters.values.llc_misses += values.llc_misses;
+  counters.values.branch_misses += values.branch_misses;
+  ++counters.launch_count;
+}
+
+const char* QueryProfile::getPhaseName(const Phase phase) {
+  static const char* phase_names[kPhaseCount]{"calcite",
+                                              "queue",
+                                              "compilation",
+                                              "cpu_fetch",
+                                              "gpu_fetch",
+                                              "cpu_kernel",
+                                              "gpu_kernel",
+                                              "reduction",
+                                              "sort",
+                                              "result_conversion"};
+  return phase_names[idx(phase)];
+}
+
+void QueryProfile::recordMetrics() const {
+  static const auto histograms = [] {
+    std::array<metrics::Histogram*, kPhaseCount> histograms;
+    for (size_t i = 0; i < kPhaseCount; ++i) {
+      histograms[i] = &metrics::Registry::get().histogram(
+          "mapd_query_phase_latency_ms",
+          "Time spent by the queries in each phase, summed over the kernel threads",
+          std::string("phase=\"") + getPhaseName(static_cast<Phase>(i)) + "\"");
+    }
+    return histograms;
+  }();
+  for (size_t i = 0; i < kPhaseCount; ++i) {
+    histograms[i]->observe(phase_us_[i] / 1000.);
+  }
+}
+
+std::string QueryProfile::toString() const {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  const auto ms = [this](const Phase phase) { return phase_us_[idx(phase)] / 1000.; };
+  oss << "Calcite: " << ms(Phase::Calcite) << " ms\n";
+  oss << "Queue: " << ms(Phase::Queue) << " ms\n";
+  oss << "Compilation: " << ms(Phase::Compilation) << " ms\n";
+  oss << "Chunk fetch CPU: " << ms(Phase::CpuFetch) << " ms, " << fetched_bytes_[0]
+      << " bytes\n";
+  oss << "Chunk fetch GPU: " << ms(Phase::GpuFetch) << " ms, " << fetched_bytes_[1]
+      << " bytes\n";
+  oss << "Kernels CPU: " << ms(Phase::CpuKernel) << " ms, " << kernel_count_[0]
+      << " kernels\n";
+  oss << "Kernels GPU: " << ms(Phase::GpuKernel) << " ms, " << kernel_count_[1]
+      << " kernels\n";
+  oss << "Reduction: " << ms(Phase::Reduction) << " ms\n";
+  oss << "Sort: " << ms(Phase::Sort) << " ms\n";
+  oss << "Result conversion: " << ms(Phase::ResultConversion) << " ms";
+  std::lock_guard<std::mutex> lock(instrumentation_mutex_);
+  for (const auto& kv : gpu_kernel_events_) {
+    oss << "\nStep " << kv.first.first << " GPU " << kv.first.second << ": "
+        << kv.second.ms << " ms, " << kv.second.launch_count << " kernels";
+  }
+  for (const auto& kv : cpu_kernel_counters_) {
+    const auto& values = kv.second.values;
+    oss << "\nStep " << kv.first << " CPU: " << kv.second.launch_count << " kernels, "
+        << values.cycles << " cycles, " << values.llc_misses << " LLC misses, "
+        << values.branch_misses << " branch misses";
+  }
+  return oss.str();
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QueryProfile.h
+ * @brief   Time spent by a query in each of the phases of its execution.
+ *
+ * The phases run by the kernel threads add to the same profile concurrently, their
+ * times are therefore the sum over the threads rather than wall clock time.
+ */
+
+#ifndef QUERYENGINE_QUERYPROFILE_H
+#define QUERYENGINE_QUERYPROFILE_H
+
+#include "CompilationOptions.h"
+#include "PerfEventCounters.h"
+#include "Shared/Tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+class QueryProfile {
+ public:
+  enum class Phase {
+    Calcite,
+    Queue,
+    Compilation,
+    CpuFetch,
+    GpuFetch,
+    CpuKernel,
+    GpuKernel,
+    Reduction,
+    Sort,
+    ResultConversion
+  };
+
+  QueryProfile();
+
+  void addTime(const Phase phase, const int64_t us) { phase_us_[idx(phase)] += us; }
+
+  void addFetchedBytes(const ExecutorDeviceType device_type, const size_t num_bytes) {
+    fetched_bytes_[device_type == ExecutorDeviceType::GPU] += num_bytes;
+  }
+
+  void addKernel(const ExecutorDeviceType device_type) {
+    ++kernel_count_[device_type == ExecutorDeviceType::GPU];
+  }
+
+  void addScannedRows(const size_t row_count) { scanned_rows_ += row_count; }
+
+  // Of the outer table of a step, the skipped ones ruled out by the chunk stats.
+  void addFragments(const size_t fragment_count, const size_t skipped_count) {
+    fragment_count_ += fragment_count;
+    skipped_fragment_count_ += skipped_count;
+  }
+
+  void addCodeCacheLookup(const bool hit) { ++code_cache_lookups_[hit]; }
+
+  // Why the query, or one of its steps, went from the GPU to the CPU.
+  void setCpuRetryReason(const std::string& reason);
+
+  void setPeakBytes(const ExecutorDeviceType device_type, const size_t num_bytes) {
+    auto& peak_bytes = peak_bytes_[device_type == ExecutorDeviceType::GPU];
+    peak_bytes = std::max(peak_bytes.load(), num_bytes);
+  }
+
+  // The kernel instrumentation below is attributed to the step of the relational
+  // algebra sequence which is executing, identified by the id of its node.
+  void setStep(const unsigned node_id) { step_ = node_id; }
+
+  void addGpuKernelEventTime(const int device_id, const float ms);
+
+  void addCpuKernelCounters(const PerfEventCounters::Values& values);
+
+  // Adds the time of each phase to its latency histogram in the metrics registry.
+  void recordMetrics() const;
+
+  int64_t getTimeUs(const Phase phase) const { return phase_us_[idx(phase)]; }
+
+  size_t getFetchedBytes(const ExecutorDeviceType device_type) const {
+    return fetched_bytes_[device_type == ExecutorDeviceType::GPU];
+  }
+
+  size_t getKernelCount(const ExecutorDeviceType device_type) const {
+    return kernel_count_[device_type == ExecutorDeviceType::GPU];
+  }
+
+  size_t getScannedRows() const { return scanned_rows_; }
+
+  size_t getFragmentCount() const { return fragment_count_; }
+
+  size_t getSkippedFragmentCount() const { return skipped_fragment_count_; }
+
+  size_t getCodeCacheLookups(const bool hit) const { return code_cache_lookups_[hit]; }
+
+  std::string getCpuRetryReason() const;
+
+  size_t getPeakBytes(const ExecutorDeviceType device_type) const {
+    return peak_bytes_[device_type == ExecutorDeviceType::GPU];
+  }
+
+  // One line per phase, in the order of the execution, followed by the kernel
+  // instrumentation of each step, if any.
+  std::string toString() const;
+
+  static const char* getPhaseName(const Phase phase);
+
+  // Adds the time elapsed during its scope to the phase, if there is a profile. Also a
+  // span of the trace of the query on the threads of the query itself.
+  class Timer {
+   public:
+    Timer(QueryProfile* profile, const Phase phase)
+        : profile_(profile)
+        , phase_(phase)
+        , start_(std::chrono::steady_clock::now())
+        , span_(getPhaseName(phase)) {}
+
+    ~Timer() {
+      if (profile_) {
+        profile_->addTime(phase_,
+                          std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - start_)
+                              .count());
+      }
+    }
+
+   private:
+    QueryProfile* profile_;
+    const Phase phase_;
+    const std::chrono::steady_clock::time_point start_;
+    tracing::Span span_;
+  };
+
+ private:
+  static constexpr size_t kPhaseCount{static_cast<size_t>(Phase::ResultConversion) + 1};
+
+  static size_t idx(const Phase phase) { return static_cast<size_t>(phase); }
+
+  std::array<std::atomic<int64_t>, kPhaseCount> phase_us_;
+  std::array<std::atomic<size_t>, 2> fetched_bytes_;
+  std::array<std::atomic<size_t>, 2> kernel_count_;
+  std::atomic<size_t> scanned_rows_;
+  std::atomic<size_t> fragment_count_;
+  std::atomic<size_t> skipped_fragment_count_;
+  // Indexed by whether the lookup was a hit.
+  std::array<std::atomic<size_t>, 2> code_cache_lookups_;
+  // Set once the query is done with the executor, by its thread.
+  std::array<std::atomic<size_t>, 2> peak_bytes_;
+
+  struct GpuKernelEvents {
+    float ms{0};
+    size_t launch_count{0};
+  };
+
+  struct CpuKernelCounters {
+    PerfEventCounters::Values values;
+    size_t launch_count{0};
+  };
+
+  std::atomic<unsigned> step_;
+  mutable std::mutex instrumentation_mutex_;
+  std::map<std::pair<unsigned, int>, GpuKernelEvents> gpu_kernel_events_;
+  std::map<unsigned, CpuKernelCounters> cpu_kernel_counters_;
+  std::string cpu_retry_reason_;
+};
+
+#endif  // QUERYENGINE_QUERYPROFILE_H
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QueryResultCache.h"
+#include "Execute.h"
+#include "ResultSet.h"
+
+#include <algorithm>
+
+QueryResultCacheKey::QueryResultCacheKey(
+    const int db_id,
+    const std::string& query_ra,
+    const bool output_columnar,
+    const TableGenerations& table_generations,
+    const StringDictionaryGenerations& string_dictionary_generations)
+    : db_id(db_id), query_ra(query_ra), output_columnar(output_columnar) {
+  for (const auto& kv : table_generations.asMap()) {
+    this->table_generations.emplace_back(
+        kv.first, kv.second.tuple_count, kv.second.start_rowid);
+  }
+  std::sort(this->table_generations.begin(), this->table_generations.end());
+  for (const auto& kv : string_dictionary_generations.asMap()) {
+    this->string_dictionary_generations.emplace_back(kv.first, kv.second);
+  }
+  std::sort(this->string_dictionary_generations.begin(),
+            this->string_dictionary_generations.end());
+}
+
+JoinHashTableCache<QueryResultCacheKey, QueryResultCache::CachedResult>
+    QueryResultCache::result_cache_(g_query_result_cache_max_bytes);
+
+bool QueryResultCache::isCacheable(const std::string& query_ra) {
+  // NOW() and the 'now' literals are evaluated at execution time, the table
+  // modifications are the updates and deletes going through Calcite.
+  return query_ra.find("\"NOW\"") == std::string::npos &&
+         query_ra.find("\"now\"") == std::string::npos &&
+         query_ra.find("LogicalTableModify") == std::string::npos;
+}
+
+boost::optional<QueryResultCache::CachedResult> QueryResultCache::get(
+    const QueryResultCacheKey& key) {
+  auto cached = result_cache_.get(
+      key, [](const CachedResult& result) { return result.rows.use_count() == 1; });
+  if (cached) {
+    cached->rows->moveToBegin();
+    cached->rows->setQueueTime(0);
+  }
+  return cached;
+}
+
+void QueryResultCache::put(const QueryResultCacheKey& key, const CachedResult& result) {
+  CHECK(result.rows);
+  if (!result.rows->getStorage()) {
+    return;
+  }
+  result_cache_.put(key,
+                    result,
+                    result.rows->getBufferSizeBytes(ExecutorDeviceType::CPU) +
+                        key.query_ra.size());
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QueryResultCache.h
+ * @brief   Cache of the final results of the queries, shared across sessions.
+ *
+ * Dashboards issue the same queries over and over again. The results are keyed by the
+ * serialized relational algebra plan and the generations of the tables and string
+ * dictionaries it reads, so that appends miss the stale entries. Updates and deletes
+ * don't change the generations and clear the cache through the update invalidators.
+ */
+
+#ifndef QUERYENGINE_QUERYRESULTCACHE_H
+#define QUERYENGINE_QUERYRESULTCACHE_H
+
+#include "JoinHashTableCache.h"
+#include "StringDictionaryGenerations.h"
+#include "TableGenerations.h"
+#include "TargetMetaInfo.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+class ResultSet;
+
+struct QueryResultCacheKey {
+  int db_id;
+  std::string query_ra;
+  bool output_columnar;
+  // Sorted by id: (table id, tuple count, start row id).
+  std::vector<std::tuple<uint32_t, size_t, size_t>> table_generations;
+  // Sorted by id: (dictionary id, entry count).
+  std::vector<std::pair<uint32_t, size_t>> string_dictionary_generations;
+
+  QueryResultCacheKey(const int db_id,
+                      const std::string& query_ra,
+                      const bool output_columnar,
+                      const TableGenerations& table_generations,
+                      const StringDictionaryGenerations& string_dictionary_generations);
+
+  bool operator==(const QueryResultCacheKey& that) const {
+    return db_id == that.db_id && output_columnar == that.output_columnar &&
+           table_generations == that.table_generations &&
+           string_dictionary_generations == that.string_dictionary_generations &&
+           query_ra == that.query_ra;
+  }
+};
+
+class QueryResultCache {
+ public:
+  struct CachedResult {
+    std::shared_ptr<ResultSet> rows;
+    std::vector<TargetMetaInfo> targets_meta;
+  };
+
+  // Whether the result of the plan only depends on the data it reads.
+  static bool isCacheable(const std::string& query_ra);
+
+  // The result set iterates through a cursor of its own, an entry still held by the
+  // session which produced or last got it is reported as a miss.
+  static boost::optional<CachedResult> get(const QueryResultCacheKey& key);
+
+  static void put(const QueryResultCacheKey& key, const CachedResult& result);
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void { result_cache_.clear(); };
+  }
+
+  static JoinHashTableCacheStats getCacheStats() { return result_cache_.getStats(); }
+
+ private:
+  static JoinHashTableCache<QueryResultCacheKey, CachedResult> result_cache_;
+};
+
+#endif  // QUERYENGINE_QUERYRESULTCACHE_H
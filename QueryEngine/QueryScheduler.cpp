@@ -0,0 +1,55 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "QueryScheduler.h"
+#include "Execute.h"
+
+std::mutex QueryScheduler::queue_mutex_;
+std::condition_variable QueryScheduler::queue_cv_;
+std::set<QueryScheduler::Ticket> QueryScheduler::waiting_;
+uint64_t QueryScheduler::next_seq_{0};
+bool QueryScheduler::running_{false};
+
+QueryPriority QueryScheduler::classify(const size_t input_bytes) {
+  return input_bytes <= g_interactive_query_max_input_bytes ? QueryPriority::Interactive
+                                                            : QueryPriority::Batch;
+}
+
+QueryScheduler::Admission::Admission(std::mutex& execute_mutex,
+                                     const QueryPriority priority)
+    : execute_mutex_(execute_mutex) {
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  const auto delay = priority == QueryPriority::Batch
+                         ? std::chrono::milliseconds(g_batch_query_max_delay_ms)
+                         : std::chrono::milliseconds(0);
+  const Ticket ticket{Clock::now() + delay, next_seq_++};
+  waiting_.insert(ticket);
+  queue_cv_.wait(lock, [&ticket] { return !running_ && *waiting_.begin() == ticket; });
+  waiting_.erase(waiting_.begin());
+  running_ = true;
+  lock.unlock();
+  // Still taken directly by the legacy path and the flush of the executors.
+  execute_mutex_.lock();
+}
+
+QueryScheduler::Admission::~Admission() {
+  execute_mutex_.unlock();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    running_ = false;
+  }
+  queue_cv_.notify_all();
+}
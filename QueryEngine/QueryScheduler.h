@@ -0,0 +1,71 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QueryScheduler.h
+ * @brief   Order in which the queued queries get to execute.
+ *
+ * The queries run one at a time under the executor mutex. Instead of granting it in
+ * whatever order the waiting threads wake up, the queries are admitted by earliest
+ * deadline: an interactive query, which reads few enough bytes, is due as soon as it
+ * arrives while a batch query is due after a grace delay. Small dashboard queries thus
+ * overtake the large ones queued shortly before them, and a batch query can't starve.
+ */
+
+#ifndef QUERYENGINE_QUERYSCHEDULER_H
+#define QUERYENGINE_QUERYSCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <utility>
+
+enum class QueryPriority { Interactive, Batch };
+
+class QueryScheduler {
+ public:
+  // Classifies the query by the estimated number of bytes of the columns it reads.
+  static QueryPriority classify(const size_t input_bytes);
+
+  // Waits for the turn of the query, then holds the given mutex until destroyed.
+  class Admission {
+   public:
+    Admission(std::mutex& execute_mutex, const QueryPriority priority);
+    ~Admission();
+
+    Admission(const Admission&) = delete;
+    Admission& operator=(const Admission&) = delete;
+
+   private:
+    std::mutex& execute_mutex_;
+  };
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  // Deadline, then arrival order among the equal deadlines.
+  using Ticket = std::pair<Clock::time_point, uint64_t>;
+
+  static std::mutex queue_mutex_;
+  static std::condition_variable queue_cv_;
+  static std::set<Ticket> waiting_;
+  static uint64_t next_seq_;
+  static bool running_;
+};
+
+#endif  // QUERYENGINE_QUERYSCHEDULER_H
@@ -27,6 +27,9 @@
 
 namespace {
 
+// Rows per batch of the batched filter loop, which is also the selection vector size.
+constexpr size_t kFilterBatchSize{1024};
+
 template <class Attributes>
 llvm::Function* default_func_builder(llvm::Module* mod, const std::string& name) {
   using namespace llvm;
@@ -115,7 +118,8 @@ template <class Attributes>
 llvm::Function* row_process(llvm::Module* mod,
                             const size_t aggr_col_count,
                             const bool is_nested,
-                            const bool hoist_literals) {
+                            const bool hoist_literals,
+                            const bool batched_filter) {
   using namespace llvm;
 
   std::vector<Type*> func_args;
@@ -142,6 +146,9 @@ llvm::Function* row_process(llvm::Module* mod,
   func_args.push_back(i64_type);
   func_args.push_back(pi64_type);
   func_args.push_back(pi64_type);
+  if (batched_filter) {
+    func_args.push_back(i32_type);  // 1 iff only the filter should be evaluated
+  }
   if (hoist_literals) {
     func_args.push_back(PointerType::get(i8_type, 0));
   }
@@ -186,7 +193,8 @@ llvm::Function* query_template_impl(llvm::Module* mod,
                                     const size_t aggr_col_count,
                                     const bool is_nested,
                                     const bool hoist_literals,
-                                    const bool is_estimate_query) {
+                                    const bool is_estimate_query,
+                                    const bool batched_filter) {
   using namespace llvm;
 
   auto func_pos_start = pos_start<Attributes>(mod);
@@ -195,8 +203,11 @@ llvm::Function* query_template_impl(llvm::Module* mod,
   CHECK(func_pos_step);
   auto func_group_buff_idx = group_buff_idx<Attributes>(mod);
   CHECK(func_group_buff_idx);
-  auto func_row_process = row_process<Attributes>(
-      mod, is_estimate_query ? 1 : aggr_col_count, is_nested, hoist_literals);
+  auto func_row_process = row_process<Attributes>(mod,
+                                                  is_estimate_query ? 1 : aggr_col_count,
+                                                  is_nested,
+                                                  hoist_literals,
+                                                  batched_filter);
   CHECK(func_row_process);
 
   auto i8_type = IntegerType::get(mod->getContext(), 8);
@@ -310,7 +321,10 @@ llvm::Function* query_template_impl(llvm::Module* mod,
   auto bb_entry = BasicBlock::Create(mod->getContext(), ".entry", query_func_ptr, 0);
   auto bb_preheader =
       BasicBlock::Create(mod->getContext(), ".loop.preheader", query_func_ptr, 0);
-  auto bb_forbody = BasicBlock::Create(mod->getContext(), ".for.body", query_func_ptr, 0);
+  auto bb_forbody =
+      batched_filter
+          ? nullptr
+          : BasicBlock::Create(mod->getContext(), ".for.body", query_func_ptr, 0);
   auto bb_crit_edge =
       BasicBlock::Create(mod->getContext(), "._crit_edge", query_func_ptr, 0);
   auto bb_exit = BasicBlock::Create(mod->getContext(), ".exit", query_func_ptr, 0);
@@ -370,40 +384,165 @@ llvm::Function* query_template_impl(llvm::Module* mod,
 
   // Block .loop.preheader
   CastInst* pos_step_i64 = new SExtInst(pos_step, i64_type, "", bb_preheader);
-  BranchInst::Create(bb_forbody, bb_preheader);
+  if (batched_filter) {
+    CHECK(!is_estimate_query);
+    // The rows are processed a batch at a time. The first loop only evaluates the filter
+    // and appends the position of the matching rows to a selection vector, without
+    // branching on the outcome, the second one runs the aggregates on the selected rows.
+    const auto make_row_process_params = [&](Value* row_pos, const bool filter_only) {
+      std::vector<Value*> params(result_ptr_vec.begin(), result_ptr_vec.end());
+      params.push_back(agg_init_val);
+      params.push_back(row_pos);
+      params.push_back(frag_row_off_ptr);
+      params.push_back(row_count_ptr);
+      params.push_back(ConstantInt::get(i32_type, filter_only ? 1 : 0));
+      if (hoist_literals) {
+        CHECK(literals);
+        params.push_back(literals);
+      }
+      return params;
+    };
+    auto bb_batch_head = BasicBlock::Create(
+        mod->getContext(), ".batch.head", query_func_ptr, bb_crit_edge);
+    auto bb_filter_body = BasicBlock::Create(
+        mod->getContext(), ".filter.body", query_func_ptr, bb_crit_edge);
+    auto bb_agg_preheader = BasicBlock::Create(
+        mod->getContext(), ".agg.preheader", query_func_ptr, bb_crit_edge);
+    auto bb_agg_body =
+        BasicBlock::Create(mod->getContext(), ".agg.body", query_func_ptr, bb_crit_edge);
+    auto bb_batch_latch = BasicBlock::Create(
+        mod->getContext(), ".batch.latch", query_func_ptr, bb_crit_edge);
+    auto selection_vector = new AllocaInst(i64_type,
+                                           0,
+                                           ConstantInt::get(i32_type, kFilterBatchSize),
+                                           "selection_vector",
+                                           bb_entry->getTerminator());
+    selection_vector->setAlignment(8);
+    BranchInst::Create(bb_batch_head, bb_preheader);
+
+    // Block .batch.head
+    PHINode* batch_start = PHINode::Create(i64_type, 2, "batch_start", bb_batch_head);
+    batch_start->addIncoming(pos_start_i64, bb_preheader);
+    auto batch_stride =
+        BinaryOperator::CreateNSW(Instruction::Mul,
+                                  pos_step_i64,
+                                  ConstantInt::get(i64_type, kFilterBatchSize),
+                                  "",
+                                  bb_batch_head);
+    auto batch_limit = BinaryOperator::CreateNSW(
+        Instruction::Add, batch_start, batch_stride, "", bb_batch_head);
+    auto batch_is_full =
+        new ICmpInst(*bb_batch_head, ICmpInst::ICMP_SLT, batch_limit, row_count, "");
+    auto batch_end = SelectInst::Create(
+        batch_is_full, batch_limit, row_count, "batch_end", bb_batch_head);
+    BranchInst::Create(bb_filter_body, bb_batch_head);
+
+    // Block .filter.body
+    PHINode* filter_pos = PHINode::Create(i64_type, 2, "filter_pos", bb_filter_body);
+    filter_pos->addIncoming(batch_start, bb_batch_head);
+    PHINode* match_count = PHINode::Create(i64_type, 2, "match_count", bb_filter_body);
+    match_count->addIncoming(ConstantInt::get(i64_type, 0), bb_batch_head);
+    CallInst* filter_match = CallInst::Create(func_row_process,
+                                              make_row_process_params(filter_pos, true),
+                                              "filter_match",
+                                              bb_filter_body);
+    filter_match->setCallingConv(CallingConv::C);
+    filter_match->setTailCall(false);
+    auto selection_slot = GetElementPtrInst::CreateInBounds(
+        selection_vector, match_count, "", bb_filter_body);
+    auto selection_st = new StoreInst(filter_pos, selection_slot, false, bb_filter_body);
+    selection_st->setAlignment(8);
+    auto match_count_inc = BinaryOperator::CreateNSW(
+        Instruction::Add,
+        match_count,
+        new ZExtInst(filter_match, i64_type, "", bb_filter_body),
+        "",
+        bb_filter_body);
+    match_count->addIncoming(match_count_inc, bb_filter_body);
+    auto filter_pos_inc = BinaryOperator::CreateNSW(
+        Instruction::Add, filter_pos, pos_step_i64, "", bb_filter_body);
+    filter_pos->addIncoming(filter_pos_inc, bb_filter_body);
+    auto filter_or_aggregate =
+        new ICmpInst(*bb_filter_body, ICmpInst::ICMP_SLT, filter_pos_inc, batch_end, "");
+    BranchInst::Create(
+        bb_filter_body, bb_agg_preheader, filter_or_aggregate, bb_filter_body);
+
+    // Block .agg.preheader
+    auto has_matches = new ICmpInst(*bb_agg_preheader,
+                                    ICmpInst::ICMP_SGT,
+                                    match_count_inc,
+                                    ConstantInt::get(i64_type, 0),
+                                    "");
+    BranchInst::Create(bb_agg_body, bb_batch_latch, has_matches, bb_agg_preheader);
+
+    // Block .agg.body
+    PHINode* selection_idx = PHINode::Create(i64_type, 2, "selection_idx", bb_agg_body);
+    selection_idx->addIncoming(ConstantInt::get(i64_type, 0), bb_agg_preheader);
+    auto row_pos_ptr = GetElementPtrInst::CreateInBounds(
+        selection_vector, selection_idx, "", bb_agg_body);
+    auto row_pos = new LoadInst(row_pos_ptr, "row_pos", false, bb_agg_body);
+    row_pos->setAlignment(8);
+    CallInst* row_process = CallInst::Create(
+        func_row_process, make_row_process_params(row_pos, false), "", bb_agg_body);
+    row_process->setCallingConv(CallingConv::C);
+    row_process->setTailCall(false);
+    Attributes row_process_pal;
+    row_process->setAttributes(row_process_pal);
+    auto selection_idx_inc = BinaryOperator::CreateNSW(Instruction::Add,
+                                                       selection_idx,
+                                                       ConstantInt::get(i64_type, 1),
+                                                       "",
+                                                       bb_agg_body);
+    selection_idx->addIncoming(selection_idx_inc, bb_agg_body);
+    auto aggregate_more = new ICmpInst(
+        *bb_agg_body, ICmpInst::ICMP_SLT, selection_idx_inc, match_count_inc, "");
+    BranchInst::Create(bb_agg_body, bb_batch_latch, aggregate_more, bb_agg_body);
+
+    // Block .batch.latch
+    batch_start->addIncoming(batch_end, bb_batch_latch);
+    auto next_batch_or_exit =
+        new ICmpInst(*bb_batch_latch, ICmpInst::ICMP_SLT, batch_end, row_count, "");
+    BranchInst::Create(bb_batch_head, bb_crit_edge, next_batch_or_exit, bb_batch_latch);
+  } else {
+    BranchInst::Create(bb_forbody, bb_preheader);
 
-  // Block  .forbody
-  Argument* pos_inc_pre = new Argument(i64_type);
-  PHINode* pos = PHINode::Create(i64_type, 2, "pos", bb_forbody);
-  pos->addIncoming(pos_start_i64, bb_preheader);
-  pos->addIncoming(pos_inc_pre, bb_forbody);
+    // Block  .forbody
+    Argument* pos_inc_pre = new Argument(i64_type);
+    PHINode* pos = PHINode::Create(i64_type, 2, "pos", bb_forbody);
+    pos->addIncoming(pos_start_i64, bb_preheader);
+    pos->addIncoming(pos_inc_pre, bb_forbody);
 
-  std::vector<Value*> row_process_params;
-  row_process_params.insert(
-      row_process_params.end(), result_ptr_vec.begin(), result_ptr_vec.end());
-  if (is_estimate_query) {
-    row_process_params.push_back(new LoadInst(out, "", false, bb_forbody));
-  }
-  row_process_params.push_back(agg_init_val);
-  row_process_params.push_back(pos);
-  row_process_params.push_back(frag_row_off_ptr);
-  row_process_params.push_back(row_count_ptr);
-  if (hoist_literals) {
-    CHECK(literals);
-    row_process_params.push_back(literals);
-  }
-  CallInst* row_process =
-      CallInst::Create(func_row_process, row_process_params, "", bb_forbody);
-  row_process->setCallingConv(CallingConv::C);
-  row_process->setTailCall(false);
-  Attributes row_process_pal;
-  row_process->setAttributes(row_process_pal);
+    std::vector<Value*> row_process_params;
+    row_process_params.insert(
+        row_process_params.end(), result_ptr_vec.begin(), result_ptr_vec.end());
+    if (is_estimate_query) {
+      row_process_params.push_back(new LoadInst(out, "", false, bb_forbody));
+    }
+    row_process_params.push_back(agg_init_val);
+    row_process_params.push_back(pos);
+    row_process_params.push_back(frag_row_off_ptr);
+    row_process_params.push_back(row_count_ptr);
+    if (hoist_literals) {
+      CHECK(literals);
+      row_process_params.push_back(literals);
+    }
+    CallInst* row_process =
+        CallInst::Create(func_row_process, row_process_params, "", bb_forbody);
+    row_process->setCallingConv(CallingConv::C);
+    row_process->setTailCall(false);
+    Attributes row_process_pal;
+    row_process->setAttributes(row_process_pal);
+
+    BinaryOperator* pos_inc =
+        BinaryOperator::CreateNSW(Instruction::Add, pos, pos_step_i64, "", bb_forbody);
+    ICmpInst* loop_or_exit =
+        new ICmpInst(*bb_forbody, ICmpInst::ICMP_SLT, pos_inc, row_count, "");
+    BranchInst::Create(bb_forbody, bb_crit_edge, loop_or_exit, bb_forbody);
 
-  BinaryOperator* pos_inc =
-      BinaryOperator::CreateNSW(Instruction::Add, pos, pos_step_i64, "", bb_forbody);
-  ICmpInst* loop_or_exit =
-      new ICmpInst(*bb_forbody, ICmpInst::ICMP_SLT, pos_inc, row_count, "");
-  BranchInst::Create(bb_forbody, bb_crit_edge, loop_or_exit, bb_forbody);
+    // Resolve Forward References
+    pos_inc_pre->replaceAllUsesWith(pos_inc);
+    delete pos_inc_pre;
+  }
 
   // Block ._crit_edge
   std::vector<Instruction*> result_vec_pre;
@@ -449,10 +588,6 @@ llvm::Function* query_template_impl(llvm::Module* mod,
 
   ReturnInst::Create(mod->getContext(), bb_exit);
 
-  // Resolve Forward References
-  pos_inc_pre->replaceAllUsesWith(pos_inc);
-  delete pos_inc_pre;
-
   if (verifyFunction(*query_func_ptr)) {
     LOG(FATAL) << "Generated invalid code. ";
   }
@@ -475,7 +610,8 @@ llvm::Function* query_group_by_template_impl(llvm::Module* mod,
   CHECK(func_pos_step);
   auto func_group_buff_idx = group_buff_idx<Attributes>(mod);
   CHECK(func_group_buff_idx);
-  auto func_row_process = row_process<Attributes>(mod, 0, is_nested, hoist_literals);
+  auto func_row_process =
+      row_process<Attributes>(mod, 0, is_nested, hoist_literals, false);
   CHECK(func_row_process);
   auto func_init_shared_mem = query_mem_desc.sharedMemBytes(device_type)
                                   ? mod->getFunction("init_shared_mem")
@@ -667,7 +803,8 @@ llvm::Function* query_group_by_template_impl(llvm::Module* mod,
   llvm::CallInst* result_buffer = nullptr;
   if (query_mem_desc.getGpuMemSharing() ==
       GroupByMemSharing::SharedForKeylessOneColumnKnownRange) {
-    int32_t num_shared_mem_buckets = query_mem_desc.getEntryCount() + 1;
+    int32_t num_shared_mem_buckets = (query_mem_desc.getEntryCount() + 1) *
+                                     query_mem_desc.getRowSize() / sizeof(int64_t);
     shared_mem_bytes_lv =
         ConstantInt::get(i32_type, query_mem_desc.sharedMemBytes(device_type));
     shared_mem_num_elements_lv = ConstantInt::get(i32_type, num_shared_mem_buckets);
@@ -786,7 +923,24 @@ llvm::Function* query_group_by_template_impl(llvm::Module* mod,
 
   // Block .exit
   if (query_mem_desc.getGpuMemSharing() ==
-      GroupByMemSharing::SharedForKeylessOneColumnKnownRange) {
+          GroupByMemSharing::SharedForKeylessOneColumnKnownRange &&
+      query_mem_desc.getSharedMemAggSlotMask()) {
+    auto func_agg_from_smem_to_gmem = mod->getFunction("agg_from_smem_to_gmem_slots");
+    CHECK(func_agg_from_smem_to_gmem);
+    const auto row_slots = query_mem_desc.getRowSize() / sizeof(int64_t);
+    CallInst::Create(
+        func_agg_from_smem_to_gmem,
+        std::vector<Value*>{
+            col_buffer,
+            result_buffer,
+            ConstantInt::get(i32_type, query_mem_desc.getEntryCount()),
+            ConstantInt::get(i32_type, row_slots),
+            ConstantInt::get(i32_type, query_mem_desc.getTargetIdxForKey()),
+            ConstantInt::get(i64_type, query_mem_desc.getSharedMemAggSlotMask())},
+        "",
+        bb_exit);
+  } else if (query_mem_desc.getGpuMemSharing() ==
+             GroupByMemSharing::SharedForKeylessOneColumnKnownRange) {
     CHECK_LT(query_mem_desc.getTargetIdxForKey(),
              2);  // Saman: not expected for the shared memory design if more than 1
     // Depending on the aggregate's target expression index, we choose different memory
@@ -832,9 +986,14 @@ llvm::Function* query_template(llvm::Module* module,
                                const size_t aggr_col_count,
                                const bool is_nested,
                                const bool hoist_literals,
-                               const bool is_estimate_query) {
-  return query_template_impl<llvm::AttributeList>(
-      module, aggr_col_count, is_nested, hoist_literals, is_estimate_query);
+                               const bool is_estimate_query,
+                               const bool batched_filter) {
+  return query_template_impl<llvm::AttributeList>(module,
+                                                  aggr_col_count,
+                                                  is_nested,
+                                                  hoist_literals,
+                                                  is_estimate_query,
+                                                  batched_filter);
 }
 llvm::Function* query_group_by_template(llvm::Module* module,
                                         const bool is_nested,
@@ -850,9 +1009,14 @@ llvm::Function* query_template(llvm::Module* module,
                                const size_t aggr_col_count,
                                const bool is_nested,
                                const bool hoist_literals,
-                               const bool is_estimate_query) {
-  return query_template_impl<llvm::AttributeSet>(
-      module, aggr_col_count, is_nested, hoist_literals, is_estimate_query);
+                               const bool is_estimate_query,
+                               const bool batched_filter) {
+  return query_template_impl<llvm::AttributeSet>(module,
+                                                 aggr_col_count,
+                                                 is_nested,
+                                                 hoist_literals,
+                                                 is_estimate_query,
+                                                 batched_filter);
 }
 llvm::Function* query_group_by_template(llvm::Module* module,
                                         const bool is_nested,
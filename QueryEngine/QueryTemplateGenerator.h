@@ -29,7 +29,8 @@ llvm::Function* query_template(llvm::Module*,
                                const size_t aggr_col_count,
                                const bool is_nested,
                                const bool hoist_literals,
-                               const bool is_estimate_query);
+                               const bool is_estimate_query,
+                               const bool batched_filter);
 llvm::Function* query_group_by_template(llvm::Module*,
                                         const bool is_nested,
                                         const bool hoist_literals,
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RangeJoinHashTable.h"
+#include "Execute.h"
+#include "JoinHashTable.h"
+#include "RangeTableIndexVisitor.h"
+#include "RuntimeFunctions.h"
+
+#include <glog/logging.h>
+#include <limits>
+
+namespace {
+
+// Marks the null bounds once decoded, no interval of the index has one.
+const int64_t NULL_BOUND{std::numeric_limits<int64_t>::min()};
+
+typedef std::pair<std::shared_ptr<Analyzer::Expr>, std::shared_ptr<Analyzer::Expr>>
+    LesserGreater;
+
+// Splits an inequality into its lesser and its greater side. The index lists closed
+// intervals, both kinds of inequality map to the same probe.
+LesserGreater get_lesser_greater(const Analyzer::BinOper* bin_oper) {
+  if (bin_oper->get_qualifier() != kONE) {
+    return {nullptr, nullptr};
+  }
+  switch (bin_oper->get_optype()) {
+    case kLT:
+    case kLE:
+      return {bin_oper->get_own_left_operand(), bin_oper->get_own_right_operand()};
+    case kGT:
+    case kGE:
+      return {bin_oper->get_own_right_operand(), bin_oper->get_own_left_operand()};
+    default:
+      return {nullptr, nullptr};
+  }
+}
+
+std::shared_ptr<Analyzer::ColumnVar> get_inner_bound(
+    const std::shared_ptr<Analyzer::Expr>& expr,
+    const int inner_rte_idx,
+    const Executor* executor) {
+  auto col_var = std::dynamic_pointer_cast<Analyzer::ColumnVar>(expr);
+  if (!col_var || col_var->get_rte_idx() != inner_rte_idx) {
+    return nullptr;
+  }
+  const auto& catalog = *executor->getCatalog();
+  const auto cd = get_column_descriptor_maybe(
+      col_var->get_column_id(), col_var->get_table_id(), catalog);
+  if (cd && cd->isVirtualCol) {
+    return nullptr;
+  }
+  const auto ti = get_column_type(col_var->get_column_id(),
+                                  col_var->get_table_id(),
+                                  cd,
+                                  executor->getTemporaryTables());
+  if (!(ti.is_integer() || ti.is_time()) || ti.get_compression() == kENCODING_DIFF) {
+    return nullptr;
+  }
+  return col_var;
+}
+
+bool is_outer_probe(const std::shared_ptr<Analyzer::Expr>& expr,
+                    const int inner_rte_idx) {
+  MaxRangeTableIndexVisitor rte_idx_visitor;
+  return rte_idx_visitor.visit(expr.get()) < inner_rte_idx;
+}
+
+bool is_range_join_type(const SQLTypeInfo& ti, const SQLTypeInfo& outer_ti) {
+  return (outer_ti.is_integer() || outer_ti.is_time()) &&
+         ti.get_type() == outer_ti.get_type();
+}
+
+int64_t get_bucket(const int64_t val, const int64_t min_val, const int64_t width) {
+  return (static_cast<uint64_t>(val) - static_cast<uint64_t>(min_val)) / width;
+}
+
+}  // namespace
+
+std::shared_ptr<RangeJoinHashTable> RangeJoinHashTable::getInstance(
+    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const int inner_rte_idx,
+    const std::vector<InputTableInfo>& query_infos,
+    const Data_Namespace::MemoryLevel memory_level,
+    const int device_count,
+    ColumnCacheMap& column_cache,
+    Executor* executor) {
+  typedef std::pair<std::shared_ptr<Analyzer::ColumnVar>, std::shared_ptr<Analyzer::Expr>>
+      InnerOuter;
+  std::vector<InnerOuter> lower_bounds;
+  std::vector<InnerOuter> upper_bounds;
+  for (const auto& qual : quals) {
+    const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual.get());
+    if (!bin_oper) {
+      continue;
+    }
+    const auto lesser_greater = get_lesser_greater(bin_oper);
+    if (!lesser_greater.first) {
+      continue;
+    }
+    const auto inner_lesser =
+        get_inner_bound(lesser_greater.first, inner_rte_idx, executor);
+    if (inner_lesser && is_outer_probe(lesser_greater.second, inner_rte_idx)) {
+      lower_bounds.emplace_back(inner_lesser, lesser_greater.second);
+      continue;
+    }
+    const auto inner_greater =
+        get_inner_bound(lesser_greater.second, inner_rte_idx, executor);
+    if (inner_greater && is_outer_probe(lesser_greater.first, inner_rte_idx)) {
+      upper_bounds.emplace_back(inner_greater, lesser_greater.first);
+    }
+  }
+  for (const auto& lower_bound : lower_bounds) {
+    for (const auto& upper_bound : upper_bounds) {
+      const auto& outer_ti = lower_bound.second->get_type_info();
+      if (!(*lower_bound.second == *upper_bound.second) ||
+          !is_range_join_type(lower_bound.first->get_type_info(), outer_ti) ||
+          !is_range_join_type(upper_bound.first->get_type_info(), outer_ti) ||
+          lower_bound.first->get_table_id() != upper_bound.first->get_table_id()) {
+        continue;
+      }
+      auto join_hash_table =
+          std::shared_ptr<RangeJoinHashTable>(new RangeJoinHashTable(lower_bound.first,
+                                                                     upper_bound.first,
+                                                                     lower_bound.second,
+                                                                     query_infos,
+                                                                     memory_level,
+                                                                     column_cache,
+                                                                     executor));
+      join_hash_table->reify(device_count);
+      return join_hash_table;
+    }
+  }
+  throw HashJoinFail("No range join expression found");
+}
+
+RangeJoinHashTable::RangeJoinHashTable(
+    const std::shared_ptr<Analyzer::ColumnVar> inner_lo,
+    const std::shared_ptr<Analyzer::ColumnVar> inner_hi,
+    const std::shared_ptr<Analyzer::Expr> outer,
+    const std::vector<InputTableInfo>& query_infos,
+    const Data_Namespace::MemoryLevel memory_level,
+    ColumnCacheMap& column_cache,
+    Executor* executor)
+    : inner_lo_(inner_lo)
+    , inner_hi_(inner_hi)
+    , outer_(outer)
+    , query_infos_(query_infos)
+    , memory_level_(memory_level)
+    , column_cache_(column_cache)
+    , executor_(executor)
+    , min_val_(0)
+    , max_val_(0)
+    , bucket_width_(1)
+    , bucket_count_(1) {}
+
+int64_t RangeJoinHashTable::getJoinHashBuffer(const ExecutorDeviceType device_type,
+                                              const int device_id) noexcept {
+  if (device_type == ExecutorDeviceType::CPU && !cpu_hash_table_buff_) {
+    return 0;
+  }
+#ifdef HAVE_CUDA
+  CHECK_LT(static_cast<size_t>(device_id), gpu_hash_table_buff_.size());
+  return device_type == ExecutorDeviceType::CPU
+             ? reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0])
+             : reinterpret_cast<int64_t>(gpu_hash_table_buff_[device_id]->getMemoryPtr());
+#else
+  CHECK(device_type == ExecutorDeviceType::CPU);
+  return reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0]);
+#endif
+}
+
+void RangeJoinHashTable::reify(const int device_count) {
+  CHECK_LT(0, device_count);
+#ifdef HAVE_CUDA
+  gpu_hash_table_buff_.resize(device_count);
+#endif  // HAVE_CUDA
+  const auto& query_info = get_inner_query_info(getInnerTableId(), query_infos_).info;
+  std::vector<int64_t> lo_vals;
+  std::vector<int64_t> hi_vals;
+  if (!query_info.fragments.empty()) {
+    lo_vals = fetchColumn(*inner_lo_, query_info.fragments);
+    hi_vals = fetchColumn(*inner_hi_, query_info.fragments);
+  }
+  initHashTableOnCpu(lo_vals, hi_vals);
+  if (memory_level_ != Data_Namespace::GPU_LEVEL) {
+    return;
+  }
+#ifdef HAVE_CUDA
+  // The index is small next to the inner columns, build it once and copy it over.
+  auto& data_mgr = executor_->getCatalog()->get_dataMgr();
+  const auto buff_size = cpu_hash_table_buff_->size() * sizeof(int32_t);
+  for (int device_id = 0; device_id < device_count; ++device_id) {
+    gpu_hash_table_buff_[device_id] =
+        alloc_gpu_abstract_buffer(&data_mgr, buff_size, device_id);
+    copy_to_gpu(
+        &data_mgr,
+        reinterpret_cast<CUdeviceptr>(gpu_hash_table_buff_[device_id]->getMemoryPtr()),
+        &(*cpu_hash_table_buff_)[0],
+        buff_size,
+        device_id);
+  }
+#else
+  CHECK(false);
+#endif
+}
+
+std::vector<int64_t> RangeJoinHashTable::fetchColumn(
+    const Analyzer::ColumnVar& col_var,
+    const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments) {
+  const auto& ti = col_var.get_type_info();
+  const auto null_val = inline_fixed_encoding_null_val(ti);
+  std::vector<int64_t> vals;
+  for (const auto& fragment : fragments) {
+    std::vector<std::shared_ptr<Chunk_NS::Chunk>> chunks_owner;
+    const int8_t* col_buff{nullptr};
+    size_t elem_count{0};
+    try {
+      std::tie(col_buff, elem_count) =
+          Executor::ExecutionDispatch::getColumnFragment(executor_,
+                                                         col_var,
+                                                         fragment,
+                                                         Data_Namespace::CPU_LEVEL,
+                                                         0,
+                                                         chunks_owner,
+                                                         column_cache_);
+    } catch (...) {
+      throw FailedToFetchColumn();
+    }
+    // Keep the row ids in sync with the linearized inner columns.
+    vals.reserve(vals.size() + fragment.getNumTuples());
+    for (size_t i = 0; i < (col_buff ? elem_count : 0); ++i) {
+      const auto val =
+          is_unsigned_type(ti)
+              ? fixed_width_unsigned_decode_noinline(col_buff, ti.get_size(), i)
+              : fixed_width_int_decode_noinline(col_buff, ti.get_size(), i);
+      vals.push_back(val == null_val ? NULL_BOUND : val);
+    }
+  }
+  return vals;
+}
+
+// Picks the width of the buckets so that an interval overlaps at most a few of them on
+// average, with no more buckets than twice the intervals, then lays the index out like
+// a one-to-many hash table: the position and the count of every bucket, followed by
+// the row ids of the intervals of the buckets.
+void RangeJoinHashTable::initHashTableOnCpu(const std::vector<int64_t>& lo_vals,
+                                            const std::vector<int64_t>& hi_vals) {
+  CHECK_EQ(lo_vals.size(), hi_vals.size());
+  if (lo_vals.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    throw TooManyHashEntries();
+  }
+  size_t interval_count{0};
+  long double total_length{0};
+  for (size_t i = 0; i < lo_vals.size(); ++i) {
+    const auto lo = lo_vals[i];
+    const auto hi = hi_vals[i];
+    if (lo == NULL_BOUND || hi == NULL_BOUND || lo > hi) {
+      continue;
+    }
+    min_val_ = interval_count ? std::min(min_val_, lo) : lo;
+    max_val_ = interval_count ? std::max(max_val_, hi) : hi;
+    total_length += static_cast<long double>(hi) - lo + 1;
+    ++interval_count;
+  }
+  if (interval_count) {
+    const auto span = static_cast<uint64_t>(max_val_) - static_cast<uint64_t>(min_val_);
+    const auto avg_length = total_length / interval_count;
+    bucket_width_ = avg_length < std::numeric_limits<int64_t>::max()
+                        ? std::max(static_cast<int64_t>(avg_length), int64_t(1))
+                        : std::numeric_limits<int64_t>::max();
+    const uint64_t max_bucket_count = 2 * interval_count;
+    if (span / bucket_width_ >= max_bucket_count) {
+      bucket_width_ = std::min<uint64_t>(span / max_bucket_count + 1,
+                                         std::numeric_limits<int64_t>::max());
+    }
+    bucket_count_ = span / bucket_width_ + 1;
+  }
+  std::vector<int32_t> counts(bucket_count_, 0);
+  size_t entry_count{0};
+  for (size_t i = 0; i < lo_vals.size(); ++i) {
+    const auto lo = lo_vals[i];
+    const auto hi = hi_vals[i];
+    if (lo == NULL_BOUND || hi == NULL_BOUND || lo > hi) {
+      continue;
+    }
+    const auto first_bucket = get_bucket(lo, min_val_, bucket_width_);
+    const auto last_bucket = get_bucket(hi, min_val_, bucket_width_);
+    for (auto bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+      ++counts[bucket];
+    }
+    entry_count += last_bucket - first_bucket + 1;
+  }
+  if (2 * bucket_count_ + entry_count >
+      static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    throw TooManyHashEntries();
+  }
+  cpu_hash_table_buff_ =
+      std::make_shared<std::vector<int32_t>>(2 * bucket_count_ + entry_count);
+  auto pos_buff = &(*cpu_hash_table_buff_)[0];
+  auto count_buff = pos_buff + bucket_count_;
+  auto id_buff = count_buff + bucket_count_;
+  int32_t pos{0};
+  for (size_t bucket = 0; bucket < bucket_count_; ++bucket) {
+    pos_buff[bucket] = counts[bucket] ? pos : -1;
+    pos += counts[bucket];
+  }
+  for (size_t i = 0; i < lo_vals.size(); ++i) {
+    const auto lo = lo_vals[i];
+    const auto hi = hi_vals[i];
+    if (lo == NULL_BOUND || hi == NULL_BOUND || lo > hi) {
+      continue;
+    }
+    const auto first_bucket = get_bucket(lo, min_val_, bucket_width_);
+    const auto last_bucket = get_bucket(hi, min_val_, bucket_width_);
+    for (auto bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+      id_buff[pos_buff[bucket] + count_buff[bucket]++] = i;
+    }
+  }
+}
+
+// The bucket of the probed value, -1 if it's outside of the range of the intervals.
+// Nulls are below the range or get discarded by the range quals.
+llvm::Value* RangeJoinHashTable::codegenBucket(const CompilationOptions& co) {
+  const auto key_lvs = executor_->codegen(outer_.get(), true, co);
+  CHECK_EQ(size_t(1), key_lvs.size());
+  auto& ir_builder = executor_->cgen_state_->ir_builder_;
+  const auto key_lv = executor_->castToTypeIn(key_lvs.front(), 64);
+  const auto in_range_lv =
+      ir_builder.CreateAnd(ir_builder.CreateICmpSGE(key_lv, executor_->ll_int(min_val_)),
+                           ir_builder.CreateICmpSLE(key_lv, executor_->ll_int(max_val_)));
+  const auto bucket_lv = ir_builder.CreateUDiv(
+      ir_builder.CreateSub(key_lv, executor_->ll_int(min_val_)),
+      executor_->ll_int(bucket_width_));
+  return ir_builder.CreateSelect(in_range_lv, bucket_lv, executor_->ll_int(int64_t(-1)));
+}
+
+llvm::Value* RangeJoinHashTable::codegenSlotIsValid(const CompilationOptions&,
+                                                    const size_t) {
+  // The range quals aren't folded into the index, nothing compares to a slot.
+  CHECK(false);
+  return nullptr;
+}
+
+llvm::Value* RangeJoinHashTable::codegenSlot(const CompilationOptions&, const size_t) {
+  CHECK(false);
+  return nullptr;
+}
+
+HashJoinMatchingSet RangeJoinHashTable::codegenMatchingSet(const CompilationOptions& co,
+                                                           const size_t index) {
+  auto hash_ptr = JoinHashTable::codegenHashTableLoad(index, executor_);
+  CHECK(hash_ptr);
+  if (!hash_ptr->getType()->isIntegerTy(64)) {
+    CHECK(hash_ptr->getType()->isPointerTy());
+    hash_ptr = executor_->cgen_state_->ir_builder_.CreatePtrToInt(
+        hash_ptr, llvm::Type::getInt64Ty(executor_->cgen_state_->context_));
+  }
+  const std::vector<llvm::Value*> hash_join_idx_args{
+      hash_ptr,
+      codegenBucket(co),
+      executor_->ll_int(int64_t(0)),
+      executor_->ll_int(static_cast<int64_t>(bucket_count_ - 1))};
+  const int64_t sub_buff_size = bucket_count_ * sizeof(int32_t);
+  return JoinHashTable::codegenMatchingSet(
+      hash_join_idx_args, false, false, false, sub_buff_size, executor_);
+}
+
+int RangeJoinHashTable::getInnerTableId() const noexcept {
+  return inner_lo_->get_table_id();
+}
+
+int RangeJoinHashTable::getInnerTableRteIdx() const noexcept {
+  return inner_lo_->get_rte_idx();
+}
+
+JoinHashTableInterface::HashType RangeJoinHashTable::getHashType() const noexcept {
+  return JoinHashTableInterface::HashType::OneToMany;
+}
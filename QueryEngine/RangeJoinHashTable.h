@@ -0,0 +1,109 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QUERYENGINE_RANGEJOINHASHTABLE_H
+#define QUERYENGINE_RANGEJOINHASHTABLE_H
+
+#include "../Analyzer/Analyzer.h"
+#include "../DataMgr/MemoryLevel.h"
+#include "ColumnarResults.h"
+#include "InputMetadata.h"
+#include "JoinHashTableInterface.h"
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <vector>
+
+class Executor;
+
+// Interval index for a join on a value of the outer tables lying between two columns of
+// the inner table, like a.ts BETWEEN b.start AND b.end. The range of the bounds is cut
+// into buckets of the same width and every interval is listed in each of the buckets
+// it overlaps, using the one-to-many layout. A probe only visits the intervals of the
+// bucket of its value: the range quals stay in the filter of the query and discard
+// the intervals of the bucket which don't contain it.
+class RangeJoinHashTable : public JoinHashTableInterface {
+ public:
+  // Throws HashJoinFail unless the quals bound an expression of the outer tables
+  // between two columns of the inner table at the given nesting level.
+  static std::shared_ptr<RangeJoinHashTable> getInstance(
+      const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+      const int inner_rte_idx,
+      const std::vector<InputTableInfo>& query_infos,
+      const Data_Namespace::MemoryLevel memory_level,
+      const int device_count,
+      ColumnCacheMap& column_cache,
+      Executor* executor);
+
+  int64_t getJoinHashBuffer(const ExecutorDeviceType device_type,
+                            const int device_id) noexcept override;
+
+  llvm::Value* codegenSlotIsValid(const CompilationOptions&, const size_t) override;
+
+  llvm::Value* codegenSlot(const CompilationOptions&, const size_t) override;
+
+  HashJoinMatchingSet codegenMatchingSet(const CompilationOptions&,
+                                         const size_t) override;
+
+  int getInnerTableId() const noexcept override;
+
+  int getInnerTableRteIdx() const noexcept override;
+
+  JoinHashTableInterface::HashType getHashType() const noexcept override;
+
+  virtual ~RangeJoinHashTable() {}
+
+ private:
+  RangeJoinHashTable(const std::shared_ptr<Analyzer::ColumnVar> inner_lo,
+                     const std::shared_ptr<Analyzer::ColumnVar> inner_hi,
+                     const std::shared_ptr<Analyzer::Expr> outer,
+                     const std::vector<InputTableInfo>& query_infos,
+                     const Data_Namespace::MemoryLevel memory_level,
+                     ColumnCacheMap& column_cache,
+                     Executor* executor);
+
+  void reify(const int device_count);
+
+  std::vector<int64_t> fetchColumn(
+      const Analyzer::ColumnVar& col_var,
+      const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments);
+
+  void initHashTableOnCpu(const std::vector<int64_t>& lo_vals,
+                          const std::vector<int64_t>& hi_vals);
+
+  llvm::Value* codegenBucket(const CompilationOptions& co);
+
+  const std::shared_ptr<Analyzer::ColumnVar> inner_lo_;
+  const std::shared_ptr<Analyzer::ColumnVar> inner_hi_;
+  const std::shared_ptr<Analyzer::Expr> outer_;
+  const std::vector<InputTableInfo>& query_infos_;
+  const Data_Namespace::MemoryLevel memory_level_;
+  ColumnCacheMap& column_cache_;
+  Executor* executor_;
+  // The buckets start at min_val_, every one of them covers bucket_width_ values.
+  int64_t min_val_;
+  int64_t max_val_;
+  int64_t bucket_width_;
+  size_t bucket_count_;
+  std::shared_ptr<std::vector<int32_t>> cpu_hash_table_buff_;
+#ifdef HAVE_CUDA
+  std::vector<Data_Namespace::AbstractBuffer*> gpu_hash_table_buff_;
+#endif
+};
+
+#endif  // QUERYENGINE_RANGEJOINHASHTABLE_H
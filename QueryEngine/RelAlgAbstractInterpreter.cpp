@@ -26,8 +26,10 @@
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
+#include <algorithm>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 extern bool g_multi_subquery_exc;
 
@@ -52,7 +54,7 @@ void RexSubQuery::setExecutionResult(
 }
 
 std::unique_ptr<RexSubQuery> RexSubQuery::deepCopy() const {
-  return std::make_unique<RexSubQuery>(type_, result_, ra_->deepCopy());
+  return std::make_unique<RexSubQuery>(type_, result_, ra_->deepCopy(), query_ra_);
 }
 
 namespace {
@@ -528,6 +530,80 @@ SQLTypeInfo parse_type(const rapidjson::Value& type_obj) {
   return ti;
 }
 
+bool is_aggregate_window_function(const SqlWindowFunctionKind kind) {
+  switch (kind) {
+    case SqlWindowFunctionKind::AVG:
+    case SqlWindowFunctionKind::MIN:
+    case SqlWindowFunctionKind::MAX:
+    case SqlWindowFunctionKind::SUM:
+    case SqlWindowFunctionKind::COUNT:
+    case SqlWindowFunctionKind::SUM_INTERNAL:
+    case SqlWindowFunctionKind::LAST_VALUE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::unique_ptr<RexOperator> parse_window_function(
+    const rapidjson::Value& expr,
+    const std::string& op_name,
+    std::vector<std::unique_ptr<const RexScalar>>& operands,
+    const SQLTypeInfo& ti,
+    const Catalog_Namespace::Catalog& cat,
+    RelAlgExecutor* ra_executor) {
+  const auto kind = to_window_function_kind(op_name);
+  if (json_bool(field(expr, "distinct"))) {
+    throw QueryNotSupported("Distinct window functions not supported");
+  }
+  const auto& partition_keys_arr = field(expr, "partition_keys");
+  CHECK(partition_keys_arr.IsArray());
+  for (auto partition_keys_arr_it = partition_keys_arr.Begin();
+       partition_keys_arr_it != partition_keys_arr.End();
+       ++partition_keys_arr_it) {
+    operands.emplace_back(parse_scalar_expr(*partition_keys_arr_it, cat, ra_executor));
+  }
+  const size_t partition_key_count = partition_keys_arr.Size();
+  const auto& order_keys_arr = field(expr, "order_keys");
+  CHECK(order_keys_arr.IsArray());
+  std::vector<SortField> collation;
+  for (auto order_keys_arr_it = order_keys_arr.Begin();
+       order_keys_arr_it != order_keys_arr.End();
+       ++order_keys_arr_it) {
+    operands.emplace_back(
+        parse_scalar_expr(field(*order_keys_arr_it, "field"), cat, ra_executor));
+    const auto sort_dir =
+        json_str(field(*order_keys_arr_it, "direction")) == std::string("DESCENDING")
+            ? SortDirection::Descending
+            : SortDirection::Ascending;
+    const auto null_pos =
+        json_str(field(*order_keys_arr_it, "nulls")) == std::string("FIRST")
+            ? NullSortedPosition::First
+            : NullSortedPosition::Last;
+    collation.emplace_back(collation.size(), sort_dir, null_pos);
+  }
+  const auto& lower_bound = field(expr, "lower_bound");
+  const auto& upper_bound = field(expr, "upper_bound");
+  const bool to_current_row = json_bool(field(upper_bound, "is_current_row"));
+  if (is_aggregate_window_function(kind) &&
+      (!json_bool(field(lower_bound, "unbounded")) ||
+       !json_bool(field(lower_bound, "preceding")) ||
+       (!to_current_row && !json_bool(field(upper_bound, "unbounded"))))) {
+    throw QueryNotSupported(
+        "Only frames from UNBOUNDED PRECEDING to CURRENT ROW or UNBOUNDED FOLLOWING "
+        "are supported for window aggregates");
+  }
+  return std::unique_ptr<RexOperator>(
+      new RexWindowFunctionOperator(op_name,
+                                    kind,
+                                    operands,
+                                    partition_key_count,
+                                    collation,
+                                    json_bool(field(expr, "is_rows")),
+                                    to_current_row,
+                                    ti));
+}
+
 std::unique_ptr<RexOperator> parse_operator(const rapidjson::Value& expr,
                                             const Catalog_Namespace::Catalog& cat,
                                             RelAlgExecutor* ra_executor) {
@@ -550,6 +626,9 @@ std::unique_ptr<RexOperator> parse_operator(const rapidjson::Value& expr,
     auto subquery = parse_subquery(expr, cat, ra_executor);
     operands.emplace_back(std::move(subquery));
   }
+  if (expr.HasMember("partition_keys")) {
+    return parse_window_function(expr, op_name, operands, ti, cat, ra_executor);
+  }
   return std::unique_ptr<RexOperator>(op == kFUNCTION
                                           ? new RexFunctionOperator(op_name, operands, ti)
                                           : new RexOperator(op, operands, ti));
@@ -614,7 +693,9 @@ std::unique_ptr<const RexAgg> parse_aggregate_expr(const rapidjson::Value& expr)
   const auto distinct = json_bool(field(expr, "distinct"));
   const auto agg_ti = parse_type(field(expr, "type"));
   const auto operands = indices_from_json_array(field(expr, "operands"));
-  if (operands.size() > 1 && (operands.size() != 2 || agg != kAPPROX_COUNT_DISTINCT)) {
+  if (operands.size() > 1 &&
+      (operands.size() != 2 ||
+       !(is_approx_count_distinct(agg) || agg == kAPPROX_QUANTILE))) {
     throw QueryNotSupported("Multiple arguments for aggregates aren't supported");
   }
   return std::unique_ptr<const RexAgg>(new RexAgg(agg, distinct, agg_ti, operands));
@@ -754,6 +835,115 @@ void bind_inputs(const std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept
   }
 }
 
+bool is_window_function_operator(const RexScalar* rex) {
+  return dynamic_cast<const RexWindowFunctionOperator*>(rex);
+}
+
+bool is_window_function_project(const RelAlgNode* node) {
+  const auto project = dynamic_cast<const RelProject*>(node);
+  if (!project) {
+    return false;
+  }
+  for (size_t i = 0; i < project->size(); ++i) {
+    if (is_window_function_operator(project->getProjectAt(i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+class RexWindowFunctionFinder : public RexVisitor<bool> {
+ public:
+  bool visitOperator(const RexOperator* rex_operator) const override {
+    return is_window_function_operator(rex_operator) ||
+           RexVisitor<bool>::visitOperator(rex_operator);
+  }
+
+ protected:
+  bool aggregateResult(const bool& aggregate, const bool& next_result) const override {
+    return aggregate || next_result;
+  }
+};
+
+// Replaces the window function calls with inputs which follow the columns of the
+// original input, in the order the calls are collected.
+class RexWindowFunctionCollector : public RexDeepCopyVisitor {
+ public:
+  RexWindowFunctionCollector(
+      const RelAlgNode* input,
+      const size_t input_size,
+      std::vector<std::unique_ptr<const RexScalar>>& window_functions)
+      : input_(input), input_size_(input_size), window_functions_(window_functions) {}
+
+  RetType visitOperator(const RexOperator* rex_operator) const override {
+    if (!is_window_function_operator(rex_operator)) {
+      return RexDeepCopyVisitor::visitOperator(rex_operator);
+    }
+    window_functions_.push_back(RexDeepCopyVisitor::visitOperator(rex_operator));
+    return boost::make_unique<RexInput>(input_,
+                                        input_size_ + window_functions_.size() - 1);
+  }
+
+ private:
+  const RelAlgNode* input_;
+  const size_t input_size_;
+  std::vector<std::unique_ptr<const RexScalar>>& window_functions_;
+};
+
+bool has_nested_window_function(const RelProject* project) {
+  RexWindowFunctionFinder finder;
+  for (size_t i = 0; i < project->size(); ++i) {
+    const auto target = project->getProjectAt(i);
+    if (!is_window_function_operator(target) && finder.visit(target)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Calcite wraps window functions in scalar expressions, for example SUM OVER is a CASE
+// on COUNT OVER and AVG OVER a division. The executor only evaluates window functions
+// which are targets themselves, move them into a new project which passes through the
+// input columns and have the original project refer to its output instead.
+void separate_window_function_expressions(
+    std::vector<std::shared_ptr<RelAlgNode>>& nodes) {
+  std::vector<std::shared_ptr<RelAlgNode>> new_nodes;
+  for (auto node : nodes) {
+    const auto project = std::dynamic_pointer_cast<RelProject>(node);
+    if (project && has_nested_window_function(project.get())) {
+      CHECK_EQ(size_t(1), project->inputCount());
+      const auto input = project->getAndOwnInput(0);
+      const auto input_outputs = get_node_output(input.get());
+      std::vector<std::unique_ptr<const RexScalar>> window_functions;
+      RexWindowFunctionCollector collector(
+          input.get(), input_outputs.size(), window_functions);
+      std::vector<std::unique_ptr<const RexScalar>> exprs;
+      for (size_t i = 0; i < project->size(); ++i) {
+        exprs.push_back(collector.visit(project->getProjectAt(i)));
+      }
+      std::vector<std::unique_ptr<const RexScalar>> window_project_exprs;
+      std::vector<std::string> window_project_fields;
+      for (const auto& input_output : input_outputs) {
+        window_project_exprs.push_back(input_output.deepCopy());
+        window_project_fields.push_back("$f" +
+                                        std::to_string(window_project_fields.size()));
+      }
+      for (auto& window_function : window_functions) {
+        window_project_exprs.push_back(std::move(window_function));
+        window_project_fields.push_back("$f" +
+                                        std::to_string(window_project_fields.size()));
+      }
+      auto window_project = std::make_shared<RelProject>(
+          window_project_exprs, window_project_fields, input);
+      project->setExpressions(exprs);
+      project->replaceInput(input, window_project);
+      new_nodes.push_back(window_project);
+    }
+    new_nodes.push_back(node);
+  }
+  nodes.swap(new_nodes);
+}
+
 void mark_nops(const std::vector<std::shared_ptr<RelAlgNode>>& nodes) noexcept {
   for (auto node : nodes) {
     const auto agg_node = std::dynamic_pointer_cast<RelAggregate>(node);
@@ -1215,7 +1405,8 @@ void coalesce_nodes(std::vector<std::shared_ptr<RelAlgNode>>& nodes,
           crt_pattern.push_back(size_t(nodeIt));
           crt_state = CoalesceState::Filter;
           nodeIt.advance(RANodeIterator::AdvancingMode::DUChain);
-        } else if (std::dynamic_pointer_cast<const RelProject>(ra_node)) {
+        } else if (std::dynamic_pointer_cast<const RelProject>(ra_node) &&
+                   !is_window_function_project(ra_node.get())) {
           crt_pattern.push_back(size_t(nodeIt));
           crt_state = CoalesceState::FirstProject;
           nodeIt.advance(RANodeIterator::AdvancingMode::DUChain);
@@ -1225,7 +1416,8 @@ void coalesce_nodes(std::vector<std::shared_ptr<RelAlgNode>>& nodes,
         break;
       }
       case CoalesceState::Filter: {
-        if (std::dynamic_pointer_cast<const RelProject>(ra_node)) {
+        if (std::dynamic_pointer_cast<const RelProject>(ra_node) &&
+            !is_window_function_project(ra_node.get())) {
           crt_pattern.push_back(size_t(nodeIt));
           crt_state = CoalesceState::FirstProject;
           nodeIt.advance(RANodeIterator::AdvancingMode::DUChain);
@@ -1342,6 +1534,7 @@ class RelAlgAbstractInterpreter {
     }
     CHECK(!nodes_.empty());
     bind_inputs(nodes_);
+    separate_window_function_expressions(nodes_);
     mark_nops(nodes_);
     simplify_sort(nodes_);
     sink_projected_boolean_expr_to_join(nodes_);
@@ -1398,6 +1591,8 @@ class RelAlgAbstractInterpreter {
         ra_node = dispatchLogicalValues(crt_node);
       } else if (rel_op == std::string("LogicalTableModify")) {
         ra_node = dispatchModify(crt_node);
+      } else if (rel_op == std::string("Sample")) {
+        ra_node = dispatchSample(crt_node);
       } else {
         throw QueryNotSupported(std::string("Node ") + rel_op + " not supported yet");
       }
@@ -1413,6 +1608,39 @@ class RelAlgAbstractInterpreter {
     return std::make_shared<RelScan>(td, field_names);
   }
 
+  // TABLESAMPLE filters the rows of the table on their row id, see TableSample.h.
+  std::shared_ptr<RelFilter> dispatchSample(const rapidjson::Value& sample_ra) {
+    const auto inputs = getRelAlgInputs(sample_ra);
+    CHECK_EQ(size_t(1), inputs.size());
+    const auto scan = std::dynamic_pointer_cast<const RelScan>(inputs.front());
+    if (!scan) {
+      throw QueryNotSupported("TABLESAMPLE is only supported on tables");
+    }
+    const auto& field_names = scan->getFieldNames();
+    const auto rowid_it = std::find(field_names.begin(), field_names.end(), "rowid");
+    CHECK(rowid_it != field_names.end());
+    const auto mode = json_str(field(sample_ra, "mode"));
+    CHECK(mode == std::string("bernoulli") || mode == std::string("system"));
+    const int64_t block_rows = mode == std::string("bernoulli")
+                                   ? 1
+                                   : scan->getTableDescriptor()->maxFragRows;
+    const auto& rate = field(sample_ra, "rate");
+    const double proportion =
+        rate.IsDouble() ? json_double(rate) : static_cast<double>(json_i64(rate));
+    // "-" unless REPEATABLE is given, the sample is the same for every query anyway.
+    const auto& repeatable_seed = field(sample_ra, "repeatableSeed");
+    const int64_t seed = repeatable_seed.IsString() ? 0 : json_i64(repeatable_seed);
+    std::vector<std::unique_ptr<const RexScalar>> operands;
+    operands.emplace_back(
+        new RexAbstractInput(std::distance(field_names.begin(), rowid_it)));
+    operands.emplace_back(new RexLiteral(block_rows, kDECIMAL, kBIGINT, 0, 19, 0, 19));
+    operands.emplace_back(new RexLiteral(proportion, kDOUBLE, kDOUBLE, 0, 15, 0, 15));
+    operands.emplace_back(new RexLiteral(seed, kDECIMAL, kBIGINT, 0, 19, 0, 19));
+    std::unique_ptr<const RexScalar> condition(
+        new RexFunctionOperator("table_sample", operands, SQLTypeInfo(kBOOLEAN, true)));
+    return std::make_shared<RelFilter>(condition, scan);
+  }
+
   std::shared_ptr<RelProject> dispatchProject(const rapidjson::Value& proj_ra) {
     const auto inputs = getRelAlgInputs(proj_ra);
     CHECK_EQ(size_t(1), inputs.size());
@@ -1616,7 +1844,7 @@ std::unique_ptr<const RexSubQuery> parse_subquery(const rapidjson::Value& expr,
   const auto& subquery_ast = field(expr, "subquery");
 
   const auto ra = ra_interpret(subquery_ast, cat, ra_executor);
-  auto subquery = std::make_shared<RexSubQuery>(ra);
+  auto subquery = std::make_shared<RexSubQuery>(ra, json_node_to_string(subquery_ast));
   ra_executor->registerSubquery(subquery);
   return subquery->deepCopy();
 }
@@ -1628,8 +1856,12 @@ std::shared_ptr<const RelAlgNode> deserialize_ra_dag(
     const std::string& query_ra,
     const Catalog_Namespace::Catalog& cat,
     RelAlgExecutor* ra_executor) {
+  // Parsed in place, the strings of the document point into the copy of the plan instead
+  // of being allocated one by one.
+  std::vector<char> query_ra_buffer(query_ra.begin(), query_ra.end());
+  query_ra_buffer.push_back('\0');
   rapidjson::Document query_ast;
-  query_ast.Parse(query_ra.c_str());
+  query_ast.ParseInsitu(query_ra_buffer.data());
   CHECK(!query_ast.HasParseError());
   CHECK(query_ast.IsObject());
   RelAlgNode::resetRelAlgFirstId();
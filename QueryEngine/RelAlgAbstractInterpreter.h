@@ -254,16 +254,21 @@ class ExecutionResult;
 
 class RexSubQuery : public RexScalar {
  public:
-  RexSubQuery(const std::shared_ptr<const RelAlgNode> ra)
+  // The serialized plan identifies the subquery across plans, it's empty for the ones
+  // recognized in the RA instead of sent by Calcite.
+  RexSubQuery(const std::shared_ptr<const RelAlgNode> ra,
+              const std::string& query_ra = "")
       : type_(new SQLTypeInfo(kNULLT, false))
       , result_(new std::shared_ptr<const ExecutionResult>(nullptr))
-      , ra_(ra) {}
+      , ra_(ra)
+      , query_ra_(query_ra) {}
 
   // for deep copy
   RexSubQuery(std::shared_ptr<SQLTypeInfo> type,
               std::shared_ptr<std::shared_ptr<const ExecutionResult>> result,
-              const std::shared_ptr<const RelAlgNode> ra)
-      : type_(type), result_(result), ra_(ra) {}
+              const std::shared_ptr<const RelAlgNode> ra,
+              const std::string& query_ra)
+      : type_(type), result_(result), ra_(ra), query_ra_(query_ra) {}
 
   RexSubQuery(const RexSubQuery&) = delete;
 
@@ -286,6 +291,8 @@ class RexSubQuery : public RexScalar {
 
   const RelAlgNode* getRelAlg() const { return ra_.get(); }
 
+  const std::string& getQueryRa() const { return query_ra_; }
+
   std::string toString() const override {
     return "(RexSubQuery " + std::to_string(reinterpret_cast<const uint64_t>(this)) + ")";
   }
@@ -298,6 +305,7 @@ class RexSubQuery : public RexScalar {
   std::shared_ptr<SQLTypeInfo> type_;
   std::shared_ptr<std::shared_ptr<const ExecutionResult>> result_;
   const std::shared_ptr<const RelAlgNode> ra_;
+  const std::string query_ra_;
 };
 
 // The actual input node understood by the Executor.
@@ -1016,6 +1024,87 @@ class SortField {
   const NullSortedPosition nulls_pos_;
 };
 
+// A window function call. The partition and order keys are kept as trailing operands,
+// after the arguments, so that the visitors which collect or rebind the inputs of an
+// operator see them as well.
+class RexWindowFunctionOperator : public RexFunctionOperator {
+ public:
+  RexWindowFunctionOperator(const std::string& name,
+                            const SqlWindowFunctionKind kind,
+                            ConstRexScalarPtrVector& operands,
+                            const size_t partition_key_count,
+                            const std::vector<SortField>& collation,
+                            const bool is_rows,
+                            const bool to_current_row,
+                            const SQLTypeInfo& ti)
+      : RexFunctionOperator(name, operands, ti)
+      , kind_(kind)
+      , partition_key_count_(partition_key_count)
+      , collation_(collation)
+      , is_rows_(is_rows)
+      , to_current_row_(to_current_row) {
+    CHECK_LE(partition_key_count_ + collation_.size(), size());
+  }
+
+  std::unique_ptr<const RexOperator> getDisambiguated(
+      std::vector<std::unique_ptr<const RexScalar>>& operands) const override {
+    return std::unique_ptr<const RexOperator>(
+        new RexWindowFunctionOperator(getName(),
+                                      kind_,
+                                      operands,
+                                      partition_key_count_,
+                                      collation_,
+                                      is_rows_,
+                                      to_current_row_,
+                                      getType()));
+  }
+
+  SqlWindowFunctionKind getKind() const { return kind_; }
+
+  size_t getArgCount() const {
+    return size() - partition_key_count_ - collation_.size();
+  }
+
+  size_t getPartitionKeyCount() const { return partition_key_count_; }
+
+  const RexScalar* getPartitionKey(const size_t i) const {
+    CHECK_LT(i, partition_key_count_);
+    return getOperand(getArgCount() + i);
+  }
+
+  // The field of each sort field is the index of the order key.
+  const std::vector<SortField>& getCollation() const { return collation_; }
+
+  const RexScalar* getOrderKey(const size_t i) const {
+    CHECK_LT(i, collation_.size());
+    return getOperand(size() - collation_.size() + i);
+  }
+
+  // The frame of the aggregates starts at the beginning of the partition and ends
+  // either at the current row (and its peers, unless is_rows) or with the partition.
+  bool isRows() const { return is_rows_; }
+
+  bool isFrameToCurrentRow() const { return to_current_row_; }
+
+  std::string toString() const override {
+    auto result = "(RexWindowFunctionOperator " + getName();
+    for (const auto& operand : operands_) {
+      result += (" " + operand->toString());
+    }
+    for (const auto& sort_field : collation_) {
+      result += (" " + sort_field.toString());
+    }
+    return result + ")";
+  }
+
+ private:
+  const SqlWindowFunctionKind kind_;
+  const size_t partition_key_count_;
+  const std::vector<SortField> collation_;
+  const bool is_rows_;
+  const bool to_current_row_;
+};
+
 class RelSort : public RelAlgNode {
  public:
   RelSort(const std::vector<SortField>& collation,
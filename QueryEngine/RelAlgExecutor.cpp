@@ -19,15 +19,25 @@
 
 #include "CalciteDeserializerUtils.h"
 #include "CardinalityEstimator.h"
+#include "ColumnarResultsCache.h"
 #include "EquiJoinCondition.h"
 #include "ExpressionRewrite.h"
 #include "InputMetadata.h"
 #include "JoinFilterPushDown.h"
+#include "QueryMemoryAccount.h"
 #include "QueryPhysicalInputsCollector.h"
+#include "QueryResultCache.h"
+#include "QueryScheduler.h"
 #include "RangeTableIndexVisitor.h"
 #include "RexVisitor.h"
+#include "SharedScans.h"
+#include "TableMetadataCache.h"
+#include "TypePunning.h"
+#include "WindowContext.h"
 
 #include "../Parser/ParserNode.h"
+#include "../Shared/Metrics.h"
+#include "../Shared/Tracing.h"
 #include "../Shared/measure.h"
 
 #include <algorithm>
@@ -109,6 +119,12 @@ void scanForTablesAndAggsInRelAlgSeqForRender(std::vector<RaExecutionDesc>& exec
   }
 }
 
+metrics::Counter& cpu_retry_count() {
+  static auto& counter = metrics::Registry::get().counter(
+      "mapd_cpu_retries_total", "Queries and work units run again on CPU");
+  return counter;
+}
+
 }  // namespace
 
 ExecutionResult RelAlgExecutor::executeRelAlgQuery(const std::string& query_ra,
@@ -123,6 +139,10 @@ ExecutionResult RelAlgExecutor::executeRelAlgQuery(const std::string& query_ra,
       throw;
     }
   }
+  cpu_retry_count().inc();
+  if (query_profile_) {
+    query_profile_->setCpuRetryReason("query must run on CPU");
+  }
   CompilationOptions co_cpu{ExecutorDeviceType::CPU,
                             co.hoist_literals_,
                             co.opt_level_,
@@ -135,15 +155,61 @@ ExecutionResult RelAlgExecutor::executeRelAlgQueryNoRetry(const std::string& que
                                                           const ExecutionOptions& eo,
                                                           RenderInfo* render_info) {
   INJECT_TIMER(executeRelAlgQueryNoRetry);
+  tracing::Span execute_span("execute_rel_alg");
+  execute_span.addAttribute(
+      "device", co.device_type_ == ExecutorDeviceType::GPU ? "GPU" : "CPU");
 
   const auto ra = deserialize_ra_dag(query_ra, cat_, this);
+  const auto priority = QueryScheduler::classify(estimateInputBytes(ra.get()));
+  const auto shareable_compound =
+      g_enable_shared_scans && !render_info && !eo.just_explain && !eo.just_validate &&
+              !eo.just_calcite_explain && !eo.find_push_down_candidates &&
+              subqueries_.empty()
+          ? SharedScans::getShareableCompound(ra.get())
+          : nullptr;
+  // While queued, the query running before this one can compute it in its own pass.
+  std::shared_ptr<SharedScanRequest> shared_scan_request;
+  if (shareable_compound) {
+    shared_scan_request = SharedScans::enqueue(
+        cat_.get_currentDB().dbId, shareable_compound, co.device_type_);
+  }
+  ScopeGuard withdraw_shared_scan = [&shared_scan_request] {
+    if (shared_scan_request) {
+      SharedScans::withdraw(shared_scan_request);
+    }
+  };
   // capture the lock acquistion time
   auto clock_begin = timer_start();
-  std::lock_guard<std::mutex> lock(executor_->execute_mutex_);
+  QueryScheduler::Admission admission(executor_->execute_mutex_, priority);
   int64_t queue_time_ms = timer_stop(clock_begin);
-  if (g_enable_dynamic_watchdog) {
-    executor_->resetInterrupt();
+  execute_span.addAttribute("queue_ms", queue_time_ms);
+  if (shared_scan_request) {
+    SharedScans::withdraw(shared_scan_request);
+    if (shared_scan_request->rows) {
+      ExecutionResult result{shared_scan_request->rows,
+                             shared_scan_request->targets_meta};
+      result.setQueueTime(queue_time_ms);
+      return result;
+    }
+  }
+  shared_scan_compound_ = shareable_compound;
+  QueryMemoryAccount::Scope memory_account_scope;
+  ScopeGuard record_peak_bytes = [this] {
+    if (query_profile_) {
+      query_profile_->setPeakBytes(
+          ExecutorDeviceType::CPU,
+          QueryMemoryAccount::getPeakBytes(ExecutorDeviceType::CPU));
+      query_profile_->setPeakBytes(
+          ExecutorDeviceType::GPU,
+          QueryMemoryAccount::getPeakBytes(ExecutorDeviceType::GPU));
+    }
+  };
+  if (query_profile_) {
+    query_profile_->addTime(QueryProfile::Phase::Queue, queue_time_ms * 1000);
   }
+  executor_->query_profile_ = query_profile_;
+  ScopeGuard reset_query_profile = [this] { executor_->query_profile_ = nullptr; };
+  executor_->resetInterrupt();
   ScopeGuard row_set_holder = [this, &render_info] {
     if (render_info) {
       // need to hold onto the RowSetMemOwner for potential
@@ -190,14 +256,28 @@ ExecutionResult RelAlgExecutor::executeRelAlgQueryNoRetry(const std::string& que
         ed_list, co, eo, render_info, queue_time_ms);
   }
 
+  boost::optional<QueryResultCacheKey> result_cache_key;
+  if (g_enable_query_result_cache && !render_info && !eo.just_explain &&
+      !eo.just_validate && !eo.just_calcite_explain &&
+      QueryResultCache::isCacheable(query_ra)) {
+    result_cache_key = QueryResultCacheKey(cat_.get_currentDB().dbId,
+                                           query_ra,
+                                           eo.output_columnar_hint,
+                                           executor_->table_generations_,
+                                           executor_->string_dictionary_generations_);
+    const auto cached = QueryResultCache::get(*result_cache_key);
+    if (cached) {
+      return {cached->rows, cached->targets_meta};
+    }
+  }
+
   // Dispatch the subqueries first
-  for (auto subquery : subqueries_) {
-    // Execute the subquery and cache the result.
-    RelAlgExecutor ra_executor(executor_, cat_);
-    auto result = ra_executor.executeRelAlgSubQuery(subquery.get(), co, eo);
-    subquery->setExecutionResult(std::make_shared<ExecutionResult>(result));
+  executeSubqueries(co, eo);
+  auto result = executeRelAlgSeq(ed_list, co, eo, render_info, queue_time_ms);
+  if (result_cache_key && result.getRows()) {
+    QueryResultCache::put(*result_cache_key, {result.getRows(), result.getTargetsMeta()});
   }
-  return executeRelAlgSeq(ed_list, co, eo, render_info, queue_time_ms);
+  return result;
 }
 
 namespace {
@@ -229,11 +309,9 @@ AggregatedColRange RelAlgExecutor::computeColRangesCache(const RelAlgNode* ra) {
   AggregatedColRange agg_col_range_cache;
   const auto phys_inputs = get_physical_inputs(cat_, ra);
   const auto phys_table_ids = get_physical_table_ids(phys_inputs);
+  const int db_id = cat_.get_currentDB().dbId;
   std::vector<InputTableInfo> query_infos;
   executor_->catalog_ = &cat_;
-  for (const int table_id : phys_table_ids) {
-    query_infos.emplace_back(InputTableInfo{table_id, executor_->getTableInfo(table_id)});
-  }
   for (const auto& phys_input : phys_inputs) {
     const auto cd = cat_.getMetadataForColumn(phys_input.table_id, phys_input.col_id);
     CHECK(cd);
@@ -241,10 +319,25 @@ AggregatedColRange RelAlgExecutor::computeColRangesCache(const RelAlgNode* ra) {
         cd->columnType.is_array() ? cd->columnType.get_elem_type() : cd->columnType;
     if (col_ti.is_number() || col_ti.is_boolean() || col_ti.is_time() ||
         (col_ti.is_string() && col_ti.get_compression() == kENCODING_DICT)) {
+      // Ranges of the same fragments the query runs on, computed by a previous query.
+      const auto table_info = executor_->getSharedTableInfo(phys_input.table_id);
+      const auto cached_col_range =
+          TableMetadataCache::getColRange(db_id, phys_input, table_info.get());
+      if (cached_col_range) {
+        agg_col_range_cache.setColRange(phys_input, *cached_col_range);
+        continue;
+      }
+      if (query_infos.empty()) {
+        for (const int table_id : phys_table_ids) {
+          query_infos.emplace_back(
+              InputTableInfo{table_id, executor_->getTableInfo(table_id)});
+        }
+      }
       const auto col_var = boost::make_unique<Analyzer::ColumnVar>(
           cd->columnType, phys_input.table_id, phys_input.col_id, 0);
       const auto col_range =
           getLeafColumnRange(col_var.get(), query_infos, executor_, false);
+      TableMetadataCache::putColRange(db_id, phys_input, table_info.get(), col_range);
       agg_col_range_cache.setColRange(phys_input, col_range);
     }
   }
@@ -275,13 +368,43 @@ TableGenerations RelAlgExecutor::computeTableGenerations(const RelAlgNode* ra) {
   const auto phys_table_ids = get_physical_table_inputs(ra);
   TableGenerations table_generations;
   for (const int table_id : phys_table_ids) {
-    const auto table_info = executor_->getTableInfo(table_id);
+    const auto table_info = executor_->getSharedTableInfo(table_id);
     table_generations.setGeneration(
-        table_id, TableGeneration{table_info.getPhysicalNumTuples(), 0});
+        table_id, TableGeneration{table_info->getPhysicalNumTuples(), 0});
   }
   return table_generations;
 }
 
+size_t RelAlgExecutor::estimateInputBytes(const RelAlgNode* ra) const {
+  // Runs before the executor is ours, only the catalog is used.
+  std::unordered_map<int, size_t> table_tuple_counts;
+  for (const int table_id : get_physical_table_inputs(ra)) {
+    const auto td = cat_.getMetadataForTable(table_id);
+    if (!td) {
+      continue;
+    }
+    size_t tuple_count{0};
+    for (const auto shard_td : cat_.getPhysicalTablesDescriptors(td)) {
+      CHECK(shard_td->fragmenter);
+      tuple_count += shard_td->fragmenter->getFragmentsForQuery().getPhysicalNumTuples();
+    }
+    table_tuple_counts.emplace(table_id, tuple_count);
+  }
+  size_t input_bytes{0};
+  for (const auto& phys_input : get_physical_inputs(cat_, ra)) {
+    const auto it = table_tuple_counts.find(phys_input.table_id);
+    const auto cd = cat_.getMetadataForColumn(phys_input.table_id, phys_input.col_id);
+    if (it == table_tuple_counts.end() || !cd) {
+      continue;
+    }
+    const auto col_size = cd->columnType.get_size();
+    // The variable length columns count as an offset and a short payload.
+    input_bytes +=
+        it->second * (col_size > 0 ? static_cast<size_t>(col_size) : 2 * sizeof(int64_t));
+  }
+  return input_bytes;
+}
+
 Executor* RelAlgExecutor::getExecutor() const {
   return executor_;
 }
@@ -332,9 +455,7 @@ void RelAlgExecutor::prepareLeafExecution(
     const TableGenerations& table_generations) {
   // capture the lock acquistion time
   auto clock_begin = timer_start();
-  if (g_enable_dynamic_watchdog) {
-    executor_->resetInterrupt();
-  }
+  executor_->resetInterrupt();
   queue_time_ms_ = timer_stop(clock_begin);
   executor_->row_set_mem_owner_ = std::make_shared<RowSetMemoryOwner>();
   executor_->table_generations_ = table_generations;
@@ -350,6 +471,57 @@ ExecutionResult RelAlgExecutor::executeRelAlgSubQuery(const RexSubQuery* subquer
   return executeRelAlgSeq(ed_list, co, eo, nullptr, 0);
 }
 
+void RelAlgExecutor::executeSubqueries(const CompilationOptions& co,
+                                       const ExecutionOptions& eo) {
+  // The same subquery sent twice in a plan reads the same data, run it only once.
+  std::unordered_map<std::string, std::shared_ptr<const ExecutionResult>> plan_results;
+  for (auto subquery : subqueries_) {
+    const auto& query_ra = subquery->getQueryRa();
+    if (!query_ra.empty()) {
+      const auto it = plan_results.find(query_ra);
+      if (it != plan_results.end()) {
+        subquery->setExecutionResult(it->second);
+        continue;
+      }
+    }
+    boost::optional<QueryResultCacheKey> result_cache_key;
+    if (g_enable_subquery_result_cache && !query_ra.empty() && !eo.just_explain &&
+        !eo.just_validate && QueryResultCache::isCacheable(query_ra)) {
+      // Only the tables the subquery reads invalidate its result.
+      TableGenerations subquery_table_generations;
+      for (const auto table_id : get_physical_table_inputs(subquery->getRelAlg())) {
+        subquery_table_generations.setGeneration(
+            table_id, executor_->table_generations_.getGeneration(table_id));
+      }
+      result_cache_key = QueryResultCacheKey(cat_.get_currentDB().dbId,
+                                             query_ra,
+                                             eo.output_columnar_hint,
+                                             subquery_table_generations,
+                                             executor_->string_dictionary_generations_);
+    }
+    boost::optional<QueryResultCache::CachedResult> cached;
+    if (result_cache_key) {
+      cached = QueryResultCache::get(*result_cache_key);
+    }
+    std::shared_ptr<const ExecutionResult> result;
+    if (cached) {
+      result = std::make_shared<ExecutionResult>(cached->rows, cached->targets_meta);
+    } else {
+      RelAlgExecutor ra_executor(executor_, cat_);
+      result = std::make_shared<ExecutionResult>(
+          ra_executor.executeRelAlgSubQuery(subquery.get(), co, eo));
+      if (result_cache_key && result->getRows()) {
+        QueryResultCache::put(*result_cache_key,
+                              {result->getRows(), result->getTargetsMeta()});
+      }
+    }
+    subquery->setExecutionResult(result);
+    if (!query_ra.empty()) {
+      plan_results.emplace(query_ra, result);
+    }
+  }
+}
+
 ExecutionResult RelAlgExecutor::executeRelAlgSeq(std::vector<RaExecutionDesc>& exec_descs,
                                                  const CompilationOptions& co,
                                                  const ExecutionOptions& eo,
@@ -357,9 +529,11 @@ ExecutionResult RelAlgExecutor::executeRelAlgSeq(std::vector<RaExecutionDesc>& e
                                                  const int64_t queue_time_ms) {
   INJECT_TIMER(executeRelAlgSeq);
   decltype(temporary_tables_)().swap(temporary_tables_);
+  decltype(temporary_table_cache_keys_)().swap(temporary_table_cache_keys_);
   decltype(target_exprs_owned_)().swap(target_exprs_owned_);
   executor_->catalog_ = &cat_;
   executor_->temporary_tables_ = &temporary_tables_;
+  executor_->temporary_table_cache_keys_ = &temporary_table_cache_keys_;
 
   // we will have to make sure the temp tables generated as a result of execution of inner
   // subqueries are available throughout the execution of the sequence.
@@ -373,6 +547,9 @@ ExecutionResult RelAlgExecutor::executeRelAlgSeq(std::vector<RaExecutionDesc>& e
   CHECK(!exec_descs.empty());
   const auto exec_desc_count = eo.just_explain ? size_t(1) : exec_descs.size();
   for (size_t i = 0; i < exec_desc_count; ++i) {
+    if (query_profile_) {
+      query_profile_->setStep(exec_descs[i].getBody()->getId());
+    }
     // only render on the last step
     executeRelAlgStep(i,
                       exec_descs,
@@ -467,6 +644,9 @@ void RelAlgExecutor::executeRelAlgStep(const size_t i,
     handleNop(exec_desc);
     return;
   }
+  tracing::Span step_span("step");
+  step_span.addAttribute("node_id", static_cast<int64_t>(body->getId()));
+  addTemporaryTableCacheKey(body, eo);
   const ExecutionOptions eo_work_unit{
       eo.output_columnar_hint,
       eo.allow_multifrag,
@@ -558,6 +738,30 @@ void RelAlgExecutor::executeRelAlgStep(const size_t i,
   CHECK(false);
 }
 
+void RelAlgExecutor::addTemporaryTableCacheKey(const RelAlgNode* body,
+                                               const ExecutionOptions& eo) {
+  if (!g_enable_columnar_results_cache || eo.just_explain || eo.just_validate) {
+    return;
+  }
+  const auto plan_key = ColumnarResultsCache::getPlanKey(body);
+  if (plan_key.empty()) {
+    return;
+  }
+  // Only the tables the step reads invalidate the columnar form of its output.
+  TableGenerations step_table_generations;
+  for (const auto table_id : get_physical_table_inputs(body)) {
+    step_table_generations.setGeneration(
+        table_id, executor_->table_generations_.getGeneration(table_id));
+  }
+  temporary_table_cache_keys_.emplace(
+      -body->getId(),
+      QueryResultCacheKey(cat_.get_currentDB().dbId,
+                          plan_key,
+                          false,
+                          step_table_generations,
+                          executor_->string_dictionary_generations_));
+}
+
 void RelAlgExecutor::handleNop(RaExecutionDesc& ed) {
   // just set the result of the previous node as the result of no op
   auto body = ed.getBody();
@@ -569,6 +773,10 @@ void RelAlgExecutor::handleNop(RaExecutionDesc& ed) {
   CHECK(it != temporary_tables_.end());
   // set up temp table as it could be used by the outer query or next step
   addTemporaryTable(-body->getId(), it->second);
+  const auto key_it = temporary_table_cache_keys_.find(-input->getId());
+  if (key_it != temporary_table_cache_keys_.end()) {
+    temporary_table_cache_keys_.emplace(-body->getId(), key_it->second);
+  }
 
   ed.setResult({it->second, input->getOutputMetainfo()});
 }
@@ -1275,6 +1483,9 @@ ExecutionResult RelAlgExecutor::executeCompound(const RelCompound* compound,
   if (work_unit.exe_unit.query_features.isCPUOnlyExecutionRequired()) {
     co_compound.device_type_ = ExecutorDeviceType::CPU;
   }
+  if (compound == shared_scan_compound_) {
+    return executeSharedScan(work_unit, co.device_type_, co_compound, eo, queue_time_ms);
+  }
   return executeWorkUnit(work_unit,
                          compound->getOutputMetainfo(),
                          compound->isAggregate(),
@@ -1284,6 +1495,150 @@ ExecutionResult RelAlgExecutor::executeCompound(const RelCompound* compound,
                          queue_time_ms);
 }
 
+namespace {
+
+bool is_shareable_scan(const RelAlgExecutionUnit& ra_exe_unit) {
+  if (ra_exe_unit.input_descs.size() != 1 ||
+      ra_exe_unit.input_descs.front().getSourceType() != InputSourceType::TABLE ||
+      !ra_exe_unit.inner_joins.empty() || !ra_exe_unit.inner_join_quals.empty() ||
+      ra_exe_unit.groupby_exprs.size() != 1 || ra_exe_unit.groupby_exprs.front() ||
+      ra_exe_unit.estimator || ra_exe_unit.scan_limit ||
+      ra_exe_unit.target_exprs.empty()) {
+    return false;
+  }
+  for (const auto target_expr : ra_exe_unit.target_exprs) {
+    const auto agg_expr = dynamic_cast<const Analyzer::AggExpr*>(target_expr);
+    if (!agg_expr || agg_expr->get_is_distinct()) {
+      return false;
+    }
+    switch (agg_expr->get_aggtype()) {
+      case kCOUNT:
+      case kSUM:
+      case kAVG:
+      case kMIN:
+      case kMAX:
+        break;
+      default:
+        return false;
+    }
+    const auto arg = agg_expr->get_arg();
+    if (arg && !arg->get_type_info().is_number() && !arg->get_type_info().is_time() &&
+        !arg->get_type_info().is_boolean()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool same_quals(const std::list<std::shared_ptr<Analyzer::Expr>>& lhs,
+                const std::list<std::shared_ptr<Analyzer::Expr>>& rhs) {
+  return lhs.size() == rhs.size() &&
+         std::equal(lhs.begin(),
+                    lhs.end(),
+                    rhs.begin(),
+                    [](const std::shared_ptr<Analyzer::Expr>& lhs_qual,
+                       const std::shared_ptr<Analyzer::Expr>& rhs_qual) {
+                      return *lhs_qual == *rhs_qual;
+                    });
+}
+
+}  // namespace
+
+ExecutionResult RelAlgExecutor::executeSharedScan(const WorkUnit& work_unit,
+                                                  const ExecutorDeviceType device_type,
+                                                  const CompilationOptions& co,
+                                                  const ExecutionOptions& eo,
+                                                  const int64_t queue_time_ms) {
+  const auto compound = static_cast<const RelCompound*>(work_unit.body);
+  const auto& ra_exe_unit = work_unit.exe_unit;
+  // The aggregator merges the results of the leaves instead.
+  if (!leaf_results_.empty() || !is_shareable_scan(ra_exe_unit)) {
+    return executeWorkUnit(
+        work_unit, compound->getOutputMetainfo(), true, co, eo, nullptr, queue_time_ms);
+  }
+  // The requests not answered here run on their own once admitted.
+  const auto requests =
+      SharedScans::take(cat_.get_currentDB().dbId,
+                        ra_exe_unit.input_descs.front().getTableId(),
+                        device_type);
+  auto fused_exe_unit = ra_exe_unit;
+  auto fused_targets_meta = compound->getOutputMetainfo();
+  std::vector<std::pair<std::shared_ptr<SharedScanRequest>, size_t>> fused_requests;
+  for (const auto& request : requests) {
+    const auto request_work_unit = createCompoundWorkUnit(
+        request->compound, {{}, SortAlgorithm::Default, 0, 0}, false);
+    const auto& request_exe_unit = request_work_unit.exe_unit;
+    if (!is_shareable_scan(request_exe_unit) ||
+        request_exe_unit.query_features.isCPUOnlyExecutionRequired() !=
+            ra_exe_unit.query_features.isCPUOnlyExecutionRequired() ||
+        !(request_exe_unit.input_descs == ra_exe_unit.input_descs) ||
+        !same_quals(request_exe_unit.simple_quals, ra_exe_unit.simple_quals) ||
+        !same_quals(request_exe_unit.quals, ra_exe_unit.quals)) {
+      continue;
+    }
+    fused_requests.emplace_back(request, fused_exe_unit.target_exprs.size());
+    fused_exe_unit.target_exprs.insert(fused_exe_unit.target_exprs.end(),
+                                       request_exe_unit.target_exprs.begin(),
+                                       request_exe_unit.target_exprs.end());
+    auto& fused_col_descs = fused_exe_unit.input_col_descs;
+    for (const auto& col_desc : request_exe_unit.input_col_descs) {
+      const auto it = std::find_if(
+          fused_col_descs.begin(),
+          fused_col_descs.end(),
+          [&col_desc](const std::shared_ptr<const InputColDescriptor>& fused_col_desc) {
+            return *fused_col_desc == *col_desc;
+          });
+      if (it == fused_col_descs.end()) {
+        fused_col_descs.push_back(col_desc);
+      }
+    }
+    const auto& targets_meta = request->compound->getOutputMetainfo();
+    fused_targets_meta.insert(
+        fused_targets_meta.end(), targets_meta.begin(), targets_meta.end());
+    for (const auto& col_range : computeColRangesCache(request->compound).asMap()) {
+      executor_->agg_col_range_cache_.setColRange(col_range.first, col_range.second);
+    }
+  }
+  if (fused_requests.empty()) {
+    return executeWorkUnit(
+        work_unit, compound->getOutputMetainfo(), true, co, eo, nullptr, queue_time_ms);
+  }
+  const auto fused_result =
+      executeWorkUnit({fused_exe_unit, compound, work_unit.max_groups_buffer_entry_guess},
+                      fused_targets_meta,
+                      true,
+                      co,
+                      eo,
+                      nullptr,
+                      queue_time_ms);
+  const auto& fused_rows = fused_result.getRows();
+  const auto& fused_query_mem_desc = fused_rows->getQueryMemDesc();
+  if (!fused_rows->getStorage() || fused_rows->entryCount() != 1 ||
+      fused_query_mem_desc.getQueryDescriptionType() !=
+          QueryDescriptionType::NonGroupedAggregate ||
+      fused_query_mem_desc.didOutputColumnar()) {
+    return executeWorkUnit(
+        work_unit, compound->getOutputMetainfo(), true, co, eo, nullptr, queue_time_ms);
+  }
+  for (size_t i = 0; i < fused_requests.size(); ++i) {
+    const auto& request = fused_requests[i].first;
+    const auto first_target = fused_requests[i].second;
+    const auto target_count = (i + 1 < fused_requests.size()
+                                   ? fused_requests[i + 1].second
+                                   : fused_exe_unit.target_exprs.size()) -
+                              first_target;
+    request->rows =
+        SharedScans::extractTargets(*fused_rows, first_target, target_count, executor_);
+    request->targets_meta = request->compound->getOutputMetainfo();
+  }
+  ExecutionResult result{
+      SharedScans::extractTargets(
+          *fused_rows, 0, ra_exe_unit.target_exprs.size(), executor_),
+      compound->getOutputMetainfo()};
+  result.setQueueTime(queue_time_ms);
+  return result;
+}
+
 ExecutionResult RelAlgExecutor::executeAggregate(const RelAggregate* aggregate,
                                                  const CompilationOptions& co,
                                                  const ExecutionOptions& eo,
@@ -1455,6 +1810,7 @@ ExecutionResult RelAlgExecutor::executeSort(const RelSort* sort,
     const auto order_entries = get_order_entries(sort);
     if (limit || offset) {
       if (!order_entries.empty()) {
+        QueryProfile::Timer sort_timer(query_profile_, QueryProfile::Phase::Sort);
         result_rows->sort(order_entries, limit + offset);
       }
       result_rows->dropFirstN(offset);
@@ -1496,6 +1852,7 @@ ExecutionResult RelAlgExecutor::executeSort(const RelSort* sort,
       if (sort->collationCount() != 0 && !rows_to_sort->definitelyHasNoRows() &&
           !use_speculative_top_n(source_work_unit.exe_unit,
                                  rows_to_sort->getQueryMemDesc())) {
+        QueryProfile::Timer sort_timer(query_profile_, QueryProfile::Phase::Sort);
         rows_to_sort->sort(source_work_unit.exe_unit.sort_info.order_entries,
                            limit + offset);
       }
@@ -1573,7 +1930,8 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createSortInputWorkUnit(
           max_groups_buffer_entry_guess,
           std::move(source_work_unit.query_rewriter),
           source_work_unit.input_permutation,
-          source_work_unit.left_deep_join_input_sizes};
+          source_work_unit.left_deep_join_input_sizes,
+          source_work_unit.join_order_info};
 }
 
 namespace {
@@ -1594,6 +1952,65 @@ size_t groups_approx_upper_bound(const std::vector<InputTableInfo>& table_infos)
   return std::max(max_num_groups, size_t(1));
 }
 
+// Entry count of the baseline hash group by buffer of a CPU kernel which can't overflow:
+// a CPU kernel scans a single fragment, which has at most as many groups as rows, and
+// the buffer is kept at most half full to keep the probes short. Zero when the groups
+// could outnumber the rows, with joins or unnested arrays, or when the buffers for all
+// the fragments, which the reduction merges into one, would exceed the memory budget.
+size_t fragment_bounded_group_count(const RelAlgExecutionUnit& ra_exe_unit,
+                                    const std::vector<InputTableInfo>& table_infos) {
+  if (table_infos.size() != 1) {
+    return 0;
+  }
+  for (const auto& groupby_expr : ra_exe_unit.groupby_exprs) {
+    const auto uoper = dynamic_cast<const Analyzer::UOper*>(groupby_expr.get());
+    if (!groupby_expr || (uoper && uoper->get_optype() == kUNNEST)) {
+      return 0;
+    }
+  }
+  size_t max_fragment_rows{0};
+  size_t total_rows{0};
+  for (const auto& fragment : table_infos.front().info.fragments) {
+    max_fragment_rows = std::max(max_fragment_rows, fragment.getNumTuples());
+    total_rows += fragment.getNumTuples();
+  }
+  static const size_t max_bytes{size_t(1) << 30};
+  const auto row_bytes =
+      (ra_exe_unit.groupby_exprs.size() + ra_exe_unit.target_exprs.size()) * 8;
+  if (!max_fragment_rows || 2 * total_rows * row_bytes > max_bytes) {
+    return 0;
+  }
+  return 2 * max_fragment_rows;
+}
+
+// Entry count of the projection buffer of a kernel which can't overflow, to run the
+// projection without counting the rows which pass the filters first: a kernel outputs
+// at most the rows of its fragment, or of all the fragments on a GPU with multifragment
+// kernels. Zero for joins, which can output more rows than they scan, or when the
+// buffers of all the kernels, which the result holds at once, exceed the budget.
+size_t fragment_bounded_projection_count(const RelAlgExecutionUnit& ra_exe_unit,
+                                         const std::vector<InputTableInfo>& table_infos,
+                                         const ExecutorDeviceType device_type,
+                                         const bool allow_multifrag) {
+  if (!g_projection_single_pass_max_bytes || table_infos.size() != 1 ||
+      ra_exe_unit.input_descs.size() != 1 || !ra_exe_unit.inner_joins.empty()) {
+    return 0;
+  }
+  size_t max_fragment_rows{0};
+  size_t total_rows{0};
+  for (const auto& fragment : table_infos.front().info.fragments) {
+    max_fragment_rows = std::max(max_fragment_rows, fragment.getNumTuples());
+    total_rows += fragment.getNumTuples();
+  }
+  // a slot per target and one for the row id
+  const auto row_bytes = (ra_exe_unit.target_exprs.size() + 1) * 8;
+  if (!max_fragment_rows || total_rows * row_bytes > g_projection_single_pass_max_bytes) {
+    return 0;
+  }
+  return device_type == ExecutorDeviceType::GPU && allow_multifrag ? total_rows
+                                                                   : max_fragment_rows;
+}
+
 bool can_use_scan_limit(const RelAlgExecutionUnit& ra_exe_unit) {
   for (const auto target_expr : ra_exe_unit.target_exprs) {
     if (dynamic_cast<const Analyzer::AggExpr*>(target_expr)) {
@@ -1677,6 +2094,87 @@ RelAlgExecutionUnit decide_approx_count_distinct_implementation(
   return ra_exe_unit;
 }
 
+// The first integer group by key of a query whose groups can be computed a subset at a
+// time, null otherwise.
+std::shared_ptr<Analyzer::Expr> get_group_by_partition_key(
+    const RelAlgExecutionUnit& ra_exe_unit) {
+  if (ra_exe_unit.sort_info.algorithm != SortAlgorithm::Default ||
+      ra_exe_unit.scan_limit || ra_exe_unit.estimator) {
+    return nullptr;
+  }
+  for (const auto& groupby_expr : ra_exe_unit.groupby_exprs) {
+    if (groupby_expr && groupby_expr->get_type_info().is_integer()) {
+      return groupby_expr;
+    }
+  }
+  return nullptr;
+}
+
+// Keeps the rows whose key is in the given partition: the partition of a key is its
+// value modulo the partition count, the null keys go to the first partition.
+std::shared_ptr<Analyzer::Expr> make_group_by_partition_qual(
+    const std::shared_ptr<Analyzer::Expr>& key,
+    const size_t partition_count,
+    const size_t partition) {
+  const auto key_i64 = key->deep_copy()->add_cast(
+      SQLTypeInfo(kBIGINT, key->get_type_info().get_notnull()));
+  const auto bigint_constant = [](const int64_t val) {
+    Datum d;
+    d.bigintval = val;
+    return makeExpr<Analyzer::Constant>(kBIGINT, false, d);
+  };
+  const auto remainder =
+      makeExpr<Analyzer::BinOper>(key_i64->get_type_info(),
+                                  false,
+                                  kMODULO,
+                                  kONE,
+                                  key_i64,
+                                  bigint_constant(partition_count));
+  const auto remainder_is = [&remainder, &bigint_constant](const int64_t val) {
+    return makeExpr<Analyzer::BinOper>(
+        kBOOLEAN, kEQ, kONE, remainder, bigint_constant(val));
+  };
+  // The remainder of a negative key is negative.
+  std::shared_ptr<Analyzer::Expr> qual = makeExpr<Analyzer::BinOper>(
+      kBOOLEAN,
+      kOR,
+      kONE,
+      remainder_is(partition),
+      remainder_is(static_cast<int64_t>(partition) -
+                   static_cast<int64_t>(partition_count)));
+  if (partition == 0 && !key->get_type_info().get_notnull()) {
+    qual = makeExpr<Analyzer::BinOper>(
+        kBOOLEAN,
+        kOR,
+        kONE,
+        qual,
+        makeExpr<Analyzer::UOper>(kBOOLEAN, kISNULL, key->deep_copy()));
+  }
+  return qual;
+}
+
+// The group by ran out of host memory, or of output slots and the watchdog wouldn't let
+// it try again with more.
+bool group_by_needs_partitions(const int32_t error_code,
+                               const RelAlgExecutionUnit& ra_exe_unit) {
+  if (!g_enable_group_by_partitioning) {
+    return false;
+  }
+  if (error_code != Executor::ERR_OUT_OF_CPU_MEM &&
+      !(error_code == Executor::ERR_OUT_OF_SLOTS && g_enable_watchdog)) {
+    return false;
+  }
+  return get_group_by_partition_key(ra_exe_unit) != nullptr;
+}
+
+bool is_window_execution_unit(const RelAlgExecutionUnit& ra_exe_unit) {
+  return std::any_of(ra_exe_unit.target_exprs.begin(),
+                     ra_exe_unit.target_exprs.end(),
+                     [](const Analyzer::Expr* target_expr) {
+                       return dynamic_cast<const Analyzer::WindowFunction*>(target_expr);
+                     });
+}
+
 }  // namespace
 
 ExecutionResult RelAlgExecutor::executeWorkUnit(
@@ -1707,6 +2205,12 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
     body->setOutputMetainfo(aggregated_result.targets_meta);
     return result;
   }
+  if (is_window_execution_unit(work_unit.exe_unit)) {
+    if (render_info) {
+      throw std::runtime_error("Window functions not supported in render queries");
+    }
+    return executeWindowFunctionWorkUnit(work_unit, targets_meta, co, eo, queue_time_ms);
+  }
   int32_t error_code{0};
 
   const auto table_infos = get_table_infos(work_unit.exe_unit, executor_);
@@ -1715,10 +2219,22 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
       work_unit.exe_unit, table_infos, executor_, co.device_type_, target_exprs_owned_);
   auto max_groups_buffer_entry_guess = work_unit.max_groups_buffer_entry_guess;
 
+  if (!eo.just_explain) {
+    sampleQualSelectivity(ra_exe_unit, table_infos, co, eo);
+  }
+
   if (!eo.just_explain && can_use_scan_limit(ra_exe_unit) && !isRowidLookup(work_unit)) {
-    const auto filter_count_all = getFilteredCountAll(work_unit, true, co, eo);
-    if (filter_count_all >= 0) {
-      ra_exe_unit.scan_limit = std::max(filter_count_all, ssize_t(1));
+    // Without a scan limit, a kernel running out of output slots fails the query and the
+    // retry runs it again on the CPU, a bound on the rows of the kernels avoids both.
+    const auto projection_bound = fragment_bounded_projection_count(
+        ra_exe_unit, table_infos, co.device_type_, eo.allow_multifrag);
+    if (projection_bound && !ra_exe_unit.scan_limit) {
+      max_groups_buffer_entry_guess = projection_bound;
+    } else {
+      const auto filter_count_all = getFilteredCountAll(work_unit, true, co, eo);
+      if (filter_count_all >= 0) {
+        ra_exe_unit.scan_limit = std::max(filter_count_all, ssize_t(1));
+      }
     }
   }
 
@@ -1746,9 +2262,14 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
                   groups_approx_upper_bound(table_infos) <= big_group_threshold),
               targets_meta};
   } catch (const CardinalityEstimationRequired&) {
+    const auto fragment_bound =
+        g_enable_fragment_bounded_group_by && co.device_type_ == ExecutorDeviceType::CPU
+            ? fragment_bounded_group_count(ra_exe_unit, table_infos)
+            : 0;
     max_groups_buffer_entry_guess =
-        2 * std::min(groups_approx_upper_bound(table_infos),
-                     getNDVEstimation(work_unit, is_agg, co, eo));
+        fragment_bound ? fragment_bound
+                       : 2 * std::min(groups_approx_upper_bound(table_infos),
+                                      getNDVEstimation(work_unit, is_agg, co, eo));
     CHECK_GT(max_groups_buffer_entry_guess, size_t(0));
     result = {executor_->executeWorkUnit(&error_code,
                                          max_groups_buffer_entry_guess,
@@ -1765,6 +2286,9 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
   }
 
   result.setQueueTime(queue_time_ms);
+  if (eo.just_explain && !work_unit.join_order_info.empty()) {
+    result.getRows()->prependExplanation(work_unit.join_order_info);
+  }
   if (render_info) {
     CHECK_GE(target_exprs_owned_.size(), targets_meta.size());
     render_info->targets.clear();
@@ -1785,6 +2309,10 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
   if (!error_code) {
     return result;
   }
+  if (group_by_needs_partitions(error_code, ra_exe_unit)) {
+    return executePartitionedGroupBy(
+        work_unit, targets_meta, is_agg, co, eo, queue_time_ms);
+  }
   handlePersistentError(error_code);
   return handleRetry(error_code,
                      {ra_exe_unit, work_unit.body, max_groups_buffer_entry_guess},
@@ -1795,6 +2323,34 @@ ExecutionResult RelAlgExecutor::executeWorkUnit(
                      queue_time_ms);
 }
 
+// Wraps the quals of a scan over a table with several fragments in their selectivity
+// on the first fragment. The code generator uses it to evaluate the cheap, selective
+// quals first and to short-circuit the rest.
+void RelAlgExecutor::sampleQualSelectivity(RelAlgExecutionUnit& ra_exe_unit,
+                                           const std::vector<InputTableInfo>& table_infos,
+                                           const CompilationOptions& co,
+                                           const ExecutionOptions& eo) {
+  if (!g_enable_adaptive_filter_ordering || ra_exe_unit.quals.size() < 2 ||
+      ra_exe_unit.input_descs.size() != 1 ||
+      ra_exe_unit.input_descs.front().getSourceType() != InputSourceType::TABLE) {
+    return;
+  }
+  CHECK_EQ(size_t(1), table_infos.size());
+  if (table_infos.front().info.fragments.size() < 2) {
+    return;
+  }
+  for (auto& qual : ra_exe_unit.quals) {
+    if (std::dynamic_pointer_cast<const Analyzer::LikelihoodExpr>(qual)) {
+      // Keep the likelihood given in the query.
+      continue;
+    }
+    const auto selectivity = getFilterSelectivity({qual}, co, eo, true);
+    if (selectivity.is_valid) {
+      qual = makeExpr<Analyzer::LikelihoodExpr>(qual, selectivity.fraction_passing);
+    }
+  }
+}
+
 ssize_t RelAlgExecutor::getFilteredCountAll(const WorkUnit& work_unit,
                                             const bool is_agg,
                                             const CompilationOptions& co,
@@ -1885,6 +2441,22 @@ bool RelAlgExecutor::isRowidLookup(const WorkUnit& work_unit) {
   return false;
 }
 
+namespace {
+
+// Input bytes of a wave, a quarter of the smallest GPU buffer pool: the hash tables, the
+// output buffers and the chunks of the previous wave on their way out need the rest.
+size_t get_gpu_wave_bytes(const Catalog_Namespace::Catalog& cat) {
+  size_t min_pool_bytes = std::numeric_limits<size_t>::max();
+  for (const auto& memory_info :
+       cat.get_dataMgr().getMemoryInfo(Data_Namespace::MemoryLevel::GPU_LEVEL)) {
+    min_pool_bytes =
+        std::min(min_pool_bytes, memory_info.maxNumPages * memory_info.pageSize);
+  }
+  return min_pool_bytes == std::numeric_limits<size_t>::max() ? 0 : min_pool_bytes / 4;
+}
+
+}  // namespace
+
 ExecutionResult RelAlgExecutor::handleRetry(
     const int32_t error_code_in,
     const RelAlgExecutor::WorkUnit& work_unit,
@@ -1912,6 +2484,47 @@ ExecutionResult RelAlgExecutor::handleRetry(
                                                      executor_),
                          {}};
   const auto table_infos = get_table_infos(work_unit.exe_unit, executor_);
+  const auto gpu_wave_bytes =
+      g_enable_gpu_waves && co.device_type_ == ExecutorDeviceType::GPU
+          ? get_gpu_wave_bytes(cat_)
+          : 0;
+  if (error_code == Executor::ERR_OUT_OF_GPU_MEM && eo.allow_multifrag &&
+      gpu_wave_bytes) {
+    // Still on the GPU, the outer fragments of each device in waves of multi-fragment
+    // kernels run one after the other, each one unpinning its chunks for the next.
+    ExecutionOptions eo_waves{eo.output_columnar_hint,
+                              true,
+                              false,
+                              eo.allow_loop_joins,
+                              eo.with_watchdog,
+                              eo.jit_debug,
+                              false,
+                              eo.with_dynamic_watchdog,
+                              eo.dynamic_watchdog_time_limit,
+                              false,
+                              false,
+                              gpu_wave_bytes};
+    VLOG(1) << "Query ran out of GPU memory, retry in waves of " << gpu_wave_bytes
+            << " bytes";
+    const auto ra_exe_unit = decide_approx_count_distinct_implementation(
+        work_unit.exe_unit, table_infos, executor_, co.device_type_, target_exprs_owned_);
+    result = {executor_->executeWorkUnit(&error_code,
+                                         max_groups_buffer_entry_guess,
+                                         is_agg,
+                                         table_infos,
+                                         ra_exe_unit,
+                                         co,
+                                         eo_waves,
+                                         cat_,
+                                         executor_->row_set_mem_owner_,
+                                         nullptr,
+                                         true),
+              targets_meta};
+    result.setQueueTime(queue_time_ms);
+    if (!error_code) {
+      return result;
+    }
+  }
   if (error_code == Executor::ERR_OUT_OF_GPU_MEM) {
     if (g_enable_watchdog && !g_allow_cpu_retry) {
       throw std::runtime_error(getErrorMessageFromCode(error_code));
@@ -1942,6 +2555,10 @@ ExecutionResult RelAlgExecutor::handleRetry(
     if (g_enable_watchdog && !g_allow_cpu_retry) {
       throw std::runtime_error(out_of_memory);
     }
+    cpu_retry_count().inc();
+    if (query_profile_) {
+      query_profile_->setCpuRetryReason(out_of_memory);
+    }
   }
   CompilationOptions co_cpu{ExecutorDeviceType::CPU,
                             co.hoist_literals_,
@@ -1972,6 +2589,10 @@ ExecutionResult RelAlgExecutor::handleRetry(
       if (!error_code) {
         return result;
       }
+      if (group_by_needs_partitions(error_code, ra_exe_unit)) {
+        return executePartitionedGroupBy(
+            work_unit, targets_meta, is_agg, co, eo, queue_time_ms);
+      }
       handlePersistentError(error_code);
       // Even the conservative guess failed; it should only happen when we group
       // by a huge cardinality array. Maybe we should throw an exception instead?
@@ -1986,6 +2607,370 @@ ExecutionResult RelAlgExecutor::handleRetry(
   return result;
 }
 
+ExecutionResult RelAlgExecutor::executePartitionedGroupBy(
+    const RelAlgExecutor::WorkUnit& work_unit,
+    const std::vector<TargetMetaInfo>& targets_meta,
+    const bool is_agg,
+    const CompilationOptions& co,
+    const ExecutionOptions& eo,
+    const int64_t queue_time_ms) {
+  const auto partition_key = get_group_by_partition_key(work_unit.exe_unit);
+  CHECK(partition_key);
+  ExecutionOptions eo_no_multifrag{eo.output_columnar_hint,
+                                   false,
+                                   false,
+                                   eo.allow_loop_joins,
+                                   eo.with_watchdog,
+                                   eo.jit_debug,
+                                   false,
+                                   eo.with_dynamic_watchdog,
+                                   eo.dynamic_watchdog_time_limit,
+                                   false};
+  CompilationOptions co_cpu{ExecutorDeviceType::CPU,
+                            co.hoist_literals_,
+                            co.opt_level_,
+                            co.with_dynamic_watchdog_};
+  const auto table_infos = get_table_infos(work_unit.exe_unit, executor_);
+  int32_t error_code{Executor::ERR_OUT_OF_CPU_MEM};
+  // Every partition scans the whole input again but only holds the groups of its keys,
+  // add partitions until the groups of every partition fit.
+  for (size_t partition_count = 4; partition_count <= g_max_group_by_partitions;
+       partition_count *= 2) {
+    LOG(INFO) << "Group by ran out of memory, compute it in " << partition_count
+              << " partitions";
+    ResultSetPtr rows;
+    for (size_t partition = 0; partition < partition_count; ++partition) {
+      auto partition_exe_unit = work_unit.exe_unit;
+      partition_exe_unit.quals.push_back(
+          make_group_by_partition_qual(partition_key, partition_count, partition));
+      const auto ra_exe_unit =
+          decide_approx_count_distinct_implementation(partition_exe_unit,
+                                                      table_infos,
+                                                      executor_,
+                                                      co_cpu.device_type_,
+                                                      target_exprs_owned_);
+      size_t max_groups_buffer_entry_guess{0};
+      ResultSetPtr partition_rows;
+      while (true) {
+        partition_rows = executor_->executeWorkUnit(&error_code,
+                                                    max_groups_buffer_entry_guess,
+                                                    is_agg,
+                                                    table_infos,
+                                                    ra_exe_unit,
+                                                    co_cpu,
+                                                    eo_no_multifrag,
+                                                    cat_,
+                                                    executor_->row_set_mem_owner_,
+                                                    nullptr,
+                                                    true);
+        if (error_code != Executor::ERR_OUT_OF_SLOTS || g_enable_watchdog) {
+          break;
+        }
+        max_groups_buffer_entry_guess *= 2;
+      }
+      if (error_code) {
+        break;
+      }
+      // The partitions have disjoint groups, their rows are simply concatenated.
+      if (!rows || rows->definitelyHasNoRows()) {
+        rows = partition_rows;
+      } else if (!partition_rows->definitelyHasNoRows()) {
+        rows->append(*partition_rows);
+      }
+    }
+    if (!error_code) {
+      ExecutionResult result{rows, targets_meta};
+      result.setQueueTime(queue_time_ms);
+      return result;
+    }
+    if (error_code != Executor::ERR_OUT_OF_CPU_MEM &&
+        error_code != Executor::ERR_OUT_OF_SLOTS) {
+      break;
+    }
+  }
+  handlePersistentError(error_code);
+  CHECK(false);
+  return {nullptr, {}};
+}
+
+namespace {
+
+int64_t scalar_value_to_slot(const ScalarTargetValue& scalar_tv) {
+  const auto ival = boost::get<int64_t>(&scalar_tv);
+  if (ival) {
+    return *ival;
+  }
+  double dval{0};
+  const auto fval = boost::get<float>(&scalar_tv);
+  if (fval) {
+    dval = *fval;
+  } else {
+    const auto dval_ptr = boost::get<double>(&scalar_tv);
+    CHECK(dval_ptr);
+    dval = *dval_ptr;
+  }
+  return *reinterpret_cast<const int64_t*>(may_alias_ptr(&dval));
+}
+
+// Replaces dictionary ids with the rank of their string, for sorting.
+void dictionary_ids_to_ordinals(WindowColumn& column, const StringDictionaryProxy* sdp) {
+  std::vector<int32_t> ids;
+  for (size_t row = 0; row < column.values.size(); ++row) {
+    if (!column.isNull(row)) {
+      ids.push_back(column.values[row]);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  std::vector<std::pair<std::string, int32_t>> strings;
+  for (const auto id : ids) {
+    strings.emplace_back(sdp->getString(id), id);
+  }
+  std::sort(strings.begin(), strings.end());
+  std::unordered_map<int32_t, int64_t> ordinals;
+  for (size_t i = 0; i < strings.size(); ++i) {
+    ordinals.emplace(strings[i].second, i);
+  }
+  for (size_t row = 0; row < column.values.size(); ++row) {
+    if (!column.isNull(row)) {
+      column.values[row] = ordinals[column.values[row]];
+    }
+  }
+}
+
+bool same_window_partitions(const Analyzer::WindowFunction* lhs,
+                            const Analyzer::WindowFunction* rhs) {
+  const auto same_exprs = [](const std::vector<std::shared_ptr<Analyzer::Expr>>& lhs,
+                             const std::vector<std::shared_ptr<Analyzer::Expr>>& rhs) {
+    if (lhs.size() != rhs.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+      if (!(*lhs[i] == *rhs[i])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!same_exprs(lhs->getPartitionKeys(), rhs->getPartitionKeys()) ||
+      !same_exprs(lhs->getOrderKeys(), rhs->getOrderKeys())) {
+    return false;
+  }
+  const auto& lhs_collation = lhs->getCollation();
+  const auto& rhs_collation = rhs->getCollation();
+  for (size_t i = 0; i < lhs_collation.size(); ++i) {
+    if (lhs_collation[i].is_desc != rhs_collation[i].is_desc ||
+        lhs_collation[i].nulls_first != rhs_collation[i].nulls_first) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+ExecutionResult RelAlgExecutor::executeWindowFunctionWorkUnit(
+    const RelAlgExecutor::WorkUnit& work_unit,
+    const std::vector<TargetMetaInfo>& targets_meta,
+    const CompilationOptions& co,
+    const ExecutionOptions& eo,
+    const int64_t queue_time_ms) {
+  if (eo.just_explain) {
+    throw std::runtime_error("EXPLAIN not supported for window functions");
+  }
+  const auto& exe_unit = work_unit.exe_unit;
+  // Project the plain targets and the inputs of the window functions first.
+  std::vector<Analyzer::Expr*> scan_targets;
+  std::vector<size_t> target_columns;
+  std::vector<std::vector<size_t>> window_arg_columns;
+  std::vector<std::vector<size_t>> window_partition_columns;
+  std::vector<std::vector<size_t>> window_order_columns;
+  for (const auto target_expr : exe_unit.target_exprs) {
+    const auto window_func = dynamic_cast<const Analyzer::WindowFunction*>(target_expr);
+    if (!window_func) {
+      target_columns.push_back(scan_targets.size());
+      scan_targets.push_back(target_expr);
+      continue;
+    }
+    target_columns.push_back(window_arg_columns.size());
+    const auto add_scan_targets =
+        [&scan_targets](const std::vector<std::shared_ptr<Analyzer::Expr>>& exprs) {
+          std::vector<size_t> columns;
+          for (const auto& expr : exprs) {
+            columns.push_back(scan_targets.size());
+            scan_targets.push_back(expr.get());
+          }
+          return columns;
+        };
+    window_arg_columns.push_back(add_scan_targets(window_func->getArgs()));
+    window_partition_columns.push_back(add_scan_targets(window_func->getPartitionKeys()));
+    window_order_columns.push_back(add_scan_targets(window_func->getOrderKeys()));
+  }
+  if (scan_targets.empty()) {
+    // Only the row count is needed, e.g. ROW_NUMBER() OVER ().
+    Datum d;
+    d.intval = 0;
+    target_exprs_owned_.push_back(
+        makeExpr<Analyzer::Constant>(SQLTypeInfo(kINT, true), false, d));
+    scan_targets.push_back(target_exprs_owned_.back().get());
+  }
+  std::vector<TargetMetaInfo> scan_targets_meta;
+  for (const auto scan_target : scan_targets) {
+    const auto& ti = scan_target->get_type_info();
+    if (ti.is_array() || ti.is_geometry() ||
+        (ti.is_string() && ti.get_compression() != kENCODING_DICT)) {
+      throw QueryNotSupported("Column type " + ti.get_type_name() +
+                              " not supported in a projection with window functions");
+    }
+    scan_targets_meta.emplace_back("", ti);
+  }
+  const WorkUnit scan_work_unit{{exe_unit.input_descs,
+                                 exe_unit.input_col_descs,
+                                 exe_unit.simple_quals,
+                                 exe_unit.quals,
+                                 exe_unit.inner_joins,
+                                 exe_unit.inner_join_quals,
+                                 exe_unit.groupby_exprs,
+                                 scan_targets,
+                                 nullptr,
+                                 {{}, SortAlgorithm::Default, 0, 0},
+                                 0},
+                                work_unit.body,
+                                work_unit.max_groups_buffer_entry_guess,
+                                nullptr,
+                                work_unit.input_permutation,
+                                work_unit.left_deep_join_input_sizes};
+  const auto scan_result = executeWorkUnit(
+      scan_work_unit, scan_targets_meta, false, co, eo, nullptr, queue_time_ms);
+  const auto scan_rows = scan_result.getRows();
+  std::vector<WindowColumn> columns(scan_targets.size());
+  for (size_t i = 0; i < scan_targets.size(); ++i) {
+    columns[i].ti = scan_targets[i]->get_type_info();
+  }
+  scan_rows->moveToBegin();
+  while (true) {
+    const auto crt_row = scan_rows->getNextRow(false, false);
+    if (crt_row.empty()) {
+      break;
+    }
+    CHECK_EQ(columns.size(), crt_row.size());
+    for (size_t i = 0; i < crt_row.size(); ++i) {
+      const auto scalar_tv = boost::get<ScalarTargetValue>(&crt_row[i]);
+      CHECK(scalar_tv);
+      columns[i].values.push_back(scalar_value_to_slot(*scalar_tv));
+    }
+  }
+  const size_t row_count = columns.front().values.size();
+  // Strings are ordered by value, not by dictionary id.
+  for (const auto& order_columns : window_order_columns) {
+    for (const auto column_idx : order_columns) {
+      auto& column = columns[column_idx];
+      if (column.ti.is_string()) {
+        dictionary_ids_to_ordinals(
+            column,
+            executor_->getStringDictionaryProxy(
+                column.ti.get_comp_param(), executor_->row_set_mem_owner_, true));
+      }
+    }
+  }
+  const auto to_column_ptrs = [&columns](const std::vector<size_t>& column_indices) {
+    std::vector<const WindowColumn*> column_ptrs;
+    for (const auto column_idx : column_indices) {
+      column_ptrs.push_back(&columns[column_idx]);
+    }
+    return column_ptrs;
+  };
+  std::vector<
+      std::pair<const Analyzer::WindowFunction*, std::unique_ptr<WindowPartitions>>>
+      partitions_cache;
+  std::vector<std::vector<int64_t>> window_results;
+  for (const auto target_expr : exe_unit.target_exprs) {
+    const auto window_func = dynamic_cast<const Analyzer::WindowFunction*>(target_expr);
+    if (!window_func) {
+      continue;
+    }
+    const auto window_idx = window_results.size();
+    const WindowPartitions* partitions{nullptr};
+    for (const auto& cached_partitions : partitions_cache) {
+      if (same_window_partitions(cached_partitions.first, window_func)) {
+        partitions = cached_partitions.second.get();
+        break;
+      }
+    }
+    if (!partitions) {
+      partitions_cache.emplace_back(
+          window_func,
+          std::make_unique<WindowPartitions>(
+              to_column_ptrs(window_partition_columns[window_idx]),
+              to_column_ptrs(window_order_columns[window_idx]),
+              window_func->getCollation(),
+              row_count));
+      partitions = partitions_cache.back().second.get();
+    }
+    window_results.push_back(compute_window_function(
+        window_func, to_column_ptrs(window_arg_columns[window_idx]), *partitions));
+  }
+  // Write the rows to a projection result set, sorted and limited by the caller.
+  std::vector<TargetInfo> target_infos;
+  std::vector<ColWidths> agg_col_widths;
+  std::vector<const std::vector<int64_t>*> output_columns;
+  for (size_t i = 0; i < exe_unit.target_exprs.size(); ++i) {
+    const auto target_expr = exe_unit.target_exprs[i];
+    target_infos.push_back({false,
+                            kMIN,
+                            target_expr->get_type_info(),
+                            SQLTypeInfo(kNULLT, false),
+                            false,
+                            false});
+    agg_col_widths.push_back({8, 8});
+    output_columns.push_back(dynamic_cast<const Analyzer::WindowFunction*>(target_expr)
+                                 ? &window_results[target_columns[i]]
+                                 : &columns[target_columns[i]].values);
+  }
+  QueryMemoryDescriptor query_mem_desc(executor_,
+                                       false,
+                                       QueryDescriptionType::Projection,
+                                       false,
+                                       false,
+                                       -1,
+                                       0,
+                                       {sizeof(int64_t)},
+                                       0,
+                                       agg_col_widths,
+                                       {},
+                                       row_count,
+                                       0,
+                                       0,
+                                       0,
+                                       false,
+                                       GroupByMemSharing::Shared,
+                                       CountDistinctDescriptors{},
+                                       false,
+                                       false,
+                                       false,
+                                       {},
+                                       {},
+                                       false);
+  auto rows = std::make_shared<ResultSet>(target_infos,
+                                          ExecutorDeviceType::CPU,
+                                          query_mem_desc,
+                                          executor_->row_set_mem_owner_,
+                                          executor_);
+  auto rs_buff =
+      reinterpret_cast<int64_t*>(rows->allocateStorage()->getUnderlyingBuffer());
+  for (size_t row = 0; row < row_count; ++row) {
+    // Any key other than EMPTY_KEY_64 marks the entry as used.
+    rs_buff[0] = row;
+    for (size_t col = 0; col < output_columns.size(); ++col) {
+      rs_buff[col + 1] = (*output_columns[col])[row];
+    }
+    rs_buff += output_columns.size() + 1;
+  }
+  ExecutionResult result(rows, targets_meta);
+  result.setQueueTime(queue_time_ms);
+  return result;
+}
+
 void RelAlgExecutor::handlePersistentError(const int32_t error_code) {
   if (error_code == Executor::ERR_SPECULATIVE_TOP_OOM) {
     throw SpeculativeTopNFailed();
@@ -1997,6 +2982,12 @@ void RelAlgExecutor::handlePersistentError(const int32_t error_code) {
     // retry on CPU is explicitly allowed through --allow-cpu-retry.
     return;
   }
+  if (error_code == Executor::ERR_OUT_OF_CPU_MEM &&
+      !QueryMemoryAccount::cpuLimitExceeded()) {
+    // Don't let the cached join hash tables and results keep the host memory from the
+    // next queries.
+    HostMemoryCacheInvalidator::invalidateCaches();
+  }
   throw std::runtime_error(getErrorMessageFromCode(error_code));
 }
 
@@ -2413,14 +3404,24 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createCompoundWorkUnit(
                                          : std::vector<JoinType>{get_join_type(compound)};
   std::vector<size_t> input_permutation;
   std::vector<size_t> left_deep_join_input_sizes;
+  std::string join_order_info;
   if (left_deep_join) {
     left_deep_join_input_sizes = get_left_deep_join_input_sizes(left_deep_join);
     if (g_from_table_reordering &&
         std::find(join_types.begin(), join_types.end(), JoinType::LEFT) ==
             join_types.end()) {
+      if (g_enable_cost_based_join_ordering) {
+        const auto join_order = getCostBasedInputPermutation(
+            left_deep_join, query_infos, input_to_nest_level, join_types, just_explain);
+        input_permutation = join_order.input_permutation;
+        join_order_info = join_order.toString();
+        VLOG(1) << join_order_info;
+      }
       do_table_reordering_maybe(
           input_descs, input_col_descs, input_to_nest_level, compound, query_infos, cat_);
-      input_permutation = get_node_input_permutation(query_infos);
+      if (input_permutation.empty()) {
+        input_permutation = get_node_input_permutation(query_infos);
+      }
       input_to_nest_level = get_input_nest_levels(compound, input_permutation);
       std::tie(input_descs, input_col_descs, std::ignore) =
           get_input_desc(compound, input_to_nest_level, input_permutation, cat_);
@@ -2474,7 +3475,8 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createCompoundWorkUnit(
           max_groups_buffer_entry_default_guess,
           std::unique_ptr<QueryRewriter>(query_rewriter),
           input_permutation,
-          left_deep_join_input_sizes};
+          left_deep_join_input_sizes,
+          join_order_info};
 }
 
 namespace {
@@ -2602,6 +3604,17 @@ std::list<std::shared_ptr<Analyzer::Expr>> RelAlgExecutor::makeJoinQuals(
   return combine_equi_join_conditions(join_condition_quals);
 }
 
+JoinOrderEstimate RelAlgExecutor::getCostBasedInputPermutation(
+    const RelLeftDeepInnerJoin* join,
+    const std::vector<InputTableInfo>& query_infos,
+    const std::unordered_map<const RelAlgNode*, int>& input_to_nest_level,
+    const std::vector<JoinType>& join_types,
+    const bool just_explain) const {
+  const auto quals = makeJoinQuals(
+      join->getInnerCondition(), join_types, input_to_nest_level, just_explain);
+  return get_cost_based_input_permutation(quals, query_infos, executor_);
+}
+
 // Translate left deep join filter and separate the conjunctive form qualifiers
 // per nesting level. The code generated for hash table lookups on each level
 // must dominate its uses in deeper nesting levels.
@@ -2815,15 +3828,25 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createProjectWorkUnit(const RelProject*
                                          : std::vector<JoinType>{get_join_type(project)};
   std::vector<size_t> input_permutation;
   std::vector<size_t> left_deep_join_input_sizes;
+  std::string join_order_info;
   if (left_deep_join) {
     left_deep_join_input_sizes = get_left_deep_join_input_sizes(left_deep_join);
     const auto query_infos = get_table_infos(input_descs, executor_);
     if (g_from_table_reordering &&
         std::find(join_types.begin(), join_types.end(), JoinType::LEFT) ==
             join_types.end()) {
+      if (g_enable_cost_based_join_ordering) {
+        const auto join_order = getCostBasedInputPermutation(
+            left_deep_join, query_infos, input_to_nest_level, join_types, just_explain);
+        input_permutation = join_order.input_permutation;
+        join_order_info = join_order.toString();
+        VLOG(1) << join_order_info;
+      }
       do_table_reordering_maybe(
           input_descs, input_col_descs, input_to_nest_level, project, query_infos, cat_);
-      input_permutation = get_node_input_permutation(query_infos);
+      if (input_permutation.empty()) {
+        input_permutation = get_node_input_permutation(query_infos);
+      }
       input_to_nest_level = get_input_nest_levels(project, input_permutation);
       std::tie(input_descs, input_col_descs, std::ignore) =
           get_input_desc(project, input_to_nest_level, input_permutation, cat_);
@@ -2862,7 +3885,8 @@ RelAlgExecutor::WorkUnit RelAlgExecutor::createProjectWorkUnit(const RelProject*
           max_groups_buffer_entry_default_guess,
           nullptr,
           input_permutation,
-          left_deep_join_input_sizes};
+          left_deep_join_input_sizes,
+          join_order_info};
 }
 
 namespace {
@@ -20,8 +20,10 @@
 #include "../Shared/scope.h"
 #include "Distributed/AggregatedResult.h"
 #include "Execute.h"
+#include "FromTableReordering.h"
 #include "InputMetadata.h"
 #include "JoinFilterPushDown.h"
+#include "QueryResultCache.h"
 #include "QueryRewrite.h"
 #include "RelAlgExecutionDescriptor.h"
 #include "SpeculativeTopN.h"
@@ -56,7 +58,9 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
       , executor_(executor)
       , cat_(cat)
       , now_(0)
-      , queue_time_ms_(0) {}
+      , queue_time_ms_(0)
+      , query_profile_(nullptr)
+      , shared_scan_compound_(nullptr) {}
 
   ExecutionResult executeRelAlgQuery(const std::string& query_ra,
                                      const CompilationOptions& co,
@@ -84,6 +88,9 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
                                         const CompilationOptions& co,
                                         const ExecutionOptions& eo);
 
+  // Executes the registered subqueries once per distinct plan and sets their results.
+  void executeSubqueries(const CompilationOptions& co, const ExecutionOptions& eo);
+
   ExecutionResult executeRelAlgSeq(std::vector<RaExecutionDesc>& ed_list,
                                    const CompilationOptions& co,
                                    const ExecutionOptions& eo,
@@ -95,6 +102,9 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
     CHECK(it_ok.second);
   }
 
+  // The profile filled by the next executions, owned by the caller.
+  void setQueryProfile(QueryProfile* query_profile) { query_profile_ = query_profile; }
+
   void registerSubquery(std::shared_ptr<RexSubQuery> subquery) noexcept {
     subqueries_.push_back(subquery);
   }
@@ -109,6 +119,9 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
 
   TableGenerations computeTableGenerations(const RelAlgNode* ra);
 
+  // Bytes of the columns the query reads, to tell the interactive queries apart.
+  size_t estimateInputBytes(const RelAlgNode* ra) const;
+
   Executor* getExecutor() const;
 
   void cleanupPostExecution();
@@ -190,6 +203,8 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
     std::unique_ptr<QueryRewriter> query_rewriter;
     const std::vector<size_t> input_permutation;
     const std::vector<size_t> left_deep_join_input_sizes;
+    // The estimates behind a cost based join order, shown by EXPLAIN.
+    const std::string join_order_info;
   };
 
   WorkUnit createSortInputWorkUnit(const RelSort*, const bool just_explain);
@@ -202,6 +217,13 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
                                   RenderInfo*,
                                   const int64_t queue_time_ms);
 
+  // Computes the queued aggregates with the same table and filter in the same pass.
+  ExecutionResult executeSharedScan(const WorkUnit& work_unit,
+                                    const ExecutorDeviceType device_type,
+                                    const CompilationOptions& co,
+                                    const ExecutionOptions& eo,
+                                    const int64_t queue_time_ms);
+
   size_t getNDVEstimation(const WorkUnit& work_unit,
                           const bool is_agg,
                           const CompilationOptions& co,
@@ -215,7 +237,13 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
   FilterSelectivity getFilterSelectivity(
       const std::vector<std::shared_ptr<Analyzer::Expr>>& filter_expressions,
       const CompilationOptions& co,
-      const ExecutionOptions& eo);
+      const ExecutionOptions& eo,
+      const bool first_fragment_only = false);
+
+  void sampleQualSelectivity(RelAlgExecutionUnit& ra_exe_unit,
+                             const std::vector<InputTableInfo>& table_infos,
+                             const CompilationOptions& co,
+                             const ExecutionOptions& eo);
 
   std::vector<PushedDownFilterInfo> selectFiltersToBePushedDown(
       const RelAlgExecutor::WorkUnit& work_unit,
@@ -232,6 +260,24 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
                               const ExecutionOptions& eo,
                               const int64_t queue_time_ms);
 
+  // Computes the groups of a query one partition of the keys of its first integer group
+  // by column at a time, when all of them don't fit in memory.
+  ExecutionResult executePartitionedGroupBy(
+      const WorkUnit& work_unit,
+      const std::vector<TargetMetaInfo>& targets_meta,
+      const bool is_agg,
+      const CompilationOptions& co,
+      const ExecutionOptions& eo,
+      const int64_t queue_time_ms);
+
+  // Evaluates the window functions of a projection over its rows, see WindowContext.h.
+  ExecutionResult executeWindowFunctionWorkUnit(
+      const WorkUnit& work_unit,
+      const std::vector<TargetMetaInfo>& targets_meta,
+      const CompilationOptions& co,
+      const ExecutionOptions& eo,
+      const int64_t queue_time_ms);
+
   static void handlePersistentError(const int32_t error_code);
 
   static std::string getErrorMessageFromCode(const int32_t error_code);
@@ -270,6 +316,9 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
     CHECK(it_ok.second);
   }
 
+  // Keys the columnar form of the output of the step in the ColumnarResultsCache.
+  void addTemporaryTableCacheKey(const RelAlgNode* body, const ExecutionOptions& eo);
+
   void handleNop(RaExecutionDesc& ed);
 
   JoinQualsPerNestingLevel translateLeftDeepJoinFilter(
@@ -286,14 +335,27 @@ class RelAlgExecutor : private StorageIOFacility<RelAlgExecutorTraits> {
       const std::unordered_map<const RelAlgNode*, int>& input_to_nest_level,
       const bool just_explain) const;
 
+  // Orders the inputs of an inner join by the estimated cost of joining them, from the
+  // qualifiers translated with the original nesting levels.
+  JoinOrderEstimate getCostBasedInputPermutation(
+      const RelLeftDeepInnerJoin* join,
+      const std::vector<InputTableInfo>& query_infos,
+      const std::unordered_map<const RelAlgNode*, int>& input_to_nest_level,
+      const std::vector<JoinType>& join_types,
+      const bool just_explain) const;
+
   Executor* executor_;
   const Catalog_Namespace::Catalog& cat_;
   TemporaryTables temporary_tables_;
+  std::unordered_map<int, QueryResultCacheKey> temporary_table_cache_keys_;
   time_t now_;
   std::vector<std::shared_ptr<Analyzer::Expr>> target_exprs_owned_;  // TODO(alex): remove
   std::vector<std::shared_ptr<RexSubQuery>> subqueries_;
   std::unordered_map<unsigned, AggregatedResult> leaf_results_;
   int64_t queue_time_ms_;
+  QueryProfile* query_profile_;
+  // The aggregate of the query which answers the shareable queued ones, if any.
+  const RelCompound* shared_scan_compound_;
   static SpeculativeTopNBlacklist speculative_topn_blacklist_;
   static const size_t max_groups_buffer_entry_default_guess{16384};
 };
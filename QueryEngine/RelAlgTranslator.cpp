@@ -168,6 +168,10 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateScalarRex(
   if (rex_literal) {
     return translateLiteral(rex_literal);
   }
+  const auto rex_window_function = dynamic_cast<const RexWindowFunctionOperator*>(rex);
+  if (rex_window_function) {
+    return translateWindowFunction(rex_window_function);
+  }
   const auto rex_function = dynamic_cast<const RexFunctionOperator*>(rex);
   if (rex_function) {
     return translateFunction(rex_function);
@@ -201,7 +205,7 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateAggregateRex(
     CHECK_LT(operand, static_cast<ssize_t>(scalar_sources.size()));
     CHECK_LE(rex->size(), 2);
     arg_expr = scalar_sources[operand];
-    if (agg_kind == kAPPROX_COUNT_DISTINCT && rex->size() == 2) {
+    if (is_approx_count_distinct(agg_kind) && rex->size() == 2) {
       err_rate = std::dynamic_pointer_cast<Analyzer::Constant>(
           scalar_sources[rex->getOperand(1)]);
       if (!err_rate || err_rate->get_type_info().get_type() != kSMALLINT ||
@@ -212,6 +216,47 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateAggregateRex(
             "1 and 100");
       }
     }
+    // Sketches are stored as the array of their registers. The sketch aggregate merges
+    // them when given one, which rolls them up further.
+    const auto& arg_ti = arg_expr->get_type_info();
+    const bool is_sketch_arg =
+        arg_ti.is_array() && arg_ti.get_elem_type().get_type() == kTINYINT;
+    if (agg_kind == kAPPROX_COUNT_DISTINCT_UNION && !is_sketch_arg) {
+      throw std::runtime_error(
+          "APPROX_COUNT_DISTINCT_UNION expects a sketch, a TINYINT[] column produced by "
+          "APPROX_COUNT_DISTINCT_SKETCH");
+    }
+    if (agg_kind == kAPPROX_COUNT_DISTINCT_SKETCH && arg_ti.is_array() &&
+        !is_sketch_arg) {
+      throw std::runtime_error(
+          "APPROX_COUNT_DISTINCT_SKETCH on arrays other than sketches not supported");
+    }
+    if (agg_kind == kAPPROX_QUANTILE) {
+      if (!arg_ti.is_number()) {
+        throw std::runtime_error("APPROX_PERCENTILE expects a numeric argument");
+      }
+      if (rex->size() == 2) {
+        const auto quantile_literal = std::dynamic_pointer_cast<Analyzer::Constant>(
+            scalar_sources[rex->getOperand(1)]);
+        if (!quantile_literal || quantile_literal->get_is_null() ||
+            !quantile_literal->get_type_info().is_number()) {
+          throw std::runtime_error(
+              "APPROX_PERCENTILE's second parameter should be a literal between 0 and "
+              "1");
+        }
+        // the sketch is built on doubles, the percentile is one as well
+        err_rate = std::dynamic_pointer_cast<Analyzer::Constant>(
+            quantile_literal->deep_copy()->add_cast(SQLTypeInfo(kDOUBLE, true)));
+        CHECK(err_rate);
+        const auto quantile = err_rate->get_constval().doubleval;
+        if (quantile < 0 || quantile > 1) {
+          throw std::runtime_error(
+              "APPROX_PERCENTILE's second parameter should be a literal between 0 and "
+              "1");
+        }
+      }
+      arg_expr = arg_expr->add_cast(SQLTypeInfo(kDOUBLE, arg_ti.get_notnull()));
+    }
   }
   const auto agg_ti = get_agg_type(agg_kind, arg_expr.get());
   return makeExpr<Analyzer::AggExpr>(agg_ti, agg_kind, arg_expr, is_distinct, err_rate);
@@ -286,6 +331,8 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateScalarSubquery(
   if (row_set->rowCount() != size_t(1)) {
     throw std::runtime_error("Scalar sub-query returned multiple rows");
   }
+  // The result can be shared by identical subqueries, read it from the start.
+  row_set->moveToBegin();
   auto first_row = row_set->getNextRow(false, false);
   auto scalar_tv = boost::get<ScalarTargetValue>(&first_row[0]);
   auto ti = rex_subquery->getType();
@@ -656,7 +703,7 @@ void fill_dictionary_encoded_in_vals(
   }
   std::vector<int32_t> dest_ids;
   translate_string_ids(dest_ids,
-                       leaf_hosts.front(),
+                       leaf_hosts,
                        dest_dict_ref,
                        source_ids,
                        source_dict_ref,
@@ -1151,6 +1198,54 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateSign(
       makeExpr<Analyzer::Constant>(operand_ti, true, Datum{0}));
 }
 
+std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateWindowFunction(
+    const RexWindowFunctionOperator* rex_window_function) const {
+  std::vector<std::shared_ptr<Analyzer::Expr>> args;
+  for (size_t i = 0; i < rex_window_function->getArgCount(); ++i) {
+    args.push_back(translateScalarRex(rex_window_function->getOperand(i)));
+  }
+  std::vector<std::shared_ptr<Analyzer::Expr>> partition_keys;
+  for (size_t i = 0; i < rex_window_function->getPartitionKeyCount(); ++i) {
+    partition_keys.push_back(
+        translateScalarRex(rex_window_function->getPartitionKey(i)));
+  }
+  const auto& collation = rex_window_function->getCollation();
+  std::vector<std::shared_ptr<Analyzer::Expr>> order_keys;
+  std::vector<Analyzer::OrderEntry> order_entries;
+  for (size_t i = 0; i < collation.size(); ++i) {
+    order_keys.push_back(translateScalarRex(rex_window_function->getOrderKey(i)));
+    order_entries.emplace_back(
+        collation[i].getField() + 1,
+        collation[i].getSortDir() == SortDirection::Descending,
+        collation[i].getNullsPosition() == NullSortedPosition::First);
+  }
+  auto ti = rex_window_function->getType();
+  switch (rex_window_function->getKind()) {
+    case SqlWindowFunctionKind::LAG:
+    case SqlWindowFunctionKind::LEAD:
+    case SqlWindowFunctionKind::FIRST_VALUE:
+    case SqlWindowFunctionKind::LAST_VALUE:
+    case SqlWindowFunctionKind::MIN:
+    case SqlWindowFunctionKind::MAX: {
+      // The values are copied from the argument, keep its dictionary and encoding.
+      CHECK(!args.empty());
+      ti = args.front()->get_type_info();
+      ti.set_notnull(false);
+      break;
+    }
+    default:
+      break;
+  }
+  return makeExpr<Analyzer::WindowFunction>(ti,
+                                            rex_window_function->getKind(),
+                                            args,
+                                            partition_keys,
+                                            order_keys,
+                                            order_entries,
+                                            rex_window_function->isRows(),
+                                            rex_window_function->isFrameToCurrentRow());
+}
+
 std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateOffsetInFragment() const {
   return makeExpr<Analyzer::OffsetInFragment>();
 }
@@ -111,6 +111,9 @@ class RelAlgTranslator {
 
   std::shared_ptr<Analyzer::Expr> translateOffsetInFragment() const;
 
+  std::shared_ptr<Analyzer::Expr> translateWindowFunction(
+      const RexWindowFunctionOperator*) const;
+
   std::shared_ptr<Analyzer::Expr> translateArrayFunction(
       const RexFunctionOperator*) const;
 
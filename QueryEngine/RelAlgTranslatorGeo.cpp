@@ -103,6 +103,45 @@ std::vector<uint8_t> compress_coords(std::vector<double>& coords, const SQLTypeI
 
 }  // namespace Importer_NS
 
+namespace {
+
+// Coordinates of a POINT literal, decompressed the way decompress_coord does it at
+// runtime. Returns false if the argument isn't a literal or its coordinates would still
+// need a transform to the given output SRID.
+bool get_point_literal_coords(const std::shared_ptr<Analyzer::Expr>& coords_expr,
+                              const SQLTypeInfo& ti,
+                              const int32_t output_srid,
+                              double& x,
+                              double& y) {
+  const auto coords = std::dynamic_pointer_cast<Analyzer::Constant>(coords_expr);
+  if (!coords || ti.get_type() != kPOINT ||
+      (ti.get_input_srid() == 4326 && output_srid == 900913)) {
+    return false;
+  }
+  std::vector<int8_t> coord_bytes;
+  for (const auto& byte_expr : coords->get_value_list()) {
+    const auto byte_const = dynamic_cast<const Analyzer::Constant*>(byte_expr.get());
+    CHECK(byte_const);
+    coord_bytes.push_back(byte_const->get_constval().tinyintval);
+  }
+  if (ti.get_compression() == kENCODING_GEOINT && ti.get_comp_param() == 32) {
+    int32_t compressed_coords[2];
+    CHECK_EQ(sizeof(compressed_coords), coord_bytes.size());
+    memcpy(compressed_coords, &coord_bytes[0], sizeof(compressed_coords));
+    x = static_cast<double>(compressed_coords[0]) * 8.3819031754424345e-08;
+    y = static_cast<double>(compressed_coords[1]) * 4.1909515877212172e-08;
+    return true;
+  }
+  double double_coords[2];
+  CHECK_EQ(sizeof(double_coords), coord_bytes.size());
+  memcpy(double_coords, &coord_bytes[0], sizeof(double_coords));
+  x = double_coords[0];
+  y = double_coords[1];
+  return true;
+}
+
+}  // namespace
+
 std::vector<std::shared_ptr<Analyzer::Expr>> RelAlgTranslator::translateGeoLiteral(
     const RexLiteral* rex_literal,
     SQLTypeInfo& ti,
@@ -767,6 +806,40 @@ std::shared_ptr<Analyzer::Expr> RelAlgTranslator::translateBinaryGeoFunction(
     }
   }
 
+  if (specialized_geofunc == std::string("ST_Distance_Point_Point")) {
+    // Against a POINT literal, pass its coordinates as doubles to an inline function.
+    double x{0};
+    double y{0};
+    const bool literal1 = get_point_literal_coords(
+        geoargs1.front(), arg1_ti, arg0_ti.get_output_srid(), x, y);
+    if (literal1 || get_point_literal_coords(
+                        geoargs0.front(), arg0_ti, arg0_ti.get_output_srid(), x, y)) {
+      const auto& point_ti = literal1 ? arg0_ti : arg1_ti;
+      Datum input_compression;
+      input_compression.intval = (point_ti.get_compression() == kENCODING_GEOINT &&
+                                  point_ti.get_comp_param() == 32)
+                                     ? 1
+                                     : 0;
+      Datum input_srid;
+      input_srid.intval = point_ti.get_input_srid();
+      Datum output_srid;
+      output_srid.intval = arg0_ti.get_output_srid();
+      Datum x_datum;
+      x_datum.doubleval = x;
+      Datum y_datum;
+      y_datum.doubleval = y;
+      std::vector<std::shared_ptr<Analyzer::Expr>> point_xy_args{
+          literal1 ? geoargs0.front() : geoargs1.front(),
+          makeExpr<Analyzer::Constant>(kINT, false, input_compression),
+          makeExpr<Analyzer::Constant>(kINT, false, input_srid),
+          makeExpr<Analyzer::Constant>(kINT, false, output_srid),
+          makeExpr<Analyzer::Constant>(kDOUBLE, false, x_datum),
+          makeExpr<Analyzer::Constant>(kDOUBLE, false, y_datum)};
+      return makeExpr<Analyzer::FunctionOper>(
+          rex_function->getType(), "ST_Distance_Point_XY", point_xy_args);
+    }
+  }
+
   // Add first input's compression mode and SRID args to enable on-the-fly
   // decompression/transforms
   Datum input_compression0;
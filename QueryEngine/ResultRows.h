@@ -24,18 +24,23 @@
 #ifndef QUERYENGINE_RESULTROWS_H
 #define QUERYENGINE_RESULTROWS_H
 
+#include "GroupByBufferPool.h"
 #include "HyperLogLog.h"
 #include "OutputBufferInitialization.h"
+#include "QueryMemoryAccount.h"
 #include "QueryMemoryDescriptor.h"
+#include "RoaringBitmap.h"
 #include "TargetValue.h"
 
 #include "../Analyzer/Analyzer.h"
 #include "../Shared/TargetInfo.h"
+#include "../Shared/checked_alloc.h"
 #include "../StringDictionary/StringDictionaryProxy.h"
 
 #include <glog/logging.h>
 #include <boost/noncopyable.hpp>
 
+#include <algorithm>
 #include <limits>
 #include <list>
 #include <mutex>
@@ -204,9 +209,58 @@ class RowSetMemoryOwner : boost::noncopyable {
     count_distinct_sets_.push_back(count_distinct_set);
   }
 
-  void addGroupByBuffer(int64_t* group_by_buffer) {
+  void addCountDistinctRoaring(RoaringBitmap* count_distinct_roaring) {
     std::lock_guard<std::mutex> lock(state_mutex_);
-    group_by_buffers_.push_back(group_by_buffer);
+    count_distinct_roarings_.push_back(count_distinct_roaring);
+  }
+
+  // Returns a zero filled count distinct bitmap. The small ones are carved out of larger
+  // arena blocks, which spares a call to the allocator for each of the groups.
+  int8_t* allocateCountDistinctBuffer(const size_t num_bytes) {
+    if (num_bytes > kArenaBlockSize / 4) {
+      QueryMemoryAccount::charge(ExecutorDeviceType::CPU, num_bytes);
+      auto count_distinct_buffer = static_cast<int8_t*>(checked_calloc(num_bytes, 1));
+      addCountDistinctBuffer(count_distinct_buffer, num_bytes, true);
+      return count_distinct_buffer;
+    }
+    const size_t aligned_bytes = (num_bytes + 7) & ~size_t(7);
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (arena_remaining_ < aligned_bytes) {
+      QueryMemoryAccount::charge(ExecutorDeviceType::CPU, kArenaBlockSize);
+      arena_blocks_.push_back(static_cast<int8_t*>(checked_calloc(kArenaBlockSize, 1)));
+      arena_ptr_ = arena_blocks_.back();
+      arena_remaining_ = kArenaBlockSize;
+    }
+    auto count_distinct_buffer = arena_ptr_;
+    arena_ptr_ += aligned_bytes;
+    arena_remaining_ -= aligned_bytes;
+    count_distinct_bitmaps_.emplace_back(
+        CountDistinctBitmapBuffer{count_distinct_buffer, num_bytes, false});
+    return count_distinct_buffer;
+  }
+
+  // The buffer goes back to the GroupByBufferPool along with the result set.
+  void addGroupByBuffer(int64_t* group_by_buffer, const size_t num_bytes) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    group_by_buffers_.emplace_back(group_by_buffer, num_bytes);
+  }
+
+  // Frees a buffer added by addGroupByBuffer before the result set is released, false
+  // if it isn't one.
+  bool freeGroupByBuffer(const int8_t* group_by_buffer) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    const auto it = std::find_if(
+        group_by_buffers_.begin(),
+        group_by_buffers_.end(),
+        [group_by_buffer](const std::pair<int64_t*, size_t>& buffer) {
+          return reinterpret_cast<const int8_t*>(buffer.first) == group_by_buffer;
+        });
+    if (it == group_by_buffers_.end()) {
+      return false;
+    }
+    free(it->first);
+    group_by_buffers_.erase(it);
+    return true;
   }
 
   void addVarlenBuffer(void* varlen_buffer) {
@@ -274,8 +328,14 @@ class RowSetMemoryOwner : boost::noncopyable {
     for (auto count_distinct_set : count_distinct_sets_) {
       delete count_distinct_set;
     }
-    for (auto group_by_buffer : group_by_buffers_) {
-      free(group_by_buffer);
+    for (auto count_distinct_roaring : count_distinct_roarings_) {
+      delete count_distinct_roaring;
+    }
+    for (auto arena_block : arena_blocks_) {
+      free(arena_block);
+    }
+    for (const auto& group_by_buffer : group_by_buffers_) {
+      GroupByBufferPool::release(group_by_buffer.first, group_by_buffer.second);
     }
     for (auto varlen_buffer : varlen_buffers_) {
       free(varlen_buffer);
@@ -296,9 +356,15 @@ class RowSetMemoryOwner : boost::noncopyable {
     const bool system_allocated;
   };
 
+  static constexpr size_t kArenaBlockSize{size_t(1) << 20};
+
   std::vector<CountDistinctBitmapBuffer> count_distinct_bitmaps_;
+  std::vector<int8_t*> arena_blocks_;
+  int8_t* arena_ptr_{nullptr};
+  size_t arena_remaining_{0};
   std::vector<std::set<int64_t>*> count_distinct_sets_;
-  std::vector<int64_t*> group_by_buffers_;
+  std::vector<RoaringBitmap*> count_distinct_roarings_;
+  std::vector<std::pair<int64_t*, size_t>> group_by_buffers_;
   std::vector<void*> varlen_buffers_;
   std::list<std::string> strings_;
   std::list<std::vector<int64_t>> arrays_;
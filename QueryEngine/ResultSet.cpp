@@ -31,13 +31,21 @@
 #include "InPlaceSort.h"
 #include "OutputBufferInitialization.h"
 #include "RuntimeFunctions.h"
+#include "Shared/ThreadPool.h"
 #include "Shared/checked_alloc.h"
 #include "Shared/likely.h"
+#include "Shared/scope.h"
 #include "Shared/thread_count.h"
 #include "SqlTypesLayout.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
 #include <algorithm>
 #include <bitset>
+#include <cerrno>
+#include <cstdlib>
 #include <future>
 #include <numeric>
 
@@ -51,7 +59,8 @@ ResultSetStorage::ResultSetStorage(const std::vector<TargetInfo>& targets,
     , buff_is_provided_(buff_is_provided) {
   for (const auto& target_info : targets_) {
     if (target_info.agg_kind == kCOUNT ||
-        target_info.agg_kind == kAPPROX_COUNT_DISTINCT) {
+        is_approx_count_distinct(target_info.agg_kind) ||
+        target_info.agg_kind == kAPPROX_QUANTILE) {
       target_init_vals_.push_back(0);
       continue;
     }
@@ -200,6 +209,12 @@ ResultSet::ResultSet(int64_t queue_time_ms,
     , cached_row_count_(-1)
     , geo_return_type_(GeoReturnType::WktString){};
 
+ResultSetStorage::~ResultSetStorage() {
+  if (spilled_bytes_) {
+    munmap(buff_, spilled_bytes_);
+  }
+}
+
 ResultSet::~ResultSet() {
   if (storage_) {
     CHECK(storage_->getUnderlyingBuffer());
@@ -283,6 +298,81 @@ void ResultSet::append(ResultSet& that) {
   for (auto& buff : that.literal_buffers_) {
     literal_buffers_.push_back(std::move(buff));
   }
+  spillAppendedStorage(that.row_set_mem_owner_);
+}
+
+namespace {
+
+// Writes the buffer to an unlinked scratch file and maps the file privately, the pages
+// are only read back from it when accessed. Returns nullptr if it couldn't be written.
+int8_t* map_spilled_buffer(const int8_t* buff, const size_t num_bytes) {
+  const auto dir = g_result_set_spill_dir.empty()
+                       ? boost::filesystem::temp_directory_path()
+                       : boost::filesystem::path(g_result_set_spill_dir);
+  auto path = (dir / "mapd_spill_XXXXXX").string();
+  const int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    return nullptr;
+  }
+  ScopeGuard close_fd = [fd] { close(fd); };
+  unlink(path.c_str());
+  for (size_t written = 0; written < num_bytes;) {
+    const auto n = write(fd, buff + written, num_bytes - written);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return nullptr;
+    }
+    written += n;
+  }
+  const auto mapped =
+      mmap(nullptr, num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  return mapped == MAP_FAILED ? nullptr : static_cast<int8_t*>(mapped);
+}
+
+}  // namespace
+
+void ResultSet::spillAppendedStorage(
+    const std::shared_ptr<RowSetMemoryOwner>& buffer_owner) {
+  if (!g_result_set_spill_threshold_bytes || appended_storage_.empty() ||
+      appended_storage_.back()->spilled_bytes_ || !buffer_owner) {
+    return;
+  }
+  size_t in_memory_bytes{0};
+  const auto add_in_memory_bytes = [&in_memory_bytes](const ResultSetStorage& storage) {
+    if (!storage.spilled_bytes_) {
+      in_memory_bytes +=
+          storage.query_mem_desc_.getBufferSizeBytes(ExecutorDeviceType::CPU);
+    }
+  };
+  if (storage_) {
+    add_in_memory_bytes(*storage_);
+  }
+  for (const auto& storage : appended_storage_) {
+    add_in_memory_bytes(*storage);
+  }
+  if (in_memory_bytes <= g_result_set_spill_threshold_bytes) {
+    return;
+  }
+  auto& storage = *appended_storage_.back();
+  const auto num_bytes =
+      storage.query_mem_desc_.getBufferSizeBytes(ExecutorDeviceType::CPU);
+  if (!num_bytes || !storage.buff_is_provided_) {
+    return;
+  }
+  const auto mapped = map_spilled_buffer(storage.buff_, num_bytes);
+  if (!mapped) {
+    LOG(WARNING) << "Could not spill " << num_bytes << " bytes of a result set";
+    return;
+  }
+  // only the buffers of the pool can be freed ahead of the result set
+  if (!buffer_owner->freeGroupByBuffer(storage.buff_)) {
+    munmap(mapped, num_bytes);
+    return;
+  }
+  storage.buff_ = mapped;
+  storage.spilled_bytes_ = num_bytes;
 }
 
 const ResultSetStorage* ResultSet::getStorage() const {
@@ -415,6 +505,11 @@ void ResultSet::setQueueTime(const int64_t queue_time) {
   queue_time_ms_ = queue_time;
 }
 
+void ResultSet::prependExplanation(const std::string& line) {
+  CHECK(just_explain_);
+  explanation_ = line + "\n" + explanation_;
+}
+
 int64_t ResultSet::getQueueTime() const {
   return queue_time_ms_;
 }
@@ -432,6 +527,12 @@ bool ResultSet::isTruncated() const {
   return keep_first_ + drop_first_;
 }
 
+void ResultSet::checkInterrupted() const {
+  if (executor_) {
+    executor_->checkInterrupted();
+  }
+}
+
 QueryMemoryDescriptor ResultSet::fixupQueryMemoryDescriptor(
     const QueryMemoryDescriptor& query_mem_desc) {
   auto query_mem_desc_copy = query_mem_desc;
@@ -467,6 +568,7 @@ void ResultSet::sort(const std::list<Analyzer::OrderEntry>& order_entries,
                      const size_t top_n) {
   CHECK_EQ(-1, cached_row_count_);
   CHECK(!targets_.empty());
+  checkInterrupted();
 #ifdef HAVE_CUDA
   if (canUseFastBaselineSort(order_entries, top_n)) {
     baselineSort(order_entries, top_n);
@@ -507,6 +609,13 @@ void ResultSet::sort(const std::list<Analyzer::OrderEntry>& order_entries,
   }
 
   permutation_ = initPermutationBuffer(0, 1);
+  checkInterrupted();
+
+  if (g_enable_cpu_radix_sort && !use_heap && permutation_.size() > 100000 &&
+      canUseRadixSortPermutation(order_entries)) {
+    radixSortPermutation(order_entries);
+    return;
+  }
 
   auto compare = createComparator(order_entries, use_heap);
 
@@ -555,6 +664,45 @@ const std::vector<uint32_t>& ResultSet::getPermutationBuffer() const {
   return permutation_;
 }
 
+namespace {
+
+// Merges the top entries of the threads, which come out of topPermutation in order, into
+// the first n entries overall. A heap holds the current entry of every thread, the best
+// one goes first and is replaced by the next entry of the same thread.
+std::vector<uint32_t> merge_top_permutations(
+    const std::vector<std::vector<uint32_t>>& top_permutations,
+    const size_t n,
+    const std::function<bool(const uint32_t, const uint32_t)> compare) {
+  std::vector<size_t> positions(top_permutations.size(), 0);
+  std::vector<size_t> heap;
+  for (size_t i = 0; i < top_permutations.size(); ++i) {
+    if (!top_permutations[i].empty()) {
+      heap.push_back(i);
+    }
+  }
+  const auto compare_heads = [&top_permutations, &positions, &compare](const size_t lhs,
+                                                                       const size_t rhs) {
+    return compare(top_permutations[lhs][positions[lhs]],
+                   top_permutations[rhs][positions[rhs]]);
+  };
+  std::make_heap(heap.begin(), heap.end(), compare_heads);
+  std::vector<uint32_t> merged;
+  merged.reserve(n);
+  while (merged.size() < n && !heap.empty()) {
+    std::pop_heap(heap.begin(), heap.end(), compare_heads);
+    const auto i = heap.back();
+    merged.push_back(top_permutations[i][positions[i]]);
+    if (++positions[i] < top_permutations[i].size()) {
+      std::push_heap(heap.begin(), heap.end(), compare_heads);
+    } else {
+      heap.pop_back();
+    }
+  }
+  return merged;
+}
+
+}  // namespace
+
 void ResultSet::parallelTop(const std::list<Analyzer::OrderEntry>& order_entries,
                             const size_t top_n) {
   const size_t step = cpu_threads();
@@ -586,12 +734,7 @@ void ResultSet::parallelTop(const std::list<Analyzer::OrderEntry>& order_entries
   for (auto& top_future : top_futures) {
     top_future.get();
   }
-  permutation_.reserve(strided_permutations.size() * top_n);
-  for (const auto& strided_permutation : strided_permutations) {
-    permutation_.insert(
-        permutation_.end(), strided_permutation.begin(), strided_permutation.end());
-  }
-  topPermutation(permutation_, top_n, compare);
+  permutation_ = merge_top_permutations(strided_permutations, top_n, compare);
 }
 
 std::pair<ssize_t, size_t> ResultSet::getStorageIndex(const size_t entry_idx) const {
@@ -637,8 +780,10 @@ bool ResultSet::ResultSetComparator<BUFFER_ITERATOR_TYPE>::operator()(
   const auto rhs_storage = rhs_storage_lookup_result.storage_ptr;
   const auto fixedup_lhs = lhs_storage_lookup_result.fixedup_entry_idx;
   const auto fixedup_rhs = rhs_storage_lookup_result.fixedup_entry_idx;
+  auto sorted_ranks_it = sorted_ranks_.begin();
   for (const auto order_entry : order_entries_) {
     CHECK_GE(order_entry.tle_no, 1);
+    const auto& sorted_ranks = *sorted_ranks_it++;
     const auto& agg_info = result_set_->targets_[order_entry.tle_no - 1];
     const auto& entry_ti = get_compact_type(agg_info);
     bool float_argument_input = takes_float_argument(agg_info);
@@ -679,6 +824,16 @@ bool ResultSet::ResultSetComparator<BUFFER_ITERATOR_TYPE>::operator()(
       if (UNLIKELY(entry_ti.is_string() &&
                    entry_ti.get_compression() == kENCODING_DICT)) {
         CHECK_EQ(4, entry_ti.get_logical_size());
+        if (sorted_ranks) {
+          CHECK_LT(lhs_v.i1, static_cast<int64_t>(sorted_ranks->size()));
+          CHECK_LT(rhs_v.i1, static_cast<int64_t>(sorted_ranks->size()));
+          const auto lhs_rank = (*sorted_ranks)[lhs_v.i1];
+          const auto rhs_rank = (*sorted_ranks)[rhs_v.i1];
+          if (lhs_rank == rhs_rank) {
+            continue;
+          }
+          return use_desc_cmp ? lhs_rank > rhs_rank : lhs_rank < rhs_rank;
+        }
         const auto string_dict_proxy = result_set_->executor_->getStringDictionaryProxy(
             entry_ti.get_comp_param(), result_set_->row_set_mem_owner_, false);
         auto lhs_str = string_dict_proxy->getString(lhs_v.i1);
@@ -688,6 +843,24 @@ bool ResultSet::ResultSetComparator<BUFFER_ITERATOR_TYPE>::operator()(
         }
         return use_desc_cmp ? lhs_str > rhs_str : lhs_str < rhs_str;
       }
+      if (UNLIKELY(result_set_->targets_[order_entry.tle_no - 1].agg_kind ==
+                   kAPPROX_QUANTILE)) {
+        const auto& count_distinct_desc =
+            result_set_->query_mem_desc_.getCountDistinctDescriptor(order_entry.tle_no -
+                                                                    1);
+        const auto lhs_val = count_distinct_set_quantile(lhs_v.i1, count_distinct_desc);
+        const auto rhs_val = count_distinct_set_quantile(rhs_v.i1, count_distinct_desc);
+        if (lhs_val == rhs_val) {
+          continue;
+        }
+        if (lhs_val == NULL_DOUBLE || rhs_val == NULL_DOUBLE) {
+          // the groups without values, same as the null entries above
+          const bool nulls_first =
+              use_heap_ ? !order_entry.nulls_first : order_entry.nulls_first;
+          return nulls_first == (lhs_val == NULL_DOUBLE);
+        }
+        return use_desc_cmp ? lhs_val > rhs_val : lhs_val < rhs_val;
+      }
       if (UNLIKELY(is_distinct_target(result_set_->targets_[order_entry.tle_no - 1]))) {
         const auto lhs_sz = count_distinct_set_size(
             lhs_v.i1,
@@ -764,6 +937,225 @@ void ResultSet::sortPermutation(
   std::sort(permutation_.begin(), permutation_.end(), compare);
 }
 
+namespace {
+
+// One stable pass of a parallel LSD radix sort of the permutation, on the 8-bit digit
+// of the keys at the given shift. The keys are permuted along. Skipped if all the keys
+// have the same digit.
+void radix_sort_pass(std::vector<uint64_t>& keys,
+                     std::vector<uint32_t>& permutation,
+                     std::vector<uint64_t>& keys_tmp,
+                     std::vector<uint32_t>& permutation_tmp,
+                     const size_t shift) {
+  constexpr size_t digit_count{256};
+  const size_t entry_count = keys.size();
+  const size_t thread_count = threadpool::ThreadPool::instance().workerCount();
+  CHECK_GT(thread_count, size_t(0));
+  const size_t chunk_size = (entry_count + thread_count - 1) / thread_count;
+  std::vector<std::vector<size_t>> histograms(thread_count,
+                                              std::vector<size_t>(digit_count, 0));
+  std::vector<std::future<void>> histogram_threads;
+  for (size_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+    histogram_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+        [&keys, &histograms, thread_idx, chunk_size, entry_count, shift] {
+          auto& histogram = histograms[thread_idx];
+          const auto end = std::min(entry_count, (thread_idx + 1) * chunk_size);
+          for (size_t i = thread_idx * chunk_size; i < end; ++i) {
+            ++histogram[(keys[i] >> shift) & (digit_count - 1)];
+          }
+        }));
+  }
+  threadpool::wait_all(histogram_threads);
+  // Turn the counts into the positions where every thread writes its keys of a digit.
+  size_t offset{0};
+  for (size_t digit = 0; digit < digit_count; ++digit) {
+    size_t digit_total{0};
+    for (const auto& histogram : histograms) {
+      digit_total += histogram[digit];
+    }
+    if (digit_total == entry_count) {
+      return;
+    }
+    for (auto& histogram : histograms) {
+      const auto count = histogram[digit];
+      histogram[digit] = offset;
+      offset += count;
+    }
+  }
+  std::vector<std::future<void>> scatter_threads;
+  for (size_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+    scatter_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+        [&keys, &permutation, &keys_tmp, &permutation_tmp, &histograms, thread_idx,
+         chunk_size, entry_count, shift] {
+          auto& positions = histograms[thread_idx];
+          const auto end = std::min(entry_count, (thread_idx + 1) * chunk_size);
+          for (size_t i = thread_idx * chunk_size; i < end; ++i) {
+            const auto pos = positions[(keys[i] >> shift) & (digit_count - 1)]++;
+            keys_tmp[pos] = keys[i];
+            permutation_tmp[pos] = permutation[i];
+          }
+        }));
+  }
+  threadpool::wait_all(scatter_threads);
+  keys.swap(keys_tmp);
+  permutation.swap(permutation_tmp);
+}
+
+void radix_sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& permutation) {
+  std::vector<uint64_t> keys_tmp(keys.size());
+  std::vector<uint32_t> permutation_tmp(permutation.size());
+  for (size_t shift = 0; shift < sizeof(uint64_t) * 8; shift += 8) {
+    radix_sort_pass(keys, permutation, keys_tmp, permutation_tmp, shift);
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<const std::vector<int32_t>> ResultSet::getSortedRanks(
+    const Analyzer::OrderEntry& order_entry) const {
+  const auto& entry_ti = get_compact_type(targets_[order_entry.tle_no - 1]);
+  if (!entry_ti.is_string() || entry_ti.get_compression() != kENCODING_DICT ||
+      !entry_ti.get_comp_param()) {
+    return nullptr;
+  }
+  const auto string_dict_proxy = getStringDictionaryProxy(entry_ti.get_comp_param());
+  // Ranking sorts the whole dictionary the first time, not worth it for a few rows.
+  if (!string_dict_proxy ||
+      string_dict_proxy->storageEntryCount() > 16 * std::max(entryCount(), size_t(1))) {
+    return nullptr;
+  }
+  return string_dict_proxy->getSortedRanks();
+}
+
+// The order entries on numbers can be sorted on normalized keys instead of decoding the
+// rows in the comparator, so can the dictionary encoded strings through the ranks of
+// their ids. Averages and count distinct sets can't.
+bool ResultSet::canUseRadixSortPermutation(
+    const std::list<Analyzer::OrderEntry>& order_entries) const {
+  for (const auto& order_entry : order_entries) {
+    CHECK_GE(order_entry.tle_no, 1);
+    CHECK_LE(static_cast<size_t>(order_entry.tle_no), targets_.size());
+    const auto& agg_info = targets_[order_entry.tle_no - 1];
+    const auto& entry_ti = get_compact_type(agg_info);
+    if (is_distinct_target(agg_info) || (agg_info.is_agg && agg_info.agg_kind == kAVG)) {
+      return false;
+    }
+    if (entry_ti.is_string()) {
+      if (!getSortedRanks(order_entry)) {
+        return false;
+      }
+      continue;
+    }
+    if (!entry_ti.is_integer() && !entry_ti.is_decimal() && !entry_ti.is_fp() &&
+        !entry_ti.is_time() && !entry_ti.is_boolean()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sorts the permutation on one order entry at a time, from the last to the first. The
+// rows with a null stay in their order and go before or after the other ones, which
+// are sorted with a stable radix sort on the normalized values of the entry, on the GPU
+// if the query ran there.
+void ResultSet::radixSortPermutation(
+    const std::list<Analyzer::OrderEntry>& order_entries) {
+  std::vector<uint64_t> keys(permutation_.size());
+  std::vector<uint8_t> is_null(permutation_.size());
+  for (auto it = order_entries.rbegin(); it != order_entries.rend(); ++it) {
+    if (query_mem_desc_.didOutputColumnar()) {
+      normalizeSortKeys<ColumnWiseTargetAccessor>(*it, keys, is_null);
+    } else {
+      normalizeSortKeys<RowWiseTargetAccessor>(*it, keys, is_null);
+    }
+    std::vector<uint32_t> null_permutation;
+    std::vector<uint32_t> non_null_permutation;
+    std::vector<uint64_t> non_null_keys;
+    non_null_permutation.reserve(permutation_.size());
+    non_null_keys.reserve(permutation_.size());
+    for (size_t i = 0; i < permutation_.size(); ++i) {
+      if (is_null[i]) {
+        null_permutation.push_back(permutation_[i]);
+      } else {
+        non_null_permutation.push_back(permutation_[i]);
+        non_null_keys.push_back(keys[i]);
+      }
+    }
+#ifdef HAVE_CUDA
+    const bool use_gpu_sort = g_enable_gpu_sort &&
+                              device_type_ == ExecutorDeviceType::GPU &&
+                              getDataManager() && getGpuCount() > 0;
+    if (!use_gpu_sort || !stableSortKeysOnGpu(non_null_keys, non_null_permutation)) {
+      radix_sort(non_null_keys, non_null_permutation);
+    }
+#else
+    radix_sort(non_null_keys, non_null_permutation);
+#endif  // HAVE_CUDA
+    const auto& first = it->nulls_first ? null_permutation : non_null_permutation;
+    const auto& second = it->nulls_first ? non_null_permutation : null_permutation;
+    std::copy(first.begin(), first.end(), permutation_.begin());
+    std::copy(second.begin(), second.end(), permutation_.begin() + first.size());
+  }
+}
+
+template <typename BUFFER_ITERATOR_TYPE>
+void ResultSet::normalizeSortKeys(const Analyzer::OrderEntry& order_entry,
+                                  std::vector<uint64_t>& keys,
+                                  std::vector<uint8_t>& is_null) const {
+  const auto target_idx = order_entry.tle_no - 1;
+  const auto& agg_info = targets_[target_idx];
+  const auto& entry_ti = get_compact_type(agg_info);
+  bool float_argument_input = takes_float_argument(agg_info);
+  // Same as in ResultSetComparator, the floats can be stored on 4 bytes anyway.
+  if (entry_ti.get_type() == kFLOAT &&
+      query_mem_desc_.getColumnWidth(target_idx).compact == sizeof(float)) {
+    float_argument_input = true;
+  }
+  const uint64_t sign_bit{uint64_t(1) << 63};
+  const auto sorted_ranks = getSortedRanks(order_entry);
+  const BUFFER_ITERATOR_TYPE buffer_itr(this);
+  const auto entry_count = permutation_.size();
+  const size_t thread_count = threadpool::ThreadPool::instance().workerCount();
+  const size_t chunk_size = (entry_count + thread_count - 1) / thread_count;
+  auto normalize_range = [&](const size_t start, const size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      const auto storage_lookup_result = findStorage(permutation_[i]);
+      const auto val =
+          buffer_itr.getColumnInternal(storage_lookup_result.storage_ptr->buff_,
+                                       storage_lookup_result.fixedup_entry_idx,
+                                       target_idx,
+                                       storage_lookup_result);
+      CHECK(val.isInt());
+      is_null[i] = isNull(entry_ti, val, float_argument_input);
+      if (is_null[i]) {
+        continue;
+      }
+      uint64_t key{0};
+      if (entry_ti.is_fp()) {
+        const double dval =
+            float_argument_input
+                ? *reinterpret_cast<const float*>(may_alias_ptr(&val.i1))
+                : *reinterpret_cast<const double*>(may_alias_ptr(&val.i1));
+        key = *reinterpret_cast<const uint64_t*>(may_alias_ptr(&dval));
+        // Negative numbers sort in the reverse order of their bits.
+        key = (key & sign_bit) ? ~key : key | sign_bit;
+      } else if (sorted_ranks) {
+        CHECK_LT(val.i1, static_cast<int64_t>(sorted_ranks->size()));
+        key = static_cast<uint64_t>((*sorted_ranks)[val.i1]);
+      } else {
+        key = static_cast<uint64_t>(val.i1) ^ sign_bit;
+      }
+      keys[i] = order_entry.is_desc ? ~key : key;
+    }
+  };
+  std::vector<std::future<void>> normalization_threads;
+  for (size_t start = 0; start < entry_count; start += chunk_size) {
+    normalization_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+        normalize_range, start, std::min(entry_count, start + chunk_size)));
+  }
+  threadpool::wait_all(normalization_threads);
+}
+
 void ResultSet::radixSortOnGpu(
     const std::list<Analyzer::OrderEntry>& order_entries) const {
   auto data_mgr = &executor_->catalog_->get_dataMgr();
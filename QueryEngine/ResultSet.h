@@ -85,6 +85,8 @@ class ResultSetStorage {
                    int8_t* buff,
                    const bool buff_is_provided);
 
+  ~ResultSetStorage();
+
   void reduce(const ResultSetStorage& that,
               const std::vector<std::string>& serialized_varlen_buffer) const;
 
@@ -105,6 +107,14 @@ class ResultSetStorage {
       const size_t end_index,
       const std::vector<std::string>& serialized_varlen_buffer) const;
 
+  bool reduceColumnNoCollisionsColWise(int8_t* this_col_ptr,
+                                       const int8_t* that_col_ptr,
+                                       const int8_t* that_buff,
+                                       const size_t start_index,
+                                       const size_t end_index,
+                                       const TargetInfo& agg_info,
+                                       const size_t agg_col_idx) const;
+
   void copyKeyColWise(const size_t entry_idx,
                       int8_t* this_buff,
                       const int8_t* that_buff) const;
@@ -120,6 +130,7 @@ class ResultSetStorage {
   bool isEmptyEntry(const size_t entry_idx) const;
 
   void reduceOneEntryBaseline(int8_t* this_buff,
+                              const size_t this_entry_count,
                               const int8_t* that_buff,
                               const size_t i,
                               const size_t that_entry_count,
@@ -179,6 +190,8 @@ class ResultSetStorage {
   const QueryMemoryDescriptor query_mem_desc_;
   int8_t* buff_;
   const bool buff_is_provided_;
+  // Size of the scratch file mapping which replaced the buffer, 0 if not spilled.
+  size_t spilled_bytes_{0};
   std::vector<int64_t> target_init_vals_;
   // Provisional field used for multi-node until we improve the count distinct
   // and flatten the main group by buffer and the distinct buffers in a single,
@@ -200,6 +213,7 @@ struct OrderEntry;
 }  // namespace Analyzer
 
 class Executor;
+class StringDictionaryProxy;
 
 struct ColumnLazyFetchInfo {
   const bool is_lazily_fetched;
@@ -281,6 +295,18 @@ class ResultSetRowIterator {
   friend class ResultSet;
 };
 
+// A column of the rows fetched by ResultSet::getNextColumnsBulk or getColumnsBulk.
+// Integers, booleans, times, decimals and the ids of the dictionary encoded strings go
+// to int_values, floats, doubles and the decimals converted to double to real_values,
+// the other strings to str_values, with a null flag per row in nulls. The translated
+// dictionary encoded strings are moved to str_values, empty for the nulls.
+struct ResultSetBulkColumn {
+  std::vector<int64_t> int_values;
+  std::vector<double> real_values;
+  std::vector<std::string> str_values;
+  std::vector<bool> nulls;
+};
+
 class TSerializedRows;
 
 class ResultSet {
@@ -364,6 +390,28 @@ class ResultSet {
 
   bool isRowAtEmpty(const size_t index) const;
 
+  // Whether all the targets are scalars the bulk getters below can decode, not arrays,
+  // geo types or approximate count distinct sketches.
+  bool canFetchColumnsBulk() const;
+
+  // Moves the cursor like getNextRow over up to max_rows rows and decodes them into
+  // columns, one per target, without building a row per value. The strings of a
+  // dictionary are translated in a single pass over the column, each distinct id looked
+  // up once. Returns the number of rows fetched.
+  size_t getNextColumnsBulk(std::vector<ResultSetBulkColumn>& columns,
+                            const size_t max_rows,
+                            const bool translate_strings,
+                            const bool decimal_to_double) const;
+
+  // Decodes the non-empty entries of the logical range [first_entry, end_entry) like
+  // getRowAtNoTranslations, without moving the cursor. Returns the number of rows.
+  size_t getColumnsBulk(std::vector<ResultSetBulkColumn>& columns,
+                        const size_t first_entry,
+                        const size_t end_entry) const;
+
+  // A sorted result set only has the logical indices of its rows, no empty entries.
+  bool isPermutationBufferEmpty() const { return permutation_.empty(); }
+
   void sort(const std::list<Analyzer::OrderEntry>& order_entries, const size_t top_n);
 
   void keepFirstN(const size_t n);
@@ -372,8 +420,22 @@ class ResultSet {
 
   void append(ResultSet& that);
 
+  // Moves the buffer of the last appended storage to a scratch file mapped back in its
+  // place once the buffers of the result set exceed g_result_set_spill_threshold_bytes.
+  // Its pages can then be evicted to the file instead of being held in memory, the
+  // iteration and the conversions read them back through the mapping.
+  void spillAppendedStorage(const std::shared_ptr<RowSetMemoryOwner>& buffer_owner);
+
   const ResultSetStorage* getStorage() const;
 
+  // The buffers of the columns of a columnar projection, read in place from the first of
+  // the entries, and the count of their rows. Empty unless all the columns are numbers,
+  // timestamps or dictionary encoded strings stored at the width of their type and the
+  // rows of the entries are contiguous.
+  std::vector<const int8_t*> getColumnarProjectionBuffers(const size_t first_entry,
+                                                          const size_t entry_count,
+                                                          size_t& row_count) const;
+
   size_t colCount() const;
 
   SQLTypeInfo getColType(const size_t col_idx) const;
@@ -406,10 +468,17 @@ class ResultSet {
 
   int64_t getRenderTime() const;
 
+  // Adds a line in front of the plan returned for an EXPLAIN query.
+  void prependExplanation(const std::string& line);
+
   void moveToBegin() const;
 
   bool isTruncated() const;
 
+  // Throws QueryInterrupted if the executor has been interrupted, checked by the loops
+  // over the entries which run after the kernels.
+  void checkInterrupted() const;
+
   // Called from the executor because in the new ResultSet we assume the 'compact' field
   // in ColWidths already contains the padding, whereas in the executor it's computed.
   // Once the buffer initialization moves to ResultSet we can remove this method.
@@ -461,6 +530,11 @@ class ResultSet {
                            const std::vector<std::string>& col_names,
                            const int32_t first_n) const;
 
+  // Shared memory copy of the Arrow batch of the given range of entries.
+  ArrowResult getArrowCopyOfEntries(const std::vector<std::string>& col_names,
+                                    const size_t first_entry,
+                                    const size_t entry_count) const;
+
   size_t getLimit();
 
   enum class GeoReturnType { GeoTargetValue, WktString };
@@ -476,11 +550,28 @@ class ResultSet {
   std::vector<TargetValue> getNextRowUnlocked(const bool translate_strings,
                                               const bool decimal_to_double) const;
 
+  // Moves the cursor past the next row and sets entry_buff_idx to its entry, returns
+  // false at the end of the result.
+  bool fetchNextEntry(size_t& entry_buff_idx) const;
+
   std::vector<TargetValue> getRowAt(const size_t index,
                                     const bool translate_strings,
                                     const bool decimal_to_double,
                                     const bool fixup_count_distinct_pointers) const;
 
+  // Decodes the targets of an entry and passes them to callback with their index,
+  // returns false if the entry is empty.
+  template <typename TargetCallback>
+  bool visitRowTargets(const size_t index,
+                       const bool translate_strings,
+                       const bool decimal_to_double,
+                       const bool fixup_count_distinct_pointers,
+                       TargetCallback callback) const;
+
+  void translateBulkStrings(std::vector<ResultSetBulkColumn>& columns) const;
+
+  StringDictionaryProxy* getStringDictionaryProxy(const int dict_id) const;
+
   size_t parallelRowCount() const;
 
   size_t advanceCursorToNextEntry() const;
@@ -642,7 +733,11 @@ class ResultSet {
         : order_entries_(order_entries)
         , use_heap_(use_heap)
         , result_set_(result_set)
-        , buffer_itr_(result_set) {}
+        , buffer_itr_(result_set) {
+      for (const auto& order_entry : order_entries_) {
+        sorted_ranks_.push_back(result_set_->getSortedRanks(order_entry));
+      }
+    }
 
     bool operator()(const uint32_t lhs, const uint32_t rhs) const;
 
@@ -651,6 +746,8 @@ class ResultSet {
     const bool use_heap_;
     const ResultSet* result_set_;
     const BufferIteratorType buffer_itr_;
+    // For each order entry, the ranks of the strings if it's a dictionary encoded one.
+    std::vector<std::shared_ptr<const std::vector<int32_t>>> sorted_ranks_;
   };
 
   std::function<bool(const uint32_t, const uint32_t)> createComparator(
@@ -679,6 +776,23 @@ class ResultSet {
 
   void sortPermutation(const std::function<bool(const uint32_t, const uint32_t)> compare);
 
+  bool canUseRadixSortPermutation(
+      const std::list<Analyzer::OrderEntry>& order_entries) const;
+
+  // The ids of a dictionary encoded order entry sort as their ranks in the dictionary,
+  // null if the entry isn't one or the dictionary can't rank its strings.
+  std::shared_ptr<const std::vector<int32_t>> getSortedRanks(
+      const Analyzer::OrderEntry& order_entry) const;
+
+  void radixSortPermutation(const std::list<Analyzer::OrderEntry>& order_entries);
+
+  // Maps the values of an order entry for the rows of the permutation to unsigned keys
+  // which sort in the order of the entry, except for the nulls.
+  template <typename BUFFER_ITERATOR_TYPE>
+  void normalizeSortKeys(const Analyzer::OrderEntry& order_entry,
+                         std::vector<uint64_t>& keys,
+                         std::vector<uint8_t>& is_null) const;
+
   std::vector<uint32_t> initPermutationBuffer(const size_t start, const size_t step);
 
   void parallelTop(const std::list<Analyzer::OrderEntry>& order_entries,
@@ -698,14 +812,27 @@ class ResultSet {
 
   int getGpuCount() const;
 
+  bool stableSortKeysOnGpu(std::vector<uint64_t>& keys,
+                           std::vector<uint32_t>& permutation) const;
+
   std::shared_ptr<arrow::RecordBatch> convertToArrow(
       const std::vector<std::string>& col_names,
       arrow::ipc::DictionaryMemo& memo,
-      const int32_t first_n) const;
+      const size_t first_entry,
+      const size_t entry_count) const;
   std::shared_ptr<const std::vector<std::string>> getDictionary(const int dict_id) const;
   std::shared_ptr<arrow::RecordBatch> getArrowBatch(
       const std::shared_ptr<arrow::Schema>& schema,
-      const int32_t first_n) const;
+      const size_t first_entry,
+      const size_t entry_count) const;
+  std::shared_ptr<arrow::RecordBatch> getColumnarArrowBatch(
+      const std::shared_ptr<arrow::Schema>& schema,
+      const size_t first_entry,
+      const size_t entry_count) const;
+  SerializedArrowOutput getSerializedArrowEntries(
+      const std::vector<std::string>& col_names,
+      const size_t first_entry,
+      const size_t entry_count) const;
 
   ArrowResult getArrowCopyOnCpu(const std::vector<std::string>& col_names,
                                 const int32_t first_n) const;
@@ -817,6 +944,8 @@ class ResultSetManager {
   void rewriteVarlenAggregates(ResultSet*);
 
  private:
+  ResultSet* reducePartitioned(std::vector<ResultSet*>&, const size_t total_entry_count);
+
   std::shared_ptr<ResultSet> rs_;
 };
 
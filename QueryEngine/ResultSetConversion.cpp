@@ -119,12 +119,9 @@ SQLTypes get_physical_type(const SQLTypeInfo& ti) {
 }
 
 template <typename TYPE, typename C_TYPE>
-void create_or_append_value(const ScalarTargetValue& val_cty,
-                            std::shared_ptr<ValueArray>& values,
-                            const size_t max_size) {
-  auto pval_cty = boost::get<C_TYPE>(&val_cty);
-  CHECK(pval_cty);
-  auto val_ty = static_cast<TYPE>(*pval_cty);
+void create_or_append_values(const std::vector<C_TYPE>& vals_cty,
+                             std::shared_ptr<ValueArray>& values,
+                             const size_t max_size) {
   if (!values) {
     values = std::make_shared<ValueArray>(std::vector<TYPE>());
     boost::get<std::vector<TYPE>>(*values).reserve(max_size);
@@ -132,11 +129,12 @@ void create_or_append_value(const ScalarTargetValue& val_cty,
   CHECK(values);
   auto values_ty = boost::get<std::vector<TYPE>>(values.get());
   CHECK(values_ty);
-  values_ty->push_back(val_ty);
+  for (const auto val_cty : vals_cty) {
+    values_ty->push_back(static_cast<TYPE>(val_cty));
+  }
 }
 
-template <typename TYPE>
-void create_or_append_validity(const ScalarTargetValue& value,
+void create_or_append_validity(const std::vector<bool>& nulls,
                                const SQLTypeInfo& col_type,
                                std::shared_ptr<std::vector<bool>>& null_bitmap,
                                const size_t max_size) {
@@ -144,27 +142,48 @@ void create_or_append_validity(const ScalarTargetValue& value,
     CHECK(!null_bitmap);
     return;
   }
-  auto pvalue = boost::get<TYPE>(&value);
-  CHECK(pvalue);
-  bool is_valid = false;
-  if (is_dict_enc_str(col_type)) {
-    is_valid = inline_int_null_val(col_type) != static_cast<int32_t>(*pvalue);
-  } else if (col_type.is_integer()) {
-    is_valid = inline_int_null_val(col_type) != static_cast<int64_t>(*pvalue);
-  } else if (col_type.get_type() == kTIMESTAMP) {
-    is_valid = inline_int_null_val(col_type) != static_cast<int64_t>(*pvalue);
-  } else if (col_type.get_type() == kTIME || col_type.get_type() == kDATE) {
-    is_valid = inline_int_null_val(col_type) != static_cast<int64_t>(*pvalue);
-  } else {
-    CHECK(col_type.is_fp());
-    is_valid = inline_fp_null_val(col_type) != static_cast<double>(*pvalue);
-  }
   if (!null_bitmap) {
     null_bitmap = std::make_shared<std::vector<bool>>();
     null_bitmap->reserve(max_size);
   }
   CHECK(null_bitmap);
-  null_bitmap->push_back(is_valid);
+  for (const bool is_null : nulls) {
+    null_bitmap->push_back(!is_null);
+  }
+}
+
+// Builds the Arrow validity bitmap of the values eight at a time, without branches so
+// that the loop vectorizes. Returns nullptr if none of the values is null.
+template <typename TYPE>
+std::shared_ptr<arrow::Buffer> make_validity_bitmap(const TYPE* values,
+                                                    const size_t row_count,
+                                                    const TYPE null_val,
+                                                    int64_t& null_count) {
+  std::shared_ptr<arrow::Buffer> bitmap;
+  ARROW_THROW_NOT_OK(arrow::AllocateBuffer(
+      arrow::default_memory_pool(), (row_count + 7) / 8, &bitmap));
+  auto bitmap_data = bitmap->mutable_data();
+  size_t valid_count{0};
+  const size_t full_byte_count = row_count / 8;
+  for (size_t i = 0; i < full_byte_count; ++i) {
+    uint8_t valid_bits{0};
+    for (size_t j = 0; j < 8; ++j) {
+      valid_bits |= static_cast<uint8_t>(values[i * 8 + j] != null_val) << j;
+    }
+    bitmap_data[i] = valid_bits;
+    valid_count += __builtin_popcount(valid_bits);
+  }
+  if (row_count % 8) {
+    uint8_t valid_bits{0};
+    for (size_t j = 0; j < row_count % 8; ++j) {
+      valid_bits |= static_cast<uint8_t>(values[full_byte_count * 8 + j] != null_val)
+                    << j;
+    }
+    bitmap_data[full_byte_count] = valid_bits;
+    valid_count += __builtin_popcount(valid_bits);
+  }
+  null_count = row_count - valid_count;
+  return null_count ? bitmap : nullptr;
 }
 
 }  // namespace
@@ -418,6 +437,35 @@ key_t get_and_copy_to_shm(const std::shared_ptr<Buffer>& data) {
 
 }  // namespace arrow
 
+namespace {
+
+ArrowResult copy_serialized_arrow_to_shm(
+    const ResultSet::SerializedArrowOutput& serialized_arrow_output) {
+  const auto& serialized_schema = serialized_arrow_output.schema;
+  const auto& serialized_records = serialized_arrow_output.records;
+
+  const auto schema_key = arrow::get_and_copy_to_shm(serialized_schema);
+  CHECK(schema_key != IPC_PRIVATE);
+  std::vector<char> schema_handle_buffer(sizeof(key_t), 0);
+  memcpy(&schema_handle_buffer[0],
+         reinterpret_cast<const unsigned char*>(&schema_key),
+         sizeof(key_t));
+
+  const auto record_key = arrow::get_and_copy_to_shm(serialized_records);
+  std::vector<char> record_handle_buffer(sizeof(key_t), 0);
+  memcpy(&record_handle_buffer[0],
+         reinterpret_cast<const unsigned char*>(&record_key),
+         sizeof(key_t));
+
+  return {schema_handle_buffer,
+          serialized_schema->size(),
+          record_handle_buffer,
+          serialized_records->size(),
+          nullptr};
+}
+
+}  // namespace
+
 std::shared_ptr<const std::vector<std::string>> ResultSet::getDictionary(
     const int dict_id) const {
   const auto sdp =
@@ -428,14 +476,18 @@ std::shared_ptr<const std::vector<std::string>> ResultSet::getDictionary(
 
 std::shared_ptr<arrow::RecordBatch> ResultSet::getArrowBatch(
     const std::shared_ptr<arrow::Schema>& schema,
-    const int32_t first_n) const {
+    const size_t first_entry,
+    const size_t entry_count) const {
   std::vector<std::shared_ptr<arrow::Array>> result_columns;
 
-  const size_t entry_count =
-      first_n < 0 ? entryCount() : std::min(size_t(first_n), entryCount());
+  CHECK_LE(first_entry + entry_count, entryCount());
   if (!entry_count) {
     return ARROW_RECORDBATCH_MAKE(schema, 0, result_columns);
   }
+  const auto columnar_batch = getColumnarArrowBatch(schema, first_entry, entry_count);
+  if (columnar_batch) {
+    return columnar_batch;
+  }
   const auto col_count = colCount();
   size_t row_count = 0;
 
@@ -453,86 +505,52 @@ std::shared_ptr<arrow::RecordBatch> ResultSet::getArrowBatch(
                    const size_t end_entry) -> size_t {
     CHECK_EQ(value_seg.size(), col_count);
     CHECK_EQ(null_bitmap_seg.size(), col_count);
+    checkInterrupted();
     const auto entry_count = end_entry - start_entry;
-    size_t seg_row_count = 0;
-    for (size_t i = start_entry; i < end_entry; ++i) {
-      auto row = getRowAtNoTranslations(i);
-      if (row.empty()) {
-        continue;
-      }
-      ++seg_row_count;
-      for (size_t j = 0; j < col_count; ++j) {
-        auto scalar_value = boost::get<ScalarTargetValue>(&row[j]);
-        // TODO(miyu): support more types other than scalar.
-        CHECK(scalar_value);
-        const auto& column = builders[j];
-        switch (column.physical_type) {
-          case kBOOLEAN:
-            create_or_append_value<bool, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kTINYINT:
-            create_or_append_value<int8_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kSMALLINT:
-            create_or_append_value<int16_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kINT:
-            create_or_append_value<int32_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kBIGINT:
-            create_or_append_value<int64_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kFLOAT:
-            create_or_append_value<float, float>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<float>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kDOUBLE:
-            create_or_append_value<double, double>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<double>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kTIME:
-            create_or_append_value<int32_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kDATE:
-            create_or_append_value<int32_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          case kTIMESTAMP:
-            create_or_append_value<int64_t, int64_t>(
-                *scalar_value, value_seg[j], entry_count);
-            create_or_append_validity<int64_t>(
-                *scalar_value, column.col_type, null_bitmap_seg[j], entry_count);
-            break;
-          default:
-            // TODO(miyu): support more scalar types.
-            throw std::runtime_error(column.col_type.get_type_name() +
-                                     " is not supported in Arrow result sets.");
-        }
+    std::vector<ResultSetBulkColumn> bulk_columns;
+    const auto seg_row_count = getColumnsBulk(bulk_columns, start_entry, end_entry);
+    for (size_t j = 0; j < col_count; ++j) {
+      const auto& column = builders[j];
+      const auto& int_values = bulk_columns[j].int_values;
+      const auto& real_values = bulk_columns[j].real_values;
+      switch (column.physical_type) {
+        case kBOOLEAN:
+          create_or_append_values<bool>(int_values, value_seg[j], entry_count);
+          break;
+        case kTINYINT:
+          create_or_append_values<int8_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kSMALLINT:
+          create_or_append_values<int16_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kINT:
+          create_or_append_values<int32_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kBIGINT:
+          create_or_append_values<int64_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kFLOAT:
+          create_or_append_values<float>(real_values, value_seg[j], entry_count);
+          break;
+        case kDOUBLE:
+          create_or_append_values<double>(real_values, value_seg[j], entry_count);
+          break;
+        case kTIME:
+          create_or_append_values<int32_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kDATE:
+          create_or_append_values<int32_t>(int_values, value_seg[j], entry_count);
+          break;
+        case kTIMESTAMP:
+          create_or_append_values<int64_t>(int_values, value_seg[j], entry_count);
+          break;
+        default:
+          // TODO(miyu): support more scalar types.
+          throw std::runtime_error(column.col_type.get_type_name() +
+                                   " is not supported in Arrow result sets.");
       }
+      create_or_append_validity(
+          bulk_columns[j].nulls, column.col_type, null_bitmap_seg[j], entry_count);
     }
     return seg_row_count;
   };
@@ -548,9 +566,10 @@ std::shared_ptr<arrow::RecordBatch> ResultSet::getArrowBatch(
     std::vector<std::vector<std::shared_ptr<std::vector<bool>>>> null_bitmap_segs(
         cpu_count, std::vector<std::shared_ptr<std::vector<bool>>>(col_count, nullptr));
     const auto stride = (entry_count + cpu_count - 1) / cpu_count;
-    for (size_t i = 0, start_entry = 0; start_entry < entry_count;
+    const auto last_entry = first_entry + entry_count;
+    for (size_t i = 0, start_entry = first_entry; start_entry < last_entry;
          ++i, start_entry += stride) {
-      const auto end_entry = std::min(entry_count, start_entry + stride);
+      const auto end_entry = std::min(last_entry, start_entry + stride);
       child_threads.push_back(std::async(std::launch::async,
                                          fetch,
                                          std::ref(column_value_segs[i]),
@@ -571,7 +590,8 @@ std::shared_ptr<arrow::RecordBatch> ResultSet::getArrowBatch(
       }
     }
   } else {
-    row_count = fetch(column_values, null_bitmaps, size_t(0), entry_count);
+    row_count =
+        fetch(column_values, null_bitmaps, first_entry, first_entry + entry_count);
     for (int i = 0; i < schema->num_fields(); ++i) {
       builders[i].reserve(row_count);
       builders[i].append(*column_values[i], null_bitmaps[i]);
@@ -584,10 +604,162 @@ std::shared_ptr<arrow::RecordBatch> ResultSet::getArrowBatch(
   return ARROW_RECORDBATCH_MAKE(schema, row_count, result_columns);
 }
 
+std::vector<const int8_t*> ResultSet::getColumnarProjectionBuffers(
+    const size_t first_entry,
+    const size_t entry_count,
+    size_t& row_count) const {
+  row_count = 0;
+  if (!storage_ || !appended_storage_.empty() || !permutation_.empty() ||
+      isTruncated() || !query_mem_desc_.didOutputColumnar() ||
+      query_mem_desc_.getQueryDescriptionType() != QueryDescriptionType::Projection ||
+      query_mem_desc_.getKeyCount() != 1) {
+    return {};
+  }
+  const auto col_count = colCount();
+  for (size_t i = 0; i < col_count; ++i) {
+    if (!lazy_fetch_info_.empty() && lazy_fetch_info_[i].is_lazily_fetched) {
+      return {};
+    }
+    const auto& col_type = getColType(i);
+    size_t type_width{0};
+    switch (get_physical_type(col_type)) {
+      case kTINYINT:
+      case kSMALLINT:
+      case kINT:
+      case kBIGINT:
+      case kFLOAT:
+      case kDOUBLE:
+      case kTIMESTAMP:
+        type_width = col_type.get_size();
+        break;
+      case kCHAR:
+      case kVARCHAR:
+      case kTEXT:
+        if (is_dict_enc_str(col_type) && col_type.get_size() == sizeof(int32_t)) {
+          type_width = sizeof(int32_t);
+        }
+        break;
+      default:
+        break;
+    }
+    if (!type_width ||
+        static_cast<size_t>(query_mem_desc_.getColumnWidth(i).compact) != type_width) {
+      return {};
+    }
+  }
+  const auto buff = storage_->getUnderlyingBuffer();
+  const auto keys = reinterpret_cast<const int64_t*>(buff) + first_entry;
+  const auto filled_count = static_cast<size_t>(
+      std::find(keys, keys + entry_count, EMPTY_KEY_64) - keys);
+  if (std::find_if(keys + filled_count, keys + entry_count, [](const int64_t key) {
+        return key != EMPTY_KEY_64;
+      }) != keys + entry_count) {
+    return {};
+  }
+  std::vector<const int8_t*> col_buffers;
+  auto col_ptr = get_cols_ptr(buff, query_mem_desc_);
+  for (size_t i = 0; i < col_count; ++i) {
+    const auto width = query_mem_desc_.getColumnWidth(i).compact;
+    col_buffers.push_back(col_ptr + first_entry * width);
+    col_ptr = advance_to_next_columnar_target_buff(col_ptr, query_mem_desc_, i);
+  }
+  row_count = filled_count;
+  return col_buffers;
+}
+
+// The columns of a columnar projection are wrapped as they are in the Arrow arrays, only
+// the validity bitmaps get built. The arrays don't own the values, the batch must not
+// outlive the result set. Returns nullptr unless all the columns have the width of
+// their Arrow type and the rows of the entries are contiguous.
+std::shared_ptr<arrow::RecordBatch> ResultSet::getColumnarArrowBatch(
+    const std::shared_ptr<arrow::Schema>& schema,
+    const size_t first_entry,
+    const size_t entry_count) const {
+  size_t row_count{0};
+  const auto col_buffers =
+      getColumnarProjectionBuffers(first_entry, entry_count, row_count);
+  if (col_buffers.empty()) {
+    return nullptr;
+  }
+  std::vector<std::shared_ptr<arrow::Array>> result_columns;
+  for (size_t i = 0; i < col_buffers.size(); ++i) {
+    const auto& col_type = getColType(i);
+    const auto width = query_mem_desc_.getColumnWidth(i).compact;
+    const auto entries_ptr = col_buffers[i];
+    std::shared_ptr<arrow::Buffer> bitmap;
+    int64_t null_count{0};
+    if (!col_type.get_notnull()) {
+      switch (width) {
+        case 1:
+          bitmap =
+              make_validity_bitmap(entries_ptr,
+                                   row_count,
+                                   static_cast<int8_t>(inline_int_null_val(col_type)),
+                                   null_count);
+          break;
+        case 2:
+          bitmap =
+              make_validity_bitmap(reinterpret_cast<const int16_t*>(entries_ptr),
+                                   row_count,
+                                   static_cast<int16_t>(inline_int_null_val(col_type)),
+                                   null_count);
+          break;
+        case 4:
+          if (col_type.is_fp()) {
+            bitmap =
+                make_validity_bitmap(reinterpret_cast<const float*>(entries_ptr),
+                                     row_count,
+                                     static_cast<float>(inline_fp_null_val(col_type)),
+                                     null_count);
+          } else {
+            bitmap =
+                make_validity_bitmap(reinterpret_cast<const int32_t*>(entries_ptr),
+                                     row_count,
+                                     static_cast<int32_t>(inline_int_null_val(col_type)),
+                                     null_count);
+          }
+          break;
+        case 8:
+          if (col_type.is_fp()) {
+            bitmap = make_validity_bitmap(reinterpret_cast<const double*>(entries_ptr),
+                                          row_count,
+                                          inline_fp_null_val(col_type),
+                                          null_count);
+          } else {
+            bitmap = make_validity_bitmap(reinterpret_cast<const int64_t*>(entries_ptr),
+                                          row_count,
+                                          inline_int_null_val(col_type),
+                                          null_count);
+          }
+          break;
+        default:
+          CHECK(false);
+      }
+    }
+    const auto values = std::make_shared<arrow::Buffer>(
+        reinterpret_cast<const uint8_t*>(entries_ptr), row_count * width);
+    const auto field = schema->field(i);
+    auto value_type = field->type();
+    if (value_type->id() == arrow::Type::DICTIONARY) {
+      value_type = static_cast<const arrow::DictionaryType&>(*value_type).index_type();
+    }
+    const auto array = arrow::MakeArray(arrow::ArrayData::Make(
+        value_type, row_count, {bitmap, values}, null_count));
+    if (field->type()->id() == arrow::Type::DICTIONARY) {
+      result_columns.push_back(
+          std::make_shared<arrow::DictionaryArray>(field->type(), array));
+    } else {
+      result_columns.push_back(array);
+    }
+  }
+  return ARROW_RECORDBATCH_MAKE(schema, row_count, result_columns);
+}
+
 std::shared_ptr<arrow::RecordBatch> ResultSet::convertToArrow(
     const std::vector<std::string>& col_names,
     arrow::ipc::DictionaryMemo& memo,
-    const int32_t first_n) const {
+    const size_t first_entry,
+    const size_t entry_count) const {
   const auto col_count = colCount();
   std::vector<std::shared_ptr<arrow::Field>> fields;
   CHECK(col_names.empty() || col_names.size() == col_count);
@@ -613,15 +785,25 @@ std::shared_ptr<arrow::RecordBatch> ResultSet::convertToArrow(
     }
     fields.push_back(arrow::make_field(col_names.empty() ? "" : col_names[i], ti, dict));
   }
-  return getArrowBatch(arrow::schema(fields), first_n);
+  return getArrowBatch(arrow::schema(fields), first_entry, entry_count);
 }
 
 ResultSet::SerializedArrowOutput ResultSet::getSerializedArrowOutput(
     const std::vector<std::string>& col_names,
     const int32_t first_n) const {
+  const size_t entry_count =
+      first_n < 0 ? entryCount() : std::min(size_t(first_n), entryCount());
+  return getSerializedArrowEntries(col_names, 0, entry_count);
+}
+
+ResultSet::SerializedArrowOutput ResultSet::getSerializedArrowEntries(
+    const std::vector<std::string>& col_names,
+    const size_t first_entry,
+    const size_t entry_count) const {
   arrow::ipc::DictionaryMemo dict_memo;
   std::shared_ptr<arrow::RecordBatch> arrow_copy =
-      convertToArrow(col_names, dict_memo, first_n);
+      convertToArrow(col_names, dict_memo, first_entry, entry_count);
+  checkInterrupted();
   std::shared_ptr<arrow::Buffer> serialized_records, serialized_schema;
 
   ARROW_THROW_NOT_OK(arrow::ipc::SerializeSchema(
@@ -641,28 +823,17 @@ ResultSet::SerializedArrowOutput ResultSet::getSerializedArrowOutput(
 //   shmctl(shmid, IPC_RMID, 0);
 ArrowResult ResultSet::getArrowCopyOnCpu(const std::vector<std::string>& col_names,
                                          const int32_t first_n) const {
-  const auto serialized_arrow_output = getSerializedArrowOutput(col_names, first_n);
-  const auto& serialized_schema = serialized_arrow_output.schema;
-  const auto& serialized_records = serialized_arrow_output.records;
-
-  const auto schema_key = arrow::get_and_copy_to_shm(serialized_schema);
-  CHECK(schema_key != IPC_PRIVATE);
-  std::vector<char> schema_handle_buffer(sizeof(key_t), 0);
-  memcpy(&schema_handle_buffer[0],
-         reinterpret_cast<const unsigned char*>(&schema_key),
-         sizeof(key_t));
-
-  const auto record_key = arrow::get_and_copy_to_shm(serialized_records);
-  std::vector<char> record_handle_buffer(sizeof(key_t), 0);
-  memcpy(&record_handle_buffer[0],
-         reinterpret_cast<const unsigned char*>(&record_key),
-         sizeof(key_t));
+  return copy_serialized_arrow_to_shm(getSerializedArrowOutput(col_names, first_n));
+}
 
-  return {schema_handle_buffer,
-          serialized_schema->size(),
-          record_handle_buffer,
-          serialized_records->size(),
-          nullptr};
+// The batches of a result can be copied while the following ones are produced, every
+// copy has its own schema and has to be deallocated as a whole.
+ArrowResult ResultSet::getArrowCopyOfEntries(const std::vector<std::string>& col_names,
+                                             const size_t first_entry,
+                                             const size_t entry_count) const {
+  CHECK_LE(first_entry, entryCount());
+  return copy_serialized_arrow_to_shm(getSerializedArrowEntries(
+      col_names, first_entry, std::min(entry_count, entryCount() - first_entry)));
 }
 
 // WARN(miyu): users are responsible to free all device copies, e.g.,
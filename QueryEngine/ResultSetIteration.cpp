@@ -32,6 +32,7 @@
 #include "SqlTypesLayout.h"
 #include "TypePunning.h"
 
+#include <unordered_map>
 #include <utility>
 
 namespace {
@@ -114,11 +115,12 @@ const int8_t* advance_col_buff_to_slot(const int8_t* buff,
 
 }  // namespace
 
-std::vector<TargetValue> ResultSet::getRowAt(
-    const size_t global_entry_idx,
-    const bool translate_strings,
-    const bool decimal_to_double,
-    const bool fixup_count_distinct_pointers) const {
+template <typename TargetCallback>
+bool ResultSet::visitRowTargets(const size_t global_entry_idx,
+                                const bool translate_strings,
+                                const bool decimal_to_double,
+                                const bool fixup_count_distinct_pointers,
+                                TargetCallback callback) const {
   const auto storage_lookup_result =
       fixup_count_distinct_pointers
           ? StorageLookupResult{storage_.get(), global_entry_idx, 0}
@@ -126,12 +128,11 @@ std::vector<TargetValue> ResultSet::getRowAt(
   const auto storage = storage_lookup_result.storage_ptr;
   const auto local_entry_idx = storage_lookup_result.fixedup_entry_idx;
   if (!fixup_count_distinct_pointers && storage->isEmptyEntry(local_entry_idx)) {
-    return {};
+    return false;
   }
 
   const auto buff = storage->buff_;
   CHECK(buff);
-  std::vector<TargetValue> row;
   size_t agg_col_idx = 0;
   int8_t* rowwise_target_ptr{nullptr};
   int8_t* keys_ptr{nullptr};
@@ -148,31 +149,33 @@ std::vector<TargetValue> ResultSet::getRowAt(
   for (size_t target_idx = 0; target_idx < storage_->targets_.size(); ++target_idx) {
     const auto& agg_info = storage_->targets_[target_idx];
     if (query_mem_desc_.didOutputColumnar()) {
-      row.push_back(getTargetValueFromBufferColwise(crt_col_ptr,
-                                                    keys_ptr,
-                                                    storage->query_mem_desc_,
-                                                    local_entry_idx,
-                                                    global_entry_idx,
-                                                    agg_info,
-                                                    target_idx,
-                                                    agg_col_idx,
-                                                    translate_strings,
-                                                    decimal_to_double));
+      callback(target_idx,
+               getTargetValueFromBufferColwise(crt_col_ptr,
+                                               keys_ptr,
+                                               storage->query_mem_desc_,
+                                               local_entry_idx,
+                                               global_entry_idx,
+                                               agg_info,
+                                               target_idx,
+                                               agg_col_idx,
+                                               translate_strings,
+                                               decimal_to_double));
       crt_col_ptr = advance_target_ptr_col_wise(crt_col_ptr,
                                                 agg_info,
                                                 agg_col_idx,
                                                 storage->query_mem_desc_,
                                                 separate_varlen_storage_valid_);
     } else {
-      row.push_back(getTargetValueFromBufferRowwise(rowwise_target_ptr,
-                                                    keys_ptr,
-                                                    global_entry_idx,
-                                                    agg_info,
-                                                    target_idx,
-                                                    agg_col_idx,
-                                                    translate_strings,
-                                                    decimal_to_double,
-                                                    fixup_count_distinct_pointers));
+      callback(target_idx,
+               getTargetValueFromBufferRowwise(rowwise_target_ptr,
+                                               keys_ptr,
+                                               global_entry_idx,
+                                               agg_info,
+                                               target_idx,
+                                               agg_col_idx,
+                                               translate_strings,
+                                               decimal_to_double,
+                                               fixup_count_distinct_pointers));
       rowwise_target_ptr = advance_target_ptr_row_wise(rowwise_target_ptr,
                                                        agg_info,
                                                        agg_col_idx,
@@ -181,7 +184,25 @@ std::vector<TargetValue> ResultSet::getRowAt(
     }
     agg_col_idx = advance_slot(agg_col_idx, agg_info, separate_varlen_storage_valid_);
   }
+  return true;
+}
 
+std::vector<TargetValue> ResultSet::getRowAt(
+    const size_t global_entry_idx,
+    const bool translate_strings,
+    const bool decimal_to_double,
+    const bool fixup_count_distinct_pointers) const {
+  std::vector<TargetValue> row;
+  const auto append_target = [&row](const size_t, TargetValue&& tv) {
+    row.push_back(std::move(tv));
+  };
+  if (!visitRowTargets(global_entry_idx,
+                       translate_strings,
+                       decimal_to_double,
+                       fixup_count_distinct_pointers,
+                       append_target)) {
+    return {};
+  }
   return row;
 }
 
@@ -291,21 +312,172 @@ std::vector<TargetValue> ResultSet::getNextRowUnlocked(
 
 std::vector<TargetValue> ResultSet::getNextRowImpl(const bool translate_strings,
                                                    const bool decimal_to_double) const {
-  auto entry_buff_idx = advanceCursorToNextEntry();
-  if (keep_first_ && fetched_so_far_ >= drop_first_ + keep_first_) {
+  size_t entry_buff_idx{0};
+  if (!fetchNextEntry(entry_buff_idx)) {
     return {};
   }
+  auto row = getRowAt(entry_buff_idx, translate_strings, decimal_to_double, false);
+  CHECK(!row.empty());
+  return row;
+}
+
+bool ResultSet::fetchNextEntry(size_t& entry_buff_idx) const {
+  entry_buff_idx = advanceCursorToNextEntry();
+  if (keep_first_ && fetched_so_far_ >= drop_first_ + keep_first_) {
+    return false;
+  }
 
   if (crt_row_buff_idx_ >= entryCount()) {
     CHECK_EQ(entryCount(), crt_row_buff_idx_);
-    return {};
+    return false;
   }
-  auto row = getRowAt(entry_buff_idx, translate_strings, decimal_to_double, false);
-  CHECK(!row.empty());
   ++crt_row_buff_idx_;
   ++fetched_so_far_;
+  return true;
+}
 
-  return row;
+namespace {
+
+void append_bulk_value(const TargetValue& tv,
+                       const SQLTypeInfo& ti,
+                       ResultSetBulkColumn& column) {
+  const auto scalar_tv = boost::get<ScalarTargetValue>(&tv);
+  CHECK(scalar_tv);
+  if (const auto ival = boost::get<int64_t>(scalar_tv)) {
+    column.int_values.push_back(*ival);
+    // the ids of the strings are read as 32 bit integers, see makeTargetValue
+    const bool is_null = ti.is_string() ? static_cast<int32_t>(*ival) == NULL_INT
+                                        : *ival == inline_int_null_val(ti);
+    column.nulls.push_back(is_null && !ti.get_notnull());
+  } else if (const auto dval = boost::get<double>(scalar_tv)) {
+    column.real_values.push_back(*dval);
+    const bool is_null =
+        ti.get_type() == kFLOAT ? *dval == NULL_FLOAT : *dval == NULL_DOUBLE;
+    column.nulls.push_back(is_null && !ti.get_notnull());
+  } else if (const auto fval = boost::get<float>(scalar_tv)) {
+    column.real_values.push_back(*fval);
+    column.nulls.push_back(*fval == NULL_FLOAT && !ti.get_notnull());
+  } else {
+    const auto s_n = boost::get<NullableString>(scalar_tv);
+    CHECK(s_n);
+    const auto s = boost::get<std::string>(s_n);
+    column.str_values.emplace_back(s ? *s : std::string());
+    column.nulls.push_back(!s && !ti.get_notnull());
+  }
+}
+
+}  // namespace
+
+bool ResultSet::canFetchColumnsBulk() const {
+  if (just_explain_) {
+    return false;
+  }
+  for (const auto& target : targets_) {
+    if (target.sql_type.is_array() || target.sql_type.is_geometry() ||
+        target.agg_kind == kAPPROX_COUNT_DISTINCT_SKETCH) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t ResultSet::getNextColumnsBulk(std::vector<ResultSetBulkColumn>& columns,
+                                     const size_t max_rows,
+                                     const bool translate_strings,
+                                     const bool decimal_to_double) const {
+  CHECK(canFetchColumnsBulk());
+  std::lock_guard<std::mutex> lock(row_iteration_mutex_);
+  columns.assign(colCount(), ResultSetBulkColumn{});
+  if (!storage_) {
+    return 0;
+  }
+  std::vector<SQLTypeInfo> col_types;
+  for (size_t i = 0; i < colCount(); ++i) {
+    col_types.push_back(getColType(i));
+  }
+  const auto append_target = [&columns, &col_types](const size_t target_idx,
+                                                    TargetValue&& tv) {
+    append_bulk_value(tv, col_types[target_idx], columns[target_idx]);
+  };
+  size_t entry_buff_idx{0};
+  while (fetched_so_far_ < drop_first_) {
+    if (!fetchNextEntry(entry_buff_idx)) {
+      return 0;
+    }
+  }
+  size_t row_count{0};
+  while (row_count < max_rows && fetchNextEntry(entry_buff_idx)) {
+    // the strings are translated once the ids of the whole column are known
+    const bool visited =
+        visitRowTargets(entry_buff_idx, false, decimal_to_double, false, append_target);
+    CHECK(visited);
+    ++row_count;
+  }
+  if (translate_strings) {
+    translateBulkStrings(columns);
+  }
+  return row_count;
+}
+
+size_t ResultSet::getColumnsBulk(std::vector<ResultSetBulkColumn>& columns,
+                                 const size_t first_entry,
+                                 const size_t end_entry) const {
+  CHECK(canFetchColumnsBulk());
+  CHECK_LE(end_entry, entryCount());
+  columns.assign(colCount(), ResultSetBulkColumn{});
+  std::vector<SQLTypeInfo> col_types;
+  for (size_t i = 0; i < colCount(); ++i) {
+    col_types.push_back(getColType(i));
+  }
+  const auto append_target = [&columns, &col_types](const size_t target_idx,
+                                                    TargetValue&& tv) {
+    append_bulk_value(tv, col_types[target_idx], columns[target_idx]);
+  };
+  size_t row_count{0};
+  for (size_t i = first_entry; i < end_entry; ++i) {
+    const auto entry_idx = permutation_.empty() ? i : permutation_[i];
+    if (visitRowTargets(entry_idx, false, false, false, append_target)) {
+      ++row_count;
+    }
+  }
+  return row_count;
+}
+
+void ResultSet::translateBulkStrings(std::vector<ResultSetBulkColumn>& columns) const {
+  for (size_t i = 0; i < columns.size(); ++i) {
+    const auto ti = getColType(i);
+    if (!ti.is_string() || ti.get_compression() != kENCODING_DICT) {
+      continue;
+    }
+    auto& column = columns[i];
+    const auto sdp = getStringDictionaryProxy(ti.get_comp_param());
+    std::unordered_map<int32_t, size_t> string_indices;
+    std::vector<std::string> strings;
+    column.str_values.reserve(column.int_values.size());
+    for (const auto ival : column.int_values) {
+      const auto string_id = static_cast<int32_t>(ival);
+      if (string_id == NULL_INT) {
+        column.str_values.emplace_back();
+        continue;
+      }
+      auto it = string_indices.find(string_id);
+      if (it == string_indices.end()) {
+        it = string_indices.emplace(string_id, strings.size()).first;
+        strings.push_back(sdp->getString(string_id));
+      }
+      column.str_values.push_back(strings[it->second]);
+    }
+    column.int_values.clear();
+  }
+}
+
+StringDictionaryProxy* ResultSet::getStringDictionaryProxy(const int dict_id) const {
+  if (!dict_id) {
+    return row_set_mem_owner_->getLiteralStringDictProxy();
+  }
+  return executor_
+             ? executor_->getStringDictionaryProxy(dict_id, row_set_mem_owner_, false)
+             : row_set_mem_owner_->getStringDictProxy(dict_id);
 }
 
 namespace {
@@ -1512,6 +1684,18 @@ TargetValue ResultSet::makeTargetValue(const int8_t* ptr,
   }
   if (chosen_type.is_integer() | chosen_type.is_boolean() || chosen_type.is_time() ||
       chosen_type.is_timeinterval()) {
+    if (target_info.agg_kind == kAPPROX_COUNT_DISTINCT_SKETCH) {
+      std::vector<ScalarTargetValue> sketch;
+      for (const auto reg : count_distinct_set_registers(
+               ival, query_mem_desc_.getCountDistinctDescriptor(target_logical_idx))) {
+        sketch.emplace_back(static_cast<int64_t>(reg));
+      }
+      return TargetValue(sketch);
+    }
+    if (target_info.agg_kind == kAPPROX_QUANTILE) {
+      return TargetValue(count_distinct_set_quantile(
+          ival, query_mem_desc_.getCountDistinctDescriptor(target_logical_idx)));
+    }
     if (is_distinct_target(target_info)) {
       return TargetValue(count_distinct_set_size(
           ival, query_mem_desc_.getCountDistinctDescriptor(target_logical_idx)));
@@ -1530,15 +1714,7 @@ TargetValue ResultSet::makeTargetValue(const int8_t* ptr,
           NULL_INT) {  // TODO(alex): this isn't nice, fix it
         return NullableString(nullptr);
       }
-      StringDictionaryProxy* sdp{nullptr};
-      if (!chosen_type.get_comp_param()) {
-        sdp = row_set_mem_owner_->getLiteralStringDictProxy();
-      } else {
-        sdp = executor_
-                  ? executor_->getStringDictionaryProxy(
-                        chosen_type.get_comp_param(), row_set_mem_owner_, false)
-                  : row_set_mem_owner_->getStringDictProxy(chosen_type.get_comp_param());
-      }
+      const auto sdp = getStringDictionaryProxy(chosen_type.get_comp_param());
       return NullableString(sdp->getString(ival));
     } else {
       return static_cast<int64_t>(static_cast<int32_t>(ival));
@@ -1658,10 +1834,8 @@ TargetValue ResultSet::getTargetValueFromBufferRowwise(
             query_mem_desc_.count_distinct_descriptors_[target_logical_idx];
         const auto bitmap_byte_sz = count_distinct_desc.bitmapSizeBytes();
 
-        auto count_distinct_buffer = static_cast<int8_t*>(checked_malloc(bitmap_byte_sz));
-        memset(count_distinct_buffer, 0, bitmap_byte_sz);
-        row_set_mem_owner_->addCountDistinctBuffer(
-            count_distinct_buffer, bitmap_byte_sz, true);
+        auto count_distinct_buffer =
+            row_set_mem_owner_->allocateCountDistinctBuffer(bitmap_byte_sz);
         *count_distinct_ptr_ptr = reinterpret_cast<int64_t>(count_distinct_buffer);
       }
     }
@@ -1676,7 +1850,10 @@ TargetValue ResultSet::getTargetValueFromBufferRowwise(
 
   // logic for deciding width of column
   int8_t compact_sz1 = 0;
-  if (target_info.is_agg) {
+  if (is_distinct_target(target_info)) {
+    // the handle of the set or of the registers
+    compact_sz1 = sizeof(int64_t);
+  } else if (target_info.is_agg) {
     compact_sz1 = std::max(
         target_info.sql_type.get_size(),
         (target_info.agg_arg_type.is_array()) ? -1 : target_info.agg_arg_type.get_size());
@@ -28,14 +28,17 @@
 #include "RuntimeFunctions.h"
 #include "SqlTypesLayout.h"
 
+#include "Shared/ThreadPool.h"
 #include "Shared/likely.h"
-#include "Shared/thread_count.h"
 
 #include <algorithm>
+#include <cmath>
 #include <future>
 #include <numeric>
+#include <type_traits>
 
 extern bool g_enable_dynamic_watchdog;
+extern bool g_enable_partitioned_reduction;
 
 namespace {
 
@@ -43,6 +46,20 @@ bool use_multithreaded_reduction(const size_t entry_count) {
   return entry_count > 100000;
 }
 
+bool use_partitioned_reduction(const size_t result_set_count,
+                               const QueryMemoryDescriptor& query_mem_desc,
+                               const size_t total_entry_count) {
+  return g_enable_partitioned_reduction && result_set_count > 1 &&
+         !query_mem_desc.didOutputColumnar() &&
+         use_multithreaded_reduction(total_entry_count);
+}
+
+// The partition of a key hash, from its high bits since the position of the key in
+// the hash table of the partition comes from the low ones.
+size_t get_key_partition(const uint32_t key_hash_val, const size_t partition_count) {
+  return (static_cast<uint64_t>(key_hash_val) * partition_count) >> 32;
+}
+
 size_t get_row_qw_count(const QueryMemoryDescriptor& query_mem_desc) {
   const auto row_bytes = get_row_bytes(query_mem_desc);
   CHECK_EQ(size_t(0), row_bytes % 8);
@@ -142,7 +159,7 @@ void ResultSetStorage::reduce(
   if (query_mem_desc_.getQueryDescriptionType() ==
       QueryDescriptionType::GroupByBaselineHash) {
     if (use_multithreaded_reduction(that.query_mem_desc_.getEntryCount())) {
-      const size_t thread_count = cpu_threads();
+      const size_t thread_count = threadpool::ThreadPool::instance().workerCount();
       std::vector<std::future<void>> reduction_threads;
       for (size_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
         const auto thread_entry_count =
@@ -150,11 +167,11 @@ void ResultSetStorage::reduce(
         const auto start_index = thread_idx * thread_entry_count;
         const auto end_index = std::min(start_index + thread_entry_count,
                                         that.query_mem_desc_.getEntryCount());
-        reduction_threads.emplace_back(std::async(
-            std::launch::async,
+        reduction_threads.emplace_back(threadpool::ThreadPool::instance().submit(
             [this, this_buff, that_buff, start_index, end_index, &that] {
               for (size_t entry_idx = start_index; entry_idx < end_index; ++entry_idx) {
                 reduceOneEntryBaseline(this_buff,
+                                       query_mem_desc_.getEntryCount(),
                                        that_buff,
                                        entry_idx,
                                        that.query_mem_desc_.getEntryCount(),
@@ -162,47 +179,44 @@ void ResultSetStorage::reduce(
               }
             }));
       }
-      for (auto& reduction_thread : reduction_threads) {
-        reduction_thread.wait();
-      }
-      for (auto& reduction_thread : reduction_threads) {
-        reduction_thread.get();
-      }
+      threadpool::wait_all(reduction_threads);
     } else {
       for (size_t i = 0; i < that.query_mem_desc_.getEntryCount(); ++i) {
-        reduceOneEntryBaseline(
-            this_buff, that_buff, i, that.query_mem_desc_.getEntryCount(), that);
+        reduceOneEntryBaseline(this_buff,
+                               query_mem_desc_.getEntryCount(),
+                               that_buff,
+                               i,
+                               that.query_mem_desc_.getEntryCount(),
+                               that);
       }
     }
     return;
   }
   if (use_multithreaded_reduction(entry_count)) {
-    const size_t thread_count = cpu_threads();
+    const size_t thread_count = threadpool::ThreadPool::instance().workerCount();
     std::vector<std::future<void>> reduction_threads;
     for (size_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
       const auto thread_entry_count = (entry_count + thread_count - 1) / thread_count;
       const auto start_index = thread_idx * thread_entry_count;
       const auto end_index = std::min(start_index + thread_entry_count, entry_count);
       if (query_mem_desc_.didOutputColumnar()) {
-        reduction_threads.emplace_back(std::async(std::launch::async,
-                                                  [this,
-                                                   this_buff,
-                                                   that_buff,
-                                                   start_index,
-                                                   end_index,
-                                                   &that,
-                                                   &serialized_varlen_buffer] {
-                                                    reduceEntriesNoCollisionsColWise(
-                                                        this_buff,
-                                                        that_buff,
-                                                        that,
-                                                        start_index,
-                                                        end_index,
-                                                        serialized_varlen_buffer);
-                                                  }));
+        reduction_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+            [this,
+             this_buff,
+             that_buff,
+             start_index,
+             end_index,
+             &that,
+             &serialized_varlen_buffer] {
+              reduceEntriesNoCollisionsColWise(this_buff,
+                                               that_buff,
+                                               that,
+                                               start_index,
+                                               end_index,
+                                               serialized_varlen_buffer);
+            }));
       } else {
-        reduction_threads.emplace_back(std::async(
-            std::launch::async,
+        reduction_threads.emplace_back(threadpool::ThreadPool::instance().submit(
             [this,
              this_buff,
              that_buff,
@@ -217,12 +231,7 @@ void ResultSetStorage::reduce(
             }));
       }
     }
-    for (auto& reduction_thread : reduction_threads) {
-      reduction_thread.wait();
-    }
-    for (auto& reduction_thread : reduction_threads) {
-      reduction_thread.get();
-    }
+    threadpool::wait_all(reduction_threads);
   } else {
     if (query_mem_desc_.didOutputColumnar()) {
       reduceEntriesNoCollisionsColWise(this_buff,
@@ -252,8 +261,176 @@ ALWAYS_INLINE void check_watchdog(const size_t sample_seed) {
   }
 }
 
+// Reductions of two integer slots, which also tell whether the result has overflown.
+template <typename T>
+struct ColumnarSumReducer {
+  T operator()(const T lhs, const T rhs, bool& overflow) const {
+    using UT = typename std::make_unsigned<T>::type;
+    const auto sum = static_cast<T>(static_cast<UT>(lhs) + static_cast<UT>(rhs));
+    overflow = check_overflow && ((lhs ^ sum) & (rhs ^ sum)) < 0;
+    return sum;
+  }
+  const bool check_overflow;
+};
+
+template <typename T>
+struct ColumnarCountReducer {
+  T operator()(const T lhs, const T rhs, bool& overflow) const {
+    using UT = typename std::make_unsigned<T>::type;
+    const auto sum = static_cast<UT>(lhs) + static_cast<UT>(rhs);
+    overflow = sum < static_cast<UT>(lhs);
+    return static_cast<T>(sum);
+  }
+};
+
+template <typename T>
+struct ColumnarMinReducer {
+  T operator()(const T lhs, const T rhs, bool& overflow) const {
+    overflow = false;
+    return std::min(lhs, rhs);
+  }
+};
+
+template <typename T>
+struct ColumnarMaxReducer {
+  T operator()(const T lhs, const T rhs, bool& overflow) const {
+    overflow = false;
+    return std::max(lhs, rhs);
+  }
+};
+
+// Reduces the entries [start_index, end_index) of an integer aggregate column of a
+// perfect hash layout with keys. The loop has neither branches nor calls, so that the
+// compiler can vectorize it; the entries which must keep their value select it instead.
+template <typename T, typename REDUCER>
+void reduce_columnar_int_slots(T* this_col,
+                               const T* that_col,
+                               const int64_t* that_key_col,
+                               const size_t start_index,
+                               const size_t end_index,
+                               const bool skip_null_val,
+                               const T null_val,
+                               const REDUCER reducer) {
+  bool overflow{false};
+  for (size_t entry_idx = start_index; entry_idx < end_index; ++entry_idx) {
+    const auto lhs = this_col[entry_idx];
+    const auto rhs = that_col[entry_idx];
+    const bool keep_lhs =
+        that_key_col[entry_idx] == EMPTY_KEY_64 || (skip_null_val && rhs == null_val);
+    const bool take_rhs = skip_null_val && lhs == null_val;
+    bool entry_overflow{false};
+    const auto reduced = reducer(lhs, rhs, entry_overflow);
+    overflow |= entry_overflow & !keep_lhs & !take_rhs;
+    this_col[entry_idx] = keep_lhs ? lhs : (take_rhs ? rhs : reduced);
+  }
+#ifdef ENABLE_COMPACTION
+  if (overflow) {
+    throw OverflowOrUnderflow();
+  }
+#endif
+}
+
+template <typename T>
+bool reduce_columnar_int_slots(int8_t* this_col_ptr,
+                               const int8_t* that_col_ptr,
+                               const int8_t* that_buff,
+                               const size_t start_index,
+                               const size_t end_index,
+                               const TargetInfo& agg_info,
+                               const int64_t init_val) {
+  const auto this_col = reinterpret_cast<T*>(this_col_ptr);
+  const auto that_col = reinterpret_cast<const T*>(that_col_ptr);
+  const auto that_key_col = reinterpret_cast<const int64_t*>(that_buff);
+  const auto null_val = static_cast<T>(init_val);
+  switch (agg_info.agg_kind) {
+    case kCOUNT:
+      reduce_columnar_int_slots(this_col,
+                                that_col,
+                                that_key_col,
+                                start_index,
+                                end_index,
+                                false,
+                                T(0),
+                                ColumnarCountReducer<T>());
+      return true;
+    case kSUM:
+      reduce_columnar_int_slots(
+          this_col,
+          that_col,
+          that_key_col,
+          start_index,
+          end_index,
+          agg_info.skip_null_val,
+          null_val,
+          ColumnarSumReducer<T>{get_compact_type(agg_info).is_integer()});
+      return true;
+    case kMIN:
+      reduce_columnar_int_slots(this_col,
+                                that_col,
+                                that_key_col,
+                                start_index,
+                                end_index,
+                                agg_info.skip_null_val,
+                                null_val,
+                                ColumnarMinReducer<T>());
+      return true;
+    case kMAX:
+      reduce_columnar_int_slots(this_col,
+                                that_col,
+                                that_key_col,
+                                start_index,
+                                end_index,
+                                agg_info.skip_null_val,
+                                null_val,
+                                ColumnarMaxReducer<T>());
+      return true;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
+// Reduces a whole column of COUNT, SUM, MIN or MAX integer aggregates at once, if the
+// target is one of them and the layout has keys. Returns false if the target must be
+// reduced one entry at a time.
+bool ResultSetStorage::reduceColumnNoCollisionsColWise(
+    int8_t* this_col_ptr,
+    const int8_t* that_col_ptr,
+    const int8_t* that_buff,
+    const size_t start_index,
+    const size_t end_index,
+    const TargetInfo& agg_info,
+    const size_t agg_col_idx) const {
+  if (query_mem_desc_.hasKeylessHash() || query_mem_desc_.targetGroupbyIndicesSize() ||
+      !agg_info.is_agg || is_distinct_target(agg_info) ||
+      takes_float_argument(agg_info) || get_compact_type(agg_info).is_fp()) {
+    return false;
+  }
+  CHECK_LT(agg_col_idx, target_init_vals_.size());
+  const auto init_val = target_init_vals_[agg_col_idx];
+  switch (query_mem_desc_.getColumnWidth(agg_col_idx).compact) {
+    case 4:
+      return reduce_columnar_int_slots<int32_t>(this_col_ptr,
+                                                that_col_ptr,
+                                                that_buff,
+                                                start_index,
+                                                end_index,
+                                                agg_info,
+                                                init_val);
+    case 8:
+      return reduce_columnar_int_slots<int64_t>(this_col_ptr,
+                                                that_col_ptr,
+                                                that_buff,
+                                                start_index,
+                                                end_index,
+                                                agg_info,
+                                                init_val);
+    default:
+      return false;
+  }
+}
+
 void ResultSetStorage::reduceEntriesNoCollisionsColWise(
     int8_t* this_buff,
     const int8_t* that_buff,
@@ -265,6 +442,16 @@ void ResultSetStorage::reduceEntriesNoCollisionsColWise(
   // functions
   CHECK(serialized_varlen_buffer.empty());
 
+  if (!query_mem_desc_.hasKeylessHash()) {
+    // copy the keys from right hand side
+    for (size_t entry_idx = start_index; entry_idx < end_index; ++entry_idx) {
+      check_watchdog(entry_idx);
+      if (reinterpret_cast<const int64_t*>(that_buff)[entry_idx] != EMPTY_KEY_64) {
+        copyKeyColWise(entry_idx, this_buff, that_buff);
+      }
+    }
+  }
+
   auto this_crt_col_ptr = get_cols_ptr(this_buff, query_mem_desc_);
   auto that_crt_col_ptr = get_cols_ptr(that_buff, query_mem_desc_);
   size_t agg_col_idx = 0;
@@ -276,6 +463,21 @@ void ResultSetStorage::reduceEntriesNoCollisionsColWise(
         this_crt_col_ptr, query_mem_desc_, agg_col_idx);
     const auto that_next_col_ptr = advance_to_next_columnar_target_buff(
         that_crt_col_ptr, query_mem_desc_, agg_col_idx);
+    if (agg_info.agg_kind != kAVG) {
+      check_watchdog(0);
+      if (reduceColumnNoCollisionsColWise(this_crt_col_ptr,
+                                          that_crt_col_ptr,
+                                          that_buff,
+                                          start_index,
+                                          end_index,
+                                          agg_info,
+                                          agg_col_idx)) {
+        this_crt_col_ptr = this_next_col_ptr;
+        that_crt_col_ptr = that_next_col_ptr;
+        agg_col_idx = advance_slot(agg_col_idx, agg_info, false);
+        continue;
+      }
+    }
     for (size_t entry_idx = start_index; entry_idx < end_index; ++entry_idx) {
       check_watchdog(entry_idx);
       if (__builtin_expect(query_mem_desc_.hasKeylessHash(), 0)) {
@@ -288,8 +490,6 @@ void ResultSetStorage::reduceEntriesNoCollisionsColWise(
         if (reinterpret_cast<const int64_t*>(that_buff)[entry_idx] == EMPTY_KEY_64) {
           continue;
         }
-        // copy the key from right hand side
-        copyKeyColWise(entry_idx, this_buff, that_buff);
       }
       auto this_ptr1 = this_crt_col_ptr +
                        entry_idx * query_mem_desc_.getColumnWidth(agg_col_idx).compact;
@@ -369,7 +569,8 @@ void ResultSetStorage::rewriteAggregateBufferOffsets(
     for (size_t target_logical_idx = 0; target_logical_idx < targets_.size();
          ++target_logical_idx) {
       const auto& target_info = targets_[target_logical_idx];
-      if (target_info.sql_type.is_varlen() && target_info.is_agg) {
+      if (target_info.sql_type.is_varlen() && target_info.is_agg &&
+          target_info.agg_kind != kAPPROX_COUNT_DISTINCT_SKETCH) {
         CHECK(target_info.agg_kind == kSAMPLE);
         auto ptr1 = rowwise_targets_ptr;
         auto slot_idx = target_slot_idx;
@@ -676,6 +877,7 @@ GroupValueInfo get_group_value_reduction(int64_t* groups_buffer,
 // Reduces entry at position that_entry_idx in that_buff into this_buff. This is
 // the baseline layout, so the position in this_buff isn't known to be that_entry_idx.
 void ResultSetStorage::reduceOneEntryBaseline(int8_t* this_buff,
+                                              const size_t this_entry_count,
                                               const int8_t* that_buff,
                                               const size_t that_entry_idx,
                                               const size_t that_entry_count,
@@ -704,7 +906,7 @@ void ResultSetStorage::reduceOneEntryBaseline(int8_t* this_buff,
     const uint32_t row_size_quad = get_row_qw_count(query_mem_desc_);
     std::tie(this_entry_slots, empty_entry) =
         get_group_value_reduction(this_buff_i64,
-                                  query_mem_desc_.getEntryCount(),
+                                  this_entry_count,
                                   &that_buff_i64[key_off],
                                   key_count,
                                   query_mem_desc_.getEffectiveKeyWidth(),
@@ -888,6 +1090,11 @@ ResultSet* ResultSetManager::reduce(std::vector<ResultSet*>& result_sets) {
                           return init + rs->query_mem_desc_.getEntryCount();
                         });
     CHECK(total_entry_count);
+    if (use_partitioned_reduction(
+            result_sets.size(), first_result.query_mem_desc_, total_entry_count) &&
+        result_rs->serialized_varlen_buffer_.empty()) {
+      return reducePartitioned(result_sets, total_entry_count);
+    }
     auto query_mem_desc = first_result.query_mem_desc_;
     query_mem_desc.setEntryCount(total_entry_count);
     rs_.reset(new ResultSet(first_result.targets_,
@@ -937,6 +1144,110 @@ ResultSet* ResultSetManager::reduce(std::vector<ResultSet*>& result_sets) {
   return result_rs;
 }
 
+// Reduces the baseline result sets in two phases instead of one after the other. First
+// every thread lists the entries of one of the result sets by partition of their key.
+// The buffer of the result then has one hash table per partition, sized for the entries
+// of the partition, and a single thread reduces all the entries of a partition into it.
+ResultSet* ResultSetManager::reducePartitioned(std::vector<ResultSet*>& result_sets,
+                                               const size_t total_entry_count) {
+  const auto& first_result = *result_sets.front()->storage_;
+  const auto& first_query_mem_desc = first_result.query_mem_desc_;
+  const auto key_count = first_query_mem_desc.getGroupbyColCount();
+  const auto key_width = first_query_mem_desc.getEffectiveKeyWidth();
+  const auto row_qw_count = get_row_qw_count(first_query_mem_desc);
+  const size_t partition_count = threadpool::ThreadPool::instance().workerCount();
+  CHECK_GT(partition_count, size_t(0));
+  // The indices of the non-empty entries, by result set then by partition.
+  std::vector<std::vector<std::vector<size_t>>> partition_entries(
+      result_sets.size(), std::vector<std::vector<size_t>>(partition_count));
+  std::vector<std::future<void>> partitioning_threads;
+  for (size_t rs_idx = 0; rs_idx < result_sets.size(); ++rs_idx) {
+    partitioning_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+        [&result_sets, &partition_entries, rs_idx, key_count, key_width, row_qw_count,
+         partition_count] {
+          const auto& storage = *result_sets[rs_idx]->storage_;
+          const auto buff_i64 = reinterpret_cast<const int64_t*>(storage.buff_);
+          auto& entries = partition_entries[rs_idx];
+          for (size_t entry_idx = 0; entry_idx < storage.query_mem_desc_.getEntryCount();
+               ++entry_idx) {
+            check_watchdog(entry_idx);
+            if (storage.isEmptyEntry(entry_idx, storage.buff_)) {
+              continue;
+            }
+            const auto h =
+                key_hash(&buff_i64[row_qw_count * entry_idx], key_count, key_width);
+            entries[get_key_partition(h, partition_count)].push_back(entry_idx);
+          }
+        }));
+  }
+  threadpool::wait_all(partitioning_threads);
+
+  std::vector<size_t> partition_entry_count(partition_count, 0);
+  size_t non_empty_entry_count{0};
+  for (size_t partition = 0; partition < partition_count; ++partition) {
+    for (const auto& entries : partition_entries) {
+      partition_entry_count[partition] += entries[partition].size();
+    }
+    non_empty_entry_count += partition_entry_count[partition];
+  }
+  // Spread the entries of the result to the partitions like their input entries, every
+  // partition gets enough to hold all of its groups even if no two of them match.
+  std::vector<size_t> partition_start(partition_count, 0);
+  size_t result_entry_count{0};
+  for (size_t partition = 0; partition < partition_count; ++partition) {
+    partition_start[partition] = result_entry_count;
+    if (partition_entry_count[partition]) {
+      partition_entry_count[partition] = std::max(
+          partition_entry_count[partition],
+          static_cast<size_t>(std::ceil(static_cast<double>(total_entry_count) *
+                                        partition_entry_count[partition] /
+                                        non_empty_entry_count)));
+    }
+    result_entry_count += partition_entry_count[partition];
+  }
+  auto query_mem_desc = first_query_mem_desc;
+  query_mem_desc.setEntryCount(std::max(result_entry_count, size_t(1)));
+  rs_.reset(new ResultSet(first_result.targets_,
+                          ExecutorDeviceType::CPU,
+                          query_mem_desc,
+                          result_sets.front()->row_set_mem_owner_,
+                          result_sets.front()->executor_));
+  auto result_storage = rs_->allocateStorage(first_result.target_init_vals_);
+  rs_->initializeStorage();
+
+  std::vector<std::future<void>> reduction_threads;
+  for (size_t partition = 0; partition < partition_count; ++partition) {
+    if (!partition_entry_count[partition]) {
+      continue;
+    }
+    reduction_threads.emplace_back(threadpool::ThreadPool::instance().submit(
+        [&result_sets,
+         &partition_entries,
+         &partition_entry_count,
+         &partition_start,
+         result_storage,
+         partition,
+         row_qw_count] {
+          const auto this_buff =
+              result_storage->getUnderlyingBuffer() +
+              partition_start[partition] * row_qw_count * sizeof(int64_t);
+          for (size_t rs_idx = 0; rs_idx < result_sets.size(); ++rs_idx) {
+            const auto& that = *result_sets[rs_idx]->storage_;
+            for (const auto entry_idx : partition_entries[rs_idx][partition]) {
+              result_storage->reduceOneEntryBaseline(this_buff,
+                                                     partition_entry_count[partition],
+                                                     that.buff_,
+                                                     entry_idx,
+                                                     that.query_mem_desc_.getEntryCount(),
+                                                     that);
+            }
+          }
+        }));
+  }
+  threadpool::wait_all(reduction_threads);
+  return rs_.get();
+}
+
 std::shared_ptr<ResultSet> ResultSetManager::getOwnResultSet() {
   return rs_;
 }
@@ -1242,7 +1553,10 @@ void ResultSetStorage::reduceOneSlot(
   if (target_info.is_agg && target_info.agg_kind != kSAMPLE) {
     switch (target_info.agg_kind) {
       case kCOUNT:
-      case kAPPROX_COUNT_DISTINCT: {
+      case kAPPROX_COUNT_DISTINCT:
+      case kAPPROX_COUNT_DISTINCT_SKETCH:
+      case kAPPROX_COUNT_DISTINCT_UNION:
+      case kAPPROX_QUANTILE: {
         if (is_distinct_target(target_info)) {
           CHECK_EQ(static_cast<size_t>(chosen_bytes), sizeof(int64_t));
           reduceOneCountDistinctSlot(this_ptr1, that_ptr1, target_logical_idx, that);
@@ -1402,7 +1716,7 @@ bool ResultRows::reduceSingleRow(const int8_t* row_ptr,
       if (is_distinct_target(agg_info)) {
         CHECK_EQ(int8_t(1), warp_count);
         CHECK(agg_info.is_agg && (agg_info.agg_kind == kCOUNT ||
-                                  agg_info.agg_kind == kAPPROX_COUNT_DISTINCT));
+                                  is_approx_count_distinct(agg_info.agg_kind)));
         partial_bin_val = count_distinct_set_size(
             partial_bin_val, query_mem_desc.getCountDistinctDescriptor(target_idx));
         if (replace_bitmap_ptr_with_bitmap_sz) {
@@ -1442,6 +1756,8 @@ bool ResultRows::reduceSingleRow(const int8_t* row_ptr,
           switch (agg_info.agg_kind) {
             case kCOUNT:
             case kAPPROX_COUNT_DISTINCT:
+            case kAPPROX_COUNT_DISTINCT_SKETCH:
+            case kAPPROX_COUNT_DISTINCT_UNION:
               AGGREGATE_ONE_NULLABLE_COUNT(
                   reinterpret_cast<int8_t*>(&agg_vals[agg_col_idx]),
                   reinterpret_cast<int8_t*>(&partial_agg_vals[agg_col_idx]),
@@ -27,6 +27,7 @@
 #include "ResultSet.h"
 #include "ResultSetSortImpl.h"
 
+#include "../DataMgr/BufferMgr/BufferMgr.h"
 #include "../Shared/thread_count.h"
 
 #include <thrust/copy.h>
@@ -49,8 +50,75 @@ void set_cuda_context(Data_Namespace::DataMgr* data_mgr, const int device_id) {
   g_cuda_mgr->setContext(device_id);
 }
 
+// Merges the consecutive sorted runs of the given size of the keys, the permutation is
+// permuted along. A key of an earlier run goes first on ties to keep the sort stable.
+void merge_sorted_runs(std::vector<uint64_t>& keys,
+                       std::vector<uint32_t>& permutation,
+                       const size_t run_size) {
+  const auto entry_count = keys.size();
+  std::vector<uint64_t> keys_tmp(entry_count);
+  std::vector<uint32_t> permutation_tmp(entry_count);
+  for (size_t width = run_size; width < entry_count; width *= 2) {
+    for (size_t start = 0; start < entry_count; start += 2 * width) {
+      const auto mid = std::min(start + width, entry_count);
+      const auto end = std::min(start + 2 * width, entry_count);
+      size_t i = start;
+      size_t j = mid;
+      size_t k = start;
+      while (i < mid && j < end) {
+        const auto from = keys[j] < keys[i] ? j++ : i++;
+        keys_tmp[k] = keys[from];
+        permutation_tmp[k++] = permutation[from];
+      }
+      for (; i < mid; ++i, ++k) {
+        keys_tmp[k] = keys[i];
+        permutation_tmp[k] = permutation[i];
+      }
+      for (; j < end; ++j, ++k) {
+        keys_tmp[k] = keys[j];
+        permutation_tmp[k] = permutation[j];
+      }
+    }
+    keys.swap(keys_tmp);
+    permutation.swap(permutation_tmp);
+  }
+}
+
 }  // namespace
 
+// Stable sort of the permutation on the keys on the first GPU. If they don't fit in its
+// memory, contiguous chunks half as large are sorted on the device and merged on the
+// host. The chunks already sorted by a failed attempt don't need to be undone, sorting
+// them again is stable. Returns false if even the smallest chunks don't fit.
+bool ResultSet::stableSortKeysOnGpu(std::vector<uint64_t>& keys,
+                                    std::vector<uint32_t>& permutation) const {
+  CHECK_EQ(keys.size(), permutation.size());
+  auto data_mgr = getDataManager();
+  CHECK(data_mgr);
+  const int device_id{0};
+  set_cuda_context(data_mgr, device_id);
+  const size_t min_chunk_size{1 << 20};
+  const auto entry_count = keys.size();
+  for (size_t chunk_size = entry_count;; chunk_size = (chunk_size + 1) / 2) {
+    try {
+      for (size_t start = 0; start < entry_count; start += chunk_size) {
+        stable_sort_keys_on_device(data_mgr,
+                                   device_id,
+                                   &keys[start],
+                                   &permutation[start],
+                                   std::min(chunk_size, entry_count - start));
+      }
+      merge_sorted_runs(keys, permutation, chunk_size);
+      return true;
+    } catch (const OutOfMemory&) {
+    } catch (const std::bad_alloc&) {
+    }
+    if (chunk_size <= min_chunk_size) {
+      return false;
+    }
+  }
+}
+
 void ResultSet::doBaselineSort(const ExecutorDeviceType device_type,
                                const std::list<Analyzer::OrderEntry>& order_entries,
                                const size_t top_n) {
@@ -157,8 +225,9 @@ void ResultSet::doBaselineSort(const ExecutorDeviceType device_type,
 bool ResultSet::canUseFastBaselineSort(
     const std::list<Analyzer::OrderEntry>& order_entries,
     const size_t top_n) {
-  if (order_entries.size() != 1 || query_mem_desc_.hasKeylessHash() ||
-      query_mem_desc_.sortOnGpu() || query_mem_desc_.didOutputColumnar()) {
+  if (order_entries.size() != 1 || !appended_storage_.empty() ||
+      query_mem_desc_.hasKeylessHash() || query_mem_desc_.sortOnGpu() ||
+      query_mem_desc_.didOutputColumnar()) {
     return false;
   }
   const auto& order_entry = order_entries.front();
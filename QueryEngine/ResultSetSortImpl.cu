@@ -430,3 +430,43 @@ template std::vector<uint32_t> baseline_sort<int64_t>(
     const size_t top_n,
     const size_t start,
     const size_t step);
+
+void stable_sort_keys_on_device(Data_Namespace::DataMgr* data_mgr,
+                                const int device_id,
+                                uint64_t* keys,
+                                uint32_t* permutation,
+                                const size_t entry_count) {
+  if (entry_count == 0) {
+    return;
+  }
+  ThrustAllocator thrust_allocator(data_mgr, device_id);
+  const auto dev_keys = get_device_ptr<uint64_t>(entry_count, thrust_allocator);
+  const auto dev_permutation = get_device_ptr<uint32_t>(entry_count, thrust_allocator);
+  const auto keys_bytes = entry_count * sizeof(uint64_t);
+  const auto permutation_bytes = entry_count * sizeof(uint32_t);
+  copy_to_gpu(data_mgr,
+              reinterpret_cast<CUdeviceptr>(dev_keys.get()),
+              keys,
+              keys_bytes,
+              device_id);
+  copy_to_gpu(data_mgr,
+              reinterpret_cast<CUdeviceptr>(dev_permutation.get()),
+              permutation,
+              permutation_bytes,
+              device_id);
+  // Picks the radix sort of thrust for the unsigned keys.
+  thrust::stable_sort_by_key(thrust::device(thrust_allocator),
+                             dev_keys,
+                             dev_keys + entry_count,
+                             dev_permutation);
+  copy_from_gpu(data_mgr,
+                keys,
+                reinterpret_cast<CUdeviceptr>(dev_keys.get()),
+                keys_bytes,
+                device_id);
+  copy_from_gpu(data_mgr,
+                permutation,
+                reinterpret_cast<CUdeviceptr>(dev_permutation.get()),
+                permutation_bytes,
+                device_id);
+}
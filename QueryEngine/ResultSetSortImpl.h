@@ -52,4 +52,12 @@ std::vector<uint32_t> baseline_sort(const ExecutorDeviceType device_type,
                                     const size_t start,
                                     const size_t step);
 
+// Stable sort of the permutation on the keys on the given device, both are permuted in
+// place. Throws OutOfMemory if they don't fit in the memory of the device.
+void stable_sort_keys_on_device(Data_Namespace::DataMgr* data_mgr,
+                                const int device_id,
+                                uint64_t* keys,
+                                uint32_t* permutation,
+                                const size_t entry_count);
+
 #endif  // QUERYENGINE_RESULTSETSORTIMPL_H
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    RoaringBitmap.h
+ * @brief   Compressed set of 64-bit values used by exact count distinct when the range
+ * of the argument is unknown or too wide for a dense bitmap.
+ *
+ * The values are partitioned on their high 48 bits. Each partition holds the low 16
+ * bits either in a sorted array, while it has at most kMaxArraySize values, or in a
+ * dense 8 KB bitmap past that. Clustered values therefore cost a bit each and sparse
+ * ones two bytes, instead of the node per value of a std::set, and the union merges
+ * whole partitions.
+ */
+
+#ifndef QUERYENGINE_ROARINGBITMAP_H
+#define QUERYENGINE_ROARINGBITMAP_H
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+class RoaringBitmap {
+ public:
+  RoaringBitmap() {}
+
+  RoaringBitmap(const RoaringBitmap& that) : containers_(that.containers_) {}
+
+  void insert(const int64_t val) {
+    const auto key = static_cast<uint64_t>(val) >> 16;
+    if (!last_container_ || key != last_key_) {
+      last_container_ = &containers_[key];
+      last_key_ = key;
+    }
+    last_container_->insert(static_cast<uint16_t>(val));
+  }
+
+  size_t size() const {
+    size_t set_size{0};
+    for (const auto& key_container : containers_) {
+      set_size += key_container.second.cardinality;
+    }
+    return set_size;
+  }
+
+  // Adds the values of the other set to this one, a partition at a time.
+  void unite(const RoaringBitmap& that) {
+    for (const auto& key_container : that.containers_) {
+      containers_[key_container.first].unite(key_container.second);
+    }
+    last_container_ = nullptr;
+  }
+
+  RoaringBitmap& operator=(const RoaringBitmap& that) {
+    containers_ = that.containers_;
+    last_container_ = nullptr;
+    return *this;
+  }
+
+ private:
+  static constexpr size_t kMaxArraySize{4096};
+  static constexpr size_t kBitmapWords{(size_t(1) << 16) / 64};
+
+  struct Container {
+    // Sorted low bits while the container is sparse, empty once it is a bitmap.
+    std::vector<uint16_t> values;
+    std::vector<uint64_t> bits;
+    size_t cardinality{0};
+
+    void insert(const uint16_t low) {
+      if (!bits.empty()) {
+        auto& word = bits[low >> 6];
+        const auto mask = uint64_t(1) << (low & 63);
+        if (!(word & mask)) {
+          word |= mask;
+          ++cardinality;
+        }
+        return;
+      }
+      const auto it = std::lower_bound(values.begin(), values.end(), low);
+      if (it != values.end() && *it == low) {
+        return;
+      }
+      values.insert(it, low);
+      ++cardinality;
+      if (values.size() > kMaxArraySize) {
+        toBitmap();
+      }
+    }
+
+    void unite(const Container& that) {
+      if (bits.empty() && that.bits.empty()) {
+        std::vector<uint16_t> merged;
+        merged.reserve(values.size() + that.values.size());
+        std::set_union(values.begin(),
+                       values.end(),
+                       that.values.begin(),
+                       that.values.end(),
+                       std::back_inserter(merged));
+        values.swap(merged);
+        cardinality = values.size();
+        if (values.size() > kMaxArraySize) {
+          toBitmap();
+        }
+        return;
+      }
+      toBitmap();
+      if (that.bits.empty()) {
+        for (const auto low : that.values) {
+          bits[low >> 6] |= uint64_t(1) << (low & 63);
+        }
+      } else {
+        for (size_t i = 0; i < kBitmapWords; ++i) {
+          bits[i] |= that.bits[i];
+        }
+      }
+      cardinality = 0;
+      for (const auto word : bits) {
+        cardinality += std::bitset<64>(word).count();
+      }
+    }
+
+    void toBitmap() {
+      if (!bits.empty()) {
+        return;
+      }
+      bits.resize(kBitmapWords, 0);
+      for (const auto low : values) {
+        bits[low >> 6] |= uint64_t(1) << (low & 63);
+      }
+      std::vector<uint16_t>().swap(values);
+    }
+  };
+
+  std::unordered_map<uint64_t, Container> containers_;
+  // Consecutive values mostly fall in the same partition, spare the lookup for them.
+  Container* last_container_{nullptr};
+  uint64_t last_key_{0};
+};
+
+#endif  // QUERYENGINE_ROARINGBITMAP_H
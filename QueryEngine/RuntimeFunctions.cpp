@@ -23,6 +23,7 @@
 #include "BufferCompaction.h"
 #include "HyperLogLogRank.h"
 #include "MurmurHash.h"
+#include "QuantileSketch.h"
 #include "TypePunning.h"
 
 #include <algorithm>
@@ -297,6 +298,50 @@ extern "C" GPU_RT_STUB void agg_approximate_count_distinct_gpu(int64_t*,
                                                                const int64_t,
                                                                const int64_t) {}
 
+// Merges a sketch, the registers stored by APPROX_COUNT_DISTINCT_SKETCH, into the
+// registers of the group. Arrays which aren't sketches are skipped.
+extern "C" NEVER_INLINE void agg_approximate_count_distinct_merge(
+    int64_t* agg,
+    const int8_t* sketch,
+    const uint32_t sketch_sz,
+    const uint32_t b) {
+  const auto q = hll_sketch_precision(sketch_sz);
+  if (!q) {
+    return;
+  }
+  uint8_t* M = reinterpret_cast<uint8_t*>(*agg);
+  for (uint32_t i = 0; i < sketch_sz; ++i) {
+    uint32_t index = i;
+    int32_t rank = sketch[i];
+    hll_fold_register(index, rank, q, b);
+    M[index] = std::max(M[index], static_cast<uint8_t>(rank));
+  }
+}
+
+extern "C" GPU_RT_STUB void agg_approximate_count_distinct_merge_gpu(int64_t*,
+                                                                     const int8_t*,
+                                                                     const uint32_t,
+                                                                     const uint32_t,
+                                                                     const int64_t,
+                                                                     const int64_t) {}
+
+// Counts the value in its bucket of the quantile sketch of the group.
+extern "C" NEVER_INLINE void agg_approx_quantile(int64_t* agg,
+                                                 const double val,
+                                                 const double null_val) {
+  if (val == null_val) {
+    return;
+  }
+  auto counts = reinterpret_cast<int64_t*>(*agg);
+  ++counts[quantile_sketch_bucket(val)];
+}
+
+extern "C" GPU_RT_STUB void agg_approx_quantile_gpu(int64_t*,
+                                                    const double,
+                                                    const double,
+                                                    const int64_t,
+                                                    const int64_t) {}
+
 extern "C" ALWAYS_INLINE int8_t bit_is_set(const int64_t bitset,
                                            const int64_t val,
                                            const int64_t min_val,
@@ -316,6 +361,39 @@ extern "C" ALWAYS_INLINE int8_t bit_is_set(const int64_t bitset,
              : 0;
 }
 
+// Probes the hash set built by InValuesHashSet, the empty slots hold the null value.
+extern "C" ALWAYS_INLINE int8_t hash_set_contains(const int64_t hash_set,
+                                                  const int64_t val,
+                                                  const int64_t capacity,
+                                                  const int64_t null_val,
+                                                  const int8_t null_bool_val) {
+  if (val == null_val) {
+    return null_bool_val;
+  }
+  const auto slots = reinterpret_cast<const int64_t*>(hash_set);
+  for (auto slot = in_values_hash_set_slot(val, capacity);;
+       slot = (slot + 1) & (capacity - 1)) {
+    if (slots[slot] == val) {
+      return 1;
+    }
+    if (slots[slot] == null_val) {
+      return 0;
+    }
+  }
+}
+
+// The keys out of the range of the table, the null one included, take the ELSE result.
+extern "C" ALWAYS_INLINE int64_t case_lookup(const int64_t table,
+                                            const int64_t key,
+                                            const int64_t min_key,
+                                            const int64_t max_key,
+                                            const int64_t else_val) {
+  if (key < min_key || key > max_key) {
+    return else_val;
+  }
+  return reinterpret_cast<const int64_t*>(table)[key - min_key];
+}
+
 extern "C" ALWAYS_INLINE int64_t agg_sum(int64_t* agg, const int64_t val) {
   const auto old = *agg;
   *agg += val;
@@ -773,6 +851,16 @@ agg_from_smem_to_gmem_binId_count(int64_t* dest, int64_t* src, const int32_t sz)
   return agg_from_smem_to_gmem_nop(dest, src, sz);
 }
 
+extern "C" __attribute__((noinline)) void agg_from_smem_to_gmem_slots(
+    int64_t* dest,
+    int64_t* src,
+    const int32_t entry_count,
+    const int32_t row_slots,
+    const int32_t key_slot,
+    const int64_t agg_slot_mask) {
+  return agg_from_smem_to_gmem_nop(dest, src, entry_count);
+}
+
 extern "C" __attribute__((noinline)) void init_group_by_buffer_gpu(
     int64_t* groups_buffer,
     const int64_t* init_vals,
@@ -984,6 +1072,19 @@ extern "C" ALWAYS_INLINE uint64_t string_pack(const int8_t* ptr, const int32_t l
          (static_cast<const uint64_t>(len) << 48);
 }
 
+// Same as string_decompress, for a copy of the dictionary in the device memory.
+extern "C" ALWAYS_INLINE uint64_t string_decompress_gpu(const int32_t string_id,
+                                                        const int64_t string_dict_buff) {
+  const auto str_count = *reinterpret_cast<const int64_t*>(string_dict_buff);
+  if (string_id < 0 || string_id >= str_count) {
+    return 0;
+  }
+  const auto offsets = reinterpret_cast<const int64_t*>(string_dict_buff) + 1;
+  const auto payload = reinterpret_cast<const int8_t*>(offsets + str_count + 1);
+  return string_pack(payload + offsets[string_id],
+                     offsets[string_id + 1] - offsets[string_id]);
+}
+
 #ifdef __clang__
 #include "../Utils/StringLike.cpp"
 #endif
@@ -183,6 +183,11 @@ extern "C" int64_t fixed_width_unsigned_decode_noinline(const int8_t* byte_strea
                                                         const int32_t byte_width,
                                                         const int64_t pos);
 
+extern "C" int64_t diff_fixed_width_int_decode_noinline(const int8_t* byte_stream,
+                                                        const int32_t byte_width,
+                                                        const int64_t null_val,
+                                                        const int64_t pos);
+
 extern "C" float fixed_width_float_decode_noinline(const int8_t* byte_stream,
                                                    const int64_t pos);
 
@@ -205,4 +210,15 @@ inline int32_t get_empty_key() {
   return EMPTY_KEY_32;
 }
 
+// First slot of a value in the hash set of an IN subquery, finalizer of MurmurHash3.
+inline uint64_t in_values_hash_set_slot(const int64_t val, const uint64_t capacity) {
+  auto h = static_cast<uint64_t>(val);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h & (capacity - 1);
+}
+
 #endif  // QUERYENGINE_RUNTIMEFUNCTIONS_H
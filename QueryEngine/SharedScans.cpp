@@ -0,0 +1,115 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SharedScans.h"
+#include "RelAlgAbstractInterpreter.h"
+#include "ResultSet.h"
+#include "ResultSetBufferAccessors.h"
+
+#include <cstring>
+
+std::list<std::shared_ptr<SharedScanRequest>> SharedScans::waiting_;
+std::mutex SharedScans::mutex_;
+
+const RelCompound* SharedScans::getShareableCompound(const RelAlgNode* ra) {
+  const auto compound = dynamic_cast<const RelCompound*>(ra);
+  if (!compound || !compound->isAggregate() || compound->getGroupByCount() ||
+      compound->isUpdateViaSelect() || compound->isDeleteViaSelect() ||
+      compound->inputCount() != 1) {
+    return nullptr;
+  }
+  return dynamic_cast<const RelScan*>(compound->getInput(0)) ? compound : nullptr;
+}
+
+std::shared_ptr<SharedScanRequest> SharedScans::enqueue(
+    const int db_id,
+    const RelCompound* compound,
+    const ExecutorDeviceType device_type) {
+  const auto scan = dynamic_cast<const RelScan*>(compound->getInput(0));
+  CHECK(scan);
+  auto request = std::make_shared<SharedScanRequest>(SharedScanRequest{
+      db_id, scan->getTableDescriptor()->tableId, device_type, compound, nullptr, {}});
+  std::lock_guard<std::mutex> lock(mutex_);
+  waiting_.push_back(request);
+  return request;
+}
+
+void SharedScans::withdraw(const std::shared_ptr<SharedScanRequest>& request) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  waiting_.remove(request);
+}
+
+std::vector<std::shared_ptr<SharedScanRequest>> SharedScans::take(
+    const int db_id,
+    const int table_id,
+    const ExecutorDeviceType device_type) {
+  std::vector<std::shared_ptr<SharedScanRequest>> requests;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = waiting_.begin(); it != waiting_.end();) {
+    const auto& request = *it;
+    if (request->db_id == db_id && request->table_id == table_id &&
+        request->device_type == device_type) {
+      requests.push_back(request);
+      it = waiting_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return requests;
+}
+
+std::shared_ptr<ResultSet> SharedScans::extractTargets(const ResultSet& fused_rows,
+                                                       const size_t first_target,
+                                                       const size_t target_count,
+                                                       const Executor* executor) {
+  const auto& fused_query_mem_desc = fused_rows.getQueryMemDesc();
+  CHECK(fused_query_mem_desc.getQueryDescriptionType() ==
+        QueryDescriptionType::NonGroupedAggregate);
+  CHECK(!fused_query_mem_desc.didOutputColumnar());
+  CHECK_EQ(size_t(1), fused_rows.entryCount());
+  const auto& fused_targets = fused_rows.getTargetInfos();
+  CHECK_LE(first_target + target_count, fused_targets.size());
+  size_t first_slot{0};
+  for (size_t i = 0; i < first_target; ++i) {
+    first_slot = advance_slot(first_slot, fused_targets[i], false);
+  }
+  const std::vector<TargetInfo> targets(
+      fused_targets.begin() + first_target,
+      fused_targets.begin() + first_target + target_count);
+  size_t slot_count{0};
+  for (const auto& target : targets) {
+    slot_count = advance_slot(slot_count, target, false);
+  }
+  auto query_mem_desc = fused_query_mem_desc;
+  query_mem_desc.clearAggColWidths();
+  for (size_t slot = first_slot; slot < first_slot + slot_count; ++slot) {
+    query_mem_desc.addAggColWidth(fused_query_mem_desc.getColumnWidth(slot));
+  }
+  auto rows = std::make_shared<ResultSet>(targets,
+                                          ExecutorDeviceType::CPU,
+                                          query_mem_desc,
+                                          fused_rows.getRowSetMemOwner(),
+                                          executor);
+  rows->allocateStorage();
+  const auto fused_buff = fused_rows.getStorage()->getUnderlyingBuffer();
+  const auto buff = rows->getStorage()->getUnderlyingBuffer();
+  for (size_t slot = 0; slot < slot_count; ++slot) {
+    memcpy(buff + query_mem_desc.getColOffInBytes(0, slot),
+           fused_buff + fused_query_mem_desc.getColOffInBytes(0, first_slot + slot),
+           query_mem_desc.getColumnWidth(slot).compact);
+  }
+  return rows;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    SharedScans.h
+ * @brief   Queued aggregates which the query running before them computes in its pass.
+ *
+ * Dashboards send many aggregates over the same table and filter at once, which the
+ * executor runs one after the other, each one scanning the table again. A non-grouped
+ * aggregate over a single table registers here before it waits for the executor. The
+ * next such query to run takes the queued ones with the same table and filter, appends
+ * their targets to its own and splits the single row of the fused pass back out; the
+ * queries it answered return their rows as soon as they get the executor.
+ */
+
+#ifndef QUERYENGINE_SHAREDSCANS_H
+#define QUERYENGINE_SHAREDSCANS_H
+
+#include "CompilationOptions.h"
+#include "TargetMetaInfo.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Executor;
+class RelAlgNode;
+class RelCompound;
+class ResultSet;
+
+struct SharedScanRequest {
+  const int db_id;
+  const int table_id;
+  const ExecutorDeviceType device_type;
+  const RelCompound* compound;
+  // Set by the query which took the request, under the executor lock.
+  std::shared_ptr<ResultSet> rows;
+  std::vector<TargetMetaInfo> targets_meta;
+};
+
+class SharedScans {
+ public:
+  // The compound if the plan is a single non-grouped aggregate over a table scan.
+  static const RelCompound* getShareableCompound(const RelAlgNode* ra);
+
+  static std::shared_ptr<SharedScanRequest> enqueue(const int db_id,
+                                                    const RelCompound* compound,
+                                                    const ExecutorDeviceType device_type);
+
+  // Called once admitted. The rows of the request are set if another query took it.
+  static void withdraw(const std::shared_ptr<SharedScanRequest>& request);
+
+  // The waiting requests over the table, which the caller answers or leaves to run.
+  static std::vector<std::shared_ptr<SharedScanRequest>> take(
+      const int db_id,
+      const int table_id,
+      const ExecutorDeviceType device_type);
+
+  // The row of the targets from first_target on, out of the single row of a fused pass.
+  static std::shared_ptr<ResultSet> extractTargets(const ResultSet& fused_rows,
+                                                   const size_t first_target,
+                                                   const size_t target_count,
+                                                   const Executor* executor);
+
+ private:
+  static std::list<std::shared_ptr<SharedScanRequest>> waiting_;
+  static std::mutex mutex_;
+};
+
+#endif  // QUERYENGINE_SHAREDSCANS_H
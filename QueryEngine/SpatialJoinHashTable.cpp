@@ -0,0 +1,498 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SpatialJoinHashTable.h"
+#include "Execute.h"
+#include "JoinHashTable.h"
+#include "SpatialJoinRuntime.h"
+
+#include <glog/logging.h>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Grows the boxes by more than the tolerance of the geo functions when they test a
+// point against the bounds of a polygon or compare a distance, so rounding and the
+// decompression of the coordinates can't push a match out of the cells of its box.
+const double kBoxPadding{0.0000001};
+
+int32_t get_int_arg(const Analyzer::FunctionOper* func_oper, const size_t idx) {
+  const auto constant = dynamic_cast<const Analyzer::Constant*>(func_oper->getArg(idx));
+  CHECK(constant);
+  return constant->get_constval().intval;
+}
+
+// The coordinates of both arguments are used as they are, without a transform.
+bool is_untransformed(const Analyzer::FunctionOper* func_oper,
+                      const size_t isr0_idx,
+                      const size_t isr1_idx,
+                      const size_t osr_idx) {
+  const auto osr = get_int_arg(func_oper, osr_idx);
+  return get_int_arg(func_oper, isr0_idx) == osr &&
+         get_int_arg(func_oper, isr1_idx) == osr;
+}
+
+const Analyzer::ColumnVar* get_point_col_var(const Analyzer::Expr* expr) {
+  const auto col_var = dynamic_cast<const Analyzer::ColumnVar*>(expr);
+  if (!col_var || col_var->get_table_id() <= 0 ||
+      col_var->get_type_info().get_type() != kPOINT) {
+    return nullptr;
+  }
+  return col_var;
+}
+
+// The physical column which holds the coordinates of a geo column.
+std::shared_ptr<Analyzer::ColumnVar> get_coords_col_var(
+    const Analyzer::ColumnVar& geo_col_var,
+    const Catalog_Namespace::Catalog& catalog) {
+  const auto cd = get_column_descriptor(
+      geo_col_var.get_column_id() + 1, geo_col_var.get_table_id(), catalog);
+  CHECK(cd);
+  return std::make_shared<Analyzer::ColumnVar>(cd->columnType,
+                                               geo_col_var.get_table_id(),
+                                               cd->columnId,
+                                               geo_col_var.get_rte_idx());
+}
+
+double get_double_constant(const Analyzer::Constant* constant) {
+  const auto& ti = constant->get_type_info();
+  const auto datum = constant->get_constval();
+  switch (ti.get_type()) {
+    case kTINYINT:
+      return datum.tinyintval;
+    case kSMALLINT:
+      return datum.smallintval;
+    case kINT:
+      return datum.intval;
+    case kBIGINT:
+      return datum.bigintval;
+    case kNUMERIC:
+    case kDECIMAL:
+      return datum.bigintval / std::pow(10., ti.get_scale());
+    case kFLOAT:
+      return datum.floatval;
+    case kDOUBLE:
+      return datum.doubleval;
+    default:
+      return -1;
+  }
+}
+
+typedef std::pair<const Analyzer::FunctionOper*, double> DistanceWithin;
+
+// Splits quals like ST_Distance(a.pt, b.pt) <= d into the distance and d, negative for
+// other quals. The grid lists closed boxes, both kinds of inequality map to the same
+// probe.
+DistanceWithin get_distance_within(const Analyzer::BinOper* bin_oper) {
+  if (bin_oper->get_qualifier() != kONE) {
+    return {nullptr, -1};
+  }
+  const Analyzer::Expr* distance{nullptr};
+  const Analyzer::Expr* upper_bound{nullptr};
+  switch (bin_oper->get_optype()) {
+    case kLT:
+    case kLE:
+      distance = bin_oper->get_left_operand();
+      upper_bound = bin_oper->get_right_operand();
+      break;
+    case kGT:
+    case kGE:
+      distance = bin_oper->get_right_operand();
+      upper_bound = bin_oper->get_left_operand();
+      break;
+    default:
+      return {nullptr, -1};
+  }
+  const auto func_oper = dynamic_cast<const Analyzer::FunctionOper*>(distance);
+  const auto constant = dynamic_cast<const Analyzer::Constant*>(upper_bound);
+  if (!func_oper || !constant || constant->get_is_null()) {
+    return {nullptr, -1};
+  }
+  return {func_oper, get_double_constant(constant)};
+}
+
+bool is_valid_box(const double min_x,
+                  const double min_y,
+                  const double max_x,
+                  const double max_y) {
+  return std::isfinite(min_x) && std::isfinite(min_y) && std::isfinite(max_x) &&
+         std::isfinite(max_y) && min_x <= max_x && min_y <= max_y;
+}
+
+}  // namespace
+
+std::shared_ptr<SpatialJoinHashTable> SpatialJoinHashTable::getInstance(
+    const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+    const int inner_rte_idx,
+    const std::vector<InputTableInfo>& query_infos,
+    const Data_Namespace::MemoryLevel memory_level,
+    const int device_count,
+    ColumnCacheMap& column_cache,
+    Executor* executor) {
+  const auto& catalog = *executor->getCatalog();
+  for (const auto& qual : quals) {
+    // ST_Contains(poly, pt): poly, poly bounds, pt, ic0, isr0, ic1, isr1, osr.
+    const auto func_oper = dynamic_cast<const Analyzer::FunctionOper*>(qual.get());
+    if (func_oper && func_oper->getArity() == 8 &&
+        (func_oper->getName() == "ST_Contains_Polygon_Point" ||
+         func_oper->getName() == "ST_Contains_MultiPolygon_Point")) {
+      const auto inner_bounds =
+          std::dynamic_pointer_cast<Analyzer::ColumnVar>(func_oper->getOwnArg(1));
+      const auto outer_point = get_point_col_var(func_oper->getArg(2));
+      if (!inner_bounds || inner_bounds->get_rte_idx() != inner_rte_idx ||
+          inner_bounds->get_table_id() <= 0 || !outer_point ||
+          outer_point->get_rte_idx() >= inner_rte_idx ||
+          !is_untransformed(func_oper, 4, 6, 7)) {
+        continue;
+      }
+      auto join_hash_table = std::shared_ptr<SpatialJoinHashTable>(
+          new SpatialJoinHashTable(inner_bounds,
+                                   InnerKind::Bounds,
+                                   0,
+                                   kBoxPadding,
+                                   get_coords_col_var(*outer_point, catalog),
+                                   get_int_arg(func_oper, 5),
+                                   query_infos,
+                                   memory_level,
+                                   column_cache,
+                                   executor));
+      join_hash_table->reify(device_count);
+      return join_hash_table;
+    }
+    const auto bin_oper = dynamic_cast<const Analyzer::BinOper*>(qual.get());
+    if (!bin_oper) {
+      continue;
+    }
+    // ST_Distance(pt0, pt1): pt0, pt1, ic0, isr0, ic1, isr1, osr.
+    const auto distance_within = get_distance_within(bin_oper);
+    const auto distance_oper = distance_within.first;
+    if (!distance_oper || distance_oper->getName() != "ST_Distance_Point_Point" ||
+        distance_oper->getArity() != 7 || distance_within.second < 0 ||
+        !is_untransformed(distance_oper, 3, 5, 6)) {
+      continue;
+    }
+    const auto point0 = get_point_col_var(distance_oper->getArg(0));
+    const auto point1 = get_point_col_var(distance_oper->getArg(1));
+    if (!point0 || !point1) {
+      continue;
+    }
+    const size_t inner_arg = point0->get_rte_idx() == inner_rte_idx ? 0 : 1;
+    const auto inner_point = inner_arg ? point1 : point0;
+    const auto outer_point = inner_arg ? point0 : point1;
+    if (inner_point->get_rte_idx() != inner_rte_idx ||
+        outer_point->get_rte_idx() >= inner_rte_idx) {
+      continue;
+    }
+    auto join_hash_table = std::shared_ptr<SpatialJoinHashTable>(
+        new SpatialJoinHashTable(get_coords_col_var(*inner_point, catalog),
+                                 InnerKind::Point,
+                                 get_int_arg(distance_oper, 2 + 2 * inner_arg),
+                                 distance_within.second + kBoxPadding,
+                                 get_coords_col_var(*outer_point, catalog),
+                                 get_int_arg(distance_oper, 4 - 2 * inner_arg),
+                                 query_infos,
+                                 memory_level,
+                                 column_cache,
+                                 executor));
+    join_hash_table->reify(device_count);
+    return join_hash_table;
+  }
+  throw HashJoinFail("No spatial join expression found");
+}
+
+SpatialJoinHashTable::SpatialJoinHashTable(
+    const std::shared_ptr<Analyzer::ColumnVar> inner_col,
+    const InnerKind inner_kind,
+    const int32_t inner_ic,
+    const double padding,
+    const std::shared_ptr<Analyzer::ColumnVar> outer_coords,
+    const int32_t outer_ic,
+    const std::vector<InputTableInfo>& query_infos,
+    const Data_Namespace::MemoryLevel memory_level,
+    ColumnCacheMap& column_cache,
+    Executor* executor)
+    : inner_col_(inner_col)
+    , inner_kind_(inner_kind)
+    , inner_ic_(inner_ic)
+    , padding_(padding)
+    , outer_coords_(outer_coords)
+    , outer_ic_(outer_ic)
+    , query_infos_(query_infos)
+    , memory_level_(memory_level)
+    , column_cache_(column_cache)
+    , executor_(executor)
+    , min_x_(0)
+    , min_y_(0)
+    , max_x_(0)
+    , max_y_(0)
+    , cell_width_(1)
+    , cell_height_(1)
+    , cells_x_(1)
+    , cells_y_(1) {}
+
+int64_t SpatialJoinHashTable::getJoinHashBuffer(const ExecutorDeviceType device_type,
+                                                const int device_id) noexcept {
+  if (device_type == ExecutorDeviceType::CPU && !cpu_hash_table_buff_) {
+    return 0;
+  }
+#ifdef HAVE_CUDA
+  CHECK_LT(static_cast<size_t>(device_id), gpu_hash_table_buff_.size());
+  return device_type == ExecutorDeviceType::CPU
+             ? reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0])
+             : reinterpret_cast<int64_t>(gpu_hash_table_buff_[device_id]->getMemoryPtr());
+#else
+  CHECK(device_type == ExecutorDeviceType::CPU);
+  return reinterpret_cast<int64_t>(&(*cpu_hash_table_buff_)[0]);
+#endif
+}
+
+void SpatialJoinHashTable::reify(const int device_count) {
+  CHECK_LT(0, device_count);
+#ifdef HAVE_CUDA
+  gpu_hash_table_buff_.resize(device_count);
+#endif  // HAVE_CUDA
+  const auto& query_info = get_inner_query_info(getInnerTableId(), query_infos_).info;
+  std::vector<Box> boxes;
+  if (!query_info.fragments.empty()) {
+    boxes = fetchBoxes(query_info.fragments);
+  }
+  initHashTableOnCpu(boxes);
+  if (memory_level_ != Data_Namespace::GPU_LEVEL) {
+    return;
+  }
+#ifdef HAVE_CUDA
+  // Same as for the range joins, build the grid once and copy it over.
+  auto& data_mgr = executor_->getCatalog()->get_dataMgr();
+  const auto buff_size = cpu_hash_table_buff_->size() * sizeof(int32_t);
+  for (int device_id = 0; device_id < device_count; ++device_id) {
+    gpu_hash_table_buff_[device_id] =
+        alloc_gpu_abstract_buffer(&data_mgr, buff_size, device_id);
+    copy_to_gpu(
+        &data_mgr,
+        reinterpret_cast<CUdeviceptr>(gpu_hash_table_buff_[device_id]->getMemoryPtr()),
+        &(*cpu_hash_table_buff_)[0],
+        buff_size,
+        device_id);
+  }
+#else
+  CHECK(false);
+#endif
+}
+
+// The box of every row of the inner table; the ones of the null or empty geometries
+// aren't valid and get skipped by the build.
+std::vector<SpatialJoinHashTable::Box> SpatialJoinHashTable::fetchBoxes(
+    const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments) {
+  const auto elem_size = inner_col_->get_type_info().get_size();
+  CHECK_GT(elem_size, 0);
+  std::vector<Box> boxes;
+  for (const auto& fragment : fragments) {
+    std::vector<std::shared_ptr<Chunk_NS::Chunk>> chunks_owner;
+    const int8_t* col_buff{nullptr};
+    size_t elem_count{0};
+    try {
+      std::tie(col_buff, elem_count) =
+          Executor::ExecutionDispatch::getColumnFragment(executor_,
+                                                         *inner_col_,
+                                                         fragment,
+                                                         Data_Namespace::CPU_LEVEL,
+                                                         0,
+                                                         chunks_owner,
+                                                         column_cache_);
+    } catch (...) {
+      throw FailedToFetchColumn();
+    }
+    // Keep the row ids in sync with the linearized inner columns.
+    boxes.reserve(boxes.size() + fragment.getNumTuples());
+    for (size_t i = 0; i < (col_buff ? elem_count : 0); ++i) {
+      const auto elem = col_buff + i * elem_size;
+      if (inner_kind_ == InnerKind::Bounds) {
+        const auto bounds = reinterpret_cast<const double*>(elem);
+        boxes.push_back({bounds[0] - padding_,
+                         bounds[1] - padding_,
+                         bounds[2] + padding_,
+                         bounds[3] + padding_});
+      } else {
+        const auto x = spatial_join_decompress_coord(elem, 0, inner_ic_, true);
+        const auto y = spatial_join_decompress_coord(elem, 1, inner_ic_, false);
+        boxes.push_back({x - padding_, y - padding_, x + padding_, y + padding_});
+      }
+    }
+  }
+  return boxes;
+}
+
+// Starts with cells of the average size of the boxes and doubles it until there are
+// no more cells than twice the boxes, then lays the grid out like a one-to-many hash
+// table: the position and the count of every cell, followed by the row ids of the
+// boxes of the cells.
+void SpatialJoinHashTable::initHashTableOnCpu(const std::vector<Box>& boxes) {
+  if (boxes.size() > static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    throw TooManyHashEntries();
+  }
+  size_t box_count{0};
+  double total_width{0};
+  double total_height{0};
+  for (const auto& box : boxes) {
+    if (!is_valid_box(box.min_x, box.min_y, box.max_x, box.max_y)) {
+      continue;
+    }
+    min_x_ = box_count ? std::min(min_x_, box.min_x) : box.min_x;
+    min_y_ = box_count ? std::min(min_y_, box.min_y) : box.min_y;
+    max_x_ = box_count ? std::max(max_x_, box.max_x) : box.max_x;
+    max_y_ = box_count ? std::max(max_y_, box.max_y) : box.max_y;
+    total_width += box.max_x - box.min_x;
+    total_height += box.max_y - box.min_y;
+    ++box_count;
+  }
+  if (box_count) {
+    const auto span_x = max_x_ - min_x_;
+    const auto span_y = max_y_ - min_y_;
+    cell_width_ = total_width / box_count;
+    cell_height_ = total_height / box_count;
+    if (!(cell_width_ > 0)) {
+      cell_width_ = span_x > 0 ? span_x / box_count : 1;
+    }
+    if (!(cell_height_ > 0)) {
+      cell_height_ = span_y > 0 ? span_y / box_count : 1;
+    }
+    const auto cells_along = [](const double span, const double cell_size) {
+      return std::floor(span / cell_size) + 1;
+    };
+    const double max_cell_count = 2. * box_count;
+    while (cells_along(span_x, cell_width_) * cells_along(span_y, cell_height_) >
+           max_cell_count) {
+      cell_width_ *= 2;
+      cell_height_ *= 2;
+    }
+    cells_x_ = cells_along(span_x, cell_width_);
+    cells_y_ = cells_along(span_y, cell_height_);
+  }
+  const size_t cell_count = cells_x_ * cells_y_;
+  std::vector<int32_t> counts(cell_count, 0);
+  const auto for_each_cell = [this](const Box& box, const auto& func) {
+    const auto first_x = spatial_join_cell_idx(box.min_x, min_x_, cell_width_, cells_x_);
+    const auto last_x = spatial_join_cell_idx(box.max_x, min_x_, cell_width_, cells_x_);
+    const auto first_y = spatial_join_cell_idx(box.min_y, min_y_, cell_height_, cells_y_);
+    const auto last_y = spatial_join_cell_idx(box.max_y, min_y_, cell_height_, cells_y_);
+    for (auto y = first_y; y <= last_y; ++y) {
+      for (auto x = first_x; x <= last_x; ++x) {
+        func(y * cells_x_ + x);
+      }
+    }
+  };
+  size_t entry_count{0};
+  for (const auto& box : boxes) {
+    if (!is_valid_box(box.min_x, box.min_y, box.max_x, box.max_y)) {
+      continue;
+    }
+    for_each_cell(box, [&counts, &entry_count](const int64_t cell) {
+      ++counts[cell];
+      ++entry_count;
+    });
+  }
+  if (2 * cell_count + entry_count >
+      static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+    throw TooManyHashEntries();
+  }
+  cpu_hash_table_buff_ =
+      std::make_shared<std::vector<int32_t>>(2 * cell_count + entry_count);
+  auto pos_buff = &(*cpu_hash_table_buff_)[0];
+  auto count_buff = pos_buff + cell_count;
+  auto id_buff = count_buff + cell_count;
+  int32_t pos{0};
+  for (size_t cell = 0; cell < cell_count; ++cell) {
+    pos_buff[cell] = counts[cell] ? pos : -1;
+    pos += counts[cell];
+  }
+  for (size_t i = 0; i < boxes.size(); ++i) {
+    const auto& box = boxes[i];
+    if (!is_valid_box(box.min_x, box.min_y, box.max_x, box.max_y)) {
+      continue;
+    }
+    for_each_cell(box, [pos_buff, count_buff, id_buff, i](const int64_t cell) {
+      id_buff[pos_buff[cell] + count_buff[cell]++] = i;
+    });
+  }
+}
+
+// The cell of the probed point, -1 if it's outside of the grid.
+llvm::Value* SpatialJoinHashTable::codegenCell(const CompilationOptions& co) {
+  const auto coords_lvs = executor_->codegen(outer_coords_.get(), true, co);
+  CHECK_EQ(size_t(1), coords_lvs.size());
+  auto cgen_state = executor_->cgen_state_.get();
+  const auto coords_ptr_lv = cgen_state->emitExternalCall(
+      "array_buff",
+      llvm::Type::getInt8PtrTy(cgen_state->context_),
+      {coords_lvs.front(), executor_->posArg(outer_coords_.get())});
+  return cgen_state->emitCall("spatial_join_grid_cell",
+                              {coords_ptr_lv,
+                               executor_->ll_int(outer_ic_),
+                               executor_->ll_fp(min_x_),
+                               executor_->ll_fp(min_y_),
+                               executor_->ll_fp(max_x_),
+                               executor_->ll_fp(max_y_),
+                               executor_->ll_fp(cell_width_),
+                               executor_->ll_fp(cell_height_),
+                               executor_->ll_int(cells_x_),
+                               executor_->ll_int(cells_y_)});
+}
+
+llvm::Value* SpatialJoinHashTable::codegenSlotIsValid(const CompilationOptions&,
+                                                      const size_t) {
+  // The spatial quals aren't folded into the grid, nothing compares to a slot.
+  CHECK(false);
+  return nullptr;
+}
+
+llvm::Value* SpatialJoinHashTable::codegenSlot(const CompilationOptions&,
+                                               const size_t) {
+  CHECK(false);
+  return nullptr;
+}
+
+HashJoinMatchingSet SpatialJoinHashTable::codegenMatchingSet(
+    const CompilationOptions& co,
+    const size_t index) {
+  auto hash_ptr = JoinHashTable::codegenHashTableLoad(index, executor_);
+  CHECK(hash_ptr);
+  if (!hash_ptr->getType()->isIntegerTy(64)) {
+    CHECK(hash_ptr->getType()->isPointerTy());
+    hash_ptr = executor_->cgen_state_->ir_builder_.CreatePtrToInt(
+        hash_ptr, llvm::Type::getInt64Ty(executor_->cgen_state_->context_));
+  }
+  const int64_t cell_count = cells_x_ * cells_y_;
+  const std::vector<llvm::Value*> hash_join_idx_args{hash_ptr,
+                                                     codegenCell(co),
+                                                     executor_->ll_int(int64_t(0)),
+                                                     executor_->ll_int(cell_count - 1)};
+  const int64_t sub_buff_size = cell_count * sizeof(int32_t);
+  return JoinHashTable::codegenMatchingSet(
+      hash_join_idx_args, false, false, false, sub_buff_size, executor_);
+}
+
+int SpatialJoinHashTable::getInnerTableId() const noexcept {
+  return inner_col_->get_table_id();
+}
+
+int SpatialJoinHashTable::getInnerTableRteIdx() const noexcept {
+  return inner_col_->get_rte_idx();
+}
+
+JoinHashTableInterface::HashType SpatialJoinHashTable::getHashType() const noexcept {
+  return JoinHashTableInterface::HashType::OneToMany;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef QUERYENGINE_SPATIALJOINHASHTABLE_H
+#define QUERYENGINE_SPATIALJOINHASHTABLE_H
+
+#include "../Analyzer/Analyzer.h"
+#include "../DataMgr/MemoryLevel.h"
+#include "ColumnarResults.h"
+#include "InputMetadata.h"
+#include "JoinHashTableInterface.h"
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <vector>
+
+class Executor;
+
+// Grid index for a join on a point of the outer tables contained by a polygon of the
+// inner table, ST_Contains(b.poly, a.pt), or within a distance of a point of the inner
+// table, ST_Distance(a.pt, b.pt) <= d. The bounding boxes of the inner geometries, the
+// points grown by the distance, are listed in every cell of a uniform grid they overlap,
+// using the one-to-many layout. A probe only visits the geometries of the cell of its
+// point: the spatial qual stays in the filter of the query and does the exact test.
+class SpatialJoinHashTable : public JoinHashTableInterface {
+ public:
+  // Throws HashJoinFail unless the quals test a point of the outer tables against a
+  // geometry of the inner table at the given nesting level, with no transform.
+  static std::shared_ptr<SpatialJoinHashTable> getInstance(
+      const std::list<std::shared_ptr<Analyzer::Expr>>& quals,
+      const int inner_rte_idx,
+      const std::vector<InputTableInfo>& query_infos,
+      const Data_Namespace::MemoryLevel memory_level,
+      const int device_count,
+      ColumnCacheMap& column_cache,
+      Executor* executor);
+
+  int64_t getJoinHashBuffer(const ExecutorDeviceType device_type,
+                            const int device_id) noexcept override;
+
+  llvm::Value* codegenSlotIsValid(const CompilationOptions&, const size_t) override;
+
+  llvm::Value* codegenSlot(const CompilationOptions&, const size_t) override;
+
+  HashJoinMatchingSet codegenMatchingSet(const CompilationOptions&,
+                                         const size_t) override;
+
+  int getInnerTableId() const noexcept override;
+
+  int getInnerTableRteIdx() const noexcept override;
+
+  JoinHashTableInterface::HashType getHashType() const noexcept override;
+
+  virtual ~SpatialJoinHashTable() {}
+
+ private:
+  enum class InnerKind { Bounds, Point };
+
+  struct Box {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+  };
+
+  SpatialJoinHashTable(const std::shared_ptr<Analyzer::ColumnVar> inner_col,
+                       const InnerKind inner_kind,
+                       const int32_t inner_ic,
+                       const double padding,
+                       const std::shared_ptr<Analyzer::ColumnVar> outer_coords,
+                       const int32_t outer_ic,
+                       const std::vector<InputTableInfo>& query_infos,
+                       const Data_Namespace::MemoryLevel memory_level,
+                       ColumnCacheMap& column_cache,
+                       Executor* executor);
+
+  void reify(const int device_count);
+
+  std::vector<Box> fetchBoxes(
+      const std::deque<Fragmenter_Namespace::FragmentInfo>& fragments);
+
+  void initHashTableOnCpu(const std::vector<Box>& boxes);
+
+  llvm::Value* codegenCell(const CompilationOptions& co);
+
+  // The bounds of the polygons or the coordinates of the points of the inner table.
+  const std::shared_ptr<Analyzer::ColumnVar> inner_col_;
+  const InnerKind inner_kind_;
+  const int32_t inner_ic_;
+  // How much the boxes of the inner geometries are grown on every side.
+  const double padding_;
+  const std::shared_ptr<Analyzer::ColumnVar> outer_coords_;
+  const int32_t outer_ic_;
+  const std::vector<InputTableInfo>& query_infos_;
+  const Data_Namespace::MemoryLevel memory_level_;
+  ColumnCacheMap& column_cache_;
+  Executor* executor_;
+  // The grid covers the boxes, cells_x_ by cells_y_ cells of the same size.
+  double min_x_;
+  double min_y_;
+  double max_x_;
+  double max_y_;
+  double cell_width_;
+  double cell_height_;
+  int64_t cells_x_;
+  int64_t cells_y_;
+  std::shared_ptr<std::vector<int32_t>> cpu_hash_table_buff_;
+#ifdef HAVE_CUDA
+  std::vector<Data_Namespace::AbstractBuffer*> gpu_hash_table_buff_;
+#endif
+};
+
+#endif  // QUERYENGINE_SPATIALJOINHASHTABLE_H
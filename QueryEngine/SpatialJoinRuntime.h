@@ -0,0 +1,58 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    SpatialJoinRuntime.h
+ * @brief   Placement of the points in the grid of a spatial join hash table.
+ *
+ * Shared by the build of the grid on the host and the probes of the generated code, so
+ * that both sides place a point in the same cell.
+ */
+
+#ifndef QUERYENGINE_SPATIALJOINRUNTIME_H
+#define QUERYENGINE_SPATIALJOINRUNTIME_H
+
+#include "../Shared/funcannotations.h"
+
+#include <cstdint>
+
+// Same as COMPRESSION_GEOINT32 in ExtensionFunctionsGeo.hpp.
+#define SPATIAL_JOIN_COMPRESSION_GEOINT32 1
+
+// Decompresses a coordinate of a point like decompress_coord in ExtensionFunctionsGeo.hpp.
+inline DEVICE double spatial_join_decompress_coord(const int8_t* coords,
+                                                  const int32_t index,
+                                                  const int32_t ic,
+                                                  const bool x) {
+  if (ic == SPATIAL_JOIN_COMPRESSION_GEOINT32) {
+    const auto compressed_coord = reinterpret_cast<const int32_t*>(coords)[index];
+    return static_cast<double>(compressed_coord) *
+           (x ? 8.3819031754424345e-08    // (180.0 / 2147483647.0)
+              : 4.1909515877212172e-08);  // (90.0 / 2147483647.0)
+  }
+  return reinterpret_cast<const double*>(coords)[index];
+}
+
+// The column or row of the cell of a coordinate within [min_val, max_val] of the grid.
+inline DEVICE int64_t spatial_join_cell_idx(const double val,
+                                           const double min_val,
+                                           const double cell_size,
+                                           const int64_t cell_count) {
+  const auto idx = static_cast<int64_t>((val - min_val) / cell_size);
+  return idx < cell_count ? idx : cell_count - 1;
+}
+
+#endif  // QUERYENGINE_SPATIALJOINRUNTIME_H
@@ -20,6 +20,8 @@
 #include "ResultSet.h"
 
 #include <glog/logging.h>
+#include <algorithm>
+#include <functional>
 
 SpeculativeTopNMap::SpeculativeTopNMap() : unknown_(0) {}
 
@@ -112,10 +114,24 @@ std::shared_ptr<ResultSet> SpeculativeTopNMap::asRows(
       throw SpeculativeTopNFailed();
     }
   }
+  return top_n_entries_to_rows(
+      vec, num_rows, ra_exe_unit, row_set_mem_owner, query_mem_desc, executor);
+}
+
+std::shared_ptr<ResultSet> top_n_entries_to_rows(
+    const std::vector<SpeculativeTopNEntry>& entries,
+    const size_t num_rows,
+    const RelAlgExecutionUnit& ra_exe_unit,
+    std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner,
+    const QueryMemoryDescriptor& query_mem_desc,
+    const Executor* executor) {
+  CHECK_LE(num_rows, entries.size());
   CHECK_EQ(size_t(2), ra_exe_unit.target_exprs.size());
   auto query_mem_desc_rs = query_mem_desc;
   query_mem_desc_rs.setQueryDescriptionType(QueryDescriptionType::GroupByBaselineHash);
   query_mem_desc_rs.setOutputColumnar(false);
+  // The rows are in order already, a sort on the host is cheap.
+  query_mem_desc_rs.setSortOnGpu(false);
   query_mem_desc_rs.setEntryCount(num_rows);
   query_mem_desc_rs.clearAggColWidths();
   query_mem_desc_rs.addAggColWidth({8, 8});
@@ -131,9 +147,9 @@ std::shared_ptr<ResultSet> SpeculativeTopNMap::asRows(
   const bool count_first =
       dynamic_cast<const Analyzer::AggExpr*>(ra_exe_unit.target_exprs[0]);
   for (size_t i = 0; i < num_rows; ++i) {
-    rs_buff[0] = vec[i].key;
-    int64_t col0 = vec[i].key;
-    int64_t col1 = vec[i].val;
+    rs_buff[0] = entries[i].key;
+    int64_t col0 = entries[i].key;
+    int64_t col1 = entries[i].val;
     if (count_first) {
       std::swap(col0, col1);
     }
@@ -179,3 +195,137 @@ bool use_speculative_top_n(const RelAlgExecutionUnit& ra_exe_unit,
   return query_mem_desc.sortOnGpu() && ra_exe_unit.sort_info.limit &&
          ra_exe_unit.sort_info.algorithm == SortAlgorithm::SpeculativeTopN;
 }
+
+bool use_top_count_pruning(const RelAlgExecutionUnit& ra_exe_unit,
+                           const QueryMemoryDescriptor& query_mem_desc) {
+  if (!g_enable_top_count_pruning || g_cluster) {
+    return false;
+  }
+  if (query_mem_desc.getQueryDescriptionType() !=
+          QueryDescriptionType::GroupByPerfectHash &&
+      query_mem_desc.getQueryDescriptionType() !=
+          QueryDescriptionType::GroupByBaselineHash) {
+    return false;
+  }
+  const auto& sort_info = ra_exe_unit.sort_info;
+  if (!sort_info.limit || sort_info.order_entries.size() != 1 ||
+      !sort_info.order_entries.front().is_desc) {
+    return false;
+  }
+  if (ra_exe_unit.groupby_exprs.size() != 1 || !ra_exe_unit.groupby_exprs.front() ||
+      ra_exe_unit.target_exprs.size() != 2) {
+    return false;
+  }
+  // Ordered by the count, the other target is the key, read as an integer.
+  const size_t count_idx = sort_info.order_entries.front().tle_no - 1;
+  if (count_idx > 1) {
+    return false;
+  }
+  const auto count_expr =
+      dynamic_cast<const Analyzer::AggExpr*>(ra_exe_unit.target_exprs[count_idx]);
+  if (!count_expr || count_expr->get_aggtype() != kCOUNT ||
+      count_expr->get_is_distinct()) {
+    return false;
+  }
+  const auto key_expr = ra_exe_unit.target_exprs[1 - count_idx];
+  const auto& key_ti = key_expr->get_type_info();
+  return !dynamic_cast<const Analyzer::AggExpr*>(key_expr) &&
+         (key_ti.is_integer() ||
+          (key_ti.is_string() && key_ti.get_compression() == kENCODING_DICT));
+}
+
+namespace {
+
+// The (key, count) pairs of a partial result, in the order of the targets.
+std::vector<SpeculativeTopNEntry> get_key_counts(const ResultSet& rows,
+                                                 const bool count_first) {
+  std::vector<SpeculativeTopNEntry> key_counts;
+  CHECK_EQ(size_t(2), rows.colCount());
+  while (true) {
+    const auto crt_row = rows.getNextRow(false, false);
+    if (crt_row.empty()) {
+      break;
+    }
+    CHECK_EQ(size_t(2), crt_row.size());
+    const auto key_r = boost::get<ScalarTargetValue>(&crt_row[count_first ? 1 : 0]);
+    const auto count_r = boost::get<ScalarTargetValue>(&crt_row[count_first ? 0 : 1]);
+    CHECK(key_r && count_r);
+    const auto key_p = boost::get<int64_t>(key_r);
+    const auto count_p = boost::get<int64_t>(count_r);
+    CHECK(key_p && count_p);
+    key_counts.push_back({*key_p, static_cast<size_t>(*count_p), false});
+  }
+  return key_counts;
+}
+
+}  // namespace
+
+std::vector<SpeculativeTopNEntry> get_top_count_groups(
+    const std::vector<std::shared_ptr<ResultSet>>& partial_results,
+    const std::vector<Analyzer::Expr*>& target_exprs,
+    const size_t top_n) {
+  CHECK_GT(top_n, size_t(0));
+  const bool count_first = dynamic_cast<const Analyzer::AggExpr*>(target_exprs[0]);
+  std::vector<std::vector<SpeculativeTopNEntry>> partial_counts;
+  for (const auto& rows : partial_results) {
+    CHECK(rows);
+    partial_counts.push_back(get_key_counts(*rows, count_first));
+  }
+  // The sums of the top counts of every partial result are lower bounds of the
+  // totals: at least top_n groups count as much as the top_n-th highest sum.
+  std::unordered_map<int64_t, size_t> lower_bounds;
+  for (auto& key_counts : partial_counts) {
+    if (key_counts.empty()) {
+      continue;
+    }
+    const auto partial_top_n = std::min(top_n, key_counts.size());
+    std::nth_element(key_counts.begin(),
+                     key_counts.begin() + partial_top_n - 1,
+                     key_counts.end(),
+                     std::greater<SpeculativeTopNEntry>());
+    for (size_t i = 0; i < partial_top_n; ++i) {
+      lower_bounds[key_counts[i].key] += key_counts[i].val;
+    }
+  }
+  size_t threshold{0};
+  if (lower_bounds.size() >= top_n) {
+    std::vector<size_t> bounds;
+    for (const auto& kv : lower_bounds) {
+      bounds.push_back(kv.second);
+    }
+    std::nth_element(
+        bounds.begin(), bounds.begin() + top_n - 1, bounds.end(), std::greater<size_t>());
+    threshold = bounds[top_n - 1];
+  }
+  // A group below threshold / partial count in every partial result counts less than
+  // the threshold in total: only the others are candidates, summed exactly.
+  const auto partial_threshold =
+      static_cast<double>(threshold) / std::max(partial_counts.size(), size_t(1));
+  std::unordered_map<int64_t, size_t> candidates;
+  for (const auto& key_counts : partial_counts) {
+    for (const auto& key_count : key_counts) {
+      if (key_count.val >= partial_threshold) {
+        candidates.emplace(key_count.key, 0);
+      }
+    }
+  }
+  for (const auto& key_counts : partial_counts) {
+    for (const auto& key_count : key_counts) {
+      const auto it = candidates.find(key_count.key);
+      if (it != candidates.end()) {
+        it->second += key_count.val;
+      }
+    }
+  }
+  std::vector<SpeculativeTopNEntry> top_groups;
+  for (const auto& kv : candidates) {
+    top_groups.push_back({kv.first, kv.second, false});
+  }
+  const auto num_rows = std::min(top_n, top_groups.size());
+  std::partial_sort(top_groups.begin(),
+                    top_groups.begin() + num_rows,
+                    top_groups.end(),
+                    std::greater<SpeculativeTopNEntry>());
+  top_groups.resize(num_rows);
+  return top_groups;
+}
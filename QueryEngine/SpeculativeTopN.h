@@ -93,4 +93,25 @@ class SpeculativeTopNBlacklist {
 
 bool use_speculative_top_n(const RelAlgExecutionUnit&, const QueryMemoryDescriptor&);
 
+// Rows of the first num_rows entries, with the layout of the speculative top N results.
+std::shared_ptr<ResultSet> top_n_entries_to_rows(
+    const std::vector<SpeculativeTopNEntry>& entries,
+    const size_t num_rows,
+    const RelAlgExecutionUnit& ra_exe_unit,
+    std::shared_ptr<RowSetMemoryOwner> row_set_mem_owner,
+    const QueryMemoryDescriptor& query_mem_desc,
+    const Executor* executor);
+
+// Whether the query keeps the groups with the highest COUNT(*) only, like
+// SELECT key, COUNT(*) AS n FROM t GROUP BY key ORDER BY n DESC LIMIT 10.
+bool use_top_count_pruning(const RelAlgExecutionUnit&, const QueryMemoryDescriptor&);
+
+// The top_n groups with the highest counts, exact and in order, from the partial
+// results of the devices. Only the groups which may be in the top, by a threshold from
+// the top counts of every partial result, are summed across them.
+std::vector<SpeculativeTopNEntry> get_top_count_groups(
+    const std::vector<std::shared_ptr<ResultSet>>& partial_results,
+    const std::vector<Analyzer::Expr*>& target_exprs,
+    const size_t top_n);
+
 #endif  // QUERYENGINE_SPECULATIVETOPN_H
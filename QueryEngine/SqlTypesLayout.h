@@ -49,8 +49,14 @@ inline const SQLTypeInfo& get_compact_type(const TargetInfo& target) {
     return target.sql_type;
   }
 
-  return (agg_type != kCOUNT && agg_type != kAPPROX_COUNT_DISTINCT) ? agg_arg
-                                                                    : target.sql_type;
+  if (agg_type == kAPPROX_COUNT_DISTINCT_SKETCH || agg_type == kAPPROX_QUANTILE) {
+    // the slot holds the handle of the registers or of the counts, the value is built
+    // from them
+    static const SQLTypeInfo sketch_handle_ti(kBIGINT, false);
+    return sketch_handle_ti;
+  }
+  return (agg_type != kCOUNT && !is_approx_count_distinct(agg_type)) ? agg_arg
+                                                                     : target.sql_type;
 }
 
 template <typename T>
@@ -117,7 +123,9 @@ inline int64_t inline_int_null_val(const SQLTypeInfo& ti) {
 }
 
 inline int64_t inline_fixed_encoding_null_val(const SQLTypeInfo& ti) {
-  if (ti.get_compression() == kENCODING_NONE) {
+  // Values of DIFF encoded columns are only narrowed by the encoder, relative to the
+  // frame of the chunk.
+  if (ti.get_compression() == kENCODING_NONE || ti.get_compression() == kENCODING_DIFF) {
     return inline_int_null_val(ti);
   }
   if (ti.get_compression() == kENCODING_DICT) {
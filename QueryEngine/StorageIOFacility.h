@@ -206,8 +206,19 @@ StorageIOFacility<EXECUTOR_TRAITS, IO_FACET, FRAGMENT_UPDATER>::yieldUpdateCallb
     if (rows_per_column == 0)
       return;
 
+    auto const column_count = update_parameters.getUpdateColumnCount();
     OffsetVector column_offsets(rows_per_column);
-    ScalarTargetValueVector scalar_target_values(rows_per_column);
+    std::vector<ScalarTargetValueVector> column_values(
+        column_count, ScalarTargetValueVector(rows_per_column));
+    std::vector<bool> is_string_column(column_count);
+    bool has_string_column{false};
+    bool has_non_string_column{false};
+    for (decltype(column_count) column_index = 0; column_index < column_count;
+         column_index++) {
+      is_string_column[column_index] = update_log.getColumnType(column_index).is_string();
+      has_string_column |= is_string_column[column_index];
+      has_non_string_column |= !is_string_column[column_index];
+    }
 
     auto complete_row_block_size = rows_per_column / normalized_cpu_threads();
     auto partial_row_block_size = rows_per_column % normalized_cpu_threads();
@@ -218,50 +229,51 @@ StorageIOFacility<EXECUTOR_TRAITS, IO_FACET, FRAGMENT_UPDATER>::yieldUpdateCallb
       usable_threads = 1;
     }
 
-    auto string_process_rows =
-        [&update_log, &update_parameters, &column_offsets, &scalar_target_values](
-            uint64_t column_index, uint64_t row_start, uint64_t row_count) -> uint64_t {
-      uint64_t rows_processed = 0;
-      for (uint64_t row_index = row_start; row_index < (row_start + row_count);
-           row_index++, rows_processed++) {
-        auto const row(update_log.getTranslatedEntryAt(row_index));
-
-        CHECK(!row.empty());
-        CHECK(row.size() == update_parameters.getUpdateColumnCount() + 1);
-
-        auto terminal_column_iter = std::prev(row.end());
-        const auto frag_offset_scalar_tv =
-            boost::get<ScalarTargetValue>(&*terminal_column_iter);
-        CHECK(frag_offset_scalar_tv);
-
-        column_offsets[row_index] =
-            static_cast<uint64_t>(*(boost::get<int64_t>(frag_offset_scalar_tv)));
-        scalar_target_values[row_index] =
-            boost::get<ScalarTargetValue>(row[column_index]);
+    auto gather_row = [&update_parameters, &column_offsets, &column_values, column_count](
+                          std::vector<TargetValue> const& row,
+                          uint64_t row_index,
+                          std::vector<bool> const& column_mask,
+                          bool const column_mask_value) {
+      CHECK(!row.empty());
+      CHECK(row.size() == update_parameters.getUpdateColumnCount() + 1);
+
+      auto terminal_column_iter = std::prev(row.end());
+      const auto frag_offset_scalar_tv =
+          boost::get<ScalarTargetValue>(&*terminal_column_iter);
+      CHECK(frag_offset_scalar_tv);
+
+      column_offsets[row_index] =
+          static_cast<uint64_t>(*(boost::get<int64_t>(frag_offset_scalar_tv)));
+      for (decltype(column_count) column_index = 0; column_index < column_count;
+           column_index++) {
+        if (column_mask[column_index] == column_mask_value) {
+          column_values[column_index][row_index] =
+              boost::get<ScalarTargetValue>(row[column_index]);
+        }
       }
-      return rows_processed;
     };
 
-    auto process_rows =
-        [&update_log, &update_parameters, &column_offsets, &scalar_target_values](
-            uint64_t column_index, uint64_t row_start, uint64_t row_count) -> uint64_t {
+    // A row is decoded once for all the updated columns, string columns read it again
+    // with their dictionary ids translated.
+    auto process_rows = [&update_log,
+                         &is_string_column,
+                         has_string_column,
+                         has_non_string_column,
+                         &gather_row](uint64_t row_start,
+                                      uint64_t row_count) -> uint64_t {
       uint64_t rows_processed = 0;
       for (uint64_t row_index = row_start; row_index < (row_start + row_count);
            row_index++, rows_processed++) {
-        auto const row(update_log.getEntryAt(row_index));
-
-        CHECK(!row.empty());
-        CHECK(row.size() == update_parameters.getUpdateColumnCount() + 1);
-
-        auto terminal_column_iter = std::prev(row.end());
-        const auto frag_offset_scalar_tv =
-            boost::get<ScalarTargetValue>(&*terminal_column_iter);
-        CHECK(frag_offset_scalar_tv);
-
-        column_offsets[row_index] =
-            static_cast<uint64_t>(*(boost::get<int64_t>(frag_offset_scalar_tv)));
-        scalar_target_values[row_index] =
-            boost::get<ScalarTargetValue>(row[column_index]);
+        if (has_non_string_column) {
+          gather_row(
+              update_log.getEntryAt(row_index), row_index, is_string_column, false);
+        }
+        if (has_string_column) {
+          gather_row(update_log.getTranslatedEntryAt(row_index),
+                     row_index,
+                     is_string_column,
+                     true);
+        }
       }
       return rows_processed;
     };
@@ -269,60 +281,38 @@ StorageIOFacility<EXECUTOR_TRAITS, IO_FACET, FRAGMENT_UPDATER>::yieldUpdateCallb
     auto get_row_index = [complete_row_block_size](uint64_t thread_index) -> uint64_t {
       return (thread_index * complete_row_block_size);
     };
-    // Iterate over each column
-    for (decltype(update_parameters.getUpdateColumnCount()) column_index = 0;
-         column_index < update_parameters.getUpdateColumnCount();
-         column_index++) {
-      RowProcessingFuturesVector row_processing_futures;
-      row_processing_futures.reserve(usable_threads);
-
-      if (!update_log.getColumnType(column_index)
-               .is_string()) {  // Process non-string columns
-        for (unsigned i = 0; i < static_cast<unsigned>(usable_threads); i++)
-          row_processing_futures.emplace_back(
-              std::async(std::launch::async,
-                         std::forward<decltype(process_rows)>(process_rows),
-                         column_index,
-                         get_row_index(i),
-                         complete_row_block_size));
-        if (partial_row_block_size) {
-          row_processing_futures.emplace_back(
-              std::async(std::launch::async,
-                         std::forward<decltype(process_rows)>(process_rows),
-                         column_index,
-                         get_row_index(usable_threads),
-                         partial_row_block_size));
-        }
-      } else {  // Process string columns
-        for (unsigned i = 0; i < (unsigned)usable_threads; i++)
-          row_processing_futures.emplace_back(
-              std::async(std::launch::async,
-                         std::forward<decltype(string_process_rows)>(string_process_rows),
-                         column_index,
-                         get_row_index(i),
-                         complete_row_block_size));
-        if (partial_row_block_size) {
-          row_processing_futures.emplace_back(
-              std::async(std::launch::async,
-                         std::forward<decltype(string_process_rows)>(string_process_rows),
-                         column_index,
-                         get_row_index(usable_threads),
-                         partial_row_block_size));
-        }
-      }
 
-      uint64_t rows_processed(0);
-      for (auto& t : row_processing_futures) {
-        t.wait();
-        rows_processed += t.get();
-      }
+    RowProcessingFuturesVector row_processing_futures;
+    row_processing_futures.reserve(usable_threads);
+    for (unsigned i = 0; i < static_cast<unsigned>(usable_threads); i++)
+      row_processing_futures.emplace_back(
+          std::async(std::launch::async,
+                     std::forward<decltype(process_rows)>(process_rows),
+                     get_row_index(i),
+                     complete_row_block_size));
+    if (partial_row_block_size) {
+      row_processing_futures.emplace_back(
+          std::async(std::launch::async,
+                     std::forward<decltype(process_rows)>(process_rows),
+                     get_row_index(usable_threads),
+                     partial_row_block_size));
+    }
+
+    uint64_t rows_processed(0);
+    for (auto& t : row_processing_futures) {
+      t.wait();
+      rows_processed += t.get();
+    }
 
+    // Iterate over each column, the values of a column are written in parallel
+    for (decltype(column_count) column_index = 0; column_index < column_count;
+         column_index++) {
       IOFacility::updateColumn(catalog_,
                                update_log.getPhysicalTableId(),
                                update_parameters.getUpdateColumnNames()[column_index],
                                update_log.getFragmentId(),
                                column_offsets,
-                               scalar_target_values,
+                               column_values[column_index],
                                update_log.getColumnType(column_index),
                                update_parameters.getTransactionTracker());
     }
@@ -52,9 +52,60 @@ extern "C" int32_t string_compress(const int64_t ptr_and_len,
   return string_dict_proxy->getIdOfString(raw_str);
 }
 
+// Decodes a dictionary-encoded string cast to none-encoded for a consumer on the GPU,
+// using the copy of the dictionary there. Returns the packed pointer and length, the
+// pointer and the length, or nothing if the string has to be decoded on the host. The
+// pointer is in the device memory, the strings must not end up in the results.
+std::vector<llvm::Value*> Executor::codegenDeviceStringDecode(
+    const Analyzer::Expr* expr,
+    const CompilationOptions& co) {
+  if (!g_enable_gpu_string_dictionaries || g_cluster ||
+      co.device_type_ != ExecutorDeviceType::GPU || !co.hoist_literals_) {
+    return {};
+  }
+  const auto cast_oper = dynamic_cast<const Analyzer::UOper*>(expr);
+  if (!cast_oper || cast_oper->get_optype() != kCAST) {
+    return {};
+  }
+  const auto& ti = cast_oper->get_type_info();
+  const auto operand = cast_oper->get_operand();
+  const auto& operand_ti = operand->get_type_info();
+  if (!ti.is_string() || ti.get_compression() != kENCODING_NONE ||
+      !operand_ti.is_string() || operand_ti.get_compression() != kENCODING_DICT ||
+      operand_ti.get_comp_param() <= 0) {
+    return {};
+  }
+  const auto dict_buffers = getGpuStringDictionaryBuffers(operand_ti.get_comp_param());
+  if (dict_buffers.empty()) {
+    return {};
+  }
+  // The address differs between the devices, hoisted literals can be set per device.
+  std::vector<std::shared_ptr<Analyzer::Constant>> dict_buffer_constants;
+  std::vector<const Analyzer::Constant*> dict_buffer_constant_ptrs;
+  for (const auto dict_buffer : dict_buffers) {
+    Datum d;
+    d.bigintval = dict_buffer;
+    dict_buffer_constants.push_back(
+        makeExpr<Analyzer::Constant>(SQLTypeInfo(kBIGINT, true), false, d));
+    dict_buffer_constant_ptrs.push_back(dict_buffer_constants.back().get());
+  }
+  const auto dict_buffer_lv =
+      codegenHoistedConstants(dict_buffer_constant_ptrs, kENCODING_NONE, 0).front();
+  const auto string_id_lv = codegen(operand, true, co).front();
+  CHECK(string_id_lv->getType()->isIntegerTy(32));
+  const auto str_lv =
+      cgen_state_->emitCall("string_decompress_gpu", {string_id_lv, dict_buffer_lv});
+  return {str_lv,
+          cgen_state_->emitCall("extract_str_ptr", {str_lv}),
+          cgen_state_->emitCall("extract_str_len", {str_lv})};
+}
+
 llvm::Value* Executor::codegen(const Analyzer::CharLengthExpr* expr,
                                const CompilationOptions& co) {
-  auto str_lv = codegen(expr->get_arg(), true, co);
+  auto str_lv = codegenDeviceStringDecode(expr->get_arg(), co);
+  if (str_lv.empty()) {
+    str_lv = codegen(expr->get_arg(), true, co);
+  }
   if (str_lv.size() != 3) {
     CHECK_EQ(size_t(1), str_lv.size());
     if (g_enable_watchdog) {
@@ -83,6 +134,48 @@ llvm::Value* Executor::codegen(const Analyzer::CharLengthExpr* expr,
              : cgen_state_->emitCall(fn_name, charlength_args);
 }
 
+namespace {
+
+// Compiles a LIKE pattern for string_like_compiled, see Utils/StringLike.cpp for the
+// layout. Returns an empty string for the patterns it doesn't handle, character classes
+// and malformed escapes, which are left to string_like.
+std::string compile_like_pattern(const std::string& pattern, const char escape_char) {
+  std::vector<std::string> segments(1);
+  std::vector<std::string> masks(1);
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    char c = pattern[i];
+    bool any_char{false};
+    if (c == escape_char) {
+      if (++i == pattern.size()) {
+        return "";
+      }
+      c = pattern[i];
+    } else if (c == '%') {
+      segments.emplace_back();
+      masks.emplace_back();
+      continue;
+    } else if (c == '[') {
+      return "";
+    } else {
+      any_char = c == '_';
+    }
+    segments.back().push_back(c);
+    masks.back().push_back(any_char ? 1 : 0);
+  }
+  std::string program;
+  for (size_t i = 0; i < segments.size(); ++i) {
+    const auto len = segments[i].size();
+    program.push_back(static_cast<char>(len & 0xff));
+    program.push_back(static_cast<char>(len >> 8));
+    program += segments[i];
+    program += masks[i];
+  }
+  // Literal strings have a 16-bit length.
+  return program.size() <= 0x7fff ? program : "";
+}
+
+}  // namespace
+
 llvm::Value* Executor::codegen(const Analyzer::LikeExpr* expr,
                                const CompilationOptions& co) {
   if (is_unnest(extract_cast_arg(expr->get_arg()))) {
@@ -115,7 +208,10 @@ llvm::Value* Executor::codegen(const Analyzer::LikeExpr* expr,
         "Cannot do LIKE / ILIKE on this dictionary encoded column, its cardinality is "
         "too high");
   }
-  auto str_lv = codegen(expr->get_arg(), true, co);
+  auto str_lv = codegenDeviceStringDecode(expr->get_arg(), co);
+  if (str_lv.empty()) {
+    str_lv = codegen(expr->get_arg(), true, co);
+  }
   if (str_lv.size() != 3) {
     CHECK_EQ(size_t(1), str_lv.size());
     str_lv.push_back(cgen_state_->emitCall("extract_str_ptr", {str_lv.front()}));
@@ -124,7 +220,20 @@ llvm::Value* Executor::codegen(const Analyzer::LikeExpr* expr,
       throw QueryMustRunOnCpu();
     }
   }
-  auto like_expr_arg_lvs = codegen(expr->get_like_expr(), true, co);
+  // Compile the pattern once here, the matching of the compiled form doesn't backtrack.
+  const auto program = expr->get_is_simple() || pattern->get_is_null()
+                           ? std::string()
+                           : compile_like_pattern(*pattern->get_constval().stringval,
+                                                  escape_char);
+  std::shared_ptr<Analyzer::Constant> program_expr;
+  if (!program.empty()) {
+    Datum program_datum;
+    program_datum.stringval = new std::string(program);
+    program_expr = makeExpr<Analyzer::Constant>(
+        pattern->get_type_info(), false, program_datum);
+  }
+  auto like_expr_arg_lvs = codegen(
+      program_expr ? program_expr.get() : expr->get_like_expr(), true, co);
   CHECK_EQ(size_t(3), like_expr_arg_lvs.size());
   const bool is_nullable{!expr->get_arg()->get_type_info().get_notnull()};
   std::vector<llvm::Value*> str_like_args{
@@ -132,6 +241,8 @@ llvm::Value* Executor::codegen(const Analyzer::LikeExpr* expr,
   std::string fn_name{expr->get_is_ilike() ? "string_ilike" : "string_like"};
   if (expr->get_is_simple()) {
     fn_name += "_simple";
+  } else if (program_expr) {
+    fn_name += "_compiled";
   } else {
     str_like_args.push_back(ll_int(int8_t(escape_char)));
   }
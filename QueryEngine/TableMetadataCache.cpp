@@ -0,0 +1,151 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TableMetadataCache.h"
+#include "Execute.h"
+
+#include "../Catalog/Catalog.h"
+
+std::map<std::pair<int, int>, TableMetadataCache::Entry> TableMetadataCache::entries_;
+std::mutex TableMetadataCache::mutex_;
+
+namespace {
+
+Fragmenter_Namespace::TableInfo build_table_info(
+    const std::vector<const TableDescriptor*>& shard_tables) {
+  size_t total_number_of_tuples{0};
+  Fragmenter_Namespace::TableInfo table_info_all_shards;
+  for (const TableDescriptor* shard_table : shard_tables) {
+    CHECK(shard_table->fragmenter);
+    const auto& shard_metainfo = shard_table->fragmenter->getFragmentsForQuery();
+    total_number_of_tuples += shard_metainfo.getPhysicalNumTuples();
+    table_info_all_shards.fragments.insert(table_info_all_shards.fragments.end(),
+                                           shard_metainfo.fragments.begin(),
+                                           shard_metainfo.fragments.end());
+  }
+  table_info_all_shards.setPhysicalNumTuples(total_number_of_tuples);
+  return table_info_all_shards;
+}
+
+std::vector<size_t> get_generations(
+    const std::vector<const TableDescriptor*>& shard_tables) {
+  std::vector<size_t> generations;
+  for (const auto shard_table : shard_tables) {
+    CHECK(shard_table->fragmenter);
+    generations.push_back(shard_table->fragmenter->getGeneration());
+  }
+  return generations;
+}
+
+}  // namespace
+
+std::vector<size_t> TableMetadataCache::getGenerations(
+    const Catalog_Namespace::Catalog& cat,
+    const int table_id) {
+  const auto td = cat.getMetadataForTable(table_id);
+  CHECK(td);
+  return get_generations(cat.getPhysicalTablesDescriptors(td));
+}
+
+std::shared_ptr<const Fragmenter_Namespace::TableInfo> TableMetadataCache::getTableInfo(
+    const Catalog_Namespace::Catalog& cat,
+    const int table_id) {
+  const auto td = cat.getMetadataForTable(table_id);
+  CHECK(td);
+  const auto shard_tables = cat.getPhysicalTablesDescriptors(td);
+  if (!g_enable_table_metadata_cache) {
+    return std::make_shared<const Fragmenter_Namespace::TableInfo>(
+        build_table_info(shard_tables));
+  }
+  // Read before the fragments: a change in between is cached under the generations
+  // preceding it, never the other way around.
+  const auto generations = get_generations(shard_tables);
+  const auto key = std::make_pair(cat.get_currentDB().dbId, table_id);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(key);
+    if (it != entries_.end() && it->second.generations == generations) {
+      return it->second.table_info;
+    }
+  }
+  auto table_info = std::make_shared<const Fragmenter_Namespace::TableInfo>(
+      build_table_info(shard_tables));
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& entry = entries_[key];
+  if (entry.table_info && entry.generations == generations) {
+    return entry.table_info;
+  }
+  entry = Entry{generations, table_info, {}};
+  return table_info;
+}
+
+boost::optional<ExpressionRange> TableMetadataCache::getColRange(
+    const int db_id,
+    const PhysicalInput& phys_input,
+    const Fragmenter_Namespace::TableInfo* table_info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(std::make_pair(db_id, phys_input.table_id));
+  if (it == entries_.end() || it->second.table_info.get() != table_info) {
+    return boost::none;
+  }
+  const auto& col_ranges = it->second.col_ranges;
+  const auto col_range_it = col_ranges.find(phys_input.col_id);
+  if (col_range_it == col_ranges.end()) {
+    return boost::none;
+  }
+  return col_range_it->second;
+}
+
+void TableMetadataCache::putColRange(const int db_id,
+                                     const PhysicalInput& phys_input,
+                                     const Fragmenter_Namespace::TableInfo* table_info,
+                                     const ExpressionRange& col_range) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(std::make_pair(db_id, phys_input.table_id));
+  if (it == entries_.end() || it->second.table_info.get() != table_info) {
+    return;
+  }
+  it->second.col_ranges.emplace(phys_input.col_id, col_range);
+}
+
+std::shared_ptr<const FragmentRangeIndex> TableMetadataCache::getFragmentRangeIndex(
+    const int db_id,
+    const PhysicalInput& phys_input,
+    const SQLTypeInfo& col_ti,
+    const Fragmenter_Namespace::TableInfo* table_info) {
+  const auto key = std::make_pair(db_id, phys_input.table_id);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.table_info.get() != table_info) {
+      return nullptr;
+    }
+    const auto& range_indexes = it->second.range_indexes;
+    const auto index_it = range_indexes.find(phys_input.col_id);
+    if (index_it != range_indexes.end()) {
+      return index_it->second;
+    }
+  }
+  // Built without the lock, the caller holds the fragments.
+  auto index = std::make_shared<const FragmentRangeIndex>(
+      table_info->fragments, phys_input.col_id, col_ti);
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = entries_.find(key);
+  if (it != entries_.end() && it->second.table_info.get() == table_info) {
+    return it->second.range_indexes.emplace(phys_input.col_id, index).first->second;
+  }
+  return index;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    TableMetadataCache.h
+ * @brief   Fragments and column ranges of the tables, shared across queries.
+ *
+ * Every query used to copy the fragments of the tables it reads from the fragmenters and
+ * to walk their metadata for the range of each column, which costs more than a selective
+ * query on tables with many fragments. Both are kept until one of the fragmenters of the
+ * table moves on to another generation, which inserts, updates and deletes all do. The
+ * range indexes the fragment skipping finds its candidate fragments with are kept the
+ * same way.
+ */
+
+#ifndef QUERYENGINE_TABLEMETADATACACHE_H
+#define QUERYENGINE_TABLEMETADATACACHE_H
+
+#include "ExpressionRange.h"
+#include "FragmentRangeIndex.h"
+#include "QueryPhysicalInputsCollector.h"
+
+#include "../Fragmenter/Fragmenter.h"
+
+#include <boost/optional.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Catalog_Namespace {
+class Catalog;
+}  // namespace Catalog_Namespace
+
+class TableMetadataCache {
+ public:
+  // The fragments of all the shards of the table. Queries which got the same pointer
+  // read the same generation of the table.
+  static std::shared_ptr<const Fragmenter_Namespace::TableInfo> getTableInfo(
+      const Catalog_Namespace::Catalog& cat,
+      const int table_id);
+
+  // The generations of the shards of the table, in the order of the physical tables.
+  // The caches of things built from the data of the table key their entries with them.
+  static std::vector<size_t> getGenerations(const Catalog_Namespace::Catalog& cat,
+                                            const int table_id);
+
+  // The range of the column computed from the fragments got above, if any.
+  static boost::optional<ExpressionRange> getColRange(
+      const int db_id,
+      const PhysicalInput& phys_input,
+      const Fragmenter_Namespace::TableInfo* table_info);
+
+  // Dropped if the table has moved on to another generation in the meantime.
+  static void putColRange(const int db_id,
+                          const PhysicalInput& phys_input,
+                          const Fragmenter_Namespace::TableInfo* table_info,
+                          const ExpressionRange& col_range);
+
+  // The index of the integer column over the fragments got above, built on the first
+  // request. Null if the fragments aren't the ones in the cache.
+  static std::shared_ptr<const FragmentRangeIndex> getFragmentRangeIndex(
+      const int db_id,
+      const PhysicalInput& phys_input,
+      const SQLTypeInfo& col_ti,
+      const Fragmenter_Namespace::TableInfo* table_info);
+
+  static auto yieldCacheInvalidator() -> std::function<void()> {
+    return []() -> void {
+      std::lock_guard<std::mutex> lock(mutex_);
+      entries_.clear();
+    };
+  }
+
+ private:
+  struct Entry {
+    // Of the shards, in the order of the physical tables.
+    std::vector<size_t> generations;
+    std::shared_ptr<const Fragmenter_Namespace::TableInfo> table_info;
+    std::unordered_map<int, ExpressionRange> col_ranges;
+    std::unordered_map<int, std::shared_ptr<const FragmentRangeIndex>> range_indexes;
+  };
+
+  // Keyed by database and table id.
+  static std::map<std::pair<int, int>, Entry> entries_;
+  static std::mutex mutex_;
+};
+
+#endif  // QUERYENGINE_TABLEMETADATACACHE_H
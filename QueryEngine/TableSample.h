@@ -0,0 +1,47 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    TableSample.h
+ * @brief   Selection of the rows of a TABLESAMPLE clause.
+ *
+ * The rows are sampled by blocks of consecutive row ids: a single row for BERNOULLI, a
+ * fragment for SYSTEM. A block is in the sample if the hash of its index is, which makes
+ * the sample the same for every query and device, and lets the fragments out of it be
+ * skipped before their columns are fetched.
+ */
+
+#ifndef QUERYENGINE_TABLESAMPLE_H
+#define QUERYENGINE_TABLESAMPLE_H
+
+#include "../Shared/funcannotations.h"
+
+#include <cstdint>
+
+DEVICE inline bool table_sample_block_selected(const int64_t block,
+                                               const double proportion,
+                                               const int64_t seed) {
+  // splitmix64 finalizer, the seed picks another sequence of blocks
+  uint64_t h = static_cast<uint64_t>(block) +
+               static_cast<uint64_t>(seed) * 0x9E3779B97F4A7C15ULL;
+  h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  // the top 53 bits, uniform in [0, 1)
+  return (h >> 11) * (1.0 / 9007199254740992.0) < proportion;
+}
+
+#endif  // QUERYENGINE_TABLESAMPLE_H
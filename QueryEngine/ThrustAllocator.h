@@ -26,6 +26,7 @@
 #define THRUSTALLOCATOR_H
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace Data_Namespace {
@@ -55,6 +56,8 @@ class ThrustAllocator {
   typedef std::unordered_map<int8_t*, Data_Namespace::AbstractBuffer*> PtrMapperType;
   PtrMapperType raw_to_ab_ptr_;
   std::vector<Data_Namespace::AbstractBuffer*> scoped_buffers_;
+  std::unordered_set<int8_t*> scratch_ptrs_;  // from the scratch pool of the device
+  std::vector<int8_t*> scoped_scratch_ptrs_;
   std::vector<int8_t*> default_alloc_scoped_buffers_;  // for unit tests only
 };
 
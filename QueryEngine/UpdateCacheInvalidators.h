@@ -5,10 +5,26 @@
 
 // Classes that are involved in needing a cache invalidated when there is an update
 #include "BaselineJoinHashTable.h"
+#include "ColumnarResultsCache.h"
+#include "GroupByBufferPool.h"
+#include "InValuesHashSet.h"
 #include "JoinHashTable.h"
+#include "QueryResultCache.h"
+#include "TableMetadataCache.h"
 
-using UpdateTriggeredCacheInvalidator =
-    CacheInvalidator<BaselineJoinHashTable, JoinHashTable>;
+using UpdateTriggeredCacheInvalidator = CacheInvalidator<BaselineJoinHashTable,
+                                                         JoinHashTable,
+                                                         QueryResultCache,
+                                                         ColumnarResultsCache,
+                                                         TableMetadataCache>;
 using DeleteTriggeredCacheInvalidator = UpdateTriggeredCacheInvalidator;
+// Releases the host memory of the caches living outside of the buffer pool.
+using HostMemoryCacheInvalidator = CacheInvalidator<BaselineJoinHashTable,
+                                                    JoinHashTable,
+                                                    QueryResultCache,
+                                                    ColumnarResultsCache,
+                                                    TableMetadataCache,
+                                                    GroupByBufferPool,
+                                                    InValuesHashSet>;
 
 #endif
@@ -0,0 +1,465 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowContext.h"
+#include "SqlTypesLayout.h"
+#include "TypePunning.h"
+
+#include "../Shared/thread_count.h"
+
+#include <boost/functional/hash.hpp>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+
+namespace {
+
+// Don't bother spawning threads for fewer rows than this.
+constexpr size_t kMinRowsPerThread{64 * 1024};
+
+int64_t double_to_slot(const double val) {
+  return *reinterpret_cast<const int64_t*>(may_alias_ptr(&val));
+}
+
+int64_t null_slot(const SQLTypeInfo& ti) {
+  return ti.is_fp() ? double_to_slot(inline_fp_null_val(ti)) : inline_int_null_val(ti);
+}
+
+int64_t int_to_slot(const int64_t val, const SQLTypeInfo& ti) {
+  return ti.is_fp() ? double_to_slot(static_cast<double>(val)) : val;
+}
+
+int64_t fp_to_slot(const double val, const SQLTypeInfo& ti) {
+  return ti.is_fp() ? double_to_slot(val) : static_cast<int64_t>(val);
+}
+
+int64_t value_to_slot(const WindowColumn* column,
+                      const size_t row,
+                      const SQLTypeInfo& ti) {
+  if (column->isNull(row)) {
+    return null_slot(ti);
+  }
+  return column->ti.is_fp() ? fp_to_slot(column->getDouble(row), ti)
+                            : int_to_slot(column->values[row], ti);
+}
+
+// Calls func(begin, end) on consecutive ranges which cover [0, count), in parallel.
+template <class FUNC>
+void parallel_for_ranges(const size_t count, const size_t min_range_size, FUNC func) {
+  const size_t range_count = std::max(
+      std::min(static_cast<size_t>(cpu_threads()), count / min_range_size), size_t(1));
+  if (range_count == 1) {
+    func(0, count);
+    return;
+  }
+  const size_t stride = (count + range_count - 1) / range_count;
+  std::vector<std::future<void>> workers;
+  for (size_t begin = 0; begin < count; begin += stride) {
+    workers.emplace_back(
+        std::async(std::launch::async, func, begin, std::min(begin + stride, count)));
+  }
+  for (auto& worker : workers) {
+    worker.wait();
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+}  // namespace
+
+bool WindowColumn::isNull(const size_t row) const {
+  if (ti.get_notnull()) {
+    return false;
+  }
+  if (ti.is_fp()) {
+    return getDouble(row) == inline_fp_null_val(ti);
+  }
+  return values[row] == inline_int_null_val(ti);
+}
+
+double WindowColumn::getDouble(const size_t row) const {
+  return *reinterpret_cast<const double*>(may_alias_ptr(&values[row]));
+}
+
+WindowPartitions::WindowPartitions(
+    const std::vector<const WindowColumn*>& partition_keys,
+    const std::vector<const WindowColumn*>& order_keys,
+    const std::vector<Analyzer::OrderEntry>& collation,
+    const size_t row_count)
+    : partition_keys_(partition_keys)
+    , order_keys_(order_keys)
+    , collation_(collation)
+    , permutation_(row_count) {
+  CHECK_EQ(order_keys_.size(), collation_.size());
+  if (partition_keys_.empty()) {
+    std::iota(permutation_.begin(), permutation_.end(), size_t(0));
+    if (!order_keys_.empty()) {
+      sortRange(0, row_count);
+    }
+    partition_offsets_ = {0, row_count};
+    return;
+  }
+  // Hash partition the rows into as many buckets as threads, keeping the row order.
+  const size_t bucket_count = cpu_threads();
+  std::vector<size_t> buckets(row_count);
+  parallel_for_ranges(
+      row_count, kMinRowsPerThread, [&](const size_t begin, const size_t end) {
+        for (size_t row = begin; row < end; ++row) {
+          size_t hash{0};
+          for (const auto partition_key : partition_keys_) {
+            boost::hash_combine(hash, partition_key->values[row]);
+          }
+          buckets[row] = hash % bucket_count;
+        }
+      });
+  std::vector<size_t> bucket_offsets(bucket_count + 1, 0);
+  for (const auto bucket : buckets) {
+    ++bucket_offsets[bucket + 1];
+  }
+  std::partial_sum(bucket_offsets.begin(), bucket_offsets.end(), bucket_offsets.begin());
+  std::vector<size_t> bucket_positions(bucket_offsets.begin(), bucket_offsets.end() - 1);
+  for (size_t row = 0; row < row_count; ++row) {
+    permutation_[bucket_positions[buckets[row]]++] = row;
+  }
+  // Sorting a bucket on all the keys makes each of its partitions contiguous and ordered.
+  std::vector<std::vector<size_t>> bucket_partition_offsets(bucket_count);
+  parallel_for_ranges(bucket_count, 1, [&](const size_t first, const size_t last) {
+    for (size_t bucket = first; bucket < last; ++bucket) {
+      const auto begin = bucket_offsets[bucket];
+      const auto end = bucket_offsets[bucket + 1];
+      std::sort(permutation_.begin() + begin,
+                permutation_.begin() + end,
+                [this](const size_t lhs, const size_t rhs) {
+                  return lessThan(lhs, rhs);
+                });
+      auto& partition_offsets = bucket_partition_offsets[bucket];
+      for (size_t pos = begin; pos < end; ++pos) {
+        if (pos == begin || !samePartition(permutation_[pos - 1], permutation_[pos])) {
+          partition_offsets.push_back(pos);
+        }
+      }
+    }
+  });
+  for (const auto& partition_offsets : bucket_partition_offsets) {
+    partition_offsets_.insert(
+        partition_offsets_.end(), partition_offsets.begin(), partition_offsets.end());
+  }
+  partition_offsets_.push_back(row_count);
+}
+
+bool WindowPartitions::arePeers(const size_t lhs_pos, const size_t rhs_pos) const {
+  const auto lhs_row = permutation_[lhs_pos];
+  const auto rhs_row = permutation_[rhs_pos];
+  for (const auto order_key : order_keys_) {
+    const bool lhs_null = order_key->isNull(lhs_row);
+    const bool rhs_null = order_key->isNull(rhs_row);
+    if (lhs_null != rhs_null ||
+        (!lhs_null && order_key->values[lhs_row] != order_key->values[rhs_row])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool WindowPartitions::lessThan(const size_t lhs_row, const size_t rhs_row) const {
+  // Partitions only need to be grouped, compare the slots as they are.
+  for (const auto partition_key : partition_keys_) {
+    const auto lhs_val = partition_key->values[lhs_row];
+    const auto rhs_val = partition_key->values[rhs_row];
+    if (lhs_val != rhs_val) {
+      return lhs_val < rhs_val;
+    }
+  }
+  for (size_t i = 0; i < order_keys_.size(); ++i) {
+    const auto order_key = order_keys_[i];
+    const auto& order_entry = collation_[i];
+    const bool lhs_null = order_key->isNull(lhs_row);
+    const bool rhs_null = order_key->isNull(rhs_row);
+    if (lhs_null || rhs_null) {
+      if (lhs_null && rhs_null) {
+        continue;
+      }
+      return lhs_null == order_entry.nulls_first;
+    }
+    if (order_key->ti.is_fp()) {
+      const auto lhs_val = order_key->getDouble(lhs_row);
+      const auto rhs_val = order_key->getDouble(rhs_row);
+      if (lhs_val != rhs_val) {
+        return order_entry.is_desc ? lhs_val > rhs_val : lhs_val < rhs_val;
+      }
+    } else {
+      const auto lhs_val = order_key->values[lhs_row];
+      const auto rhs_val = order_key->values[rhs_row];
+      if (lhs_val != rhs_val) {
+        return order_entry.is_desc ? lhs_val > rhs_val : lhs_val < rhs_val;
+      }
+    }
+  }
+  // Keep the sort deterministic for peers.
+  return lhs_row < rhs_row;
+}
+
+bool WindowPartitions::samePartition(const size_t lhs_row, const size_t rhs_row) const {
+  for (const auto partition_key : partition_keys_) {
+    if (partition_key->values[lhs_row] != partition_key->values[rhs_row]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sorts a single partition: the chunks are sorted in parallel, then merged pairwise.
+void WindowPartitions::sortRange(const size_t begin, const size_t end) {
+  const auto comparator = [this](const size_t lhs, const size_t rhs) {
+    return lessThan(lhs, rhs);
+  };
+  const size_t chunk_count =
+      std::max(std::min(static_cast<size_t>(cpu_threads()),
+                        (end - begin) / kMinRowsPerThread),
+               size_t(1));
+  std::vector<size_t> chunk_offsets;
+  for (size_t i = 0; i <= chunk_count; ++i) {
+    chunk_offsets.push_back(begin + (end - begin) * i / chunk_count);
+  }
+  parallel_for_ranges(chunk_count, 1, [&](const size_t first, const size_t last) {
+    for (size_t chunk = first; chunk < last; ++chunk) {
+      std::sort(permutation_.begin() + chunk_offsets[chunk],
+                permutation_.begin() + chunk_offsets[chunk + 1],
+                comparator);
+    }
+  });
+  while (chunk_offsets.size() > 2) {
+    std::vector<size_t> merged_offsets;
+    std::vector<std::future<void>> mergers;
+    for (size_t i = 0; i + 2 < chunk_offsets.size(); i += 2) {
+      const auto first = chunk_offsets[i];
+      const auto middle = chunk_offsets[i + 1];
+      const auto last = chunk_offsets[i + 2];
+      mergers.emplace_back(
+          std::async(std::launch::async, [this, first, middle, last, &comparator] {
+            std::inplace_merge(permutation_.begin() + first,
+                               permutation_.begin() + middle,
+                               permutation_.begin() + last,
+                               comparator);
+          }));
+      merged_offsets.push_back(first);
+    }
+    if (chunk_offsets.size() % 2 == 0) {
+      // An odd number of chunks, the last one waits for the next round.
+      merged_offsets.push_back(chunk_offsets[chunk_offsets.size() - 2]);
+    }
+    merged_offsets.push_back(chunk_offsets.back());
+    for (auto& merger : mergers) {
+      merger.wait();
+    }
+    for (auto& merger : mergers) {
+      merger.get();
+    }
+    chunk_offsets.swap(merged_offsets);
+  }
+}
+
+namespace {
+
+// Computes the aggregates, with the frame from the start of the partition to either the
+// current row, the last of its peers or the end of the partition.
+void compute_partition_aggregate(const Analyzer::WindowFunction* window_func,
+                                 const std::vector<const WindowColumn*>& args,
+                                 const WindowPartitions& partitions,
+                                 const size_t begin,
+                                 const size_t end,
+                                 std::vector<int64_t>& output) {
+  const auto kind = window_func->getKind();
+  const auto& ti = window_func->get_type_info();
+  const auto& permutation = partitions.getPermutation();
+  const auto arg = args.empty() ? nullptr : args.front();
+  const bool fp_arg = arg && arg->ti.is_fp();
+  int64_t count{0};
+  int64_t int_acc{0};
+  double fp_acc{0};
+  for (size_t frame_begin = begin; frame_begin < end;) {
+    size_t frame_end = frame_begin + 1;
+    if (!window_func->isFrameToCurrentRow()) {
+      frame_end = end;
+    } else if (!window_func->isRows()) {
+      while (frame_end < end && partitions.arePeers(frame_begin, frame_end)) {
+        ++frame_end;
+      }
+    }
+    for (size_t pos = frame_begin; pos < frame_end; ++pos) {
+      const auto row = permutation[pos];
+      if (!arg) {
+        ++count;
+        continue;
+      }
+      if (kind == SqlWindowFunctionKind::LAST_VALUE || arg->isNull(row)) {
+        continue;
+      }
+      const bool first_value = !count;
+      ++count;
+      if (fp_arg) {
+        const auto val = arg->getDouble(row);
+        if (kind == SqlWindowFunctionKind::MIN) {
+          fp_acc = first_value ? val : std::min(fp_acc, val);
+        } else if (kind == SqlWindowFunctionKind::MAX) {
+          fp_acc = first_value ? val : std::max(fp_acc, val);
+        } else {
+          fp_acc += val;
+        }
+      } else {
+        const auto val = arg->values[row];
+        if (kind == SqlWindowFunctionKind::MIN) {
+          int_acc = first_value ? val : std::min(int_acc, val);
+        } else if (kind == SqlWindowFunctionKind::MAX) {
+          int_acc = first_value ? val : std::max(int_acc, val);
+        } else {
+          int_acc += val;
+        }
+      }
+    }
+    int64_t result{0};
+    switch (kind) {
+      case SqlWindowFunctionKind::LAST_VALUE: {
+        CHECK(arg);
+        result = value_to_slot(arg, permutation[frame_end - 1], ti);
+        break;
+      }
+      case SqlWindowFunctionKind::COUNT: {
+        result = int_to_slot(count, ti);
+        break;
+      }
+      case SqlWindowFunctionKind::AVG: {
+        const double sum = fp_arg ? fp_acc : static_cast<double>(int_acc);
+        result = count ? fp_to_slot(sum / count, ti) : null_slot(ti);
+        break;
+      }
+      case SqlWindowFunctionKind::SUM_INTERNAL: {
+        result = fp_arg ? fp_to_slot(fp_acc, ti) : int_to_slot(int_acc, ti);
+        break;
+      }
+      default: {
+        CHECK(kind == SqlWindowFunctionKind::SUM || kind == SqlWindowFunctionKind::MIN ||
+              kind == SqlWindowFunctionKind::MAX);
+        if (!count) {
+          result = null_slot(ti);
+        } else {
+          result = fp_arg ? fp_to_slot(fp_acc, ti) : int_to_slot(int_acc, ti);
+        }
+        break;
+      }
+    }
+    for (size_t pos = frame_begin; pos < frame_end; ++pos) {
+      output[permutation[pos]] = result;
+    }
+    frame_begin = frame_end;
+  }
+}
+
+void compute_partition(const Analyzer::WindowFunction* window_func,
+                       const std::vector<const WindowColumn*>& args,
+                       const WindowPartitions& partitions,
+                       const size_t begin,
+                       const size_t end,
+                       std::vector<int64_t>& output) {
+  const auto kind = window_func->getKind();
+  const auto& ti = window_func->get_type_info();
+  const auto& permutation = partitions.getPermutation();
+  switch (kind) {
+    case SqlWindowFunctionKind::ROW_NUMBER: {
+      for (size_t pos = begin; pos < end; ++pos) {
+        output[permutation[pos]] = pos - begin + 1;
+      }
+      break;
+    }
+    case SqlWindowFunctionKind::RANK: {
+      int64_t rank{1};
+      for (size_t pos = begin; pos < end; ++pos) {
+        if (pos > begin && !partitions.arePeers(pos - 1, pos)) {
+          rank = pos - begin + 1;
+        }
+        output[permutation[pos]] = rank;
+      }
+      break;
+    }
+    case SqlWindowFunctionKind::DENSE_RANK: {
+      int64_t rank{1};
+      for (size_t pos = begin; pos < end; ++pos) {
+        if (pos > begin && !partitions.arePeers(pos - 1, pos)) {
+          ++rank;
+        }
+        output[permutation[pos]] = rank;
+      }
+      break;
+    }
+    case SqlWindowFunctionKind::LAG:
+    case SqlWindowFunctionKind::LEAD: {
+      CHECK(!args.empty());
+      for (size_t pos = begin; pos < end; ++pos) {
+        const auto row = permutation[pos];
+        const int64_t offset = args.size() > 1 ? args[1]->values[row] : 1;
+        const int64_t target_pos = kind == SqlWindowFunctionKind::LAG
+                                       ? static_cast<int64_t>(pos) - offset
+                                       : static_cast<int64_t>(pos) + offset;
+        if (target_pos >= static_cast<int64_t>(begin) &&
+            target_pos < static_cast<int64_t>(end)) {
+          output[row] = value_to_slot(args.front(), permutation[target_pos], ti);
+        } else if (args.size() > 2) {
+          output[row] = value_to_slot(args[2], row, ti);
+        } else {
+          output[row] = null_slot(ti);
+        }
+      }
+      break;
+    }
+    case SqlWindowFunctionKind::FIRST_VALUE: {
+      CHECK(!args.empty());
+      for (size_t pos = begin; pos < end; ++pos) {
+        output[permutation[pos]] = value_to_slot(args.front(), permutation[begin], ti);
+      }
+      break;
+    }
+    default: {
+      compute_partition_aggregate(window_func, args, partitions, begin, end, output);
+      break;
+    }
+  }
+}
+
+}  // namespace
+
+std::vector<int64_t> compute_window_function(
+    const Analyzer::WindowFunction* window_func,
+    const std::vector<const WindowColumn*>& args,
+    const WindowPartitions& partitions) {
+  const auto& partition_offsets = partitions.getPartitionOffsets();
+  CHECK(!partition_offsets.empty());
+  std::vector<int64_t> output(partitions.getPermutation().size());
+  parallel_for_ranges(
+      partition_offsets.size() - 1, 1, [&](const size_t first, const size_t last) {
+        for (size_t partition_idx = first; partition_idx < last; ++partition_idx) {
+          compute_partition(window_func,
+                            args,
+                            partitions,
+                            partition_offsets[partition_idx],
+                            partition_offsets[partition_idx + 1],
+                            output);
+        }
+      });
+  return output;
+}
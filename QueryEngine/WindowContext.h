@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    WindowContext.h
+ * @brief   Evaluation of window functions over projected rows.
+ *
+ * The rows are hash partitioned on the partition keys and each hash bucket is sorted on
+ * the partition and order keys, in parallel, which leaves every partition contiguous and
+ * ordered. The functions are then computed in a single pass over each partition, with
+ * the partitions spread across threads.
+ */
+
+#ifndef QUERYENGINE_WINDOWCONTEXT_H
+#define QUERYENGINE_WINDOWCONTEXT_H
+
+#include "../Analyzer/Analyzer.h"
+
+#include <cstdint>
+#include <vector>
+
+// The values of a projected column, one 64-bit slot per row: floating point values are
+// stored as the bits of a double and dictionary encoded strings as their ids.
+struct WindowColumn {
+  SQLTypeInfo ti;
+  std::vector<int64_t> values;
+
+  bool isNull(const size_t row) const;
+
+  double getDouble(const size_t row) const;
+};
+
+// The rows sorted on the partition keys, then on the order keys within a partition.
+// Window functions with the same partition and order keys share it.
+class WindowPartitions {
+ public:
+  WindowPartitions(const std::vector<const WindowColumn*>& partition_keys,
+                   const std::vector<const WindowColumn*>& order_keys,
+                   const std::vector<Analyzer::OrderEntry>& collation,
+                   const size_t row_count);
+
+  // Row at the given position in the sorted order.
+  const std::vector<size_t>& getPermutation() const { return permutation_; }
+
+  // Start position of each partition, followed by the row count.
+  const std::vector<size_t>& getPartitionOffsets() const { return partition_offsets_; }
+
+  // Whether the rows at the given sorted positions have the same order keys.
+  bool arePeers(const size_t lhs_pos, const size_t rhs_pos) const;
+
+ private:
+  bool lessThan(const size_t lhs_row, const size_t rhs_row) const;
+
+  bool samePartition(const size_t lhs_row, const size_t rhs_row) const;
+
+  void sortRange(const size_t begin, const size_t end);
+
+  const std::vector<const WindowColumn*> partition_keys_;
+  const std::vector<const WindowColumn*> order_keys_;
+  const std::vector<Analyzer::OrderEntry> collation_;
+  std::vector<size_t> permutation_;
+  std::vector<size_t> partition_offsets_;
+};
+
+// Computes the window function for every row. The arguments are in the order of the
+// function's and the result uses the slot layout of WindowColumn for its type.
+std::vector<int64_t> compute_window_function(
+    const Analyzer::WindowFunction* window_func,
+    const std::vector<const WindowColumn*>& args,
+    const WindowPartitions& partitions);
+
+#endif  // QUERYENGINE_WINDOWCONTEXT_H
@@ -6,6 +6,7 @@
 #include "ExtensionFunctions.hpp"
 #include "GpuRtConstants.h"
 #include "HyperLogLogRank.h"
+#include "QuantileSketch.h"
 
 extern "C" __device__ int32_t pos_start_impl(const int32_t* row_index_resume) {
   return blockIdx.x * blockDim.x + threadIdx.x;
@@ -145,6 +146,39 @@ extern "C" __device__ void agg_from_smem_to_gmem_count_binId(int64_t* gmem_dest,
   }
 }
 
+/**
+ * Aggregate the result stored into shared memory back into global memory, for rows made
+ * of one 64-bit slot per target.
+ * The slots set in agg_slot_mask hold COUNT or SUM aggregates and are added up, the
+ * other ones hold the group by columns and are written back. Both only for the entries
+ * the block has hit, which have a non-zero value in the slot at key_slot.
+ */
+extern "C" __device__ void agg_from_smem_to_gmem_slots(int64_t* gmem_dest,
+                                                       int64_t* smem_src,
+                                                       const int32_t entry_count,
+                                                       const int32_t row_slots,
+                                                       const int32_t key_slot,
+                                                       const int64_t agg_slot_mask) {
+  __syncthreads();
+  for (int i = threadIdx.x; i < entry_count; i += blockDim.x) {
+    const auto smem_row = smem_src + i * row_slots;
+    if (!smem_row[key_slot]) {
+      continue;
+    }
+    auto gmem_row = gmem_dest + i * row_slots;
+    for (int j = 0; j < row_slots; ++j) {
+      if (agg_slot_mask & (int64_t(1) << j)) {
+        if (smem_row[j]) {
+          atomicAdd(reinterpret_cast<unsigned long long*>(gmem_row + j),
+                    static_cast<unsigned long long>(smem_row[j]));
+        }
+      } else {
+        gmem_row[j] = smem_row[j];
+      }
+    }
+  }
+}
+
 #define init_group_by_buffer_gpu_impl init_group_by_buffer_gpu
 
 #include "GpuInitGroups.cu"
@@ -909,6 +943,40 @@ extern "C" __device__ void agg_approximate_count_distinct_gpu(
   atomicMax(&M[index], rank);
 }
 
+extern "C" __device__ void agg_approximate_count_distinct_merge_gpu(
+    int64_t* agg,
+    const int8_t* sketch,
+    const uint32_t sketch_sz,
+    const uint32_t b,
+    const int64_t base_dev_addr,
+    const int64_t base_host_addr) {
+  const auto q = hll_sketch_precision(sketch_sz);
+  if (!q) {
+    return;
+  }
+  const int64_t host_addr = *agg;
+  int32_t* M = (int32_t*)(base_dev_addr + host_addr - base_host_addr);
+  for (uint32_t i = 0; i < sketch_sz; ++i) {
+    uint32_t index = i;
+    int32_t rank = sketch[i];
+    hll_fold_register(index, rank, q, b);
+    atomicMax(&M[index], rank);
+  }
+}
+
+extern "C" __device__ void agg_approx_quantile_gpu(int64_t* agg,
+                                                   const double val,
+                                                   const double null_val,
+                                                   const int64_t base_dev_addr,
+                                                   const int64_t base_host_addr) {
+  if (val == null_val) {
+    return;
+  }
+  const int64_t host_addr = *agg;
+  auto counts = (unsigned long long*)(base_dev_addr + host_addr - base_host_addr);
+  atomicAdd(&counts[quantile_sketch_bucket(val)], 1ULL);
+}
+
 extern "C" __device__ void force_sync() {
   __threadfence_block();
 }
@@ -55,6 +55,7 @@ struct MetaClientContext {
   TLicenseInfo license_info;
   std::vector<TCompletionHint> completion_hints;
   std::vector<TDashboard> dash_names;
+  std::vector<TStringRow> load_rows;
 
   MetaClientContext(TTransport& t, CLIENT_TYPE& c)
       : transport(t)
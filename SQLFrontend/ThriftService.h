@@ -34,7 +34,8 @@ enum ThriftService {
   kSET_LICENSE_KEY,
   kGET_LICENSE_CLAIMS,
   kGET_COMPLETION_HINTS,
-  kGET_DASHBOARDS
+  kGET_DASHBOARDS,
+  kLOAD_TABLE
 };
 
 #endif
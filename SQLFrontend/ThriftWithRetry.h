@@ -138,6 +138,9 @@ bool thrift_with_retry(SERVICE_ENUM which_service,
       case kGET_DASHBOARDS:
         context.client.get_dashboards(context.dash_names, context.session);
         break;
+      case kLOAD_TABLE:
+        context.client.load_table(context.session, arg, context.load_rows);
+        break;
     }
   } catch (TMapDException& e) {
     std::cerr << e.error_msg << std::endl;
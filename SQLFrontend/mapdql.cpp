@@ -122,7 +122,8 @@ void copy_table(char const* filepath, char const* table, ClientContext& context)
   if (l >= 4 && strcmp(filepath + l - 4, ".tsv") == 0) {
     delim = "\t";
   }
-  std::vector<TStringRow> input_rows;
+  auto& input_rows = context.load_rows;
+  input_rows.clear();
   TStringRow row;
   boost::char_separator<char> sep{delim, "", boost::keep_empty_tokens};
   try {
@@ -149,16 +150,15 @@ void copy_table(char const* filepath, char const* table, ClientContext& context)
       }
       input_rows.push_back(row);
       if (input_rows.size() >= LOAD_PATCH_SIZE) {
-        try {
-          context.client.load_table(context.session, table, input_rows);
-        } catch (TMapDException& e) {
-          std::cerr << e.error_msg << std::endl;
-        }
+        // a batch the server rejects is reported and dropped, one whose connection
+        // broke is sent again after reconnecting
+        (void)thrift_with_retry(kLOAD_TABLE, context, table);
         input_rows.clear();
       }
     }
     if (input_rows.size() > 0) {
-      context.client.load_table(context.session, table, input_rows);
+      (void)thrift_with_retry(kLOAD_TABLE, context, table);
+      input_rows.clear();
     }
   } catch (TMapDException& e) {
     std::cerr << e.error_msg << std::endl;
@@ -788,6 +788,9 @@ void print_memory_info(ClientContext& context, std::string memory_level) {
     if (nodeIt.is_allocation_capped) {
       tss << "The allocation is capped!";
     }
+    tss << "Hits: " << nodeIt.num_hits << " Misses: " << nodeIt.num_misses
+        << " Evictions: " << nodeIt.num_evictions
+        << " Largest free block: " << nodeIt.largest_free_pages << " pages" << std::endl;
     tss << "SLAB     ST_PAGE NUM_PAGE  TOUCH         CHUNK_KEY" << std::endl;
     for (auto segIt = nodeIt.node_memory_data.begin();
          segIt != nodeIt.node_memory_data.end();
@@ -27,6 +27,8 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include "StringTransform.h"
@@ -83,6 +85,83 @@ int64_t parse_numeric(const std::string& s, SQLTypeInfo& ti) {
   return result * sign;
 }
 
+namespace {
+
+// Fast paths for the plain spellings of the values, which are most of what gets
+// imported. They only accept what the general parsers below read the same way, the
+// rest is left to those.
+
+bool parse_digits(const char* p, const size_t num_digits, int& val) {
+  val = 0;
+  for (size_t i = 0; i < num_digits; ++i) {
+    const unsigned digit = static_cast<unsigned char>(p[i]) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    val = val * 10 + digit;
+  }
+  return true;
+}
+
+bool parse_plain_integer(const std::string& s, int64_t& val) {
+  const bool has_sign = !s.empty() && (s[0] == '-' || s[0] == '+');
+  const size_t num_digits = s.size() - (has_sign ? 1 : 0);
+  // Can't overflow.
+  if (num_digits == 0 || num_digits > 18) {
+    return false;
+  }
+  int64_t result = 0;
+  for (size_t i = has_sign ? 1 : 0; i < s.size(); ++i) {
+    const unsigned digit = static_cast<unsigned char>(s[i]) - '0';
+    if (digit > 9) {
+      return false;
+    }
+    result = result * 10 + digit;
+  }
+  val = s[0] == '-' ? -result : result;
+  return true;
+}
+
+bool parse_plain_int(const std::string& s, int& val) {
+  int64_t result;
+  if (!parse_plain_integer(s, result) || result < std::numeric_limits<int>::min() ||
+      result > std::numeric_limits<int>::max()) {
+    return false;
+  }
+  val = result;
+  return true;
+}
+
+// YYYY-MM-DD
+bool parse_plain_date(const char* p, std::tm& tm_struct) {
+  int year, month, day;
+  if (!parse_digits(p, 4, year) || p[4] != '-' || !parse_digits(p + 5, 2, month) ||
+      p[7] != '-' || !parse_digits(p + 8, 2, day) || month < 1 || month > 12 ||
+      day < 1 || day > 31) {
+    return false;
+  }
+  tm_struct.tm_year = year - 1900;
+  tm_struct.tm_mon = month - 1;
+  tm_struct.tm_mday = day;
+  return true;
+}
+
+// HH:MM:SS
+bool parse_plain_time(const char* p, std::tm& tm_struct) {
+  int hour, min, sec;
+  if (!parse_digits(p, 2, hour) || p[2] != ':' || !parse_digits(p + 3, 2, min) ||
+      p[5] != ':' || !parse_digits(p + 6, 2, sec) || hour > 23 || min > 59 ||
+      sec > 60) {
+    return false;
+  }
+  tm_struct.tm_hour = hour;
+  tm_struct.tm_min = min;
+  tm_struct.tm_sec = sec;
+  return true;
+}
+
+}  // namespace
+
 /*
  * @brief convert string to a datum
  */
@@ -104,18 +183,26 @@ Datum StringToDatum(const std::string& s, SQLTypeInfo& ti) {
     case kDECIMAL:
       d.bigintval = parse_numeric(s, ti);
       break;
-    case kBIGINT:
-      d.bigintval = std::stoll(s);
+    case kBIGINT: {
+      int64_t val;
+      d.bigintval = parse_plain_integer(s, val) ? val : std::stoll(s);
       break;
-    case kINT:
-      d.intval = std::stoi(s);
+    }
+    case kINT: {
+      int val;
+      d.intval = parse_plain_int(s, val) ? val : std::stoi(s);
       break;
-    case kSMALLINT:
-      d.smallintval = std::stoi(s);
+    }
+    case kSMALLINT: {
+      int val;
+      d.smallintval = parse_plain_int(s, val) ? val : std::stoi(s);
       break;
-    case kTINYINT:
-      d.tinyintval = std::stoi(s);
+    }
+    case kTINYINT: {
+      int val;
+      d.tinyintval = parse_plain_int(s, val) ? val : std::stoi(s);
       break;
+    }
     case kFLOAT:
       d.floatval = std::stof(s);
       break;
@@ -143,6 +230,15 @@ Datum StringToDatum(const std::string& s, SQLTypeInfo& ti) {
       std::tm tm_struct = {0};
       // not sure in advance if it is used so need to zero before processing
       tm_struct.tm_gmtoff = 0;
+      if (s.size() == 19 && (s[10] == ' ' || s[10] == 'T') &&
+          parse_plain_date(s.c_str(), tm_struct) &&
+          parse_plain_time(s.c_str() + 11, tm_struct)) {
+        d.timeval = ti.get_dimension() > 0
+                        ? TimeGM::instance().my_timegm(&tm_struct, 0, ti)
+                        : TimeGM::instance().my_timegm(&tm_struct);
+        break;
+      }
+      tm_struct = std::tm{0};
       char* tp;
       // try ISO8601 date first
       tp = strptime(s.c_str(), "%Y-%m-%d", &tm_struct);
@@ -237,6 +333,11 @@ Datum StringToDatum(const std::string& s, SQLTypeInfo& ti) {
       std::tm tm_struct = {0};
       // not sure in advance if it is used so need to zero before processing
       tm_struct.tm_gmtoff = 0;
+      if (s.size() == 10 && parse_plain_date(s.c_str(), tm_struct)) {
+        d.timeval = TimeGM::instance().my_timegm(&tm_struct);
+        break;
+      }
+      tm_struct = std::tm{0};
       char* tp;
       // try ISO8601 date first
       tp = strptime(s.c_str(), "%Y-%m-%d", &tm_struct);
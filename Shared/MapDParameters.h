@@ -32,6 +32,7 @@ struct MapDParameters {
   size_t calcite_max_mem = 1024;    // max memory for calcite jvm in MB
   int mapd_server_port = 9091;      // default port mapd_server runs on
   int calcite_port = 9093;          // default port for calcite server to run on
+  size_t calcite_plan_cache_size = 0;  // number of cached Calcite plans, 0 disables it
   std::string ha_group_id;          // name of the HA group this server is in
   std::string ha_unique_server_id;  // name of the HA unique id for this server
   std::string ha_brokers;           // name of the HA broker
@@ -39,6 +40,11 @@ struct MapDParameters {
   bool is_decr_start_epoch;         // are we doing a start epoch decrement?
   size_t cpu_buffer_mem_bytes = 0;  // max size of memory reserved for CPU buffers [bytes]
   size_t gpu_buffer_mem_bytes = 0;  // max size of memory reserved for GPU buffers [bytes]
+  size_t pinned_cpu_buffer_mem_bytes = 0;  // page-locked part of the CPU buffers [bytes]
+  bool cpu_buffer_huge_pages = false;       // back the CPU buffers with huge pages
+  bool cpu_buffer_numa_interleave = false;  // spread the CPU buffers over NUMA nodes
+  size_t reusable_gpu_buffer_mem_bytes = 0;  // GPU output buffers kept per GPU [bytes]
+  size_t gpu_scratch_mem_bytes = 1UL << 28;  // scratch memory pooled per GPU [bytes]
   std::string ssl_cert_file = "";   // file path to server's certified PKI certificate
   std::string ssl_key_file = "";    // file path to server's' private PKI key
   std::string ssl_trust_store = "";     // file path to java jks version of ssl_key_fle
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    Metrics.h
+ * @brief   Process wide counters and histograms, exported in the Prometheus text
+ * format.
+ *
+ * A metric is registered on first use and lives until the process exits, the
+ * references returned by the registry can therefore be kept by the callers to avoid
+ * the lookup on their hot paths. Header only, so that every library can record
+ * metrics regardless of the link order.
+ */
+
+#ifndef SHARED_METRICS_H
+#define SHARED_METRICS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metrics {
+
+class Counter {
+ public:
+  void inc(const uint64_t n = 1) { value_ += n; }
+
+  uint64_t value() const { return value_; }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+ public:
+  void add(const int64_t n) { value_ += n; }
+
+  void set(const int64_t n) { value_ = n; }
+
+  int64_t value() const { return value_; }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+class Histogram {
+ public:
+  explicit Histogram(const std::vector<double>& bounds)
+      : bounds_(bounds), bucket_counts_(bounds.size() + 1, 0) {}
+
+  void observe(const double value) {
+    const auto bucket =
+        std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin();
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++bucket_counts_[bucket];
+    sum_ += value;
+  }
+
+  // Appends the cumulative buckets, the sum and the count of the observations.
+  void print(std::ostream& os, const std::string& name, const std::string& labels) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto sep = labels.empty() ? "" : ",";
+    uint64_t count{0};
+    for (size_t i = 0; i < bucket_counts_.size(); ++i) {
+      count += bucket_counts_[i];
+      os << name << "_bucket{" << labels << sep << "le=\"";
+      if (i < bounds_.size()) {
+        os << bounds_[i];
+      } else {
+        os << "+Inf";
+      }
+      os << "\"} " << count << "\n";
+    }
+    const auto braced = labels.empty() ? labels : "{" + labels + "}";
+    os << name << "_sum" << braced << " " << sum_ << "\n";
+    os << name << "_count" << braced << " " << count << "\n";
+  }
+
+ private:
+  const std::vector<double> bounds_;
+  mutable std::mutex mutex_;
+  std::vector<uint64_t> bucket_counts_;
+  double sum_{0};
+};
+
+// Upper bounds of the buckets of the latency histograms, in milliseconds.
+inline const std::vector<double>& latency_ms_bounds() {
+  static const std::vector<double> bounds{
+      1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000};
+  return bounds;
+}
+
+// Prints a family of samples kept by a component itself rather than in the registry,
+// e.g. its cache statistics, read when the metrics are exported.
+template <class VALUE>
+void print_family(std::ostream& os,
+                  const std::string& name,
+                  const std::string& help,
+                  const std::string& type,
+                  const std::vector<std::pair<std::string, VALUE>>& samples) {
+  os << "# HELP " << name << " " << help << "\n";
+  os << "# TYPE " << name << " " << type << "\n";
+  for (const auto& sample : samples) {
+    os << name;
+    if (!sample.first.empty()) {
+      os << "{" << sample.first << "}";
+    }
+    os << " " << sample.second << "\n";
+  }
+}
+
+class Registry {
+ public:
+  static Registry& get() {
+    static Registry registry;
+    return registry;
+  }
+
+  // The labels are given in the exposition syntax, e.g. level="gpu",device="0".
+  Counter& counter(const std::string& name,
+                   const std::string& help,
+                   const std::string& labels = "") {
+    return getOrCreate<Counter>(name, help, "counter", labels, counters_);
+  }
+
+  Gauge& gauge(const std::string& name,
+               const std::string& help,
+               const std::string& labels = "") {
+    return getOrCreate<Gauge>(name, help, "gauge", labels, gauges_);
+  }
+
+  Histogram& histogram(const std::string& name,
+                       const std::string& help,
+                       const std::string& labels = "",
+                       const std::vector<double>& bounds = latency_ms_bounds()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    addFamily(name, help, "histogram");
+    auto& metric = histograms_[std::make_pair(name, labels)];
+    if (!metric) {
+      metric.reset(new Histogram(bounds));
+    }
+    return *metric;
+  }
+
+  std::string toPrometheusText() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream os;
+    for (const auto& family : families_) {
+      const auto& name = family.first;
+      os << "# HELP " << name << " " << family.second.first << "\n";
+      os << "# TYPE " << name << " " << family.second.second << "\n";
+      printValues(os, name, counters_);
+      printValues(os, name, gauges_);
+      for (auto it = histograms_.lower_bound(std::make_pair(name, std::string()));
+           it != histograms_.end() && it->first.first == name;
+           ++it) {
+        it->second->print(os, name, it->first.second);
+      }
+    }
+    return os.str();
+  }
+
+ private:
+  Registry() {}
+
+  template <class METRIC>
+  using MetricMap =
+      std::map<std::pair<std::string, std::string>, std::unique_ptr<METRIC>>;
+
+  void addFamily(const std::string& name,
+                 const std::string& help,
+                 const std::string& type) {
+    families_.emplace(name, std::make_pair(help, type));
+  }
+
+  template <class METRIC>
+  METRIC& getOrCreate(const std::string& name,
+                      const std::string& help,
+                      const std::string& type,
+                      const std::string& labels,
+                      MetricMap<METRIC>& metrics) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    addFamily(name, help, type);
+    auto& metric = metrics[std::make_pair(name, labels)];
+    if (!metric) {
+      metric.reset(new METRIC());
+    }
+    return *metric;
+  }
+
+  template <class METRIC>
+  static void printValues(std::ostream& os,
+                          const std::string& name,
+                          const MetricMap<METRIC>& metrics) {
+    for (auto it = metrics.lower_bound(std::make_pair(name, std::string()));
+         it != metrics.end() && it->first.first == name;
+         ++it) {
+      os << name;
+      if (!it->first.second.empty()) {
+        os << "{" << it->first.second << "}";
+      }
+      os << " " << it->second->value() << "\n";
+    }
+  }
+
+  mutable std::mutex mutex_;
+  // name -> (help, type), sorted so that the output is stable
+  std::map<std::string, std::pair<std::string, std::string>> families_;
+  MetricMap<Counter> counters_;
+  MetricMap<Gauge> gauges_;
+  MetricMap<Histogram> histograms_;
+};
+
+}  // namespace metrics
+
+#endif  // SHARED_METRICS_H
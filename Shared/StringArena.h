@@ -0,0 +1,76 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    StringArena.h
+ * @brief   Sequence of strings stored back to back in a single payload.
+ *
+ * Appending a string copies its bytes at the end of the payload and records where it
+ * ends, instead of allocating a std::string per value. Clearing keeps the capacity, so
+ * a buffer reused batch after batch stops allocating once it has seen its largest one.
+ */
+
+#ifndef STRINGARENA_H
+#define STRINGARENA_H
+
+#include <boost/utility/string_ref.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class StringArena {
+ public:
+  StringArena() : ends_(1, 0) {}
+
+  void emplace_back(const char* str, const size_t size) {
+    payload_.insert(payload_.end(), str, str + size);
+    ends_.push_back(payload_.size());
+  }
+
+  void push_back(const boost::string_ref str) { emplace_back(str.data(), str.size()); }
+
+  void pop_back() {
+    ends_.pop_back();
+    payload_.resize(ends_.back());
+  }
+
+  // Only valid until the next string is appended.
+  boost::string_ref operator[](const size_t index) const {
+    return boost::string_ref(payload_.data() + ends_[index],
+                             ends_[index + 1] - ends_[index]);
+  }
+
+  size_t size() const { return ends_.size() - 1; }
+
+  bool empty() const { return ends_.size() == 1; }
+
+  void reserve(const size_t count, const size_t bytes) {
+    ends_.reserve(ends_.size() + count);
+    payload_.reserve(payload_.size() + bytes);
+  }
+
+  void clear() {
+    payload_.clear();
+    ends_.resize(1);
+  }
+
+ private:
+  std::vector<char> payload_;
+  std::vector<size_t> ends_;  // ends_[i + 1] is the end of string i, ends_[0] is 0
+};
+
+#endif  // STRINGARENA_H
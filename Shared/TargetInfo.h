@@ -34,8 +34,10 @@ struct TargetInfo {
   bool is_distinct;
 };
 
+// The targets whose slot holds the handle of a set, a bitmap or a sketch.
 inline bool is_distinct_target(const TargetInfo& target_info) {
-  return target_info.is_distinct || target_info.agg_kind == kAPPROX_COUNT_DISTINCT;
+  return target_info.is_distinct || is_approx_count_distinct(target_info.agg_kind) ||
+         target_info.agg_kind == kAPPROX_QUANTILE;
 }
 
 inline bool takes_float_argument(const TargetInfo& target_info) {
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPool.h"
+
+#include <unistd.h>
+#include <algorithm>
+
+size_t g_query_worker_threads{0};
+
+namespace threadpool {
+
+namespace {
+
+// Nesting level of the task running on the current thread; zero outside of the pool.
+thread_local size_t tl_task_depth{0};
+thread_local TaskPriority tl_task_priority{TaskPriority::NORMAL};
+
+size_t default_worker_count() {
+  return std::max(sysconf(_SC_NPROCESSORS_ONLN), 1L);
+}
+
+}  // namespace
+
+ThreadPool& ThreadPool::instance() {
+  static ThreadPool pool(g_query_worker_threads ? g_query_worker_threads
+                                                : default_worker_count());
+  return pool;
+}
+
+ThreadPool::ThreadPool(const size_t worker_count) : shutdown_(false) {
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+TaskPriority ThreadPool::currentPriority() {
+  return tl_task_priority;
+}
+
+void ThreadPool::enqueue(const TaskPriority priority, std::function<void()> func) {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    queues_[static_cast<size_t>(priority)].push_back(
+        Task{std::move(func), priority, tl_task_depth + 1});
+  }
+  queue_cv_.notify_one();
+}
+
+bool ThreadPool::runPendingTask() {
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    bool found = false;
+    // Only pick up tasks nested deeper than the one we're waiting from. Running a
+    // sibling or an unrelated outer task here could make it wait on locks or
+    // resources held further up the stack of the current thread.
+    for (auto& queue : queues_) {
+      auto it = std::find_if(queue.begin(), queue.end(), [](const Task& t) {
+        return t.depth > tl_task_depth;
+      });
+      if (it != queue.end()) {
+        task = std::move(*it);
+        queue.erase(it);
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  runTask(task);
+  return true;
+}
+
+void ThreadPool::runTask(Task& task) {
+  const auto prev_depth = tl_task_depth;
+  const auto prev_priority = tl_task_priority;
+  tl_task_depth = task.depth;
+  tl_task_priority = task.priority;
+  // Exceptions are captured by the packaged task and surface through its future.
+  task.func();
+  tl_task_depth = prev_depth;
+  tl_task_priority = prev_priority;
+}
+
+void ThreadPool::workerLoop() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this] {
+        return shutdown_ || std::any_of(queues_.begin(),
+                                        queues_.end(),
+                                        [](const std::deque<Task>& queue) {
+                                          return !queue.empty();
+                                        });
+      });
+      if (shutdown_) {
+        return;
+      }
+      for (auto& queue : queues_) {
+        if (!queue.empty()) {
+          task = std::move(queue.front());
+          queue.pop_front();
+          break;
+        }
+      }
+    }
+    runTask(task);
+  }
+}
+
+ScopedTaskPriority::ScopedTaskPriority(const TaskPriority priority)
+    : prev_priority_(tl_task_priority) {
+  tl_task_priority = priority;
+}
+
+ScopedTaskPriority::~ScopedTaskPriority() {
+  tl_task_priority = prev_priority_;
+}
+
+}  // namespace threadpool
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    ThreadPool.h
+ * @brief   Process-wide pool of worker threads used by the query engine.
+ *
+ * Tasks are queued per priority level and run in FIFO order within a level. A
+ * thread which waits on the futures of tasks it has submitted (see wait_all) keeps
+ * running queued tasks which are nested deeper than itself while it waits, so a
+ * task can fan out into sub-tasks without tying up the pool or deadlocking it when
+ * every worker is busy with an outer task.
+ */
+
+#ifndef SHARED_THREADPOOL_H
+#define SHARED_THREADPOOL_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Number of worker threads in the shared pool; zero means one per core. Must be set
+// before the first use of the pool.
+extern size_t g_query_worker_threads;
+
+namespace threadpool {
+
+enum class TaskPriority { HIGH = 0, NORMAL, LOW };
+
+class ThreadPool {
+ public:
+  static ThreadPool& instance();
+
+  ~ThreadPool();
+
+  // Queues a task with the priority of the calling thread: sub-tasks of a query keep
+  // the priority of the task which spawned them.
+  template <typename F, typename... Args>
+  std::future<typename std::result_of<F(Args...)>::type> submit(F&& f, Args&&... args) {
+    return submitWithPriority(
+        currentPriority(), std::forward<F>(f), std::forward<Args>(args)...);
+  }
+
+  template <typename F, typename... Args>
+  std::future<typename std::result_of<F(Args...)>::type>
+  submitWithPriority(const TaskPriority priority, F&& f, Args&&... args) {
+    using R = typename std::result_of<F(Args...)>::type;
+    auto task = std::make_shared<std::packaged_task<R()>>(
+        std::bind(std::forward<F>(f), std::forward<Args>(args)...));
+    auto future = task->get_future();
+    enqueue(priority, [task]() { (*task)(); });
+    return future;
+  }
+
+  // Runs one queued task nested deeper than the calling thread, if there is any.
+  bool runPendingTask();
+
+  size_t workerCount() const { return workers_.size(); }
+
+  static TaskPriority currentPriority();
+
+ private:
+  struct Task {
+    std::function<void()> func;
+    TaskPriority priority;
+    size_t depth;
+  };
+
+  explicit ThreadPool(const size_t worker_count);
+
+  void enqueue(const TaskPriority priority, std::function<void()> func);
+
+  void workerLoop();
+
+  static void runTask(Task& task);
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::array<std::deque<Task>, 3> queues_;
+  bool shutdown_;
+  std::vector<std::thread> workers_;
+};
+
+// Waits for all the futures, running other queued work on the calling thread in the
+// meantime. Rethrows the first exception after all the tasks have finished.
+template <typename T>
+void wait_all(std::vector<std::future<T>>& futures) {
+  auto& pool = ThreadPool::instance();
+  for (auto& future : futures) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (!pool.runPendingTask()) {
+        future.wait_for(std::chrono::microseconds(100));
+      }
+    }
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+// Sets the priority of the tasks submitted by the current thread for its lifetime.
+class ScopedTaskPriority {
+ public:
+  explicit ScopedTaskPriority(const TaskPriority priority);
+  ~ScopedTaskPriority();
+
+ private:
+  TaskPriority prev_priority_;
+};
+
+}  // namespace threadpool
+
+#endif  // SHARED_THREADPOOL_H
@@ -18,6 +18,7 @@
 #include <thrift/transport/THttpClient.h>
 #include <thrift/transport/TSSLSocket.h>
 #include <thrift/transport/TSocket.h>
+#include <thrift/transport/TZlibTransport.h>
 #include <boost/filesystem.hpp>
 
 using namespace ::apache::thrift::transport;
@@ -37,11 +38,14 @@ class InsecureAccessManager : public AccessManager {
 mapd::shared_ptr<TTransport> openBufferedClientTransport(
     const std::string& server_host,
     const int port,
-    const std::string& ca_cert_name) {
+    const std::string& ca_cert_name,
+    const bool compress) {
   mapd::shared_ptr<TTransport> transport;
   if (ca_cert_name.empty()) {
-    transport = mapd::shared_ptr<TTransport>(new TBufferedTransport(
-        mapd::shared_ptr<TTransport>(new TSocket(server_host, port))));
+    mapd::shared_ptr<TTransport> socket(new TSocket(server_host, port));
+    // The zlib transport does its own buffering.
+    transport = compress ? mapd::shared_ptr<TTransport>(new TZlibTransport(socket))
+                         : mapd::shared_ptr<TTransport>(new TBufferedTransport(socket));
   } else {
     // Thrift issue 4164 https://jira.apache.org/jira/browse/THRIFT-4164 reports a problem
     // if TSSLSocketFactory is destroyed before any sockets it creates are destroyed.
@@ -53,7 +57,9 @@ mapd::shared_ptr<TTransport> openBufferedClientTransport(
     factory->authenticate(false);
     factory->access(mapd::shared_ptr<InsecureAccessManager>(new InsecureAccessManager()));
     mapd::shared_ptr<TSocket> secure_socket = factory->createSocket(server_host, port);
-    transport = mapd::shared_ptr<TTransport>(new TBufferedTransport(secure_socket));
+    transport =
+        compress ? mapd::shared_ptr<TTransport>(new TZlibTransport(secure_socket))
+                 : mapd::shared_ptr<TTransport>(new TBufferedTransport(secure_socket));
   }
   return transport;
 }
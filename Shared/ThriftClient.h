@@ -29,26 +29,31 @@ struct ThriftClientConnection {
   bool skip_host_verify_;
   std::string ca_cert_name_;
   std::string trust_cert_file_;
+  // zlib compression of the binary transports, for the compressed port of the server.
+  bool compress_;
 
   ThriftClientConnection(const std::string& server_host,
                          const int port,
                          const ThriftConnectionType conn_type,
                          bool skip_host_verify,
                          const std::string& ca_cert_name,
-                         const std::string& trust_cert_file)
+                         const std::string& trust_cert_file,
+                         const bool compress = false)
       : server_host_(server_host)
       , port_(port)
       , conn_type_(conn_type)
       , skip_host_verify_(skip_host_verify)
       , ca_cert_name_(ca_cert_name)
-      , trust_cert_file_(trust_cert_file){};
+      , trust_cert_file_(trust_cert_file)
+      , compress_(compress){};
   ThriftClientConnection(){};
 };
 
 mapd::shared_ptr<::apache::thrift::transport::TTransport> openBufferedClientTransport(
     const std::string& server_host,
     const int port,
-    const std::string& ca_cert_name);
+    const std::string& ca_cert_name,
+    const bool compress = false);
 
 mapd::shared_ptr<::apache::thrift::transport::TTransport> openHttpClientTransport(
     const std::string& server_host,
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    Tracing.h
+ * @brief   Spans of the phases of a sampled query, across the nodes of a cluster.
+ *
+ * A trace is started for a sampled fraction of the queries and its context travels
+ * between the nodes in the W3C traceparent format, in the Thrift calls of the
+ * distributed execution. A span is a scoped object and the child of the innermost span
+ * of its thread; outside of a sampled trace it costs a thread local read. Each process
+ * appends the spans of its part of a trace to its own file once the outermost one ends,
+ * one OTLP JSON export request per line, which the file receiver of the OpenTelemetry
+ * collector forwards to Jaeger, where the parts of all the nodes join by the trace id.
+ * Header only, like the metrics, so that every library can open spans.
+ */
+
+#ifndef SHARED_TRACING_H
+#define SHARED_TRACING_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tracing {
+
+struct SpanRecord {
+  std::string name;
+  uint64_t span_id;
+  uint64_t parent_span_id;  // 0 for the root of the trace
+  int64_t start_ns;
+  int64_t end_ns;
+  // key and OTLP JSON value pairs
+  std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+// The spans of a trace in this process, written out when the outermost one ends.
+struct LocalTrace {
+  uint64_t trace_id_high;
+  uint64_t trace_id_low;
+  std::vector<SpanRecord> spans;
+};
+
+inline std::string to_hex(const uint64_t val) {
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(val));
+  return buf;
+}
+
+inline std::string json_escape(const std::string& str) {
+  std::string escaped;
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      escaped += buf;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+inline int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// Non-zero random ids, from a generator per thread.
+inline uint64_t random_id() {
+  static thread_local std::mt19937_64 generator(
+      std::random_device{}() ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
+  uint64_t id{0};
+  while (!id) {
+    id = generator();
+  }
+  return id;
+}
+
+class Tracer {
+ public:
+  static Tracer& get() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  // A sample rate of 0, the default, starts no trace; remote contexts are still
+  // followed so that a leaf records the traces its aggregator samples.
+  void init(const std::string& path,
+            const double sample_rate,
+            const std::string& service_instance) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_.is_open()) {
+      file_.close();
+    }
+    file_.open(path, std::ios::out | std::ios::app);
+    sample_rate_ = sample_rate;
+    service_instance_ = service_instance;
+  }
+
+  bool sample() {
+    if (sample_rate_ <= 0) {
+      return false;
+    }
+    static thread_local std::mt19937_64 generator(random_id());
+    return std::uniform_real_distribution<double>(0, 1)(generator) < sample_rate_;
+  }
+
+  void exportTrace(const LocalTrace& trace) {
+    std::ostringstream line;
+    line << "{\"resourceSpans\":[{\"resource\":{\"attributes\":["
+         << "{\"key\":\"service.name\",\"value\":{\"stringValue\":\"mapd_server\"}},"
+         << "{\"key\":\"service.instance.id\",\"value\":{\"stringValue\":\""
+         << json_escape(service_instance_) << "\"}}]},"
+         << "\"scopeSpans\":[{\"scope\":{\"name\":\"mapd\"},\"spans\":[";
+    const auto trace_id = to_hex(trace.trace_id_high) + to_hex(trace.trace_id_low);
+    for (size_t i = 0; i < trace.spans.size(); ++i) {
+      const auto& span = trace.spans[i];
+      line << (i ? "," : "") << "{\"traceId\":\"" << trace_id << "\",\"spanId\":\""
+           << to_hex(span.span_id) << "\",\"parentSpanId\":\""
+           << (span.parent_span_id ? to_hex(span.parent_span_id) : "")
+           << "\",\"name\":\"" << json_escape(span.name)
+           << "\",\"kind\":1,\"startTimeUnixNano\":\"" << span.start_ns
+           << "\",\"endTimeUnixNano\":\"" << span.end_ns << "\",\"attributes\":[";
+      for (size_t j = 0; j < span.attributes.size(); ++j) {
+        line << (j ? "," : "") << "{\"key\":\"" << json_escape(span.attributes[j].first)
+             << "\",\"value\":" << span.attributes[j].second << "}";
+      }
+      line << "]}";
+    }
+    line << "]}]}]}\n";
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+      file_ << line.str();
+      file_.flush();
+    }
+  }
+
+ private:
+  Tracer() {}
+
+  std::mutex mutex_;
+  std::ofstream file_;
+  double sample_rate_{0};
+  std::string service_instance_;
+};
+
+class Span {
+ public:
+  // The child of the innermost span of the thread, if that one is sampled.
+  explicit Span(const char* name) : parent_(current()) {
+    if (parent_ && parent_->trace_) {
+      start(name, parent_->trace_, parent_->record_.span_id);
+    }
+  }
+
+  // Continues the trace of a context from another node or thread, see traceparent().
+  // Does nothing if the context is empty, i.e. the trace is not sampled.
+  Span(const char* name, const std::string& traceparent) : parent_(current()) {
+    unsigned long long trace_id_high, trace_id_low, parent_span_id;
+    unsigned flags;
+    if (traceparent.size() != 55 ||
+        sscanf(traceparent.c_str(),
+               "00-%16llx%16llx-%16llx-%2x",
+               &trace_id_high,
+               &trace_id_low,
+               &parent_span_id,
+               &flags) != 4 ||
+        !(flags & 1)) {
+      return;
+    }
+    auto trace = std::make_shared<LocalTrace>();
+    trace->trace_id_high = trace_id_high;
+    trace->trace_id_low = trace_id_low;
+    start(name, trace, parent_span_id);
+    local_root_ = true;
+  }
+
+  ~Span() {
+    if (!trace_) {
+      return;
+    }
+    record_.end_ns = now_ns();
+    trace_->spans.push_back(std::move(record_));
+    current() = parent_;
+    if (local_root_) {
+      Tracer::get().exportTrace(*trace_);
+    }
+  }
+
+  void addAttribute(const std::string& key, const std::string& val) {
+    if (trace_) {
+      record_.attributes.emplace_back(key,
+                                      "{\"stringValue\":\"" + json_escape(val) + "\"}");
+    }
+  }
+
+  void addAttribute(const std::string& key, const int64_t val) {
+    if (trace_) {
+      record_.attributes.emplace_back(key,
+                                      "{\"intValue\":\"" + std::to_string(val) + "\"}");
+    }
+  }
+
+  bool sampled() const { return trace_ != nullptr; }
+
+  // The context for the children of this span in another node or thread, empty if the
+  // trace is not sampled.
+  std::string traceparent() const {
+    if (!trace_) {
+      return "";
+    }
+    return "00-" + to_hex(trace_->trace_id_high) + to_hex(trace_->trace_id_low) + "-" +
+           to_hex(record_.span_id) + "-01";
+  }
+
+  // The context of the innermost span of the thread.
+  static std::string currentTraceparent() {
+    return current() ? current()->traceparent() : "";
+  }
+
+  // The context of a new trace if it is sampled, for the outermost span of a query.
+  static std::string newTrace() {
+    if (!Tracer::get().sample()) {
+      return "";
+    }
+    return "00-" + to_hex(random_id()) + to_hex(random_id()) + "-" + to_hex(0) + "-01";
+  }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+ private:
+  static Span*& current() {
+    static thread_local Span* span{nullptr};
+    return span;
+  }
+
+  void start(const char* name,
+             const std::shared_ptr<LocalTrace>& trace,
+             const uint64_t parent_span_id) {
+    trace_ = trace;
+    record_.name = name;
+    record_.span_id = random_id();
+    record_.parent_span_id = parent_span_id;
+    record_.start_ns = now_ns();
+    current() = this;
+  }
+
+  Span* const parent_;
+  // Null unless sampled.
+  std::shared_ptr<LocalTrace> trace_;
+  SpanRecord record_;
+  bool local_root_{false};
+};
+
+}  // namespace tracing
+
+#endif  // SHARED_TRACING_H
@@ -67,7 +67,45 @@ enum SQLOps {
 
 enum SQLQualifier { kONE, kANY, kALL };
 
-enum SQLAgg { kAVG, kMIN, kMAX, kSUM, kCOUNT, kAPPROX_COUNT_DISTINCT, kSAMPLE };
+enum SQLAgg {
+  kAVG,
+  kMIN,
+  kMAX,
+  kSUM,
+  kCOUNT,
+  kAPPROX_COUNT_DISTINCT,
+  kSAMPLE,
+  kAPPROX_COUNT_DISTINCT_SKETCH,
+  kAPPROX_COUNT_DISTINCT_UNION,
+  kAPPROX_QUANTILE  // APPROX_PERCENTILE and APPROX_MEDIAN
+};
+
+// The aggregates computed on HyperLogLog registers. The sketch returns the registers
+// themselves, the union merges sketches stored in TINYINT[] columns and returns the
+// estimate.
+inline bool is_approx_count_distinct(const SQLAgg agg_kind) {
+  return agg_kind == kAPPROX_COUNT_DISTINCT ||
+         agg_kind == kAPPROX_COUNT_DISTINCT_SKETCH ||
+         agg_kind == kAPPROX_COUNT_DISTINCT_UNION;
+}
+
+// The window functions evaluated over the sorted partitions of a projection. SUM_INTERNAL
+// is the $SUM0 Calcite emits for SUM OVER: the sum of an empty frame is zero, not NULL.
+enum class SqlWindowFunctionKind {
+  ROW_NUMBER,
+  RANK,
+  DENSE_RANK,
+  LAG,
+  LEAD,
+  FIRST_VALUE,
+  LAST_VALUE,
+  AVG,
+  MIN,
+  MAX,
+  SUM,
+  COUNT,
+  SUM_INTERNAL
+};
 
 enum SQLStmtType { kSELECT, kUPDATE, kINSERT, kDELETE, kCREATE_TABLE };
 
@@ -253,7 +253,7 @@ class SQLTypeInfoCore : public TYPE_FACET_PACK<SQLTypeInfoCore<TYPE_FACET_PACK..
   HOST DEVICE inline int get_comp_param() const { return comp_param; }
   HOST DEVICE inline int get_size() const { return size; }
   inline int get_logical_size() const {
-    if (compression == kENCODING_FIXED) {
+    if (compression == kENCODING_FIXED || compression == kENCODING_DIFF) {
       SQLTypeInfoCore ti(type, dimension, scale, notnull, kENCODING_NONE, 0, subtype);
       return ti.get_size();
     }
@@ -548,10 +548,10 @@ class SQLTypeInfoCore : public TYPE_FACET_PACK<SQLTypeInfoCore<TYPE_FACET_PACK..
           case kENCODING_NONE:
             return sizeof(int16_t);
           case kENCODING_FIXED:
+          case kENCODING_DIFF:
           case kENCODING_SPARSE:
             return comp_param / 8;
           case kENCODING_RL:
-          case kENCODING_DIFF:
             break;
           default:
             assert(false);
@@ -562,10 +562,10 @@ class SQLTypeInfoCore : public TYPE_FACET_PACK<SQLTypeInfoCore<TYPE_FACET_PACK..
           case kENCODING_NONE:
             return sizeof(int32_t);
           case kENCODING_FIXED:
+          case kENCODING_DIFF:
           case kENCODING_SPARSE:
             return comp_param / 8;
           case kENCODING_RL:
-          case kENCODING_DIFF:
             break;
           default:
             assert(false);
@@ -578,10 +578,10 @@ class SQLTypeInfoCore : public TYPE_FACET_PACK<SQLTypeInfoCore<TYPE_FACET_PACK..
           case kENCODING_NONE:
             return sizeof(int64_t);
           case kENCODING_FIXED:
+          case kENCODING_DIFF:
           case kENCODING_SPARSE:
             return comp_param / 8;
           case kENCODING_RL:
-          case kENCODING_DIFF:
             break;
           default:
             assert(false);
@@ -628,8 +628,9 @@ class SQLTypeInfoCore : public TYPE_FACET_PACK<SQLTypeInfoCore<TYPE_FACET_PACK..
               assert(false);  // disable compression for timestamp precisions
             }
             return comp_param / 8;
-          case kENCODING_RL:
           case kENCODING_DIFF:
+            return comp_param / 8;
+          case kENCODING_RL:
           case kENCODING_SPARSE:
             assert(false);
             break;
@@ -711,7 +712,8 @@ int64_t convert_decimal_value_to_scale(const int64_t decimal_value,
 
 inline SQLTypeInfo get_logical_type_info(const SQLTypeInfo& type_info) {
   EncodingType encoding = type_info.get_compression();
-  if (encoding == kENCODING_FIXED && (type_info.get_type() != kARRAY)) {
+  if ((encoding == kENCODING_FIXED || encoding == kENCODING_DIFF) &&
+      (type_info.get_type() != kARRAY)) {
     encoding = kENCODING_NONE;
   }
   return SQLTypeInfo(type_info.get_type(),
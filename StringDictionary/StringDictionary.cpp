@@ -18,6 +18,7 @@
 #include "../Shared/sqltypes.h"
 #include "../Utils/Regexp.h"
 #include "../Utils/StringLike.h"
+#include "Shared/Metrics.h"
 #include "Shared/thread_count.h"
 #include "StringDictionaryClient.h"
 
@@ -27,12 +28,53 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/sort/spreadsort/string_sort.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
 #include <future>
+#include <iterator>
+#include <limits>
 #include <thread>
+#include <unordered_set>
+
+bool g_enable_string_dict_trigram_index{false};
+size_t g_string_dict_index_memory_budget{0};
 
 namespace {
 const int SYSTEM_PAGE_SIZE = getpagesize();
 
+const uint64_t HASH_INDEX_MAGIC{0x4d41504448494458};
+
+struct HashIndexHeader {
+  uint64_t magic;
+  uint64_t str_count;
+  uint64_t capacity;
+};
+
+// Dictionaries with their hash table loaded, only persistent ones are unloaded.
+std::mutex loaded_hash_indexes_mutex;
+std::unordered_set<StringDictionary*> loaded_hash_indexes;
+std::atomic<uint64_t> hash_index_clock{0};
+
+struct DictionaryMetrics {
+  metrics::Counter& lookups;
+  metrics::Counter& additions;
+  metrics::Gauge& strings;
+};
+
+DictionaryMetrics& dictionary_metrics() {
+  auto& registry = metrics::Registry::get();
+  static DictionaryMetrics dictionary_metrics{
+      registry.counter("mapd_string_dictionary_get_or_add_total",
+                       "Strings looked up or added through getOrAdd and getOrAddBulk"),
+      registry.counter("mapd_string_dictionary_additions_total",
+                       "Strings added to the dictionaries"),
+      registry.gauge("mapd_string_dictionary_strings",
+                     "Strings in the dictionaries loaded by the server")};
+  return dictionary_metrics;
+}
+
 size_t file_size(const int fd) {
   struct stat buf;
   int err = fstat(fd, &buf);
@@ -67,6 +109,15 @@ void checked_munmap(void* addr, size_t length) {
   CHECK_EQ(0, munmap(addr, length));
 }
 
+// Flushes the pages of the map holding the bytes in [begin, end).
+bool sync_range(void* map, const size_t begin, const size_t end) {
+  if (begin >= end) {
+    return true;
+  }
+  const size_t page_begin = begin - begin % SYSTEM_PAGE_SIZE;
+  return msync(static_cast<char*>(map) + page_begin, end - page_begin, MS_SYNC) == 0;
+}
+
 const uint32_t round_up_p2(const size_t num) {
   uint32_t in = num;
   in--;
@@ -85,13 +136,193 @@ const uint32_t round_up_p2(const size_t num) {
   return in;
 }
 
-size_t rk_hash(const std::string& str) {
+size_t rk_hash(const boost::string_ref str) {
   size_t str_hash = 1;
   for (size_t i = 0; i < str.size(); ++i) {
     str_hash = str_hash * 997 + str[i];
   }
   return str_hash;
 }
+
+// Calls func on consecutive ranges covering [0, count), on multiple threads if the count
+// is large enough for it to pay off.
+template <class F>
+void for_each_range(const size_t count, F func) {
+  const bool multithreaded = count > 10000;
+  if (!multithreaded) {
+    func(size_t(0), count);
+    return;
+  }
+  const size_t worker_count = cpu_threads();
+  CHECK_GT(worker_count, size_t(0));
+  const auto stride = (count + (worker_count - 1)) / worker_count;
+  std::vector<std::future<void>> workers;
+  for (size_t start = 0; start < count; start += stride) {
+    workers.push_back(
+        std::async(std::launch::async, func, start, std::min(start + stride, count)));
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+// Runs func(shard) for every shard of a remote dictionary, each one on its own thread.
+template <class F>
+void for_each_shard(const size_t shard_count, F func) {
+  if (shard_count == 1) {
+    func(size_t(0));
+    return;
+  }
+  std::vector<std::future<void>> workers;
+  for (size_t shard = 0; shard < shard_count; ++shard) {
+    workers.push_back(std::async(std::launch::async, func, shard));
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+}
+
+// The shards are part of the ids handed out, this must never change.
+size_t shard_of(const std::string& str, const size_t shard_count) {
+  return ((rk_hash(str) * 0x9E3779B97F4A7C15ULL) >> 32) % shard_count;
+}
+
+int32_t to_global_id(const int32_t shard_id,
+                     const size_t shard,
+                     const size_t shard_count) {
+  if (shard_id < 0) {
+    // INVALID_STR_ID or null, same on the shards.
+    return shard_id;
+  }
+  const int64_t id = static_cast<int64_t>(shard_id) * shard_count + shard;
+  CHECK_LE(id, std::numeric_limits<int32_t>::max());
+  return id;
+}
+
+// Number of the strings of the shard whose global ids are below the generation.
+size_t to_shard_generation(const size_t generation,
+                           const size_t shard,
+                           const size_t shard_count) {
+  return generation > shard ? (generation - shard + shard_count - 1) / shard_count : 0;
+}
+
+char fold_case(const char c) {
+  return 'A' <= c && c <= 'Z' ? 'a' + (c - 'A') : c;
+}
+
+uint32_t pack_trigram(const char* str) {
+  return (static_cast<uint32_t>(static_cast<uint8_t>(fold_case(str[0]))) << 16) |
+         (static_cast<uint32_t>(static_cast<uint8_t>(fold_case(str[1]))) << 8) |
+         static_cast<uint32_t>(static_cast<uint8_t>(fold_case(str[2])));
+}
+
+void add_trigrams(const std::string& literal, std::vector<uint32_t>& trigrams) {
+  for (size_t i = 0; i + 3 <= literal.size(); ++i) {
+    trigrams.push_back(pack_trigram(&literal[i]));
+  }
+}
+
+std::vector<uint32_t> unique_trigrams(const char* str, const size_t size) {
+  std::vector<uint32_t> trigrams;
+  for (size_t i = 0; i + 3 <= size; ++i) {
+    trigrams.push_back(pack_trigram(str + i));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+  return trigrams;
+}
+
+// Trigrams of the literal runs of a LIKE pattern, every match contains all of them.
+std::vector<uint32_t> like_trigrams(const std::string& pattern,
+                                    const bool is_simple,
+                                    const char escape) {
+  std::vector<uint32_t> trigrams;
+  if (is_simple) {
+    add_trigrams(pattern, trigrams);
+    return trigrams;
+  }
+  std::string literal;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    const char c = pattern[i];
+    if (c == escape && i + 1 < pattern.size()) {
+      literal.push_back(pattern[++i]);
+    } else if (c == '%' || c == '_') {
+      add_trigrams(literal, trigrams);
+      literal.clear();
+    } else {
+      literal.push_back(c);
+    }
+  }
+  add_trigrams(literal, trigrams);
+  return trigrams;
+}
+
+// Trigrams of the literal runs a match of an extended regular expression must contain.
+// Alternations, groups and bracket expressions nested in brackets aren't looked into,
+// no trigram is returned for them and the caller has to scan the whole dictionary.
+std::vector<uint32_t> regexp_trigrams(const std::string& pattern) {
+  std::vector<uint32_t> trigrams;
+  std::string literal;
+  const auto end_literal = [&literal, &trigrams] {
+    add_trigrams(literal, trigrams);
+    literal.clear();
+  };
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    const char c = pattern[i];
+    switch (c) {
+      case '|':
+      case '(':
+      case ')':
+        return {};
+      case '\\':
+        if (i + 1 < pattern.size() && !isalnum(pattern[i + 1])) {
+          literal.push_back(pattern[++i]);
+        } else {
+          end_literal();
+          ++i;
+        }
+        break;
+      case '[':
+        end_literal();
+        ++i;
+        if (i < pattern.size() && pattern[i] == '^') {
+          ++i;
+        }
+        if (i < pattern.size() && pattern[i] == ']') {
+          ++i;
+        }
+        for (; i < pattern.size() && pattern[i] != ']'; ++i) {
+          if (pattern[i] == '[') {
+            return {};
+          }
+        }
+        break;
+      case '*':
+      case '?':
+      case '{':
+        // the atom before is optional
+        if (!literal.empty()) {
+          literal.pop_back();
+        }
+        end_literal();
+        if (c == '{') {
+          for (; i < pattern.size() && pattern[i] != '}'; ++i) {
+          }
+        }
+        break;
+      case '+':
+      case '.':
+      case '^':
+      case '$':
+        end_literal();
+        break;
+      default:
+        literal.push_back(c);
+    }
+  }
+  end_literal();
+  return trigrams;
+}
 }  // namespace
 
 const int32_t StringDictionary::INVALID_STR_ID{-1};
@@ -109,8 +340,11 @@ StringDictionary::StringDictionary(const std::string& folder,
     , payload_map_(nullptr)
     , offset_file_size_(0)
     , payload_file_size_(0)
+    , offset_map_size_(0)
+    , payload_map_size_(0)
     , payload_file_off_(0)
-    , strings_cache_(nullptr) {
+    , strings_cache_(nullptr)
+    , use_trigram_index_(g_enable_string_dict_trigram_index) {
   if (!isTemp && folder.empty()) {
     return;
   }
@@ -119,6 +353,12 @@ StringDictionary::StringDictionary(const std::string& folder,
   if (!isTemp_) {
     boost::filesystem::path storage_path(folder);
     offsets_path_ = (storage_path / boost::filesystem::path("DictOffsets")).string();
+    hash_index_path_ =
+        (storage_path / boost::filesystem::path("DictHashIndex")).string();
+    if (!recover) {
+      // Left over from a dictionary whose storage is truncated below.
+      boost::filesystem::remove(hash_index_path_);
+    }
     const auto payload_path =
         (storage_path / boost::filesystem::path("DictPayload")).string();
     payload_fd_ = checked_open(payload_path.c_str(), recover);
@@ -135,87 +375,233 @@ StringDictionary::StringDictionary(const std::string& folder,
   }
   if (!isTemp_) {  // we never mmap or recover temp dictionaries
     payload_map_ = reinterpret_cast<char*>(checked_mmap(payload_fd_, payload_file_size_));
+    payload_map_size_ = payload_file_size_;
     offset_map_ =
         reinterpret_cast<StringIdxEntry*>(checked_mmap(offset_fd_, offset_file_size_));
+    offset_map_size_ = offset_file_size_;
     if (recover) {
       const size_t bytes = file_size(offset_fd_);
       if (bytes % sizeof(StringIdxEntry) != 0) {
         LOG(WARNING) << "Offsets " << offsets_path_ << " file is truncated";
       }
-      const unsigned str_count = bytes / sizeof(StringIdxEntry);
-      // at this point we know the size of the StringDict we need to load
-      // so lets reallocate the vector to the correct size
-      const uint32_t max_entries = round_up_p2(str_count * 2 + 1);
-      std::vector<int32_t> new_str_ids(max_entries, INVALID_STR_ID);
-      str_ids_.swap(new_str_ids);
-      unsigned string_id = 0;
+      const size_t max_str_count = bytes / sizeof(StringIdxEntry);
       mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
-      const uint32_t items_per_thread = 1000;
-      uint32_t thread_inits = 0;
-      const auto thread_count = std::thread::hardware_concurrency();
-      std::vector<std::future<std::vector<std::pair<unsigned int, unsigned int>>>>
-          dictionary_futures;
-      for (string_id = 0; string_id < str_count; string_id += items_per_thread) {
-        dictionary_futures.emplace_back(
-            std::async(std::launch::async, [string_id, str_count, this] {
-              std::vector<std::pair<unsigned int, unsigned int>> hashVec;
-              for (uint32_t curr_id = string_id;
-                   curr_id < string_id + items_per_thread && curr_id < str_count;
-                   curr_id++) {
-                const auto recovered = getStringFromStorage(curr_id);
-                if (recovered.canary) {
-                  // hit the canary, recovery finished
-                  break;
-                } else {
-                  std::string temp(recovered.c_str_ptr, recovered.size);
-                  hashVec.emplace_back(std::make_pair(rk_hash(temp), temp.size()));
-                }
-              }
-              return hashVec;
-            }));
-        thread_inits++;
-        if (thread_inits % thread_count == 0) {
-          processDictionaryFutures(dictionary_futures);
-        }
+      // The offsets past the last string are canaries.
+      size_t str_count = 0;
+      while (str_count < max_str_count && !getStringFromStorage(str_count).canary) {
+        ++str_count;
+      }
+      if (str_count) {
+        const auto last_str = getStringFromStorage(str_count - 1);
+        payload_file_off_ = last_str.c_str_ptr - payload_map_.load() + last_str.size;
+      }
+      buildHashIndex(str_count);
+      str_count_ = str_count;
+      checkpointed_str_count_ = str_count;
+      checkpointed_payload_off_ = payload_file_off_;
+      if (use_trigram_index_) {
+        buildTrigramIndex();
       }
-      // gather last few threads
-      if (dictionary_futures.size() != 0) {
-        processDictionaryFutures(dictionary_futures);
+    }
+  }
+  hash_index_bytes_ = str_ids_.size() * sizeof(int32_t);
+  if (!isTemp_) {
+    touchHashIndex();
+    {
+      std::lock_guard<std::mutex> registry_lock(loaded_hash_indexes_mutex);
+      loaded_hash_indexes.insert(this);
+    }
+    evictColdHashIndexes(this);
+  }
+  dictionary_metrics().strings.add(str_count_);
+}
+
+// Fills str_ids_ for the first str_count strings of the storage. The table persisted at
+// the last checkpoint is read if there's one, only the strings added since then are
+// hashed. Must be called with the write lock held.
+void StringDictionary::buildHashIndex(const size_t str_count) const {
+  size_t indexed_count{0};
+  if (!readHashIndex(str_count, indexed_count)) {
+    std::vector<int32_t>(std::max(round_up_p2(str_count * 2 + 1), uint32_t(256)),
+                         INVALID_STR_ID)
+        .swap(str_ids_);
+  }
+  hash_index_str_count_ = indexed_count;
+  // Hashing in parallel, the inserts into the table can't be.
+  const size_t batch_size = 1 << 20;
+  std::vector<size_t> hashes;
+  for (size_t start = indexed_count; start < str_count; start += batch_size) {
+    const size_t end = std::min(start + batch_size, str_count);
+    hashes.resize(end - start);
+    for_each_range(end - start, [this, start, &hashes](size_t first, size_t last) {
+      for (size_t i = first; i < last; ++i) {
+        hashes[i] = rk_hash(getStringChecked(start + i));
       }
+    });
+    for (size_t i = start; i < end; ++i) {
+      str_ids_[computeUniqueBucketWithHash(hashes[i - start], str_ids_)] = i;
     }
   }
+  hash_index_bytes_ = str_ids_.size() * sizeof(int32_t);
+}
+
+bool StringDictionary::readHashIndex(const size_t str_count,
+                                     size_t& indexed_count) const {
+  if (hash_index_path_.empty() || !boost::filesystem::exists(hash_index_path_)) {
+    return false;
+  }
+  const auto bytes = boost::filesystem::file_size(hash_index_path_);
+  std::ifstream in(hash_index_path_, std::ios::binary);
+  HashIndexHeader header;
+  if (bytes < sizeof(header) ||
+      !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+    return false;
+  }
+  // The table must leave room for the strings added since it was written.
+  if (header.magic != HASH_INDEX_MAGIC || header.str_count > str_count ||
+      header.capacity <= str_count * 2 || (header.capacity & (header.capacity - 1)) ||
+      bytes != sizeof(header) + header.capacity * sizeof(int32_t)) {
+    return false;
+  }
+  std::vector<int32_t> str_ids(header.capacity);
+  if (!in.read(reinterpret_cast<char*>(str_ids.data()),
+               header.capacity * sizeof(int32_t))) {
+    return false;
+  }
+  str_ids_.swap(str_ids);
+  indexed_count = header.str_count;
+  return true;
+}
+
+// Must be called with the lock held, shared or not.
+void StringDictionary::writeHashIndex() const {
+  CHECK(!hash_index_path_.empty());
+  const HashIndexHeader header{HASH_INDEX_MAGIC, str_count_, str_ids_.size()};
+  const auto tmp_path = hash_index_path_ + ".tmp";
+  const int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG(WARNING) << "Could not write the dictionary hash table " << tmp_path;
+    return;
+  }
+  const size_t data_bytes = str_ids_.size() * sizeof(int32_t);
+  const bool written =
+      write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) &&
+      write(fd, str_ids_.data(), data_bytes) == static_cast<ssize_t>(data_bytes) &&
+      fsync(fd) == 0;
+  close(fd);
+  if (!written || std::rename(tmp_path.c_str(), hash_index_path_.c_str())) {
+    LOG(WARNING) << "Could not write the dictionary hash table " << hash_index_path_;
+    return;
+  }
+  hash_index_str_count_ = header.str_count;
 }
 
-void StringDictionary::processDictionaryFutures(
-    std::vector<std::future<std::vector<std::pair<unsigned int, unsigned int>>>>&
-        dictionary_futures) {
-  for (auto& dictionary_future : dictionary_futures) {
-    dictionary_future.wait();
-    auto hashVec = dictionary_future.get();
-    for (auto& hash : hashVec) {
-      int32_t bucket = computeUniqueBucketWithHash(hash.first, str_ids_);
-      payload_file_off_ += hash.second;
-      str_ids_[bucket] = static_cast<int32_t>(str_count_);
-      ++str_count_;
+// Must be called with the write lock held.
+void StringDictionary::loadHashIndexIfUnloaded() const {
+  if (hash_index_loaded_) {
+    return;
+  }
+  buildHashIndex(str_count_);
+  hash_index_loaded_ = true;
+  {
+    std::lock_guard<std::mutex> registry_lock(loaded_hash_indexes_mutex);
+    loaded_hash_indexes.insert(const_cast<StringDictionary*>(this));
+  }
+  evictColdHashIndexes(this);
+}
+
+// Must be called with the write lock held. The lock-free readers of the strings don't
+// need the hash table, the pages of the storage maps are dropped but stay valid.
+void StringDictionary::unloadHashIndex() {
+  CHECK(!isTemp_);
+  if (hash_index_str_count_ != str_count_) {
+    writeHashIndex();
+  }
+  decltype(str_ids_)().swap(str_ids_);
+  decltype(sorted_cache)().swap(sorted_cache);
+  sorted_ranks_.reset();
+  strings_cache_.reset();
+  invalidateInvertedIndex();
+  hash_index_bytes_ = 0;
+  hash_index_loaded_ = false;
+#ifdef __linux__
+  madvise(payload_map_, payload_map_size_, MADV_DONTNEED);
+  madvise(offset_map_, offset_map_size_, MADV_DONTNEED);
+#endif
+}
+
+void StringDictionary::touchHashIndex() const noexcept {
+  last_access_.store(hash_index_clock.fetch_add(1, std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+}
+
+// Unloads the least recently used hash tables, other than the one just loaded, until
+// they all fit in the budget. Dictionaries busy with another thread are skipped.
+void StringDictionary::evictColdHashIndexes(const StringDictionary* loaded) {
+  if (!g_string_dict_index_memory_budget) {
+    return;
+  }
+  std::lock_guard<std::mutex> registry_lock(loaded_hash_indexes_mutex);
+  size_t total_bytes{0};
+  std::vector<StringDictionary*> candidates;
+  for (const auto dict : loaded_hash_indexes) {
+    total_bytes += dict->hash_index_bytes_;
+    if (dict != loaded) {
+      candidates.push_back(dict);
+    }
+  }
+  if (total_bytes <= g_string_dict_index_memory_budget) {
+    return;
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const StringDictionary* lhs, const StringDictionary* rhs) {
+              return lhs->last_access_ < rhs->last_access_;
+            });
+  for (const auto dict : candidates) {
+    if (total_bytes <= g_string_dict_index_memory_budget) {
+      break;
     }
+    if (!dict->rw_mutex_.try_lock()) {
+      continue;
+    }
+    total_bytes -= dict->hash_index_bytes_;
+    dict->unloadHashIndex();
+    dict->rw_mutex_.unlock();
+    loaded_hash_indexes.erase(dict);
   }
-  dictionary_futures.clear();
 }
 
 StringDictionary::StringDictionary(const LeafHostInfo& host, const DictRef dict_ref)
-    : strings_cache_(nullptr)
-    , client_(new StringDictionaryClient(host, dict_ref, true))
-    , client_no_timeout_(new StringDictionaryClient(host, dict_ref, false)) {}
+    : StringDictionary(std::vector<LeafHostInfo>{host}, dict_ref) {}
+
+StringDictionary::StringDictionary(const std::vector<LeafHostInfo>& hosts,
+                                   const DictRef dict_ref)
+    : strings_cache_(nullptr), use_trigram_index_(false) {
+  CHECK(!hosts.empty());
+  for (const auto& host : hosts) {
+    clients_.emplace_back(new StringDictionaryClient(host, dict_ref, true));
+    clients_no_timeout_.emplace_back(new StringDictionaryClient(host, dict_ref, false));
+  }
+}
 
 StringDictionary::~StringDictionary() noexcept {
-  if (client_) {
+  if (isClient()) {
     return;
   }
+  dictionary_metrics().strings.add(-static_cast<int64_t>(str_count_));
+  if (!isTemp_) {
+    std::lock_guard<std::mutex> registry_lock(loaded_hash_indexes_mutex);
+    loaded_hash_indexes.erase(this);
+  }
   if (payload_map_) {
     if (!isTemp_) {
       CHECK(offset_map_);
-      checked_munmap(payload_map_, payload_file_size_);
-      checked_munmap(offset_map_, offset_file_size_);
+      checked_munmap(payload_map_, payload_map_size_);
+      checked_munmap(offset_map_, offset_map_size_);
+      for (const auto& retired_map : retired_maps_) {
+        checked_munmap(retired_map.first, retired_map.second);
+      }
       CHECK_GE(payload_fd_, 0);
       close(payload_fd_);
       CHECK_GE(offset_fd_, 0);
@@ -224,16 +610,20 @@ StringDictionary::~StringDictionary() noexcept {
       CHECK(offset_map_);
       free(payload_map_);
       free(offset_map_);
+      for (const auto& retired_map : retired_maps_) {
+        free(retired_map.first);
+      }
     }
   }
 }
 
 int32_t StringDictionary::getOrAdd(const std::string& str) noexcept {
-  if (client_) {
+  if (isClient()) {
+    const auto shard = shard_of(str, clients_.size());
     std::vector<int32_t> string_ids;
-    client_->get_or_add_bulk(string_ids, {str});
+    clients_[shard]->get_or_add_bulk(string_ids, {str});
     CHECK_EQ(size_t(1), string_ids.size());
-    return string_ids.front();
+    return to_global_id(string_ids.front(), shard, clients_.size());
   }
   return getOrAddImpl(str);
 }
@@ -252,55 +642,131 @@ void log_encoding_error(const std::string& str) {
 template <class T>
 void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
                                     T* encoded_vec) {
-  if (client_no_timeout_) {
+  if (isClient()) {
     getOrAddBulkRemote(string_vec, encoded_vec);
     return;
   }
-  size_t out_idx{0};
-  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  getOrAddBulkLocal(string_vec, encoded_vec);
+}
+template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
+                                             uint8_t* encoded_vec);
+template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
+                                             uint16_t* encoded_vec);
+template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
+                                             int32_t* encoded_vec);
 
-  for (const auto& str : string_vec) {
+template <class T>
+void StringDictionary::getOrAddBulk(const StringArena& strings, T* encoded_vec) {
+  if (isClient()) {
+    std::vector<std::string> string_vec;
+    string_vec.reserve(strings.size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+      string_vec.push_back(strings[i].to_string());
+    }
+    getOrAddBulkRemote(string_vec, encoded_vec);
+    return;
+  }
+  getOrAddBulkLocal(strings, encoded_vec);
+}
+template void StringDictionary::getOrAddBulk(const StringArena& strings,
+                                             uint8_t* encoded_vec);
+template void StringDictionary::getOrAddBulk(const StringArena& strings,
+                                             uint16_t* encoded_vec);
+template void StringDictionary::getOrAddBulk(const StringArena& strings,
+                                             int32_t* encoded_vec);
+
+template <class T, class Strings>
+void StringDictionary::getOrAddBulkLocal(const Strings& string_vec, T* encoded_vec) {
+  dictionary_metrics().lookups.inc(string_vec.size());
+  // Hashing and probing for the strings already there, the bulk of the work for a
+  // dictionary which has seen most of the batch before, run in parallel.
+  std::vector<size_t> hashes(string_vec.size());
+  for_each_range(string_vec.size(), [&string_vec, &hashes](size_t start, size_t end) {
+    for (size_t i = start; i < end; ++i) {
+      hashes[i] = rk_hash(string_vec[i]);
+    }
+  });
+  touchHashIndex();
+  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  loadHashIndexIfUnloaded();
+  std::vector<int32_t> string_ids(string_vec.size(), INVALID_STR_ID);
+  for_each_range(string_vec.size(),
+                 [&string_vec, &hashes, &string_ids, this](size_t start, size_t end) {
+                   for (size_t i = start; i < end; ++i) {
+                     if (!string_vec[i].empty()) {
+                       string_ids[i] = str_ids_[computeBucket(
+                           hashes[i], string_vec[i], str_ids_, false)];
+                     }
+                   }
+                 });
+
+  const size_t str_count_before = str_count_;
+  for (size_t i = 0; i < string_vec.size(); ++i) {
+    const boost::string_ref str = string_vec[i];
     if (str.empty()) {
-      encoded_vec[out_idx++] = inline_int_null_value<T>();
+      encoded_vec[i] = inline_int_null_value<T>();
       continue;
     }
     CHECK(str.size() <= MAX_STRLEN);
-    int32_t bucket;
-    const size_t hash = rk_hash(str);
-    bucket = computeBucket(hash, str, str_ids_, false);
-    if (str_ids_[bucket] != INVALID_STR_ID) {
-      encoded_vec[out_idx++] = str_ids_[bucket];
-      continue;
-    }
-    if (str_ids_[bucket] == INVALID_STR_ID) {
-      if (fillRateIsHigh()) {
-        // resize when more than 50% is full
-        increaseCapacity();
-        bucket = computeBucket(hash, str, str_ids_, false);
-      }
-      appendToStorage(str);
+    if (string_ids[i] == INVALID_STR_ID) {
+      // Probed again, an earlier string of the batch may have added it.
+      const size_t hash = hashes[i];
+      int32_t bucket = computeBucket(hash, str, str_ids_, false);
+      if (str_ids_[bucket] == INVALID_STR_ID) {
+        if (fillRateIsHigh()) {
+          // resize when more than 50% is full
+          increaseCapacity();
+          bucket = computeBucket(hash, str, str_ids_, false);
+        }
+        appendToStorage(str);
+        addToTrigramIndex(str, str_count_);
 
-      str_ids_[bucket] = static_cast<int32_t>(str_count_);
-      ++str_count_;
+        str_ids_[bucket] = static_cast<int32_t>(str_count_);
+        ++str_count_;
+      }
+      string_ids[i] = str_ids_[bucket];
     }
-    encoded_vec[out_idx++] = str_ids_[bucket];
+    encoded_vec[i] = string_ids[i];
   }
+  dictionary_metrics().additions.inc(str_count_ - str_count_before);
+  dictionary_metrics().strings.add(str_count_ - str_count_before);
 
   invalidateInvertedIndex();
 }
-template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
-                                             uint8_t* encoded_vec);
-template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
-                                             uint16_t* encoded_vec);
-template void StringDictionary::getOrAddBulk(const std::vector<std::string>& string_vec,
-                                             int32_t* encoded_vec);
 
 template <class T>
 void StringDictionary::getOrAddBulkRemote(const std::vector<std::string>& string_vec,
                                           T* encoded_vec) {
-  CHECK(client_no_timeout_);
+  CHECK(isClient());
+  const size_t shard_count = clients_no_timeout_.size();
   std::vector<int32_t> string_ids;
-  client_no_timeout_->get_or_add_bulk(string_ids, string_vec);
+  if (shard_count == 1) {
+    clients_no_timeout_.front()->get_or_add_bulk(string_ids, string_vec);
+  } else {
+    // One batch per shard, sent to all the shards at once.
+    std::vector<std::vector<size_t>> shard_positions(shard_count);
+    for (size_t i = 0; i < string_vec.size(); ++i) {
+      shard_positions[shard_of(string_vec[i], shard_count)].push_back(i);
+    }
+    string_ids.resize(string_vec.size());
+    for_each_shard(shard_count, [&](const size_t shard) {
+      const auto& positions = shard_positions[shard];
+      if (positions.empty()) {
+        return;
+      }
+      std::vector<std::string> shard_strings;
+      shard_strings.reserve(positions.size());
+      for (const auto pos : positions) {
+        shard_strings.push_back(string_vec[pos]);
+      }
+      std::vector<int32_t> shard_ids;
+      clients_no_timeout_[shard]->get_or_add_bulk(shard_ids, shard_strings);
+      CHECK_EQ(positions.size(), shard_ids.size());
+      for (size_t i = 0; i < positions.size(); ++i) {
+        string_ids[positions[i]] = to_global_id(shard_ids[i], shard, shard_count);
+      }
+    });
+  }
   size_t out_idx{0};
   for (size_t i = 0; i < string_ids.size(); ++i) {
     const auto string_id = string_ids[i];
@@ -327,10 +793,20 @@ template void StringDictionary::getOrAddBulkRemote(
     int32_t* encoded_vec);
 
 int32_t StringDictionary::getIdOfString(const std::string& str) const {
-  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
-  if (client_) {
-    return client_->get(str);
+  if (isClient()) {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    const auto shard = shard_of(str, clients_.size());
+    return to_global_id(clients_[shard]->get(str), shard, clients_.size());
   }
+  touchHashIndex();
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    if (hash_index_loaded_) {
+      return getUnlocked(str);
+    }
+  }
+  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  loadHashIndexIfUnloaded();
   return getUnlocked(str);
 }
 
@@ -341,10 +817,12 @@ int32_t StringDictionary::getUnlocked(const std::string& str) const noexcept {
 }
 
 std::string StringDictionary::getString(int32_t string_id) const {
-  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
-  if (client_) {
+  if (isClient()) {
+    CHECK_GE(string_id, 0);
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
     std::string ret;
-    client_->get_string(ret, string_id);
+    clients_[string_id % clients_.size()]->get_string(ret,
+                                                       string_id / clients_.size());
     return ret;
   }
   return getStringUnlocked(string_id);
@@ -357,21 +835,63 @@ std::string StringDictionary::getStringUnlocked(int32_t string_id) const noexcep
 
 std::pair<char*, size_t> StringDictionary::getStringBytes(int32_t string_id) const
     noexcept {
-  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
-  CHECK(!client_);
+  CHECK(!isClient());
   CHECK_LE(0, string_id);
   CHECK_LT(string_id, static_cast<int32_t>(str_count_));
   return getStringBytesChecked(string_id);
 }
 
 size_t StringDictionary::storageEntryCount() const {
-  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
-  if (client_) {
-    return client_->storage_entry_count();
+  if (isClient()) {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    const size_t shard_count = clients_.size();
+    if (shard_count == 1) {
+      return clients_.front()->storage_entry_count();
+    }
+    // One past the largest id handed out, the ids of the shards interleave.
+    std::vector<size_t> shard_entry_counts(shard_count);
+    for_each_shard(shard_count, [this, &shard_entry_counts](const size_t shard) {
+      shard_entry_counts[shard] = clients_[shard]->storage_entry_count();
+    });
+    size_t entry_count{0};
+    for (size_t shard = 0; shard < shard_count; ++shard) {
+      if (shard_entry_counts[shard]) {
+        entry_count = std::max(
+            entry_count, (shard_entry_counts[shard] - 1) * shard_count + shard + 1);
+      }
+    }
+    return entry_count;
   }
   return str_count_;
 }
 
+template <class F>
+std::vector<int32_t> StringDictionary::getMatchingRemote(F get_shard_ids,
+                                                         const size_t generation) const {
+  const size_t shard_count = clients_.size();
+  std::vector<std::vector<int32_t>> shard_ids(shard_count);
+  for_each_shard(shard_count, [&](const size_t shard) {
+    auto& client = *clients_[shard];
+    // The shards behind the others in size may not have the generation asked for.
+    const size_t shard_generation =
+        shard_count == 1
+            ? generation
+            : std::min(to_shard_generation(generation, shard, shard_count),
+                       static_cast<size_t>(client.storage_entry_count()));
+    shard_ids[shard] = get_shard_ids(client, shard_generation);
+  });
+  if (shard_count == 1) {
+    return shard_ids.front();
+  }
+  std::vector<int32_t> result;
+  for (size_t shard = 0; shard < shard_count; ++shard) {
+    for (const auto shard_id : shard_ids[shard]) {
+      result.push_back(to_global_id(shard_id, shard, shard_count));
+    }
+  }
+  return result;
+}
+
 namespace {
 
 bool is_like(const std::string& str,
@@ -403,21 +923,47 @@ std::vector<int32_t> StringDictionary::getLike(const std::string& pattern,
                                                const bool is_simple,
                                                const char escape,
                                                const size_t generation) const {
-  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
-  if (client_) {
-    return client_->get_like(pattern, icase, is_simple, escape, generation);
+  if (isClient()) {
+    mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+    return getMatchingRemote(
+        [&](StringDictionaryClient& client, const size_t shard_generation) {
+          return client.get_like(pattern, icase, is_simple, escape, shard_generation);
+        },
+        generation);
   }
-  const auto cache_key = std::make_tuple(pattern, icase, is_simple, escape);
-  const auto it = like_cache_.find(cache_key);
-  if (it != like_cache_.end()) {
-    return it->second;
+  const auto cache_key = std::make_tuple(pattern, icase, is_simple, escape, generation);
+  {
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    const auto it = like_cache_.find(cache_key);
+    if (it != like_cache_.end()) {
+      return it->second;
+    }
   }
   std::vector<int32_t> result;
+  CHECK_LE(generation, str_count_);
+  std::vector<int32_t> candidates;
+  if (getTrigramCandidates(
+          like_trigrams(pattern, is_simple, escape), generation, candidates)) {
+    std::vector<char> matches(candidates.size(), 0);
+    for_each_range(candidates.size(), [&](const size_t start, const size_t end) {
+      for (size_t i = start; i < end; ++i) {
+        matches[i] =
+            is_like(getStringUnlocked(candidates[i]), pattern, icase, is_simple, escape);
+      }
+    });
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (matches[i]) {
+        result.push_back(candidates[i]);
+      }
+    }
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    like_cache_.insert(std::make_pair(cache_key, result));
+    return result;
+  }
   std::vector<std::thread> workers;
   int worker_count = cpu_threads();
   CHECK_GT(worker_count, 0);
   std::vector<std::vector<int32_t>> worker_results(worker_count);
-  CHECK_LE(generation, str_count_);
   for (int worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
     workers.emplace_back([&worker_results,
                           &pattern,
@@ -443,10 +989,10 @@ std::vector<int32_t> StringDictionary::getLike(const std::string& pattern,
   for (const auto& worker_result : worker_results) {
     result.insert(result.end(), worker_result.begin(), worker_result.end());
   }
-  // place result into cache for reuse if similar query
-  const auto it_ok = like_cache_.insert(std::make_pair(cache_key, result));
-
-  CHECK(it_ok.second);
+  // place result into cache for reuse if similar query, a concurrent one may have
+  // already placed the same result
+  std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+  like_cache_.insert(std::make_pair(cache_key, result));
 
   return result;
 }
@@ -471,28 +1017,11 @@ std::vector<int32_t> StringDictionary::getEquals(std::string pattern,
       }
     }
   } else {
-    std::vector<std::thread> workers;
-    int worker_count = cpu_threads();
-    CHECK_GT(worker_count, 0);
-    std::vector<std::vector<int32_t>> worker_results(worker_count);
     CHECK_LE(generation, str_count_);
-    for (int worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
-      workers.emplace_back(
-          [&worker_results, &pattern, generation, worker_idx, worker_count, this]() {
-            for (size_t string_id = worker_idx; string_id < generation;
-                 string_id += worker_count) {
-              const auto str = getStringUnlocked(string_id);
-              if (str == pattern) {
-                worker_results[worker_idx].push_back(string_id);
-              }
-            }
-          });
-    }
-    for (auto& worker : workers) {
-      worker.join();
-    }
-    for (const auto& worker_result : worker_results) {
-      result.insert(result.end(), worker_result.begin(), worker_result.end());
+    // The strings are unique, the hash table has the only candidate.
+    const auto str_id = getUnlocked(pattern);
+    if (str_id != INVALID_STR_ID && static_cast<size_t>(str_id) < generation) {
+      result.push_back(str_id);
     }
     if (result.size() > 0) {
       const auto it_ok = equal_cache_.insert(std::make_pair(pattern, result[0]));
@@ -515,13 +1044,19 @@ std::vector<int32_t> StringDictionary::getCompare(const std::string& pattern,
                                                   const std::string& comp_operator,
                                                   const size_t generation) {
   mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
-  if (client_) {
-    return client_->get_compare(pattern, comp_operator, generation);
+  if (isClient()) {
+    return getMatchingRemote(
+        [&](StringDictionaryClient& client, const size_t shard_generation) {
+          return client.get_compare(pattern, comp_operator, shard_generation);
+        },
+        generation);
   }
   std::vector<int32_t> ret;
   if (str_count_ == 0) {
     return ret;
   }
+  touchHashIndex();
+  loadHashIndexIfUnloaded();
   if (sorted_cache.size() < str_count_) {
     if (comp_operator == "=" || comp_operator == "<>") {
       return getEquals(pattern, comp_operator, generation);
@@ -675,21 +1210,45 @@ bool is_regexp_like(const std::string& str,
 std::vector<int32_t> StringDictionary::getRegexpLike(const std::string& pattern,
                                                      const char escape,
                                                      const size_t generation) const {
-  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
-  if (client_) {
-    return client_->get_regexp_like(pattern, escape, generation);
+  if (isClient()) {
+    mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+    return getMatchingRemote(
+        [&](StringDictionaryClient& client, const size_t shard_generation) {
+          return client.get_regexp_like(pattern, escape, shard_generation);
+        },
+        generation);
   }
-  const auto cache_key = std::make_pair(pattern, escape);
-  const auto it = regex_cache_.find(cache_key);
-  if (it != regex_cache_.end()) {
-    return it->second;
+  const auto cache_key = std::make_tuple(pattern, escape, generation);
+  {
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    const auto it = regex_cache_.find(cache_key);
+    if (it != regex_cache_.end()) {
+      return it->second;
+    }
   }
   std::vector<int32_t> result;
+  CHECK_LE(generation, str_count_);
+  std::vector<int32_t> candidates;
+  if (getTrigramCandidates(regexp_trigrams(pattern), generation, candidates)) {
+    std::vector<char> matches(candidates.size(), 0);
+    for_each_range(candidates.size(), [&](const size_t start, const size_t end) {
+      for (size_t i = start; i < end; ++i) {
+        matches[i] = is_regexp_like(getStringUnlocked(candidates[i]), pattern, escape);
+      }
+    });
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (matches[i]) {
+        result.push_back(candidates[i]);
+      }
+    }
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    regex_cache_.insert(std::make_pair(cache_key, result));
+    return result;
+  }
   std::vector<std::thread> workers;
   int worker_count = cpu_threads();
   CHECK_GT(worker_count, 0);
   std::vector<std::vector<int32_t>> worker_results(worker_count);
-  CHECK_LE(generation, str_count_);
   for (int worker_idx = 0; worker_idx < worker_count; ++worker_idx) {
     workers.emplace_back([&worker_results,
                           &pattern,
@@ -713,15 +1272,15 @@ std::vector<int32_t> StringDictionary::getRegexpLike(const std::string& pattern,
   for (const auto& worker_result : worker_results) {
     result.insert(result.end(), worker_result.begin(), worker_result.end());
   }
-  const auto it_ok = regex_cache_.insert(std::make_pair(cache_key, result));
-  CHECK(it_ok.second);
+  std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+  regex_cache_.insert(std::make_pair(cache_key, result));
 
   return result;
 }
 
 std::shared_ptr<const std::vector<std::string>> StringDictionary::copyStrings() const {
   mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
-  if (client_) {
+  if (isClient()) {
     // TODO(miyu): support remote string dictionary
     throw std::runtime_error(
         "copying dictionaries from remote server is not supported yet.");
@@ -750,9 +1309,10 @@ std::shared_ptr<const std::vector<std::string>> StringDictionary::copyStrings()
   if (multithreaded) {
     std::vector<std::future<void>> workers;
     const auto stride = (str_count_ + (worker_count - 1)) / worker_count;
-    for (size_t worker_idx = 0, start = 0, end = std::min(start + stride, str_count_);
-         worker_idx < worker_count && start < str_count_;
-         ++worker_idx, start += stride, end = std::min(start + stride, str_count_)) {
+    const size_t str_count = str_count_;
+    for (size_t worker_idx = 0, start = 0, end = std::min(start + stride, str_count);
+         worker_idx < worker_count && start < str_count;
+         ++worker_idx, start += stride, end = std::min(start + stride, str_count)) {
       workers.push_back(std::async(
           std::launch::async, copy, std::ref(worker_results[worker_idx]), start, end));
     }
@@ -791,6 +1351,7 @@ void StringDictionary::increaseCapacity() noexcept {
     new_str_ids[bucket] = i;
   }
   str_ids_.swap(new_str_ids);
+  hash_index_bytes_ = str_ids_.size() * sizeof(int32_t);
 }
 
 int32_t StringDictionary::getOrAddImpl(const std::string& str) noexcept {
@@ -799,16 +1360,21 @@ int32_t StringDictionary::getOrAddImpl(const std::string& str) noexcept {
     return inline_int_null_value<int32_t>();
   }
   CHECK(str.size() <= MAX_STRLEN);
+  dictionary_metrics().lookups.inc();
   int32_t bucket;
   const size_t hash = rk_hash(str);
+  touchHashIndex();
   {
     mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
-    bucket = computeBucket(hash, str, str_ids_, false);
-    if (str_ids_[bucket] != INVALID_STR_ID) {
-      return str_ids_[bucket];
+    if (hash_index_loaded_) {
+      bucket = computeBucket(hash, str, str_ids_, false);
+      if (str_ids_[bucket] != INVALID_STR_ID) {
+        return str_ids_[bucket];
+      }
     }
   }
   mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  loadHashIndexIfUnloaded();
   // need to recalculate the bucket in case it changed before
   // we got the lock
   bucket = computeBucket(hash, str, str_ids_, false);
@@ -819,8 +1385,11 @@ int32_t StringDictionary::getOrAddImpl(const std::string& str) noexcept {
       bucket = computeBucket(hash, str, str_ids_, false);
     }
     appendToStorage(str);
+    addToTrigramIndex(str, str_count_);
     str_ids_[bucket] = static_cast<int32_t>(str_count_);
     ++str_count_;
+    dictionary_metrics().additions.inc();
+    dictionary_metrics().strings.add(1);
     invalidateInvertedIndex();
   }
   return str_ids_[bucket];
@@ -840,7 +1409,7 @@ std::pair<char*, size_t> StringDictionary::getStringBytesChecked(
 }
 
 int32_t StringDictionary::computeBucket(const size_t hash,
-                                        const std::string str,
+                                        const boost::string_ref str,
                                         const std::vector<int32_t>& data,
                                         const bool unique) const noexcept {
   auto bucket = hash & (data.size() - 1);
@@ -854,7 +1423,7 @@ int32_t StringDictionary::computeBucket(const size_t hash,
     if (!unique) {
       const auto old_str = getStringFromStorage(data[bucket]);
       if (str.size() == old_str.size &&
-          !memcmp(str.c_str(), old_str.c_str_ptr, str.size())) {
+          !memcmp(str.data(), old_str.c_str_ptr, str.size())) {
         // found the string
         break;
       }
@@ -884,40 +1453,26 @@ int32_t StringDictionary::computeUniqueBucketWithHash(
   return bucket;
 }
 
-void StringDictionary::appendToStorage(const std::string& str) noexcept {
+void StringDictionary::appendToStorage(const boost::string_ref str) noexcept {
   if (!isTemp_) {
     CHECK_GE(payload_fd_, 0);
     CHECK_GE(offset_fd_, 0);
   }
   // write the payload
   if (payload_file_off_ + str.size() > payload_file_size_) {
-    if (!isTemp_) {
-      checked_munmap(payload_map_, payload_file_size_);
-      addPayloadCapacity();
-      CHECK(payload_file_off_ + str.size() <= payload_file_size_);
-      payload_map_ =
-          reinterpret_cast<char*>(checked_mmap(payload_fd_, payload_file_size_));
-    } else {
-      addPayloadCapacity();
-    }
+    addPayloadCapacity();
+    CHECK(payload_file_off_ + str.size() <= payload_file_size_);
   }
-  memcpy(payload_map_ + payload_file_off_, str.c_str(), str.size());
+  memcpy(payload_map_.load() + payload_file_off_, str.data(), str.size());
   // write the offset and length
   size_t offset_file_off = str_count_ * sizeof(StringIdxEntry);
   StringIdxEntry str_meta{static_cast<uint64_t>(payload_file_off_), str.size()};
   payload_file_off_ += str.size();
   if (offset_file_off + sizeof(str_meta) >= offset_file_size_) {
-    if (!isTemp_) {
-      checked_munmap(offset_map_, offset_file_size_);
-      addOffsetCapacity();
-      CHECK(offset_file_off + sizeof(str_meta) <= offset_file_size_);
-      offset_map_ =
-          reinterpret_cast<StringIdxEntry*>(checked_mmap(offset_fd_, offset_file_size_));
-    } else {
-      addOffsetCapacity();
-    }
+    addOffsetCapacity();
+    CHECK(offset_file_off + sizeof(str_meta) <= offset_file_size_);
   }
-  memcpy(offset_map_ + str_count_, &str_meta, sizeof(str_meta));
+  memcpy(offset_map_.load() + str_count_, &str_meta, sizeof(str_meta));
 }
 
 StringDictionary::PayloadString StringDictionary::getStringFromStorage(
@@ -927,17 +1482,21 @@ StringDictionary::PayloadString StringDictionary::getStringFromStorage(
     CHECK_GE(offset_fd_, 0);
   }
   CHECK_GE(string_id, 0);
-  const StringIdxEntry* str_meta = offset_map_ + string_id;
+  const StringIdxEntry* str_meta = offset_map_.load() + string_id;
   if (str_meta->size == 0xffff) {
     // hit the canary
     return {nullptr, 0, true};
   }
-  return {payload_map_ + str_meta->off, str_meta->size, false};
+  return {payload_map_.load() + str_meta->off, str_meta->size, false};
 }
 
 void StringDictionary::addPayloadCapacity() noexcept {
   if (!isTemp_) {
     payload_file_size_ += addStorageCapacity(payload_fd_);
+    if (payload_map_ && payload_file_size_ > payload_map_size_) {
+      payload_map_ = static_cast<char*>(growStorageMapping(
+          payload_map_, payload_map_size_, payload_fd_, payload_file_size_));
+    }
   } else {
     payload_map_ =
         static_cast<char*>(addMemoryCapacity(payload_map_, payload_file_size_));
@@ -947,6 +1506,10 @@ void StringDictionary::addPayloadCapacity() noexcept {
 void StringDictionary::addOffsetCapacity() noexcept {
   if (!isTemp_) {
     offset_file_size_ += addStorageCapacity(offset_fd_);
+    if (offset_map_ && offset_file_size_ > offset_map_size_) {
+      offset_map_ = static_cast<StringIdxEntry*>(growStorageMapping(
+          offset_map_, offset_map_size_, offset_fd_, offset_file_size_));
+    }
   } else {
     offset_map_ =
         static_cast<StringIdxEntry*>(addMemoryCapacity(offset_map_, offset_file_size_));
@@ -965,27 +1528,45 @@ size_t StringDictionary::addStorageCapacity(int fd) noexcept {
   return CANARY_BUFF_SIZE;
 }
 
+// The memory is doubled rather than reallocated: readers can still be using the
+// previous block, which is only freed with the dictionary.
 void* StringDictionary::addMemoryCapacity(void* addr, size_t& mem_size) noexcept {
-  static const ssize_t CANARY_BUFF_SIZE = 1024 * SYSTEM_PAGE_SIZE;
-  if (!CANARY_BUFFER) {
-    CANARY_BUFFER = reinterpret_cast<char*>(malloc(CANARY_BUFF_SIZE));
-    CHECK(CANARY_BUFFER);
-    memset(CANARY_BUFFER, 0xff, CANARY_BUFF_SIZE);
-  }
-  void* new_addr = realloc(addr, mem_size + CANARY_BUFF_SIZE);
+  static const size_t CANARY_BUFF_SIZE = 1024 * SYSTEM_PAGE_SIZE;
+  const size_t new_mem_size = mem_size + std::max(CANARY_BUFF_SIZE, mem_size);
+  void* new_addr = malloc(new_mem_size);
   CHECK(new_addr);
-  void* write_addr = reinterpret_cast<void*>(static_cast<char*>(new_addr) + mem_size);
-  CHECK(memcpy(write_addr, CANARY_BUFFER, CANARY_BUFF_SIZE));
-  mem_size += CANARY_BUFF_SIZE;
+  if (addr) {
+    memcpy(new_addr, addr, mem_size);
+    retired_maps_.emplace_back(addr, mem_size);
+  }
+  memset(static_cast<char*>(new_addr) + mem_size, 0xff, new_mem_size - mem_size);
+  mem_size = new_mem_size;
+  return new_addr;
+}
+
+// Maps the grown file again, twice as large as before so the mappings given up along
+// the way take at most as much address space as the current one. They stay mapped for
+// the readers still using them, all the mappings share the pages of the file.
+void* StringDictionary::growStorageMapping(void* addr,
+                                           size_t& map_size,
+                                           const int fd,
+                                           const size_t file_size) noexcept {
+  const size_t new_map_size = std::max(map_size * 2, file_size);
+  void* new_addr = checked_mmap(fd, new_map_size);
+  retired_maps_.emplace_back(addr, map_size);
+  map_size = new_map_size;
   return new_addr;
 }
 
 void StringDictionary::invalidateInvertedIndex() noexcept {
-  if (!like_cache_.empty()) {
-    decltype(like_cache_)().swap(like_cache_);
-  }
-  if (!regex_cache_.empty()) {
-    decltype(regex_cache_)().swap(regex_cache_);
+  {
+    std::lock_guard<std::mutex> cache_lock(cache_mutex_);
+    if (!like_cache_.empty()) {
+      decltype(like_cache_)().swap(like_cache_);
+    }
+    if (!regex_cache_.empty()) {
+      decltype(regex_cache_)().swap(regex_cache_);
+    }
   }
   if (!equal_cache_.empty()) {
     decltype(equal_cache_)().swap(equal_cache_);
@@ -993,25 +1574,156 @@ void StringDictionary::invalidateInvertedIndex() noexcept {
   compare_cache_.invalidateInvertedIndex();
 }
 
+void StringDictionary::addToTrigramIndex(const boost::string_ref str,
+                                         const int32_t string_id) noexcept {
+  if (!use_trigram_index_) {
+    return;
+  }
+  const auto trigrams = unique_trigrams(str.data(), str.size());
+  mapd_lock_guard<mapd_shared_mutex> write_lock(trigram_index_mutex_);
+  for (const auto trigram : trigrams) {
+    trigram_index_[trigram].push_back(string_id);
+  }
+}
+
+// Indexes the recovered strings, each worker a range of ids so the partial indices can
+// be concatenated in order.
+void StringDictionary::buildTrigramIndex() {
+  const size_t str_count = str_count_;
+  const size_t worker_count =
+      str_count > 10000 ? static_cast<size_t>(cpu_threads()) : size_t(1);
+  CHECK_GT(worker_count, size_t(0));
+  const auto stride = (str_count + (worker_count - 1)) / worker_count;
+  std::vector<std::future<TrigramIndex>> workers;
+  for (size_t start = 0; start < str_count; start += stride) {
+    const auto end = std::min(start + stride, str_count);
+    workers.push_back(std::async(std::launch::async, [start, end, this] {
+      TrigramIndex partial_index;
+      for (size_t string_id = start; string_id < end; ++string_id) {
+        const auto str = getStringFromStorage(string_id);
+        for (const auto trigram : unique_trigrams(str.c_str_ptr, str.size)) {
+          partial_index[trigram].push_back(string_id);
+        }
+      }
+      return partial_index;
+    }));
+  }
+  mapd_lock_guard<mapd_shared_mutex> write_lock(trigram_index_mutex_);
+  for (auto& worker : workers) {
+    const auto partial_index = worker.get();
+    for (const auto& posting : partial_index) {
+      auto& string_ids = trigram_index_[posting.first];
+      string_ids.insert(string_ids.end(), posting.second.begin(), posting.second.end());
+    }
+  }
+}
+
+// Sets candidates to the ids below generation of the strings which contain all the
+// trigrams, returns false if there's nothing to narrow down the ids with.
+bool StringDictionary::getTrigramCandidates(const std::vector<uint32_t>& trigrams,
+                                            const size_t generation,
+                                            std::vector<int32_t>& candidates) const {
+  if (!use_trigram_index_ || trigrams.empty()) {
+    return false;
+  }
+  candidates.clear();
+  mapd_shared_lock<mapd_shared_mutex> read_lock(trigram_index_mutex_);
+  std::vector<const std::vector<int32_t>*> postings;
+  for (const auto trigram : trigrams) {
+    const auto it = trigram_index_.find(trigram);
+    if (it == trigram_index_.end()) {
+      return true;
+    }
+    postings.push_back(&it->second);
+  }
+  std::sort(postings.begin(),
+            postings.end(),
+            [](const std::vector<int32_t>* lhs, const std::vector<int32_t>* rhs) {
+              return lhs->size() < rhs->size();
+            });
+  const auto& shortest = *postings.front();
+  const auto generation_end = std::lower_bound(
+      shortest.begin(), shortest.end(), static_cast<int32_t>(generation));
+  candidates.assign(shortest.begin(), generation_end);
+  // The candidates are at most as many as the ids of any other trigram, looking them up
+  // is cheaper than walking the longer lists.
+  for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+    const auto& string_ids = *postings[i];
+    const auto not_in_ids = [&string_ids](const int32_t string_id) {
+      return !std::binary_search(string_ids.begin(), string_ids.end(), string_id);
+    };
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), not_in_ids),
+                     candidates.end());
+  }
+  return true;
+}
+
 char* StringDictionary::CANARY_BUFFER{nullptr};
 
 bool StringDictionary::checkpoint() noexcept {
-  if (client_) {
+  if (isClient()) {
     try {
-      return client_->checkpoint();
+      bool ret = true;
+      for (const auto& client : clients_) {
+        ret = client->checkpoint() && ret;
+      }
+      return ret;
     } catch (...) {
       return false;
     }
   }
   CHECK(!isTemp_);
   bool ret = true;
-  ret = ret && (msync((void*)offset_map_, offset_file_size_, MS_SYNC) == 0);
-  ret = ret && (msync((void*)payload_map_, payload_file_size_, MS_SYNC) == 0);
-  ret = ret && (fsync(offset_fd_) == 0);
-  ret = ret && (fsync(payload_fd_) == 0);
+  // The maps don't grow and no string is added while the lock is held.
+  mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+  const size_t str_count = str_count_;
+  if (str_count != checkpointed_str_count_) {
+    // Only the pages written since the last checkpoint are flushed.
+    ret = ret && sync_range(offset_map_.load(),
+                            checkpointed_str_count_ * sizeof(StringIdxEntry),
+                            str_count * sizeof(StringIdxEntry));
+    ret = ret &&
+          sync_range(payload_map_.load(), checkpointed_payload_off_, payload_file_off_);
+    ret = ret && (fdatasync(offset_fd_) == 0);
+    ret = ret && (fdatasync(payload_fd_) == 0);
+    if (ret) {
+      checkpointed_str_count_ = str_count;
+      checkpointed_payload_off_ = payload_file_off_;
+    }
+  }
+  // Written after the storage is synced, it must not cover strings that aren't.
+  if (ret && hash_index_loaded_ && hash_index_str_count_ != str_count) {
+    writeHashIndex();
+  }
   return ret;
 }
 
+std::shared_ptr<const std::vector<int32_t>> StringDictionary::getSortedRanks() {
+  if (isClient()) {
+    return nullptr;
+  }
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    if (sorted_ranks_ && sorted_ranks_->size() == str_count_) {
+      return sorted_ranks_;
+    }
+  }
+  mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
+  if (sorted_ranks_ && sorted_ranks_->size() == str_count_) {
+    return sorted_ranks_;
+  }
+  // Only the strings added since the last call are sorted, then merged into the cache.
+  if (sorted_cache.size() < str_count_) {
+    buildSortedCache();
+  }
+  auto ranks = std::make_shared<std::vector<int32_t>>(sorted_cache.size());
+  for (size_t i = 0; i < sorted_cache.size(); ++i) {
+    (*ranks)[sorted_cache[i]] = static_cast<int32_t>(i);
+  }
+  sorted_ranks_ = ranks;
+  return sorted_ranks_;
+}
+
 void StringDictionary::buildSortedCache() {
   // This method is not thread-safe.
   const auto cur_cache_size = sorted_cache.size();
@@ -1060,14 +1772,77 @@ void StringDictionary::mergeSortedCache(std::vector<int32_t>& temp_sorted_cache)
   sorted_cache.swap(updated_cache);
 }
 
+bool StringDictionary::isClient() const noexcept {
+  return !clients_.empty();
+}
+
 void translate_string_ids(std::vector<int32_t>& dest_ids,
-                          const LeafHostInfo& dict_server_host,
+                          const std::vector<LeafHostInfo>& dict_server_hosts,
                           const DictRef dest_dict_ref,
                           const std::vector<int32_t>& source_ids,
                           const DictRef source_dict_ref,
                           const int32_t dest_generation) {
   DictRef temp_dict_ref(-1, -1);
-  StringDictionaryClient string_client(dict_server_host, temp_dict_ref, true);
-  string_client.translate_string_ids(
-      dest_ids, dest_dict_ref, source_ids, source_dict_ref, dest_generation);
+  const size_t shard_count = dict_server_hosts.size();
+  CHECK_GT(shard_count, size_t(0));
+  if (shard_count == 1) {
+    StringDictionaryClient string_client(dict_server_hosts.front(), temp_dict_ref, true);
+    string_client.translate_string_ids(
+        dest_ids, dest_dict_ref, source_ids, source_dict_ref, dest_generation);
+    return;
+  }
+  // A string is on the same shard in both dictionaries, each shard translates its ids.
+  std::vector<std::vector<size_t>> shard_positions(shard_count);
+  for (size_t i = 0; i < source_ids.size(); ++i) {
+    CHECK_GE(source_ids[i], 0);
+    shard_positions[source_ids[i] % shard_count].push_back(i);
+  }
+  dest_ids.resize(source_ids.size());
+  for_each_shard(shard_count, [&](const size_t shard) {
+    const auto& positions = shard_positions[shard];
+    if (positions.empty()) {
+      return;
+    }
+    std::vector<int32_t> shard_source_ids;
+    shard_source_ids.reserve(positions.size());
+    for (const auto pos : positions) {
+      shard_source_ids.push_back(source_ids[pos] / shard_count);
+    }
+    std::vector<int32_t> shard_dest_ids;
+    StringDictionaryClient string_client(dict_server_hosts[shard], temp_dict_ref, true);
+    const int32_t shard_dest_generation =
+        dest_generation < 0 ? dest_generation
+                            : to_shard_generation(dest_generation, shard, shard_count);
+    string_client.translate_string_ids(shard_dest_ids,
+                                       dest_dict_ref,
+                                       shard_source_ids,
+                                       source_dict_ref,
+                                       shard_dest_generation);
+    CHECK_EQ(positions.size(), shard_dest_ids.size());
+    for (size_t i = 0; i < positions.size(); ++i) {
+      dest_ids[positions[i]] = to_global_id(shard_dest_ids[i], shard, shard_count);
+    }
+  });
+}
+
+bool checkpoint_string_dictionaries(const std::vector<StringDictionary*>& string_dicts) {
+  // Columns may share a dictionary.
+  std::vector<StringDictionary*> unique_dicts;
+  std::copy_if(string_dicts.begin(),
+               string_dicts.end(),
+               std::back_inserter(unique_dicts),
+               [](const StringDictionary* string_dict) { return string_dict; });
+  std::sort(unique_dicts.begin(), unique_dicts.end());
+  unique_dicts.erase(std::unique(unique_dicts.begin(), unique_dicts.end()),
+                     unique_dicts.end());
+  std::vector<std::future<bool>> checkpoints;
+  for (const auto string_dict : unique_dicts) {
+    checkpoints.push_back(std::async(
+        std::launch::async, [string_dict] { return string_dict->checkpoint(); }));
+  }
+  bool ret = true;
+  for (auto& checkpoint : checkpoints) {
+    ret = checkpoint.get() && ret;
+  }
+  return ret;
 }
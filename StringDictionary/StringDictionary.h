@@ -17,6 +17,7 @@
 #ifndef STRINGDICTIONARY_STRINGDICTIONARY_H
 #define STRINGDICTIONARY_STRINGDICTIONARY_H
 
+#include "../Shared/StringArena.h"
 #include "../Shared/mapd_shared_mutex.h"
 #include "DictRef.h"
 #include "DictionaryCache.hpp"
@@ -27,14 +28,20 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <future>
 #include <map>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 class StringDictionaryClient;
 
+extern bool g_enable_string_dict_trigram_index;
+extern size_t g_string_dict_index_memory_budget;
+
 class DictPayloadUnavailable : public std::runtime_error {
  public:
   DictPayloadUnavailable() : std::runtime_error("DictPayloadUnavailable") {}
@@ -49,11 +56,17 @@ class StringDictionary {
                    const bool recover,
                    size_t initial_capacity = 256);
   StringDictionary(const LeafHostInfo& host, const DictRef dict_ref);
+  // Each of the hosts serves a shard of the dictionary. A string goes to the shard picked
+  // by its hash and the ids are interleaved: shard s hands out s, s + N, s + 2N and so on
+  // for N hosts, so the ids of the dictionary are unique without any coordination.
+  StringDictionary(const std::vector<LeafHostInfo>& hosts, const DictRef dict_ref);
   ~StringDictionary() noexcept;
 
   int32_t getOrAdd(const std::string& str) noexcept;
   template <class T>
   void getOrAddBulk(const std::vector<std::string>& string_vec, T* encoded_vec);
+  template <class T>
+  void getOrAddBulk(const StringArena& strings, T* encoded_vec);
   int32_t getIdOfString(const std::string& str) const;
   std::string getString(int32_t string_id) const;
   std::pair<char*, size_t> getStringBytes(int32_t string_id) const noexcept;
@@ -73,10 +86,17 @@ class StringDictionary {
                                      const char escape,
                                      const size_t generation) const;
 
+  // Position of each string in the sorted order of the dictionary, indexed by id. The
+  // table covers all the strings added so far and is shared until the next one is added;
+  // null for a remote dictionary.
+  std::shared_ptr<const std::vector<int32_t>> getSortedRanks();
+
   std::shared_ptr<const std::vector<std::string>> copyStrings() const;
 
   bool checkpoint() noexcept;
 
+  bool isClient() const noexcept;
+
   static const int32_t INVALID_STR_ID;
   static const size_t MAX_STRLEN = (1 << 15) - 1;
 
@@ -101,31 +121,53 @@ class StringDictionary {
     bool canary;
   };
 
-  void processDictionaryFutures(
-      std::vector<std::future<std::vector<std::pair<unsigned int, unsigned int>>>>&
-          dictionary_futures);
+  // Ids of the strings containing a trigram, in increasing order. The trigrams are case
+  // folded, so the index can narrow down both LIKE and ILIKE.
+  using TrigramIndex = std::unordered_map<uint32_t, std::vector<int32_t>>;
+
+  void buildHashIndex(const size_t str_count) const;
+  bool readHashIndex(const size_t str_count, size_t& indexed_count) const;
+  void writeHashIndex() const;
+  void loadHashIndexIfUnloaded() const;
+  void unloadHashIndex();
+  void touchHashIndex() const noexcept;
+  static void evictColdHashIndexes(const StringDictionary* loaded);
   bool fillRateIsHigh() const noexcept;
   void increaseCapacity() noexcept;
   int32_t getOrAddImpl(const std::string& str) noexcept;
+  template <class T, class Strings>
+  void getOrAddBulkLocal(const Strings& strings, T* encoded_vec);
   template <class T>
   void getOrAddBulkRemote(const std::vector<std::string>& string_vec, T* encoded_vec);
+  // Gathers the ids returned by get_shard_ids(client, shard_generation) for every shard.
+  template <class F>
+  std::vector<int32_t> getMatchingRemote(F get_shard_ids, const size_t generation) const;
   int32_t getUnlocked(const std::string& str) const noexcept;
   std::string getStringUnlocked(int32_t string_id) const noexcept;
   std::string getStringChecked(const int string_id) const noexcept;
   std::pair<char*, size_t> getStringBytesChecked(const int string_id) const noexcept;
   int32_t computeBucket(const size_t hash,
-                        const std::string str,
+                        const boost::string_ref str,
                         const std::vector<int32_t>& data,
                         const bool unique) const noexcept;
   int32_t computeUniqueBucketWithHash(const size_t hash,
                                       const std::vector<int32_t>& data) const noexcept;
-  void appendToStorage(const std::string& str) noexcept;
+  void appendToStorage(const boost::string_ref str) noexcept;
   PayloadString getStringFromStorage(const int string_id) const noexcept;
   void addPayloadCapacity() noexcept;
   void addOffsetCapacity() noexcept;
   size_t addStorageCapacity(int fd) noexcept;
   void* addMemoryCapacity(void* addr, size_t& mem_size) noexcept;
+  void* growStorageMapping(void* addr,
+                           size_t& map_size,
+                           const int fd,
+                           const size_t file_size) noexcept;
   void invalidateInvertedIndex() noexcept;
+  void addToTrigramIndex(const boost::string_ref str, const int32_t string_id) noexcept;
+  void buildTrigramIndex();
+  bool getTrigramCandidates(const std::vector<uint32_t>& trigrams,
+                            const size_t generation,
+                            std::vector<int32_t>& candidates) const;
   std::vector<int32_t> getEquals(std::string pattern,
                                  std::string comp_operator,
                                  size_t generation);
@@ -135,35 +177,69 @@ class StringDictionary {
   void mergeSortedCache(std::vector<int32_t>& temp_sorted_cache);
   compare_cache_value_t* binary_search_cache(const std::string& pattern) const;
 
-  size_t str_count_;
-  std::vector<int32_t> str_ids_;
+  // Readers of the strings take no lock: the storage is append-only and a string is
+  // published by bumping str_count_ after it's written, the maps are replaced when the
+  // storage grows but the previous ones stay valid until the dictionary goes away.
+  std::atomic<size_t> str_count_;
+  // The hash table of the ids, dropped while the dictionary is cold and its memory is
+  // needed for others (see g_string_dict_index_memory_budget) and built again on the
+  // next lookup. It is persisted at checkpoint so building it doesn't take hashing all
+  // the strings again.
+  mutable std::vector<int32_t> str_ids_;
+  mutable bool hash_index_loaded_{true};
+  mutable std::atomic<size_t> hash_index_bytes_{0};
+  // Strings covered by the persisted hash table.
+  mutable std::atomic<size_t> hash_index_str_count_{0};
+  mutable std::atomic<uint64_t> last_access_{0};
+  // Strings and payload bytes flushed by the last checkpoint.
+  std::atomic<size_t> checkpointed_str_count_{0};
+  std::atomic<size_t> checkpointed_payload_off_{0};
+  std::string hash_index_path_;
   std::vector<int32_t> sorted_cache;
+  std::shared_ptr<const std::vector<int32_t>> sorted_ranks_;
   bool isTemp_;
   std::string offsets_path_;
   int payload_fd_;
   int offset_fd_;
-  StringIdxEntry* offset_map_;
-  char* payload_map_;
+  std::atomic<StringIdxEntry*> offset_map_;
+  std::atomic<char*> payload_map_;
   size_t offset_file_size_;
   size_t payload_file_size_;
+  size_t offset_map_size_;
+  size_t payload_map_size_;
   size_t payload_file_off_;
+  std::vector<std::pair<void*, size_t>> retired_maps_;
   mutable mapd_shared_mutex rw_mutex_;
-  mutable std::map<std::tuple<std::string, bool, bool, char>, std::vector<int32_t>>
+  // Guards the LIKE and REGEXP caches, their results are only valid for the generation
+  // in their key.
+  mutable std::mutex cache_mutex_;
+  mutable std::map<std::tuple<std::string, bool, bool, char, size_t>,
+                   std::vector<int32_t>>
       like_cache_;
-  mutable std::map<std::pair<std::string, char>, std::vector<int32_t>> regex_cache_;
+  mutable std::map<std::tuple<std::string, char, size_t>, std::vector<int32_t>>
+      regex_cache_;
   mutable std::map<std::string, int32_t> equal_cache_;
   mutable DictionaryCache<std::string, compare_cache_value_t> compare_cache_;
   mutable std::shared_ptr<std::vector<std::string>> strings_cache_;
-  std::unique_ptr<StringDictionaryClient> client_;
-  std::unique_ptr<StringDictionaryClient> client_no_timeout_;
+  // Only maintained if g_enable_string_dict_trigram_index was set at construction, it
+  // has its own lock so the lookups don't wait for rw_mutex_.
+  bool use_trigram_index_;
+  TrigramIndex trigram_index_;
+  mutable mapd_shared_mutex trigram_index_mutex_;
+  // One per shard of a remote dictionary, empty for a local one.
+  std::vector<std::unique_ptr<StringDictionaryClient>> clients_;
+  std::vector<std::unique_ptr<StringDictionaryClient>> clients_no_timeout_;
 
   static char* CANARY_BUFFER;
 };
 
 int32_t truncate_to_generation(const int32_t id, const size_t generation);
 
+// Checkpoints the dictionaries in parallel, each one once. False if any of them failed.
+bool checkpoint_string_dictionaries(const std::vector<StringDictionary*>& string_dicts);
+
 void translate_string_ids(std::vector<int32_t>& dest_ids,
-                          const LeafHostInfo& dict_server_host,
+                          const std::vector<LeafHostInfo>& dict_server_hosts,
                           const DictRef dest_dict_ref,
                           const std::vector<int32_t>& source_ids,
                           const DictRef source_dict_ref,
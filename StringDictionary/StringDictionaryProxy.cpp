@@ -41,8 +41,7 @@ int32_t truncate_to_generation(const int32_t id, const size_t generation) {
 int32_t StringDictionaryProxy::getOrAddTransient(const std::string& str) {
   mapd_lock_guard<mapd_shared_mutex> write_lock(rw_mutex_);
   CHECK_GE(generation_, 0);
-  auto transient_id =
-      truncate_to_generation(string_dict_->getIdOfString(str), generation_);
+  auto transient_id = getIdOfStringFromDict(str);
   if (transient_id != StringDictionary::INVALID_STR_ID) {
     return transient_id;
   }
@@ -66,7 +65,7 @@ int32_t StringDictionaryProxy::getOrAddTransient(const std::string& str) {
 int32_t StringDictionaryProxy::getIdOfString(const std::string& str) const {
   mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
   CHECK_GE(generation_, 0);
-  auto str_id = truncate_to_generation(string_dict_->getIdOfString(str), generation_);
+  auto str_id = getIdOfStringFromDict(str);
   if (str_id != StringDictionary::INVALID_STR_ID || transient_str_to_int_.empty()) {
     return str_id;
   }
@@ -89,7 +88,7 @@ int32_t StringDictionaryProxy::getIdOfStringNoGeneration(const std::string& str)
 std::string StringDictionaryProxy::getString(int32_t string_id) const {
   mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
   if (string_id >= 0) {
-    return string_dict_->getString(string_id);
+    return getStringFromDict(string_id);
   }
   CHECK_NE(StringDictionary::INVALID_STR_ID, string_id);
   auto it = transient_int_to_str_.find(string_id);
@@ -97,6 +96,41 @@ std::string StringDictionaryProxy::getString(int32_t string_id) const {
   return it->second;
 }
 
+int32_t StringDictionaryProxy::getIdOfStringFromDict(const std::string& str) const {
+  if (!string_dict_->isClient()) {
+    return truncate_to_generation(string_dict_->getIdOfString(str), generation_);
+  }
+  {
+    std::lock_guard<std::mutex> cache_lock(remote_cache_mutex_);
+    const auto it = remote_str_to_id_.find(str);
+    if (it != remote_str_to_id_.end()) {
+      return it->second;
+    }
+  }
+  const auto str_id =
+      truncate_to_generation(string_dict_->getIdOfString(str), generation_);
+  std::lock_guard<std::mutex> cache_lock(remote_cache_mutex_);
+  remote_str_to_id_.emplace(str, str_id);
+  return str_id;
+}
+
+std::string StringDictionaryProxy::getStringFromDict(const int32_t string_id) const {
+  if (!string_dict_->isClient()) {
+    return string_dict_->getString(string_id);
+  }
+  {
+    std::lock_guard<std::mutex> cache_lock(remote_cache_mutex_);
+    const auto it = remote_id_to_str_.find(string_id);
+    if (it != remote_id_to_str_.end()) {
+      return it->second;
+    }
+  }
+  const auto str = string_dict_->getString(string_id);
+  std::lock_guard<std::mutex> cache_lock(remote_cache_mutex_);
+  remote_id_to_str_.emplace(string_id, str);
+  return str;
+}
+
 namespace {
 
 bool is_like(const std::string& str,
@@ -223,6 +257,17 @@ void StringDictionaryProxy::updateGeneration(const ssize_t generation) noexcept
   generation_ = generation;
 }
 
+std::shared_ptr<const std::vector<int32_t>> StringDictionaryProxy::getSortedRanks()
+    const {
+  {
+    mapd_shared_lock<mapd_shared_mutex> read_lock(rw_mutex_);
+    if (!transient_int_to_str_.empty()) {
+      return nullptr;
+    }
+  }
+  return string_dict_->getSortedRanks();
+}
+
 StringDictionary* StringDictionaryProxy::getDictionary() noexcept {
   return string_dict_.get();
 }
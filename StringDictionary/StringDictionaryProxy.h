@@ -25,8 +25,10 @@
 #include "StringDictionary.h"
 
 #include <map>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 // used to access a StringDictionary when transient strings are involved
@@ -56,11 +58,22 @@ class StringDictionaryProxy {
 
   std::vector<int32_t> getRegexpLike(const std::string& pattern, const char escape) const;
 
+  // Ranks of the ids in the order of their strings, null if there are transient strings.
+  std::shared_ptr<const std::vector<int32_t>> getSortedRanks() const;
+
  private:
+  int32_t getIdOfStringFromDict(const std::string& str) const;
+  std::string getStringFromDict(const int32_t string_id) const;
+
   std::shared_ptr<StringDictionary> string_dict_;
   std::map<int32_t, std::string> transient_int_to_str_;
   std::map<std::string, int32_t> transient_str_to_int_;
   ssize_t generation_;
   mutable mapd_shared_mutex rw_mutex_;
+  // Lookups already answered by the server of a remote dictionary. The ids of the
+  // strings don't change and the generation is fixed once set, so they never go stale.
+  mutable std::unordered_map<std::string, int32_t> remote_str_to_id_;
+  mutable std::unordered_map<int32_t, std::string> remote_id_to_str_;
+  mutable std::mutex remote_cache_mutex_;
 };
 #endif  // STRINGDICTIONARY_STRINGDICTIONARYPROXY_H
\ No newline at end of file
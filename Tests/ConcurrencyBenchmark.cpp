@@ -0,0 +1,488 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ConcurrencyBenchmark.cpp
+ * @brief   Throughput and tail latency of a server under a mix of concurrent clients.
+ *
+ * Connects to a running server and, for a fixed duration, runs concurrent clients of
+ * each kind against one table: dashboard queries, streaming inserts through
+ * load_table_binary_columnar as the Kafka and stream importers do, bulk COPY FROM of a
+ * generated file, UPDATE and DELETE statements, and DDL creating and dropping a table.
+ * Each client has a connection of its own, so every operation goes through the locks
+ * of the server as in production: the table locks of the handler, the catalog, the
+ * buffer pools. Reports the operations per second, the p50, p90 and p99 latencies of
+ * each kind and the ingest rate, as JSON. Run once with the dashboard clients alone to
+ * get the baseline the contention of the mixed run compares to. The file of the COPY
+ * clients is written to the temporary directory, the server has to run on this host
+ * to read it.
+ */
+
+#include "../Shared/ThriftClient.h"
+#include "gen-cpp/MapD.h"
+
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <thrift/protocol/TBinaryProtocol.h>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ::apache::thrift;
+using namespace ::apache::thrift::protocol;
+using namespace ::apache::thrift::transport;
+
+namespace {
+
+const std::string g_table_name{"concurrency_benchmark"};
+
+struct ServerOptions {
+  std::string host;
+  int port;
+  std::string user;
+  std::string passwd;
+  std::string db;
+};
+
+// A client of the server with a session of its own.
+class Connection {
+ public:
+  explicit Connection(const ServerOptions& options)
+      : transport_(openBufferedClientTransport(options.host, options.port, "")) {
+    mapd::shared_ptr<TProtocol> protocol(new TBinaryProtocol(transport_));
+    client_.reset(new MapDClient(protocol));
+    transport_->open();
+    client_->connect(session_, options.user, options.passwd, options.db);
+  }
+
+  ~Connection() {
+    try {
+      client_->disconnect(session_);
+      transport_->close();
+    } catch (const TException& e) {
+      LOG(WARNING) << "Could not disconnect: " << e.what();
+    }
+  }
+
+  void sql(const std::string& query_str) {
+    TQueryResult result;
+    client_->sql_execute(result, session_, query_str, true, "", -1, -1);
+  }
+
+  void load(const std::vector<TColumn>& columns) {
+    client_->load_table_binary_columnar(session_, g_table_name, columns);
+  }
+
+ private:
+  mapd::shared_ptr<TTransport> transport_;
+  std::unique_ptr<MapDClient> client_;
+  TSessionId session_;
+};
+
+// Rows of the table, ids from first_id on.
+class RowGenerator {
+ public:
+  explicit RowGenerator(const unsigned seed) : rng_(seed) {}
+
+  std::vector<TColumn> columns(const int64_t first_id, const size_t row_count) {
+    std::uniform_int_distribution<int32_t> quantity_dist(1, 50);
+    std::uniform_real_distribution<double> price_dist(1, 10000);
+    std::uniform_int_distribution<int> category_dist(0, 99);
+    std::uniform_int_distribution<int> name_dist(0, 99999);
+    std::vector<TColumn> columns(5);
+    for (size_t i = 0; i < row_count; ++i) {
+      columns[0].data.int_col.push_back(first_id + i);
+      columns[1].data.int_col.push_back(quantity_dist(rng_));
+      columns[2].data.real_col.push_back(std::round(price_dist(rng_) * 100) / 100);
+      const auto category = category_dist(rng_);
+      const auto name = name_dist(rng_);
+      columns[3].data.str_col.push_back("category_" + std::to_string(category));
+      columns[4].data.str_col.push_back("name_" + std::to_string(name));
+    }
+    for (auto& column : columns) {
+      column.nulls.resize(row_count, false);
+    }
+    return columns;
+  }
+
+ private:
+  std::mt19937_64 rng_;
+};
+
+void write_csv(const std::string& path, const std::vector<TColumn>& columns) {
+  std::ofstream csv(path);
+  csv << "id,quantity,price,category,name\n";
+  for (size_t i = 0; i < columns[0].data.int_col.size(); ++i) {
+    csv << columns[0].data.int_col[i] << "," << columns[1].data.int_col[i] << ","
+        << columns[2].data.real_col[i] << "," << columns[3].data.str_col[i] << ","
+        << columns[4].data.str_col[i] << "\n";
+  }
+}
+
+// Filters, group bys and a top k with random literals, as the widgets of a dashboard
+// send them when a filter changes.
+std::string dashboard_query(std::mt19937_64& rng) {
+  std::uniform_int_distribution<int> query_dist(0, 3);
+  std::uniform_int_distribution<int> quantity_dist(1, 50);
+  std::uniform_int_distribution<int> category_dist(0, 99);
+  const auto quantity = std::to_string(quantity_dist(rng));
+  const auto category = "'category_" + std::to_string(category_dist(rng)) + "'";
+  switch (query_dist(rng)) {
+    case 0:
+      return "SELECT COUNT(*), AVG(price) FROM " + g_table_name + " WHERE quantity < " +
+             quantity + ";";
+    case 1:
+      return "SELECT category, COUNT(*), SUM(price) FROM " + g_table_name +
+             " WHERE quantity > " + quantity + " GROUP BY category;";
+    case 2:
+      return "SELECT name, SUM(price) AS revenue FROM " + g_table_name +
+             " WHERE category = " + category +
+             " GROUP BY name ORDER BY revenue DESC LIMIT 10;";
+    default:
+      return "SELECT quantity, COUNT(*) FROM " + g_table_name +
+             " WHERE category = " + category + " GROUP BY quantity ORDER BY quantity;";
+  }
+}
+
+struct OperationStats {
+  std::vector<double> latencies_ms;
+  size_t errors{0};
+  size_t rows{0};
+};
+
+// An operation of a client, returns the number of rows it inserted.
+using Operation = std::function<size_t(Connection&)>;
+
+// Runs the operation in a loop on its own connection until the deadline.
+OperationStats run_client(const ServerOptions& server_options,
+                          const std::chrono::steady_clock::time_point deadline,
+                          const Operation& operation) {
+  OperationStats stats;
+  Connection connection(server_options);
+  while (std::chrono::steady_clock::now() < deadline) {
+    size_t rows{0};
+    const auto start = std::chrono::steady_clock::now();
+    try {
+      rows = operation(connection);
+    } catch (const TMapDException& e) {
+      LOG(WARNING) << e.error_msg;
+      ++stats.errors;
+      continue;
+    }
+    stats.latencies_ms.push_back(std::chrono::duration<double, std::milli>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+    stats.rows += rows;
+  }
+  return stats;
+}
+
+struct KindResult {
+  std::string kind;
+  size_t clients;
+  OperationStats stats;
+};
+
+double percentile(const std::vector<double>& sorted, const double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+  return sorted[std::max(rank, size_t(1)) - 1];
+}
+
+std::string to_json(const size_t duration_secs,
+                    const unsigned seed,
+                    const std::vector<KindResult>& results) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("duration_secs");
+  writer.Uint64(duration_secs);
+  writer.Key("seed");
+  writer.Uint(seed);
+  writer.Key("results");
+  writer.StartArray();
+  for (const auto& result : results) {
+    auto latencies_ms = result.stats.latencies_ms;
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    writer.StartObject();
+    writer.Key("kind");
+    writer.String(result.kind.c_str());
+    writer.Key("clients");
+    writer.Uint64(result.clients);
+    writer.Key("operations");
+    writer.Uint64(latencies_ms.size());
+    writer.Key("errors");
+    writer.Uint64(result.stats.errors);
+    writer.Key("operations_per_second");
+    writer.Double(static_cast<double>(latencies_ms.size()) / duration_secs);
+    writer.Key("rows_per_second");
+    writer.Double(static_cast<double>(result.stats.rows) / duration_secs);
+    writer.Key("latency_ms");
+    writer.StartObject();
+    writer.Key("p50");
+    writer.Double(percentile(latencies_ms, 0.5));
+    writer.Key("p90");
+    writer.Double(percentile(latencies_ms, 0.9));
+    writer.Key("p99");
+    writer.Double(percentile(latencies_ms, 0.99));
+    writer.Key("max");
+    writer.Double(latencies_ms.empty() ? 0 : latencies_ms.back());
+    writer.EndObject();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ServerOptions server_options{"localhost", 9091, "mapd", "HyperInteractive", "mapd"};
+  size_t duration_secs{60};
+  size_t initial_rows{1000000};
+  unsigned seed{42};
+  size_t dashboard_clients{16};
+  size_t stream_clients{2};
+  size_t stream_batch_rows{1000};
+  size_t copy_clients{1};
+  size_t copy_rows{100000};
+  size_t update_clients{1};
+  size_t ddl_clients{1};
+  std::string output_path;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()("host",
+                     po::value<std::string>(&server_options.host)
+                         ->default_value(server_options.host),
+                     "Host of the server");
+  desc.add_options()(
+      "port",
+      po::value<int>(&server_options.port)->default_value(server_options.port),
+      "Binary port of the server");
+  desc.add_options()("user",
+                     po::value<std::string>(&server_options.user)
+                         ->default_value(server_options.user),
+                     "User name");
+  desc.add_options()("passwd",
+                     po::value<std::string>(&server_options.passwd)
+                         ->default_value(server_options.passwd),
+                     "Password");
+  desc.add_options()(
+      "db",
+      po::value<std::string>(&server_options.db)->default_value(server_options.db),
+      "Database");
+  desc.add_options()("duration",
+                     po::value<size_t>(&duration_secs)->default_value(duration_secs),
+                     "Seconds the clients run for");
+  desc.add_options()("rows",
+                     po::value<size_t>(&initial_rows)->default_value(initial_rows),
+                     "Rows loaded before the clients start");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the data");
+  desc.add_options()(
+      "dashboard-clients",
+      po::value<size_t>(&dashboard_clients)->default_value(dashboard_clients),
+      "Clients running dashboard queries");
+  desc.add_options()("stream-clients",
+                     po::value<size_t>(&stream_clients)->default_value(stream_clients),
+                     "Clients inserting batches through load_table_binary_columnar");
+  desc.add_options()(
+      "stream-batch-rows",
+      po::value<size_t>(&stream_batch_rows)->default_value(stream_batch_rows),
+      "Rows per streamed batch");
+  desc.add_options()("copy-clients",
+                     po::value<size_t>(&copy_clients)->default_value(copy_clients),
+                     "Clients running COPY FROM");
+  desc.add_options()("copy-rows",
+                     po::value<size_t>(&copy_rows)->default_value(copy_rows),
+                     "Rows of the file loaded by each COPY FROM");
+  desc.add_options()("update-clients",
+                     po::value<size_t>(&update_clients)->default_value(update_clients),
+                     "Clients running UPDATE and DELETE statements");
+  desc.add_options()("ddl-clients",
+                     po::value<size_t>(&ddl_clients)->default_value(ddl_clients),
+                     "Clients creating and dropping tables");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: ConcurrencyBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  const auto data_dir =
+      boost::filesystem::temp_directory_path() / "mapd_concurrency_benchmark";
+  boost::filesystem::create_directories(data_dir);
+  const auto csv_path = (data_dir / "concurrency_benchmark.csv").string();
+  RowGenerator generator(seed);
+  try {
+    Connection connection(server_options);
+    connection.sql("DROP TABLE IF EXISTS " + g_table_name + ";");
+    connection.sql("CREATE TABLE " + g_table_name +
+                   " (id BIGINT, quantity INTEGER, price DOUBLE, category TEXT ENCODING "
+                   "DICT, name TEXT ENCODING DICT);");
+    const size_t load_batch_rows{100000};
+    for (size_t loaded = 0; loaded < initial_rows; loaded += load_batch_rows) {
+      const auto row_count = std::min(load_batch_rows, initial_rows - loaded);
+      connection.load(generator.columns(loaded, row_count));
+    }
+    write_csv(csv_path, generator.columns(-static_cast<int64_t>(copy_rows), copy_rows));
+  } catch (const TMapDException& e) {
+    std::cerr << e.error_msg << std::endl;
+    return 1;
+  } catch (const TException& e) {
+    std::cerr << "Thrift error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // Generated up front, out of the measured operations. The ids of the streamed rows
+  // repeat, no query depends on them being unique.
+  std::vector<std::vector<TColumn>> stream_batches;
+  for (size_t i = 0; i < 16; ++i) {
+    stream_batches.push_back(
+        generator.columns(initial_rows + i * stream_batch_rows, stream_batch_rows));
+  }
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(duration_secs);
+  std::vector<std::pair<std::string, std::future<OperationStats>>> clients;
+  const auto start_clients =
+      [&](const std::string& kind, const size_t count, const Operation& operation) {
+        for (size_t i = 0; i < count; ++i) {
+          clients.emplace_back(
+              kind,
+              std::async(
+                  std::launch::async, run_client, server_options, deadline, operation));
+        }
+      };
+  start_clients("dashboard", dashboard_clients, [seed](Connection& connection) {
+    static thread_local std::mt19937_64 rng(
+        seed ^ std::hash<std::thread::id>()(std::this_thread::get_id()));
+    connection.sql(dashboard_query(rng));
+    return size_t(0);
+  });
+  std::atomic<size_t> next_batch{0};
+  start_clients("stream", stream_clients, [&](Connection& connection) {
+    connection.load(stream_batches[next_batch++ % stream_batches.size()]);
+    return stream_batch_rows;
+  });
+  start_clients("copy", copy_clients, [&csv_path, copy_rows](Connection& connection) {
+    connection.sql("COPY " + g_table_name + " FROM '" + csv_path +
+                   "' WITH (header='true');");
+    return copy_rows;
+  });
+  start_clients("update_delete", update_clients, [seed](Connection& connection) {
+    static thread_local std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<int> key_dist(0, 999);
+    const auto key = std::to_string(key_dist(rng));
+    if (rng() % 2) {
+      connection.sql("UPDATE " + g_table_name +
+                     " SET price = price + 1 WHERE MOD(id, 1000) = " + key + ";");
+    } else {
+      connection.sql("DELETE FROM " + g_table_name + " WHERE MOD(id, 100000) = " + key +
+                     ";");
+    }
+    return size_t(0);
+  });
+  std::atomic<size_t> next_ddl_table{0};
+  start_clients("ddl", ddl_clients, [&next_ddl_table](Connection& connection) {
+    const auto table_name = g_table_name + "_ddl_" + std::to_string(next_ddl_table++);
+    connection.sql("CREATE TABLE " + table_name +
+                   " (id BIGINT, name TEXT ENCODING DICT);");
+    connection.sql("DROP TABLE " + table_name + ";");
+    return size_t(0);
+  });
+
+  std::vector<KindResult> results;
+  for (auto& client : clients) {
+    OperationStats stats;
+    try {
+      stats = client.second.get();
+    } catch (const TException& e) {
+      std::cerr << "Thrift error: " << e.what() << std::endl;
+      return 1;
+    }
+    auto result_it =
+        std::find_if(results.begin(), results.end(), [&client](const KindResult& r) {
+          return r.kind == client.first;
+        });
+    if (result_it == results.end()) {
+      results.push_back({client.first, 0, {}});
+      result_it = results.end() - 1;
+    }
+    ++result_it->clients;
+    auto& kind_stats = result_it->stats;
+    kind_stats.latencies_ms.insert(kind_stats.latencies_ms.end(),
+                                   stats.latencies_ms.begin(),
+                                   stats.latencies_ms.end());
+    kind_stats.errors += stats.errors;
+    kind_stats.rows += stats.rows;
+  }
+  for (const auto& result : results) {
+    auto latencies_ms = result.stats.latencies_ms;
+    std::sort(latencies_ms.begin(), latencies_ms.end());
+    std::cerr << std::left << std::setw(14) << result.kind << std::right << std::setw(8)
+              << latencies_ms.size() << " ops" << std::fixed << std::setprecision(1)
+              << std::setw(10) << percentile(latencies_ms, 0.5) << " ms p50"
+              << std::setw(10) << percentile(latencies_ms, 0.99) << " ms p99"
+              << std::endl;
+  }
+
+  try {
+    Connection(server_options).sql("DROP TABLE IF EXISTS " + g_table_name + ";");
+  } catch (const TException& e) {
+    LOG(WARNING) << "Could not drop " << g_table_name << ": " << e.what();
+  }
+  boost::filesystem::remove_all(data_dir);
+
+  const auto json = to_json(duration_secs, seed, results);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <DataMgr/BufferMgr/CompressedChunkCache.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+using namespace Buffer_Namespace;
+
+namespace {
+
+// Small integers, as compressible as a typical fixed width column.
+std::vector<int8_t> make_chunk(const size_t size, const int seed) {
+  std::vector<int8_t> chunk(size);
+  for (size_t i = 0; i < size; i += 4) {
+    chunk[i] = (i / 4 * 7 + seed) % 100;
+  }
+  return chunk;
+}
+
+}  // namespace
+
+TEST(CompressedChunkCache, TakeCompressed) {
+  CompressedChunkCache cache(1 << 20);
+  const auto chunk = make_chunk(256 << 10, 1);
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  cache.flush();
+  ASSERT_LT(cache.getBytes(), chunk.size() / 2);
+
+  std::vector<int8_t> prefix(1000);
+  ASSERT_TRUE(cache.take({1, 1, 1, 0}, prefix.data(), prefix.size()));
+  ASSERT_TRUE(std::equal(prefix.begin(), prefix.end(), chunk.begin()));
+  // Taking a chunk drops it.
+  ASSERT_FALSE(cache.take({1, 1, 1, 0}, prefix.data(), prefix.size()));
+  ASSERT_EQ(0u, cache.getBytes());
+  ASSERT_EQ(1u, cache.getNumHits());
+}
+
+TEST(CompressedChunkCache, TakeWhole) {
+  CompressedChunkCache cache(1 << 20);
+  const auto chunk = make_chunk(100 << 10, 2);
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  std::vector<int8_t> more(chunk.size() + 1);
+  ASSERT_FALSE(cache.take({1, 1, 1, 0}, more.data(), more.size()));
+
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  std::vector<int8_t> whole(chunk.size());
+  ASSERT_TRUE(cache.take({1, 1, 1, 0}, whole.data(), whole.size()));
+  ASSERT_EQ(chunk, whole);
+}
+
+TEST(CompressedChunkCache, Eviction) {
+  const auto chunk = make_chunk(100 << 10, 3);
+  size_t compressed_size;
+  {
+    CompressedChunkCache cache(1 << 20);
+    cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+    cache.flush();
+    compressed_size = cache.getBytes();
+  }
+  // A chunk takes its full size until compressed.
+  CompressedChunkCache cache(chunk.size() + compressed_size);
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  cache.flush();
+  cache.put({1, 1, 1, 1}, chunk.data(), chunk.size());
+  ASSERT_EQ(2u, cache.getNumChunks());
+
+  CompressedChunkCache small_cache(chunk.size() + compressed_size - 1);
+  small_cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  small_cache.flush();
+  small_cache.put({1, 1, 1, 1}, chunk.data(), chunk.size());
+  ASSERT_EQ(1u, small_cache.getNumChunks());
+  std::vector<int8_t> dst(chunk.size());
+  ASSERT_FALSE(small_cache.take({1, 1, 1, 0}, dst.data(), dst.size()));
+  ASSERT_TRUE(small_cache.take({1, 1, 1, 1}, dst.data(), dst.size()));
+}
+
+TEST(CompressedChunkCache, ErasePrefix) {
+  CompressedChunkCache cache(1 << 20);
+  const auto chunk = make_chunk(10 << 10, 4);
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  cache.put({1, 1, 2, 0}, chunk.data(), chunk.size());
+  cache.put({1, 2, 1, 0}, chunk.data(), chunk.size());
+  cache.erase({1, 1});
+  cache.flush();
+  ASSERT_EQ(1u, cache.getNumChunks());
+  std::vector<int8_t> dst(chunk.size());
+  ASSERT_TRUE(cache.take({1, 2, 1, 0}, dst.data(), dst.size()));
+}
+
+TEST(CompressedChunkCache, Incompressible) {
+  CompressedChunkCache cache(1 << 20);
+  std::vector<int8_t> chunk(10 << 10);
+  unsigned int state = 12345;
+  for (auto& byte : chunk) {
+    state = state * 1103515245 + 12345;
+    byte = state >> 24;
+  }
+  cache.put({1, 1, 1, 0}, chunk.data(), chunk.size());
+  cache.flush();
+  ASSERT_EQ(0u, cache.getNumChunks());
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+  return err;
+}
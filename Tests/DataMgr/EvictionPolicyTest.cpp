@@ -0,0 +1,88 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <DataMgr/BufferMgr/EvictionPolicy.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+using namespace Buffer_Namespace;
+
+namespace {
+
+BufferSeg make_seg(const ChunkKey& key,
+                   const unsigned int last_touched,
+                   const unsigned int touch_count) {
+  BufferSeg seg(0, 1, USED, last_touched);
+  seg.chunkKey = key;
+  seg.touchCount = touch_count;
+  return seg;
+}
+
+}  // namespace
+
+TEST(EvictionPolicy, Lru) {
+  auto policy = create_eviction_policy("lru");
+  const auto old_hot = make_seg({1, 1, 1, 0}, 10, 20);
+  const auto new_cold = make_seg({1, 2, 1, 0}, 20, 1);
+  ASSERT_LT(policy->score(old_hot), policy->score(new_cold));
+  ASSERT_EQ(0u, policy->admit({1, 2, 1, 0}));
+}
+
+TEST(EvictionPolicy, TwoQueueScanResistance) {
+  auto policy = create_eviction_policy("2q");
+  const auto old_hot = make_seg({1, 1, 1, 0}, 10, 2);
+  const auto new_cold = make_seg({1, 2, 1, 0}, 20, 1);
+  const auto newer_cold = make_seg({1, 2, 1, 1}, 30, 1);
+  ASSERT_LT(policy->score(new_cold), policy->score(old_hot));
+  ASSERT_LT(policy->score(new_cold), policy->score(newer_cold));
+}
+
+TEST(EvictionPolicy, TwoQueueGhosts) {
+  TwoQueueEvictionPolicy policy(2);
+  policy.evicted(make_seg({1, 2, 1, 0}, 20, 1));
+  // Chunks touched more than once and unkeyed allocations aren't remembered.
+  policy.evicted(make_seg({1, 1, 1, 0}, 10, 2));
+  policy.evicted(make_seg({-1, 0}, 5, 1));
+  ASSERT_EQ(0u, policy.admit({1, 1, 1, 0}));
+  ASSERT_EQ(0u, policy.admit({-1, 0}));
+  ASSERT_EQ(1u, policy.admit({1, 2, 1, 0}));
+  // Admitting a chunk consumes its ghost entry.
+  ASSERT_EQ(0u, policy.admit({1, 2, 1, 0}));
+  // Older ghosts are forgotten first.
+  policy.evicted(make_seg({1, 3, 1, 0}, 20, 1));
+  policy.evicted(make_seg({1, 3, 1, 1}, 20, 1));
+  policy.evicted(make_seg({1, 3, 1, 2}, 20, 1));
+  ASSERT_EQ(0u, policy.admit({1, 3, 1, 0}));
+  ASSERT_EQ(1u, policy.admit({1, 3, 1, 2}));
+}
+
+TEST(EvictionPolicy, UnknownPolicy) {
+  ASSERT_THROW(create_eviction_policy("mru"), std::runtime_error);
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+  return err;
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <DataMgr/FileMgr/ColdStorage.h>
+#include <DataMgr/FileMgr/File.h>
+#include <DataMgr/FileMgr/GlobalFileMgr.h>
+#include <DataMgr/FileMgr/HeaderIndex.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace File_Namespace;
+
+namespace {
+
+const size_t PAGE_SIZE{64};
+const size_t HEADER_SIZE{8};
+const size_t PAGE_DATA_SIZE{PAGE_SIZE - HEADER_SIZE};
+
+// Writes num_pages pages with a header of -1 bytes and returns the concatenated data.
+std::vector<int8_t> write_pages(FILE* f, const size_t num_pages) {
+  std::vector<int8_t> pages(PAGE_SIZE * num_pages);
+  std::vector<int8_t> data;
+  for (size_t page_num = 0; page_num < num_pages; ++page_num) {
+    for (size_t i = 0; i < PAGE_SIZE; ++i) {
+      const int8_t val = i < HEADER_SIZE ? -1 : (page_num * 7 + i) % 100;
+      pages[page_num * PAGE_SIZE + i] = val;
+      if (i >= HEADER_SIZE) {
+        data.push_back(val);
+      }
+    }
+  }
+  CHECK_EQ(pages.size(), fwrite(pages.data(), 1, pages.size(), f));
+  fflush(f);
+  return data;
+}
+
+std::string create_temp_dir() {
+  const auto path = boost::filesystem::temp_directory_path() /
+                    boost::filesystem::unique_path("header_index_%%%%-%%%%");
+  boost::filesystem::create_directory(path);
+  return path.string() + "/";
+}
+
+std::vector<int8_t> make_data(const size_t size, const int seed) {
+  std::vector<int8_t> data(size);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = (i * 13 + seed) % 127;
+  }
+  return data;
+}
+
+size_t count_files(const std::string& dir) {
+  size_t num_files = 0;
+  for (boost::filesystem::recursive_directory_iterator it(dir), end; it != end; ++it) {
+    if (boost::filesystem::is_regular_file(it->status())) {
+      ++num_files;
+    }
+  }
+  return num_files;
+}
+
+bool same_header(const HeaderInfo& lhs, const HeaderInfo& rhs) {
+  return lhs.chunkKey == rhs.chunkKey && lhs.pageId == rhs.pageId &&
+         lhs.versionEpoch == rhs.versionEpoch && lhs.page.fileId == rhs.page.fileId &&
+         lhs.page.pageNum == rhs.page.pageNum;
+}
+
+}  // namespace
+
+TEST(File, ReadPagesData) {
+  FILE* f = tmpfile();
+  ASSERT_TRUE(f);
+  // More pages than fit in a single vectored read.
+  const size_t num_pages{3000};
+  const auto data = write_pages(f, num_pages);
+  for (const size_t start_page : {0, 1, 5}) {
+    for (const size_t start_offset : {0, 3, 55}) {
+      const auto max_size = (num_pages - start_page) * PAGE_DATA_SIZE - start_offset;
+      for (const size_t size : std::vector<size_t>{1,
+                                                   10,
+                                                   PAGE_DATA_SIZE - start_offset,
+                                                   PAGE_DATA_SIZE + 1,
+                                                   1000 * PAGE_DATA_SIZE,
+                                                   max_size}) {
+        std::vector<int8_t> buf(size);
+        ASSERT_EQ(size,
+                  readPagesData(
+                      f, PAGE_SIZE, HEADER_SIZE, start_page, start_offset, size, &buf[0]));
+        const auto data_begin =
+            data.begin() + start_page * PAGE_DATA_SIZE + start_offset;
+        ASSERT_TRUE(std::equal(buf.begin(), buf.end(), data_begin));
+      }
+    }
+  }
+  fclose(f);
+}
+
+TEST(HeaderIndex, WriteRead) {
+  const auto dir = create_temp_dir();
+  const std::vector<HeaderIndexFile> files{{0, 4096, 256}, {1, 2097152, 256}};
+  std::vector<HeaderInfo> headers;
+  headers.emplace_back(ChunkKey{1, 2, 3, 4}, -1, 1, Page(0, 0));
+  headers.emplace_back(ChunkKey{1, 2, 3, 4}, 0, 1, Page(1, 0));
+  headers.emplace_back(ChunkKey{1, 2, 3, 4}, 0, 2, Page(1, 7));
+  headers.emplace_back(ChunkKey{1, 2, 5, 1, 2}, -1, 2, Page(0, 1));
+  headers.emplace_back(ChunkKey{1, 2, 5, 1, 2}, 0, 2, Page(1, 255));
+  ASSERT_TRUE(writeHeaderIndex(dir, 3, files, headers));
+  ASSERT_TRUE(headerIndexExists(dir));
+
+  // The files can be listed in any order, and the epoch can be later.
+  for (const int epoch : {3, 10}) {
+    std::vector<HeaderInfo> readHeaders;
+    ASSERT_TRUE(readHeaderIndex(
+        dir, epoch, std::vector<HeaderIndexFile>{files[1], files[0]}, readHeaders));
+    ASSERT_EQ(headers.size(), readHeaders.size());
+    ASSERT_TRUE(
+        std::equal(headers.begin(), headers.end(), readHeaders.begin(), same_header));
+  }
+
+  std::vector<HeaderInfo> readHeaders;
+  // Written after the epoch the table is opened at.
+  ASSERT_FALSE(readHeaderIndex(dir, 2, files, readHeaders));
+  // A file was added or grew since.
+  const std::vector<HeaderIndexFile> added_files{files[0], files[1], {2, 4096, 256}};
+  ASSERT_FALSE(readHeaderIndex(dir, 3, added_files, readHeaders));
+  const std::vector<HeaderIndexFile> grown_files{files[0], {1, 2097152, 512}};
+  ASSERT_FALSE(readHeaderIndex(dir, 3, grown_files, readHeaders));
+  ASSERT_TRUE(readHeaders.empty());
+
+  removeHeaderIndex(dir);
+  ASSERT_FALSE(headerIndexExists(dir));
+  ASSERT_FALSE(readHeaderIndex(dir, 3, files, readHeaders));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(HeaderIndex, Corrupt) {
+  const auto dir = create_temp_dir();
+  const std::vector<HeaderIndexFile> files{{0, 4096, 16}};
+  std::vector<HeaderInfo> headers;
+  headers.emplace_back(ChunkKey{1, 2, 3, 4}, -1, 1, Page(0, 3));
+  ASSERT_TRUE(writeHeaderIndex(dir, 2, files, headers));
+  const auto path = dir + "header_index";
+  const auto size = boost::filesystem::file_size(path);
+  for (const size_t offset : std::vector<size_t>{0, 20, size - 1}) {
+    ASSERT_TRUE(writeHeaderIndex(dir, 2, files, headers));
+    FILE* f = fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(f);
+    int8_t byte;
+    fseek(f, offset, SEEK_SET);
+    ASSERT_EQ(size_t(1), fread(&byte, 1, 1, f));
+    byte = ~byte;
+    fseek(f, offset, SEEK_SET);
+    ASSERT_EQ(size_t(1), fwrite(&byte, 1, 1, f));
+    fclose(f);
+    std::vector<HeaderInfo> readHeaders;
+    ASSERT_FALSE(readHeaderIndex(dir, 2, files, readHeaders));
+  }
+  boost::filesystem::resize_file(path, size / 2);
+  std::vector<HeaderInfo> readHeaders;
+  ASSERT_FALSE(readHeaderIndex(dir, 2, files, readHeaders));
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(ColdStorage, ReadThroughCache) {
+  const auto dir = create_temp_dir();
+  const auto data = make_data(1000, 1);
+  const auto path = dir + "file";
+  FILE* f = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(f);
+  ASSERT_EQ(data.size(), fwrite(data.data(), 1, data.size(), f));
+  fclose(f);
+
+  const size_t block_size{64};
+  const size_t cache_bytes{256};
+  const size_t prefetch_blocks{2};
+  ColdStorage cold_storage(create_object_store(dir + "objects", ""),
+                           dir + "cache",
+                           cache_bytes,
+                           block_size,
+                           prefetch_blocks);
+  cold_storage.upload("1_2/file", path);
+  for (const size_t offset : {0, 63, 64, 500, 999}) {
+    for (const size_t size : {1, 64, 65, 300}) {
+      if (offset + size > data.size()) {
+        continue;
+      }
+      std::vector<int8_t> buf(size);
+      cold_storage.read("1_2/file", data.size(), offset, size, buf.data());
+      ASSERT_TRUE(std::equal(buf.begin(), buf.end(), data.begin() + offset));
+      // Prefetched blocks may be in flight still.
+      ASSERT_LE(cold_storage.getCachedBytes(),
+                cache_bytes + (prefetch_blocks + 1) * block_size);
+    }
+  }
+
+  cold_storage.remove("1_2/file");
+  ASSERT_EQ(size_t(0), cold_storage.getCachedBytes());
+  std::vector<int8_t> buf(10);
+  ASSERT_THROW(cold_storage.read("1_2/file", data.size(), 0, buf.size(), buf.data()),
+               std::runtime_error);
+  boost::filesystem::remove_all(dir);
+}
+
+TEST(ColdStorage, DataFiles) {
+  const auto dir = create_temp_dir();
+  g_cold_storage_url = dir + "objects";
+  const auto cold_file_age_seconds = g_cold_file_age_seconds;
+  g_cold_file_age_seconds = 0;
+  const ChunkKey key{1, 2, 3, 4};
+  const size_t page_size{65536};
+  // Spans several pages, the last one partially.
+  auto data = make_data(5 * page_size, 2);
+  {
+    GlobalFileMgr gfm(0, dir + "data", 0, page_size);
+    auto buffer = gfm.createBuffer(key);
+    buffer->append(data.data(), data.size());
+    gfm.checkpoint(1, 2);
+    ASSERT_GT(gfm.offloadColdFiles(), size_t(0));
+    ASSERT_EQ(size_t(0), gfm.offloadColdFiles());
+
+    std::vector<int8_t> buf(data.size());
+    buffer->read(buf.data(), buf.size());
+    ASSERT_EQ(data, buf);
+
+    // Written to, the last page gets local again.
+    auto more_data = make_data(page_size, 3);
+    buffer->append(more_data.data(), more_data.size());
+    data.insert(data.end(), more_data.begin(), more_data.end());
+    gfm.checkpoint(1, 2);
+  }
+  {
+    GlobalFileMgr gfm(0, dir + "data", 0, page_size);
+    auto buffer = gfm.getBuffer(key);
+    ASSERT_EQ(data.size(), buffer->size());
+    std::vector<int8_t> buf(data.size());
+    buffer->read(buf.data(), buf.size());
+    ASSERT_EQ(data, buf);
+    ASSERT_GT(count_files(dir + "objects"), size_t(0));
+    gfm.removeTableRelatedDS(1, 2);
+  }
+  ASSERT_EQ(size_t(0), count_files(dir + "objects"));
+  g_cold_storage_url.clear();
+  g_cold_file_age_seconds = cold_file_age_seconds;
+  boost::filesystem::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+  return err;
+}
@@ -19,11 +19,15 @@
 #include "../Import/Importer.h"
 #include "../Parser/parser.h"
 #include "../QueryEngine/ArrowResultSet.h"
+#include "../QueryEngine/ColumnarResultsCache.h"
 #include "../QueryEngine/Execute.h"
+#include "../QueryEngine/QueryMemoryAccount.h"
+#include "../QueryEngine/QueryResultCache.h"
 #include "../QueryEngine/RelAlgExecutionDescriptor.h"
 #include "../QueryRunner/QueryRunner.h"
 #include "../Shared/ConfigResolve.h"
 #include "../Shared/TimeGM.h"
+#include "../Shared/scope.h"
 #include "../SqliteConnector/SqliteConnector.h"
 #include "DistributedLoader.h"
 
@@ -32,8 +36,10 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/any.hpp>
 #include <boost/program_options.hpp>
+#include <chrono>
 #include <cmath>
 #include <sstream>
+#include <thread>
 
 #ifndef BASE_PATH
 #define BASE_PATH "./tmp"
@@ -47,6 +53,9 @@ extern bool g_multi_subquery_exc;
 
 extern int g_test_against_columnId_gap;
 extern bool g_enable_smem_group_by;
+extern bool g_enable_mapped_chunks;
+extern int g_file_page_compression_level;
+extern bool g_enable_chunk_bloom_filters;
 
 namespace {
 
@@ -788,6 +797,10 @@ TEST(Select, FilterAndSimpleAggregation) {
       c("SELECT COUNT(*), z FROM test where x = 7 GROUP BY z ORDER BY z DESC;", dt);
       c("SELECT z as z0, z as z1, COUNT(*) FROM test GROUP BY z0, z1 ORDER BY z0 DESC;",
         dt);
+      c("SELECT y, SUM(x) FROM test GROUP BY y ORDER BY y DESC;", dt);
+      c("SELECT SUM(x), COUNT(*) FROM test GROUP BY z ORDER BY z DESC;", dt);
+      c("SELECT str, COUNT(*), SUM(x + 1) FROM test GROUP BY str ORDER BY str DESC;",
+        dt);
       ;
     }
   }
@@ -945,6 +958,817 @@ TEST(Select, FilterAndMultipleAggregation) {
   }
 }
 
+TEST(Select, CpuMorsels) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_cpu_morsels_state = g_enable_cpu_morsels;
+  const auto cpu_morsel_size_state = g_cpu_morsel_size;
+  ScopeGuard reset_morsels = [&enable_cpu_morsels_state, &cpu_morsel_size_state] {
+    g_enable_cpu_morsels = enable_cpu_morsels_state;
+    g_cpu_morsel_size = cpu_morsel_size_state;
+  };
+  g_enable_cpu_morsels = true;
+  g_cpu_morsel_size = 3;
+  const auto dt = ExecutorDeviceType::CPU;
+  c("SELECT COUNT(*) FROM test;", dt);
+  c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x + y) FROM test WHERE z > 100;", dt);
+  c("SELECT AVG(x), AVG(y) FROM test;", dt);
+  c("SELECT x, COUNT(*) FROM test GROUP BY x ORDER BY x;", dt);
+  c("SELECT y, SUM(x) FROM test WHERE x > 6 GROUP BY y ORDER BY y;", dt);
+}
+
+TEST(Select, TieredCpuCodegen) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_tiered_codegen_state = g_enable_tiered_cpu_codegen;
+  ScopeGuard reset_tiered_codegen = [&enable_tiered_codegen_state] {
+    g_enable_tiered_cpu_codegen = enable_tiered_codegen_state;
+  };
+  g_enable_tiered_cpu_codegen = true;
+  const auto dt = ExecutorDeviceType::CPU;
+  // Run each query past the promotion count to cover both the quick and optimized code.
+  for (size_t i = 0; i <= g_tiered_codegen_promotion_count; ++i) {
+    c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x + y) FROM test WHERE z > 100;", dt);
+    c("SELECT x, COUNT(*) FROM test GROUP BY x ORDER BY x;", dt);
+    c("SELECT str, MIN(y) FROM test WHERE y IS NOT NULL GROUP BY str ORDER BY str;", dt);
+  }
+}
+
+TEST(Select, BatchedCpuCodegen) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_batched_codegen_state = g_enable_batched_cpu_codegen;
+  ScopeGuard reset_batched_codegen = [&enable_batched_codegen_state] {
+    g_enable_batched_cpu_codegen = enable_batched_codegen_state;
+  };
+  g_enable_batched_cpu_codegen = true;
+  const auto dt = ExecutorDeviceType::CPU;
+  c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x) FROM test WHERE z > 100;", dt);
+  c("SELECT COUNT(*), AVG(y) FROM test WHERE x = 7 OR y > 42;", dt);
+  c("SELECT COUNT(*), SUM(z) FROM test WHERE NOT (x < 8) AND y IS NOT NULL;", dt);
+  c("SELECT COUNT(*) FROM test WHERE ofd IS NULL;", dt);
+  c("SELECT COUNT(*) FROM test WHERE x > 100;", dt);
+  // Not eligible, runs the per row template.
+  c("SELECT COUNT(*), MAX(x) FROM test WHERE str = 'foo';", dt);
+}
+
+TEST(Select, ExpressionCse) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_expression_cse_state = g_enable_expression_cse;
+  ScopeGuard reset_expression_cse = [&enable_expression_cse_state] {
+    g_enable_expression_cse = enable_expression_cse_state;
+  };
+  g_enable_expression_cse = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT x + y, COUNT(*) FROM test WHERE x + y > 48 GROUP BY x + y ORDER BY x + y;",
+      dt);
+    c("SELECT SUM(x * 2), MAX(x * 2), MIN(CAST(x AS BIGINT) * 2) FROM test;", dt);
+    c("SELECT CASE WHEN x > 7 THEN y ELSE z END AS k, SUM(CASE WHEN x > 7 THEN y ELSE z "
+      "END) FROM test WHERE CASE WHEN x > 7 THEN y ELSE z END > 0 GROUP BY k ORDER BY k;",
+      dt);
+    c("SELECT SUM(CASE WHEN x + y > 50 THEN x + y ELSE 0 END), SUM(x + y) FROM test;",
+      dt);
+    ASSERT_EQ(
+        2 * g_num_rows,
+        v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM test WHERE EXTRACT(HOUR FROM m) "
+                                  "> 0 AND EXTRACT(HOUR FROM m) < 24;",
+                                  dt)));
+    const auto rows = run_multiple_agg(
+        "SELECT EXTRACT(HOUR FROM m) AS h, COUNT(*) FROM test WHERE EXTRACT(HOUR FROM m) "
+        "> 0 GROUP BY h;",
+        dt);
+    ASSERT_EQ(size_t(1), rows->rowCount());
+  }
+}
+
+TEST(Select, AdaptiveFilterOrdering) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_adaptive_filter_ordering_state = g_enable_adaptive_filter_ordering;
+  ScopeGuard reset_adaptive_filter_ordering = [&enable_adaptive_filter_ordering_state] {
+    g_enable_adaptive_filter_ordering = enable_adaptive_filter_ordering_state;
+  };
+  g_enable_adaptive_filter_ordering = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT COUNT(*) FROM test WHERE str LIKE '%o%' AND x + y > 49;", dt);
+    c("SELECT SUM(x) FROM test WHERE x + y > 49 AND str LIKE 'ba%' AND y - x > 0;", dt);
+    c("SELECT COUNT(*) FROM test WHERE x + y < 0 AND str LIKE '%a%';", dt);
+    c("SELECT x, y FROM test WHERE x * 2 > y - 30 AND str NOT LIKE 'f%' ORDER BY x, y;",
+      dt);
+  }
+}
+
+TEST(Select, FragmentBoundedGroupBy) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_fragment_bounded_group_by_state = g_enable_fragment_bounded_group_by;
+  ScopeGuard reset_fragment_bounded_group_by = [&enable_fragment_bounded_group_by_state] {
+    g_enable_fragment_bounded_group_by = enable_fragment_bounded_group_by_state;
+  };
+  g_enable_fragment_bounded_group_by = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT x, y, COUNT(*) FROM test GROUP BY x, y ORDER BY x, y;", dt);
+    c("SELECT str, f, SUM(x) FROM test GROUP BY str, f ORDER BY str, f;", dt);
+    c("SELECT x, z, MAX(y) FROM test WHERE y > 40 GROUP BY x, z ORDER BY x, z;", dt);
+  }
+}
+
+TEST(Select, ChunkPrefetch) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_chunk_prefetch_state = g_enable_chunk_prefetch;
+  ScopeGuard reset_chunk_prefetch = [&enable_chunk_prefetch_state] {
+    g_enable_chunk_prefetch = enable_chunk_prefetch_state;
+  };
+  g_enable_chunk_prefetch = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x + y) FROM test WHERE z > 100;", dt);
+    c("SELECT x, COUNT(*) FROM test GROUP BY x ORDER BY x;", dt);
+    c("SELECT str, MIN(y) FROM test WHERE y IS NOT NULL GROUP BY str ORDER BY str;", dt);
+    c("SELECT x, y FROM test WHERE x > 7 ORDER BY x, y LIMIT 5;", dt);
+  }
+}
+
+TEST(Select, HybridExecution) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_hybrid_execution_state = g_enable_hybrid_execution;
+  ScopeGuard reset_hybrid_execution = [&enable_hybrid_execution_state] {
+    g_enable_hybrid_execution = enable_hybrid_execution_state;
+  };
+  g_enable_hybrid_execution = true;
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT COUNT(*) FROM test WHERE x > 7;", dt);
+    c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x + y) FROM test WHERE z > 100;", dt);
+    c("SELECT AVG(x), AVG(f), MIN(d), MAX(d) FROM test;", dt);
+    c("SELECT SUM(x) FROM test WHERE str = 'foo';", dt);
+  }
+}
+
+TEST(Select, ResidencyAwarePlacement) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_residency_aware_placement_state = g_enable_residency_aware_placement;
+  ScopeGuard reset_residency_aware_placement = [&enable_residency_aware_placement_state] {
+    g_enable_residency_aware_placement = enable_residency_aware_placement_state;
+  };
+  g_enable_residency_aware_placement = true;
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    // The second round finds the columns of the first one resident.
+    for (size_t i = 0; i < 2; ++i) {
+      c("SELECT COUNT(*), SUM(x), MAX(y) FROM test WHERE z > 100;", dt);
+      c("SELECT x, COUNT(*) FROM test GROUP BY x ORDER BY x;", dt);
+      c("SELECT str, SUM(y) FROM test GROUP BY str ORDER BY str;", dt);
+    }
+  }
+}
+
+TEST(Select, GpuStringDictionaries) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_gpu_string_dictionaries_state = g_enable_gpu_string_dictionaries;
+  ScopeGuard reset_gpu_string_dictionaries = [&enable_gpu_string_dictionaries_state] {
+    g_enable_gpu_string_dictionaries = enable_gpu_string_dictionaries_state;
+  };
+  g_enable_gpu_string_dictionaries = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT COUNT(*) FROM test WHERE str = real_str;", dt);
+    c("SELECT COUNT(*) FROM test WHERE str < real_str;", dt);
+    c("SELECT COUNT(*) FROM test WHERE LENGTH(str) = 3;", dt);
+    c("SELECT x, COUNT(*) FROM test WHERE real_str > str GROUP BY x ORDER BY x;", dt);
+    ASSERT_EQ(2 * g_num_rows,
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM test WHERE CHAR_LENGTH(str) = 3;", dt)));
+  }
+  Executor::clearGpuStringDictionaries();
+}
+
+TEST(Select, MappedChunks) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_mapped_chunks_state = g_enable_mapped_chunks;
+  ScopeGuard reset_mapped_chunks = [&enable_mapped_chunks_state] {
+    g_enable_mapped_chunks = enable_mapped_chunks_state;
+  };
+  g_enable_mapped_chunks = true;
+  // Evict the chunks from the CPU pool so the scans use the views of the data files.
+  g_session->get_catalog().get_dataMgr().clearMemory(Data_Namespace::MemoryLevel::CPU_LEVEL);
+  const auto dt = ExecutorDeviceType::CPU;
+  c("SELECT COUNT(*), MIN(x), MAX(y), SUM(x + y) FROM test WHERE z > 100;", dt);
+  c("SELECT x, COUNT(*) FROM test GROUP BY x ORDER BY x;", dt);
+  c("SELECT str, MIN(y) FROM test WHERE y IS NOT NULL GROUP BY str ORDER BY str;", dt);
+  c("SELECT real_str FROM test WHERE x > 7 ORDER BY real_str LIMIT 5;", dt);
+}
+
+TEST(Select, CompressedPages) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto file_page_compression_level_state = g_file_page_compression_level;
+  ScopeGuard reset_file_page_compression_level = [&file_page_compression_level_state] {
+    g_file_page_compression_level = file_page_compression_level_state;
+  };
+  g_file_page_compression_level = 1;
+  run_ddl_statement("DROP TABLE IF EXISTS compressed_pages;");
+  // Small pages, so the rows below fill up a few of them.
+  run_ddl_statement(
+      "CREATE TABLE compressed_pages (x INT, y BIGINT) WITH (page_size=256);");
+  for (int i = 0; i < 64; ++i) {
+    run_multiple_agg("INSERT INTO compressed_pages VALUES(" + std::to_string(i % 4) +
+                         ", " + std::to_string(i % 2 * 1000) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    // Read the chunks back from disk.
+    g_session->get_catalog().get_dataMgr().clearMemory(
+        Data_Namespace::MemoryLevel::CPU_LEVEL);
+    ASSERT_EQ(int64_t(96),
+              v<int64_t>(run_simple_agg("SELECT SUM(x) FROM compressed_pages;", dt)));
+    ASSERT_EQ(int64_t(32000),
+              v<int64_t>(run_simple_agg("SELECT SUM(y) FROM compressed_pages;", dt)));
+    ASSERT_EQ(
+        int64_t(16),
+        v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM compressed_pages WHERE x = 3;",
+                                  dt)));
+  }
+  run_ddl_statement("DROP TABLE compressed_pages;");
+}
+
+TEST(Insert, DeferredCheckpoint) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto commit_interval_state = g_insert_commit_interval_ms;
+  const auto commit_max_rows_state = g_insert_commit_max_rows;
+  ScopeGuard reset_insert_commit = [&commit_interval_state, &commit_max_rows_state] {
+    g_insert_commit_interval_ms = commit_interval_state;
+    g_insert_commit_max_rows = commit_max_rows_state;
+  };
+  g_insert_commit_interval_ms = 100;
+  g_insert_commit_max_rows = 16;
+  run_ddl_statement("DROP TABLE IF EXISTS deferred_checkpoint;");
+  run_ddl_statement("CREATE TABLE deferred_checkpoint (x INT, s TEXT);");
+  // More rows than the pending limit, some get checkpointed right away.
+  for (int i = 0; i < 40; ++i) {
+    run_multiple_agg("INSERT INTO deferred_checkpoint VALUES(" + std::to_string(i) +
+                         ", 'str" + std::to_string(i % 3) + "');",
+                     ExecutorDeviceType::CPU);
+    // The rows are visible before their checkpoint.
+    ASSERT_EQ(
+        int64_t(i + 1),
+        v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM deferred_checkpoint;",
+                                  ExecutorDeviceType::CPU)));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(780),
+              v<int64_t>(run_simple_agg("SELECT SUM(x) FROM deferred_checkpoint;", dt)));
+    ASSERT_EQ(int64_t(13),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM deferred_checkpoint WHERE s = 'str1';", dt)));
+  }
+  run_ddl_statement("DROP TABLE deferred_checkpoint;");
+}
+
+TEST(Select, BloomFilterSkipping) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  auto save_watchdog = g_enable_watchdog;
+  ScopeGuard reset_watchdog = [&save_watchdog] { g_enable_watchdog = save_watchdog; };
+  g_enable_watchdog = false;
+  run_ddl_statement("DROP TABLE IF EXISTS bloom_filter_skipping;");
+  run_ddl_statement(
+      "CREATE TABLE bloom_filter_skipping (x INT, y SMALLINT ENCODING FIXED(8)) WITH "
+      "(fragment_size=4, vacuum='delayed');");
+  // Even values only, every fragment covers a range with holes.
+  for (int i = 0; i < 16; ++i) {
+    run_multiple_agg("INSERT INTO bloom_filter_skipping VALUES(" +
+                         std::to_string(i * 2) + ", " + std::to_string(i * 2) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  const auto check_counts = [](const ExecutorDeviceType dt) {
+    for (int i = 0; i < 32; ++i) {
+      const auto expected = int64_t(i % 2 ? 0 : 1);
+      ASSERT_EQ(expected,
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM bloom_filter_skipping WHERE x = " +
+                        std::to_string(i) + ";",
+                    dt)));
+      ASSERT_EQ(expected,
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM bloom_filter_skipping WHERE y = " +
+                        std::to_string(i) + ";",
+                    dt)));
+    }
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    check_counts(dt);
+    // The filters are persisted along with the rest of the chunk metadata.
+    g_session->get_catalog().get_dataMgr().clearMemory(
+        Data_Namespace::MemoryLevel::CPU_LEVEL);
+    check_counts(dt);
+  }
+  if (std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value) {
+    // Updated values can't be found in the filter built from the inserted ones.
+    run_multiple_agg("UPDATE bloom_filter_skipping SET x = 3 WHERE x = 2;",
+                     ExecutorDeviceType::CPU);
+    for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+      SKIP_NO_GPU();
+      ASSERT_EQ(int64_t(1),
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM bloom_filter_skipping WHERE x = 3;", dt)));
+    }
+  }
+  run_ddl_statement("DROP TABLE bloom_filter_skipping;");
+}
+
+TEST(Select, KeyIndexSkipping) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_bloom_filters = g_enable_chunk_bloom_filters;
+  ScopeGuard reset_bloom_filters = [&save_bloom_filters] {
+    g_enable_chunk_bloom_filters = save_bloom_filters;
+  };
+  // Only the index can skip the fragments then.
+  g_enable_chunk_bloom_filters = false;
+  run_ddl_statement("DROP TABLE IF EXISTS key_index_skipping;");
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE key_index_skipping (x DOUBLE) WITH "
+                                 "(index_column='x');"),
+               std::runtime_error);
+  run_ddl_statement(
+      "CREATE TABLE key_index_skipping (x INT, y INT) WITH (index_column='x', "
+      "fragment_size=4);");
+  // The even numbers below 32 scattered, the ranges of the fragments overlap.
+  for (int i = 0; i < 16; ++i) {
+    run_multiple_agg("INSERT INTO key_index_skipping VALUES(" +
+                         std::to_string(i * 7 % 16 * 2) + ", " + std::to_string(i) +
+                         ");",
+                     ExecutorDeviceType::CPU);
+  }
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (int i = 0; i < 32; ++i) {
+      ASSERT_EQ(int64_t(i % 2 ? 0 : 1),
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM key_index_skipping WHERE x = " +
+                        std::to_string(i) + ";",
+                    dt)));
+    }
+  }
+  if (std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value) {
+    // The fragment of an updated key loses its index.
+    run_multiple_agg("UPDATE key_index_skipping SET x = 3 WHERE x = 14;",
+                     ExecutorDeviceType::CPU);
+    for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+      SKIP_NO_GPU();
+      ASSERT_EQ(int64_t(1),
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM key_index_skipping WHERE x = 3;", dt)));
+    }
+  }
+  run_ddl_statement("DROP TABLE key_index_skipping;");
+}
+
+TEST(Select, FragmentRangeIndex) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS fragment_range_index;");
+  run_ddl_statement(
+      "CREATE TABLE fragment_range_index (x INT, y INT) WITH (fragment_size=4);");
+  // The fragments cover overlapping ranges of x, out of order.
+  for (int i = 0; i < 64; ++i) {
+    run_multiple_agg("INSERT INTO fragment_range_index VALUES(" +
+                         std::to_string(i * 7 % 64) + ", " + std::to_string(i) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  const auto count = [](const std::string& filter, const ExecutorDeviceType dt) {
+    return v<int64_t>(run_simple_agg(
+        "SELECT COUNT(*) FROM fragment_range_index WHERE " + filter + ";", dt));
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (int i = 0; i < 64; i += 5) {
+      const auto bound = std::to_string(i);
+      ASSERT_EQ(int64_t(64 - i), count("x >= " + bound, dt));
+      ASSERT_EQ(int64_t(63 - i), count("x > " + bound, dt));
+      ASSERT_EQ(int64_t(i + 1), count("x <= " + bound, dt));
+      ASSERT_EQ(int64_t(i), count("x < " + bound, dt));
+      ASSERT_EQ(int64_t(1), count("x = " + bound, dt));
+      ASSERT_EQ(int64_t(std::min(i, 60) - std::max(i - 20, 0)),
+                count("x >= " + std::to_string(std::max(i - 20, 0)) + " AND x < " +
+                          std::to_string(std::min(i, 60)) + " AND y < 64",
+                      dt));
+    }
+    ASSERT_EQ(int64_t(0), count("x > 10 AND x < 5", dt));
+    ASSERT_EQ(int64_t(0), count("x > 2147483647", dt));
+    ASSERT_EQ(int64_t(2), count("x < 2 AND y >= 0", dt));
+  }
+  // The index of the appended rows is built again.
+  run_multiple_agg("INSERT INTO fragment_range_index VALUES(100, 64);",
+                   ExecutorDeviceType::CPU);
+  ASSERT_EQ(int64_t(1), count("x >= 100", ExecutorDeviceType::CPU));
+  run_ddl_statement("DROP TABLE fragment_range_index;");
+}
+
+TEST(Select, SharedScans) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_shared_scans = g_enable_shared_scans;
+  g_enable_shared_scans = true;
+  ScopeGuard reset_shared_scans = [save_shared_scans] {
+    g_enable_shared_scans = save_shared_scans;
+  };
+  run_ddl_statement("DROP TABLE IF EXISTS shared_scans;");
+  run_ddl_statement(
+      "CREATE TABLE shared_scans (x INT, y DOUBLE, z SMALLINT) WITH (fragment_size=8);");
+  for (int i = 0; i < 64; ++i) {
+    run_multiple_agg("INSERT INTO shared_scans VALUES(" + std::to_string(i) + ", " +
+                         std::to_string(i / 2.) + ", " + std::to_string(i % 5) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    // Queued behind each other, most of them get computed in the pass of another one.
+    const std::vector<std::string> queries{
+        "SELECT COUNT(*) FROM shared_scans WHERE x >= 10;",
+        "SELECT SUM(x) FROM shared_scans WHERE x >= 10;",
+        "SELECT MIN(z), MAX(y) FROM shared_scans WHERE x >= 10;",
+        "SELECT AVG(y) FROM shared_scans WHERE x >= 10;",
+        "SELECT MAX(x) FROM shared_scans WHERE z = 3;",
+        "SELECT COUNT(*), SUM(z) FROM shared_scans;"};
+    std::vector<std::vector<TargetValue>> rows(queries.size() * 4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      threads.emplace_back([&queries, &rows, i, dt] {
+        const auto result = run_multiple_agg(queries[i % queries.size()], dt);
+        rows[i] = result->getNextRow(false, false);
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const auto& row = rows[i];
+      switch (i % queries.size()) {
+        case 0:
+          ASSERT_EQ(size_t(1), row.size());
+          ASSERT_EQ(int64_t(54), v<int64_t>(row[0]));
+          break;
+        case 1:
+          ASSERT_EQ(size_t(1), row.size());
+          ASSERT_EQ(int64_t(1971), v<int64_t>(row[0]));
+          break;
+        case 2:
+          ASSERT_EQ(size_t(2), row.size());
+          ASSERT_EQ(int64_t(0), v<int64_t>(row[0]));
+          ASSERT_DOUBLE_EQ(31.5, v<double>(row[1]));
+          break;
+        case 3:
+          ASSERT_EQ(size_t(1), row.size());
+          ASSERT_DOUBLE_EQ(18.25, v<double>(row[0]));
+          break;
+        case 4:
+          ASSERT_EQ(size_t(1), row.size());
+          ASSERT_EQ(int64_t(63), v<int64_t>(row[0]));
+          break;
+        case 5:
+          ASSERT_EQ(size_t(2), row.size());
+          ASSERT_EQ(int64_t(64), v<int64_t>(row[0]));
+          ASSERT_EQ(int64_t(126), v<int64_t>(row[1]));
+          break;
+      }
+    }
+  }
+  run_ddl_statement("DROP TABLE shared_scans;");
+}
+
+TEST(Select, QueryMemoryLimits) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_cpu_limit = g_query_cpu_memory_limit_bytes;
+  const auto save_gpu_limit = g_query_gpu_memory_limit_bytes;
+  const auto save_allow_cpu_retry = g_allow_cpu_retry;
+  ScopeGuard reset_limits = [save_cpu_limit, save_gpu_limit, save_allow_cpu_retry] {
+    g_query_cpu_memory_limit_bytes = save_cpu_limit;
+    g_query_gpu_memory_limit_bytes = save_gpu_limit;
+    g_allow_cpu_retry = save_allow_cpu_retry;
+  };
+  g_allow_cpu_retry = true;
+  const std::string query{"SELECT x, COUNT(*) FROM test GROUP BY x;"};
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    const auto row_count = run_multiple_agg(query, dt)->rowCount();
+    ASSERT_GT(QueryMemoryAccount::getPeakBytes(ExecutorDeviceType::CPU), size_t(0));
+    // Past the GPU limit, the query moves on to the CPU.
+    g_query_gpu_memory_limit_bytes = 1;
+    ASSERT_EQ(row_count, run_multiple_agg(query, dt)->rowCount());
+    g_query_gpu_memory_limit_bytes = 0;
+    // Past the CPU limit, it fails on its own.
+    g_query_cpu_memory_limit_bytes = 1;
+    EXPECT_ANY_THROW(run_multiple_agg(query, dt));
+    g_query_cpu_memory_limit_bytes = 0;
+    ASSERT_EQ(row_count, run_multiple_agg(query, dt)->rowCount());
+  }
+}
+
+TEST(Select, JoinKeyFragmentSkipping) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  auto save_watchdog = g_enable_watchdog;
+  ScopeGuard reset_watchdog = [&save_watchdog] { g_enable_watchdog = save_watchdog; };
+  g_enable_watchdog = false;
+  run_ddl_statement("DROP TABLE IF EXISTS join_key_skipping_outer;");
+  run_ddl_statement("DROP TABLE IF EXISTS join_key_skipping_inner;");
+  run_ddl_statement(
+      "CREATE TABLE join_key_skipping_outer (x INT) WITH (fragment_size=4);");
+  run_ddl_statement(
+      "CREATE TABLE join_key_skipping_inner (x INT) WITH (fragment_size=4);");
+  for (int i = 0; i < 32; ++i) {
+    run_multiple_agg(
+        "INSERT INTO join_key_skipping_outer VALUES(" + std::to_string(i) + ");",
+        ExecutorDeviceType::CPU);
+  }
+  // The build side covers the keys from 8 to 24 with holes, most outer fragments only
+  // have keys out of its range or in its holes.
+  for (int i : {8, 9, 16, 24}) {
+    run_multiple_agg(
+        "INSERT INTO join_key_skipping_inner VALUES(" + std::to_string(i) + ");",
+        ExecutorDeviceType::CPU);
+  }
+  const auto check_counts = [](const ExecutorDeviceType dt) {
+    ASSERT_EQ(int64_t(4),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM join_key_skipping_outer o, "
+                  "join_key_skipping_inner i WHERE o.x = i.x;",
+                  dt)));
+    ASSERT_EQ(int64_t(57),
+              v<int64_t>(run_simple_agg(
+                  "SELECT SUM(o.x) FROM join_key_skipping_outer o, "
+                  "join_key_skipping_inner i WHERE o.x = i.x;",
+                  dt)));
+    // The outer rows without a match are kept by the left join.
+    ASSERT_EQ(int64_t(32),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM join_key_skipping_outer o LEFT JOIN "
+                  "join_key_skipping_inner i ON o.x = i.x;",
+                  dt)));
+  };
+  const auto save_skipping = g_enable_join_key_fragment_skipping;
+  ScopeGuard reset_skipping = [&save_skipping] {
+    g_enable_join_key_fragment_skipping = save_skipping;
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (const bool skipping : {false, true}) {
+      g_enable_join_key_fragment_skipping = skipping;
+      check_counts(dt);
+    }
+  }
+  run_ddl_statement("DROP TABLE join_key_skipping_outer;");
+  run_ddl_statement("DROP TABLE join_key_skipping_inner;");
+}
+
+TEST(Select, TableSample) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS table_sample_test;");
+  run_ddl_statement("CREATE TABLE table_sample_test (x INT) WITH (fragment_size=4);");
+  for (int i = 0; i < 64; ++i) {
+    run_multiple_agg("INSERT INTO table_sample_test VALUES(" + std::to_string(i) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  // The sample only depends on the row ids, it's the same on both devices.
+  const auto bernoulli_count = v<int64_t>(run_simple_agg(
+      "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE BERNOULLI(50);",
+      ExecutorDeviceType::CPU));
+  const auto system_count = v<int64_t>(run_simple_agg(
+      "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE SYSTEM(50);",
+      ExecutorDeviceType::CPU));
+  ASSERT_LT(bernoulli_count, int64_t(64));
+  ASSERT_LT(system_count, int64_t(64));
+  // SYSTEM keeps or drops whole fragments.
+  ASSERT_EQ(int64_t(0), system_count % 4);
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(64),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE BERNOULLI(100);",
+                  dt)));
+    ASSERT_EQ(int64_t(0),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE BERNOULLI(0);",
+                  dt)));
+    ASSERT_EQ(int64_t(64),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE SYSTEM(100);",
+                  dt)));
+    ASSERT_EQ(int64_t(0),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE SYSTEM(0);", dt)));
+    ASSERT_EQ(bernoulli_count,
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE BERNOULLI(50);",
+                  dt)));
+    ASSERT_EQ(system_count,
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE SYSTEM(50);", dt)));
+    ASSERT_EQ(int64_t(0),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM (SELECT x / 4 AS frag, COUNT(*) AS n FROM "
+                  "table_sample_test TABLESAMPLE SYSTEM(50) GROUP BY frag) WHERE n <> 4;",
+                  dt)));
+    ASSERT_EQ(int64_t(64),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM table_sample_test TABLESAMPLE BERNOULLI(100) "
+                  "REPEATABLE(7);",
+                  dt)));
+  }
+  run_ddl_statement("DROP TABLE table_sample_test;");
+}
+
+TEST(Select, RangeJoin) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS range_join_events;");
+  run_ddl_statement("DROP TABLE IF EXISTS range_join_intervals;");
+  run_ddl_statement("CREATE TABLE range_join_events (ts INT) WITH (fragment_size=4);");
+  run_ddl_statement(
+      "CREATE TABLE range_join_intervals (lo INT, hi INT) WITH (fragment_size=2);");
+  for (int i = 0; i < 40; ++i) {
+    run_multiple_agg("INSERT INTO range_join_events VALUES(" + std::to_string(i) + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  // Overlapping, single value and long intervals, along with ones which never match.
+  for (const auto& interval : {"5, 9",
+                               "8, 20",
+                               "30, 30",
+                               "35, 100",
+                               "NULL, 12",
+                               "15, NULL",
+                               "25, 22"}) {
+    run_multiple_agg(
+        std::string("INSERT INTO range_join_intervals VALUES(") + interval + ");",
+        ExecutorDeviceType::CPU);
+  }
+  const auto check_matches = [](const ExecutorDeviceType dt) {
+    ASSERT_EQ(int64_t(24),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM range_join_events o, range_join_intervals i "
+                  "WHERE o.ts BETWEEN i.lo AND i.hi;",
+                  dt)));
+    ASSERT_EQ(int64_t(432),
+              v<int64_t>(run_simple_agg(
+                  "SELECT SUM(o.ts) FROM range_join_events o JOIN range_join_intervals "
+                  "i ON o.ts >= i.lo AND i.hi >= o.ts;",
+                  dt)));
+    // The bounds are excluded by the quals, the index is the same.
+    ASSERT_EQ(int64_t(18),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM range_join_events o, range_join_intervals i "
+                  "WHERE o.ts > i.lo AND o.ts < i.hi;",
+                  dt)));
+  };
+  const auto save_range_join = g_enable_range_join_hash_table;
+  ScopeGuard reset_range_join = [&save_range_join] {
+    g_enable_range_join_hash_table = save_range_join;
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (const bool range_join : {false, true}) {
+      g_enable_range_join_hash_table = range_join;
+      check_matches(dt);
+    }
+  }
+  run_ddl_statement("DROP TABLE range_join_events;");
+  run_ddl_statement("DROP TABLE range_join_intervals;");
+}
+
+TEST(Select, SpatialJoin) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS spatial_join_points;");
+  run_ddl_statement("DROP TABLE IF EXISTS spatial_join_polys;");
+  run_ddl_statement("DROP TABLE IF EXISTS spatial_join_centers;");
+  run_ddl_statement(
+      "CREATE TABLE spatial_join_points (id INT, p POINT) WITH (fragment_size=4);");
+  run_ddl_statement(
+      "CREATE TABLE spatial_join_polys (id INT, poly POLYGON) WITH (fragment_size=2);");
+  run_ddl_statement(
+      "CREATE TABLE spatial_join_centers (id INT, p POINT) WITH (fragment_size=2);");
+  for (int i = 0; i < 10; ++i) {
+    run_multiple_agg("INSERT INTO spatial_join_points VALUES(" + std::to_string(i) +
+                         ", 'POINT(" + std::to_string(i) + " " + std::to_string(i) +
+                         ")');",
+                     ExecutorDeviceType::CPU);
+  }
+  int id{0};
+  for (const auto poly : {"0.5 0.5, 3.5 0.5, 3.5 3.5, 0.5 3.5, 0.5 0.5",
+                          "4.5 4.5, 8.5 4.5, 8.5 8.5, 4.5 8.5, 4.5 4.5",
+                          "20 20, 21 20, 21 21, 20 21, 20 20"}) {
+    run_multiple_agg("INSERT INTO spatial_join_polys VALUES(" + std::to_string(id++) +
+                         ", 'POLYGON((" + poly + "))');",
+                     ExecutorDeviceType::CPU);
+  }
+  for (const auto center : {"2 2", "6.5 6.5", "100 100"}) {
+    run_multiple_agg("INSERT INTO spatial_join_centers VALUES(" + std::to_string(id++) +
+                         ", 'POINT(" + center + ")');",
+                     ExecutorDeviceType::CPU);
+  }
+  const auto check_matches = [](const ExecutorDeviceType dt) {
+    ASSERT_EQ(int64_t(7),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM spatial_join_points o, spatial_join_polys i "
+                  "WHERE ST_Contains(i.poly, o.p);",
+                  dt)));
+    ASSERT_EQ(int64_t(7),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM spatial_join_points o JOIN spatial_join_polys i "
+                  "ON ST_Within(o.p, i.poly);",
+                  dt)));
+    ASSERT_EQ(int64_t(5),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM spatial_join_points o, spatial_join_centers i "
+                  "WHERE ST_Distance(o.p, i.p) <= 1.5;",
+                  dt)));
+    ASSERT_EQ(int64_t(3),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM spatial_join_points o, spatial_join_centers i "
+                  "WHERE 1.0 > ST_Distance(i.p, o.p);",
+                  dt)));
+  };
+  const auto save_spatial_join = g_enable_spatial_join_hash_table;
+  ScopeGuard reset_spatial_join = [&save_spatial_join] {
+    g_enable_spatial_join_hash_table = save_spatial_join;
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (const bool spatial_join : {false, true}) {
+      g_enable_spatial_join_hash_table = spatial_join;
+      check_matches(dt);
+    }
+  }
+  run_ddl_statement("DROP TABLE spatial_join_points;");
+  run_ddl_statement("DROP TABLE spatial_join_polys;");
+  run_ddl_statement("DROP TABLE spatial_join_centers;");
+}
+
+TEST(Select, DiffEncoding) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS diff_encoding;");
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE diff_encoding (x INT ENCODING DIFF(32));"),
+               std::runtime_error);
+  run_ddl_statement(
+      "CREATE TABLE diff_encoding (x INT ENCODING DIFF(8), y INT, t TIMESTAMP ENCODING "
+      "DIFF(16)) WITH (fragment_size=8);");
+  // The jumps of x don't fit into the frame of the chunk and start new fragments.
+  int64_t x_sum{0};
+  for (int i = 0; i < 24; ++i) {
+    const int64_t x = (i / 6) * 1000 + i - 10;
+    x_sum += x;
+    run_multiple_agg("INSERT INTO diff_encoding VALUES(" + std::to_string(x) + ", " +
+                         std::to_string(x) + ", " + std::to_string(1500000000 + i * 60) +
+                         ");",
+                     ExecutorDeviceType::CPU);
+  }
+  run_multiple_agg("INSERT INTO diff_encoding VALUES(NULL, NULL, NULL);",
+                   ExecutorDeviceType::CPU);
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(25),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM diff_encoding;", dt)));
+    ASSERT_EQ(x_sum, v<int64_t>(run_simple_agg("SELECT SUM(x) FROM diff_encoding;", dt)));
+    ASSERT_EQ(int64_t(-10),
+              v<int64_t>(run_simple_agg("SELECT MIN(x) FROM diff_encoding;", dt)));
+    ASSERT_EQ(int64_t(1),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM diff_encoding WHERE x IS NULL;", dt)));
+    ASSERT_EQ(int64_t(24),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM diff_encoding WHERE x = y;", dt)));
+    ASSERT_EQ(int64_t(1500000000 + 23 * 60),
+              v<int64_t>(run_simple_agg(
+                  "SELECT MAX(t) FROM diff_encoding WHERE x > 2000;", dt)));
+    // The inner table of the join reads the decoded column.
+    ASSERT_EQ(int64_t(24),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM diff_encoding a, "
+                                        "diff_encoding b WHERE a.y = b.x;",
+                                        dt)));
+  }
+  run_ddl_statement("DROP TABLE diff_encoding;");
+}
+
 TEST(Select, FilterAndGroupBy) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -1198,6 +2022,33 @@ TEST(Select, CountDistinct) {
   }
 }
 
+TEST(Select, CountDistinctWideRange) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_roaring = g_enable_roaring_count_distinct;
+  ScopeGuard reset_roaring = [&save_roaring] {
+    g_enable_roaring_count_distinct = save_roaring;
+  };
+  // Both the compressed bitmaps and the ordered sets, the range is too wide for a
+  // dense bitmap.
+  for (const bool enable_roaring : {true, false}) {
+    g_enable_roaring_count_distinct = enable_roaring;
+    for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+      SKIP_NO_GPU();
+      c("SELECT COUNT(distinct x * 1000000000000) FROM test;", dt);
+      c("SELECT COUNT(distinct x * 1000000000000 + y) FROM test;", dt);
+      c("SELECT COUNT(distinct -x * 1000000000000) FROM test;", dt);
+      c("SELECT COUNT(distinct d) FROM test;", dt);
+      c("SELECT y, COUNT(distinct x * 1000000000000 + z) AS n FROM test GROUP BY y "
+        "ORDER BY y;",
+        dt);
+      c("SELECT z, COUNT(distinct d), COUNT(distinct x * 1000000000000) FROM test "
+        "GROUP BY z ORDER BY z;",
+        dt);
+    }
+  }
+}
+
 TEST(Select, ApproxCountDistinct) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -1291,6 +2142,93 @@ TEST(Select, ApproxCountDistinct) {
   }
 }
 
+TEST(Select, ApproxCountDistinctSketch) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS approx_sketch_test;");
+  run_ddl_statement(
+      "CREATE TABLE approx_sketch_test AS SELECT y, APPROX_COUNT_DISTINCT_SKETCH(x) AS "
+      "sx, APPROX_COUNT_DISTINCT_SKETCH(str) AS sstr FROM test GROUP BY y;");
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(v<int64_t>(run_simple_agg("SELECT COUNT(distinct x) FROM test;", dt)),
+              v<int64_t>(run_simple_agg(
+                  "SELECT APPROX_COUNT_DISTINCT_UNION(sx) FROM approx_sketch_test;",
+                  dt)));
+    ASSERT_EQ(v<int64_t>(run_simple_agg("SELECT COUNT(distinct str) FROM test;", dt)),
+              v<int64_t>(run_simple_agg(
+                  "SELECT APPROX_COUNT_DISTINCT_UNION(sstr) FROM approx_sketch_test;",
+                  dt)));
+    // A coarser union folds the stored registers.
+    ASSERT_EQ(v<int64_t>(run_simple_agg("SELECT COUNT(distinct x) FROM test;", dt)),
+              v<int64_t>(run_simple_agg(
+                  "SELECT APPROX_COUNT_DISTINCT_UNION(sx, 10) FROM approx_sketch_test;",
+                  dt)));
+    // Sketching the sketches rolls them up without losing any register.
+    ASSERT_EQ(v<int64_t>(run_simple_agg("SELECT COUNT(distinct x) FROM test;", dt)),
+              v<int64_t>(run_simple_agg(
+                  "SELECT APPROX_COUNT_DISTINCT_UNION(s) FROM (SELECT "
+                  "APPROX_COUNT_DISTINCT_SKETCH(sx) AS s FROM approx_sketch_test);",
+                  dt)));
+    c("SELECT y, APPROX_COUNT_DISTINCT_UNION(sx) FROM approx_sketch_test GROUP BY y "
+      "ORDER BY y;",
+      "SELECT y, COUNT(distinct x) FROM test GROUP BY y ORDER BY y;",
+      dt);
+    EXPECT_THROW(
+        run_multiple_agg("SELECT APPROX_COUNT_DISTINCT_UNION(y) FROM approx_sketch_test;",
+                         dt),
+        std::runtime_error);
+    EXPECT_THROW(
+        run_multiple_agg("SELECT APPROX_COUNT_DISTINCT_SKETCH(arr_i32) FROM array_test;",
+                         dt),
+        std::runtime_error);
+  }
+  run_ddl_statement("DROP TABLE approx_sketch_test;");
+}
+
+TEST(Select, ApproxPercentile) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  // The sketches bound the relative error by 2%.
+  const auto check_approx = [](const double target, const double val) {
+    ASSERT_TRUE(approx_eq(val, target, 0.02 * std::abs(target)));
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    check_approx(101,
+                 v<double>(run_simple_agg("SELECT APPROX_MEDIAN(z) FROM test;", dt)));
+    check_approx(
+        -78, v<double>(run_simple_agg("SELECT APPROX_PERCENTILE(z, 0) FROM test;", dt)));
+    check_approx(
+        102, v<double>(run_simple_agg("SELECT APPROX_PERCENTILE(z, 1) FROM test;", dt)));
+    check_approx(
+        1.2,
+        v<double>(run_simple_agg("SELECT APPROX_PERCENTILE(f, 0.3) FROM test;", dt)));
+    check_approx(
+        -1000.3,
+        v<double>(run_simple_agg(
+            "SELECT APPROX_PERCENTILE(fn, 0.25) FROM test WHERE y = 43;", dt)));
+    ASSERT_EQ(inline_fp_null_val(SQLTypeInfo(kDOUBLE, false)),
+              v<double>(run_simple_agg(
+                  "SELECT APPROX_MEDIAN(fn) FROM test WHERE y = 42;", dt)));
+    {
+      const auto rows = run_multiple_agg(
+          "SELECT y, APPROX_MEDIAN(z) FROM test GROUP BY y ORDER BY y;", dt);
+      ASSERT_EQ(size_t(2), rows->rowCount());
+      auto crt_row = rows->getNextRow(true, true);
+      ASSERT_EQ(int64_t(42), v<int64_t>(crt_row[0]));
+      check_approx(101, v<double>(crt_row[1]));
+      crt_row = rows->getNextRow(true, true);
+      ASSERT_EQ(int64_t(43), v<int64_t>(crt_row[0]));
+      check_approx(-78, v<double>(crt_row[1]));
+    }
+    EXPECT_THROW(run_multiple_agg("SELECT APPROX_MEDIAN(str) FROM test;", dt),
+                 std::runtime_error);
+    EXPECT_THROW(run_multiple_agg("SELECT APPROX_PERCENTILE(x, 1.5) FROM test;", dt),
+                 std::runtime_error);
+  }
+}
+
 TEST(Select, ScanNoAggregation) {
   SKIP_ALL_ON_AGGREGATOR();
 
@@ -1627,6 +2565,65 @@ TEST(Select, Case) {
   }
 }
 
+TEST(Select, CaseLookup) {
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT CASE WHEN x = 6 THEN 1 WHEN x = 7 THEN 2 WHEN x IN (8, 9) THEN 3 WHEN x = "
+      "10 THEN 4 ELSE 5 END AS c, COUNT(*) FROM test GROUP BY c ORDER BY c;",
+      dt);
+    // The first branch of a key wins.
+    c("SELECT SUM(CASE WHEN x = 7 THEN 10 WHEN x = 8 THEN 20 WHEN x = 7 THEN 30 WHEN 9 = "
+      "x THEN 40 END) FROM test;",
+      dt);
+    c("SELECT CASE WHEN str = 'foo' THEN 1 WHEN str = 'bar' THEN 2 WHEN str = 'baz' THEN "
+      "3 WHEN str = 'none' THEN 4 ELSE 0 END AS c, COUNT(*) FROM test GROUP BY c "
+      "ORDER BY c;",
+      dt);
+    c("SELECT COUNT(*) FROM test WHERE CASE WHEN y = 41 THEN FALSE WHEN y = 42 THEN TRUE "
+      "WHEN y = 43 THEN FALSE WHEN y = 44 THEN FALSE ELSE FALSE END;",
+      dt);
+    // Too sparse for a table.
+    c("SELECT SUM(CASE WHEN x = 7 THEN 1 WHEN x = 8 THEN 2 WHEN x = 100000000 THEN 3 "
+      "WHEN x = -100000000 THEN 4 ELSE 5 END) FROM test;",
+      dt);
+  }
+}
+
+TEST(Select, TopCountGroups) {
+  const std::string drop_old_top_count_test{"DROP TABLE IF EXISTS top_count_test;"};
+  run_ddl_statement(drop_old_top_count_test);
+  g_sqlite_comparator.query(drop_old_top_count_test);
+  run_ddl_statement(
+      "CREATE TABLE top_count_test(x int, str text encoding dict) WITH "
+      "(fragment_size=3);");
+  g_sqlite_comparator.query("CREATE TABLE top_count_test(x int, str text);");
+  // Distinct counts, spread over the fragments, for a deterministic order.
+  for (size_t i = 1; i <= 9; ++i) {
+    for (size_t j = 0; j < i; ++j) {
+      const std::string insert_query{"INSERT INTO top_count_test VALUES(" +
+                                     std::to_string(i) + ", 'str" + std::to_string(i) +
+                                     "');"};
+      run_multiple_agg(insert_query, ExecutorDeviceType::CPU);
+      g_sqlite_comparator.query(insert_query);
+    }
+  }
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT x, COUNT(*) AS n FROM top_count_test GROUP BY x ORDER BY n DESC LIMIT 3;",
+      dt);
+    c("SELECT COUNT(*) AS n, x FROM top_count_test GROUP BY x ORDER BY n DESC LIMIT 2 "
+      "OFFSET 2;",
+      dt);
+    c("SELECT str, COUNT(*) AS n FROM top_count_test GROUP BY str ORDER BY n DESC "
+      "LIMIT 4;",
+      dt);
+    c("SELECT x, COUNT(*) AS n FROM top_count_test GROUP BY x ORDER BY n DESC LIMIT 20;",
+      dt);
+  }
+  run_ddl_statement(drop_old_top_count_test);
+  g_sqlite_comparator.query(drop_old_top_count_test);
+}
+
 TEST(Select, Strings) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -1967,6 +2964,10 @@ TEST(Select, StringsNoneEncoding) {
     c("SELECT COUNT(*) FROM test WHERE real_str LIKE 'real_ba_' or real_str LIKE "
       "'real_fo_';",
       dt);
+    c("SELECT COUNT(*) FROM test WHERE real_str LIKE 'r%a%_o';", dt);
+    c("SELECT COUNT(*) FROM test WHERE real_str LIKE '%e%l@_%r' ESCAPE '@';", dt);
+    c("SELECT COUNT(*) FROM test WHERE real_str NOT LIKE 'real%%a%';", dt);
+    c("SELECT COUNT(*) FROM test WHERE real_str LIKE 'real_foo';", dt);
     c("SELECT COUNT(*) FROM test WHERE real_str IS NULL;", dt);
     c("SELECT COUNT(*) FROM test WHERE real_str IS NOT NULL;", dt);
     c("SELECT COUNT(*) FROM test WHERE real_str > 'real_bar';", dt);
@@ -3098,6 +4099,19 @@ TEST(Select, Time) {
     ASSERT_EQ(15,
               v<int64_t>(run_simple_agg(
                   "SELECT COUNT(*) FROM test GROUP BY CAST(m AS date);", dt)));
+    for (const std::string field : {"hour", "quarterday", "day"}) {
+      ASSERT_EQ(15,
+                v<int64_t>(run_simple_agg("SELECT COUNT(*) AS n FROM test GROUP BY "
+                                          "DATE_TRUNC(" +
+                                              field + ", m) ORDER BY n DESC LIMIT 1;",
+                                          dt)));
+    }
+    ASSERT_EQ(2 * g_num_rows,
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM test WHERE EXTRACT(DOW FROM DATE_TRUNC(week, m)) "
+                  "= 0 AND DATE_TRUNC(week, m) <= m AND m < TIMESTAMPADD(DAY, 7, "
+                  "DATE_TRUNC(week, m));",
+                  dt)));
     const auto rows = run_multiple_agg(
         "SELECT DATE_TRUNC(month, CAST(o AS TIMESTAMP(0))) AS key0, str AS key1, "
         "COUNT(*) AS val FROM test GROUP BY "
@@ -3208,6 +4222,16 @@ TEST(Select, In) {
     c("SELECT COUNT(*) FROM test WHERE x IN (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, "
       "14, 15, 16, 17, 18, 19, 20);",
       dt);
+    // Sparse values, probed in a cached hash set: run twice to hit the cache.
+    for (size_t i = 0; i < 2; ++i) {
+      c("SELECT COUNT(*) FROM test WHERE t IN (1001, -50000000000, 1002, 50000000000);",
+        dt);
+      c("SELECT COUNT(*) FROM test WHERE t NOT IN (50000000000, 1001, 7, -50000000000);",
+        dt);
+    }
+    // Same kernel, the bounds of the bitmap are hoisted literals.
+    c("SELECT COUNT(*) FROM test WHERE x IN (7, 8, 9, 10);", dt);
+    c("SELECT COUNT(*) FROM test WHERE x IN (8, 9, 10, 11, 12);", dt);
   }
 }
 
@@ -4295,7 +5319,176 @@ void import_geospatial_test() {
   }
 }
 
-}  // namespace
+}  // namespace
+
+TEST(Select, SortColumn) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS sort_column_test;");
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE sort_column_test (x INT, s TEXT ENCODING "
+                                 "DICT) WITH (sort_column='s');"),
+               std::runtime_error);
+  EXPECT_THROW(run_ddl_statement(
+                   "CREATE TABLE sort_column_test (x INT) WITH (sort_column='y');"),
+               std::runtime_error);
+  run_ddl_statement(
+      "CREATE TABLE sort_column_test (s TEXT ENCODING NONE, x INT) WITH "
+      "(sort_column='x', fragment_size=4);");
+  auto& cat = g_session->get_catalog();
+  const auto td = cat.getMetadataForTable("sort_column_test");
+  CHECK(td);
+  auto loader = get_loader(td);
+  std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
+  const auto col_descs =
+      cat.getAllColumnMetadataForTable(td->tableId, false, false, false);
+  for (const auto cd : col_descs) {
+    import_buffers.emplace_back(new Importer_NS::TypedImportBuffer(cd, nullptr));
+  }
+  // A single batch in descending order, the rows get appended in ascending order of x.
+  const size_t row_count{16};
+  for (size_t i = 0; i < row_count; ++i) {
+    const auto x = row_count - 1 - i;
+    import_buffers[0]->addString("str" + std::to_string(x));
+    import_buffers[1]->addInt(x);
+  }
+  loader->load(import_buffers, row_count);
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(row_count),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM sort_column_test WHERE rowid = x;", dt)));
+    ASSERT_EQ("str6",
+              boost::get<std::string>(v<NullableString>(run_simple_agg(
+                  "SELECT s FROM sort_column_test WHERE x = 6;", dt))));
+  }
+  run_ddl_statement("DROP TABLE sort_column_test;");
+}
+
+TEST(Insert, DeferredLoadCheckpoint) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto commit_interval_state = g_load_commit_interval_ms;
+  const auto commit_max_rows_state = g_load_commit_max_rows;
+  ScopeGuard reset_load_commit = [&commit_interval_state, &commit_max_rows_state] {
+    g_load_commit_interval_ms = commit_interval_state;
+    g_load_commit_max_rows = commit_max_rows_state;
+  };
+  g_load_commit_interval_ms = 100;
+  g_load_commit_max_rows = 16;
+  run_ddl_statement("DROP TABLE IF EXISTS deferred_load_checkpoint;");
+  run_ddl_statement("CREATE TABLE deferred_load_checkpoint (x INT);");
+  auto& cat = g_session->get_catalog();
+  const auto td = cat.getMetadataForTable("deferred_load_checkpoint");
+  CHECK(td);
+  auto loader = get_loader(td);
+  const auto col_descs =
+      cat.getAllColumnMetadataForTable(td->tableId, false, false, false);
+  CHECK_EQ(size_t(1), col_descs.size());
+  // More rows than the pending limit, some get checkpointed right away.
+  for (int batch = 0; batch < 5; ++batch) {
+    std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
+    import_buffers.emplace_back(
+        new Importer_NS::TypedImportBuffer(col_descs.front(), nullptr));
+    for (int i = 0; i < 8; ++i) {
+      import_buffers[0]->addInt(batch * 8 + i);
+    }
+    ASSERT_TRUE(loader->load(import_buffers, 8));
+    // The rows are visible before their checkpoint.
+    ASSERT_EQ(int64_t(8 * (batch + 1)),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM deferred_load_checkpoint;",
+                                        ExecutorDeviceType::CPU)));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(
+        int64_t(780),
+        v<int64_t>(run_simple_agg("SELECT SUM(x) FROM deferred_load_checkpoint;", dt)));
+  }
+  run_ddl_statement("DROP TABLE deferred_load_checkpoint;");
+}
+
+TEST(Select, NullFreeGroupedAggregates) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS null_free_agg;");
+  run_ddl_statement("CREATE TABLE null_free_agg (g INT, x INT, d DOUBLE);");
+  for (int i = 1; i <= 3; ++i) {
+    const auto val = std::to_string(i);
+    run_multiple_agg("INSERT INTO null_free_agg VALUES(1, " + val + ", " + val + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  const auto check = [](const int64_t expected_count) {
+    for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+      SKIP_NO_GPU();
+      ASSERT_EQ(int64_t(6),
+                v<int64_t>(run_simple_agg(
+                    "SELECT SUM(x) FROM null_free_agg GROUP BY g;", dt)));
+      ASSERT_EQ(int64_t(1),
+                v<int64_t>(run_simple_agg(
+                    "SELECT MIN(x) FROM null_free_agg GROUP BY g;", dt)));
+      ASSERT_EQ(int64_t(3),
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(x) FROM null_free_agg GROUP BY g;", dt)));
+      ASSERT_EQ(expected_count,
+                v<int64_t>(run_simple_agg(
+                    "SELECT COUNT(*) FROM null_free_agg GROUP BY g;", dt)));
+      ASSERT_EQ(double(6),
+                v<double>(run_simple_agg(
+                    "SELECT SUM(d) FROM null_free_agg GROUP BY g;", dt)));
+    }
+  };
+  // No nulls in the chunks, the updates skip the null checks.
+  check(3);
+  // The code compiled without the null checks mustn't be used once there are nulls.
+  run_multiple_agg("INSERT INTO null_free_agg VALUES(1, NULL, NULL);",
+                   ExecutorDeviceType::CPU);
+  check(4);
+  run_ddl_statement("DROP TABLE null_free_agg;");
+}
+
+TEST(Select, PartitionRetention) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS partition_test;");
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE partition_test (ts TIMESTAMP, x INT) WITH "
+                                 "(partition_interval=86400);"),
+               std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE partition_test (ts TIMESTAMP, x INT) WITH "
+                                 "(sort_column='x', partition_interval=86400);"),
+               std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("CREATE TABLE partition_test (ts TIMESTAMP, x INT) WITH "
+                                 "(sort_column='ts', retention=86400);"),
+               std::runtime_error);
+  run_ddl_statement(
+      "CREATE TABLE partition_test (ts TIMESTAMP, x INT) WITH (sort_column='ts', "
+      "partition_interval=86400, retention=172800);");
+  auto& cat = g_session->get_catalog();
+  const auto td = cat.getMetadataForTable("partition_test");
+  CHECK(td);
+  auto loader = get_loader(td);
+  std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
+  const auto col_descs =
+      cat.getAllColumnMetadataForTable(td->tableId, false, false, false);
+  for (const auto cd : col_descs) {
+    import_buffers.emplace_back(new Importer_NS::TypedImportBuffer(cd, nullptr));
+  }
+  // Two rows a day for five days, the days ending two days before the newest row go.
+  const size_t row_count{10};
+  for (size_t i = 0; i < row_count; ++i) {
+    import_buffers[0]->addTime((i / 2) * 86400 + (i % 2 + 1) * 3600);
+    import_buffers[1]->addInt(i);
+  }
+  loader->load(import_buffers, row_count);
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    ASSERT_EQ(int64_t(6),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM partition_test;", dt)));
+    ASSERT_EQ(int64_t(4),
+              v<int64_t>(run_simple_agg("SELECT MIN(x) FROM partition_test;", dt)));
+  }
+  run_ddl_statement("DROP TABLE partition_test;");
+}
 
 TEST(Select, ArrayUnnest) {
   SKIP_ALL_ON_AGGREGATOR();
@@ -4922,6 +6115,57 @@ TEST(Select, Subqueries) {
   }
 }
 
+TEST(Select, SubqueryResultCache) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_subquery_result_cache = g_enable_subquery_result_cache;
+  g_enable_subquery_result_cache = true;
+  ScopeGuard reset_subquery_result_cache = [save_subquery_result_cache] {
+    g_enable_subquery_result_cache = save_subquery_result_cache;
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    // The same subquery twice in a plan.
+    c("SELECT COUNT(*) FROM test WHERE x IN (SELECT x FROM test WHERE y > 42) OR y IN "
+      "(SELECT x FROM test WHERE y > 42);",
+      dt);
+    c("SELECT SUM(x) FROM test WHERE x < (SELECT MAX(y) FROM test) AND y < (SELECT "
+      "MAX(y) FROM test);",
+      dt);
+    // The same subquery in two queries.
+    c("SELECT COUNT(*) FROM test WHERE x IN (SELECT x FROM test GROUP BY x ORDER BY "
+      "COUNT(*) DESC LIMIT 1);",
+      dt);
+    const auto hits = QueryResultCache::getCacheStats().hits;
+    c("SELECT SUM(y) FROM test WHERE x IN (SELECT x FROM test GROUP BY x ORDER BY "
+      "COUNT(*) DESC LIMIT 1);",
+      dt);
+    ASSERT_EQ(hits + 1, QueryResultCache::getCacheStats().hits);
+  }
+}
+
+TEST(Select, ColumnarResultsCache) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_columnar_results_cache = g_enable_columnar_results_cache;
+  g_enable_columnar_results_cache = true;
+  ScopeGuard reset_columnar_results_cache = [save_columnar_results_cache] {
+    g_enable_columnar_results_cache = save_columnar_results_cache;
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    // The same derived table joined in two queries.
+    c("SELECT COUNT(*) FROM test a JOIN (SELECT x FROM test WHERE y > 42 GROUP BY x) b "
+      "ON a.x = b.x;",
+      dt);
+    const auto hits = ColumnarResultsCache::getCacheStats().hits;
+    c("SELECT SUM(a.y) FROM test a JOIN (SELECT x FROM test WHERE y > 42 GROUP BY x) b "
+      "ON a.x = b.x;",
+      dt);
+    ASSERT_LT(hits, ColumnarResultsCache::getCacheStats().hits);
+  }
+}
+
 TEST(Select, Joins_Arrays) {
   SKIP_ALL_ON_AGGREGATOR();
 
@@ -5433,6 +6677,58 @@ TEST(Select, Joins_InnerJoin_Filters) {
   }
 }
 
+TEST(Select, Joins_CostBasedOrdering) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto enable_cost_based_join_ordering_state = g_enable_cost_based_join_ordering;
+  ScopeGuard reset_cost_based_join_ordering = [&enable_cost_based_join_ordering_state] {
+    g_enable_cost_based_join_ordering = enable_cost_based_join_ordering_state;
+  };
+  g_enable_cost_based_join_ordering = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c("SELECT count(*) FROM test AS a JOIN join_test AS b ON a.x = b.x JOIN test_inner "
+      "AS c ON b.str = c.str WHERE a.y < 43;",
+      dt);
+    c("SELECT a.x, b.x, c.x FROM test a JOIN test_inner b ON a.x = b.x JOIN join_test c "
+      "ON b.x = c.x ORDER BY a.x;",
+      dt);
+    c("SELECT COUNT(*) FROM test a JOIN join_test b ON a.x = b.x JOIN test_inner c ON "
+      "c.str = a.str WHERE c.str = 'foo' AND a.x IN (7, 8);",
+      dt);
+    c("SELECT COUNT(*) FROM test a JOIN test_inner b ON a.str = b.str JOIN "
+      "hash_join_test c ON a.x = c.x JOIN join_test d ON a.x > d.x;",
+      dt);
+    c("SELECT SUM(a.x), b.str FROM test AS a JOIN hash_join_test AS b ON a.x = b.x JOIN "
+      "test_inner AS c ON b.str = c.str WHERE a.y = 43 AND b.x <> 8 GROUP BY b.str "
+      "ORDER BY b.str;",
+      dt);
+  }
+}
+
+TEST(Select, Joins_DictionaryTranslationMap) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto save_dictionary_translation_map = g_enable_dictionary_translation_map;
+  ScopeGuard reset_dictionary_translation_map = [save_dictionary_translation_map] {
+    g_enable_dictionary_translation_map = save_dictionary_translation_map;
+  };
+  for (const bool enable_dictionary_translation_map : {false, true}) {
+    g_enable_dictionary_translation_map = enable_dictionary_translation_map;
+    for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+      SKIP_NO_GPU();
+      // The string columns of the two tables don't share their dictionary.
+      c("SELECT COUNT(*) FROM test a JOIN join_test b ON a.str = b.str;", dt);
+      c("SELECT COUNT(*) FROM test a JOIN join_test b ON a.str = b.dup_str;", dt);
+      c("SELECT a.x, b.str FROM test a JOIN join_test b ON a.str = b.str ORDER BY a.x, "
+        "b.str;",
+        dt);
+      c("SELECT COUNT(*) FROM test a JOIN test_inner b ON a.str = b.str WHERE a.y < 43;",
+        dt);
+    }
+  }
+}
+
 TEST(Select, Joins_LeftOuterJoin) {
   SKIP_ALL_ON_AGGREGATOR();
   auto save_watchdog = g_enable_watchdog;
@@ -5477,6 +6773,9 @@ TEST(Select, Joins_LeftOuterJoin) {
     c("SELECT COUNT(*) FROM test_inner_x a LEFT JOIN test_x b ON a.x = b.x;", dt);
     c("SELECT COUNT(*) FROM test a LEFT JOIN join_test b ON a.str = b.dup_str;", dt);
     c("SELECT COUNT(*) FROM test a LEFT JOIN join_test b ON a.str = b.dup_str;", dt);
+    c("SELECT a.x, a.y, a.z, a.t, b.str FROM test a LEFT JOIN join_test b ON a.str = "
+      "b.dup_str ORDER BY a.x, a.y, a.z, a.t, b.str IS NULL, b.str LIMIT 10;",
+      dt);
     c("SELECT a.x, b.str FROM test_inner_x a LEFT JOIN test_x b ON a.x = b.x ORDER BY "
       "a.x, b.str IS NULL, b.str;",
       dt);
@@ -5625,6 +6924,15 @@ TEST(Select, Joins_LeftJoin_Filters) {
     c("SELECT COUNT(*) FROM join_test a LEFT JOIN test b ON a.x = b.x WHERE a.x = 7;",
       dt);
     c("SELECT a.x FROM join_test a LEFT JOIN test b ON a.x = b.x WHERE a.x = 7;", dt);
+    c("SELECT a.x, b.y FROM test_inner a LEFT JOIN test b ON a.x = b.x AND a.y = b.y "
+      "ORDER BY a.x, b.y IS NULL, b.y;",
+      dt);
+    c("SELECT a.x, b.str FROM test_inner a LEFT JOIN test_x b ON a.x = b.x AND b.str <> "
+      "'foo' ORDER BY a.x, b.str IS NULL, b.str;",
+      dt);
+    c("SELECT a.x, COUNT(b.x) FROM test a LEFT JOIN join_test b ON a.str = b.dup_str AND "
+      "b.x < a.x GROUP BY a.x ORDER BY a.x;",
+      dt);
   }
 }
 
@@ -5649,6 +6957,11 @@ TEST(Select, Joins_MultiCompositeColumns) {
       "test_inner c ON a.x = c.x WHERE "
       "c.str <> 'foo';",
       dt);
+    // the keys of test.t fit on 4 bytes, 5000000000 doesn't and can't match
+    c("SELECT COUNT(*) FROM hash_join_test a JOIN test b ON a.t = b.t AND a.x = b.x;",
+      dt);
+    c("SELECT COUNT(*) FROM test a JOIN hash_join_test b ON a.t = b.t AND a.x = b.x;",
+      dt);
     c("SELECT a.x, b.x, d.str FROM test a JOIN test_inner b ON a.str = b.str JOIN "
       "hash_join_test c ON a.x = c.x JOIN "
       "join_test d ON a.x >= d.x AND a.x < d.x + 5 ORDER BY a.x, b.x;",
@@ -6038,6 +7351,109 @@ TEST(Select, CreateTableAsSelect) {
   }
 }
 
+TEST(Select, MaterializedView) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto dt = ExecutorDeviceType::CPU;
+  run_ddl_statement("DROP VIEW IF EXISTS mat_view_test;");
+  run_ddl_statement("DROP TABLE IF EXISTS mat_view_src;");
+  run_ddl_statement("CREATE TABLE mat_view_src (k INT, x INT);");
+  run_multiple_agg("INSERT INTO mat_view_src VALUES (1, 10);", dt);
+  run_multiple_agg("INSERT INTO mat_view_src VALUES (1, 20);", dt);
+  run_multiple_agg("INSERT INTO mat_view_src VALUES (2, 5);", dt);
+  run_ddl_statement(
+      "CREATE MATERIALIZED VIEW mat_view_test AS SELECT k, COUNT(*) AS n, SUM(x) AS s, "
+      "MIN(x) AS lo, MAX(x) AS hi, AVG(x) AS a FROM mat_view_src GROUP BY k;");
+  const auto check_view = [dt] {
+    const auto view_rows = run_multiple_agg(
+        "SELECT k, n, s, lo, hi, a FROM mat_view_test ORDER BY k;", dt);
+    const auto source_rows = run_multiple_agg(
+        "SELECT k, COUNT(*), SUM(x), MIN(x), MAX(x), AVG(x) FROM mat_view_src GROUP BY "
+        "k ORDER BY k;",
+        dt);
+    ASSERT_EQ(source_rows->rowCount(), view_rows->rowCount());
+    for (size_t i = 0; i < source_rows->rowCount(); ++i) {
+      const auto source_row = source_rows->getNextRow(true, true);
+      const auto view_row = view_rows->getNextRow(true, true);
+      for (size_t j = 0; j < 5; ++j) {
+        ASSERT_EQ(v<int64_t>(source_row[j]), v<int64_t>(view_row[j]));
+      }
+      ASSERT_NEAR(v<double>(source_row[5]), v<double>(view_row[5]), 1e-9);
+    }
+  };
+  check_view();
+
+  run_multiple_agg("INSERT INTO mat_view_src VALUES (2, 7);", dt);
+  run_multiple_agg("INSERT INTO mat_view_src VALUES (3, 1);", dt);
+  // The appended rows are only aggregated by the refresh.
+  ASSERT_EQ(int64_t(2),
+            v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM mat_view_test;", dt)));
+  run_ddl_statement("REFRESH MATERIALIZED VIEW mat_view_test;");
+  check_view();
+
+  EXPECT_THROW(run_ddl_statement("DROP TABLE mat_view_src;"), std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("CREATE MATERIALIZED VIEW mat_view_bad AS SELECT k, "
+                                 "COUNT(DISTINCT x) AS n FROM mat_view_src GROUP BY k;"),
+               std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("CREATE MATERIALIZED VIEW mat_view_bad AS SELECT k, "
+                                 "SUM(x) AS s FROM mat_view_src;"),
+               std::runtime_error);
+  run_ddl_statement("DROP VIEW mat_view_test;");
+  run_ddl_statement("DROP TABLE mat_view_src;");
+}
+
+TEST(Select, AnalyzeTable) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto dt = ExecutorDeviceType::CPU;
+  run_ddl_statement("DROP TABLE IF EXISTS analyze_test;");
+  run_ddl_statement("CREATE TABLE analyze_test (k INT, x DOUBLE, s TEXT);");
+  ScopeGuard drop_analyze_test = [] {
+    run_ddl_statement("DROP TABLE IF EXISTS analyze_test;");
+  };
+  for (int i = 0; i < 10; ++i) {
+    run_multiple_agg("INSERT INTO analyze_test VALUES (" + std::to_string(i % 4) + ", " +
+                         (i % 5 ? std::to_string(i) : std::string("NULL")) + ", 'str" +
+                         std::to_string(i % 3) + "');",
+                     dt);
+  }
+  run_ddl_statement("ANALYZE TABLE analyze_test;");
+  const auto& cat = g_session->get_catalog();
+  const auto td = cat.getMetadataForTable("analyze_test");
+  CHECK(td);
+  const auto get_statistics = [&cat, td](const std::string& column_name) {
+    const auto cd = cat.getMetadataForColumn(td->tableId, column_name);
+    CHECK(cd);
+    return cat.getColumnStatistics(td->tableId, cd->columnId);
+  };
+  const auto k_statistics = get_statistics("k");
+  ASSERT_TRUE(k_statistics);
+  ASSERT_EQ(int64_t(10), k_statistics->rowCount);
+  ASSERT_EQ(int64_t(0), k_statistics->nullCount);
+  ASSERT_EQ(int64_t(4), k_statistics->distinctCount);
+  ASSERT_FALSE(k_statistics->histogram.empty());
+  ASSERT_EQ(0., k_statistics->histogram.front());
+  ASSERT_EQ(3., k_statistics->histogram.back());
+  const auto x_statistics = get_statistics("x");
+  ASSERT_TRUE(x_statistics);
+  ASSERT_EQ(int64_t(2), x_statistics->nullCount);
+  ASSERT_NEAR(8, x_statistics->distinctCount, 1);
+  ASSERT_EQ(1., x_statistics->histogram.front());
+  ASSERT_EQ(9., x_statistics->histogram.back());
+  const auto s_statistics = get_statistics("s");
+  ASSERT_TRUE(s_statistics);
+  ASSERT_EQ(int64_t(3), s_statistics->distinctCount);
+  ASSERT_TRUE(s_statistics->histogram.empty());
+  // The statistics are used to size the group by buffers.
+  ASSERT_EQ(size_t(10),
+            run_multiple_agg("SELECT k, s, COUNT(*) FROM analyze_test GROUP BY k, s;", dt)
+                ->rowCount());
+  ASSERT_EQ(size_t(10),
+            run_multiple_agg("SELECT k, x, COUNT(*) FROM analyze_test GROUP BY k, x;", dt)
+                ->rowCount());
+  EXPECT_THROW(run_ddl_statement("ANALYZE TABLE analyze_missing;"), std::runtime_error);
+}
+
 TEST(Select, PgShim) {
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
     SKIP_NO_GPU();
@@ -6084,6 +7500,66 @@ TEST(Select, ArrowOutput) {
   }
 }
 
+TEST(Select, ArrowOutputColumnar) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  const auto saved_enable_columnar_output = g_enable_columnar_output;
+  g_enable_columnar_output = true;
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    c_arrow("SELECT x, y, t, f, d, fn, dn, str FROM test;", dt);
+    c_arrow("SELECT x, fn, dn FROM test WHERE y > 42;", dt);
+  }
+  g_enable_columnar_output = saved_enable_columnar_output;
+}
+
+TEST(Select, BulkColumns) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    for (const std::string query :
+         {"SELECT x, y, f, d, str, null_str FROM test "
+          "ORDER BY x, y, f, d, str, null_str;",
+          "SELECT x, f, str FROM test ORDER BY x, f, str LIMIT 5 OFFSET 3;",
+          "SELECT str, COUNT(*), AVG(y) FROM test GROUP BY str ORDER BY str;"}) {
+      const auto rows = run_multiple_agg(query, dt);
+      const auto bulk_rows = run_multiple_agg(query, dt);
+      ASSERT_TRUE(bulk_rows->canFetchColumnsBulk());
+      const size_t batch_rows{4};
+      std::vector<ResultSetBulkColumn> columns;
+      while (true) {
+        const auto fetched =
+            bulk_rows->getNextColumnsBulk(columns, batch_rows, true, true);
+        for (size_t i = 0; i < fetched; ++i) {
+          const auto crt_row = rows->getNextRow(true, true);
+          ASSERT_EQ(columns.size(), crt_row.size());
+          for (size_t j = 0; j < crt_row.size(); ++j) {
+            const auto scalar_tv = boost::get<ScalarTargetValue>(&crt_row[j]);
+            ASSERT_TRUE(scalar_tv);
+            if (const auto ival = boost::get<int64_t>(scalar_tv)) {
+              ASSERT_EQ(*ival, columns[j].int_values[i]);
+            } else if (const auto dval = boost::get<double>(scalar_tv)) {
+              ASSERT_EQ(*dval, columns[j].real_values[i]);
+            } else if (const auto fval = boost::get<float>(scalar_tv)) {
+              ASSERT_EQ(*fval, columns[j].real_values[i]);
+            } else {
+              const auto s =
+                  boost::get<std::string>(boost::get<NullableString>(scalar_tv));
+              ASSERT_EQ(s ? *s : std::string(), columns[j].str_values[i]);
+              ASSERT_EQ(!s, columns[j].nulls[i]);
+            }
+          }
+        }
+        if (fetched < batch_rows) {
+          break;
+        }
+      }
+      ASSERT_TRUE(rows->getNextRow(true, true).empty());
+    }
+  }
+}
+
 TEST(Select, WatchdogTest) {
   g_enable_watchdog = true;
   for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
@@ -7599,6 +9075,35 @@ TEST(Update, MultiColumnInteger) {
   }
 }
 
+TEST(Update, JoinHashTableCache) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value) {
+    return;
+  }
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("create table join_cache_dim (k integer) with (vacuum='delayed');");
+    run_ddl_statement("create table join_cache_fact (k integer);");
+    run_multiple_agg("insert into join_cache_dim values (1);", dt);
+    run_multiple_agg("insert into join_cache_dim values (2);", dt);
+    run_multiple_agg("insert into join_cache_fact values (1);", dt);
+    run_multiple_agg("insert into join_cache_fact values (2);", dt);
+
+    const std::string join_count{
+        "select count(*) from join_cache_fact f join join_cache_dim d on f.k = d.k;"};
+    ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg(join_count, dt)));
+    // The update keeps the element count of the cached hash table.
+    run_multiple_agg("update join_cache_dim set k = 3 where k = 2;", dt);
+    ASSERT_EQ(int64_t(1), v<int64_t>(run_simple_agg(join_count, dt)));
+
+    run_ddl_statement("drop table join_cache_fact;");
+    run_ddl_statement("drop table join_cache_dim;");
+  }
+}
+
 TEST(Update, TimestampUpdate) {
   SKIP_ALL_ON_AGGREGATOR();
 
@@ -7725,6 +9230,79 @@ TEST(Update, FloatUpdate) {
   }
 }
 
+TEST(Update, QueryResultCache) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value) {
+    return;
+  }
+  const auto save_result_cache = g_enable_query_result_cache;
+  g_enable_query_result_cache = true;
+  ScopeGuard reset_result_cache = [save_result_cache] {
+    g_enable_query_result_cache = save_result_cache;
+  };
+  const auto dt = ExecutorDeviceType::CPU;
+
+  run_ddl_statement("drop table if exists result_cache_test;");
+  run_ddl_statement("create table result_cache_test (x int) with (vacuum='delayed');");
+  run_multiple_agg("insert into result_cache_test values (1);", dt);
+  run_multiple_agg("insert into result_cache_test values (2);", dt);
+
+  const std::string query{"select sum(x) from result_cache_test;"};
+  ASSERT_EQ(int64_t(3), v<int64_t>(run_simple_agg(query, dt)));
+  const auto hits = QueryResultCache::getCacheStats().hits;
+  ASSERT_EQ(int64_t(3), v<int64_t>(run_simple_agg(query, dt)));
+  ASSERT_EQ(hits + 1, QueryResultCache::getCacheStats().hits);
+
+  // An append changes the table generation.
+  run_multiple_agg("insert into result_cache_test values (3);", dt);
+  ASSERT_EQ(int64_t(6), v<int64_t>(run_simple_agg(query, dt)));
+
+  // An update keeps the generation, the invalidators clear the cache.
+  run_multiple_agg("update result_cache_test set x = 10 where x = 3;", dt);
+  ASSERT_EQ(int64_t(13), v<int64_t>(run_simple_agg(query, dt)));
+
+  run_ddl_statement("drop table result_cache_test;");
+}
+
+TEST(Update, TableMetadataCache) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  if (!std::is_same<CalciteUpdatePathSelector, PreprocessorTrue>::value) {
+    return;
+  }
+  const auto save_metadata_cache = g_enable_table_metadata_cache;
+  g_enable_table_metadata_cache = true;
+  ScopeGuard reset_metadata_cache = [save_metadata_cache] {
+    g_enable_table_metadata_cache = save_metadata_cache;
+  };
+  const auto dt = ExecutorDeviceType::CPU;
+
+  run_ddl_statement("drop table if exists metadata_cache_test;");
+  run_ddl_statement(
+      "create table metadata_cache_test (x int) with (vacuum='delayed', "
+      "fragment_size=2);");
+  run_multiple_agg("insert into metadata_cache_test values (1);", dt);
+  run_multiple_agg("insert into metadata_cache_test values (2);", dt);
+
+  // The group by buffer is sized from the cached range of x.
+  const std::string query{
+      "select x from metadata_cache_test group by x order by x desc limit 1;"};
+  ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg(query, dt)));
+  ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg(query, dt)));
+
+  run_multiple_agg("insert into metadata_cache_test values (30);", dt);
+  ASSERT_EQ(int64_t(30), v<int64_t>(run_simple_agg(query, dt)));
+
+  run_multiple_agg("update metadata_cache_test set x = 400 where x = 30;", dt);
+  ASSERT_EQ(int64_t(400), v<int64_t>(run_simple_agg(query, dt)));
+
+  run_multiple_agg("delete from metadata_cache_test where x = 400;", dt);
+  ASSERT_EQ(int64_t(2), v<int64_t>(run_simple_agg(query, dt)));
+
+  run_ddl_statement("drop table metadata_cache_test;");
+}
+
 TEST(Update, IntegerUpdate) {
   SKIP_ALL_ON_AGGREGATOR();
 
@@ -9547,6 +11125,82 @@ TEST(Delete, ExtraFragment) {
   }
 }
 
+TEST(Delete, OptimizeTable) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  if (std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value) {
+    return;
+  }
+
+  const auto num_fragments = []() {
+    const auto td = g_session->get_catalog().getMetadataForTable("vacuum_test");
+    CHECK(td);
+    return td->fragmenter->getFragmentsForQuery().fragments.size();
+  };
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("drop table if exists vacuum_test;");
+    run_ddl_statement(
+        "create table vacuum_test (i1 integer, t1 text encoding none) with "
+        "(vacuum='delayed', fragment_size=10);");
+    for (int i = 1; i <= 100; i++) {
+      run_multiple_agg("insert into vacuum_test values (" + std::to_string(i) + ", '" +
+                           std::to_string(i) + "');",
+                       dt);
+    }
+    run_multiple_agg("delete from vacuum_test where i1 > 25;", dt);
+    ASSERT_EQ(size_t(10), num_fragments());
+    EXPECT_THROW(
+        run_ddl_statement("optimize table vacuum_test with (min_deleted_fraction=2);"),
+        std::runtime_error);
+    // Only the fragments without live rows.
+    run_ddl_statement("optimize table vacuum_test with (min_deleted_fraction=0.6);");
+    ASSERT_EQ(size_t(3), num_fragments());
+    ASSERT_EQ(int64_t(25),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test;", dt)));
+    run_ddl_statement("optimize table vacuum_test;");
+    ASSERT_EQ(size_t(3), num_fragments());
+    ASSERT_EQ(int64_t(25),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM vacuum_test;", dt)));
+    ASSERT_EQ(int64_t(325),
+              v<int64_t>(run_simple_agg("SELECT SUM(i1) FROM vacuum_test;", dt)));
+    ASSERT_EQ("23",
+              boost::get<std::string>(v<NullableString>(
+                  run_simple_agg("SELECT t1 FROM vacuum_test WHERE i1 = 23;", dt))));
+    run_ddl_statement("drop table vacuum_test;");
+  }
+}
+
+TEST(Delete, FragmentsWithoutDeletes) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  if (std::is_same<CalciteDeletePathSelector, PreprocessorFalse>::value) {
+    return;
+  }
+
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+
+    run_ddl_statement("drop table if exists sparse_delete_test;");
+    run_ddl_statement(
+        "create table sparse_delete_test (i1 integer) with (vacuum='delayed', "
+        "fragment_size=10);");
+    for (int i = 1; i <= 100; i++) {
+      run_multiple_agg(
+          "insert into sparse_delete_test values (" + std::to_string(i) + ");", dt);
+    }
+    // Only one of the ten fragments has a deleted row.
+    run_multiple_agg("delete from sparse_delete_test where i1 = 55;", dt);
+    ASSERT_EQ(int64_t(99),
+              v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM sparse_delete_test;", dt)));
+    ASSERT_EQ(int64_t(5050 - 55),
+              v<int64_t>(run_simple_agg("SELECT SUM(i1) FROM sparse_delete_test;", dt)));
+    run_ddl_statement("drop table sparse_delete_test;");
+  }
+}
+
 TEST(Delete, Joins_ImplicitJoins) {
   SKIP_ALL_ON_AGGREGATOR();
 
@@ -9691,6 +11345,19 @@ TEST(Select, GeoSpatial_Basics) {
         v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM geospatial_test WHERE "
                                   "ST_Distance(ST_GeomFromText('POINT(0 0)'), p) < 9;",
                                   dt)));
+    ASSERT_EQ(
+        static_cast<int64_t>(7),
+        v<int64_t>(run_simple_agg("SELECT COUNT(*) FROM geospatial_test WHERE "
+                                  "ST_Distance(p, ST_GeomFromText('POINT(0 0)')) < 9;",
+                                  dt)));
+    ASSERT_EQ(v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM geospatial_test WHERE ST_Distance(gp4326, "
+                  "ST_GeomFromText('POINT(2 2)', 4326)) < 3;",
+                  dt)),
+              v<int64_t>(run_simple_agg(
+                  "SELECT COUNT(*) FROM geospatial_test WHERE ST_Distance(gp4326none, "
+                  "ST_GeomFromText('POINT(2 2)', 4326)) < 3;",
+                  dt)));
     ASSERT_EQ(
         static_cast<int64_t>(5),
         v<int64_t>(run_simple_agg(
@@ -11058,6 +12725,69 @@ TEST(Select, Sample) {
   }
 }
 
+TEST(Select, WindowFunctions) {
+  SKIP_ALL_ON_AGGREGATOR();
+
+  run_ddl_statement("DROP TABLE IF EXISTS window_func_test;");
+  run_ddl_statement(
+      "CREATE TABLE window_func_test (grp INT, v INT, w INT, s TEXT ENCODING DICT) WITH "
+      "(fragment_size=2);");
+  for (const auto& row : {"1, 10, 1, 'b'",
+                          "1, 20, NULL, 'a'",
+                          "1, 20, 3, 'c'",
+                          "2, 5, 4, 'a'",
+                          "2, 6, NULL, 'b'",
+                          "3, 7, NULL, 'c'"}) {
+    run_multiple_agg(std::string("INSERT INTO window_func_test VALUES(") + row + ");",
+                     ExecutorDeviceType::CPU);
+  }
+  const auto check_rows = [](const std::string& query,
+                             const std::vector<std::vector<int64_t>>& expected,
+                             const ExecutorDeviceType dt) {
+    const auto rows = run_multiple_agg(query, dt);
+    for (const auto& expected_row : expected) {
+      const auto crt_row = rows->getNextRow(true, true);
+      ASSERT_EQ(expected_row.size(), crt_row.size());
+      for (size_t i = 0; i < expected_row.size(); ++i) {
+        ASSERT_EQ(expected_row[i], v<int64_t>(crt_row[i]));
+      }
+    }
+    ASSERT_EQ(size_t(0), rows->getNextRow(true, true).size());
+  };
+  for (auto dt : {ExecutorDeviceType::CPU, ExecutorDeviceType::GPU}) {
+    SKIP_NO_GPU();
+    check_rows(
+        "SELECT grp, v, ROW_NUMBER() OVER (PARTITION BY grp ORDER BY v, s) AS rn, RANK() "
+        "OVER (PARTITION BY grp ORDER BY v) AS r, DENSE_RANK() OVER (PARTITION BY grp "
+        "ORDER BY v) AS dr FROM window_func_test ORDER BY grp, rn;",
+        {{1, 10, 1, 1, 1},
+         {1, 20, 2, 2, 2},
+         {1, 20, 3, 2, 2},
+         {2, 5, 1, 1, 1},
+         {2, 6, 2, 2, 2},
+         {3, 7, 1, 1, 1}},
+        dt);
+    // The peers of the current row are in the frame, the nulls aren't counted.
+    check_rows(
+        "SELECT grp, v, SUM(w) OVER (PARTITION BY grp ORDER BY v) AS running, COUNT(w) "
+        "OVER (PARTITION BY grp) AS cnt FROM window_func_test WHERE grp < 3 ORDER BY "
+        "grp, v;",
+        {{1, 10, 1, 2}, {1, 20, 4, 2}, {1, 20, 4, 2}, {2, 5, 4, 1}, {2, 6, 4, 1}},
+        dt);
+    check_rows(
+        "SELECT v, LAG(v, 1, 0) OVER (ORDER BY v, s) AS prev, v - MIN(v) OVER "
+        "(PARTITION BY grp) AS delta FROM window_func_test ORDER BY v, prev;",
+        {{5, 0, 0}, {6, 5, 1}, {7, 6, 0}, {10, 7, 0}, {20, 10, 10}, {20, 20, 10}},
+        dt);
+    ASSERT_EQ("a",
+              boost::get<std::string>(v<NullableString>(run_simple_agg(
+                  "SELECT FIRST_VALUE(s) OVER (PARTITION BY grp ORDER BY s) FROM "
+                  "window_func_test WHERE grp = 1 ORDER BY v LIMIT 1;",
+                  dt))));
+  }
+  run_ddl_statement("DROP TABLE window_func_test;");
+}
+
 namespace {
 
 int create_sharded_join_table(const std::string& table_name,
@@ -0,0 +1,595 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    ImportBenchmark.cpp
+ * @brief   Ingest throughput of the import paths, per stage and thread count.
+ *
+ * Loads the same generated table through the delimited file importer, the Parquet
+ * importer, the Arrow stream path of load_table_binary_arrow and the columnar path of
+ * load_table_binary_columnar, which the Kafka and stream importers use, with an
+ * increasing number of threads. The threads of the binary paths are concurrent
+ * clients, each load is a call of the server. Reports the rows and megabytes per
+ * second and where the time went: reading the input, parsing it into the import
+ * buffers, encoding the dictionary strings, inserting into the table and checkpointing.
+ * The stage times are summed over the threads. The results are written as JSON.
+ */
+
+#include "../Catalog/Catalog.h"
+#include "../Import/Importer.h"
+#include "../QueryEngine/ArrowUtil.h"
+#include "../QueryRunner/QueryRunner.h"
+#include "../Shared/measure.h"
+#include "gen-cpp/mapd_types.h"
+
+#include <arrow/api.h>
+#include <arrow/io/memory.h>
+#include <arrow/ipc/api.h>
+#ifdef ENABLE_IMPORT_PARQUET
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+#endif  // ENABLE_IMPORT_PARQUET
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <atomic>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef BASE_PATH
+#define BASE_PATH "./tmp"
+#endif
+
+namespace {
+
+const std::string g_table_name{"import_benchmark"};
+
+using SessionPtr = std::unique_ptr<Catalog_Namespace::SessionInfo>;
+
+// A fact table with numbers, a low cardinality and a high cardinality string column.
+struct GeneratedTable {
+  std::vector<int64_t> ids;
+  std::vector<int32_t> quantities;
+  std::vector<double> prices;
+  std::vector<std::string> categories;
+  std::vector<std::string> names;
+
+  size_t size() const { return ids.size(); }
+};
+
+GeneratedTable generate_table(const size_t row_count, const unsigned seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int32_t> quantity_dist(1, 50);
+  std::uniform_real_distribution<double> price_dist(1, 10000);
+  std::uniform_int_distribution<int> category_dist(0, 99);
+  std::uniform_int_distribution<size_t> name_dist(0, std::max(row_count / 4, size_t(1)));
+  GeneratedTable table;
+  for (size_t i = 0; i < row_count; ++i) {
+    // drawn one statement at a time, the order of evaluation within an expression is
+    // unspecified and the data has to be the same for every build
+    table.ids.push_back(i);
+    table.quantities.push_back(quantity_dist(rng));
+    table.prices.push_back(std::round(price_dist(rng) * 100) / 100);
+    table.categories.push_back("category_" + std::to_string(category_dist(rng)));
+    table.names.push_back("name_" + std::to_string(name_dist(rng)));
+  }
+  return table;
+}
+
+void create_table(const SessionPtr& session) {
+  QueryRunner::run_ddl_statement("DROP TABLE IF EXISTS " + g_table_name + ";", session);
+  QueryRunner::run_ddl_statement(
+      "CREATE TABLE " + g_table_name +
+          " (id BIGINT, quantity INTEGER, price DOUBLE, category TEXT ENCODING DICT, "
+          "name TEXT ENCODING DICT);",
+      session);
+}
+
+const TableDescriptor* get_table(
+    const SessionPtr& session) {
+  const auto td = session->get_catalog().getMetadataForTable(g_table_name);
+  CHECK(td);
+  return td;
+}
+
+struct StageTimes {
+  int64_t read_us{0};
+  int64_t parse_us{0};
+  int64_t encode_us{0};
+  int64_t load_us{0};
+  int64_t checkpoint_us{0};
+};
+
+struct IngestResult {
+  std::string format;
+  size_t threads;
+  size_t rows;
+  size_t bytes;
+  int64_t elapsed_ms;
+  StageTimes stages;
+};
+
+// The stage times of the importer. The dictionary encoding happens within the loads,
+// it is taken out of their time.
+StageTimes stage_times(const Importer_NS::ImportStatus& import_status,
+                       const Importer_NS::Loader& loader) {
+  StageTimes stages;
+  stages.read_us = import_status.read_us;
+  stages.parse_us = import_status.parse_us;
+  stages.encode_us = loader.getDictEncodeTime();
+  stages.load_us = import_status.load_us - stages.encode_us;
+  stages.checkpoint_us = import_status.checkpoint_us;
+  return stages;
+}
+
+void write_csv(const std::string& path, const GeneratedTable& table) {
+  std::ofstream csv(path);
+  csv << "id,quantity,price,category,name\n";
+  for (size_t i = 0; i < table.size(); ++i) {
+    csv << table.ids[i] << "," << table.quantities[i] << "," << table.prices[i] << ","
+        << table.categories[i] << "," << table.names[i] << "\n";
+  }
+}
+
+// Runs the importer on the given file, as COPY FROM does.
+IngestResult run_importer(const std::string& format,
+                          const std::string& path,
+                          Importer_NS::CopyParams copy_params,
+                          const size_t threads,
+                          const SessionPtr& session) {
+  create_table(session);
+  copy_params.threads = threads;
+  // owned by the importer
+  auto loader = new Importer_NS::Loader(session->get_catalog(), get_table(session));
+  Importer_NS::Importer importer(loader, path, copy_params);
+  Importer_NS::ImportStatus import_status;
+  const auto elapsed_ms =
+      measure<>::execution([&]() { import_status = importer.import(); });
+  return {format,
+          threads,
+          import_status.rows_completed,
+          boost::filesystem::file_size(path),
+          elapsed_ms,
+          stage_times(import_status, *loader)};
+}
+
+std::shared_ptr<arrow::RecordBatch> make_record_batch(const GeneratedTable& table,
+                                                      const size_t begin,
+                                                      const size_t end) {
+  arrow::Int64Builder id_builder;
+  arrow::Int32Builder quantity_builder;
+  arrow::DoubleBuilder price_builder;
+  arrow::StringBuilder category_builder;
+  arrow::StringBuilder name_builder;
+  for (size_t i = begin; i < end; ++i) {
+    ARROW_THROW_NOT_OK(id_builder.Append(table.ids[i]));
+    ARROW_THROW_NOT_OK(quantity_builder.Append(table.quantities[i]));
+    ARROW_THROW_NOT_OK(price_builder.Append(table.prices[i]));
+    ARROW_THROW_NOT_OK(category_builder.Append(table.categories[i]));
+    ARROW_THROW_NOT_OK(name_builder.Append(table.names[i]));
+  }
+  std::vector<std::shared_ptr<arrow::Array>> arrays(5);
+  ARROW_THROW_NOT_OK(id_builder.Finish(&arrays[0]));
+  ARROW_THROW_NOT_OK(quantity_builder.Finish(&arrays[1]));
+  ARROW_THROW_NOT_OK(price_builder.Finish(&arrays[2]));
+  ARROW_THROW_NOT_OK(category_builder.Finish(&arrays[3]));
+  ARROW_THROW_NOT_OK(name_builder.Finish(&arrays[4]));
+  const auto schema = arrow::schema({arrow::field("id", arrow::int64()),
+                                     arrow::field("quantity", arrow::int32()),
+                                     arrow::field("price", arrow::float64()),
+                                     arrow::field("category", arrow::utf8()),
+                                     arrow::field("name", arrow::utf8())});
+  return arrow::RecordBatch::Make(schema, end - begin, arrays);
+}
+
+#ifdef ENABLE_IMPORT_PARQUET
+void write_parquet(const std::string& path,
+                   const GeneratedTable& table,
+                   const size_t row_group_size) {
+  std::shared_ptr<arrow::Table> arrow_table;
+  PARQUET_THROW_NOT_OK(arrow::Table::FromRecordBatches(
+      {make_record_batch(table, 0, table.size())}, &arrow_table));
+  std::shared_ptr<arrow::io::FileOutputStream> out;
+  PARQUET_THROW_NOT_OK(arrow::io::FileOutputStream::Open(path, &out));
+  PARQUET_THROW_NOT_OK(parquet::arrow::WriteTable(
+      *arrow_table, arrow::default_memory_pool(), out, row_group_size));
+  PARQUET_THROW_NOT_OK(out->Close());
+}
+#endif  // ENABLE_IMPORT_PARQUET
+
+// The payload of a load_table_binary_arrow call, a stream with a single batch.
+std::string serialize_record_batch(const arrow::RecordBatch& batch) {
+  std::shared_ptr<arrow::io::BufferOutputStream> sink;
+  ARROW_THROW_NOT_OK(arrow::io::BufferOutputStream::Create(
+      1 << 20, arrow::default_memory_pool(), &sink));
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  ARROW_THROW_NOT_OK(
+      arrow::ipc::RecordBatchStreamWriter::Open(sink.get(), batch.schema(), &writer));
+  ARROW_THROW_NOT_OK(writer->WriteRecordBatch(batch));
+  ARROW_THROW_NOT_OK(writer->Close());
+  std::shared_ptr<arrow::Buffer> buffer;
+  ARROW_THROW_NOT_OK(sink->Finish(&buffer));
+  return buffer->ToString();
+}
+
+std::shared_ptr<arrow::RecordBatch> read_record_batch(const std::string& stream) {
+  auto stream_buffer =
+      std::make_shared<arrow::Buffer>(reinterpret_cast<const uint8_t*>(stream.c_str()),
+                                      static_cast<int64_t>(stream.size()));
+  arrow::io::BufferReader buf_reader(stream_buffer);
+  std::shared_ptr<arrow::RecordBatchReader> batch_reader;
+  ARROW_THROW_NOT_OK(
+      arrow::ipc::RecordBatchStreamReader::Open(&buf_reader, &batch_reader));
+  std::shared_ptr<arrow::RecordBatch> batch;
+  ARROW_THROW_NOT_OK(batch_reader->ReadNext(&batch));
+  CHECK(batch);
+  return batch;
+}
+
+// The payload of a load_table_binary_columnar call.
+std::vector<TColumn> make_columns(const GeneratedTable& table,
+                                  const size_t begin,
+                                  const size_t end) {
+  std::vector<TColumn> columns(5);
+  for (size_t i = begin; i < end; ++i) {
+    columns[0].data.int_col.push_back(table.ids[i]);
+    columns[1].data.int_col.push_back(table.quantities[i]);
+    columns[2].data.real_col.push_back(table.prices[i]);
+    columns[3].data.str_col.push_back(table.categories[i]);
+    columns[4].data.str_col.push_back(table.names[i]);
+  }
+  for (auto& column : columns) {
+    column.nulls.resize(end - begin, false);
+  }
+  return columns;
+}
+
+size_t columns_size(const std::vector<TColumn>& columns) {
+  size_t bytes{0};
+  for (const auto& column : columns) {
+    bytes += column.data.int_col.size() * sizeof(int64_t) +
+             column.data.real_col.size() * sizeof(double) + column.nulls.size();
+    for (const auto& str : column.data.str_col) {
+      bytes += str.size();
+    }
+  }
+  return bytes;
+}
+
+using ImportBuffers = std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>;
+
+ImportBuffers make_import_buffers(const Importer_NS::Loader& loader) {
+  ImportBuffers import_buffers;
+  for (const auto cd : loader.get_column_descs()) {
+    import_buffers.emplace_back(
+        new Importer_NS::TypedImportBuffer(cd, loader.get_string_dict(cd)));
+  }
+  return import_buffers;
+}
+
+// Hands the payloads out to the client threads, each payload is loaded as one call of
+// the server would: with a loader of its own. Returns the time of the whole load.
+template <class PAYLOAD, class LOAD_PAYLOAD>
+int64_t run_clients(const std::vector<PAYLOAD>& payloads,
+                    const size_t threads,
+                    const LOAD_PAYLOAD& load_payload) {
+  std::atomic<size_t> next_payload{0};
+  return measure<>::execution([&]() {
+    std::vector<std::future<void>> clients;
+    for (size_t i = 0; i < threads; ++i) {
+      clients.push_back(std::async(std::launch::async, [&]() {
+        for (size_t payload_idx = next_payload++; payload_idx < payloads.size();
+             payload_idx = next_payload++) {
+          load_payload(payloads[payload_idx]);
+        }
+      }));
+    }
+    for (auto& client : clients) {
+      client.get();
+    }
+  });
+}
+
+// As load_table_binary_arrow, every call checkpoints, within the time of the loads.
+IngestResult run_arrow(const std::vector<std::string>& streams,
+                       const size_t threads,
+                       const SessionPtr& session) {
+  create_table(session);
+  const auto td = get_table(session);
+  std::atomic<int64_t> read_us{0};
+  std::atomic<int64_t> parse_us{0};
+  std::atomic<int64_t> encode_us{0};
+  std::atomic<int64_t> load_us{0};
+  std::atomic<size_t> row_count{0};
+  const auto elapsed_ms = run_clients(streams, threads, [&](const std::string& stream) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    read_us += measure<std::chrono::microseconds>::execution(
+        [&]() { batch = read_record_batch(stream); });
+    Importer_NS::Loader loader(session->get_catalog(), td);
+    auto import_buffers = make_import_buffers(loader);
+    size_t batch_rows{0};
+    parse_us += measure<std::chrono::microseconds>::execution([&]() {
+      size_t col_idx = 0;
+      for (const auto cd : loader.get_column_descs()) {
+        batch_rows =
+            import_buffers[col_idx]->add_arrow_values(cd, *batch->column(col_idx));
+        ++col_idx;
+      }
+    });
+    load_us += measure<std::chrono::microseconds>::execution(
+        [&]() { loader.load(import_buffers, batch_rows); });
+    encode_us += loader.getDictEncodeTime();
+    row_count += batch_rows;
+  });
+  size_t bytes{0};
+  for (const auto& stream : streams) {
+    bytes += stream.size();
+  }
+  StageTimes stages;
+  stages.read_us = read_us;
+  stages.parse_us = parse_us;
+  stages.encode_us = encode_us;
+  stages.load_us = load_us - encode_us;
+  return {"arrow", threads, row_count, bytes, elapsed_ms, stages};
+}
+
+// As the Kafka and stream importers use load_table_binary_columnar: the batches are
+// loaded without a checkpoint and the table is checkpointed once at the end, as
+// checkpoint_table does.
+IngestResult run_columnar(const std::vector<std::vector<TColumn>>& batches,
+                          const size_t threads,
+                          const SessionPtr& session) {
+  create_table(session);
+  const auto td = get_table(session);
+  std::atomic<int64_t> parse_us{0};
+  std::atomic<int64_t> encode_us{0};
+  std::atomic<int64_t> load_us{0};
+  std::atomic<size_t> row_count{0};
+  auto elapsed_ms = run_clients(batches, threads, [&](const std::vector<TColumn>& cols) {
+    Importer_NS::Loader loader(session->get_catalog(), td);
+    auto import_buffers = make_import_buffers(loader);
+    size_t batch_rows{0};
+    parse_us += measure<std::chrono::microseconds>::execution([&]() {
+      size_t col_idx = 0;
+      for (const auto cd : loader.get_column_descs()) {
+        batch_rows = import_buffers[col_idx]->add_values(cd, cols[col_idx]);
+        ++col_idx;
+      }
+    });
+    load_us += measure<std::chrono::microseconds>::execution(
+        [&]() { loader.loadNoCheckpoint(import_buffers, batch_rows); });
+    encode_us += loader.getDictEncodeTime();
+    row_count += batch_rows;
+  });
+  auto& cat = session->get_catalog();
+  const auto checkpoint_ms = measure<>::execution([&]() {
+    const auto cds = cat.getAllColumnMetadataForTable(td->tableId, false, false, false);
+    for (const auto cd : cds) {
+      if (cd->columnType.get_compression() == kENCODING_DICT) {
+        const auto dd = cat.getMetadataForDict(cd->columnType.get_comp_param());
+        CHECK(dd);
+        CHECK(dd->stringDict->checkpoint());
+      }
+    }
+    Importer_NS::Loader(cat, td).checkpoint();
+  });
+  elapsed_ms += checkpoint_ms;
+  size_t bytes{0};
+  for (const auto& cols : batches) {
+    bytes += columns_size(cols);
+  }
+  StageTimes stages;
+  stages.parse_us = parse_us;
+  stages.encode_us = encode_us;
+  stages.load_us = load_us - encode_us;
+  stages.checkpoint_us = checkpoint_ms * 1000;
+  return {"columnar", threads, row_count, bytes, elapsed_ms, stages};
+}
+
+std::string to_json(const size_t row_count,
+                    const unsigned seed,
+                    const std::vector<IngestResult>& results) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("rows");
+  writer.Uint64(row_count);
+  writer.Key("seed");
+  writer.Uint(seed);
+  writer.Key("results");
+  writer.StartArray();
+  for (const auto& result : results) {
+    const double seconds = std::max(result.elapsed_ms, int64_t(1)) / 1000.;
+    writer.StartObject();
+    writer.Key("format");
+    writer.String(result.format.c_str());
+    writer.Key("threads");
+    writer.Uint64(result.threads);
+    writer.Key("rows");
+    writer.Uint64(result.rows);
+    writer.Key("bytes");
+    writer.Uint64(result.bytes);
+    writer.Key("elapsed_ms");
+    writer.Int64(result.elapsed_ms);
+    writer.Key("rows_per_second");
+    writer.Double(result.rows / seconds);
+    writer.Key("mb_per_second");
+    writer.Double(result.bytes / seconds / (1 << 20));
+    writer.Key("stage_ms");
+    writer.StartObject();
+    writer.Key("read");
+    writer.Double(result.stages.read_us / 1000.);
+    writer.Key("parse");
+    writer.Double(result.stages.parse_us / 1000.);
+    writer.Key("dictionary_encode");
+    writer.Double(result.stages.encode_us / 1000.);
+    writer.Key("load");
+    writer.Double(result.stages.load_us / 1000.);
+    writer.Key("checkpoint");
+    writer.Double(result.stages.checkpoint_us / 1000.);
+    writer.EndObject();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string db_path{BASE_PATH};
+  size_t row_count{2000000};
+  size_t batch_size{100000};
+  unsigned seed{42};
+  std::string thread_counts_str{"1,2,4,8"};
+  std::string formats_str{"csv,parquet,arrow,columnar"};
+  std::string output_path;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()(
+      "path", po::value<std::string>(&db_path)->default_value(db_path), "Data directory");
+  desc.add_options()("rows",
+                     po::value<size_t>(&row_count)->default_value(row_count),
+                     "Number of rows loaded by each run");
+  desc.add_options()("batch-size",
+                     po::value<size_t>(&batch_size)->default_value(batch_size),
+                     "Rows per Parquet row group and per call of the binary loads");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the data");
+  desc.add_options()("threads",
+                     po::value<std::string>(&thread_counts_str)
+                         ->default_value(thread_counts_str),
+                     "Comma separated thread counts to run with");
+  desc.add_options()("formats",
+                     po::value<std::string>(&formats_str)->default_value(formats_str),
+                     "Comma separated import paths to run");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: ImportBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<std::string> formats;
+  boost::split(formats, formats_str, boost::is_any_of(","));
+  std::vector<std::string> thread_count_strs;
+  boost::split(thread_count_strs, thread_counts_str, boost::is_any_of(","));
+  std::vector<size_t> thread_counts;
+  for (const auto& str : thread_count_strs) {
+    thread_counts.push_back(std::stoul(str));
+  }
+  const auto runs_format = [&formats](const std::string& format) {
+    return std::find(formats.begin(), formats.end(), format) != formats.end();
+  };
+
+  std::unique_ptr<Catalog_Namespace::SessionInfo> session(
+      QueryRunner::get_session(db_path.c_str()));
+
+  const auto data_dir =
+      boost::filesystem::temp_directory_path() / "mapd_import_benchmark";
+  boost::filesystem::create_directories(data_dir);
+  const auto table = generate_table(row_count, seed);
+  std::vector<IngestResult> results;
+  const auto report = [&results](const IngestResult& result) {
+    results.push_back(result);
+    std::cerr << std::left << std::setw(10) << result.format << std::right
+              << std::setw(4) << result.threads << " threads" << std::setw(12)
+              << std::fixed << std::setprecision(0)
+              << result.rows / (std::max(result.elapsed_ms, int64_t(1)) / 1000.)
+              << " rows/s" << std::endl;
+  };
+
+  if (runs_format("csv")) {
+    const auto csv_path = (data_dir / "import_benchmark.csv").string();
+    write_csv(csv_path, table);
+    Importer_NS::CopyParams copy_params;
+    copy_params.has_header = true;
+    for (const auto threads : thread_counts) {
+      report(run_importer("csv", csv_path, copy_params, threads, session));
+    }
+  }
+#ifdef ENABLE_IMPORT_PARQUET
+  if (runs_format("parquet")) {
+    const auto parquet_path = (data_dir / "import_benchmark.parquet").string();
+    write_parquet(parquet_path, table, batch_size);
+    Importer_NS::CopyParams copy_params;
+    copy_params.is_parquet = true;
+    for (const auto threads : thread_counts) {
+      report(run_importer("parquet", parquet_path, copy_params, threads, session));
+    }
+  }
+#else
+  if (runs_format("parquet")) {
+    LOG(WARNING) << "Parquet support not available, skipping the parquet runs";
+  }
+#endif  // ENABLE_IMPORT_PARQUET
+  if (runs_format("arrow")) {
+    std::vector<std::string> streams;
+    for (size_t begin = 0; begin < row_count; begin += batch_size) {
+      streams.push_back(serialize_record_batch(
+          *make_record_batch(table, begin, std::min(begin + batch_size, row_count))));
+    }
+    for (const auto threads : thread_counts) {
+      report(run_arrow(streams, threads, session));
+    }
+  }
+  if (runs_format("columnar")) {
+    std::vector<std::vector<TColumn>> batches;
+    for (size_t begin = 0; begin < row_count; begin += batch_size) {
+      batches.push_back(
+          make_columns(table, begin, std::min(begin + batch_size, row_count)));
+    }
+    for (const auto threads : thread_counts) {
+      report(run_columnar(batches, threads, session));
+    }
+  }
+
+  QueryRunner::run_ddl_statement("DROP TABLE IF EXISTS " + g_table_name + ";", session);
+  boost::filesystem::remove_all(data_dir);
+
+  const auto json = to_json(row_count, seed, results);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+  return 0;
+}
@@ -19,6 +19,7 @@
 #include "../Import/Importer.h"
 
 #include <algorithm>
+#include <fstream>
 #include <string>
 
 #include <glog/logging.h>
@@ -32,6 +33,13 @@
 #include "../Shared/geo_types.h"
 #include "boost/filesystem.hpp"
 
+#ifdef ENABLE_IMPORT_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+#endif  // ENABLE_IMPORT_PARQUET
+
 #ifndef BASE_PATH
 #define BASE_PATH "./tmp"
 #endif
@@ -248,6 +256,29 @@ TEST(Detect, Numeric) {
   d(kTEXT, "1.22.22");
 }
 
+TEST(StringToDatum, PlainValues) {
+  // Spellings taking the fast path and the general one have to agree.
+  SQLTypeInfo timestamp_ti(kTIMESTAMP, false);
+  EXPECT_EQ(1514862245, StringToDatum("2018-01-02 03:04:05", timestamp_ti).timeval);
+  EXPECT_EQ(1514862245, StringToDatum("2018-01-02T03:04:05", timestamp_ti).timeval);
+  EXPECT_EQ(1514862240, StringToDatum("2018-01-02 03:04", timestamp_ti).timeval);
+  SQLTypeInfo timestamp3_ti(kTIMESTAMP, 3, 0, false);
+  EXPECT_EQ(1514862245000, StringToDatum("2018-01-02 03:04:05", timestamp3_ti).timeval);
+  EXPECT_EQ(1514862245123,
+            StringToDatum("2018-01-02 03:04:05.123", timestamp3_ti).timeval);
+  SQLTypeInfo date_ti(kDATE, false);
+  EXPECT_EQ(1514851200, StringToDatum("2018-01-02", date_ti).timeval);
+  EXPECT_EQ(1514851200, StringToDatum("01/02/2018", date_ti).timeval);
+  SQLTypeInfo int_ti(kINT, false);
+  EXPECT_EQ(-123, StringToDatum("-123", int_ti).intval);
+  EXPECT_EQ(77, StringToDatum("+77", int_ti).intval);
+  EXPECT_EQ(12, StringToDatum(" 12", int_ti).intval);
+  EXPECT_THROW(StringToDatum("3000000000", int_ti), std::out_of_range);
+  SQLTypeInfo bigint_ti(kBIGINT, false);
+  EXPECT_EQ(-9223372036854775807,
+            StringToDatum("-9223372036854775807", bigint_ti).bigintval);
+}
+
 const char* create_table_fix1 = R"(
     CREATE TABLE fix1(
       pt GEOMETRY(POINT),
@@ -397,6 +428,107 @@ TEST_F(ImportTestSharded, One_csv_file) {
   EXPECT_TRUE(import_test_local("sharded_trip_data_9.csv", 100, 1.0));
 }
 
+namespace {
+
+int64_t select_int(const std::string& query_str) {
+  auto rows = run_query(query_str);
+  auto crt_row = rows->getNextRow(true, true);
+  CHECK_EQ(size_t(1), crt_row.size());
+  return v<int64_t>(crt_row[0]);
+}
+
+}  // namespace
+
+TEST(ImportPrimaryKey, Upsert) {
+  ASSERT_NO_THROW(run_ddl_statement("drop table if exists upsert;"););
+  EXPECT_THROW(run_ddl_statement("create table upsert (id int, v int) with "
+                                 "(primary_key='id');"),
+               std::runtime_error);
+  EXPECT_THROW(run_ddl_statement("create table upsert (id int not null, s text "
+                                 "encoding none) with (primary_key='id');"),
+               std::runtime_error);
+  ASSERT_NO_THROW(
+      run_ddl_statement("create table upsert (id int not null, v int, s text) with "
+                        "(primary_key='id', fragment_size=2);"););
+  const auto file_path =
+      boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  const auto copy_rows = [&file_path](const std::string& rows,
+                                      const std::string& options) {
+    {
+      std::ofstream file(file_path.string());
+      file << rows;
+    }
+    run_ddl_statement("copy upsert from '" + file_path.string() +
+                      "' with (header='false'" + options + ");");
+  };
+  // The last row of a key in a batch wins.
+  copy_rows("1,10,a\n2,20,b\n3,30,c\n1,11,d\n", "");
+  EXPECT_EQ(3, select_int("select count(*) from upsert;"));
+  EXPECT_EQ(11, select_int("select v from upsert where id = 1;"));
+
+  copy_rows("2,21,e\n4,40,f\n", "");
+  EXPECT_EQ(4, select_int("select count(*) from upsert;"));
+  EXPECT_EQ(21, select_int("select v from upsert where id = 2;"));
+  EXPECT_EQ(1, select_int("select count(*) from upsert where s = 'e';"));
+
+  copy_rows("3,31,g\n5,50,h\n", ", on_duplicate_key='skip'");
+  EXPECT_EQ(5, select_int("select count(*) from upsert;"));
+  EXPECT_EQ(30, select_int("select v from upsert where id = 3;"));
+
+  boost::filesystem::remove(file_path);
+  ASSERT_NO_THROW(run_ddl_statement("drop table upsert;"););
+}
+
+#ifdef ENABLE_IMPORT_PARQUET
+TEST(ImportExternalParquet, QueryInPlace) {
+  ASSERT_NO_THROW(run_ddl_statement("drop table if exists external_parquet;"););
+  const auto file_path = boost::filesystem::temp_directory_path() /
+                         boost::filesystem::unique_path("%%%%-%%%%.parquet");
+  {
+    arrow::Int32Builder id_builder;
+    arrow::StringBuilder str_builder;
+    const std::vector<std::string> strs{"a", "b", "", "c", "a", "b"};
+    for (size_t i = 0; i < strs.size(); ++i) {
+      PARQUET_THROW_NOT_OK(id_builder.Append(i + 1));
+      PARQUET_THROW_NOT_OK(strs[i].empty() ? str_builder.AppendNull()
+                                           : str_builder.Append(strs[i]));
+    }
+    std::shared_ptr<arrow::Array> ids;
+    PARQUET_THROW_NOT_OK(id_builder.Finish(&ids));
+    std::shared_ptr<arrow::Array> strings;
+    PARQUET_THROW_NOT_OK(str_builder.Finish(&strings));
+    const auto schema = arrow::schema(
+        {arrow::field("id", arrow::int32()), arrow::field("s", arrow::utf8())});
+    const auto table = arrow::Table::Make(schema, {ids, strings});
+    std::shared_ptr<arrow::io::FileOutputStream> outfile;
+    PARQUET_THROW_NOT_OK(arrow::io::FileOutputStream::Open(file_path.string(), &outfile));
+    // Row groups of two rows, three fragments.
+    PARQUET_THROW_NOT_OK(
+        parquet::arrow::WriteTable(*table, arrow::default_memory_pool(), outfile, 2));
+  }
+  EXPECT_THROW(run_ddl_statement("create table external_parquet (id int, s text "
+                                 "encoding none) with (external_parquet='" +
+                                 file_path.string() + "');"),
+               std::runtime_error);
+  ASSERT_NO_THROW(run_ddl_statement("create table external_parquet (id int, s text) "
+                                    "with (external_parquet='" +
+                                    file_path.string() + "');"););
+  EXPECT_EQ(6, select_int("select count(*) from external_parquet;"));
+  EXPECT_EQ(11, select_int("select sum(id) from external_parquet where id > 4;"));
+  EXPECT_EQ(2, select_int("select count(*) from external_parquet where s = 'a';"));
+  EXPECT_EQ(1, select_int("select count(*) from external_parquet where s is null;"));
+  EXPECT_EQ(3, select_int("select id from external_parquet where s is null;"));
+  EXPECT_THROW(run_ddl_statement("truncate table external_parquet;"),
+               std::runtime_error);
+  EXPECT_THROW(run_query("insert into external_parquet values (7, 'd');"),
+               std::runtime_error);
+  EXPECT_EQ(6, select_int("select count(*) from external_parquet;"));
+  ASSERT_NO_THROW(run_ddl_statement("drop table external_parquet;"););
+  EXPECT_TRUE(boost::filesystem::exists(file_path));
+  boost::filesystem::remove(file_path);
+}
+#endif  // ENABLE_IMPORT_PARQUET
+
 namespace {
 const char* create_table_geo = R"(
     CREATE TABLE geospatial (
@@ -0,0 +1,780 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    MicroBenchmark.cpp
+ * @brief   Micro benchmarks of the runtime functions and of the hash join kernels.
+ *
+ * Runs the hash join table fills, the aggregate functions, the group by probes and
+ * the string matching functions in isolation, on generated columns of varying
+ * cardinality, key width and null ratio, on CPU and on GPU when there is one. Each
+ * benchmark is repeated until it ran for a minimum time, in the manner of Google
+ * Benchmark, and reported as the time per iteration and the rows per second.
+ */
+
+#include "../QueryEngine/HashJoinRuntime.h"
+#include "../QueryEngine/RuntimeFunctions.h"
+#include "../Shared/measure.h"
+#include "../Shared/sqltypes.h"
+#include "../Shared/thread_count.h"
+#include "../Utils/StringLike.h"
+#ifdef HAVE_CUDA
+#include "../CudaMgr/CudaMgr.h"
+#endif  // HAVE_CUDA
+
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::vector<size_t> g_cardinalities{1 << 10, 1 << 16, 1 << 22};
+const std::vector<double> g_null_ratios{0, 0.1, 0.5};
+
+const int32_t g_invalid_slot_val{-1};
+
+// Keeps the results of the benchmarked functions alive.
+volatile int64_t g_sink;
+
+// Runs the given number of iterations of a benchmark.
+using RunFunction = std::function<void(const size_t iterations)>;
+
+struct Benchmark {
+  std::string name;
+  size_t rows_per_iteration;
+  // Generates the data of the benchmark, which only lives as long as the returned
+  // function, so that the data of a single benchmark is in memory at once.
+  std::function<RunFunction()> setup;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  size_t iterations;
+  double ns_per_iteration;
+  double rows_per_second;
+};
+
+BenchmarkResult run_benchmark(const Benchmark& benchmark, const double min_time_ms) {
+  const auto run = benchmark.setup();
+  // a first iteration to fault in the buffers and warm up the caches
+  run(1);
+  size_t iterations{1};
+  while (true) {
+    const auto elapsed_us =
+        measure<std::chrono::microseconds>::execution([&]() { run(iterations); });
+    if (elapsed_us >= min_time_ms * 1000 || iterations >= 1000000000) {
+      const double ns_per_iteration = elapsed_us * 1000. / iterations;
+      return {benchmark.name,
+              iterations,
+              ns_per_iteration,
+              ns_per_iteration > 0 ? benchmark.rows_per_iteration * 1e9 / ns_per_iteration
+                                   : 0};
+    }
+    // grow the iteration count towards the minimum time, at most tenfold at once
+    const double multiplier =
+        elapsed_us > 0 ? std::min(10., 1.4 * min_time_ms * 1000 / elapsed_us) : 10.;
+    iterations = std::max(iterations + 1, static_cast<size_t>(iterations * multiplier));
+  }
+}
+
+std::string benchmark_name(const std::string& function,
+                           const std::string& device,
+                           const size_t cardinality,
+                           const size_t key_width,
+                           const double null_ratio) {
+  std::ostringstream oss;
+  oss << function << "/" << device << "/cardinality:" << cardinality
+      << "/key_width:" << key_width << "/null_ratio:" << null_ratio;
+  return oss.str();
+}
+
+// Generates the keys of a column. Distinct keys are a permutation of the range
+// [0, row_count), as on the inner side of a one to one join, otherwise the keys are
+// drawn uniformly from [0, cardinality). The nulls are placed at random.
+template <typename T>
+std::shared_ptr<std::vector<T>> generate_keys(const size_t row_count,
+                                              const size_t cardinality,
+                                              const double null_ratio,
+                                              const bool distinct,
+                                              const unsigned seed) {
+  std::mt19937_64 rng(seed);
+  auto keys = std::make_shared<std::vector<T>>(row_count);
+  if (distinct) {
+    std::iota(keys->begin(), keys->end(), 0);
+    std::shuffle(keys->begin(), keys->end(), rng);
+  } else {
+    std::uniform_int_distribution<int64_t> key_dist(0, cardinality - 1);
+    for (auto& key : *keys) {
+      key = key_dist(rng);
+    }
+  }
+  std::bernoulli_distribution null_dist(null_ratio);
+  for (auto& key : *keys) {
+    if (null_dist(rng)) {
+      key = inline_int_null_value<T>();
+    }
+  }
+  return keys;
+}
+
+// Perfect hashing on the range [0, cardinality), the nulls are not inserted.
+template <typename T>
+JoinColumnTypeInfo join_type_info(const size_t cardinality) {
+  return {sizeof(T),
+          0,
+          inline_int_null_value<T>(),
+          false,
+          static_cast<int64_t>(cardinality),
+          false};
+}
+
+template <typename T>
+JoinColumn join_column(const std::vector<T>& keys) {
+  return {reinterpret_cast<const int8_t*>(&keys[0]), keys.size()};
+}
+
+void run_on_cpu_threads(const std::function<void(const int32_t, const int32_t)>& fn) {
+  const int32_t thread_count = cpu_threads();
+  std::vector<std::future<void>> threads;
+  for (int32_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+    threads.push_back(std::async(std::launch::async, fn, thread_idx, thread_count));
+  }
+  for (auto& thread : threads) {
+    thread.get();
+  }
+}
+
+void init_hash_join_buff_on_cpu(int32_t* buff, const int32_t entry_count) {
+  run_on_cpu_threads([&](const int32_t thread_idx, const int32_t thread_count) {
+    init_hash_join_buff(buff, entry_count, g_invalid_slot_val, thread_idx, thread_count);
+  });
+}
+
+// One to one on an inner column with as many distinct keys as the cardinality.
+template <typename T>
+RunFunction setup_fill_hash_join_buff(const size_t cardinality,
+                                      const double null_ratio,
+                                      const unsigned seed) {
+  const auto keys =
+      generate_keys<T>(cardinality, cardinality, null_ratio, /*distinct=*/true, seed);
+  auto buff = std::make_shared<std::vector<int32_t>>(cardinality);
+  return [keys, buff, cardinality](const size_t iterations) {
+    for (size_t i = 0; i < iterations; ++i) {
+      init_hash_join_buff_on_cpu(&(*buff)[0], cardinality);
+      run_on_cpu_threads([&](const int32_t thread_idx, const int32_t thread_count) {
+        const auto err = fill_hash_join_buff(&(*buff)[0],
+                                             g_invalid_slot_val,
+                                             join_column(*keys),
+                                             join_type_info<T>(cardinality),
+                                             nullptr,
+                                             nullptr,
+                                             thread_idx,
+                                             thread_count);
+        CHECK_EQ(0, err);
+      });
+    }
+  };
+}
+
+// One to many, each key is repeated row_count / cardinality times on average.
+template <typename T>
+RunFunction setup_fill_one_to_many_hash_table(const size_t cardinality,
+                                              const double null_ratio,
+                                              const size_t row_count,
+                                              const bool partitioned,
+                                              const unsigned seed) {
+  const auto keys =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  auto buff = std::make_shared<std::vector<int32_t>>(2 * cardinality + row_count);
+  return [keys, buff, cardinality, partitioned](const size_t iterations) {
+    const auto fill = partitioned ? fill_one_to_many_hash_table_partitioned
+                                  : fill_one_to_many_hash_table;
+    for (size_t i = 0; i < iterations; ++i) {
+      init_hash_join_buff_on_cpu(&(*buff)[0], cardinality);
+      fill(&(*buff)[0],
+           cardinality,
+           g_invalid_slot_val,
+           join_column(*keys),
+           join_type_info<T>(cardinality),
+           nullptr,
+           nullptr,
+           cpu_threads());
+    }
+  };
+}
+
+// Baseline one to one on composite keys of two components, distinct together.
+template <typename T>
+RunFunction setup_fill_baseline_hash_join_buff(const size_t cardinality,
+                                               const double null_ratio,
+                                               const unsigned seed) {
+  const size_t key_component_count{2};
+  const size_t entry_count = 2 * cardinality;
+  const auto keys =
+      generate_keys<T>(cardinality, cardinality, null_ratio, /*distinct=*/true, seed);
+  auto high = std::make_shared<std::vector<T>>(cardinality);
+  auto low = std::make_shared<std::vector<T>>(cardinality);
+  for (size_t i = 0; i < cardinality; ++i) {
+    const auto key = (*keys)[i];
+    const bool is_null = key == inline_int_null_value<T>();
+    (*high)[i] = is_null ? key : key >> 10;
+    (*low)[i] = is_null ? key : key & 1023;
+  }
+  auto buff = std::make_shared<std::vector<int8_t>>(
+      entry_count * (key_component_count + 1) * sizeof(T));
+  return [high, low, buff, entry_count, key_component_count, cardinality](
+             const size_t iterations) {
+    const auto init = sizeof(T) == 4 ? init_baseline_hash_join_buff_32
+                                     : init_baseline_hash_join_buff_64;
+    const auto fill = sizeof(T) == 4 ? fill_baseline_hash_join_buff_32
+                                     : fill_baseline_hash_join_buff_64;
+    const std::vector<JoinColumn> join_columns{join_column(*high), join_column(*low)};
+    const std::vector<JoinColumnTypeInfo> type_infos{join_type_info<T>(cardinality),
+                                                     join_type_info<T>(cardinality)};
+    const std::vector<const void*> sd_proxies{nullptr, nullptr};
+    for (size_t i = 0; i < iterations; ++i) {
+      run_on_cpu_threads([&](const int32_t thread_idx, const int32_t thread_count) {
+        init(&(*buff)[0],
+             entry_count,
+             key_component_count,
+             true,
+             g_invalid_slot_val,
+             thread_idx,
+             thread_count);
+      });
+      run_on_cpu_threads([&](const int32_t thread_idx, const int32_t thread_count) {
+        const auto err = fill(&(*buff)[0],
+                              entry_count,
+                              g_invalid_slot_val,
+                              key_component_count,
+                              true,
+                              join_columns,
+                              type_infos,
+                              sd_proxies,
+                              sd_proxies,
+                              thread_idx,
+                              thread_count);
+        CHECK_EQ(0, err);
+      });
+    }
+  };
+}
+
+#ifdef HAVE_CUDA
+class DeviceBuffer {
+ public:
+  DeviceBuffer(CudaMgr_Namespace::CudaMgr* cuda_mgr, const size_t size)
+      : cuda_mgr_(cuda_mgr), ptr_(cuda_mgr->allocateDeviceMem(size, 0)) {
+    cuda_mgr_->zeroDeviceMem(ptr_, size, 0);
+  }
+
+  template <typename T>
+  DeviceBuffer(CudaMgr_Namespace::CudaMgr* cuda_mgr, const std::vector<T>& host_vec)
+      : cuda_mgr_(cuda_mgr)
+      , ptr_(cuda_mgr->allocateDeviceMem(host_vec.size() * sizeof(T), 0)) {
+    cuda_mgr_->copyHostToDevice(ptr_,
+                                reinterpret_cast<const int8_t*>(&host_vec[0]),
+                                host_vec.size() * sizeof(T),
+                                0);
+  }
+
+  ~DeviceBuffer() { cuda_mgr_->freeDeviceMem(ptr_); }
+
+  int8_t* get() const { return ptr_; }
+
+ private:
+  CudaMgr_Namespace::CudaMgr* cuda_mgr_;
+  int8_t* ptr_;
+};
+
+size_t gpu_block_size(const CudaMgr_Namespace::CudaMgr* cuda_mgr) {
+  return cuda_mgr->deviceProperties[0].maxThreadsPerBlock;
+}
+
+size_t gpu_grid_size(const CudaMgr_Namespace::CudaMgr* cuda_mgr) {
+  return 2 * cuda_mgr->deviceProperties[0].numMPs;
+}
+
+// The kernels are launched asynchronously, the device is synchronized once all the
+// iterations are queued.
+template <typename T>
+RunFunction setup_fill_hash_join_buff_on_device(CudaMgr_Namespace::CudaMgr* cuda_mgr,
+                                                const size_t cardinality,
+                                                const double null_ratio,
+                                                const unsigned seed) {
+  const auto keys =
+      generate_keys<T>(cardinality, cardinality, null_ratio, /*distinct=*/true, seed);
+  auto dev_keys = std::make_shared<DeviceBuffer>(cuda_mgr, *keys);
+  auto dev_buff =
+      std::make_shared<DeviceBuffer>(cuda_mgr, cardinality * sizeof(int32_t));
+  auto dev_err = std::make_shared<DeviceBuffer>(cuda_mgr, sizeof(int));
+  return [cuda_mgr, dev_keys, dev_buff, dev_err, cardinality](const size_t iterations) {
+    const auto block_size = gpu_block_size(cuda_mgr);
+    const auto grid_size = gpu_grid_size(cuda_mgr);
+    auto buff = reinterpret_cast<int32_t*>(dev_buff->get());
+    for (size_t i = 0; i < iterations; ++i) {
+      init_hash_join_buff_on_device(
+          buff, cardinality, g_invalid_slot_val, block_size, grid_size);
+      fill_hash_join_buff_on_device(buff,
+                                    g_invalid_slot_val,
+                                    reinterpret_cast<int*>(dev_err->get()),
+                                    {dev_keys->get(), cardinality},
+                                    join_type_info<T>(cardinality),
+                                    block_size,
+                                    grid_size);
+    }
+    cuda_mgr->synchronizeDevices();
+  };
+}
+
+template <typename T>
+RunFunction setup_fill_one_to_many_hash_table_on_device(
+    CudaMgr_Namespace::CudaMgr* cuda_mgr,
+    const size_t cardinality,
+    const double null_ratio,
+    const size_t row_count,
+    const unsigned seed) {
+  const auto keys =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  auto dev_keys = std::make_shared<DeviceBuffer>(cuda_mgr, *keys);
+  auto dev_buff = std::make_shared<DeviceBuffer>(
+      cuda_mgr, (2 * cardinality + row_count) * sizeof(int32_t));
+  return [cuda_mgr, dev_keys, dev_buff, cardinality, row_count](
+             const size_t iterations) {
+    const auto block_size = gpu_block_size(cuda_mgr);
+    const auto grid_size = gpu_grid_size(cuda_mgr);
+    auto buff = reinterpret_cast<int32_t*>(dev_buff->get());
+    for (size_t i = 0; i < iterations; ++i) {
+      init_hash_join_buff_on_device(
+          buff, cardinality, g_invalid_slot_val, block_size, grid_size);
+      fill_one_to_many_hash_table_on_device(buff,
+                                            cardinality,
+                                            g_invalid_slot_val,
+                                            {dev_keys->get(), row_count},
+                                            join_type_info<T>(cardinality),
+                                            block_size,
+                                            grid_size);
+    }
+    cuda_mgr->synchronizeDevices();
+  };
+}
+#endif  // HAVE_CUDA
+
+template <typename T>
+RunFunction setup_agg_sum_skip_val(const size_t cardinality,
+                                   const double null_ratio,
+                                   const size_t row_count,
+                                   const unsigned seed) {
+  const auto vals =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  return [vals](const size_t iterations) {
+    const T null_val = inline_int_null_value<T>();
+    for (size_t i = 0; i < iterations; ++i) {
+      T agg{null_val};
+      for (const auto val : *vals) {
+        if (sizeof(T) == 4) {
+          agg_sum_int32_skip_val(reinterpret_cast<int32_t*>(&agg), val, null_val);
+        } else {
+          agg_sum_skip_val(reinterpret_cast<int64_t*>(&agg), val, null_val);
+        }
+      }
+      g_sink = agg;
+    }
+  };
+}
+
+template <typename T>
+RunFunction setup_agg_max_skip_val(const size_t cardinality,
+                                   const double null_ratio,
+                                   const size_t row_count,
+                                   const unsigned seed) {
+  const auto vals =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  return [vals](const size_t iterations) {
+    const T null_val = inline_int_null_value<T>();
+    for (size_t i = 0; i < iterations; ++i) {
+      T agg{null_val};
+      for (const auto val : *vals) {
+        if (sizeof(T) == 4) {
+          agg_max_int32_skip_val(reinterpret_cast<int32_t*>(&agg), val, null_val);
+        } else {
+          agg_max_skip_val(reinterpret_cast<int64_t*>(&agg), val, null_val);
+        }
+      }
+      g_sink = agg;
+    }
+  };
+}
+
+// The bitmap has a bit per value of the range, the nulls are skipped by the caller as
+// in the generated code.
+template <typename T>
+RunFunction setup_agg_count_distinct_bitmap(const size_t cardinality,
+                                            const double null_ratio,
+                                            const size_t row_count,
+                                            const unsigned seed) {
+  const auto vals =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  auto bitmap = std::make_shared<std::vector<int8_t>>((cardinality + 7) / 8);
+  return [vals, bitmap](const size_t iterations) {
+    const T null_val = inline_int_null_value<T>();
+    auto agg = reinterpret_cast<int64_t>(&(*bitmap)[0]);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (const auto val : *vals) {
+        if (val != null_val) {
+          agg_count_distinct_bitmap(&agg, val, 0);
+        }
+      }
+    }
+    g_sink = (*bitmap)[0];
+  };
+}
+
+// The groups buffer has twice as many entries as there are groups and holds the keys
+// and a single aggregate per entry. The first iteration inserts the groups, the
+// following ones find them. The components after the first are derived from it, as
+// in a group by city and country, so that the number of groups is the cardinality.
+template <typename T>
+RunFunction setup_get_group_value(const size_t cardinality,
+                                  const double null_ratio,
+                                  const size_t row_count,
+                                  const uint32_t key_count,
+                                  const unsigned seed) {
+  const auto groups =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  auto keys = std::make_shared<std::vector<T>>(row_count * key_count);
+  for (size_t row = 0; row < row_count; ++row) {
+    const auto group = (*groups)[row];
+    const bool is_null = group == inline_int_null_value<T>();
+    for (uint32_t k = 0; k < key_count; ++k) {
+      (*keys)[row * key_count + k] = k == 0 || is_null ? group : group % (k + 6);
+    }
+  }
+  const uint32_t entry_count = 2 * cardinality;
+  const uint32_t row_size_quad = (key_count * sizeof(T) + 7) / 8 + 1;
+  auto groups_buffer =
+      std::make_shared<std::vector<int64_t>>(entry_count * row_size_quad);
+  for (size_t i = 0; i < entry_count; ++i) {
+    *reinterpret_cast<T*>(&(*groups_buffer)[i * row_size_quad]) =
+        sizeof(T) == 4 ? EMPTY_KEY_32 : EMPTY_KEY_64;
+  }
+  return [keys, groups_buffer, entry_count, key_count, row_size_quad](
+             const size_t iterations) {
+    std::vector<int64_t> key_buff(key_count);
+    for (size_t i = 0; i < iterations; ++i) {
+      for (size_t off = 0; off < keys->size(); off += key_count) {
+        memcpy(&key_buff[0], &(*keys)[off], key_count * sizeof(T));
+        auto agg = get_group_value(&(*groups_buffer)[0],
+                                   entry_count,
+                                   &key_buff[0],
+                                   key_count,
+                                   sizeof(T),
+                                   row_size_quad);
+        CHECK(agg);
+        ++*agg;
+      }
+    }
+  };
+}
+
+// Perfect hash, an entry per value of the range and one for the nulls.
+template <typename T>
+RunFunction setup_get_group_value_fast(const size_t cardinality,
+                                       const double null_ratio,
+                                       const size_t row_count,
+                                       const unsigned seed) {
+  const auto keys =
+      generate_keys<T>(row_count, cardinality, null_ratio, /*distinct=*/false, seed);
+  auto groups_buffer = std::make_shared<std::vector<int64_t>>(2 * (cardinality + 1));
+  for (size_t i = 0; i < groups_buffer->size(); i += 2) {
+    (*groups_buffer)[i] = EMPTY_KEY_64;
+  }
+  return [keys, groups_buffer, cardinality](const size_t iterations) {
+    const T null_val = inline_int_null_value<T>();
+    for (size_t i = 0; i < iterations; ++i) {
+      for (const auto key : *keys) {
+        auto agg = get_group_value_fast(
+            &(*groups_buffer)[0], key == null_val ? cardinality : key, 0, 0, 2);
+        ++*agg;
+      }
+    }
+  };
+}
+
+template <typename T>
+void add_benchmarks(std::vector<Benchmark>& benchmarks,
+                    const size_t cardinality,
+                    const double null_ratio,
+                    const size_t row_count,
+                    const unsigned seed) {
+  const auto name = [&](const std::string& function) {
+    return benchmark_name(function, "cpu", cardinality, sizeof(T), null_ratio);
+  };
+  benchmarks.push_back({name("fill_hash_join_buff"), cardinality, [=]() {
+                          return setup_fill_hash_join_buff<T>(
+                              cardinality, null_ratio, seed);
+                        }});
+  for (const bool partitioned : {false, true}) {
+    benchmarks.push_back({name(partitioned ? "fill_one_to_many_hash_table_partitioned"
+                                           : "fill_one_to_many_hash_table"),
+                          row_count,
+                          [=]() {
+                            return setup_fill_one_to_many_hash_table<T>(
+                                cardinality, null_ratio, row_count, partitioned, seed);
+                          }});
+  }
+  benchmarks.push_back({name("fill_baseline_hash_join_buff"), cardinality, [=]() {
+                          return setup_fill_baseline_hash_join_buff<T>(
+                              cardinality, null_ratio, seed);
+                        }});
+  benchmarks.push_back({name("agg_sum_skip_val"), row_count, [=]() {
+                          return setup_agg_sum_skip_val<T>(
+                              cardinality, null_ratio, row_count, seed);
+                        }});
+  benchmarks.push_back({name("agg_max_skip_val"), row_count, [=]() {
+                          return setup_agg_max_skip_val<T>(
+                              cardinality, null_ratio, row_count, seed);
+                        }});
+  benchmarks.push_back({name("agg_count_distinct_bitmap"), row_count, [=]() {
+                          return setup_agg_count_distinct_bitmap<T>(
+                              cardinality, null_ratio, row_count, seed);
+                        }});
+  for (const uint32_t key_count : {1, 2}) {
+    benchmarks.push_back(
+        {name("get_group_value/keys:" + std::to_string(key_count)), row_count, [=]() {
+           return setup_get_group_value<T>(
+               cardinality, null_ratio, row_count, key_count, seed);
+         }});
+  }
+  benchmarks.push_back({name("get_group_value_fast"), row_count, [=]() {
+                          return setup_get_group_value_fast<T>(
+                              cardinality, null_ratio, row_count, seed);
+                        }});
+}
+
+#ifdef HAVE_CUDA
+template <typename T>
+void add_gpu_benchmarks(std::vector<Benchmark>& benchmarks,
+                        CudaMgr_Namespace::CudaMgr* cuda_mgr,
+                        const size_t cardinality,
+                        const double null_ratio,
+                        const size_t row_count,
+                        const unsigned seed) {
+  const auto name = [&](const std::string& function) {
+    return benchmark_name(function, "gpu", cardinality, sizeof(T), null_ratio);
+  };
+  benchmarks.push_back({name("fill_hash_join_buff"), cardinality, [=]() {
+                          return setup_fill_hash_join_buff_on_device<T>(
+                              cuda_mgr, cardinality, null_ratio, seed);
+                        }});
+  benchmarks.push_back({name("fill_one_to_many_hash_table"), row_count, [=]() {
+                          return setup_fill_one_to_many_hash_table_on_device<T>(
+                              cuda_mgr, cardinality, null_ratio, row_count, seed);
+                        }});
+}
+#endif  // HAVE_CUDA
+
+// Strings of the given length over a small alphabet, so that the patterns match a
+// part of them. string_like_simple is what the LIKE '%needle%' patterns call.
+void add_string_benchmarks(std::vector<Benchmark>& benchmarks,
+                           const size_t row_count,
+                           const unsigned seed) {
+  const std::vector<std::string> patterns{"abc%", "%abc", "%abc%", "%a_c%"};
+  for (const size_t length : {8, 32, 128}) {
+    const auto setup_strings = [=]() {
+      std::mt19937_64 rng(seed);
+      std::uniform_int_distribution<int> char_dist('a', 'e');
+      auto strings = std::make_shared<std::vector<std::string>>(row_count);
+      for (auto& str : *strings) {
+        str.resize(length);
+        for (auto& c : str) {
+          c = char_dist(rng);
+        }
+      }
+      return strings;
+    };
+    const auto name = [&](const std::string& function, const std::string& pattern) {
+      return function + "/cpu/length:" + std::to_string(length) + "/pattern:" + pattern;
+    };
+    for (const auto& pattern : patterns) {
+      benchmarks.push_back({name("string_like", pattern), row_count, [=]() {
+                              const auto strings = setup_strings();
+                              return [strings, pattern](const size_t iterations) {
+                                int64_t match_count{0};
+                                for (size_t i = 0; i < iterations; ++i) {
+                                  for (const auto& str : *strings) {
+                                    match_count += string_like(str.c_str(),
+                                                               str.size(),
+                                                               pattern.c_str(),
+                                                               pattern.size(),
+                                                               '\\');
+                                  }
+                                }
+                                g_sink = match_count;
+                              };
+                            }});
+    }
+    benchmarks.push_back({name("string_like_simple", "abc"), row_count, [=]() {
+                            const auto strings = setup_strings();
+                            return [strings](const size_t iterations) {
+                              int64_t match_count{0};
+                              for (size_t i = 0; i < iterations; ++i) {
+                                for (const auto& str : *strings) {
+                                  match_count += string_like_simple(
+                                      str.c_str(), str.size(), "abc", 3);
+                                }
+                              }
+                              g_sink = match_count;
+                            };
+                          }});
+  }
+}
+
+std::string to_json(const std::vector<BenchmarkResult>& results) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("cpu_threads");
+  writer.Int(cpu_threads());
+  writer.Key("benchmarks");
+  writer.StartArray();
+  for (const auto& result : results) {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(result.name.c_str());
+    writer.Key("iterations");
+    writer.Uint64(result.iterations);
+    writer.Key("ns_per_iteration");
+    writer.Double(result.ns_per_iteration);
+    writer.Key("rows_per_second");
+    writer.Double(result.rows_per_second);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t row_count{1 << 22};
+  double min_time_ms{500};
+  unsigned seed{42};
+  std::string filter;
+  std::string output_path;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()("rows",
+                     po::value<size_t>(&row_count)->default_value(row_count),
+                     "Number of rows of the probed and aggregated columns");
+  desc.add_options()("min-time-ms",
+                     po::value<double>(&min_time_ms)->default_value(min_time_ms),
+                     "Minimum run time of each benchmark");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the data");
+  desc.add_options()("filter",
+                     po::value<std::string>(&filter),
+                     "Only run the benchmarks whose name contains this string");
+  desc.add_options()("cpu-only", "Do not run the benchmarks on GPU");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: MicroBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<Benchmark> benchmarks;
+  for (const auto cardinality : g_cardinalities) {
+    for (const auto null_ratio : g_null_ratios) {
+      add_benchmarks<int32_t>(benchmarks, cardinality, null_ratio, row_count, seed);
+      add_benchmarks<int64_t>(benchmarks, cardinality, null_ratio, row_count, seed);
+    }
+  }
+  add_string_benchmarks(benchmarks, row_count, seed);
+
+#ifdef HAVE_CUDA
+  std::unique_ptr<CudaMgr_Namespace::CudaMgr> cuda_mgr;
+  if (!vm.count("cpu-only")) {
+    try {
+      cuda_mgr.reset(new CudaMgr_Namespace::CudaMgr(1));
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "No GPU benchmarks: " << e.what();
+    }
+  }
+  if (cuda_mgr) {
+    for (const auto cardinality : g_cardinalities) {
+      for (const auto null_ratio : g_null_ratios) {
+        add_gpu_benchmarks<int32_t>(
+            benchmarks, cuda_mgr.get(), cardinality, null_ratio, row_count, seed);
+        add_gpu_benchmarks<int64_t>(
+            benchmarks, cuda_mgr.get(), cardinality, null_ratio, row_count, seed);
+      }
+    }
+  }
+#endif  // HAVE_CUDA
+
+  std::vector<BenchmarkResult> results;
+  for (const auto& benchmark : benchmarks) {
+    if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+      continue;
+    }
+    results.push_back(run_benchmark(benchmark, min_time_ms));
+    const auto& result = results.back();
+    std::cerr << std::left << std::setw(90) << result.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0)
+              << result.ns_per_iteration << " ns" << std::setw(12)
+              << std::setprecision(2) << result.rows_per_second / 1e6 << " M rows/s"
+              << std::endl;
+  }
+
+  const auto json = to_json(results);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+  return 0;
+}
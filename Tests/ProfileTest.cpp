@@ -22,6 +22,7 @@
  * Copyright (c) 2016 MapD Technologies, Inc.  All rights reserved.
  */
 #include "ProfileTest.h"
+#include "../QueryEngine/HashJoinRuntime.h"
 #include "../QueryEngine/ResultRows.h"
 #include "../QueryEngine/ResultSet.h"
 #include "Shared/measure.h"
@@ -36,6 +37,7 @@
 
 #include <algorithm>
 #include <future>
+#include <numeric>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -1246,6 +1248,159 @@ class Deduplicater {
 
 }  // namespace
 
+TEST(Hash, JoinBuild) {
+#if defined(HAVE_CUDA) && CUDA_VERSION >= 8000
+  // Config
+  const size_t row_count = 10000000;
+  const size_t block_size = 1024;
+  const int32_t invalid_slot_val{-1};
+
+  int device_id{0};
+  int sm_count{0};
+  cudaGetDevice(&device_id);
+  cudaDeviceGetAttribute(&sm_count, cudaDevAttrMultiProcessorCount, device_id);
+  const size_t grid_size = 2 * sm_count;
+
+  struct BuildTry {
+    std::string name;
+    int32_t key_range;
+    bool unique_keys;
+    double hot_key_frac;
+  };
+  const std::vector<BuildTry> build_tries{
+      {"unique keys", static_cast<int32_t>(row_count), true, 0},
+      {"uniform(0, 4000000)", 4000000, false, 0},
+      {"uniform(0, 4000000), half of them on 16 hot keys", 4000000, false, 0.5}};
+  std::mt19937 gen(42);
+  for (const auto& build_try : build_tries) {
+    std::cout << "Build a join hash table from " << row_count / 1000000.f << "M "
+              << build_try.name << std::endl;
+    const auto hash_entry_count = build_try.key_range;
+    const auto partition_count =
+        get_smem_hash_join_partition_count(hash_entry_count, grid_size);
+    ASSERT_GT(partition_count, size_t(0));
+
+    // Generate the keys.
+    std::vector<int32_t> keys(row_count);
+    if (build_try.unique_keys) {
+      std::iota(keys.begin(), keys.end(), 0);
+      std::shuffle(keys.begin(), keys.end(), gen);
+    } else {
+      std::uniform_int_distribution<int32_t> key_dist(0, build_try.key_range - 1);
+      std::uniform_int_distribution<int32_t> hot_key_dist(0, 15);
+      std::bernoulli_distribution is_hot_key(build_try.hot_key_frac);
+      for (auto& key : keys) {
+        key = is_hot_key(gen) ? hot_key_dist(gen) * (build_try.key_range / 16)
+                              : key_dist(gen);
+      }
+    }
+    int8_t* dev_keys = nullptr;
+    cudaMalloc(&dev_keys, keys.size() * sizeof(int32_t));
+    cudaMemcpy(
+        dev_keys, &keys[0], keys.size() * sizeof(int32_t), cudaMemcpyHostToDevice);
+    const JoinColumn join_column{dev_keys, row_count};
+    const JoinColumnTypeInfo type_info{sizeof(int32_t),
+                                       0,
+                                       std::numeric_limits<int32_t>::min(),
+                                       false,
+                                       hash_entry_count,
+                                       false};
+    int8_t* dev_scratch_buff = nullptr;
+    cudaMalloc(&dev_scratch_buff,
+               get_smem_hash_join_scratch_size(row_count, partition_count));
+
+    const size_t buff_entry_count =
+        build_try.unique_keys ? hash_entry_count : 2 * hash_entry_count + row_count;
+    std::vector<int32_t> global_buff(buff_entry_count);
+    std::vector<int32_t> smem_buff(buff_entry_count);
+    int32_t* dev_buff = nullptr;
+    cudaMalloc(&dev_buff, buff_entry_count * sizeof(int32_t));
+    int* dev_err = nullptr;
+    cudaMalloc(&dev_err, sizeof(int));
+    for (const bool use_smem : {false, true}) {
+      std::cout << (use_smem ? "  Shared memory build: " : "  Global memory build: ");
+      cudaMemset(dev_err, 0, sizeof(int));
+      init_hash_join_buff_on_device(
+          dev_buff, hash_entry_count, invalid_slot_val, block_size, grid_size);
+      {
+        CudaTimer timer;
+        if (build_try.unique_keys && use_smem) {
+          fill_hash_join_buff_on_device_partitioned(dev_buff,
+                                                    hash_entry_count,
+                                                    invalid_slot_val,
+                                                    dev_err,
+                                                    join_column,
+                                                    type_info,
+                                                    dev_scratch_buff,
+                                                    partition_count,
+                                                    block_size,
+                                                    grid_size);
+        } else if (build_try.unique_keys) {
+          fill_hash_join_buff_on_device(dev_buff,
+                                        invalid_slot_val,
+                                        dev_err,
+                                        join_column,
+                                        type_info,
+                                        block_size,
+                                        grid_size);
+        } else if (use_smem) {
+          fill_one_to_many_hash_table_on_device_partitioned(dev_buff,
+                                                            hash_entry_count,
+                                                            invalid_slot_val,
+                                                            join_column,
+                                                            type_info,
+                                                            dev_scratch_buff,
+                                                            partition_count,
+                                                            block_size,
+                                                            grid_size);
+        } else {
+          fill_one_to_many_hash_table_on_device(dev_buff,
+                                                hash_entry_count,
+                                                invalid_slot_val,
+                                                join_column,
+                                                type_info,
+                                                block_size,
+                                                grid_size);
+        }
+      }
+      int err{0};
+      cudaMemcpy(&err, dev_err, sizeof(int), cudaMemcpyDeviceToHost);
+      ASSERT_EQ(0, err);
+      auto& host_buff = use_smem ? smem_buff : global_buff;
+      cudaMemcpy(&host_buff[0],
+                 dev_buff,
+                 buff_entry_count * sizeof(int32_t),
+                 cudaMemcpyDeviceToHost);
+    }
+    cudaFree(dev_err);
+    cudaFree(dev_buff);
+    cudaFree(dev_scratch_buff);
+    cudaFree(dev_keys);
+
+    if (build_try.unique_keys) {
+      ASSERT_TRUE(global_buff == smem_buff);
+      continue;
+    }
+    // Same positions and counts, the order of the row ids of a key is arbitrary.
+    ASSERT_TRUE(std::equal(global_buff.begin(),
+                           global_buff.begin() + 2 * hash_entry_count,
+                           smem_buff.begin()));
+    const auto global_ids = global_buff.begin() + 2 * hash_entry_count;
+    const auto smem_ids = smem_buff.begin() + 2 * hash_entry_count;
+    for (int32_t slot = 0; slot < hash_entry_count; ++slot) {
+      const auto count = global_buff[hash_entry_count + slot];
+      if (!count) {
+        continue;
+      }
+      const auto pos = global_buff[slot];
+      std::sort(global_ids + pos, global_ids + pos + count);
+      std::sort(smem_ids + pos, smem_ids + pos + count);
+      ASSERT_TRUE(std::equal(global_ids + pos, global_ids + pos + count, smem_ids + pos));
+    }
+  }
+#endif  // HAVE_CUDA
+}
+
 TEST(Reduction, Baseline) {
   // Config
   std::vector<OP_KIND> agg_ops{OP_SUM, OP_MAX};
@@ -1835,7 +1990,7 @@ int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   g_gpus_present = is_gpu_present();
 #ifndef HAVE_CUDA
-  testing::GTEST_FLAG(filter) = "-Hash.Baseline";
+  testing::GTEST_FLAG(filter) = "-Hash.Baseline:Hash.JoinBuild";
 #endif
   auto err = RUN_ALL_TESTS();
   return err;
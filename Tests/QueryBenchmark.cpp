@@ -0,0 +1,408 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    QueryBenchmark.cpp
+ * @brief   End to end query benchmark on a generated star schema.
+ *
+ * Generates a fact table and two dimension tables shaped after the Star Schema
+ * Benchmark at the given scale, loads them through COPY FROM and runs a fixed suite of
+ * queries once cold, with empty buffer pools and caches, then a number of times warm,
+ * on CPU and on GPU when there is one. The data only depends on the scale and the
+ * seed, the timings of two builds are therefore comparable. The results are written
+ * as JSON.
+ */
+
+#include "../Catalog/Catalog.h"
+#include "../DataMgr/DataMgr.h"
+#include "../QueryEngine/ResultSet.h"
+#include "../QueryEngine/UpdateCacheInvalidators.h"
+#include "../QueryRunner/QueryRunner.h"
+#include "../Shared/measure.h"
+
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef BASE_PATH
+#define BASE_PATH "./tmp"
+#endif
+
+namespace {
+
+struct BenchmarkQuery {
+  std::string name;
+  std::string sql;
+};
+
+// Filters, group bys of low and high cardinality, joins, top k, count distinct and
+// string matching.
+const std::vector<BenchmarkQuery> g_queries{
+    {"filter_count",
+     "SELECT COUNT(*) FROM lineorder WHERE lo_discount BETWEEN 1 AND 3 AND lo_quantity "
+     "< 25;"},
+    {"filter_sum",
+     "SELECT SUM(lo_extendedprice * lo_discount) FROM lineorder WHERE lo_orderdate "
+     "BETWEEN 19930101 AND 19931231 AND lo_discount BETWEEN 1 AND 3 AND lo_quantity < "
+     "25;"},
+    {"group_by_low_cardinality",
+     "SELECT lo_shipmode, COUNT(*), SUM(lo_revenue) FROM lineorder GROUP BY "
+     "lo_shipmode;"},
+    {"group_by_high_cardinality",
+     "SELECT lo_custkey, SUM(lo_revenue) FROM lineorder GROUP BY lo_custkey;"},
+    {"join_group_by",
+     "SELECT c_nation, SUM(lo_revenue) FROM lineorder, customer WHERE lo_custkey = "
+     "c_custkey AND c_region = 'ASIA' GROUP BY c_nation;"},
+    {"join_two_dimensions",
+     "SELECT c_region, p_category, SUM(lo_revenue) FROM lineorder, customer, part WHERE "
+     "lo_custkey = c_custkey AND lo_partkey = p_partkey GROUP BY c_region, p_category;"},
+    {"top_k",
+     "SELECT lo_orderkey, lo_revenue FROM lineorder ORDER BY lo_revenue DESC LIMIT "
+     "100;"},
+    {"group_by_top_k",
+     "SELECT lo_custkey, SUM(lo_revenue) AS revenue FROM lineorder GROUP BY lo_custkey "
+     "ORDER BY revenue DESC LIMIT 10;"},
+    {"count_distinct", "SELECT COUNT(DISTINCT lo_custkey) FROM lineorder;"},
+    {"approx_count_distinct", "SELECT APPROX_COUNT_DISTINCT(lo_partkey) FROM lineorder;"},
+    {"string_like_fact", "SELECT COUNT(*) FROM lineorder WHERE lo_shipmode LIKE 'R%';"},
+    {"string_like_dimension",
+     "SELECT COUNT(*) FROM customer WHERE c_name LIKE '%12%';"}};
+
+const std::vector<std::string> g_regions{
+    "AFRICA", "AMERICA", "ASIA", "EUROPE", "MIDDLE EAST"};
+const std::vector<std::string> g_ship_modes{
+    "AIR", "FOB", "MAIL", "RAIL", "REG AIR", "SHIP", "TRUCK"};
+
+struct TableSizes {
+  size_t lineorder;
+  size_t customer;
+  size_t part;
+};
+
+TableSizes table_sizes(const double scale) {
+  return {std::max(size_t(1000), static_cast<size_t>(6000000 * scale)),
+          std::max(size_t(100), static_cast<size_t>(30000 * scale)),
+          std::max(size_t(100), static_cast<size_t>(20000 * scale))};
+}
+
+void write_customer(const std::string& path, const size_t rows, std::mt19937_64& rng) {
+  std::ofstream csv(path);
+  csv << "c_custkey,c_name,c_city,c_nation,c_region\n";
+  std::uniform_int_distribution<size_t> region_dist(0, g_regions.size() - 1);
+  std::uniform_int_distribution<int> nation_dist(0, 4);
+  std::uniform_int_distribution<int> city_dist(0, 9);
+  for (size_t i = 1; i <= rows; ++i) {
+    // drawn one statement at a time, the order of evaluation within an expression is
+    // unspecified and the data has to be the same for every build
+    const auto& region = g_regions[region_dist(rng)];
+    const auto nation = region + " " + std::to_string(nation_dist(rng));
+    const auto city = nation + " " + std::to_string(city_dist(rng));
+    csv << i << ",Customer#" << i << "," << city << "," << nation << "," << region
+        << "\n";
+  }
+}
+
+void write_part(const std::string& path, const size_t rows, std::mt19937_64& rng) {
+  std::ofstream csv(path);
+  csv << "p_partkey,p_category,p_brand\n";
+  std::uniform_int_distribution<int> mfgr_dist(1, 5);
+  std::uniform_int_distribution<int> category_dist(1, 5);
+  std::uniform_int_distribution<int> brand_dist(1, 40);
+  for (size_t i = 1; i <= rows; ++i) {
+    const auto mfgr = mfgr_dist(rng);
+    const auto category = "MFGR#" + std::to_string(mfgr) +
+                          std::to_string(category_dist(rng));
+    const auto brand = category + std::to_string(brand_dist(rng));
+    csv << i << "," << category << "," << brand << "\n";
+  }
+}
+
+void write_lineorder(const std::string& path,
+                     const TableSizes& sizes,
+                     std::mt19937_64& rng) {
+  std::ofstream csv(path);
+  csv << "lo_orderkey,lo_custkey,lo_partkey,lo_orderdate,lo_quantity,lo_extendedprice,"
+         "lo_discount,lo_revenue,lo_shipmode\n";
+  std::uniform_int_distribution<size_t> cust_dist(1, sizes.customer);
+  std::uniform_int_distribution<size_t> part_dist(1, sizes.part);
+  std::uniform_int_distribution<int> year_dist(1992, 1998);
+  std::uniform_int_distribution<int> month_dist(1, 12);
+  std::uniform_int_distribution<int> day_dist(1, 28);
+  std::uniform_int_distribution<int> quantity_dist(1, 50);
+  std::uniform_int_distribution<int> price_dist(90000, 10000000);
+  std::uniform_int_distribution<int> discount_dist(0, 10);
+  std::uniform_int_distribution<size_t> ship_mode_dist(0, g_ship_modes.size() - 1);
+  for (size_t i = 1; i <= sizes.lineorder; ++i) {
+    const auto custkey = cust_dist(rng);
+    const auto partkey = part_dist(rng);
+    const auto year = year_dist(rng);
+    const auto month = month_dist(rng);
+    const auto day = day_dist(rng);
+    const auto quantity = quantity_dist(rng);
+    const int64_t extended_price = price_dist(rng);
+    const auto discount = discount_dist(rng);
+    const auto& ship_mode = g_ship_modes[ship_mode_dist(rng)];
+    csv << i << "," << custkey << "," << partkey << ","
+        << year * 10000 + month * 100 + day << "," << quantity << "," << extended_price
+        << "," << discount << "," << extended_price * (100 - discount) / 100 << ","
+        << ship_mode << "\n";
+  }
+}
+
+// Returns the load time of each table, in milliseconds.
+std::vector<std::pair<std::string, int64_t>> create_and_load_tables(
+    const std::unique_ptr<Catalog_Namespace::SessionInfo>& session,
+    const double scale,
+    const unsigned seed) {
+  const auto data_dir = boost::filesystem::temp_directory_path() / "mapd_query_benchmark";
+  boost::filesystem::create_directories(data_dir);
+  const auto sizes = table_sizes(scale);
+  std::mt19937_64 rng(seed);
+  const auto customer_csv = (data_dir / "customer.csv").string();
+  const auto part_csv = (data_dir / "part.csv").string();
+  const auto lineorder_csv = (data_dir / "lineorder.csv").string();
+  write_customer(customer_csv, sizes.customer, rng);
+  write_part(part_csv, sizes.part, rng);
+  write_lineorder(lineorder_csv, sizes, rng);
+
+  const std::vector<std::pair<std::string, std::string>> tables{
+      {"customer",
+       "CREATE TABLE customer (c_custkey INTEGER, c_name TEXT ENCODING DICT, c_city TEXT "
+       "ENCODING DICT, c_nation TEXT ENCODING DICT, c_region TEXT ENCODING DICT);"},
+      {"part",
+       "CREATE TABLE part (p_partkey INTEGER, p_category TEXT ENCODING DICT, p_brand "
+       "TEXT ENCODING DICT);"},
+      {"lineorder",
+       "CREATE TABLE lineorder (lo_orderkey BIGINT, lo_custkey INTEGER, lo_partkey "
+       "INTEGER, lo_orderdate INTEGER, lo_quantity SMALLINT, lo_extendedprice BIGINT, "
+       "lo_discount SMALLINT, lo_revenue BIGINT, lo_shipmode TEXT ENCODING DICT);"}};
+  std::vector<std::pair<std::string, int64_t>> load_times_ms;
+  for (const auto& table : tables) {
+    QueryRunner::run_ddl_statement("DROP TABLE IF EXISTS " + table.first + ";", session);
+    QueryRunner::run_ddl_statement(table.second, session);
+    const auto csv_path = (data_dir / (table.first + ".csv")).string();
+    load_times_ms.emplace_back(table.first, measure<>::execution([&]() {
+      QueryRunner::run_ddl_statement(
+          "COPY " + table.first + " FROM '" + csv_path + "' WITH (header='true');",
+          session);
+    }));
+  }
+  boost::filesystem::remove_all(data_dir);
+  return load_times_ms;
+}
+
+void drop_tables(const std::unique_ptr<Catalog_Namespace::SessionInfo>& session) {
+  for (const auto& table : {"lineorder", "customer", "part"}) {
+    QueryRunner::run_ddl_statement(std::string("DROP TABLE IF EXISTS ") + table + ";",
+                                   session);
+  }
+}
+
+// Empties the buffer pools and the caches of the join hash tables and query results,
+// the generated code stays cached.
+void clear_memory(const std::unique_ptr<Catalog_Namespace::SessionInfo>& session) {
+  HostMemoryCacheInvalidator::invalidateCaches();
+  auto& data_mgr = session->get_catalog().get_dataMgr();
+  data_mgr.clearMemory(Data_Namespace::MemoryLevel::CPU_LEVEL);
+  if (data_mgr.gpusPresent()) {
+    data_mgr.clearMemory(Data_Namespace::MemoryLevel::GPU_LEVEL);
+  }
+}
+
+struct QueryTimings {
+  std::string query;
+  std::string device;
+  int64_t cold_ms;
+  std::vector<int64_t> warm_ms;
+  size_t row_count;
+};
+
+QueryTimings run_query(const BenchmarkQuery& query,
+                       const ExecutorDeviceType device_type,
+                       const size_t iterations,
+                       const std::unique_ptr<Catalog_Namespace::SessionInfo>& session) {
+  QueryTimings timings;
+  timings.query = query.name;
+  timings.device = device_type == ExecutorDeviceType::GPU ? "gpu" : "cpu";
+  std::shared_ptr<ResultSet> rows;
+  clear_memory(session);
+  timings.cold_ms = measure<>::execution([&]() {
+    rows = QueryRunner::run_multiple_agg(query.sql, session, device_type, true, false);
+  });
+  timings.row_count = rows->rowCount();
+  for (size_t i = 0; i < iterations; ++i) {
+    timings.warm_ms.push_back(measure<>::execution([&]() {
+      QueryRunner::run_multiple_agg(query.sql, session, device_type, true, false);
+    }));
+  }
+  return timings;
+}
+
+std::string to_json(const double scale,
+                    const unsigned seed,
+                    const size_t iterations,
+                    const std::vector<std::pair<std::string, int64_t>>& load_times_ms,
+                    const std::vector<QueryTimings>& all_timings) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("scale");
+  writer.Double(scale);
+  writer.Key("seed");
+  writer.Uint(seed);
+  writer.Key("iterations");
+  writer.Uint64(iterations);
+  writer.Key("load_ms");
+  writer.StartObject();
+  for (const auto& load_time : load_times_ms) {
+    writer.Key(load_time.first.c_str());
+    writer.Int64(load_time.second);
+  }
+  writer.EndObject();
+  writer.Key("queries");
+  writer.StartArray();
+  for (const auto& timings : all_timings) {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(timings.query.c_str());
+    writer.Key("device");
+    writer.String(timings.device.c_str());
+    writer.Key("rows");
+    writer.Uint64(timings.row_count);
+    writer.Key("cold_ms");
+    writer.Int64(timings.cold_ms);
+    auto warm_ms = timings.warm_ms;
+    std::sort(warm_ms.begin(), warm_ms.end());
+    if (!warm_ms.empty()) {
+      writer.Key("warm_min_ms");
+      writer.Int64(warm_ms.front());
+      writer.Key("warm_median_ms");
+      writer.Int64(warm_ms[warm_ms.size() / 2]);
+      writer.Key("warm_max_ms");
+      writer.Int64(warm_ms.back());
+    }
+    writer.Key("warm_ms");
+    writer.StartArray();
+    for (const auto ms : timings.warm_ms) {
+      writer.Int64(ms);
+    }
+    writer.EndArray();
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string db_path{BASE_PATH};
+  double scale{0.1};
+  unsigned seed{42};
+  size_t iterations{5};
+  std::string output_path;
+  std::string query_filter;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()(
+      "path", po::value<std::string>(&db_path)->default_value(db_path), "Data directory");
+  desc.add_options()("scale",
+                     po::value<double>(&scale)->default_value(scale),
+                     "Scale of the data, 1 is 6M rows in the fact table");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the data");
+  desc.add_options()("iterations",
+                     po::value<size_t>(&iterations)->default_value(iterations),
+                     "Number of warm runs of each query");
+  desc.add_options()("query",
+                     po::value<std::string>(&query_filter),
+                     "Only run the queries whose name contains this string");
+  desc.add_options()("cpu-only", "Do not run the queries on GPU");
+  desc.add_options()("skip-load", "Run on the tables loaded by a previous run");
+  desc.add_options()("keep-tables", "Do not drop the tables at the end");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: QueryBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  std::unique_ptr<Catalog_Namespace::SessionInfo> session(
+      QueryRunner::get_session(db_path.c_str()));
+
+  std::vector<std::pair<std::string, int64_t>> load_times_ms;
+  if (!vm.count("skip-load")) {
+    load_times_ms = create_and_load_tables(session, scale, seed);
+  }
+
+  std::vector<ExecutorDeviceType> device_types{ExecutorDeviceType::CPU};
+  if (!vm.count("cpu-only") && session->get_catalog().get_dataMgr().gpusPresent()) {
+    device_types.push_back(ExecutorDeviceType::GPU);
+  }
+
+  std::vector<QueryTimings> all_timings;
+  int err{0};
+  for (const auto& query : g_queries) {
+    if (!query_filter.empty() && query.name.find(query_filter) == std::string::npos) {
+      continue;
+    }
+    for (const auto device_type : device_types) {
+      try {
+        all_timings.push_back(run_query(query, device_type, iterations, session));
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Query " << query.name << " failed: " << e.what();
+        err = 1;
+      }
+    }
+  }
+
+  const auto json = to_json(scale, seed, iterations, load_times_ms, all_timings);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+
+  if (!vm.count("keep-tables")) {
+    drop_tables(session);
+  }
+  session.reset(nullptr);
+  return err;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <QueryEngine/JoinHashTableCache.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+TEST(JoinHashTableCache, HitsAndMisses) {
+  size_t max_bytes{100};
+  JoinHashTableCache<int, int> cache(max_bytes);
+  ASSERT_FALSE(cache.get(1));
+  cache.put(1, 10, 40);
+  cache.put(1, 11, 40);
+  const auto cached = cache.get(1);
+  ASSERT_TRUE(cached);
+  ASSERT_EQ(10, *cached);
+  const auto stats = cache.getStats();
+  ASSERT_EQ(size_t(1), stats.hits);
+  ASSERT_EQ(size_t(1), stats.misses);
+  ASSERT_EQ(size_t(1), stats.entry_count);
+  ASSERT_EQ(size_t(40), stats.bytes);
+}
+
+TEST(JoinHashTableCache, LruEviction) {
+  size_t max_bytes{100};
+  JoinHashTableCache<int, int> cache(max_bytes);
+  cache.put(1, 10, 40);
+  cache.put(2, 20, 40);
+  // Touch the oldest table, the other one goes first.
+  ASSERT_TRUE(cache.get(1));
+  cache.put(3, 30, 40);
+  ASSERT_TRUE(cache.get(1));
+  ASSERT_FALSE(cache.get(2));
+  ASSERT_TRUE(cache.get(3));
+  auto stats = cache.getStats();
+  ASSERT_EQ(size_t(1), stats.evictions);
+  ASSERT_EQ(size_t(80), stats.bytes);
+  // Too large to be cached, nothing is flushed for it.
+  cache.put(4, 40, 101);
+  ASSERT_FALSE(cache.get(4));
+  ASSERT_EQ(size_t(2), cache.getStats().entry_count);
+  // The limit can be lowered after the construction.
+  max_bytes = 50;
+  cache.put(5, 50, 10);
+  ASSERT_FALSE(cache.get(1));
+  stats = cache.getStats();
+  ASSERT_EQ(size_t(2), stats.entry_count);
+  ASSERT_EQ(size_t(50), stats.bytes);
+}
+
+TEST(JoinHashTableCache, Evict) {
+  size_t max_bytes{100};
+  JoinHashTableCache<int, int> cache(max_bytes);
+  cache.put(1, 10, 30);
+  cache.put(2, 20, 30);
+  cache.put(3, 30, 30);
+  ASSERT_EQ(size_t(60), cache.evict(31));
+  ASSERT_TRUE(cache.get(3));
+  ASSERT_EQ(size_t(30), cache.evict(1000));
+  ASSERT_EQ(size_t(0), cache.getStats().bytes);
+  cache.put(1, 10, 30);
+  cache.clear();
+  ASSERT_FALSE(cache.get(1));
+}
+
+TEST(JoinHashTableCache, UnusableEntry) {
+  size_t max_bytes{100};
+  JoinHashTableCache<int, int> cache(max_bytes);
+  cache.put(1, 10, 40);
+  ASSERT_FALSE(cache.get(1, [](const int value) { return value != 10; }));
+  ASSERT_TRUE(cache.get(1, [](const int value) { return value == 10; }));
+  const auto stats = cache.getStats();
+  ASSERT_EQ(size_t(1), stats.hits);
+  ASSERT_EQ(size_t(1), stats.misses);
+  ASSERT_EQ(size_t(1), stats.entry_count);
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+  return err;
+}
@@ -35,6 +35,8 @@
 #include <queue>
 #include <random>
 
+extern bool g_enable_cpu_radix_sort;
+
 TEST(Construct, Allocate) {
   std::vector<TargetInfo> target_infos;
   QueryMemoryDescriptor query_mem_desc;
@@ -88,6 +90,24 @@ class ReverseOddOrEvenNumberGenerator : public NumberGenerator {
   int64_t init_;
 };
 
+// Negative and positive values, each of them generated several times.
+class ModuloNumberGenerator : public NumberGenerator {
+ public:
+  ModuloNumberGenerator(const int64_t modulo) : crt_(0), modulo_(modulo) {}
+
+  int64_t getNextValue() override {
+    const auto crt = crt_;
+    crt_ += 7919;
+    return crt % modulo_ - modulo_ / 2;
+  }
+
+  void reset() override { crt_ = 0; }
+
+ private:
+  int64_t crt_;
+  int64_t modulo_;
+};
+
 void write_int(int8_t* slot_ptr, const int64_t v, const size_t slot_bytes) {
   switch (slot_bytes) {
     case 4:
@@ -2160,6 +2180,15 @@ TEST(Reduce, BaselineHash) {
   test_reduce(target_infos, query_mem_desc, generator1, generator2, 1);
 }
 
+TEST(Reduce, BaselineHashPartitioned) {
+  const auto target_infos = generate_test_target_infos();
+  auto query_mem_desc = baseline_hash_two_col_desc(target_infos, 8);
+  query_mem_desc.setEntryCount(60000);
+  EvenNumberGenerator generator1;
+  ReverseOddOrEvenNumberGenerator generator2(2 * query_mem_desc.getEntryCount() - 1);
+  test_reduce(target_infos, query_mem_desc, generator1, generator2, 1);
+}
+
 TEST(Reduce, BaselineHashColumnar) {
   const auto target_infos = generate_test_target_infos();
   auto query_mem_desc = baseline_hash_two_col_desc(target_infos, 8);
@@ -2169,6 +2198,86 @@ TEST(Reduce, BaselineHashColumnar) {
   test_reduce(target_infos, query_mem_desc, generator1, generator2, 1);
 }
 
+TEST(Sort, RadixSortPerfectHashOneCol) {
+  const auto target_infos = generate_test_target_infos();
+  const auto query_mem_desc = perfect_hash_one_col_desc(target_infos, 8, 0, 300000);
+  const auto row_set_mem_owner = std::make_shared<RowSetMemoryOwner>();
+  std::list<Analyzer::OrderEntry> order_entries;
+  order_entries.emplace_back(2, true, false);
+  order_entries.emplace_back(1, false, false);
+  auto get_sorted_rows = [&](const bool use_radix_sort) {
+    ResultSet rs(target_infos,
+                 ExecutorDeviceType::CPU,
+                 query_mem_desc,
+                 row_set_mem_owner,
+                 nullptr);
+    const auto storage = rs.allocateStorage();
+    ModuloNumberGenerator generator(1000);
+    fill_storage_buffer(
+        storage->getUnderlyingBuffer(), target_infos, query_mem_desc, generator, 1);
+    g_enable_cpu_radix_sort = use_radix_sort;
+    rs.sort(order_entries, 0);
+    g_enable_cpu_radix_sort = true;
+    std::vector<OneRow> rows;
+    while (true) {
+      const auto row = rs.getNextRow(false, false);
+      if (row.empty()) {
+        break;
+      }
+      rows.push_back(row);
+    }
+    return rows;
+  };
+  const auto radix_sorted_rows = get_sorted_rows(true);
+  const auto sorted_rows = get_sorted_rows(false);
+  ASSERT_EQ(sorted_rows.size(), radix_sorted_rows.size());
+  for (size_t i = 0; i < sorted_rows.size(); ++i) {
+    ASSERT_EQ(v<int64_t>(sorted_rows[i][0]), v<int64_t>(radix_sorted_rows[i][0]));
+    ASSERT_EQ(v<int64_t>(sorted_rows[i][1]), v<int64_t>(radix_sorted_rows[i][1]));
+    if (i) {
+      ASSERT_LE(v<int64_t>(radix_sorted_rows[i][1]),
+                v<int64_t>(radix_sorted_rows[i - 1][1]));
+    }
+  }
+}
+
+TEST(Sort, ParallelTopPerfectHashOneCol) {
+  const auto target_infos = generate_test_target_infos();
+  const auto query_mem_desc = perfect_hash_one_col_desc(target_infos, 8, 0, 300000);
+  const auto row_set_mem_owner = std::make_shared<RowSetMemoryOwner>();
+  std::list<Analyzer::OrderEntry> order_entries;
+  order_entries.emplace_back(2, true, false);
+  auto get_sorted_rows = [&](const size_t top_n) {
+    ResultSet rs(target_infos,
+                 ExecutorDeviceType::CPU,
+                 query_mem_desc,
+                 row_set_mem_owner,
+                 nullptr);
+    const auto storage = rs.allocateStorage();
+    ModuloNumberGenerator generator(100000);
+    fill_storage_buffer(
+        storage->getUnderlyingBuffer(), target_infos, query_mem_desc, generator, 1);
+    rs.sort(order_entries, top_n);
+    std::vector<OneRow> rows;
+    while (true) {
+      const auto row = rs.getNextRow(false, false);
+      if (row.empty()) {
+        break;
+      }
+      rows.push_back(row);
+    }
+    return rows;
+  };
+  const size_t top_n{500};
+  const auto top_rows = get_sorted_rows(top_n);
+  const auto sorted_rows = get_sorted_rows(0);
+  ASSERT_EQ(top_n, top_rows.size());
+  ASSERT_LE(top_n, sorted_rows.size());
+  for (size_t i = 0; i < top_rows.size(); ++i) {
+    ASSERT_EQ(v<int64_t>(sorted_rows[i][1]), v<int64_t>(top_rows[i][1]));
+  }
+}
+
 TEST(MoreReduce, MissingValues) {
   std::vector<TargetInfo> target_infos;
   SQLTypeInfo bigint_ti(kBIGINT, false);
@@ -45,6 +45,47 @@ using namespace Fragmenter_Namespace;
 using namespace Chunk_NS;
 using namespace Data_Namespace;
 
+// Hashes the values like scan_chunk, a batch of them at a time. False if the column
+// isn't of fixed width.
+template <typename T>
+bool scan_chunk_batched(ChunkIter& cit, const SQLTypeInfo& ti, size_t& hash) {
+  if (cit.skip_size <= 0) {
+    return false;
+  }
+  constexpr size_t batch_size{1024};
+  T values[batch_size];
+  size_t count{0};
+  for (int nth = 0;
+       (count = ChunkIter_get_nth_batch(&cit, nth, batch_size, values)) != 0;
+       nth += count) {
+    for (size_t i = 0; i < count; ++i) {
+      switch (ti.get_type()) {
+        case kSMALLINT:
+          boost::hash_combine(hash, static_cast<int16_t>(values[i]));
+          break;
+        case kINT:
+          boost::hash_combine(hash, static_cast<int32_t>(values[i]));
+          break;
+        case kFLOAT:
+          boost::hash_combine(hash, static_cast<float>(values[i]));
+          break;
+        case kDOUBLE:
+          boost::hash_combine(hash, static_cast<double>(values[i]));
+          break;
+        case kTIME:
+        case kTIMESTAMP:
+        case kDATE:
+          boost::hash_combine(hash, static_cast<time_t>(values[i]));
+          break;
+        default:
+          boost::hash_combine(hash, static_cast<int64_t>(values[i]));
+          break;
+      }
+    }
+  }
+  return true;
+}
+
 void scan_chunk(const ChunkMetadata& chunk_metadata,
                 const Chunk& chunk,
                 size_t& hash,
@@ -53,6 +94,30 @@ void scan_chunk(const ChunkMetadata& chunk_metadata,
   VarlenDatum vd;
   bool is_end;
   const ColumnDescriptor* cd = chunk.get_column_desc();
+  if (!use_iter) {
+    switch (cd->columnType.get_type()) {
+      case kSMALLINT:
+      case kINT:
+      case kBIGINT:
+      case kNUMERIC:
+      case kDECIMAL:
+      case kTIME:
+      case kTIMESTAMP:
+      case kDATE:
+        if (scan_chunk_batched<int64_t>(cit, cd->columnType, hash)) {
+          return;
+        }
+        break;
+      case kFLOAT:
+      case kDOUBLE:
+        if (scan_chunk_batched<double>(cit, cd->columnType, hash)) {
+          return;
+        }
+        break;
+      default:
+        break;
+    }
+  }
   std::hash<std::string> string_hash;
   int nth = 0;
   while (true) {
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Shared/ThreadPool.h>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+TEST(ThreadPool, Submit) {
+  std::vector<std::future<int>> futures;
+  for (int i = 0; i < 100; ++i) {
+    futures.push_back(
+        threadpool::ThreadPool::instance().submit([](const int x) { return x * x; }, i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(i * i, futures[i].get());
+  }
+}
+
+TEST(ThreadPool, NestedTasks) {
+  // Every outer task fans out and waits; must not deadlock with more outer tasks than
+  // there are workers.
+  auto& pool = threadpool::ThreadPool::instance();
+  std::atomic<size_t> count{0};
+  std::vector<std::future<void>> outer;
+  for (size_t i = 0; i < 4 * pool.workerCount(); ++i) {
+    outer.push_back(pool.submit([&pool, &count] {
+      std::vector<std::future<void>> inner;
+      for (size_t j = 0; j < 8; ++j) {
+        inner.push_back(pool.submit([&count] { ++count; }));
+      }
+      threadpool::wait_all(inner);
+    }));
+  }
+  threadpool::wait_all(outer);
+  ASSERT_EQ(4 * pool.workerCount() * 8, count.load());
+}
+
+TEST(ThreadPool, Exception) {
+  std::vector<std::future<void>> futures;
+  futures.push_back(threadpool::ThreadPool::instance().submit(
+      [] { throw std::runtime_error("task failed"); }));
+  futures.push_back(threadpool::ThreadPool::instance().submit([] {}));
+  ASSERT_THROW(threadpool::wait_all(futures), std::runtime_error);
+}
+
+TEST(ThreadPool, Priority) {
+  threadpool::ScopedTaskPriority priority(threadpool::TaskPriority::LOW);
+  auto future = threadpool::ThreadPool::instance().submit(
+      [] { return threadpool::ThreadPool::currentPriority(); });
+  ASSERT_EQ(threadpool::TaskPriority::LOW, future.get());
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  testing::InitGoogleTest(&argc, argv);
+
+  int err{0};
+  try {
+    err = RUN_ALL_TESTS();
+  } catch (const std::exception& e) {
+    LOG(ERROR) << e.what();
+  }
+  return err;
+}
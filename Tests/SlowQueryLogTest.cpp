@@ -0,0 +1,72 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../ThriftHandler/SlowQueryLog.h"
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+TEST(NormalizeQuery, Literals) {
+  ASSERT_EQ("SELECT x FROM t WHERE y = ? AND z > ?",
+            SlowQueryLog::normalizeQuery("SELECT x FROM t WHERE y = 'a''b' AND z > 1.5e3"));
+  ASSERT_EQ("SELECT x2, ? FROM t2 LIMIT ?",
+            SlowQueryLog::normalizeQuery("SELECT x2, .5 FROM t2 LIMIT 10"));
+}
+
+TEST(NormalizeQuery, WhiteSpaceAndIdentifiers) {
+  ASSERT_EQ("SELECT \"col 1\" FROM t",
+            SlowQueryLog::normalizeQuery("  SELECT\n\t\"col 1\"   FROM t \n"));
+}
+
+TEST(SlowQueryLog, Records) {
+  const auto path =
+      (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+          .string();
+  {
+    SlowQueryLog log(path);
+    for (size_t i = 0; i < SlowQueryLog::kMaxRecentRecords + 2; ++i) {
+      SlowQueryRecord record{};
+      record.user_name = i % 2 ? "alice" : "bob";
+      record.query = "SELECT\t?";
+      record.total_ms = i;
+      log.add(record);
+    }
+    const auto all = log.getRecords("");
+    ASSERT_EQ(SlowQueryLog::kMaxRecentRecords, all.rows.size());
+    ASSERT_EQ("total_ms", all.row_desc[1].col_name);
+    ASSERT_EQ(int64_t(2), all.rows.front().cols[1].val.int_val);
+    const auto alice = log.getRecords("alice");
+    ASSERT_EQ(SlowQueryLog::kMaxRecentRecords / 2, alice.rows.size());
+  }
+  // The header and one line per record, the tab in the query replaced.
+  std::ifstream file(path);
+  std::string line;
+  size_t line_count{0};
+  while (std::getline(file, line)) {
+    if (line_count++) {
+      ASSERT_EQ(line.find("SELECT ?"), line.size() - 8);
+    }
+  }
+  ASSERT_EQ(SlowQueryLog::kMaxRecentRecords + 3, line_count);
+  boost::filesystem::remove(path);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,462 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    StorageBenchmark.cpp
+ * @brief   Throughput of the file and buffer managers on synthetic chunks.
+ *
+ * Drives the DataMgr directly, without a catalog or a query, on chunks of random bytes
+ * without an encoder. Measures the appends and the in place writes of a FileBuffer by
+ * block size, the open of the data files by number of reader threads, which scan the
+ * page headers, and the fetch of the chunks into the CPU pool from as many threads, the
+ * checkpoint latency by number of dirty chunks, the copy of the chunks from the CPU
+ * pool to the GPU pool when there is a GPU, and the allocations and the evictions of
+ * the CPU pool when the chunks fetched are more than it holds. The reads are served
+ * from the page cache of the OS unless it is dropped before the run. The results are
+ * written as JSON.
+ */
+
+#include "../DataMgr/DataMgr.h"
+#include "../Shared/MapDParameters.h"
+#include "../Shared/measure.h"
+
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BASE_PATH
+#define BASE_PATH "./tmp"
+#endif
+
+using namespace Data_Namespace;
+
+namespace {
+
+const size_t g_mb{1 << 20};
+
+struct StorageResult {
+  std::string name;
+  size_t ops;
+  size_t bytes;
+  int64_t elapsed_us;
+  size_t evictions;
+};
+
+ChunkKey chunk_key(const int tb_id, const int chunk_id) {
+  return {1, tb_id, 1, chunk_id};
+}
+
+std::vector<int8_t> random_bytes(const size_t byte_count, const unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> byte_dist(-128, 127);
+  std::vector<int8_t> bytes(byte_count);
+  for (auto& byte : bytes) {
+    byte = byte_dist(rng);
+  }
+  return bytes;
+}
+
+// A data manager on its own directory, which is emptied unless reopened.
+std::unique_ptr<DataMgr> make_data_mgr(const boost::filesystem::path& data_path,
+                                       const bool reopen,
+                                       const size_t cpu_pool_bytes,
+                                       const bool use_gpus = false,
+                                       const size_t num_reader_threads = 0) {
+  if (!reopen) {
+    boost::filesystem::remove_all(data_path);
+    boost::filesystem::create_directories(data_path);
+  }
+  MapDParameters mapd_parameters;
+  mapd_parameters.cpu_buffer_mem_bytes = cpu_pool_bytes;
+  return std::unique_ptr<DataMgr>(new DataMgr(data_path.string(),
+                                              mapd_parameters,
+                                              use_gpus,
+                                              use_gpus ? -1 : 0,
+                                              "",
+                                              0,
+                                              1 << 27,
+                                              num_reader_threads));
+}
+
+// Creates the chunks of a table on disk and checkpoints them.
+void create_chunks(DataMgr* data_mgr,
+                   const int tb_id,
+                   const size_t chunk_count,
+                   const size_t chunk_bytes,
+                   std::vector<int8_t>& bytes) {
+  for (size_t chunk_id = 0; chunk_id < chunk_count; ++chunk_id) {
+    auto buffer = data_mgr->createChunkBuffer(chunk_key(tb_id, chunk_id), DISK_LEVEL);
+    for (size_t offset = 0; offset < chunk_bytes; offset += bytes.size()) {
+      buffer->append(&bytes[0], std::min(bytes.size(), chunk_bytes - offset));
+    }
+  }
+  data_mgr->checkpoint(1, tb_id);
+}
+
+size_t cpu_evictions(DataMgr* data_mgr) {
+  return data_mgr->getMemoryInfo(CPU_LEVEL).front().numEvictions;
+}
+
+// Appends a chunk in blocks of each size, checkpoints it, then writes it over in place.
+void run_write_benchmarks(std::vector<StorageResult>& results,
+                          const boost::filesystem::path& base_path,
+                          const size_t chunk_bytes,
+                          const unsigned seed) {
+  auto data_mgr = make_data_mgr(base_path / "write", false, 64 * g_mb);
+  int tb_id{0};
+  for (const size_t block_bytes : {4 << 10, 64 << 10, 1 << 20, 16 << 20}) {
+    if (block_bytes > chunk_bytes) {
+      continue;
+    }
+    ++tb_id;
+    auto block = random_bytes(block_bytes, seed);
+    const auto block_count = chunk_bytes / block_bytes;
+    const auto suffix = "/block_bytes:" + std::to_string(block_bytes);
+    auto buffer = data_mgr->createChunkBuffer(chunk_key(tb_id, 0), DISK_LEVEL);
+    const auto append_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (size_t i = 0; i < block_count; ++i) {
+        buffer->append(&block[0], block_bytes);
+      }
+    });
+    results.push_back({"append" + suffix,
+                       block_count,
+                       block_count * block_bytes,
+                       static_cast<int64_t>(append_us),
+                       0});
+    const auto checkpoint_us = measure<std::chrono::microseconds>::execution(
+        [&]() { data_mgr->checkpoint(1, tb_id); });
+    results.push_back({"append_checkpoint" + suffix,
+                       1,
+                       block_count * block_bytes,
+                       static_cast<int64_t>(checkpoint_us),
+                       0});
+    const auto write_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (size_t i = 0; i < block_count; ++i) {
+        buffer->write(&block[0], block_bytes, i * block_bytes);
+      }
+      data_mgr->checkpoint(1, tb_id);
+    });
+    results.push_back({"write_checkpoint" + suffix,
+                       block_count,
+                       block_count * block_bytes,
+                       static_cast<int64_t>(write_us),
+                       0});
+  }
+}
+
+// Reopens the same files with each number of reader threads and fetches all the chunks
+// into the CPU pool from as many threads.
+void run_read_benchmarks(std::vector<StorageResult>& results,
+                         const boost::filesystem::path& base_path,
+                         const size_t chunk_bytes,
+                         const size_t chunk_count,
+                         const unsigned seed) {
+  const auto data_path = base_path / "read";
+  const auto pool_bytes = chunk_count * chunk_bytes + 64 * g_mb;
+  {
+    auto data_mgr = make_data_mgr(data_path, false, pool_bytes);
+    auto bytes = random_bytes(std::min(chunk_bytes, 16 * g_mb), seed);
+    create_chunks(data_mgr.get(), 1, chunk_count, chunk_bytes, bytes);
+  }
+  for (const size_t thread_count : {1, 2, 4, 8, 16}) {
+    const auto suffix = "/reader_threads:" + std::to_string(thread_count);
+    std::unique_ptr<DataMgr> data_mgr;
+    const auto open_us = measure<std::chrono::microseconds>::execution([&]() {
+      data_mgr = make_data_mgr(data_path, true, pool_bytes, false, thread_count);
+    });
+    results.push_back({"open" + suffix,
+                       1,
+                       chunk_count * chunk_bytes,
+                       static_cast<int64_t>(open_us),
+                       0});
+    const auto read_us = measure<std::chrono::microseconds>::execution([&]() {
+      std::vector<std::future<void>> threads;
+      for (size_t thread_idx = 0; thread_idx < thread_count; ++thread_idx) {
+        threads.push_back(std::async(std::launch::async, [&, thread_idx]() {
+          for (size_t chunk_id = thread_idx; chunk_id < chunk_count;
+               chunk_id += thread_count) {
+            auto buffer = data_mgr->getChunkBuffer(
+                chunk_key(1, chunk_id), CPU_LEVEL, 0, chunk_bytes);
+            buffer->unPin();
+          }
+        }));
+      }
+      for (auto& thread : threads) {
+        thread.get();
+      }
+    });
+    results.push_back({"read" + suffix,
+                       chunk_count,
+                       chunk_count * chunk_bytes,
+                       static_cast<int64_t>(read_us),
+                       0});
+  }
+}
+
+// Appends to the given number of chunks between the checkpoints, as the inserts into
+// a table with as many columns and fragments do.
+void run_checkpoint_benchmarks(std::vector<StorageResult>& results,
+                               const boost::filesystem::path& base_path,
+                               const unsigned seed) {
+  const size_t append_bytes{64 << 10};
+  const size_t repetitions{3};
+  auto data_mgr = make_data_mgr(base_path / "checkpoint", false, 64 * g_mb);
+  auto bytes = random_bytes(append_bytes, seed);
+  int tb_id{0};
+  for (const size_t dirty_count : {1, 16, 256, 4096}) {
+    ++tb_id;
+    create_chunks(data_mgr.get(), tb_id, dirty_count, append_bytes, bytes);
+    int64_t checkpoint_us{0};
+    for (size_t i = 0; i < repetitions; ++i) {
+      for (size_t chunk_id = 0; chunk_id < dirty_count; ++chunk_id) {
+        data_mgr->getChunkBuffer(chunk_key(tb_id, chunk_id), DISK_LEVEL)
+            ->append(&bytes[0], append_bytes);
+      }
+      checkpoint_us += measure<std::chrono::microseconds>::execution(
+          [&]() { data_mgr->checkpoint(1, tb_id); });
+    }
+    results.push_back({"checkpoint/dirty_chunks:" + std::to_string(dirty_count),
+                       repetitions,
+                       repetitions * dirty_count * append_bytes,
+                       checkpoint_us,
+                       0});
+  }
+}
+
+// Copies chunks resident in the CPU pool into the pool of the first GPU, as the fetch
+// of the columns of a query on GPU does, then drops them from the GPU pool.
+void run_gpu_transfer_benchmarks(std::vector<StorageResult>& results,
+                                 const boost::filesystem::path& base_path,
+                                 const unsigned seed) {
+  const size_t repetitions{10};
+  const std::vector<size_t> chunk_sizes{1 * g_mb, 16 * g_mb, 256 * g_mb};
+  const auto pool_bytes =
+      std::accumulate(chunk_sizes.begin(), chunk_sizes.end(), size_t(0)) + 64 * g_mb;
+  auto data_mgr = make_data_mgr(base_path / "gpu", false, pool_bytes, true);
+  if (!data_mgr->gpusPresent()) {
+    LOG(INFO) << "No GPU, skipping the transfer benchmarks";
+    return;
+  }
+  auto bytes = random_bytes(16 * g_mb, seed);
+  int tb_id{0};
+  for (const auto chunk_bytes : chunk_sizes) {
+    ++tb_id;
+    const auto key = chunk_key(tb_id, 0);
+    create_chunks(data_mgr.get(), tb_id, 1, chunk_bytes, bytes);
+    data_mgr->getChunkBuffer(key, CPU_LEVEL, 0, chunk_bytes)->unPin();
+    // the first copy creates the slab of the GPU pool
+    data_mgr->getChunkBuffer(key, GPU_LEVEL, 0, chunk_bytes)->unPin();
+    data_mgr->deleteChunksWithPrefix(key, GPU_LEVEL);
+    int64_t transfer_us{0};
+    for (size_t i = 0; i < repetitions; ++i) {
+      transfer_us += measure<std::chrono::microseconds>::execution([&]() {
+        data_mgr->getChunkBuffer(key, GPU_LEVEL, 0, chunk_bytes)->unPin();
+      });
+      data_mgr->deleteChunksWithPrefix(key, GPU_LEVEL);
+    }
+    results.push_back({"cpu_to_gpu/chunk_bytes:" + std::to_string(chunk_bytes),
+                       repetitions,
+                       repetitions * chunk_bytes,
+                       transfer_us,
+                       0});
+  }
+}
+
+// Allocations and frees of the CPU pool in batches, then fetches in random order of
+// working sets smaller and larger than the pool, which evict the least recently used
+// chunks once it is full.
+void run_buffer_pool_benchmarks(std::vector<StorageResult>& results,
+                                const boost::filesystem::path& base_path,
+                                const size_t pool_bytes,
+                                const unsigned seed) {
+  auto data_mgr = make_data_mgr(base_path / "pool", false, pool_bytes);
+  for (const size_t alloc_bytes : {4 << 10, 1 << 20, 32 << 20}) {
+    const auto batch_size =
+        std::max(size_t(1), std::min(size_t(64), pool_bytes / 2 / alloc_bytes));
+    const size_t batch_count{std::max(size_t(1), size_t(10000) / batch_size)};
+    std::vector<AbstractBuffer*> batch(batch_size);
+    const auto alloc_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (size_t i = 0; i < batch_count; ++i) {
+        for (auto& buffer : batch) {
+          buffer = data_mgr->alloc(CPU_LEVEL, 0, alloc_bytes);
+        }
+        for (auto buffer : batch) {
+          data_mgr->free(buffer);
+        }
+      }
+    });
+    results.push_back({"alloc_free/alloc_bytes:" + std::to_string(alloc_bytes),
+                       batch_count * batch_size,
+                       batch_count * batch_size * alloc_bytes,
+                       static_cast<int64_t>(alloc_us),
+                       0});
+  }
+
+  const size_t chunk_bytes{8 * g_mb};
+  const size_t passes{3};
+  auto bytes = random_bytes(chunk_bytes, seed);
+  int tb_id{0};
+  for (const double working_set_ratio : {0.5, 2., 4.}) {
+    ++tb_id;
+    const auto chunk_count = std::max(
+        size_t(1), static_cast<size_t>(working_set_ratio * pool_bytes / chunk_bytes));
+    create_chunks(data_mgr.get(), tb_id, chunk_count, chunk_bytes, bytes);
+    data_mgr->clearMemory(CPU_LEVEL);
+    std::vector<int> chunk_ids(chunk_count);
+    std::iota(chunk_ids.begin(), chunk_ids.end(), 0);
+    std::mt19937 rng(seed);
+    const auto evictions_before = cpu_evictions(data_mgr.get());
+    const auto fetch_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (size_t pass = 0; pass < passes; ++pass) {
+        std::shuffle(chunk_ids.begin(), chunk_ids.end(), rng);
+        for (const auto chunk_id : chunk_ids) {
+          data_mgr->getChunkBuffer(chunk_key(tb_id, chunk_id), CPU_LEVEL, 0, chunk_bytes)
+              ->unPin();
+        }
+      }
+    });
+    std::ostringstream name;
+    name << "fetch/working_set_ratio:" << working_set_ratio;
+    results.push_back({name.str(),
+                       passes * chunk_count,
+                       passes * chunk_count * chunk_bytes,
+                       static_cast<int64_t>(fetch_us),
+                       cpu_evictions(data_mgr.get()) - evictions_before});
+  }
+}
+
+std::string to_json(const std::vector<StorageResult>& results) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("benchmarks");
+  writer.StartArray();
+  for (const auto& result : results) {
+    const double seconds = std::max(result.elapsed_us, int64_t(1)) / 1e6;
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(result.name.c_str());
+    writer.Key("ops");
+    writer.Uint64(result.ops);
+    writer.Key("bytes");
+    writer.Uint64(result.bytes);
+    writer.Key("elapsed_ms");
+    writer.Double(result.elapsed_us / 1000.);
+    writer.Key("ms_per_op");
+    writer.Double(result.ops ? result.elapsed_us / 1000. / result.ops : 0);
+    writer.Key("ops_per_second");
+    writer.Double(result.ops / seconds);
+    writer.Key("mb_per_second");
+    writer.Double(result.bytes / seconds / g_mb);
+    writer.Key("evictions");
+    writer.Uint64(result.evictions);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string base_path{BASE_PATH};
+  size_t chunk_mb{64};
+  size_t read_chunk_count{16};
+  size_t pool_mb{256};
+  unsigned seed{42};
+  std::string output_path;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()("path",
+                     po::value<std::string>(&base_path)->default_value(base_path),
+                     "Directory of the data files of the benchmark, which is removed");
+  desc.add_options()("chunk-mb",
+                     po::value<size_t>(&chunk_mb)->default_value(chunk_mb),
+                     "Size of the chunks written and read");
+  desc.add_options()(
+      "read-chunks",
+      po::value<size_t>(&read_chunk_count)->default_value(read_chunk_count),
+      "Number of chunks read by the read benchmarks");
+  desc.add_options()("pool-mb",
+                     po::value<size_t>(&pool_mb)->default_value(pool_mb),
+                     "Size of the CPU pool of the allocation and eviction benchmarks");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the data");
+  desc.add_options()("cpu-only", "Do not run the transfer benchmarks on GPU");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: StorageBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  const auto benchmark_path = boost::filesystem::path(base_path) / "storage_benchmark";
+  std::vector<StorageResult> results;
+  run_write_benchmarks(results, benchmark_path, chunk_mb * g_mb, seed);
+  run_read_benchmarks(results, benchmark_path, chunk_mb * g_mb, read_chunk_count, seed);
+  run_checkpoint_benchmarks(results, benchmark_path, seed);
+  if (!vm.count("cpu-only")) {
+    run_gpu_transfer_benchmarks(results, benchmark_path, seed);
+  }
+  run_buffer_pool_benchmarks(results, benchmark_path, pool_mb * g_mb, seed);
+  boost::filesystem::remove_all(benchmark_path);
+
+  for (const auto& result : results) {
+    const double seconds = std::max(result.elapsed_us, int64_t(1)) / 1e6;
+    std::cerr << std::left << std::setw(48) << result.name << std::right << std::setw(12)
+              << std::fixed << std::setprecision(3)
+              << (result.ops ? result.elapsed_us / 1000. / result.ops : 0) << " ms/op"
+              << std::setw(12) << std::setprecision(1) << result.bytes / seconds / g_mb
+              << " MB/s" << std::endl;
+  }
+
+  const auto json = to_json(results);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,544 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    StringDictionaryBenchmark.cpp
+ * @brief   Throughput of the string dictionary operations at scale.
+ *
+ * Fills a dictionary through getOrAddBulk in import sized batches, for several rates of
+ * duplicated strings, with the hash table growing from its default capacity and, for
+ * the distinct strings, presized so that the cost of increaseCapacity shows as the
+ * difference. On the dictionary of distinct strings it then times the lookups in both
+ * directions, LIKE, ILIKE, REGEXP and comparison patterns, a full and an incremental
+ * checkpoint, and concurrent readers and writers for several thread counts. Given the
+ * address of a string dictionary server, runs the same operations through the remote
+ * path of StringDictionaryClient instead. The results are written as JSON.
+ */
+
+#include "../StringDictionary/StringDictionary.h"
+#include "../StringDictionary/StringDictionaryClient.h"
+#include "../Shared/measure.h"
+
+#include <glog/logging.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keeps the results of the benchmarked functions alive.
+volatile int64_t g_sink;
+
+struct BenchmarkResult {
+  std::string name;
+  size_t operations;
+  // Strings added, looked up or scanned by the operations.
+  size_t strings;
+  int64_t elapsed_us;
+};
+
+uint64_t mix(uint64_t key) {
+  key += 0x9e3779b97f4a7c15ULL;
+  key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+  return key ^ (key >> 31);
+}
+
+// Lower case letters derived from the key, 8 to 23 of them, followed by the key so
+// that distinct keys make distinct strings.
+std::string make_string(const uint64_t key) {
+  auto bits = mix(key);
+  std::string str(8 + bits % 16, ' ');
+  bits /= 16;
+  for (auto& c : str) {
+    if (!bits) {
+      bits = mix(bits + key);
+    }
+    c = 'a' + bits % 26;
+    bits /= 26;
+  }
+  return str + "#" + std::to_string(key);
+}
+
+// The given number of strings, drawn from the given number of distinct ones.
+std::vector<std::string> make_strings(const size_t count,
+                                      const size_t distinct_count,
+                                      const uint64_t first_key,
+                                      std::mt19937_64& rng) {
+  std::vector<std::string> strings;
+  strings.reserve(count);
+  if (distinct_count >= count) {
+    for (size_t i = 0; i < count; ++i) {
+      strings.push_back(make_string(first_key + i));
+    }
+    return strings;
+  }
+  std::uniform_int_distribution<uint64_t> key_dist(
+      0, std::max(distinct_count, size_t(1)) - 1);
+  for (size_t i = 0; i < count; ++i) {
+    strings.push_back(make_string(first_key + key_dist(rng)));
+  }
+  return strings;
+}
+
+std::string random_letters(const size_t length, std::mt19937_64& rng) {
+  std::uniform_int_distribution<int> letter_dist('a', 'z');
+  std::string letters(length, ' ');
+  for (auto& c : letters) {
+    c = letter_dist(rng);
+  }
+  return letters;
+}
+
+// Creates the dictionaries, local in their own directory or remote on the server.
+class DictionaryFactory {
+ public:
+  DictionaryFactory(const std::string& server) : next_dict_id_(1) {
+    if (!server.empty()) {
+      std::vector<std::string> host_port;
+      boost::split(host_port, server, boost::is_any_of(":"));
+      CHECK_EQ(size_t(2), host_port.size());
+      server_host_.reset(new LeafHostInfo(
+          host_port[0], std::stoi(host_port[1]), NodeRole::String));
+    }
+    base_dir_ = boost::filesystem::temp_directory_path() / "mapd_dictionary_benchmark";
+    boost::filesystem::create_directories(base_dir_);
+  }
+
+  ~DictionaryFactory() {
+    for (const auto& dict_ref : remote_dicts_) {
+      StringDictionaryClient(*server_host_, dict_ref, false).drop(dict_ref);
+    }
+    boost::filesystem::remove_all(base_dir_);
+  }
+
+  bool isRemote() const { return server_host_ != nullptr; }
+
+  std::unique_ptr<StringDictionary> create(const size_t initial_capacity = 256) {
+    const DictRef dict_ref(-1, next_dict_id_++);
+    if (server_host_) {
+      StringDictionaryClient(*server_host_, dict_ref, false).create(dict_ref, false);
+      remote_dicts_.push_back(dict_ref);
+      return std::make_unique<StringDictionary>(*server_host_, dict_ref);
+    }
+    const auto folder = base_dir_ / std::to_string(dict_ref.dictId);
+    boost::filesystem::create_directories(folder);
+    return std::make_unique<StringDictionary>(
+        folder.string(), false, false, initial_capacity);
+  }
+
+ private:
+  std::unique_ptr<LeafHostInfo> server_host_;
+  boost::filesystem::path base_dir_;
+  int32_t next_dict_id_;
+  std::vector<DictRef> remote_dicts_;
+};
+
+// Adds the strings in batches, as the importer does.
+BenchmarkResult bulk_add(const std::string& name,
+                         StringDictionary& dict,
+                         const std::vector<std::string>& strings,
+                         const size_t batch_size) {
+  std::vector<std::vector<std::string>> batches;
+  for (size_t begin = 0; begin < strings.size(); begin += batch_size) {
+    batches.emplace_back(strings.begin() + begin,
+                         strings.begin() + std::min(begin + batch_size, strings.size()));
+  }
+  std::vector<int32_t> ids(batch_size);
+  const auto elapsed_us = measure<std::chrono::microseconds>::execution([&]() {
+    for (const auto& batch : batches) {
+      dict.getOrAddBulk(batch, ids.data());
+    }
+  });
+  g_sink = ids.front();
+  return {name, batches.size(), strings.size(), elapsed_us};
+}
+
+// Runs the calls of a pattern kind, each with another pattern so that no call is
+// answered by the cache of the previous ones. The first call builds the indexes.
+template <class CALL>
+void run_pattern_calls(const std::function<void(const BenchmarkResult&)>& report,
+                       const std::string& name,
+                       const size_t entry_count,
+                       const size_t call_count,
+                       std::mt19937_64& rng,
+                       const CALL& call) {
+  size_t match_count{0};
+  const auto cold_us = measure<std::chrono::microseconds>::execution(
+      [&]() { match_count += call(random_letters(3, rng)).size(); });
+  report({name + "/first_call", 1, entry_count, cold_us});
+  std::vector<std::string> needles;
+  for (size_t i = 0; i < call_count; ++i) {
+    needles.push_back(random_letters(3, rng));
+  }
+  const auto elapsed_us = measure<std::chrono::microseconds>::execution([&]() {
+    for (const auto& needle : needles) {
+      match_count += call(needle).size();
+    }
+  });
+  g_sink = match_count;
+  report({name, call_count, call_count * entry_count, elapsed_us});
+}
+
+// Each thread looks up existing strings or, for the given fraction of its operations,
+// adds a batch of new ones, for the given time.
+BenchmarkResult run_contention(StringDictionary& dict,
+                               const std::vector<std::string>& existing,
+                               const size_t thread_count,
+                               const double write_ratio,
+                               const size_t write_batch_size,
+                               const int64_t duration_ms,
+                               const unsigned seed) {
+  std::atomic<uint64_t> next_key{1ULL << 40};
+  std::atomic<size_t> strings{0};
+  std::vector<std::future<size_t>> threads;
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+  const auto elapsed_us = measure<std::chrono::microseconds>::execution([&]() {
+    for (size_t i = 0; i < thread_count; ++i) {
+      threads.push_back(std::async(std::launch::async, [&, i]() {
+        std::mt19937_64 rng(seed + i);
+        std::uniform_int_distribution<size_t> string_dist(0, existing.size() - 1);
+        std::uniform_real_distribution<double> op_dist(0, 1);
+        std::vector<int32_t> ids(write_batch_size);
+        size_t operations{0};
+        int64_t id_sum{0};
+        while (std::chrono::steady_clock::now() < deadline) {
+          if (op_dist(rng) < write_ratio) {
+            const auto first_key = next_key.fetch_add(write_batch_size);
+            const auto batch =
+                make_strings(write_batch_size, write_batch_size, first_key, rng);
+            dict.getOrAddBulk(batch, ids.data());
+            strings += write_batch_size;
+          } else {
+            id_sum += dict.getIdOfString(existing[string_dist(rng)]);
+            ++strings;
+          }
+          ++operations;
+        }
+        g_sink = id_sum;
+        return operations;
+      }));
+    }
+  });
+  size_t operations{0};
+  for (auto& thread : threads) {
+    operations += thread.get();
+  }
+  std::ostringstream name;
+  name << "contention/threads:" << thread_count << "/write_ratio:" << write_ratio;
+  return {name.str(), operations, strings, elapsed_us};
+}
+
+std::string to_json(const size_t entry_count,
+                    const bool remote,
+                    const std::vector<BenchmarkResult>& results) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("entries");
+  writer.Uint64(entry_count);
+  writer.Key("remote");
+  writer.Bool(remote);
+  writer.Key("trigram_index");
+  writer.Bool(g_enable_string_dict_trigram_index);
+  writer.Key("benchmarks");
+  writer.StartArray();
+  for (const auto& result : results) {
+    const double seconds = std::max(result.elapsed_us, int64_t(1)) / 1e6;
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(result.name.c_str());
+    writer.Key("operations");
+    writer.Uint64(result.operations);
+    writer.Key("elapsed_ms");
+    writer.Double(result.elapsed_us / 1000.);
+    writer.Key("operations_per_second");
+    writer.Double(result.operations / seconds);
+    writer.Key("strings_per_second");
+    writer.Double(result.strings / seconds);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t entry_count{10000000};
+  size_t batch_size{100000};
+  size_t lookup_count{1000000};
+  size_t pattern_calls{10};
+  std::string duplicate_rates_str{"0,0.5,0.9"};
+  std::string thread_counts_str{"1,2,4,8,16"};
+  double write_ratio{0.1};
+  size_t write_batch_size{100};
+  int64_t contention_ms{2000};
+  unsigned seed{42};
+  std::string server;
+  std::string filter;
+  std::string output_path;
+
+  namespace po = boost::program_options;
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages");
+  desc.add_options()("entries",
+                     po::value<size_t>(&entry_count)->default_value(entry_count),
+                     "Strings added to each dictionary");
+  desc.add_options()("batch-size",
+                     po::value<size_t>(&batch_size)->default_value(batch_size),
+                     "Strings per getOrAddBulk call");
+  desc.add_options()("lookups",
+                     po::value<size_t>(&lookup_count)->default_value(lookup_count),
+                     "Lookups of each direction");
+  desc.add_options()("pattern-calls",
+                     po::value<size_t>(&pattern_calls)->default_value(pattern_calls),
+                     "Calls of each pattern kind after the first one");
+  desc.add_options()("duplicate-rates",
+                     po::value<std::string>(&duplicate_rates_str)
+                         ->default_value(duplicate_rates_str),
+                     "Comma separated fractions of duplicated strings to add");
+  desc.add_options()("threads",
+                     po::value<std::string>(&thread_counts_str)
+                         ->default_value(thread_counts_str),
+                     "Comma separated thread counts of the contention runs");
+  desc.add_options()("write-ratio",
+                     po::value<double>(&write_ratio)->default_value(write_ratio),
+                     "Fraction of the operations of the contention runs which add");
+  desc.add_options()(
+      "write-batch-size",
+      po::value<size_t>(&write_batch_size)->default_value(write_batch_size),
+      "Strings added by each adding operation of the contention runs");
+  desc.add_options()("contention-ms",
+                     po::value<int64_t>(&contention_ms)->default_value(contention_ms),
+                     "Duration of each contention run");
+  desc.add_options()(
+      "seed", po::value<unsigned>(&seed)->default_value(seed), "Seed of the strings");
+  desc.add_options()("trigram-index",
+                     po::bool_switch(&g_enable_string_dict_trigram_index),
+                     "Index the trigrams of the strings for the LIKE patterns");
+  desc.add_options()("server",
+                     po::value<std::string>(&server),
+                     "host:port of a string dictionary server to run against");
+  desc.add_options()("filter",
+                     po::value<std::string>(&filter),
+                     "Only run the benchmarks whose name contains this string");
+  desc.add_options()("output",
+                     po::value<std::string>(&output_path),
+                     "JSON file for the results, standard output by default");
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    if (vm.count("help")) {
+      std::cout << "Usage: StringDictionaryBenchmark [options]\n" << desc << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+
+  google::InitGoogleLogging(argv[0]);
+
+  std::vector<std::string> duplicate_rate_strs;
+  boost::split(duplicate_rate_strs, duplicate_rates_str, boost::is_any_of(","));
+  std::vector<std::string> thread_count_strs;
+  boost::split(thread_count_strs, thread_counts_str, boost::is_any_of(","));
+
+  DictionaryFactory factory(server);
+  std::mt19937_64 rng(seed);
+  std::vector<BenchmarkResult> results;
+  const auto runs = [&filter](const std::string& name) {
+    return filter.empty() || name.find(filter) != std::string::npos;
+  };
+  const std::function<void(const BenchmarkResult&)> report =
+      [&results](const BenchmarkResult& result) {
+        results.push_back(result);
+        const double seconds = std::max(result.elapsed_us, int64_t(1)) / 1e6;
+        std::cerr << std::left << std::setw(50) << result.name << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(1)
+                  << result.elapsed_us / 1000. << " ms" << std::setw(14)
+                  << std::setprecision(2) << result.strings / seconds / 1e6
+                  << " M strings/s" << std::endl;
+      };
+
+  for (const auto& rate_str : duplicate_rate_strs) {
+    const auto rate = std::stod(rate_str);
+    const auto name = "bulk_add/duplicates:" + rate_str;
+    if (!runs(name) || rate == 0) {
+      continue;
+    }
+    const auto strings = make_strings(
+        entry_count, static_cast<size_t>(entry_count * (1 - rate)), 0, rng);
+    auto dict = factory.create();
+    report(bulk_add(name, *dict, strings, batch_size));
+  }
+
+  // The distinct strings, the dictionary the other benchmarks run on.
+  const auto strings = make_strings(entry_count, entry_count, 0, rng);
+  if (!factory.isRemote() && runs("bulk_add/duplicates:0/presized")) {
+    size_t capacity{256};
+    while (capacity < 2 * entry_count) {
+      capacity *= 2;
+    }
+    auto dict = factory.create(capacity);
+    report(bulk_add("bulk_add/duplicates:0/presized", *dict, strings, batch_size));
+  }
+  auto dict = factory.create();
+  report(bulk_add("bulk_add/duplicates:0", *dict, strings, batch_size));
+  const auto generation = dict->storageEntryCount();
+
+  if (runs("checkpoint")) {
+    const auto full_us = measure<std::chrono::microseconds>::execution(
+        [&]() { CHECK(dict->checkpoint()); });
+    report({"checkpoint/full", 1, entry_count, full_us});
+    const auto added_count = entry_count / 100;
+    const auto added = make_strings(added_count, added_count, 1ULL << 48, rng);
+    std::vector<int32_t> ids(added.size());
+    dict->getOrAddBulk(added, ids.data());
+    const auto incremental_us = measure<std::chrono::microseconds>::execution(
+        [&]() { CHECK(dict->checkpoint()); });
+    report({"checkpoint/incremental_1_percent", 1, added.size(), incremental_us});
+  }
+
+  if (runs("get_id_of_string")) {
+    std::uniform_int_distribution<size_t> string_dist(0, strings.size() - 1);
+    std::vector<const std::string*> lookups;
+    for (size_t i = 0; i < lookup_count; ++i) {
+      lookups.push_back(&strings[string_dist(rng)]);
+    }
+    int64_t id_sum{0};
+    const auto elapsed_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (const auto str : lookups) {
+        id_sum += dict->getIdOfString(*str);
+      }
+    });
+    g_sink = id_sum;
+    report({"get_id_of_string", lookup_count, lookup_count, elapsed_us});
+  }
+  if (runs("get_string")) {
+    std::uniform_int_distribution<int32_t> id_dist(0, generation - 1);
+    std::vector<int32_t> lookups;
+    for (size_t i = 0; i < lookup_count; ++i) {
+      lookups.push_back(id_dist(rng));
+    }
+    size_t length_sum{0};
+    const auto elapsed_us = measure<std::chrono::microseconds>::execution([&]() {
+      for (const auto id : lookups) {
+        length_sum += dict->getString(id).size();
+      }
+    });
+    g_sink = length_sum;
+    report({"get_string", lookup_count, lookup_count, elapsed_us});
+  }
+
+  // As the executor calls them for LIKE '%abc%', LIKE 'abc%', ILIKE '%ABC%' and
+  // REGEXP: simple patterns come with their wildcards stripped.
+  if (runs("get_like/contains")) {
+    run_pattern_calls(report,
+                      "get_like/contains",
+                      generation,
+                      pattern_calls,
+                      rng,
+                      [&](const std::string& needle) {
+                        return dict->getLike(needle, false, true, '\\', generation);
+                      });
+  }
+  if (runs("get_like/prefix")) {
+    run_pattern_calls(report,
+                      "get_like/prefix",
+                      generation,
+                      pattern_calls,
+                      rng,
+                      [&](const std::string& needle) {
+                        return dict->getLike(
+                            needle + "%", false, false, '\\', generation);
+                      });
+  }
+  if (runs("get_ilike/contains")) {
+    run_pattern_calls(report,
+                      "get_ilike/contains",
+                      generation,
+                      pattern_calls,
+                      rng,
+                      [&](const std::string& needle) {
+                        return dict->getLike(needle, true, true, '\\', generation);
+                      });
+  }
+  if (runs("get_regexp_like")) {
+    run_pattern_calls(report,
+                      "get_regexp_like",
+                      generation,
+                      pattern_calls,
+                      rng,
+                      [&](const std::string& needle) {
+                        return dict->getRegexpLike(
+                            "^" + needle + ".*[0-9]$", '\\', generation);
+                      });
+  }
+  // The first call sorts the dictionary, the next ones search the sorted cache.
+  if (runs("get_compare")) {
+    run_pattern_calls(report,
+                      "get_compare/less_than",
+                      generation,
+                      pattern_calls,
+                      rng,
+                      [&](const std::string& needle) {
+                        return dict->getCompare(needle, "<", generation);
+                      });
+  }
+
+  for (const auto& thread_count_str : thread_count_strs) {
+    const auto thread_count = std::stoul(thread_count_str);
+    if (!runs("contention")) {
+      break;
+    }
+    report(run_contention(*dict,
+                          strings,
+                          thread_count,
+                          write_ratio,
+                          write_batch_size,
+                          contention_ms,
+                          seed));
+  }
+
+  const auto json = to_json(entry_count, factory.isRemote(), results);
+  if (output_path.empty()) {
+    std::cout << json << std::endl;
+  } else {
+    std::ofstream(output_path) << json << std::endl;
+  }
+  return 0;
+}
@@ -16,8 +16,12 @@
 
 #include "../StringDictionary/StringDictionary.h"
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
+#include <thread>
 
+#include <boost/filesystem.hpp>
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
@@ -86,6 +90,186 @@ TEST(StringDictionary, RecoverMany) {
   }
 }
 
+TEST(StringDictionary, RecoverTrigramIndex) {
+  g_enable_string_dict_trigram_index = true;
+  StringDictionary string_dict(BASE_PATH, false, true);
+  g_enable_string_dict_trigram_index = false;
+  std::vector<int32_t> expected_ids;
+  for (int i = 0; i < g_op_count; ++i) {
+    if (std::to_string(i).find("1234") != std::string::npos) {
+      expected_ids.push_back(i);
+    }
+  }
+  ASSERT_EQ(expected_ids, string_dict.getLike("%1234%", false, false, '\\', g_op_count));
+}
+
+TEST(StringDictionary, RecoverPersistedHashIndex) {
+  {
+    StringDictionary string_dict(BASE_PATH, false, true);
+    ASSERT_TRUE(string_dict.checkpoint());
+    // not covered by the persisted hash table, hashed on recovery
+    CHECK_EQ(g_op_count, string_dict.getOrAdd(std::to_string(g_op_count)));
+  }
+  StringDictionary string_dict(BASE_PATH, false, true);
+  for (int i = 0; i <= g_op_count; ++i) {
+    CHECK_EQ(i, string_dict.getIdOfString(std::to_string(i)));
+  }
+  ASSERT_EQ(g_op_count + 1, string_dict.getOrAdd("new string"));
+}
+
+TEST(StringDictionary, UnloadColdHashIndex) {
+  const auto cold_path = std::string(BASE_PATH) + "/cold_dict";
+  const auto hot_path = std::string(BASE_PATH) + "/hot_dict";
+  boost::filesystem::create_directory(cold_path);
+  boost::filesystem::create_directory(hot_path);
+  StringDictionary cold_dict(cold_path, false, false);
+  StringDictionary hot_dict(hot_path, false, false);
+  const int str_count{1000};
+  for (int i = 0; i < str_count; ++i) {
+    CHECK_EQ(i, cold_dict.getOrAdd("cold" + std::to_string(i)));
+    CHECK_EQ(i, hot_dict.getOrAdd("hot" + std::to_string(i)));
+  }
+  // Only room for one of the hash tables, each lookup unloads the other one.
+  g_string_dict_index_memory_budget = 1;
+  for (int i = 0; i < str_count; ++i) {
+    CHECK_EQ(i, cold_dict.getIdOfString("cold" + std::to_string(i)));
+    CHECK_EQ(i, hot_dict.getOrAdd("hot" + std::to_string(i)));
+  }
+  ASSERT_EQ(str_count, cold_dict.getOrAdd("cold" + std::to_string(str_count)));
+  ASSERT_EQ(std::vector<int32_t>({0}), hot_dict.getCompare("hot0", "=", str_count));
+  g_string_dict_index_memory_budget = 0;
+}
+
+TEST(StringDictionary, CheckpointIncrementally) {
+  const auto first_path = std::string(BASE_PATH) + "/first_dict";
+  const auto second_path = std::string(BASE_PATH) + "/second_dict";
+  boost::filesystem::create_directory(first_path);
+  boost::filesystem::create_directory(second_path);
+  {
+    StringDictionary first_dict(first_path, false, false);
+    StringDictionary second_dict(second_path, false, false);
+    for (int i = 0; i < 1000; ++i) {
+      CHECK_EQ(i, first_dict.getOrAdd(std::to_string(i)));
+      ASSERT_TRUE(first_dict.checkpoint());
+    }
+    // nothing new to flush
+    ASSERT_TRUE(first_dict.checkpoint());
+    CHECK_EQ(0, second_dict.getOrAdd("foo"));
+    ASSERT_TRUE(
+        checkpoint_string_dictionaries({&first_dict, nullptr, &second_dict, &first_dict}));
+  }
+  StringDictionary first_dict(first_path, false, true);
+  StringDictionary second_dict(second_path, false, true);
+  for (int i = 0; i < 1000; ++i) {
+    CHECK_EQ(std::to_string(i), first_dict.getString(i));
+  }
+  ASSERT_EQ(0, second_dict.getIdOfString("foo"));
+}
+
+TEST(StringDictionary, GetDuringBulkAdd) {
+  StringDictionary string_dict(BASE_PATH, true, false);
+  std::atomic<bool> done{false};
+  std::thread reader([&string_dict, &done] {
+    while (!done) {
+      const auto str_count = string_dict.storageEntryCount();
+      for (size_t i = 0; i < str_count; i += 97) {
+        CHECK_EQ(std::to_string(i), string_dict.getString(i));
+      }
+    }
+  });
+  const int batch_size{10000};
+  for (int i = 0; i < g_op_count; i += batch_size) {
+    std::vector<std::string> strings;
+    for (int j = i; j < i + batch_size; ++j) {
+      strings.push_back(std::to_string(j));
+    }
+    std::vector<int32_t> string_ids(strings.size());
+    string_dict.getOrAddBulk(strings, string_ids.data());
+    for (int j = 0; j < batch_size; ++j) {
+      CHECK_EQ(i + j, string_ids[j]);
+    }
+  }
+  done = true;
+  reader.join();
+  ASSERT_EQ(static_cast<size_t>(g_op_count), string_dict.storageEntryCount());
+}
+
+TEST(StringDictionary, GetOrAddBulkFromArena) {
+  StringDictionary string_dict(BASE_PATH, true, false);
+  const std::vector<std::string> strings{"foo", "", "bar", "foo", "baz"};
+  StringArena arena;
+  for (const auto& str : strings) {
+    arena.push_back(str);
+  }
+  std::vector<int32_t> arena_ids(arena.size());
+  string_dict.getOrAddBulk(arena, arena_ids.data());
+  std::vector<int32_t> string_ids(strings.size());
+  string_dict.getOrAddBulk(strings, string_ids.data());
+  ASSERT_EQ(string_ids, arena_ids);
+  ASSERT_EQ(arena_ids[0], arena_ids[3]);
+  ASSERT_EQ(std::numeric_limits<int32_t>::min(), arena_ids[1]);
+  ASSERT_EQ("baz", string_dict.getString(arena_ids[4]));
+  ASSERT_EQ(size_t(3), string_dict.storageEntryCount());
+}
+
+TEST(StringDictionary, TrigramIndex) {
+  const std::vector<std::string> strings{
+      "foobar", "FooBaz", "barfoo", "fo", "xfoboar", "a.b+c", "quux_1", "quux%2"};
+  g_enable_string_dict_trigram_index = false;
+  StringDictionary scanned_dict(BASE_PATH, true, false);
+  g_enable_string_dict_trigram_index = true;
+  StringDictionary indexed_dict(BASE_PATH, true, false);
+  g_enable_string_dict_trigram_index = false;
+  for (const auto& str : strings) {
+    ASSERT_EQ(scanned_dict.getOrAdd(str), indexed_dict.getOrAdd(str));
+  }
+  const auto generation = strings.size();
+  // the scan doesn't return the ids in order
+  const auto sorted = [](std::vector<int32_t> string_ids) {
+    std::sort(string_ids.begin(), string_ids.end());
+    return string_ids;
+  };
+  for (const auto& pattern : std::vector<std::string>{
+           "%foo%", "foo%", "%bar", "%oob%", "fo", "%xyz%", "%a_b%"}) {
+    ASSERT_EQ(sorted(scanned_dict.getLike(pattern, false, false, '\\', generation)),
+              indexed_dict.getLike(pattern, false, false, '\\', generation));
+    ASSERT_EQ(sorted(scanned_dict.getLike(pattern, true, false, '\\', generation)),
+              indexed_dict.getLike(pattern, true, false, '\\', generation));
+  }
+  ASSERT_EQ(std::vector<int32_t>({6}),
+            indexed_dict.getLike("%quux\\_%", false, false, '\\', generation));
+  ASSERT_EQ(std::vector<int32_t>({0, 2}),
+            indexed_dict.getLike("foo", false, true, '\\', 3));
+  for (const auto& pattern : std::vector<std::string>{"foo.*",
+                                                      ".*[Bb]a[rz]",
+                                                      "fo+bar",
+                                                      "foob?ar",
+                                                      "a\\.b\\+c",
+                                                      "quux_[0-9]",
+                                                      "(foo|bar).*",
+                                                      "xyz.*"}) {
+    ASSERT_EQ(sorted(scanned_dict.getRegexpLike(pattern, '\\', generation)),
+              sorted(indexed_dict.getRegexpLike(pattern, '\\', generation)));
+  }
+  ASSERT_EQ(std::vector<int32_t>({1}),
+            indexed_dict.getCompare("FooBaz", "=", generation));
+}
+
+TEST(StringDictionary, SortedRanks) {
+  StringDictionary string_dict(BASE_PATH, true, false);
+  for (const auto& str : std::vector<std::string>{"pear", "apple", "Zoo", "banana"}) {
+    string_dict.getOrAdd(str);
+  }
+  const auto ranks = string_dict.getSortedRanks();
+  ASSERT_EQ(std::vector<int32_t>({3, 1, 0, 2}), *ranks);
+  ASSERT_EQ(ranks, string_dict.getSortedRanks());
+  // the strings added later are merged in
+  string_dict.getOrAdd("cherry");
+  string_dict.getOrAdd("a");
+  ASSERT_EQ(std::vector<int32_t>({5, 2, 0, 3, 4, 1}), *string_dict.getSortedRanks());
+  ASSERT_EQ(std::vector<int32_t>({3, 1, 0, 2}), *ranks);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   auto err = RUN_ALL_TESTS();
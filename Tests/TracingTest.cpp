@@ -0,0 +1,75 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../Shared/Tracing.h"
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+TEST(Tracing, Unsampled) {
+  tracing::Span root("root", "");
+  ASSERT_FALSE(root.sampled());
+  tracing::Span child("child");
+  ASSERT_FALSE(child.sampled());
+  ASSERT_EQ("", tracing::Span::currentTraceparent());
+}
+
+TEST(Tracing, Propagation) {
+  const auto path =
+      (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path())
+          .string();
+  tracing::Tracer::get().init(path, 1, "test");
+  const auto trace = tracing::Span::newTrace();
+  ASSERT_EQ(size_t(55), trace.size());
+  std::string remote_traceparent;
+  {
+    tracing::Span root("root", trace);
+    ASSERT_TRUE(root.sampled());
+    tracing::Span child("child");
+    ASSERT_TRUE(child.sampled());
+    remote_traceparent = tracing::Span::currentTraceparent();
+    ASSERT_EQ(child.traceparent(), remote_traceparent);
+  }
+  ASSERT_EQ("", tracing::Span::currentTraceparent());
+  {
+    // On another node, which exports its own part of the trace.
+    tracing::Span remote("remote", remote_traceparent);
+    ASSERT_EQ(trace.substr(0, 35), remote.traceparent().substr(0, 35));
+  }
+  tracing::Tracer::get().init(path, 0, "test");
+  ASSERT_EQ("", tracing::Span::newTrace());
+
+  std::ifstream file(path);
+  std::string root_line, remote_line, line;
+  ASSERT_TRUE(std::getline(file, root_line));
+  ASSERT_TRUE(std::getline(file, remote_line));
+  ASSERT_FALSE(std::getline(file, line));
+  const auto trace_id = "\"traceId\":\"" + trace.substr(3, 32) + "\"";
+  ASSERT_NE(std::string::npos, root_line.find(trace_id));
+  ASSERT_NE(std::string::npos, root_line.find("\"name\":\"child\""));
+  ASSERT_NE(std::string::npos, root_line.find("\"parentSpanId\":\"\""));
+  ASSERT_NE(std::string::npos, remote_line.find(trace_id));
+  ASSERT_NE(std::string::npos,
+            remote_line.find("\"parentSpanId\":\"" + remote_traceparent.substr(36, 16)));
+  boost::filesystem::remove(path);
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -41,6 +41,9 @@ TEST(Utils, Regexp) {
   ASSERT_FALSE(regexp_like("abc100%efg", 10, ".+100!%...", 10, '!'));
   ASSERT_TRUE(regexp_like("[ hello", 7, ".*\\[.*", 6, '\\'));
   ASSERT_TRUE(regexp_like("hello [", 7, ".*\\[.*", 6, '\\'));
+  // Malformed patterns don't match, also once they are compiled.
+  ASSERT_FALSE(regexp_like("(abc", 4, "(abc", 4, '\\'));
+  ASSERT_FALSE(regexp_like("(abc", 4, "(abc", 4, '\\'));
 }
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CompactResult.h"
+
+#include <glog/logging.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+size_t compact_width(const SQLTypeInfo& ti) {
+  if (ti.is_array() || ti.is_geometry()) {
+    throw std::runtime_error("Columns of type " + ti.get_type_name() +
+                             " have no compact encoding");
+  }
+  switch (ti.get_type()) {
+    case kBOOLEAN:
+    case kTINYINT:
+      return 1;
+    case kSMALLINT:
+      return 2;
+    case kINT:
+    case kFLOAT:
+    case kTEXT:
+    case kVARCHAR:
+    case kCHAR:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+bool is_compact_integer(const SQLTypeInfo& ti) {
+  return !ti.is_fp() && !ti.is_string();
+}
+
+}  // namespace
+
+CompactColumnEncoder::CompactColumnEncoder(const SQLTypeInfo& ti, const bool delta_encode)
+    : ti_(ti)
+    , delta_encode_(delta_encode && is_compact_integer(ti))
+    , width_(compact_width(ti)) {}
+
+// The values are copied in host order, little-endian on all the supported platforms.
+template <class T>
+void CompactColumnEncoder::appendFixed(const T val) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &val, sizeof(T));
+  values_.append(bytes, sizeof(T));
+}
+
+void CompactColumnEncoder::append(const TargetValue& tv) {
+  const auto scalar_tv = boost::get<ScalarTargetValue>(&tv);
+  CHECK(scalar_tv);
+  if (const auto ival = boost::get<int64_t>(scalar_tv)) {
+    bool is_null{false};
+    switch (ti_.get_type()) {
+      case kBOOLEAN:
+        is_null = *ival == NULL_BOOLEAN;
+        break;
+      case kTINYINT:
+        is_null = *ival == NULL_TINYINT;
+        break;
+      case kSMALLINT:
+        is_null = *ival == NULL_SMALLINT;
+        break;
+      case kINT:
+        is_null = *ival == NULL_INT;
+        break;
+      case kTIME:
+      case kTIMESTAMP:
+      case kDATE:
+      case kINTERVAL_DAY_TIME:
+      case kINTERVAL_YEAR_MONTH:
+        is_null = *ival == (sizeof(time_t) == 4 ? NULL_INT : NULL_BIGINT);
+        break;
+      default:
+        is_null = *ival == NULL_BIGINT;
+    }
+    appendNull(is_null && !ti_.get_notnull());
+    appendInteger(*ival);
+  } else if (const auto dval = boost::get<double>(scalar_tv)) {
+    if (ti_.get_type() == kFLOAT) {
+      appendNull(*dval == NULL_FLOAT && !ti_.get_notnull());
+      appendFixed(static_cast<float>(*dval));
+    } else {
+      appendNull(*dval == NULL_DOUBLE && !ti_.get_notnull());
+      appendFixed(*dval);
+    }
+  } else if (const auto fval = boost::get<float>(scalar_tv)) {
+    CHECK_EQ(kFLOAT, ti_.get_type());
+    appendNull(*fval == NULL_FLOAT && !ti_.get_notnull());
+    appendFixed(*fval);
+  } else if (const auto s_n = boost::get<NullableString>(scalar_tv)) {
+    const auto s = boost::get<std::string>(s_n);
+    appendNull(!s && !ti_.get_notnull());
+    int32_t string_id{0};
+    if (s) {
+      const auto it = string_ids_.emplace(*s, dictionary_.size());
+      if (it.second) {
+        dictionary_.push_back(*s);
+      }
+      string_id = it.first->second;
+    }
+    appendFixed(string_id);
+  } else {
+    CHECK(false);
+  }
+  ++row_count_;
+}
+
+TCompactColumn CompactColumnEncoder::finalize() {
+  TCompactColumn column;
+  column.values.swap(values_);
+  if (has_nulls_) {
+    column.nulls.swap(nulls_);
+  }
+  column.dictionary.swap(dictionary_);
+  column.delta_encoded = delta_encode_;
+  row_count_ = 0;
+  has_nulls_ = false;
+  last_value_ = 0;
+  nulls_.clear();
+  string_ids_.clear();
+  return column;
+}
+
+void CompactColumnEncoder::appendNull(const bool is_null) {
+  if (row_count_ % 8 == 0) {
+    nulls_.push_back(0);
+  }
+  if (is_null) {
+    nulls_.back() |= 1 << (row_count_ % 8);
+    has_nulls_ = true;
+  }
+}
+
+void CompactColumnEncoder::appendInteger(const int64_t val) {
+  if (!delta_encode_) {
+    switch (width_) {
+      case 1:
+        appendFixed(static_cast<int8_t>(val));
+        break;
+      case 2:
+        appendFixed(static_cast<int16_t>(val));
+        break;
+      case 4:
+        appendFixed(static_cast<int32_t>(val));
+        break;
+      default:
+        appendFixed(val);
+    }
+    return;
+  }
+  // wraps around like the decoder, a delta never overflows
+  const uint64_t delta = static_cast<uint64_t>(val) - static_cast<uint64_t>(last_value_);
+  uint64_t zigzag =
+      (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+  while (zigzag >= 0x80) {
+    values_.push_back(static_cast<char>(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  values_.push_back(static_cast<char>(zigzag));
+  last_value_ = val;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    CompactResult.h
+ * @brief   Compact columns of a query result, as returned by sql_execute_compact.
+ *
+ * A column is a single buffer of little-endian values instead of a Thrift value and a
+ * null flag per row: booleans take 1 byte, integers their width, decimals the unscaled
+ * 8 byte integer, dates, times and timestamps 8 bytes, floats 4 and doubles 8. Strings
+ * are 4 byte indexes into a dictionary of the distinct strings of the column. Nulls are
+ * a bitmap, bit i % 8 of byte i / 8 set for row i, empty if the column has none, and
+ * the value of a null row is unspecified. With delta encoding, the integer columns are
+ * instead the zigzag varints of the difference of each value to the previous one.
+ */
+
+#ifndef COMPACTRESULT_H
+#define COMPACTRESULT_H
+
+#include "QueryEngine/TargetValue.h"
+#include "Shared/sqltypes.h"
+#include "gen-cpp/mapd_types.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CompactColumnEncoder {
+ public:
+  // Throws for the array and geo types, which have no compact encoding.
+  CompactColumnEncoder(const SQLTypeInfo& ti, const bool delta_encode);
+
+  void append(const TargetValue& tv);
+
+  // Moves the encoded column out, the encoder is empty afterwards.
+  TCompactColumn finalize();
+
+ private:
+  void appendNull(const bool is_null);
+  void appendInteger(const int64_t val);
+  template <class T>
+  void appendFixed(const T val);
+
+  const SQLTypeInfo ti_;
+  const bool delta_encode_;
+  const size_t width_;
+  size_t row_count_{0};
+  bool has_nulls_{false};
+  int64_t last_value_{0};
+  std::string values_;
+  std::string nulls_;
+  std::unordered_map<std::string, int32_t> string_ids_;
+  std::vector<std::string> dictionary_;
+};
+
+#endif  // COMPACTRESULT_H
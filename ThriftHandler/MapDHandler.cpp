@@ -22,6 +22,7 @@
  */
 
 #include "MapDHandler.h"
+#include "CompactResult.h"
 #include "DistributedLoader.h"
 #include "MapDServer.h"
 #include "TokenCompletionHints.h"
@@ -59,8 +60,11 @@
 #include "QueryEngine/GpuMemUtils.h"
 #include "QueryEngine/JoinFilterPushDown.h"
 #include "QueryEngine/JsonAccessors.h"
+#include "QueryEngine/UpdateCacheInvalidators.h"
 #include "Shared/MapDParameters.h"
 #include "Shared/SQLTypeUtilities.h"
+#include "Shared/Metrics.h"
+#include "Shared/Tracing.h"
 #include "Shared/StringTransform.h"
 #include "Shared/geo_types.h"
 #include "Shared/geosupport.h"
@@ -85,12 +89,15 @@
 #include <boost/tokenizer.hpp>
 #include <cmath>
 #include <csignal>
+#include <ctime>
 #include <fstream>
 #include <future>
+#include <limits>
 #include <map>
 #include <memory>
 #include <random>
 #include <regex>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <typeinfo>
@@ -115,6 +122,14 @@ using namespace Lock_Namespace;
 
 std::string generate_random_string(const size_t len);
 
+size_t g_vacuum_interval_secs{0};
+double g_vacuum_min_deleted_fraction{0.3};
+size_t g_hot_chunks_save_interval_secs{0};
+size_t g_hot_chunks_prefetch_mb_per_sec{256};
+size_t g_async_query_threads{4};
+int64_t g_slow_query_threshold_ms{-1};
+double g_trace_sample_rate{0};
+
 MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
                          const std::vector<LeafHostInfo>& string_leaves,
                          const std::string& base_data_path,
@@ -151,7 +166,10 @@ MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
     , access_priv_check_(access_priv_check)
     , idle_session_duration_(idle_session_duration * 60)
     , max_session_duration_(max_session_duration * 60)
-    , _was_geo_copy_from(false) {
+    , _was_geo_copy_from(false)
+    , stop_vacuum_(false)
+    , stop_hot_chunks_(false)
+    , hot_chunks_prefetched_(false) {
   LOG(INFO) << "MapD Server " << MAPD_RELEASE;
   if (executor_device == "gpu") {
 #ifdef HAVE_CUDA
@@ -235,18 +253,232 @@ MapDHandler::MapDHandler(const std::vector<LeafHostInfo>& db_leaves,
       LOG(ERROR) << "Distributed leaf support disabled: " << e.what();
     }
   }
+
+  if (g_vacuum_interval_secs > 0 && !read_only_ && leaf_aggregator_.leafCount() == 0) {
+    vacuum_thread_ = std::thread([this] { vacuum_deleted_rows_periodically(); });
+  }
+  if (g_hot_chunks_save_interval_secs > 0 && leaf_aggregator_.leafCount() == 0) {
+    hot_chunks_thread_ =
+        std::thread([this] { prefetch_and_save_hot_chunks_periodically(); });
+  }
+  char host_name[256]{0};
+  gethostname(host_name, sizeof(host_name) - 1);
+  tracing::Tracer::get().init(
+      (boost::filesystem::path(base_data_path_) / "mapd_log" / "traces.jsonl").string(),
+      g_trace_sample_rate,
+      std::string(host_name) + ":" + std::to_string(mapd_parameters_.mapd_server_port));
+  if (g_slow_query_threshold_ms >= 0) {
+    slow_query_log_.reset(new SlowQueryLog(
+        (boost::filesystem::path(base_data_path_) / "mapd_log" / "slow_queries.tsv")
+            .string()));
+  }
 }
 
 MapDHandler::~MapDHandler() {
+  if (vacuum_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(vacuum_mutex_);
+      stop_vacuum_ = true;
+    }
+    vacuum_cv_.notify_all();
+    vacuum_thread_.join();
+  }
+  if (hot_chunks_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(hot_chunks_mutex_);
+      stop_hot_chunks_ = true;
+    }
+    hot_chunks_cv_.notify_all();
+    hot_chunks_thread_.join();
+    save_hot_chunks();
+  }
+  {
+    std::lock_guard<std::mutex> lock(async_queries_mutex_);
+    stop_async_queries_ = true;
+  }
+  async_queries_cv_.notify_all();
+  for (auto& async_query_thread : async_query_threads_) {
+    async_query_thread.join();
+  }
   LOG(INFO) << "mapd_server exits." << std::endl;
 }
 
+// Rewrites the fragments of the tables of the databases in use once enough of their
+// rows got deleted, taking the same locks as OPTIMIZE TABLE.
+void MapDHandler::vacuum_deleted_rows_periodically() {
+  const auto interval = std::chrono::seconds(g_vacuum_interval_secs);
+  std::unique_lock<std::mutex> lock(vacuum_mutex_);
+  while (!vacuum_cv_.wait_for(lock, interval, [this] { return stop_vacuum_; })) {
+    lock.unlock();
+    for (const auto& db : SysCatalog::instance().getAllDBMetadata()) {
+      const auto cat = Catalog::get(db.dbName);
+      if (!cat) {
+        continue;
+      }
+      std::vector<std::string> table_names;
+      for (const auto td : cat->getAllTableMetadata()) {
+        if (!td->isView && cat->getLogicalTableId(td->tableId) == td->tableId) {
+          table_names.push_back(td->tableName);
+        }
+      }
+      for (const auto& table_name : table_names) {
+        try {
+          auto chkpt_lock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+              *cat, table_name, LockType::CheckpointLock);
+          auto upddel_lock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+              *cat, table_name, LockType::UpdateDeleteLock);
+          const auto td = cat->getMetadataForTable(table_name);
+          if (td && cat->getDeletedColumnIfRowsDeleted(td)) {
+            cat->vacuumDeletedRows(td, g_vacuum_min_deleted_fraction);
+          }
+        } catch (const std::exception& e) {
+          LOG(WARNING) << "Could not vacuum table " << table_name << ": " << e.what();
+        }
+      }
+    }
+    lock.lock();
+  }
+}
+
+// Loads the chunks which were resident in the buffer pools before the restart, the most
+// touched first, then records the resident chunks every interval.
+void MapDHandler::prefetch_and_save_hot_chunks_periodically() {
+  prefetch_hot_chunks();
+  const auto interval = std::chrono::seconds(g_hot_chunks_save_interval_secs);
+  std::unique_lock<std::mutex> lock(hot_chunks_mutex_);
+  while (!hot_chunks_cv_.wait_for(lock, interval, [this] { return stop_hot_chunks_; })) {
+    lock.unlock();
+    save_hot_chunks();
+    lock.lock();
+  }
+}
+
+std::string MapDHandler::hot_chunks_file_path() const {
+  return (boost::filesystem::path(base_data_path_) / "mapd_hot_chunks").string();
+}
+
+// One chunk per line, the memory level, the device, the touch count and the chunk key.
+void MapDHandler::save_hot_chunks() {
+  // Until they're prefetched, the resident chunks are a fraction of the recorded ones.
+  if (!hot_chunks_prefetched_) {
+    return;
+  }
+  std::lock_guard<std::mutex> save_lock(hot_chunks_save_mutex_);
+  const auto file_path = hot_chunks_file_path();
+  const auto tmp_file_path = file_path + ".tmp";
+  try {
+    {
+      std::ofstream hot_chunks_file(tmp_file_path, std::ios::trunc);
+      for (const auto& chunk : data_mgr_->getHotChunks()) {
+        hot_chunks_file << static_cast<int>(chunk.memLevel) << ' ' << chunk.deviceId
+                        << ' ' << chunk.touchCount;
+        for (const auto key_part : chunk.key) {
+          hot_chunks_file << ' ' << key_part;
+        }
+        hot_chunks_file << '\n';
+      }
+      if (!hot_chunks_file) {
+        throw std::runtime_error("write failed");
+      }
+    }
+    boost::filesystem::rename(tmp_file_path, file_path);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Could not save the hot chunks to " << file_path << ": " << e.what();
+  }
+}
+
+// Prefetches within --hot-chunks-prefetch-mb-per-sec, so that the queries which run
+// meanwhile still get most of the disk bandwidth.
+void MapDHandler::prefetch_hot_chunks() {
+  std::ifstream hot_chunks_file(hot_chunks_file_path());
+  if (!hot_chunks_file) {
+    hot_chunks_prefetched_ = true;
+    return;
+  }
+  std::vector<Data_Namespace::HotChunk> hot_chunks;
+  std::string line;
+  while (std::getline(hot_chunks_file, line)) {
+    std::istringstream line_stream(line);
+    int mem_level{0};
+    Data_Namespace::HotChunk chunk;
+    line_stream >> mem_level >> chunk.deviceId >> chunk.touchCount;
+    chunk.memLevel = static_cast<Data_Namespace::MemoryLevel>(mem_level);
+    int key_part{0};
+    while (line_stream >> key_part) {
+      chunk.key.push_back(key_part);
+    }
+    if (chunk.key.size() >= 4 && chunk.memLevel != Data_Namespace::DISK_LEVEL) {
+      hot_chunks.push_back(chunk);
+    }
+  }
+  std::map<int, Catalog_Namespace::DBMetadata> dbs_by_id;
+  for (const auto& db : SysCatalog::instance().getAllDBMetadata()) {
+    dbs_by_id.emplace(db.dbId, db);
+  }
+  const auto bytes_per_sec = std::max(g_hot_chunks_prefetch_mb_per_sec, size_t(1)) << 20;
+  const auto start = std::chrono::steady_clock::now();
+  size_t prefetched_bytes{0};
+  size_t prefetched_chunks{0};
+  for (const auto& chunk : hot_chunks) {
+    {
+      const auto due =
+          start + std::chrono::microseconds(prefetched_bytes * 1000000 / bytes_per_sec);
+      std::unique_lock<std::mutex> lock(hot_chunks_mutex_);
+      if (hot_chunks_cv_.wait_until(lock, due, [this] { return stop_hot_chunks_; })) {
+        return;
+      }
+    }
+    const auto db_it = dbs_by_id.find(chunk.key[0]);
+    if (db_it == dbs_by_id.end()) {
+      continue;
+    }
+    try {
+      const auto cat = SysCatalog::instance().getCatalog(db_it->second);
+      const auto td = cat->getMetadataForTable(chunk.key[1]);
+      if (!td || td->isView) {
+        continue;
+      }
+      // Like a query, so that the table can't be dropped or truncated meanwhile.
+      auto upddel_lock = getTableLock<mapd_shared_mutex, mapd_shared_lock>(
+          *cat, td->tableName, LockType::UpdateDeleteLock);
+      const auto bytes =
+          data_mgr_->prefetchChunk(chunk.key, chunk.memLevel, chunk.deviceId);
+      if (bytes) {
+        prefetched_bytes += bytes;
+        ++prefetched_chunks;
+      }
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "Could not prefetch a chunk of table " << chunk.key[1] << ": "
+                   << e.what();
+    }
+  }
+  LOG(INFO) << "Prefetched " << prefetched_chunks << " hot chunks, " << prefetched_bytes
+            << " bytes";
+  hot_chunks_prefetched_ = true;
+}
+
 void MapDHandler::check_read_only(const std::string& str) {
   if (MapDHandler::read_only_) {
     THROW_MAPD_EXCEPTION(str + " disabled: server running in read-only mode.");
   }
 }
 
+// Folds the rows just loaded into the materialized views of the database and analyzes
+// again the tables whose statistics are stale. A failed refresh leaves the views or the
+// statistics behind until the next one, it doesn't fail the load.
+void MapDHandler::refresh_after_load(const Catalog_Namespace::SessionInfo& session_info) {
+  try {
+    Parser::RefreshMaterializedViewStmt::refreshAll(session_info);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Materialized view refresh failed: " << e.what();
+  }
+  try {
+    Parser::AnalyzeTableStmt::analyzeStale(session_info);
+  } catch (const std::exception& e) {
+    LOG(WARNING) << "Table statistics refresh failed: " << e.what();
+  }
+}
+
 std::string generate_random_string(const size_t len) {
   static char charset[] =
       "0123456789"
@@ -268,7 +500,6 @@ std::string generate_random_string(const size_t len) {
 void MapDHandler::internal_connect(TSessionId& session,
                                    const std::string& user,
                                    const std::string& dbname) {
-  mapd_lock_guard<mapd_shared_mutex> write_lock(sessions_mutex_);
   Catalog_Namespace::UserMetadata user_meta;
   if (!SysCatalog::instance().getMetadataForUser(user, user_meta)) {
     THROW_MAPD_EXCEPTION(std::string("User ") + user + " does not exist.");
@@ -298,7 +529,8 @@ void MapDHandler::connect(TSessionId& session,
                           const std::string& user,
                           const std::string& passwd,
                           const std::string& dbname) {
-  mapd_lock_guard<mapd_shared_mutex> write_lock(sessions_mutex_);
+  // The login and the privilege checks run without the session lock, only the insert
+  // of the new session blocks the lookups of the calls of the other sessions.
   Catalog_Namespace::UserMetadata user_meta;
   std::shared_ptr<Catalog> cat = nullptr;
   try {
@@ -330,6 +562,7 @@ void MapDHandler::connectImpl(TSessionId& session,
                               const std::string& dbname,
                               Catalog_Namespace::UserMetadata& user_meta,
                               std::shared_ptr<Catalog> cat) {
+  mapd_lock_guard<mapd_shared_mutex> write_lock(sessions_mutex_);
   session = INVALID_SESSION_ID;
   while (true) {
     session = generate_random_string(32);
@@ -365,38 +598,53 @@ void MapDHandler::disconnect(const TSessionId& session) {
   LOG(INFO) << "User " << session_it->second->get_currentUser().userName
             << " disconnected from database " << dbname << std::endl;
   sessions_.erase(session_it);
+  std::lock_guard<std::mutex> cursors_lock(df_cursors_mutex_);
+  for (auto it = df_cursors_.begin(); it != df_cursors_.end();) {
+    if (it->second->session == session) {
+      release_df_cursor(*it->second);
+      it = df_cursors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::lock_guard<std::mutex> row_cursors_lock(row_cursors_mutex_);
+  for (auto it = row_cursors_.begin(); it != row_cursors_.end();) {
+    if (it->second->session == session) {
+      it = row_cursors_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void MapDHandler::interrupt(const TSessionId& session) {
-  if (g_enable_dynamic_watchdog) {
-    // Shared lock to allow simultaneous interrupts of multiple sessions
-    mapd_shared_lock<mapd_shared_mutex> read_lock(sessions_mutex_);
-    if (leaf_aggregator_.leafCount() > 0) {
-      leaf_aggregator_.interrupt(session);
-    }
-    auto session_it = get_session_it(session);
-    const auto dbname = session_it->second->get_catalog().get_currentDB().dbName;
-    auto session_info_ptr = session_it->second.get();
-    auto& cat = session_info_ptr->get_catalog();
-    auto executor = Executor::getExecutor(cat.get_currentDB().dbId,
-                                          jit_debug_ ? "/tmp" : "",
-                                          jit_debug_ ? "mapdquery" : "",
-                                          mapd_parameters_,
-                                          nullptr);
-    CHECK(executor);
+  // Shared lock to allow simultaneous interrupts of multiple sessions
+  mapd_shared_lock<mapd_shared_mutex> read_lock(sessions_mutex_);
+  if (leaf_aggregator_.leafCount() > 0) {
+    leaf_aggregator_.interrupt(session);
+  }
+  auto session_it = get_session_it(session);
+  const auto dbname = session_it->second->get_catalog().get_currentDB().dbName;
+  auto session_info_ptr = session_it->second.get();
+  auto& cat = session_info_ptr->get_catalog();
+  auto executor = Executor::getExecutor(cat.get_currentDB().dbId,
+                                        jit_debug_ ? "/tmp" : "",
+                                        jit_debug_ ? "mapdquery" : "",
+                                        mapd_parameters_,
+                                        nullptr);
+  CHECK(executor);
 
-    VLOG(1) << "Received interrupt: "
-            << "Session " << session_it->second->get_currentUser().userName << "_"
-            << session.substr(0, 3) << ", Executor " << executor << ", leafCount "
-            << leaf_aggregator_.leafCount() << ", User "
-            << session_it->second->get_currentUser().userName << ", Database " << dbname
-            << std::endl;
+  VLOG(1) << "Received interrupt: "
+          << "Session " << session_it->second->get_currentUser().userName << "_"
+          << session.substr(0, 3) << ", Executor " << executor << ", leafCount "
+          << leaf_aggregator_.leafCount() << ", User "
+          << session_it->second->get_currentUser().userName << ", Database " << dbname
+          << std::endl;
 
-    executor->interrupt();
+  executor->interrupt();
 
-    LOG(INFO) << "User " << session_it->second->get_currentUser().userName
-              << " interrupted session with database " << dbname << std::endl;
-  }
+  LOG(INFO) << "User " << session_it->second->get_currentUser().userName
+            << " interrupted session with database " << dbname << std::endl;
 }
 
 void MapDHandler::get_server_status(TServerStatus& _return, const TSessionId& session) {
@@ -709,6 +957,11 @@ void MapDHandler::sql_execute(TQueryResult& _return,
       THROW_MAPD_EXCEPTION("Distributed support is disabled.");
     }
     _return.total_time_ms = measure<>::execution([&]() {
+      // The aggregator passes the context on to the leaves, in TPendingQuery.
+      tracing::Span query_span("cluster_execute", tracing::Span::newTrace());
+      if (query_span.sampled()) {
+        query_span.addAttribute("db.statement", SlowQueryLog::normalizeQuery(query_str));
+      }
       try {
         agg_handler_->cluster_execute(
             _return, session_info, query_str, column_format, nonce, first_n, at_most_n);
@@ -734,7 +987,14 @@ void MapDHandler::sql_execute(TQueryResult& _return,
     });
     LOG(INFO) << "sql_execute-COMPLETED Total: " << _return.total_time_ms
               << " (ms), Execution: " << _return.execution_time_ms << " (ms)";
+    ParserWrapper pw{query_str};
+    if (pw.is_update_dml || (pw.is_copy && !pw.is_copy_to)) {
+      refresh_after_load(session_info);
+    }
   }
+  static auto& query_latency_ms = metrics::Registry::get().histogram(
+      "mapd_query_latency_ms", "Total time of the sql_execute calls");
+  query_latency_ms.observe(_return.total_time_ms);
 
   // if the SQL statement we just executed was a geo COPY FROM, the import
   // parameters were captured, and this flag set, so we do the actual import here
@@ -864,6 +1124,477 @@ void MapDHandler::deallocate_df(const TSessionId& session,
       data_mgr_.get());
 }
 
+int64_t MapDHandler::sql_execute_df_cursor(const TSessionId& session,
+                                           const std::string& query_str,
+                                           const int32_t batch_entry_count) {
+  const auto session_info = MapDHandler::get_session(session);
+  if (batch_entry_count <= 0) {
+    THROW_MAPD_EXCEPTION("Exception: the batch entry count must be positive");
+  }
+  LOG(INFO) << hide_sensitive_data(query_str);
+  auto cursor = std::make_shared<DataFrameCursor>();
+  try {
+    const auto result = execute_cursor_query(session_info, query_str);
+    cursor->session = session;
+    cursor->rows = result.getRows();
+    cursor->col_names = getTargetNames(result.getTargetsMeta());
+    cursor->batch_entry_count = batch_entry_count;
+    cursor->next_entry = 0;
+  } catch (std::exception& e) {
+    THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+  }
+  prefetch_df_batch(*cursor);
+  std::lock_guard<std::mutex> cursors_lock(df_cursors_mutex_);
+  const auto cursor_id = next_df_cursor_id_++;
+  df_cursors_.emplace(cursor_id, cursor);
+  return cursor_id;
+}
+
+void MapDHandler::fetch_df_batch(TDataFrame& _return,
+                                 const TSessionId& session,
+                                 const int64_t cursor_id) {
+  get_session(session);
+  std::shared_ptr<DataFrameCursor> cursor;
+  {
+    std::lock_guard<std::mutex> cursors_lock(df_cursors_mutex_);
+    const auto it = df_cursors_.find(cursor_id);
+    if (it == df_cursors_.end() || it->second->session != session) {
+      THROW_MAPD_EXCEPTION("Exception: invalid data frame cursor " +
+                           std::to_string(cursor_id));
+    }
+    cursor = it->second;
+  }
+  std::lock_guard<std::mutex> cursor_lock(cursor->mutex);
+  if (!cursor->next_batch.valid()) {
+    return;
+  }
+  ArrowResult batch;
+  try {
+    batch = cursor->next_batch.get();
+  } catch (std::exception& e) {
+    THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+  }
+  prefetch_df_batch(*cursor);
+  _return.sm_handle = std::string(batch.sm_handle.begin(), batch.sm_handle.end());
+  _return.sm_size = batch.sm_size;
+  _return.df_handle = std::string(batch.df_handle.begin(), batch.df_handle.end());
+  _return.df_size = batch.df_size;
+}
+
+void MapDHandler::close_df_cursor(const TSessionId& session, const int64_t cursor_id) {
+  get_session(session);
+  std::lock_guard<std::mutex> cursors_lock(df_cursors_mutex_);
+  const auto it = df_cursors_.find(cursor_id);
+  if (it == df_cursors_.end() || it->second->session != session) {
+    THROW_MAPD_EXCEPTION("Exception: invalid data frame cursor " +
+                         std::to_string(cursor_id));
+  }
+  release_df_cursor(*it->second);
+  df_cursors_.erase(it);
+}
+
+int64_t MapDHandler::sql_execute_cursor(const TSessionId& session,
+                                        const std::string& query_str,
+                                        const int32_t first_n,
+                                        const int32_t at_most_n) {
+  const auto session_info = MapDHandler::get_session(session);
+  if (first_n >= 0 && at_most_n >= 0) {
+    THROW_MAPD_EXCEPTION(std::string("At most one of first_n and at_most_n can be set"));
+  }
+  LOG(INFO) << hide_sensitive_data(query_str);
+  auto cursor = std::make_shared<RowCursor>();
+  try {
+    const auto result = execute_cursor_query(session_info, query_str);
+    cursor->session = session;
+    cursor->rows = result.getRows();
+    cursor->targets = result.getTargetsMeta();
+    cursor->remaining = first_n >= 0 ? static_cast<size_t>(first_n)
+                                     : std::numeric_limits<size_t>::max();
+  } catch (std::exception& e) {
+    THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+  }
+  // Checked up front rather than failing after some pages have been delivered.
+  if (at_most_n >= 0 && cursor->rows->rowCount() > static_cast<size_t>(at_most_n)) {
+    THROW_MAPD_EXCEPTION("The result contains more rows than the specified cap of " +
+                         std::to_string(at_most_n));
+  }
+  std::lock_guard<std::mutex> cursors_lock(row_cursors_mutex_);
+  const auto cursor_id = next_row_cursor_id_++;
+  row_cursors_.emplace(cursor_id, cursor);
+  return cursor_id;
+}
+
+void MapDHandler::fetch_rows(TQueryResult& _return,
+                             const TSessionId& session,
+                             const int64_t cursor_id,
+                             const bool column_format,
+                             const int32_t max_rows) {
+  get_session(session);
+  if (max_rows <= 0) {
+    THROW_MAPD_EXCEPTION("Exception: the number of rows to fetch must be positive");
+  }
+  std::shared_ptr<RowCursor> cursor;
+  {
+    std::lock_guard<std::mutex> cursors_lock(row_cursors_mutex_);
+    const auto it = row_cursors_.find(cursor_id);
+    if (it == row_cursors_.end() || it->second->session != session) {
+      THROW_MAPD_EXCEPTION("Exception: invalid cursor " + std::to_string(cursor_id));
+    }
+    cursor = it->second;
+  }
+  std::lock_guard<std::mutex> cursor_lock(cursor->mutex);
+  _return.row_set.is_columnar = column_format;
+  if (!cursor->rows) {
+    return;
+  }
+  const auto page_rows = std::min(cursor->remaining, static_cast<size_t>(max_rows));
+  _return.execution_time_ms += measure<>::execution([&]() {
+    convert_rows(_return,
+                 cursor->targets,
+                 *cursor->rows,
+                 column_format,
+                 static_cast<int32_t>(page_rows),
+                 -1);
+  });
+  const size_t fetched =
+      column_format ? (_return.row_set.columns.empty()
+                           ? 0
+                           : _return.row_set.columns.front().nulls.size())
+                    : _return.row_set.rows.size();
+  CHECK_LE(fetched, cursor->remaining);
+  cursor->remaining -= fetched;
+  if (fetched < page_rows || !cursor->remaining) {
+    cursor->rows.reset();
+  }
+}
+
+void MapDHandler::close_cursor(const TSessionId& session, const int64_t cursor_id) {
+  get_session(session);
+  std::lock_guard<std::mutex> cursors_lock(row_cursors_mutex_);
+  const auto it = row_cursors_.find(cursor_id);
+  if (it == row_cursors_.end() || it->second->session != session) {
+    THROW_MAPD_EXCEPTION("Exception: invalid cursor " + std::to_string(cursor_id));
+  }
+  row_cursors_.erase(it);
+}
+
+// The threads are started by the first submission, a server thread is only held for
+// the submission itself.
+int64_t MapDHandler::sql_submit(const TSessionId& session, const std::string& query_str) {
+  get_session(session);
+  LOG(INFO) << "sql_submit :" << hide_sensitive_data(query_str);
+  auto query = std::make_shared<AsyncQuery>();
+  query->session = session;
+  query->query_str = query_str;
+  query->state = TQueryState::QUEUED;
+  query->submit_time = std::chrono::steady_clock::now();
+  query->execution_time_ms = 0;
+  int64_t query_id;
+  {
+    std::lock_guard<std::mutex> lock(async_queries_mutex_);
+    if (async_query_threads_.empty()) {
+      for (size_t i = 0; i < std::max(g_async_query_threads, size_t(1)); ++i) {
+        async_query_threads_.emplace_back([this] { run_async_queries(); });
+      }
+    }
+    query_id = next_async_query_id_++;
+    async_queries_.emplace(query_id, query);
+    queued_async_queries_.push_back(query_id);
+  }
+  async_queries_cv_.notify_one();
+  return query_id;
+}
+
+void MapDHandler::run_async_queries() {
+  std::unique_lock<std::mutex> lock(async_queries_mutex_);
+  while (true) {
+    async_queries_cv_.wait(lock, [this] {
+      return stop_async_queries_ || !queued_async_queries_.empty();
+    });
+    if (stop_async_queries_) {
+      return;
+    }
+    const auto query_id = queued_async_queries_.front();
+    queued_async_queries_.pop_front();
+    const auto it = async_queries_.find(query_id);
+    if (it == async_queries_.end()) {
+      continue;
+    }
+    const auto query = it->second;
+    query->state = TQueryState::RUNNING;
+    lock.unlock();
+    std::shared_ptr<ResultSet> rows;
+    std::vector<TargetMetaInfo> targets;
+    std::string error_msg;
+    const auto clock_begin = timer_start();
+    try {
+      const auto result =
+          execute_cursor_query(get_session(query->session), query->query_str);
+      rows = result.getRows();
+      targets = result.getTargetsMeta();
+    } catch (const TMapDException& e) {
+      error_msg = e.error_msg;
+    } catch (const std::exception& e) {
+      error_msg = std::string("Exception: ") + e.what();
+    }
+    const auto execution_time_ms = timer_stop(clock_begin);
+    lock.lock();
+    // Canceled while running, the result is dropped here.
+    if (!async_queries_.count(query_id)) {
+      continue;
+    }
+    query->state = error_msg.empty() ? TQueryState::FINISHED : TQueryState::FAILED;
+    query->end_time = std::chrono::steady_clock::now();
+    query->execution_time_ms = execution_time_ms;
+    query->error_msg = error_msg;
+    query->rows = rows;
+    query->targets = targets;
+  }
+}
+
+std::shared_ptr<MapDHandler::AsyncQuery> MapDHandler::get_async_query(
+    const TSessionId& session,
+    const int64_t query_id) {
+  const auto it = async_queries_.find(query_id);
+  if (it == async_queries_.end() || it->second->session != session) {
+    THROW_MAPD_EXCEPTION("Exception: invalid query " + std::to_string(query_id));
+  }
+  return it->second;
+}
+
+void MapDHandler::get_query_status(TQueryStatus& _return,
+                                   const TSessionId& session,
+                                   const int64_t query_id) {
+  get_session(session);
+  std::lock_guard<std::mutex> lock(async_queries_mutex_);
+  const auto query = get_async_query(session, query_id);
+  const auto done =
+      query->state == TQueryState::FINISHED || query->state == TQueryState::FAILED;
+  _return.state = query->state;
+  _return.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           (done ? query->end_time : std::chrono::steady_clock::now()) -
+                           query->submit_time)
+                           .count();
+  _return.execution_time_ms = query->execution_time_ms;
+  _return.error_msg = query->error_msg;
+}
+
+void MapDHandler::fetch_query_result(TQueryResult& _return,
+                                     const TSessionId& session,
+                                     const int64_t query_id,
+                                     const bool column_format,
+                                     const int32_t first_n) {
+  get_session(session);
+  std::shared_ptr<AsyncQuery> query;
+  {
+    std::lock_guard<std::mutex> lock(async_queries_mutex_);
+    query = get_async_query(session, query_id);
+    if (query->state == TQueryState::QUEUED || query->state == TQueryState::RUNNING) {
+      THROW_MAPD_EXCEPTION("Exception: query " + std::to_string(query_id) +
+                           " hasn't finished yet");
+    }
+    async_queries_.erase(query_id);
+  }
+  if (query->state == TQueryState::FAILED) {
+    THROW_MAPD_EXCEPTION(query->error_msg);
+  }
+  _return.execution_time_ms = query->execution_time_ms;
+  _return.total_time_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(query->end_time -
+                                                            query->submit_time)
+          .count();
+  _return.total_time_ms += measure<>::execution([&]() {
+    convert_rows(_return, query->targets, *query->rows, column_format, first_n, -1);
+  });
+}
+
+// A running query isn't stopped, interrupt does that.
+void MapDHandler::cancel_query(const TSessionId& session, const int64_t query_id) {
+  get_session(session);
+  std::lock_guard<std::mutex> lock(async_queries_mutex_);
+  get_async_query(session, query_id);
+  async_queries_.erase(query_id);
+}
+
+// Encodes the result set into the compact columns directly, without the Thrift value
+// and null flag per row of convert_rows.
+void MapDHandler::sql_execute_compact(TCompactResult& _return,
+                                      const TSessionId& session,
+                                      const std::string& query_str,
+                                      const std::string& nonce,
+                                      const int32_t first_n,
+                                      const int32_t at_most_n,
+                                      const bool delta_encode) {
+  const auto session_info = MapDHandler::get_session(session);
+  if (first_n >= 0 && at_most_n >= 0) {
+    THROW_MAPD_EXCEPTION(std::string("At most one of first_n and at_most_n can be set"));
+  }
+  LOG(INFO) << hide_sensitive_data(query_str);
+  _return.total_time_ms = measure<>::execution([&]() {
+    try {
+      const auto clock_begin = timer_start();
+      const auto result = execute_cursor_query(session_info, query_str);
+      _return.execution_time_ms = timer_stop(clock_begin);
+      const auto& targets = result.getTargetsMeta();
+      const auto& rows = result.getRows();
+      if (at_most_n >= 0 && rows->rowCount() > static_cast<size_t>(at_most_n)) {
+        throw std::runtime_error(
+            "The result contains more rows than the specified cap of " +
+            std::to_string(at_most_n));
+      }
+      _return.row_desc = convert_target_metainfo(targets);
+      std::vector<CompactColumnEncoder> encoders;
+      for (const auto& target : targets) {
+        encoders.emplace_back(target.get_type_info(), delta_encode);
+      }
+      int64_t fetched{0};
+      while (first_n < 0 || fetched < first_n) {
+        const auto crt_row = rows->getNextRow(true, true);
+        if (crt_row.empty()) {
+          break;
+        }
+        for (size_t i = 0; i < encoders.size(); ++i) {
+          encoders[i].append(crt_row[i]);
+        }
+        ++fetched;
+      }
+      _return.row_count = fetched;
+      for (auto& encoder : encoders) {
+        _return.columns.push_back(encoder.finalize());
+      }
+    } catch (std::exception& e) {
+      THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+    }
+  });
+  _return.nonce = nonce;
+  LOG(INFO) << "sql_execute_compact-COMPLETED Total: " << _return.total_time_ms
+            << " (ms), Execution: " << _return.execution_time_ms << " (ms)";
+}
+
+// The queries of a batch wait for the executor together: the aggregates over the same
+// table can share a scan and the interactive ones overtake the heavy ones.
+void MapDHandler::sql_execute_batch(std::vector<TBatchQueryResult>& _return,
+                                    const TSessionId& session,
+                                    const std::vector<std::string>& queries,
+                                    const bool column_format,
+                                    const std::string& nonce,
+                                    const int32_t first_n) {
+  const auto session_info = MapDHandler::get_session(session);
+  LOG(INFO) << "sql_execute_batch :" << session_info.get_currentUser().userName << "_"
+            << session.substr(0, 3) << " :queries:" << queries.size();
+  _return.resize(queries.size());
+  // A chart shown more than once is only executed once.
+  std::vector<size_t> first_occurrence(queries.size());
+  std::vector<size_t> distinct_queries;
+  std::unordered_map<std::string, size_t> query_index;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    first_occurrence[i] = query_index.emplace(queries[i], i).first->second;
+    if (first_occurrence[i] == i) {
+      distinct_queries.push_back(i);
+    }
+  }
+  const auto execute_query = [&](const size_t i) {
+    auto& result = _return[i];
+    try {
+      ParserWrapper pw{queries[i]};
+      if (pw.is_ddl || pw.is_update_dml || pw.is_copy || pw.is_other_explain) {
+        throw std::runtime_error("only queries can be executed in a batch");
+      }
+      if (leaf_aggregator_.leafCount() > 0) {
+        sql_execute(
+            result.result, session, queries[i], column_format, nonce, first_n, -1);
+        return;
+      }
+      result.result.total_time_ms = measure<>::execution([&]() {
+        sql_execute_impl(result.result,
+                         session_info,
+                         queries[i],
+                         column_format,
+                         nonce,
+                         session_info.get_executor_device_type(),
+                         first_n,
+                         -1);
+      });
+    } catch (const TMapDException& e) {
+      result.error_msg = e.error_msg;
+    } catch (const std::exception& e) {
+      result.error_msg = std::string("Exception: ") + e.what();
+    }
+  };
+  const auto worker_count =
+      std::min(distinct_queries.size(),
+               std::max(size_t(1), size_t(std::thread::hardware_concurrency())));
+  std::atomic<size_t> next_query{0};
+  std::vector<std::future<void>> workers;
+  for (size_t i = 0; i < worker_count; ++i) {
+    workers.push_back(std::async(std::launch::async, [&] {
+      for (auto j = next_query++; j < distinct_queries.size(); j = next_query++) {
+        execute_query(distinct_queries[j]);
+      }
+    }));
+  }
+  for (auto& worker : workers) {
+    worker.get();
+  }
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (first_occurrence[i] != i) {
+      _return[i] = _return[first_occurrence[i]];
+    }
+  }
+  LOG(INFO) << "sql_execute_batch-COMPLETED queries: " << queries.size()
+            << ", distinct: " << distinct_queries.size();
+}
+
+// The locks are only held for the execution, the cursors convert the result set to the
+// client format afterwards.
+ExecutionResult MapDHandler::execute_cursor_query(
+    const Catalog_Namespace::SessionInfo& session_info,
+    const std::string& query_str) {
+  ParserWrapper pw{query_str};
+  if (pw.is_ddl || pw.is_update_dml || pw.is_other_explain ||
+      pw.is_select_calcite_explain) {
+    throw std::runtime_error("only queries can be delivered through a cursor");
+  }
+  std::map<std::string, bool> tableNames;
+  const auto query_ra = parse_to_ra(query_str, {}, session_info, &tableNames);
+  mapd_shared_lock<mapd_shared_mutex> executeReadLock(
+      *LockMgr<mapd_shared_mutex, bool>::getMutex(ExecutorOuterLock, true));
+  std::vector<std::shared_ptr<VLock>> upddelLocks;
+  getTableLocks<mapd_shared_mutex>(
+      session_info.get_catalog(), tableNames, upddelLocks, LockType::UpdateDeleteLock);
+  return execute_rel_alg_result(query_ra, session_info, ExecutorDeviceType::CPU);
+}
+
+void MapDHandler::prefetch_df_batch(DataFrameCursor& cursor) {
+  const auto first_entry = cursor.next_entry;
+  if (first_entry >= cursor.rows->entryCount()) {
+    return;
+  }
+  cursor.next_entry += cursor.batch_entry_count;
+  cursor.next_batch = std::async(std::launch::async,
+                                 [rows = cursor.rows,
+                                  col_names = cursor.col_names,
+                                  first_entry,
+                                  entry_count = cursor.batch_entry_count] {
+                                   return rows->getArrowCopyOfEntries(
+                                       col_names, first_entry, entry_count);
+                                 });
+}
+
+// The batch being converted hasn't been handed to the client, it's freed here.
+void MapDHandler::release_df_cursor(DataFrameCursor& cursor) {
+  std::lock_guard<std::mutex> cursor_lock(cursor.mutex);
+  if (!cursor.next_batch.valid()) {
+    return;
+  }
+  try {
+    deallocate_arrow_result(
+        cursor.next_batch.get(), ExecutorDeviceType::CPU, 0, data_mgr_.get());
+  } catch (std::exception& e) {
+    LOG(WARNING) << "Failed to release a data frame batch: " << e.what();
+  }
+}
+
 std::string MapDHandler::apply_copy_to_shim(const std::string& query_str) {
   auto result = query_str;
   {
@@ -1832,6 +2563,9 @@ void MapDHandler::get_version(std::string& version) {
 
 void MapDHandler::clear_gpu_memory(const TSessionId& session) {
   const auto session_info = get_session(session);
+  Executor::clearGpuStringDictionaries();
+  // The cached IN list hash sets pin their copies on the devices.
+  InValuesHashSet::yieldCacheInvalidator()();
   SysCatalog::instance().get_dataMgr().clearMemory(MemoryLevel::GPU_LEVEL);
   if (render_handler_) {
     render_handler_->clear_gpu_memory();
@@ -1842,8 +2576,25 @@ void MapDHandler::clear_gpu_memory(const TSessionId& session) {
   }
 }
 
+int64_t MapDHandler::compact_memory(const TSessionId& session,
+                                    const std::string& memory_level) {
+  const auto session_info = get_session(session);
+  const auto mem_level = memory_level == "gpu" ? MemoryLevel::GPU_LEVEL
+                                               : MemoryLevel::CPU_LEVEL;
+  return SysCatalog::instance().get_dataMgr().compactMemory(mem_level);
+}
+
 void MapDHandler::clear_cpu_memory(const TSessionId& session) {
   const auto session_info = get_session(session);
+  // The cached join hash tables and query results live outside of the buffer pool,
+  // release them as well.
+  LOG(INFO) << "Join hash table cache: " << JoinHashTable::getCacheStats();
+  LOG(INFO) << "Baseline join hash table cache: "
+            << BaselineJoinHashTable::getCacheStats();
+  LOG(INFO) << "Query result cache: " << QueryResultCache::getCacheStats();
+  LOG(INFO) << "Columnar results cache: " << ColumnarResultsCache::getCacheStats();
+  LOG(INFO) << "IN list hash set cache: " << InValuesHashSet::getCacheStats();
+  HostMemoryCacheInvalidator::invalidateCaches();
   SysCatalog::instance().get_dataMgr().clearMemory(MemoryLevel::CPU_LEVEL);
   if (render_handler_) {
     render_handler_->clear_cpu_memory();
@@ -1883,6 +2634,10 @@ void MapDHandler::get_memory(std::vector<TNodeMemoryInfo>& _return,
     nodeInfo.max_num_pages = memInfo.maxNumPages;
     nodeInfo.num_pages_allocated = memInfo.numPageAllocated;
     nodeInfo.is_allocation_capped = memInfo.isAllocationCapped;
+    nodeInfo.num_hits = memInfo.numHits;
+    nodeInfo.num_misses = memInfo.numMisses;
+    nodeInfo.num_evictions = memInfo.numEvictions;
+    nodeInfo.largest_free_pages = memInfo.largestFreePages;
     for (auto gpu : memInfo.nodeMemoryData) {
       TMemoryData md;
       md.slab = gpu.slabNum;
@@ -1902,6 +2657,151 @@ void MapDHandler::get_memory(std::vector<TNodeMemoryInfo>& _return,
   }
 }
 
+namespace {
+
+void print_buffer_pool_metrics(std::ostream& os, Data_Namespace::DataMgr& data_mgr) {
+  std::vector<std::pair<std::string, size_t>> hits, misses, evictions, bytes, used_bytes,
+      largest_free_bytes;
+  const auto print_level = [&](const MemoryLevel level, const std::string& level_name) {
+    const auto memory_infos = data_mgr.getMemoryInfo(level);
+    for (size_t device = 0; device < memory_infos.size(); ++device) {
+      const auto& memory_info = memory_infos[device];
+      const auto labels =
+          "level=\"" + level_name + "\",device=\"" + std::to_string(device) + "\"";
+      hits.emplace_back(labels, memory_info.numHits);
+      misses.emplace_back(labels, memory_info.numMisses);
+      evictions.emplace_back(labels, memory_info.numEvictions);
+      bytes.emplace_back(labels, memory_info.numPageAllocated * memory_info.pageSize);
+      size_t used_pages{0};
+      for (const auto& segment : memory_info.nodeMemoryData) {
+        if (segment.isFree != Buffer_Namespace::MemStatus::FREE) {
+          used_pages += segment.numPages;
+        }
+      }
+      used_bytes.emplace_back(labels, used_pages * memory_info.pageSize);
+      largest_free_bytes.emplace_back(
+          labels, memory_info.largestFreePages * memory_info.pageSize);
+    }
+  };
+  print_level(MemoryLevel::CPU_LEVEL, "cpu");
+  if (data_mgr.gpusPresent()) {
+    print_level(MemoryLevel::GPU_LEVEL, "gpu");
+  }
+  metrics::print_family(os,
+                        "mapd_buffer_pool_hits_total",
+                        "Chunks found in the buffer pool",
+                        "counter",
+                        hits);
+  metrics::print_family(os,
+                        "mapd_buffer_pool_misses_total",
+                        "Chunks fetched from the level below",
+                        "counter",
+                        misses);
+  metrics::print_family(os,
+                        "mapd_buffer_pool_evictions_total",
+                        "Chunks evicted to make room for others",
+                        "counter",
+                        evictions);
+  metrics::print_family(
+      os, "mapd_buffer_pool_bytes", "Bytes of the allocated slabs", "gauge", bytes);
+  metrics::print_family(os,
+                        "mapd_buffer_pool_used_bytes",
+                        "Bytes of the slabs holding buffers",
+                        "gauge",
+                        used_bytes);
+  metrics::print_family(os,
+                        "mapd_buffer_pool_largest_free_bytes",
+                        "Bytes of the largest free segment of the slabs",
+                        "gauge",
+                        largest_free_bytes);
+}
+
+void print_cache_metrics(std::ostream& os) {
+  const std::vector<std::pair<std::string, JoinHashTableCacheStats>> caches{
+      {"cache=\"join_hash_table\"", JoinHashTable::getCacheStats()},
+      {"cache=\"baseline_join_hash_table\"", BaselineJoinHashTable::getCacheStats()},
+      {"cache=\"query_result\"", QueryResultCache::getCacheStats()},
+      {"cache=\"columnar_results\"", ColumnarResultsCache::getCacheStats()}};
+  std::vector<std::pair<std::string, size_t>> hits, misses, evictions, bytes;
+  for (const auto& cache : caches) {
+    hits.emplace_back(cache.first, cache.second.hits);
+    misses.emplace_back(cache.first, cache.second.misses);
+    evictions.emplace_back(cache.first, cache.second.evictions);
+    bytes.emplace_back(cache.first, cache.second.bytes);
+  }
+  metrics::print_family(
+      os, "mapd_cache_hits_total", "Lookups served by the cache", "counter", hits);
+  metrics::print_family(
+      os, "mapd_cache_misses_total", "Lookups missed by the cache", "counter", misses);
+  metrics::print_family(os,
+                        "mapd_cache_evictions_total",
+                        "Entries evicted from the cache",
+                        "counter",
+                        evictions);
+  metrics::print_family(
+      os, "mapd_cache_bytes", "Bytes held by the cache", "gauge", bytes);
+}
+
+}  // namespace
+
+void MapDHandler::get_metrics(std::string& _return, const TSessionId& session) {
+  const auto session_info = get_session(session);
+  std::ostringstream os;
+  print_buffer_pool_metrics(os, SysCatalog::instance().get_dataMgr());
+  print_cache_metrics(os);
+  _return = os.str() + metrics::Registry::get().toPrometheusText();
+}
+
+// The records of the other users are only returned to a superuser.
+void MapDHandler::get_slow_queries(TQueryResult& _return, const TSessionId& session) {
+  const auto session_info = get_session(session);
+  if (!slow_query_log_) {
+    THROW_MAPD_EXCEPTION("The slow query log is disabled, see --slow-query-threshold-ms");
+  }
+  const auto& user = session_info.get_currentUser();
+  _return.row_set = slow_query_log_->getRecords(user.isSuper ? "" : user.userName);
+}
+
+void MapDHandler::log_slow_query(const Catalog_Namespace::SessionInfo& session_info,
+                                 const std::string& query_str,
+                                 const std::string& query_ra,
+                                 const QueryProfile& query_profile,
+                                 const std::time_t start_time,
+                                 const int64_t total_ms) {
+  if (!slow_query_log_ || total_ms < g_slow_query_threshold_ms) {
+    return;
+  }
+  SlowQueryRecord record{};
+  std::tm start_tm;
+  gmtime_r(&start_time, &start_tm);
+  char start_time_str[32];
+  std::strftime(start_time_str, sizeof(start_time_str), "%Y-%m-%d %H:%M:%S", &start_tm);
+  record.start_time = start_time_str;
+  record.user_name = session_info.get_currentUser().userName;
+  record.db_name = session_info.get_catalog().get_currentDB().dbName;
+  record.query = SlowQueryLog::normalizeQuery(query_str);
+  std::ostringstream plan_hash;
+  plan_hash << std::hex << std::hash<std::string>()(query_ra);
+  record.plan_hash = plan_hash.str();
+  const bool used_cpu = query_profile.getKernelCount(ExecutorDeviceType::CPU) > 0;
+  const bool used_gpu = query_profile.getKernelCount(ExecutorDeviceType::GPU) > 0;
+  record.device = used_cpu && used_gpu ? "CPU+GPU" : (used_gpu ? "GPU" : "CPU");
+  record.cpu_retry_reason = query_profile.getCpuRetryReason();
+  record.total_ms = total_ms;
+  record.compilation_ms =
+      query_profile.getTimeUs(QueryProfile::Phase::Compilation) / 1000;
+  record.code_cache_hits = query_profile.getCodeCacheLookups(true);
+  record.code_cache_misses = query_profile.getCodeCacheLookups(false);
+  record.rows_scanned = query_profile.getScannedRows();
+  record.fragments_total = query_profile.getFragmentCount();
+  record.fragments_skipped = query_profile.getSkippedFragmentCount();
+  record.cpu_fetched_bytes = query_profile.getFetchedBytes(ExecutorDeviceType::CPU);
+  record.gpu_fetched_bytes = query_profile.getFetchedBytes(ExecutorDeviceType::GPU);
+  record.cpu_peak_bytes = query_profile.getPeakBytes(ExecutorDeviceType::CPU);
+  record.gpu_peak_bytes = query_profile.getPeakBytes(ExecutorDeviceType::GPU);
+  slow_query_log_->add(std::move(record));
+}
+
 void MapDHandler::get_databases(std::vector<TDBInfo>& dbinfos,
                                 const TSessionId& session) {
   const auto session_info = get_session(session);
@@ -2024,6 +2924,7 @@ void MapDHandler::load_table_binary(const TSessionId& session,
     }
   }
   loader->load(import_buffers, rows.size());
+  refresh_after_load(session_info);
 }
 
 void MapDHandler::prepare_columnar_loader(
@@ -2064,7 +2965,24 @@ void MapDHandler::load_table_binary_columnar(const TSessionId& session,
                                              const std::string& table_name,
                                              const std::vector<TColumn>& cols) {
   check_read_only("load_table_binary_columnar");
+  load_columnar(session, table_name, cols, true);
+  refresh_after_load(get_session(session));
+}
+
+// Lets a streaming client load many batches and make them durable at once, with
+// checkpoint_table, instead of paying for a checkpoint on every batch.
+void MapDHandler::load_table_binary_columnar_no_checkpoint(
+    const TSessionId& session,
+    const std::string& table_name,
+    const std::vector<TColumn>& cols) {
+  check_read_only("load_table_binary_columnar_no_checkpoint");
+  load_columnar(session, table_name, cols, false);
+}
 
+void MapDHandler::load_columnar(const TSessionId& session,
+                                const std::string& table_name,
+                                const std::vector<TColumn>& cols,
+                                const bool checkpoint) {
   std::unique_ptr<Importer_NS::Loader> loader;
   std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>> import_buffers;
   const auto session_info = get_session(session);
@@ -2095,7 +3013,12 @@ void MapDHandler::load_table_binary_columnar(const TSessionId& session,
         << ". Issue at column : " << (col_idx + 1) << ". Import aborted";
     THROW_MAPD_EXCEPTION(oss.str());
   }
-  loader->load(import_buffers, numRows);
+  // The leaves checkpoint each load forwarded by the aggregator.
+  if (checkpoint || leaf_aggregator_.leafCount() > 0) {
+    loader->load(import_buffers, numRows);
+  } else {
+    loader->loadNoCheckpoint(import_buffers, numRows);
+  }
 }
 
 using RecordBatchVector = std::vector<std::shared_ptr<arrow::RecordBatch>>;
@@ -2181,6 +3104,7 @@ void MapDHandler::load_table_binary_arrow(const TSessionId& session,
     THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
   }
   loader->load(import_buffers, numRows);
+  refresh_after_load(session_info);
 }
 
 void MapDHandler::load_table(const TSessionId& session,
@@ -2287,6 +3211,7 @@ void MapDHandler::load_table(const TSessionId& session,
     }
   }
   loader->load(import_buffers, rows_completed);
+  refresh_after_load(session_info);
 }
 
 char MapDHandler::unescape_char(std::string str) {
@@ -3276,6 +4201,7 @@ void MapDHandler::create_table(const TSessionId& session,
       col_stmt.append(" ENCODING " + thrift_to_encoding_name(col.col_type));
       if (thrift_to_encoding(col.col_type.encoding) == kENCODING_DICT ||
           thrift_to_encoding(col.col_type.encoding) == kENCODING_FIXED ||
+          thrift_to_encoding(col.col_type.encoding) == kENCODING_DIFF ||
           thrift_to_encoding(col.col_type.encoding) == kENCODING_GEOINT) {
         col_stmt.append("(" + std::to_string(col.col_type.comp_param) + ")");
       }
@@ -3357,6 +4283,7 @@ void MapDHandler::import_table(const TSessionId& session,
   } catch (const std::exception& e) {
     THROW_MAPD_EXCEPTION("Exception: " + std::string(e.what()));
   }
+  refresh_after_load(session_info);
 }
 
 void MapDHandler::import_geo_table(const TSessionId& session,
@@ -3535,6 +4462,7 @@ void MapDHandler::import_geo_table(const TSessionId& session,
   } catch (const std::exception& e) {
     THROW_MAPD_EXCEPTION(std::string("import_geo_table failed: ") + e.what());
   }
+  refresh_after_load(session_info);
 }
 
 void MapDHandler::import_table_status(TImportStatus& _return,
@@ -3757,7 +4685,8 @@ std::vector<PushedDownFilterInfo> MapDHandler::execute_rel_alg(
     const bool just_explain,
     const bool just_validate,
     const bool find_push_down_candidates,
-    const bool just_calcite_explain) const {
+    const bool just_calcite_explain,
+    QueryProfile* query_profile) const {
   INJECT_TIMER(execute_rel_alg);
   const auto& cat = session_info.get_catalog();
   CompilationOptions co = {
@@ -3779,6 +4708,7 @@ std::vector<PushedDownFilterInfo> MapDHandler::execute_rel_alg(
                                         mapd_parameters_,
                                         nullptr);
   RelAlgExecutor ra_executor(executor.get(), cat);
+  ra_executor.setQueryProfile(query_profile);
   ExecutionResult result{std::make_shared<ResultSet>(std::vector<TargetInfo>{},
                                                      ExecutorDeviceType::CPU,
                                                      QueryMemoryDescriptor(),
@@ -3796,6 +4726,8 @@ std::vector<PushedDownFilterInfo> MapDHandler::execute_rel_alg(
   if (just_explain) {
     convert_explain(_return, *result.getRows(), column_format);
   } else if (!just_calcite_explain) {
+    QueryProfile::Timer conversion_timer(query_profile,
+                                         QueryProfile::Phase::ResultConversion);
     convert_rows(_return,
                  result.getTargetsMeta(),
                  *result.getRows(),
@@ -3812,6 +4744,28 @@ void MapDHandler::execute_rel_alg_df(TDataFrame& _return,
                                      const ExecutorDeviceType device_type,
                                      const size_t device_id,
                                      const int32_t first_n) const {
+  const auto result = execute_rel_alg_result(query_ra, session_info, device_type);
+  const auto rs = result.getRows();
+  const auto copy = rs->getArrowCopy(data_mgr_.get(),
+                                     device_type,
+                                     device_id,
+                                     getTargetNames(result.getTargetsMeta()),
+                                     first_n);
+  _return.sm_handle = std::string(copy.sm_handle.begin(), copy.sm_handle.end());
+  _return.sm_size = copy.sm_size;
+  _return.df_handle = std::string(copy.df_handle.begin(), copy.df_handle.end());
+  if (device_type == ExecutorDeviceType::GPU) {
+    std::lock_guard<std::mutex> map_lock(handle_to_dev_ptr_mutex_);
+    CHECK(!ipc_handle_to_dev_ptr_.count(_return.df_handle));
+    ipc_handle_to_dev_ptr_.insert(std::make_pair(_return.df_handle, copy.df_dev_ptr));
+  }
+  _return.df_size = copy.df_size;
+}
+
+ExecutionResult MapDHandler::execute_rel_alg_result(
+    const std::string& query_ra,
+    const Catalog_Namespace::SessionInfo& session_info,
+    const ExecutorDeviceType device_type) const {
   const auto& cat = session_info.get_catalog();
   CHECK(device_type == ExecutorDeviceType::CPU ||
         session_info.get_executor_device_type() == ExecutorDeviceType::GPU);
@@ -3833,22 +4787,7 @@ void MapDHandler::execute_rel_alg_df(TDataFrame& _return,
                                         mapd_parameters_,
                                         nullptr);
   RelAlgExecutor ra_executor(executor.get(), cat);
-  const auto result = ra_executor.executeRelAlgQuery(query_ra, co, eo, nullptr);
-  const auto rs = result.getRows();
-  const auto copy = rs->getArrowCopy(data_mgr_.get(),
-                                     device_type,
-                                     device_id,
-                                     getTargetNames(result.getTargetsMeta()),
-                                     first_n);
-  _return.sm_handle = std::string(copy.sm_handle.begin(), copy.sm_handle.end());
-  _return.sm_size = copy.sm_size;
-  _return.df_handle = std::string(copy.df_handle.begin(), copy.df_handle.end());
-  if (device_type == ExecutorDeviceType::GPU) {
-    std::lock_guard<std::mutex> map_lock(handle_to_dev_ptr_mutex_);
-    CHECK(!ipc_handle_to_dev_ptr_.count(_return.df_handle));
-    ipc_handle_to_dev_ptr_.insert(std::make_pair(_return.df_handle, copy.df_dev_ptr));
-  }
-  _return.df_size = copy.df_size;
+  return ra_executor.executeRelAlgQuery(query_ra, co, eo, nullptr);
 }
 
 void MapDHandler::execute_root_plan(TQueryResult& _return,
@@ -3959,9 +4898,14 @@ void MapDHandler::convert_rows(TQueryResult& _return,
                                const int32_t at_most_n) const {
   INJECT_TIMER(convert_rows);
   _return.row_set.row_desc = convert_target_metainfo(targets);
+  // Rows between the checks whether the query has been interrupted.
+  const int32_t interrupt_check_rows{4096};
   int32_t fetched{0};
   if (column_format) {
     _return.row_set.is_columnar = true;
+    if (convert_columns_bulk(_return, results, first_n, at_most_n)) {
+      return;
+    }
     std::vector<TColumn> tcolumns(results.colCount());
     while (first_n == -1 || fetched < first_n) {
       const auto crt_row = results.getNextRow(true, true);
@@ -3973,6 +4917,9 @@ void MapDHandler::convert_rows(TQueryResult& _return,
         THROW_MAPD_EXCEPTION("The result contains more rows than the specified cap of " +
                              std::to_string(at_most_n));
       }
+      if (fetched % interrupt_check_rows == 0) {
+        results.checkInterrupted();
+      }
       for (size_t i = 0; i < results.colCount(); ++i) {
         const auto agg_result = crt_row[i];
         value_to_thrift_column(agg_result, targets[i].get_type_info(), tcolumns[i]);
@@ -3993,6 +4940,9 @@ void MapDHandler::convert_rows(TQueryResult& _return,
         THROW_MAPD_EXCEPTION("The result contains more rows than the specified cap of " +
                              std::to_string(at_most_n));
       }
+      if (fetched % interrupt_check_rows == 0) {
+        results.checkInterrupted();
+      }
       TRow trow;
       trow.cols.reserve(results.colCount());
       for (size_t i = 0; i < results.colCount(); ++i) {
@@ -4004,6 +4954,57 @@ void MapDHandler::convert_rows(TQueryResult& _return,
   }
 }
 
+bool MapDHandler::convert_columns_bulk(TQueryResult& _return,
+                                       const ResultSet& results,
+                                       const int32_t first_n,
+                                       const int32_t at_most_n) const {
+  if (!results.canFetchColumnsBulk()) {
+    return false;
+  }
+  const size_t batch_rows{64 * 1024};
+  auto max_rows = first_n >= 0 ? static_cast<size_t>(first_n)
+                               : std::numeric_limits<size_t>::max();
+  if (at_most_n >= 0) {
+    // one row past the cap tells it's exceeded
+    max_rows = std::min(max_rows, static_cast<size_t>(at_most_n) + 1);
+  }
+  std::vector<TColumn> tcolumns(results.colCount());
+  std::vector<ResultSetBulkColumn> columns;
+  size_t fetched{0};
+  while (fetched < max_rows) {
+    results.checkInterrupted();
+    const auto batch_max_rows = std::min(batch_rows, max_rows - fetched);
+    const auto row_count =
+        results.getNextColumnsBulk(columns, batch_max_rows, true, true);
+    fetched += row_count;
+    if (at_most_n >= 0 && fetched > static_cast<size_t>(at_most_n)) {
+      THROW_MAPD_EXCEPTION("The result contains more rows than the specified cap of " +
+                           std::to_string(at_most_n));
+    }
+    // a column only has the values of its type, the other vectors are empty
+    for (size_t i = 0; i < tcolumns.size(); ++i) {
+      auto& column = columns[i];
+      auto& data = tcolumns[i].data;
+      data.int_col.insert(
+          data.int_col.end(), column.int_values.begin(), column.int_values.end());
+      data.real_col.insert(
+          data.real_col.end(), column.real_values.begin(), column.real_values.end());
+      data.str_col.insert(data.str_col.end(),
+                          std::make_move_iterator(column.str_values.begin()),
+                          std::make_move_iterator(column.str_values.end()));
+      tcolumns[i].nulls.insert(
+          tcolumns[i].nulls.end(), column.nulls.begin(), column.nulls.end());
+    }
+    if (row_count < batch_max_rows) {
+      break;
+    }
+  }
+  for (auto& tcolumn : tcolumns) {
+    _return.row_set.columns.push_back(std::move(tcolumn));
+  }
+  return true;
+}
+
 TRowDescriptor MapDHandler::fixup_row_descriptor(const TRowDescriptor& row_desc,
                                                  const Catalog& cat) {
   TRowDescriptor fixedup_row_desc;
@@ -4097,6 +5098,13 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
   _return.execution_time_ms = 0;
   auto& cat = session_info.get_catalog();
 
+  tracing::Span query_span("sql_execute", tracing::Span::newTrace());
+  if (query_span.sampled()) {
+    query_span.addAttribute("db.user", session_info.get_currentUser().userName);
+    query_span.addAttribute("db.name", cat.get_currentDB().dbName);
+    query_span.addAttribute("db.statement", SlowQueryLog::normalizeQuery(query_str));
+  }
+
   SQLParser parser;
   std::list<std::unique_ptr<Parser::Stmt>> parse_trees;
   std::string last_parsed;
@@ -4113,7 +5121,6 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
   */
   mapd_unique_lock<mapd_shared_mutex> chkptlLock;
   mapd_unique_lock<mapd_shared_mutex> upddelLock;
-  mapd_unique_lock<mapd_shared_mutex> executeWriteLock;
   mapd_shared_lock<mapd_shared_mutex> executeReadLock;
   std::vector<std::shared_ptr<VLock>> upddelLocks;
 
@@ -4121,8 +5128,14 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
     ParserWrapper pw{query_str};
     std::map<std::string, bool> tableNames;
     if (is_calcite_path_permissable(pw, read_only_)) {
+      // always collected for the latency metrics, returned on demand
+      auto query_profile = std::make_unique<QueryProfile>();
+      const auto start_time = std::time(nullptr);
+      const auto clock_begin = timer_start();
       std::string query_ra;
       _return.execution_time_ms += measure<>::execution([&]() {
+        QueryProfile::Timer calcite_timer(query_profile.get(),
+                                          QueryProfile::Phase::Calcite);
         // query_ra = TIME_WRAP(parse_to_ra)(query_str, session_info);
         query_ra = parse_to_ra(query_str, {}, session_info, &tableNames);
       });
@@ -4164,7 +5177,8 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
           pw.is_select_explain,
           false,
           g_enable_filter_push_down && !g_cluster,
-          pw.is_select_calcite_explain);
+          pw.is_select_calcite_explain,
+          query_profile.get());
       if (pw.is_select_calcite_explain && filter_push_down_requests.empty()) {
         // we only reach here if filter push down was enabled, but no filter
         // push down candidate was found
@@ -4182,7 +5196,8 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
                                               pw.is_select_explain,
                                               pw.is_select_calcite_explain,
                                               query_str,
-                                              filter_push_down_requests);
+                                              filter_push_down_requests,
+                                              query_profile.get());
       } else if (pw.is_select_calcite_explain && filter_push_down_requests.empty()) {
         // return the ra as the result:
         // If we reach here, the 'filter_push_down_request' turned out to be empty, i.e.,
@@ -4206,6 +5221,20 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
         convert_explain(_return, ResultSet(query_ra), true);
         return;
       }
+      query_profile->recordMetrics();
+      log_slow_query(session_info,
+                     query_str,
+                     query_ra,
+                     *query_profile,
+                     start_time,
+                     timer_stop(clock_begin));
+      if (pw.is_select_explain_analyze) {
+        // the query ran in full, return its profile in place of its rows
+        _return.row_set = TRowSet();
+        convert_explain(_return, ResultSet(query_profile->toString()), true);
+      } else if (g_enable_query_profile || g_enable_kernel_instrumentation) {
+        _return.__set_execution_profile(query_profile->toString());
+      }
       return;
     }
     LOG(INFO) << "passing query to legacy processor";
@@ -4269,6 +5298,13 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
               session_info.get_catalog(),
               *stmtp->get_table(),
               LockType::UpdateDeleteLock);
+        } else if (auto stmtp = dynamic_cast<Parser::OptimizeTableStmt*>(stmt.get())) {
+          chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+              session_info.get_catalog(), *stmtp->get_table(), LockType::CheckpointLock);
+          upddelLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
+              session_info.get_catalog(),
+              *stmtp->get_table(),
+              LockType::UpdateDeleteLock);
         } else if (auto stmtp = dynamic_cast<Parser::AddColumnStmt*>(stmt.get())) {
           chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
               session_info.get_catalog(), *stmtp->get_table(), LockType::CheckpointLock);
@@ -4338,12 +5374,12 @@ void MapDHandler::sql_execute_impl(TQueryResult& _return,
           // InsertOrderFragmenter::insertData, or deadlock will occur w/o moving the
           // following lock back to here!!!
         } else if (auto stmtp = dynamic_cast<Parser::InsertValuesStmt*>(stmt.get())) {
-          // INSERT_VALUES: CheckpointLock >> write ExecutorOuterLock [ >> write
-          // UpdateDeleteLocks ]
+          // INSERT_VALUES: CheckpointLock [ >> write UpdateDeleteLocks ]
+          // Like COPY_FROM, the rows become visible at once when the fragmenter
+          // publishes its fragment metadata. The queries keep reading the fragments
+          // they started with, so they don't have to be drained first.
           chkptlLock = getTableLock<mapd_shared_mutex, mapd_unique_lock>(
               session_info.get_catalog(), *stmtp->get_table(), LockType::CheckpointLock);
-          executeWriteLock = mapd_unique_lock<mapd_shared_mutex>(
-              *LockMgr<mapd_shared_mutex, bool>::getMutex(ExecutorOuterLock, true));
           // [ write UpdateDeleteLocks ] lock is deferred in
           // InsertOrderFragmenter::deleteFragments
         }
@@ -4379,7 +5415,8 @@ void MapDHandler::execute_rel_alg_with_filter_push_down(
     const bool just_explain,
     const bool just_calcite_explain,
     const std::string& query_str,
-    const std::vector<PushedDownFilterInfo> filter_push_down_requests) {
+    const std::vector<PushedDownFilterInfo> filter_push_down_requests,
+    QueryProfile* query_profile) {
   // collecting the selected filters' info to be sent to Calcite:
   std::vector<TFilterPushDownInfo> filter_push_down_info;
   for (const auto& req : filter_push_down_requests) {
@@ -4410,7 +5447,8 @@ void MapDHandler::execute_rel_alg_with_filter_push_down(
                   just_explain,
                   /*just_validate = */ false,
                   /*find_push_down_candidates = */ false,
-                  /*just_calcite_explain = */ false);
+                  /*just_calcite_explain = */ false,
+                  query_profile);
 }
 
 void MapDHandler::execute_distributed_copy_statement(
@@ -4436,7 +5474,8 @@ Planner::RootPlan* MapDHandler::parse_to_plan(
   ParserWrapper pw{query_str};
   // if this is a calcite select or explain select run in calcite
   if (!pw.is_ddl && !pw.is_update_dml && !pw.is_other_explain) {
-    const std::string actual_query{pw.is_select_explain || pw.is_select_calcite_explain
+    const std::string actual_query{pw.is_select_explain || pw.is_select_calcite_explain ||
+                                           pw.is_select_explain_analyze
                                        ? pw.actual_query
                                        : query_str};
     const auto query_ra =
@@ -4464,8 +5503,10 @@ std::string MapDHandler::parse_to_ra(
     std::map<std::string, bool>* tableNames) {
   INJECT_TIMER(parse_to_ra);
   ParserWrapper pw{query_str};
-  const std::string actual_query{
-      pw.is_select_explain || pw.is_select_calcite_explain ? pw.actual_query : query_str};
+  const std::string actual_query{pw.is_select_explain || pw.is_select_calcite_explain ||
+                                         pw.is_select_explain_analyze
+                                     ? pw.actual_query
+                                     : query_str};
   if (is_calcite_path_permissable(pw)) {
     auto result = calcite_->process(session_info,
                                     legacy_syntax_ ? pg_shim(actual_query) : actual_query,
@@ -4497,6 +5538,8 @@ void MapDHandler::execute_first_step(TStepResult& _return,
     THROW_MAPD_EXCEPTION("Distributed support is disabled.");
   }
   LOG(INFO) << "execute_first_step :  id:" << pending_query.id;
+  tracing::Span step_span("execute_first_step", pending_query.traceparent);
+  step_span.addAttribute("query_id", static_cast<int64_t>(pending_query.id));
   auto time_ms = measure<>::execution([&]() {
     try {
       leaf_handler_->execute_first_step(_return, pending_query);
@@ -4504,6 +5547,7 @@ void MapDHandler::execute_first_step(TStepResult& _return,
       THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
     }
   });
+  _return.traceparent = step_span.traceparent();
   LOG(INFO) << "execute_first_step-COMPLETED " << time_ms << "ms";
 }
 
@@ -4530,11 +5574,15 @@ void MapDHandler::start_query(TPendingQuery& _return,
 
 void MapDHandler::broadcast_serialized_rows(const std::string& serialized_rows,
                                             const TRowDescriptor& row_desc,
-                                            const TQueryId query_id) {
+                                            const TQueryId query_id,
+                                            const std::string& traceparent) {
   if (!leaf_handler_) {
     THROW_MAPD_EXCEPTION("Distributed support is disabled.");
   }
   LOG(INFO) << "BROADCAST-SERIALIZED-ROWS  id:" << query_id;
+  tracing::Span broadcast_span("broadcast_serialized_rows", traceparent);
+  broadcast_span.addAttribute("query_id", static_cast<int64_t>(query_id));
+  broadcast_span.addAttribute("bytes", static_cast<int64_t>(serialized_rows.size()));
   auto time_ms = measure<>::execution([&]() {
     try {
       leaf_handler_->broadcast_serialized_rows(serialized_rows, row_desc, query_id);
@@ -4679,6 +5727,41 @@ void MapDHandler::checkpoint(const TSessionId& session,
   cat.get_dataMgr().checkpoint(db_id, table_id);
 }
 
+int32_t MapDHandler::checkpoint_table(const TSessionId& session,
+                                      const std::string& table_name) {
+  check_read_only("checkpoint_table");
+  const auto session_info = get_session(session);
+  auto& cat = session_info.get_catalog();
+  const auto td = cat.getMetadataForTable(table_name, false);
+  if (!td) {
+    THROW_MAPD_EXCEPTION("Table " + table_name + " does not exist.");
+  }
+  check_table_load_privileges(session_info, table_name);
+  const int32_t db_id = cat.get_currentDB().dbId;
+  if (leaf_aggregator_.leafCount() > 0) {
+    leaf_aggregator_.checkpointLeaf(session_info, db_id, td->tableId);
+    return leaf_aggregator_.get_table_epochLeaf(session_info, db_id, td->tableId);
+  }
+  if (td->persistenceLevel == Data_Namespace::MemoryLevel::DISK_LEVEL) {
+    // The strings of the rows loaded since the last checkpoint have to be durable first.
+    const auto col_descs =
+        cat.getAllColumnMetadataForTable(td->tableId, false, false, false);
+    for (const auto cd : col_descs) {
+      if (cd->columnType.get_compression() != kENCODING_DICT) {
+        continue;
+      }
+      const auto dd = cat.getMetadataForDict(cd->columnType.get_comp_param());
+      CHECK(dd);
+      if (!dd->stringDict->checkpoint()) {
+        THROW_MAPD_EXCEPTION("Checkpointing the dictionary of column " + cd->columnName +
+                             " failed.");
+      }
+    }
+    cat.checkpoint(td->tableId);
+  }
+  return cat.getTableEpoch(db_id, td->tableId);
+}
+
 // check and reset epoch if a request has been made
 void MapDHandler::set_table_epoch(const TSessionId& session,
                                   const int db_id,
@@ -4742,6 +5825,81 @@ int32_t MapDHandler::get_table_epoch_by_name(const TSessionId& session,
   return cat.getTableEpoch(db_id, td->tableId);
 }
 
+void MapDHandler::preload_table(const TSessionId& session,
+                                const std::string& table_name,
+                                const std::vector<std::string>& column_names,
+                                const TDeviceType::type device_type,
+                                const int32_t eviction_priority) {
+  const auto session_info = get_session(session);
+  if (!session_info.get_currentUser().isSuper) {
+    THROW_MAPD_EXCEPTION("Only superuser can preload tables");
+  }
+  if (eviction_priority < 0 || eviction_priority >= (1 << 16)) {
+    THROW_MAPD_EXCEPTION("Eviction priority must be between 0 and 65535");
+  }
+  const auto mem_level = device_type == TDeviceType::GPU
+                             ? Data_Namespace::MemoryLevel::GPU_LEVEL
+                             : Data_Namespace::MemoryLevel::CPU_LEVEL;
+  if (mem_level == Data_Namespace::MemoryLevel::GPU_LEVEL && !data_mgr_->gpusPresent()) {
+    THROW_MAPD_EXCEPTION("No GPU to preload table " + table_name + " to");
+  }
+  auto& cat = session_info.get_catalog();
+  try {
+    // Like a query, so that the table can't be dropped or truncated meanwhile.
+    auto upddel_lock = getTableLock<mapd_shared_mutex, mapd_shared_lock>(
+        cat, table_name, LockType::UpdateDeleteLock);
+    const auto td = cat.getMetadataForTable(table_name);
+    CHECK(td);
+    if (td->isView) {
+      throw std::runtime_error(table_name + " is a view");
+    }
+    std::vector<const ColumnDescriptor*> cds;
+    if (column_names.empty()) {
+      for (const auto cd :
+           cat.getAllColumnMetadataForTable(td->tableId, false, false, true)) {
+        cds.push_back(cd);
+      }
+    }
+    for (const auto& column_name : column_names) {
+      const auto cd = cat.getMetadataForColumn(td->tableId, column_name);
+      if (!cd) {
+        throw std::runtime_error("Column " + column_name + " does not exist");
+      }
+      cds.push_back(cd);
+      // The coordinates, rings and bounds of a geo column are its physical columns.
+      for (int i = 1; i <= cd->columnType.get_physical_cols(); ++i) {
+        cds.push_back(cat.getMetadataForColumn(td->tableId, cd->columnId + i));
+      }
+    }
+    const int db_id = cat.get_currentDB().dbId;
+    for (const auto physical_td : cat.getPhysicalTablesDescriptors(td)) {
+      const auto table_info = physical_td->fragmenter->getFragmentsForQuery();
+      for (const auto& fragment : table_info.fragments) {
+        const auto& chunk_metadata_map = fragment.getChunkMetadataMapPhysical();
+        for (const auto cd : cds) {
+          const auto chunk_metadata_it = chunk_metadata_map.find(cd->columnId);
+          if (chunk_metadata_it == chunk_metadata_map.end()) {
+            continue;
+          }
+          const auto& chunk_metadata = chunk_metadata_it->second;
+          // The chunk is unpinned when it goes out of scope, it stays in the pool.
+          Chunk_NS::Chunk::getChunk(cd,
+                                    data_mgr_.get(),
+                                    {db_id, physical_td->tableId, cd->columnId,
+                                     fragment.fragmentId},
+                                    mem_level,
+                                    fragment.deviceIds[static_cast<int>(mem_level)],
+                                    chunk_metadata.numBytes,
+                                    chunk_metadata.numElements);
+        }
+      }
+      data_mgr_->setTableEvictionPriority(db_id, physical_td->tableId, eviction_priority);
+    }
+  } catch (const std::exception& e) {
+    THROW_MAPD_EXCEPTION(std::string("Exception: ") + e.what());
+  }
+}
+
 void MapDHandler::set_license_key(TLicenseInfo& _return,
                                   const TSessionId& session,
                                   const std::string& key,
@@ -4759,6 +5917,9 @@ void MapDHandler::get_license_claims(TLicenseInfo& _return,
 }
 
 void MapDHandler::shutdown() {
+  if (hot_chunks_thread_.joinable()) {
+    save_hot_chunks();
+  }
   if (calcite_) {
     calcite_->close_calcite_server();
   }
@@ -25,6 +25,7 @@
 #define MAPDHANDLER_H
 
 #include "LeafAggregator.h"
+#include "SlowQueryLog.h"
 #ifdef HAVE_PROFILER
 #include <gperftools/heap-profiler.h>
 #endif  // HAVE_PROFILER
@@ -79,8 +80,13 @@
 #include <boost/program_options.hpp>
 #include <boost/regex.hpp>
 #include <boost/tokenizer.hpp>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -167,8 +173,12 @@ class MapDHandler : public MapDIf {
   void get_memory(std::vector<TNodeMemoryInfo>& _return,
                   const TSessionId& session,
                   const std::string& memory_level);
+  // Counters and histograms of the engine internals, in the Prometheus text format.
+  void get_metrics(std::string& _return, const TSessionId& session);
+  void get_slow_queries(TQueryResult& _return, const TSessionId& session);
   void clear_cpu_memory(const TSessionId& session);
   void clear_gpu_memory(const TSessionId& session);
+  int64_t compact_memory(const TSessionId& session, const std::string& memory_level);
   void set_table_epoch(const TSessionId& session,
                        const int db_id,
                        const int table_id,
@@ -181,6 +191,11 @@ class MapDHandler : public MapDIf {
                           const int32_t table_id);
   int32_t get_table_epoch_by_name(const TSessionId& session,
                                   const std::string& table_name);
+  void preload_table(const TSessionId& session,
+                     const std::string& table_name,
+                     const std::vector<std::string>& column_names,
+                     const TDeviceType::type device_type,
+                     const int32_t eviction_priority);
   // query, render
   void sql_execute(TQueryResult& _return,
                    const TSessionId& session,
@@ -209,6 +224,46 @@ class MapDHandler : public MapDIf {
                      const TDataFrame& df,
                      const TDeviceType::type device_type,
                      const int32_t device_id);
+  int64_t sql_execute_df_cursor(const TSessionId& session,
+                                const std::string& query,
+                                const int32_t batch_entry_count);
+  void fetch_df_batch(TDataFrame& _return,
+                      const TSessionId& session,
+                      const int64_t cursor_id);
+  void close_df_cursor(const TSessionId& session, const int64_t cursor_id);
+  int64_t sql_execute_cursor(const TSessionId& session,
+                             const std::string& query,
+                             const int32_t first_n,
+                             const int32_t at_most_n);
+  void fetch_rows(TQueryResult& _return,
+                  const TSessionId& session,
+                  const int64_t cursor_id,
+                  const bool column_format,
+                  const int32_t max_rows);
+  void close_cursor(const TSessionId& session, const int64_t cursor_id);
+  void sql_execute_compact(TCompactResult& _return,
+                           const TSessionId& session,
+                           const std::string& query,
+                           const std::string& nonce,
+                           const int32_t first_n,
+                           const int32_t at_most_n,
+                           const bool delta_encode);
+  void sql_execute_batch(std::vector<TBatchQueryResult>& _return,
+                         const TSessionId& session,
+                         const std::vector<std::string>& queries,
+                         const bool column_format,
+                         const std::string& nonce,
+                         const int32_t first_n);
+  int64_t sql_submit(const TSessionId& session, const std::string& query);
+  void get_query_status(TQueryStatus& _return,
+                        const TSessionId& session,
+                        const int64_t query_id);
+  void fetch_query_result(TQueryResult& _return,
+                          const TSessionId& session,
+                          const int64_t query_id,
+                          const bool column_format,
+                          const int32_t first_n);
+  void cancel_query(const TSessionId& session, const int64_t query_id);
   void interrupt(const TSessionId& session);
   void sql_validate(TTableDescriptor& _return,
                     const TSessionId& session,
@@ -291,10 +346,17 @@ class MapDHandler : public MapDIf {
       size_t num_cols,
       std::unique_ptr<Importer_NS::Loader>* loader,
       std::vector<std::unique_ptr<Importer_NS::TypedImportBuffer>>* import_buffers);
+  void load_columnar(const TSessionId& session,
+                     const std::string& table_name,
+                     const std::vector<TColumn>& cols,
+                     const bool checkpoint);
 
   void load_table_binary_columnar(const TSessionId& session,
                                   const std::string& table_name,
                                   const std::vector<TColumn>& cols);
+  void load_table_binary_columnar_no_checkpoint(const TSessionId& session,
+                                                const std::string& table_name,
+                                                const std::vector<TColumn>& cols);
   void load_table_binary_arrow(const TSessionId& session,
                                const std::string& table_name,
                                const std::string& arrow_stream);
@@ -339,7 +401,8 @@ class MapDHandler : public MapDIf {
   void execute_first_step(TStepResult& _return, const TPendingQuery& pending_query);
   void broadcast_serialized_rows(const std::string& serialized_rows,
                                  const TRowDescriptor& row_desc,
-                                 const TQueryId query_id);
+                                 const TQueryId query_id,
+                                 const std::string& traceparent);
 
   void start_render_query(TPendingRenderQuery& _return,
                           const TSessionId& session,
@@ -352,6 +415,7 @@ class MapDHandler : public MapDIf {
 
   void insert_data(const TSessionId& session, const TInsertData& insert_data);
   void checkpoint(const TSessionId& session, const int32_t db_id, const int32_t table_id);
+  int32_t checkpoint_table(const TSessionId& session, const std::string& table_name);
   // deprecated
   void get_table_descriptor(TTableDescriptor& _return,
                             const TSessionId& session,
@@ -442,6 +506,12 @@ class MapDHandler : public MapDIf {
                               const bool get_system,
                               const bool get_physical);
   void check_read_only(const std::string& str);
+  void refresh_after_load(const Catalog_Namespace::SessionInfo& session_info);
+  void vacuum_deleted_rows_periodically();
+  void prefetch_and_save_hot_chunks_periodically();
+  std::string hot_chunks_file_path() const;
+  void save_hot_chunks();
+  void prefetch_hot_chunks();
   void check_session_exp(const SessionMap::iterator& session_it);
   SessionMap::iterator get_session_it(const TSessionId& session);
   static void value_to_thrift_column(const TargetValue& tv,
@@ -482,7 +552,8 @@ class MapDHandler : public MapDIf {
       const bool just_explain,
       const bool just_validate,
       const bool find_push_down_candidates,
-      const bool just_calcite_explain) const;
+      const bool just_calcite_explain,
+      QueryProfile* query_profile = nullptr) const;
 
   void execute_rel_alg_with_filter_push_down(
       TQueryResult& _return,
@@ -495,7 +566,15 @@ class MapDHandler : public MapDIf {
       const bool just_explain,
       const bool just_calcite_explain,
       const std::string& query_str,
-      const std::vector<PushedDownFilterInfo> filter_push_down_requests);
+      const std::vector<PushedDownFilterInfo> filter_push_down_requests,
+      QueryProfile* query_profile = nullptr);
+
+  void log_slow_query(const Catalog_Namespace::SessionInfo& session_info,
+                      const std::string& query_str,
+                      const std::string& query_ra,
+                      const QueryProfile& query_profile,
+                      const std::time_t start_time,
+                      const int64_t total_ms);
 
   void execute_rel_alg_df(TDataFrame& _return,
                           const std::string& query_ra,
@@ -503,6 +582,12 @@ class MapDHandler : public MapDIf {
                           const ExecutorDeviceType device_type,
                           const size_t device_id,
                           const int32_t first_n) const;
+  ExecutionResult execute_rel_alg_result(
+      const std::string& query_ra,
+      const Catalog_Namespace::SessionInfo& session_info,
+      const ExecutorDeviceType device_type) const;
+  ExecutionResult execute_cursor_query(const Catalog_Namespace::SessionInfo& session_info,
+                                       const std::string& query_str);
   TColumnType populateThriftColumnType(const Catalog_Namespace::Catalog* cat,
                                        const ColumnDescriptor* cd);
   TRowDescriptor fixup_row_descriptor(const TRowDescriptor& row_desc,
@@ -540,6 +625,13 @@ class MapDHandler : public MapDIf {
                     const int32_t first_n,
                     const int32_t at_most_n) const;
 
+  // Fetches the rows in batches of decoded columns instead of a row of TargetValue at a
+  // time, false if the result has targets which can't be fetched in bulk.
+  bool convert_columns_bulk(TQueryResult& _return,
+                            const ResultSet& results,
+                            const int32_t first_n,
+                            const int32_t at_most_n) const;
+
   void create_simple_result(TQueryResult& _return,
                             const ResultSet& results,
                             const bool column_format,
@@ -616,10 +708,88 @@ class MapDHandler : public MapDIf {
   std::string _geo_copy_from_file_name;
   Importer_NS::CopyParams _geo_copy_from_copy_params;
 
+  // Background rewrite of fragments with deleted rows, see --vacuum-interval-secs
+  std::thread vacuum_thread_;
+  std::mutex vacuum_mutex_;
+  std::condition_variable vacuum_cv_;
+  bool stop_vacuum_;
+
+  // Background record of the chunks resident in the buffer pools, prefetched again
+  // after a restart, see --hot-chunks-save-interval-secs
+  std::thread hot_chunks_thread_;
+  std::mutex hot_chunks_mutex_;
+  std::condition_variable hot_chunks_cv_;
+  bool stop_hot_chunks_;
+  std::atomic<bool> hot_chunks_prefetched_;
+  std::mutex hot_chunks_save_mutex_;
+
   // Only for IPC device memory deallocation
   mutable std::mutex handle_to_dev_ptr_mutex_;
   mutable std::unordered_map<std::string, int8_t*> ipc_handle_to_dev_ptr_;
 
+  // The result of a query delivered in data frame batches. The next batch is converted
+  // while the client processes the current one, never more than one batch ahead.
+  struct DataFrameCursor {
+    TSessionId session;
+    std::shared_ptr<ResultSet> rows;
+    std::vector<std::string> col_names;
+    size_t batch_entry_count;
+    size_t next_entry;
+    std::future<ArrowResult> next_batch;
+    std::mutex mutex;
+  };
+
+  void prefetch_df_batch(DataFrameCursor& cursor);
+  void release_df_cursor(DataFrameCursor& cursor);
+
+  std::mutex df_cursors_mutex_;
+  std::unordered_map<int64_t, std::shared_ptr<DataFrameCursor>> df_cursors_;
+  int64_t next_df_cursor_id_{0};
+
+  // The result of a query delivered in pages of rows. The result set is released as soon
+  // as the last page has been fetched, the pages themselves as soon as they're sent.
+  struct RowCursor {
+    TSessionId session;
+    std::shared_ptr<ResultSet> rows;
+    std::vector<TargetMetaInfo> targets;
+    // Rows left to deliver, first_n when set.
+    size_t remaining;
+    std::mutex mutex;
+  };
+
+  std::mutex row_cursors_mutex_;
+  std::unordered_map<int64_t, std::shared_ptr<RowCursor>> row_cursors_;
+  int64_t next_row_cursor_id_{0};
+
+  // A query run in the background by the async query threads, all of it guarded by
+  // async_queries_mutex_. Dropped once fetched or canceled.
+  struct AsyncQuery {
+    TSessionId session;
+    std::string query_str;
+    TQueryState::type state;
+    std::chrono::steady_clock::time_point submit_time;
+    std::chrono::steady_clock::time_point end_time;
+    int64_t execution_time_ms;
+    std::string error_msg;
+    std::shared_ptr<ResultSet> rows;
+    std::vector<TargetMetaInfo> targets;
+  };
+
+  void run_async_queries();
+  std::shared_ptr<AsyncQuery> get_async_query(const TSessionId& session,
+                                              const int64_t query_id);
+
+  std::vector<std::thread> async_query_threads_;
+  std::mutex async_queries_mutex_;
+  std::condition_variable async_queries_cv_;
+  std::deque<int64_t> queued_async_queries_;
+  std::unordered_map<int64_t, std::shared_ptr<AsyncQuery>> async_queries_;
+  int64_t next_async_query_id_{0};
+  bool stop_async_queries_{false};
+
+  // Null unless the slow query threshold is set.
+  std::unique_ptr<SlowQueryLog> slow_query_log_;
+
   friend void run_warmup_queries(mapd::shared_ptr<MapDHandler> handler,
                                  std::string base_path,
                                  std::string query_file_path);
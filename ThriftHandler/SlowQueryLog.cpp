@@ -0,0 +1,285 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SlowQueryLog.h"
+
+#include <glog/logging.h>
+
+#include <cctype>
+
+constexpr size_t SlowQueryLog::kMaxRecentRecords;
+
+namespace {
+
+// Calls the visitor with the name and the value of each column, in the order of the
+// log file and of the result of get_slow_queries.
+template <class V>
+void visit_columns(const SlowQueryRecord& record, V& visitor) {
+  visitor("start_time", record.start_time);
+  visitor("total_ms", record.total_ms);
+  visitor("user_name", record.user_name);
+  visitor("db_name", record.db_name);
+  visitor("device", record.device);
+  visitor("cpu_retry_reason", record.cpu_retry_reason);
+  visitor("plan_hash", record.plan_hash);
+  visitor("compilation_ms", record.compilation_ms);
+  visitor("code_cache_hits", record.code_cache_hits);
+  visitor("code_cache_misses", record.code_cache_misses);
+  visitor("rows_scanned", record.rows_scanned);
+  visitor("fragments_total", record.fragments_total);
+  visitor("fragments_skipped", record.fragments_skipped);
+  visitor("cpu_fetched_bytes", record.cpu_fetched_bytes);
+  visitor("gpu_fetched_bytes", record.gpu_fetched_bytes);
+  visitor("cpu_peak_bytes", record.cpu_peak_bytes);
+  visitor("gpu_peak_bytes", record.gpu_peak_bytes);
+  visitor("query", record.query);
+}
+
+class LineWriter {
+ public:
+  LineWriter(std::ostream& os, const bool header) : os_(os), header_(header) {}
+
+  void operator()(const char* name, const std::string& val) {
+    separate();
+    if (header_) {
+      os_ << name;
+      return;
+    }
+    // A tab or a line break would start another column or record.
+    for (const char c : val) {
+      os_ << (c == '\t' || c == '\n' || c == '\r' ? ' ' : c);
+    }
+  }
+
+  void operator()(const char* name, const int64_t val) {
+    separate();
+    if (header_) {
+      os_ << name;
+    } else {
+      os_ << val;
+    }
+  }
+
+ private:
+  void separate() {
+    if (!first_) {
+      os_ << '\t';
+    }
+    first_ = false;
+  }
+
+  std::ostream& os_;
+  const bool header_;
+  bool first_{true};
+};
+
+class RowDescriptorBuilder {
+ public:
+  explicit RowDescriptorBuilder(TRowDescriptor& row_desc) : row_desc_(row_desc) {}
+
+  void operator()(const char* name, const std::string&) { add(name, TDatumType::STR); }
+
+  void operator()(const char* name, const int64_t) { add(name, TDatumType::BIGINT); }
+
+ private:
+  void add(const char* name, const TDatumType::type type) {
+    TColumnType col_type;
+    col_type.col_name = name;
+    col_type.col_type.type = type;
+    col_type.col_type.encoding = TEncodingType::NONE;
+    col_type.col_type.nullable = false;
+    col_type.col_type.is_array = false;
+    row_desc_.push_back(col_type);
+  }
+
+  TRowDescriptor& row_desc_;
+};
+
+class RowBuilder {
+ public:
+  explicit RowBuilder(TRow& row) : row_(row) {}
+
+  void operator()(const char*, const std::string& val) {
+    TDatum datum;
+    datum.val.str_val = val;
+    datum.is_null = false;
+    row_.cols.push_back(datum);
+  }
+
+  void operator()(const char*, const int64_t val) {
+    TDatum datum;
+    datum.val.int_val = val;
+    datum.is_null = false;
+    row_.cols.push_back(datum);
+  }
+
+ private:
+  TRow& row_;
+};
+
+bool is_identifier_char(const char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+}  // namespace
+
+SlowQueryLog::SlowQueryLog(const std::string& path) : stop_(false) {
+  file_.open(path, std::ios::out | std::ios::app);
+  if (!file_) {
+    LOG(ERROR) << "Could not open the slow query log " << path;
+  } else if (file_.tellp() == 0) {
+    LineWriter header_writer(file_, true);
+    visit_columns(SlowQueryRecord{}, header_writer);
+    file_ << '\n';
+    file_.flush();
+  }
+  writer_ = std::thread([this] { write(); });
+}
+
+SlowQueryLog::~SlowQueryLog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+}
+
+void SlowQueryLog::add(SlowQueryRecord record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  recent_.push_back(record);
+  if (recent_.size() > kMaxRecentRecords) {
+    recent_.pop_front();
+  }
+  pending_.push_back(std::move(record));
+  cv_.notify_one();
+}
+
+void SlowQueryLog::write() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      CHECK(stop_);
+      return;
+    }
+    std::deque<SlowQueryRecord> records;
+    records.swap(pending_);
+    lock.unlock();
+    if (file_) {
+      for (const auto& record : records) {
+        LineWriter line_writer(file_, false);
+        visit_columns(record, line_writer);
+        file_ << '\n';
+      }
+      file_.flush();
+    }
+    lock.lock();
+  }
+}
+
+TRowSet SlowQueryLog::getRecords(const std::string& user_name) const {
+  TRowSet row_set;
+  row_set.is_columnar = false;
+  RowDescriptorBuilder row_desc_builder(row_set.row_desc);
+  visit_columns(SlowQueryRecord{}, row_desc_builder);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& record : recent_) {
+    if (!user_name.empty() && record.user_name != user_name) {
+      continue;
+    }
+    TRow row;
+    RowBuilder row_builder(row);
+    visit_columns(record, row_builder);
+    row_set.rows.push_back(std::move(row));
+  }
+  return row_set;
+}
+
+std::string SlowQueryLog::normalizeQuery(const std::string& query_str) {
+  std::string normalized;
+  normalized.reserve(query_str.size());
+  size_t i = 0;
+  while (i < query_str.size()) {
+    const char c = query_str[i];
+    if (std::isspace(static_cast<unsigned char>(c))) {
+      while (i < query_str.size() &&
+             std::isspace(static_cast<unsigned char>(query_str[i]))) {
+        ++i;
+      }
+      if (!normalized.empty() && i < query_str.size()) {
+        normalized += ' ';
+      }
+      continue;
+    }
+    if (c == '\'') {
+      // Quotes within the string are doubled.
+      ++i;
+      while (i < query_str.size()) {
+        if (query_str[i] == '\'') {
+          if (i + 1 < query_str.size() && query_str[i + 1] == '\'') {
+            i += 2;
+            continue;
+          }
+          ++i;
+          break;
+        }
+        ++i;
+      }
+      normalized += '?';
+      continue;
+    }
+    if (c == '"') {
+      // A quoted identifier, kept as it is.
+      const auto end = query_str.find('"', i + 1);
+      const auto next = end == std::string::npos ? query_str.size() : end + 1;
+      normalized.append(query_str, i, next - i);
+      i = next;
+      continue;
+    }
+    const bool starts_number =
+        std::isdigit(static_cast<unsigned char>(c)) ||
+        (c == '.' && i + 1 < query_str.size() &&
+         std::isdigit(static_cast<unsigned char>(query_str[i + 1])));
+    if (starts_number && (normalized.empty() || !is_identifier_char(normalized.back()))) {
+      while (i < query_str.size() &&
+             (std::isdigit(static_cast<unsigned char>(query_str[i])) ||
+              query_str[i] == '.')) {
+        ++i;
+      }
+      // The exponent, if any.
+      if (i < query_str.size() && (query_str[i] == 'e' || query_str[i] == 'E')) {
+        auto j = i + 1;
+        if (j < query_str.size() && (query_str[j] == '+' || query_str[j] == '-')) {
+          ++j;
+        }
+        if (j < query_str.size() &&
+            std::isdigit(static_cast<unsigned char>(query_str[j]))) {
+          i = j;
+          while (i < query_str.size() &&
+                 std::isdigit(static_cast<unsigned char>(query_str[i]))) {
+            ++i;
+          }
+        }
+      }
+      normalized += '?';
+      continue;
+    }
+    normalized += c;
+    ++i;
+  }
+  return normalized;
+}
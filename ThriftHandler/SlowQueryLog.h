@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file    SlowQueryLog.h
+ * @brief   Performance records of the queries which took longer than a threshold.
+ *
+ * A record is appended to mapd_log/slow_queries.tsv by a writer thread, off the thread
+ * of the query, one tab separated line per query under a header line: the file loads
+ * into a table with COPY FROM and the delimiter set to a tab. The latest records are
+ * also kept in memory and returned by get_slow_queries as a query result with the same
+ * columns. The query is normalized, its literals replaced by ?, so the records of the
+ * runs of a dashboard query group together.
+ */
+
+#ifndef SLOWQUERYLOG_H
+#define SLOWQUERYLOG_H
+
+#include "gen-cpp/mapd_types.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct SlowQueryRecord {
+  std::string start_time;
+  std::string user_name;
+  std::string db_name;
+  std::string query;
+  // Of the relational algebra, the runs of the same plan with the same literals share it.
+  std::string plan_hash;
+  // CPU, GPU or both for the hybrid execution.
+  std::string device;
+  std::string cpu_retry_reason;
+  int64_t total_ms;
+  int64_t compilation_ms;
+  int64_t code_cache_hits;
+  int64_t code_cache_misses;
+  int64_t rows_scanned;
+  int64_t fragments_total;
+  int64_t fragments_skipped;
+  int64_t cpu_fetched_bytes;
+  int64_t gpu_fetched_bytes;
+  int64_t cpu_peak_bytes;
+  int64_t gpu_peak_bytes;
+};
+
+class SlowQueryLog {
+ public:
+  explicit SlowQueryLog(const std::string& path);
+  ~SlowQueryLog();
+
+  void add(SlowQueryRecord record);
+
+  // The latest records, oldest first. All of them if the user name is empty.
+  TRowSet getRecords(const std::string& user_name) const;
+
+  // Literals replaced by ? and white space collapsed.
+  static std::string normalizeQuery(const std::string& query_str);
+
+  static constexpr size_t kMaxRecentRecords{1000};
+
+ private:
+  void write();
+
+  std::ofstream file_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<SlowQueryRecord> pending_;
+  std::deque<SlowQueryRecord> recent_;
+  bool stop_;
+  std::thread writer_;
+};
+
+#endif  // SLOWQUERYLOG_H
@@ -21,6 +21,10 @@
 
 #include "ChunkIter.h"
 
+#ifndef __CUDACC__
+#include <algorithm>
+#endif
+
 DEVICE static void decompress(const SQLTypeInfo& ti,
                               int8_t* compressed,
                               VarlenDatum* result,
@@ -222,3 +226,70 @@ DEVICE void ChunkIter_get_nth(ChunkIter* it, int n, ArrayDatum* result, bool* is
     result->is_null = (result->length == 0);
   }
 }
+
+#ifndef __CUDACC__
+namespace {
+
+// Plain loops over the chunk buffer, vectorized by the compiler.
+template <typename T, typename OUT_TYPE>
+void widen(const int8_t* in, const size_t count, OUT_TYPE* out) {
+  const auto values = reinterpret_cast<const T*>(in);
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = values[i];
+  }
+}
+
+size_t batch_count(const ChunkIter* it, const int n, const size_t count) {
+  assert(it->skip_size > 0);
+  if (n < 0 || static_cast<size_t>(n) >= it->num_elems) {
+    return 0;
+  }
+  return std::min(count, it->num_elems - n);
+}
+
+}  // namespace
+
+size_t ChunkIter_get_nth_batch(ChunkIter* it, int n, size_t count, int64_t* out) {
+  count = batch_count(it, n, count);
+  const int8_t* current_pos = it->start_pos + n * it->skip_size;
+  // the 8 and 16 bit dictionary ids are unsigned
+  const bool is_unsigned = it->type_info.is_string();
+  switch (it->skip_size) {
+    case 1:
+      if (is_unsigned) {
+        widen<uint8_t>(current_pos, count, out);
+      } else {
+        widen<int8_t>(current_pos, count, out);
+      }
+      break;
+    case 2:
+      if (is_unsigned) {
+        widen<uint16_t>(current_pos, count, out);
+      } else {
+        widen<int16_t>(current_pos, count, out);
+      }
+      break;
+    case 4:
+      widen<int32_t>(current_pos, count, out);
+      break;
+    case 8:
+      widen<int64_t>(current_pos, count, out);
+      break;
+    default:
+      assert(false);
+  }
+  return count;
+}
+
+size_t ChunkIter_get_nth_batch(ChunkIter* it, int n, size_t count, double* out) {
+  assert(it->type_info.is_fp());
+  count = batch_count(it, n, count);
+  const int8_t* current_pos = it->start_pos + n * it->skip_size;
+  if (it->skip_size == sizeof(float)) {
+    widen<float>(current_pos, count, out);
+  } else {
+    widen<double>(current_pos, count, out);
+  }
+  return count;
+}
+#endif  // __CUDACC__
@@ -51,4 +51,15 @@ DEVICE void ChunkIter_get_nth(ChunkIter* it,
                               bool* is_end);
 DEVICE void ChunkIter_get_nth(ChunkIter* it, int nth, ArrayDatum* vd, bool* is_end);
 
+#ifndef __CUDACC__
+// @brief get up to count fixed width elements from the nth into out, without the
+// per element dispatch on the type and the encoding. The integers, decimals, booleans,
+// dates, times and dictionary ids are widened to 64 bits like ChunkIter_get_nth does
+// when uncompressing, the floating point numbers to double. Returns the number of
+// elements read, fewer than count at the end of the Chunk. Does not change ChunkIter
+// state.
+size_t ChunkIter_get_nth_batch(ChunkIter* it, int nth, size_t count, int64_t* out);
+size_t ChunkIter_get_nth_batch(ChunkIter* it, int nth, size_t count, double* out);
+#endif  // __CUDACC__
+
 #endif  // _CHUNK_ITER_H_
@@ -26,6 +26,35 @@
 
 #ifndef __CUDACC__
 #include <boost/regex.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// Patterns compiled by this thread, a null entry for the malformed ones. Compiling is
+// by far the most expensive part of a match, do it once per pattern instead of per row.
+const boost::regex* get_compiled_regexp(const char* pattern, const int32_t pat_len) {
+  thread_local std::unordered_map<std::string, std::unique_ptr<boost::regex>> cache;
+  const std::string pattern_str(pattern, pat_len);
+  auto it = cache.find(pattern_str);
+  if (it == cache.end()) {
+    if (cache.size() >= 256) {
+      cache.clear();
+    }
+    std::unique_ptr<boost::regex> re;
+    try {
+      re.reset(new boost::regex(pattern, pat_len, boost::regex::extended));
+    } catch (std::runtime_error& error) {
+      // LOG(ERROR) << "Regexp compile error: " << error.what();
+    }
+    it = cache.emplace(pattern_str, std::move(re)).first;
+  }
+  return it->second.get();
+}
+
+}  // namespace
 #endif
 
 /*
@@ -43,11 +72,14 @@ extern "C" DEVICE bool regexp_like(const char* str,
                                    const int32_t pat_len,
                                    const char escape_char) {
 #ifndef __CUDACC__
+  const auto re = get_compiled_regexp(pattern, pat_len);
+  if (!re) {
+    return false;
+  }
   bool result;
   try {
-    boost::regex re(pattern, pat_len, boost::regex::extended);
     boost::cmatch what;
-    result = boost::regex_match(str, str + str_len, what, re);
+    result = boost::regex_match(str, str + str_len, what, *re);
   } catch (std::runtime_error& error) {
     // LOG(ERROR) << "Regexp match error: " << error.what();
     result = false;
@@ -25,6 +25,10 @@
 
 #include "StringLike.h"
 
+#ifndef __CUDACC__
+#include <cstring>
+#endif
+
 enum LikeStatus {
   kLIKE_TRUE,
   kLIKE_FALSE,
@@ -72,6 +76,128 @@ extern "C" DEVICE bool string_ilike_simple(const char* str,
   return false;
 }
 
+DEVICE static int32_t inline like_segment_len(const char* seg) {
+  return static_cast<int32_t>(static_cast<uint8_t>(seg[0])) |
+         (static_cast<int32_t>(static_cast<uint8_t>(seg[1])) << 8);
+}
+
+// Whether the segment of a compiled LIKE pattern matches the string at str, which has
+// at least len characters left. A set mask byte marks a '_' in the segment.
+DEVICE static bool like_segment_matches(const char* str,
+                                        const char* seg,
+                                        const char* mask,
+                                        const int32_t len,
+                                        const bool is_ilike) {
+  for (int32_t i = 0; i < len; ++i) {
+    if (!mask[i] && seg[i] != (is_ilike ? lowercase(str[i]) : str[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Leftmost position in [from, to] where the segment matches, -1 if there is none.
+// Candidates are found by scanning for the first literal character of the segment, with
+// memchr on the host, and only those are compared in full.
+DEVICE static int32_t like_segment_find(const char* str,
+                                        int32_t from,
+                                        const int32_t to,
+                                        const char* seg,
+                                        const char* mask,
+                                        const int32_t len,
+                                        const bool is_ilike) {
+  int32_t lit_idx = 0;
+  while (lit_idx < len && mask[lit_idx]) {
+    ++lit_idx;
+  }
+  if (lit_idx == len) {
+    return from <= to ? from : -1;
+  }
+  const char lit = seg[lit_idx];
+  while (from <= to) {
+#ifndef __CUDACC__
+    if (!is_ilike) {
+      const auto hit = static_cast<const char*>(
+          memchr(str + from + lit_idx, lit, to - from + 1));
+      if (!hit) {
+        return -1;
+      }
+      from = hit - str - lit_idx;
+    }
+#endif
+    if ((is_ilike ? lowercase(str[from + lit_idx]) : str[from + lit_idx]) == lit &&
+        like_segment_matches(str + from, seg, mask, len, is_ilike)) {
+      return from;
+    }
+    ++from;
+  }
+  return -1;
+}
+
+// Matches a pattern compiled by the query engine. The pattern is the list of the
+// segments between its '%' characters, escapes resolved and in lowercase for ILIKE, each
+// stored as a 16-bit length, the characters and a mask with a byte per character which
+// is set for '_'. The first segment is anchored at the start of the string, the last
+// one at its end and the ones in between are matched at their leftmost position, which
+// is exact since every segment has a fixed length. No backtracking is ever needed.
+DEVICE static bool string_like_compiled_match(const char* str,
+                                              const int32_t str_len,
+                                              const char* program,
+                                              const int32_t program_len,
+                                              const bool is_ilike) {
+  int32_t off = 0;
+  int32_t len = like_segment_len(program + off);
+  if (off + 2 + 2 * len == program_len) {
+    // No '%' at all, the whole string must match the only segment.
+    return str_len == len &&
+           like_segment_matches(str, program + 2, program + 2 + len, len, is_ilike);
+  }
+  if (len > str_len ||
+      !like_segment_matches(str, program + 2, program + 2 + len, len, is_ilike)) {
+    return false;
+  }
+  int32_t pos = len;
+  off += 2 + 2 * len;
+  len = like_segment_len(program + off);
+  while (off + 2 + 2 * len < program_len) {
+    if (pos + len > str_len) {
+      return false;
+    }
+    const auto found = like_segment_find(str,
+                                         pos,
+                                         str_len - len,
+                                         program + off + 2,
+                                         program + off + 2 + len,
+                                         len,
+                                         is_ilike);
+    if (found < 0) {
+      return false;
+    }
+    pos = found + len;
+    off += 2 + 2 * len;
+    len = like_segment_len(program + off);
+  }
+  return pos + len <= str_len && like_segment_matches(str + str_len - len,
+                                                      program + off + 2,
+                                                      program + off + 2 + len,
+                                                      len,
+                                                      is_ilike);
+}
+
+extern "C" DEVICE bool string_like_compiled(const char* str,
+                                            const int32_t str_len,
+                                            const char* program,
+                                            const int32_t program_len) {
+  return string_like_compiled_match(str, str_len, program, program_len, false);
+}
+
+extern "C" DEVICE bool string_ilike_compiled(const char* str,
+                                             const int32_t str_len,
+                                             const char* program,
+                                             const int32_t program_len) {
+  return string_like_compiled_match(str, str_len, program, program_len, true);
+}
+
 #define STR_LIKE_SIMPLE_NULLABLE(base_func)                               \
   extern "C" DEVICE int8_t base_func##_nullable(const char* lhs,          \
                                                 const int32_t lhs_len,    \
@@ -86,6 +212,8 @@ extern "C" DEVICE bool string_ilike_simple(const char* str,
 
 STR_LIKE_SIMPLE_NULLABLE(string_like_simple)
 STR_LIKE_SIMPLE_NULLABLE(string_ilike_simple)
+STR_LIKE_SIMPLE_NULLABLE(string_like_compiled)
+STR_LIKE_SIMPLE_NULLABLE(string_ilike_compiled)
 
 #undef STR_LIKE_SIMPLE_NULLABLE
 
@@ -64,6 +64,21 @@ extern "C" DEVICE bool string_ilike_simple(const char* str,
                                            const char* pattern,
                                            const int32_t pat_len);
 
+/*
+ * @brief string_like_compiled performs the SQL LIKE and ILIKE operation with a pattern
+ * compiled by the query engine into its '%' separated segments, see StringLike.cpp for
+ * the layout. Needs no backtracking, unlike string_like.
+ */
+extern "C" DEVICE bool string_like_compiled(const char* str,
+                                            const int32_t str_len,
+                                            const char* program,
+                                            const int32_t program_len);
+
+extern "C" DEVICE bool string_ilike_compiled(const char* str,
+                                             const int32_t str_len,
+                                             const char* program,
+                                             const int32_t program_len);
+
 extern "C" DEVICE bool string_lt(const char* lhs,
                                  const int32_t lhs_len,
                                  const char* rhs,
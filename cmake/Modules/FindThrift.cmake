@@ -53,6 +53,41 @@ find_library(Thrift_LIBRARY
   /usr/local/homebrew/lib
   /opt/local/lib)
 
+# zlib transport, used by the compressed binary port.
+find_library(Thrift_Z_LIBRARY
+  NAMES thriftz
+  HINTS
+  ENV LD_LIBRARY_PATH
+  ENV DYLD_LIBRARY_PATH
+  PATHS
+  /usr/lib
+  /usr/local/lib
+  /usr/local/homebrew/lib
+  /opt/local/lib)
+
+# Event loop server, used by the nonblocking binary port.
+find_library(Thrift_NB_LIBRARY
+  NAMES thriftnb
+  HINTS
+  ENV LD_LIBRARY_PATH
+  ENV DYLD_LIBRARY_PATH
+  PATHS
+  /usr/lib
+  /usr/local/lib
+  /usr/local/homebrew/lib
+  /opt/local/lib)
+
+find_library(Thrift_Event_LIBRARY
+  NAMES event
+  HINTS
+  ENV LD_LIBRARY_PATH
+  ENV DYLD_LIBRARY_PATH
+  PATHS
+  /usr/lib
+  /usr/local/lib
+  /usr/local/homebrew/lib
+  /opt/local/lib)
+
 get_filename_component(Thrift_LIBRARY_DIR ${Thrift_LIBRARY} DIRECTORY)
 
 find_program(Thrift_EXECUTABLE
@@ -84,7 +119,10 @@ if(Thrift_USE_STATIC_LIBS)
 endif()
 
 # Set standard CMake FindPackage variables if found.
-set(Thrift_LIBRARIES ${Thrift_LIBRARY})
+# The nonblocking server library depends on the base one, list it first for the static
+# link.
+set(Thrift_LIBRARIES ${Thrift_NB_LIBRARY} ${Thrift_LIBRARY} ${Thrift_Z_LIBRARY}
+  ${Thrift_Event_LIBRARY})
 if(Thrift_USE_STATIC_LIBS)
   set(Thrift_LIBRARIES ${Thrift_LIBRARIES} ${OPENSSL_LIBRARIES})
 endif()
@@ -93,4 +131,5 @@ set(Thrift_LIBRARY_DIRS ${Thrift_LIBRARY_DIR})
 set(Thrift_INCLUDE_DIRS ${Thrift_LIBRARY_DIR}/../include)
 
 include(FindPackageHandleStandardArgs)
-find_package_handle_standard_args(Thrift REQUIRED_VARS Thrift_LIBRARY Thrift_VERSION)
+find_package_handle_standard_args(Thrift REQUIRED_VARS Thrift_LIBRARY Thrift_Z_LIBRARY
+  Thrift_NB_LIBRARY Thrift_Event_LIBRARY Thrift_VERSION)
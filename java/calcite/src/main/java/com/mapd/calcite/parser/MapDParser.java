@@ -33,6 +33,7 @@ import org.apache.calcite.sql.SqlBasicCall;
 import org.apache.calcite.sql.SqlCall;
 import org.apache.calcite.sql.SqlDialect;
 import org.apache.calcite.sql.SqlIdentifier;
+import org.apache.calcite.sql.SqlKind;
 import org.apache.calcite.sql.SqlLiteral;
 import org.apache.calcite.sql.SqlNode;
 import org.apache.calcite.sql.SqlNodeList;
@@ -254,6 +255,10 @@ public final class MapDParser {
       return false;
     }
     SqlNode from = getUnaliasedExpression(select_node.getFrom());
+    // The sampled table still has a rowid to hide
+    if (from instanceof SqlCall && from.getKind() == SqlKind.TABLESAMPLE) {
+      from = getUnaliasedExpression(((SqlCall) from).operand(0));
+    }
     if (from instanceof SqlCall) {
       return false;
     }
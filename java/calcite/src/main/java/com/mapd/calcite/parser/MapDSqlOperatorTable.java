@@ -174,6 +174,10 @@ public class MapDSqlOperatorTable extends ChainedSqlOperatorTable {
     opTab.addOperator(new CastToGeography());
     opTab.addOperator(new OffsetInFragment());
     opTab.addOperator(new ApproxCountDistinct());
+    opTab.addOperator(new ApproxCountDistinctSketch());
+    opTab.addOperator(new ApproxCountDistinctUnion());
+    opTab.addOperator(new ApproxPercentile());
+    opTab.addOperator(new ApproxMedian());
     opTab.addOperator(new Sample());
     opTab.addOperator(new LastSample());
     opTab.addOperator(new MapD_GeoPolyBoundsPtr());
@@ -1169,6 +1173,85 @@ public class MapDSqlOperatorTable extends ChainedSqlOperatorTable {
     }
   }
 
+  // The HyperLogLog registers, to be stored and merged by APPROX_COUNT_DISTINCT_UNION
+  static class ApproxCountDistinctSketch extends SqlAggFunction {
+    ApproxCountDistinctSketch() {
+      super("APPROX_COUNT_DISTINCT_SKETCH",
+              null,
+              SqlKind.OTHER_FUNCTION,
+              null,
+              null,
+              OperandTypes.or(OperandTypes.family(SqlTypeFamily.ANY),
+                      OperandTypes.family(SqlTypeFamily.ANY, SqlTypeFamily.INTEGER)),
+              SqlFunctionCategory.SYSTEM);
+    }
+
+    @Override
+    public RelDataType inferReturnType(SqlOperatorBinding opBinding) {
+      final RelDataTypeFactory typeFactory = opBinding.getTypeFactory();
+      return typeFactory.createArrayType(
+              typeFactory.createSqlType(SqlTypeName.TINYINT), -1);
+    }
+  }
+
+  static class ApproxCountDistinctUnion extends SqlAggFunction {
+    ApproxCountDistinctUnion() {
+      super("APPROX_COUNT_DISTINCT_UNION",
+              null,
+              SqlKind.OTHER_FUNCTION,
+              null,
+              null,
+              OperandTypes.or(OperandTypes.family(SqlTypeFamily.ARRAY),
+                      OperandTypes.family(SqlTypeFamily.ARRAY, SqlTypeFamily.INTEGER)),
+              SqlFunctionCategory.SYSTEM);
+    }
+
+    @Override
+    public RelDataType inferReturnType(SqlOperatorBinding opBinding) {
+      final RelDataTypeFactory typeFactory = opBinding.getTypeFactory();
+      return typeFactory.createSqlType(SqlTypeName.BIGINT);
+    }
+  }
+
+  // Null for the groups without any non-null value
+  static class ApproxPercentile extends SqlAggFunction {
+    ApproxPercentile() {
+      super("APPROX_PERCENTILE",
+              null,
+              SqlKind.OTHER_FUNCTION,
+              null,
+              null,
+              OperandTypes.family(SqlTypeFamily.NUMERIC, SqlTypeFamily.NUMERIC),
+              SqlFunctionCategory.SYSTEM);
+    }
+
+    @Override
+    public RelDataType inferReturnType(SqlOperatorBinding opBinding) {
+      final RelDataTypeFactory typeFactory = opBinding.getTypeFactory();
+      return typeFactory.createTypeWithNullability(
+              typeFactory.createSqlType(SqlTypeName.DOUBLE), true);
+    }
+  }
+
+  static class ApproxMedian extends SqlAggFunction {
+    ApproxMedian() {
+      super("APPROX_MEDIAN",
+              null,
+              SqlKind.OTHER_FUNCTION,
+              null,
+              null,
+              OperandTypes.family(SqlTypeFamily.NUMERIC),
+              SqlFunctionCategory.SYSTEM);
+    }
+
+    @Override
+    public RelDataType inferReturnType(SqlOperatorBinding opBinding) {
+      final RelDataTypeFactory typeFactory = opBinding.getTypeFactory();
+      return typeFactory.createTypeWithNullability(
+              typeFactory.createSqlType(SqlTypeName.DOUBLE), true);
+    }
+  }
+
   public static class Sample extends SqlAggFunction {
     public Sample() {
       super("SAMPLE",
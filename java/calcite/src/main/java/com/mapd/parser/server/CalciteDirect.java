@@ -0,0 +1,120 @@
+/*
+ * Copyright 2018 MapD Technologies, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package com.mapd.parser.server;
+
+import com.mapd.common.SockTransportProperties;
+import com.mapd.thrift.calciteserver.InvalidParseRequest;
+import com.mapd.thrift.calciteserver.TCompletionHint;
+import com.mapd.thrift.calciteserver.TFilterPushDownInfo;
+import com.mapd.thrift.calciteserver.TPlanResult;
+
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+import org.apache.thrift.TException;
+import org.apache.thrift.TSerializer;
+import org.apache.thrift.protocol.TBinaryProtocol;
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+/**
+ * Entry point of the server when it runs Calcite in its own process, called through
+ * JNI. The requests are the ones of the Thrift server without the socket: the results
+ * are handed back serialized with the binary protocol, the errors as exceptions with
+ * the message to report.
+ */
+public class CalciteDirect {
+  final static Logger MAPDLOGGER = LoggerFactory.getLogger(CalciteDirect.class);
+
+  private final CalciteServerHandler handler;
+
+  public CalciteDirect(int mapdPort,
+          String dataDir,
+          String extensionsDir,
+          String trustStore,
+          String trustStorePassword) {
+    SockTransportProperties skT = null;
+    try {
+      if (!trustStore.isEmpty()) {
+        skT = new SockTransportProperties(trustStore, trustStorePassword);
+      }
+    } catch (Exception ex) {
+      MAPDLOGGER.error(
+              "Supplied java trust stored could not be opened " + ex.getMessage());
+    }
+    handler = new CalciteServerHandler(mapdPort,
+            dataDir,
+            Paths.get(extensionsDir, "ExtensionFunctions.ast").toString(),
+            skT);
+  }
+
+  // The filters pushed down come as (input_prev, input_start, input_next) triples.
+  public byte[] process(String user,
+          String session,
+          String catalog,
+          String sqlText,
+          int[] filterPushDownInfo,
+          boolean legacySyntax,
+          boolean isExplain) throws TException {
+    List<TFilterPushDownInfo> thriftFilterPushDownInfo = new ArrayList<>();
+    for (int i = 0; i + 2 < filterPushDownInfo.length; i += 3) {
+      thriftFilterPushDownInfo.add(new TFilterPushDownInfo(filterPushDownInfo[i],
+              filterPushDownInfo[i + 1],
+              filterPushDownInfo[i + 2]));
+    }
+    TPlanResult result;
+    try {
+      result = handler.process(user,
+              session,
+              catalog,
+              sqlText,
+              thriftFilterPushDownInfo,
+              legacySyntax,
+              isExplain);
+    } catch (InvalidParseRequest ex) {
+      throw new IllegalArgumentException(ex.whyUp);
+    }
+    return new TSerializer(new TBinaryProtocol.Factory()).serialize(result);
+  }
+
+  public void updateMetadata(String catalog, String table) throws TException {
+    handler.updateMetadata(catalog, table);
+  }
+
+  public String getExtensionFunctionWhitelist() {
+    return handler.getExtensionFunctionWhitelist();
+  }
+
+  public byte[][] getCompletionHints(String user,
+          String session,
+          String catalog,
+          String[] visibleTables,
+          String sql,
+          int cursor) throws TException {
+    List<String> visibleTableList = new ArrayList<>();
+    for (String table : visibleTables) {
+      visibleTableList.add(table);
+    }
+    List<TCompletionHint> hints = handler.getCompletionHints(
+            user, session, catalog, visibleTableList, sql, cursor);
+    TSerializer serializer = new TSerializer(new TBinaryProtocol.Factory());
+    byte[][] result = new byte[hints.size()][];
+    for (int i = 0; i < hints.size(); ++i) {
+      result[i] = serializer.serialize(hints.get(i));
+    }
+    return result;
+  }
+}
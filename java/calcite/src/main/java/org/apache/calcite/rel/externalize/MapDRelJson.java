@@ -36,10 +36,14 @@ import org.apache.calcite.rex.RexBuilder;
 import org.apache.calcite.rex.RexCall;
 import org.apache.calcite.rex.RexCorrelVariable;
 import org.apache.calcite.rex.RexFieldAccess;
+import org.apache.calcite.rex.RexFieldCollation;
 import org.apache.calcite.rex.RexInputRef;
 import org.apache.calcite.rex.RexLiteral;
 import org.apache.calcite.rex.RexNode;
+import org.apache.calcite.rex.RexOver;
 import org.apache.calcite.rex.RexSubQuery;
+import org.apache.calcite.rex.RexWindow;
+import org.apache.calcite.rex.RexWindowBound;
 import org.apache.calcite.sql.SemiJoinType;
 import org.apache.calcite.sql.SqlAggFunction;
 import org.apache.calcite.sql.SqlFunction;
@@ -349,6 +353,28 @@ public class MapDRelJson {
             ((RexSubQuery) node).rel.explain(subqueryWriter);
             map.put("subquery", subqueryWriter.asJsonMap());
           }
+          if (node instanceof RexOver) {
+            final RexOver over = (RexOver) node;
+            final RexWindow window = over.getWindow();
+            final List<Object> partitionKeys = jsonBuilder.list();
+            for (RexNode partitionKey : window.partitionKeys) {
+              partitionKeys.add(toJson(partitionKey));
+            }
+            map.put("partition_keys", partitionKeys);
+            final List<Object> orderKeys = jsonBuilder.list();
+            for (RexFieldCollation orderKey : window.orderKeys) {
+              final Map<String, Object> orderKeyMap = jsonBuilder.map();
+              orderKeyMap.put("field", toJson(orderKey.left));
+              orderKeyMap.put("direction", orderKey.getDirection().name());
+              orderKeyMap.put("nulls", orderKey.getNullDirection().name());
+              orderKeys.add(orderKeyMap);
+            }
+            map.put("order_keys", orderKeys);
+            map.put("is_rows", window.isRows());
+            map.put("lower_bound", toJson(window.getLowerBound()));
+            map.put("upper_bound", toJson(window.getUpperBound()));
+            map.put("distinct", over.isDistinct());
+          }
           if (call.getOperator() instanceof SqlFunction) {
             switch (((SqlFunction) call.getOperator()).getFunctionType()) {
               case USER_DEFINED_CONSTRUCTOR:
@@ -364,6 +390,15 @@ public class MapDRelJson {
     }
   }
 
+  private Object toJson(RexWindowBound windowBound) {
+    final Map<String, Object> map = jsonBuilder.map();
+    map.put("unbounded", windowBound.isUnbounded());
+    map.put("preceding", windowBound.isPreceding());
+    map.put("following", windowBound.isFollowing());
+    map.put("is_current_row", windowBound.isCurrentRow());
+    return map;
+  }
+
   RexNode toRex(RelInput relInput, Object o) {
     final RelOptCluster cluster = relInput.getCluster();
     final RexBuilder rexBuilder = cluster.getRexBuilder();
@@ -40,6 +40,13 @@ enum TExecuteMode {
   CPU
 }
 
+enum TQueryState {
+  QUEUED,
+  RUNNING,
+  FINISHED,
+  FAILED
+}
+
 enum TDeviceType {
   CPU,
   GPU
@@ -132,6 +139,7 @@ struct TStepResult {
   4: bool sharded
   5: TRowDescriptor row_desc
   6: i32 node_id
+  7: string traceparent /* of the span of the step on the leaf */
 }
 
 struct TRowSet {
@@ -146,6 +154,38 @@ struct TQueryResult {
   2: i64 execution_time_ms
   3: i64 total_time_ms
   4: string nonce
+  5: optional string execution_profile
+}
+
+/* see ThriftHandler/CompactResult.h for the encoding */
+struct TCompactColumn {
+  1: binary values
+  2: binary nulls
+  3: list<string> dictionary
+  4: bool delta_encoded
+}
+
+struct TCompactResult {
+  1: TRowDescriptor row_desc
+  2: i64 row_count
+  3: list<TCompactColumn> columns
+  4: i64 execution_time_ms
+  5: i64 total_time_ms
+  6: string nonce
+}
+
+/* one per query of a sql_execute_batch call, error_msg is set if the query failed */
+struct TBatchQueryResult {
+  1: TQueryResult result
+  2: string error_msg
+}
+
+/* elapsed_ms since the submission, up to the end of the execution once it's done */
+struct TQueryStatus {
+  1: TQueryState state
+  2: i64 elapsed_ms
+  3: i64 execution_time_ms
+  4: string error_msg
 }
 
 struct TDataFrame {
@@ -293,6 +333,10 @@ struct TNodeMemoryInfo {
   4: i64 num_pages_allocated
   5: bool is_allocation_capped
   6: list<TMemoryData> node_memory_data
+  7: i64 num_hits
+  8: i64 num_misses
+  9: i64 num_evictions
+  10: i64 largest_free_pages
 }
 
 struct TTableMeta {
@@ -352,6 +396,7 @@ struct TPendingQuery {
   2: list<TColumnRange> column_ranges
   3: list<TDictionaryGeneration> dictionary_generations
   4: list<TTableGeneration> table_generations
+  5: string traceparent /* W3C trace context, empty unless the query is traced */
 }
 
 struct TVarLen {
@@ -500,17 +545,42 @@ service MapD {
   void stop_heap_profile(1: TSessionId session) throws (1: TMapDException e)
   string get_heap_profile(1: TSessionId session) throws (1: TMapDException e)
   list<TNodeMemoryInfo> get_memory(1: TSessionId session, 2: string memory_level) throws (1: TMapDException e)
+  string get_metrics(1: TSessionId session) throws (1: TMapDException e)
+  # the latest records of the slow query log, the columns of mapd_log/slow_queries.tsv
+  TQueryResult get_slow_queries(1: TSessionId session) throws (1: TMapDException e)
   void clear_cpu_memory(1: TSessionId session) throws (1: TMapDException e)
   void clear_gpu_memory(1: TSessionId session) throws (1: TMapDException e)
+  # moves the unpinned chunks of each slab together to make its free pages contiguous, returns the bytes moved
+  i64 compact_memory(1: TSessionId session, 2: string memory_level) throws (1: TMapDException e)
   void set_table_epoch (1: TSessionId session 2: i32 db_id 3: i32 table_id 4: i32 new_epoch) throws (1: TMapDException e)
   void set_table_epoch_by_name (1: TSessionId session 2: string table_name 3: i32 new_epoch) throws (1: TMapDException e)
   i32 get_table_epoch (1: TSessionId session 2: i32 db_id 3: i32 table_id);
   i32 get_table_epoch_by_name (1: TSessionId session 2: string table_name);
+  # loads columns of a table, all of them if none is given, into CPU or GPU memory; a higher eviction priority pins them
+  void preload_table(1: TSessionId session, 2: string table_name, 3: list<string> column_names, 4: TDeviceType device_type, 5: i32 eviction_priority = 0) throws (1: TMapDException e)
   # query, render
   TQueryResult sql_execute(1: TSessionId session, 2: string query 3: bool column_format, 4: string nonce, 5: i32 first_n = -1, 6: i32 at_most_n = -1) throws (1: TMapDException e)
   TDataFrame sql_execute_df(1: TSessionId session, 2: string query 3: TDeviceType device_type 4: i32 device_id = 0 5: i32 first_n = -1) throws (1: TMapDException e)
   TDataFrame sql_execute_gdf(1: TSessionId session, 2: string query 3: i32 device_id = 0, 4: i32 first_n = -1) throws (1: TMapDException e)
   void deallocate_df(1: TSessionId session, 2: TDataFrame df, 3: TDeviceType device_type, 4: i32 device_id = 0) throws (1: TMapDException e)
+  # data frame batches of at most batch_entry_count entries on CPU, an empty data frame ends the results
+  i64 sql_execute_df_cursor(1: TSessionId session, 2: string query, 3: i32 batch_entry_count = 1000000) throws (1: TMapDException e)
+  TDataFrame fetch_df_batch(1: TSessionId session, 2: i64 cursor_id) throws (1: TMapDException e)
+  void close_df_cursor(1: TSessionId session, 2: i64 cursor_id) throws (1: TMapDException e)
+  # pages of at most max_rows rows of the result of a query, an empty row set ends the results
+  i64 sql_execute_cursor(1: TSessionId session, 2: string query, 3: i32 first_n = -1, 4: i32 at_most_n = -1) throws (1: TMapDException e)
+  TQueryResult fetch_rows(1: TSessionId session, 2: i64 cursor_id, 3: bool column_format, 4: i32 max_rows) throws (1: TMapDException e)
+  void close_cursor(1: TSessionId session, 2: i64 cursor_id) throws (1: TMapDException e)
+  # the result of a query as raw value buffers, null bitmaps and per column string dictionaries
+  TCompactResult sql_execute_compact(1: TSessionId session, 2: string query, 3: string nonce, 4: i32 first_n = -1, 5: i32 at_most_n = -1, 6: bool delta_encode = false) throws (1: TMapDException e)
+  # the queries of a dashboard executed concurrently, the results in the order of the queries
+  list<TBatchQueryResult> sql_execute_batch(1: TSessionId session, 2: list<string> queries, 3: bool column_format, 4: string nonce, 5: i32 first_n = -1) throws (1: TMapDException e)
+  # queries run by a pool of server threads: the handle is polled until the query is done, then its result fetched
+  # once; cancel_query drops a query, interrupt stops the execution of one already running
+  i64 sql_submit(1: TSessionId session, 2: string query) throws (1: TMapDException e)
+  TQueryStatus get_query_status(1: TSessionId session, 2: i64 query_id) throws (1: TMapDException e)
+  TQueryResult fetch_query_result(1: TSessionId session, 2: i64 query_id, 3: bool column_format, 4: i32 first_n = -1) throws (1: TMapDException e)
+  void cancel_query(1: TSessionId session, 2: i64 query_id) throws (1: TMapDException e)
   void interrupt(1: TSessionId session) throws (1: TMapDException e)
   TTableDescriptor sql_validate(1: TSessionId session, 2: string query) throws (1: TMapDException e)
   list<completion_hints.TCompletionHint> get_completion_hints(1: TSessionId session, 2:string sql, 3:i32 cursor) throws (1: TMapDException e)
@@ -537,6 +607,7 @@ service MapD {
   # import
   void load_table_binary(1: TSessionId session, 2: string table_name, 3: list<TRow> rows) throws (1: TMapDException e)
   void load_table_binary_columnar(1: TSessionId session, 2: string table_name, 3: list<TColumn> cols) throws (1: TMapDException e)
+  void load_table_binary_columnar_no_checkpoint(1: TSessionId session, 2: string table_name, 3: list<TColumn> cols) throws (1: TMapDException e)
   void load_table_binary_arrow(1: TSessionId session, 2: string table_name, 3: binary arrow_stream) throws (1: TMapDException e)
   void load_table(1: TSessionId session, 2: string table_name, 3: list<TStringRow> rows) throws (1: TMapDException e)
   TDetectResult detect_column_types(1: TSessionId session, 2: string file_name, 3: TCopyParams copy_params) throws (1: TMapDException e)
@@ -549,11 +620,12 @@ service MapD {
   # distributed
   TPendingQuery start_query(1: TSessionId session, 2: string query_ra, 3: bool just_explain) throws (1: TMapDException e)
   TStepResult execute_first_step(1: TPendingQuery pending_query) throws (1: TMapDException e)
-  void broadcast_serialized_rows(1: string serialized_rows, 2: TRowDescriptor row_desc, 3: TQueryId query_id) throws (1: TMapDException e)
+  void broadcast_serialized_rows(1: string serialized_rows, 2: TRowDescriptor row_desc, 3: TQueryId query_id, 4: string traceparent) throws (1: TMapDException e)
   TPendingRenderQuery start_render_query(1: TSessionId session, 2: i64 widget_id, 3: i16 node_idx, 4: string vega_json) throws (1: TMapDException e)
   TRenderStepResult execute_next_render_step(1: TPendingRenderQuery pending_render, 2: TRenderAggDataMap merged_data) throws (1: TMapDException e)
   void insert_data(1: TSessionId session, 2: TInsertData insert_data) throws (1: TMapDException e)
   void checkpoint(1: TSessionId session, 2: i32 db_id, 3: i32 table_id) throws (1: TMapDException e)
+  i32 checkpoint_table(1: TSessionId session, 2: string table_name) throws (1: TMapDException e)
   # deprecated
   TTableDescriptor get_table_descriptor(1: TSessionId session, 2: string table_name) throws (1: TMapDException e)
   TRowDescriptor get_row_descriptor(1: TSessionId session, 2: string table_name) throws (1: TMapDException e)